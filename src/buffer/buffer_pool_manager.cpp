@@ -12,31 +12,104 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>  // NOLINT
 #include <list>
-#include <unordered_map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/logger.h"
+#include "common/memory_accounting.h"
+#include "common/util/contention_profiler.h"
+#include "common/util/tracer.h"
 
 namespace bustub {
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new ClockReplacer(pool_size);
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                                     ReplacerPolicy replacer_policy, size_t max_pool_size)
+    : BufferPoolManager(pool_size, 1, 0, disk_manager, log_manager, replacer_policy, max_pool_size) {}
 
-  // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+BufferPoolManager::BufferPoolManager(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                     DiskManager *disk_manager, LogManager *log_manager,
+                                     ReplacerPolicy replacer_policy, size_t max_pool_size, int numa_node)
+    : pool_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      frame_arena_(std::max(pool_size, max_pool_size), numa_node),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      page_table_(frame_arena_.GetNumFrames()),
+      read_pending_(frame_arena_.GetNumFrames()),
+      background_pinned_(frame_arena_.GetNumFrames()),
+      prefetched_(frame_arena_.GetNumFrames()),
+      last_access_(frame_arena_.GetNumFrames()),
+      accesses_(frame_arena_.GetNumFrames()),
+      rec_lsns_(frame_arena_.GetNumFrames()) {
+  BUSTUB_ASSERT(num_instances > 0, "A buffer pool needs at least one shard.");
+  BUSTUB_ASSERT(instance_index < num_instances, "The shard index must be smaller than the number of shards.");
+  // We allocate a consecutive memory space for the buffer pool. The metadata of the frames is kept densely packed,
+  // separately from the data in the arena.
+  // Frames beyond pool_size are only set up for Resize.
+  const size_t max_frames = frame_arena_.GetNumFrames();
+  pages_ = static_cast<Page *>(::operator new(max_frames * sizeof(Page)));
+  for (size_t i = 0; i < max_frames; ++i) {
+    new (&pages_[i]) Page(frame_arena_.GetFrame(static_cast<frame_id_t>(i)));
+  }
+  switch (replacer_policy) {
+    case ReplacerPolicy::LRU_K:
+      replacer_ = new LRUKReplacer(max_frames, LRUK_REPLACER_K);
+      break;
+    case ReplacerPolicy::CLOCK:
+      replacer_ = new ClockReplacer(max_frames);
+      break;
+  }
+
+  // Initially, every page is in the free list. Free frames are marked as claimed so that they cannot be pinned.
+  for (size_t i = 0; i < max_frames; ++i) {
+    pages_[i].pin_count_ = -1;
+    if (i < pool_size_) {
+      free_list_.emplace_back(static_cast<int>(i));
+    }
   }
 
-  cur_size_ = 0;
+  MemoryAccounting::Get(MemorySubsystem::BUFFER_POOL)->Consume(pool_size_ * PAGE_SIZE, pool_size_);
+
+  if (max_frames > 0) {
+    flusher_thread_ = new std::thread(&BufferPoolManager::RunFlusher, this);
+    prefetcher_thread_ = new std::thread(&BufferPoolManager::RunPrefetcher, this);
+  }
 }
 
 BufferPoolManager::~BufferPoolManager() {
-  delete[] pages_;
+  StopWarmStartDumps();
+  {
+    ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+    shutdown_ = true;
+  }
+  flusher_cv_.notify_one();
+  prefetcher_cv_.notify_one();
+  for (auto *thread : {flusher_thread_, prefetcher_thread_}) {
+    if (thread != nullptr) {
+      thread->join();
+      delete thread;
+    }
+  }
+  for (size_t i = 0; i < frame_arena_.GetNumFrames(); ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete(pages_);
   delete replacer_;
+  // A buffer pool of shards holds no frames of its own, whatever its size.
+  const size_t frames = std::min(pool_size_.load(), frame_arena_.GetNumFrames());
+  MemoryAccounting::Get(MemorySubsystem::BUFFER_POOL)->Release(frames * PAGE_SIZE, frames);
 }
 
-// For FetchPageImpl,you should return NULL if no page is available in the free list and all other pages are currently pinned.
 Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
@@ -45,113 +118,279 @@ Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-
-  // case 1: if this page_id exist in the page table
-  if (page_table_.count(page_id)) {
-    int frame_id = page_table_[page_id];
-    pages_[frame_id].pin_count_++;
-    return &pages_[frame_id];
+  Page *page = PinMappedPage(page_id);
+  if (page != nullptr) {
+    return page;
   }
-
-  // case 2: if this page_id does not exist in the page table, find a replacement page from free list or replacer
-  frame_id_t replace_frame_id = -1;
-  if (!free_list_.empty()) {
-    replace_frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    replacer_->Victim(&replace_frame_id);
+  page = TryPinResidentPage(page_id);
+  if (page != nullptr) {
+    return page;
   }
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
 
-  // if all pages pinned now, cannot find a replacement
-  if (replace_frame_id == -1) { return nullptr; }
-
-  page_id_t replace_page_id = pages_[replace_frame_id].page_id_;
-
-  // check the replacement page dirty status
-  if (pages_[replace_frame_id].IsDirty()) {
-    FlushPageImpl(replace_page_id);
+  frame_id_t frame_id;
+  if (page_table_.Find(page_id, &frame_id)) {
+    return PinResidentPage(&lock, page_id, frame_id);
   }
 
-  // delete the replacement page and insert the required page
-  auto it = page_table_.find(replace_page_id);
-  page_table_.erase(it);
-  page_table_[page_id] = replace_frame_id;
+  if (!AcquireFrame(&lock, &frame_id)) {
+    stats_.RecordFetchFailure();
+    return nullptr;
+  }
+  // AcquireFrame may have waited for a frame, and somebody else may have loaded the page meanwhile.
+  frame_id_t resident_frame_id;
+  if (page_table_.Find(page_id, &resident_frame_id)) {
+    ReleaseFrame(frame_id);
+    return PinResidentPage(&lock, page_id, resident_frame_id);
+  }
+  page = LoadPage(page_id, frame_id);
+  if (page != nullptr) {
+    ReadAhead(page_id);
+  }
+  return page;
+}
 
-  // fetch data from the disk
-  update_page_metadata(replace_frame_id, page_id);
-  disk_manager_->ReadPage(page_id, pages_[replace_frame_id].data_);
+Page *BufferPoolManager::FetchPageForScanImpl(page_id_t page_id, BufferRing *ring) {
+  // Read-only pages take no frame, so the ring has nothing to recycle.
+  Page *page = PinMappedPage(page_id);
+  if (page != nullptr) {
+    return page;
+  }
+  ring->RecordFetch();
+  page = TryPinResidentPage(page_id);
+  if (page != nullptr) {
+    return page;
+  }
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
 
-  return &pages_[replace_frame_id];
+  frame_id_t frame_id;
+  if (page_table_.Find(page_id, &frame_id)) {
+    return PinResidentPage(&lock, page_id, frame_id);
+  }
+  // Prefer the frame of the oldest ring page. If somebody else is using it, take a frame from the pool instead; the
+  // new page then occupies the slot, so the ring keeps its size.
+  page_id_t candidate = ring->IsActive() ? ring->GetRecycleCandidate() : INVALID_PAGE_ID;
+  if ((candidate == INVALID_PAGE_ID || !RecycleFrame(candidate, &frame_id)) && !AcquireFrame(&lock, &frame_id)) {
+    stats_.RecordFetchFailure();
+    return nullptr;
+  }
+  frame_id_t resident_frame_id;
+  if (page_table_.Find(page_id, &resident_frame_id)) {
+    ReleaseFrame(frame_id);
+    return PinResidentPage(&lock, page_id, resident_frame_id);
+  }
+  if (ring->IsActive()) {
+    ring->Advance(page_id);
+  }
+  return LoadPage(page_id, frame_id);
 }
 
 bool BufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
-  if (page_id == INVALID_PAGE_ID || !page_table_.count(page_id)) return false;
-
-  // decrement the pin_count, and call the replacer unpin if pin_count == 0
-  if (--pages_[page_table_[page_id]].pin_count_ == 0) {
-    replacer_->Unpin(page_table_[page_id]);
-    free_list_.push_back(page_table_[page_id]);
+  if (UnpinMappedPage(page_id, is_dirty)) {
+    return true;
   }
-
-  // check the dirty status of this page
-  pages_[page_table_[page_id]].is_dirty_ |= is_dirty;
-
-  // if this page is dirty, then write back to disk
-  if (pages_[page_table_[page_id]].is_dirty_) {
-    FlushPageImpl(page_id);
+  frame_id_t frame_id;
+  int pin_count = DecrementPin(page_id, is_dirty, &frame_id);
+  if (pin_count < 0) {
+    return false;
+  }
+  if (pin_count == 0) {
+    ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+    // The page may have been pinned again, or even been replaced, while we waited for the latch.
+    if (pages_[frame_id].pin_count_ == 0 && pages_[frame_id].page_id_ == page_id) {
+      replacer_->Unpin(frame_id);
+    }
   }
   return true;
 }
 
+bool BufferPoolManager::UnpinPagesImpl(const std::vector<page_id_t> &page_ids, bool is_dirty) {
+  bool all_pinned = true;
+  std::vector<std::pair<page_id_t, frame_id_t>> unpinned;
+  for (page_id_t page_id : page_ids) {
+    if (UnpinMappedPage(page_id, is_dirty)) {
+      continue;
+    }
+    frame_id_t frame_id;
+    int pin_count = DecrementPin(page_id, is_dirty, &frame_id);
+    if (pin_count < 0) {
+      all_pinned = false;
+    } else if (pin_count == 0) {
+      unpinned.emplace_back(page_id, frame_id);
+    }
+  }
+  if (!unpinned.empty()) {
+    ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+    for (const auto &[page_id, frame_id] : unpinned) {
+      if (pages_[frame_id].pin_count_ == 0 && pages_[frame_id].page_id_ == page_id) {
+        replacer_->Unpin(frame_id);
+      }
+    }
+  }
+  return all_pinned;
+}
+
 bool BufferPoolManager::FlushPageImpl(page_id_t page_id) {
   // Make sure you call DiskManager::WritePage!
-  if (!page_table_.count(page_id)) { return false; }
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  if (disk_manager_->GetMappedPage(page_id) != nullptr) {
+    // Read-only pages are always on disk.
+    return true;
+  }
+  ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
 
-  disk_manager_->WritePage(page_id, pages_[page_table_[page_id]].GetData());
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    return false;
+  }
+  FlushFrame(frame_id);
   return true;
 }
 
 Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
-  // 0.   Make sure you call DiskManager::AllocatePage!
+  // 0.   Make sure you call AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  return CreatePage(&lock, page_id);
+}
 
-  // corner case: if buffer pool is full and all pages are pinned
-  int frame_id_tmp = 0;
-  if (cur_size_ == pool_size_ && free_list_.empty() && !replacer_->Victim(&frame_id_tmp)) {
-    return nullptr;
+Page *BufferPoolManager::NewPageInExtentImpl(page_id_t prev_page_id, page_id_t *page_id) {
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  return CreatePage(&lock, page_id, true, prev_page_id);
+}
+
+std::vector<Page *> BufferPoolManager::NewPagesImpl(size_t n, std::vector<page_id_t> *page_ids) {
+  std::vector<Page *> pages;
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  while (pages.size() < n) {
+    page_id_t page_id;
+    Page *page = CreatePage(&lock, &page_id);
+    if (page == nullptr) {
+      break;
+    }
+    pages.push_back(page);
+    page_ids->push_back(page_id);
+  }
+  return pages;
+}
+
+std::vector<Page *> BufferPoolManager::FetchPagesImpl(const std::vector<page_id_t> &page_ids) {
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  std::vector<size_t> misses;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    pages[i] = PinMappedPage(page_ids[i]);
+    if (pages[i] == nullptr) {
+      pages[i] = TryPinResidentPage(page_ids[i]);
+    }
+    if (pages[i] == nullptr) {
+      misses.push_back(i);
+    }
+  }
+  if (misses.empty()) {
+    return pages;
   }
 
-  int new_page_id = disk_manager_->AllocatePage();
-  *page_id = new_page_id;
+  // Sorting the misses by page id lets the reads sweep the file, and puts duplicates next to each other.
+  std::stable_sort(misses.begin(), misses.end(), [&](size_t a, size_t b) { return page_ids[a] < page_ids[b]; });
+  std::vector<std::pair<page_id_t, frame_id_t>> reads;
+  std::vector<size_t> deferred;
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  for (size_t i : misses) {
+    const page_id_t page_id = page_ids[i];
+    frame_id_t frame_id;
+    if (!page_table_.Find(page_id, &frame_id)) {
+      frame_id_t free_frame_id;
+      if (!AcquireFrame(&lock, &free_frame_id)) {
+        stats_.RecordFetchFailure();
+        continue;
+      }
+      // AcquireFrame may have waited for a frame, and somebody else may have loaded the page meanwhile.
+      if (!page_table_.Find(page_id, &frame_id)) {
+        // The read happens outside the latch, so the frame is published as pending like a prefetched frame. The pin
+        // belongs to the caller, it is not a background pin.
+        Page *page = &pages_[free_frame_id];
+        page->BeginWrite();
+        page->page_id_ = page_id;
+        page->is_dirty_ = false;
+        ResetRecLSN(free_frame_id);
+        read_pending_[free_frame_id] = true;
+        prefetched_[free_frame_id] = false;
+        page->pin_count_ = 1;
+        page_table_.Insert(page_id, free_frame_id);
+        replacer_->Pin(free_frame_id);
+        stats_.RecordMiss();
+        reads.emplace_back(page_id, free_frame_id);
+        pages[i] = page;
+        continue;
+      }
+      ReleaseFrame(free_frame_id);
+    }
 
-  // case 1: if the current buffer pool is not full
-  if (cur_size_ < pool_size_) {
-    frame_id_tmp = free_list_.front();
-    free_list_.pop_front();
-    update_page_metadata(frame_id_tmp, new_page_id);
-    cur_size_++;
-  }
-  // case 2: if the current buffer pool has been full
-  else if (cur_size_ == pool_size_) {
-    // first find the free list
-    if (!free_list_.empty()) {
-      frame_id_tmp = free_list_.front();
-      free_list_.pop_front();
-    } else { // if free list is empty, then find the replacer victim
-      replacer_->Victim(&frame_id_tmp);
+    if (!read_pending_[frame_id]) {
+      pages[i] = PinResidentPage(&lock, page_id, frame_id);
+    } else if (!reads.empty() && reads.back().first == page_id) {
+      // A duplicate of a page that this batch reads itself.
+      pages_[frame_id].pin_count_++;
+      stats_.RecordHit();
+      pages[i] = &pages_[frame_id];
+    } else {
+      // Waiting for somebody else's read while holding pending frames of our own could deadlock, so such pages are
+      // fetched once our reads are done.
+      deferred.push_back(i);
     }
+  }
 
-    // find the page_id needs to be evicted
-    page_id_t evict_page_id = pages_[frame_id_tmp].page_id_;
-    auto it = page_table_.find(evict_page_id);
-    page_table_.erase(it);
-    update_page_metadata(frame_id_tmp, new_page_id);
+  if (!reads.empty()) {
+    lock.unlock();
+    std::vector<page_id_t> read_page_ids;
+    std::vector<char *> read_data;
+    for (const auto &[page_id, frame_id] : reads) {
+      read_page_ids.push_back(page_id);
+      read_data.push_back(pages_[frame_id].data_);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<bool> valid;
+    {
+      TraceScope trace("page_read", read_page_ids.front());
+      valid = disk_manager_->ReadPages(read_page_ids, read_data);
+    }
+    stats_.RecordRead(std::chrono::steady_clock::now() - start);
+    lock.lock();
+    bool failed = false;
+    for (size_t j = 0; j < reads.size(); j++) {
+      const frame_id_t frame_id = reads[j].second;
+      if (!valid[j]) {
+        DiscardFailedRead(frame_id);
+        failed = true;
+      }
+      pages_[frame_id].EndWrite();
+      read_pending_[frame_id] = false;
+      TouchFrame(frame_id);
+    }
+    background_pin_cv_.notify_all();
+    if (failed) {
+      // Our pins are the only ones on pages with an invalid id, a pin on a page that was read keeps it from being
+      // deleted. Duplicates hold one pin each.
+      for (auto &page : pages) {
+        if (page != nullptr && page->page_id_ == INVALID_PAGE_ID) {
+          DropPin(static_cast<frame_id_t>(page - pages_));
+          stats_.RecordFetchFailure();
+          page = nullptr;
+        }
+      }
+    }
   }
+  lock.unlock();
 
-  return &pages_[frame_id_tmp];
+  for (size_t i : deferred) {
+    pages[i] = FetchPageImpl(page_ids[i]);
+  }
+  return pages;
 }
 
 bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
@@ -160,43 +399,888 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
+  if (disk_manager_->GetMappedPage(page_id) != nullptr) {
+    return false;
+  }
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+
+  frame_id_t frame_id;
+  while (true) {
+    if (!page_table_.Find(page_id, &frame_id)) {
+      disk_manager_->DeallocatePage(page_id);
+      return true;
+    }
+    if (ClaimFrame(frame_id)) {
+      break;
+    }
+    // A pin of the flusher or the prefetcher goes away once its I/O is done, any other pin belongs to a user.
+    if (!background_pinned_[frame_id] || pages_[frame_id].pin_count_ != 1) {
+      return false;
+    }
+    background_pin_cv_.wait(lock);
+  }
+
+  Page *page = &pages_[frame_id];
+  disk_manager_->DeallocatePage(page_id);
+  page_table_.Erase(page_id);
+  accesses_[frame_id].store(0, std::memory_order_relaxed);
+  if (page->is_dirty_.exchange(false)) {
+    num_dirty_--;
+  }
+  // The frame is about to move to the free list, so the replacer forgets it. It stays claimed.
+  replacer_->Remove(frame_id);
+  page->page_id_ = INVALID_PAGE_ID;
+  page->BeginWrite();
+  page->ResetMemory();
+  page->EndWrite();
+  prefetched_[frame_id] = false;
+  free_list_.push_back(frame_id);
+  return true;
+}
+
+void BufferPoolManager::FlushAllPagesImpl() {
+  ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (pages_[i].page_id_ != INVALID_PAGE_ID) {
+      FlushFrame(static_cast<frame_id_t>(i));
+    }
+  }
+  disk_manager_->FlushFreeSpaceMap();
+}
 
-  if (!page_table_.count(page_id)) { return true; }
+void BufferPoolManager::PrefetchPagesImpl(page_id_t start, size_t n) {
+  ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  QueuePrefetches(start, n);
+}
 
-  int frame_id = page_table_[page_id];
-  if (pages_[frame_id].pin_count_ != 0) { return false; }
+BufferPoolStats BufferPoolManager::GetStatsImpl() { return stats_.Snapshot(); }
 
-  auto it = page_table_.find(page_id);
-  page_table_.erase(it);
-  cur_size_--;
-  free_list_.push_back(page_table_[page_id]);
-  reset_page_metadata(frame_id);
+void BufferPoolManager::CollectMetrics(MetricsSnapshot *snapshot) {
+  const BufferPoolStats stats = GetStats();
+  const auto add_counter = [snapshot](const char *name, const char *help, uint64_t value) {
+    snapshot->AddCounter(name, help, static_cast<double>(value));
+  };
+  add_counter("bustub_buffer_pool_fetch_hits_total", "Fetches of pages that were resident.", stats.fetch_hits);
+  add_counter("bustub_buffer_pool_fetch_misses_total", "Fetches of pages that were read from disk.",
+              stats.fetch_misses);
+  add_counter("bustub_buffer_pool_fetch_failures_total", "Fetches that failed because every frame was pinned.",
+              stats.fetch_failures);
+  add_counter("bustub_buffer_pool_new_page_failures_total", "New pages that failed because every frame was pinned.",
+              stats.new_page_failures);
+  add_counter("bustub_buffer_pool_evictions_total", "Pages evicted to make room for another page.", stats.evictions);
+  add_counter("bustub_buffer_pool_dirty_evictions_total", "Evicted pages that were written back first.",
+              stats.dirty_evictions);
+  add_counter("bustub_buffer_pool_pin_waits_total", "Fetches that waited for a frame or a page being read.",
+              stats.pin_waits);
+  add_counter("bustub_buffer_pool_flushes_total", "Pages written back to disk.", stats.flushes);
+  const auto add_seconds = [snapshot](const char *name, const char *help, uint64_t us) {
+    snapshot->AddCounter(name, help, static_cast<double>(us) / 1e6);
+  };
+  add_seconds("bustub_buffer_pool_pin_wait_seconds_total", "Time spent waiting by fetches.", stats.pin_wait_time_us);
+  add_seconds("bustub_buffer_pool_read_seconds_total", "Time spent reading pages by fetches that missed.",
+              stats.read_time_us);
+  add_seconds("bustub_buffer_pool_flush_seconds_total", "Time spent writing pages back.", stats.flush_time_us);
 
+  // Each power of two bucket of the flush latencies is counted at its largest value.
+  HistogramSnapshot flush_latency;
+  for (size_t i = 0; i < BufferPoolStats::NUM_LATENCY_BUCKETS; i++) {
+    const uint64_t count = stats.flush_latency_us[i];
+    if (count != 0) {
+      const uint64_t upper = i == 0 ? 0 : (uint64_t{1} << i) - 1;
+      flush_latency.buckets_[HistogramSnapshot::GetBucket(upper)] += count;
+      flush_latency.count_ += count;
+      flush_latency.max_ = upper;
+    }
+  }
+  flush_latency.sum_ = stats.flush_time_us;
+  snapshot->AddHistogram("bustub_buffer_pool_flush_latency_us", "Latency of the page writes, in microseconds.",
+                         flush_latency);
+  snapshot->AddGauge("bustub_buffer_pool_frames", "Frames of the buffer pool.", static_cast<double>(GetPoolSize()));
+}
+
+bool BufferPoolManager::DumpResidentPages(const std::string &file_name) {
+  auto pages = GetResidentPagesImpl();
+  std::sort(pages.begin(), pages.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+
+  // Write a new file and swap it in, a crash in between must not leave a truncated list behind.
+  const std::string tmp_file_name = file_name + ".tmp";
+  {
+    std::ofstream out(tmp_file_name, std::ios::trunc);
+    for (const auto &[last_access, page_id] : pages) {
+      out << page_id << '\n';
+    }
+    out.close();
+    if (!out) {
+      std::remove(tmp_file_name.c_str());
+      return false;
+    }
+  }
+  return std::rename(tmp_file_name.c_str(), file_name.c_str()) == 0;
+}
+
+size_t BufferPoolManager::RestoreResidentPages(const std::string &file_name) {
+  std::ifstream in(file_name);
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  while (in >> page_id) {
+    page_ids.push_back(page_id);
+  }
+  return page_ids.empty() ? 0 : LoadPagesImpl(page_ids);
+}
+
+void BufferPoolManager::StartWarmStartDumps(const std::string &file_name) {
+  StopWarmStartDumps();
+  warm_start_file_ = file_name;
+  stop_warm_start_ = false;
+  warm_start_thread_ = new std::thread([this] {
+    std::unique_lock<std::mutex> lock(warm_start_latch_);
+    while (!warm_start_cv_.wait_for(lock, warm_start_interval, [&] { return stop_warm_start_; })) {
+      DumpResidentPages(warm_start_file_);
+    }
+  });
+}
+
+void BufferPoolManager::StopWarmStartDumps() {
+  if (warm_start_thread_ == nullptr) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(warm_start_latch_);
+    stop_warm_start_ = true;
+  }
+  warm_start_cv_.notify_one();
+  warm_start_thread_->join();
+  delete warm_start_thread_;
+  warm_start_thread_ = nullptr;
+  DumpResidentPages(warm_start_file_);
+}
+
+std::vector<std::pair<uint64_t, page_id_t>> BufferPoolManager::GetResidentPagesImpl() {
+  ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  std::vector<std::pair<uint64_t, page_id_t>> pages;
+  for (size_t i = 0; i < frame_arena_.GetNumFrames(); i++) {
+    // Frames on the free list or being reused have a negative pin count, pages being read are not accessed yet.
+    if (pages_[i].pin_count_ >= 0 && !read_pending_[i] && pages_[i].page_id_ != INVALID_PAGE_ID) {
+      pages.emplace_back(last_access_[i].load(std::memory_order_relaxed), pages_[i].page_id_);
+    }
+  }
+  return pages;
+}
+
+std::vector<std::pair<page_id_t, lsn_t>> BufferPoolManager::GetDirtyPageTableImpl() {
+  ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  std::vector<std::pair<page_id_t, lsn_t>> pages;
+  for (size_t i = 0; i < frame_arena_.GetNumFrames(); i++) {
+    const Page &page = pages_[i];
+    if (page.page_id_ != INVALID_PAGE_ID && !read_pending_[i] && (page.is_dirty_ || page.pin_count_ > 0)) {
+      pages.emplace_back(page.page_id_, rec_lsns_[i].load(std::memory_order_relaxed));
+    }
+  }
+  return pages;
+}
+
+size_t BufferPoolManager::LoadPagesImpl(const std::vector<page_id_t> &page_ids) {
+  // Frames are taken from the free list only, a warm start must never push out pages that are in use already. Like
+  // prefetched frames, the frames stay pinned and flagged as pending until their read is done.
+  std::vector<std::pair<page_id_t, frame_id_t>> reads;
+  {
+    ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+    const page_id_t num_pages = disk_manager_->GetNumPagesOnDisk();
+    for (page_id_t page_id : page_ids) {
+      if (free_list_.empty()) {
+        break;
+      }
+      frame_id_t frame_id;
+      if (page_id < 0 || page_id >= num_pages || static_cast<uint32_t>(page_id) % num_instances_ != instance_index_ ||
+          page_table_.Find(page_id, &frame_id)) {
+        continue;
+      }
+      frame_id = free_list_.front();
+      free_list_.pop_front();
+
+      Page *page = &pages_[frame_id];
+      page->BeginWrite();
+      page->page_id_ = page_id;
+      page->is_dirty_ = false;
+      ResetRecLSN(frame_id);
+      read_pending_[frame_id] = true;
+      prefetched_[frame_id] = false;
+      page->pin_count_ = 1;
+      background_pinned_[frame_id] = true;
+      page_table_.Insert(page_id, frame_id);
+      replacer_->Pin(frame_id);
+      num_background_pins_++;
+      reads.emplace_back(page_id, frame_id);
+    }
+  }
+
+  // Read in page id order, so that the reads sweep the file, and split the sweep among a few threads.
+  auto sorted_reads = reads;
+  std::sort(sorted_reads.begin(), sorted_reads.end());
+  const size_t num_readers = std::min(static_cast<size_t>(WARM_START_READERS), sorted_reads.size());
+  // One byte per read, so that the readers do not share the words of a std::vector<bool>.
+  std::vector<char> valid(sorted_reads.size());
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < num_readers; i++) {
+    readers.emplace_back([&, i] {
+      const size_t begin = sorted_reads.size() * i / num_readers;
+      const size_t end = sorted_reads.size() * (i + 1) / num_readers;
+      for (size_t j = begin; j < end; j++) {
+        valid[j] = static_cast<char>(
+            disk_manager_->ReadPage(sorted_reads[j].first, pages_[sorted_reads[j].second].data_));
+      }
+    });
+  }
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  // Unpin the coldest pages first, so that the replacer evicts them before the hotter ones.
+  ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  size_t num_loaded = reads.size();
+  for (size_t j = 0; j < sorted_reads.size(); j++) {
+    if (valid[j] == 0) {
+      DiscardFailedRead(sorted_reads[j].second);
+      num_loaded--;
+    }
+  }
+  const auto now = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+  for (auto it = reads.rbegin(); it != reads.rend(); ++it) {
+    frame_id_t frame_id = it->second;
+    pages_[frame_id].EndWrite();
+    const auto rank = static_cast<uint64_t>(reads.rend() - it - 1);
+    last_access_[frame_id].store(now - rank, std::memory_order_relaxed);
+    read_pending_[frame_id] = false;
+    ReleaseBackgroundPin(frame_id);
+  }
+  return num_loaded;
+}
+
+bool BufferPoolManager::ResizeImpl(size_t pool_size) {
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  const size_t old_pool_size = pool_size_;
+  if (pool_size > frame_arena_.GetNumFrames()) {
+    return false;
+  }
+  MemoryAccount *account = MemoryAccounting::Get(MemorySubsystem::BUFFER_POOL);
+  if (pool_size >= old_pool_size) {
+    // The buffer pools do not grow past the soft limit of their memory.
+    const size_t added = pool_size - old_pool_size;
+    if (!account->Fits(added * PAGE_SIZE)) {
+      return false;
+    }
+    for (size_t i = old_pool_size; i < pool_size; ++i) {
+      free_list_.emplace_back(static_cast<frame_id_t>(i));
+    }
+    pool_size_ = pool_size;
+    account->Consume(added * PAGE_SIZE, added);
+    return true;
+  }
+
+  // Pins of the flusher and the prefetcher go away once their I/O is done, and cannot be taken again under the latch.
+  background_pin_cv_.wait(lock, [&] {
+    for (size_t i = pool_size; i < old_pool_size; ++i) {
+      if (background_pinned_[i]) {
+        return false;
+      }
+    }
+    return true;
+  });
+
+  // Claim every frame that is removed. Free frames are claimed already, they only have to leave the free list.
+  free_list_.remove_if([&](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= pool_size; });
+  std::vector<frame_id_t> claimed;
+  bool all_claimed = true;
+  for (size_t i = pool_size; i < old_pool_size; ++i) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    Page *page = &pages_[frame_id];
+    // A frame whose read failed may still be pinned by the fetches that waited for it, see DiscardFailedRead().
+    if (page->page_id_ == INVALID_PAGE_ID && page->pin_count_ < 0) {
+      continue;
+    }
+    if (!ClaimFrame(frame_id)) {
+      all_claimed = false;
+      continue;
+    }
+    replacer_->Remove(frame_id);
+    if (page->is_dirty_) {
+      FlushFrame(frame_id);
+    }
+    ReportAccesses(frame_id);
+    page_table_.Erase(page->page_id_);
+    page->page_id_ = INVALID_PAGE_ID;
+    prefetched_[frame_id] = false;
+    claimed.push_back(frame_id);
+  }
+
+  if (!all_claimed) {
+    // Some page is still in use. The pages that were dropped meanwhile leave their frames empty but usable.
+    for (size_t i = pool_size; i < old_pool_size; ++i) {
+      if (pages_[i].page_id_ == INVALID_PAGE_ID && pages_[i].pin_count_ < 0) {
+        free_list_.emplace_back(static_cast<frame_id_t>(i));
+      }
+    }
+    return false;
+  }
+  pool_size_ = pool_size;
+  for (frame_id_t frame_id : claimed) {
+    pages_[frame_id].BeginWrite();
+  }
+  frame_arena_.Discard(static_cast<frame_id_t>(pool_size), old_pool_size - pool_size);
+  for (frame_id_t frame_id : claimed) {
+    pages_[frame_id].EndWrite();
+  }
+  account->Release((old_pool_size - pool_size) * PAGE_SIZE, old_pool_size - pool_size);
   return true;
 }
 
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page != nullptr) {
+    page->RLatch();
+  }
+  return ReadPageGuard(this, page);
+}
 
-void BufferPoolManager::FlushAllPagesImpl() {
-  for (auto & it : page_table_) {
-    FlushPageImpl(it.first);
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page != nullptr) {
+    page->WLatch();
   }
+  return WritePageGuard(this, page);
 }
 
-void BufferPoolManager::update_page_metadata(frame_id_t frame_id, page_id_t page_id) {
-  page_table_[page_id] = frame_id;
-  pages_[frame_id].page_id_ = page_id;
-  pages_[frame_id].pin_count_ = 1;
-  pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].ResetMemory();
-  replacer_->Pin(frame_id);
+page_id_t BufferPoolManager::AllocatePage(bool in_extent, page_id_t prev_page_id) {
+  // Every shard hands out ids from its own residue class, so page_id % num_instances_ routes back to this shard.
+  const page_id_t page_id = in_extent
+                                ? disk_manager_->AllocateExtentPage(prev_page_id, num_instances_, instance_index_)
+                                : disk_manager_->AllocatePage(num_instances_, instance_index_);
+  BUSTUB_ASSERT(static_cast<uint32_t>(page_id) % num_instances_ == instance_index_,
+                "Allocated pages must map back to this shard.");
+  return page_id;
+}
+
+bool BufferPoolManager::FindReplacementFrame(frame_id_t *frame_id) {
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+  if (!replacer_->Victim(frame_id)) {
+    return false;
+  }
+  // Only unpinned frames are evictable, and they can only be pinned again under the latch.
+  bool claimed = ClaimFrame(*frame_id);
+  BUSTUB_ASSERT(claimed, "The replacer must only hand out unpinned frames.");
+
+  Page *victim = &pages_[*frame_id];
+  stats_.RecordEviction(victim->is_dirty_);
+  if (victim->is_dirty_) {
+    FlushFrame(*frame_id);
+  }
+  ReportAccesses(*frame_id);
+  page_table_.Erase(victim->page_id_);
+  return claimed;
 }
 
-void BufferPoolManager::reset_page_metadata(frame_id_t frame_id) {
+bool BufferPoolManager::AcquireFrame(std::unique_lock<std::mutex> *lock, frame_id_t *frame_id) {
+  while (!FindReplacementFrame(frame_id)) {
+    if (num_background_pins_ == 0) {
+      return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    background_pin_cv_.wait(*lock);
+    stats_.RecordPinWait(std::chrono::steady_clock::now() - start);
+  }
+  return true;
+}
+
+void BufferPoolManager::ReleaseFrame(frame_id_t frame_id) {
+  // The frame stays claimed while it is on the free list.
+  replacer_->Remove(frame_id);
   pages_[frame_id].page_id_ = INVALID_PAGE_ID;
-  pages_[frame_id].pin_count_ = 0;
-  pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].ResetMemory();
+  prefetched_[frame_id] = false;
+  free_list_.push_front(frame_id);
 }
 
+int BufferPoolManager::DecrementPin(page_id_t page_id, bool is_dirty, frame_id_t *frame_id) {
+  // The caller's pin keeps the frame from being reused, so the latch is only needed once the last pin is gone.
+  if (!page_table_.Find(page_id, frame_id)) {
+    // The lookup can miss while the table is being rebuilt, retry under the latch.
+    ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+    if (!page_table_.Find(page_id, frame_id)) {
+      return -1;
+    }
+  }
+  Page *page = &pages_[*frame_id];
+  if (page->page_id_ != page_id || page->pin_count_ <= 0) {
+    return -1;
+  }
+
+  // Dirty pages are written back by the flusher or on eviction, never while unpinning. The flag has to be set before
+  // the pin is dropped, otherwise the page could be evicted without being written.
+  if (is_dirty) {
+    MarkFrameDirty(*frame_id);
+  }
+  // A pin of the flusher or the prefetcher is not the caller's to drop. The flag is read again after every read of the
+  // pin count: ReleaseBackgroundPin() clears it before it drops its pin, so a count without that pin is never checked
+  // against a flag that still counts it.
+  int pin_count = page->pin_count_;
+  do {
+    if (pin_count <= (background_pinned_[*frame_id] ? 1 : 0)) {
+      return -1;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  return pin_count - 1;
+}
+
+Page *BufferPoolManager::CreatePage(std::unique_lock<std::mutex> *lock, page_id_t *page_id, bool in_extent,
+                                    page_id_t prev_page_id) {
+  frame_id_t frame_id;
+  if (!AcquireFrame(lock, &frame_id)) {
+    stats_.RecordNewPageFailure();
+    return nullptr;
+  }
+
+  *page_id = AllocatePage(in_extent, prev_page_id);
+  Page *page = &pages_[frame_id];
+  page->BeginWrite();
+  page->page_id_ = *page_id;
+  page->is_dirty_ = false;
+  ResetRecLSN(frame_id);
+  page->ResetMemory();
+  page->EndWrite();
+  prefetched_[frame_id] = false;
+  TouchFrame(frame_id);
+  page->pin_count_ = 1;
+  page_table_.Insert(*page_id, frame_id);
+  replacer_->Pin(frame_id);
+  return page;
+}
+
+Page *BufferPoolManager::TryPinResidentPage(page_id_t page_id) {
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    return nullptr;
+  }
+  // Only add to existing pins: the first pin has to take the frame out of the replacer, which needs the latch. A pinned
+  // frame cannot be claimed, so once our pin is in place the frame can no longer change hands.
+  Page *page = &pages_[frame_id];
+  int pin_count = page->pin_count_;
+  do {
+    if (pin_count <= 0) {
+      return nullptr;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+
+  // The frame may have been reused between the lookup and the pin. Pages that are still being read, or that a scan
+  // consumes for the first time after a prefetch, are handed out by the latched path instead. A read that failed
+  // invalidates the page id before the read stops being pending, so the id is checked after the flag.
+  if (read_pending_[frame_id] || page->page_id_ != page_id || prefetched_[frame_id]) {
+    ProfiledLock guard(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+    DropPin(frame_id);
+    return nullptr;
+  }
+  TouchFrame(frame_id);
+  stats_.RecordHit();
+  return page;
+}
+
+Page *BufferPoolManager::PinMappedPage(page_id_t page_id) {
+  const char *data = disk_manager_->GetMappedPage(page_id);
+  if (data == nullptr) {
+    return nullptr;
+  }
+  std::scoped_lock mapped_lock(mapped_latch_);
+  std::unique_ptr<Page> &page = mapped_pages_[page_id];
+  if (page == nullptr) {
+    // The mapping is read-only, so writes to the view fault instead of corrupting the segment.
+    page.reset(new Page(const_cast<char *>(data)));
+    page->page_id_ = page_id;
+  }
+  page->pin_count_++;
+  stats_.RecordHit();
+  return page.get();
+}
+
+bool BufferPoolManager::UnpinMappedPage(page_id_t page_id, bool is_dirty) {
+  if (!disk_manager_->HasMappedSegments()) {
+    return false;
+  }
+  std::scoped_lock mapped_lock(mapped_latch_);
+  auto it = mapped_pages_.find(page_id);
+  if (it == mapped_pages_.end() || it->second->pin_count_ == 0) {
+    return false;
+  }
+  if (is_dirty) {
+    LOG_DEBUG("Read-only page %d was unpinned as dirty", page_id);
+  }
+  it->second->pin_count_--;
+  return true;
+}
+
+bool BufferPoolManager::ClaimFrame(frame_id_t frame_id) {
+  int pin_count = 0;
+  return pages_[frame_id].pin_count_.compare_exchange_strong(pin_count, -1);
+}
+
+void BufferPoolManager::DropPin(frame_id_t frame_id) {
+  if (--pages_[frame_id].pin_count_ != 0) {
+    return;
+  }
+  if (pages_[frame_id].page_id_ == INVALID_PAGE_ID) {
+    // The read of the page failed. The frame is in no page table, so nobody can pin it meanwhile.
+    bool claimed = ClaimFrame(frame_id);
+    BUSTUB_ASSERT(claimed, "A discarded frame must not be pinned again.");
+    ReleaseFrame(frame_id);
+    return;
+  }
+  replacer_->Unpin(frame_id);
+}
+
+void BufferPoolManager::DiscardFailedRead(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  page_table_.Erase(page->page_id_);
+  // Lock-free fetches check read_pending_ before the page id, so they see the invalid id once the read is no longer
+  // pending.
+  page->page_id_ = INVALID_PAGE_ID;
+  prefetched_[frame_id] = false;
+}
+
+Page *BufferPoolManager::PinResidentPage(std::unique_lock<std::mutex> *lock, page_id_t page_id, frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  page->pin_count_++;
+  replacer_->Pin(frame_id);
+  TouchFrame(frame_id);
+  stats_.RecordHit();
+  // Our pin keeps the frame from being reused, so it still holds page_id once the read has completed.
+  if (read_pending_[frame_id]) {
+    auto start = std::chrono::steady_clock::now();
+    background_pin_cv_.wait(*lock, [&] { return !read_pending_[frame_id]; });
+    stats_.RecordPinWait(std::chrono::steady_clock::now() - start);
+    if (page->page_id_ != page_id) {
+      // The read failed its checksum, see DiscardFailedRead().
+      DropPin(frame_id);
+      stats_.RecordFetchFailure();
+      return nullptr;
+    }
+  }
+
+  if (prefetched_[frame_id]) {
+    // The scan has consumed a page that was read ahead, slide the read-ahead window forward by one page.
+    prefetched_[frame_id] = false;
+    QueuePrefetches(page_id + READ_AHEAD_PAGES * num_instances_, 1);
+  }
+  return page;
+}
+
+bool BufferPoolManager::RecycleFrame(page_id_t page_id, frame_id_t *frame_id) {
+  if (!page_table_.Find(page_id, frame_id) || !ClaimFrame(*frame_id)) {
+    return false;
+  }
+  // Like a victim, the frame is handed on without the accesses of its page.
+  replacer_->Remove(*frame_id);
+  stats_.RecordEviction(pages_[*frame_id].is_dirty_);
+  if (pages_[*frame_id].is_dirty_) {
+    FlushFrame(*frame_id);
+  }
+  ReportAccesses(*frame_id);
+  page_table_.Erase(page_id);
+  return true;
+}
+
+Page *BufferPoolManager::LoadPage(page_id_t page_id, frame_id_t frame_id) {
+  // The frame is published only once it holds the page, a lock-free lookup must never see it half loaded.
+  Page *page = &pages_[frame_id];
+  page->BeginWrite();
+  page->page_id_ = page_id;
+  page->is_dirty_ = false;
+  ResetRecLSN(frame_id);
+  prefetched_[frame_id] = false;
+  const auto start = std::chrono::steady_clock::now();
+  bool valid;
+  {
+    TraceScope trace("page_read", page_id);
+    valid = disk_manager_->ReadPage(page_id, page->data_);
+  }
+  stats_.RecordRead(std::chrono::steady_clock::now() - start);
+  page->EndWrite();
+  if (!valid) {
+    // The page is corrupt, its data must not reach anybody. A later fetch reads it again.
+    ReleaseFrame(frame_id);
+    stats_.RecordFetchFailure();
+    return nullptr;
+  }
+  stats_.RecordMiss();
+  TouchFrame(frame_id);
+  page->pin_count_ = 1;
+  page_table_.Insert(page_id, frame_id);
+  replacer_->Pin(frame_id);
+  return page;
+}
+
+void BufferPoolManager::ReadAhead(page_id_t page_id) {
+  // Within a shard, consecutive pages of a table are num_instances_ ids apart.
+  if (last_miss_page_id_ != INVALID_PAGE_ID && page_id == last_miss_page_id_ + static_cast<page_id_t>(num_instances_)) {
+    num_sequential_misses_++;
+  } else {
+    num_sequential_misses_ = 1;
+  }
+  last_miss_page_id_ = page_id;
+
+  if (num_sequential_misses_ >= static_cast<size_t>(READ_AHEAD_TRIGGER)) {
+    QueuePrefetches(page_id + 1, READ_AHEAD_PAGES * num_instances_);
+  }
+}
+
+void BufferPoolManager::QueuePrefetches(page_id_t start, size_t n) {
+  for (page_id_t page_id = start; page_id < start + static_cast<page_id_t>(n); page_id++) {
+    frame_id_t frame_id;
+    if (static_cast<uint32_t>(page_id) % num_instances_ != instance_index_ || page_table_.Find(page_id, &frame_id) ||
+        disk_manager_->GetMappedPage(page_id) != nullptr) {
+      continue;
+    }
+    if (!IsAllocated(page_id) || !FindReplacementFrame(&frame_id)) {
+      break;
+    }
+
+    // The frame stays pinned by the prefetcher until the read is done. Lock-free lookups may find it right away, so
+    // the pending read is flagged before the frame is published.
+    Page *page = &pages_[frame_id];
+    page->BeginWrite();
+    page->page_id_ = page_id;
+    page->is_dirty_ = false;
+    ResetRecLSN(frame_id);
+    read_pending_[frame_id] = true;
+    prefetched_[frame_id] = true;
+    page->pin_count_ = 1;
+    background_pinned_[frame_id] = true;
+    page_table_.Insert(page_id, frame_id);
+    replacer_->Pin(frame_id);
+    num_background_pins_++;
+    prefetch_queue_.emplace_back(page_id, frame_id);
+  }
+  prefetcher_cv_.notify_one();
+}
+
+bool BufferPoolManager::IsAllocated(page_id_t page_id) { return disk_manager_->IsPageAllocated(page_id); }
+
+void BufferPoolManager::ReleaseBackgroundPin(frame_id_t frame_id) {
+  // The flag is cleared before the pin is dropped, see DecrementPin().
+  background_pinned_[frame_id] = false;
+  DropPin(frame_id);
+  num_background_pins_--;
+  background_pin_cv_.notify_all();
+}
+
+void BufferPoolManager::FlushFrame(frame_id_t frame_id) {
+  // A frame whose read is still in flight holds no data yet, and it is clean anyway.
+  if (read_pending_[frame_id]) {
+    return;
+  }
+  Page *page = &pages_[frame_id];
+  auto start = std::chrono::steady_clock::now();
+  // Write-ahead logging: the log records of the page go to disk before the page does.
+  if (!IsLogPersistent(page)) {
+    log_manager_->WaitUntilPersistent(page->GetLSN());
+  }
+  // Without a pin, every change whose record was appended before is in the page. A pinned page may be in the middle
+  // of one, so it keeps its recLSN.
+  const lsn_t rec_lsn = log_manager_ != nullptr ? log_manager_->GetNextLSN() : 0;
+  const bool unpinned = page->pin_count_ <= 0;
+  disk_manager_->WritePage(page->page_id_, page->GetData());
+  if (unpinned) {
+    rec_lsns_[frame_id].store(rec_lsn, std::memory_order_relaxed);
+  }
+  stats_.RecordFlush(std::chrono::steady_clock::now() - start);
+  if (page->is_dirty_.exchange(false)) {
+    num_dirty_--;
+  }
+}
+
+void BufferPoolManager::MarkFrameDirty(frame_id_t frame_id) {
+  if (pages_[frame_id].is_dirty_.exchange(true)) {
+    return;
+  }
+  if ((num_dirty_.fetch_add(1) + 1) * 100 >= pool_size_ * dirty_page_high_water_mark) {
+    flusher_cv_.notify_one();
+  }
+}
+
+bool BufferPoolManager::IsLogPersistent(Page *page) {
+  if (!enable_logging || log_manager_ == nullptr) {
+    return true;
+  }
+  return page->GetLSN() <= log_manager_->GetPersistentLSN();
+}
+
+bool BufferPoolManager::PinForWriteBack(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  int pin_count = 0;
+  if (!page->is_dirty_ || !IsLogPersistent(page) || !page->pin_count_.compare_exchange_strong(pin_count, 1)) {
+    return false;
+  }
+  background_pinned_[frame_id] = true;
+  replacer_->Pin(frame_id);
+  num_background_pins_++;
+  return true;
+}
+
+void BufferPoolManager::WriteBackFrames(const std::vector<frame_id_t> &frames, char *staging) {
+  // The frames are pinned, so their pages stay put.
+  std::vector<frame_id_t> sorted(frames);
+  std::sort(sorted.begin(), sorted.end(),
+            [this](frame_id_t a, frame_id_t b) { return pages_[a].page_id_ < pages_[b].page_id_; });
+  for (size_t begin = 0; begin < sorted.size(); begin += IO_URING_QUEUE_DEPTH) {
+    const size_t end = std::min(sorted.size(), begin + IO_URING_QUEUE_DEPTH);
+    // Hits do not need the latch, so the page may be pinned and modified meanwhile. Every page is copied under its
+    // latch, so that a write in flight never holds up a writer of the page.
+    std::vector<uint64_t> versions;
+    std::vector<lsn_t> rec_lsns;
+    std::vector<page_id_t> page_ids;
+    std::vector<const char *> copies;
+    for (size_t i = begin; i < end; i++) {
+      Page *page = &pages_[sorted[i]];
+      char *copy = staging + (i - begin) * PAGE_SIZE;
+      page->RLatch();
+      versions.push_back(page->version_.load());
+      // Writers hold the latch from appending their record until the change is in the page.
+      rec_lsns.push_back(log_manager_ != nullptr ? log_manager_->GetNextLSN() : 0);
+      memcpy(copy, page->GetData(), PAGE_SIZE);
+      page->RUnlatch();
+      page_ids.push_back(page->page_id_);
+      copies.push_back(copy);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    disk_manager_->WritePages(page_ids, copies);
+    disk_manager_->SyncPages();
+    const auto latency = std::chrono::steady_clock::now() - start;
+    for (size_t i = begin; i < end; i++) {
+      Page *page = &pages_[sorted[i]];
+      stats_.RecordFlush(latency);
+      // A page that was modified after its copy is still dirty. Modifications that start later are followed by an
+      // unpin that marks the page again.
+      if (page->is_dirty_.exchange(false)) {
+        num_dirty_--;
+      }
+      if (page->version_.load() != versions[i - begin]) {
+        MarkFrameDirty(sorted[i]);
+      } else {
+        rec_lsns_[sorted[i]].store(rec_lsns[i - begin], std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+size_t BufferPoolManager::WriteBackPagesImpl(const std::vector<page_id_t> &page_ids) {
+  // The pages are written without waiting for the log, so the log is forced up to the latest record first.
+  if (enable_logging && log_manager_ != nullptr) {
+    log_manager_->WaitUntilPersistent(log_manager_->GetNextLSN() - 1);
+  }
+  std::unique_ptr<char, decltype(&free)> staging(
+      static_cast<char *>(aligned_alloc(PAGE_SIZE, IO_URING_QUEUE_DEPTH * PAGE_SIZE)), &free);
+  std::vector<frame_id_t> frames;
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  for (page_id_t page_id : page_ids) {
+    frame_id_t frame_id;
+    if (page_table_.Find(page_id, &frame_id) && !read_pending_[frame_id] && PinForWriteBack(frame_id)) {
+      frames.push_back(frame_id);
+    }
+  }
+  lock.unlock();
+  WriteBackFrames(frames, staging.get());
+  lock.lock();
+  for (auto frame_id : frames) {
+    ReleaseBackgroundPin(frame_id);
+  }
+  return frames.size();
+}
+
+void BufferPoolManager::RunFlusher() {
+  // Pages are written from copies, which have to be aligned for direct I/O.
+  std::unique_ptr<char, decltype(&free)> staging(
+      static_cast<char *>(aligned_alloc(PAGE_SIZE, IO_URING_QUEUE_DEPTH * PAGE_SIZE)), &free);
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  while (true) {
+    flusher_cv_.wait_for(lock, flush_interval, [&] {
+      return shutdown_ || num_dirty_ * 100 >= pool_size_ * dirty_page_high_water_mark;
+    });
+    // Unpins do not write their pages, so on shutdown a last pass writes back the ones that are still dirty. Their
+    // records have to be on disk first, like for WriteBackPages().
+    const bool last_pass = shutdown_;
+    if (last_pass) {
+      if (disk_manager_->IsShutDown()) {
+        return;
+      }
+      lock.unlock();
+      if (enable_logging && log_manager_ != nullptr) {
+        log_manager_->WaitUntilPersistent(log_manager_->GetNextLSN() - 1);
+      }
+      lock.lock();
+    }
+
+    // Pin every dirty page that nobody is using so that it can neither be evicted nor deleted while it is written.
+    std::vector<frame_id_t> frames;
+    for (size_t i = 0; i < pool_size_; i++) {
+      if (PinForWriteBack(static_cast<frame_id_t>(i))) {
+        frames.push_back(static_cast<frame_id_t>(i));
+      }
+    }
+    if (frames.empty()) {
+      if (last_pass) {
+        return;
+      }
+      // Nothing can be written right now, wait for the next interval instead of spinning on the high-water mark.
+      flusher_cv_.wait_for(lock, flush_interval, [&] { return shutdown_; });
+      continue;
+    }
+
+    lock.unlock();
+    WriteBackFrames(frames, staging.get());
+    lock.lock();
+
+    for (auto frame_id : frames) {
+      ReleaseBackgroundPin(frame_id);
+    }
+    if (last_pass) {
+      return;
+    }
+  }
+}
+
+void BufferPoolManager::RunPrefetcher() {
+  ProfiledLock lock(&latch_, LatchSite::BUFFER_POOL, instance_index_);
+  while (true) {
+    prefetcher_cv_.wait(lock, [&] { return shutdown_ || !prefetch_queue_.empty(); });
+    // Drain the queue even on shutdown, a fetch may be waiting for one of the reads.
+    if (prefetch_queue_.empty()) {
+      return;
+    }
+    // Take the whole queue, so that all of its reads are in flight at once.
+    std::deque<std::pair<page_id_t, frame_id_t>> batch;
+    batch.swap(prefetch_queue_);
+
+    lock.unlock();
+    std::vector<std::future<bool>> reads;
+    reads.reserve(batch.size());
+    for (const auto &[page_id, frame_id] : batch) {
+      reads.push_back(disk_manager_->ReadPageAsync(page_id, pages_[frame_id].data_));
+    }
+    // Hand out every page as soon as its own read is done, a fetch may be waiting for it.
+    for (size_t i = 0; i < batch.size(); i++) {
+      const bool valid = reads[i].get();
+      frame_id_t frame_id = batch[i].second;
+      lock.lock();
+      if (!valid) {
+        DiscardFailedRead(frame_id);
+      }
+      pages_[frame_id].EndWrite();
+      read_pending_[frame_id] = false;
+      ReleaseBackgroundPin(frame_id);
+      lock.unlock();
+    }
+    lock.lock();
+  }
+}
 
 }  // namespace bustub
@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+namespace bustub {
+
+double BufferPoolStats::HitRatio() const {
+  const uint64_t fetches = fetch_hits + fetch_misses;
+  return fetches == 0 ? 0 : static_cast<double>(fetch_hits) / static_cast<double>(fetches);
+}
+
+BufferPoolStats &BufferPoolStats::operator+=(const BufferPoolStats &other) {
+  fetch_hits += other.fetch_hits;
+  fetch_misses += other.fetch_misses;
+  fetch_failures += other.fetch_failures;
+  new_page_failures += other.new_page_failures;
+  evictions += other.evictions;
+  dirty_evictions += other.dirty_evictions;
+  pin_waits += other.pin_waits;
+  pin_wait_time_us += other.pin_wait_time_us;
+  read_time_us += other.read_time_us;
+  flushes += other.flushes;
+  flush_time_us += other.flush_time_us;
+  for (size_t i = 0; i < NUM_LATENCY_BUCKETS; i++) {
+    flush_latency_us[i] += other.flush_latency_us[i];
+  }
+  return *this;
+}
+
+BufferPoolCounters::Stripe *BufferPoolCounters::GetStripe() {
+  // Threads are spread over the stripes round robin, in the order in which they first record anything.
+  static std::atomic<size_t> next_stripe{0};
+  static thread_local const size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % NUM_STRIPES;
+  return &stripes_[stripe];
+}
+
+void BufferPoolCounters::RecordPinWait(std::chrono::steady_clock::duration wait_time) {
+  Add(&Stripe::pin_waits_, 1);
+  Add(&Stripe::pin_wait_time_us_,
+      static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(wait_time).count()));
+}
+
+void BufferPoolCounters::RecordRead(std::chrono::steady_clock::duration read_time) {
+  Add(&Stripe::read_time_us_,
+      static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(read_time).count()));
+}
+
+void BufferPoolCounters::RecordFlush(std::chrono::steady_clock::duration latency) {
+  auto us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+  size_t bucket = 0;
+  while (us > 0 && bucket < BufferPoolStats::NUM_LATENCY_BUCKETS - 1) {
+    us >>= 1;
+    bucket++;
+  }
+  Stripe *stripe = GetStripe();
+  stripe->flushes_.fetch_add(1, std::memory_order_relaxed);
+  stripe->flush_time_us_.fetch_add(
+      static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count()),
+      std::memory_order_relaxed);
+  stripe->flush_latency_us_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+BufferPoolStats BufferPoolCounters::Snapshot() const {
+  BufferPoolStats stats;
+  for (const auto &stripe : stripes_) {
+    stats.fetch_hits += stripe.fetch_hits_.load(std::memory_order_relaxed);
+    stats.fetch_misses += stripe.fetch_misses_.load(std::memory_order_relaxed);
+    stats.fetch_failures += stripe.fetch_failures_.load(std::memory_order_relaxed);
+    stats.new_page_failures += stripe.new_page_failures_.load(std::memory_order_relaxed);
+    stats.evictions += stripe.evictions_.load(std::memory_order_relaxed);
+    stats.dirty_evictions += stripe.dirty_evictions_.load(std::memory_order_relaxed);
+    stats.pin_waits += stripe.pin_waits_.load(std::memory_order_relaxed);
+    stats.pin_wait_time_us += stripe.pin_wait_time_us_.load(std::memory_order_relaxed);
+    stats.read_time_us += stripe.read_time_us_.load(std::memory_order_relaxed);
+    stats.flushes += stripe.flushes_.load(std::memory_order_relaxed);
+    stats.flush_time_us += stripe.flush_time_us_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < BufferPoolStats::NUM_LATENCY_BUCKETS; i++) {
+      stats.flush_latency_us[i] += stripe.flush_latency_us_[i].load(std::memory_order_relaxed);
+    }
+  }
+  return stats;
+}
+
+}  // namespace bustub
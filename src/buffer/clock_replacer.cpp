@@ -14,101 +14,70 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {
-  this->capacity = num_pages;
-  this->cur_size = 0;
-  this->clock_hand = 0;
-  this->buckets.resize(num_pages, -1);
-  this->ref_bits.resize(num_pages, -1);
-}
+ClockReplacer::ClockReplacer(size_t num_pages) : states_(num_pages) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
 bool ClockReplacer::Victim(frame_id_t *frame_id) {
-  if (cur_size == 0) { return false; }
-
-  int sweep_cnt = 0;
-  while (sweep_cnt < cur_size) {
-    clock_hand %= capacity;
-
-    // empty slot or been recently pinned
-    if (buckets[clock_hand] == -1 || recent_pinned.count(buckets[clock_hand])) {
-      clock_hand++;
+  // While a frame is evictable, the hand gets to it within two sweeps, unless it is pinned or referenced again
+  // meanwhile, which makes it not a victim anyway.
+  while (num_evictable_.load() > 0) {
+    const size_t slot = clock_hand_.fetch_add(1) % states_.size();
+    uint8_t state = states_[slot].load();
+    if ((state & EVICTABLE) == 0) {
       continue;
     }
-
-    // otherwise verify this clock hand position
-    if (ref_bits[clock_hand] == 1) {  // this slot still got ref_bit == 1
-      ref_bits[clock_hand] = 0;
-      clock_hand++;
-      sweep_cnt++;
-    } else {  // find the victim
-      int ans = buckets[clock_hand];
-      *frame_id = ans;
-      buckets[clock_hand] = -1;
-      clock_hand++;
-      auto it = map.find(ans);
-      map.erase(it);
-      cur_size--;
-      return true;
+    if ((state & REFERENCED) != 0) {
+      // If the frame changed meanwhile, the next sweep looks at it again.
+      states_[slot].compare_exchange_strong(state, state & ~REFERENCED);
+      continue;
     }
-  }
-
-  // no victim after whole sweep, then find the smallest frame_id as victim
-  int smallest_frame_id = INT_MAX;
-  for (int i = 0; i < capacity; i++) {
-    if (buckets[i] != -1 && buckets[i] < smallest_frame_id) {
-      smallest_frame_id = buckets[i];
+    if (states_[slot].compare_exchange_strong(state, 0)) {
+      num_evictable_--;
+      *frame_id = static_cast<frame_id_t>(slot);
+      return true;
     }
   }
-  *frame_id = smallest_frame_id;
-  auto it = map.find(smallest_frame_id);
-  map.erase(it);
-  cur_size--;
-  return true;
+  return false;
 }
 
 void ClockReplacer::Pin(frame_id_t frame_id) {
-  if (!map.count(frame_id)) { return; } // this frame_id has not been added into clockReplacer
-
-  recent_pinned.insert(frame_id);
-  cur_size--;
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= states_.size()) {
+    return;
+  }
+  // A frame that is not tracked has no evictable bit, so it stays untracked.
+  if ((states_[frame_id].fetch_and(~EVICTABLE) & EVICTABLE) != 0) {
+    num_evictable_--;
+  }
 }
 
 void ClockReplacer::Unpin(frame_id_t frame_id) {
-  // case 1: if not in the clockReplacer, add <frame_id, 0>
-  // case 2: if in the clockReplacer
-  //    case 2.1: if in the recent_pinned set, set ref_bit = 1
-  //    case 2.2: else, do nothing
-
-  if (frame_id > capacity) { return; }
-
-  if (!map.count(frame_id)) {
-    int slot = find_next_available(clock_hand);
-    buckets[slot] = frame_id;
-    ref_bits[slot] = 0;
-    map[frame_id] = slot;
-    cur_size++;
-  } else if (recent_pinned.count(frame_id)) {
-    auto it = recent_pinned.find(frame_id);
-    recent_pinned.erase(it);
-    ref_bits[map[frame_id]] = 1;
-    cur_size++;
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= states_.size()) {
+    return;
   }
+  // The count goes up first, so that a victim that claims the frame right away never takes it below zero.
+  num_evictable_++;
+  uint8_t state = states_[frame_id].load();
+  uint8_t new_state;
+  do {
+    if ((state & EVICTABLE) != 0) {
+      num_evictable_--;
+      return;
+    }
+    // A frame that comes back after a pin was just used, a new one was not.
+    new_state = (state & TRACKED) != 0 ? TRACKED | EVICTABLE | REFERENCED : TRACKED | EVICTABLE;
+  } while (!states_[frame_id].compare_exchange_weak(state, new_state));
 }
 
-size_t ClockReplacer::Size() { return cur_size; }
-
-auto ClockReplacer::find_next_available(int start) -> int {
-  for (int i = 0; i < capacity; i++) {
-    int cur_slot = (i + start) % capacity;
-    if (buckets[cur_slot] == -1) {
-      return cur_slot;
-    } else if (recent_pinned.count(buckets[cur_slot])) {
-      return cur_slot;
-    }
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= states_.size()) {
+    return;
+  }
+  if ((states_[frame_id].exchange(0) & EVICTABLE) != 0) {
+    num_evictable_--;
   }
-  return -1;
 }
 
+size_t ClockReplacer::Size() { return num_evictable_.load(); }
+
 }  // namespace bustub
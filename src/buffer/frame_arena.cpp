@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <new>
+
+#include "common/logger.h"
+#include "common/util/numa_util.h"
+
+namespace bustub {
+
+namespace {
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+}  // namespace
+
+FrameArena::FrameArena(size_t num_frames, int numa_node) : num_frames_(num_frames) {
+  if (num_frames == 0) {
+    return;
+  }
+  // Round up to whole huge pages, mmap rejects MAP_HUGETLB mappings of any other size.
+  size_ = (num_frames * PAGE_SIZE + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+  void *data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  is_huge_tlb_ = data != MAP_FAILED;
+#endif
+  if (data == MAP_FAILED) {
+    // No huge pages are reserved. Regular anonymous mappings are page aligned, and transparent huge pages can still
+    // back the parts of the mapping that are huge page aligned.
+    data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    if (madvise(data, size_, MADV_HUGEPAGE) != 0) {
+      LOG_DEBUG("Transparent huge pages are not available for the buffer pool.");
+    }
+#endif
+  }
+  data_ = static_cast<char *>(data);
+
+  // The mapping is not touched yet, so binding it places every page of it on the node once it is first written.
+  if (numa_node != ANY_NUMA_NODE) {
+    if (NumaUtil::BindMemory(data_, size_, static_cast<size_t>(numa_node))) {
+      numa_node_ = numa_node;
+    } else {
+      LOG_DEBUG("Could not bind the buffer pool to NUMA node %d.", numa_node);
+    }
+  }
+}
+
+void FrameArena::Discard(frame_id_t first, size_t n) {
+  if (n == 0) {
+    return;
+  }
+  // Huge pages are only released if the whole huge page is discarded, the kernel rejects anything else.
+  if (madvise(GetFrame(first), n * PAGE_SIZE, MADV_DONTNEED) != 0) {
+    LOG_DEBUG("Could not release the memory of %zu buffer pool frames.", n);
+  }
+}
+
+FrameArena::~FrameArena() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : k_(k), frames_(num_pages) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to remember at least one access per frame.");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  if (evictable_.empty()) {
+    return false;
+  }
+  const frame_id_t victim = evictable_.begin()->second;
+  evictable_.erase(evictable_.begin());
+  FrameInfo &info = frames_[victim];
+  info.history_.clear();
+  info.tracked_ = false;
+  info.evictable_ = false;
+  *frame_id = victim;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= frames_.size()) {
+    return;
+  }
+  // The access changes the key, so the frame leaves the evictable frames first.
+  MakeUnevictable(frame_id);
+  FrameInfo &info = frames_[frame_id];
+  RecordAccess(&info);
+  info.tracked_ = true;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= frames_.size()) {
+    return;
+  }
+  FrameInfo &info = frames_[frame_id];
+  if (!info.tracked_) {
+    // The frame was never pinned through the replacer, treat the unpin as its first access.
+    RecordAccess(&info);
+    info.tracked_ = true;
+  }
+  if (!info.evictable_) {
+    info.evictable_ = true;
+    evictable_.emplace(GetEvictionKey(info), frame_id);
+  }
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= frames_.size()) {
+    return;
+  }
+  MakeUnevictable(frame_id);
+  FrameInfo &info = frames_[frame_id];
+  info.history_.clear();
+  info.tracked_ = false;
+}
+
+size_t LRUKReplacer::Size() { return evictable_.size(); }
+
+void LRUKReplacer::MakeUnevictable(frame_id_t frame_id) {
+  FrameInfo &info = frames_[frame_id];
+  if (info.evictable_) {
+    evictable_.erase(GetEvictionKey(info));
+    info.evictable_ = false;
+  }
+}
+
+void LRUKReplacer::RecordAccess(FrameInfo *info) {
+  info->history_.push_back(current_timestamp_++);
+  if (info->history_.size() > k_) {
+    info->history_.pop_front();
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+namespace {
+/** @return the smallest power of two that keeps the table at most half full */
+size_t TableCapacity(size_t num_frames) {
+  size_t capacity = 8;
+  while (capacity < 2 * num_frames) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+}  // namespace
+
+PageTable::PageTable(size_t num_frames)
+    : capacity_(TableCapacity(num_frames)), slots_(new std::atomic<uint64_t>[capacity_]) {
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].store(EMPTY, std::memory_order_relaxed);
+  }
+}
+
+size_t PageTable::Home(page_id_t page_id) const {
+  // Fibonacci hashing spreads the consecutive ids of a table heap over the whole table.
+  return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >> 32) &
+         (capacity_ - 1);
+}
+
+bool PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const {
+  size_t idx = Home(page_id);
+  for (size_t probes = 0; probes < capacity_; probes++) {
+    const uint64_t slot = slots_[idx].load(std::memory_order_acquire);
+    if (slot == EMPTY) {
+      return false;
+    }
+    if (slot != TOMBSTONE && SlotPageId(slot) == page_id) {
+      *frame_id = SlotFrameId(slot);
+      return true;
+    }
+    idx = (idx + 1) & (capacity_ - 1);
+  }
+  return false;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "Only valid pages can be resident.");
+  // Keep at least a quarter of the slots empty so that probes of absent pages terminate quickly.
+  if (4 * (size_ + num_tombstones_ + 1) > 3 * capacity_) {
+    Rebuild();
+  }
+  size_t idx = Home(page_id);
+  while (true) {
+    const uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY || slot == TOMBSTONE) {
+      num_tombstones_ -= slot == TOMBSTONE ? 1 : 0;
+      slots_[idx].store(MakeSlot(page_id, frame_id), std::memory_order_release);
+      size_++;
+      return;
+    }
+    BUSTUB_ASSERT(SlotPageId(slot) != page_id, "A page can only be resident in one frame.");
+    idx = (idx + 1) & (capacity_ - 1);
+  }
+}
+
+bool PageTable::Erase(page_id_t page_id) {
+  size_t idx = Home(page_id);
+  for (size_t probes = 0; probes < capacity_; probes++) {
+    const uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY) {
+      return false;
+    }
+    if (slot != TOMBSTONE && SlotPageId(slot) == page_id) {
+      slots_[idx].store(TOMBSTONE, std::memory_order_release);
+      size_--;
+      num_tombstones_++;
+      return true;
+    }
+    idx = (idx + 1) & (capacity_ - 1);
+  }
+  return false;
+}
+
+void PageTable::Rebuild() {
+  std::vector<uint64_t> live;
+  live.reserve(size_);
+  for (size_t i = 0; i < capacity_; i++) {
+    const uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+    if (slot != EMPTY && slot != TOMBSTONE) {
+      live.push_back(slot);
+    }
+    // Concurrent readers may miss entries from here on, which they tolerate, but never observe a wrong mapping.
+    slots_[i].store(EMPTY, std::memory_order_release);
+  }
+  size_ = 0;
+  num_tombstones_ = 0;
+  for (auto slot : live) {
+    size_t idx = Home(SlotPageId(slot));
+    while (slots_[idx].load(std::memory_order_relaxed) != EMPTY) {
+      idx = (idx + 1) & (capacity_ - 1);
+    }
+    slots_[idx].store(slot, std::memory_order_release);
+    size_++;
+  }
+}
+
+}  // namespace bustub
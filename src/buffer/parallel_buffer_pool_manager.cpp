@@ -0,0 +1,294 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include "common/util/numa_util.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerPolicy replacer_policy, size_t max_pool_size,
+                                                     bool numa_aware)
+    : BufferPoolManager(0, disk_manager, log_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "A buffer pool needs at least one shard.");
+  // The frames live in the shards, this object only routes requests.
+  pool_size_ = num_instances * pool_size;
+  instances_.reserve(num_instances);
+  const size_t num_nodes = numa_aware ? NumaUtil::GetNumNodes() : 0;
+  if (numa_aware) {
+    node_instances_.resize(num_nodes);
+  }
+  for (size_t i = 0; i < num_instances; i++) {
+    int numa_node = FrameArena::ANY_NUMA_NODE;
+    if (numa_aware) {
+      numa_node = static_cast<int>(i % num_nodes);
+      node_instances_[i % num_nodes].push_back(i);
+    }
+    instances_.push_back(new BufferPoolManager(pool_size, static_cast<uint32_t>(num_instances),
+                                               static_cast<uint32_t>(i), disk_manager, log_manager,
+                                               replacer_policy, max_pool_size, numa_node));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // The last dump reads the shards, so it has to happen before they go away.
+  StopWarmStartDumps();
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+std::vector<std::pair<uint64_t, page_id_t>> ParallelBufferPoolManager::GetResidentPagesImpl() {
+  std::vector<std::pair<uint64_t, page_id_t>> pages;
+  for (auto *instance : instances_) {
+    auto shard_pages = instance->GetResidentPagesImpl();
+    pages.insert(pages.end(), shard_pages.begin(), shard_pages.end());
+  }
+  return pages;
+}
+
+std::vector<std::pair<page_id_t, lsn_t>> ParallelBufferPoolManager::GetDirtyPageTableImpl() {
+  std::vector<std::pair<page_id_t, lsn_t>> pages;
+  for (auto *instance : instances_) {
+    auto shard_pages = instance->GetDirtyPageTableImpl();
+    pages.insert(pages.end(), shard_pages.begin(), shard_pages.end());
+  }
+  return pages;
+}
+
+size_t ParallelBufferPoolManager::WriteBackPagesImpl(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> shard_page_ids(instances_.size());
+  for (page_id_t page_id : page_ids) {
+    if (page_id >= 0) {
+      shard_page_ids[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+    }
+  }
+  size_t num_written = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (!shard_page_ids[i].empty()) {
+      num_written += instances_[i]->WriteBackPagesImpl(shard_page_ids[i]);
+    }
+  }
+  return num_written;
+}
+
+size_t ParallelBufferPoolManager::LoadPagesImpl(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> shard_page_ids(instances_.size());
+  for (page_id_t page_id : page_ids) {
+    if (page_id >= 0) {
+      shard_page_ids[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+    }
+  }
+  size_t num_loaded = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (!shard_page_ids[i].empty()) {
+      num_loaded += instances_[i]->LoadPagesImpl(shard_page_ids[i]);
+    }
+  }
+  return num_loaded;
+}
+
+BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
+  return instances_[static_cast<size_t>(page_id) % instances_.size()];
+}
+
+Page *ParallelBufferPoolManager::FetchPageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchPageForScanImpl(page_id_t page_id, BufferRing *ring) {
+  return GetBufferPoolManager(page_id)->FetchPageForScan(page_id, ring);
+}
+
+bool ParallelBufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPageImpl(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+std::vector<size_t> ParallelBufferPoolManager::GetNewPageOrder(size_t *num_preferred) {
+  const size_t num_instances = instances_.size();
+  const size_t rotation = next_instance_.fetch_add(1);
+  std::vector<size_t> order;
+  order.reserve(num_instances);
+  const size_t node = node_instances_.empty() ? 0 : NumaUtil::GetCurrentNode() % node_instances_.size();
+  if (node_instances_.empty() || node_instances_[node].empty()) {
+    for (size_t i = 0; i < num_instances; i++) {
+      order.push_back((rotation + i) % num_instances);
+    }
+    *num_preferred = num_instances;
+    return order;
+  }
+
+  // Shard i lives on node i % node_instances_.size().
+  const std::vector<size_t> &local = node_instances_[node];
+  for (size_t i = 0; i < local.size(); i++) {
+    order.push_back(local[(rotation + i) % local.size()]);
+  }
+  *num_preferred = order.size();
+  for (size_t i = 0; i < num_instances; i++) {
+    const size_t instance = (rotation + i) % num_instances;
+    if (instance % node_instances_.size() != node) {
+      order.push_back(instance);
+    }
+  }
+  return order;
+}
+
+Page *ParallelBufferPoolManager::NewPageImpl(page_id_t *page_id) {
+  size_t num_preferred;
+  for (size_t instance : GetNewPageOrder(&num_preferred)) {
+    Page *page = instances_[instance]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  *page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+Page *ParallelBufferPoolManager::NewPageInExtentImpl(page_id_t prev_page_id, page_id_t *page_id) {
+  std::vector<size_t> order;
+  if (prev_page_id == INVALID_PAGE_ID) {
+    size_t num_preferred;
+    order = GetNewPageOrder(&num_preferred);
+  } else {
+    for (size_t i = 1; i <= instances_.size(); i++) {
+      order.push_back((static_cast<size_t>(prev_page_id) + i) % instances_.size());
+    }
+  }
+  for (size_t instance : order) {
+    Page *page = instances_[instance]->NewPageInExtent(prev_page_id, page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  *page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+std::vector<Page *> ParallelBufferPoolManager::FetchPagesImpl(const std::vector<page_id_t> &page_ids) {
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  std::vector<std::vector<size_t>> shard_indexes(instances_.size());
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    if (page_ids[i] != INVALID_PAGE_ID) {
+      shard_indexes[static_cast<size_t>(page_ids[i]) % instances_.size()].push_back(i);
+    }
+  }
+  for (size_t shard = 0; shard < instances_.size(); shard++) {
+    if (shard_indexes[shard].empty()) {
+      continue;
+    }
+    std::vector<page_id_t> shard_page_ids;
+    for (size_t i : shard_indexes[shard]) {
+      shard_page_ids.push_back(page_ids[i]);
+    }
+    std::vector<Page *> shard_pages = instances_[shard]->FetchPages(shard_page_ids);
+    for (size_t j = 0; j < shard_pages.size(); j++) {
+      pages[shard_indexes[shard][j]] = shard_pages[j];
+    }
+  }
+  return pages;
+}
+
+std::vector<Page *> ParallelBufferPoolManager::NewPagesImpl(size_t n, std::vector<page_id_t> *page_ids) {
+  size_t num_preferred;
+  const std::vector<size_t> order = GetNewPageOrder(&num_preferred);
+  std::vector<Page *> pages;
+  for (size_t i = 0; i < order.size() && pages.size() < n; i++) {
+    // Every remaining shard takes an equal share of what is still missing. The preferred shards split all pages among
+    // themselves, the others only take what the preferred ones had no room for.
+    const size_t num_sharing = i < num_preferred ? num_preferred - i : order.size() - i;
+    const size_t share = (n - pages.size() + num_sharing - 1) / num_sharing;
+    std::vector<page_id_t> shard_page_ids;
+    std::vector<Page *> shard_pages = instances_[order[i]]->NewPages(share, &shard_page_ids);
+    pages.insert(pages.end(), shard_pages.begin(), shard_pages.end());
+    page_ids->insert(page_ids->end(), shard_page_ids.begin(), shard_page_ids.end());
+  }
+  return pages;
+}
+
+bool ParallelBufferPoolManager::UnpinPagesImpl(const std::vector<page_id_t> &page_ids, bool is_dirty) {
+  bool all_pinned = true;
+  std::vector<std::vector<page_id_t>> shard_page_ids(instances_.size());
+  for (page_id_t page_id : page_ids) {
+    if (page_id == INVALID_PAGE_ID) {
+      all_pinned = false;
+      continue;
+    }
+    shard_page_ids[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+  }
+  for (size_t shard = 0; shard < instances_.size(); shard++) {
+    if (!shard_page_ids[shard].empty() && !instances_[shard]->UnpinPages(shard_page_ids[shard], is_dirty)) {
+      all_pinned = false;
+    }
+  }
+  return all_pinned;
+}
+
+bool ParallelBufferPoolManager::DeletePageImpl(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPagesImpl() {
+  for (auto *instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+void ParallelBufferPoolManager::PrefetchPagesImpl(page_id_t start, size_t n) {
+  // Every shard skips the pages of the range that it does not own.
+  for (auto *instance : instances_) {
+    instance->PrefetchPages(start, n);
+  }
+}
+
+bool ParallelBufferPoolManager::ResizeImpl(size_t pool_size) {
+  const size_t num_instances = instances_.size();
+  if (pool_size % num_instances != 0) {
+    return false;
+  }
+  const size_t old_instance_size = pool_size_ / num_instances;
+  for (size_t i = 0; i < num_instances; i++) {
+    if (!instances_[i]->Resize(pool_size / num_instances)) {
+      for (size_t j = 0; j < i; j++) {
+        instances_[j]->Resize(old_instance_size);
+      }
+      return false;
+    }
+  }
+  pool_size_ = pool_size;
+  return true;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStatsImpl() {
+  BufferPoolStats stats;
+  for (auto *instance : instances_) {
+    stats += instance->GetStats();
+  }
+  return stats;
+}
+
+}  // namespace bustub
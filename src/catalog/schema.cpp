@@ -30,6 +30,7 @@ Schema::Schema(const std::vector<Column> &columns) : tuple_is_inlined_(true) {
     // set column offset
     column.column_offset_ = curr_offset;
     curr_offset += column.GetFixedLength();
+    layouts_.push_back(ColumnLayout{column.GetOffset(), column.GetType(), column.IsInlined()});
 
     // add column
     this->columns_.push_back(column);
@@ -0,0 +1,445 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// simple_catalog.cpp
+//
+// Identification: src/catalog/simple_catalog.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "catalog/simple_catalog.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/util/byte_buffer.h"
+#include "storage/page/overflow_page.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the hash of a name in the directory, FNV-1a, so that it does not change with the build */
+uint64_t HashName(const std::string &name) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : name) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+[[noreturn]] void ThrowCorrupt() { throw Exception(ExceptionType::INVALID, "The catalog is corrupt."); }
+
+}  // namespace
+
+SimpleCatalog::SimpleCatalog(BufferPoolManager *bpm, LockManager *lock_manager, LogManager *log_manager,
+                             bool persistent)
+    : SimpleCatalog(bpm, lock_manager, log_manager) {
+  persistent_ = persistent;
+  if (!persistent_) {
+    return;
+  }
+  if (!bpm_->IsAllocated(HEADER_PAGE_ID)) {
+    page_id_t page_id;
+    BasicPageGuard guard = bpm_->NewPageGuarded(&page_id);
+    if (!guard.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for the catalog.");
+    }
+    if (page_id != HEADER_PAGE_ID) {
+      throw Exception(ExceptionType::INVALID, "The catalog must be the first page of the database.");
+    }
+    guard.AsMut<CatalogPage>()->Init(page_id);
+    guard.Drop();
+    bpm_->FlushPage(HEADER_PAGE_ID);
+    return;
+  }
+  ReadPageGuard guard = bpm_->FetchPageRead(HEADER_PAGE_ID);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for the catalog.");
+  }
+  auto page = guard.As<CatalogPage>();
+  if (!page->IsCatalogPage()) {
+    throw Exception(ExceptionType::INVALID, "The first page of the database is not a catalog page.");
+  }
+  next_table_oid_ = page->GetNextTableOid();
+  next_index_oid_ = page->GetNextIndexOid();
+}
+
+TableMetadata *SimpleCatalog::AddTable(CatalogSnapshot *draft, std::unique_ptr<TableMetadata> metadata) {
+  TableMetadata *table_info = metadata.get();
+  tables_.push_back(std::move(metadata));
+  draft->tables_.emplace(table_info->oid_, table_info);
+  draft->names_.emplace(table_info->name_, table_info->oid_);
+  return table_info;
+}
+
+IndexInfo *SimpleCatalog::AddIndex(CatalogSnapshot *draft, std::unique_ptr<IndexInfo> info) {
+  IndexInfo *index_info = info.get();
+  indexes_.push_back(std::move(info));
+  draft->indexes_.emplace(index_info->oid_, index_info);
+  draft->index_names_[index_info->table_name_].emplace(index_info->name_, index_info->oid_);
+  return index_info;
+}
+
+TableMetadata *SimpleCatalog::FindTable(CatalogSnapshot *draft, const std::string &table_name) {
+  auto it = draft->names_.find(table_name);
+  if (it != draft->names_.end()) {
+    return draft->tables_.at(it->second);
+  }
+  if (!persistent_) {
+    return nullptr;
+  }
+  const uint64_t name_hash = HashName(table_name);
+  TableMetadata *result = nullptr;
+  ForEachEntry([&](const CatalogEntry &entry, const RID &) {
+    if (entry.kind_ == CatalogEntryKind::TABLE && entry.name_hash_ == name_hash) {
+      result = LoadTable(draft, entry, &table_name);
+    }
+    return result != nullptr;
+  });
+  return result;
+}
+
+TableMetadata *SimpleCatalog::LoadTable(CatalogSnapshot *draft, table_oid_t table_oid) {
+  auto it = draft->tables_.find(table_oid);
+  if (it != draft->tables_.end()) {
+    return it->second;
+  }
+  TableMetadata *result = nullptr;
+  ForEachEntry([&](const CatalogEntry &entry, const RID &) {
+    if (entry.kind_ == CatalogEntryKind::TABLE && entry.oid_ == table_oid) {
+      result = LoadTable(draft, entry, nullptr);
+    }
+    return result != nullptr;
+  });
+  return result;
+}
+
+IndexInfo *SimpleCatalog::LoadIndex(CatalogSnapshot *draft, index_oid_t index_oid) {
+  std::vector<char> record;
+  ForEachEntry([&](const CatalogEntry &entry, const RID &) {
+    if (entry.kind_ == CatalogEntryKind::INDEX && entry.oid_ == index_oid) {
+      record = ReadRecord(entry);
+      return true;
+    }
+    return false;
+  });
+  if (record.empty()) {
+    return nullptr;
+  }
+  // The index is loaded with its table.
+  ByteReader reader(record.data(), record.size());
+  std::string index_name;
+  table_oid_t table_oid;
+  if (!reader.ReadString(&index_name) || !reader.Read(&table_oid)) {
+    ThrowCorrupt();
+  }
+  LoadTable(draft, table_oid);
+  auto it = draft->indexes_.find(index_oid);
+  return it == draft->indexes_.end() ? nullptr : it->second;
+}
+
+TableMetadata *SimpleCatalog::LoadTable(CatalogSnapshot *draft, const CatalogEntry &entry,
+                                        const std::string *table_name) {
+  const std::vector<char> record = ReadRecord(entry);
+  ByteReader reader(record.data(), record.size());
+  std::string name;
+  page_id_t first_page_id;
+  uint32_t num_columns;
+  if (!reader.ReadString(&name) || !reader.Read(&first_page_id) || !reader.Read(&num_columns)) {
+    ThrowCorrupt();
+  }
+  if (table_name != nullptr && name != *table_name) {
+    return nullptr;
+  }
+  std::vector<Column> columns;
+  for (uint32_t i = 0; i < num_columns; i++) {
+    std::string column_name;
+    TypeId type_id;
+    uint32_t length;
+    if (!reader.ReadString(&column_name) || !reader.Read(&type_id) || !reader.Read(&length)) {
+      ThrowCorrupt();
+    }
+    if (type_id == TypeId::VARCHAR) {
+      columns.emplace_back(column_name, type_id, length);
+    } else {
+      columns.emplace_back(column_name, type_id);
+    }
+  }
+  if (!reader.AtEnd()) {
+    ThrowCorrupt();
+  }
+
+  const Schema schema(columns);
+  auto table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, first_page_id, entry.oid_);
+  table->EnableOverflow(schema);
+  table->EnableZoneMap(schema);
+  TableMetadata *table_info =
+      AddTable(draft, std::make_unique<TableMetadata>(schema, name, std::move(table), entry.oid_));
+
+  // The statistics and the indexes of the table follow it in the directory.
+  const uint64_t name_hash = HashName(name);
+  ForEachEntry([&](const CatalogEntry &other, const RID &) {
+    if (other.kind_ == CatalogEntryKind::STATISTICS && other.oid_ == entry.oid_) {
+      const std::vector<char> stats = ReadRecord(other);
+      if (!table_info->stats_.DeserializeFrom(stats.data(), stats.size())) {
+        ThrowCorrupt();
+      }
+      return false;
+    }
+    if (other.kind_ != CatalogEntryKind::INDEX || other.name_hash_ != name_hash) {
+      return false;
+    }
+    const std::vector<char> index_record = ReadRecord(other);
+    ByteReader index_reader(index_record.data(), index_record.size());
+    std::string index_name;
+    table_oid_t table_oid;
+    uint64_t num_buckets;
+    uint32_t num_key_attrs;
+    if (!index_reader.ReadString(&index_name) || !index_reader.Read(&table_oid) || !index_reader.Read(&num_buckets) ||
+        !index_reader.Read(&num_key_attrs)) {
+      ThrowCorrupt();
+    }
+    if (table_oid != entry.oid_) {
+      return false;
+    }
+    std::vector<uint32_t> key_attrs(num_key_attrs);
+    for (uint32_t &key_attr : key_attrs) {
+      if (!index_reader.Read(&key_attr)) {
+        ThrowCorrupt();
+      }
+    }
+
+    // The index is rebuilt from the live tuples of the table, which nobody writes before it is loaded.
+    auto index = CreateLinearProbeHashTableIndex(
+        new IndexMetadata(index_name, name, &table_info->schema_, key_attrs), bpm_, num_buckets);
+    if (index == nullptr) {
+      ThrowCorrupt();
+    }
+    const Schema *key_schema = index->GetKeySchema();
+    TableHeap *heap = table_info->table_.get();
+    auto insert = [&](const RID &rid, const char *data, uint32_t size) {
+      Tuple tuple(data, size);
+      tuple.SetOverflowStore(heap->GetOverflowStore());
+      index->InsertEntry(tuple.KeyFromTuple(table_info->schema_, *key_schema, key_attrs), rid, nullptr);
+    };
+    for (page_id_t page_id = heap->GetFirstPageId(); page_id != INVALID_PAGE_ID;) {
+      if (!heap->ScanPageInPlace(page_id, nullptr, &page_id, insert)) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for a page of the table heap.");
+      }
+    }
+    AddIndex(draft, std::make_unique<IndexInfo>(std::move(index), index_name, name, other.oid_));
+    return false;
+  });
+  return table_info;
+}
+
+void SimpleCatalog::PersistTable(const TableMetadata &table_info) {
+  std::vector<char> record;
+  ByteWriter writer(&record);
+  writer.WriteString(table_info.name_);
+  writer.Write(table_info.table_->GetFirstPageId());
+  writer.Write(table_info.schema_.GetColumnCount());
+  for (const Column &column : table_info.schema_.GetColumns()) {
+    writer.WriteString(column.GetName());
+    writer.Write(column.GetType());
+    writer.Write(column.GetVariableLength());
+  }
+  const page_id_t record_page_id = WriteRecord(record);
+  AppendEntry(CatalogEntry{CatalogEntryKind::TABLE, table_info.oid_, HashName(table_info.name_), record_page_id,
+                           static_cast<uint32_t>(record.size())});
+  PersistOids();
+}
+
+void SimpleCatalog::PersistIndex(const IndexInfo &index_info, table_oid_t table_oid,
+                                 const std::vector<uint32_t> &key_attrs, size_t num_buckets) {
+  std::vector<char> record;
+  ByteWriter writer(&record);
+  writer.WriteString(index_info.name_);
+  writer.Write(table_oid);
+  writer.Write(static_cast<uint64_t>(num_buckets));
+  writer.Write(static_cast<uint32_t>(key_attrs.size()));
+  for (uint32_t key_attr : key_attrs) {
+    writer.Write(key_attr);
+  }
+  const page_id_t record_page_id = WriteRecord(record);
+  AppendEntry(CatalogEntry{CatalogEntryKind::INDEX, index_info.oid_, HashName(index_info.table_name_), record_page_id,
+                           static_cast<uint32_t>(record.size())});
+  PersistOids();
+}
+
+void SimpleCatalog::PersistStatistics(const TableMetadata &table_info) {
+  if (table_info.table_->GetColumnarSchema() != nullptr) {
+    return;
+  }
+  std::vector<char> record;
+  table_info.stats_.SerializeTo(&record);
+  const CatalogEntry stats_entry{CatalogEntryKind::STATISTICS, table_info.oid_, HashName(table_info.name_),
+                                 WriteRecord(record), static_cast<uint32_t>(record.size())};
+
+  // The entry of the statistics written before points to the new ones once they are on disk.
+  RID location;
+  page_id_t old_record_page_id = INVALID_PAGE_ID;
+  ForEachEntry([&](const CatalogEntry &entry, const RID &entry_location) {
+    if (entry.kind_ == CatalogEntryKind::STATISTICS && entry.oid_ == table_info.oid_) {
+      location = entry_location;
+      old_record_page_id = entry.record_page_id_;
+      return true;
+    }
+    return false;
+  });
+  if (old_record_page_id == INVALID_PAGE_ID) {
+    AppendEntry(stats_entry);
+    return;
+  }
+  {
+    WritePageGuard guard = bpm_->FetchPageWrite(location.GetPageId());
+    if (!guard.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for the catalog.");
+    }
+    guard.AsMut<CatalogPage>()->SetEntry(location.GetSlotNum(), stats_entry);
+  }
+  bpm_->FlushPage(location.GetPageId());
+  FreeRecord(old_record_page_id);
+}
+
+void SimpleCatalog::ForEachEntry(const std::function<bool(const CatalogEntry &, const RID &)> &fn) {
+  for (page_id_t page_id = HEADER_PAGE_ID; page_id != INVALID_PAGE_ID;) {
+    const page_id_t entries_page_id = page_id;
+    std::vector<CatalogEntry> entries;
+    {
+      ReadPageGuard guard = bpm_->FetchPageRead(page_id);
+      if (!guard.IsValid()) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for the catalog.");
+      }
+      auto page = guard.As<CatalogPage>();
+      for (uint32_t slot = 0; slot < page->GetNumEntries(); slot++) {
+        entries.push_back(page->GetEntry(slot));
+      }
+      page_id = page->GetNextPageId();
+    }
+    // The page is let go of first, fn may read records or the directory itself.
+    for (uint32_t slot = 0; slot < entries.size(); slot++) {
+      if (fn(entries[slot], RID(entries_page_id, slot))) {
+        return;
+      }
+    }
+  }
+}
+
+void SimpleCatalog::AppendEntry(const CatalogEntry &entry) {
+  page_id_t page_id = HEADER_PAGE_ID;
+  while (true) {
+    WritePageGuard guard = bpm_->FetchPageWrite(page_id);
+    if (!guard.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for the catalog.");
+    }
+    auto page = guard.AsMut<CatalogPage>();
+    if (page->GetNextPageId() != INVALID_PAGE_ID) {
+      page_id = page->GetNextPageId();
+      continue;
+    }
+    if (page->AppendEntry(entry)) {
+      guard.Drop();
+      bpm_->FlushPage(page_id);
+      return;
+    }
+    // The last page is full, the directory grows by a page that is on disk before the last page links to it.
+    page_id_t new_page_id;
+    BasicPageGuard new_guard = bpm_->NewPageGuarded(&new_page_id);
+    if (!new_guard.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for the catalog.");
+    }
+    auto new_page = new_guard.AsMut<CatalogPage>();
+    new_page->Init(new_page_id);
+    new_page->AppendEntry(entry);
+    new_guard.Drop();
+    bpm_->FlushPage(new_page_id);
+    page->SetNextPageId(new_page_id);
+    guard.Drop();
+    bpm_->FlushPage(page_id);
+    return;
+  }
+}
+
+void SimpleCatalog::PersistOids() {
+  {
+    WritePageGuard guard = bpm_->FetchPageWrite(HEADER_PAGE_ID);
+    if (!guard.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for the catalog.");
+    }
+    auto page = guard.AsMut<CatalogPage>();
+    page->SetNextTableOid(next_table_oid_);
+    page->SetNextIndexOid(next_index_oid_);
+  }
+  bpm_->FlushPage(HEADER_PAGE_ID);
+}
+
+page_id_t SimpleCatalog::WriteRecord(const std::vector<char> &record) {
+  // The chain is written from its last piece to its first one, so that a page knows the next one when it is written.
+  const auto size = static_cast<uint32_t>(record.size());
+  const uint32_t num_pages = std::max<uint32_t>((size + OverflowPage::CAPACITY - 1) / OverflowPage::CAPACITY, 1);
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  for (uint32_t i = num_pages; i-- > 0;) {
+    page_id_t page_id;
+    BasicPageGuard guard = bpm_->NewPageGuarded(&page_id);
+    if (!guard.IsValid()) {
+      FreeRecord(next_page_id);
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for the catalog.");
+    }
+    const uint32_t offset = i * OverflowPage::CAPACITY;
+    guard.AsMut<OverflowPage>()->Init(page_id, next_page_id, record.data() + offset,
+                                      std::min(OverflowPage::CAPACITY, size - offset));
+    guard.Drop();
+    bpm_->FlushPage(page_id);
+    next_page_id = page_id;
+  }
+  return next_page_id;
+}
+
+std::vector<char> SimpleCatalog::ReadRecord(const CatalogEntry &entry) {
+  std::vector<char> record(entry.record_size_);
+  uint32_t offset = 0;
+  for (page_id_t page_id = entry.record_page_id_; page_id != INVALID_PAGE_ID;) {
+    ReadPageGuard guard = bpm_->FetchPageRead(page_id);
+    if (!guard.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for the catalog.");
+    }
+    auto page = guard.As<OverflowPage>();
+    const uint32_t size = page->GetDataSize();
+    if (size > entry.record_size_ - offset) {
+      ThrowCorrupt();
+    }
+    memcpy(record.data() + offset, page->GetPieceData(), size);
+    offset += size;
+    page_id = page->GetNextPageId();
+  }
+  if (offset != entry.record_size_) {
+    ThrowCorrupt();
+  }
+  return record;
+}
+
+void SimpleCatalog::FreeRecord(page_id_t first_page_id) {
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    page_id_t next_page_id;
+    {
+      ReadPageGuard guard = bpm_->FetchPageRead(page_id);
+      if (!guard.IsValid()) {
+        return;
+      }
+      next_page_id = guard.As<OverflowPage>()->GetNextPageId();
+    }
+    bpm_->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+}  // namespace bustub
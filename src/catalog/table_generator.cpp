@@ -1,73 +1,224 @@
 #include "catalog/table_generator.h"
 
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>  // NOLINT
+#include <map>
+#include <mutex>  // NOLINT
 #include <random>
+#include <thread>  // NOLINT
 #include <vector>
 
 namespace bustub {
 
+TableGenerator::Sampler::Sampler(Dist dist, uint64_t min, uint64_t max, uint64_t seed)
+    : dist_(dist), min_(min), num_values_(max - min + 1), generator_(seed) {
+  switch (dist) {
+    case Dist::Zipf_50:
+      theta_ = 0.5;
+      break;
+    case Dist::Zipf_75:
+      theta_ = 0.75;
+      break;
+    case Dist::Zipf_95:
+      theta_ = 0.95;
+      break;
+    case Dist::Zipf_99:
+      theta_ = 0.99;
+      break;
+    default:
+      return;
+  }
+  for (uint64_t i = 1; i <= num_values_; i++) {
+    zeta_n_ += 1.0 / std::pow(static_cast<double>(i), theta_);
+  }
+  const double zeta_2 = 1.0 + 1.0 / std::pow(2.0, theta_);
+  alpha_ = 1.0 / (1.0 - theta_);
+  eta_ = (1.0 - std::pow(2.0 / static_cast<double>(num_values_), 1.0 - theta_)) / (1.0 - zeta_2 / zeta_n_);
+}
+
+uint64_t TableGenerator::Sampler::Next() {
+  switch (dist_) {
+    case Dist::Serial:
+      return min_ + serial_counter_++ % num_values_;
+    case Dist::Uniform:
+      return min_ + std::uniform_int_distribution<uint64_t>(0, num_values_ - 1)(generator_);
+    default:
+      break;
+  }
+  const double u = unit_(generator_);
+  const double uz = u * zeta_n_;
+  if (uz < 1.0 || num_values_ == 1) {
+    return min_;
+  }
+  if (uz < 1.0 + std::pow(0.5, theta_)) {
+    return min_ + 1;
+  }
+  const auto k = static_cast<uint64_t>(static_cast<double>(num_values_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+  return min_ + std::min(k, num_values_ - 1);
+}
+
+void TableGenerator::Sampler::Seed(uint64_t seed) {
+  generator_.seed(seed);
+  serial_counter_ = 0;
+}
+
 template <typename CppType>
-std::vector<Value> TableGenerator::GenNumericValues(ColumnInsertMeta *col_meta, uint32_t count) {
+std::vector<Value> TableGenerator::GenNumericValues(const ColumnInsertMeta &col_meta, uint64_t first_row,
+                                                    uint32_t count, Sampler *sampler, std::mt19937_64 *generator) {
   std::vector<Value> values;
-  if (col_meta->dist_ == Dist::Serial) {
+  values.reserve(count);
+  if (col_meta.dist_ == Dist::Serial) {
     for (uint32_t i = 0; i < count; i++) {
-      values.emplace_back(Value(col_meta->type_, static_cast<CppType>(col_meta->serial_counter_)));
-      col_meta->serial_counter_ += 1;
+      values.emplace_back(Value(col_meta.type_, static_cast<CppType>(col_meta.serial_counter_ + first_row + i)));
     }
     return values;
   }
-  std::default_random_engine generator;
-  // TODO(Amadou): Break up in two branches if this is too weird.
-  std::conditional_t<std::is_integral_v<CppType>, std::uniform_int_distribution<CppType>,
-                     std::uniform_real_distribution<CppType>>
-      distribution(static_cast<CppType>(col_meta->min_), static_cast<CppType>(col_meta->max_));
-  for (uint32_t i = 0; i < count; i++) {
-    values.emplace_back(Value(col_meta->type_, distribution(generator)));
+  if constexpr (std::is_integral_v<CppType>) {
+    for (uint32_t i = 0; i < count; i++) {
+      values.emplace_back(Value(col_meta.type_, static_cast<CppType>(sampler->Next())));
+    }
+  } else {
+    std::uniform_real_distribution<CppType> distribution(static_cast<CppType>(col_meta.min_),
+                                                         static_cast<CppType>(col_meta.max_));
+    for (uint32_t i = 0; i < count; i++) {
+      values.emplace_back(Value(col_meta.type_, distribution(*generator)));
+    }
   }
   return values;
 }
 
-std::vector<Value> TableGenerator::MakeValues(ColumnInsertMeta *col_meta, uint32_t count) {
-  std::vector<Value> values;
-  switch (col_meta->type_) {
+std::vector<Value> TableGenerator::MakeValues(const ColumnInsertMeta &col_meta, uint64_t first_row, uint32_t count,
+                                              Sampler *sampler, std::mt19937_64 *generator) {
+  switch (col_meta.type_) {
     case TypeId::TINYINT:
-      return GenNumericValues<int8_t>(col_meta, count);
+      return GenNumericValues<int8_t>(col_meta, first_row, count, sampler, generator);
     case TypeId::SMALLINT:
-      return GenNumericValues<int16_t>(col_meta, count);
+      return GenNumericValues<int16_t>(col_meta, first_row, count, sampler, generator);
     case TypeId::INTEGER:
-      return GenNumericValues<int32_t>(col_meta, count);
+      return GenNumericValues<int32_t>(col_meta, first_row, count, sampler, generator);
     case TypeId::BIGINT:
-      return GenNumericValues<int64_t>(col_meta, count);
+      return GenNumericValues<int64_t>(col_meta, first_row, count, sampler, generator);
     case TypeId::DECIMAL:
-      return GenNumericValues<double>(col_meta, count);
+      return GenNumericValues<double>(col_meta, first_row, count, sampler, generator);
     default:
       UNREACHABLE("Not yet implemented");
   }
 }
 
-void TableGenerator::FillTable(TableMetadata *info, TableInsertMeta *table_meta) {
-  uint32_t num_inserted = 0;
-  uint32_t batch_size = 128;
-  while (num_inserted < table_meta->num_rows_) {
-    std::vector<std::vector<Value>> values;
-    uint32_t num_values = std::min(batch_size, table_meta->num_rows_ - num_inserted);
-    for (auto &col_meta : table_meta->col_meta_) {
-      values.emplace_back(MakeValues(&col_meta, num_values));
+std::vector<Tuple> TableGenerator::MakeBatch(const TableMetadata *info, const TableInsertMeta &table_meta,
+                                             const TableFillOptions &options, uint64_t batch,
+                                             RowGenerator *row_generator) {
+  const uint64_t first_row = batch * GENERATE_BATCH_SIZE;
+  const auto count = static_cast<uint32_t>(std::min<uint64_t>(GENERATE_BATCH_SIZE, table_meta.num_rows_ - first_row));
+  const uint64_t batch_seed = options.seed_ * 1000003 + batch;
+  row_generator->generator_.seed(batch_seed);
+  std::vector<std::vector<Value>> values;
+  values.reserve(table_meta.col_meta_.size());
+  for (size_t i = 0; i < table_meta.col_meta_.size(); i++) {
+    Sampler *sampler = &row_generator->samplers_[i];
+    sampler->Seed(batch_seed * 31 + i);
+    values.emplace_back(MakeValues(table_meta.col_meta_[i], first_row, count, sampler, &row_generator->generator_));
+  }
+  std::vector<Tuple> tuples;
+  tuples.reserve(count);
+  std::vector<Value> entry;
+  entry.reserve(values.size());
+  for (uint32_t i = 0; i < count; i++) {
+    entry.clear();
+    for (const auto &col : values) {
+      entry.emplace_back(col[i]);
+    }
+    tuples.emplace_back(entry, &info->schema_);
+  }
+  return tuples;
+}
+
+void TableGenerator::FillTable(TableMetadata *info, TableInsertMeta *table_meta, const TableFillOptions &options) {
+  const uint64_t num_batches = (uint64_t{table_meta->num_rows_} + GENERATE_BATCH_SIZE - 1) / GENERATE_BATCH_SIZE;
+  Transaction *txn = exec_ctx_->GetTransaction();
+  auto insert = [&](const std::vector<Tuple> &tuples) {
+    std::vector<RID> rids;
+    const bool inserted = options.bulk_load_ ? info->table_->BulkInsert(tuples, nullptr, txn)
+                                             : info->table_->InsertTuples(tuples, &rids, txn);
+    BUSTUB_ASSERT(inserted, "Sequential insertion cannot fail");
+  };
+  // The threads get copies of the samplers, the Zipf ones are only set up once.
+  RowGenerator row_generator;
+  for (const auto &col_meta : table_meta->col_meta_) {
+    row_generator.samplers_.emplace_back(col_meta.dist_, col_meta.min_, col_meta.max_);
+  }
+
+  if (options.num_threads_ == 0) {
+    for (uint64_t batch = 0; batch < num_batches; batch++) {
+      insert(MakeBatch(info, *table_meta, options, batch, &row_generator));
+    }
+  } else {
+    // The threads generate the batches in the order they take them, and they run at most two batches each ahead of
+    // the inserts, which take the batches in order.
+    const uint64_t max_ahead = 2 * options.num_threads_;
+    std::mutex latch;
+    std::condition_variable cv;
+    std::map<uint64_t, std::vector<Tuple>> ready;
+    uint64_t next_generated = 0;
+    uint64_t next_inserted = 0;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < options.num_threads_; i++) {
+      threads.emplace_back([&, thread_generator = row_generator]() mutable {
+        std::unique_lock<std::mutex> lock(latch);
+        while (true) {
+          cv.wait(lock, [&] { return next_generated >= num_batches || next_generated < next_inserted + max_ahead; });
+          if (next_generated >= num_batches) {
+            return;
+          }
+          const uint64_t batch = next_generated++;
+          lock.unlock();
+          std::vector<Tuple> tuples = MakeBatch(info, *table_meta, options, batch, &thread_generator);
+          lock.lock();
+          ready.emplace(batch, std::move(tuples));
+          cv.notify_all();
+        }
+      });
     }
-    for (uint32_t i = 0; i < num_values; i++) {
-      std::vector<Value> entry;
-      entry.reserve(values.size());
-      for (const auto &col : values) {
-        entry.emplace_back(col[i]);
+    while (next_inserted < num_batches) {
+      std::vector<Tuple> tuples;
+      {
+        std::unique_lock<std::mutex> lock(latch);
+        cv.wait(lock, [&] { return ready.count(next_inserted) != 0; });
+        auto it = ready.find(next_inserted);
+        tuples = std::move(it->second);
+        ready.erase(it);
+        next_inserted++;
       }
-      RID rid;
-      bool inserted = info->table_->InsertTuple(Tuple(entry, &info->schema_), &rid, exec_ctx_->GetTransaction());
-      BUSTUB_ASSERT(inserted, "Sequential insertion cannot fail");
-      num_inserted++;
+      cv.notify_all();
+      insert(tuples);
     }
-    // exec_ctx_->GetBufferPoolManager()->FlushAllPages();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  // Serial columns go on from here if the table is filled again.
+  for (auto &col_meta : table_meta->col_meta_) {
+    col_meta.serial_counter_ += table_meta->num_rows_;
   }
-  LOG_INFO("Wrote %d tuples to table %s.", num_inserted, table_meta->name_);
+  LOG_INFO("Wrote %u tuples to table %s.", table_meta->num_rows_, table_meta->name_);
+}
+
+TableMetadata *TableGenerator::GenerateTable(TableInsertMeta *table_meta, const TableFillOptions &options) {
+  std::vector<Column> cols{};
+  cols.reserve(table_meta->col_meta_.size());
+  for (const auto &col_meta : table_meta->col_meta_) {
+    if (col_meta.type_ != TypeId::VARCHAR) {
+      cols.emplace_back(col_meta.name_, col_meta.type_);
+    } else {
+      cols.emplace_back(col_meta.name_, col_meta.type_, TEST_VARLEN_SIZE);
+    }
+  }
+  Schema schema(cols);
+  auto info = exec_ctx_->GetCatalog()->CreateTable(exec_ctx_->GetTransaction(), table_meta->name_, schema);
+  FillTable(info, table_meta, options);
+  return info;
 }
 
 void TableGenerator::GenerateTestTables() {
@@ -108,19 +259,7 @@ void TableGenerator::GenerateTestTables() {
   };
 
   for (auto &table_meta : insert_meta) {
-    // Create Schema
-    std::vector<Column> cols{};
-    cols.reserve(table_meta.col_meta_.size());
-    for (const auto &col_meta : table_meta.col_meta_) {
-      if (col_meta.type_ != TypeId::VARCHAR) {
-        cols.emplace_back(col_meta.name_, col_meta.type_);
-      } else {
-        cols.emplace_back(col_meta.name_, col_meta.type_, TEST_VARLEN_SIZE);
-      }
-    }
-    Schema schema(cols);
-    auto info = exec_ctx_->GetCatalog()->CreateTable(exec_ctx_->GetTransaction(), table_meta.name_, schema);
-    FillTable(info, &table_meta);
+    GenerateTable(&table_meta);
   }
 }
 }  // namespace bustub
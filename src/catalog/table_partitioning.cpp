@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_partitioning.cpp
+//
+// Identification: src/catalog/table_partitioning.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "catalog/table_partitioning.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "common/util/hash_util.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return true if a comparison of two values holds */
+bool Holds(CmpBool result) { return result == CmpBool::CmpTrue; }
+
+/** @return the comparison that holds for b and a if another holds for a and b */
+ComparisonType Flip(ComparisonType type) {
+  switch (type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return type;
+  }
+}
+
+bool IsInteger(TypeId type) { return type >= TypeId::TINYINT && type <= TypeId::BIGINT; }
+
+}  // namespace
+
+TablePartitioning TablePartitioning::Hash(const Schema &schema, uint32_t col_idx, size_t num_partitions) {
+  BUSTUB_ASSERT(num_partitions > 0, "A table has at least one partition.");
+  return TablePartitioning(PartitionKind::HASH, schema.GetColumn(col_idx).GetType(), col_idx, num_partitions, {});
+}
+
+TablePartitioning TablePartitioning::Range(const Schema &schema, uint32_t col_idx, std::vector<Value> bounds) {
+  for (size_t i = 1; i < bounds.size(); i++) {
+    BUSTUB_ASSERT(Holds(bounds[i - 1].CompareLessThan(bounds[i])), "The bounds of the partitions must ascend.");
+  }
+  const size_t num_partitions = bounds.size() + 1;
+  return TablePartitioning(PartitionKind::RANGE, schema.GetColumn(col_idx).GetType(), col_idx, num_partitions,
+                           std::move(bounds));
+}
+
+bool TablePartitioning::HashAlike(TypeId a, TypeId b) { return a == b || (IsInteger(a) && IsInteger(b)); }
+
+size_t TablePartitioning::PartitionOf(const Value &key) const {
+  if (key.IsNull()) {
+    return 0;
+  }
+  if (kind_ == PartitionKind::HASH) {
+    return HashUtil::HashValue(&key) % num_partitions_;
+  }
+  // The partition of a key is the number of bounds that are not above it.
+  return std::upper_bound(bounds_.begin(), bounds_.end(), key,
+                          [](const Value &a, const Value &b) { return Holds(a.CompareLessThan(b)); }) -
+         bounds_.begin();
+}
+
+std::vector<bool> TablePartitioning::Prune(const AbstractExpression *predicate) const {
+  std::vector<bool> kept(num_partitions_, true);
+  auto comparison = dynamic_cast<const ComparisonExpression *>(predicate);
+  if (comparison == nullptr) {
+    return kept;
+  }
+  ComparisonType type = comparison->GetComparisonType();
+  auto column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  auto constant_expr = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  if (column == nullptr) {
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+    constant_expr = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+    type = Flip(type);
+  }
+  if (column == nullptr || constant_expr == nullptr || column->GetColIdx() != col_idx_ ||
+      type == ComparisonType::NotEqual) {
+    return kept;
+  }
+  const Value &constant = constant_expr->GetValue();
+  // A null passes no comparison, so no partition holds a tuple that passes it.
+  if (constant.IsNull()) {
+    return std::vector<bool>(num_partitions_, false);
+  }
+  if (kind_ == PartitionKind::HASH) {
+    // Only a key that equals the constant, and hashes like it, is in the partition of the constant.
+    if (type == ComparisonType::Equal && HashAlike(key_type_, constant.GetTypeId())) {
+      kept.assign(num_partitions_, false);
+      kept[PartitionOf(constant)] = true;
+    }
+    return kept;
+  }
+  // Partition i holds the keys from bounds_[i - 1] up to, but not including, bounds_[i].
+  for (size_t i = 0; i < num_partitions_; i++) {
+    const Value *lower = i == 0 ? nullptr : &bounds_[i - 1];
+    const Value *upper = i + 1 == num_partitions_ ? nullptr : &bounds_[i];
+    switch (type) {
+      case ComparisonType::Equal:
+        kept[i] = (lower == nullptr || Holds(lower->CompareLessThanEquals(constant))) &&
+                  (upper == nullptr || Holds(upper->CompareGreaterThan(constant)));
+        break;
+      case ComparisonType::LessThan:
+        kept[i] = lower == nullptr || Holds(lower->CompareLessThan(constant));
+        break;
+      case ComparisonType::LessThanOrEqual:
+        kept[i] = lower == nullptr || Holds(lower->CompareLessThanEquals(constant));
+        break;
+      case ComparisonType::GreaterThan:
+      case ComparisonType::GreaterThanOrEqual:
+        kept[i] = upper == nullptr || Holds(upper->CompareGreaterThan(constant));
+        break;
+      default:
+        break;
+    }
+  }
+  return kept;
+}
+
+bool TablePartitioning::IsCoPartitionedWith(const TablePartitioning &other) const {
+  if (kind_ != other.kind_ || num_partitions_ != other.num_partitions_) {
+    return false;
+  }
+  if (kind_ == PartitionKind::HASH) {
+    return HashAlike(key_type_, other.key_type_);
+  }
+  for (size_t i = 0; i < bounds_.size(); i++) {
+    if (!Holds(bounds_[i].CompareEquals(other.bounds_[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace bustub
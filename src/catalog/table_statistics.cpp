@@ -0,0 +1,271 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_statistics.cpp
+//
+// Identification: src/catalog/table_statistics.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "catalog/table_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "common/util/byte_buffer.h"
+#include "common/util/hash_util.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return true if a comparison of two values holds */
+bool Holds(CmpBool result) { return result == CmpBool::CmpTrue; }
+
+/** @return the comparison that holds for b and a if another holds for a and b */
+ComparisonType Flip(ComparisonType type) {
+  switch (type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return type;
+  }
+}
+
+}  // namespace
+
+void TableStatistics::AddTuple(const Tuple &tuple) {
+  num_rows_++;
+  for (uint32_t col_idx = 0; col_idx < columns_.size(); col_idx++) {
+    ColumnStatistics &column = columns_[col_idx];
+    const Value value = tuple.GetValue(schema_, col_idx);
+    if (value.IsNull()) {
+      column.num_nulls_++;
+      continue;
+    }
+    if (!column.has_values_) {
+      column.has_values_ = true;
+      column.min_ = value;
+      column.max_ = value;
+    } else if (Holds(value.CompareLessThan(column.min_))) {
+      column.min_ = value;
+    } else if (Holds(value.CompareGreaterThan(column.max_))) {
+      column.max_ = value;
+    }
+    column.sketch_.Add(HashUtil::HashValue(&value));
+  }
+}
+
+void TableStatistics::Add(const std::vector<Tuple> &tuples) {
+  std::scoped_lock latch(latch_);
+  for (const Tuple &tuple : tuples) {
+    AddTuple(tuple);
+  }
+}
+
+void TableStatistics::Analyze(const std::vector<TableHeap *> &tables, Transaction *txn) {
+  // The statistics are gathered aside, so that inserts are not held up by the scan.
+  TableStatistics fresh(schema_);
+  std::vector<std::vector<Value>> values(columns_.size());
+  for (TableHeap *table : tables) {
+    for (auto it = table->Begin(txn); it != table->End(); ++it) {
+      fresh.AddTuple(*it);
+      for (uint32_t col_idx = 0; col_idx < values.size(); col_idx++) {
+        Value value = it->GetValue(schema_, col_idx);
+        if (!value.IsNull()) {
+          values[col_idx].push_back(std::move(value));
+        }
+      }
+    }
+  }
+  for (uint32_t col_idx = 0; col_idx < values.size(); col_idx++) {
+    std::vector<Value> &column_values = values[col_idx];
+    std::sort(column_values.begin(), column_values.end(),
+              [](const Value &a, const Value &b) { return Holds(a.CompareLessThan(b)); });
+    const size_t num_buckets = std::min(HISTOGRAM_BUCKETS, column_values.size());
+    for (size_t i = 1; i <= num_buckets; i++) {
+      fresh.columns_[col_idx].bounds_.push_back(column_values[i * column_values.size() / num_buckets - 1]);
+    }
+  }
+  std::scoped_lock latch(latch_);
+  num_rows_ = fresh.num_rows_;
+  columns_ = std::move(fresh.columns_);
+  analyzed_ = true;
+}
+
+bool TableStatistics::IsAnalyzed() const {
+  std::scoped_lock latch(latch_);
+  return analyzed_;
+}
+
+size_t TableStatistics::GetNumRows() const {
+  std::scoped_lock latch(latch_);
+  return num_rows_;
+}
+
+ColumnStatistics TableStatistics::GetColumn(uint32_t col_idx) const {
+  std::scoped_lock latch(latch_);
+  return columns_[col_idx];
+}
+
+size_t TableStatistics::GetNumDistinct(uint32_t col_idx) const {
+  std::scoped_lock latch(latch_);
+  return EstimateDistinct(columns_[col_idx], num_rows_ - columns_[col_idx].num_nulls_);
+}
+
+size_t TableStatistics::EstimateDistinct(const ColumnStatistics &column, size_t num_values) {
+  if (num_values == 0) {
+    return 0;
+  }
+  const double estimate = column.sketch_.Estimate();
+  return std::clamp<size_t>(static_cast<size_t>(std::llround(estimate)), 1, num_values);
+}
+
+double TableStatistics::EstimateSelectivity(const AbstractExpression *predicate) const {
+  if (predicate == nullptr) {
+    return 1;
+  }
+  auto comparison = dynamic_cast<const ComparisonExpression *>(predicate);
+  if (comparison == nullptr) {
+    return DEFAULT_SELECTIVITY;
+  }
+  ComparisonType type = comparison->GetComparisonType();
+  auto column_expr = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  auto constant_expr = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  if (column_expr == nullptr) {
+    column_expr = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+    constant_expr = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+    type = Flip(type);
+  }
+  if (column_expr == nullptr || constant_expr == nullptr || column_expr->GetColIdx() >= columns_.size()) {
+    return DEFAULT_SELECTIVITY;
+  }
+  const Value &constant = constant_expr->GetValue();
+  std::scoped_lock latch(latch_);
+  const ColumnStatistics &column = columns_[column_expr->GetColIdx()];
+  const size_t num_values = num_rows_ - column.num_nulls_;
+  // A null passes no comparison, and neither does a constant outside of the values for most of them.
+  if (num_rows_ == 0 || num_values == 0 || constant.IsNull()) {
+    return 0;
+  }
+  const double non_null = static_cast<double>(num_values) / num_rows_;
+  const double equal = Holds(constant.CompareLessThan(column.min_)) || Holds(constant.CompareGreaterThan(column.max_))
+                           ? 0
+                           : 1.0 / EstimateDistinct(column, num_values);
+  if (type == ComparisonType::Equal) {
+    return non_null * equal;
+  }
+  if (type == ComparisonType::NotEqual) {
+    return non_null * (1 - equal);
+  }
+  // The fraction of the values below the constant: the buckets below it, and half of the one that it falls into.
+  double below;
+  if (Holds(constant.CompareLessThanEquals(column.min_))) {
+    below = 0;
+  } else if (Holds(constant.CompareGreaterThan(column.max_))) {
+    below = 1;
+  } else if (column.bounds_.empty()) {
+    below = DEFAULT_SELECTIVITY;
+  } else {
+    auto less = [](const Value &bound, const Value &value) { return Holds(bound.CompareLessThan(value)); };
+    const auto it = std::lower_bound(column.bounds_.begin(), column.bounds_.end(), constant, less);
+    below = (static_cast<double>(it - column.bounds_.begin()) + 0.5) / column.bounds_.size();
+  }
+  double fraction;
+  switch (type) {
+    case ComparisonType::LessThan:
+      fraction = below;
+      break;
+    case ComparisonType::LessThanOrEqual:
+      fraction = below + equal;
+      break;
+    case ComparisonType::GreaterThan:
+      fraction = 1 - below - equal;
+      break;
+    default:
+      fraction = 1 - below;
+      break;
+  }
+  return non_null * std::clamp(fraction, 0.0, 1.0);
+}
+
+void TableStatistics::SerializeTo(std::vector<char> *buffer) const {
+  ByteWriter writer(buffer);
+  std::scoped_lock latch(latch_);
+  writer.Write(static_cast<uint64_t>(num_rows_));
+  writer.Write(static_cast<uint8_t>(analyzed_));
+  for (const ColumnStatistics &column : columns_) {
+    writer.Write(static_cast<uint64_t>(column.num_nulls_));
+    writer.Write(static_cast<uint8_t>(column.has_values_));
+    if (column.has_values_) {
+      writer.WriteValue(column.min_);
+      writer.WriteValue(column.max_);
+    }
+    writer.Write(static_cast<uint32_t>(column.bounds_.size()));
+    for (const Value &bound : column.bounds_) {
+      writer.WriteValue(bound);
+    }
+    writer.Write(column.sketch_);
+  }
+}
+
+bool TableStatistics::DeserializeFrom(const char *data, size_t size) {
+  ByteReader reader(data, size);
+  uint64_t num_rows;
+  uint8_t analyzed;
+  if (!reader.Read(&num_rows) || !reader.Read(&analyzed)) {
+    return false;
+  }
+  std::vector<ColumnStatistics> columns(schema_->GetColumnCount());
+  for (uint32_t col_idx = 0; col_idx < columns.size(); col_idx++) {
+    ColumnStatistics &column = columns[col_idx];
+    const TypeId type_id = schema_->GetColumn(col_idx).GetType();
+    uint64_t num_nulls;
+    uint8_t has_values;
+    uint32_t num_bounds;
+    if (!reader.Read(&num_nulls) || !reader.Read(&has_values)) {
+      return false;
+    }
+    column.num_nulls_ = num_nulls;
+    column.has_values_ = has_values != 0;
+    if (column.has_values_ && (!reader.ReadValue(type_id, &column.min_) || !reader.ReadValue(type_id, &column.max_))) {
+      return false;
+    }
+    if (!reader.Read(&num_bounds)) {
+      return false;
+    }
+    column.bounds_.resize(num_bounds);
+    for (Value &bound : column.bounds_) {
+      if (!reader.ReadValue(type_id, &bound)) {
+        return false;
+      }
+    }
+    if (!reader.Read(&column.sketch_)) {
+      return false;
+    }
+  }
+  if (!reader.AtEnd()) {
+    return false;
+  }
+  std::scoped_lock latch(latch_);
+  num_rows_ = num_rows;
+  analyzed_ = analyzed != 0;
+  columns_ = std::move(columns);
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_logger.cpp
+//
+// Identification: src/common/async_logger.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/async_logger.h"
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <thread>  // NOLINT
+
+#include "common/logger.h"
+
+namespace bustub {
+
+std::atomic<bool> AsyncLogger::running_{false};
+std::atomic<uint64_t> AsyncLogger::num_dropped_{0};
+std::unique_ptr<AsyncLogger::Slot[]> AsyncLogger::slots_;
+size_t AsyncLogger::mask_ = 0;
+std::atomic<size_t> AsyncLogger::enqueue_pos_{0};
+size_t AsyncLogger::dequeue_pos_ = 0;
+std::thread *AsyncLogger::thread_ = nullptr;
+
+void AsyncLogger::Start(size_t capacity) {
+  if (thread_ != nullptr) {
+    return;
+  }
+  if (slots_ == nullptr) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    slots_ = std::make_unique<Slot[]>(size);
+    for (size_t i = 0; i < size; i++) {
+      slots_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+    mask_ = size - 1;
+  }
+  running_.store(true, std::memory_order_release);
+  thread_ = new std::thread(Run);
+}
+
+void AsyncLogger::Stop() {
+  if (thread_ == nullptr) {
+    return;
+  }
+  running_.store(false, std::memory_order_release);
+  thread_->join();
+  delete thread_;
+  thread_ = nullptr;
+}
+
+AsyncLogger::Slot *AsyncLogger::Reserve() {
+  // A slot is free for position pos once its sequence is pos, see Publish() and WriteNext().
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    Slot *slot = &slots_[pos & mask_];
+    const size_t sequence = slot->sequence_.load(std::memory_order_acquire);
+    const auto diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        return slot;
+      }
+    } else if (diff < 0) {
+      // The slot still holds the message of the previous round, which has not been written yet.
+      return nullptr;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool AsyncLogger::WriteNext() {
+  Slot *slot = &slots_[dequeue_pos_ & mask_];
+  if (slot->sequence_.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+    return false;
+  }
+  char message[1024];
+  slot->format_fn_(*slot, message, sizeof(message));
+  OutputLogHeader(slot->file_, slot->line_, slot->func_, slot->level_, slot->time_);
+  ::fprintf(LOG_OUTPUT_STREAM, "%s\n", message);
+  // The slot is free for the next round.
+  slot->sequence_.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+  dequeue_pos_++;
+  return true;
+}
+
+void AsyncLogger::Run() {
+  while (running_.load(std::memory_order_acquire)) {
+    if (!WriteNext()) {
+      ::fflush(LOG_OUTPUT_STREAM);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  while (WriteNext()) {
+  }
+  ::fflush(LOG_OUTPUT_STREAM);
+}
+
+}  // namespace bustub
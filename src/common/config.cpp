@@ -18,6 +18,26 @@ std::atomic<bool> enable_logging(false);
 
 std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
+std::chrono::milliseconds async_commit_delay = std::chrono::milliseconds(5);
+
+std::atomic<int> async_commit_max_lag(1000);
+
+std::chrono::milliseconds flush_interval = std::chrono::milliseconds(100);
+
+std::atomic<size_t> dirty_page_high_water_mark(50);
+
+std::chrono::milliseconds warm_start_interval = std::chrono::seconds(60);
+
+std::chrono::milliseconds checkpoint_flush_interval = std::chrono::milliseconds(10);
+
+std::chrono::milliseconds vacuum_interval = std::chrono::seconds(1);
+
+std::chrono::milliseconds tier_migration_interval = std::chrono::seconds(10);
+
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
+std::chrono::milliseconds wound_check_interval = std::chrono::milliseconds(10);
+
+std::atomic<size_t> lock_escalation_threshold(1000);
+
 }  // namespace bustub
@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_accounting.cpp
+//
+// Identification: src/common/memory_accounting.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/memory_accounting.h"
+
+#include <array>
+#include <string>
+
+#include "common/config.h"
+#include "common/util/metrics.h"
+
+namespace bustub {
+
+namespace {
+
+/** The accounts, which are constant-initialized so that the Values of other static objects may use them. */
+MemoryAccount accounts[NUM_MEMORY_SUBSYSTEMS] = {
+    MemoryAccount(MemorySubsystem::BUFFER_POOL), MemoryAccount(MemorySubsystem::LOCK_TABLE),
+    MemoryAccount(MemorySubsystem::WRITE_SET),   MemoryAccount(MemorySubsystem::HASH_JOIN),
+    MemoryAccount(MemorySubsystem::OPERATOR),    MemoryAccount(MemorySubsystem::VARLEN),
+};
+
+}  // namespace
+
+/**
+ * The charges of a thread that are not in the accounts yet, which it hands on as it exits. What the thread frees
+ * after that, e.g. the Values of static objects, goes to the accounts directly.
+ */
+struct PendingCharges {
+  ~PendingCharges() {
+    for (size_t i = 0; i < NUM_MEMORY_SUBSYSTEMS; i++) {
+      accounts[i].Apply(bytes_[i], count_[i]);
+      bytes_[i] = 0;
+      count_[i] = 0;
+    }
+    exited_ = true;
+  }
+
+  std::array<int64_t, NUM_MEMORY_SUBSYSTEMS> bytes_{};
+  std::array<int64_t, NUM_MEMORY_SUBSYSTEMS> count_{};
+  bool exited_{false};
+};
+
+namespace {
+
+thread_local PendingCharges pending_charges;
+
+}  // namespace
+
+void MemoryAccount::Charge(int64_t bytes, int64_t count) {
+  const auto i = static_cast<size_t>(subsystem_);
+  int64_t &pending_bytes = pending_charges.bytes_[i];
+  int64_t &pending_count = pending_charges.count_[i];
+  pending_bytes += bytes;
+  pending_count += count;
+  if (pending_bytes >= MEMORY_ACCOUNT_BATCH || pending_bytes <= -MEMORY_ACCOUNT_BATCH || pending_charges.exited_) {
+    Apply(pending_bytes, pending_count);
+    pending_bytes = 0;
+    pending_count = 0;
+  }
+}
+
+void MemoryAccount::Apply(int64_t bytes, int64_t count) {
+  if (bytes == 0 && count == 0) {
+    return;
+  }
+  count_.fetch_add(count, std::memory_order_relaxed);
+  const int64_t usage = usage_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  int64_t peak = peak_.load(std::memory_order_relaxed);
+  while (usage > peak && !peak_.compare_exchange_weak(peak, usage, std::memory_order_relaxed)) {
+  }
+}
+
+void MemoryAccount::Flush() {
+  const auto i = static_cast<size_t>(subsystem_);
+  Apply(pending_charges.bytes_[i], pending_charges.count_[i]);
+  pending_charges.bytes_[i] = 0;
+  pending_charges.count_[i] = 0;
+}
+
+MemoryAccount *MemoryAccounting::Get(MemorySubsystem subsystem) { return &accounts[static_cast<size_t>(subsystem)]; }
+
+const char *MemoryAccounting::GetName(MemorySubsystem subsystem) {
+  switch (subsystem) {
+    case MemorySubsystem::BUFFER_POOL:
+      return "buffer_pool";
+    case MemorySubsystem::LOCK_TABLE:
+      return "lock_table";
+    case MemorySubsystem::WRITE_SET:
+      return "write_set";
+    case MemorySubsystem::HASH_JOIN:
+      return "hash_join";
+    case MemorySubsystem::OPERATOR:
+      return "operator";
+    case MemorySubsystem::VARLEN:
+      return "varlen";
+  }
+  return "unknown";
+}
+
+void MemoryAccounting::CollectMetrics(MetricsSnapshot *snapshot) {
+  for (size_t i = 0; i < NUM_MEMORY_SUBSYSTEMS; i++) {
+    const auto subsystem = static_cast<MemorySubsystem>(i);
+    const MemoryAccount *account = Get(subsystem);
+    const std::string labels = std::string("subsystem=\"") + GetName(subsystem) + "\"";
+    snapshot->AddGauge("bustub_memory_bytes", "Bytes that a subsystem holds.", static_cast<double>(account->GetUsage()),
+                       labels);
+    snapshot->AddGauge("bustub_memory_peak_bytes", "Most bytes that a subsystem has held at a time.",
+                       static_cast<double>(account->GetPeak()), labels);
+    snapshot->AddGauge("bustub_memory_allocations", "Allocations that the bytes of a subsystem are in.",
+                       static_cast<double>(account->GetNumAllocations()), labels);
+    snapshot->AddGauge("bustub_memory_soft_limit_bytes", "Soft limit of the bytes of a subsystem, 0 for none.",
+                       static_cast<double>(account->GetSoftLimit()), labels);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// rwlatch.cpp
+//
+// Identification: src/common/rwlatch.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/rwlatch.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <climits>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#endif
+
+namespace bustub {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "A futex is a plain 32-bit word.");
+
+void ReaderWriterLatch::Wait(std::atomic<uint32_t> *word, uint32_t expected) {
+#if defined(SYS_futex) && defined(FUTEX_WAIT_PRIVATE)
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+  if (word->load() == expected) {
+    std::this_thread::yield();
+  }
+#endif
+}
+
+void ReaderWriterLatch::WakeAll(std::atomic<uint32_t> *word) {
+#if defined(SYS_futex) && defined(FUTEX_WAKE_PRIVATE)
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+void ReaderWriterLatch::Pause() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+void ReaderWriterLatch::WLockSlow() {
+  // Enter as the writer first, which keeps new readers out.
+  for (int spins = 0;; spins++) {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & WRITER) == 0) {
+      if (state_.compare_exchange_weak(state, state | WRITER, std::memory_order_acquire)) {
+        break;
+      }
+      continue;
+    }
+    if (spins < LATCH_SPINS) {
+      Pause();
+      continue;
+    }
+    if ((state & WAITERS) == 0 && !state_.compare_exchange_weak(state, state | WAITERS, std::memory_order_relaxed)) {
+      continue;
+    }
+    Wait(&state_, state | WAITERS);
+  }
+  // Then wait for the readers inside to leave.
+  for (int spins = 0;; spins++) {
+    uint32_t state = state_.load(std::memory_order_acquire);
+    if ((state & READERS) == 0) {
+      return;
+    }
+    if (spins < LATCH_SPINS) {
+      Pause();
+      continue;
+    }
+    if ((state & WAITERS) == 0 && !state_.compare_exchange_weak(state, state | WAITERS, std::memory_order_relaxed)) {
+      continue;
+    }
+    Wait(&state_, state | WAITERS);
+  }
+}
+
+void ReaderWriterLatch::RLockSlow() {
+  for (int spins = 0;; spins++) {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & WRITER) == 0) {
+      BUSTUB_ASSERT((state & READERS) != READERS, "Too many readers.");
+      if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+        return;
+      }
+      continue;
+    }
+    if (spins < LATCH_SPINS) {
+      Pause();
+      continue;
+    }
+    // The waiters bit may only be set while there is a writer, which clears it when it is done.
+    if ((state & WAITERS) == 0 && !state_.compare_exchange_weak(state, state | WAITERS, std::memory_order_relaxed)) {
+      continue;
+    }
+    Wait(&state_, state | WAITERS);
+  }
+}
+
+void DistributedReaderWriterLatch::WLock() {
+  writer_mutex_.lock();
+  writer_.store(1);
+  for (int spins = 0;; spins++) {
+    // The sequence is read before the counters, so that a reader that leaves afterwards changes it.
+    const uint32_t seq = drain_seq_.load();
+    int64_t readers = 0;
+    for (const auto &slot : slots_) {
+      readers += slot.count_.load();
+    }
+    if (readers == 0) {
+      return;
+    }
+    if (spins < LATCH_SPINS) {
+      ReaderWriterLatch::Pause();
+      continue;
+    }
+    ReaderWriterLatch::Wait(&drain_seq_, seq);
+  }
+}
+
+void DistributedReaderWriterLatch::WUnlock() {
+  writer_.store(0);
+  ReaderWriterLatch::WakeAll(&writer_);
+  writer_mutex_.unlock();
+}
+
+void DistributedReaderWriterLatch::RLockSlow(std::atomic<int64_t> *count) {
+  for (;;) {
+    count->fetch_sub(1);
+    WakeWriter();
+    for (int spins = 0; writer_.load() != 0; spins++) {
+      if (spins < LATCH_SPINS) {
+        ReaderWriterLatch::Pause();
+      } else {
+        ReaderWriterLatch::Wait(&writer_, 1);
+      }
+    }
+    count->fetch_add(1);
+    if (writer_.load() == 0) {
+      return;
+    }
+  }
+}
+
+void DistributedReaderWriterLatch::WakeWriter() {
+  drain_seq_.fetch_add(1);
+  ReaderWriterLatch::WakeAll(&drain_seq_);
+}
+
+}  // namespace bustub
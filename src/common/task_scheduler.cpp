@@ -0,0 +1,169 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// task_scheduler.cpp
+//
+// Identification: src/common/task_scheduler.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/task_scheduler.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+namespace {
+
+/** The scheduler whose worker the calling thread is, and its index among the workers. */
+thread_local const TaskScheduler *current_scheduler = nullptr;
+thread_local size_t current_worker = 0;
+/** The waits of RunPendingTasksUntil() that the calling thread is in, of any scheduler. */
+thread_local size_t wait_depth = 0;
+
+}  // namespace
+
+TaskScheduler::NestedWait::NestedWait() : may_run_tasks_(wait_depth < static_cast<size_t>(TASK_WAIT_MAX_DEPTH)) {
+  wait_depth++;
+}
+
+TaskScheduler::NestedWait::~NestedWait() { wait_depth--; }
+
+TaskScheduler::TaskScheduler(size_t num_threads, bool pin_threads) {
+  num_threads = std::max<size_t>(num_threads, 1);
+  std::vector<int> cpus;
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (pin_threads && sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  for (size_t i = 0; i < num_threads; i++) {
+    queues_.push_back(std::make_unique<TaskQueue>());
+  }
+  for (size_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back(&TaskScheduler::RunWorker, this, i);
+    if (!cpus.empty()) {
+      cpu_set_t cpu;
+      CPU_ZERO(&cpu);
+      CPU_SET(cpus[i % cpus.size()], &cpu);
+      pthread_setaffinity_np(threads_.back().native_handle(), sizeof(cpu), &cpu);
+    }
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  {
+    std::scoped_lock lock(latch_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t TaskScheduler::GetWorkerIndex() const {
+  return current_scheduler == this ? current_worker : queues_.size();
+}
+
+void TaskScheduler::Submit(Task task, TaskPriority priority) {
+  if (priority == TaskPriority::BACKGROUND) {
+    std::scoped_lock lock(background_.latch_);
+    background_.tasks_.push_back(std::move(task));
+  } else {
+    size_t index = GetWorkerIndex();
+    if (index == queues_.size()) {
+      index = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    }
+    std::scoped_lock lock(queues_[index]->latch_);
+    queues_[index]->tasks_.push_back(std::move(task));
+    num_pending_normal_.fetch_add(1, std::memory_order_relaxed);
+  }
+  num_pending_.fetch_add(1, std::memory_order_release);
+  // The latch orders the count before the check of a worker that is about to sleep, so the wake-up is not lost.
+  { std::scoped_lock lock(latch_); }
+  cv_.notify_one();
+}
+
+bool TaskScheduler::TakeTask(size_t index, bool background, Task *task) {
+  const size_t num_queues = queues_.size();
+  if (num_pending_normal_.load(std::memory_order_acquire) != 0) {
+    if (index < num_queues) {
+      TaskQueue *own = queues_[index].get();
+      std::scoped_lock lock(own->latch_);
+      if (!own->tasks_.empty()) {
+        *task = std::move(own->tasks_.back());
+        own->tasks_.pop_back();
+        num_pending_normal_.fetch_sub(1, std::memory_order_relaxed);
+        num_pending_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    for (size_t i = 1; i <= num_queues; i++) {
+      TaskQueue *victim = queues_[(index + i) % num_queues].get();
+      std::scoped_lock lock(victim->latch_);
+      if (!victim->tasks_.empty()) {
+        *task = std::move(victim->tasks_.front());
+        victim->tasks_.pop_front();
+        num_pending_normal_.fetch_sub(1, std::memory_order_relaxed);
+        num_pending_.fetch_sub(1, std::memory_order_relaxed);
+        if (index < num_queues) {
+          num_steals_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+      }
+    }
+  }
+  if (background) {
+    std::scoped_lock lock(background_.latch_);
+    if (!background_.tasks_.empty()) {
+      *task = std::move(background_.tasks_.front());
+      background_.tasks_.pop_front();
+      num_pending_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TaskScheduler::RunPendingTask() {
+  Task task;
+  if (!TakeTask(GetWorkerIndex(), false, &task)) {
+    return false;
+  }
+  task();
+  return true;
+}
+
+void TaskScheduler::RunWorker(size_t index) {
+  current_scheduler = this;
+  current_worker = index;
+  Task task;
+  while (true) {
+    if (TakeTask(index, true, &task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock lock(latch_);
+    // The tasks that were submitted are all run before the workers stop.
+    cv_.wait(lock, [&] { return stop_ || num_pending_.load(std::memory_order_acquire) != 0; });
+    if (stop_ && num_pending_.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// contention_profiler.cpp
+//
+// Identification: src/common/util/contention_profiler.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/contention_profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+
+namespace bustub {
+
+namespace {
+
+/** Waits of different resources are recorded under different latches, so that the profiler adds little contention. */
+constexpr size_t PROFILER_STRIPES = 64;
+
+struct Stripe {
+  std::mutex latch_;
+  std::unordered_map<int64_t, ContentionStats> stats_;
+};
+
+std::array<std::array<Stripe, PROFILER_STRIPES>, static_cast<size_t>(LatchSite::NUM_LATCH_SITES)> stripes;
+
+}  // namespace
+
+void ContentionProfiler::Record(LatchSite site, int64_t key, uint64_t start) {
+  const uint64_t wait_ns = Now() - start;
+  Stripe &stripe = stripes[static_cast<size_t>(site)][std::hash<int64_t>()(key) % PROFILER_STRIPES];
+  std::lock_guard<std::mutex> guard(stripe.latch_);
+  auto it = stripe.stats_.try_emplace(key, ContentionStats{site, key, 0, 0, 0}).first;
+  it->second.waits_++;
+  it->second.total_wait_ns_ += wait_ns;
+  it->second.max_wait_ns_ = std::max(it->second.max_wait_ns_, wait_ns);
+}
+
+std::vector<ContentionStats> ContentionProfiler::GetTopContended(size_t n) {
+  std::vector<ContentionStats> all;
+  for (auto &site : stripes) {
+    for (auto &stripe : site) {
+      std::lock_guard<std::mutex> guard(stripe.latch_);
+      for (const auto &entry : stripe.stats_) {
+        all.push_back(entry.second);
+      }
+    }
+  }
+  auto longer = [](const ContentionStats &a, const ContentionStats &b) { return a.total_wait_ns_ > b.total_wait_ns_; };
+  if (all.size() > n) {
+    std::partial_sort(all.begin(), all.begin() + n, all.end(), longer);
+    all.resize(n);
+  } else {
+    std::sort(all.begin(), all.end(), longer);
+  }
+  return all;
+}
+
+std::string ContentionProfiler::Report(size_t n) {
+  std::ostringstream os;
+  for (const ContentionStats &stats : GetTopContended(n)) {
+    os << GetSiteName(stats.site_) << " " << stats.key_ << ": " << stats.waits_ << " waits, "
+       << stats.total_wait_ns_ / 1000 << " us total, " << stats.max_wait_ns_ / 1000 << " us max\n";
+  }
+  return os.str();
+}
+
+void ContentionProfiler::Reset() {
+  for (auto &site : stripes) {
+    for (auto &stripe : site) {
+      std::lock_guard<std::mutex> guard(stripe.latch_);
+      stripe.stats_.clear();
+    }
+  }
+}
+
+const char *ContentionProfiler::GetSiteName(LatchSite site) {
+  switch (site) {
+    case LatchSite::PAGE_READ:
+      return "page_read";
+    case LatchSite::PAGE_WRITE:
+      return "page_write";
+    case LatchSite::BUFFER_POOL:
+      return "buffer_pool";
+    case LatchSite::LOCK_PARTITION:
+      return "lock_partition";
+    case LatchSite::LOCK_TABLE:
+      return "lock_table";
+    case LatchSite::ROW_LOCK:
+      return "row_lock";
+    case LatchSite::TABLE_LOCK:
+      return "table_lock";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace bustub
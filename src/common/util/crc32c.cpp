@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.cpp
+//
+// Identification: src/common/util/crc32c.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+// The reflected Castagnoli polynomial.
+constexpr uint32_t CRC32C_POLYNOMIAL = 0x82f63b78;
+
+std::array<uint32_t, 256> MakeTable() {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < table.size(); i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLYNOMIAL : 0);
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+uint32_t ExtendSoftware(uint32_t crc, const char *data, size_t len) {
+  static const std::array<uint32_t, 256> table = MakeTable();
+  for (size_t i = 0; i < len; i++) {
+    crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xff] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t ExtendHardware(uint32_t crc, const char *data, size_t len) {
+  uint64_t crc64 = crc;
+  for (; len >= sizeof(uint64_t); data += sizeof(uint64_t), len -= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  auto crc32 = static_cast<uint32_t>(crc64);
+  for (; len > 0; data++, len--) {
+    crc32 = _mm_crc32_u8(crc32, static_cast<uint8_t>(*data));
+  }
+  return crc32;
+}
+#endif
+
+}  // namespace
+
+uint32_t Crc32c::Extend(uint32_t crc, const char *data, size_t len) {
+  // The checksum is kept inverted while data is added.
+  crc = ~crc;
+#if defined(__x86_64__)
+  if (IsHardwareAccelerated()) {
+    return ~ExtendHardware(crc, data, len);
+  }
+#endif
+  return ~ExtendSoftware(crc, data, len);
+}
+
+bool Crc32c::IsHardwareAccelerated() {
+#if defined(__x86_64__)
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  return has_sse42;
+#else
+  return false;
+#endif
+}
+
+}  // namespace bustub
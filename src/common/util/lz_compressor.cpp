@@ -0,0 +1,168 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_compressor.cpp
+//
+// Identification: src/common/util/lz_compressor.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/lz_compressor.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 0xffff;
+constexpr int HASH_BITS = 12;
+
+uint32_t Read32(const char *data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32_t Hash(uint32_t value) { return (value * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Writes the bytes of a length that did not fit into its nibble. */
+bool WriteLength(size_t length, char *dst, size_t dst_capacity, size_t *op) {
+  for (; length >= 255; length -= 255) {
+    if (*op >= dst_capacity) {
+      return false;
+    }
+    dst[(*op)++] = static_cast<char>(255);
+  }
+  if (*op >= dst_capacity) {
+    return false;
+  }
+  dst[(*op)++] = static_cast<char>(length);
+  return true;
+}
+
+/** Reads the bytes of a length that did not fit into its nibble. */
+bool ReadLength(const char *src, size_t src_size, size_t *ip, size_t *length) {
+  uint8_t byte;
+  do {
+    if (*ip >= src_size) {
+      return false;
+    }
+    byte = static_cast<uint8_t>(src[(*ip)++]);
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * Writes a sequence of the literals src[anchor, ip) and, if match_length is not 0, a match.
+ * @return false if the sequence does not fit into dst
+ */
+bool WriteSequence(const char *src, size_t anchor, size_t ip, size_t offset, size_t match_length, char *dst,
+                   size_t dst_capacity, size_t *op) {
+  const size_t literal_length = ip - anchor;
+  const size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+  if (*op >= dst_capacity) {
+    return false;
+  }
+  dst[(*op)++] = static_cast<char>((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(match_code, 15));
+  if (literal_length >= 15 && !WriteLength(literal_length - 15, dst, dst_capacity, op)) {
+    return false;
+  }
+  if (*op + literal_length > dst_capacity) {
+    return false;
+  }
+  memcpy(dst + *op, src + anchor, literal_length);
+  *op += literal_length;
+  if (match_length == 0) {
+    return true;
+  }
+  if (*op + 2 > dst_capacity) {
+    return false;
+  }
+  dst[(*op)++] = static_cast<char>(offset & 0xff);
+  dst[(*op)++] = static_cast<char>(offset >> 8);
+  return match_code < 15 || WriteLength(match_code - 15, dst, dst_capacity, op);
+}
+
+}  // namespace
+
+size_t LzCompressor::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) {
+  // The last position that each hash of 4 bytes was seen at, plus one so that 0 means never.
+  std::array<uint32_t, 1 << HASH_BITS> table{};
+  size_t ip = 0;
+  size_t anchor = 0;
+  size_t op = 0;
+  while (ip + MIN_MATCH <= src_size) {
+    const uint32_t value = Read32(src + ip);
+    const uint32_t hash = Hash(value);
+    const size_t candidate = table[hash];
+    table[hash] = static_cast<uint32_t>(ip + 1);
+    if (candidate == 0 || ip + 1 - candidate > MAX_OFFSET || Read32(src + candidate - 1) != value) {
+      ip++;
+      continue;
+    }
+    const size_t match = candidate - 1;
+    size_t match_length = MIN_MATCH;
+    while (ip + match_length < src_size && src[match + match_length] == src[ip + match_length]) {
+      match_length++;
+    }
+    if (!WriteSequence(src, anchor, ip, ip - match, match_length, dst, dst_capacity, &op)) {
+      return 0;
+    }
+    ip += match_length;
+    anchor = ip;
+  }
+  if (!WriteSequence(src, anchor, src_size, 0, 0, dst, dst_capacity, &op)) {
+    return 0;
+  }
+  return op;
+}
+
+size_t LzCompressor::Decompress(const char *src, size_t src_size, char *dst, size_t dst_capacity) {
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < src_size) {
+    const auto token = static_cast<uint8_t>(src[ip++]);
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(src, src_size, &ip, &literal_length)) {
+      return 0;
+    }
+    if (ip + literal_length > src_size || op + literal_length > dst_capacity) {
+      return 0;
+    }
+    memcpy(dst + op, src + ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    if (ip == src_size) {
+      break;
+    }
+    if (ip + 2 > src_size) {
+      return 0;
+    }
+    const size_t offset = static_cast<uint8_t>(src[ip]) | (static_cast<size_t>(static_cast<uint8_t>(src[ip + 1])) << 8);
+    ip += 2;
+    size_t match_length = token & 15;
+    if (match_length == 15 && !ReadLength(src, src_size, &ip, &match_length)) {
+      return 0;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > op || op + match_length > dst_capacity) {
+      return 0;
+    }
+    // Matches may overlap the bytes they produce, so they are copied byte by byte.
+    for (size_t i = 0; i < match_length; i++, op++) {
+      dst[op] = dst[op - offset];
+    }
+  }
+  return op;
+}
+
+}  // namespace bustub
@@ -0,0 +1,316 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics.cpp
+//
+// Identification: src/common/util/metrics.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return a value as Prometheus expects it, integers without a fraction */
+std::string FormatValue(double value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.15g", value);
+  return buf;
+}
+
+/** @return the name of a metric with its labels and an extra label, e.g. quantile="0.99" */
+std::string FormatSeries(const std::string &name, const std::string &labels, const std::string &extra = "") {
+  if (labels.empty() && extra.empty()) {
+    return name;
+  }
+  if (labels.empty() || extra.empty()) {
+    return name + "{" + labels + extra + "}";
+  }
+  return name + "{" + labels + "," + extra + "}";
+}
+
+const char *GetTypeName(MetricType type) {
+  switch (type) {
+    case MetricType::COUNTER:
+      return "counter";
+    case MetricType::GAUGE:
+      return "gauge";
+    case MetricType::HISTOGRAM:
+      return "summary";
+  }
+  return "untyped";
+}
+
+}  // namespace
+
+uint64_t MetricCounter::Value() const {
+  uint64_t sum = 0;
+  for (const Stripe &stripe : stripes_) {
+    sum += stripe.value_.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+size_t MetricCounter::GetStripe() {
+  static std::atomic<size_t> next_stripe{0};
+  static thread_local const size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % METRIC_STRIPES;
+  return stripe;
+}
+
+size_t HistogramSnapshot::GetBucket(uint64_t value) {
+  if (value < SUB_BUCKETS) {
+    return value;
+  }
+  // The position of the highest set bit, at least SUB_BUCKET_BITS; the SUB_BUCKET_BITS bits below it pick the bucket.
+  const size_t exponent = 63 - __builtin_clzll(value);
+  if (exponent > MAX_EXPONENT) {
+    return NUM_BUCKETS - 1;
+  }
+  const size_t sub_bucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+  return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t HistogramSnapshot::GetBucketUpperBound(size_t bucket) {
+  if (bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+  if (bucket >= NUM_BUCKETS - 1) {
+    return UINT64_MAX;
+  }
+  const size_t exponent = (bucket - SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS;
+  const uint64_t sub_bucket = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+  const size_t shift = exponent - SUB_BUCKET_BITS;
+  return ((SUB_BUCKETS + sub_bucket + 1) << shift) - 1;
+}
+
+uint64_t HistogramSnapshot::Percentile(double fraction) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count_))));
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < buckets_.size(); bucket++) {
+    seen += buckets_[bucket];
+    if (seen >= rank) {
+      return std::min(GetBucketUpperBound(bucket), max_);
+    }
+  }
+  return max_;
+}
+
+HistogramSnapshot &HistogramSnapshot::operator+=(const HistogramSnapshot &other) {
+  count_ += other.count_;
+  sum_ += other.sum_;
+  max_ = std::max(max_, other.max_);
+  for (size_t bucket = 0; bucket < buckets_.size(); bucket++) {
+    buckets_[bucket] += other.buckets_[bucket];
+  }
+  return *this;
+}
+
+MetricHistogram::~MetricHistogram() {
+  for (auto &stripe : stripes_) {
+    delete stripe.load();
+  }
+}
+
+void MetricHistogram::Record(uint64_t value) {
+  std::atomic<Stripe *> &slot = stripes_[MetricCounter::GetStripe()];
+  Stripe *stripe = slot.load(std::memory_order_acquire);
+  if (stripe == nullptr) {
+    auto *created = new Stripe();
+    if (slot.compare_exchange_strong(stripe, created, std::memory_order_acq_rel)) {
+      stripe = created;
+    } else {
+      delete created;
+    }
+  }
+  stripe->count_.fetch_add(1, std::memory_order_relaxed);
+  stripe->sum_.fetch_add(value, std::memory_order_relaxed);
+  uint64_t max = stripe->max_.load(std::memory_order_relaxed);
+  while (value > max && !stripe->max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+  stripe->buckets_[HistogramSnapshot::GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+}
+
+HistogramSnapshot MetricHistogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  for (const auto &slot : stripes_) {
+    const Stripe *stripe = slot.load(std::memory_order_acquire);
+    if (stripe == nullptr) {
+      continue;
+    }
+    snapshot.count_ += stripe->count_.load(std::memory_order_relaxed);
+    snapshot.sum_ += stripe->sum_.load(std::memory_order_relaxed);
+    snapshot.max_ = std::max(snapshot.max_, stripe->max_.load(std::memory_order_relaxed));
+    for (size_t bucket = 0; bucket < HistogramSnapshot::NUM_BUCKETS; bucket++) {
+      snapshot.buckets_[bucket] += stripe->buckets_[bucket].load(std::memory_order_relaxed);
+    }
+  }
+  return snapshot;
+}
+
+MetricsSnapshot::Family *MetricsSnapshot::GetFamily(const std::string &name, const std::string &help,
+                                                    MetricType type) {
+  auto [it, inserted] = families_.try_emplace(name);
+  Family &family = it->second;
+  if (inserted) {
+    family.help_ = help;
+    family.type_ = type;
+  } else if (family.type_ != type) {
+    throw Exception("metric " + name + " is added as a " + GetTypeName(type) + " but is a " +
+                    GetTypeName(family.type_));
+  }
+  return &family;
+}
+
+void MetricsSnapshot::AddCounter(const std::string &name, const std::string &help, double value,
+                                 const std::string &labels) {
+  GetFamily(name, help, MetricType::COUNTER)->values_[labels] += value;
+}
+
+void MetricsSnapshot::AddGauge(const std::string &name, const std::string &help, double value,
+                               const std::string &labels) {
+  GetFamily(name, help, MetricType::GAUGE)->values_[labels] += value;
+}
+
+void MetricsSnapshot::AddHistogram(const std::string &name, const std::string &help,
+                                   const HistogramSnapshot &histogram, const std::string &labels) {
+  GetFamily(name, help, MetricType::HISTOGRAM)->histograms_[labels] += histogram;
+}
+
+std::optional<double> MetricsSnapshot::GetValue(const std::string &name, const std::string &labels) const {
+  auto family = families_.find(name);
+  if (family == families_.end()) {
+    return std::nullopt;
+  }
+  auto value = family->second.values_.find(labels);
+  if (value == family->second.values_.end()) {
+    return std::nullopt;
+  }
+  return value->second;
+}
+
+const HistogramSnapshot *MetricsSnapshot::GetHistogram(const std::string &name, const std::string &labels) const {
+  auto family = families_.find(name);
+  if (family == families_.end()) {
+    return nullptr;
+  }
+  auto histogram = family->second.histograms_.find(labels);
+  return histogram == family->second.histograms_.end() ? nullptr : &histogram->second;
+}
+
+std::string MetricsSnapshot::ToText() const {
+  static constexpr std::pair<double, const char *> QUANTILES[] = {
+      {0.5, "0.5"}, {0.9, "0.9"}, {0.99, "0.99"}, {0.999, "0.999"}};
+  std::string text;
+  for (const auto &[name, family] : families_) {
+    text += "# HELP " + name + " " + family.help_ + "\n";
+    text += "# TYPE " + name + " " + GetTypeName(family.type_) + "\n";
+    for (const auto &[labels, value] : family.values_) {
+      text += FormatSeries(name, labels) + " " + FormatValue(value) + "\n";
+    }
+    for (const auto &[labels, histogram] : family.histograms_) {
+      for (const auto &[fraction, quantile] : QUANTILES) {
+        text += FormatSeries(name, labels, std::string("quantile=\"") + quantile + "\"") + " " +
+                FormatValue(static_cast<double>(histogram.Percentile(fraction))) + "\n";
+      }
+      text += FormatSeries(name + "_sum", labels) + " " + FormatValue(static_cast<double>(histogram.sum_)) + "\n";
+      text += FormatSeries(name + "_count", labels) + " " + FormatValue(static_cast<double>(histogram.count_)) + "\n";
+    }
+  }
+  return text;
+}
+
+MetricsRegistry::Metric *MetricsRegistry::GetMetric(const std::string &name, const std::string &help,
+                                                    const std::string &labels, MetricType type) {
+  std::scoped_lock latch(latch_);
+  // The metrics of a name are next to each other, and all of the same type.
+  auto same_name = metrics_.lower_bound({name, ""});
+  if (same_name != metrics_.end() && same_name->first.first == name && same_name->second.type_ != type) {
+    throw Exception("metric " + name + " is registered as a " + GetTypeName(same_name->second.type_) + ", not as a " +
+                    GetTypeName(type));
+  }
+  auto [it, inserted] = metrics_.try_emplace({name, labels});
+  Metric &metric = it->second;
+  if (inserted) {
+    metric.help_ = help;
+    metric.type_ = type;
+    switch (type) {
+      case MetricType::COUNTER:
+        metric.counter_ = std::make_unique<MetricCounter>();
+        break;
+      case MetricType::GAUGE:
+        metric.gauge_ = std::make_unique<MetricGauge>();
+        break;
+      case MetricType::HISTOGRAM:
+        metric.histogram_ = std::make_unique<MetricHistogram>();
+        break;
+    }
+  }
+  return &metric;
+}
+
+MetricCounter *MetricsRegistry::GetCounter(const std::string &name, const std::string &help,
+                                           const std::string &labels) {
+  return GetMetric(name, help, labels, MetricType::COUNTER)->counter_.get();
+}
+
+MetricGauge *MetricsRegistry::GetGauge(const std::string &name, const std::string &help, const std::string &labels) {
+  return GetMetric(name, help, labels, MetricType::GAUGE)->gauge_.get();
+}
+
+MetricHistogram *MetricsRegistry::GetHistogram(const std::string &name, const std::string &help,
+                                               const std::string &labels) {
+  return GetMetric(name, help, labels, MetricType::HISTOGRAM)->histogram_.get();
+}
+
+size_t MetricsRegistry::AddCollector(Collector collector) {
+  std::scoped_lock latch(latch_);
+  const size_t id = next_collector_id_++;
+  collectors_.emplace(id, std::move(collector));
+  return id;
+}
+
+void MetricsRegistry::RemoveCollector(size_t id) {
+  std::scoped_lock latch(latch_);
+  collectors_.erase(id);
+}
+
+MetricsSnapshot MetricsRegistry::Collect() const {
+  MetricsSnapshot snapshot;
+  std::scoped_lock latch(latch_);
+  for (const auto &[key, metric] : metrics_) {
+    const auto &[name, labels] = key;
+    switch (metric.type_) {
+      case MetricType::COUNTER:
+        snapshot.AddCounter(name, metric.help_, static_cast<double>(metric.counter_->Value()), labels);
+        break;
+      case MetricType::GAUGE:
+        snapshot.AddGauge(name, metric.help_, static_cast<double>(metric.gauge_->Value()), labels);
+        break;
+      case MetricType::HISTOGRAM:
+        snapshot.AddHistogram(name, metric.help_, metric.histogram_->Snapshot(), labels);
+        break;
+    }
+  }
+  for (const auto &[id, collector] : collectors_) {
+    collector(&snapshot);
+  }
+  return snapshot;
+}
+
+}  // namespace bustub
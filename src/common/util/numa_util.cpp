@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// numa_util.cpp
+//
+// Identification: src/common/util/numa_util.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/numa_util.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#endif
+
+namespace bustub {
+
+size_t NumaUtil::GetNumNodes() {
+  // The online nodes are listed as ranges, e.g. "0-1" or "0,2-3". Node ids are dense in practice, so the largest id
+  // tells the number of nodes.
+  static const size_t num_nodes = [] {
+    std::ifstream in("/sys/devices/system/node/online");
+    std::string online;
+    if (!(in >> online) || online.empty()) {
+      return static_cast<size_t>(1);
+    }
+    const size_t last = online.find_last_of(",-");
+    return static_cast<size_t>(std::stoul(last == std::string::npos ? online : online.substr(last + 1))) + 1;
+  }();
+  return num_nodes;
+}
+
+size_t NumaUtil::GetCurrentNode() {
+#ifdef SYS_getcpu
+  unsigned cpu;
+  unsigned node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return node < GetNumNodes() ? node : 0;
+  }
+#endif
+  return 0;
+}
+
+bool NumaUtil::BindMemory(void *addr, size_t len, size_t node) {
+#if defined(SYS_mbind) && defined(MPOL_BIND)
+  constexpr size_t bits_per_word = 8 * sizeof(unsigned long);  // NOLINT
+  static constexpr size_t max_nodes = 1024;
+  if (node >= max_nodes) {
+    return false;
+  }
+  unsigned long node_mask[max_nodes / bits_per_word] = {};  // NOLINT
+  node_mask[node / bits_per_word] = 1UL << (node % bits_per_word);
+  return syscall(SYS_mbind, addr, len, MPOL_BIND, node_mask, max_nodes, 0) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace bustub
@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tracer.cpp
+//
+// Identification: src/common/util/tracer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/tracer.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+namespace bustub {
+
+std::atomic<uint64_t> Tracer::sample_threshold_{0};
+std::atomic<uint64_t> Tracer::num_dropped_{0};
+thread_local txn_id_t Tracer::current_txn_ = INVALID_TXN_ID;
+
+namespace {
+
+/** The spans of a thread. Its latch is only contended while the spans are read or reset. */
+struct ThreadSpans {
+  std::mutex latch_;
+  std::vector<TraceSpan> spans_;
+  uint32_t thread_;
+};
+
+/** The buffers of all the threads that recorded a span, kept after their threads exit. */
+struct SpanBuffers {
+  std::mutex latch_;
+  std::vector<std::unique_ptr<ThreadSpans>> threads_;
+};
+
+SpanBuffers *GetBuffers() {
+  static auto *buffers = new SpanBuffers();
+  return buffers;
+}
+
+ThreadSpans *GetThreadSpans() {
+  static thread_local ThreadSpans *spans = [] {
+    SpanBuffers *buffers = GetBuffers();
+    std::scoped_lock latch(buffers->latch_);
+    auto thread_spans = std::make_unique<ThreadSpans>();
+    thread_spans->thread_ = buffers->threads_.size();
+    buffers->threads_.push_back(std::move(thread_spans));
+    return buffers->threads_.back().get();
+  }();
+  return spans;
+}
+
+}  // namespace
+
+void Tracer::SetSampleRate(double rate) {
+  rate = std::clamp(rate, 0.0, 1.0);
+  sample_threshold_.store(static_cast<uint64_t>(rate * static_cast<double>(uint64_t{1} << 32)),
+                          std::memory_order_relaxed);
+}
+
+void Tracer::Record(txn_id_t txn_id, const char *name, uint64_t start_ns, int64_t arg) {
+  const uint64_t end_ns = Now();
+  ThreadSpans *spans = GetThreadSpans();
+  std::scoped_lock latch(spans->latch_);
+  if (spans->spans_.size() >= MAX_SPANS_PER_THREAD) {
+    num_dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  spans->spans_.push_back({txn_id, name, start_ns, end_ns - start_ns, spans->thread_, arg});
+}
+
+std::vector<TraceSpan> Tracer::GetSpans() {
+  std::vector<TraceSpan> result;
+  SpanBuffers *buffers = GetBuffers();
+  std::scoped_lock latch(buffers->latch_);
+  for (const auto &thread_spans : buffers->threads_) {
+    std::scoped_lock thread_latch(thread_spans->latch_);
+    result.insert(result.end(), thread_spans->spans_.begin(), thread_spans->spans_.end());
+  }
+  std::stable_sort(result.begin(), result.end(),
+                   [](const TraceSpan &a, const TraceSpan &b) { return a.start_ns_ < b.start_ns_; });
+  return result;
+}
+
+std::string Tracer::ExportChromeTrace() {
+  std::string json = "{\"traceEvents\":[";
+  bool first = true;
+  char event[256];
+  for (const TraceSpan &span : GetSpans()) {
+    // Complete events, in microseconds; the names are literals that need no escaping.
+    snprintf(event, sizeof(event),
+             "%s\n{\"name\":\"%s\",\"cat\":\"bustub\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,"
+             "\"args\":{\"txn_id\":%d,\"arg\":%" PRId64 "}}",
+             first ? "" : ",", span.name_, static_cast<double>(span.start_ns_) / 1e3,
+             static_cast<double>(span.duration_ns_) / 1e3, span.thread_, span.txn_id_, span.arg_);
+    json += event;
+    first = false;
+  }
+  json += "\n],\"displayTimeUnit\":\"ns\"}\n";
+  return json;
+}
+
+void Tracer::Reset() {
+  SpanBuffers *buffers = GetBuffers();
+  std::scoped_lock latch(buffers->latch_);
+  for (const auto &thread_spans : buffers->threads_) {
+    std::scoped_lock thread_latch(thread_spans->latch_);
+    thread_spans->spans_.clear();
+  }
+  num_dropped_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace bustub
@@ -15,53 +15,625 @@
 #include <utility>
 #include <vector>
 
+#include "common/util/contention_profiler.h"
+#include "common/util/tracer.h"
+
 namespace bustub {
 
-bool LockManager::LockShared(Transaction *txn, const RID &rid) {
+bool LockManager::LockShared(Transaction *txn, const RID &rid, table_oid_t oid) {
+  if (oid != INVALID_TABLE_OID && txn->IsTableSharedLocked(oid)) {
+    return true;
+  }
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  if (txn->IsSharedLocked(rid) || txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  LockTablePartition *partition = GetPartition(rid);
+  ProfiledLock lock(&partition->latch_, LatchSite::LOCK_PARTITION, partition - lock_table_.data());
+  LockRequestQueue *queue = &partition->lock_table_[rid];
+  queue->resource_ = rid.Get();
+  auto request = queue->request_queue_.emplace(queue->request_queue_.end(), txn, LockMode::SHARED);
+  if (!WaitForGrant(&lock, queue, request)) {
+    EraseIfEmpty(partition, rid);
+    return false;
+  }
   txn->GetSharedLockSet()->emplace(rid);
+  lock.unlock();
+  AddTableRow(txn, rid, oid);
   return true;
 }
 
-bool LockManager::LockExclusive(Transaction *txn, const RID &rid) {
+bool LockManager::LockExclusive(Transaction *txn, const RID &rid, table_oid_t oid) {
+  // Checked before the state, the rollback of an aborted transaction finds its escalated rows locked, too.
+  if (oid != INVALID_TABLE_OID && txn->IsTableExclusiveLocked(oid)) {
+    return true;
+  }
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  if (txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  if (txn->IsSharedLocked(rid)) {
+    return LockUpgrade(txn, rid, oid);
+  }
+  LockTablePartition *partition = GetPartition(rid);
+  ProfiledLock lock(&partition->latch_, LatchSite::LOCK_PARTITION, partition - lock_table_.data());
+  LockRequestQueue *queue = &partition->lock_table_[rid];
+  queue->resource_ = rid.Get();
+  auto request = queue->request_queue_.emplace(queue->request_queue_.end(), txn, LockMode::EXCLUSIVE);
+  if (!WaitForGrant(&lock, queue, request)) {
+    EraseIfEmpty(partition, rid);
+    return false;
+  }
   txn->GetExclusiveLockSet()->emplace(rid);
+  lock.unlock();
+  AddTableRow(txn, rid, oid);
   return true;
 }
 
-bool LockManager::LockUpgrade(Transaction *txn, const RID &rid) {
+bool LockManager::LockUpgrade(Transaction *txn, const RID &rid, table_oid_t oid) {
+  if (oid != INVALID_TABLE_OID && txn->IsTableExclusiveLocked(oid)) {
+    return true;
+  }
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  if (txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  LockTablePartition *partition = GetPartition(rid);
+  ProfiledLock lock(&partition->latch_, LatchSite::LOCK_PARTITION, partition - lock_table_.data());
+  auto queue_it = partition->lock_table_.find(rid);
+  BUSTUB_ASSERT(queue_it != partition->lock_table_.end(), "An upgrade needs a shared lock.");
+  LockRequestQueue *queue = &queue_it->second;
+  if (!WaitForUpgrade(&lock, queue, txn, LockMode::EXCLUSIVE)) {
+    txn->GetSharedLockSet()->erase(rid);
+    EraseIfEmpty(partition, rid);
+    return false;
+  }
   txn->GetSharedLockSet()->erase(rid);
   txn->GetExclusiveLockSet()->emplace(rid);
+  lock.unlock();
+  AddTableRow(txn, rid, oid);
   return true;
 }
 
 bool LockManager::Unlock(Transaction *txn, const RID &rid) {
+  if (txn->GetState() == TransactionState::GROWING) {
+    txn->SetState(TransactionState::SHRINKING);
+  }
+  return ReleaseRow(txn, rid);
+}
+
+bool LockManager::ReleaseRow(Transaction *txn, const RID &rid) {
   txn->GetSharedLockSet()->erase(rid);
   txn->GetExclusiveLockSet()->erase(rid);
+  for (auto &[oid, rows] : *txn->GetTableRowLockSet()) {
+    rows.erase(rid);
+  }
+  LockTablePartition *partition = GetPartition(rid);
+  ProfiledLock guard(&partition->latch_, LatchSite::LOCK_PARTITION, partition - lock_table_.data());
+  auto queue_it = partition->lock_table_.find(rid);
+  if (queue_it == partition->lock_table_.end()) {
+    return false;
+  }
+  auto &requests = queue_it->second.request_queue_;
+  auto request = std::find_if(requests.begin(), requests.end(), [txn](const LockRequest &request) {
+    return request.txn_id_ == txn->GetTransactionId() && request.granted_;
+  });
+  if (request == requests.end()) {
+    return false;
+  }
+  requests.erase(request);
+  if (requests.empty()) {
+    partition->lock_table_.erase(queue_it);
+  } else {
+    queue_it->second.cv_.notify_all();
+  }
+  return true;
+}
+
+void LockManager::AddTableRow(Transaction *txn, const RID &rid, table_oid_t oid) {
+  if (oid == INVALID_TABLE_OID) {
+    return;
+  }
+  auto &rows = (*txn->GetTableRowLockSet())[oid];
+  const size_t count = rows.size();
+  rows.emplace(rid);
+  size_t threshold = lock_escalation_threshold;
+  // Over the soft limit of the lock table, the row locks of a table are traded for a table lock early, even where they
+  // are not escalated otherwise, so that the lock table shrinks rather than grows.
+  if (MemoryAccounting::Get(MemorySubsystem::LOCK_TABLE)->IsOverSoftLimit()) {
+    threshold = threshold == 0 ? LOCK_ESCALATION_PRESSURE_ROWS
+                               : std::min<size_t>(threshold, LOCK_ESCALATION_PRESSURE_ROWS);
+  }
+  // An upgraded row is counted already, a failed escalation is tried again once as many rows are locked again.
+  if (threshold > 0 && rows.size() > count && rows.size() % threshold == 0) {
+    Escalate(txn, oid);
+  }
+}
+
+bool LockManager::Escalate(Transaction *txn, table_oid_t oid) {
+  auto rows = txn->GetTableRowLockSet()->find(oid);
+  const bool exclusive = std::any_of(rows->second.begin(), rows->second.end(),
+                                     [txn](const RID &rid) { return txn->IsExclusiveLocked(rid); });
+  LockMode lock_mode = exclusive ? LockMode::EXCLUSIVE : LockMode::SHARED;
+  auto held = txn->GetTableLockSet()->find(oid);
+  if (held != txn->GetTableLockSet()->end() && !Covers(held->second, lock_mode)) {
+    // SHARED and INTENTION_EXCLUSIVE cover each other's modes only together.
+    lock_mode = Covers(lock_mode, held->second) ? lock_mode : LockMode::SHARED_INTENTION_EXCLUSIVE;
+  }
+  if (held == txn->GetTableLockSet()->end() || held->second != lock_mode) {
+    ProfiledLock guard(&table_latch_, LatchSite::LOCK_TABLE, 0);
+    LockRequestQueue *queue = &table_lock_table_[oid];
+    auto &requests = queue->request_queue_;
+    // Waiting for the table could deadlock, or abort a transaction that could go on with its row locks.
+    const bool conflicts = std::any_of(requests.begin(), requests.end(), [txn, lock_mode](const LockRequest &request) {
+      return request.txn_id_ != txn->GetTransactionId() && !AreCompatible(request.lock_mode_, lock_mode);
+    });
+    if (queue->upgrading_ || conflicts) {
+      if (requests.empty()) {
+        table_lock_table_.erase(oid);
+      }
+      return false;
+    }
+    if (held == txn->GetTableLockSet()->end()) {
+      auto first_waiting = std::find_if(requests.begin(), requests.end(),
+                                        [](const LockRequest &request) { return !request.granted_; });
+      requests.emplace(first_waiting, txn, lock_mode)->granted_ = true;
+      txn->GetTableLockSet()->emplace(oid, lock_mode);
+    } else {
+      auto request = std::find_if(requests.begin(), requests.end(), [txn](const LockRequest &request) {
+        return request.txn_id_ == txn->GetTransactionId();
+      });
+      request->lock_mode_ = lock_mode;
+      held->second = lock_mode;
+    }
+  }
+  // The table lock covers the rows now.
+  std::unordered_set<RID> released = std::move(rows->second);
+  txn->GetTableRowLockSet()->erase(rows);
+  for (const RID &rid : released) {
+    ReleaseRow(txn, rid);
+  }
   return true;
 }
 
-void LockManager::AddEdge(txn_id_t t1, txn_id_t t2) { assert(Detection()); }
+bool LockManager::LockTable(Transaction *txn, table_oid_t oid, LockMode lock_mode) {
+  auto held = txn->GetTableLockSet()->find(oid);
+  // Most row operations find their intention lock held already, which needs no latch. The rollback of an aborted
+  // transaction does, too.
+  if (held != txn->GetTableLockSet()->end() && Covers(held->second, lock_mode)) {
+    return true;
+  }
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  ProfiledLock lock(&table_latch_, LatchSite::LOCK_TABLE, 0);
+  LockRequestQueue *queue = &table_lock_table_[oid];
+  queue->resource_ = oid;
+  if (held == txn->GetTableLockSet()->end()) {
+    auto request = queue->request_queue_.emplace(queue->request_queue_.end(), txn, lock_mode);
+    if (!WaitForGrant(&lock, queue, request)) {
+      if (queue->request_queue_.empty()) {
+        table_lock_table_.erase(oid);
+      }
+      return false;
+    }
+    txn->GetTableLockSet()->emplace(oid, lock_mode);
+    return true;
+  }
+  // SHARED and INTENTION_EXCLUSIVE cover each other's modes only together.
+  const LockMode upgrade_mode = Covers(lock_mode, held->second) ? lock_mode : LockMode::SHARED_INTENTION_EXCLUSIVE;
+  if (!WaitForUpgrade(&lock, queue, txn, upgrade_mode)) {
+    txn->GetTableLockSet()->erase(oid);
+    if (queue->request_queue_.empty()) {
+      table_lock_table_.erase(oid);
+    }
+    return false;
+  }
+  held->second = upgrade_mode;
+  return true;
+}
 
-void LockManager::RemoveEdge(txn_id_t t1, txn_id_t t2) { assert(Detection()); }
+bool LockManager::UnlockTable(Transaction *txn, table_oid_t oid) {
+  if (txn->GetTableLockSet()->erase(oid) == 0) {
+    return false;
+  }
+  if (txn->GetState() == TransactionState::GROWING) {
+    txn->SetState(TransactionState::SHRINKING);
+  }
+  ProfiledLock guard(&table_latch_, LatchSite::LOCK_TABLE, 0);
+  auto queue_it = table_lock_table_.find(oid);
+  if (queue_it == table_lock_table_.end()) {
+    return false;
+  }
+  auto &requests = queue_it->second.request_queue_;
+  auto request = std::find_if(requests.begin(), requests.end(), [txn](const LockRequest &request) {
+    return request.txn_id_ == txn->GetTransactionId() && request.granted_;
+  });
+  if (request == requests.end()) {
+    return false;
+  }
+  requests.erase(request);
+  if (requests.empty()) {
+    table_lock_table_.erase(queue_it);
+  } else {
+    queue_it->second.cv_.notify_all();
+  }
+  return true;
+}
+
+bool LockManager::AreCompatible(LockMode held, LockMode requested) {
+  switch (held) {
+    case LockMode::INTENTION_SHARED:
+      return requested != LockMode::EXCLUSIVE;
+    case LockMode::INTENTION_EXCLUSIVE:
+      return requested == LockMode::INTENTION_SHARED || requested == LockMode::INTENTION_EXCLUSIVE;
+    case LockMode::SHARED:
+      return requested == LockMode::INTENTION_SHARED || requested == LockMode::SHARED;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      return requested == LockMode::INTENTION_SHARED;
+    case LockMode::EXCLUSIVE:
+      return false;
+  }
+  return false;
+}
+
+bool LockManager::Covers(LockMode held, LockMode requested) {
+  switch (held) {
+    case LockMode::INTENTION_SHARED:
+      return requested == LockMode::INTENTION_SHARED;
+    case LockMode::INTENTION_EXCLUSIVE:
+      return requested == LockMode::INTENTION_SHARED || requested == LockMode::INTENTION_EXCLUSIVE;
+    case LockMode::SHARED:
+      return requested == LockMode::INTENTION_SHARED || requested == LockMode::SHARED;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      return requested != LockMode::EXCLUSIVE;
+    case LockMode::EXCLUSIVE:
+      return true;
+  }
+  return false;
+}
+
+bool LockManager::WaitForUpgrade(std::unique_lock<std::mutex> *lock, LockRequestQueue *queue, Transaction *txn,
+                                 LockMode lock_mode) {
+  auto &requests = queue->request_queue_;
+  auto held = std::find_if(requests.begin(), requests.end(),
+                           [txn](const LockRequest &request) { return request.txn_id_ == txn->GetTransactionId(); });
+  BUSTUB_ASSERT(held != requests.end() && held->granted_, "An upgrade needs a granted lock.");
+  requests.erase(held);
+  // Two upgrades in the same queue would wait for each other. A failed upgrade gives up the held lock, too.
+  if (queue->upgrading_) {
+    txn->SetState(TransactionState::ABORTED);
+    queue->cv_.notify_all();
+    return false;
+  }
+  // The upgrade goes ahead of the waiting requests, it only waits for the other holders of the lock.
+  auto first_waiting = std::find_if(requests.begin(), requests.end(),
+                                    [](const LockRequest &request) { return !request.granted_; });
+  auto request = requests.emplace(first_waiting, txn, lock_mode);
+  queue->upgrading_ = true;
+  // The waiting requests wait for the upgrade now, which may turn them into waits for an older transaction.
+  queue->cv_.notify_all();
+  const bool granted = WaitForGrant(lock, queue, request);
+  queue->upgrading_ = false;
+  return granted;
+}
+
+bool LockManager::WaitForGrant(std::unique_lock<std::mutex> *lock, LockRequestQueue *queue,
+                               LockRequestList::iterator request) {
+  Transaction *txn = request->txn_;
+  std::chrono::steady_clock::time_point wait_start{};
+  while (!IsGrantable(*queue, request)) {
+    // Wait-die: only older transactions wait for younger ones, so no cycle of waiting transactions can form.
+    if (Prevention() && WaitsForOlder(*queue, request)) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    // Wound-wait: only younger transactions wait for older ones, the older ones abort them instead.
+    if (WoundWait()) {
+      WoundYounger(queue, request);
+    }
+    if (txn->GetState() == TransactionState::ABORTED) {
+      if (Detection()) {
+        ClearWaiting(request->txn_id_);
+      }
+      queue->request_queue_.erase(request);
+      // The requests behind this one may be grantable now.
+      queue->cv_.notify_all();
+      aborted_requests_.fetch_add(1, std::memory_order_relaxed);
+      RecordWait(lock, *queue, txn, wait_start);
+      return false;
+    }
+    // The requests before this one change while it waits, its edges are renewed whenever it wakes up.
+    if (Detection()) {
+      SetWaiting(lock, queue, request);
+    }
+    if (wait_start == std::chrono::steady_clock::time_point{}) {
+      wait_start = std::chrono::steady_clock::now();
+    }
+    if (WoundWait()) {
+      // A transaction wounded through another queue is not notified on this one.
+      queue->cv_.wait_for(*lock, wound_check_interval);
+    } else {
+      queue->cv_.wait(*lock);
+    }
+  }
+  if (Detection()) {
+    ClearWaiting(request->txn_id_);
+  }
+  request->granted_ = true;
+  RecordWait(lock, *queue, txn, wait_start);
+  return true;
+}
+
+void LockManager::RecordWait([[maybe_unused]] std::unique_lock<std::mutex> *lock,
+                             const LockRequestQueue &queue, Transaction *txn,
+                             std::chrono::steady_clock::time_point wait_start) {
+  if (wait_start == std::chrono::steady_clock::time_point{}) {
+    return;
+  }
+  const auto wait_time = std::chrono::steady_clock::now() - wait_start;
+  lock_waits_.fetch_add(1, std::memory_order_relaxed);
+  const uint64_t wait_us = std::chrono::duration_cast<std::chrono::microseconds>(wait_time).count();
+  lock_wait_time_us_.fetch_add(wait_us, std::memory_order_relaxed);
+  lock_wait_us_.Record(wait_us);
+  if (txn->IsTraced()) {
+    Tracer::Record(txn->GetTransactionId(), "lock_wait",
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(wait_start.time_since_epoch()).count(),
+                   queue.resource_);
+  }
+#ifdef BUSTUB_CONTENTION_PROFILE
+  const LatchSite site = lock->mutex() == &table_latch_ ? LatchSite::TABLE_LOCK : LatchSite::ROW_LOCK;
+  ContentionProfiler::Record(
+      site, queue.resource_,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(wait_start.time_since_epoch()).count());
+#endif
+}
+
+LockManagerStats LockManager::GetStats() const {
+  LockManagerStats stats;
+  stats.lock_waits = lock_waits_.load(std::memory_order_relaxed);
+  stats.lock_wait_time_us = lock_wait_time_us_.load(std::memory_order_relaxed);
+  stats.aborted_requests = aborted_requests_.load(std::memory_order_relaxed);
+  stats.detection_runs = detection_runs_.load(std::memory_order_relaxed);
+  stats.detection_time_us = detection_time_us_.load(std::memory_order_relaxed);
+  stats.detection_victims = detection_victims_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void LockManager::CollectMetrics(MetricsSnapshot *snapshot) const {
+  const LockManagerStats stats = GetStats();
+  snapshot->AddCounter("bustub_lock_waits_total", "Lock requests that had to wait.",
+                       static_cast<double>(stats.lock_waits));
+  snapshot->AddCounter("bustub_lock_wait_seconds_total", "Time spent waiting for locks.",
+                       static_cast<double>(stats.lock_wait_time_us) / 1e6);
+  snapshot->AddHistogram("bustub_lock_wait_us", "Latency of the lock waits, in microseconds.",
+                         lock_wait_us_.Snapshot());
+  snapshot->AddCounter("bustub_lock_aborted_requests_total", "Lock requests that gave up because of an abort.",
+                       static_cast<double>(stats.aborted_requests));
+  snapshot->AddCounter("bustub_lock_detection_runs_total", "Rounds of the cycle detection.",
+                       static_cast<double>(stats.detection_runs));
+  snapshot->AddCounter("bustub_lock_detection_seconds_total", "Time spent in the rounds of the cycle detection.",
+                       static_cast<double>(stats.detection_time_us) / 1e6);
+  snapshot->AddCounter("bustub_lock_detection_victims_total", "Transactions that the cycle detection aborted.",
+                       static_cast<double>(stats.detection_victims));
+}
+
+void LockManager::SetWaiting(std::unique_lock<std::mutex> *lock, LockRequestQueue *queue,
+                             LockRequestList::const_iterator request) {
+  std::vector<txn_id_t> edges;
+  for (auto it = queue->request_queue_.cbegin(); it != request; ++it) {
+    if (!AreCompatible(it->lock_mode_, request->lock_mode_) &&
+        std::find(edges.begin(), edges.end(), it->txn_id_) == edges.end()) {
+      edges.push_back(it->txn_id_);
+    }
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  waits_for_[request->txn_id_] = std::move(edges);
+  waiting_[request->txn_id_] = WaitingRequest{queue, lock->mutex()};
+}
+
+void LockManager::ClearWaiting(txn_id_t txn_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  waits_for_.erase(txn_id);
+  waiting_.erase(txn_id);
+}
+
+void LockManager::EraseIfEmpty(LockTablePartition *partition, const RID &rid) {
+  auto queue_it = partition->lock_table_.find(rid);
+  if (queue_it != partition->lock_table_.end() && queue_it->second.request_queue_.empty()) {
+    partition->lock_table_.erase(queue_it);
+  }
+}
+
+bool LockManager::IsGrantable(const LockRequestQueue &queue, LockRequestList::const_iterator request) {
+  for (auto it = queue.request_queue_.begin(); it != request; ++it) {
+    if (!AreCompatible(it->lock_mode_, request->lock_mode_)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LockManager::WaitsForOlder(const LockRequestQueue &queue, LockRequestList::const_iterator request) {
+  for (auto it = queue.request_queue_.begin(); it != request; ++it) {
+    if (!AreCompatible(it->lock_mode_, request->lock_mode_) && it->txn_id_ < request->txn_id_) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void LockManager::WoundYounger(LockRequestQueue *queue, LockRequestList::const_iterator request) {
+  bool wounded = false;
+  for (auto it = queue->request_queue_.cbegin(); it != request; ++it) {
+    // A transaction that commits or shrinks asks for no lock anymore, so waiting for it cannot deadlock.
+    if (!AreCompatible(it->lock_mode_, request->lock_mode_) && it->txn_id_ > request->txn_id_ &&
+        it->txn_->GetState() == TransactionState::GROWING) {
+      it->txn_->SetState(TransactionState::ABORTED);
+      wounded = wounded || !it->granted_;
+    }
+  }
+  if (wounded) {
+    queue->cv_.notify_all();
+  }
+}
+
+void LockManager::AddEdge(txn_id_t t1, txn_id_t t2) {
+  assert(Detection());
+  std::lock_guard<std::mutex> guard(latch_);
+  auto &edges = waits_for_[t1];
+  if (std::find(edges.begin(), edges.end(), t2) == edges.end()) {
+    edges.push_back(t2);
+  }
+}
+
+void LockManager::RemoveEdge(txn_id_t t1, txn_id_t t2) {
+  assert(Detection());
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = waits_for_.find(t1);
+  if (it == waits_for_.end()) {
+    return;
+  }
+  it->second.erase(std::remove(it->second.begin(), it->second.end(), t2), it->second.end());
+  if (it->second.empty()) {
+    waits_for_.erase(it);
+  }
+}
 
 bool LockManager::HasCycle(txn_id_t *txn_id) {
   BUSTUB_ASSERT(Detection(), "Detection should be enabled!");
+  std::lock_guard<std::mutex> guard(latch_);
+  return FindVictim(&waits_for_, txn_id);
+}
+
+bool LockManager::FindVictim(WaitsForGraph *graph, txn_id_t *txn_id) {
+  // Searching from the oldest transaction and along the oldest edges first makes the result deterministic.
+  std::vector<txn_id_t> txns;
+  for (auto &[txn, edges] : *graph) {
+    txns.push_back(txn);
+    std::sort(edges.begin(), edges.end());
+  }
+  std::sort(txns.begin(), txns.end());
+  std::unordered_set<txn_id_t> visited;
+  for (const txn_id_t txn : txns) {
+    std::vector<txn_id_t> path;
+    if (visited.count(txn) == 0 && FindCycle(*graph, txn, &path, &visited, txn_id)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool LockManager::FindCycle(const WaitsForGraph &graph, txn_id_t txn_id, std::vector<txn_id_t> *path,
+                            std::unordered_set<txn_id_t> *visited, txn_id_t *victim) {
+  visited->insert(txn_id);
+  path->push_back(txn_id);
+  auto it = graph.find(txn_id);
+  if (it != graph.end()) {
+    for (const txn_id_t next : it->second) {
+      auto on_path = std::find(path->begin(), path->end(), next);
+      if (on_path != path->end()) {
+        *victim = *std::max_element(on_path, path->end());
+        return true;
+      }
+      if (visited->count(next) == 0 && FindCycle(graph, next, path, visited, victim)) {
+        return true;
+      }
+    }
+  }
+  path->pop_back();
   return false;
 }
 
 std::vector<std::pair<txn_id_t, txn_id_t>> LockManager::GetEdgeList() {
   BUSTUB_ASSERT(Detection(), "Detection should be enabled!");
-  return {};
+  std::lock_guard<std::mutex> guard(latch_);
+  std::vector<std::pair<txn_id_t, txn_id_t>> edges;
+  for (const auto &[t1, targets] : waits_for_) {
+    for (const txn_id_t t2 : targets) {
+      edges.emplace_back(t1, t2);
+    }
+  }
+  return edges;
+}
+
+void LockManager::AbortWaiting(LockRequestQueue *queue, txn_id_t txn_id) {
+  auto &requests = queue->request_queue_;
+  auto request = std::find_if(requests.begin(), requests.end(), [txn_id](const LockRequest &request) {
+    return request.txn_id_ == txn_id && !request.granted_;
+  });
+  if (request != requests.end()) {
+    request->txn_->SetState(TransactionState::ABORTED);
+    queue->cv_.notify_all();
+  }
 }
 
 void LockManager::RunCycleDetection() {
   BUSTUB_ASSERT(Detection(), "Detection should be enabled!");
   while (enable_cycle_detection_) {
     std::this_thread::sleep_for(cycle_detection_interval);
+    const auto start = std::chrono::steady_clock::now();
+    // The search runs on a copy of the graph, the lock table goes on meanwhile.
+    WaitsForGraph graph;
+    std::unordered_map<txn_id_t, WaitingRequest> waiting;
     {
-      std::unique_lock<std::mutex> l(latch_);
-      // TODO(student): remove the continue and add your cycle detection and abort code here
-      continue;
+      std::lock_guard<std::mutex> guard(latch_);
+      graph = waits_for_;
+      waiting = waiting_;
+    }
+    // Aborting the newest transaction of a cycle breaks it, the search goes on without its edges.
+    std::vector<txn_id_t> victims;
+    txn_id_t victim;
+    while (FindVictim(&graph, &victim)) {
+      graph.erase(victim);
+      for (auto &[txn, edges] : graph) {
+        edges.erase(std::remove(edges.begin(), edges.end(), victim), edges.end());
+      }
+      victims.push_back(victim);
+    }
+    // A victim is only aborted if it still waits in the same queue, which then still exists.
+    for (const txn_id_t txn_id : victims) {
+      auto it = waiting.find(txn_id);
+      if (it == waiting.end()) {
+        continue;
+      }
+      std::lock_guard<std::mutex> guard(*it->second.latch_);
+      bool still_waiting;
+      {
+        std::lock_guard<std::mutex> graph_guard(latch_);
+        auto current = waiting_.find(txn_id);
+        still_waiting = current != waiting_.end() && current->second.queue_ == it->second.queue_;
+      }
+      if (still_waiting) {
+        AbortWaiting(it->second.queue_, txn_id);
+        detection_victims_.fetch_add(1, std::memory_order_relaxed);
+      }
     }
+    detection_runs_.fetch_add(1, std::memory_order_relaxed);
+    detection_time_us_.fetch_add(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count(),
+        std::memory_order_relaxed);
   }
 }
 
@@ -12,87 +12,341 @@
 
 #include "concurrency/transaction_manager.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "common/util/tracer.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-std::unordered_map<txn_id_t, Transaction *> TransactionManager::txn_map = {};
+namespace {
 
-Transaction *TransactionManager::Begin(Transaction *txn) {
+/**
+ * Inserts into a map through the node of an erased entry if there is one, so that the insert allocates nothing.
+ * @param map the map to insert into
+ * @param nodes the nodes extracted from the map, which the insert takes one of
+ * @param key the key to insert, whose entry is overwritten if it exists
+ * @param value the value to insert
+ */
+template <class Map>
+void InsertWithNode(Map *map, std::vector<typename Map::node_type> *nodes, const typename Map::key_type &key,
+                    typename Map::mapped_type value) {
+  if (nodes->empty()) {
+    (*map)[key] = std::move(value);
+    return;
+  }
+  auto node = std::move(nodes->back());
+  nodes->pop_back();
+  node.key() = key;
+  node.mapped() = std::move(value);
+  auto result = map->insert(std::move(node));
+  if (!result.inserted) {
+    result.position->second = std::move(result.node.mapped());
+    nodes->push_back(std::move(result.node));
+  }
+}
+
+}  // namespace
+
+TransactionRegistry TransactionManager::txn_registry;
+
+TransactionManager::~TransactionManager() {
+  for (Transaction *txn : txn_pool_) {
+    delete txn;
+  }
+}
+
+Transaction *TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level, bool read_only) {
   // Acquire the global transaction latch in shared mode.
   global_txn_latch_.RLock();
 
-  if (txn == nullptr) {
-    txn = new Transaction(next_txn_id_++);
+  // A checkpoint must not miss a transaction whose BEGIN record is in the log already.
+  std::scoped_lock lock(active_txns_latch_);
+  if (txn == nullptr && !txn_pool_.empty()) {
+    txn = txn_pool_.back();
+    txn_pool_.pop_back();
+    txn->Reset(next_txn_id_++, isolation_level, read_only);
+  } else if (txn == nullptr) {
+    txn = new Transaction(next_txn_id_++, isolation_level, read_only);
   }
-
-  if (enable_logging) {
-    // TODO(student): Add logging here.
+  txn_registry.Register(txn);
+  // The read timestamp is taken while the transaction becomes active, so that no commit drops the versions it sees.
+  txn->SetReadTs(last_commit_ts_);
+  lsn_t begin_lsn = INVALID_LSN;
+  if (enable_logging && log_manager_ != nullptr && !txn->IsReadOnly()) {
+    LogRecord log_record(txn->GetTransactionId(), INVALID_LSN, LogRecordType::BEGIN);
+    begin_lsn = log_manager_->AppendLogRecord(&log_record);
+    txn->SetPrevLSN(begin_lsn);
+  }
+  InsertWithNode(&active_txns_, &active_txns_nodes_, txn->GetTransactionId(), {txn, begin_lsn});
+  if (Tracer::Sample(txn->GetTransactionId())) {
+    txn->SetTraceStart(Tracer::Now());
+    Tracer::SetCurrentTxn(txn->GetTransactionId());
   }
-
-  txn_map[txn->GetTransactionId()] = txn;
   return txn;
 }
 
 void TransactionManager::Commit(Transaction *txn) {
+  if (txn->IsOptimistic() && !WriteBuffered(txn)) {
+    Abort(txn);
+    return;
+  }
   txn->SetState(TransactionState::COMMITTED);
+  if (!CommitVersions(txn)) {
+    Abort(txn);
+    return;
+  }
 
-  // Perform all deletes before we commit.
+  // The listeners of the tables learn of the commit while the deleted tuples are still on the pages.
   auto write_set = txn->GetWriteSet();
+  std::vector<TableHeap *> published_tables;
+  for (const auto &item : *write_set) {
+    if (item.table_->HasCommitListeners() &&
+        std::find(published_tables.begin(), published_tables.end(), item.table_) == published_tables.end()) {
+      item.table_->PublishCommit(txn);
+      published_tables.push_back(item.table_);
+    }
+  }
+
+  // The tables that the transaction wrote, whose last-modified LSN moves on to its commit.
+  std::vector<TableHeap *> written_tables;
+  for (const auto &item : *write_set) {
+    if (std::find(written_tables.begin(), written_tables.end(), item.table_) == written_tables.end()) {
+      written_tables.push_back(item.table_);
+    }
+  }
+
+  // Perform all deletes before we commit.
+  // The tables that the transaction truncated, whose earlier writes went with the pages that the truncation retired.
+  std::vector<TableHeap *> truncated_tables;
   while (!write_set->empty()) {
     auto &item = write_set->back();
     auto table = item.table_;
-    if (item.wtype_ == WType::DELETE) {
+    if (std::find(truncated_tables.begin(), truncated_tables.end(), table) != truncated_tables.end()) {
+      write_set->pop_back();
+      continue;
+    }
+    if (item.wtype_ == WType::TRUNCATE) {
+      table->ApplyTruncate(item.tuple_, this);
+      truncated_tables.push_back(table);
+    } else if (item.wtype_ == WType::DELETE) {
       // Note that this also releases the lock when holding the page latch.
       table->ApplyDelete(item.rid_, txn);
+    } else if (item.wtype_ == WType::UPDATE) {
+      table->ApplyUpdate(item.tuple_);
     }
     write_set->pop_back();
   }
   write_set->clear();
+  txn->GetReadSet()->clear();
 
-  if (enable_logging) {
-    // TODO(student): add logging here
+  if (enable_logging && log_manager_ != nullptr && !txn->IsReadOnly()) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+    if (synchronous_commit_ && txn->IsSynchronousCommit()) {
+      // The transaction is committed once its commit record is on disk. Concurrent commits share the write.
+      TraceScope trace("log_wait", txn->GetPrevLSN());
+      log_manager_->WaitUntilPersistent(txn->GetPrevLSN());
+    } else {
+      log_manager_->PersistAsync(txn->GetPrevLSN());
+    }
+  }
+  for (TableHeap *table : written_tables) {
+    table->MarkModified(txn->GetPrevLSN());
   }
 
   // Release all the locks.
   ReleaseLocks(txn);
+  EndTransaction(txn);
   // Release the global transaction latch.
   global_txn_latch_.RUnlock();
 }
 
 void TransactionManager::Abort(Transaction *txn) {
   txn->SetState(TransactionState::ABORTED);
+  const bool logged = enable_logging && log_manager_ != nullptr && !txn->IsReadOnly();
+  // The log buffer that the updates are read back through, which holds the records of many writes at a time.
+  LogReadBuffer log_buffer;
 
   // Rollback before releasing the lock.
   auto write_set = txn->GetWriteSet();
   while (!write_set->empty()) {
     auto &item = write_set->back();
     auto table = item.table_;
+    // Taking a write back changes the rows of the table as much as making it did.
+    table->MarkModified(INVALID_LSN);
     if (item.wtype_ == WType::DELETE) {
       table->RollbackDelete(item.rid_, txn);
     } else if (item.wtype_ == WType::INSERT) {
       // Note that this also releases the lock when holding the page latch.
       table->ApplyDelete(item.rid_, txn);
     } else if (item.wtype_ == WType::UPDATE) {
-      table->UpdateTuple(item.tuple_, item.rid_, txn);
+      if (item.tuple_.GetLength() > 0) {
+        table->UpdateTuple(item.tuple_, item.rid_, txn);
+      } else {
+        table->RollbackUpdate(item.rid_, item.lsn_, &log_buffer, txn);
+      }
+    } else if (item.wtype_ == WType::BULKINSERT) {
+      table->RollbackBulkInsert(item.rid_.GetPageId(), txn);
+    } else if (item.wtype_ == WType::TRUNCATE) {
+      table->RollbackTruncate(item.tuple_, this, txn);
     }
     write_set->pop_back();
+    if (logged) {
+      // Undo goes on with the last record of the write before. The records in between are those that this rollback
+      // logged, and those that the write logged before its last one, e.g. of the page that it created.
+      const lsn_t undo_next_lsn = write_set->empty() ? INVALID_LSN : write_set->back().lsn_;
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), undo_next_lsn);
+      txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+    }
   }
   write_set->clear();
+  txn->GetReadSet()->clear();
+  txn->GetWriteBuffer()->clear();
 
-  if (enable_logging) {
-    // TODO(student): add logging here
+  if (enable_logging && log_manager_ != nullptr && !txn->IsReadOnly()) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
   }
 
   // Release all the locks.
   ReleaseLocks(txn);
+  EndTransaction(txn);
   // Release the global transaction latch.
   global_txn_latch_.RUnlock();
 }
 
+std::vector<std::pair<txn_id_t, lsn_t>> TransactionManager::GetActiveTransactions(lsn_t *begin_lsn) {
+  std::scoped_lock lock(active_txns_latch_);
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns;
+  active_txns.reserve(active_txns_.size());
+  lsn_t oldest_begin_lsn = INVALID_LSN;
+  for (const auto &[txn_id, entry] : active_txns_) {
+    if (entry.first->IsReadOnly()) {
+      continue;
+    }
+    active_txns.emplace_back(txn_id, entry.first->GetPrevLSN());
+    if (entry.second != INVALID_LSN && (oldest_begin_lsn == INVALID_LSN || entry.second < oldest_begin_lsn)) {
+      oldest_begin_lsn = entry.second;
+    }
+  }
+  if (begin_lsn != nullptr) {
+    *begin_lsn = oldest_begin_lsn;
+  }
+  return active_txns;
+}
+
+std::vector<txn_id_t> TransactionManager::GetActiveTxnIds() {
+  std::scoped_lock lock(active_txns_latch_);
+  std::vector<txn_id_t> txn_ids;
+  txn_ids.reserve(active_txns_.size());
+  for (const auto &[txn_id, entry] : active_txns_) {
+    txn_ids.push_back(txn_id);
+  }
+  return txn_ids;
+}
+
+void TransactionManager::EndTransaction(Transaction *txn) {
+  txn_registry.Unregister(txn);
+  {
+    std::scoped_lock lock(active_txns_latch_);
+    auto node = active_txns_.extract(txn->GetTransactionId());
+    if (!node.empty()) {
+      active_txns_nodes_.push_back(std::move(node));
+    }
+  }
+  if (txn->IsTraced()) {
+    Tracer::Record(txn->GetTransactionId(), "transaction", txn->GetTraceStart());
+    if (Tracer::GetCurrentTxn() == txn->GetTransactionId()) {
+      Tracer::SetCurrentTxn(INVALID_TXN_ID);
+    }
+  }
+}
+
+void TransactionManager::Recycle(Transaction *txn) {
+  std::scoped_lock lock(active_txns_latch_);
+  txn_pool_.push_back(txn);
+}
+
+bool TransactionManager::WriteBuffered(Transaction *txn) {
+  auto write_buffer = txn->GetWriteBuffer();
+  // All rows are locked before the first is written. The transaction stops growing then, so no older transaction can
+  // wound it anymore, and it must not wait for another lock afterwards.
+  for (const auto &item : *write_buffer) {
+    if (!item.table_->LockTable(txn, LockMode::INTENTION_EXCLUSIVE) ||
+        (item.wtype_ != WType::INSERT && !item.table_->LockRowExclusive(item.rid_, txn))) {
+      return false;
+    }
+  }
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  txn->SetState(TransactionState::COMMITTED);
+  for (const auto &item : *write_buffer) {
+    RID rid;
+    bool written = false;
+    if (item.wtype_ == WType::INSERT) {
+      written = item.table_->InsertTuple(item.tuple_, &rid, txn);
+    } else if (item.wtype_ == WType::DELETE) {
+      written = item.table_->MarkDelete(item.rid_, txn);
+    } else if (item.wtype_ == WType::UPDATE) {
+      written = item.table_->UpdateTuple(item.tuple_, item.rid_, txn);
+    }
+    if (!written || txn->GetState() == TransactionState::ABORTED) {
+      return false;
+    }
+  }
+  write_buffer->clear();
+  return true;
+}
+
+bool TransactionManager::CommitVersions(Transaction *txn) {
+  auto write_set = txn->GetWriteSet();
+  // A transaction that wrote nothing read a consistent snapshot, which needs no validation.
+  if (write_set->empty()) {
+    return true;
+  }
+  std::scoped_lock commit_lock(commit_latch_);
+  // Under the latch, a row that was read cannot be committed by another transaction before this one anymore.
+  for (const auto &item : *txn->GetReadSet()) {
+    if (!item.table_->GetVersionStore()->Validate(item.rid_, txn)) {
+      return false;
+    }
+  }
+  const timestamp_t commit_ts = last_commit_ts_ + 1;
+  // The versions before the oldest snapshot are dropped.
+  const timestamp_t watermark = ComputeWatermark();
+  for (const auto &item : *write_set) {
+    if (item.wtype_ != WType::BULKINSERT && item.wtype_ != WType::TRUNCATE) {
+      item.table_->GetVersionStore()->Commit(item.rid_, txn, commit_ts, watermark);
+    }
+  }
+  last_commit_ts_ = commit_ts;
+  return true;
+}
+
+timestamp_t TransactionManager::GetWatermark() {
+  std::scoped_lock commit_lock(commit_latch_);
+  return ComputeWatermark();
+}
+
+timestamp_t TransactionManager::ComputeWatermark() {
+  // A snapshot that begins before the next commit is visible reads at the last commit timestamp, which bounds the
+  // watermark as well.
+  timestamp_t watermark = last_commit_ts_;
+  std::scoped_lock lock(active_txns_latch_);
+  for (const auto &[txn_id, entry] : active_txns_) {
+    if (entry.first->IsSnapshot()) {
+      watermark = std::min(watermark, entry.first->GetReadTs());
+    }
+  }
+  return watermark;
+}
+
 void TransactionManager::BlockAllTransactions() { global_txn_latch_.WLock(); }
 
 void TransactionManager::ResumeTransactions() { global_txn_latch_.WUnlock(); }
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// transaction_registry.cpp
+//
+// Identification: src/concurrency/transaction_registry.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/transaction_registry.h"
+
+#include "concurrency/transaction.h"
+
+namespace bustub {
+
+void TransactionRegistry::Register(Transaction *txn) {
+  const txn_id_t txn_id = txn->GetTransactionId();
+  Slot *slot = GetSlot(txn_id);
+  txn_id_t expected = INVALID_TXN_ID;
+  // The id claims the slot, the transaction is published in it afterwards.
+  if (slot->txn_id_.compare_exchange_strong(expected, txn_id) || expected == txn_id) {
+    slot->txn_.store(txn, std::memory_order_release);
+    return;
+  }
+  std::scoped_lock lock(overflow_latch_);
+  overflow_[txn_id] = txn;
+  overflow_size_ = overflow_.size();
+}
+
+void TransactionRegistry::Unregister(Transaction *txn) {
+  const txn_id_t txn_id = txn->GetTransactionId();
+  Slot *slot = GetSlot(txn_id);
+  if (slot->txn_id_.load(std::memory_order_acquire) == txn_id) {
+    // The transaction leaves the slot before the id frees it for the next one.
+    slot->txn_.store(nullptr, std::memory_order_release);
+    slot->txn_id_.store(INVALID_TXN_ID, std::memory_order_release);
+    return;
+  }
+  if (overflow_size_ == 0) {
+    return;
+  }
+  std::scoped_lock lock(overflow_latch_);
+  overflow_.erase(txn_id);
+  overflow_size_ = overflow_.size();
+}
+
+Transaction *TransactionRegistry::Find(txn_id_t txn_id) {
+  Slot *slot = GetSlot(txn_id);
+  if (slot->txn_id_.load(std::memory_order_acquire) == txn_id) {
+    Transaction *txn = slot->txn_.load(std::memory_order_acquire);
+    // The slot may have been handed to another transaction in between, which would have changed the id.
+    if (txn != nullptr && slot->txn_id_.load(std::memory_order_acquire) == txn_id) {
+      return txn;
+    }
+  }
+  if (overflow_size_ == 0) {
+    return nullptr;
+  }
+  std::scoped_lock lock(overflow_latch_);
+  auto it = overflow_.find(txn_id);
+  return it != overflow_.end() ? it->second : nullptr;
+}
+
+}  // namespace bustub
@@ -0,0 +1,240 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table.cpp
+//
+// Identification: src/container/hash/extendible_hash_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/rid.h"
+#include "container/hash/extendible_hash_table.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+EXTENDIBLE_HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+                                                const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  // 1. get a directory page from the BufferPoolManager
+  Page *directory_page = buffer_pool_manager_->NewPage(&directory_page_id_, nullptr);
+  directory_page_ = reinterpret_cast<HashTableDirectoryPage *>(directory_page->GetData());
+  directory_page_->SetPageId(directory_page_id_);
+
+  // 2. create the only bucket, which all keys hash to at global depth 0
+  page_id_t bucket_page_id;
+  buffer_pool_manager_->NewPage(&bucket_page_id, nullptr);
+  directory_page_->SetBucketPageId(0, bucket_page_id);
+  directory_page_->SetLocalDepth(0, 0);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key,
+                                          std::vector<ValueType> *result) {
+  std::vector<ValueType> values;
+  table_latch_.RLock();
+  // Lookups read the bucket optimistically, the scan may run again if an insert or remove gets in the way.
+  bool fetched = buffer_pool_manager_->ReadPageOptimistic(KeyToPageId(key), [&](const char *data) {
+    values.clear();
+    reinterpret_cast<const BucketPage *>(data)->GetValue(key, comparator_, &values);
+  });
+  table_latch_.RUnlock();
+  if (!fetched || values.empty()) {
+    return false;
+  }
+  result->insert(result->end(), values.begin(), values.end());
+  return true;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.RLock();
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(KeyToPageId(key));
+  if (!bucket_guard.IsValid()) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  auto bucket_page = bucket_guard.AsMut<BucketPage>();
+  if (!bucket_page->IsFull()) {
+    bool inserted = bucket_page->Insert(key, value, comparator_);
+    bucket_guard.Drop();
+    table_latch_.RUnlock();
+    return inserted;
+  }
+  bucket_guard.Drop();
+  table_latch_.RUnlock();
+  return SplitInsert(key, value);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::SplitInsert(const KeyType &key, const ValueType &value) {
+  table_latch_.WLock();
+  bool inserted = false;
+  for (;;) {
+    // The directory may have changed since the bucket was found full, and a split may leave every pair on one side.
+    const uint32_t bucket_idx = Hash(key) & directory_page_->GetGlobalDepthMask();
+    const page_id_t bucket_page_id = directory_page_->GetBucketPageId(bucket_idx);
+    WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);
+    if (!bucket_guard.IsValid()) {
+      break;
+    }
+    auto bucket_page = bucket_guard.AsMut<BucketPage>();
+    if (!bucket_page->IsFull()) {
+      inserted = bucket_page->Insert(key, value, comparator_);
+      break;
+    }
+    std::vector<ValueType> values;
+    bucket_page->GetValue(key, comparator_, &values);
+    if (std::find(values.begin(), values.end(), value) != values.end()) {
+      break;
+    }
+
+    const uint32_t local_depth = directory_page_->GetLocalDepth(bucket_idx);
+    if (local_depth == directory_page_->GetGlobalDepth()) {
+      if (directory_page_->Size() * 2 > DIRECTORY_ARRAY_SIZE) {
+        LOG_WARN("Hash table directory is full and cannot split any more buckets.");
+        break;
+      }
+      directory_page_->IncrGlobalDepth();
+    }
+
+    // Split: the pairs whose hash has the next bit set move to the image.
+    page_id_t image_page_id;
+    WritePageGuard image_guard = buffer_pool_manager_->NewPageGuarded(&image_page_id).UpgradeWrite();
+    if (!image_guard.IsValid()) {
+      break;
+    }
+    auto image_page = image_guard.AsMut<BucketPage>();
+    const uint32_t high_bit = 1U << local_depth;
+    slot_offset_t image_ind = 0;
+    for (slot_offset_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+      if (bucket_page->IsReadable(i) && (Hash(bucket_page->KeyAt(i)) & high_bit) != 0) {
+        image_page->InsertAt(image_ind++, bucket_page->KeyAt(i), bucket_page->ValueAt(i));
+        bucket_page->RemoveAt(i);
+      }
+    }
+    for (uint32_t i = 0; i < directory_page_->Size(); i++) {
+      if (directory_page_->GetBucketPageId(i) == bucket_page_id) {
+        directory_page_->SetLocalDepth(i, local_depth + 1);
+        if ((i & high_bit) != 0) {
+          directory_page_->SetBucketPageId(i, image_page_id);
+        }
+      }
+    }
+  }
+  table_latch_.WUnlock();
+  return inserted;
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool EXTENDIBLE_HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.RLock();
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(KeyToPageId(key));
+  if (!bucket_guard.IsValid()) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  auto bucket_page = bucket_guard.AsMut<BucketPage>();
+  const bool removed = bucket_page->Remove(key, value, comparator_);
+  const bool emptied = removed && bucket_page->IsEmpty();
+  bucket_guard.Drop();
+  table_latch_.RUnlock();
+  if (emptied) {
+    Merge(key);
+  }
+  return removed;
+}
+
+/*****************************************************************************
+ * MERGE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void EXTENDIBLE_HASH_TABLE_TYPE::Merge(const KeyType &key) {
+  table_latch_.WLock();
+  for (;;) {
+    const uint32_t bucket_idx = Hash(key) & directory_page_->GetGlobalDepthMask();
+    const uint32_t local_depth = directory_page_->GetLocalDepth(bucket_idx);
+    if (local_depth == 0) {
+      break;
+    }
+    const uint32_t image_idx = directory_page_->GetSplitImageIndex(bucket_idx);
+    if (directory_page_->GetLocalDepth(image_idx) != local_depth) {
+      break;
+    }
+    // An insert may have refilled the bucket before the directory was write latched.
+    const page_id_t bucket_page_id = directory_page_->GetBucketPageId(bucket_idx);
+    bool empty = false;
+    if (!buffer_pool_manager_->ReadPageOptimistic(bucket_page_id, [&](const char *data) {
+          empty = reinterpret_cast<const BucketPage *>(data)->IsEmpty();
+        }) ||
+        !empty) {
+      break;
+    }
+
+    const page_id_t image_page_id = directory_page_->GetBucketPageId(image_idx);
+    for (uint32_t i = 0; i < directory_page_->Size(); i++) {
+      const page_id_t page_id = directory_page_->GetBucketPageId(i);
+      if (page_id == bucket_page_id || page_id == image_page_id) {
+        directory_page_->SetBucketPageId(i, image_page_id);
+        directory_page_->SetLocalDepth(i, local_depth - 1);
+      }
+    }
+    buffer_pool_manager_->DeletePage(bucket_page_id);
+  }
+  while (directory_page_->CanShrink()) {
+    directory_page_->DecrGlobalDepth();
+  }
+  table_latch_.WUnlock();
+}
+
+/*****************************************************************************
+ * GETGLOBALDEPTH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::GetGlobalDepth() {
+  table_latch_.RLock();
+  uint32_t global_depth = directory_page_->GetGlobalDepth();
+  table_latch_.RUnlock();
+  return global_depth;
+}
+
+/*****************************************************************************
+ * VERIFY INTEGRITY
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void EXTENDIBLE_HASH_TABLE_TYPE::VerifyIntegrity() {
+  table_latch_.RLock();
+  directory_page_->VerifyIntegrity();
+  table_latch_.RUnlock();
+}
+
+template class ExtendibleHashTable<int, int, IntComparator>;
+
+template class ExtendibleHashTable<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExtendibleHashTable<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExtendibleHashTable<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -10,7 +10,8 @@
 //
 //===----------------------------------------------------------------------===//
 
-#include <iostream>
+#include <algorithm>
+#include <array>
 #include <string>
 #include <utility>
 #include <vector>
@@ -19,29 +20,65 @@
 #include "common/logger.h"
 #include "common/rid.h"
 #include "container/hash/linear_probe_hash_table.h"
+#include "storage/index/hash_comparator.h"
+#include "storage/table/tmp_tuple.h"
 
 namespace bustub {
 
+namespace {
+
+/** Sorts (position, item) pairs by position, a byte at a time from the lowest. */
+void RadixSortPositions(std::vector<std::pair<uint64_t, size_t>> *entries, uint64_t max_position) {
+  std::vector<std::pair<uint64_t, size_t>> sorted(entries->size());
+  for (int shift = 0; shift < 64 && (max_position >> shift) != 0; shift += 8) {
+    std::array<size_t, 257> offsets{};
+    for (const auto &entry : *entries) {
+      offsets[((entry.first >> shift) & 0xff) + 1]++;
+    }
+    for (size_t digit = 1; digit < offsets.size(); digit++) {
+      offsets[digit] += offsets[digit - 1];
+    }
+    for (const auto &entry : *entries) {
+      sorted[offsets[(entry.first >> shift) & 0xff]++] = entry;
+    }
+    entries->swap(sorted);
+  }
+}
+
+}  // namespace
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                       const KeyComparator &comparator, size_t num_buckets,
-                                      HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)), num_blocks_(num_buckets) {
-  // assume that the num_buckets is always no larger than 1020
+                                      HashFunction<KeyType> hash_fn, bool unique_keys)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      unique_keys_(unique_keys),
+      hash_fn_(std::move(hash_fn)),
+      num_blocks_(num_buckets) {
   // 1. get a header page from the BufferPoolManager
-  header_page_ = reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->NewPage(&header_page_id_, nullptr)->GetData());
+  Page *header_page = buffer_pool_manager_->NewPage(&header_page_id_, nullptr);
+  header_page_ = reinterpret_cast<HashTableHeaderPage *>(header_page->GetData());
 
-  // 2. create block pages
-  page_id_t block_page_id_tmp;
-  for (size_t i = 0; i < num_buckets; i++) {
-    buffer_pool_manager_->NewPage(&block_page_id_tmp, nullptr);
-    header_page_->AddBlockPageId(block_page_id_tmp);
-    buffer_pool_manager_->UnpinPage(block_page_id_tmp, true);
+  // 2. create block pages, in batches as large as the free frames of the buffer pool allow
+  std::vector<page_id_t> block_page_ids;
+  while (block_page_ids_.size() < num_buckets) {
+    if (buffer_pool_manager_->NewPages(num_buckets - block_page_ids_.size(), &block_page_ids).empty()) {
+      break;
+    }
+    buffer_pool_manager_->UnpinPages(block_page_ids, true);
+    if (!AddBlockPages(block_page_ids)) {
+      for (page_id_t block_page_id : block_page_ids) {
+        buffer_pool_manager_->DeletePage(block_page_id);
+      }
+      break;
+    }
   }
+  num_blocks_ = block_page_ids_.size();
 
   // 3. set header page metadata
   header_page_->SetPageId(header_page_id_);
-  header_page_->SetSize(BLOCK_ARRAY_SIZE * num_buckets);
+  header_page_->SetSize(BLOCK_ARRAY_SIZE * num_blocks_);
 }
 
 /*****************************************************************************
@@ -49,42 +86,228 @@ HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
+  Migrate();
   uint64_t hash_res = hash_fn_.GetHash(key);
-  page_id_t block_page_id = header_page_->GetBlockPageId(hash_res % num_blocks_);
-  auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator> *>(buffer_pool_manager_->FetchPage(block_page_id)->GetData());
+  table_latch_.RLock();
+  bool found = LookupValues(key, hash_res, result);
+  table_latch_.RUnlock();
+  return found;
+}
 
-  slot_offset_t buck_ind = hash_res % BLOCK_ARRAY_SIZE;
-  while (buck_ind < BLOCK_ARRAY_SIZE) {
-    if (!block_page->IsOccupied(buck_ind)) { break; }
-    if (block_page->IsReadable(buck_ind)) { result->push_back(block_page->ValueAt(buck_ind)); }
-    buck_ind++;
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::GetValueBatch(Transaction *transaction, const std::vector<KeyType> &keys,
+                                    std::vector<std::vector<ValueType>> *results) {
+  Migrate();
+  results->assign(keys.size(), {});
+  std::vector<uint64_t> hashes(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    hashes[i] = hash_fn_.GetHash(keys[i]);
   }
+  bool found = true;
+  table_latch_.RLock();
+  std::vector<page_id_t> page_ids;
+  std::vector<size_t> probed;
+  for (size_t group = 0; group < keys.size(); group += HASH_TABLE_BATCH_SIZE) {
+    const size_t group_end = std::min<size_t>(keys.size(), group + HASH_TABLE_BATCH_SIZE);
+    // The home blocks of the group are pinned together, which reads the missing ones in a single pass. The keys that
+    // the filter rules out need no block.
+    page_ids.clear();
+    probed.clear();
+    for (size_t i = group; i < group_end; i++) {
+      const size_t block_index = GetBlockIndex(hashes[i]);
+      if (filter_ == nullptr || filter_->MayContain(block_index, hashes[i])) {
+        page_ids.push_back(GetBlockPageId(block_index));
+        probed.push_back(i);
+      }
+    }
+    std::vector<Page *> pages = buffer_pool_manager_->FetchPages(page_ids);
+    for (size_t j = 0; j < probed.size(); j++) {
+      if (pages[j] != nullptr) {
+        reinterpret_cast<const BlockPage *>(pages[j]->GetData())->PrefetchBucket(GetBucketIndex(hashes[probed[j]]));
+      }
+    }
+    for (size_t i : probed) {
+      found = LookupValues(keys[i], hashes[i], &(*results)[i]) && found;
+    }
+    page_ids.clear();
+    for (Page *page : pages) {
+      if (page != nullptr) {
+        page_ids.push_back(page->GetPageId());
+      }
+    }
+    buffer_pool_manager_->UnpinPages(page_ids, false);
+  }
+  table_latch_.RUnlock();
+  return found;
+}
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::LookupValues(const KeyType &key, uint64_t hash, std::vector<ValueType> *result) {
+  const size_t num_active = GetNumActiveBlocks();
+  const size_t num_buckets = num_active * BLOCK_ARRAY_SIZE;
+  size_t block_index = GetBlockIndex(hash);
+  if (filter_ != nullptr && !filter_->MayContain(block_index, hash)) {
+    return true;
+  }
+  slot_offset_t start_ind = GetBucketIndex(hash);
+  if (start_ind + HASH_TABLE_PREFETCH_SLOTS >= BLOCK_ARRAY_SIZE) {
+    PrefetchNextBlock(block_index, num_active);
+  }
+  // Lookups read each block optimistically, the probe of a block may run again if an insert or remove gets in the way.
+  const uint8_t fingerprint = GetFingerprint(hash);
+  std::vector<ValueType> values;
+  std::vector<ValueType> block_values;
+  bool found = true;
+  bool run_ended = false;
+  for (size_t probed = 0; found && !run_ended && probed < num_buckets; block_index = (block_index + 1) % num_active) {
+    const slot_offset_t end_ind = std::min<size_t>(BLOCK_ARRAY_SIZE, start_ind + num_buckets - probed);
+    found = buffer_pool_manager_->ReadPageOptimistic(
+        GetBlockPageId(block_index), [&](const char *data) {
+          block_values.clear();
+          auto block_page = reinterpret_cast<const BlockPage *>(data);
+          // A unique key ends the probe at its match.
+          run_ended = ProbeBlock(block_page, start_ind, end_ind, fingerprint, nullptr, [&](slot_offset_t buck_ind) {
+                        if (comparator_(block_page->KeyAt(buck_ind), key) == 0) {
+                          block_values.push_back(block_page->ValueAt(buck_ind));
+                          return unique_keys_;
+                        }
+                        return false;
+                      }) != BlockProbe::CONTINUE;
+        });
+    values.insert(values.end(), block_values.begin(), block_values.end());
+    probed += end_ind - start_ind;
+    start_ind = 0;
+  }
+  if (!found) {
+    return false;
+  }
+  result->insert(result->end(), values.begin(), values.end());
   return true;
 }
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
   // only returns false if it tries to insert an existing key-value pair.
+  Migrate();
+  for (;;) {
+    table_latch_.RLock();
+    ProbeResult result = TryInsert(key, value, false);
+    size_t size = header_page_->GetSize();
+    table_latch_.RUnlock();
+    if (result == ProbeResult::WRAPPED) {
+      table_latch_.WLock();
+      result = TryInsert(key, value, true);
+      size = header_page_->GetSize();
+      table_latch_.WUnlock();
+    }
+    if (result != ProbeResult::FULL) {
+      if (result == ProbeResult::SUCCESS) {
+        std::atomic<int64_t> &count = entry_counts_[DistributedReaderWriterLatch::GetSlot()].count_;
+        const int64_t num_inserts = count.fetch_add(1, std::memory_order_relaxed) + 1;
+        const bool check_load = num_inserts % HASH_TABLE_LOAD_CHECK_INTERVAL == 0;
+        if (check_load && !growing_ && CountEntries() * 100 > size * HASH_TABLE_MAX_LOAD_PERCENT) {
+          Resize(size);
+        }
+      }
+      return result == ProbeResult::SUCCESS;
+    }
+    if (!Grow()) {
+      LOG_WARN("Hash table is full and cannot insert any more kv pair.");
+      return false;
+    }
+  }
+}
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+typename HASH_TABLE_TYPE::ProbeResult HASH_TABLE_TYPE::TryInsert(const KeyType &key, const ValueType &value,
+                                                                bool exclusive) {
   uint64_t hash_res = hash_fn_.GetHash(key);
-  page_id_t block_page_id = header_page_->GetBlockPageId(hash_res % num_blocks_);
-  auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator> *>(buffer_pool_manager_->FetchPage(block_page_id)->GetData());
+  const uint8_t fingerprint = GetFingerprint(hash_res);
+  const size_t num_active = GetNumActiveBlocks();
+  const size_t num_buckets = num_active * BLOCK_ARRAY_SIZE;
+  size_t block_index = GetBlockIndex(hash_res);
+  slot_offset_t bucket_ind = GetBucketIndex(hash_res);
+  if (bucket_ind + HASH_TABLE_PREFETCH_SLOTS >= BLOCK_ARRAY_SIZE) {
+    PrefetchNextBlock(block_index, num_active);
+  }
 
-  slot_offset_t bucket_ind = hash_res % BLOCK_ARRAY_SIZE;
-  while (bucket_ind < BLOCK_ARRAY_SIZE) {
-    if (block_page->IsReadable(bucket_ind) && block_page->ValueAt(bucket_ind) == value) {
-      std::cout << "Cannot insert duplicate values for the same key." << std::endl;
-      return false;
+  // The home block, the block of the free slot and the current block. An exclusive probe, which nobody can get in
+  // the way of, only keeps the current one, and may thus come around to a block again.
+  std::vector<WritePageGuard> guards;
+  size_t current_block = block_index;
+  size_t free_guard = 0;
+  size_t free_block = 0;
+  // The first tombstone or empty bucket takes the pair, but the rest of the run may still hold it.
+  slot_offset_t free_ind = BLOCK_ARRAY_SIZE;
+  for (size_t probed = 0; probed < num_buckets;) {
+    if (exclusive) {
+      guards.clear();
+    }
+    current_block = block_index;
+    guards.push_back(buffer_pool_manager_->FetchPageWrite(GetBlockPageId(block_index)));
+    if (!guards.back().IsValid()) {
+      return ProbeResult::FAILURE;
+    }
+    auto block_page = guards.back().As<BlockPage>();
+    const slot_offset_t end_ind = std::min<size_t>(BLOCK_ARRAY_SIZE, bucket_ind + num_buckets - probed);
+    const bool has_free = free_ind != BLOCK_ARRAY_SIZE;
+    const BlockProbe probe = ProbeBlock(block_page, bucket_ind, end_ind, fingerprint, has_free ? nullptr : &free_ind,
+                                        [&](slot_offset_t match_ind) {
+                                          return comparator_(block_page->KeyAt(match_ind), key) == 0 &&
+                                                 (unique_keys_ || block_page->ValueAt(match_ind) == value);
+                                        });
+    if (probe == BlockProbe::STOPPED) {
+      if (unique_keys_) {
+        LOG_DEBUG("Cannot insert a duplicate key.");
+      } else {
+        LOG_DEBUG("Cannot insert duplicate values for the same key.");
+      }
+      return ProbeResult::FAILURE;
+    }
+    if (!has_free && free_ind != BLOCK_ARRAY_SIZE) {
+      free_guard = guards.size() - 1;
+      free_block = block_index;
+    }
+    probed += end_ind - bucket_ind;
+    if (probe == BlockProbe::RUN_ENDED) {
+      break;
+    }
+    if (!exclusive && guards.size() > 1 && free_guard != guards.size() - 1) {
+      guards.pop_back();
+    }
+    bucket_ind = 0;
+    if (++block_index == num_active) {
+      if (!exclusive) {
+        return ProbeResult::WRAPPED;
+      }
+      block_index = 0;
     }
-    if (block_page->Insert(bucket_ind, key, value)) { return true; }
-    bucket_ind++;
   }
-
-   std::cout << "Block page [" << block_page_id << "] is full and cannot insert any more kv pair." << std::endl;
-   return false;
+  if (free_ind == BLOCK_ARRAY_SIZE) {
+    return ProbeResult::FULL;
+  }
+  if (exclusive) {
+    if (free_block != current_block) {
+      guards.clear();
+      guards.push_back(buffer_pool_manager_->FetchPageWrite(GetBlockPageId(free_block)));
+      if (!guards.back().IsValid()) {
+        return ProbeResult::FAILURE;
+      }
+    }
+    free_guard = guards.size() - 1;
+  }
+  // The filter takes the key first, so that a lookup that finds the pair also passes the filter.
+  if (filter_ != nullptr) {
+    filter_->Add(GetBlockIndex(hash_res), hash_res);
+  }
+  if (guards[free_guard].As<BlockPage>()->IsOccupied(free_ind)) {
+    tombstone_counts_[DistributedReaderWriterLatch::GetSlot()].count_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  guards[free_guard].AsMut<BlockPage>()->Insert(free_ind, key, value, fingerprint);
+  return ProbeResult::SUCCESS;
 }
 
 /*****************************************************************************
@@ -92,34 +315,640 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  Migrate();
+  table_latch_.RLock();
+  ProbeResult result = TryRemove(key, value, false);
+  size_t num_buckets = GetNumActiveBlocks() * BLOCK_ARRAY_SIZE;
+  table_latch_.RUnlock();
+  if (result == ProbeResult::WRAPPED) {
+    table_latch_.WLock();
+    result = TryRemove(key, value, true);
+    num_buckets = GetNumActiveBlocks() * BLOCK_ARRAY_SIZE;
+    table_latch_.WUnlock();
+  }
+  if (result != ProbeResult::SUCCESS) {
+    return false;
+  }
+  const size_t slot = DistributedReaderWriterLatch::GetSlot();
+  entry_counts_[slot].count_.fetch_sub(1, std::memory_order_relaxed);
+  const int64_t removes = tombstone_counts_[slot].count_.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (removes % HASH_TABLE_LOAD_CHECK_INTERVAL == 0 && HasTooManyTombstones(num_buckets)) {
+    Compact();
+  }
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+typename HASH_TABLE_TYPE::ProbeResult HASH_TABLE_TYPE::TryRemove(const KeyType &key, const ValueType &value,
+                                                                bool exclusive) {
   uint64_t hash_res = hash_fn_.GetHash(key);
-  page_id_t block_page_id = header_page_->GetBlockPageId(hash_res % num_blocks_);
-  auto block_page = reinterpret_cast<HashTableBlockPage<KeyType, ValueType, KeyComparator> *>(buffer_pool_manager_->FetchPage(block_page_id)->GetData());
+  const uint8_t fingerprint = GetFingerprint(hash_res);
+  const size_t num_active = GetNumActiveBlocks();
+  const size_t num_buckets = num_active * BLOCK_ARRAY_SIZE;
+  size_t block_index = GetBlockIndex(hash_res);
+  slot_offset_t bucket_ind = GetBucketIndex(hash_res);
+  if (bucket_ind + HASH_TABLE_PREFETCH_SLOTS >= BLOCK_ARRAY_SIZE) {
+    PrefetchNextBlock(block_index, num_active);
+  }
+
+  // The home block and the current block, see TryInsert().
+  std::vector<WritePageGuard> guards;
+  for (size_t probed = 0; probed < num_buckets;) {
+    if (exclusive) {
+      guards.clear();
+    } else if (guards.size() > 1) {
+      guards.pop_back();
+    }
+    guards.push_back(buffer_pool_manager_->FetchPageWrite(GetBlockPageId(block_index)));
+    if (!guards.back().IsValid()) {
+      return ProbeResult::FAILURE;
+    }
+    auto block_page = guards.back().As<BlockPage>();
+    const slot_offset_t end_ind = std::min<size_t>(BLOCK_ARRAY_SIZE, bucket_ind + num_buckets - probed);
+    slot_offset_t found_ind = BLOCK_ARRAY_SIZE;
+    const BlockProbe probe =
+        ProbeBlock(block_page, bucket_ind, end_ind, fingerprint, nullptr, [&](slot_offset_t match_ind) {
+          found_ind = match_ind;
+          return comparator_(block_page->KeyAt(match_ind), key) == 0 &&
+                 (unique_keys_ || block_page->ValueAt(match_ind) == value);
+        });
+    if (probe == BlockProbe::STOPPED) {
+      // The only pair of a unique key may have another value.
+      if (!(block_page->ValueAt(found_ind) == value)) {
+        return ProbeResult::FAILURE;
+      }
+      guards.back().AsMut<BlockPage>()->Remove(found_ind);
+      return ProbeResult::SUCCESS;
+    }
+    if (probe == BlockProbe::RUN_ENDED) {
+      return ProbeResult::FAILURE;
+    }
+    probed += end_ind - bucket_ind;
+    bucket_ind = 0;
+    if (++block_index == num_active) {
+      if (!exclusive) {
+        return ProbeResult::WRAPPED;
+      }
+      block_index = 0;
+    }
+  }
+  return ProbeResult::FAILURE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <class OnMatch>
+typename HASH_TABLE_TYPE::BlockProbe HASH_TABLE_TYPE::ProbeBlock(const BlockPage *block_page, slot_offset_t begin,
+                                                                slot_offset_t end, uint8_t fingerprint,
+                                                                slot_offset_t *first_free, OnMatch &&on_match) {
+  constexpr slot_offset_t group_size = BlockPage::BLOCK_GROUP_SIZE;
+  for (slot_offset_t group_ind = begin - begin % group_size; group_ind < end; group_ind += group_size) {
+    const auto masks = block_page->MatchGroup(group_ind, fingerprint);
+    const slot_offset_t low = std::max(begin, group_ind) - group_ind;
+    const slot_offset_t high = std::min(end, group_ind + group_size) - group_ind;
+    const uint32_t range = (high == 32 ? ~0U : (1U << high) - 1) & ~((1U << low) - 1);
+    const uint32_t empty = masks.empty_ & range;
+    const uint32_t first_empty = empty & (~empty + 1);
+    // Only the buckets before the first empty one belong to the run.
+    const uint32_t run = empty == 0 ? range : range & (first_empty - 1);
+    if (first_free != nullptr && *first_free == BLOCK_ARRAY_SIZE) {
+      const uint32_t free = ~masks.readable_ & (run | first_empty);
+      if (free != 0) {
+        *first_free = group_ind + __builtin_ctz(free);
+      }
+    }
+    for (uint32_t match = masks.match_ & run; match != 0; match &= match - 1) {
+      if (on_match(group_ind + __builtin_ctz(match))) {
+        return BlockProbe::STOPPED;
+      }
+    }
+    if (empty != 0) {
+      return BlockProbe::RUN_ENDED;
+    }
+  }
+  return BlockProbe::CONTINUE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::PrefetchNextBlock(size_t block_index, size_t num_active_blocks) {
+  if (num_active_blocks > 1) {
+    buffer_pool_manager_->PrefetchPages(GetBlockPageId((block_index + 1) % num_active_blocks), 1);
+  }
+}
+
+/*****************************************************************************
+ * BATCH INSERTION AND REMOVE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::InsertBatch(Transaction *transaction, const std::vector<MappingType> &pairs) {
+  Migrate();
+  std::vector<size_t> order;
+  std::vector<size_t> retries;
+  size_t inserted = 0;
+  for (size_t begin = 0; begin < pairs.size(); begin += BLOCK_ARRAY_SIZE) {
+    table_latch_.RLock();
+    // The order of a table that grew in between is still good enough, the probes start from the current homes.
+    if (order.empty()) {
+      order = SortByHome(pairs);
+    }
+    size_t chunk_inserted = 0;
+    for (size_t i = begin; i < std::min<size_t>(pairs.size(), begin + BLOCK_ARRAY_SIZE); i++) {
+      const MappingType &pair = pairs[order[i]];
+      const ProbeResult result = TryInsert(pair.first, pair.second, false);
+      if (result == ProbeResult::SUCCESS) {
+        chunk_inserted++;
+      } else if (result == ProbeResult::WRAPPED || result == ProbeResult::FULL) {
+        retries.push_back(order[i]);
+      }
+    }
+    const size_t size = header_page_->GetSize();
+    table_latch_.RUnlock();
+    entry_counts_[DistributedReaderWriterLatch::GetSlot()].count_.fetch_add(chunk_inserted, std::memory_order_relaxed);
+    inserted += chunk_inserted;
+    if (chunk_inserted != 0 && !growing_ && CountEntries() * 100 > size * HASH_TABLE_MAX_LOAD_PERCENT) {
+      Resize(size);
+    }
+  }
+  for (size_t retry : retries) {
+    inserted += Insert(transaction, pairs[retry].first, pairs[retry].second) ? 1 : 0;
+  }
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::RemoveBatch(Transaction *transaction, const std::vector<MappingType> &pairs) {
+  Migrate();
+  std::vector<size_t> retries;
+  table_latch_.RLock();
+  const std::vector<size_t> order = SortByHome(pairs);
+  size_t removed = 0;
+  for (size_t i : order) {
+    const ProbeResult result = TryRemove(pairs[i].first, pairs[i].second, false);
+    if (result == ProbeResult::SUCCESS) {
+      removed++;
+    } else if (result == ProbeResult::WRAPPED) {
+      retries.push_back(i);
+    }
+  }
+  const size_t num_buckets = GetNumActiveBlocks() * BLOCK_ARRAY_SIZE;
+  table_latch_.RUnlock();
+  if (removed != 0) {
+    const size_t slot = DistributedReaderWriterLatch::GetSlot();
+    entry_counts_[slot].count_.fetch_sub(removed, std::memory_order_relaxed);
+    tombstone_counts_[slot].count_.fetch_add(removed, std::memory_order_relaxed);
+    if (HasTooManyTombstones(num_buckets)) {
+      Compact();
+    }
+  }
+  for (size_t retry : retries) {
+    removed += Remove(transaction, pairs[retry].first, pairs[retry].second) ? 1 : 0;
+  }
+  return removed;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+std::vector<size_t> HASH_TABLE_TYPE::SortByHome(const std::vector<MappingType> &pairs) {
+  std::vector<std::pair<uint64_t, size_t>> positions(pairs.size());
+  for (size_t i = 0; i < pairs.size(); i++) {
+    const uint64_t hash = hash_fn_.GetHash(pairs[i].first);
+    positions[i] = {GetBlockIndex(hash) * BLOCK_ARRAY_SIZE + GetBucketIndex(hash), i};
+  }
+  RadixSortPositions(&positions, GetNumActiveBlocks() * BLOCK_ARRAY_SIZE - 1);
+  std::vector<size_t> order(pairs.size());
+  for (size_t i = 0; i < positions.size(); i++) {
+    order[i] = positions[i].second;
+  }
+  return order;
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::BulkLoad(const std::vector<MappingType> &items) {
+  table_latch_.WLock();
+  if (growing_ || CountEntries() != 0) {
+    table_latch_.WUnlock();
+    return false;
+  }
+  // 1. add the blocks that keep the load below the growth threshold. The table is not growing, so any number of
+  // blocks is addressed by hash % num_blocks_.
+  const size_t per_block = BLOCK_ARRAY_SIZE * HASH_TABLE_MAX_LOAD_PERCENT / 100;
+  const size_t blocks_needed = std::max<size_t>(num_blocks_, (items.size() + per_block - 1) / per_block);
+  if (blocks_needed > HashTableHeaderPage::MaxBlocks()) {
+    table_latch_.WUnlock();
+    return false;
+  }
+  std::vector<page_id_t> new_page_ids;
+  std::vector<page_id_t> block_page_ids;
+  while (num_blocks_ + new_page_ids.size() < blocks_needed) {
+    if (buffer_pool_manager_->NewPages(blocks_needed - num_blocks_ - new_page_ids.size(), &block_page_ids).empty()) {
+      break;
+    }
+    new_page_ids.insert(new_page_ids.end(), block_page_ids.begin(), block_page_ids.end());
+    buffer_pool_manager_->UnpinPages(block_page_ids, true);
+  }
+  if (num_blocks_ + new_page_ids.size() < blocks_needed || !AddBlockPages(new_page_ids)) {
+    for (page_id_t page_id : new_page_ids) {
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+    table_latch_.WUnlock();
+    return false;
+  }
+  num_blocks_ = blocks_needed;
+  header_page_->SetSize(BLOCK_ARRAY_SIZE * num_blocks_);
+
+  // 2. place the pairs
+  const bool loaded = PlacePairs(items);
+  table_latch_.WUnlock();
+  return loaded;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::PlacePairs(const std::vector<MappingType> &items) {
+  // 1. sort the pairs by the position of their home bucket in the whole table
+  const uint64_t num_buckets = GetNumActiveBlocks() * BLOCK_ARRAY_SIZE;
+  std::vector<uint64_t> hashes(items.size());
+  std::vector<std::pair<uint64_t, size_t>> positions(items.size());
+  for (size_t i = 0; i < items.size(); i++) {
+    hashes[i] = hash_fn_.GetHash(items[i].first);
+    positions[i] = {GetBlockIndex(hashes[i]) * BLOCK_ARRAY_SIZE + GetBucketIndex(hashes[i]), i};
+  }
+  RadixSortPositions(&positions, num_buckets - 1);
+
+  // 2. place every pair in the first free bucket from its home on, which is past the pairs placed before it. The
+  // pairs that run past the end of the table wrap around to the free buckets at its start.
+  std::vector<uint64_t> slots;
+  std::vector<size_t> placed;
+  uint64_t next_free = 0;
+  for (size_t i = 0; i < positions.size(); i++) {
+    const auto &[home, item] = positions[i];
+    bool duplicate = false;
+    for (size_t j = i; j > 0 && positions[j - 1].first == home && !duplicate; j--) {
+      const MappingType &other = items[positions[j - 1].second];
+      duplicate = comparator_(other.first, items[item].first) == 0 &&
+                  (unique_keys_ || other.second == items[item].second);
+    }
+    if (!duplicate) {
+      next_free = std::max(next_free, home);
+      slots.push_back(next_free++);
+      placed.push_back(item);
+    }
+  }
+  if (placed.size() > num_buckets) {
+    return false;
+  }
+  // The wrapped pairs came last, they take the buckets at the start of the table that no pair before them took.
+  uint64_t wrap_free = 0;
+  size_t first_wrapped = slots.size();
+  while (first_wrapped > 0 && slots[first_wrapped - 1] >= num_buckets) {
+    first_wrapped--;
+  }
+  for (size_t i = first_wrapped, in_order = 0; i < slots.size(); i++) {
+    for (; in_order < first_wrapped && slots[in_order] <= wrap_free; in_order++) {
+      wrap_free = std::max(wrap_free, slots[in_order] + 1);
+    }
+    slots[i] = wrap_free++;
+  }
 
-  slot_offset_t bucket_ind = hash_res % BLOCK_ARRAY_SIZE;
-  while (bucket_ind < BLOCK_ARRAY_SIZE) {
-    if (block_page->IsReadable(bucket_ind) && block_page->ValueAt(bucket_ind) == value) {
-      block_page->Remove(bucket_ind);
-      return true;
+  // 3. write the pairs block by block
+  size_t written = 0;
+  while (written < placed.size()) {
+    const size_t block_index = slots[written] / BLOCK_ARRAY_SIZE;
+    WritePageGuard block_guard = buffer_pool_manager_->FetchPageWrite(GetBlockPageId(block_index));
+    if (!block_guard.IsValid()) {
+      break;
+    }
+    auto block_page = block_guard.AsMut<BlockPage>();
+    for (; written < placed.size() && slots[written] / BLOCK_ARRAY_SIZE == block_index; written++) {
+      const MappingType &pair = items[placed[written]];
+      if (filter_ != nullptr) {
+        filter_->Add(GetBlockIndex(hashes[placed[written]]), hashes[placed[written]]);
+      }
+      block_page->Insert(slots[written] % BLOCK_ARRAY_SIZE, pair.first, pair.second,
+                         GetFingerprint(hashes[placed[written]]));
     }
-    if (!block_page->IsOccupied(bucket_ind)) { break; }
-    bucket_ind++;
   }
-  return false;
+  entry_counts_[DistributedReaderWriterLatch::GetSlot()].count_.fetch_add(written, std::memory_order_relaxed);
+  return written == placed.size();
+}
+
+/*****************************************************************************
+ * STATISTICS AND COMPACTION
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::GetStats(HashTableStats *stats) {
+  table_latch_.RLock();
+  const size_t num_active = GetNumActiveBlocks();
+  *stats = HashTableStats();
+  stats->num_buckets_ = num_active * BLOCK_ARRAY_SIZE;
+  bool complete = true;
+  for (size_t block_index = 0; block_index < num_active; block_index++) {
+    ReadPageGuard block_guard = buffer_pool_manager_->FetchPageRead(GetBlockPageId(block_index));
+    if (!block_guard.IsValid()) {
+      complete = false;
+      break;
+    }
+    auto block_page = block_guard.As<BlockPage>();
+    for (slot_offset_t bucket_ind = 0; bucket_ind < BLOCK_ARRAY_SIZE; bucket_ind++) {
+      if (!block_page->IsReadable(bucket_ind)) {
+        stats->num_tombstones_ += block_page->IsOccupied(bucket_ind) ? 1 : 0;
+        continue;
+      }
+      stats->num_pairs_++;
+      uint64_t hash_res = hash_fn_.GetHash(block_page->KeyAt(bucket_ind));
+      const size_t home = GetBlockIndex(hash_res) * BLOCK_ARRAY_SIZE + GetBucketIndex(hash_res);
+      const size_t position = block_index * BLOCK_ARRAY_SIZE + bucket_ind;
+      // A pair that sits before its home wrapped around the end of the table.
+      const size_t distance = position >= home ? position - home : position + stats->num_buckets_ - home;
+      const size_t bin = 63 - __builtin_clzll(distance + 1);
+      if (stats->probe_lengths_.size() <= bin) {
+        stats->probe_lengths_.resize(bin + 1);
+      }
+      stats->probe_lengths_[bin]++;
+    }
+  }
+  table_latch_.RUnlock();
+  return complete;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::Compact() {
+  table_latch_.WLock();
+  const size_t num_active = GetNumActiveBlocks();
+  std::vector<MappingType> entries;
+  for (size_t block_index = 0; block_index < num_active; block_index++) {
+    WritePageGuard block_guard = buffer_pool_manager_->FetchPageWrite(GetBlockPageId(block_index));
+    if (!block_guard.IsValid()) {
+      // The blocks emptied so far lose their pairs unless they are put back.
+      PlacePairs(entries);
+      table_latch_.WUnlock();
+      return false;
+    }
+    auto block_page = block_guard.AsMut<BlockPage>();
+    for (slot_offset_t bucket_ind = 0; bucket_ind < BLOCK_ARRAY_SIZE; bucket_ind++) {
+      if (block_page->IsReadable(bucket_ind)) {
+        entries.emplace_back(block_page->KeyAt(bucket_ind), block_page->ValueAt(bucket_ind));
+      }
+    }
+    block_page->Clear();
+    if (filter_ != nullptr) {
+      filter_->Clear(block_index);
+    }
+  }
+  for (size_t slot = 0; slot < DISTRIBUTED_LATCH_SLOTS; slot++) {
+    entry_counts_[slot].count_.store(0, std::memory_order_relaxed);
+    tombstone_counts_[slot].count_.store(0, std::memory_order_relaxed);
+  }
+  const bool placed = PlacePairs(entries);
+  table_latch_.WUnlock();
+  return placed;
+}
+
+/*****************************************************************************
+ * FILTER
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::EnableFilter() {
+  table_latch_.WLock();
+  const size_t bits_per_block = BLOCK_ARRAY_SIZE * HASH_TABLE_FILTER_BITS_PER_SLOT;
+  filter_ = std::make_unique<HashBlockFilter>((bits_per_block + 511) / 512);
+  filter_->Resize(block_page_ids_.size());
+  const size_t num_active = GetNumActiveBlocks();
+  for (size_t block_index = 0; block_index < num_active; block_index++) {
+    ReadPageGuard block_guard = buffer_pool_manager_->FetchPageRead(GetBlockPageId(block_index));
+    if (!block_guard.IsValid()) {
+      filter_.reset();
+      table_latch_.WUnlock();
+      return false;
+    }
+    auto block_page = block_guard.As<BlockPage>();
+    for (slot_offset_t bucket_ind = 0; bucket_ind < BLOCK_ARRAY_SIZE; bucket_ind++) {
+      if (block_page->IsReadable(bucket_ind)) {
+        uint64_t hash_res = hash_fn_.GetHash(block_page->KeyAt(bucket_ind));
+        filter_->Add(GetBlockIndex(hash_res), hash_res);
+      }
+    }
+  }
+  table_latch_.WUnlock();
+  return true;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  table_latch_.WLock();
+  // Somebody else may have resized the table while we waited for the latch.
+  if (header_page_->GetSize() < 2 * initial_size) {
+    // A doubling that is still in progress is finished first, the addressing only knows one at a time.
+    while (growing_ && SplitBlock()) {
+    }
+    if (!growing_) {
+      StartGrowth();
+    }
+  }
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::Migrate() {
+  if (!growing_) {
+    return;
+  }
+  table_latch_.WLock();
+  for (int i = 0; growing_ && i < HASH_TABLE_SPLITS_PER_OP; i++) {
+    if (!SplitBlock()) {
+      break;
+    }
+  }
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::Grow() {
+  table_latch_.WLock();
+  // Every split adds a block to the probes.
+  const bool grown = growing_ ? SplitBlock() : StartGrowth();
+  table_latch_.WUnlock();
+  return grown;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::StartGrowth() {
+  if (2 * num_blocks_ > HashTableHeaderPage::MaxBlocks()) {
+    return false;
+  }
+  // The new blocks are added all at once, they join the probes as the doubling goes on.
+  std::vector<page_id_t> new_page_ids;
+  std::vector<page_id_t> block_page_ids;
+  while (new_page_ids.size() < num_blocks_) {
+    if (buffer_pool_manager_->NewPages(num_blocks_ - new_page_ids.size(), &block_page_ids).empty()) {
+      for (page_id_t page_id : new_page_ids) {
+        buffer_pool_manager_->DeletePage(page_id);
+      }
+      return false;
+    }
+    new_page_ids.insert(new_page_ids.end(), block_page_ids.begin(), block_page_ids.end());
+    buffer_pool_manager_->UnpinPages(block_page_ids, true);
+  }
+  if (!AddBlockPages(new_page_ids)) {
+    for (page_id_t page_id : new_page_ids) {
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+    return false;
+  }
+  header_page_->SetSize(BLOCK_ARRAY_SIZE * 2 * num_blocks_);
+  next_split_ = 0;
+  growing_ = true;
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::AddBlockPages(const std::vector<page_id_t> &page_ids) {
+  const size_t num_blocks = block_page_ids_.size();
+  const size_t num_directories = header_page_->NumDirectories();
+  const size_t directories_needed = (num_blocks + page_ids.size() + BLOCK_DIRECTORY_ARRAY_SIZE - 1) /
+                                    BLOCK_DIRECTORY_ARRAY_SIZE;
+  if (directories_needed > HashTableHeaderPage::MaxDirectories()) {
+    return false;
+  }
+  // The new directory pages are created up front, the header page only lists them once they are filled in.
+  std::vector<page_id_t> new_directory_ids;
+  std::vector<page_id_t> batch_ids;
+  auto delete_new_directories = [&]() {
+    for (page_id_t page_id : new_directory_ids) {
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+  };
+  while (num_directories + new_directory_ids.size() < directories_needed) {
+    if (buffer_pool_manager_->NewPages(directories_needed - num_directories - new_directory_ids.size(), &batch_ids)
+            .empty()) {
+      delete_new_directories();
+      return false;
+    }
+    new_directory_ids.insert(new_directory_ids.end(), batch_ids.begin(), batch_ids.end());
+    buffer_pool_manager_->UnpinPages(batch_ids, true);
+  }
+  for (size_t i = 0; i < page_ids.size();) {
+    const size_t directory_index = (num_blocks + i) / BLOCK_DIRECTORY_ARRAY_SIZE;
+    WritePageGuard directory_guard = buffer_pool_manager_->FetchPageWrite(
+        directory_index < num_directories ? header_page_->GetDirectoryPageId(directory_index)
+                                          : new_directory_ids[directory_index - num_directories]);
+    if (!directory_guard.IsValid()) {
+      // The entries written past the listed blocks of the last directory page are overwritten by the next attempt.
+      delete_new_directories();
+      return false;
+    }
+    auto directory_page = directory_guard.AsMut<HashTableBlockDirectoryPage>();
+    for (; i < page_ids.size() && (num_blocks + i) / BLOCK_DIRECTORY_ARRAY_SIZE == directory_index; i++) {
+      directory_page->SetBlockPageId((num_blocks + i) % BLOCK_DIRECTORY_ARRAY_SIZE, page_ids[i]);
+    }
+  }
+  for (page_id_t page_id : new_directory_ids) {
+    header_page_->AddDirectoryPageId(page_id);
+  }
+  header_page_->SetNumBlocks(num_blocks + page_ids.size());
+  block_page_ids_.insert(block_page_ids_.end(), page_ids.begin(), page_ids.end());
+  if (filter_ != nullptr) {
+    filter_->Resize(block_page_ids_.size());
+  }
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::SplitBlock() {
+  // Both runs are collected with the addressing from before the split. The run at the start of the table goes first,
+  // the run of the split block may reach into it.
+  std::vector<MappingType> entries;
+  if (!ExtractEntries(0, true, &entries) || !ExtractEntries(next_split_, false, &entries)) {
+    return false;
+  }
+  // All the pairs whose home was the split block were extracted, they add themselves back as they are reinserted.
+  if (filter_ != nullptr) {
+    filter_->Clear(next_split_);
+  }
+  if (++next_split_ == num_blocks_) {
+    num_blocks_ *= 2;
+    next_split_ = 0;
+    growing_ = false;
+  }
+  for (const MappingType &entry : entries) {
+    // There is room for all of them: they took no more before, and the new block adds some.
+    const ProbeResult result = TryInsert(entry.first, entry.second, true);
+    BUSTUB_ASSERT(result == ProbeResult::SUCCESS, "A pair of a split block could not be reinserted.");
+  }
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::ExtractEntries(size_t start_block, bool wrapped, std::vector<MappingType> *entries) {
+  const size_t num_active = GetNumActiveBlocks();
+  const size_t num_buckets = num_active * BLOCK_ARRAY_SIZE;
+  size_t block_index = start_block;
+  for (size_t probed = 0; probed < num_buckets; block_index = (block_index + 1) % num_active) {
+    WritePageGuard block_guard = buffer_pool_manager_->FetchPageWrite(GetBlockPageId(block_index));
+    if (!block_guard.IsValid()) {
+      return false;
+    }
+    auto block_page = block_guard.As<BlockPage>();
+    for (slot_offset_t bucket_ind = 0; bucket_ind < BLOCK_ARRAY_SIZE && probed < num_buckets;
+         bucket_ind++, probed++) {
+      // A run of the split block may have gaps within the block, past it the run ends at the first empty slot.
+      if (!block_page->IsOccupied(bucket_ind) && (wrapped || probed >= BLOCK_ARRAY_SIZE)) {
+        return true;
+      }
+      if (!block_page->IsReadable(bucket_ind)) {
+        continue;
+      }
+      uint64_t hash_res = hash_fn_.GetHash(block_page->KeyAt(bucket_ind));
+      const size_t home_block = GetBlockIndex(hash_res);
+      // A pair that sits before its home wrapped around the end of the table.
+      const bool move = wrapped ? home_block * BLOCK_ARRAY_SIZE + GetBucketIndex(hash_res) >
+                                      block_index * BLOCK_ARRAY_SIZE + bucket_ind
+                                : home_block == start_block;
+      if (move) {
+        entries->emplace_back(block_page->KeyAt(bucket_ind), block_page->ValueAt(bucket_ind));
+        block_guard.AsMut<BlockPage>()->Remove(bucket_ind);
+        tombstone_counts_[DistributedReaderWriterLatch::GetSlot()].count_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+  return true;
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::CountEntries() const {
+  int64_t num_entries = 0;
+  for (const SlotCount &entry_count : entry_counts_) {
+    num_entries += entry_count.count_.load(std::memory_order_relaxed);
+  }
+  return std::max<int64_t>(num_entries, 0);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::CountTombstones() const {
+  int64_t num_tombstones = 0;
+  for (const SlotCount &tombstone_count : tombstone_counts_) {
+    num_tombstones += tombstone_count.count_.load(std::memory_order_relaxed);
+  }
+  return std::max<int64_t>(num_tombstones, 0);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::HasTooManyTombstones(size_t num_buckets) const {
+  return CountTombstones() * 100 > num_buckets * HASH_TABLE_MAX_TOMBSTONE_PERCENT;
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 size_t HASH_TABLE_TYPE::GetSize() {
-  return 0;
+  table_latch_.RLock();
+  size_t size = header_page_->GetSize();
+  table_latch_.RUnlock();
+  return size;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
@@ -130,4 +959,6 @@ template class LinearProbeHashTable<GenericKey<16>, RID, GenericComparator<16>>;
 template class LinearProbeHashTable<GenericKey<32>, RID, GenericComparator<32>>;
 template class LinearProbeHashTable<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class LinearProbeHashTable<hash_t, TmpTuple, HashComparator>;
+
 }  // namespace bustub
@@ -0,0 +1,179 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregate_view.cpp
+//
+// Identification: src/execution/aggregate_view.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/aggregate_view.h"
+
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the types of the aggregations with the hidden count of rows in front */
+std::vector<AggregationType> WithRowCount(std::vector<AggregationType> agg_types) {
+  agg_types.insert(agg_types.begin(), AggregationType::CountAggregate);
+  return agg_types;
+}
+
+std::vector<TypeId> InputTypesOf(const std::vector<const AbstractExpression *> &aggregates) {
+  std::vector<TypeId> input_types{TypeId::INTEGER};
+  for (const AbstractExpression *expr : aggregates) {
+    input_types.push_back(expr->GetReturnType());
+  }
+  return input_types;
+}
+
+std::vector<TypeId> KeyTypesOf(const std::vector<const AbstractExpression *> &group_bys) {
+  std::vector<TypeId> key_types;
+  for (const AbstractExpression *expr : group_bys) {
+    key_types.push_back(expr->GetReturnType());
+  }
+  return key_types;
+}
+
+}  // namespace
+
+AggregateView::AggregateView(TableHeap *table, const Schema *schema, std::vector<const AbstractExpression *> group_bys,
+                             std::vector<const AbstractExpression *> aggregates, std::vector<AggregationType> agg_types)
+    : table_(table),
+      schema_(schema),
+      group_bys_(std::move(group_bys)),
+      aggregates_(std::move(aggregates)),
+      agg_types_(WithRowCount(std::move(agg_types))),
+      input_types_(InputTypesOf(aggregates_)),
+      key_types_(KeyTypesOf(group_bys_)),
+      groups_(agg_types_, input_types_, key_types_) {
+  BUSTUB_ASSERT(AggregationTable::CanAggregate(agg_types_, input_types_), "The view keeps its aggregates unboxed.");
+}
+
+AggregateView::~AggregateView() {
+  if (built_) {
+    table_->RemoveCommitListener(listener_id_);
+  }
+}
+
+bool AggregateView::Build(Transaction *txn) {
+  if (!Locks(txn) || !table_->LockTable(txn, LockMode::SHARED)) {
+    return false;
+  }
+  {
+    std::scoped_lock lock(latch_);
+    if (built_) {
+      return true;
+    }
+    Aggregate(txn);
+  }
+  // No transaction that writes the table commits while the lock is held, so the view misses none of their commits.
+  // The listener is added without the latch, which the committing transactions take under the latch of the listeners.
+  const size_t listener_id = table_->AddCommitListener([this](const TableChange &change) { Apply(change); });
+  std::scoped_lock lock(latch_);
+  listener_id_ = listener_id;
+  built_ = true;
+  return true;
+}
+
+bool AggregateView::ReadGroups(Transaction *txn, std::vector<Group> *groups) {
+  if (!Locks(txn)) {
+    return false;
+  }
+  for (const auto &item : *txn->GetWriteSet()) {
+    if (item.table_ == table_) {
+      return false;
+    }
+  }
+  // The lock is taken before the latch, which the committing transactions take while they hold their locks.
+  if (!table_->LockTable(txn, LockMode::SHARED)) {
+    return false;
+  }
+  std::scoped_lock lock(latch_);
+  if (!built_) {
+    return false;
+  }
+  if (stale_) {
+    Aggregate(txn);
+  }
+  groups->clear();
+  for (size_t group = 0; group < groups_.GetNumGroups(); group++) {
+    std::vector<Value> aggregates = groups_.GetAggregates(group);
+    if (aggregates[0].GetAs<int32_t>() == 0) {
+      continue;
+    }
+    aggregates.erase(aggregates.begin());
+    groups->emplace_back(groups_.GetKeys(group), std::move(aggregates));
+  }
+  return true;
+}
+
+void AggregateView::Aggregate(Transaction *txn) {
+  groups_ = AggregationTable(agg_types_, input_types_, key_types_);
+  std::vector<Tuple> tuples;
+  for (auto it = table_->Begin(txn); it != table_->End(); ++it) {
+    tuples.push_back(*it);
+    if (tuples.size() == static_cast<size_t>(EXECUTOR_BATCH_SIZE)) {
+      Combine(tuples, false);
+      tuples.clear();
+    }
+  }
+  Combine(tuples, false);
+  stale_ = false;
+}
+
+bool AggregateView::Combine(const std::vector<Tuple> &tuples, bool remove) {
+  std::vector<std::vector<Value>> key_columns(group_bys_.size());
+  std::vector<std::vector<Value>> agg_columns(agg_types_.size());
+  agg_columns[0].assign(tuples.size(), ValueFactory::GetIntegerValue(1));
+  for (const Tuple &tuple : tuples) {
+    for (size_t i = 0; i < group_bys_.size(); i++) {
+      key_columns[i].push_back(group_bys_[i]->Evaluate(&tuple, schema_));
+    }
+    for (size_t i = 0; i < aggregates_.size(); i++) {
+      agg_columns[i + 1].push_back(aggregates_[i]->Evaluate(&tuple, schema_));
+    }
+  }
+  std::vector<hash_t> hashes;
+  groups_.HashKeys(key_columns, tuples.size(), &hashes);
+  for (size_t row = 0; row < tuples.size(); row++) {
+    if (!remove) {
+      groups_.InsertCombine(hashes[row], key_columns, agg_columns, row);
+    } else if (!groups_.RemoveCombine(hashes[row], key_columns, agg_columns, row)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AggregateView::Apply(const TableChange &change) {
+  std::scoped_lock lock(latch_);
+  if (stale_) {
+    return;
+  }
+  if (change.incomplete_) {
+    stale_ = true;
+    return;
+  }
+  if (change.truncated_) {
+    groups_ = AggregationTable(agg_types_, input_types_, key_types_);
+  }
+  // The tuples that an update replaced go first, their new versions may land in the same groups. A sum that overflows
+  // fails the read rather than the commit.
+  try {
+    stale_ = !Combine(change.removed_, true) || !Combine(change.added_, false);
+  } catch (const Exception &e) {
+    stale_ = true;
+  }
+}
+
+}  // namespace bustub
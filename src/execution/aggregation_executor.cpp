@@ -1,31 +1,288 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// aggregation_executor.cpp
-//
-// Identification: src/execution/aggregation_executor.cpp
-//
-// Copyright (c) 2015-19, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include <memory>
-#include <vector>
-
-#include "execution/executors/aggregation_executor.h"
-
-namespace bustub {
-
-AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
-                                         std::unique_ptr<AbstractExecutor> &&child)
-    : AbstractExecutor(exec_ctx) {}
-
-const AbstractExecutor *AggregationExecutor::GetChildExecutor() const { return child_.get(); }
-
-const Schema *AggregationExecutor::GetOutputSchema() { return plan_->OutputSchema(); }
-
-void AggregationExecutor::Init() {}
-
-bool AggregationExecutor::Next(Tuple *tuple) { return false; }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_executor.cpp
+//
+// Identification: src/execution/aggregation_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executors/aggregation_executor.h"
+
+namespace bustub {
+
+AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
+                                         std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      child_(std::move(child)),
+      aht_(plan->GetAggregates(), plan->GetAggregateTypes()),
+      aht_iterator_(aht_.Begin()),
+      memory_(exec_ctx->GetMemoryTracker()) {}
+
+const AbstractExecutor *AggregationExecutor::GetChildExecutor() const { return child_.get(); }
+
+const Schema *AggregationExecutor::GetOutputSchema() { return plan_->OutputSchema(); }
+
+void AggregationExecutor::Init() {
+  spilled_ = false;
+  spill_runs_.clear();
+  pending_.clear();
+  current_ = SpilledPartition();
+  ResetNextFromBatch();
+  view_groups_.clear();
+  view_index_ = 0;
+  AggregateView *view = plan_->GetView();
+  from_view_ = view != nullptr && view->ReadGroups(exec_ctx_->GetTransaction(), &view_groups_);
+  if (from_view_) {
+    aht_.Clear();
+    partitions_.clear();
+    memory_.Release();
+    return;
+  }
+  child_->Init();
+  input_types_.clear();
+  for (const AbstractExpression *expr : plan_->GetAggregates()) {
+    input_types_.push_back(expr->GetReturnType());
+  }
+  unboxed_ = AggregationTable::CanAggregate(plan_->GetAggregateTypes(), input_types_);
+  Aggregate(0);
+}
+
+void AggregationExecutor::Aggregate(int depth) {
+  aht_.Clear();
+  partitions_.clear();
+  memory_.Release();
+  partition_index_ = 0;
+  group_index_ = 0;
+  if (unboxed_) {
+    AggregateUnboxed(depth);
+  } else {
+    AggregateBoxed(depth);
+    aht_.Finish();
+    aht_iterator_ = aht_.Begin();
+  }
+  if (!spill_runs_.empty()) {
+    FinishSpilling(depth);
+  }
+  // The groups are held until they are produced.
+  memory_.Resize(GetMemoryUsage());
+}
+
+void AggregationExecutor::AggregateBoxed(int depth) {
+  TupleBatch batch;
+  std::vector<uint32_t> new_rows;
+  while (NextInput(&batch)) {
+    if (spill_runs_.empty()) {
+      aht_.InsertCombineBatch(batch, plan_->GetGroupBys());
+      if (depth < HASH_JOIN_MAX_DEPTH && IsOverBudget(aht_.GetMemoryUsage())) {
+        StartSpilling();
+      }
+      continue;
+    }
+    new_rows.clear();
+    aht_.InsertCombineBatch(batch, plan_->GetGroupBys(), &new_rows);
+    for (uint32_t i : new_rows) {
+      const Tuple tuple = batch.GetTuple(batch.GetSelection()[i]);
+      const hash_t hash = std::hash<AggregateKey>{}(MakeKey(&tuple));
+      spill_runs_[HashUtil::Partition(hash, depth, HASH_JOIN_PARTITIONS)]->Append(tuple);
+    }
+  }
+}
+
+void AggregationExecutor::AggregateUnboxed(int depth) {
+  const auto &group_bys = plan_->GetGroupBys();
+  const auto &aggregates = plan_->GetAggregates();
+  const size_t num_workers = exec_ctx_->GetParallelism();
+  std::vector<TypeId> key_types;
+  for (const AbstractExpression *expr : group_bys) {
+    key_types.push_back(expr->GetReturnType());
+  }
+  const AggregationTable empty_table(plan_->GetAggregateTypes(), input_types_, key_types);
+  partitions_.assign(num_workers, empty_table);
+  // tables[worker][partition]
+  std::vector<std::vector<AggregationTable>> tables(num_workers, partitions_);
+  // Each partition is merged into partitions_ by the worker of the same number.
+  auto merge = [&]() {
+    exec_ctx_->RunWorkers([&](size_t worker) {
+      if (partitions_[worker].GetNumGroups() == 0) {
+        std::swap(partitions_[worker], tables[0][worker]);
+      }
+      for (auto &worker_tables : tables) {
+        partitions_[worker].Merge(worker_tables[worker]);
+        worker_tables[worker] = empty_table;
+      }
+    });
+  };
+  bool input_done = false;
+  while (!input_done) {
+    std::vector<TupleBatch> batches(num_workers * AGGREGATION_ROUND_BATCHES);
+    size_t num_batches = 0;
+    while (num_batches < batches.size() && !input_done) {
+      if (NextInput(&batches[num_batches])) {
+        num_batches++;
+      } else {
+        input_done = true;
+      }
+    }
+    // Once spilling, partitions_ holds the groups that stay in memory, and is only read until the next merge. The rows
+    // of other groups are set aside by partition, spilled[worker][partition], and appended to the runs afterwards.
+    const bool spilling = !spill_runs_.empty();
+    std::vector<std::vector<std::vector<Tuple>>> spilled(
+        spilling ? num_workers : 0, std::vector<std::vector<Tuple>>(HASH_JOIN_PARTITIONS));
+    std::atomic<size_t> next_batch{0};
+    exec_ctx_->RunWorkers([&](size_t worker) {
+      std::vector<std::vector<Value>> key_columns(group_bys.size());
+      std::vector<std::vector<Value>> agg_columns(aggregates.size());
+      std::vector<hash_t> hashes;
+      for (size_t b = next_batch++; b < num_batches; b = next_batch++) {
+        for (size_t i = 0; i < group_bys.size(); i++) {
+          group_bys[i]->EvaluateBatch(batches[b], &key_columns[i]);
+        }
+        for (size_t i = 0; i < aggregates.size(); i++) {
+          aggregates[i]->EvaluateBatch(batches[b], &agg_columns[i]);
+        }
+        empty_table.HashKeys(key_columns, batches[b].GetSize(), &hashes);
+        for (size_t row = 0; row < batches[b].GetSize(); row++) {
+          const hash_t hash = hashes[row];
+          const size_t partition = WorkerPartitionOf(hash, num_workers);
+          if (spilling && !partitions_[partition].Contains(hash, key_columns, row)) {
+            spilled[worker][HashUtil::Partition(hash, depth, HASH_JOIN_PARTITIONS)].push_back(
+                batches[b].GetTuple(batches[b].GetSelection()[row]));
+            continue;
+          }
+          tables[worker][partition].InsertCombine(hash, key_columns, agg_columns, row);
+        }
+      }
+    });
+    for (const auto &worker_spilled : spilled) {
+      for (size_t i = 0; i < worker_spilled.size(); i++) {
+        for (const Tuple &tuple : worker_spilled[i]) {
+          spill_runs_[i]->Append(tuple);
+        }
+      }
+    }
+    if (spilling || depth >= HASH_JOIN_MAX_DEPTH) {
+      continue;
+    }
+    size_t memory_usage = 0;
+    for (const auto &worker_tables : tables) {
+      for (const auto &table : worker_tables) {
+        memory_usage += table.GetMemoryUsage();
+      }
+    }
+    if (IsOverBudget(memory_usage)) {
+      merge();
+      StartSpilling();
+    }
+  }
+  merge();
+}
+
+void AggregationExecutor::StartSpilling() {
+  spilled_ = true;
+  spill_runs_.resize(HASH_JOIN_PARTITIONS);
+  for (auto &run : spill_runs_) {
+    run = std::make_unique<TmpTupleRun>(exec_ctx_->GetSpillFileManager());
+  }
+}
+
+void AggregationExecutor::FinishSpilling(int depth) {
+  for (auto &run : spill_runs_) {
+    run->Finish();
+    // The partitions of a split go first, so that the runs that are on disk at any time stay few.
+    if (run->GetNumTuples() > 0) {
+      pending_.push_front(SpilledPartition{std::move(run), depth});
+    }
+  }
+  spill_runs_.clear();
+}
+
+bool AggregationExecutor::NextInput(TupleBatch *batch) {
+  if (current_.run_ == nullptr) {
+    return child_->NextBatch(batch);
+  }
+  batch->Reset(child_->GetOutputSchema());
+  Tuple tuple;
+  while (!batch->IsFull() && current_.run_->Read(&current_cursor_, &tuple)) {
+    batch->AppendTuple(tuple);
+  }
+  return !batch->IsEmpty();
+}
+
+void AggregationExecutor::Stop() {
+  child_->Stop();
+  pending_.clear();
+  current_ = SpilledPartition();
+  spill_runs_.clear();
+  partitions_.clear();
+  memory_.Release();
+  ResetNextFromBatch();
+}
+
+bool AggregationExecutor::NextPartition() {
+  if (pending_.empty()) {
+    return false;
+  }
+  current_ = std::move(pending_.front());
+  pending_.pop_front();
+  current_cursor_ = TmpTupleRun::Cursor();
+  Aggregate(current_.depth_ + 1);
+  // The groups of the partition are in memory now, its run can go.
+  current_ = SpilledPartition();
+  return true;
+}
+
+void AggregationExecutor::AppendGroup(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates,
+                                      TupleBatch *batch) {
+  const AbstractExpression *having = plan_->GetHaving();
+  if (having != nullptr && !having->EvaluateAggregate(group_bys, aggregates).GetAs<bool>()) {
+    return;
+  }
+  const Schema *output_schema = GetOutputSchema();
+  std::vector<Value> values;
+  values.reserve(output_schema->GetColumnCount());
+  for (const auto &column : output_schema->GetColumns()) {
+    values.emplace_back(column.GetExpr()->EvaluateAggregate(group_bys, aggregates));
+  }
+  batch->AppendRow(std::move(values));
+}
+
+bool AggregationExecutor::NextBatch(TupleBatch *batch) {
+  batch->Reset(GetOutputSchema());
+  if (from_view_) {
+    for (; view_index_ < view_groups_.size() && !batch->IsFull(); view_index_++) {
+      AppendGroup(view_groups_[view_index_].first, view_groups_[view_index_].second, batch);
+    }
+    return !batch->IsEmpty();
+  }
+  do {
+    if (unboxed_) {
+      while (partition_index_ < partitions_.size() && !batch->IsFull()) {
+        const AggregationTable &table = partitions_[partition_index_];
+        if (group_index_ >= table.GetNumGroups()) {
+          partition_index_++;
+          group_index_ = 0;
+          continue;
+        }
+        AppendGroup(table.GetKeys(group_index_), table.GetAggregates(group_index_), batch);
+        group_index_++;
+      }
+    } else {
+      for (; aht_iterator_ != aht_.End() && !batch->IsFull(); ++aht_iterator_) {
+        AppendGroup(aht_iterator_.Key().group_bys_, aht_iterator_.Val().aggregates_, batch);
+      }
+    }
+    // The groups in memory are done with, the next spilled partition takes their place.
+  } while (batch->IsEmpty() && NextPartition());
+  return !batch->IsEmpty();
+}
+
+}  // namespace bustub
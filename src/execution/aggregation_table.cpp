@@ -0,0 +1,332 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_table.cpp
+//
+// Identification: src/execution/aggregation_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/aggregation_table.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "common/exception.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return a number as an int64_t, the value being of an integer type */
+int64_t IntOf(const Value &value) {
+  switch (value.GetTypeId()) {
+    case TypeId::TINYINT:
+      return value.GetAs<int8_t>();
+    case TypeId::SMALLINT:
+      return value.GetAs<int16_t>();
+    case TypeId::INTEGER:
+      return value.GetAs<int32_t>();
+    default:
+      return value.GetAs<int64_t>();
+  }
+}
+
+/** @return a number as a double, the value being of a numeric type */
+double RealOf(const Value &value) {
+  return value.GetTypeId() == TypeId::DECIMAL ? value.GetAs<double>() : static_cast<double>(IntOf(value));
+}
+
+/** @return an integer as an INTEGER value, or a BIGINT one for BIGINT input */
+Value BoxInt(int64_t value, bool big) {
+  if (big) {
+    return ValueFactory::GetBigIntValue(value);
+  }
+  if (value < BUSTUB_INT32_MIN || value > BUSTUB_INT32_MAX) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "Numeric value out of range.");
+  }
+  return ValueFactory::GetIntegerValue(static_cast<int32_t>(value));
+}
+
+}  // namespace
+
+AggregationTable::AggregationTable(const std::vector<AggregationType> &agg_types,
+                                   const std::vector<TypeId> &input_types, const std::vector<TypeId> &key_types)
+    : agg_types_(agg_types), input_types_(input_types), num_keys_(key_types.size()), buckets_(16, -1) {
+  for (TypeId type : key_types) {
+    key_kernels_.push_back(&TypeKernels::Get(type));
+  }
+}
+
+bool AggregationTable::CanAggregate(const std::vector<AggregationType> &agg_types,
+                                    const std::vector<TypeId> &input_types) {
+  for (size_t i = 0; i < agg_types.size(); i++) {
+    if (agg_types[i] == AggregationType::CountDistinctAggregate ||
+        agg_types[i] == AggregationType::ApproxCountDistinctAggregate) {
+      return false;
+    }
+    if (agg_types[i] == AggregationType::CountAggregate) {
+      continue;
+    }
+    switch (input_types[i]) {
+      case TypeId::TINYINT:
+      case TypeId::SMALLINT:
+      case TypeId::INTEGER:
+      case TypeId::BIGINT:
+      case TypeId::DECIMAL:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+void AggregationTable::HashKeys(const std::vector<std::vector<Value>> &key_columns, size_t num_rows,
+                                std::vector<hash_t> *hashes) const {
+  hashes->assign(num_rows, 0);
+  for (size_t i = 0; i < num_keys_; i++) {
+    key_kernels_[i]->hash_combine_(key_columns[i], false, hashes->data());
+  }
+}
+
+size_t AggregationTable::AddGroup(hash_t hash, size_t bucket) {
+  const size_t group = hashes_.size();
+  buckets_[bucket] = static_cast<int64_t>(group);
+  hashes_.push_back(hash);
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    AggregateSlot slot;
+    slot.error_ = 0;
+    switch (agg_types_[i]) {
+      case AggregationType::CountAggregate:
+        slot.int_ = 0;
+        break;
+      case AggregationType::SumAggregate:
+        if (IsReal(i)) {
+          slot.real_ = 0;
+        } else {
+          slot.int_ = 0;
+        }
+        break;
+      case AggregationType::MinAggregate:
+        if (IsReal(i)) {
+          slot.real_ = std::numeric_limits<double>::max();
+        } else {
+          slot.int_ = std::numeric_limits<int64_t>::max();
+        }
+        break;
+      case AggregationType::MaxAggregate:
+        if (IsReal(i)) {
+          slot.real_ = std::numeric_limits<double>::lowest();
+        } else {
+          slot.int_ = std::numeric_limits<int64_t>::min();
+        }
+        break;
+      case AggregationType::CountDistinctAggregate:
+      case AggregationType::ApproxCountDistinctAggregate:
+        UNREACHABLE("Distinct counts are not aggregated in an AggregationTable.");
+    }
+    slots_.push_back(slot);
+  }
+  return group;
+}
+
+void AggregationTable::Grow() {
+  buckets_.assign(buckets_.size() * 2, -1);
+  const size_t mask = buckets_.size() - 1;
+  for (size_t group = 0; group < hashes_.size(); group++) {
+    size_t b = hashes_[group] & mask;
+    while (buckets_[b] >= 0) {
+      b = (b + 1) & mask;
+    }
+    buckets_[b] = static_cast<int64_t>(group);
+  }
+}
+
+void AggregationTable::InsertCombine(hash_t hash, const std::vector<std::vector<Value>> &key_columns,
+                                     const std::vector<std::vector<Value>> &agg_columns, size_t row) {
+  size_t bucket;
+  int64_t group = Find(hash, [&](size_t i) -> const Value & { return key_columns[i][row]; }, &bucket);
+  if (group < 0) {
+    group = static_cast<int64_t>(AddGroup(hash, bucket));
+    for (const auto &column : key_columns) {
+      keys_.push_back(column[row]);
+    }
+    if (hashes_.size() * 2 > buckets_.size()) {
+      Grow();
+    }
+  }
+  AggregateSlot *slots = slots_.data() + group * agg_types_.size();
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    const Value &value = agg_columns[i][row];
+    if (agg_types_[i] == AggregationType::CountAggregate) {
+      // Count increases by one for every row, like SimpleAggregationHashTable's.
+      slots[i].int_++;
+      continue;
+    }
+    if (value.IsNull()) {
+      continue;
+    }
+    if (IsReal(i)) {
+      const double real = RealOf(value);
+      switch (agg_types_[i]) {
+        case AggregationType::SumAggregate:
+          AddReal(&slots[i], real);
+          break;
+        case AggregationType::MinAggregate:
+          slots[i].real_ = std::min(slots[i].real_, real);
+          break;
+        default:
+          slots[i].real_ = std::max(slots[i].real_, real);
+          break;
+      }
+    } else {
+      const int64_t integer = IntOf(value);
+      switch (agg_types_[i]) {
+        case AggregationType::SumAggregate:
+          AddInt(&slots[i], integer);
+          break;
+        case AggregationType::MinAggregate:
+          slots[i].int_ = std::min(slots[i].int_, integer);
+          break;
+        default:
+          slots[i].int_ = std::max(slots[i].int_, integer);
+          break;
+      }
+    }
+  }
+}
+
+bool AggregationTable::RemoveCombine(hash_t hash, const std::vector<std::vector<Value>> &key_columns,
+                                     const std::vector<std::vector<Value>> &agg_columns, size_t row) {
+  size_t bucket;
+  const int64_t group = Find(hash, [&](size_t i) -> const Value & { return key_columns[i][row]; }, &bucket);
+  if (group < 0) {
+    return false;
+  }
+  AggregateSlot *slots = slots_.data() + group * agg_types_.size();
+  // Nothing changes unless the row can be taken out of every aggregate.
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    const Value &value = agg_columns[i][row];
+    if ((agg_types_[i] != AggregationType::MinAggregate && agg_types_[i] != AggregationType::MaxAggregate) ||
+        value.IsNull()) {
+      continue;
+    }
+    if (IsReal(i) ? RealOf(value) == slots[i].real_ : IntOf(value) == slots[i].int_) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    const Value &value = agg_columns[i][row];
+    if (agg_types_[i] == AggregationType::CountAggregate) {
+      slots[i].int_--;
+    } else if (agg_types_[i] == AggregationType::SumAggregate && !value.IsNull()) {
+      if (IsReal(i)) {
+        AddReal(&slots[i], -RealOf(value));
+      } else {
+        SubtractInt(&slots[i], IntOf(value));
+      }
+    }
+  }
+  return true;
+}
+
+void AggregationTable::Merge(const AggregationTable &other) {
+  const size_t num_aggs = agg_types_.size();
+  for (size_t other_group = 0; other_group < other.GetNumGroups(); other_group++) {
+    const Value *other_keys = other.keys_.data() + other_group * num_keys_;
+    const hash_t hash = other.hashes_[other_group];
+    size_t bucket;
+    int64_t group = Find(hash, [other_keys](size_t i) -> const Value & { return other_keys[i]; }, &bucket);
+    if (group < 0) {
+      group = static_cast<int64_t>(AddGroup(hash, bucket));
+      keys_.insert(keys_.end(), other_keys, other_keys + num_keys_);
+      std::copy_n(other.slots_.data() + other_group * num_aggs, num_aggs, slots_.data() + group * num_aggs);
+      if (hashes_.size() * 2 > buckets_.size()) {
+        Grow();
+      }
+      continue;
+    }
+    AggregateSlot *slots = slots_.data() + group * num_aggs;
+    const AggregateSlot *other_slots = other.slots_.data() + other_group * num_aggs;
+    for (size_t i = 0; i < num_aggs; i++) {
+      const bool real = agg_types_[i] != AggregationType::CountAggregate && IsReal(i);
+      switch (agg_types_[i]) {
+        case AggregationType::CountAggregate:
+          slots[i].int_ += other_slots[i].int_;
+          break;
+        case AggregationType::SumAggregate:
+          if (real) {
+            AddReal(&slots[i], other_slots[i].real_);
+            slots[i].error_ += other_slots[i].error_;
+          } else {
+            AddInt(&slots[i], other_slots[i].int_);
+          }
+          break;
+        case AggregationType::MinAggregate:
+          if (real) {
+            slots[i].real_ = std::min(slots[i].real_, other_slots[i].real_);
+          } else {
+            slots[i].int_ = std::min(slots[i].int_, other_slots[i].int_);
+          }
+          break;
+        case AggregationType::MaxAggregate:
+          if (real) {
+            slots[i].real_ = std::max(slots[i].real_, other_slots[i].real_);
+          } else {
+            slots[i].int_ = std::max(slots[i].int_, other_slots[i].int_);
+          }
+          break;
+        case AggregationType::CountDistinctAggregate:
+        case AggregationType::ApproxCountDistinctAggregate:
+          UNREACHABLE("Distinct counts are not aggregated in an AggregationTable.");
+      }
+    }
+  }
+}
+
+std::vector<Value> AggregationTable::GetKeys(size_t group) const {
+  return std::vector<Value>(keys_.begin() + group * num_keys_, keys_.begin() + (group + 1) * num_keys_);
+}
+
+std::vector<Value> AggregationTable::GetAggregates(size_t group) const {
+  std::vector<Value> aggregates;
+  aggregates.reserve(agg_types_.size());
+  const AggregateSlot *slots = slots_.data() + group * agg_types_.size();
+  for (size_t i = 0; i < agg_types_.size(); i++) {
+    // A group whose values are all null has no min or max, its slot is still at its start.
+    bool is_null = false;
+    if (agg_types_[i] == AggregationType::MinAggregate) {
+      is_null = IsReal(i) ? slots[i].real_ == std::numeric_limits<double>::max()
+                          : slots[i].int_ == std::numeric_limits<int64_t>::max();
+    } else if (agg_types_[i] == AggregationType::MaxAggregate) {
+      is_null = IsReal(i) ? slots[i].real_ == std::numeric_limits<double>::lowest()
+                          : slots[i].int_ == std::numeric_limits<int64_t>::min();
+    }
+    if (agg_types_[i] == AggregationType::CountAggregate) {
+      aggregates.push_back(BoxInt(slots[i].int_, false));
+    } else if (is_null) {
+      const TypeId type = IsReal(i) || input_types_[i] == TypeId::BIGINT ? input_types_[i] : TypeId::INTEGER;
+      aggregates.push_back(ValueFactory::GetNullValueByType(type));
+    } else if (IsReal(i) && agg_types_[i] == AggregationType::SumAggregate) {
+      const double sum = slots[i].real_ + slots[i].error_;
+      if (!std::isfinite(sum)) {
+        throw Exception(ExceptionType::OUT_OF_RANGE, "Numeric value out of range.");
+      }
+      aggregates.push_back(ValueFactory::GetDecimalValue(sum));
+    } else if (IsReal(i)) {
+      aggregates.push_back(ValueFactory::GetDecimalValue(slots[i].real_));
+    } else {
+      aggregates.push_back(BoxInt(slots[i].int_, input_types_[i] == TypeId::BIGINT));
+    }
+  }
+  return aggregates;
+}
+
+}  // namespace bustub
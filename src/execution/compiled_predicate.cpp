@@ -0,0 +1,231 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_predicate.cpp
+//
+// Identification: src/execution/compiled_predicate.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/compiled_predicate.h"
+
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "type/limits.h"
+
+namespace bustub {
+
+namespace {
+
+using Operands = CompiledPredicate::Operands;
+
+/** @return the column of a C++ type at an offset of a tuple */
+template <class T>
+T Load(const char *data, uint32_t offset) {
+  T value;
+  memcpy(&value, data + offset, sizeof(T));
+  return value;
+}
+
+/** @return the value that stands for null in a column of a C++ type */
+template <class T>
+constexpr T NullOf() {
+  if constexpr (std::is_same_v<T, int8_t>) {
+    return BUSTUB_INT8_NULL;
+  } else if constexpr (std::is_same_v<T, int16_t>) {
+    return BUSTUB_INT16_NULL;
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return BUSTUB_INT32_NULL;
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    return BUSTUB_INT64_NULL;
+  } else {
+    return BUSTUB_DECIMAL_NULL;
+  }
+}
+
+/** @return the constant of a comparison in a C++ type, int64_t or double */
+template <class Common>
+Common ConstantOf(const Operands &operands) {
+  if constexpr (std::is_same_v<Common, double>) {
+    return operands.real_;
+  } else {
+    return operands.int_;
+  }
+}
+
+/** The comparison of the left column with the constant. */
+template <class Left, class Common, class Cmp>
+bool TestColumnConstant(const Operands &operands, const char *data) {
+  const Left left = Load<Left>(data, operands.left_offset_);
+  return left != NullOf<Left>() && Cmp()(static_cast<Common>(left), ConstantOf<Common>(operands));
+}
+
+/** The comparison of the left column with the right one. */
+template <class Left, class Right, class Common, class Cmp>
+bool TestColumns(const Operands &operands, const char *data) {
+  const Left left = Load<Left>(data, operands.left_offset_);
+  const Right right = Load<Right>(data, operands.right_offset_);
+  if (left == NullOf<Left>() || right == NullOf<Right>()) {
+    return false;
+  }
+  return Cmp()(static_cast<Common>(left), static_cast<Common>(right));
+}
+
+bool TestTrue(const Operands & /*operands*/, const char * /*data*/) { return true; }
+
+bool TestFalse(const Operands & /*operands*/, const char * /*data*/) { return false; }
+
+/**
+ * Calls fn with a value of the C++ type of a numeric type.
+ * @return false if the type is not numeric, fn was not called then
+ */
+template <class Fn>
+bool WithType(TypeId type, Fn &&fn) {
+  switch (type) {
+    case TypeId::TINYINT:
+      fn(int8_t{});
+      return true;
+    case TypeId::SMALLINT:
+      fn(int16_t{});
+      return true;
+    case TypeId::INTEGER:
+      fn(int32_t{});
+      return true;
+    case TypeId::BIGINT:
+      fn(int64_t{});
+      return true;
+    case TypeId::DECIMAL:
+      fn(double{});
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** Calls fn with the function object of a comparison of values of a C++ type. */
+template <class Common, class Fn>
+void WithComparison(ComparisonType type, Fn &&fn) {
+  switch (type) {
+    case ComparisonType::Equal:
+      fn(std::equal_to<Common>());
+      break;
+    case ComparisonType::NotEqual:
+      fn(std::not_equal_to<Common>());
+      break;
+    case ComparisonType::LessThan:
+      fn(std::less<Common>());
+      break;
+    case ComparisonType::LessThanOrEqual:
+      fn(std::less_equal<Common>());
+      break;
+    case ComparisonType::GreaterThan:
+      fn(std::greater<Common>());
+      break;
+    case ComparisonType::GreaterThanOrEqual:
+      fn(std::greater_equal<Common>());
+      break;
+  }
+}
+
+/** @return the comparison that holds for (b, a) when the given one holds for (a, b) */
+ComparisonType Flip(ComparisonType type) {
+  switch (type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return type;
+  }
+}
+
+/** The type in which two numbers compare, a double if either is one, else a 64-bit integer. */
+template <class Left, class Right>
+using CommonType =
+    std::conditional_t<std::is_floating_point_v<Left> || std::is_floating_point_v<Right>, double, int64_t>;
+
+}  // namespace
+
+std::unique_ptr<CompiledPredicate> CompiledPredicate::Compile(const AbstractExpression *predicate,
+                                                              const Schema *schema) {
+  auto comparison = dynamic_cast<const ComparisonExpression *>(predicate);
+  if (comparison == nullptr) {
+    return nullptr;
+  }
+  ComparisonType comp_type = comparison->GetComparisonType();
+  auto left_column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  auto right_column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+  auto left_constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+  auto right_constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  // A constant on the left is compared the other way around.
+  if (left_constant != nullptr && right_column != nullptr) {
+    std::swap(left_column, right_column);
+    std::swap(left_constant, right_constant);
+    comp_type = Flip(comp_type);
+  }
+  if ((left_column != nullptr && left_column->GetTupleIdx() != 0) ||
+      (right_column != nullptr && right_column->GetTupleIdx() != 0)) {
+    return nullptr;
+  }
+
+  TestFn test = nullptr;
+  Operands operands;
+  if (left_column != nullptr && right_column != nullptr) {
+    const Column &left = schema->GetColumn(left_column->GetColIdx());
+    const Column &right = schema->GetColumn(right_column->GetColIdx());
+    operands.left_offset_ = left.GetOffset();
+    operands.right_offset_ = right.GetOffset();
+    WithType(left.GetType(), [&](auto left_type) {
+      using Left = decltype(left_type);
+      WithType(right.GetType(), [&](auto right_type) {
+        using Right = decltype(right_type);
+        using Common = CommonType<Left, Right>;
+        WithComparison<Common>(comp_type, [&](auto cmp) { test = &TestColumns<Left, Right, Common, decltype(cmp)>; });
+      });
+    });
+  } else if (left_column != nullptr && right_constant != nullptr) {
+    const Column &left = schema->GetColumn(left_column->GetColIdx());
+    const Value &constant = right_constant->GetValue();
+    operands.left_offset_ = left.GetOffset();
+    WithType(constant.GetTypeId(), [&](auto constant_type) {
+      using Constant = decltype(constant_type);
+      WithType(left.GetType(), [&](auto left_type) {
+        using Left = decltype(left_type);
+        using Common = CommonType<Left, Constant>;
+        if (constant.IsNull()) {
+          test = &TestFalse;
+          return;
+        }
+        if constexpr (std::is_same_v<Common, double>) {
+          operands.real_ = static_cast<double>(constant.GetAs<Constant>());
+        } else {
+          operands.int_ = static_cast<int64_t>(constant.GetAs<Constant>());
+        }
+        WithComparison<Common>(comp_type, [&](auto cmp) { test = &TestColumnConstant<Left, Common, decltype(cmp)>; });
+      });
+    });
+  } else if (left_constant != nullptr && right_constant != nullptr) {
+    // The predicate does not depend on the tuple, it is evaluated here once and for all.
+    const Value result = predicate->Evaluate(nullptr, schema);
+    test = !result.IsNull() && result.GetAs<bool>() ? &TestTrue : &TestFalse;
+  }
+  if (test == nullptr) {
+    return nullptr;
+  }
+  return std::unique_ptr<CompiledPredicate>(new CompiledPredicate(test, operands));
+}
+
+}  // namespace bustub
@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// distinct_executor.cpp
+//
+// Identification: src/execution/distinct_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/distinct_executor.h"
+
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/abstract_expression.h"
+
+namespace bustub {
+
+void DistinctExecutor::Init() {
+  child_->Init();
+  set_.Clear();
+  memory_.Release();
+  child_batch_.Clear();
+  ResetNextFromBatch();
+}
+
+bool DistinctExecutor::NextBatch(TupleBatch *batch) {
+  const Schema *output_schema = GetOutputSchema();
+  const uint32_t num_columns = output_schema->GetColumnCount();
+  batch->Reset(output_schema);
+  columns_.resize(num_columns);
+  while (batch->IsEmpty()) {
+    if (!child_->NextBatch(&child_batch_)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < num_columns; i++) {
+      output_schema->GetColumn(i).GetExpr()->EvaluateBatch(child_batch_, &columns_[i]);
+    }
+    for (size_t row = 0; row < child_batch_.GetSize(); row++) {
+      key_.clear();
+      for (const auto &column : columns_) {
+        DistinctHashSet::AppendKey(column[row], &key_);
+      }
+      if (!set_.Insert(DistinctHashSet::HashKey(key_), key_)) {
+        continue;
+      }
+      std::vector<Value> values;
+      values.reserve(num_columns);
+      for (auto &column : columns_) {
+        values.push_back(std::move(column[row]));
+      }
+      batch->AppendRow(std::move(values));
+    }
+    memory_.Resize(set_.GetMemoryUsage());
+  }
+  return true;
+}
+
+void DistinctExecutor::Stop() {
+  child_->Stop();
+  set_.Clear();
+  memory_.Release();
+  child_batch_.Clear();
+  ResetNextFromBatch();
+}
+
+}  // namespace bustub
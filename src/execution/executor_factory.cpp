@@ -17,43 +17,119 @@
 
 #include "execution/executors/abstract_executor.h"
 #include "execution/executors/aggregation_executor.h"
+#include "execution/executors/distinct_executor.h"
+#include "execution/executors/fetch_executor.h"
 #include "execution/executors/hash_join_executor.h"
+#include "execution/executors/index_nested_loop_join_executor.h"
+#include "execution/executors/index_scan_executor.h"
 #include "execution/executors/insert_executor.h"
+#include "execution/executors/instrumented_executor.h"
+#include "execution/executors/limit_executor.h"
 #include "execution/executors/seq_scan_executor.h"
+#include "execution/executors/sort_executor.h"
+#include "execution/executors/topn_executor.h"
 
 namespace bustub {
 std::unique_ptr<AbstractExecutor> ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx,
                                                                   const AbstractPlanNode *plan) {
+  return CreateExecutor(exec_ctx, plan, nullptr);
+}
+
+std::unique_ptr<AbstractExecutor> ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx,
+                                                                  const AbstractPlanNode *plan,
+                                                                  ExecutorStats *parent_stats) {
+  if (!exec_ctx->IsStatsEnabled()) {
+    return CreatePlanExecutor(exec_ctx, plan, nullptr);
+  }
+  auto stats = std::make_shared<ExecutorStats>();
+  stats->plan_ = plan;
+  if (parent_stats != nullptr) {
+    parent_stats->children_.push_back(stats);
+  }
+  auto executor = CreatePlanExecutor(exec_ctx, plan, stats.get());
+  return std::make_unique<InstrumentedExecutor>(exec_ctx, std::move(executor), std::move(stats));
+}
+
+std::unique_ptr<AbstractExecutor> ExecutorFactory::CreatePlanExecutor(ExecutorContext *exec_ctx,
+                                                                      const AbstractPlanNode *plan,
+                                                                      ExecutorStats *stats) {
   switch (plan->GetType()) {
     // Create a new sequential scan executor.
     case PlanType::SeqScan: {
       return std::make_unique<SeqScanExecutor>(exec_ctx, dynamic_cast<const SeqScanPlanNode *>(plan));
     }
 
+    // Create a new index scan executor.
+    case PlanType::IndexScan: {
+      return std::make_unique<IndexScanExecutor>(exec_ctx, dynamic_cast<const IndexScanPlanNode *>(plan));
+    }
+
     // Create a new insert executor.
     case PlanType::Insert: {
       auto insert_plan = dynamic_cast<const InsertPlanNode *>(plan);
       auto child_executor =
-          insert_plan->IsRawInsert() ? nullptr : ExecutorFactory::CreateExecutor(exec_ctx, insert_plan->GetChildPlan());
+          insert_plan->IsRawInsert() ? nullptr : CreateExecutor(exec_ctx, insert_plan->GetChildPlan(), stats);
       return std::make_unique<InsertExecutor>(exec_ctx, insert_plan, std::move(child_executor));
     }
 
     // Create a new hash join executor.
     case PlanType::HashJoin: {
       auto join_plan = dynamic_cast<const HashJoinPlanNode *>(plan);
-      auto left_executor = ExecutorFactory::CreateExecutor(exec_ctx, join_plan->GetLeftPlan());
-      auto right_executor = ExecutorFactory::CreateExecutor(exec_ctx, join_plan->GetRightPlan());
+      auto left_executor = CreateExecutor(exec_ctx, join_plan->GetLeftPlan(), stats);
+      auto right_executor = CreateExecutor(exec_ctx, join_plan->GetRightPlan(), stats);
       return std::make_unique<HashJoinExecutor>(exec_ctx, join_plan, std::move(left_executor),
                                                 std::move(right_executor));
     }
 
+    // Create a new index nested loop join executor.
+    case PlanType::IndexNestedLoopJoin: {
+      auto join_plan = dynamic_cast<const IndexNestedLoopJoinPlanNode *>(plan);
+      auto outer_executor = CreateExecutor(exec_ctx, join_plan->GetOuterPlan(), stats);
+      return std::make_unique<IndexNestedLoopJoinExecutor>(exec_ctx, join_plan, std::move(outer_executor));
+    }
+
     // Create a new aggregation executor.
     case PlanType::Aggregation: {
       auto agg_plan = dynamic_cast<const AggregationPlanNode *>(plan);
-      auto child_executor = ExecutorFactory::CreateExecutor(exec_ctx, agg_plan->GetChildPlan());
+      auto child_executor = CreateExecutor(exec_ctx, agg_plan->GetChildPlan(), stats);
       return std::make_unique<AggregationExecutor>(exec_ctx, agg_plan, std::move(child_executor));
     }
 
+    // Create a new sort executor.
+    case PlanType::Sort: {
+      auto sort_plan = dynamic_cast<const SortPlanNode *>(plan);
+      auto child_executor = CreateExecutor(exec_ctx, sort_plan->GetChildPlan(), stats);
+      return std::make_unique<SortExecutor>(exec_ctx, sort_plan, std::move(child_executor));
+    }
+
+    // Create a new top-n executor.
+    case PlanType::TopN: {
+      auto topn_plan = dynamic_cast<const TopNPlanNode *>(plan);
+      auto child_executor = CreateExecutor(exec_ctx, topn_plan->GetChildPlan(), stats);
+      return std::make_unique<TopNExecutor>(exec_ctx, topn_plan, std::move(child_executor));
+    }
+
+    // Create a new limit executor.
+    case PlanType::Limit: {
+      auto limit_plan = dynamic_cast<const LimitPlanNode *>(plan);
+      auto child_executor = CreateExecutor(exec_ctx, limit_plan->GetChildPlan(), stats);
+      return std::make_unique<LimitExecutor>(exec_ctx, limit_plan, std::move(child_executor));
+    }
+
+    // Create a new fetch executor.
+    case PlanType::Fetch: {
+      auto fetch_plan = dynamic_cast<const FetchPlanNode *>(plan);
+      auto child_executor = CreateExecutor(exec_ctx, fetch_plan->GetChildPlan(), stats);
+      return std::make_unique<FetchExecutor>(exec_ctx, fetch_plan, std::move(child_executor));
+    }
+
+    // Create a new distinct executor.
+    case PlanType::Distinct: {
+      auto distinct_plan = dynamic_cast<const DistinctPlanNode *>(plan);
+      auto child_executor = CreateExecutor(exec_ctx, distinct_plan->GetChildPlan(), stats);
+      return std::make_unique<DistinctExecutor>(exec_ctx, distinct_plan, std::move(child_executor));
+    }
+
     default: {
       BUSTUB_ASSERT(false, "Unsupported plan type.");
     }
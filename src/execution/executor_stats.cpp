@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// executor_stats.cpp
+//
+// Identification: src/execution/executor_stats.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executor_stats.h"
+
+#include <sstream>
+
+namespace bustub {
+
+namespace {
+
+const char *PlanTypeName(PlanType type) {
+  switch (type) {
+    case PlanType::SeqScan:
+      return "SeqScan";
+    case PlanType::IndexScan:
+      return "IndexScan";
+    case PlanType::HashJoin:
+      return "HashJoin";
+    case PlanType::IndexNestedLoopJoin:
+      return "IndexNestedLoopJoin";
+    case PlanType::Insert:
+      return "Insert";
+    case PlanType::Aggregation:
+      return "Aggregation";
+    case PlanType::Sort:
+      return "Sort";
+    case PlanType::TopN:
+      return "TopN";
+    case PlanType::Limit:
+      return "Limit";
+    case PlanType::Fetch:
+      return "Fetch";
+    case PlanType::Distinct:
+      return "Distinct";
+  }
+  return "Unknown";
+}
+
+void Print(const ExecutorStats &stats, int depth, std::ostringstream *os) {
+  auto us = [](std::chrono::nanoseconds time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+  };
+  *os << std::string(depth * 2, ' ') << PlanTypeName(stats.plan_->GetType()) << " rows=" << stats.num_rows_
+      << " init=" << us(stats.init_time_) << "us next=" << us(stats.next_time_) << "us pages=" << stats.page_fetches_
+      << " hits=" << stats.page_hits_ << " memory=" << stats.peak_memory_ << "\n";
+  for (const auto &child : stats.children_) {
+    Print(*child, depth + 1, os);
+  }
+}
+
+}  // namespace
+
+std::string ExecutorStats::ToString() const {
+  std::ostringstream os;
+  Print(*this, 0, &os);
+  return os.str();
+}
+
+}  // namespace bustub
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// fetch_executor.cpp
+//
+// Identification: src/execution/fetch_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/fetch_executor.h"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+void FetchExecutor::Init() {
+  child_->Init();
+  tables_.clear();
+  for (const FetchSource &source : plan_->GetSources()) {
+    tables_.push_back(exec_ctx_->GetCatalog()->GetTable(source.table_oid_));
+  }
+  child_batch_.Clear();
+  ResetNextFromBatch();
+}
+
+void FetchExecutor::FetchTuples(size_t source, std::vector<Tuple> *tuples, std::vector<bool> *found) {
+  const std::vector<Value> &column = child_batch_.GetColumn(plan_->GetSources()[source].rid_col_idx_);
+  const std::vector<uint32_t> &selection = child_batch_.GetSelection();
+  std::vector<int64_t> rids(selection.size());
+  for (size_t i = 0; i < selection.size(); i++) {
+    rids[i] = column[selection[i]].GetAs<int64_t>();
+  }
+  std::vector<size_t> order(rids.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&rids](size_t a, size_t b) { return rids[a] < rids[b]; });
+  TableHeap *table = tables_[source]->table_.get();
+  for (size_t k = 0; k < order.size(); k++) {
+    const size_t i = order[k];
+    if (k > 0 && rids[order[k - 1]] == rids[i]) {
+      const size_t first = order[k - 1];
+      (*found)[i] = (*found)[i] && (*found)[first];
+      (*tuples)[i] = (*tuples)[first];
+      continue;
+    }
+    if (!table->GetTuple(RID(rids[i]), &(*tuples)[i], exec_ctx_->GetTransaction())) {
+      (*found)[i] = false;
+    }
+  }
+}
+
+bool FetchExecutor::NextBatch(TupleBatch *batch) {
+  const Schema *output_schema = GetOutputSchema();
+  const size_t num_sources = plan_->GetSources().size();
+  batch->Reset(output_schema);
+  std::vector<std::vector<Tuple>> tuples(num_sources);
+  std::vector<bool> found;
+  while (batch->IsEmpty()) {
+    if (!child_->NextBatch(&child_batch_)) {
+      return false;
+    }
+    found.assign(child_batch_.GetSize(), true);
+    for (size_t source = 0; source < num_sources; source++) {
+      tuples[source].assign(child_batch_.GetSize(), Tuple());
+      FetchTuples(source, &tuples[source], &found);
+    }
+    for (size_t i = 0; i < found.size(); i++) {
+      if (!found[i]) {
+        continue;
+      }
+      std::vector<Value> values;
+      values.reserve(output_schema->GetColumnCount());
+      for (const Column &column : output_schema->GetColumns()) {
+        if (num_sources == 1) {
+          values.push_back(column.GetExpr()->Evaluate(&tuples[0][i], &tables_[0]->schema_));
+        } else {
+          values.push_back(column.GetExpr()->EvaluateJoin(&tuples[0][i], &tables_[0]->schema_, &tuples[1][i],
+                                                          &tables_[1]->schema_));
+        }
+      }
+      batch->AppendRow(std::move(values));
+    }
+  }
+  return true;
+}
+
+void FetchExecutor::Stop() {
+  child_->Stop();
+  child_batch_.Clear();
+  ResetNextFromBatch();
+}
+
+}  // namespace bustub
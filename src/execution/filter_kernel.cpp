@@ -0,0 +1,488 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// filter_kernel.cpp
+//
+// Identification: src/execution/filter_kernel.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/filter_kernel.h"
+
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "storage/table/table_heap.h"
+#include "type/limits.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+using Constant = FilterKernel::Constant;
+using WordsFn = void (*)(const char *values, size_t num_words, const Constant &constant, uint64_t *mask);
+using RowsFn = void (*)(const char *values, size_t begin, size_t end, const Constant &constant, uint64_t *mask);
+
+/** The instruction sets that the kernels are built for. */
+enum class Isa { SCALAR, AVX2, AVX512 };
+
+/** @return the best instruction set that the CPU supports */
+Isa DetectIsa() {
+#if defined(__x86_64__)
+  static const Isa isa = __builtin_cpu_supports("avx512f") ? Isa::AVX512
+                         : __builtin_cpu_supports("avx2")  ? Isa::AVX2
+                                                           : Isa::SCALAR;
+  return isa;
+#else
+  return Isa::SCALAR;
+#endif
+}
+
+/** @return the i'th value of a vector of values of a C++ type */
+template <class T>
+T Load(const char *values, size_t i) {
+  T value;
+  memcpy(&value, values + i * sizeof(T), sizeof(T));
+  return value;
+}
+
+/** @return the value that stands for null in a column of a C++ type */
+template <class T>
+constexpr T NullOf() {
+  if constexpr (std::is_same_v<T, int32_t>) {
+    return BUSTUB_INT32_NULL;
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    return BUSTUB_INT64_NULL;
+  } else {
+    return BUSTUB_DECIMAL_NULL;
+  }
+}
+
+/** @return the constant of a kernel in the C++ type that it compares in */
+template <class C>
+C ConstantOf(const Constant &constant) {
+  if constexpr (std::is_floating_point_v<C>) {
+    return constant.real_;
+  } else {
+    return static_cast<C>(constant.int_);
+  }
+}
+
+template <ComparisonType Cmp, class C>
+bool Compare(C left, C right) {
+  if constexpr (Cmp == ComparisonType::Equal) {
+    return left == right;
+  } else if constexpr (Cmp == ComparisonType::NotEqual) {
+    return left != right;
+  } else if constexpr (Cmp == ComparisonType::LessThan) {
+    return left < right;
+  } else if constexpr (Cmp == ComparisonType::LessThanOrEqual) {
+    return left <= right;
+  } else if constexpr (Cmp == ComparisonType::GreaterThan) {
+    return left > right;
+  } else {
+    return left >= right;
+  }
+}
+
+/** @return true if a value of a column of type T passes the comparison with a constant, compared in C */
+template <class T, class C, ComparisonType Cmp>
+bool Passes(T value, C constant) {
+  return value != NullOf<T>() && Compare<Cmp>(static_cast<C>(value), constant);
+}
+
+template <class T, class C, ComparisonType Cmp>
+void ScalarRows(const char *values, size_t begin, size_t end, const Constant &constant, uint64_t *mask) {
+  const C c = ConstantOf<C>(constant);
+  for (size_t i = begin; i < end; i++) {
+    if (Passes<T, C, Cmp>(Load<T>(values, i), c)) {
+      mask[i / 64] |= uint64_t{1} << (i % 64);
+    }
+  }
+}
+
+/** @return the word of the mask of the 64 values from values on */
+template <class T, class C, ComparisonType Cmp>
+uint64_t ScalarWord(const char *values, C constant) {
+  uint64_t word = 0;
+  for (size_t i = 0; i < 64; i++) {
+    word |= static_cast<uint64_t>(Passes<T, C, Cmp>(Load<T>(values, i), constant)) << i;
+  }
+  return word;
+}
+
+template <class T, class C, uint64_t (*Word)(const char *, C)>
+void RunWords(const char *values, size_t num_words, const Constant &constant, uint64_t *mask) {
+  const C c = ConstantOf<C>(constant);
+  for (size_t w = 0; w < num_words; w++) {
+    mask[w] = Word(values + w * 64 * sizeof(T), c);
+  }
+}
+
+#if defined(__x86_64__)
+
+/** @return the _CMP_ predicate of a comparison of doubles, which like C++ holds for no NaN but != */
+constexpr int FloatPredicate(ComparisonType type) {
+  switch (type) {
+    case ComparisonType::Equal:
+      return _CMP_EQ_OQ;
+    case ComparisonType::NotEqual:
+      return _CMP_NEQ_UQ;
+    case ComparisonType::LessThan:
+      return _CMP_LT_OQ;
+    case ComparisonType::LessThanOrEqual:
+      return _CMP_LE_OQ;
+    case ComparisonType::GreaterThan:
+      return _CMP_GT_OQ;
+    default:
+      return _CMP_GE_OQ;
+  }
+}
+
+/** @return the _MM_CMPINT_ predicate of a comparison of integers */
+constexpr int IntPredicate(ComparisonType type) {
+  switch (type) {
+    case ComparisonType::Equal:
+      return _MM_CMPINT_EQ;
+    case ComparisonType::NotEqual:
+      return _MM_CMPINT_NE;
+    case ComparisonType::LessThan:
+      return _MM_CMPINT_LT;
+    case ComparisonType::LessThanOrEqual:
+      return _MM_CMPINT_LE;
+    case ComparisonType::GreaterThan:
+      return _MM_CMPINT_NLE;
+    default:
+      return _MM_CMPINT_NLT;
+  }
+}
+
+/** @return true if AVX2 tests a comparison as the negation of equal, or of greater than either way around */
+constexpr bool IsNegated(ComparisonType type) {
+  return type == ComparisonType::NotEqual || type == ComparisonType::LessThanOrEqual ||
+         type == ComparisonType::GreaterThanOrEqual;
+}
+
+template <ComparisonType Cmp>
+__attribute__((target("avx2"))) uint64_t Avx2WordInt32(const char *values, int32_t constant) {
+  const __m256i c = _mm256_set1_epi32(constant);
+  const __m256i null = _mm256_set1_epi32(BUSTUB_INT32_NULL);
+  uint64_t word = 0;
+  for (int j = 0; j < 8; j++) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values) + j);
+    __m256i hit;
+    if constexpr (Cmp == ComparisonType::Equal || Cmp == ComparisonType::NotEqual) {
+      hit = _mm256_cmpeq_epi32(v, c);
+    } else if constexpr (Cmp == ComparisonType::GreaterThan || Cmp == ComparisonType::LessThanOrEqual) {
+      hit = _mm256_cmpgt_epi32(v, c);
+    } else {
+      hit = _mm256_cmpgt_epi32(c, v);
+    }
+    auto bits = static_cast<uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(hit)));
+    if constexpr (IsNegated(Cmp)) {
+      bits = ~bits;
+    }
+    bits &= ~static_cast<uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, null))));
+    word |= (bits & 0xff) << (j * 8);
+  }
+  return word;
+}
+
+template <ComparisonType Cmp>
+__attribute__((target("avx2"))) uint64_t Avx2WordInt64(const char *values, int64_t constant) {
+  const __m256i c = _mm256_set1_epi64x(constant);
+  const __m256i null = _mm256_set1_epi64x(BUSTUB_INT64_NULL);
+  uint64_t word = 0;
+  for (int j = 0; j < 16; j++) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values) + j);
+    __m256i hit;
+    if constexpr (Cmp == ComparisonType::Equal || Cmp == ComparisonType::NotEqual) {
+      hit = _mm256_cmpeq_epi64(v, c);
+    } else if constexpr (Cmp == ComparisonType::GreaterThan || Cmp == ComparisonType::LessThanOrEqual) {
+      hit = _mm256_cmpgt_epi64(v, c);
+    } else {
+      hit = _mm256_cmpgt_epi64(c, v);
+    }
+    auto bits = static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(hit)));
+    if constexpr (IsNegated(Cmp)) {
+      bits = ~bits;
+    }
+    bits &= ~static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, null))));
+    word |= (bits & 0xf) << (j * 4);
+  }
+  return word;
+}
+
+template <ComparisonType Cmp>
+__attribute__((target("avx2"))) uint64_t Avx2WordDouble(const char *values, double constant) {
+  const __m256d c = _mm256_set1_pd(constant);
+  const __m256d null = _mm256_set1_pd(BUSTUB_DECIMAL_NULL);
+  constexpr int predicate = FloatPredicate(Cmp);
+  uint64_t word = 0;
+  for (int j = 0; j < 16; j++) {
+    const __m256d v = _mm256_loadu_pd(reinterpret_cast<const double *>(values) + j * 4);
+    auto bits = static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(v, c, predicate)));
+    bits &= ~static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(v, null, _CMP_EQ_OQ)));
+    word |= (bits & 0xf) << (j * 4);
+  }
+  return word;
+}
+
+template <ComparisonType Cmp>
+__attribute__((target("avx512f"))) uint64_t Avx512WordInt32(const char *values, int32_t constant) {
+  const __m512i c = _mm512_set1_epi32(constant);
+  const __m512i null = _mm512_set1_epi32(BUSTUB_INT32_NULL);
+  constexpr int predicate = IntPredicate(Cmp);
+  uint64_t word = 0;
+  for (int j = 0; j < 4; j++) {
+    const __m512i v = _mm512_loadu_si512(values + j * 64);
+    const __mmask16 hit = _mm512_cmp_epi32_mask(v, c, predicate) & ~_mm512_cmpeq_epi32_mask(v, null);
+    word |= static_cast<uint64_t>(hit) << (j * 16);
+  }
+  return word;
+}
+
+template <ComparisonType Cmp>
+__attribute__((target("avx512f"))) uint64_t Avx512WordInt64(const char *values, int64_t constant) {
+  const __m512i c = _mm512_set1_epi64(constant);
+  const __m512i null = _mm512_set1_epi64(BUSTUB_INT64_NULL);
+  constexpr int predicate = IntPredicate(Cmp);
+  uint64_t word = 0;
+  for (int j = 0; j < 8; j++) {
+    const __m512i v = _mm512_loadu_si512(values + j * 64);
+    const __mmask8 hit = _mm512_cmp_epi64_mask(v, c, predicate) & ~_mm512_cmpeq_epi64_mask(v, null);
+    word |= static_cast<uint64_t>(hit) << (j * 8);
+  }
+  return word;
+}
+
+template <ComparisonType Cmp>
+__attribute__((target("avx512f"))) uint64_t Avx512WordDouble(const char *values, double constant) {
+  const __m512d c = _mm512_set1_pd(constant);
+  const __m512d null = _mm512_set1_pd(BUSTUB_DECIMAL_NULL);
+  constexpr int predicate = FloatPredicate(Cmp);
+  uint64_t word = 0;
+  for (int j = 0; j < 8; j++) {
+    const __m512d v = _mm512_loadu_pd(reinterpret_cast<const double *>(values) + j * 8);
+    const __mmask8 hit = _mm512_cmp_pd_mask(v, c, predicate) & ~_mm512_cmp_pd_mask(v, null, _CMP_EQ_OQ);
+    word |= static_cast<uint64_t>(hit) << (j * 8);
+  }
+  return word;
+}
+
+#endif
+
+/**
+ * @return the kernel of the words of a column of type T compared in C, vectorized for the CPU if the values and the
+ * constant are of the same width
+ */
+template <class T, class C, ComparisonType Cmp>
+WordsFn SelectWords() {
+#if defined(__x86_64__)
+  if constexpr (std::is_same_v<T, C>) {
+    switch (DetectIsa()) {
+      case Isa::AVX512:
+        if constexpr (std::is_same_v<T, int32_t>) {
+          return &RunWords<T, C, &Avx512WordInt32<Cmp>>;
+        } else if constexpr (std::is_same_v<T, double>) {
+          return &RunWords<T, C, &Avx512WordDouble<Cmp>>;
+        } else {
+          return &RunWords<T, C, &Avx512WordInt64<Cmp>>;
+        }
+      case Isa::AVX2:
+        if constexpr (std::is_same_v<T, int32_t>) {
+          return &RunWords<T, C, &Avx2WordInt32<Cmp>>;
+        } else if constexpr (std::is_same_v<T, double>) {
+          return &RunWords<T, C, &Avx2WordDouble<Cmp>>;
+        } else {
+          return &RunWords<T, C, &Avx2WordInt64<Cmp>>;
+        }
+      case Isa::SCALAR:
+        break;
+    }
+  }
+#endif
+  return &RunWords<T, C, &ScalarWord<T, C, Cmp>>;
+}
+
+/** Calls fn with std::integral_constant<ComparisonType, type>. */
+template <class Fn>
+void WithComparison(ComparisonType type, Fn &&fn) {
+  switch (type) {
+    case ComparisonType::Equal:
+      fn(std::integral_constant<ComparisonType, ComparisonType::Equal>());
+      break;
+    case ComparisonType::NotEqual:
+      fn(std::integral_constant<ComparisonType, ComparisonType::NotEqual>());
+      break;
+    case ComparisonType::LessThan:
+      fn(std::integral_constant<ComparisonType, ComparisonType::LessThan>());
+      break;
+    case ComparisonType::LessThanOrEqual:
+      fn(std::integral_constant<ComparisonType, ComparisonType::LessThanOrEqual>());
+      break;
+    case ComparisonType::GreaterThan:
+      fn(std::integral_constant<ComparisonType, ComparisonType::GreaterThan>());
+      break;
+    case ComparisonType::GreaterThanOrEqual:
+      fn(std::integral_constant<ComparisonType, ComparisonType::GreaterThanOrEqual>());
+      break;
+  }
+}
+
+/** @return the comparison that holds for (b, a) when the given one holds for (a, b) */
+ComparisonType Flip(ComparisonType type) {
+  switch (type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return type;
+  }
+}
+
+/** @return an integer constant as a 64-bit integer */
+int64_t IntegerOf(const Value &value) {
+  switch (value.GetTypeId()) {
+    case TypeId::TINYINT:
+      return value.GetAs<int8_t>();
+    case TypeId::SMALLINT:
+      return value.GetAs<int16_t>();
+    case TypeId::INTEGER:
+      return value.GetAs<int32_t>();
+    default:
+      return value.GetAs<int64_t>();
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<FilterKernel> FilterKernel::Compile(const AbstractExpression *predicate, const Schema *schema,
+                                                   const TableHeap *table) {
+  auto comparison = dynamic_cast<const ComparisonExpression *>(predicate);
+  if (comparison == nullptr) {
+    return nullptr;
+  }
+  ComparisonType comp_type = comparison->GetComparisonType();
+  auto column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  auto constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  // A constant on the left is compared the other way around.
+  if (column == nullptr) {
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+    constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+    comp_type = Flip(comp_type);
+  }
+  if (column == nullptr || constant == nullptr || column->GetTupleIdx() != 0 || constant->GetValue().IsNull()) {
+    return nullptr;
+  }
+
+  const Value &value = constant->GetValue();
+  const TypeId constant_type = value.GetTypeId();
+  const bool integral = constant_type >= TypeId::TINYINT && constant_type <= TypeId::BIGINT;
+  const ColumnDictionary *dictionary = table == nullptr ? nullptr : table->GetDictionary(column->GetColIdx());
+  Constant operand;
+  if (dictionary != nullptr) {
+    // The codes keep the equality of the strings but not their order. A string that has no code is -1, which equals
+    // no code.
+    if (constant_type != TypeId::VARCHAR || value.GetLength() == BUSTUB_VARCHAR_MAX_LEN ||
+        (comp_type != ComparisonType::Equal && comp_type != ComparisonType::NotEqual)) {
+      return nullptr;
+    }
+    operand.int_ = dictionary->Find(value.ToString());
+  } else if (integral) {
+    operand.int_ = IntegerOf(value);
+    operand.real_ = static_cast<double>(operand.int_);
+  } else if (constant_type == TypeId::DECIMAL) {
+    operand.real_ = value.GetAs<double>();
+  } else {
+    return nullptr;
+  }
+
+  WordsFn words = nullptr;
+  RowsFn rows = nullptr;
+  auto make = [&](auto column_type, auto common_type) {
+    using T = decltype(column_type);
+    using C = decltype(common_type);
+    WithComparison(comp_type, [&](auto cmp) {
+      words = SelectWords<T, C, decltype(cmp)::value>();
+      rows = &ScalarRows<T, C, decltype(cmp)::value>;
+    });
+  };
+  const bool fits_int32 = operand.int_ >= std::numeric_limits<int32_t>::min() &&
+                          operand.int_ <= std::numeric_limits<int32_t>::max();
+  if (dictionary != nullptr) {
+    make(int32_t{}, int32_t{});
+  } else {
+    switch (schema->GetColumn(column->GetColIdx()).GetType()) {
+      case TypeId::INTEGER:
+        if (integral && fits_int32) {
+          make(int32_t{}, int32_t{});
+        } else if (integral) {
+          make(int32_t{}, int64_t{});
+        } else if (constant_type == TypeId::DECIMAL) {
+          make(int32_t{}, double{});
+        }
+        break;
+      case TypeId::BIGINT:
+        if (integral) {
+          make(int64_t{}, int64_t{});
+        } else if (constant_type == TypeId::DECIMAL) {
+          make(int64_t{}, double{});
+        }
+        break;
+      case TypeId::DECIMAL:
+        make(double{}, double{});
+        break;
+      default:
+        break;
+    }
+  }
+  if (words == nullptr) {
+    return nullptr;
+  }
+  return std::unique_ptr<FilterKernel>(new FilterKernel(column->GetColIdx(), words, rows, operand));
+}
+
+size_t FilterKernel::Filter(const char *values, size_t num_rows, uint64_t *mask) const {
+  const size_t num_words = num_rows / 64;
+  words_(values, num_words, constant_, mask);
+  if (num_rows % 64 != 0) {
+    mask[num_words] = 0;
+    rows_(values, num_words * 64, num_rows, constant_, mask);
+  }
+  size_t num_passed = 0;
+  for (size_t w = 0; w < (num_rows + 63) / 64; w++) {
+    num_passed += __builtin_popcountll(mask[w]);
+  }
+  return num_passed;
+}
+
+const char *FilterKernel::GetInstructionSet() {
+  switch (DetectIsa()) {
+    case Isa::AVX512:
+      return "avx512";
+    case Isa::AVX2:
+      return "avx2";
+    default:
+      return "scalar";
+  }
+}
+
+}  // namespace bustub
@@ -1,29 +1,589 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// hash_join_executor.cpp
-//
-// Identification: src/execution/hash_join_executor.cpp
-//
-// Copyright (c) 2015-19, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include <memory>
-#include <vector>
-
-#include "execution/executors/hash_join_executor.h"
-
-namespace bustub {
-
-HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan,
-                                   std::unique_ptr<AbstractExecutor> &&left, std::unique_ptr<AbstractExecutor> &&right)
-    : AbstractExecutor(exec_ctx) {}
-
-/** @return the JHT in use. Do not modify this function, otherwise you will get a zero. */
-// Uncomment me! const HT *GetJHT() const { return &jht_; }
-
-void HashJoinExecutor::Init() {}
-
-bool HashJoinExecutor::Next(Tuple *tuple) { return false; }
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_join_executor.cpp
+//
+// Identification: src/execution/hash_join_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "execution/executors/hash_join_executor.h"
+#include "execution/executors/instrumented_executor.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the executor as a sequential scan, under its instrumentation if it has any, nullptr if it is not one */
+const SeqScanExecutor *AsSeqScan(AbstractExecutor *executor) {
+  if (auto instrumented = dynamic_cast<InstrumentedExecutor *>(executor); instrumented != nullptr) {
+    executor = instrumented->GetExecutor();
+  }
+  return dynamic_cast<const SeqScanExecutor *>(executor);
+}
+
+}  // namespace
+
+HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan,
+                                   std::unique_ptr<AbstractExecutor> &&left, std::unique_ptr<AbstractExecutor> &&right)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_(std::move(left)),
+      right_(std::move(right)),
+      left_replay_(exec_ctx, left_.get()),
+      right_replay_(exec_ctx, right_.get()),
+      jht_("hash_join", exec_ctx->GetBufferPoolManager(), jht_comp_, jht_num_buckets_, jht_hash_fn_),
+      memory_(exec_ctx->GetMemoryTracker(), MemorySubsystem::HASH_JOIN) {}
+
+void HashJoinExecutor::Init() {
+  left_->Init();
+  right_->Init();
+  memory_.Release();
+  if (ChoosePartitionWise()) {
+    swapped_ = false;
+    build_ = left_.get();
+    probe_ = right_.get();
+  } else {
+    ChooseBuildSide();
+  }
+  key_layout_ = JoinKeyLayout(BuildKeys(), ProbeKeys());
+  probe_key_.assign(key_layout_.GetWidth(), 0);
+  hot_run_ = std::make_unique<TmpTupleRun>(exec_ctx_->GetBufferPoolManager());
+  right_done_ = false;
+  right_batch_.Clear();
+  right_index_ = 0;
+  matches_.clear();
+  match_index_ = 0;
+  outputs_.clear();
+  output_index_ = 0;
+  build_tuples_.clear();
+  build_keys_.clear();
+  build_hashes_.clear();
+  ResetNextFromBatch();
+  if (IsPartitionWise()) {
+    return;
+  }
+  if (exec_ctx_->GetParallelism() > 1 && BuildRadix()) {
+    PushFilter();
+    return;
+  }
+  Tuple tuple;
+  while (build_->Next(&tuple)) {
+    BuildTuple(tuple);
+  }
+  // Once built, the pages are only read, and may be evicted like any other.
+  hot_run_->Finish();
+  for (size_t i = 1; i < left_runs_.size(); i++) {
+    left_runs_[i]->Finish();
+  }
+  PushFilter();
+}
+
+void HashJoinExecutor::ChooseBuildSide() {
+  left_replay_.Init();
+  right_replay_.Init();
+  swapped_ = false;
+  build_ = left_.get();
+  probe_ = right_.get();
+  const std::optional<size_t> estimate = plan_->GetEstimatedBuildRows();
+  if (!estimate.has_value()) {
+    return;
+  }
+  build_ = &left_replay_;
+  probe_ = &right_replay_;
+  // Up to the limit, the left child is as large as estimated, give or take, and is built on as planned.
+  const size_t limit = std::max(*estimate * HASH_JOIN_MISESTIMATE_FACTOR, static_cast<size_t>(EXECUTOR_BATCH_SIZE));
+  if (left_replay_.ReadAhead(limit)) {
+    return;
+  }
+  // The right child is read no further than it takes to tell that it is not the smaller one.
+  if (right_replay_.ReadAhead(left_replay_.GetNumRows()) && right_replay_.GetNumRows() < left_replay_.GetNumRows()) {
+    swapped_ = true;
+    std::swap(build_, probe_);
+  }
+}
+
+bool HashJoinExecutor::ChoosePartitionWise() {
+  left_scan_ = nullptr;
+  right_scan_ = nullptr;
+  // An optimistic transaction records its reads, which only one thread may do.
+  if (exec_ctx_->GetParallelism() <= 1 || exec_ctx_->GetTransaction()->IsOptimistic()) {
+    return false;
+  }
+  const SeqScanExecutor *left = AsSeqScan(left_.get());
+  const SeqScanExecutor *right = AsSeqScan(right_.get());
+  if (left == nullptr || right == nullptr || left->GetPartitioning() == nullptr ||
+      right->GetPartitioning() == nullptr || !left->GetPartitioning()->IsCoPartitionedWith(*right->GetPartitioning())) {
+    return false;
+  }
+  const auto &left_keys = plan_->GetLeftKeys();
+  const auto &right_keys = plan_->GetRightKeys();
+  bool on_partition_key = false;
+  for (size_t i = 0; i < left_keys.size() && i < right_keys.size(); i++) {
+    on_partition_key = on_partition_key || (left->IsPartitionKey(left_keys[i]) && right->IsPartitionKey(right_keys[i]));
+  }
+  if (!on_partition_key) {
+    return false;
+  }
+  // A worker holds both partitions of its pair in memory, and the workers of a round as many pairs at once.
+  size_t max_pages = 0;
+  for (size_t i = 0; i < left->GetPartitioning()->GetNumPartitions(); i++) {
+    max_pages = std::max(max_pages, left->GetPartitionPages(i) + right->GetPartitionPages(i));
+  }
+  const size_t round_pages = max_pages * exec_ctx_->GetParallelism();
+  if (round_pages > exec_ctx_->GetMemoryBudget() || !memory_.Resize(round_pages * PAGE_SIZE)) {
+    memory_.Release();
+    return false;
+  }
+  left_scan_ = left;
+  right_scan_ = right;
+  next_partition_ = 0;
+  return true;
+}
+
+bool HashJoinExecutor::NextPartitionWise(std::vector<Value> *values) {
+  const size_t num_partitions = left_scan_->GetPartitioning()->GetNumPartitions();
+  while (output_index_ >= outputs_.size()) {
+    if (next_partition_ >= num_partitions) {
+      return false;
+    }
+    const size_t round_end = std::min(next_partition_ + exec_ctx_->GetParallelism(), num_partitions);
+    std::atomic<size_t> next{next_partition_};
+    std::vector<std::vector<std::vector<Value>>> results(exec_ctx_->GetParallelism());
+    std::atomic<bool> failed{false};
+    exec_ctx_->RunWorkers([&](size_t worker) {
+      for (size_t partition = next++; partition < round_end; partition = next++) {
+        if (!JoinPartition(partition, &results[worker])) {
+          failed = true;
+        }
+      }
+    });
+    next_partition_ = round_end;
+    if (failed) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for a page of a partition-wise join.");
+    }
+    outputs_.clear();
+    output_index_ = 0;
+    for (auto &result : results) {
+      std::move(result.begin(), result.end(), std::back_inserter(outputs_));
+    }
+  }
+  *values = std::move(outputs_[output_index_++]);
+  return true;
+}
+
+bool HashJoinExecutor::JoinPartition(size_t partition, std::vector<std::vector<Value>> *outputs) {
+  std::vector<TupleBatch> left_batches;
+  std::vector<TupleBatch> right_batches;
+  if (!left_scan_->ScanPartition(partition, &left_batches)) {
+    return false;
+  }
+  if (left_batches.empty()) {
+    return true;
+  }
+  if (!right_scan_->ScanPartition(partition, &right_batches)) {
+    return false;
+  }
+  const Schema *left_schema = left_->GetOutputSchema();
+  const Schema *right_schema = right_->GetOutputSchema();
+  size_t num_rows = 0;
+  for (const TupleBatch &batch : left_batches) {
+    num_rows += batch.GetSize();
+  }
+  SimpleHashJoinHashTable table("hash_join_partition", nullptr, jht_comp_, num_rows, jht_hash_fn_,
+                                key_layout_.GetWidth());
+  std::vector<char> key(key_layout_.GetWidth());
+  for (const TupleBatch &batch : left_batches) {
+    for (uint32_t row : batch.GetSelection()) {
+      const Tuple tuple = batch.GetTuple(row);
+      key_layout_.Normalize(tuple, left_schema, BuildKeys(), key.data());
+      table.Insert(exec_ctx_->GetTransaction(), HashValues(&tuple, left_schema, BuildKeys()), tuple, key.data());
+    }
+  }
+  std::vector<Value> output;
+  for (const TupleBatch &batch : right_batches) {
+    for (uint32_t row : batch.GetSelection()) {
+      const Tuple tuple = batch.GetTuple(row);
+      key_layout_.Normalize(tuple, right_schema, ProbeKeys(), key.data());
+      for (const Tuple &match : table.Probe(HashValues(&tuple, right_schema, ProbeKeys()), key.data())) {
+        if (MakeOutput(match, tuple, &output)) {
+          outputs->push_back(std::move(output));
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void HashJoinExecutor::PushFilter() {
+  join_filter_ = std::make_unique<JoinFilter>(build_hashes_.size());
+  for (hash_t hash : build_hashes_) {
+    join_filter_->Add(hash);
+  }
+  build_hashes_.clear();
+  build_hashes_.shrink_to_fit();
+  filter_pushed_ = probe_->PushJoinFilter(join_filter_.get(), ProbeKeys());
+}
+
+void HashJoinExecutor::BuildTuple(const Tuple &tuple) {
+  const hash_t hash = HashValues(&tuple, build_->GetOutputSchema(), BuildKeys());
+  build_hashes_.push_back(hash);
+  if (HasSpilled() && PartitionOf(hash, 0) != 0) {
+    left_runs_[PartitionOf(hash, 0)]->Append(tuple);
+    return;
+  }
+  jht_.Insert(exec_ctx_->GetTransaction(), hash, AppendHot(tuple));
+  if (!HasSpilled()) {
+    const size_t num_pages = hot_run_->GetNumPages();
+    const bool query_fits = memory_.Resize(num_pages * PAGE_SIZE);
+    if (!query_fits || num_pages > exec_ctx_->GetMemoryBudget()) {
+      Spill();
+    }
+  }
+}
+
+TmpTuple HashJoinExecutor::AppendHot(const Tuple &tuple) {
+  const size_t width = key_layout_.GetWidth();
+  record_.resize(width + tuple.GetLength());
+  key_layout_.Normalize(tuple, build_->GetOutputSchema(), BuildKeys(), record_.data());
+  std::memcpy(record_.data() + width, tuple.GetData(), tuple.GetLength());
+  return hot_run_->Append(Tuple(record_.data(), record_.size()));
+}
+
+bool HashJoinExecutor::BuildRadix() {
+  const Schema *left_schema = build_->GetOutputSchema();
+  const size_t budget = exec_ctx_->GetMemoryBudget() * PAGE_SIZE;
+  const size_t width = key_layout_.GetWidth();
+  size_t size = 0;
+  std::vector<RadixJoin::Row> rows;
+  bool fits = true;
+  Tuple tuple;
+  while (fits && build_->Next(&tuple)) {
+    rows.push_back(RadixJoin::Row{HashValues(&tuple, left_schema, BuildKeys()),
+                                  static_cast<uint32_t>(build_tuples_.size())});
+    size += tuple.GetLength() + sizeof(Tuple) + sizeof(RadixJoin::Row) + width;
+    build_keys_.resize(build_keys_.size() + width);
+    key_layout_.Normalize(tuple, left_schema, BuildKeys(), build_keys_.data() + build_keys_.size() - width);
+    build_tuples_.push_back(tuple);
+    fits = memory_.Resize(size) && size <= budget;
+  }
+  if (fits) {
+    for (const RadixJoin::Row &row : rows) {
+      build_hashes_.push_back(row.hash_);
+    }
+    radix_ = std::make_unique<RadixJoin>(exec_ctx_->GetParallelism(), HASH_JOIN_RADIX_PARTITION_ROWS,
+                                          exec_ctx_->GetScheduler());
+    radix_->Build(std::move(rows));
+    return true;
+  }
+  for (const Tuple &build_tuple : build_tuples_) {
+    BuildTuple(build_tuple);
+  }
+  build_tuples_.clear();
+  build_tuples_.shrink_to_fit();
+  build_keys_.clear();
+  build_keys_.shrink_to_fit();
+  return false;
+}
+
+bool HashJoinExecutor::NextRadix(std::vector<Value> *values) {
+  while (output_index_ >= outputs_.size()) {
+    if (right_done_) {
+      return false;
+    }
+    const Schema *right_schema = probe_->GetOutputSchema();
+    const size_t width = key_layout_.GetWidth();
+    std::vector<Tuple> probe_tuples;
+    std::vector<char> probe_keys;
+    std::vector<RadixJoin::Row> rows;
+    Tuple right_tuple;
+    hash_t hash;
+    while (probe_tuples.size() < static_cast<size_t>(HASH_JOIN_PROBE_BATCH) && NextRight(&right_tuple, &hash)) {
+      rows.push_back(RadixJoin::Row{hash, static_cast<uint32_t>(probe_tuples.size())});
+      probe_keys.resize(probe_keys.size() + width);
+      key_layout_.Normalize(right_tuple, right_schema, ProbeKeys(), probe_keys.data() + probe_keys.size() - width);
+      probe_tuples.push_back(right_tuple);
+    }
+    std::vector<std::vector<std::vector<Value>>> results(exec_ctx_->GetParallelism());
+    radix_->Probe(std::move(rows), [&](size_t worker, uint32_t build_index, uint32_t probe_index) {
+      if (!JoinKeyLayout::Equal(build_keys_.data() + build_index * width, probe_keys.data() + probe_index * width,
+                                width)) {
+        return;
+      }
+      std::vector<Value> output;
+      if (MakeOutput(build_tuples_[build_index], probe_tuples[probe_index], &output)) {
+        results[worker].push_back(std::move(output));
+      }
+    });
+    outputs_.clear();
+    output_index_ = 0;
+    for (auto &result : results) {
+      std::move(result.begin(), result.end(), std::back_inserter(outputs_));
+    }
+  }
+  *values = std::move(outputs_[output_index_++]);
+  return true;
+}
+
+bool HashJoinExecutor::NextRight(Tuple *tuple, hash_t *hash) {
+  while (right_index_ >= right_batch_.GetSize()) {
+    right_index_ = 0;
+    if (right_done_ || !probe_->NextBatch(&right_batch_)) {
+      right_done_ = true;
+      right_batch_.Clear();
+      return false;
+    }
+    JoinFilter::HashKeys(right_batch_, ProbeKeys(), &right_hashes_);
+    size_t num_kept = 0;
+    right_batch_.Filter([this, &num_kept](size_t i) {
+      if (!MayMatch(right_hashes_[i])) {
+        return false;
+      }
+      right_hashes_[num_kept++] = right_hashes_[i];
+      return true;
+    });
+    right_hashes_.resize(num_kept);
+  }
+  *hash = right_hashes_[right_index_];
+  *tuple = right_batch_.GetTuple(right_batch_.GetSelection()[right_index_++]);
+  return true;
+}
+
+void HashJoinExecutor::Spill() {
+  SpillFileManager *spill_files = exec_ctx_->GetSpillFileManager();
+  Transaction *txn = exec_ctx_->GetTransaction();
+  const Schema *left_schema = build_->GetOutputSchema();
+  left_runs_.resize(HASH_JOIN_PARTITIONS);
+  right_runs_.resize(HASH_JOIN_PARTITIONS);
+  for (size_t i = 1; i < left_runs_.size(); i++) {
+    left_runs_[i] = std::make_unique<TmpTupleRun>(spill_files);
+    right_runs_[i] = std::make_unique<TmpTupleRun>(spill_files);
+  }
+  TmpTupleRun::Cursor cursor;
+  Tuple record;
+  TmpTuple tmp_tuple(INVALID_PAGE_ID, 0);
+  while (hot_run_->Read(&cursor, &record, &tmp_tuple)) {
+    const Tuple tuple = StoredTuple(record.GetData(), record.GetLength());
+    const hash_t hash = HashValues(&tuple, left_schema, BuildKeys());
+    const size_t partition = PartitionOf(hash, 0);
+    if (partition != 0) {
+      left_runs_[partition]->Append(tuple);
+      jht_.Remove(txn, hash, tmp_tuple);
+    }
+  }
+}
+
+void HashJoinExecutor::Repartition(PartitionPair *pair) {
+  SpillFileManager *spill_files = exec_ctx_->GetSpillFileManager();
+  std::vector<PartitionPair> pairs(HASH_JOIN_PARTITIONS);
+  for (auto &split : pairs) {
+    split.left_ = std::make_unique<TmpTupleRun>(spill_files);
+    split.right_ = std::make_unique<TmpTupleRun>(spill_files);
+    split.depth_ = pair->depth_ + 1;
+  }
+  const Schema *left_schema = build_->GetOutputSchema();
+  const Schema *right_schema = probe_->GetOutputSchema();
+  TmpTupleRun::Cursor cursor;
+  Tuple tuple;
+  while (pair->left_->Read(&cursor, &tuple)) {
+    const hash_t hash = HashValues(&tuple, left_schema, BuildKeys());
+    pairs[PartitionOf(hash, pair->depth_ + 1)].left_->Append(tuple);
+  }
+  cursor = TmpTupleRun::Cursor();
+  while (pair->right_->Read(&cursor, &tuple)) {
+    const hash_t hash = HashValues(&tuple, right_schema, ProbeKeys());
+    pairs[PartitionOf(hash, pair->depth_ + 1)].right_->Append(tuple);
+  }
+  // The split pairs go first, so that the runs that are on disk at any time stay few.
+  for (auto &split : pairs) {
+    split.left_->Finish();
+    split.right_->Finish();
+    pending_.push_front(std::move(split));
+  }
+  pair->left_.reset();
+  pair->right_.reset();
+}
+
+bool HashJoinExecutor::NextPartition() {
+  current_table_.reset();
+  current_.left_.reset();
+  current_.right_.reset();
+  while (!pending_.empty()) {
+    PartitionPair pair = std::move(pending_.front());
+    pending_.pop_front();
+    if (pair.left_->GetNumTuples() == 0 || pair.right_->GetNumTuples() == 0) {
+      continue;
+    }
+    const size_t num_pages = pair.left_->GetNumPages();
+    const bool query_fits = memory_.Resize(num_pages * PAGE_SIZE);
+    if ((!query_fits || num_pages > exec_ctx_->GetMemoryBudget()) && pair.depth_ < HASH_JOIN_MAX_DEPTH) {
+      Repartition(&pair);
+      continue;
+    }
+    const Schema *left_schema = build_->GetOutputSchema();
+    current_table_ =
+        std::make_unique<SimpleHashJoinHashTable>("hash_join_partition", nullptr, jht_comp_, pair.left_->GetNumTuples(),
+                                                  jht_hash_fn_, key_layout_.GetWidth());
+    TmpTupleRun::Cursor cursor;
+    Tuple tuple;
+    std::vector<char> key(key_layout_.GetWidth());
+    while (pair.left_->Read(&cursor, &tuple)) {
+      key_layout_.Normalize(tuple, left_schema, BuildKeys(), key.data());
+      current_table_->Insert(exec_ctx_->GetTransaction(), HashValues(&tuple, left_schema, BuildKeys()), tuple,
+                             key.data());
+    }
+    current_ = std::move(pair);
+    current_cursor_ = TmpTupleRun::Cursor();
+    return true;
+  }
+  memory_.Release();
+  return false;
+}
+
+bool HashJoinExecutor::NextProbe() {
+  const Schema *right_schema = probe_->GetOutputSchema();
+  while (!right_done_) {
+    hash_t hash;
+    if (!NextRight(&right_tuple_, &hash)) {
+      for (size_t i = 1; i < right_runs_.size(); i++) {
+        right_runs_[i]->Finish();
+        pending_.push_back(PartitionPair{std::move(left_runs_[i]), std::move(right_runs_[i]), 0});
+      }
+      break;
+    }
+    if (HasSpilled() && PartitionOf(hash, 0) != 0) {
+      right_runs_[PartitionOf(hash, 0)]->Append(right_tuple_);
+      continue;
+    }
+    matches_.clear();
+    match_index_ = 0;
+    jht_.GetValue(exec_ctx_->GetTransaction(), hash, &matches_);
+    key_layout_.Normalize(right_tuple_, right_schema, ProbeKeys(), probe_key_.data());
+    return true;
+  }
+  matches_.clear();
+  match_index_ = 0;
+  while (current_table_ != nullptr || NextPartition()) {
+    if (current_.right_->Read(&current_cursor_, &right_tuple_)) {
+      key_layout_.Normalize(right_tuple_, right_schema, ProbeKeys(), probe_key_.data());
+      auto range = current_table_->Probe(HashValues(&right_tuple_, right_schema, ProbeKeys()), probe_key_.data());
+      partition_match_ = range.begin();
+      partition_end_ = range.end();
+      return true;
+    }
+    current_table_.reset();
+  }
+  return false;
+}
+
+void HashJoinExecutor::Stop() {
+  left_->Stop();
+  right_->Stop();
+  left_replay_.Stop();
+  right_replay_.Stop();
+  right_done_ = true;
+  if (IsPartitionWise()) {
+    next_partition_ = left_scan_->GetPartitioning()->GetNumPartitions();
+  }
+  matches_.clear();
+  match_index_ = 0;
+  partition_match_ = partition_end_ = SimpleHashJoinHashTable::Iterator(nullptr, 0);
+  current_table_.reset();
+  current_ = PartitionPair{};
+  pending_.clear();
+  left_runs_.clear();
+  right_runs_.clear();
+  hot_run_.reset();
+  memory_.Release();
+  radix_.reset();
+  build_tuples_.clear();
+  build_keys_.clear();
+  build_hashes_.clear();
+  outputs_.clear();
+  output_index_ = 0;
+  ResetNextFromBatch();
+}
+
+bool HashJoinExecutor::MakeOutput(const Tuple &build_tuple, const Tuple &probe_tuple, std::vector<Value> *values) {
+  // The expressions of the plan take the tuple of the left child first, whichever side is built on.
+  const Tuple *left_tuple = swapped_ ? &probe_tuple : &build_tuple;
+  const Tuple *right_tuple = swapped_ ? &build_tuple : &probe_tuple;
+  const Schema *left_schema = left_->GetOutputSchema();
+  const Schema *right_schema = right_->GetOutputSchema();
+  const AbstractExpression *predicate = plan_->Predicate();
+  // Tuples whose keys only share their hash, or their bytes in the key layout, are weeded out here.
+  if (predicate != nullptr &&
+      !predicate->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema).GetAs<bool>()) {
+    return false;
+  }
+  const Schema *output_schema = GetOutputSchema();
+  values->clear();
+  values->reserve(output_schema->GetColumnCount());
+  for (const auto &column : output_schema->GetColumns()) {
+    values->emplace_back(column.GetExpr()->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema));
+  }
+  return true;
+}
+
+bool HashJoinExecutor::NextBatch(TupleBatch *batch) {
+  batch->Reset(GetOutputSchema());
+  std::vector<Value> values;
+  while (!batch->IsFull() && NextOutput(&values)) {
+    batch->AppendRow(std::move(values));
+  }
+  return !batch->IsEmpty();
+}
+
+bool HashJoinExecutor::NextOutput(std::vector<Value> *values) {
+  if (IsPartitionWise()) {
+    return NextPartitionWise(values);
+  }
+  if (radix_ != nullptr) {
+    return NextRadix(values);
+  }
+  BufferPoolManager *bpm = exec_ctx_->GetBufferPoolManager();
+  const size_t width = key_layout_.GetWidth();
+  while (true) {
+    while (match_index_ < matches_.size()) {
+      const TmpTuple &match = matches_[match_index_++];
+      ReadPageGuard guard = bpm->FetchPageRead(match.GetPageId());
+      if (!guard.IsValid()) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for the build side of a hash join.");
+      }
+      // The record is its size and its data, the join key and the tuple. A tuple whose key differs is skipped, and one
+      // whose key is equal is joined in place, neither is copied out of the page.
+      const char *record = guard.GetData() + match.GetOffset();
+      const char *data = record + sizeof(uint32_t);
+      if (!JoinKeyLayout::Equal(data, probe_key_.data(), width)) {
+        continue;
+      }
+      if (MakeOutput(StoredTuple(data, *reinterpret_cast<const uint32_t *>(record)), right_tuple_, values)) {
+        return true;
+      }
+    }
+    while (partition_match_ != partition_end_) {
+      const Tuple &left_tuple = *partition_match_;
+      ++partition_match_;
+      if (MakeOutput(left_tuple, right_tuple_, values)) {
+        return true;
+      }
+    }
+    if (!NextProbe()) {
+      return false;
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_nested_loop_join_executor.cpp
+//
+// Identification: src/execution/index_nested_loop_join_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/index_nested_loop_join_executor.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+IndexNestedLoopJoinExecutor::IndexNestedLoopJoinExecutor(ExecutorContext *exec_ctx,
+                                                         const IndexNestedLoopJoinPlanNode *plan,
+                                                         std::unique_ptr<AbstractExecutor> &&outer)
+    : AbstractExecutor(exec_ctx), plan_(plan), outer_(std::move(outer)) {}
+
+void IndexNestedLoopJoinExecutor::Init() {
+  SimpleCatalog *catalog = exec_ctx_->GetCatalog();
+  inner_info_ = catalog->GetTable(plan_->GetInnerTableOid());
+  index_ = catalog->GetIndex(plan_->GetIndexOid())->index_.get();
+  outer_->Init();
+  outer_tuples_.clear();
+  outer_keys_.clear();
+  matches_.clear();
+  match_index_ = 0;
+  inner_valid_ = false;
+  ResetNextFromBatch();
+}
+
+void IndexNestedLoopJoinExecutor::Stop() {
+  outer_->Stop();
+  outer_tuples_.clear();
+  outer_keys_.clear();
+  matches_.clear();
+  match_index_ = 0;
+  inner_tuple_.Release();
+  inner_valid_ = false;
+  ResetNextFromBatch();
+}
+
+bool IndexNestedLoopJoinExecutor::ProbeNextBatch() {
+  TupleBatch outer_batch;
+  if (!outer_->NextBatch(&outer_batch)) {
+    return false;
+  }
+  const Schema *outer_schema = outer_->GetOutputSchema();
+  const Schema *key_schema = index_->GetKeySchema();
+  outer_tuples_.clear();
+  outer_keys_.clear();
+  std::vector<Tuple> index_keys;
+  for (uint32_t row : outer_batch.GetSelection()) {
+    Tuple outer_tuple = outer_batch.GetTuple(row);
+    std::vector<Value> key;
+    key.reserve(plan_->GetOuterKeys().size());
+    for (const AbstractExpression *expr : plan_->GetOuterKeys()) {
+      key.push_back(expr->Evaluate(&outer_tuple, outer_schema));
+    }
+    if (std::any_of(key.begin(), key.end(), [](const Value &value) { return value.IsNull(); })) {
+      continue;
+    }
+    index_keys.emplace_back(key, key_schema);
+    outer_tuples_.push_back(std::move(outer_tuple));
+    outer_keys_.push_back(std::move(key));
+  }
+
+  std::vector<std::vector<RID>> rids;
+  index_->ScanKeys(index_keys, &rids, exec_ctx_->GetTransaction());
+  matches_.clear();
+  match_index_ = 0;
+  for (size_t i = 0; i < rids.size(); i++) {
+    for (const RID &rid : rids[i]) {
+      matches_.emplace_back(i, rid);
+    }
+  }
+  std::stable_sort(matches_.begin(), matches_.end(),
+                   [](const auto &a, const auto &b) { return a.second.Get() < b.second.Get(); });
+  inner_valid_ = false;
+  return true;
+}
+
+bool IndexNestedLoopJoinExecutor::HasKey(const Tuple &inner_tuple, const std::vector<Value> &key) const {
+  const std::vector<uint32_t> &key_attrs = index_->GetKeyAttrs();
+  for (size_t i = 0; i < key_attrs.size(); i++) {
+    if (inner_tuple.GetValueView(&inner_info_->schema_, key_attrs[i]).CompareEquals(key[i]) != CmpBool::CmpTrue) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IndexNestedLoopJoinExecutor::NextBatch(TupleBatch *batch) {
+  batch->Reset(GetOutputSchema());
+  const Schema *outer_schema = outer_->GetOutputSchema();
+  const Schema *inner_schema = &inner_info_->schema_;
+  const Schema *output_schema = GetOutputSchema();
+  const AbstractExpression *predicate = plan_->Predicate();
+  while (!batch->IsFull()) {
+    if (match_index_ == matches_.size()) {
+      inner_tuple_.Release();
+      inner_valid_ = false;
+      if (!ProbeNextBatch()) {
+        break;
+      }
+    }
+    while (!batch->IsFull() && match_index_ < matches_.size()) {
+      const auto &[outer_idx, rid] = matches_[match_index_++];
+      // The matches of one inner tuple are next to each other, it is read once for all of them.
+      if (!inner_valid_ || !(inner_rid_ == rid)) {
+        inner_rid_ = rid;
+        inner_valid_ = inner_info_->table_->GetTupleRef(rid, &inner_tuple_, exec_ctx_->GetTransaction());
+        if (!inner_valid_) {
+          continue;
+        }
+      }
+      const Tuple &outer_tuple = outer_tuples_[outer_idx];
+      if (!HasKey(*inner_tuple_, outer_keys_[outer_idx])) {
+        continue;
+      }
+      if (predicate != nullptr) {
+        const Value value = predicate->EvaluateJoin(&outer_tuple, outer_schema, &*inner_tuple_, inner_schema);
+        if (value.IsNull() || !value.GetAs<bool>()) {
+          continue;
+        }
+      }
+      std::vector<Value> values;
+      values.reserve(output_schema->GetColumnCount());
+      for (const auto &column : output_schema->GetColumns()) {
+        values.emplace_back(column.GetExpr()->EvaluateJoin(&outer_tuple, outer_schema, &*inner_tuple_, inner_schema));
+      }
+      batch->AppendRow(std::move(values));
+    }
+  }
+  inner_tuple_.Release();
+  inner_valid_ = false;
+  return !batch->IsEmpty();
+}
+
+}  // namespace bustub
@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_scan_executor.cpp
+//
+// Identification: src/execution/index_scan_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/index_scan_executor.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace bustub {
+
+IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  SimpleCatalog *catalog = exec_ctx_->GetCatalog();
+  table_info_ = catalog->GetTable(plan_->GetTableOid());
+  index_ = catalog->GetIndex(plan_->GetIndexOid())->index_.get();
+  rids_.clear();
+  next_rid_ = 0;
+  index_->ScanKey(Tuple(plan_->GetKey(), index_->GetKeySchema()), &rids_, exec_ctx_->GetTransaction());
+  std::sort(rids_.begin(), rids_.end(), [](const RID &a, const RID &b) { return a.Get() < b.Get(); });
+  rids_.erase(std::unique(rids_.begin(), rids_.end()), rids_.end());
+}
+
+bool IndexScanExecutor::HasKey(const Tuple &tuple) const {
+  const std::vector<uint32_t> &key_attrs = index_->GetKeyAttrs();
+  for (size_t i = 0; i < key_attrs.size(); i++) {
+    const Value value = tuple.GetValueView(&table_info_->schema_, key_attrs[i]);
+    if (value.CompareEquals(plan_->GetKey()[i]) != CmpBool::CmpTrue) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IndexScanExecutor::Next(Tuple *tuple) {
+  const Schema *schema = &table_info_->schema_;
+  const AbstractExpression *predicate = plan_->GetPredicate();
+  // The tuple is read in place, only the values of the output are copied out of its page.
+  TupleRef table_tuple;
+  while (next_rid_ < rids_.size()) {
+    if (!table_info_->table_->GetTupleRef(rids_[next_rid_++], &table_tuple, exec_ctx_->GetTransaction()) ||
+        !HasKey(*table_tuple)) {
+      continue;
+    }
+    if (predicate != nullptr) {
+      const Value value = predicate->Evaluate(&*table_tuple, schema);
+      if (value.IsNull() || !value.GetAs<bool>()) {
+        continue;
+      }
+    }
+    const Schema *output_schema = GetOutputSchema();
+    std::vector<Value> values;
+    values.reserve(output_schema->GetColumnCount());
+    for (const Column &column : output_schema->GetColumns()) {
+      values.push_back(column.GetExpr()->Evaluate(&*table_tuple, schema));
+    }
+    *tuple = Tuple(values, output_schema);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace bustub
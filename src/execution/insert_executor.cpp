@@ -1,28 +1,138 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// insert_executor.cpp
-//
-// Identification: src/execution/insert_executor.cpp
-//
-// Copyright (c) 2015-19, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include <memory>
-
-#include "execution/executors/insert_executor.h"
-
-namespace bustub {
-
-InsertExecutor::InsertExecutor(ExecutorContext *exec_ctx, const InsertPlanNode *plan,
-                               std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
-
-const Schema *InsertExecutor::GetOutputSchema() { return plan_->OutputSchema(); }
-
-void InsertExecutor::Init() {}
-
-bool InsertExecutor::Next([[maybe_unused]] Tuple *tuple) { return false; }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// insert_executor.cpp
+//
+// Identification: src/execution/insert_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executors/insert_executor.h"
+
+namespace bustub {
+
+InsertExecutor::InsertExecutor(ExecutorContext *exec_ctx, const InsertPlanNode *plan,
+                               std::unique_ptr<AbstractExecutor> &&child_executor)
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+const Schema *InsertExecutor::GetOutputSchema() { return plan_->OutputSchema(); }
+
+void InsertExecutor::Init() {
+  table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->TableOid());
+  table_indexes_ = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);
+  partition_indexes_.clear();
+  for (TableMetadata *partition : table_info_->partitions_) {
+    partition_indexes_.push_back(exec_ctx_->GetCatalog()->GetTableIndexes(partition->name_));
+  }
+  if (child_executor_ != nullptr) {
+    child_executor_->Init();
+  }
+  done_ = false;
+}
+
+bool InsertExecutor::InsertTuples(const std::vector<Tuple> &tuples) {
+  Transaction *txn = exec_ctx_->GetTransaction();
+  // The rows of an LSM table go to its memtable, under an intention lock on its heap; it has no indexes.
+  if (table_info_->lsm_ != nullptr) {
+    if (!table_info_->table_->LockTable(txn, LockMode::INTENTION_EXCLUSIVE) ||
+        !table_info_->lsm_->InsertTuples(tuples)) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    table_info_->stats_.Add(tuples);
+    return true;
+  }
+  if (table_info_->partitioning_ == nullptr) {
+    return InsertInto(table_info_, table_indexes_, tuples);
+  }
+  // The rows of a partitioned table go to their partitions, a batch per partition.
+  std::vector<std::vector<Tuple>> partition_tuples(table_info_->partitions_.size());
+  for (const Tuple &tuple : tuples) {
+    partition_tuples[table_info_->partitioning_->PartitionOf(tuple, &table_info_->schema_)].push_back(tuple);
+  }
+  for (size_t i = 0; i < partition_tuples.size(); i++) {
+    if (!partition_tuples[i].empty() &&
+        !InsertInto(table_info_->partitions_[i], partition_indexes_[i], partition_tuples[i])) {
+      return false;
+    }
+  }
+  table_info_->stats_.Add(tuples);
+  return true;
+}
+
+bool InsertExecutor::InsertInto(TableMetadata *table_info, const std::vector<IndexInfo *> &indexes,
+                                const std::vector<Tuple> &tuples) {
+  std::vector<RID> rids;
+  Transaction *txn = exec_ctx_->GetTransaction();
+  if (!table_info->table_->InsertTuples(tuples, &rids, txn)) {
+    return false;
+  }
+  table_info->stats_.Add(tuples);
+  // A buffered insert has no rid yet, so it is not indexed.
+  std::vector<Tuple> keys;
+  std::vector<RID> key_rids;
+  for (IndexInfo *index_info : indexes) {
+    Index *index = index_info->index_.get();
+    keys.clear();
+    key_rids.clear();
+    for (size_t i = 0; i < tuples.size(); i++) {
+      if (rids[i].GetPageId() != INVALID_PAGE_ID) {
+        keys.push_back(tuples[i].KeyFromTuple(table_info->schema_, *index->GetKeySchema(), index->GetKeyAttrs()));
+        key_rids.push_back(rids[i]);
+      }
+    }
+    index->InsertEntries(keys, key_rids, txn);
+  }
+  return true;
+}
+
+bool InsertExecutor::Next([[maybe_unused]] Tuple *tuple) {
+  if (done_) {
+    return false;
+  }
+  done_ = true;
+  const Schema *schema = &table_info_->schema_;
+  std::vector<Tuple> tuples;
+  if (plan_->IsRawInsert()) {
+    for (const auto &values : plan_->RawValues()) {
+      tuples.emplace_back(values, schema);
+      if (tuples.size() == static_cast<size_t>(EXECUTOR_BATCH_SIZE)) {
+        if (!InsertTuples(tuples)) {
+          return false;
+        }
+        tuples.clear();
+      }
+    }
+    return InsertTuples(tuples);
+  }
+  TupleBatch batch;
+  while (child_executor_->NextBatch(&batch)) {
+    tuples.clear();
+    for (uint32_t row : batch.GetSelection()) {
+      std::vector<Value> values;
+      values.reserve(schema->GetColumnCount());
+      for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+        values.push_back(batch.GetValue(i, row));
+      }
+      tuples.emplace_back(values, schema);
+    }
+    if (!InsertTuples(tuples)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool InsertExecutor::NextBatch(TupleBatch *batch) {
+  batch->Reset(GetOutputSchema());
+  Next(nullptr);
+  return false;
+}
+
+}  // namespace bustub
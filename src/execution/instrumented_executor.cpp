@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// instrumented_executor.cpp
+//
+// Identification: src/execution/instrumented_executor.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/instrumented_executor.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+
+namespace bustub {
+
+template <class Call>
+auto InstrumentedExecutor::Measure(std::chrono::nanoseconds *time, Call &&call) {
+  BufferPoolManager *bpm = exec_ctx_->GetBufferPoolManager();
+  const BufferPoolStats before = bpm->GetStats();
+  const auto start = std::chrono::steady_clock::now();
+  auto result = call();
+  *time += std::chrono::steady_clock::now() - start;
+  const BufferPoolStats after = bpm->GetStats();
+  stats_->page_hits_ += after.fetch_hits - before.fetch_hits;
+  stats_->page_fetches_ += after.fetch_hits + after.fetch_misses - before.fetch_hits - before.fetch_misses;
+  stats_->peak_memory_ = std::max(stats_->peak_memory_, executor_->GetMemoryUsage());
+  return result;
+}
+
+void InstrumentedExecutor::Init() {
+  Measure(&stats_->init_time_, [this] {
+    executor_->Init();
+    return true;
+  });
+}
+
+bool InstrumentedExecutor::Next(Tuple *tuple) {
+  const bool produced = Measure(&stats_->next_time_, [&] { return executor_->Next(tuple); });
+  stats_->num_rows_ += produced ? 1 : 0;
+  return produced;
+}
+
+bool InstrumentedExecutor::NextBatch(TupleBatch *batch) {
+  const bool produced = Measure(&stats_->next_time_, [&] { return executor_->NextBatch(batch); });
+  stats_->num_rows_ += produced ? batch->GetSize() : 0;
+  return produced;
+}
+
+}  // namespace bustub
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_key.cpp
+//
+// Identification: src/execution/join_key.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/join_key.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "execution/expressions/column_value_expression.h"
+
+namespace bustub {
+
+JoinKeyLayout::KeyKind JoinKeyLayout::KindOf(TypeId type) {
+  switch (type) {
+    case TypeId::TINYINT:
+    case TypeId::SMALLINT:
+    case TypeId::INTEGER:
+    case TypeId::BIGINT:
+      return KeyKind::INTEGER;
+    case TypeId::BOOLEAN:
+      return KeyKind::BOOLEAN;
+    case TypeId::TIMESTAMP:
+      return KeyKind::TIMESTAMP;
+    case TypeId::DECIMAL:
+      return KeyKind::DECIMAL;
+    case TypeId::VARCHAR:
+      return KeyKind::VARCHAR;
+    default:
+      return KeyKind::INVALID;
+  }
+}
+
+JoinKeyLayout::JoinKeyLayout(const std::vector<const AbstractExpression *> &build_keys,
+                             const std::vector<const AbstractExpression *> &probe_keys) {
+  if (build_keys.empty() || build_keys.size() != probe_keys.size()) {
+    return;
+  }
+  size_t width = 0;
+  for (size_t i = 0; i < build_keys.size(); i++) {
+    const KeyKind kind = KindOf(build_keys[i]->GetReturnType());
+    if (kind == KeyKind::INVALID || kind != KindOf(probe_keys[i]->GetReturnType())) {
+      kinds_.clear();
+      offsets_.clear();
+      return;
+    }
+    kinds_.push_back(kind);
+    offsets_.push_back(width);
+    width += sizeof(uint64_t) + (kind == KeyKind::VARCHAR ? VARCHAR_PREFIX : 0);
+  }
+  width_ = width;
+}
+
+void JoinKeyLayout::Normalize(const Tuple &tuple, const Schema *schema,
+                              const std::vector<const AbstractExpression *> &exprs, char *key) const {
+  if (width_ == 0) {
+    return;
+  }
+  std::memset(key, 0, width_);
+  for (size_t i = 0; i < kinds_.size(); i++) {
+    // A key that is a column is read in place, without copying its string.
+    const auto *column = dynamic_cast<const ColumnValueExpression *>(exprs[i]);
+    const Value value =
+        column != nullptr ? tuple.GetValueView(schema, column->GetColIdx()) : exprs[i]->Evaluate(&tuple, schema);
+    if (value.IsNull()) {
+      continue;
+    }
+    char *word = key + offsets_[i];
+    uint64_t bits = 0;
+    switch (kinds_[i]) {
+      case KeyKind::INTEGER:
+        switch (value.GetTypeId()) {
+          case TypeId::TINYINT:
+            bits = static_cast<int64_t>(value.GetAs<int8_t>());
+            break;
+          case TypeId::SMALLINT:
+            bits = static_cast<int64_t>(value.GetAs<int16_t>());
+            break;
+          case TypeId::INTEGER:
+            bits = static_cast<int64_t>(value.GetAs<int32_t>());
+            break;
+          default:
+            bits = value.GetAs<int64_t>();
+            break;
+        }
+        break;
+      case KeyKind::BOOLEAN:
+        bits = static_cast<uint64_t>(value.GetAs<int8_t>());
+        break;
+      case KeyKind::TIMESTAMP:
+        bits = value.GetAs<uint64_t>();
+        break;
+      case KeyKind::DECIMAL: {
+        double raw = value.GetAs<double>();
+        if (raw == 0) {
+          raw = 0;
+        }
+        std::memcpy(&bits, &raw, sizeof(bits));
+        break;
+      }
+      case KeyKind::VARCHAR: {
+        // The length of a VARCHAR counts its terminating zero, which is not compared.
+        const uint32_t length = value.GetLength() == 0 ? 0 : value.GetLength() - 1;
+        bits = length;
+        std::memcpy(word + sizeof(uint64_t), value.GetData(), std::min<size_t>(length, VARCHAR_PREFIX));
+        break;
+      }
+      default:
+        break;
+    }
+    std::memcpy(word, &bits, sizeof(bits));
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// limit_executor.cpp
+//
+// Identification: src/execution/limit_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/limit_executor.h"
+
+namespace bustub {
+
+void LimitExecutor::Init() {
+  remaining_ = plan_->GetLimit();
+  stopped_ = remaining_ == 0;
+  if (!stopped_) {
+    child_->Init();
+  }
+  ResetNextFromBatch();
+}
+
+bool LimitExecutor::NextBatch(TupleBatch *batch) {
+  if (stopped_) {
+    batch->Reset(GetOutputSchema());
+    return false;
+  }
+  if (!child_->NextBatch(batch)) {
+    return false;
+  }
+  if (batch->GetSize() >= remaining_) {
+    const size_t keep = remaining_;
+    batch->Filter([keep](size_t i) { return i < keep; });
+    Stop();
+  }
+  remaining_ -= batch->GetSize();
+  return !batch->IsEmpty();
+}
+
+void LimitExecutor::Stop() {
+  if (!stopped_) {
+    stopped_ = true;
+    child_->Stop();
+  }
+}
+
+}  // namespace bustub
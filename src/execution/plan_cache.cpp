@@ -0,0 +1,269 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// plan_cache.cpp
+//
+// Identification: src/execution/plan_cache.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/plan_cache.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "execution/executor_factory.h"
+#include "execution/expressions/aggregate_value_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/fetch_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_nested_loop_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/insert_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+
+namespace bustub {
+
+namespace {
+
+/** Writes the signature of a plan tree, see PreparedPlan::GetSignature(). */
+class SignatureWriter {
+ public:
+  SignatureWriter(std::ostringstream *os, const std::vector<ConstantValueExpression *> &params)
+      : os_(os), params_(params) {}
+
+  void WritePlan(const AbstractPlanNode *plan) {
+    *os_ << "P" << static_cast<int>(plan->GetType()) << "(";
+    switch (plan->GetType()) {
+      case PlanType::SeqScan: {
+        auto scan = static_cast<const SeqScanPlanNode *>(plan);
+        *os_ << "t" << scan->GetTableOid();
+        WriteExpr(scan->GetPredicate());
+        break;
+      }
+      case PlanType::IndexScan: {
+        auto scan = static_cast<const IndexScanPlanNode *>(plan);
+        *os_ << "t" << scan->GetTableOid() << "i" << scan->GetIndexOid();
+        WriteExpr(scan->GetPredicate());
+        WriteValues(scan->GetKey());
+        break;
+      }
+      case PlanType::HashJoin: {
+        auto join = static_cast<const HashJoinPlanNode *>(plan);
+        WriteExpr(join->Predicate());
+        WriteExprs(join->GetLeftKeys());
+        WriteExprs(join->GetRightKeys());
+        // The estimate only picks the build side, which does not change the results.
+        break;
+      }
+      case PlanType::IndexNestedLoopJoin: {
+        auto join = static_cast<const IndexNestedLoopJoinPlanNode *>(plan);
+        *os_ << "t" << join->GetInnerTableOid() << "i" << join->GetIndexOid();
+        WriteExpr(join->Predicate());
+        WriteExprs(join->GetOuterKeys());
+        break;
+      }
+      case PlanType::Insert: {
+        auto insert = static_cast<const InsertPlanNode *>(plan);
+        *os_ << "t" << insert->TableOid();
+        if (insert->IsRawInsert()) {
+          for (const auto &row : insert->RawValues()) {
+            WriteValues(row);
+          }
+        }
+        break;
+      }
+      case PlanType::Aggregation: {
+        auto agg = static_cast<const AggregationPlanNode *>(plan);
+        WriteExpr(agg->GetHaving());
+        WriteExprs(agg->GetGroupBys());
+        WriteExprs(agg->GetAggregates());
+        for (AggregationType type : agg->GetAggregateTypes()) {
+          *os_ << "a" << static_cast<int>(type);
+        }
+        // A plan that reads a view is not the one that aggregates its child.
+        if (agg->GetView() != nullptr) {
+          *os_ << "m" << static_cast<const void *>(agg->GetView());
+        }
+        break;
+      }
+      case PlanType::Sort: {
+        WriteOrderBys(static_cast<const SortPlanNode *>(plan)->GetOrderBy());
+        break;
+      }
+      case PlanType::TopN: {
+        auto topn = static_cast<const TopNPlanNode *>(plan);
+        *os_ << "n" << topn->GetN();
+        WriteOrderBys(topn->GetOrderBy());
+        break;
+      }
+      case PlanType::Limit: {
+        *os_ << "n" << static_cast<const LimitPlanNode *>(plan)->GetLimit();
+        break;
+      }
+      case PlanType::Fetch: {
+        for (const FetchSource &source : static_cast<const FetchPlanNode *>(plan)->GetSources()) {
+          *os_ << "r" << source.rid_col_idx_ << "t" << source.table_oid_;
+        }
+        break;
+      }
+      case PlanType::Distinct: {
+        break;
+      }
+    }
+    WriteSchema(plan->OutputSchema());
+    for (const AbstractPlanNode *child : plan->GetChildren()) {
+      WritePlan(child);
+    }
+    *os_ << ")";
+  }
+
+ private:
+  void WriteExpr(const AbstractExpression *expr) {
+    if (expr == nullptr) {
+      *os_ << "_";
+      return;
+    }
+    if (auto constant = dynamic_cast<const ConstantValueExpression *>(expr); constant != nullptr) {
+      auto param = std::find(params_.begin(), params_.end(), constant);
+      if (param != params_.end()) {
+        *os_ << "?" << param - params_.begin() << ":" << static_cast<int>(constant->GetReturnType());
+      } else {
+        WriteValue(constant->GetValue());
+      }
+      return;
+    }
+    if (auto column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+      *os_ << "c" << column->GetTupleIdx() << "." << column->GetColIdx();
+    } else if (auto agg = dynamic_cast<const AggregateValueExpression *>(expr); agg != nullptr) {
+      *os_ << (agg->IsGroupByTerm() ? "g" : "a") << agg->GetTermIdx();
+    } else if (auto comparison = dynamic_cast<const ComparisonExpression *>(expr); comparison != nullptr) {
+      *os_ << "=" << static_cast<int>(comparison->GetComparisonType());
+    } else {
+      // Any other expression is told apart by its class, and by its children.
+      *os_ << typeid(*expr).name();
+    }
+    *os_ << ":" << static_cast<int>(expr->GetReturnType()) << "(";
+    for (const AbstractExpression *child : expr->GetChildren()) {
+      WriteExpr(child);
+    }
+    *os_ << ")";
+  }
+
+  void WriteExprs(const std::vector<const AbstractExpression *> &exprs) {
+    *os_ << "[";
+    for (const AbstractExpression *expr : exprs) {
+      WriteExpr(expr);
+    }
+    *os_ << "]";
+  }
+
+  void WriteOrderBys(const std::vector<OrderBy> &order_bys) {
+    for (const auto &[type, expr] : order_bys) {
+      *os_ << (type == OrderByType::ASC ? "<" : ">");
+      WriteExpr(expr);
+    }
+  }
+
+  void WriteValue(const Value &value) {
+    *os_ << "v" << static_cast<int>(value.GetTypeId());
+    if (value.IsNull()) {
+      *os_ << "null";
+      return;
+    }
+    // The length keeps a string from running into whatever follows it.
+    const std::string text = value.ToString();
+    *os_ << "'" << text.size() << "'" << text;
+  }
+
+  void WriteValues(const std::vector<Value> &values) {
+    *os_ << "[";
+    for (const Value &value : values) {
+      WriteValue(value);
+    }
+    *os_ << "]";
+  }
+
+  void WriteSchema(const Schema *schema) {
+    // Plans that output nothing, e.g. inserts, have no schema.
+    if (schema == nullptr) {
+      *os_ << "{}";
+      return;
+    }
+    *os_ << "{";
+    for (const Column &column : schema->GetColumns()) {
+      *os_ << column.GetName().size() << "'" << column.GetName() << static_cast<int>(column.GetType()) << "l"
+           << column.GetLength();
+      WriteExpr(column.GetExpr());
+    }
+    *os_ << "}";
+  }
+
+  std::ostringstream *os_;
+  const std::vector<ConstantValueExpression *> &params_;
+};
+
+}  // namespace
+
+std::string PreparedPlan::GetSignature() const {
+  BUSTUB_ASSERT(root_ != nullptr, "A plan needs a root.");
+  if (!signature_.empty()) {
+    return signature_;
+  }
+  std::ostringstream os;
+  SignatureWriter(&os, params_).WritePlan(root_);
+  return os.str();
+}
+
+void PreparedPlan::Execute(const std::vector<Value> &params, std::vector<Tuple> *result) {
+  result->clear();
+  TupleVectorSink sink(result);
+  Execute(params, &sink);
+}
+
+bool PreparedPlan::Execute(const std::vector<Value> &params, ResultSink *sink) {
+  BUSTUB_ASSERT(executor_ != nullptr, "A plan is prepared before it is executed.");
+  BUSTUB_ASSERT(params.size() == params_.size(), "Every parameter needs a value.");
+  for (size_t i = 0; i < params.size(); i++) {
+    params_[i]->SetValue(params[i]);
+  }
+  num_executions_++;
+  return sink->Drain(executor_.get());
+}
+
+PreparedPlan *PlanCache::Prepare(std::unique_ptr<PreparedPlan> &&plan) {
+  std::string signature = plan->GetSignature();
+  auto it = signatures_.find(signature);
+  if (it != signatures_.end()) {
+    num_hits_++;
+    plans_.splice(plans_.begin(), plans_, it->second);
+    return plans_.front().get();
+  }
+  num_misses_++;
+  plan->executor_ = ExecutorFactory::CreateExecutor(exec_ctx_, plan->GetRoot());
+  plan->exec_ctx_ = exec_ctx_;
+  plan->signature_ = signature;
+  plans_.push_front(std::move(plan));
+  signatures_.emplace(std::move(signature), plans_.begin());
+  if (plans_.size() > capacity_) {
+    signatures_.erase(plans_.back()->signature_);
+    plans_.pop_back();
+  }
+  return plans_.front().get();
+}
+
+}  // namespace bustub
@@ -0,0 +1,244 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// push_engine.cpp
+//
+// Identification: src/execution/push_engine.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/push_engine.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_factory.h"
+#include "execution/executors/aggregation_executor.h"
+#include "execution/join_filter.h"
+
+namespace bustub {
+
+namespace {
+
+/** The build side of a hash join, column by column, with a chained hash table on the hashes of its keys. */
+class JoinBuildSide {
+ public:
+  explicit JoinBuildSide(const Schema *schema) : columns_(schema->GetColumnCount()) {}
+
+  /** Adds the selected rows of a batch, whose keys have the given hashes. */
+  void Add(const TupleBatch &batch, const std::vector<hash_t> &hashes) {
+    for (size_t i = 0; i < batch.GetSize(); i++) {
+      const uint32_t row = batch.GetSelection()[i];
+      for (uint32_t col = 0; col < columns_.size(); col++) {
+        columns_[col].push_back(batch.GetValue(col, row));
+      }
+      hashes_.push_back(hashes[i]);
+    }
+  }
+
+  /** Builds the hash table, once all the rows were added. */
+  void Finish() {
+    size_t num_buckets = 1;
+    while (num_buckets < hashes_.size()) {
+      num_buckets <<= 1;
+    }
+    mask_ = num_buckets - 1;
+    heads_.assign(num_buckets, -1);
+    next_.assign(hashes_.size(), -1);
+    for (size_t i = 0; i < hashes_.size(); i++) {
+      int32_t &head = heads_[hashes_[i] & mask_];
+      next_[i] = head;
+      head = static_cast<int32_t>(i);
+    }
+  }
+
+  /** Calls fn(row) on every row whose keys have the hash. */
+  template <class Fn>
+  void ForEachMatch(hash_t hash, Fn &&fn) const {
+    for (int32_t i = heads_[hash & mask_]; i >= 0; i = next_[i]) {
+      if (hashes_[i] == hash) {
+        fn(static_cast<size_t>(i));
+      }
+    }
+  }
+
+  /** Appends a row to a batch of the schema of the build side. */
+  void AppendTo(size_t row, TupleBatch *batch) const {
+    std::vector<Value> values;
+    values.reserve(columns_.size());
+    for (const auto &column : columns_) {
+      values.push_back(column[row]);
+    }
+    batch->AppendRow(std::move(values));
+  }
+
+ private:
+  std::vector<std::vector<Value>> columns_;
+  std::vector<hash_t> hashes_;
+  std::vector<int32_t> heads_;
+  std::vector<int32_t> next_;
+  size_t mask_{0};
+};
+
+}  // namespace
+
+void PushEngine::Execute(const AbstractPlanNode *plan, const Consumer &consumer) { Produce(plan, consumer); }
+
+void PushEngine::Execute(const AbstractPlanNode *plan, std::vector<Tuple> *result) {
+  Produce(plan, [result](TupleBatch *batch) {
+    for (uint32_t row : batch->GetSelection()) {
+      result->push_back(batch->GetTuple(row));
+    }
+  });
+}
+
+void PushEngine::Produce(const AbstractPlanNode *plan, const Consumer &consumer) {
+  switch (plan->GetType()) {
+    case PlanType::HashJoin:
+      ProduceHashJoin(dynamic_cast<const HashJoinPlanNode *>(plan), consumer);
+      break;
+    case PlanType::Aggregation:
+      ProduceAggregation(dynamic_cast<const AggregationPlanNode *>(plan), consumer);
+      break;
+    case PlanType::Insert:
+      ProduceInsert(dynamic_cast<const InsertPlanNode *>(plan));
+      break;
+    default:
+      ProduceExecutor(plan, consumer);
+      break;
+  }
+}
+
+void PushEngine::ProduceExecutor(const AbstractPlanNode *plan, const Consumer &consumer) {
+  auto executor = ExecutorFactory::CreateExecutor(exec_ctx_, plan);
+  executor->Init();
+  TupleBatch batch;
+  while (executor->NextBatch(&batch)) {
+    consumer(&batch);
+  }
+}
+
+void PushEngine::ProduceHashJoin(const HashJoinPlanNode *plan, const Consumer &consumer) {
+  const Schema *left_schema = plan->GetLeftPlan()->OutputSchema();
+  const Schema *right_schema = plan->GetRightPlan()->OutputSchema();
+  const Schema *output_schema = plan->OutputSchema();
+  const AbstractExpression *predicate = plan->Predicate();
+
+  // The pipeline of the left side ends in the build of the hash table.
+  JoinBuildSide build(left_schema);
+  std::vector<hash_t> hashes;
+  Produce(plan->GetLeftPlan(), [&](TupleBatch *batch) {
+    JoinFilter::HashKeys(*batch, plan->GetLeftKeys(), &hashes);
+    build.Add(*batch, hashes);
+  });
+  build.Finish();
+
+  // The probe is fused into the pipeline of the right side: the matches of a batch are gathered into a pair of
+  // batches, row i of the one joining with row i of the other, on which the predicate and the output are evaluated.
+  TupleBatch left_rows(left_schema);
+  TupleBatch right_rows(right_schema);
+  TupleBatch output;
+  std::vector<Value> predicate_values;
+  auto flush = [&]() {
+    if (left_rows.IsEmpty()) {
+      return;
+    }
+    if (predicate != nullptr) {
+      predicate->EvaluateJoinBatch(left_rows, right_rows, &predicate_values);
+      left_rows.Filter([&predicate_values](size_t i) { return predicate_values[i].GetAs<bool>(); });
+      right_rows.Filter([&predicate_values](size_t i) { return predicate_values[i].GetAs<bool>(); });
+    }
+    std::vector<std::vector<Value>> columns(output_schema->GetColumnCount());
+    for (uint32_t i = 0; i < columns.size(); i++) {
+      output_schema->GetColumn(i).GetExpr()->EvaluateJoinBatch(left_rows, right_rows, &columns[i]);
+    }
+    output.Reset(output_schema);
+    output.Assign(std::move(columns), left_rows.GetSize());
+    left_rows.Clear();
+    right_rows.Clear();
+    if (!output.IsEmpty()) {
+      consumer(&output);
+    }
+  };
+  Produce(plan->GetRightPlan(), [&](TupleBatch *batch) {
+    JoinFilter::HashKeys(*batch, plan->GetRightKeys(), &hashes);
+    for (size_t i = 0; i < batch->GetSize(); i++) {
+      const uint32_t row = batch->GetSelection()[i];
+      build.ForEachMatch(hashes[i], [&](size_t build_row) {
+        build.AppendTo(build_row, &left_rows);
+        std::vector<Value> values;
+        values.reserve(right_schema->GetColumnCount());
+        for (uint32_t col = 0; col < right_schema->GetColumnCount(); col++) {
+          values.push_back(batch->GetValue(col, row));
+        }
+        right_rows.AppendRow(std::move(values));
+        if (left_rows.IsFull()) {
+          flush();
+        }
+      });
+    }
+  });
+  flush();
+}
+
+void PushEngine::ProduceAggregation(const AggregationPlanNode *plan, const Consumer &consumer) {
+  // The pipeline of the child ends in the hash table.
+  SimpleAggregationHashTable aht(plan->GetAggregates(), plan->GetAggregateTypes());
+  Produce(plan->GetChildPlan(), [&](TupleBatch *batch) { aht.InsertCombineBatch(*batch, plan->GetGroupBys()); });
+  aht.Finish();
+
+  const Schema *output_schema = plan->OutputSchema();
+  const AbstractExpression *having = plan->GetHaving();
+  TupleBatch output(output_schema);
+  for (auto it = aht.Begin(); it != aht.End(); ++it) {
+    const std::vector<Value> &group_bys = it.Key().group_bys_;
+    const std::vector<Value> &aggregates = it.Val().aggregates_;
+    if (having != nullptr && !having->EvaluateAggregate(group_bys, aggregates).GetAs<bool>()) {
+      continue;
+    }
+    std::vector<Value> values;
+    values.reserve(output_schema->GetColumnCount());
+    for (const auto &column : output_schema->GetColumns()) {
+      values.emplace_back(column.GetExpr()->EvaluateAggregate(group_bys, aggregates));
+    }
+    output.AppendRow(std::move(values));
+    if (output.IsFull()) {
+      consumer(&output);
+      output.Reset(output_schema);
+    }
+  }
+  if (!output.IsEmpty()) {
+    consumer(&output);
+  }
+}
+
+void PushEngine::ProduceInsert(const InsertPlanNode *plan) {
+  TableMetadata *table_info = exec_ctx_->GetCatalog()->GetTable(plan->TableOid());
+  const Schema *schema = &table_info->schema_;
+  Transaction *txn = exec_ctx_->GetTransaction();
+  RID rid;
+  if (plan->IsRawInsert()) {
+    for (const auto &values : plan->RawValues()) {
+      Tuple tuple(values, schema);
+      table_info->TableOf(tuple)->table_->InsertTuple(tuple, &rid, txn);
+    }
+    return;
+  }
+  Produce(plan->GetChildPlan(), [&](TupleBatch *batch) {
+    for (uint32_t row : batch->GetSelection()) {
+      std::vector<Value> values;
+      values.reserve(schema->GetColumnCount());
+      for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+        values.push_back(batch->GetValue(i, row));
+      }
+      Tuple tuple(values, schema);
+      table_info->TableOf(tuple)->table_->InsertTuple(tuple, &rid, txn);
+    }
+  });
+}
+
+}  // namespace bustub
@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// radix_join.cpp
+//
+// Identification: src/execution/radix_join.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/radix_join.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace bustub {
+
+namespace {
+
+// the rows that fill a cache line, the unit in which a scatter writes its output
+constexpr size_t ROWS_PER_LINE = 64 / sizeof(RadixJoin::Row);
+
+}  // namespace
+
+void RadixJoin::Build(std::vector<Row> rows) {
+  radix_bits_ = 0;
+  while ((rows.size() >> radix_bits_) > partition_rows_ && radix_bits_ < 2 * HASH_JOIN_RADIX_BITS_PER_PASS) {
+    radix_bits_++;
+  }
+  PartitionRows(&rows, &build_offsets_);
+  build_rows_ = std::move(rows);
+
+  // A table with twice as many buckets as rows keeps the chains short.
+  const size_t num_partitions = GetNumPartitions();
+  bucket_offsets_.assign(num_partitions + 1, 0);
+  for (size_t p = 0; p < num_partitions; p++) {
+    size_t num_buckets = 1;
+    while (num_buckets < 2 * (build_offsets_[p + 1] - build_offsets_[p])) {
+      num_buckets *= 2;
+    }
+    bucket_offsets_[p + 1] = bucket_offsets_[p] + num_buckets;
+  }
+  heads_.assign(bucket_offsets_.back(), -1);
+  next_.assign(build_rows_.size(), -1);
+  std::atomic<size_t> next_partition{0};
+  RunWorkers([&](size_t worker) {
+    for (size_t p = next_partition++; p < num_partitions; p = next_partition++) {
+      const size_t begin = build_offsets_[p];
+      const size_t mask = bucket_offsets_[p + 1] - bucket_offsets_[p] - 1;
+      int32_t *heads = &heads_[bucket_offsets_[p]];
+      for (size_t i = begin; i < build_offsets_[p + 1]; i++) {
+        int32_t &head = heads[build_rows_[i].hash_ & mask];
+        next_[i] = head;
+        head = static_cast<int32_t>(i - begin);
+      }
+    }
+  });
+}
+
+void RadixJoin::PartitionRows(std::vector<Row> *rows, std::vector<size_t> *offsets) const {
+  if (radix_bits_ == 0) {
+    *offsets = {0, rows->size()};
+    return;
+  }
+  std::vector<Row> scratch(rows->size());
+  const int first_bits = std::min(radix_bits_, HASH_JOIN_RADIX_BITS_PER_PASS);
+  std::vector<size_t> first_offsets;
+  Scatter(rows->data(), scratch.data(), 0, rows->size(), 64 - first_bits, first_bits, num_threads_, &first_offsets);
+  const int second_bits = radix_bits_ - first_bits;
+  if (second_bits == 0) {
+    *rows = std::move(scratch);
+    *offsets = std::move(first_offsets);
+    return;
+  }
+
+  // The second pass splits each partition of the first on its own, one worker per partition, back into rows.
+  const size_t first_partitions = first_offsets.size() - 1;
+  const size_t fanout = static_cast<size_t>(1) << second_bits;
+  offsets->assign(GetNumPartitions() + 1, rows->size());
+  std::atomic<size_t> next_partition{0};
+  RunWorkers([&](size_t worker) {
+    std::vector<size_t> second_offsets;
+    for (size_t p = next_partition++; p < first_partitions; p = next_partition++) {
+      Scatter(scratch.data(), rows->data(), first_offsets[p], first_offsets[p + 1], 64 - radix_bits_, second_bits, 1,
+              &second_offsets);
+      std::copy(second_offsets.begin(), second_offsets.begin() + fanout, offsets->begin() + p * fanout);
+    }
+  });
+}
+
+void RadixJoin::Scatter(const Row *in, Row *out, size_t begin, size_t end, int shift, int bits, size_t num_workers,
+                        std::vector<size_t> *offsets) const {
+  const size_t fanout = static_cast<size_t>(1) << bits;
+  const size_t mask = fanout - 1;
+  const size_t num_rows = end - begin;
+  auto share_begin = [&](size_t worker) { return begin + num_rows * worker / num_workers; };
+
+  // 1. count the rows of every worker per partition
+  std::vector<std::vector<size_t>> counts(num_workers, std::vector<size_t>(fanout, 0));
+  auto count = [&](size_t worker) {
+    for (size_t i = share_begin(worker); i < share_begin(worker + 1); i++) {
+      counts[worker][(in[i].hash_ >> shift) & mask]++;
+    }
+  };
+
+  // 2. every worker writes its rows of a partition after those of the workers before it
+  offsets->assign(fanout + 1, 0);
+  std::vector<std::vector<size_t>> positions(num_workers, std::vector<size_t>(fanout, 0));
+  auto place = [&]() {
+    size_t position = begin;
+    for (size_t p = 0; p < fanout; p++) {
+      (*offsets)[p] = position;
+      for (size_t worker = 0; worker < num_workers; worker++) {
+        positions[worker][p] = position;
+        position += counts[worker][p];
+      }
+    }
+    (*offsets)[fanout] = position;
+  };
+
+  // 3. scatter through a line of rows per partition
+  auto scatter = [&](size_t worker) {
+    std::vector<Row> lines(fanout * ROWS_PER_LINE);
+    std::vector<uint8_t> filled(fanout, 0);
+    std::vector<size_t> &position = positions[worker];
+    for (size_t i = share_begin(worker); i < share_begin(worker + 1); i++) {
+      const size_t p = (in[i].hash_ >> shift) & mask;
+      Row *line = &lines[p * ROWS_PER_LINE];
+      line[filled[p]++] = in[i];
+      if (filled[p] == ROWS_PER_LINE) {
+        memcpy(&out[position[p]], line, sizeof(Row) * ROWS_PER_LINE);
+        position[p] += ROWS_PER_LINE;
+        filled[p] = 0;
+      }
+    }
+    for (size_t p = 0; p < fanout; p++) {
+      memcpy(&out[position[p]], &lines[p * ROWS_PER_LINE], sizeof(Row) * filled[p]);
+    }
+  };
+
+  if (num_workers == 1) {
+    count(0);
+    place();
+    scatter(0);
+    return;
+  }
+  RunWorkers([&](size_t worker) {
+    if (worker < num_workers) {
+      count(worker);
+    }
+  });
+  place();
+  RunWorkers([&](size_t worker) {
+    if (worker < num_workers) {
+      scatter(worker);
+    }
+  });
+}
+
+}  // namespace bustub
@@ -0,0 +1,189 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// result_cache.cpp
+//
+// Identification: src/execution/result_cache.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/result_cache.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "execution/plans/fetch_plan.h"
+#include "execution/plans/index_nested_loop_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "type/type.h"
+
+namespace bustub {
+
+namespace {
+
+/**
+ * Adds the heaps of a table to the tables that a plan reads, once each.
+ * @return false if the table is of the LSM layout, whose rows are not in its heap
+ */
+bool AddTable(SimpleCatalog *catalog, table_oid_t oid, std::vector<TableHeap *> *tables) {
+  TableMetadata *table_info = catalog->GetTable(oid);
+  if (table_info->lsm_ != nullptr) {
+    return false;
+  }
+  auto add = [tables](TableHeap *heap) {
+    if (std::find(tables->begin(), tables->end(), heap) == tables->end()) {
+      tables->push_back(heap);
+    }
+  };
+  // The heap of a partitioned table has no rows, the writes go to the heaps of its partitions.
+  if (table_info->partitioning_ == nullptr) {
+    add(table_info->table_.get());
+  }
+  for (TableMetadata *partition : table_info->partitions_) {
+    add(partition->table_.get());
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ResultCache::CollectTables(const AbstractPlanNode *plan, SimpleCatalog *catalog,
+                                std::vector<TableHeap *> *tables) {
+  bool cacheable = true;
+  switch (plan->GetType()) {
+    case PlanType::SeqScan:
+      cacheable = AddTable(catalog, static_cast<const SeqScanPlanNode *>(plan)->GetTableOid(), tables);
+      break;
+    case PlanType::IndexScan:
+      cacheable = AddTable(catalog, static_cast<const IndexScanPlanNode *>(plan)->GetTableOid(), tables);
+      break;
+    case PlanType::IndexNestedLoopJoin:
+      cacheable =
+          AddTable(catalog, static_cast<const IndexNestedLoopJoinPlanNode *>(plan)->GetInnerTableOid(), tables);
+      break;
+    case PlanType::Fetch:
+      for (const FetchSource &source : static_cast<const FetchPlanNode *>(plan)->GetSources()) {
+        cacheable = cacheable && AddTable(catalog, source.table_oid_, tables);
+      }
+      break;
+    case PlanType::Insert:
+      return false;
+    default:
+      // The other plans read their children only. An aggregation that reads a view still has the scan of its table.
+      break;
+  }
+  if (!cacheable) {
+    return false;
+  }
+  for (const AbstractPlanNode *child : plan->GetChildren()) {
+    if (!CollectTables(child, catalog, tables)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string ResultCache::KeyOf(const PreparedPlan *plan, const std::vector<Value> &params) {
+  std::string key = plan->GetSignature();
+  // The bytes of the values, rather than their text, tell apart the values that print alike, e.g. close decimals.
+  for (const Value &value : params) {
+    key.push_back(static_cast<char>(value.GetTypeId()));
+    if (value.IsNull()) {
+      key.push_back('n');
+      continue;
+    }
+    key.push_back('v');
+    const size_t size = value.GetTypeId() == TypeId::VARCHAR ? sizeof(uint32_t) + value.GetLength()
+                                                             : Type::GetTypeSize(value.GetTypeId());
+    std::string bytes(size, '\0');
+    value.SerializeTo(bytes.data());
+    key += bytes;
+  }
+  return key;
+}
+
+bool ResultCache::IsCurrent(const Entry &entry) {
+  return std::all_of(entry.tables_.begin(), entry.tables_.end(),
+                     [](const auto &table) { return table.first->GetLastModifiedLsn() == table.second; });
+}
+
+void ResultCache::Erase(std::list<Entry>::iterator entry) {
+  num_bytes_ -= entry->bytes_;
+  keys_.erase(entry->key_);
+  entries_.erase(entry);
+}
+
+bool ResultCache::Execute(PreparedPlan *plan, const std::vector<Value> &params, std::vector<Tuple> *result) {
+  ExecutorContext *exec_ctx = plan->GetExecutorContext();
+  BUSTUB_ASSERT(exec_ctx != nullptr, "A plan is prepared before it is executed.");
+  Transaction *txn = exec_ctx->GetTransaction();
+  std::vector<TableHeap *> tables;
+  bool cacheable = Locks(txn) && CollectTables(plan->GetRoot(), exec_ctx->GetCatalog(), &tables);
+  for (const auto &item : *txn->GetWriteSet()) {
+    cacheable = cacheable && std::find(tables.begin(), tables.end(), item.table_) == tables.end();
+  }
+  // The locks are taken before the latch, and held until the transaction ends, so that no writer changes the tables
+  // between the check of their LSNs and the end of the transaction.
+  for (TableHeap *table : tables) {
+    cacheable = cacheable && table->LockTable(txn, LockMode::SHARED);
+  }
+  if (!cacheable) {
+    plan->Execute(params, result);
+    return false;
+  }
+
+  Entry entry;
+  entry.key_ = KeyOf(plan, params);
+  {
+    std::scoped_lock lock(latch_);
+    auto it = keys_.find(entry.key_);
+    if (it != keys_.end()) {
+      if (IsCurrent(*it->second)) {
+        num_hits_++;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        *result = entries_.front().tuples_;
+        return true;
+      }
+      Erase(it->second);
+    }
+    num_misses_++;
+  }
+
+  // The LSNs are read before the plan runs: a change that it may or may not have seen moves them on past the entry.
+  for (TableHeap *table : tables) {
+    entry.tables_.emplace_back(table, table->GetLastModifiedLsn());
+  }
+  plan->Execute(params, result);
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return false;
+  }
+  for (const Tuple &tuple : *result) {
+    entry.bytes_ += tuple.GetLength();
+  }
+  if (entry.bytes_ > max_bytes_) {
+    return false;
+  }
+  entry.tuples_ = *result;
+
+  std::scoped_lock lock(latch_);
+  // Another session may have kept the same result meanwhile, which this one replaces.
+  if (auto it = keys_.find(entry.key_); it != keys_.end()) {
+    Erase(it->second);
+  }
+  num_bytes_ += entry.bytes_;
+  entries_.push_front(std::move(entry));
+  keys_.emplace(entries_.front().key_, entries_.begin());
+  while (num_bytes_ > max_bytes_) {
+    Erase(std::prev(entries_.end()));
+  }
+  return false;
+}
+
+}  // namespace bustub
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// result_sink.cpp
+//
+// Identification: src/execution/result_sink.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/result_sink.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "common/util/tracer.h"
+#include "concurrency/transaction.h"
+
+namespace bustub {
+
+bool ResultSink::Drain(AbstractExecutor *executor) {
+  Transaction *txn = executor->GetExecutorContext()->GetTransaction();
+  TraceScope trace(txn != nullptr && txn->IsTraced() ? txn->GetTransactionId() : INVALID_TXN_ID, "execute");
+  TupleBatch batch;
+  try {
+    executor->Init();
+    while (executor->NextBatch(&batch)) {
+      if (!Consume(&batch)) {
+        executor->Stop();
+        Finish();
+        return false;
+      }
+    }
+  } catch (...) {
+    Finish();
+    throw;
+  }
+  Finish();
+  return true;
+}
+
+bool ResultQueue::Consume(TupleBatch *batch) {
+  std::unique_lock<std::mutex> lock(latch_);
+  not_full_.wait(lock, [&] { return cancelled_ || batches_.size() < capacity_; });
+  if (cancelled_) {
+    return false;
+  }
+  batches_.push_back(std::move(*batch));
+  peak_size_ = std::max(peak_size_, batches_.size());
+  not_empty_.notify_one();
+  return true;
+}
+
+void ResultQueue::Finish() {
+  std::scoped_lock lock(latch_);
+  finished_ = true;
+  not_empty_.notify_all();
+}
+
+bool ResultQueue::Pop(TupleBatch *batch) {
+  std::unique_lock<std::mutex> lock(latch_);
+  not_empty_.wait(lock, [&] { return finished_ || cancelled_ || !batches_.empty(); });
+  if (batches_.empty()) {
+    return false;
+  }
+  *batch = std::move(batches_.front());
+  batches_.pop_front();
+  not_full_.notify_one();
+  return true;
+}
+
+void ResultQueue::Cancel() {
+  std::scoped_lock lock(latch_);
+  cancelled_ = true;
+  batches_.clear();
+  not_full_.notify_all();
+  not_empty_.notify_all();
+}
+
+size_t ResultQueue::GetPeakSize() const {
+  std::scoped_lock lock(latch_);
+  return peak_size_;
+}
+
+}  // namespace bustub
@@ -1,22 +1,520 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// seq_scan_executor.cpp
-//
-// Identification: src/execution/seq_scan_executor.cpp
-//
-// Copyright (c) 2015-19, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include "execution/executors/seq_scan_executor.h"
-
-namespace bustub {
-
-SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : AbstractExecutor(exec_ctx) {}
-
-void SeqScanExecutor::Init() {}
-
-bool SeqScanExecutor::Next(Tuple *tuple) { return false; }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// seq_scan_executor.cpp
+//
+// Identification: src/execution/seq_scan_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/seq_scan_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/row_id_expression.h"
+
+namespace bustub {
+
+namespace {
+
+/** Marks the columns that an expression reads. */
+void MarkColumns(const AbstractExpression *expr, std::vector<bool> *read) {
+  if (auto column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+    (*read)[column->GetColIdx()] = true;
+  }
+  for (const AbstractExpression *child : expr->GetChildren()) {
+    MarkColumns(child, read);
+  }
+}
+
+/** @return true if an expression reads the rids of the tuples, see RowIdExpression */
+bool ReadsRids(const AbstractExpression *expr) {
+  if (dynamic_cast<const RowIdExpression *>(expr) != nullptr) {
+    return true;
+  }
+  return std::any_of(expr->GetChildren().begin(), expr->GetChildren().end(), ReadsRids);
+}
+
+/** @return the comparison that holds for b and a if another holds for a and b */
+ComparisonType Flip(ComparisonType type) {
+  switch (type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return type;
+  }
+}
+
+/** @return false if no value of a zone passes a comparison with a constant */
+bool ZoneMayMatch(const ColumnZone &zone, ComparisonType type, const Value &constant) {
+  // A null passes no comparison, so neither does a page of nulls only.
+  if (!zone.has_values_) {
+    return false;
+  }
+  auto holds = [](CmpBool result) { return result == CmpBool::CmpTrue; };
+  switch (type) {
+    case ComparisonType::Equal:
+      return holds(zone.min_.CompareLessThanEquals(constant)) && holds(zone.max_.CompareGreaterThanEquals(constant));
+    case ComparisonType::NotEqual:
+      return !holds(zone.min_.CompareEquals(constant)) || !holds(zone.max_.CompareEquals(constant));
+    case ComparisonType::LessThan:
+      return holds(zone.min_.CompareLessThan(constant));
+    case ComparisonType::LessThanOrEqual:
+      return holds(zone.min_.CompareLessThanEquals(constant));
+    case ComparisonType::GreaterThan:
+      return holds(zone.max_.CompareGreaterThan(constant));
+    case ComparisonType::GreaterThanOrEqual:
+      return holds(zone.max_.CompareGreaterThanEquals(constant));
+  }
+  return true;
+}
+
+}  // namespace
+
+SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan)
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void SeqScanExecutor::Init() {
+  table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
+  tables_.clear();
+  kept_partitions_.clear();
+  if (table_info_->partitioning_ != nullptr) {
+    kept_partitions_ = table_info_->partitioning_->Prune(plan_->GetPredicate());
+    for (size_t i = 0; i < kept_partitions_.size(); i++) {
+      if (kept_partitions_[i]) {
+        tables_.push_back(table_info_->partitions_[i]);
+      }
+    }
+  } else {
+    tables_.push_back(table_info_);
+  }
+  // One lock on the table instead of one on every row that the scan reads. A snapshot reads without any locks, so that
+  // it never blocks the writers of the table.
+  if (!exec_ctx_->GetTransaction()->IsSnapshot()) {
+    for (TableMetadata *table : tables_) {
+      table->table_->LockTable(exec_ctx_->GetTransaction(), LockMode::SHARED);
+    }
+  }
+  // An optimistic transaction records its reads, which only one thread may do.
+  morsels_.reset();
+  parallel_batches_.clear();
+  parallel_index_ = 0;
+  ResetNextFromBatch();
+  in_place_ = std::all_of(tables_.begin(), tables_.end(), [this](TableMetadata *table) {
+    return table->table_->ReadsInPlace(exec_ctx_->GetTransaction());
+  });
+  columnar_ = in_place_ && table_info_->table_->GetLayout() == TableLayout::COLUMNAR;
+  // The tuples of a columnar table are not read as rows, the predicate is tested on their column arrays if it compiles
+  // into a kernel, and evaluated on the batch otherwise.
+  compiled_predicate_.reset();
+  filter_kernel_.reset();
+  if (plan_->GetPredicate() != nullptr && !columnar_) {
+    compiled_predicate_ = CompiledPredicate::Compile(plan_->GetPredicate(), &table_info_->schema_);
+  }
+  if (plan_->GetPredicate() != nullptr && columnar_) {
+    filter_kernel_ = FilterKernel::Compile(plan_->GetPredicate(), &table_info_->schema_, table_info_->table_.get());
+  }
+  UpdateReadColumns();
+  UpdateZoneFilter();
+  lsm_iter_.reset();
+  if (table_info_->lsm_ != nullptr) {
+    lsm_iter_ = std::make_unique<LsmTable::Iterator>(table_info_->lsm_->Begin());
+    return;
+  }
+  if (exec_ctx_->GetParallelism() > 1 && !exec_ctx_->GetTransaction()->IsOptimistic()) {
+    std::vector<TableHeap *> heaps;
+    for (TableMetadata *table : tables_) {
+      heaps.push_back(table->table_.get());
+    }
+    morsels_ = std::make_unique<MorselQueue>(heaps);
+    return;
+  }
+  // Like a table that is larger than a quarter of the buffer pool, a scan that has fetched that many pages starts
+  // recycling a small ring of frames instead of evicting everybody else's pages.
+  const size_t activation_threshold = exec_ctx_->GetBufferPoolManager()->GetPoolSize() / 4;
+  const size_t ring_size = std::min(static_cast<size_t>(SCAN_RING_SIZE), activation_threshold);
+  if (ring_size > 1) {
+    ring_ = std::make_unique<BufferRing>(ring_size, activation_threshold);
+  }
+  table_idx_ = 0;
+  OpenTable();
+}
+
+void SeqScanExecutor::OpenTable() {
+  iter_.reset();
+  page_id_ = INVALID_PAGE_ID;
+  if (table_idx_ >= tables_.size()) {
+    return;
+  }
+  TableHeap *table = tables_[table_idx_]->table_.get();
+  if (in_place_) {
+    page_id_ = table->GetFirstPageId();
+    return;
+  }
+  iter_ = std::make_unique<TableIterator>(table->Begin(exec_ctx_->GetTransaction(), ring_.get()));
+}
+
+void SeqScanExecutor::Stop() {
+  iter_.reset();
+  lsm_iter_.reset();
+  ring_.reset();
+  page_id_ = INVALID_PAGE_ID;
+  table_idx_ = tables_.size();
+  morsels_.reset();
+  parallel_batches_.clear();
+  parallel_index_ = 0;
+  table_batch_.Clear();
+  ResetNextFromBatch();
+}
+
+void SeqScanExecutor::UpdateReadColumns() {
+  std::vector<bool> read(table_info_->schema_.GetColumnCount(), false);
+  read_rids_ = false;
+  for (const Column &column : GetOutputSchema()->GetColumns()) {
+    MarkColumns(column.GetExpr(), &read);
+    read_rids_ = read_rids_ || ReadsRids(column.GetExpr());
+  }
+  if (plan_->GetPredicate() != nullptr && !IsPredicateApplied()) {
+    MarkColumns(plan_->GetPredicate(), &read);
+    read_rids_ = read_rids_ || ReadsRids(plan_->GetPredicate());
+  }
+  for (const AbstractExpression *key : join_filter_keys_) {
+    MarkColumns(key, &read);
+  }
+  read_columns_.clear();
+  for (uint32_t i = 0; i < read.size(); i++) {
+    if (read[i]) {
+      read_columns_.push_back(i);
+    }
+  }
+  table_batch_.KeepRids(read_rids_);
+}
+
+void SeqScanExecutor::ReadColumns(ColumnarTablePage *page, uint32_t num_tuples, TupleBatch *table_batch) const {
+  const TableHeap *table = table_info_->table_.get();
+  const Schema &schema = *table->GetColumnarSchema();
+  // Appends the values of a column of the rows that for_each_row visits. The codes of a dictionary encoded column are
+  // decoded into views of the strings of its dictionary.
+  auto read_column = [&](uint32_t col_idx, std::vector<Value> *column, auto &&for_each_row) {
+    const char *data = page->GetColumnData(schema, col_idx);
+    const TypeId type = schema.GetColumn(col_idx).GetType();
+    const uint32_t width = schema.GetColumn(col_idx).GetFixedLength();
+    if (const ColumnDictionary *dictionary = table->GetDictionary(col_idx); dictionary != nullptr) {
+      for_each_row([&](uint32_t i) {
+        int32_t code;
+        memcpy(&code, data + i * width, sizeof(int32_t));
+        column->push_back(dictionary->Decode(code));
+      });
+      return;
+    }
+    for_each_row([&](uint32_t i) { column->push_back(Value::DeserializeFrom(data + i * width, type)); });
+  };
+  if (filter_kernel_ == nullptr) {
+    auto for_each_tuple = [num_tuples](auto &&fn) {
+      for (uint32_t i = 0; i < num_tuples; i++) {
+        fn(i);
+      }
+    };
+    table_batch->AppendColumnValues(
+        read_columns_, num_tuples,
+        [&](uint32_t col_idx, std::vector<Value> *column) { read_column(col_idx, column, for_each_tuple); },
+        [&](std::vector<RID> *rids) {
+          for_each_tuple([&](uint32_t i) { rids->emplace_back(page->GetTablePageId(), i); });
+        });
+    return;
+  }
+  // Only the tuples that pass the kernel are taken out of the arrays.
+  std::vector<uint64_t> mask((num_tuples + 63) / 64);
+  const size_t num_passed =
+      filter_kernel_->Filter(page->GetColumnData(schema, filter_kernel_->GetColIdx()), num_tuples, mask.data());
+  auto for_each_passed = [&mask](auto &&fn) {
+    for (size_t w = 0; w < mask.size(); w++) {
+      for (uint64_t bits = mask[w]; bits != 0; bits &= bits - 1) {
+        fn(static_cast<uint32_t>(w * 64 + __builtin_ctzll(bits)));
+      }
+    }
+  };
+  table_batch->AppendColumnValues(
+      read_columns_, num_passed,
+      [&](uint32_t col_idx, std::vector<Value> *column) { read_column(col_idx, column, for_each_passed); },
+      [&](std::vector<RID> *rids) {
+        for_each_passed([&](uint32_t i) { rids->emplace_back(page->GetTablePageId(), i); });
+      });
+}
+
+void SeqScanExecutor::UpdateZoneFilter() {
+  zone_col_idx_ = -1;
+  const ZoneMap *zone_map = table_info_->table_->GetZoneMap();
+  auto comparison = dynamic_cast<const ComparisonExpression *>(plan_->GetPredicate());
+  if (zone_map == nullptr || comparison == nullptr) {
+    return;
+  }
+  ComparisonType type = comparison->GetComparisonType();
+  auto column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  auto constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  if (column == nullptr) {
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+    constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+    type = Flip(type);
+  }
+  if (column == nullptr || constant == nullptr || !zone_map->IsTracked(column->GetColIdx())) {
+    return;
+  }
+  // The zones are numbers, which compare with numbers only.
+  const TypeId constant_type = constant->GetValue().GetTypeId();
+  if (constant->GetValue().IsNull() || constant_type < TypeId::TINYINT || constant_type > TypeId::DECIMAL) {
+    return;
+  }
+  zone_col_idx_ = column->GetColIdx();
+  zone_cmp_ = type;
+  zone_constant_ = constant->GetValue();
+}
+
+bool SeqScanExecutor::SkipPage(const TableHeap *table, page_id_t page_id, page_id_t *next_page_id) const {
+  if (zone_col_idx_ < 0) {
+    return false;
+  }
+  ColumnZone zone;
+  page_id_t zone_next_page_id;
+  if (!table->GetZoneMap()->GetZone(page_id, zone_col_idx_, &zone, &zone_next_page_id) ||
+      ZoneMayMatch(zone, zone_cmp_, zone_constant_)) {
+    return false;
+  }
+  *next_page_id = zone_next_page_id;
+  return true;
+}
+
+bool SeqScanExecutor::PushJoinFilter(const JoinFilter *filter, const std::vector<const AbstractExpression *> &keys) {
+  std::vector<const AbstractExpression *> table_keys;
+  for (const AbstractExpression *key : keys) {
+    auto column = dynamic_cast<const ColumnValueExpression *>(key);
+    if (column == nullptr) {
+      return false;
+    }
+    table_keys.push_back(GetOutputSchema()->GetColumn(column->GetColIdx()).GetExpr());
+  }
+  join_filter_ = filter;
+  join_filter_keys_ = std::move(table_keys);
+  // Before Init(), which works them out anyway, the table is not known yet.
+  if (table_info_ != nullptr) {
+    UpdateReadColumns();
+  }
+  return true;
+}
+
+void SeqScanExecutor::FilterAndProject(TupleBatch *table_batch, TupleBatch *batch) const {
+  const Schema *output_schema = plan_->OutputSchema();
+  const AbstractExpression *predicate = plan_->GetPredicate();
+  if (predicate != nullptr && !IsPredicateApplied()) {
+    std::vector<Value> predicate_values;
+    predicate->EvaluateBatch(*table_batch, &predicate_values);
+    // A predicate that is null, i.e. compares a null, does not hold.
+    table_batch->Filter([&predicate_values](size_t i) {
+      return !predicate_values[i].IsNull() && predicate_values[i].GetAs<bool>();
+    });
+  }
+  if (join_filter_ != nullptr) {
+    std::vector<hash_t> key_hashes;
+    JoinFilter::HashKeys(*table_batch, join_filter_keys_, &key_hashes);
+    table_batch->Filter([this, &key_hashes](size_t i) { return join_filter_->MayContain(key_hashes[i]); });
+  }
+  std::vector<std::vector<Value>> columns(output_schema->GetColumnCount());
+  for (uint32_t i = 0; i < columns.size(); i++) {
+    output_schema->GetColumn(i).GetExpr()->EvaluateBatch(*table_batch, &columns[i]);
+  }
+  batch->Reset(output_schema);
+  batch->Assign(std::move(columns), table_batch->GetSize());
+}
+
+bool SeqScanExecutor::NextBatch(TupleBatch *batch) {
+  if (lsm_iter_ != nullptr) {
+    return NextLsmBatch(batch);
+  }
+  if (morsels_ != nullptr) {
+    return NextParallelBatch(batch);
+  }
+  if (in_place_) {
+    return NextInPlaceBatch(batch);
+  }
+  batch->Reset(GetOutputSchema());
+  while (batch->IsEmpty() && table_idx_ < tables_.size()) {
+    table_batch_.Reset(&table_info_->schema_);
+    while (table_idx_ < tables_.size() && !table_batch_.IsFull()) {
+      const TableIterator end = tables_[table_idx_]->table_->End();
+      for (; *iter_ != end && !table_batch_.IsFull(); ++(*iter_)) {
+        ReadTuple(**iter_, &table_batch_);
+      }
+      if (*iter_ == end) {
+        table_idx_++;
+        OpenTable();
+      }
+    }
+    FilterAndProject(&table_batch_, batch);
+  }
+  return !batch->IsEmpty();
+}
+
+bool SeqScanExecutor::NextLsmBatch(TupleBatch *batch) {
+  batch->Reset(GetOutputSchema());
+  Tuple tuple;
+  bool more = true;
+  while (batch->IsEmpty() && more) {
+    table_batch_.Reset(&table_info_->schema_);
+    while (!table_batch_.IsFull() && (more = lsm_iter_->Next(&tuple))) {
+      ReadTuple(tuple, &table_batch_);
+    }
+    FilterAndProject(&table_batch_, batch);
+  }
+  return !batch->IsEmpty();
+}
+
+bool SeqScanExecutor::NextInPlaceBatch(TupleBatch *batch) {
+  batch->Reset(GetOutputSchema());
+  while (batch->IsEmpty() && table_idx_ < tables_.size()) {
+    table_batch_.Reset(&table_info_->schema_);
+    // The batch takes whole pages, so it may end up a page's worth of tuples over EXECUTOR_BATCH_SIZE.
+    while (table_idx_ < tables_.size() && !table_batch_.IsFull()) {
+      if (page_id_ == INVALID_PAGE_ID) {
+        table_idx_++;
+        OpenTable();
+        continue;
+      }
+      TableHeap *table = tables_[table_idx_]->table_.get();
+      if (SkipPage(table, page_id_, &page_id_)) {
+        continue;
+      }
+      if (!ReadPageInPlace(table, page_id_, ring_.get(), &page_id_, &table_batch_, [] {})) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for a page of a scan.");
+      }
+    }
+    FilterAndProject(&table_batch_, batch);
+  }
+  return !batch->IsEmpty();
+}
+
+bool SeqScanExecutor::NextParallelBatch(TupleBatch *batch) {
+  while (parallel_index_ >= parallel_batches_.size()) {
+    parallel_batches_.clear();
+    parallel_index_ = 0;
+    if (morsels_->IsDone()) {
+      batch->Reset(GetOutputSchema());
+      return false;
+    }
+    std::vector<std::vector<TupleBatch>> results(exec_ctx_->GetParallelism());
+    std::atomic<bool> failed{false};
+    exec_ctx_->RunWorkers([&](size_t worker) {
+      size_t table_idx;
+      const std::vector<page_id_t> page_ids = morsels_->Next(&table_idx);
+      if (!page_ids.empty() && !ScanMorsel(tables_[table_idx]->table_.get(), page_ids, &results[worker])) {
+        failed = true;
+      }
+    });
+    if (failed) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for a page of a parallel scan.");
+    }
+    for (auto &result : results) {
+      std::move(result.begin(), result.end(), std::back_inserter(parallel_batches_));
+    }
+  }
+  *batch = std::move(parallel_batches_[parallel_index_++]);
+  return true;
+}
+
+bool SeqScanExecutor::IsPartitionKey(const AbstractExpression *expr) const {
+  const TablePartitioning *partitioning = GetPartitioning();
+  auto column = dynamic_cast<const ColumnValueExpression *>(expr);
+  if (partitioning == nullptr || column == nullptr) {
+    return false;
+  }
+  auto table_column =
+      dynamic_cast<const ColumnValueExpression *>(plan_->OutputSchema()->GetColumn(column->GetColIdx()).GetExpr());
+  return table_column != nullptr && table_column->GetColIdx() == partitioning->GetColIdx();
+}
+
+bool SeqScanExecutor::ScanPartition(size_t partition, std::vector<TupleBatch> *batches) const {
+  if (!kept_partitions_[partition]) {
+    return true;
+  }
+  TableHeap *table = table_info_->partitions_[partition]->table_.get();
+  return ScanMorsel(table, table->GetPageIds(0, std::numeric_limits<size_t>::max()), batches);
+}
+
+bool SeqScanExecutor::ScanMorsel(TableHeap *table, const std::vector<page_id_t> &page_ids,
+                                 std::vector<TupleBatch> *batches) const {
+  TupleBatch table_batch(&table_info_->schema_);
+  table_batch.KeepRids(read_rids_);
+  auto flush = [&]() {
+    TupleBatch batch;
+    FilterAndProject(&table_batch, &batch);
+    if (!batch.IsEmpty()) {
+      batches->push_back(std::move(batch));
+    }
+    table_batch.Clear();
+  };
+  // On a scheduler, the reads of the pages that miss are all started up front, and the worker runs other tasks, e.g.
+  // morsels of other queries, while the read of the page it is at is in flight rather than block in the disk manager.
+  TaskScheduler *scheduler = exec_ctx_->GetScheduler();
+  BufferPoolManager *bpm = exec_ctx_->GetBufferPoolManager();
+  std::vector<page_id_t> read_page_ids;
+  for (page_id_t page_id : page_ids) {
+    page_id_t next_page_id;
+    if (!SkipPage(table, page_id, &next_page_id)) {
+      read_page_ids.push_back(page_id);
+      if (scheduler != nullptr && !bpm->IsPageReady(page_id)) {
+        bpm->PrefetchPages(page_id, 1);
+      }
+    }
+  }
+  std::vector<Tuple> tuples;
+  for (page_id_t page_id : read_page_ids) {
+    page_id_t next_page_id;
+    if (scheduler != nullptr) {
+      scheduler->RunPendingTasksUntil([&] { return bpm->IsPageReady(page_id); });
+    }
+    if (in_place_) {
+      auto on_read = [&]() {
+        if (table_batch.IsFull()) {
+          flush();
+        }
+      };
+      if (!ReadPageInPlace(table, page_id, nullptr, &next_page_id, &table_batch, on_read)) {
+        return false;
+      }
+      continue;
+    }
+    tuples.clear();
+    if (!table->ScanPage(page_id, exec_ctx_->GetTransaction(), &tuples)) {
+      return false;
+    }
+    for (const Tuple &tuple : tuples) {
+      ReadTuple(tuple, &table_batch);
+      if (table_batch.IsFull()) {
+        flush();
+      }
+    }
+  }
+  if (table_batch.GetNumRows() > 0) {
+    flush();
+  }
+  return true;
+}
+
+}  // namespace bustub
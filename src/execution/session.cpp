@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// session.cpp
+//
+// Identification: src/execution/session.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/session.h"
+
+#include <vector>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+Session::Session(BustubInstance *instance, SimpleCatalog *catalog, size_t plan_cache_size)
+    : instance_(instance),
+      catalog_(catalog),
+      exec_ctx_(nullptr, catalog, instance->buffer_pool_manager_),
+      plan_cache_(&exec_ctx_, plan_cache_size) {
+  exec_ctx_.SetScheduler(instance->task_scheduler_);
+}
+
+Session::~Session() { Abort(); }
+
+void Session::Begin(IsolationLevel isolation_level) {
+  if (txn_ != nullptr) {
+    return;
+  }
+  txn_ = instance_->transaction_manager_->Begin(nullptr, isolation_level);
+  exec_ctx_.SetTransaction(txn_);
+}
+
+bool Session::Commit() {
+  if (txn_ == nullptr) {
+    return false;
+  }
+  instance_->transaction_manager_->Commit(txn_);
+  const bool committed = txn_->GetState() == TransactionState::COMMITTED;
+  EndTransaction();
+  return committed;
+}
+
+void Session::Abort() {
+  if (txn_ == nullptr) {
+    return;
+  }
+  instance_->transaction_manager_->Abort(txn_);
+  EndTransaction();
+}
+
+void Session::EndTransaction() {
+  instance_->transaction_manager_->Recycle(txn_);
+  txn_ = nullptr;
+  exec_ctx_.SetTransaction(nullptr);
+}
+
+bool Session::ExecuteBatch(const std::vector<Statement> &statements, std::vector<StatementResult> *results) {
+  results->clear();
+  results->resize(statements.size());
+  const bool own_txn = txn_ == nullptr;
+  Begin();
+  bool aborted = false;
+  for (size_t i = 0; i < statements.size() && !aborted; i++) {
+    StatementResult *result = &(*results)[i];
+    try {
+      if (result_cache_ != nullptr) {
+        result_cache_->Execute(statements[i].plan_, statements[i].params_, &result->tuples_);
+      } else {
+        statements[i].plan_->Execute(statements[i].params_, &result->tuples_);
+      }
+    } catch (const Exception &e) {
+      result->error_ = e.what();
+      txn_->SetState(TransactionState::ABORTED);
+    }
+    aborted = txn_->GetState() == TransactionState::ABORTED;
+    result->status_ = aborted ? StatementStatus::ABORTED : StatementStatus::OK;
+  }
+  if (aborted) {
+    Abort();
+    return false;
+  }
+  return !own_txn || Commit();
+}
+
+}  // namespace bustub
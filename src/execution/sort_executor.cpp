@@ -0,0 +1,146 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor.cpp
+//
+// Identification: src/execution/sort_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/sort_executor.h"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+SortExecutor::SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan,
+                           std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx), plan_(plan), child_(std::move(child)), memory_(exec_ctx->GetMemoryTracker()) {}
+
+bool SortExecutor::RunLess::operator()(size_t a, size_t b) const {
+  if (sort_->done_[a] || sort_->done_[b]) {
+    return !sort_->done_[a] && sort_->done_[b];
+  }
+  const int cmp = sort_->heads_[a].key_.compare(sort_->heads_[b].key_);
+  return cmp < 0 || (cmp == 0 && a < b);
+}
+
+void SortExecutor::Init() {
+  child_->Init();
+  entries_.clear();
+  order_.clear();
+  next_ = 0;
+  entries_bytes_ = 0;
+  memory_.Release();
+  merge_.reset();
+  runs_.clear();
+  cursors_.clear();
+  heads_.clear();
+  done_.clear();
+  ResetNextFromBatch();
+
+  const Schema *schema = child_->GetOutputSchema();
+  const size_t budget = exec_ctx_->GetMemoryBudget() * static_cast<size_t>(PAGE_SIZE);
+  TupleBatch batch;
+  while (child_->NextBatch(&batch)) {
+    for (uint32_t row : batch.GetSelection()) {
+      Tuple tuple = batch.GetTuple(row);
+      std::string key = SortKey::Make(tuple, schema, plan_->GetOrderBy());
+      entries_bytes_ += sizeof(Entry) + sizeof(size_t) + key.size() + tuple.GetLength();
+      entries_.push_back(Entry{std::move(key), std::move(tuple)});
+    }
+    if (entries_bytes_ > budget || !memory_.Resize(entries_bytes_)) {
+      SpillEntries();
+    }
+  }
+  if (runs_.empty()) {
+    SortEntries();
+    return;
+  }
+  SpillEntries();
+  cursors_.resize(runs_.size());
+  heads_.resize(runs_.size());
+  done_.resize(runs_.size());
+  for (size_t run = 0; run < runs_.size(); run++) {
+    AdvanceRun(run);
+  }
+  merge_ = std::make_unique<LoserTree<RunLess>>(runs_.size(), RunLess{this});
+}
+
+void SortExecutor::Stop() {
+  child_->Stop();
+  merge_.reset();
+  runs_.clear();
+  cursors_.clear();
+  heads_.clear();
+  done_.clear();
+  entries_.clear();
+  order_.clear();
+  next_ = 0;
+  memory_.Release();
+  ResetNextFromBatch();
+}
+
+void SortExecutor::SortEntries() {
+  order_.resize(entries_.size());
+  std::iota(order_.begin(), order_.end(), 0);
+  std::stable_sort(order_.begin(), order_.end(),
+                   [this](size_t a, size_t b) { return entries_[a].key_ < entries_[b].key_; });
+  next_ = 0;
+}
+
+void SortExecutor::SpillEntries() {
+  if (entries_.empty()) {
+    return;
+  }
+  SortEntries();
+  std::vector<const Tuple *> tuples;
+  tuples.reserve(order_.size());
+  for (size_t i : order_) {
+    tuples.push_back(&entries_[i].tuple_);
+  }
+  auto run = std::make_unique<TmpTupleRun>(exec_ctx_->GetSpillFileManager());
+  run->AppendInOrder(tuples);
+  run->Finish();
+  runs_.push_back(std::move(run));
+  entries_.clear();
+  order_.clear();
+  entries_bytes_ = 0;
+  memory_.Release();
+}
+
+void SortExecutor::AdvanceRun(size_t run) {
+  Entry &head = heads_[run];
+  done_[run] = !runs_[run]->Read(&cursors_[run], &head.tuple_);
+  if (!done_[run]) {
+    head.key_ = SortKey::Make(head.tuple_, child_->GetOutputSchema(), plan_->GetOrderBy());
+  }
+}
+
+bool SortExecutor::NextBatch(TupleBatch *batch) {
+  batch->Reset(GetOutputSchema());
+  if (merge_ == nullptr) {
+    while (!batch->IsFull() && next_ < order_.size()) {
+      batch->AppendTuple(entries_[order_[next_++]].tuple_);
+    }
+    return !batch->IsEmpty();
+  }
+  while (!batch->IsFull()) {
+    const size_t run = merge_->GetWinner();
+    if (done_[run]) {
+      break;
+    }
+    batch->AppendTuple(heads_[run].tuple_);
+    AdvanceRun(run);
+    merge_->Update();
+  }
+  return !batch->IsEmpty();
+}
+
+}  // namespace bustub
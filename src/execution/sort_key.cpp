@@ -0,0 +1,37 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key.cpp
+//
+// Identification: src/execution/sort_key.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/sort_key.h"
+
+#include <string>
+#include <vector>
+
+#include "execution/expressions/column_value_expression.h"
+
+namespace bustub {
+
+std::string SortKey::Make(const Tuple &tuple, const Schema *schema, const std::vector<OrderBy> &order_bys) {
+  std::string key;
+  for (const auto &[type, expr] : order_bys) {
+    // A key that is a column is read in place, without copying its string.
+    const auto *column = dynamic_cast<const ColumnValueExpression *>(expr);
+    Append(column != nullptr ? tuple.GetValueView(schema, column->GetColIdx()) : expr->Evaluate(&tuple, schema), type,
+           &key);
+  }
+  return key;
+}
+
+void SortKey::Append(const Value &value, OrderByType type, std::string *key) {
+  KeyNormalizer::Append(value, type == OrderByType::DESC, key);
+}
+
+}  // namespace bustub
@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_executor.cpp
+//
+// Identification: src/execution/topn_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/topn_executor.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+TopNExecutor::TopNExecutor(ExecutorContext *exec_ctx, const TopNPlanNode *plan,
+                           std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx), plan_(plan), child_(std::move(child)) {}
+
+void TopNExecutor::Init() {
+  child_->Init();
+  entries_.clear();
+  heap_.clear();
+  next_ = 0;
+  ResetNextFromBatch();
+
+  const size_t n = plan_->GetN();
+  const Schema *schema = child_->GetOutputSchema();
+  auto before = [this](size_t a, size_t b) { return Before(a, b); };
+  entries_.reserve(n);
+  size_t seq = 0;
+  TupleBatch batch;
+  while (n > 0 && child_->NextBatch(&batch)) {
+    for (uint32_t row : batch.GetSelection()) {
+      Tuple tuple = batch.GetTuple(row);
+      std::string key = SortKey::Make(tuple, schema, plan_->GetOrderBy());
+      if (entries_.size() < n) {
+        entries_.push_back(Entry{std::move(key), seq++, std::move(tuple)});
+        heap_.push_back(entries_.size() - 1);
+        std::push_heap(heap_.begin(), heap_.end(), before);
+        continue;
+      }
+      // A tuple that ties with the largest one comes after it, so it is dropped as well.
+      const size_t largest = heap_.front();
+      if (key.compare(entries_[largest].key_) >= 0) {
+        seq++;
+        continue;
+      }
+      std::pop_heap(heap_.begin(), heap_.end(), before);
+      entries_[largest] = Entry{std::move(key), seq++, std::move(tuple)};
+      std::push_heap(heap_.begin(), heap_.end(), before);
+    }
+  }
+  std::sort_heap(heap_.begin(), heap_.end(), before);
+}
+
+bool TopNExecutor::NextBatch(TupleBatch *batch) {
+  batch->Reset(GetOutputSchema());
+  while (!batch->IsFull() && next_ < heap_.size()) {
+    batch->AppendTuple(entries_[heap_[next_++]].tuple_);
+  }
+  return !batch->IsEmpty();
+}
+
+}  // namespace bustub
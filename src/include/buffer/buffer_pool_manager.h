@@ -12,14 +12,29 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/buffer_ring.h"
 #include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/page_table.h"
+#include "common/util/metrics.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -36,13 +51,32 @@ class BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the policy used to pick frames for replacement
+   * @param max_pool_size the size that the buffer pool can grow to with Resize, 0 = pool_size
    */
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                    ReplacerPolicy replacer_policy = ReplacerPolicy::CLOCK, size_t max_pool_size = 0);
+
+  /**
+   * Creates a new BufferPoolManager that serves as one shard of a ParallelBufferPoolManager.
+   * The shard only ever holds pages whose id satisfies page_id % num_instances == instance_index.
+   * @param pool_size the size of this shard
+   * @param num_instances the total number of shards
+   * @param instance_index the index of this shard, in [0, num_instances)
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the policy used to pick frames for replacement
+   * @param max_pool_size the size that the shard can grow to with Resize, 0 = pool_size
+   * @param numa_node the NUMA node that the frames of the shard are allocated on, FrameArena::ANY_NUMA_NODE = any
+   */
+  BufferPoolManager(size_t pool_size, uint32_t num_instances, uint32_t instance_index, DiskManager *disk_manager,
+                    LogManager *log_manager = nullptr, ReplacerPolicy replacer_policy = ReplacerPolicy::CLOCK,
+                    size_t max_pool_size = 0, int numa_node = FrameArena::ANY_NUMA_NODE);
 
   /**
    * Destroys an existing BufferPoolManager.
    */
-  ~BufferPoolManager();
+  virtual ~BufferPoolManager();
 
   /** Grading function. Do not modify! */
   Page *FetchPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
@@ -91,13 +125,274 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetches several pages at once. Resident pages are pinned without the latch, the misses are brought in with a
+   * single pass over the latch and read from disk in page id order.
+   * @param page_ids ids of the pages to be fetched, may contain duplicates
+   * @return the pages in the order of page_ids, nullptr for every page that could not be brought in
+   */
+  std::vector<Page *> FetchPages(const std::vector<page_id_t> &page_ids) {
+    if (page_ids.empty()) {
+      return {};
+    }
+    return FetchPagesImpl(page_ids);
+  }
+
+  /**
+   * Creates several pages at once, taking the latch once per shard.
+   * @param n the number of pages to be created
+   * @param[out] page_ids ids of the created pages
+   * @return the created pages in the order of page_ids, fewer than n if the buffer pool ran out of frames
+   */
+  std::vector<Page *> NewPages(size_t n, std::vector<page_id_t> *page_ids) {
+    page_ids->clear();
+    if (n == 0) {
+      return {};
+    }
+    return NewPagesImpl(n, page_ids);
+  }
+
+  /**
+   * Unpins several pages at once. Pages whose last pin is dropped are handed to the replacer under a single latch.
+   * @param page_ids ids of the pages to be unpinned, a page that is listed twice is unpinned twice
+   * @param is_dirty true if the pages should be marked as dirty, false otherwise
+   * @return false if any of the pages was not pinned, true otherwise
+   */
+  bool UnpinPages(const std::vector<page_id_t> &page_ids, bool is_dirty) { return UnpinPagesImpl(page_ids, is_dirty); }
+
+  /**
+   * Fetches a page on behalf of a sequential scan. Once the ring is active, a miss reuses the frame of the page that
+   * the ring brought in least recently instead of taking a frame from the rest of the pool.
+   * @param page_id id of page to be fetched
+   * @param ring the scan's buffer ring, nullptr to fetch the page like FetchPage does
+   * @return the requested page, nullptr if it could not be brought in
+   */
+  Page *FetchPageForScan(page_id_t page_id, BufferRing *ring) {
+    if (ring == nullptr) {
+      return FetchPageImpl(page_id);
+    }
+    return FetchPageForScanImpl(page_id, ring);
+  }
+
+  /**
+   * Asynchronously reads pages into the buffer pool so that later fetches of them hit. Pages that are already
+   * resident are skipped; prefetching stops at the first page that was never allocated or once no frame is available.
+   * @param start id of the first page to be read
+   * @param n the number of consecutive page ids to be read
+   */
+  void PrefetchPages(page_id_t start, size_t n) {
+    if (start == INVALID_PAGE_ID || n == 0) {
+      return;
+    }
+    PrefetchPagesImpl(start, n);
+  }
+
+  /**
+   * @param page_id id of a page
+   * @return true if a fetch of the page would find it resident and not waiting for a read, e.g. one that was
+   * prefetched; only a hint, since the page may be evicted right after
+   */
+  bool IsPageReady(page_id_t page_id) {
+    if (disk_manager_->GetMappedPage(page_id) != nullptr) {
+      return true;
+    }
+    BufferPoolManager *shard = GetShardImpl(page_id);
+    frame_id_t frame_id;
+    return shard->page_table_.Find(page_id, &frame_id) && !shard->read_pending_[frame_id];
+  }
+
+  /**
+   * Fetches a page and wraps its pin in a guard that unpins the page when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @return the guard of the page, an empty guard if the page could not be brought in
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id) { return BasicPageGuard(this, FetchPage(page_id)); }
+
+  /**
+   * Fetches a page and latches it for reading. The guard releases the latch and the pin when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @return the guard of the page, an empty guard if the page could not be brought in
+   */
+  ReadPageGuard FetchPageRead(page_id_t page_id);
+
+  /**
+   * Reads a resident page without latching or pinning it, so that readers do not write to memory shared with other
+   * readers. The read is validated against the version of the page afterwards and retried if a writer got in the way;
+   * after OPTIMISTIC_READ_RETRIES failed attempts, or if the page is not resident, the page is read under its read
+   * latch instead.
+   *
+   * Except for the last one, the calls of reader may see a torn copy of the page. reader must therefore keep every
+   * access within the page, tolerate any contents, and only touch state that it resets on every call.
+   * @param page_id id of page to be read
+   * @param reader called as reader(const char *data), possibly several times
+   * @return false if the page could not be brought in
+   */
+  template <class Reader>
+  bool ReadPageOptimistic(page_id_t page_id, Reader &&reader) {
+    // Read-only pages never change, so they need no validation.
+    if (const char *data = disk_manager_->GetMappedPage(page_id); data != nullptr) {
+      reader(data);
+      return true;
+    }
+    BufferPoolManager *shard = GetShardImpl(page_id);
+    for (int attempt = 0; attempt < OPTIMISTIC_READ_RETRIES; attempt++) {
+      frame_id_t frame_id;
+      if (!shard->page_table_.Find(page_id, &frame_id)) {
+        break;
+      }
+      // The frame may be reused at any time, which changes its version, but its memory stays valid.
+      Page *page = &shard->pages_[frame_id];
+      const uint64_t version = page->version_.load(std::memory_order_acquire);
+      if ((version & 1) != 0 || page->page_id_ != page_id) {
+        continue;
+      }
+      reader(static_cast<const char *>(page->data_));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (page->version_.load(std::memory_order_relaxed) == version && page->page_id_ == page_id) {
+        shard->stats_.RecordHit();
+        return true;
+      }
+    }
+    ReadPageGuard guard = FetchPageRead(page_id);
+    if (!guard.IsValid()) {
+      return false;
+    }
+    reader(guard.GetData());
+    return true;
+  }
+
+  /**
+   * Fetches a page and latches it for writing. The guard releases the latch and the pin when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @return the guard of the page, an empty guard if the page could not be brought in
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+
+  /**
+   * Creates a new page and wraps its pin in a guard that unpins the page when it goes out of scope.
+   * @param[out] page_id id of created page
+   * @return the guard of the page, an empty guard if no new page could be created
+   */
+  BasicPageGuard NewPageGuarded(page_id_t *page_id) { return BasicPageGuard(this, NewPage(page_id)); }
+
+  /**
+   * Creates a new page in a dedicated extent on disk, right after prev_page_id if possible, so that a chain of pages
+   * that is read in order, like a table heap, stays physically sequential.
+   * @param prev_page_id the page that the new page follows, INVALID_PAGE_ID to start the chain in a new extent
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageInExtent(page_id_t prev_page_id, page_id_t *page_id) {
+    return NewPageInExtentImpl(prev_page_id, page_id);
+  }
+
+  /**
+   * Creates a new page like NewPageInExtent and wraps its pin in a guard that unpins the page when it goes out of
+   * scope.
+   * @param prev_page_id the page that the new page follows, INVALID_PAGE_ID to start the chain in a new extent
+   * @param[out] page_id id of created page
+   * @return the guard of the page, an empty guard if no new page could be created
+   */
+  BasicPageGuard NewPageInExtentGuarded(page_id_t prev_page_id, page_id_t *page_id) {
+    return BasicPageGuard(this, NewPageInExtent(prev_page_id, page_id));
+  }
+
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
   /** @return size of the buffer pool */
   size_t GetPoolSize() { return pool_size_; }
 
+  /** @return the NUMA node that the frames are allocated on, FrameArena::ANY_NUMA_NODE if they are not bound */
+  int GetNumaNode() const { return frame_arena_.GetNumaNode(); }
+
+  /**
+   * Changes the number of frames of the buffer pool while it is in use. Growing adds empty frames, up to the maximum
+   * size given at construction, and within the soft limit of the BUFFER_POOL subsystem, see MemoryAccounting.
+   * Shrinking writes back and drops the pages held by the frames that are removed.
+   * @param pool_size the new size of the buffer pool
+   * @return false if the size exceeds the maximum or the soft limit, or if a frame that would be removed is pinned
+   */
+  bool Resize(size_t pool_size) { return ResizeImpl(pool_size); }
+
+  /**
+   * Makes a segment of the database read-only and maps it into memory, see DiskManager::MapSegmentReadOnly. The
+   * dirty pages are written back first. From then on, fetching a page of the segment returns a view of the mapping,
+   * which is pinned and latched like any other page, but takes no frame and is never evicted. Its data must not be
+   * modified. Frames that already hold pages of the segment are clean and are reused by eviction as usual.
+   * @param segment the number of the segment
+   * @return true if the segment is mapped
+   */
+  bool MapSegmentReadOnly(size_t segment) {
+    FlushAllPages();
+    return disk_manager_->MapSegmentReadOnly(segment);
+  }
+
+  /**
+   * Takes a snapshot of the counters of the buffer pool. The counters are cheap to maintain and always enabled.
+   * @return the hit, eviction, wait and flush counters since the buffer pool was created
+   */
+  BufferPoolStats GetStats() { return GetStatsImpl(); }
+
+  /**
+   * Adds the counters of GetStats() and the size of the buffer pool to a snapshot, see MetricsRegistry.
+   * @param snapshot the snapshot to add the metrics to
+   */
+  void CollectMetrics(MetricsSnapshot *snapshot);
+
+  /**
+   * Takes a snapshot of the dirty page table for a fuzzy checkpoint. Pinned pages are included even if they are not
+   * marked dirty yet, since their modifications are only reported by the unpin.
+   * @return the pages that may differ from their copy on disk, each with its recLSN: all the log records of changes
+   * that are missing on disk have this LSN or a larger one
+   */
+  std::vector<std::pair<page_id_t, lsn_t>> GetDirtyPageTable() { return GetDirtyPageTableImpl(); }
+
+  /**
+   * Writes back some pages like the background flusher does, copying each under its latch so that their writers are
+   * not held up. Pages that are not resident, clean or pinned are skipped.
+   * @param page_ids the pages to be written back
+   * @return the number of pages that were written
+   */
+  size_t WriteBackPages(const std::vector<page_id_t> &page_ids) { return WriteBackPagesImpl(page_ids); }
+
+  /**
+   * Saves the ids of the resident pages to a file, most recently used first, so that a later run can warm up with
+   * RestoreResidentPages. The file is replaced atomically.
+   * @param file_name the warm start file
+   * @return false if the file could not be written
+   */
+  bool DumpResidentPages(const std::string &file_name);
+
+  /**
+   * Loads the pages listed in a warm start file into free frames, most recently used first, until no free frame is
+   * left. The reads are sorted by page id and spread over WARM_START_READERS threads. Pages that are resident already
+   * or that no longer exist are skipped.
+   * @param file_name the warm start file
+   * @return the number of pages that were loaded
+   */
+  size_t RestoreResidentPages(const std::string &file_name);
+
+  /**
+   * Starts saving the resident pages every warm_start_interval, until StopWarmStartDumps is called or the buffer pool
+   * is destroyed.
+   * @param file_name the warm start file
+   */
+  void StartWarmStartDumps(const std::string &file_name);
+
+  /** Stops the periodic saving of the resident pages, saving them one last time. Does nothing if it is not running. */
+  void StopWarmStartDumps();
+
+  /**
+   * @param page_id the page id to check
+   * @return true if the page is allocated on disk
+   */
+  bool IsAllocated(page_id_t page_id);
+
  protected:
+  // The parallel buffer pool merges the resident pages of its shards and hands warm start pages to them.
+  friend class ParallelBufferPoolManager;
+
   /**
    * Grading function. Do not modify!
    * Invokes the callback function if it is not null.
@@ -116,7 +411,15 @@ class BufferPoolManager {
    * @param page_id id of page to be fetched
    * @return the requested page
    */
-  Page *FetchPageImpl(page_id_t page_id);
+  virtual Page *FetchPageImpl(page_id_t page_id);
+
+  /**
+   * Fetch the requested page, recycling the frames of the scan's buffer ring on a miss.
+   * @param page_id id of page to be fetched
+   * @param ring the buffer ring of the scan
+   * @return the requested page
+   */
+  virtual Page *FetchPageForScanImpl(page_id_t page_id, BufferRing *ring);
 
   /**
    * Unpin the target page from the buffer pool.
@@ -124,38 +427,121 @@ class BufferPoolManager {
    * @param is_dirty true if the page should be marked as dirty, false otherwise
    * @return false if the page pin count is <= 0 before this call, true otherwise
    */
-  bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
+  virtual bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
+
+  /**
+   * Fetches several pages from the buffer pool.
+   * @param page_ids ids of the pages to be fetched
+   * @return the pages in the order of page_ids, nullptr for the ones that could not be brought in
+   */
+  virtual std::vector<Page *> FetchPagesImpl(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Creates several pages in the buffer pool.
+   * @param n the number of pages to be created
+   * @param[out] page_ids ids of the created pages, empty on entry
+   * @return the created pages, fewer than n if no more frames were available
+   */
+  virtual std::vector<Page *> NewPagesImpl(size_t n, std::vector<page_id_t> *page_ids);
+
+  /**
+   * Unpins several pages from the buffer pool.
+   * @param page_ids ids of the pages to be unpinned
+   * @param is_dirty true if the pages should be marked as dirty, false otherwise
+   * @return false if any of the pages was not pinned, true otherwise
+   */
+  virtual bool UnpinPagesImpl(const std::vector<page_id_t> &page_ids, bool is_dirty);
 
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
    */
-  bool FlushPageImpl(page_id_t page_id);
+  virtual bool FlushPageImpl(page_id_t page_id);
 
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  Page *NewPageImpl(page_id_t *page_id);
+  virtual Page *NewPageImpl(page_id_t *page_id);
+
+  /**
+   * Creates a new page in the buffer pool whose id comes from a dedicated extent on disk.
+   * @param prev_page_id the page that the new page follows, INVALID_PAGE_ID to start a new extent
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPageInExtentImpl(page_id_t prev_page_id, page_id_t *page_id);
 
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
-  bool DeletePageImpl(page_id_t page_id);
+  virtual bool DeletePageImpl(page_id_t page_id);
 
   /**
    * Flushes all the pages in the buffer pool to disk.
    */
-  void FlushAllPagesImpl();
+  virtual void FlushAllPagesImpl();
+
+  /**
+   * Queues reads for the pages in [start, start + n) that belong to this buffer pool.
+   * @param start id of the first page to be read
+   * @param n the number of consecutive page ids to be read
+   */
+  virtual void PrefetchPagesImpl(page_id_t start, size_t n);
+
+  /**
+   * Changes the number of frames of the buffer pool.
+   * @param pool_size the new size of the buffer pool
+   * @return false if the buffer pool could not be resized
+   */
+  virtual bool ResizeImpl(size_t pool_size);
+
+  /** @return a snapshot of the counters of the buffer pool */
+  virtual BufferPoolStats GetStatsImpl();
+
+  /**
+   * @param page_id id of a page
+   * @return the buffer pool whose frames hold the page if it is resident
+   */
+  virtual BufferPoolManager *GetShardImpl(page_id_t page_id) { return this; }
+
+  /** @return the resident pages, each with the time of its last access */
+  virtual std::vector<std::pair<uint64_t, page_id_t>> GetResidentPagesImpl();
+
+  /** @return the dirty and the pinned pages, each with its recLSN */
+  virtual std::vector<std::pair<page_id_t, lsn_t>> GetDirtyPageTableImpl();
+
+  /**
+   * Writes back the dirty, unpinned pages among the given ones.
+   * @param page_ids the pages to be written back
+   * @return the number of pages that were written
+   */
+  virtual size_t WriteBackPagesImpl(const std::vector<page_id_t> &page_ids);
 
-  /** Number of pages in the buffer pool. */
-  size_t pool_size_;
+  /**
+   * Loads pages into free frames, never evicting any resident page.
+   * @param page_ids the pages to be loaded, the most important ones first
+   * @return the number of pages that were loaded
+   */
+  virtual size_t LoadPagesImpl(const std::vector<page_id_t> &page_ids);
+
+  /** Number of pages in the buffer pool. Frames [pool_size_, max_pool_size) are retired and never used. */
+  std::atomic<size_t> pool_size_;
+
+  /** Number of shards that the page id space is split into, 1 if this is a standalone buffer pool. */
+  const uint32_t num_instances_ = 1;
 
-  /** Array of buffer pool pages. */
+  /** Index of this shard, page ids allocated here satisfy page_id % num_instances_ == instance_index_. */
+  const uint32_t instance_index_ = 0;
+
+  /** The data of all frames. Declared before pages_, which points into it. */
+  FrameArena frame_arena_;
+
+  /** Array of buffer pool pages. Only holds the metadata of the frames, their data lives in frame_arena_. */
   Page *pages_;
 
   /** Pointer to the disk manager. */
@@ -164,8 +550,8 @@ class BufferPoolManager {
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
 
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  /** Page table for keeping track of buffer pool pages. Modified under latch_, but can be read without it. */
+  PageTable page_table_;
 
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
@@ -173,13 +559,307 @@ class BufferPoolManager {
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
 
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /**
+   * This latch serializes modifications of page_table_, free_list_ and replacer_. Buffer pool hits only pin the frame
+   * with a compare-and-swap on its pin count and do not take the latch; everything that reuses a frame first claims
+   * it by swapping a pin count of 0 for -1, so a frame can never be pinned and reused at the same time.
+   */
   std::mutex latch_;
 
-  size_t cur_size_;
+  /** Counters reported by GetStats. */
+  BufferPoolCounters stats_;
+
+  /** Number of frames whose page is dirty. */
+  std::atomic<size_t> num_dirty_{0};
+
+  /** Background thread that writes dirty pages back to disk, nullptr if the pool has no frames. */
+  std::thread *flusher_thread_ = nullptr;
+
+  /** Wakes up the flusher early, either on shutdown or once the dirty high-water mark is reached. */
+  std::condition_variable flusher_cv_;
+
+  /** Background thread that performs the reads queued by prefetching, nullptr if the pool has no frames. */
+  std::thread *prefetcher_thread_ = nullptr;
+
+  /** Wakes up the prefetcher when reads are queued or on shutdown. */
+  std::condition_variable prefetcher_cv_;
+
+  /** Reads queued for the prefetcher as (page, frame) pairs. Protected by latch_. */
+  std::deque<std::pair<page_id_t, frame_id_t>> prefetch_queue_;
+
+  /** True for frames whose page is still being read by the prefetcher. Only modified under latch_. */
+  std::vector<std::atomic<bool>> read_pending_;
+
+  /**
+   * True for frames that hold a pin of the flusher or the prefetcher, which unpins by callers must not drop. Only
+   * modified under latch_, and read without it by DecrementPin() after each read of the pin count.
+   */
+  std::vector<std::atomic<bool>> background_pinned_;
+
+  /** True for frames that were filled by a prefetch and have not been fetched since. Only modified under latch_. */
+  std::vector<std::atomic<bool>> prefetched_;
+
+  /** The steady clock time at which each frame was last pinned, to order the pages of a warm start file. */
+  std::vector<std::atomic<uint64_t>> last_access_;
+
+  /**
+   * The pins of each frame since its page was read, which are reported to the disk manager when the page leaves the
+   * frame, so that the extents whose pages stay in the buffer pool do not look cold to a tiered disk manager.
+   */
+  std::vector<std::atomic<uint32_t>> accesses_;
+
+  /**
+   * The recLSN of each frame: the next LSN when the page was read or last written back, which no log record of a
+   * newer change of the page can be below.
+   */
+  std::vector<std::atomic<lsn_t>> rec_lsns_;
+
+  /** Background thread that periodically saves the resident pages, nullptr if it is not running. */
+  std::thread *warm_start_thread_ = nullptr;
+
+  /** The warm start file, and the latch and condition variable used to stop warm_start_thread_. */
+  std::string warm_start_file_;
+  std::mutex warm_start_latch_;
+  std::condition_variable warm_start_cv_;
+  bool stop_warm_start_ = false;
+
+  /** Number of frames that are temporarily pinned by the flusher or the prefetcher. Protected by latch_. */
+  size_t num_background_pins_ = 0;
+
+  /** Signalled whenever the flusher or the prefetcher unpins a frame, e.g. because a pending read completed. */
+  std::condition_variable background_pin_cv_;
+
+  /** The page of the last miss and the number of misses in a row that were one page apart, for read-ahead. */
+  page_id_t last_miss_page_id_ = INVALID_PAGE_ID;
+  size_t num_sequential_misses_ = 0;
+
+  /** True once the background threads have been asked to exit. Protected by latch_. */
+  bool shutdown_ = false;
+
+  /** The views of the read-only pages that have been fetched, which point into the mappings of the disk manager. */
+  std::unordered_map<page_id_t, std::unique_ptr<Page>> mapped_pages_;
+  std::mutex mapped_latch_;
+
+ private:
+  /**
+   * Allocates a page id on disk that is owned by this buffer pool.
+   * @param in_extent true to allocate the page in a dedicated extent, false to allocate it in a shared one
+   * @param prev_page_id the page that a page in a dedicated extent follows, INVALID_PAGE_ID to open a new extent
+   * @return the id of the allocated page
+   */
+  page_id_t AllocatePage(bool in_extent = false, page_id_t prev_page_id = INVALID_PAGE_ID);
+
+  /**
+   * Finds a frame that can hold a new page, taking from the free list first and the replacer second.
+   * If the frame held a page, the page is written back when dirty and removed from the page table.
+   * The caller must hold latch_.
+   * @param[out] frame_id the frame that can be reused
+   * @return false if all frames are pinned, true otherwise
+   */
+  bool FindReplacementFrame(frame_id_t *frame_id);
+
+  /**
+   * Like FindReplacementFrame, but if every frame is pinned and some of the pins belong to the flusher or the
+   * prefetcher, waits for them to be released instead of failing.
+   * @param lock the caller's lock on latch_
+   * @param[out] frame_id the frame that can be reused
+   * @return false if all frames are pinned by users of the buffer pool, true otherwise
+   */
+  bool AcquireFrame(std::unique_lock<std::mutex> *lock, frame_id_t *frame_id);
+
+  /**
+   * Returns a frame from FindReplacementFrame or RecycleFrame that turned out not to be needed to the free list.
+   * @param frame_id the unused frame
+   */
+  void ReleaseFrame(frame_id_t frame_id);
+
+  /**
+   * Creates a new page in a frame from AcquireFrame. Must be called with latch_ held.
+   * @param lock the caller's lock on latch_
+   * @param[out] page_id id of created page
+   * @param in_extent true to allocate the page in a dedicated extent, see AllocatePage
+   * @param prev_page_id the page that a page in a dedicated extent follows
+   * @return the new page, pinned once, nullptr if no frame was available
+   */
+  Page *CreatePage(std::unique_lock<std::mutex> *lock, page_id_t *page_id, bool in_extent = false,
+                   page_id_t prev_page_id = INVALID_PAGE_ID);
+
+  /**
+   * Drops a pin of a page without the latch. The replacer has to be told about the page once its last pin is gone.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty
+   * @param[out] frame_id the frame of the page
+   * @return the number of pins left, -1 if the page was not pinned
+   */
+  int DecrementPin(page_id_t page_id, bool is_dirty, frame_id_t *frame_id);
+
+  /**
+   * Pins a resident page without taking latch_. Fails if the page is not resident in a frame that can be used right
+   * away, i.e. when it has not been found, its frame changed hands, its read is in flight or it was prefetched.
+   * @param page_id the page to be pinned
+   * @return the pinned page, nullptr if the caller has to take the latched path
+   */
+  Page *TryPinResidentPage(page_id_t page_id);
+
+  /**
+   * Pins the view of a page of a read-only segment, creating it on the first fetch.
+   * @param page_id the page to be pinned
+   * @return the pinned view, nullptr if the page is not read-only
+   */
+  Page *PinMappedPage(page_id_t page_id);
+
+  /**
+   * Unpins the view of a page of a read-only segment. Views cannot become dirty, so is_dirty is ignored.
+   * @param page_id the page to be unpinned
+   * @param is_dirty true if the caller modified the page, which it must not have
+   * @return false if the page has no pinned view, e.g. because it is not read-only
+   */
+  bool UnpinMappedPage(page_id_t page_id, bool is_dirty);
+
+  /**
+   * Records an access to a frame for the warm start file and the heat of its extent.
+   * @param frame_id the frame that was pinned
+   */
+  void TouchFrame(frame_id_t frame_id) {
+    last_access_[frame_id].store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                                 std::memory_order_relaxed);
+    accesses_[frame_id].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Reports the accesses to the page of a frame that is about to leave it to the disk manager.
+   * @param frame_id the frame whose page is evicted
+   */
+  void ReportAccesses(frame_id_t frame_id) {
+    disk_manager_->RecordPageAccesses(pages_[frame_id].page_id_,
+                                      accesses_[frame_id].exchange(0, std::memory_order_relaxed));
+  }
+
+  /**
+   * Starts the recLSN of a frame at the next LSN, when its page has been read or before it is copied for a write.
+   * @param frame_id the frame whose page matches its copy on disk up to the log records that follow
+   */
+  void ResetRecLSN(frame_id_t frame_id) {
+    rec_lsns_[frame_id].store(log_manager_ != nullptr ? log_manager_->GetNextLSN() : 0, std::memory_order_relaxed);
+  }
+
+  /**
+   * Claims an unpinned frame for reuse by swapping its pin count of 0 for -1.
+   * @param frame_id the frame to be claimed
+   * @return false if the frame is pinned or already claimed
+   */
+  bool ClaimFrame(frame_id_t frame_id);
+
+  /**
+   * Drops a pin, making the frame evictable once the last pin is gone. A frame whose read failed goes back to the free
+   * list instead. The caller must hold latch_.
+   * @param frame_id the frame to be unpinned
+   */
+  void DropPin(frame_id_t frame_id);
+
+  /**
+   * Unpublishes a frame whose page was read in the background and failed its checksum, so that no fetch hands out its
+   * data; a later fetch of the page reads it again. The pins stay in place, the last DropPin() frees the frame. The
+   * caller must hold latch_, and must do this before it clears read_pending_.
+   * @param frame_id the frame of the failed read
+   */
+  void DiscardFailedRead(frame_id_t frame_id);
+
+  /**
+   * Pins a resident page on behalf of a fetch, waiting for its read to complete if it is still being prefetched.
+   * The caller must hold latch_.
+   * @param lock the caller's lock on latch_
+   * @param page_id the page that was found in the page table
+   * @param frame_id the frame holding the page
+   * @return the page, nullptr if its pending read failed
+   */
+  Page *PinResidentPage(std::unique_lock<std::mutex> *lock, page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Takes back the frame of a page that a buffer ring wants to recycle. The page is written back when dirty and
+   * removed from the page table. The caller must hold latch_.
+   * @param page_id the page that gives up its frame
+   * @param[out] frame_id the frame that can be reused
+   * @return false if the page is not resident or still pinned, true otherwise
+   */
+  bool RecycleFrame(page_id_t page_id, frame_id_t *frame_id);
+
+  /**
+   * Loads a page from disk into a frame that was just taken from the free list, the replacer or a ring, and pins it.
+   * The caller must hold latch_.
+   * @param page_id the page to be read
+   * @param frame_id the frame to read the page into
+   * @return the page, nullptr if it failed its checksum, in which case the frame is back on the free list
+   */
+  Page *LoadPage(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Detects sequential misses and starts reading ahead once READ_AHEAD_TRIGGER of them happened in a row.
+   * The caller must hold latch_.
+   * @param page_id the page that missed
+   */
+  void ReadAhead(page_id_t page_id);
+
+  /**
+   * Queues reads for the pages in [start, start + n) that belong to this buffer pool. The caller must hold latch_.
+   * @param start id of the first page to be read
+   * @param n the number of consecutive page ids to be read
+   */
+  void QueuePrefetches(page_id_t start, size_t n);
+
+  /**
+   * Drops a pin that the flusher or the prefetcher held on a frame. The caller must hold latch_.
+   * @param frame_id the frame to be unpinned
+   */
+  void ReleaseBackgroundPin(frame_id_t frame_id);
+
+  /**
+   * Writes the page held by the frame back to disk and clears its dirty flag. The caller must hold latch_.
+   * @param frame_id the frame to be written back
+   */
+  void FlushFrame(frame_id_t frame_id);
+
+  /**
+   * Marks the page held by the frame as dirty, waking up the flusher if too many frames are dirty.
+   * The caller must hold latch_.
+   * @param frame_id the frame that was modified
+   */
+  void MarkFrameDirty(frame_id_t frame_id);
+
+  /**
+   * @param page the page to be written back
+   * @return true if writing the page does not violate the WAL rule, i.e. its log records are on disk
+   */
+  bool IsLogPersistent(Page *page);
+
+  /**
+   * Pins a frame for a write back if its page is dirty, its log records are on disk and nobody else uses it. The
+   * caller must hold latch_.
+   * @param frame_id the frame to be written back
+   * @return true if the frame holds a background pin now
+   */
+  bool PinForWriteBack(frame_id_t frame_id);
+
+  /**
+   * Writes back frames that were pinned with PinForWriteBack, without holding latch_. The frames stay pinned. The
+   * pages are written in page id order, in batches that are each a DiskManager::WritePages() and a SyncPages(), so
+   * that adjacent pages go out as one write.
+   * @param frames the frames to be written back
+   * @param staging aligned space for IO_URING_QUEUE_DEPTH page copies
+   */
+  void WriteBackFrames(const std::vector<frame_id_t> &frames, char *staging);
 
-  void update_page_metadata(frame_id_t frame_id, page_id_t page_id);
+  /**
+   * Body of the flusher thread. Periodically writes back dirty, unpinned pages until shutdown_ is set, then writes
+   * them back a last time unless the disk manager was already shut down.
+   * Pages are pinned while they are written, so the frame latch is not held during disk I/O.
+   */
+  void RunFlusher();
 
-  void reset_page_metadata(frame_id_t frame_id);
+  /**
+   * Body of the prefetcher thread. Performs the queued reads until shutdown_ is set and the queue is drained.
+   * Frames stay pinned until their read completes, so fetches of a page in flight wait instead of reading it twice.
+   */
+  void RunPrefetcher();
 };
 }  // namespace bustub
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * BufferPoolStats is a point-in-time copy of the counters of a buffer pool.
+ */
+struct BufferPoolStats {
+  /**
+   * Number of buckets of the flush latency histogram. Bucket 0 counts writes that took less than 1 us, bucket i > 0
+   * counts writes that took [2^(i-1), 2^i) us, and the last bucket also counts everything slower.
+   */
+  static constexpr size_t NUM_LATENCY_BUCKETS = 24;
+
+  /** Fetches of pages that were resident. */
+  uint64_t fetch_hits = 0;
+  /** Fetches of pages that had to be read from disk. */
+  uint64_t fetch_misses = 0;
+  /** Fetches that failed because every frame was pinned. */
+  uint64_t fetch_failures = 0;
+  /** NewPage calls that failed because every frame was pinned. */
+  uint64_t new_page_failures = 0;
+  /** Pages that were evicted to make room for another page. */
+  uint64_t evictions = 0;
+  /** Evicted pages that had to be written back first. */
+  uint64_t dirty_evictions = 0;
+  /** Number of times a fetch had to wait for a frame or for a page that was still being read. */
+  uint64_t pin_waits = 0;
+  /** Total time spent in those waits, in microseconds. */
+  uint64_t pin_wait_time_us = 0;
+  /** Total time that fetches which missed spent reading their pages, in microseconds. */
+  uint64_t read_time_us = 0;
+  /** Pages written back to disk, by evictions, explicit flushes and the background flusher. */
+  uint64_t flushes = 0;
+  /** Total time spent in those writes, in microseconds. */
+  uint64_t flush_time_us = 0;
+  /** Histogram of the latencies of those writes. */
+  std::array<uint64_t, NUM_LATENCY_BUCKETS> flush_latency_us{};
+
+  /** @return the fraction of fetches that hit, 0 if there were none */
+  double HitRatio() const;
+
+  /** Adds the counters of another buffer pool, e.g. to sum up the shards of a parallel buffer pool. */
+  BufferPoolStats &operator+=(const BufferPoolStats &other);
+};
+
+/**
+ * BufferPoolCounters are the live counters of a buffer pool. Recording is a relaxed atomic increment on one of
+ * several cache-line sized stripes, picked per thread, so that hits in different threads do not contend on the same
+ * cache line. Snapshots sum up the stripes and are therefore not atomic with respect to concurrent updates.
+ */
+class BufferPoolCounters {
+ public:
+  void RecordHit() { Add(&Stripe::fetch_hits_, 1); }
+  void RecordMiss() { Add(&Stripe::fetch_misses_, 1); }
+  void RecordFetchFailure() { Add(&Stripe::fetch_failures_, 1); }
+  void RecordNewPageFailure() { Add(&Stripe::new_page_failures_, 1); }
+  void RecordEviction(bool is_dirty) {
+    Add(&Stripe::evictions_, 1);
+    if (is_dirty) {
+      Add(&Stripe::dirty_evictions_, 1);
+    }
+  }
+
+  /** @param wait_time how long a fetch waited for a frame or for a read to complete */
+  void RecordPinWait(std::chrono::steady_clock::duration wait_time);
+
+  /** @param read_time how long a fetch that missed took to read its pages */
+  void RecordRead(std::chrono::steady_clock::duration read_time);
+
+  /** @param latency how long a page write took */
+  void RecordFlush(std::chrono::steady_clock::duration latency);
+
+  /** @return the current value of all counters */
+  BufferPoolStats Snapshot() const;
+
+ private:
+  static constexpr size_t NUM_STRIPES = 16;
+
+  struct alignas(64) Stripe {
+    std::atomic<uint64_t> fetch_hits_{0};
+    std::atomic<uint64_t> fetch_misses_{0};
+    std::atomic<uint64_t> fetch_failures_{0};
+    std::atomic<uint64_t> new_page_failures_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> dirty_evictions_{0};
+    std::atomic<uint64_t> pin_waits_{0};
+    std::atomic<uint64_t> pin_wait_time_us_{0};
+    std::atomic<uint64_t> read_time_us_{0};
+    std::atomic<uint64_t> flushes_{0};
+    std::atomic<uint64_t> flush_time_us_{0};
+    std::array<std::atomic<uint64_t>, BufferPoolStats::NUM_LATENCY_BUCKETS> flush_latency_us_{};
+  };
+
+  /** @return the stripe of the calling thread */
+  Stripe *GetStripe();
+
+  void Add(std::atomic<uint64_t> Stripe::*counter, uint64_t n) {
+    (GetStripe()->*counter).fetch_add(n, std::memory_order_relaxed);
+  }
+
+  std::array<Stripe, NUM_STRIPES> stripes_;
+};
+
+}  // namespace bustub
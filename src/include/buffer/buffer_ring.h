@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_ring.h
+//
+// Identification: src/include/buffer/buffer_ring.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * BufferRing is a buffer access strategy for large sequential scans.
+ *
+ * Instead of letting every page of a scan compete for frames of the whole buffer pool, a scan that is handed a ring
+ * recycles a small, fixed set of frames: once the ring is full, the page brought in by the oldest ring miss gives up
+ * its frame for the next one. The ring only kicks in after the scan has fetched activation_threshold pages, so small
+ * scans behave exactly as before.
+ *
+ * A ring belongs to a single scan and is not thread-safe. It only remembers page ids, so it never keeps a page alive:
+ * if another thread pins a page that the ring wants to recycle, the buffer pool falls back to its regular replacer.
+ */
+class BufferRing {
+ public:
+  /**
+   * Creates a new BufferRing.
+   * @param ring_size the number of frames the scan may recycle
+   * @param activation_threshold the number of pages fetched through the ring before recycling starts
+   */
+  explicit BufferRing(size_t ring_size, size_t activation_threshold = 0)
+      : slots_(ring_size, INVALID_PAGE_ID), activation_threshold_(activation_threshold) {}
+
+  /** @return the number of frames the scan may recycle */
+  size_t GetRingSize() const { return slots_.size(); }
+
+  /** @return true if the scan has fetched enough pages for recycling to kick in */
+  bool IsActive() const { return !slots_.empty() && num_fetched_ >= activation_threshold_; }
+
+  /** Records that the scan fetched another page. */
+  void RecordFetch() { num_fetched_++; }
+
+  /** @return the page that should give up its frame for the next ring miss, INVALID_PAGE_ID if the ring is not full */
+  page_id_t GetRecycleCandidate() const { return slots_[cursor_]; }
+
+  /**
+   * Remembers the page that was just brought in by a ring miss and advances to the next slot.
+   * @param page_id the page that now occupies the current slot
+   */
+  void Advance(page_id_t page_id) {
+    slots_[cursor_] = page_id;
+    cursor_ = (cursor_ + 1) % slots_.size();
+  }
+
+ private:
+  /** Pages brought in by ring misses, in the order in which their frames will be recycled. */
+  std::vector<page_id_t> slots_;
+  /** The slot whose page is recycled next. */
+  size_t cursor_ = 0;
+  /** Number of pages fetched through this ring so far. */
+  size_t num_fetched_ = 0;
+  /** Number of pages that must be fetched before recycling starts. */
+  const size_t activation_threshold_;
+};
+
+}  // namespace bustub
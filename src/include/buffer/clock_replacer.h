@@ -12,11 +12,8 @@
 
 #pragma once
 
-#include <algorithm>
-#include <list>
-#include <mutex>  // NOLINT
-#include <unordered_map>
-#include <unordered_set>
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -26,6 +23,14 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * The clock hand sweeps over the frames in the order of their ids. A frame that was unpinned after a pin gets its
+ * reference bit set, and the hand clears the bit rather than evicting the frame the first time it passes it; a frame
+ * that the replacer did not track before starts out without the bit.
+ *
+ * Every frame has a state word with its tracked, evictable and reference bits. It takes no latch: Pin() and Unpin()
+ * are a single atomic update of the state of their frame, and Victim() can run concurrently with them, claiming its
+ * victim with a compare-and-swap on the state.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -46,19 +51,22 @@ class ClockReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void Remove(frame_id_t frame_id) override;
+
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
-  int capacity;
-  int cur_size;
-  int clock_hand;
-  std::vector<frame_id_t> buckets;
-  std::vector<int> ref_bits;  // it represent whether this frame changed from pinned to unpinned recently
-  std::unordered_map<frame_id_t, int> map; // key=frame_id, value=butck id in clockReplacer
-  std::unordered_set<frame_id_t> recent_pinned; // a set of recent pinned frame_id
+  /** The frame is tracked by the replacer, pinned or not. */
+  static constexpr uint8_t TRACKED = 1;
+  /** The frame is tracked and unpinned, it can be victimized. */
+  static constexpr uint8_t EVICTABLE = 2;
+  /** The frame was unpinned since the hand last passed it. */
+  static constexpr uint8_t REFERENCED = 4;
 
-  auto find_next_available(int start) -> int;
+  std::vector<std::atomic<uint8_t>> states_;
+  /** The number of frames that the hand has passed, modulo the number of frames it points at the next one. */
+  std::atomic<size_t> clock_hand_{0};
+  std::atomic<size_t> num_evictable_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FrameArena is one contiguous, zeroed block of memory that holds the data of every frame of a buffer pool.
+ *
+ * Frames are PAGE_SIZE bytes each and PAGE_SIZE aligned, so they can be handed to O_DIRECT I/O. The arena is backed
+ * by 2 MB huge pages where the system provides them: explicitly reserved huge pages are tried first, otherwise the
+ * kernel is asked to back the mapping with transparent huge pages. Either way, a few TLB entries cover the whole pool.
+ *
+ * An arena can be bound to a NUMA node, so that the threads running on that node access the frames locally.
+ */
+class FrameArena {
+ public:
+  /** The NUMA node of arenas that are not bound to a node. */
+  static constexpr int ANY_NUMA_NODE = -1;
+
+  /**
+   * Maps a new FrameArena.
+   * @param num_frames the number of frames in the arena
+   * @param numa_node the NUMA node that the memory is allocated on, ANY_NUMA_NODE to leave it to the kernel
+   */
+  explicit FrameArena(size_t num_frames, int numa_node = ANY_NUMA_NODE);
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  /** Unmaps the arena. */
+  ~FrameArena();
+
+  /**
+   * @param frame_id the frame
+   * @return the PAGE_SIZE bytes of data of the frame
+   */
+  char *GetFrame(frame_id_t frame_id) const { return data_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  /**
+   * Gives the memory of a range of frames back to the system. The frames stay mapped and can be used again later.
+   * @param first the first frame of the range
+   * @param n the number of frames in the range
+   */
+  void Discard(frame_id_t first, size_t n);
+
+  /** @return the number of frames in the arena */
+  size_t GetNumFrames() const { return num_frames_; }
+
+  /** @return true if the arena is backed by explicitly reserved huge pages */
+  bool IsHugeTLB() const { return is_huge_tlb_; }
+
+  /** @return the NUMA node that the arena is bound to, ANY_NUMA_NODE if it is not bound */
+  int GetNumaNode() const { return numa_node_; }
+
+ private:
+  const size_t num_frames_;
+  char *data_ = nullptr;
+  size_t size_ = 0;
+  bool is_huge_tlb_ = false;
+  int numa_node_ = ANY_NUMA_NODE;
+};
+
+}  // namespace bustub
@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The backward k-distance of a frame is the time elapsed since its k-th most recent access. The victim is the
+ * evictable frame with the largest backward k-distance. Frames with fewer than k recorded accesses have an infinite
+ * backward k-distance; among those, the frame whose oldest access is the earliest is evicted first. This keeps
+ * pages that were touched only once, e.g. by a sequential scan, from pushing out frequently used pages.
+ *
+ * The evictable frames are kept in the order in which they are victimized, so that Victim() takes the first one
+ * instead of looking at every frame. Every Pin counts as an access to the frame. The replacer does not latch
+ * internally, the buffer pool manager serializes all calls.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of accesses that are remembered per frame
+   */
+  LRUKReplacer(size_t num_pages, size_t k);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  /** Book-keeping for a single frame. */
+  struct FrameInfo {
+    /** Timestamps of the last (at most) k accesses, oldest first. */
+    std::list<size_t> history_;
+    /** True if the frame is tracked by the replacer. */
+    bool tracked_ = false;
+    /** True if the frame is tracked and can be victimized. */
+    bool evictable_ = false;
+  };
+
+  /**
+   * The order of the evictable frames: the ones with fewer than k accesses come first, and within each group the one
+   * whose oldest remembered access is the earliest. No two accesses share a timestamp, so the key is unique.
+   */
+  using EvictionKey = std::pair<bool, size_t>;
+
+  /** @return the key of a frame that has an access */
+  EvictionKey GetEvictionKey(const FrameInfo &info) const {
+    return {info.history_.size() >= k_, info.history_.front()};
+  }
+
+  /** Appends an access at the current timestamp to the frame's history, forgetting accesses older than k. */
+  void RecordAccess(FrameInfo *info);
+
+  /** Takes a frame out of the evictable frames, if it is one. */
+  void MakeUnevictable(frame_id_t frame_id);
+
+  const size_t k_;
+  size_t current_timestamp_ = 0;
+  std::vector<FrameInfo> frames_;
+  /** The evictable frames, the next victim first. */
+  std::map<EvictionKey, frame_id_t> evictable_;
+};
+
+}  // namespace bustub
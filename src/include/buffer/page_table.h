@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the ids of resident pages to the frames that hold them.
+ *
+ * It is an open-addressing hash table with linear probing whose slots are single atomic words, so Find can run
+ * concurrently with Insert and Erase without taking a latch. Modifications must be serialized by the caller.
+ *
+ * Lookups are optimistic: Find may miss an entry that is being inserted, or while the table is being rebuilt to
+ * get rid of tombstones, and it may return a mapping that is erased right afterwards. Callers that do not hold the
+ * latch serializing modifications must validate the frame they get and fall back to a latched lookup on a miss.
+ */
+class PageTable {
+ public:
+  /**
+   * Creates a new PageTable.
+   * @param num_frames the maximum number of pages that are resident at the same time
+   */
+  explicit PageTable(size_t num_frames);
+
+  /**
+   * Looks up the frame holding a page. Safe to call concurrently with modifications.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame holding the page
+   * @return true if the page was found
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id) const;
+
+  /**
+   * Inserts a mapping for a page that is not in the table yet. The caller must serialize modifications.
+   * @param page_id the page that became resident
+   * @param frame_id the frame holding the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Removes the mapping of a page. The caller must serialize modifications.
+   * @param page_id the page that is no longer resident
+   * @return true if the page was in the table
+   */
+  bool Erase(page_id_t page_id);
+
+  /** @return the number of pages in the table */
+  size_t Size() const { return size_; }
+
+ private:
+  static constexpr uint64_t EMPTY = ~static_cast<uint64_t>(0);
+  static constexpr uint64_t TOMBSTONE = EMPTY - 1;
+
+  static uint64_t MakeSlot(page_id_t page_id, frame_id_t frame_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static page_id_t SlotPageId(uint64_t slot) { return static_cast<page_id_t>(slot >> 32); }
+  static frame_id_t SlotFrameId(uint64_t slot) { return static_cast<frame_id_t>(slot & 0xFFFFFFFF); }
+
+  /** @return the first slot that page_id probes */
+  size_t Home(page_id_t page_id) const;
+
+  /** Clears the table and reinserts all live entries, dropping every tombstone. */
+  void Rebuild();
+
+  const size_t capacity_;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+  size_t size_ = 0;
+  size_t num_tombstones_ = 0;
+};
+
+}  // namespace bustub
@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager splits its frames into several independently latched BufferPoolManager shards.
+ * Every page lives in exactly one shard, chosen by page_id % num_instances, so operations on pages that belong
+ * to different shards never contend on the same latch.
+ *
+ * In NUMA mode, the shards are spread over the NUMA nodes of the machine and the frames of every shard are allocated on
+ * its node. Which shard holds an existing page is fixed by its id, but new pages are created in a shard on the node of
+ * the calling thread whenever it has room, so the pages a worker creates are local to it.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of shards to split the buffer pool into
+   * @param pool_size the size of each shard
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the policy every shard uses to pick frames for replacement
+   * @param max_pool_size the size that each shard can grow to with Resize, 0 = pool_size
+   * @param numa_aware true to bind shard i to NUMA node i % NumaUtil::GetNumNodes()
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr, ReplacerPolicy replacer_policy = ReplacerPolicy::CLOCK,
+                            size_t max_pool_size = 0, bool numa_aware = false);
+
+  /**
+   * Destroys an existing ParallelBufferPoolManager and all of its shards.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @return the number of shards */
+  size_t GetNumInstances() const { return instances_.size(); }
+
+  /**
+   * @param instance_index the index of the shard
+   * @return a snapshot of the counters of that shard
+   */
+  BufferPoolStats GetShardStats(size_t instance_index) { return instances_[instance_index]->GetStats(); }
+
+ protected:
+  /**
+   * @param page_id id of the page
+   * @return the shard that is responsible for the given page
+   */
+  BufferPoolManager *GetBufferPoolManager(page_id_t page_id);
+
+  /**
+   * Fetch the requested page from the shard that owns it.
+   * @param page_id id of page to be fetched
+   * @return the requested page
+   */
+  Page *FetchPageImpl(page_id_t page_id) override;
+
+  /**
+   * Fetch the requested page from the shard that owns it on behalf of a scan. A shard can only recycle ring slots
+   * holding its own pages; slots of other shards fall back to the shard's replacer.
+   * @param page_id id of page to be fetched
+   * @param ring the buffer ring of the scan
+   * @return the requested page
+   */
+  Page *FetchPageForScanImpl(page_id_t page_id, BufferRing *ring) override;
+
+  /**
+   * Unpin the target page from the shard that owns it.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  bool UnpinPageImpl(page_id_t page_id, bool is_dirty) override;
+
+  /**
+   * Flushes the target page to disk.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  bool FlushPageImpl(page_id_t page_id) override;
+
+  /**
+   * Creates a new page. Shards are tried round robin, starting one past the shard used by the previous call,
+   * so that new pages are spread evenly and a single full shard does not fail the allocation.
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created in any shard, otherwise pointer to new page
+   */
+  Page *NewPageImpl(page_id_t *page_id) override;
+
+  /**
+   * Creates a new page in a dedicated extent. A page that follows prev_page_id is tried in the shard that owns the next
+   * page id first, so that the chain stays physically sequential across shards.
+   * @param prev_page_id the page that the new page follows, INVALID_PAGE_ID to start a new extent
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created in any shard, otherwise pointer to new page
+   */
+  Page *NewPageInExtentImpl(page_id_t prev_page_id, page_id_t *page_id) override;
+
+  /**
+   * Deletes a page from the shard that owns it.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  bool DeletePageImpl(page_id_t page_id) override;
+
+  /**
+   * Flushes all the pages in every shard to disk.
+   */
+  void FlushAllPagesImpl() override;
+
+  /**
+   * Queues reads for the pages in [start, start + n) in the shards that own them.
+   * @param start id of the first page to be read
+   * @param n the number of consecutive page ids to be read
+   */
+  void PrefetchPagesImpl(page_id_t start, size_t n) override;
+
+  /**
+   * Resizes every shard to an equal share of the new size. If one of the shards cannot be shrunk, the shards that
+   * were resized already are grown back.
+   * @param pool_size the new total size, must be a multiple of the number of shards
+   * @return false if the buffer pool could not be resized
+   */
+  bool ResizeImpl(size_t pool_size) override;
+
+  /** @return the sum of the counters of all shards */
+  BufferPoolStats GetStatsImpl() override;
+
+  /**
+   * @param page_id id of a page
+   * @return the shard that owns the page
+   */
+  BufferPoolManager *GetShardImpl(page_id_t page_id) override { return GetBufferPoolManager(page_id); }
+
+  /** @return the resident pages of all shards */
+  std::vector<std::pair<uint64_t, page_id_t>> GetResidentPagesImpl() override;
+
+  /** @return the dirty page tables of all shards */
+  std::vector<std::pair<page_id_t, lsn_t>> GetDirtyPageTableImpl() override;
+
+  /** Writes back the pages of every shard through the shard. */
+  size_t WriteBackPagesImpl(const std::vector<page_id_t> &page_ids) override;
+
+  /**
+   * Splits the pages by shard and fetches each shard's pages with one batch.
+   * @param page_ids ids of the pages to be fetched
+   * @return the pages in the order of page_ids, nullptr for the ones that could not be brought in
+   */
+  std::vector<Page *> FetchPagesImpl(const std::vector<page_id_t> &page_ids) override;
+
+  /**
+   * Spreads the new pages evenly over the preferred shards of GetNewPageOrder. Pages that a full shard cannot take are
+   * created by the shards after it.
+   * @param n the number of pages to be created
+   * @param[out] page_ids ids of the created pages, empty on entry
+   * @return the created pages, fewer than n if all shards ran out of frames
+   */
+  std::vector<Page *> NewPagesImpl(size_t n, std::vector<page_id_t> *page_ids) override;
+
+  /**
+   * Splits the pages by shard and unpins each shard's pages with one batch.
+   * @param page_ids ids of the pages to be unpinned
+   * @param is_dirty true if the pages should be marked as dirty, false otherwise
+   * @return false if any of the pages was not pinned, true otherwise
+   */
+  bool UnpinPagesImpl(const std::vector<page_id_t> &page_ids, bool is_dirty) override;
+
+  /**
+   * Hands every page to its shard, keeping the order of the pages within each shard.
+   * @param page_ids the pages to be loaded, the most important ones first
+   * @return the number of pages that were loaded by all shards
+   */
+  size_t LoadPagesImpl(const std::vector<page_id_t> &page_ids) override;
+
+ private:
+  /** The shards, instances_[i] owns the pages whose id is congruent to i. */
+  std::vector<BufferPoolManager *> instances_;
+
+  /**
+   * Orders the shards for the creation of new pages. The order rotates between calls so that new pages are spread
+   * evenly; in NUMA mode, the shards on the node of the calling thread come first.
+   * @param[out] num_preferred the number of shards at the front of the order that are preferred
+   * @return the indexes of all shards
+   */
+  std::vector<size_t> GetNewPageOrder(size_t *num_preferred);
+
+  /** The shard that the next call to NewPageImpl starts from. */
+  std::atomic<size_t> next_instance_{0};
+
+  /** The shards on every NUMA node, empty if the buffer pool is not NUMA aware. */
+  std::vector<std::vector<size_t>> node_instances_;
+};
+
+}  // namespace bustub
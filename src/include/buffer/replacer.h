@@ -16,6 +16,9 @@
 
 namespace bustub {
 
+/** The replacement policies that a buffer pool can be configured with. */
+enum class ReplacerPolicy { CLOCK, LRU_K };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -43,6 +46,13 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Forgets a frame whose page is gone, e.g. deleted or evicted by the buffer pool itself. The frame is not
+   * victimized, and the next page in it starts out like in a frame that the replacer never tracked.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
@@ -21,6 +21,17 @@
 
 namespace bustub {
 
+/**
+ * ColumnLayout is where a column sits in the tuples of a schema. The schema works the layouts out once, so that a tuple
+ * reads a column without looking up its Column, see Tuple::GetInt32().
+ */
+struct ColumnLayout {
+  /** The offset of the value in the tuple, or of the offset of its varlen data if the column is not inlined. */
+  uint32_t offset_;
+  TypeId type_id_;
+  bool inlined_;
+};
+
 class Schema {
  public:
   /**
@@ -48,6 +59,9 @@ class Schema {
    */
   const Column &GetColumn(const uint32_t col_idx) const { return columns_[col_idx]; }
 
+  /** @return the layout of a column in the tuples of the schema */
+  const ColumnLayout &GetColumnLayout(const uint32_t col_idx) const { return layouts_[col_idx]; }
+
   /**
    * @param col_name name of the wanted column
    * @return the column with the given name
@@ -93,6 +107,9 @@ class Schema {
   /** All the columns in the schema, inlined and uninlined. */
   std::vector<Column> columns_;
 
+  /** The layouts of the columns, one per column. */
+  std::vector<ColumnLayout> layouts_;
+
   /** True if all the columns are inlined, false otherwise. */
   bool tuple_is_inlined_;
 
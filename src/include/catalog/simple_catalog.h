@@ -1,13 +1,24 @@
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
+#include "catalog/table_partitioning.h"
+#include "catalog/table_statistics.h"
+#include "common/rcu_pointer.h"
 #include "storage/index/index.h"
+#include "storage/index/linear_probe_hash_table_index.h"
+#include "storage/page/catalog_page.h"
+#include "storage/table/lsm_table.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -15,8 +26,8 @@ namespace bustub {
 /**
  * Typedefs
  */
-using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
+using index_oid_t = uint32_t;
 
 /**
  * Metadata about a table.
@@ -28,11 +39,70 @@ struct TableMetadata {
   std::string name_;
   std::unique_ptr<TableHeap> table_;
   table_oid_t oid_;
+  /** The rows of a table of the LSM layout, nullptr for the others. Its heap has no rows, and carries its locks. */
+  std::unique_ptr<LsmTable> lsm_;
+  /** The statistics of the table, which inserts through an InsertExecutor keep up to date, see AnalyzeTable(). */
+  TableStatistics stats_{&schema_};
+  /**
+   * How the rows of a partitioned table are dealt out to its partitions, nullptr for the other tables. The heap of a
+   * partitioned table has no rows, the heaps of its partitions hold them.
+   */
+  std::unique_ptr<TablePartitioning> partitioning_;
+  /** The partitions of a partitioned table, in order, see SimpleCatalog::CreatePartitionedTable(). */
+  std::vector<TableMetadata *> partitions_;
+  /** The partitioned table that this table is a partition of, nullptr if none. */
+  TableMetadata *parent_{nullptr};
+
+  /** @return the table that holds a tuple of this table: its partition, or this table if it is not partitioned */
+  TableMetadata *TableOf(const Tuple &tuple) {
+    return partitioning_ == nullptr ? this : partitions_[partitioning_->PartitionOf(tuple, &schema_)];
+  }
+};
+
+/**
+ * Metadata about an index.
+ */
+struct IndexInfo {
+  IndexInfo(std::unique_ptr<Index> &&index, std::string name, std::string table_name, index_oid_t oid)
+      : index_(std::move(index)), name_(std::move(name)), table_name_(std::move(table_name)), oid_(oid) {}
+  /** The index, whose metadata names the key columns of the table and holds the schema of the keys. */
+  std::unique_ptr<Index> index_;
+  std::string name_;
+  std::string table_name_;
+  index_oid_t oid_;
+};
+
+/**
+ * An immutable version of the maps of a SimpleCatalog, which lookups read, see RcuPointer. The metadata that it points
+ * to is owned by the catalog and lives as long as the catalog.
+ */
+struct CatalogSnapshot {
+  /** tables_ : table identifiers -> table metadata */
+  std::unordered_map<table_oid_t, TableMetadata *> tables_;
+  /** names_ : table names -> table identifiers */
+  std::unordered_map<std::string, table_oid_t> names_;
+  /** indexes_ : index identifiers -> index metadata */
+  std::unordered_map<index_oid_t, IndexInfo *> indexes_;
+  /** index_names_ : table names -> index names -> index identifiers */
+  std::unordered_map<std::string, std::unordered_map<std::string, index_oid_t>> index_names_;
 };
 
 /**
- * SimpleCatalog is a non-persistent catalog that is designed for the executor to use.
- * It handles table creation and table lookup.
+ * SimpleCatalog is a catalog that is designed for the executor to use.
+ * It handles table and index creation and lookup.
+ *
+ * A persistent catalog keeps its metadata in a directory of CatalogPages that starts at HEADER_PAGE_ID, with the
+ * schema and first page of every table, the definition of every index and the statistics that AnalyzeTable() gathered.
+ * Opening it reads the first page of the directory only: a table is loaded on its first lookup, together with its
+ * indexes, so that startup takes as long for a thousand tables as for one. The metadata is written back as soon as it
+ * changes, and is not logged.
+ *
+ * Lookups read an immutable snapshot of the maps of the catalog, see CatalogSnapshot, without taking a latch, so that
+ * the Init() of many concurrent short queries does not contend on the catalog. Creating a table or an index, or loading
+ * one, copies the snapshot under a writer latch and publishes the copy atomically.
+ *
+ * The hash indexes cannot reopen their pages, so a persistent index is rebuilt from its table when it is loaded. A
+ * table laid out by column keeps the dictionaries of its VARCHAR columns in memory, so it is not persisted at all.
  */
 class SimpleCatalog {
  public:
@@ -46,33 +116,380 @@ class SimpleCatalog {
       : bpm_{bpm}, lock_manager_{lock_manager}, log_manager_{log_manager} {}
 
   /**
-   * Create a new table and return its metadata.
+   * Opens the persistent catalog of a database, or creates it if the database has none yet. A new catalog must be
+   * created before any other page of the database is allocated, so that its directory starts at HEADER_PAGE_ID.
+   * @param bpm the buffer pool manager backing tables created by this catalog
+   * @param lock_manager the lock manager in use by the system
+   * @param log_manager the log manager in use by the system
+   * @param persistent true to open the persistent catalog, false for a catalog like the one above
+   */
+  SimpleCatalog(BufferPoolManager *bpm, LockManager *lock_manager, LogManager *log_manager, bool persistent);
+
+  /**
+   * Create a new table, which keeps a zone map of its pages, and return its metadata.
    * @param txn the transaction in which the table is being created
    * @param table_name the name of the new table
    * @param schema the schema of the new table
+   * @param layout how the pages of the table hold its tuples, COLUMNAR dictionary encodes the VARCHAR columns, LSM
+   * keys the rows by the first column, which is an integer
    * @return a pointer to the metadata of the new table
    */
-  TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema) {
-    BUSTUB_ASSERT(names_.count(table_name) == 0, "Table names should be unique!");
-    return nullptr;
+  TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema,
+                             TableLayout layout = TableLayout::ROW) {
+    return Update([&](CatalogSnapshot *draft) {
+      BUSTUB_ASSERT(FindTable(draft, table_name) == nullptr, "Table names should be unique!");
+      table_oid_t oid = next_table_oid_++;
+      auto table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn, oid);
+      if (layout == TableLayout::COLUMNAR) {
+        table->UseColumnarLayout(schema);
+      } else if (layout == TableLayout::ROW) {
+        table->EnableOverflow(schema);
+      }
+      table->EnableZoneMap(schema);
+      auto metadata = std::make_unique<TableMetadata>(schema, table_name, std::move(table), oid);
+      if (layout == TableLayout::LSM) {
+        metadata->lsm_ = std::make_unique<LsmTable>(bpm_, schema);
+      }
+      TableMetadata *result = AddTable(draft, std::move(metadata));
+      if (persistent_ && layout == TableLayout::ROW) {
+        PersistTable(*result);
+      }
+      return result;
+    });
   }
 
-  /** @return table metadata by name */
-  TableMetadata *GetTable(const std::string &table_name) { return nullptr; }
+  /**
+   * Creates a table that is partitioned by a key column, each partition a table of the row layout with a heap of its
+   * own, see PartitionName(). The partitioned table and its partitions are not persisted.
+   * @param txn the transaction in which the table is being created
+   * @param table_name the name of the new table
+   * @param schema the schema of the new table
+   * @param partitioning how the rows of the table are dealt out to the partitions
+   * @return a pointer to the metadata of the new table, whose partitions_ are those of the partitions
+   */
+  TableMetadata *CreatePartitionedTable(Transaction *txn, const std::string &table_name, const Schema &schema,
+                                        const TablePartitioning &partitioning) {
+    return Update([&](CatalogSnapshot *draft) {
+      BUSTUB_ASSERT(FindTable(draft, table_name) == nullptr, "Table names should be unique!");
+      auto add_table = [&](const std::string &name) {
+        table_oid_t oid = next_table_oid_++;
+        auto table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn, oid);
+        table->EnableOverflow(schema);
+        table->EnableZoneMap(schema);
+        return AddTable(draft, std::make_unique<TableMetadata>(schema, name, std::move(table), oid));
+      };
+      TableMetadata *result = add_table(table_name);
+      result->partitioning_ = std::make_unique<TablePartitioning>(partitioning);
+      for (size_t i = 0; i < partitioning.GetNumPartitions(); i++) {
+        BUSTUB_ASSERT(FindTable(draft, PartitionName(table_name, i)) == nullptr, "Table names should be unique!");
+        TableMetadata *partition = add_table(PartitionName(table_name, i));
+        partition->parent_ = result;
+        result->partitions_.push_back(partition);
+      }
+      return result;
+    });
+  }
+
+  /** @return the name of a partition of a partitioned table, by which it is a table of the catalog of its own */
+  static std::string PartitionName(const std::string &table_name, size_t partition) {
+    return table_name + "$" + std::to_string(partition);
+  }
+
+  /** @return table metadata by name, throws std::out_of_range if the table does not exist */
+  TableMetadata *GetTable(const std::string &table_name) {
+    TableMetadata *table_info = snapshot_.Read([&](const CatalogSnapshot &snapshot) -> TableMetadata * {
+      auto it = snapshot.names_.find(table_name);
+      return it == snapshot.names_.end() ? nullptr : snapshot.tables_.at(it->second);
+    });
+    if (table_info == nullptr && persistent_) {
+      table_info = Update([&](CatalogSnapshot *draft) { return FindTable(draft, table_name); });
+    }
+    if (table_info == nullptr) {
+      throw std::out_of_range("Table " + table_name + " does not exist.");
+    }
+    return table_info;
+  }
+
+  /** @return table metadata by oid, throws std::out_of_range if the table does not exist */
+  TableMetadata *GetTable(table_oid_t table_oid) {
+    TableMetadata *table_info = snapshot_.Read([&](const CatalogSnapshot &snapshot) -> TableMetadata * {
+      auto it = snapshot.tables_.find(table_oid);
+      return it == snapshot.tables_.end() ? nullptr : it->second;
+    });
+    if (table_info == nullptr && persistent_) {
+      table_info = Update([&](CatalogSnapshot *draft) { return LoadTable(draft, table_oid); });
+    }
+    if (table_info == nullptr) {
+      throw std::out_of_range("Table " + std::to_string(table_oid) + " does not exist.");
+    }
+    return table_info;
+  }
 
-  /** @return table metadata by oid */
-  TableMetadata *GetTable(table_oid_t table_oid) { return nullptr; }
+  /**
+   * Gathers the statistics of a table afresh from all of its tuples, see TableStatistics::Analyze().
+   * @param txn the transaction that reads the table
+   * @param table_name the name of the table, which must exist
+   * @return a pointer to the metadata of the table
+   */
+  TableMetadata *AnalyzeTable(Transaction *txn, const std::string &table_name) {
+    TableMetadata *table_info = GetTable(table_name);
+    // The heap of an LSM table has no tuples, it keeps the statistics of its inserts.
+    if (table_info->lsm_ != nullptr) {
+      return table_info;
+    }
+    // The heaps of the partitions of a partitioned table hold its tuples, each partition has statistics of its own.
+    if (table_info->partitioning_ != nullptr) {
+      std::vector<TableHeap *> heaps;
+      for (TableMetadata *partition : table_info->partitions_) {
+        partition->stats_.Analyze(partition->table_.get(), txn);
+        heaps.push_back(partition->table_.get());
+      }
+      table_info->stats_.Analyze(heaps, txn);
+      return table_info;
+    }
+    table_info->stats_.Analyze(table_info->table_.get(), txn);
+    if (persistent_) {
+      std::scoped_lock lock(writer_latch_);
+      PersistStatistics(*table_info);
+    }
+    return table_info;
+  }
+
+  /**
+   * Creates a hash index on a table, see CreateLinearProbeHashTableIndex(), and fills it with the tuples that the
+   * table holds. Inserts through an InsertExecutor keep the index up to date from then on.
+   * @param txn the transaction in which the index is being created
+   * @param index_name the name of the new index
+   * @param table_name the name of the table to index, which must exist
+   * @param key_attrs the columns of the table that make up the key
+   * @param num_buckets the initial number of buckets of the hash table
+   * @return a pointer to the metadata of the new index, nullptr if the key is too wide for a hash index
+   */
+  IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
+                         const std::vector<uint32_t> &key_attrs, size_t num_buckets) {
+    TableMetadata *table_info = GetTable(table_name);
+    BUSTUB_ASSERT(!HasIndex(index_name, table_name), "Index names should be unique per table!");
+    BUSTUB_ASSERT(table_info->lsm_ == nullptr, "An LSM table has no indexes!");
+    BUSTUB_ASSERT(table_info->partitioning_ == nullptr, "A partitioned table is indexed by CreatePartitionedIndex()!");
+    auto index = CreateLinearProbeHashTableIndex(
+        new IndexMetadata(index_name, table_name, &table_info->schema_, key_attrs), bpm_, num_buckets);
+    if (index == nullptr) {
+      return nullptr;
+    }
+    const Schema *key_schema = index->GetKeySchema();
+    for (auto it = table_info->table_->Begin(txn); it != table_info->table_->End(); ++it) {
+      index->InsertEntry(it->KeyFromTuple(table_info->schema_, *key_schema, key_attrs), it->GetRid(), txn);
+    }
+    return Update([&](CatalogSnapshot *draft) {
+      index_oid_t oid = next_index_oid_++;
+      IndexInfo *result = AddIndex(draft, std::make_unique<IndexInfo>(std::move(index), index_name, table_name, oid));
+      if (persistent_ && table_info->table_->GetColumnarSchema() == nullptr && table_info->parent_ == nullptr) {
+        PersistIndex(*result, table_info->oid_, key_attrs, num_buckets);
+      }
+      return result;
+    });
+  }
+
+  /**
+   * Creates a hash index on every partition of a partitioned table, see CreateIndex(), each of the name, with the
+   * same key columns, and as many buckets.
+   * @return the metadata of the index of each partition, in order, none if the key is too wide for a hash index
+   */
+  std::vector<IndexInfo *> CreatePartitionedIndex(Transaction *txn, const std::string &index_name,
+                                                  const std::string &table_name,
+                                                  const std::vector<uint32_t> &key_attrs, size_t num_buckets) {
+    TableMetadata *table_info = GetTable(table_name);
+    BUSTUB_ASSERT(table_info->partitioning_ != nullptr, "The table is not partitioned!");
+    std::vector<IndexInfo *> result;
+    for (TableMetadata *partition : table_info->partitions_) {
+      IndexInfo *index_info = CreateIndex(txn, index_name, partition->name_, key_attrs, num_buckets);
+      if (index_info == nullptr) {
+        return {};
+      }
+      result.push_back(index_info);
+    }
+    return result;
+  }
+
+  /** @return index metadata by oid, throws std::out_of_range if the index does not exist */
+  IndexInfo *GetIndex(index_oid_t index_oid) {
+    IndexInfo *index_info = snapshot_.Read([&](const CatalogSnapshot &snapshot) -> IndexInfo * {
+      auto it = snapshot.indexes_.find(index_oid);
+      return it == snapshot.indexes_.end() ? nullptr : it->second;
+    });
+    if (index_info == nullptr && persistent_) {
+      index_info = Update([&](CatalogSnapshot *draft) { return LoadIndex(draft, index_oid); });
+    }
+    if (index_info == nullptr) {
+      throw std::out_of_range("Index " + std::to_string(index_oid) + " does not exist.");
+    }
+    return index_info;
+  }
+
+  /** @return index metadata by name, throws std::out_of_range if the index does not exist */
+  IndexInfo *GetIndex(const std::string &index_name, const std::string &table_name) {
+    LoadIndexes(table_name);
+    return snapshot_.Read([&](const CatalogSnapshot &snapshot) {
+      return snapshot.indexes_.at(snapshot.index_names_.at(table_name).at(index_name));
+    });
+  }
+
+  /** @return the metadata of every index on a table, none if the table has no index */
+  std::vector<IndexInfo *> GetTableIndexes(const std::string &table_name) {
+    LoadIndexes(table_name);
+    return snapshot_.Read([&](const CatalogSnapshot &snapshot) {
+      std::vector<IndexInfo *> result;
+      auto it = snapshot.index_names_.find(table_name);
+      if (it != snapshot.index_names_.end()) {
+        for (const auto &name_oid : it->second) {
+          result.push_back(snapshot.indexes_.at(name_oid.second));
+        }
+      }
+      return result;
+    });
+  }
+
+  /**
+   * Adds the metrics of the indexes that have been loaded to a snapshot, labeled with their table and name, see
+   * MetricsRegistry.
+   * @param snapshot the snapshot to add the metrics to
+   */
+  void CollectMetrics(MetricsSnapshot *snapshot) {
+    auto indexes = snapshot_.Read([](const CatalogSnapshot &catalog) {
+      std::vector<IndexInfo *> result;
+      for (const auto &oid_index : catalog.indexes_) {
+        result.push_back(oid_index.second);
+      }
+      return result;
+    });
+    for (IndexInfo *index_info : indexes) {
+      index_info->index_->CollectMetrics(
+          snapshot, "table=\"" + index_info->table_name_ + "\",index=\"" + index_info->name_ + "\"");
+    }
+  }
 
  private:
-  [[maybe_unused]] BufferPoolManager *bpm_;
-  [[maybe_unused]] LockManager *lock_manager_;
-  [[maybe_unused]] LogManager *log_manager_;
+  /**
+   * Changes a copy of the current snapshot under the writer latch, and publishes the copy if fn added metadata to it.
+   * @param fn called as fn(draft), with the copy
+   * @return what fn returned
+   */
+  template <class Fn>
+  std::invoke_result_t<Fn, CatalogSnapshot *> Update(Fn &&fn) {
+    std::scoped_lock lock(writer_latch_);
+    auto draft = std::make_unique<CatalogSnapshot>(snapshot_.GetForWriter());
+    const size_t num_objects = draft->tables_.size() + draft->indexes_.size();
+    auto result = fn(draft.get());
+    if (draft->tables_.size() + draft->indexes_.size() != num_objects) {
+      snapshot_.Publish(std::move(draft));
+    }
+    return result;
+  }
+
+  /** @return true if a table has an index of the name */
+  bool HasIndex(const std::string &index_name, const std::string &table_name) {
+    return snapshot_.Read([&](const CatalogSnapshot &snapshot) {
+      auto it = snapshot.index_names_.find(table_name);
+      return it != snapshot.index_names_.end() && it->second.count(index_name) != 0;
+    });
+  }
+
+  /** Loads a persistent table, and with it its indexes, if it is not loaded yet. */
+  void LoadIndexes(const std::string &table_name) {
+    if (persistent_ &&
+        !snapshot_.Read([&](const CatalogSnapshot &snapshot) { return snapshot.names_.count(table_name) != 0; })) {
+      Update([&](CatalogSnapshot *draft) { return FindTable(draft, table_name); });
+    }
+  }
+
+  /** Adds a table to a draft, and keeps its metadata. The caller holds writer_latch_. */
+  TableMetadata *AddTable(CatalogSnapshot *draft, std::unique_ptr<TableMetadata> metadata);
+
+  /** Adds an index to a draft, and keeps its metadata. The caller holds writer_latch_. */
+  IndexInfo *AddIndex(CatalogSnapshot *draft, std::unique_ptr<IndexInfo> info);
+
+  /**
+   * Looks a table up by name in a draft, loading it into the draft if it is persistent and not loaded yet. The caller
+   * holds writer_latch_.
+   * @return the metadata of the table, nullptr if it does not exist
+   */
+  TableMetadata *FindTable(CatalogSnapshot *draft, const std::string &table_name);
+
+  /**
+   * Loads a persistent table and its indexes into a draft. The caller holds writer_latch_.
+   * @return the metadata of the table, nullptr if it does not exist
+   */
+  TableMetadata *LoadTable(CatalogSnapshot *draft, table_oid_t table_oid);
+
+  /**
+   * Loads a persistent index, with its table and the other indexes of the table, into a draft. The caller holds
+   * writer_latch_.
+   * @return the metadata of the index, nullptr if it does not exist
+   */
+  IndexInfo *LoadIndex(CatalogSnapshot *draft, index_oid_t index_oid);
+
+  /**
+   * Loads the table of a TABLE entry, its statistics and its indexes into a draft. The caller holds writer_latch_.
+   * @param draft the draft
+   * @param entry the entry
+   * @param table_name the name of the table if it is known, to skip an entry of another name with the same hash
+   * @return the metadata of the table, nullptr if the entry is of another table
+   */
+  TableMetadata *LoadTable(CatalogSnapshot *draft, const CatalogEntry &entry, const std::string *table_name);
+
+  /** Writes a new table into the directory. The caller holds writer_latch_. */
+  void PersistTable(const TableMetadata &table_info);
+
+  /** Writes a new index into the directory. The caller holds writer_latch_. */
+  void PersistIndex(const IndexInfo &index_info, table_oid_t table_oid, const std::vector<uint32_t> &key_attrs,
+                    size_t num_buckets);
+
+  /**
+   * Writes the statistics of a table into the directory, replacing those written before. The caller holds
+   * writer_latch_.
+   */
+  void PersistStatistics(const TableMetadata &table_info);
+
+  /**
+   * Walks the entries of the directory.
+   * @param fn called as fn(entry, location) for every entry, the location being the page and the slot of the entry,
+   * until it returns true
+   */
+  void ForEachEntry(const std::function<bool(const CatalogEntry &, const RID &)> &fn);
+
+  /** Appends an entry to the directory, growing it by a page if its last page is full. */
+  void AppendEntry(const CatalogEntry &entry);
+
+  /** Writes the oids that are handed out next to the first page of the directory. */
+  void PersistOids();
+
+  /** @return the first page of a new chain that holds a record, which is on disk */
+  page_id_t WriteRecord(const std::vector<char> &record);
+
+  /** @return the record that an entry describes */
+  std::vector<char> ReadRecord(const CatalogEntry &entry);
+
+  /** Deallocates the chain of a record that nothing points to anymore. */
+  void FreeRecord(page_id_t first_page_id);
+
+  /** True if the metadata is kept in the directory. */
+  bool persistent_{false};
+
+  BufferPoolManager *bpm_;
+  LockManager *lock_manager_;
+  LogManager *log_manager_;
+
+  /** The maps that lookups read. */
+  RcuPointer<CatalogSnapshot> snapshot_{std::make_unique<CatalogSnapshot>()};
+  /** Serializes the changes of the snapshot, and protects the metadata that the catalog owns and the directory. */
+  std::mutex writer_latch_;
+  /** The metadata of the tables and indexes, which the snapshots point to. */
+  std::vector<std::unique_ptr<TableMetadata>> tables_;
+  std::vector<std::unique_ptr<IndexInfo>> indexes_;
 
-  /** tables_ : table identifiers -> table metadata. Note that tables_ owns all table metadata. */
-  std::unordered_map<table_oid_t, std::unique_ptr<TableMetadata>> tables_;
-  /** names_ : table names -> table identifiers */
-  std::unordered_map<std::string, table_oid_t> names_;
   /** The next table identifier to be used. */
   std::atomic<table_oid_t> next_table_oid_{0};
+  /** The next index identifier to be used. */
+  std::atomic<index_oid_t> next_index_oid_{0};
 };
 }  // namespace bustub
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -12,6 +13,20 @@ namespace bustub {
 static constexpr uint32_t TEST1_SIZE = 1000;
 static constexpr uint32_t TEST2_SIZE = 100;
 static constexpr uint32_t TEST_VARLEN_SIZE = 10;
+static constexpr uint32_t GENERATE_BATCH_SIZE = 1024;  // rows that are generated and inserted at a time
+
+/** How TableGenerator generates the rows of a table and inserts them. */
+struct TableFillOptions {
+  /** Threads that generate batches of rows while the calling thread inserts them, 0 to generate them inline. */
+  size_t num_threads_{0};
+  /**
+   * Insert the rows with TableHeap::BulkInsert(), which fills whole pages and logs their images, instead of
+   * TableHeap::InsertTuples(). The transaction then locks the table exclusively, so it should have created it.
+   */
+  bool bulk_load_{false};
+  /** Seed of the values. A seed gives the same rows in the same order for any number of threads. */
+  uint64_t seed_{0};
+};
 
 class TableGenerator {
  public:
@@ -25,12 +40,45 @@ class TableGenerator {
    */
   void GenerateTestTables();
 
- private:
   /**
    * Enumeration to characterize the distribution of values in a given column
    */
   enum class Dist : uint8_t { Uniform, Zipf_50, Zipf_75, Zipf_95, Zipf_99, Serial };
 
+  /**
+   * Sampler draws integers in [min, max] from a Dist, e.g. the values of a column, or the pages that a benchmark
+   * fetches. Zipf_T draws min + k with a probability proportional to 1 / (k + 1)^(T / 100), so the smallest values are
+   * the most frequent; it uses the method of Gray et al., "Quickly Generating Billion-Record Synthetic Databases",
+   * which sums up the zeta constant once and then takes constant time per value. Serial counts up from min and wraps
+   * around after max.
+   */
+  class Sampler {
+   public:
+    Sampler(Dist dist, uint64_t min, uint64_t max, uint64_t seed = 0);
+
+    /** @return the next value */
+    uint64_t Next();
+
+    /**
+     * Restarts the draws from a new seed, and a Serial sampler from min. Cheaper than a new Zipf sampler, which sums
+     * up its zeta constant over all values.
+     */
+    void Seed(uint64_t seed);
+
+   private:
+    Dist dist_;
+    uint64_t min_;
+    uint64_t num_values_;
+    uint64_t serial_counter_{0};
+    std::mt19937_64 generator_;
+    std::uniform_real_distribution<double> unit_{0.0, 1.0};
+    // the constants of a Zipf distribution
+    double theta_{0.0};
+    double zeta_n_{0.0};
+    double alpha_{0.0};
+    double eta_{0.0};
+  };
+
   /**
    * Metadata about the data for a given column. Specifically, the type of the
    * column, the distribution of values, a min and max if appropriate.
@@ -97,12 +145,40 @@ class TableGenerator {
         : name_(name), num_rows_(num_rows), col_meta_(std::move(col_meta)) {}
   };
 
-  void FillTable(TableMetadata *info, TableInsertMeta *table_meta);
+  /**
+   * Creates a table in the catalog and fills it, see FillTable().
+   * @return the table
+   */
+  TableMetadata *GenerateTable(TableInsertMeta *table_meta, const TableFillOptions &options = TableFillOptions{});
+
+  /**
+   * Inserts the rows of a table meta into a table in batches of GENERATE_BATCH_SIZE rows, in the transaction of the
+   * executor context. Every batch draws its values from samplers seeded by the seed and the batch, so that threads can
+   * generate the batches in any order while they are inserted in order.
+   */
+  void FillTable(TableMetadata *info, TableInsertMeta *table_meta,
+                 const TableFillOptions &options = TableFillOptions{});
+
+ private:
+  /**
+   * The state of a thread that generates rows: a sampler per column, which the Zipf columns are costly to set up for,
+   * and a generator for the DECIMAL columns. Both are seeded anew for every batch.
+   */
+  struct RowGenerator {
+    std::vector<Sampler> samplers_;
+    std::mt19937_64 generator_;
+  };
+
+  /** Generates the rows of batch number batch, the rows from batch * GENERATE_BATCH_SIZE on. */
+  static std::vector<Tuple> MakeBatch(const TableMetadata *info, const TableInsertMeta &table_meta,
+                                      const TableFillOptions &options, uint64_t batch, RowGenerator *row_generator);
 
-  std::vector<Value> MakeValues(ColumnInsertMeta *col_meta, uint32_t count);
+  static std::vector<Value> MakeValues(const ColumnInsertMeta &col_meta, uint64_t first_row, uint32_t count,
+                                       Sampler *sampler, std::mt19937_64 *generator);
 
   template <typename CppType>
-  std::vector<Value> GenNumericValues(ColumnInsertMeta *col_meta, uint32_t count);
+  static std::vector<Value> GenNumericValues(const ColumnInsertMeta &col_meta, uint64_t first_row, uint32_t count,
+                                             Sampler *sampler, std::mt19937_64 *generator);
 
  private:
   ExecutorContext *exec_ctx_;
@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_partitioning.h
+//
+// Identification: src/include/catalog/table_partitioning.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+class AbstractExpression;
+
+/** How the rows of a partitioned table are dealt out to its partitions. */
+enum class PartitionKind : uint8_t { HASH, RANGE };
+
+/**
+ * TablePartitioning splits the rows of a table into partitions by the value of a key column, each partition a table of
+ * its own, with its own heap and indexes, see SimpleCatalog::CreatePartitionedTable().
+ *
+ * A HASH partitioning deals the rows out by the hash of their key, see HashUtil::HashValue(), so that the integer
+ * types of any width deal alike. A RANGE partitioning deals them out by ascending bounds: partition i holds the keys
+ * from bounds[i - 1] up to, but not including, bounds[i], the first and the last partitions are open-ended. A null key
+ * goes to partition 0.
+ *
+ * Prune() tells the partitions that a predicate may hold in, so that a scan reads those only. The tables of two
+ * partitionings that are alike, see IsCoPartitionedWith(), hold the rows whose keys are equal in the partitions of the
+ * same index, so that a join on their keys joins one pair of partitions at a time.
+ */
+class TablePartitioning {
+ public:
+  /**
+   * @param schema the schema of the table
+   * @param col_idx the key column
+   * @param num_partitions the number of partitions, at least 1
+   * @return a HASH partitioning
+   */
+  static TablePartitioning Hash(const Schema &schema, uint32_t col_idx, size_t num_partitions);
+
+  /**
+   * @param schema the schema of the table
+   * @param col_idx the key column
+   * @param bounds the ascending bounds between the partitions, of which there are one more than bounds
+   * @return a RANGE partitioning
+   */
+  static TablePartitioning Range(const Schema &schema, uint32_t col_idx, std::vector<Value> bounds);
+
+  PartitionKind GetKind() const { return kind_; }
+
+  /** @return the key column */
+  uint32_t GetColIdx() const { return col_idx_; }
+
+  size_t GetNumPartitions() const { return num_partitions_; }
+
+  /** @return the partition of a key */
+  size_t PartitionOf(const Value &key) const;
+
+  /** @return the partition of a tuple of the table */
+  size_t PartitionOf(const Tuple &tuple, const Schema *schema) const {
+    return PartitionOf(tuple.GetValue(schema, col_idx_));
+  }
+
+  /**
+   * Works out the partitions that the tuples which pass a predicate may be in. A predicate that compares the key column
+   * with a constant prunes the others, any other predicate prunes none.
+   * @param predicate the predicate on the tuples of the table, nullptr for none
+   * @return for each partition, false if no tuple of it passes the predicate
+   */
+  std::vector<bool> Prune(const AbstractExpression *predicate) const;
+
+  /**
+   * @return true if the tables of the two partitionings keep the rows of equal keys in the partitions of the same
+   * index, i.e. they are of the same kind, with as many partitions, the same bounds, and keys of types that hash alike
+   */
+  bool IsCoPartitionedWith(const TablePartitioning &other) const;
+
+ private:
+  TablePartitioning(PartitionKind kind, TypeId key_type, uint32_t col_idx, size_t num_partitions,
+                    std::vector<Value> bounds)
+      : kind_(kind),
+        key_type_(key_type),
+        col_idx_(col_idx),
+        num_partitions_(num_partitions),
+        bounds_(std::move(bounds)) {}
+
+  /** @return true if the values of two types of keys hash alike, see HashUtil::HashValue() */
+  static bool HashAlike(TypeId a, TypeId b);
+
+  PartitionKind kind_;
+  TypeId key_type_;
+  uint32_t col_idx_;
+  size_t num_partitions_;
+  /** The bounds between the partitions of a RANGE partitioning. */
+  std::vector<Value> bounds_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_statistics.h
+//
+// Identification: src/include/catalog/table_statistics.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/util/hyper_log_log.h"
+#include "concurrency/transaction.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+class AbstractExpression;
+class TableHeap;
+
+/** The statistics of a column of a table. */
+struct ColumnStatistics {
+  /** The sketch has 2^SKETCH_BITS registers. */
+  static constexpr size_t SKETCH_BITS = 8;
+
+  /** The number of nulls. */
+  size_t num_nulls_{0};
+  /** The smallest and the largest value that is not null, both unset until there is one. */
+  bool has_values_{false};
+  Value min_;
+  Value max_;
+  /**
+   * The upper bounds of the buckets of an equi-depth histogram of the values that are not null, in increasing order:
+   * about as many values fall into each bucket, those up to its bound and above that of the bucket before. Built by
+   * TableStatistics::Analyze(), empty until then.
+   */
+  std::vector<Value> bounds_;
+  /** A sketch of the hashes of the values that are not null. */
+  HyperLogLog<SKETCH_BITS> sketch_;
+};
+
+/**
+ * TableStatistics estimates how many tuples of a table pass a predicate, for a planner to choose plans by, see
+ * JoinPlanner. It counts the tuples of the table, and for each column the nulls, the bounds of the values and,
+ * by a HyperLogLog sketch, how many distinct values there are.
+ *
+ * The statistics are kept up to date as tuples are inserted through an InsertExecutor, see Add(), except for the
+ * histograms of the columns, which take a pass over the whole table, see Analyze(), like ANALYZE. Deletes and aborted
+ * inserts are not taken back out, so the counts only stay estimates until the table is analyzed again.
+ */
+class TableStatistics {
+ public:
+  /** The selectivity of a predicate whose selectivity is not known. */
+  static constexpr double DEFAULT_SELECTIVITY = 1.0 / 3;
+  /** The number of buckets of the histograms. */
+  static constexpr size_t HISTOGRAM_BUCKETS = 32;
+
+  /** Creates the statistics of an empty table of a schema, which must outlive them. */
+  explicit TableStatistics(const Schema *schema) : schema_(schema), columns_(schema->GetColumnCount()) {}
+
+  /** Counts inserted tuples of the table in. */
+  void Add(const std::vector<Tuple> &tuples);
+
+  /**
+   * Gathers the statistics of the table afresh from all of its tuples, histograms included.
+   * @param table the table
+   * @param txn the transaction that reads the table
+   */
+  void Analyze(TableHeap *table, Transaction *txn) { Analyze(std::vector<TableHeap *>{table}, txn); }
+
+  /**
+   * Gathers the statistics of a table whose tuples are held by several heaps, e.g. its partitions.
+   * @param tables the heaps of the table
+   * @param txn the transaction that reads the table
+   */
+  void Analyze(const std::vector<TableHeap *> &tables, Transaction *txn);
+
+  /** @return true if the statistics were gathered by Analyze() */
+  bool IsAnalyzed() const;
+
+  /** @return the number of tuples of the table */
+  size_t GetNumRows() const;
+
+  /** @return the statistics of a column */
+  ColumnStatistics GetColumn(uint32_t col_idx) const;
+
+  /** @return the estimated number of distinct values of a column, but for nulls, at least one if it has any */
+  size_t GetNumDistinct(uint32_t col_idx) const;
+
+  /**
+   * Estimates the fraction of the tuples of the table that pass a predicate. A comparison of a column with a constant
+   * is estimated from the statistics of the column, anything else by DEFAULT_SELECTIVITY.
+   * @param predicate the predicate, on tuples of the table, nullptr for none
+   * @return the fraction, from 0 to 1
+   */
+  double EstimateSelectivity(const AbstractExpression *predicate) const;
+
+  /**
+   * Appends the statistics to a buffer, so that they outlive a restart, see SimpleCatalog.
+   * @param[out] buffer the buffer
+   */
+  void SerializeTo(std::vector<char> *buffer) const;
+
+  /**
+   * Replaces the statistics by serialized ones, of a table of the same schema.
+   * @param data the statistics, as SerializeTo() wrote them
+   * @param size the size of the data in bytes
+   * @return false if the data is not a complete serialization, the statistics are left alone then
+   */
+  bool DeserializeFrom(const char *data, size_t size);
+
+ private:
+  /** Counts a tuple in. Called with the latch held. */
+  void AddTuple(const Tuple &tuple);
+
+  /** @return the estimate of GetNumDistinct() from the sketch of a column */
+  static size_t EstimateDistinct(const ColumnStatistics &column, size_t num_values);
+
+  const Schema *schema_;
+  mutable std::mutex latch_;
+  size_t num_rows_{0};
+  bool analyzed_{false};
+  std::vector<ColumnStatistics> columns_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,197 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_logger.h
+//
+// Identification: src/include/common/async_logger.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <thread>  // NOLINT
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace bustub {
+
+/** A string argument of a log message, copied so that the message can be formatted after the string is gone. */
+struct LogString {
+  static constexpr size_t CAPACITY = 64;
+
+  explicit LogString(const char *str) {
+    if (str == nullptr) {
+      str = "(null)";
+    }
+    const size_t length = strnlen(str, CAPACITY - 1);
+    memcpy(data_, str, length);
+    data_[length] = '\0';
+  }
+
+  char data_[CAPACITY];
+};
+
+/**
+ * AsyncLogger takes the formatting and the writing of log messages off the threads that log them. The LOG_XXX macros
+ * of logger.h hand their messages to it once it has been started: a message is copied as it is, its format string
+ * and its raw arguments, into a slot of a bounded lock-free ring buffer, and a background thread formats the messages
+ * and writes them out in the order of their slots. A message that finds the ring buffer full is dropped and counted
+ * rather than waited for, so that logging never holds up the thread that logs, even under load.
+ *
+ * Until Start() and after Stop(), the macros format and write their messages on the calling thread, as before.
+ *
+ * Messages are written with the header of OutputLogHeader(), stamped with the time they were logged at. Strings are
+ * copied up to LogString::CAPACITY - 1 characters; other arguments are copied by value, so pointers are printed but
+ * not followed, as with %p.
+ */
+class AsyncLogger {
+ public:
+  /** The number of bytes of a slot that hold the arguments of a message. */
+  static constexpr size_t ARGS_SIZE = 256;
+
+  /**
+   * Starts the background thread. A ring buffer of the given capacity is made by the first Start(), and kept until
+   * the process exits, so that a thread that logs while the logger stops never writes to freed memory.
+   * @param capacity the number of messages that the ring buffer holds, rounded up to a power of two
+   */
+  static void Start(size_t capacity = 1 << 16);
+
+  /**
+   * Writes the messages in the ring buffer, and stops the background thread. A message that is logged while the
+   * logger stops may be written by the next Start(), or not at all.
+   */
+  static void Stop();
+
+  /** @return true between Start() and Stop() */
+  static bool IsRunning() { return running_.load(std::memory_order_relaxed); }
+
+  /** @return the number of messages that were dropped because the ring buffer was full */
+  static uint64_t GetNumDropped() { return num_dropped_.load(std::memory_order_relaxed); }
+
+  /**
+   * Hands a message to the background thread, see the LOG_XXX macros.
+   * @return false if the logger is not running, and the caller has to write the message itself
+   */
+  template <class... Args>
+  static bool Log(const char *file, int line, const char *func, int level, const char *format, Args... args) {
+    if (!IsRunning()) {
+      return false;
+    }
+    Slot *slot = Reserve();
+    if (slot == nullptr) {
+      num_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    slot->file_ = file;
+    slot->line_ = line;
+    slot->func_ = func;
+    slot->level_ = level;
+    slot->format_ = format;
+    slot->time_ = ::time(nullptr);
+    using Captured = std::tuple<typename Capture<Args>::Type...>;
+    if constexpr (sizeof(Captured) <= ARGS_SIZE && alignof(Captured) <= alignof(std::max_align_t)) {
+      static_assert((std::is_trivially_copyable_v<typename Capture<Args>::Type> && ...),
+                    "Only scalars and strings can be logged.");
+      new (slot->args_) Captured(typename Capture<Args>::Type(args)...);
+      slot->format_fn_ = &FormatCaptured<Captured>;
+    } else {
+      // Too many arguments to copy, the message is formatted right away, cut short to fit.
+      FormatMessage(slot->args_, ARGS_SIZE, format, args...);
+      slot->format_fn_ = &FormatText;
+    }
+    Publish(slot);
+    return true;
+  }
+
+ private:
+  /** A message in the ring buffer. */
+  struct Slot {
+    /** The position in the ring buffer that the slot is free for or, once published, one past it. */
+    std::atomic<size_t> sequence_;
+    const char *file_;
+    int line_;
+    const char *func_;
+    int level_;
+    const char *format_;
+    time_t time_;
+    /** Formats the message of a slot, instantiated for the types of its arguments. */
+    void (*format_fn_)(const Slot &slot, char *buf, size_t size);
+    alignas(std::max_align_t) char args_[ARGS_SIZE];
+  };
+
+  /** The type that an argument is copied as. */
+  template <class T>
+  struct Capture {
+    using Type = T;
+  };
+
+  /** @return a captured argument as printf expects it */
+  static const char *Get(const LogString &value) { return value.data_; }
+  template <class T>
+  static const T &Get(const T &value) {
+    return value;
+  }
+
+  template <class... Args>
+  static void FormatMessage(char *buf, size_t size, const char *format, Args... args) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-security"
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    snprintf(buf, size, format, args...);
+#pragma GCC diagnostic pop
+  }
+
+  template <class Captured>
+  static void FormatCaptured(const Slot &slot, char *buf, size_t size) {
+    const auto *captured = reinterpret_cast<const Captured *>(slot.args_);
+    std::apply([&](const auto &... args) { FormatMessage(buf, size, slot.format_, Get(args)...); }, *captured);
+  }
+
+  static void FormatText(const Slot &slot, char *buf, size_t size) { snprintf(buf, size, "%s", slot.args_); }
+
+  /** @return a free slot, which the caller fills and publishes, nullptr if the ring buffer is full */
+  static Slot *Reserve();
+
+  /** Hands a filled slot to the background thread. */
+  static void Publish(Slot *slot) {
+    slot->sequence_.store(slot->sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /** Formats and writes the published messages until Stop(). */
+  static void Run();
+
+  /** @return true if a message was written */
+  static bool WriteNext();
+
+  static std::atomic<bool> running_;
+  static std::atomic<uint64_t> num_dropped_;
+  static std::unique_ptr<Slot[]> slots_;
+  static size_t mask_;
+  static std::atomic<size_t> enqueue_pos_;
+  static size_t dequeue_pos_;
+  static std::thread *thread_;
+};
+
+template <>
+struct AsyncLogger::Capture<const char *> {
+  using Type = LogString;
+};
+
+template <>
+struct AsyncLogger::Capture<char *> {
+  using Type = LogString;
+};
+
+}  // namespace bustub
@@ -10,45 +10,102 @@
 //
 //===----------------------------------------------------------------------===//
 
+#pragma once
+
+#include <algorithm>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "common/config.h"
+#include "common/exception.h"
+#include "common/memory_accounting.h"
+#include "common/task_scheduler.h"
+#include "common/util/metrics.h"
+#include "common/util/numa_util.h"
 #include "concurrency/lock_manager.h"
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/table/vacuum_manager.h"
 
 namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  /**
+   * Creates a new BustubInstance.
+   * @param db_file_name the database file
+   * @param config the sizes of the buffer pool and the log
+   */
+  explicit BustubInstance(const std::string &db_file_name, const BustubConfig &config = BustubConfig{}) {
+    if (config.page_size != PAGE_SIZE) {
+      throw Exception("BusTub was built with a page size of " + std::to_string(PAGE_SIZE) + " bytes.");
+    }
     enable_logging = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = new DiskManager(db_file_name, config.direct_io ? DiskIOMode::DIRECT : DiskIOMode::BUFFERED,
+                                    config.compress_pages, config.stripe_dirs, config.capacity_dir);
+    disk_manager_->SetVerifyChecksums(config.verify_checksums);
+    disk_manager_->SetCompressLog(config.compress_log);
 
     // log related
-    log_manager_ = new LogManager(disk_manager_);
+    log_manager_ = new LogManager(disk_manager_, config.log_buffer_size);
 
-    buffer_pool_manager_ = new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    const size_t num_nodes = config.numa_aware ? NumaUtil::GetNumNodes() : 1;
+    if (num_nodes > 1) {
+      buffer_pool_manager_ = new ParallelBufferPoolManager(
+          num_nodes, std::max<size_t>(config.buffer_pool_size / num_nodes, 1), disk_manager_, log_manager_,
+          ReplacerPolicy::CLOCK, config.max_buffer_pool_size / num_nodes, true);
+    } else {
+      buffer_pool_manager_ = new BufferPoolManager(config.buffer_pool_size, disk_manager_, log_manager_,
+                                                   ReplacerPolicy::CLOCK, config.max_buffer_pool_size);
+    }
+    if (!config.warm_start_file.empty()) {
+      buffer_pool_manager_->RestoreResidentPages(config.warm_start_file);
+      buffer_pool_manager_->StartWarmStartDumps(config.warm_start_file);
+    }
 
     // txn related
     lock_manager_ = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);  // S2PL
     transaction_manager_ = new TransactionManager(lock_manager_, log_manager_);
+    transaction_manager_->SetSynchronousCommit(config.synchronous_commit);
 
     // checkpoints
     checkpoint_manager_ = new CheckpointManager(transaction_manager_, log_manager_, buffer_pool_manager_);
+
+    // vacuum
+    vacuum_manager_ = new VacuumManager(transaction_manager_);
+
+    // the workers of the parallel operators, see ExecutorContext::SetScheduler()
+    const size_t num_threads =
+        config.scheduler_threads != 0 ? config.scheduler_threads : std::max(std::thread::hardware_concurrency(), 1U);
+    task_scheduler_ = new TaskScheduler(num_threads, config.pin_scheduler_threads);
+
+    // metrics, the components keep their own counters and are read at each collection
+    metrics_registry_ = new MetricsRegistry();
+    metrics_registry_->AddCollector([this](MetricsSnapshot *snapshot) {
+      disk_manager_->CollectMetrics(snapshot);
+      log_manager_->CollectMetrics(snapshot);
+      buffer_pool_manager_->CollectMetrics(snapshot);
+      lock_manager_->CollectMetrics(snapshot);
+      MemoryAccounting::CollectMetrics(snapshot);
+    });
   }
 
   ~BustubInstance() {
     if (enable_logging) {
       log_manager_->StopFlushThread();
     }
+    delete metrics_registry_;
+    delete task_scheduler_;
+    delete vacuum_manager_;
     delete checkpoint_manager_;
-    delete log_manager_;
+    // The buffer pool writes back its dirty pages when it is deleted, after their records.
     delete buffer_pool_manager_;
+    delete log_manager_;
     delete lock_manager_;
     delete transaction_manager_;
     delete disk_manager_;
@@ -60,6 +117,11 @@ class BustubInstance {
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
   CheckpointManager *checkpoint_manager_;
+  VacuumManager *vacuum_manager_;
+  /** The workers that the parallel operators of the queries run on, shared so that they do not oversubscribe. */
+  TaskScheduler *task_scheduler_;
+  /** The metrics of the components, e.g. for a Prometheus scrape with metrics_registry_->ExportText(). */
+  MetricsRegistry *metrics_registry_;
 };
 
 }  // namespace bustub
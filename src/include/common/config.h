@@ -14,19 +14,52 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 namespace bustub {
 
+/** Dirty pages are written back by the buffer pool's background flusher every FLUSH_INTERVAL milliseconds. */
+extern std::chrono::milliseconds flush_interval;
+
+/** The background flusher is woken up early once this percentage of a buffer pool's frames is dirty. */
+extern std::atomic<size_t> dirty_page_high_water_mark;
+
+/** The resident pages of a buffer pool are written to its warm start file every WARM_START_INTERVAL milliseconds. */
+extern std::chrono::milliseconds warm_start_interval;
+
+/** A checkpoint writes back a batch of CHECKPOINT_FLUSH_BATCH dirty pages every CHECKPOINT_FLUSH_INTERVAL ms. */
+extern std::chrono::milliseconds checkpoint_flush_interval;
+
+/** The background vacuum of a VacuumManager vacuums its tables every VACUUM_INTERVAL milliseconds. */
+extern std::chrono::milliseconds vacuum_interval;
+
+/** A tiered disk manager moves extents between its tiers every TIER_MIGRATION_INTERVAL milliseconds. */
+extern std::chrono::milliseconds tier_migration_interval;
+
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
 extern std::chrono::milliseconds cycle_detection_interval;
 
+/** With wound-wait, a waiting transaction checks every WOUND_CHECK_INTERVAL milliseconds whether it was wounded. */
+extern std::chrono::milliseconds wound_check_interval;
+
+/** A transaction's row locks on a table are escalated to a table lock at LOCK_ESCALATION_THRESHOLD rows, 0: never. */
+extern std::atomic<size_t> lock_escalation_threshold;
+
 /** True if logging should be enabled, false otherwise. */
 extern std::atomic<bool> enable_logging;
 
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** The commit record of an asynchronous commit is flushed to disk within ASYNC_COMMIT_DELAY milliseconds. */
+extern std::chrono::milliseconds async_commit_delay;
+
+/** An asynchronous commit waits until no more than ASYNC_COMMIT_MAX_LAG log records are not on disk yet. */
+extern std::atomic<int> async_commit_max_lag;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
@@ -35,6 +68,63 @@ static constexpr int PAGE_SIZE = 4096;                                        //
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int LRUK_REPLACER_K = 2;                                     // history length of LRU-K
+static constexpr int SCAN_RING_SIZE = 32;                                     // frames recycled by a large scan
+static constexpr int SCAN_MORSEL_PAGES = 64;                                  // pages a parallel scan worker takes
+static constexpr int READ_AHEAD_TRIGGER = 2;                                  // sequential misses before read-ahead
+static constexpr int READ_AHEAD_PAGES = 4;                                    // pages read ahead of a scan
+static constexpr int WARM_START_READERS = 4;                                  // threads reading a warm start
+static constexpr int OPTIMISTIC_READ_RETRIES = 3;                             // optimistic reads before latching
+static constexpr unsigned IO_URING_QUEUE_DEPTH = 64;                          // page I/Os in flight per disk manager
+static constexpr int EXTENT_SIZE = 64;                                        // contiguous pages per extent
+static constexpr int COMPRESSED_SLOT_SIZE = 512;                              // file space unit of compressed pages
+static constexpr int SEGMENT_SIZE = 262144;                                   // pages per segment file (1 GB)
+static constexpr int TIER_MIGRATION_BATCH = 64;                               // extents moved between tiers per pass
+static constexpr int TIER_PROMOTE_HEAT = 8;                                   // accesses that bring a cold extent back
+static constexpr int REDO_WORKERS = 4;                                        // threads replaying the log on restart
+static constexpr int CHECKPOINT_FLUSH_BATCH = 16;                             // pages a checkpoint writes at a time
+static constexpr int64_t BACKUP_BYTES_PER_SECOND = 64 << 20;                  // default rate of a hot backup
+static constexpr int BACKUP_PAGE_RETRIES = 100;                               // reads of a page torn by a write
+static constexpr int64_t LOG_SEGMENT_SIZE = 1 << 24;                          // bytes per log segment file (16 MB)
+static constexpr int64_t REPLICA_MAX_APPLY_LAG = 1 << 24;                     // log bytes a replica holds back at most
+static constexpr size_t LOG_SHIPPER_MAX_BACKLOG = 1 << 26;                    // log bytes queued for a slow replica
+static constexpr int LOCK_TABLE_PARTITIONS = 16;                              // lock table parts with their own latch
+static constexpr int LOCK_ESCALATION_PRESSURE_ROWS = 64;                      // row locks escalated over the soft limit
+static constexpr int TXN_REGISTRY_SIZE = 1 << 14;                             // slots of the transaction registry
+static constexpr int LATCH_SPINS = 64;                                        // spins before a latch waiter sleeps
+static constexpr int DISTRIBUTED_LATCH_SLOTS = 16;                            // reader counters of a distributed latch
+static constexpr int HASH_TABLE_SPLITS_PER_OP = 1;                            // hash blocks split per op while growing
+static constexpr int HASH_TABLE_MAX_LOAD_PERCENT = 90;                        // hash table load that starts growth
+static constexpr int HASH_TABLE_PREFETCH_SLOTS = 16;                          // probe this near a block end prefetches
+static constexpr int HASH_TABLE_BATCH_SIZE = 16;                              // keys a batched lookup fetches at once
+static constexpr int HASH_TABLE_LOAD_CHECK_INTERVAL = 8;                      // inserts per thread between load checks
+static constexpr int HASH_TABLE_FILTER_BITS_PER_SLOT = 8;                     // bloom filter bits per hash table slot
+static constexpr int HASH_TABLE_FILTER_PROBES = 4;                            // bloom filter bits per key, at most 4
+static constexpr int HASH_TABLE_MAX_TOMBSTONE_PERCENT = 20;                   // tombstones that start compaction
+static constexpr int HASH_JOIN_PARTITIONS = 8;                                // partitions of a spilling join input
+static constexpr int HASH_JOIN_MAX_DEPTH = 3;                                 // times a join partition is split again
+static constexpr int HASH_JOIN_RADIX_PARTITION_ROWS = 4096;                   // build rows of a radix join partition
+static constexpr int HASH_JOIN_RADIX_BITS_PER_PASS = 8;                       // radix join partitions per pass, log2
+static constexpr int HASH_JOIN_PROBE_BATCH = 1 << 14;                         // probe rows a radix join joins at once
+static constexpr int HASH_JOIN_FILTER_BITS_PER_KEY = 8;                       // bloom filter bits per build side key
+static constexpr int HASH_JOIN_MISESTIMATE_FACTOR = 4;                        // join build rows over estimate, at most
+static constexpr int EXECUTOR_BATCH_SIZE = 1024;                              // rows of a TupleBatch
+static constexpr int TASK_WAIT_MAX_DEPTH = 1;                                 // nested waits that run other tasks
+static constexpr int AGGREGATION_ROUND_BATCHES = 8;                           // batches per aggregation worker round
+static constexpr int APPROX_COUNT_DISTINCT_BITS = 14;                         // log2 of approx distinct count registers
+static constexpr int ARENA_BLOCK_SIZE = 64 * 1024;                            // bytes of a block of an ArenaPool
+static constexpr int SPILL_BLOCK_SIZE = 64 * 1024;                            // bytes a spill file writes at once
+static constexpr int SPILL_MEMORY_BUDGET = 4 << 20;                           // bytes of spill file buffers per query
+static constexpr int MEMORY_ACCOUNT_BATCH = 64 * 1024;                        // bytes a thread tallies before charging
+static constexpr int SESSION_PLAN_CACHE_SIZE = 64;                            // prepared plans a session keeps
+static constexpr int SESSION_MAX_CONNECTIONS = 256;                           // clients a session server serves at once
+static constexpr int SESSION_MAX_LINE_SIZE = 64 * 1024;                       // bytes of a session server request line
+static constexpr int SESSION_MAX_BATCH_LINES = 4096;                          // lines of a session server request batch
+static constexpr int RESULT_CACHE_MAX_BYTES = 4 << 20;                        // bytes of results a result cache keeps
+static constexpr int LSM_MEMTABLE_SIZE = 4 << 20;                             // bytes of an LSM memtable before a flush
+static constexpr int LSM_MAX_IMMUTABLE = 2;                                   // frozen LSM memtables that stall writers
+static constexpr int LSM_COMPACTION_TRIGGER = 4;                              // LSM runs that start a compaction
+static constexpr int LSM_FILTER_BITS_PER_KEY = 10;                            // bloom filter bits per LSM run key
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -42,5 +132,43 @@ using txn_id_t = int32_t;      // transaction id type
 using lsn_t = int32_t;         // log sequence number type
 using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
+using table_oid_t = uint32_t;  // table id type
+using timestamp_t = int64_t;   // commit timestamp type
+
+static constexpr table_oid_t INVALID_TABLE_OID = UINT32_MAX;  // invalid table id
+
+/** Sizes that a BustubInstance is set up with. The defaults are the compile-time constants above. */
+struct BustubConfig {
+  /** Number of frames in the buffer pool. */
+  size_t buffer_pool_size = BUFFER_POOL_SIZE;
+  /** Number of frames that the buffer pool can grow to while running, 0 = buffer_pool_size. */
+  size_t max_buffer_pool_size = 0;
+  /** Size of each of the log manager's buffers in byte. */
+  size_t log_buffer_size = LOG_BUFFER_SIZE;
+  /** Size of a data page in byte. The on-disk layouts are compiled against PAGE_SIZE, so it must match. */
+  size_t page_size = PAGE_SIZE;
+  /** File that the resident pages are saved to and reloaded from on startup, empty = no warm start. */
+  std::string warm_start_file;
+  /** Split the buffer pool into one shard per NUMA node, with the frames of every shard allocated on its node. */
+  bool numa_aware = false;
+  /** Access the database file with direct I/O, so that pages are cached by the buffer pool only. */
+  bool direct_io = false;
+  /** Verify the checksum of every page that is read. Checksums are computed on writes either way. */
+  bool verify_checksums = true;
+  /** Store the pages of the database file compressed. A database file must always be opened in the same mode. */
+  bool compress_pages = false;
+  /** Directories that the segment files after the first are spread over round-robin, empty = next to the database. */
+  std::vector<std::string> stripe_dirs;
+  /** Directory of the capacity tier that cold extents are moved to, e.g. on a slower drive, empty = no tiering. */
+  std::string capacity_dir;
+  /** Wait for the commit record to be on disk before a commit returns. Off, a crash can lose the latest commits. */
+  bool synchronous_commit = true;
+  /** Write the log buffers as compressed blocks, for logs of repetitive records. */
+  bool compress_log = false;
+  /** Number of workers of the task scheduler that the parallel operators share, 0 = one per hardware thread. */
+  size_t scheduler_threads = 0;
+  /** Pin each worker of the task scheduler to a CPU of its own. */
+  bool pin_scheduler_threads = false;
+};
 
 }  // namespace bustub
@@ -36,6 +36,8 @@
 #include <ctime>
 #include <string>
 
+#include "common/async_logger.h"
+
 namespace bustub {
 
 // https://blog.galowicz.de/2016/02/20/short_file_macro/
@@ -86,7 +88,7 @@ static constexpr int LOG_LEVEL = LOG_LEVEL_INFO;
 #define __FUNCTION__ ""
 #endif
 
-void OutputLogHeader(const char *file, int line, const char *func, int level);
+void OutputLogHeader(const char *file, int line, const char *func, int level, time_t t = ::time(nullptr));
 
 // Two convenient macros for debugging
 // 1. Logging macros.
@@ -98,11 +100,15 @@ void OutputLogHeader(const char *file, int line, const char *func, int level);
 #if LOG_LEVEL <= LOG_LEVEL_ERROR
 #define LOG_ERROR_ENABLED
 // #pragma message("LOG_ERROR was enabled.")
-#define LOG_ERROR(...)                                                      \
-  OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_ERROR); \
-  ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                \
-  fprintf(LOG_OUTPUT_STREAM, "\n");                                         \
-  ::fflush(stdout)
+#define LOG_ERROR(...)                                                                                       \
+  do {                                                                                                       \
+    if (!::bustub::AsyncLogger::Log(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_ERROR, __VA_ARGS__)) { \
+      OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_ERROR);                              \
+      ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                                             \
+      fprintf(LOG_OUTPUT_STREAM, "\n");                                                                      \
+      ::fflush(stdout);                                                                                      \
+    }                                                                                                        \
+  } while (0)
 #else
 #define LOG_ERROR(...) ((void)0)
 #endif
@@ -113,11 +119,15 @@ void OutputLogHeader(const char *file, int line, const char *func, int level);
 #if LOG_LEVEL <= LOG_LEVEL_WARN
 #define LOG_WARN_ENABLED
 // #pragma message("LOG_WARN was enabled.")
-#define LOG_WARN(...)                                                      \
-  OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_WARN); \
-  ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                               \
-  fprintf(LOG_OUTPUT_STREAM, "\n");                                        \
-  ::fflush(stdout)
+#define LOG_WARN(...)                                                                                       \
+  do {                                                                                                      \
+    if (!::bustub::AsyncLogger::Log(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_WARN, __VA_ARGS__)) { \
+      OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_WARN);                              \
+      ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                                            \
+      fprintf(LOG_OUTPUT_STREAM, "\n");                                                                     \
+      ::fflush(stdout);                                                                                     \
+    }                                                                                                       \
+  } while (0)
 #else
 #define LOG_WARN(...) ((void)0)
 #endif
@@ -128,11 +138,15 @@ void OutputLogHeader(const char *file, int line, const char *func, int level);
 #if LOG_LEVEL <= LOG_LEVEL_INFO
 #define LOG_INFO_ENABLED
 // #pragma message("LOG_INFO was enabled.")
-#define LOG_INFO(...)                                                      \
-  OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_INFO); \
-  ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                               \
-  fprintf(LOG_OUTPUT_STREAM, "\n");                                        \
-  ::fflush(stdout)
+#define LOG_INFO(...)                                                                                       \
+  do {                                                                                                      \
+    if (!::bustub::AsyncLogger::Log(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_INFO, __VA_ARGS__)) { \
+      OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_INFO);                              \
+      ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                                            \
+      fprintf(LOG_OUTPUT_STREAM, "\n");                                                                     \
+      ::fflush(stdout);                                                                                     \
+    }                                                                                                       \
+  } while (0)
 #else
 #define LOG_INFO(...) ((void)0)
 #endif
@@ -143,11 +157,15 @@ void OutputLogHeader(const char *file, int line, const char *func, int level);
 #if LOG_LEVEL <= LOG_LEVEL_DEBUG
 #define LOG_DEBUG_ENABLED
 // #pragma message("LOG_DEBUG was enabled.")
-#define LOG_DEBUG(...)                                                      \
-  OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_DEBUG); \
-  ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                \
-  fprintf(LOG_OUTPUT_STREAM, "\n");                                         \
-  ::fflush(stdout)
+#define LOG_DEBUG(...)                                                                                       \
+  do {                                                                                                       \
+    if (!::bustub::AsyncLogger::Log(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_DEBUG, __VA_ARGS__)) { \
+      OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_DEBUG);                              \
+      ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                                             \
+      fprintf(LOG_OUTPUT_STREAM, "\n");                                                                      \
+      ::fflush(stdout);                                                                                      \
+    }                                                                                                        \
+  } while (0)
 #else
 #define LOG_DEBUG(...) ((void)0)
 #endif
@@ -158,19 +176,23 @@ void OutputLogHeader(const char *file, int line, const char *func, int level);
 #if LOG_LEVEL <= LOG_LEVEL_TRACE
 #define LOG_TRACE_ENABLED
 // #pragma message("LOG_TRACE was enabled.")
-#define LOG_TRACE(...)                                                      \
-  OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_TRACE); \
-  ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                \
-  fprintf(LOG_OUTPUT_STREAM, "\n");                                         \
-  ::fflush(stdout)
+#define LOG_TRACE(...)                                                                                       \
+  do {                                                                                                       \
+    if (!::bustub::AsyncLogger::Log(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_TRACE, __VA_ARGS__)) { \
+      OutputLogHeader(__SHORT_FILE__, __LINE__, __FUNCTION__, LOG_LEVEL_TRACE);                              \
+      ::fprintf(LOG_OUTPUT_STREAM, __VA_ARGS__);                                                             \
+      fprintf(LOG_OUTPUT_STREAM, "\n");                                                                      \
+      ::fflush(stdout);                                                                                      \
+    }                                                                                                        \
+  } while (0)
 #else
 #define LOG_TRACE(...) ((void)0)
 #endif
 
 // Output log message header in this format: [type] [file:line:function] time -
 // ex: [ERROR] [somefile.cpp:123:doSome()] 2008/07/06 10:00:00 -
-inline void OutputLogHeader(const char *file, int line, const char *func, int level) {
-  time_t t = ::time(nullptr);
+// t is the time that the message was logged at, which the AsyncLogger writes later
+inline void OutputLogHeader(const char *file, int line, const char *func, int level, time_t t) {
   tm *curTime = localtime(&t);  // NOLINT
   char time_str[32];            // FIXME
   ::strftime(time_str, 32, LOG_LOG_TIME_FORMAT, curTime);
@@ -0,0 +1,172 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_accounting.h
+//
+// Identification: src/include/common/memory_accounting.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace bustub {
+
+class MetricsSnapshot;
+
+/** The parts of the process whose memory is accounted for separately, see MemoryAccounting. */
+enum class MemorySubsystem : uint8_t {
+  BUFFER_POOL,  // the frames of the buffer pools
+  LOCK_TABLE,   // the queues and requests of the lock managers
+  WRITE_SET,    // the write sets and write buffers of the transactions
+  HASH_JOIN,    // the hash tables and partitions of the hash joins
+  OPERATOR,     // what the other operators of queries hold, e.g. the tuples of a sort or the groups of an aggregation
+  VARLEN,       // the strings that Values own rather than borrow
+};
+
+static constexpr size_t NUM_MEMORY_SUBSYSTEMS = 6;
+
+/**
+ * MemoryAccount adds up the bytes that a subsystem holds, and the number of allocations that they are in, and keeps
+ * the most bytes that it has held at a time.
+ *
+ * A thread charges its allocations to its own tally first, and to the account once the tally is MEMORY_ACCOUNT_BATCH
+ * bytes or more either way, so that the threads that allocate small things often, e.g. strings, do not contend on the
+ * account. The account is behind by less than that per thread, and its peak is that of what was charged to it.
+ *
+ * An account may have a soft limit, which its subsystem holds itself to by giving memory back rather than failing:
+ * the lock managers escalate row locks to table locks sooner, the operators of queries spill, and the buffer pools
+ * do not grow, see IsOverSoftLimit().
+ */
+class MemoryAccount {
+ public:
+  constexpr explicit MemoryAccount(MemorySubsystem subsystem) : subsystem_(subsystem) {}
+
+  MemoryAccount(const MemoryAccount &) = delete;
+  MemoryAccount &operator=(const MemoryAccount &) = delete;
+
+  /** Charges an allocation of bytes, or a number of them, to the subsystem. */
+  void Consume(size_t bytes, size_t count = 1) { Charge(static_cast<int64_t>(bytes), static_cast<int64_t>(count)); }
+
+  /** Gives back an allocation of bytes, or a number of them, that was charged to the subsystem. */
+  void Release(size_t bytes, size_t count = 1) { Charge(-static_cast<int64_t>(bytes), -static_cast<int64_t>(count)); }
+
+  /** @return the bytes that the subsystem holds */
+  size_t GetUsage() const { return Clamp(usage_.load(std::memory_order_relaxed)); }
+
+  /** @return the most bytes that the subsystem has held at a time */
+  size_t GetPeak() const { return Clamp(peak_.load(std::memory_order_relaxed)); }
+
+  /** @return the number of allocations that the bytes of the subsystem are in */
+  size_t GetNumAllocations() const { return Clamp(count_.load(std::memory_order_relaxed)); }
+
+  /** @return the soft limit of the subsystem in bytes, 0 if it has none */
+  size_t GetSoftLimit() const { return soft_limit_.load(std::memory_order_relaxed); }
+
+  /** Sets the soft limit of the subsystem in bytes, 0 for none. */
+  void SetSoftLimit(size_t bytes) { soft_limit_.store(bytes, std::memory_order_relaxed); }
+
+  /** @return true if the subsystem has a soft limit and holds more bytes than it */
+  bool IsOverSoftLimit() const {
+    const size_t limit = GetSoftLimit();
+    return limit != 0 && GetUsage() > limit;
+  }
+
+  /**
+   * @return true if the subsystem has no soft limit, or stays within it after an allocation of bytes, e.g. to decide
+   * whether to make it
+   */
+  bool Fits(size_t bytes) const {
+    const size_t limit = GetSoftLimit();
+    return limit == 0 || GetUsage() + bytes <= limit;
+  }
+
+  /** Charges the tally of the calling thread to the account, e.g. before the account is read in a test. */
+  void Flush();
+
+ private:
+  friend struct PendingCharges;
+
+  static size_t Clamp(int64_t value) { return value < 0 ? 0 : static_cast<size_t>(value); }
+
+  void Charge(int64_t bytes, int64_t count);
+
+  /** Adds bytes and allocations to the account, and moves its peak on. */
+  void Apply(int64_t bytes, int64_t count);
+
+  MemorySubsystem subsystem_;
+  std::atomic<int64_t> usage_{0};
+  std::atomic<int64_t> peak_{0};
+  std::atomic<int64_t> count_{0};
+  std::atomic<size_t> soft_limit_{0};
+};
+
+/**
+ * MemoryAccounting holds the account of each subsystem. The accounts are those of the process, shared by all its
+ * instances, since some of what they count, e.g. the strings of Values, belongs to no instance.
+ */
+class MemoryAccounting {
+ public:
+  /** @return the account of a subsystem */
+  static MemoryAccount *Get(MemorySubsystem subsystem);
+
+  /** @return the name of a subsystem, e.g. "lock_table" */
+  static const char *GetName(MemorySubsystem subsystem);
+
+  /**
+   * Adds the bytes, peak, allocations and soft limit of every account to a snapshot, each labeled with its subsystem,
+   * see MetricsRegistry.
+   * @param snapshot the snapshot to add the metrics to
+   */
+  static void CollectMetrics(MetricsSnapshot *snapshot);
+};
+
+/**
+ * TrackedAllocator is a standard allocator that charges what it allocates to the account of a subsystem, so that a
+ * container that uses it, e.g. the write set of a transaction, counts towards its subsystem.
+ */
+template <class T, MemorySubsystem S>
+class TrackedAllocator {
+ public:
+  using value_type = T;
+
+  template <class U>
+  struct rebind {
+    using other = TrackedAllocator<U, S>;
+  };
+
+  TrackedAllocator() noexcept = default;
+
+  template <class U>
+  TrackedAllocator(const TrackedAllocator<U, S> &other) noexcept {}  // NOLINT
+
+  T *allocate(size_t n) {
+    T *result = std::allocator<T>().allocate(n);
+    MemoryAccounting::Get(S)->Consume(n * sizeof(T));
+    return result;
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    MemoryAccounting::Get(S)->Release(n * sizeof(T));
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template <class U>
+  bool operator==(const TrackedAllocator<U, S> &other) const noexcept {
+    return true;
+  }
+
+  template <class U>
+  bool operator!=(const TrackedAllocator<U, S> &other) const noexcept {
+    return false;
+  }
+};
+
+}  // namespace bustub
@@ -0,0 +1,101 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// rcu_pointer.h
+//
+// Identification: src/include/common/rcu_pointer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rwlatch.h"
+
+namespace bustub {
+
+/**
+ * RcuPointer holds an immutable version of an object that many threads read and few replace, read-copy-update style:
+ * a writer publishes a new version, see Publish(), and a reader sees either the old or the new one, without ever
+ * waiting. A reader only counts itself in on the counter of its thread, see DistributedReaderWriterLatch::GetSlot(),
+ * so readers do not contend on a cache line.
+ *
+ * An old version is deleted once the readers that may still see it left. The counters come in two phases: a writer
+ * flips the phase that new readers count themselves into and waits for the other phase to drain, twice, so that a
+ * reader that read the phase before a flip but counted itself in after it is waited for as well.
+ */
+template <class T>
+class RcuPointer {
+ public:
+  explicit RcuPointer(std::unique_ptr<T> value) : value_(value.release()) {}
+
+  ~RcuPointer() { delete value_.load(); }
+
+  DISALLOW_COPY(RcuPointer);
+
+  /**
+   * Reads the current version, which stays valid until fn returns. Does not wait.
+   * @param fn called as fn(version)
+   * @return what fn returned
+   */
+  template <class Fn>
+  auto Read(Fn &&fn) const {
+    std::atomic<int64_t> *count = &slots_[DistributedReaderWriterLatch::GetSlot()].counts_[phase_.load()];
+    // Sequentially consistent, so that a writer that missed this reader has published its version before the load.
+    count->fetch_add(1);
+    struct Leave {
+      ~Leave() { count_->fetch_sub(1); }
+      std::atomic<int64_t> *count_;
+    } leave{count};
+    return fn(static_cast<const T &>(*value_.load()));
+  }
+
+  /** @return the current version, only for the writer, which keeps other writers out */
+  const T &GetForWriter() const { return *value_.load(); }
+
+  /**
+   * Replaces the current version, and deletes it once no reader sees it anymore. The writers are serialized by the
+   * caller.
+   */
+  void Publish(std::unique_ptr<T> value) {
+    T *old_value = value_.exchange(value.release());
+    for (int flip = 0; flip < 2; flip++) {
+      const size_t old_phase = phase_.load();
+      phase_.store(1 - old_phase);
+      while (true) {
+        int64_t readers = 0;
+        for (const Slot &slot : slots_) {
+          readers += slot.counts_[old_phase].load();
+        }
+        if (readers == 0) {
+          break;
+        }
+        std::this_thread::yield();
+      }
+    }
+    delete old_value;
+  }
+
+ private:
+  /** The reader counters of the two phases on their own cache line. */
+  struct alignas(64) Slot {
+    std::array<std::atomic<int64_t>, 2> counts_{};
+  };
+
+  std::atomic<T *> value_;
+  mutable std::array<Slot, DISTRIBUTED_LATCH_SLOTS> slots_;
+  /** The phase that new readers count themselves into. */
+  alignas(64) std::atomic<size_t> phase_{0};
+};
+
+}  // namespace bustub
@@ -12,25 +12,29 @@
 
 #pragma once
 
-#include <climits>
-#include <condition_variable>  // NOLINT
-#include <mutex>               // NOLINT
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 
+#include "common/config.h"
 #include "common/macros.h"
 
 namespace bustub {
 
 /**
- * Reader-Writer latch backed by std::mutex.
+ * Reader-Writer latch in a single atomic word, which holds the number of readers, a writer bit and a bit that tells
+ * whether anybody sleeps on the word. An uncontended RLock() or WLock() is a single compare-and-swap, and an unlock a
+ * single atomic update; waiters spin LATCH_SPINS times before they sleep on a futex.
+ *
+ * Writers are preferred: once a writer entered, new readers wait until it is done, and the writer waits for the
+ * readers inside to leave.
  */
 class ReaderWriterLatch {
-  using mutex_t = std::mutex;
-  using cond_t = std::condition_variable;
-  static const uint32_t MAX_READERS = UINT_MAX;
-
  public:
   ReaderWriterLatch() = default;
-  ~ReaderWriterLatch() { std::lock_guard<mutex_t> guard(mutex_); }
+  ~ReaderWriterLatch() = default;
 
   DISALLOW_COPY(ReaderWriterLatch);
 
@@ -38,13 +42,9 @@ class ReaderWriterLatch {
    * Acquire a write latch.
    */
   void WLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_) {
-      reader_.wait(latch);
-    }
-    writer_entered_ = true;
-    while (reader_count_ > 0) {
-      writer_.wait(latch);
+    uint32_t state = 0;
+    if (!state_.compare_exchange_strong(state, WRITER, std::memory_order_acquire)) {
+      WLockSlow();
     }
   }
 
@@ -52,45 +52,137 @@ class ReaderWriterLatch {
    * Release a write latch.
    */
   void WUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    writer_entered_ = false;
-    reader_.notify_all();
+    // No reader gets in while the writer is, so the writer bit and the waiters bit are all there is to clear.
+    if ((state_.exchange(0, std::memory_order_release) & WAITERS) != 0) {
+      WakeAll(&state_);
+    }
+  }
+
+  /**
+   * Acquire a write latch if that needs no wait.
+   * @return true if the latch was acquired
+   */
+  bool TryWLock() {
+    uint32_t state = 0;
+    return state_.compare_exchange_strong(state, WRITER, std::memory_order_acquire);
   }
 
   /**
    * Acquire a read latch.
    */
   void RLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_ || reader_count_ == MAX_READERS) {
-      reader_.wait(latch);
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & WRITER) != 0 || !state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+      RLockSlow();
     }
-    reader_count_++;
+  }
+
+  /**
+   * Acquire a read latch if that needs no wait.
+   * @return true if the latch was acquired
+   */
+  bool TryRLock() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    return (state & WRITER) == 0 && state_.compare_exchange_strong(state, state + 1, std::memory_order_acquire);
   }
 
   /**
    * Release a read latch.
    */
   void RUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    reader_count_--;
-    if (writer_entered_) {
-      if (reader_count_ == 0) {
-        writer_.notify_one();
-      }
-    } else {
-      if (reader_count_ == MAX_READERS - 1) {
-        reader_.notify_one();
-      }
+    // The last reader to leave wakes the writer that waits for it. The waiters bit stays set until the writer is done.
+    const uint32_t state = state_.fetch_sub(1, std::memory_order_release);
+    if ((state & (WAITERS | READERS)) == (WAITERS | 1)) {
+      WakeAll(&state_);
+    }
+  }
+
+ private:
+  friend class DistributedReaderWriterLatch;
+
+  /** Set while a writer holds the latch or waits for the readers to leave. */
+  static constexpr uint32_t WRITER = 1U << 31;
+  /** Set while a waiter sleeps on the word, only ever together with WRITER. */
+  static constexpr uint32_t WAITERS = 1U << 30;
+  /** The number of readers that hold the latch. */
+  static constexpr uint32_t READERS = WAITERS - 1;
+
+  void WLockSlow();
+  void RLockSlow();
+
+  /** Sleeps until word changes from expected, or a spurious wake up. */
+  static void Wait(std::atomic<uint32_t> *word, uint32_t expected);
+  /** Wakes all sleepers on word. */
+  static void WakeAll(std::atomic<uint32_t> *word);
+  /** Hints the CPU that the caller spins. */
+  static void Pause();
+
+  std::atomic<uint32_t> state_{0};
+};
+
+/**
+ * Reader-Writer latch for latches that are read latched very often and write latched rarely, e.g. the latch that
+ * every transaction holds while it runs. Readers count themselves in one of DISTRIBUTED_LATCH_SLOTS cache line sized
+ * counters, picked by their thread, so that they do not fight over a single cache line; a writer has to look at all
+ * of them. A read latch may be released by another thread than the one that acquired it.
+ */
+class DistributedReaderWriterLatch {
+ public:
+  DistributedReaderWriterLatch() = default;
+  ~DistributedReaderWriterLatch() = default;
+
+  DISALLOW_COPY(DistributedReaderWriterLatch);
+
+  /** Acquire a write latch. */
+  void WLock();
+
+  /** Release a write latch. */
+  void WUnlock();
+
+  /** Acquire a read latch. */
+  void RLock() {
+    std::atomic<int64_t> *count = &slots_[GetSlot()].count_;
+    count->fetch_add(1);
+    // Sequentially consistent, so that either the reader sees the writer or the writer sees the reader.
+    if (writer_.load() != 0) {
+      RLockSlow(count);
+    }
+  }
+
+  /** Release a read latch. */
+  void RUnlock() {
+    slots_[GetSlot()].count_.fetch_sub(1);
+    if (writer_.load() != 0) {
+      WakeWriter();
     }
   }
 
+  /** @return the slot of the calling thread, below DISTRIBUTED_LATCH_SLOTS; other per-thread counters may use it too */
+  static size_t GetSlot() {
+    static thread_local const size_t slot =
+        std::hash<std::thread::id>{}(std::this_thread::get_id()) % DISTRIBUTED_LATCH_SLOTS;
+    return slot;
+  }
+
  private:
-  mutex_t mutex_;
-  cond_t writer_;
-  cond_t reader_;
-  uint32_t reader_count_{0};
-  bool writer_entered_{false};
+  /** A reader counter on its own cache line. It may go negative when read latches move between threads. */
+  struct alignas(64) Slot {
+    std::atomic<int64_t> count_{0};
+  };
+
+  /** Backs off from a writer that came in and retries. */
+  void RLockSlow(std::atomic<int64_t> *count);
+
+  /** Tells the writer that waits for the readers that one left. */
+  void WakeWriter();
+
+  std::array<Slot, DISTRIBUTED_LATCH_SLOTS> slots_;
+  /** 1 while a writer holds the latch or waits for the readers to leave. */
+  alignas(64) std::atomic<uint32_t> writer_{0};
+  /** Changes whenever a reader leaves while there is a writer, which the writer sleeps on. */
+  std::atomic<uint32_t> drain_seq_{0};
+  /** Serializes the writers. */
+  std::mutex writer_mutex_;
 };
 
 }  // namespace bustub
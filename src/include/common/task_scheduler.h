@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// task_scheduler.h
+//
+// Identification: src/include/common/task_scheduler.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** The priority of a task, see TaskScheduler::Submit(). */
+enum class TaskPriority : uint8_t {
+  NORMAL,      // work that a query waits for, e.g. a morsel of a parallel scan
+  BACKGROUND,  // work that nobody waits for, e.g. writing back dirty pages, which only runs on otherwise idle workers
+};
+
+/**
+ * TaskScheduler is a pool of worker threads that the components of a BustubInstance share, so that parallel operators
+ * take turns on the cores rather than each starting threads of their own and oversubscribing the machine.
+ *
+ * Every worker has a deque of tasks. A task that a worker submits goes to the back of its own deque, and the worker
+ * takes its next task from there, so that a worker runs what it just produced while its data is in the cache; a task
+ * submitted from elsewhere goes to the workers in turn. A worker whose deque is empty steals from the front of the
+ * others, the oldest tasks, which are usually the largest. Background tasks have a queue of their own, which a worker
+ * only takes from once there is no normal task left anywhere.
+ */
+class TaskScheduler {
+ public:
+  using Task = std::function<void()>;
+
+  /**
+   * Starts the workers.
+   * @param num_threads the number of workers, at least one
+   * @param pin_threads true to pin the workers to the CPUs that the process may run on, one each in turn
+   */
+  explicit TaskScheduler(size_t num_threads, bool pin_threads = false);
+
+  /** Runs the tasks that were submitted, and stops the workers. */
+  ~TaskScheduler();
+
+  DISALLOW_COPY_AND_MOVE(TaskScheduler);
+
+  /** @return the number of workers */
+  size_t GetNumThreads() const { return threads_.size(); }
+
+  /** Submits a task, which runs on one of the workers. */
+  void Submit(Task task, TaskPriority priority = TaskPriority::NORMAL);
+
+  /**
+   * Runs fn(worker) for every worker from 0 to num_workers - 1, worker 0 on the calling thread and the others as tasks,
+   * and waits for all of them. While it waits, the calling thread runs pending tasks itself, so that a task may run
+   * a ParallelFor of its own without the workers all waiting on each other.
+   */
+  template <class Fn>
+  void ParallelFor(size_t num_workers, const Fn &fn) {
+    std::atomic<size_t> remaining{num_workers > 0 ? num_workers - 1 : 0};
+    for (size_t worker = 1; worker < num_workers; worker++) {
+      Submit([&fn, &remaining, worker] {
+        fn(worker);
+        remaining.fetch_sub(1, std::memory_order_release);
+      });
+    }
+    if (num_workers > 0) {
+      fn(0);
+    }
+    while (remaining.load(std::memory_order_acquire) != 0) {
+      if (!RunPendingTask()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /**
+   * Runs fn(worker) for every worker like ParallelFor(), on the scheduler if there is one, and otherwise on threads of
+   * their own, as before there was a scheduler.
+   */
+  template <class Fn>
+  static void RunWorkers(TaskScheduler *scheduler, size_t num_workers, const Fn &fn) {
+    if (scheduler != nullptr) {
+      scheduler->ParallelFor(num_workers, fn);
+      return;
+    }
+    std::vector<std::thread> threads;
+    for (size_t worker = 1; worker < num_workers; worker++) {
+      threads.emplace_back(fn, worker);
+    }
+    fn(0);
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  /**
+   * Runs a pending normal task on the calling thread, preferring those of its own deque if it is a worker.
+   * @return false if there was none
+   */
+  bool RunPendingTask();
+
+  /**
+   * Runs pending normal tasks on the calling thread until ready() is true or there are none left, e.g. while a read
+   * that the caller started is in flight, so that the thread does other work rather than block on it. The tasks may be
+   * of other queries, and may wait in turn: only TASK_WAIT_MAX_DEPTH waits on a thread run tasks, the ones nested
+   * deeper return right away and the caller blocks instead. That bounds the stack of the thread, and how long a task
+   * keeps the wait it runs in from noticing that it is ready.
+   */
+  template <class Ready>
+  void RunPendingTasksUntil(const Ready &ready) {
+    NestedWait wait;
+    if (!wait.MayRunTasks()) {
+      return;
+    }
+    while (!ready() && RunPendingTask()) {
+    }
+  }
+
+  /** @return the number of tasks that a worker took from the deque of another */
+  uint64_t GetNumSteals() const { return num_steals_.load(std::memory_order_relaxed); }
+
+ private:
+  /** Counts a wait of RunPendingTasksUntil() among the ones nested on the calling thread, while it is in scope. */
+  class NestedWait {
+   public:
+    NestedWait();
+    ~NestedWait();
+    DISALLOW_COPY_AND_MOVE(NestedWait);
+
+    /** @return true if the wait is within TASK_WAIT_MAX_DEPTH, and may run tasks */
+    bool MayRunTasks() const { return may_run_tasks_; }
+
+   private:
+    bool may_run_tasks_;
+  };
+
+  /** The tasks of a worker, or the background tasks. */
+  struct alignas(64) TaskQueue {
+    std::mutex latch_;
+    std::deque<Task> tasks_;
+  };
+
+  /** Takes the tasks of the worker of an index until the scheduler stops. */
+  void RunWorker(size_t index);
+
+  /**
+   * Takes a task: from the back of the deque of a worker, from the front of the others, then a background task.
+   * @param index the worker that takes the task, or the number of workers for a thread that is not one
+   * @return false if there is no task
+   */
+  bool TakeTask(size_t index, bool background, Task *task);
+
+  /** @return the index of the calling thread among the workers of this scheduler, the number of workers if none */
+  size_t GetWorkerIndex() const;
+
+  std::vector<std::unique_ptr<TaskQueue>> queues_;
+  TaskQueue background_;
+  std::vector<std::thread> threads_;
+  /** The tasks that were submitted and not yet taken, which the workers sleep on while there are none. */
+  std::atomic<size_t> num_pending_{0};
+  std::atomic<size_t> num_pending_normal_{0};
+  std::mutex latch_;
+  std::condition_variable cv_;
+  bool stop_{false};
+  /** The worker that the next task from a thread that is not a worker goes to. */
+  std::atomic<size_t> next_queue_{0};
+  std::atomic<uint64_t> num_steals_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// byte_buffer.h
+//
+// Identification: src/include/common/util/byte_buffer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * ByteWriter serializes metadata that outlives a restart into a buffer, e.g. the statistics of a table, see
+ * ByteReader for reading it back. Objects are written in the byte order of the machine.
+ */
+class ByteWriter {
+ public:
+  /** @param[out] buffer the buffer that is appended to */
+  explicit ByteWriter(std::vector<char> *buffer) : buffer_(buffer) {}
+
+  /** Appends the bytes of a trivially copyable object. */
+  template <class T>
+  void Write(const T &object) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto *bytes = reinterpret_cast<const char *>(&object);
+    buffer_->insert(buffer_->end(), bytes, bytes + sizeof(T));
+  }
+
+  /** Appends a string, after its length. */
+  void WriteString(const std::string &str) {
+    Write(static_cast<uint32_t>(str.size()));
+    buffer_->insert(buffer_->end(), str.begin(), str.end());
+  }
+
+  /** Appends a value that is not null, as Value::SerializeTo() lays it out. */
+  void WriteValue(const Value &value) {
+    const size_t offset = buffer_->size();
+    const size_t size = value.GetTypeId() == TypeId::VARCHAR ? sizeof(uint32_t) + value.GetLength()
+                                                               : Type::GetTypeSize(value.GetTypeId());
+    buffer_->resize(offset + size);
+    value.SerializeTo(buffer_->data() + offset);
+  }
+
+ private:
+  std::vector<char> *buffer_;
+};
+
+/** ByteReader reads what a ByteWriter wrote, front to back, and fails once a read would run past the end. */
+class ByteReader {
+ public:
+  ByteReader(const char *data, size_t size) : data_(data), end_(data + size) {}
+
+  /** @return false if the object would run past the end */
+  template <class T>
+  bool Read(T *object) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (Remaining() < sizeof(T)) {
+      return false;
+    }
+    memcpy(static_cast<void *>(object), data_, sizeof(T));
+    data_ += sizeof(T);
+    return true;
+  }
+
+  /** @return false if the string would run past the end */
+  bool ReadString(std::string *str) {
+    uint32_t size;
+    if (!Read(&size) || Remaining() < size) {
+      return false;
+    }
+    str->assign(data_, size);
+    data_ += size;
+    return true;
+  }
+
+  /** @return false if the value would run past the end */
+  bool ReadValue(TypeId type_id, Value *value) {
+    size_t size = Type::GetTypeSize(type_id);
+    if (type_id == TypeId::VARCHAR) {
+      uint32_t length;
+      if (Remaining() < sizeof(uint32_t)) {
+        return false;
+      }
+      memcpy(&length, data_, sizeof(uint32_t));
+      size = sizeof(uint32_t) + length;
+    }
+    if (Remaining() < size) {
+      return false;
+    }
+    *value = Value::DeserializeFrom(data_, type_id);
+    data_ += size;
+    return true;
+  }
+
+  /** @return true if everything was read */
+  bool AtEnd() const { return data_ == end_; }
+
+ private:
+  size_t Remaining() const { return static_cast<size_t>(end_ - data_); }
+
+  const char *data_;
+  const char *end_;
+};
+
+}  // namespace bustub
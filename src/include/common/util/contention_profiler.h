@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// contention_profiler.h
+//
+// Identification: src/include/common/util/contention_profiler.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+namespace bustub {
+
+/** The places that latches and locks are waited for at. */
+enum class LatchSite : uint8_t {
+  PAGE_READ,        // page read latch, by page id
+  PAGE_WRITE,       // page write latch, by page id
+  BUFFER_POOL,      // buffer pool manager latch, by instance index
+  LOCK_PARTITION,   // latch of a lock table partition, by partition index
+  LOCK_TABLE,       // latch of the table lock table
+  ROW_LOCK,         // row lock queue, by RID::Get()
+  TABLE_LOCK,       // table lock queue, by table oid
+  NUM_LATCH_SITES,
+};
+
+/** How long the acquisitions of one resource waited. */
+struct ContentionStats {
+  LatchSite site_;
+  int64_t key_;
+  uint64_t waits_;
+  uint64_t total_wait_ns_;
+  uint64_t max_wait_ns_;
+};
+
+/**
+ * ContentionProfiler collects the wait times of contended latch and lock acquisitions, per site and per resource,
+ * e.g. per page id. Only acquisitions that could not be made right away are timed, so an uncontended acquisition
+ * costs no more than before.
+ *
+ * The sites are instrumented only when BusTub is configured with -DBUSTUB_CONTENTION_PROFILE=ON; otherwise nothing is
+ * ever recorded.
+ */
+class ContentionProfiler {
+ public:
+  /** @return a monotonic time stamp in nanoseconds */
+  static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /**
+   * Records a wait.
+   * @param site where the wait was
+   * @param key the resource that was waited for
+   * @param start the Now() at which the wait began
+   */
+  static void Record(LatchSite site, int64_t key, uint64_t start);
+
+  /** @return the n resources that were waited for the longest in total, longest first */
+  static std::vector<ContentionStats> GetTopContended(size_t n);
+
+  /** @return the n resources that were waited for the longest, one line each */
+  static std::string Report(size_t n);
+
+  /** Forgets all recorded waits. */
+  static void Reset();
+
+  /** @return the name of a site */
+  static const char *GetSiteName(LatchSite site);
+};
+
+#ifdef BUSTUB_CONTENTION_PROFILE
+/** Acquires with acquire, and records the wait if try_acquire failed. */
+#define BUSTUB_PROFILE_LATCH(site, key, try_acquire, acquire)  \
+  do {                                                         \
+    if (!(try_acquire)) {                                      \
+      const uint64_t profile_start = ContentionProfiler::Now(); \
+      acquire;                                                 \
+      ContentionProfiler::Record(site, key, profile_start);    \
+    }                                                          \
+  } while (0)
+#else
+#define BUSTUB_PROFILE_LATCH(site, key, try_acquire, acquire) acquire
+#endif
+
+/** A std::unique_lock<std::mutex> that reports how long it waited for the mutex to the ContentionProfiler. */
+class ProfiledLock : public std::unique_lock<std::mutex> {
+ public:
+  ProfiledLock(std::mutex *latch, LatchSite site, int64_t key) : std::unique_lock<std::mutex>(*latch, std::defer_lock) {
+    BUSTUB_PROFILE_LATCH(site, key, try_lock(), lock());
+  }
+};
+
+}  // namespace bustub
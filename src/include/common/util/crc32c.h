@@ -0,0 +1,45 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.h
+//
+// Identification: src/include/common/util/crc32c.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * Crc32c computes CRC-32C (Castagnoli) checksums. On x86 CPUs with SSE 4.2 the crc32 instruction is used, elsewhere a
+ * lookup table.
+ */
+class Crc32c {
+ public:
+  /**
+   * @param crc the checksum of the data before data, 0 for the start of the data
+   * @param data the data to be added to the checksum
+   * @param len the length of data in bytes
+   * @return the checksum of the data before and including data
+   */
+  static uint32_t Extend(uint32_t crc, const char *data, size_t len);
+
+  /**
+   * @param data the data
+   * @param len the length of data in bytes
+   * @return the checksum of the data
+   */
+  static uint32_t Value(const char *data, size_t len) { return Extend(0, data, len); }
+
+  /** @return true if the checksums are computed by the CPU */
+  static bool IsHardwareAccelerated();
+};
+
+}  // namespace bustub
@@ -13,10 +13,16 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
 #include "common/macros.h"
 #include "type/value.h"
 
@@ -24,29 +30,86 @@ namespace bustub {
 
 using hash_t = std::size_t;
 
+/**
+ * Hashing of keys and values. The bytes are hashed a word at a time in the manner of wyhash: two words are multiplied
+ * into 128 bits and the halves folded together, which mixes every input bit into every output bit in a few cycles.
+ */
 class HashUtil {
  private:
   static const hash_t prime_factor = 10000019;
 
+  // Odd constants with evenly spread bits, from wyhash.
+  static constexpr uint64_t P0 = 0xa0761d6478bd642fULL;
+  static constexpr uint64_t P1 = 0xe7037ed1a0b428dbULL;
+  static constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+
+  static inline uint64_t Load64(const char *bytes) {
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    return word;
+  }
+
+  static inline uint64_t Load32(const char *bytes) {
+    uint32_t word;
+    memcpy(&word, bytes, sizeof(word));
+    return word;
+  }
+
  public:
+  /** @return the halves of the 128-bit product of a and b, folded together */
+  static inline uint64_t Mix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    const __uint128_t product = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#elif defined(__SSE4_2__)
+    const uint64_t crc = (static_cast<uint64_t>(_mm_crc32_u64(a, b)) << 32) | _mm_crc32_u64(b, a);
+    return (crc ^ (crc >> 29)) * P2;
+#else
+    uint64_t h = (a ^ (b >> 31) ^ (b << 33)) * P2;
+    return h ^ (h >> 32);
+#endif
+  }
+
   static inline hash_t HashBytes(const char *bytes, size_t length) {
-    // https://github.com/greenplum-db/gpos/blob/b53c1acd6285de94044ff91fbee91589543feba1/libgpos/src/utils.cpp#L126
-    hash_t hash = length;
-    for (size_t i = 0; i < length; ++i) {
-      hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+    uint64_t seed = P0 ^ length;
+    const char *end = bytes + length;
+    for (; end - bytes > 16; bytes += 16) {
+      seed = Mix(Load64(bytes) ^ P1, Load64(bytes + 8) ^ seed);
+    }
+    // The last 1 to 16 bytes are read as two words, which overlap if there are less than 16 of them.
+    const size_t rest = end - bytes;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (rest >= 8) {
+      a = Load64(bytes);
+      b = Load64(end - 8);
+    } else if (rest >= 4) {
+      a = Load32(bytes);
+      b = Load32(end - 4);
+    } else if (rest > 0) {
+      a = (static_cast<uint64_t>(static_cast<uint8_t>(bytes[0])) << 16) |
+          (static_cast<uint64_t>(static_cast<uint8_t>(bytes[rest >> 1])) << 8) |
+          static_cast<uint8_t>(bytes[rest - 1]);
     }
-    return hash;
+    return Mix(Mix(a ^ P1, b ^ seed) ^ P0, length ^ P1);
   }
 
-  static inline hash_t CombineHashes(hash_t l, hash_t r) {
-    hash_t both[2];
-    both[0] = l;
-    both[1] = r;
-    return HashBytes(reinterpret_cast<char *>(both), sizeof(hash_t) * 2);
+  /** @return the hash of a 64-bit integer, which is cheaper than hashing its bytes */
+  static inline hash_t HashInt(uint64_t val) { return Mix(Mix(val ^ P0, P1), P2); }
+
+  static inline hash_t CombineHashes(hash_t l, hash_t r) { return Mix(l ^ P0, r ^ P1); }
+
+  /**
+   * @return the partition of a hash among num_partitions at a level of partitioning. The partitions of a level are
+   * independent of those of the others, so that a partition that is split again spreads out over all of the new ones.
+   */
+  static inline size_t Partition(hash_t hash, size_t level, size_t num_partitions) {
+    return Mix(hash ^ P2, level ^ P1) % num_partitions;
   }
 
   static inline hash_t SumHashes(hash_t l, hash_t r) { return (l % prime_factor + r % prime_factor) % prime_factor; }
 
+  /** Hashes the bytes of an object. The length is a constant, so the branches of HashBytes on it fold away. */
   template <typename T>
   static inline hash_t Hash(const T *ptr) {
     return HashBytes(reinterpret_cast<const char *>(ptr), sizeof(T));
@@ -54,31 +117,27 @@ class HashUtil {
 
   template <typename T>
   static inline hash_t HashPtr(const T *ptr) {
-    return HashBytes(reinterpret_cast<const char *>(&ptr), sizeof(void *));
+    return HashInt(reinterpret_cast<uintptr_t>(ptr));
   }
 
   /** @return the hash of the value */
   static inline hash_t HashValue(const Value *val) {
     switch (val->GetTypeId()) {
+      // The integer types widen to 64 bits, so that equal values of different types hash alike.
       case TypeId::TINYINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int8_t>());
-        return Hash<int64_t>(&raw);
+        return HashInt(static_cast<int64_t>(val->GetAs<int8_t>()));
       }
       case TypeId::SMALLINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int16_t>());
-        return Hash<int64_t>(&raw);
+        return HashInt(static_cast<int64_t>(val->GetAs<int16_t>()));
       }
       case TypeId::INTEGER: {
-        auto raw = static_cast<int64_t>(val->GetAs<int32_t>());
-        return Hash<int64_t>(&raw);
+        return HashInt(static_cast<int64_t>(val->GetAs<int32_t>()));
       }
       case TypeId::BIGINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int64_t>());
-        return Hash<int64_t>(&raw);
+        return HashInt(static_cast<int64_t>(val->GetAs<int64_t>()));
       }
       case TypeId::BOOLEAN: {
-        auto raw = val->GetAs<bool>();
-        return Hash<bool>(&raw);
+        return HashInt(static_cast<uint64_t>(val->GetAs<bool>()));
       }
       case TypeId::DECIMAL: {
         auto raw = val->GetAs<double>();
@@ -90,8 +149,7 @@ class HashUtil {
         return HashBytes(raw, len);
       }
       case TypeId::TIMESTAMP: {
-        auto raw = val->GetAs<uint64_t>();
-        return Hash<uint64_t>(&raw);
+        return HashInt(val->GetAs<uint64_t>());
       }
       default: {
         BUSTUB_ASSERT(false, "Unsupported type.");
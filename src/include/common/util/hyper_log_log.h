@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hyper_log_log.h
+//
+// Identification: src/include/common/util/hyper_log_log.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/**
+ * HyperLogLog estimates the number of distinct hashes added to it in a fixed 2^BITS bytes, with a standard error of
+ * about 1.04 / sqrt(2^BITS): some 6.5% for 8 bits, below 1% for 14. The hashes must be well mixed in all 64 bits, like
+ * those of HashUtil.
+ *
+ * The first BITS bits of a hash pick a register, which keeps one more than the most leading zeros seen in the rest of
+ * the hashes. Sketches of the same size merge by keeping the larger of each pair of registers.
+ */
+template <size_t BITS>
+class HyperLogLog {
+ public:
+  static_assert(BITS >= 4 && BITS <= 16, "A HyperLogLog has 2^4 to 2^16 registers.");
+  /** The number of registers. */
+  static constexpr size_t NUM_REGISTERS = static_cast<size_t>(1) << BITS;
+
+  /** Adds a hash. */
+  void Add(hash_t hash) {
+    const size_t reg = hash >> (64 - BITS);
+    const uint64_t rest = (static_cast<uint64_t>(hash) << BITS) | (static_cast<uint64_t>(1) << (BITS - 1));
+    const auto rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    registers_[reg] = std::max(registers_[reg], rank);
+  }
+
+  /** Adds the hashes of another sketch. */
+  void Merge(const HyperLogLog &other) {
+    for (size_t i = 0; i < NUM_REGISTERS; i++) {
+      registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+  }
+
+  /** @return the estimated number of distinct hashes added */
+  double Estimate() const {
+    constexpr auto m = static_cast<double>(NUM_REGISTERS);
+    double sum = 0;
+    size_t num_zeros = 0;
+    for (uint8_t rank : registers_) {
+      sum += std::ldexp(1.0, -rank);
+      num_zeros += rank == 0 ? 1 : 0;
+    }
+    const double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    // Few distinct hashes leave registers empty, which count them more precisely.
+    if (estimate <= 2.5 * m && num_zeros > 0) {
+      return m * std::log(m / static_cast<double>(num_zeros));
+    }
+    return estimate;
+  }
+
+ private:
+  std::array<uint8_t, NUM_REGISTERS> registers_{};
+};
+
+}  // namespace bustub
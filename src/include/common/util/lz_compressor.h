@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_compressor.h
+//
+// Identification: src/include/common/util/lz_compressor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * LzCompressor is a small LZ77 compressor in the style of the LZ4 block format. It is built for speed rather than
+ * ratio, and does well on pages with runs of zeros and repeated values, such as the free space of table pages.
+ *
+ * The data is a sequence of matches, each preceded by the literal bytes before it. A sequence starts with a token
+ * byte holding the literal length in its high and the match length minus 4 in its low nibble, with 15 meaning that
+ * more length bytes follow, then the literals, then the 2 byte offset of the match. The last sequence only has
+ * literals.
+ */
+class LzCompressor {
+ public:
+  /**
+   * @param src the data to compress
+   * @param src_size the size of the data in bytes
+   * @param[out] dst the buffer for the compressed data
+   * @param dst_capacity the size of dst in bytes
+   * @return the size of the compressed data, 0 if it does not fit into dst
+   */
+  static size_t Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity);
+
+  /**
+   * @param src the compressed data
+   * @param src_size the size of the compressed data in bytes
+   * @param[out] dst the buffer for the data
+   * @param dst_capacity the size of dst in bytes
+   * @return the size of the data, 0 if the compressed data is corrupt or the data does not fit into dst
+   */
+  static size_t Decompress(const char *src, size_t src_size, char *dst, size_t dst_capacity);
+};
+
+}  // namespace bustub
@@ -0,0 +1,223 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// metrics.h
+//
+// Identification: src/include/common/util/metrics.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+/** Number of stripes that counters and histograms spread their updates over, see MetricCounter. */
+static constexpr size_t METRIC_STRIPES = 16;
+
+/**
+ * MetricCounter is a counter that only goes up. An update is a relaxed atomic add on one of METRIC_STRIPES cache-line
+ * sized stripes, picked per thread, so that threads do not contend on a single cache line; a read sums up the stripes.
+ */
+class MetricCounter {
+ public:
+  void Add(uint64_t n = 1) { stripes_[GetStripe()].value_.fetch_add(n, std::memory_order_relaxed); }
+
+  /** @return the sum of the stripes, which is not atomic with respect to concurrent updates */
+  uint64_t Value() const;
+
+  /** @return the stripe of the calling thread, the same for all counters and histograms */
+  static size_t GetStripe();
+
+ private:
+  struct alignas(64) Stripe {
+    std::atomic<uint64_t> value_{0};
+  };
+  std::array<Stripe, METRIC_STRIPES> stripes_;
+};
+
+/** MetricGauge is a value that goes up and down, e.g. the number of dirty pages. */
+class MetricGauge {
+ public:
+  void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+  void Add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+  int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+/**
+ * HistogramSnapshot is a point-in-time copy of a MetricHistogram. The buckets are those of an HDR histogram: the
+ * values below 2^SUB_BUCKET_BITS have a bucket each, and every power of two above is split into 2^SUB_BUCKET_BITS
+ * buckets of equal width, so that a bucket is at most 1 / 2^SUB_BUCKET_BITS of its values wide.
+ */
+struct HistogramSnapshot {
+  static constexpr size_t SUB_BUCKET_BITS = 4;
+  static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BUCKET_BITS;
+  /** The largest power of two that has buckets of its own, larger values are counted in the last bucket. */
+  static constexpr size_t MAX_EXPONENT = 47;
+  static constexpr size_t NUM_BUCKETS = SUB_BUCKETS + (MAX_EXPONENT + 1 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+  /** @return the bucket that a value is counted in */
+  static size_t GetBucket(uint64_t value);
+
+  /** @return the largest value that a bucket counts */
+  static uint64_t GetBucketUpperBound(size_t bucket);
+
+  /**
+   * @return the value below or at which a fraction of the recorded values lie, e.g. 0.99 for the 99th percentile, as
+   * the upper bound of its bucket but no more than the largest recorded value; 0 if there are none
+   */
+  uint64_t Percentile(double fraction) const;
+
+  /** @return the mean of the recorded values, 0 if there are none */
+  double Mean() const { return count_ == 0 ? 0 : static_cast<double>(sum_) / static_cast<double>(count_); }
+
+  /** Adds the values of another histogram. */
+  HistogramSnapshot &operator+=(const HistogramSnapshot &other);
+
+  uint64_t count_{0};
+  uint64_t sum_{0};
+  uint64_t max_{0};
+  std::vector<uint64_t> buckets_ = std::vector<uint64_t>(NUM_BUCKETS);
+};
+
+/**
+ * MetricHistogram records the distribution of values, e.g. latencies in microseconds, in the buckets of a
+ * HistogramSnapshot. Like a MetricCounter, it records on the stripe of the calling thread.
+ */
+class MetricHistogram {
+ public:
+  MetricHistogram() = default;
+  MetricHistogram(const MetricHistogram &) = delete;
+  MetricHistogram &operator=(const MetricHistogram &) = delete;
+  ~MetricHistogram();
+
+  void Record(uint64_t value);
+
+  /** @return the sum of the stripes, which is not atomic with respect to concurrent updates */
+  HistogramSnapshot Snapshot() const;
+
+ private:
+  struct alignas(64) Stripe {
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+    std::array<std::atomic<uint64_t>, HistogramSnapshot::NUM_BUCKETS> buckets_{};
+  };
+  // The stripes take about 6 KB each, so they are only allocated by the first record.
+  std::array<std::atomic<Stripe *>, METRIC_STRIPES> stripes_{};
+};
+
+enum class MetricType : uint8_t { COUNTER, GAUGE, HISTOGRAM };
+
+/**
+ * MetricsSnapshot is a point-in-time copy of metrics, grouped into families by name. A metric is identified by its
+ * name and its labels, given in the Prometheus syntax without the braces, e.g. `index="orders_pk"`; the values of a
+ * metric that is added more than once add up, e.g. those of the shards of a parallel buffer pool.
+ */
+class MetricsSnapshot {
+ public:
+  void AddCounter(const std::string &name, const std::string &help, double value, const std::string &labels = "");
+  void AddGauge(const std::string &name, const std::string &help, double value, const std::string &labels = "");
+  void AddHistogram(const std::string &name, const std::string &help, const HistogramSnapshot &histogram,
+                    const std::string &labels = "");
+
+  /** @return the value of a counter or a gauge, std::nullopt if there is none of the name and the labels */
+  std::optional<double> GetValue(const std::string &name, const std::string &labels = "") const;
+
+  /** @return a histogram, nullptr if there is none of the name and the labels */
+  const HistogramSnapshot *GetHistogram(const std::string &name, const std::string &labels = "") const;
+
+  /**
+   * @return the metrics in the Prometheus text exposition format, families sorted by name. A histogram is exposed as a
+   * summary, with the quantiles 0.5, 0.9, 0.99 and 0.999 and its sum and count.
+   */
+  std::string ToText() const;
+
+ private:
+  struct Family {
+    std::string help_;
+    MetricType type_;
+    std::map<std::string, double> values_;
+    std::map<std::string, HistogramSnapshot> histograms_;
+  };
+
+  Family *GetFamily(const std::string &name, const std::string &help, MetricType type);
+
+  std::map<std::string, Family> families_;
+};
+
+/**
+ * MetricsRegistry is the central place to read the metrics of a BustubInstance from. It holds two kinds of metrics:
+ *
+ * - counters, gauges and histograms that it owns, which a component gets by name and labels and then updates in place;
+ *   they live as long as the registry, and the same name and labels give the same metric;
+ * - collectors, functions that add the metrics that a component keeps on its own to a snapshot, e.g. its existing
+ *   stats, so that nothing is counted twice and an update costs nothing extra.
+ *
+ * Collect() takes a snapshot of both, and ExportText() renders it for a Prometheus scrape.
+ */
+class MetricsRegistry {
+ public:
+  using Collector = std::function<void(MetricsSnapshot *)>;
+
+  /** @return the counter of a name and labels, created on first use */
+  MetricCounter *GetCounter(const std::string &name, const std::string &help, const std::string &labels = "");
+
+  /** @return the gauge of a name and labels, created on first use */
+  MetricGauge *GetGauge(const std::string &name, const std::string &help, const std::string &labels = "");
+
+  /** @return the histogram of a name and labels, created on first use */
+  MetricHistogram *GetHistogram(const std::string &name, const std::string &help, const std::string &labels = "");
+
+  /**
+   * Adds a collector, which every Collect() calls, under the latch of the registry: it must not call back into the
+   * registry, and it must be removed before what it reads goes away.
+   * @return the id of the collector
+   */
+  size_t AddCollector(Collector collector);
+
+  /** Removes a collector, which is not called anymore once this returns. */
+  void RemoveCollector(size_t id);
+
+  /** @return the current values of the metrics of the registry and of its collectors */
+  MetricsSnapshot Collect() const;
+
+  /** @return Collect() in the Prometheus text exposition format */
+  std::string ExportText() const { return Collect().ToText(); }
+
+ private:
+  struct Metric {
+    std::string help_;
+    MetricType type_;
+    std::unique_ptr<MetricCounter> counter_;
+    std::unique_ptr<MetricGauge> gauge_;
+    std::unique_ptr<MetricHistogram> histogram_;
+  };
+
+  Metric *GetMetric(const std::string &name, const std::string &help, const std::string &labels, MetricType type);
+
+  mutable std::mutex latch_;
+  /** The metrics of the registry, by name and labels. */
+  std::map<std::pair<std::string, std::string>, Metric> metrics_;
+  std::map<size_t, Collector> collectors_;
+  size_t next_collector_id_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,41 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// numa_util.h
+//
+// Identification: src/include/common/util/numa_util.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * NumaUtil queries the NUMA topology of the machine and places memory on NUMA nodes. It talks to the kernel directly,
+ * so BusTub does not depend on libnuma. On machines or kernels without NUMA support, everything is on node 0.
+ */
+class NumaUtil {
+ public:
+  /** @return the number of NUMA nodes of the machine, at least 1 */
+  static size_t GetNumNodes();
+
+  /** @return the NUMA node that the calling thread is running on */
+  static size_t GetCurrentNode();
+
+  /**
+   * Makes the kernel allocate the memory of a mapping on a NUMA node. Must be called before the memory is touched.
+   * @param addr the page aligned start of the memory
+   * @param len the length of the memory in bytes
+   * @param node the NUMA node
+   * @return false if the memory could not be bound
+   */
+  static bool BindMemory(void *addr, size_t len, size_t node);
+};
+
+}  // namespace bustub
@@ -0,0 +1,164 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tracer.h
+//
+// Identification: src/include/common/util/tracer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** A span of time that a traced transaction spent in one place, e.g. waiting for a lock. */
+struct TraceSpan {
+  txn_id_t txn_id_;
+  /** What the time was spent on, e.g. "lock_wait", a string literal. */
+  const char *name_;
+  uint64_t start_ns_;
+  uint64_t duration_ns_;
+  /** The thread that recorded the span, numbered from 0 in the order in which the threads first recorded one. */
+  uint32_t thread_;
+  /** A detail of the span, e.g. the page that was read, -1 if there is none. */
+  int64_t arg_;
+};
+
+/**
+ * Tracer records where sampled transactions spend their time, to tell why a slow transaction was slow: the
+ * TransactionManager samples a share of the transactions at Begin(), and the subsystems record spans for them:
+ *
+ * - "transaction", from Begin() to the end of Commit() or Abort();
+ * - "lock_wait", for each lock request that had to wait, with its row (RID::Get()) or table oid;
+ * - "page_read", for each read of a fetch that missed, with the page id, the first one of a batch;
+ * - "log_wait", for a commit that waited for its commit record to be written, with its LSN;
+ * - "execute", for each run of a tree of executors to completion, see ResultSink::Drain().
+ *
+ * Except for lock waits, the spans are tied to the transaction that the thread runs, see SetCurrentTxn(), which
+ * TransactionManager::Begin() sets for the thread that begins a traced transaction.
+ *
+ * A span is appended to a buffer of the thread that records it, so threads do not contend; an untraced transaction
+ * costs a load and a compare at each place. The spans are kept until Reset(), up to MAX_SPANS_PER_THREAD a thread.
+ */
+class Tracer {
+ public:
+  static constexpr size_t MAX_SPANS_PER_THREAD = 1 << 20;
+
+  /**
+   * Sets the share of the transactions that are traced, 0 by default.
+   * @param rate from 0 for none to 1 for all
+   */
+  static void SetSampleRate(double rate);
+
+  /** @return true if the transaction of an id is to be traced, which is decided by a hash of the id */
+  static bool Sample(txn_id_t txn_id) {
+    const uint64_t threshold = sample_threshold_.load(std::memory_order_relaxed);
+    if (threshold == 0) {
+      return false;
+    }
+    return ((static_cast<uint64_t>(txn_id) * 0x9E3779B97F4A7C15ULL) >> 32) < threshold;
+  }
+
+  /** @return a monotonic time stamp in nanoseconds */
+  static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /** @return the traced transaction that the calling thread runs, INVALID_TXN_ID if none */
+  static txn_id_t GetCurrentTxn() { return current_txn_; }
+
+  /** Sets the traced transaction that the calling thread runs, INVALID_TXN_ID once it is done. */
+  static void SetCurrentTxn(txn_id_t txn_id) { current_txn_ = txn_id; }
+
+  /**
+   * Records a span that ends now.
+   * @param txn_id the traced transaction that the span belongs to
+   * @param name what the time was spent on, a string literal
+   * @param start_ns the Now() at which the span began
+   * @param arg a detail of the span, -1 if there is none
+   */
+  static void Record(txn_id_t txn_id, const char *name, uint64_t start_ns, int64_t arg = -1);
+
+  /** @return the spans of all the threads, ordered by their start */
+  static std::vector<TraceSpan> GetSpans();
+
+  /**
+   * @return the spans in the Chrome trace event format, a JSON object that chrome://tracing and Perfetto load; each
+   * thread is a track, and each span carries the id of its transaction
+   */
+  static std::string ExportChromeTrace();
+
+  /** @return the number of spans that were dropped because the buffer of their thread was full */
+  static uint64_t GetNumDropped() { return num_dropped_.load(std::memory_order_relaxed); }
+
+  /** Forgets all the recorded spans. */
+  static void Reset();
+
+ private:
+  /** Sample() traces the ids whose hash is below the threshold, out of 2^32. */
+  static std::atomic<uint64_t> sample_threshold_;
+  static std::atomic<uint64_t> num_dropped_;
+  static thread_local txn_id_t current_txn_;
+};
+
+/**
+ * TraceScope records a span of a traced transaction from its construction to its destruction, and nothing if the
+ * transaction is not traced.
+ */
+class TraceScope {
+ public:
+  /** Records a span of the current transaction of the thread, see Tracer::GetCurrentTxn(). */
+  explicit TraceScope(const char *name, int64_t arg = -1) : TraceScope(Tracer::GetCurrentTxn(), name, arg, false) {}
+
+  /**
+   * Records a span of a transaction, which is the current transaction of the thread until the span ends, e.g. for a
+   * thread that runs executors for a transaction that another thread began.
+   * @param txn_id the transaction, INVALID_TXN_ID if it is not traced
+   */
+  TraceScope(txn_id_t txn_id, const char *name, int64_t arg = -1) : TraceScope(txn_id, name, arg, true) {}
+
+  ~TraceScope() {
+    if (txn_id_ != INVALID_TXN_ID) {
+      Tracer::Record(txn_id_, name_, start_ns_, arg_);
+      if (set_current_) {
+        Tracer::SetCurrentTxn(prev_txn_id_);
+      }
+    }
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+ private:
+  TraceScope(txn_id_t txn_id, const char *name, int64_t arg, bool set_current)
+      : txn_id_(txn_id), name_(name), arg_(arg), set_current_(set_current) {
+    if (txn_id_ != INVALID_TXN_ID) {
+      start_ns_ = Tracer::Now();
+      if (set_current_) {
+        prev_txn_id_ = Tracer::GetCurrentTxn();
+        Tracer::SetCurrentTxn(txn_id_);
+      }
+    }
+  }
+
+  txn_id_t txn_id_;
+  const char *name_;
+  int64_t arg_;
+  bool set_current_;
+  txn_id_t prev_txn_id_{INVALID_TXN_ID};
+  uint64_t start_ns_{0};
+};
+
+}  // namespace bustub
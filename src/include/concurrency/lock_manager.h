@@ -13,15 +13,21 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <chrono>  // NOLINT
 #include <condition_variable>  // NOLINT
+#include <functional>
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "common/memory_accounting.h"
 #include "common/rid.h"
+#include "common/util/metrics.h"
 #include "concurrency/transaction.h"
 
 namespace bustub {
@@ -31,29 +37,74 @@ class TransactionManager;
 /** Two-Phase Locking mode. */
 enum class TwoPLMode { REGULAR, STRICT };
 
-/** Deadlock mode. */
-enum class DeadlockMode { PREVENTION, DETECTION };
+/** Deadlock mode. PREVENTION is wait-die, WOUND_WAIT the other timestamp-ordered prevention scheme. */
+enum class DeadlockMode { PREVENTION, DETECTION, WOUND_WAIT };
+
+/**
+ * LockManagerStats is a point-in-time copy of the counters of a lock manager, which tell what waiting for locks and
+ * dealing with deadlocks cost.
+ */
+struct LockManagerStats {
+  /** Lock requests on rows and tables that had to wait. */
+  uint64_t lock_waits = 0;
+  /** Total time spent in those waits, in microseconds. */
+  uint64_t lock_wait_time_us = 0;
+  /** Requests that gave up because their transaction was aborted: by wait-die, wound-wait or cycle detection. */
+  uint64_t aborted_requests = 0;
+  /** Rounds of the cycle detection thread. */
+  uint64_t detection_runs = 0;
+  /** Total time spent in those rounds, sleeps left out, in microseconds. */
+  uint64_t detection_time_us = 0;
+  /** Transactions that cycle detection aborted. */
+  uint64_t detection_victims = 0;
+};
 
 /**
  * LockManager handles transactions asking for locks on records.
  */
 class LockManager {
-  enum class LockMode { SHARED, EXCLUSIVE };
-
   class LockRequest {
    public:
-    LockRequest(txn_id_t txn_id, LockMode lock_mode) : txn_id_(txn_id), lock_mode_(lock_mode), granted_(false) {}
+    LockRequest(Transaction *txn, LockMode lock_mode)
+        : txn_id_(txn->GetTransactionId()), lock_mode_(lock_mode), granted_(false), txn_(txn) {}
 
     txn_id_t txn_id_;
     LockMode lock_mode_;
     bool granted_;
+    /** The requesting transaction, which cycle detection aborts while the request waits, and wound-wait at any time. */
+    Transaction *txn_;
   };
 
+  /** The requests of a queue, which are charged to the LOCK_TABLE subsystem, as are the queues. */
+  using LockRequestList = std::list<LockRequest, TrackedAllocator<LockRequest, MemorySubsystem::LOCK_TABLE>>;
+
   class LockRequestQueue {
    public:
-    std::list<LockRequest> request_queue_;
+    /** The granted requests, followed by the waiting ones in the order that they are granted in. */
+    LockRequestList request_queue_;
     std::condition_variable cv_;  // for notifying blocked transactions on this rid
     bool upgrading_ = false;
+    int64_t resource_ = 0;  // the row (RID::Get()) or the table oid, for the contention profiler
+  };
+
+  /** Where a transaction of the waits-for graph waits: a queue, and the latch of the lock table part that it is in. */
+  struct WaitingRequest {
+    LockRequestQueue *queue_;
+    std::mutex *latch_;
+  };
+
+  using WaitsForGraph = std::unordered_map<txn_id_t, std::vector<txn_id_t>>;
+
+  /** The queues of the rows or tables, by row or table. */
+  template <class K>
+  using LockQueueMap =
+      std::unordered_map<K, LockRequestQueue, std::hash<K>, std::equal_to<K>,
+                         TrackedAllocator<std::pair<const K, LockRequestQueue>, MemorySubsystem::LOCK_TABLE>>;
+
+  /** A part of the lock table. The queues of a partition are latched by its latch, requests wait on their queue. */
+  struct LockTablePartition {
+    std::mutex latch_;
+    LockQueueMap<RID> lock_table_;
   };
 
  public:
@@ -87,31 +138,47 @@ class LockManager {
    * 2. block on wait, return true when the lock request is granted; and
    * 3. it is undefined behavior to try locking an already locked RID in the same transaction, i.e. the transaction
    *    is responsible for keeping track of its current locks.
+   * Requests are granted in their order of arrival. With deadlock prevention, a request that would wait for an older
+   * transaction aborts its own transaction instead (wait-die). With wound-wait, a request that would wait for a younger
+   * transaction aborts that one instead and waits until it is gone; a wounded transaction finds out through its state,
+   * within wound_check_interval if it waits for a lock. With deadlock detection, the background thread aborts the
+   * newest transaction of every cycle of waiting transactions.
+   *
+   * [ESCALATION_NOTE]: A row lock can be taken as a row of its table. Such a row needs no lock of its own while the
+   * transaction holds a table lock that covers it, and once the transaction holds lock_escalation_threshold row locks
+   * on the table, they are replaced by a SHARED or EXCLUSIVE lock on the table. Escalation never waits: if another
+   * transaction holds or waits for a conflicting table lock, the row locks are kept and escalation is tried again after
+   * another lock_escalation_threshold rows.
+   * While the lock table is over the soft limit of its memory, see MemoryAccounting, the threshold is at most
+   * LOCK_ESCALATION_PRESSURE_ROWS, also where escalation is off.
    */
 
   /**
    * Acquire a lock on RID in shared mode. See [LOCK_NOTE] in header file.
    * @param txn the transaction requesting the shared lock
    * @param rid the RID to be locked in shared mode
+   * @param oid the table of the row, see [ESCALATION_NOTE], or INVALID_TABLE_OID
    * @return true if the lock is granted, false otherwise
    */
-  bool LockShared(Transaction *txn, const RID &rid);
+  bool LockShared(Transaction *txn, const RID &rid, table_oid_t oid = INVALID_TABLE_OID);
 
   /**
    * Acquire a lock on RID in exclusive mode. See [LOCK_NOTE] in header file.
    * @param txn the transaction requesting the exclusive lock
    * @param rid the RID to be locked in exclusive mode
+   * @param oid the table of the row, see [ESCALATION_NOTE], or INVALID_TABLE_OID
    * @return true if the lock is granted, false otherwise
    */
-  bool LockExclusive(Transaction *txn, const RID &rid);
+  bool LockExclusive(Transaction *txn, const RID &rid, table_oid_t oid = INVALID_TABLE_OID);
 
   /**
    * Upgrade a lock from a shared lock to an exclusive lock.
    * @param txn the transaction requesting the lock upgrade
    * @param rid the RID that should already be locked in shared mode by the requesting transaction
+   * @param oid the table of the row, see [ESCALATION_NOTE], or INVALID_TABLE_OID
    * @return true if the upgrade is successful, false otherwise
    */
-  bool LockUpgrade(Transaction *txn, const RID &rid);
+  bool LockUpgrade(Transaction *txn, const RID &rid, table_oid_t oid = INVALID_TABLE_OID);
 
   /**
    * Release the lock held by the transaction.
@@ -121,6 +188,40 @@ class LockManager {
    */
   bool Unlock(Transaction *txn, const RID &rid);
 
+  /**
+   * Acquire a lock on a table, or strengthen the lock that the transaction holds on it: a lock that covers both the
+   * held and the requested mode is acquired, e.g. SHARED_INTENTION_EXCLUSIVE for SHARED and INTENTION_EXCLUSIVE. See
+   * [LOCK_NOTE] in header file, except that the table may be locked already.
+   * @param txn the transaction requesting the lock
+   * @param oid the table to be locked
+   * @param lock_mode the mode that the table is needed in
+   * @return true if the lock is granted, false otherwise
+   */
+  bool LockTable(Transaction *txn, table_oid_t oid, LockMode lock_mode);
+
+  /**
+   * Release the lock held by the transaction on a table. The locks on its rows should be released before.
+   * @param txn the transaction releasing the lock, it should actually hold the lock
+   * @param oid the table that is locked by the transaction
+   * @return true if the unlock is successful, false otherwise
+   */
+  bool UnlockTable(Transaction *txn, table_oid_t oid);
+
+  /** @return the current value of the counters of the lock manager */
+  LockManagerStats GetStats() const;
+
+  /**
+   * Adds the counters of GetStats() and the distribution of the lock wait times to a snapshot, see MetricsRegistry.
+   * @param snapshot the snapshot to add the metrics to
+   */
+  void CollectMetrics(MetricsSnapshot *snapshot) const;
+
+  /** @return true if locks of the two modes can be held on the same table or row at the same time */
+  static bool AreCompatible(LockMode held, LockMode requested);
+
+  /** @return true if a lock of mode held allows everything that a lock of mode requested does */
+  static bool Covers(LockMode held, LockMode requested);
+
   /*** Graph API ***/
   /**
    * Adds edge t1->t2
@@ -151,15 +252,140 @@ class LockManager {
 
   bool Detection() { return deadlock_mode_ == DeadlockMode::DETECTION; }
   bool Prevention() { return deadlock_mode_ == DeadlockMode::PREVENTION; }
+  bool WoundWait() { return deadlock_mode_ == DeadlockMode::WOUND_WAIT; }
+
+  /** @return the partition of the lock table that the queue of rid is in */
+  LockTablePartition *GetPartition(const RID &rid) {
+    const size_t hash = std::hash<RID>()(rid);
+    return &lock_table_[(hash ^ (hash >> 32)) % LOCK_TABLE_PARTITIONS];
+  }
+
+  /**
+   * Waits until a request is granted, or until its transaction is aborted. An aborted request is removed.
+   * @param lock the held latch of the partition of the queue
+   * @param queue the queue of the request
+   * @param request the request, which must be in the queue
+   * @return true if the request was granted
+   */
+  bool WaitForGrant(std::unique_lock<std::mutex> *lock, LockRequestQueue *queue,
+                    LockRequestList::iterator request);
+
+  /**
+   * Counts the wait of a request of txn that began at wait_start, and reports it to the contention profiler and, if
+   * the transaction is traced, to the Tracer, if it waited at all.
+   */
+  void RecordWait(std::unique_lock<std::mutex> *lock, const LockRequestQueue &queue, Transaction *txn,
+                  std::chrono::steady_clock::time_point wait_start);
+
+  /**
+   * Releases the lock on a row, without the change to the transaction's state of Unlock().
+   * @return true if the transaction held the lock
+   */
+  bool ReleaseRow(Transaction *txn, const RID &rid);
+
+  /** Counts a granted row lock towards the lock escalation of its table, and escalates at the threshold. */
+  void AddTableRow(Transaction *txn, const RID &rid, table_oid_t oid);
+
+  /**
+   * Replaces the row locks of the transaction on a table by a lock on the table, if it can be granted without waiting.
+   * @return true if the row locks were replaced
+   */
+  bool Escalate(Transaction *txn, table_oid_t oid);
+
+  /** Removes the queue of rid from the partition, whose latch is held, if no request is left in it. */
+  static void EraseIfEmpty(LockTablePartition *partition, const RID &rid);
+
+  /**
+   * Replaces the granted request of the transaction in the queue by a waiting one for a stronger mode, which goes
+   * ahead of the other waiting requests and waits for the other holders only. A failed upgrade releases the lock.
+   * @param lock the held latch of the partition of the queue
+   * @param queue the queue of the request
+   * @param txn the transaction, whose request is granted
+   * @param lock_mode the stronger mode
+   * @return true if the stronger mode was granted
+   */
+  bool WaitForUpgrade(std::unique_lock<std::mutex> *lock, LockRequestQueue *queue, Transaction *txn,
+                      LockMode lock_mode);
+
+  /**
+   * Aborts a transaction of the waits-for graph if it still waits in the queue, and wakes it up.
+   * @param queue the queue that the transaction waited in, whose latch is held
+   * @param txn_id the transaction
+   */
+  static void AbortWaiting(LockRequestQueue *queue, txn_id_t txn_id);
+
+  /** @return true if no request before request conflicts with it */
+  static bool IsGrantable(const LockRequestQueue &queue, LockRequestList::const_iterator request);
+
+  /** @return true if a request that conflicts with request and is before it was made by an older transaction */
+  static bool WaitsForOlder(const LockRequestQueue &queue, LockRequestList::const_iterator request);
+
+  /**
+   * Aborts the younger transactions whose requests conflict with request and are before it, unless they are done
+   * already, and wakes up the ones of them that wait in the queue.
+   * @param queue the queue of the request, whose latch is held
+   * @param request the waiting request
+   */
+  static void WoundYounger(LockRequestQueue *queue, LockRequestList::const_iterator request);
+
+  /**
+   * Replaces the edges of a waiting request in the waits-for graph by the conflicting requests before it.
+   * @param lock the held latch of the partition of the queue
+   * @param queue the queue of the request
+   * @param request the waiting request
+   */
+  void SetWaiting(std::unique_lock<std::mutex> *lock, LockRequestQueue *queue,
+                  LockRequestList::const_iterator request);
+
+  /** Removes the edges of a transaction that no longer waits from the waits-for graph, the partition latch is held. */
+  void ClearWaiting(txn_id_t txn_id);
+
+  /**
+   * Finds a cycle in a waits-for graph.
+   * @param graph the graph, whose edges are sorted by the search
+   * @param[out] txn_id the newest transaction of the cycle
+   * @return true if the graph has a cycle
+   */
+  static bool FindVictim(WaitsForGraph *graph, txn_id_t *txn_id);
+
+  /**
+   * Depth-first search for a cycle through the waits-for graph.
+   * @param graph the graph
+   * @param txn_id the transaction that the search is at
+   * @param[in,out] path the transactions on the way to txn_id
+   * @param[in,out] visited the transactions that the search has been at
+   * @param[out] victim the newest transaction of the cycle that was found
+   * @return true if a cycle was found
+   */
+  static bool FindCycle(const WaitsForGraph &graph, txn_id_t txn_id, std::vector<txn_id_t> *path,
+                        std::unordered_set<txn_id_t> *visited, txn_id_t *victim);
 
-  std::mutex latch_;
   std::atomic<bool> enable_cycle_detection_;
   std::thread *cycle_detection_thread_;
 
-  /** Lock table for lock requests. */
-  std::unordered_map<RID, LockRequestQueue> lock_table_;
-  /** Waits-for graph representation. */
-  std::unordered_map<txn_id_t, std::vector<txn_id_t>> waits_for_;
+  /** Counters reported by GetStats, only updated by requests that wait and by the cycle detection thread. */
+  std::atomic<uint64_t> lock_waits_{0};
+  std::atomic<uint64_t> lock_wait_time_us_{0};
+  std::atomic<uint64_t> aborted_requests_{0};
+  std::atomic<uint64_t> detection_runs_{0};
+  std::atomic<uint64_t> detection_time_us_{0};
+  std::atomic<uint64_t> detection_victims_{0};
+  /** Microseconds of the lock waits. */
+  MetricHistogram lock_wait_us_;
+
+  /** Lock table for lock requests, split into partitions by the hash of the rid. */
+  std::array<LockTablePartition, LOCK_TABLE_PARTITIONS> lock_table_;
+  /** Latches the lock requests on tables, which are few and mostly taken in intention modes. */
+  std::mutex table_latch_;
+  /** Lock table for lock requests on tables. */
+  LockQueueMap<table_oid_t> table_lock_table_;
+
+  /** Latches the waits-for graph and the waiting map. Taken while holding a lock table latch, never before one. */
+  std::mutex latch_;
+  /** Waits-for graph representation, kept up to date by the waiting requests with deadlock detection. */
+  WaitsForGraph waits_for_;
+  /** The waiting transactions of the waits-for graph, with the queues that they wait in. */
+  std::unordered_map<txn_id_t, WaitingRequest> waiting_;
 };
 
 }  // namespace bustub
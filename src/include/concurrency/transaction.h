@@ -13,13 +13,14 @@
 #pragma once
 
 #include <atomic>
-#include <deque>
-#include <memory>
 #include <thread>  // NOLINT
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "common/config.h"
 #include "common/logger.h"
+#include "common/memory_accounting.h"
 #include "storage/page/page.h"
 #include "storage/table/tuple.h"
 
@@ -36,51 +37,122 @@ namespace bustub {
  **/
 enum class TransactionState { GROWING, SHRINKING, COMMITTED, ABORTED };
 
+/**
+ * Isolation levels. REPEATABLE_READ locks what it reads. SNAPSHOT_ISOLATION reads the rows as of its begin without
+ * locks, and aborts when writing a row that was changed after its begin. OPTIMISTIC reads like a snapshot and buffers
+ * its writes; it locks and writes the rows only when it commits, and aborts if a row that it read changed meanwhile.
+ */
+enum class IsolationLevel { REPEATABLE_READ, SNAPSHOT_ISOLATION, OPTIMISTIC };
+
+/**
+ * Lock modes. Rows are locked SHARED or EXCLUSIVE. A table is locked in one of the intention modes before its rows, or
+ * SHARED or EXCLUSIVE to lock all its rows at once. SHARED_INTENTION_EXCLUSIVE reads the whole table and writes some
+ * of its rows.
+ */
+enum class LockMode { SHARED, EXCLUSIVE, INTENTION_SHARED, INTENTION_EXCLUSIVE, SHARED_INTENTION_EXCLUSIVE };
+
 /**
  * Type of write operation.
  */
-enum class WType { INSERT = 0, DELETE, UPDATE };
+enum class WType {
+  INSERT = 0,
+  DELETE,
+  UPDATE,
+  /** A page that a bulk insert filled, the rid is any rid on the page. */
+  BULKINSERT,
+  /** A truncation of a table, the tuple holds what the table had before, see TableHeap::Truncate(). */
+  TRUNCATE
+};
 
 class TableHeap;
 
 /**
  * WriteRecord tracks information related to a write.
+ *
+ * With logging on, the log holds what a write changed, and an abort reads its record back to roll it back, see
+ * TransactionManager::Abort(). The write record then only tells where the write was and which record logged it.
  */
 class WriteRecord {
  public:
-  WriteRecord(RID rid, WType wtype, const Tuple &tuple, TableHeap *table)
-      : rid_(rid), wtype_(wtype), tuple_(tuple), table_(table) {}
+  WriteRecord(RID rid, WType wtype, const Tuple &tuple, TableHeap *table, lsn_t lsn = INVALID_LSN)
+      : rid_(rid), wtype_(wtype), lsn_(lsn), tuple_(tuple), table_(table) {}
 
   RID rid_;
   WType wtype_;
-  /** The tuple is only used for the update operation. */
+  /** The LSN of the last log record of the write, INVALID_LSN if it was not logged. */
+  lsn_t lsn_;
+  /**
+   * The tuple is only used for the insert in a write buffer and the truncation, for the tuple before an update that
+   * was not logged or whose table stores values out of line, and for the tuple before an update or a delete of a table
+   * with commit listeners, see TableHeap::AddCommitListener(). It is empty otherwise.
+   */
   Tuple tuple_;
   /** The table heap specifies which table this write record is for. */
   TableHeap *table_;
 };
 
+/** The write records of a transaction, whose storage is charged to the WRITE_SET subsystem. */
+using WriteRecordVector = std::vector<WriteRecord, TrackedAllocator<WriteRecord, MemorySubsystem::WRITE_SET>>;
+
+/**
+ * ReadRecord tracks a row that an optimistic transaction read, which is validated when it commits.
+ */
+class ReadRecord {
+ public:
+  ReadRecord(RID rid, TableHeap *table) : rid_(rid), table_(table) {}
+
+  RID rid_;
+  /** The table heap specifies which table this read record is for. */
+  TableHeap *table_;
+};
+
 /**
- * Transaction tracks information related to a transaction.
+ * Transaction tracks information related to a transaction. The sets that it tracks are held inline and allocate
+ * nothing until they are first used; Reset() keeps their storage, so that a transaction that is reused for another one
+ * allocates nothing at all unless it needs more than the ones before.
  */
 class Transaction {
  public:
-  explicit Transaction(txn_id_t txn_id)
+  explicit Transaction(txn_id_t txn_id, IsolationLevel isolation_level = IsolationLevel::REPEATABLE_READ,
+                       bool read_only = false)
       : state_(TransactionState::GROWING),
+        isolation_level_(read_only ? IsolationLevel::SNAPSHOT_ISOLATION : isolation_level),
+        read_only_(read_only),
         thread_id_(std::this_thread::get_id()),
         txn_id_(txn_id),
-        prev_lsn_(INVALID_LSN),
-        shared_lock_set_{new std::unordered_set<RID>},
-        exclusive_lock_set_{new std::unordered_set<RID>} {
-    // Initialize the sets that will be tracked.
-    write_set_ = std::make_shared<std::deque<WriteRecord>>();
-    page_set_ = std::make_shared<std::deque<bustub::Page *>>();
-    deleted_page_set_ = std::make_shared<std::unordered_set<page_id_t>>();
-  }
+        prev_lsn_(INVALID_LSN) {}
 
   ~Transaction() = default;
 
   DISALLOW_COPY(Transaction);
 
+  /**
+   * Reinitializes a finished transaction as a new one, see TransactionManager::Recycle().
+   * @param txn_id the id of the new transaction
+   * @param isolation_level the isolation level of the new transaction
+   * @param read_only true if the new transaction is read-only
+   */
+  void Reset(txn_id_t txn_id, IsolationLevel isolation_level, bool read_only) {
+    state_ = TransactionState::GROWING;
+    isolation_level_ = read_only ? IsolationLevel::SNAPSHOT_ISOLATION : isolation_level;
+    read_only_ = read_only;
+    read_ts_ = 0;
+    thread_id_ = std::this_thread::get_id();
+    txn_id_ = txn_id;
+    prev_lsn_ = INVALID_LSN;
+    synchronous_commit_ = true;
+    trace_start_ns_ = 0;
+    write_set_.clear();
+    read_set_.clear();
+    write_buffer_.clear();
+    page_set_.clear();
+    deleted_page_set_.clear();
+    shared_lock_set_.clear();
+    exclusive_lock_set_.clear();
+    table_lock_set_.clear();
+    table_row_lock_set_.clear();
+  }
+
   /** @return the id of the thread running the transaction */
   inline std::thread::id GetThreadId() const { return thread_id_; }
 
@@ -88,37 +160,63 @@ class Transaction {
   inline txn_id_t GetTransactionId() const { return txn_id_; }
 
   /** @return the list of of write records of this transaction */
-  inline std::shared_ptr<std::deque<WriteRecord>> GetWriteSet() { return write_set_; }
+  inline WriteRecordVector *GetWriteSet() { return &write_set_; }
+
+  /** @return the rows that this transaction read, if it is optimistic */
+  inline std::vector<ReadRecord> *GetReadSet() { return &read_set_; }
+
+  /** @return the writes that this transaction buffered until it commits, if it is optimistic */
+  inline WriteRecordVector *GetWriteBuffer() { return &write_buffer_; }
 
   /** @return the page set */
-  inline std::shared_ptr<std::deque<Page *>> GetPageSet() { return page_set_; }
+  inline std::vector<Page *> *GetPageSet() { return &page_set_; }
 
   /**
    * Adds a page into the page set.
    * @param page page to be added
    */
-  inline void AddIntoPageSet(Page *page) { page_set_->push_back(page); }
+  inline void AddIntoPageSet(Page *page) { page_set_.push_back(page); }
 
   /** @return the deleted page set */
-  inline std::shared_ptr<std::unordered_set<page_id_t>> GetDeletedPageSet() { return deleted_page_set_; }
+  inline std::unordered_set<page_id_t> *GetDeletedPageSet() { return &deleted_page_set_; }
 
   /**
    * Adds a page to the deleted page set.
    * @param page_id id of the page to be marked as deleted
    */
-  inline void AddIntoDeletedPageSet(page_id_t page_id) { deleted_page_set_->insert(page_id); }
+  inline void AddIntoDeletedPageSet(page_id_t page_id) { deleted_page_set_.insert(page_id); }
 
   /** @return the set of resources under a shared lock */
-  inline std::shared_ptr<std::unordered_set<RID>> GetSharedLockSet() { return shared_lock_set_; }
+  inline std::unordered_set<RID> *GetSharedLockSet() { return &shared_lock_set_; }
 
   /** @return the set of resources under an exclusive lock */
-  inline std::shared_ptr<std::unordered_set<RID>> GetExclusiveLockSet() { return exclusive_lock_set_; }
+  inline std::unordered_set<RID> *GetExclusiveLockSet() { return &exclusive_lock_set_; }
 
   /** @return true if rid is shared locked by this transaction */
-  bool IsSharedLocked(const RID &rid) { return shared_lock_set_->find(rid) != shared_lock_set_->end(); }
+  bool IsSharedLocked(const RID &rid) { return shared_lock_set_.find(rid) != shared_lock_set_.end(); }
 
   /** @return true if rid is exclusively locked by this transaction */
-  bool IsExclusiveLocked(const RID &rid) { return exclusive_lock_set_->find(rid) != exclusive_lock_set_->end(); }
+  bool IsExclusiveLocked(const RID &rid) { return exclusive_lock_set_.find(rid) != exclusive_lock_set_.end(); }
+
+  /** @return the locked tables and the modes that they are locked in */
+  inline std::unordered_map<table_oid_t, LockMode> *GetTableLockSet() { return &table_lock_set_; }
+
+  /** @return true if the table is locked in a mode that lets this transaction read all its rows without row locks */
+  bool IsTableSharedLocked(table_oid_t oid) {
+    auto it = table_lock_set_.find(oid);
+    return it != table_lock_set_.end() &&
+           (it->second == LockMode::SHARED || it->second == LockMode::SHARED_INTENTION_EXCLUSIVE ||
+            it->second == LockMode::EXCLUSIVE);
+  }
+
+  /** @return the locked rows of each table, for lock escalation; rows locked without their table are not in it */
+  inline std::unordered_map<table_oid_t, std::unordered_set<RID>> *GetTableRowLockSet() { return &table_row_lock_set_; }
+
+  /** @return true if the table is exclusively locked by this transaction */
+  bool IsTableExclusiveLocked(table_oid_t oid) {
+    auto it = table_lock_set_.find(oid);
+    return it != table_lock_set_.end() && it->second == LockMode::EXCLUSIVE;
+  }
 
   /** @return the current state of the transaction */
   inline TransactionState GetState() { return state_; }
@@ -129,6 +227,27 @@ class Transaction {
    */
   inline void SetState(TransactionState state) { state_ = state; }
 
+  /** @return the isolation level of the transaction */
+  inline IsolationLevel GetIsolationLevel() const { return isolation_level_; }
+
+  /** @return true if the transaction reads a snapshot, which an optimistic one does as well */
+  inline bool IsSnapshot() const { return isolation_level_ != IsolationLevel::REPEATABLE_READ; }
+
+  /**
+   * @return true if the transaction must not write. It reads a snapshot whatever its isolation level, which is
+   * serializable without any locks since it writes nothing, and it logs nothing.
+   */
+  inline bool IsReadOnly() const { return read_only_; }
+
+  /** @return true if the transaction buffers its writes and validates its reads when it commits */
+  inline bool IsOptimistic() const { return isolation_level_ == IsolationLevel::OPTIMISTIC; }
+
+  /** @return the commit timestamp of the newest transaction that this one sees the writes of */
+  inline timestamp_t GetReadTs() const { return read_ts_; }
+
+  /** @param read_ts the commit timestamp that the snapshot of the transaction is taken at */
+  inline void SetReadTs(timestamp_t read_ts) { read_ts_ = read_ts; }
+
   /** @return the previous LSN */
   inline lsn_t GetPrevLSN() { return prev_lsn_; }
 
@@ -138,28 +257,64 @@ class Transaction {
    */
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
+  /** @return false if the commit of the transaction does not wait for its commit record to be on disk */
+  inline bool IsSynchronousCommit() const { return synchronous_commit_; }
+
+  /**
+   * Sets whether the commit of the transaction waits for its commit record to be on disk.
+   * @param synchronous_commit false to return from the commit before, a crash right after may lose the transaction
+   */
+  inline void SetSynchronousCommit(bool synchronous_commit) { synchronous_commit_ = synchronous_commit; }
+
+  /** @return true if the transaction was sampled for tracing, see Tracer */
+  inline bool IsTraced() const { return trace_start_ns_ != 0; }
+
+  /** @return the Tracer::Now() at which a traced transaction began */
+  inline uint64_t GetTraceStart() const { return trace_start_ns_; }
+
+  /** @param trace_start_ns the Tracer::Now() at which the transaction began, to trace it */
+  inline void SetTraceStart(uint64_t trace_start_ns) { trace_start_ns_ = trace_start_ns; }
+
  private:
   /** The current transaction state. */
   TransactionState state_;
+  /** The isolation level of the transaction. */
+  IsolationLevel isolation_level_;
+  /** True if the transaction must not write. */
+  bool read_only_;
+  /** The commit timestamp that the snapshot of the transaction is taken at. */
+  timestamp_t read_ts_{0};
   /** The thread ID, used in single-threaded transactions. */
   std::thread::id thread_id_;
   /** The ID of this transaction. */
   txn_id_t txn_id_;
 
   /** The undo set of the transaction. */
-  std::shared_ptr<std::deque<WriteRecord>> write_set_;
-  /** The LSN of the last record written by the transaction. */
-  lsn_t prev_lsn_;
+  WriteRecordVector write_set_;
+  /** The rows read by an optimistic transaction. */
+  std::vector<ReadRecord> read_set_;
+  /** The writes of an optimistic transaction that are not written yet; the rid of an insert is invalid. */
+  WriteRecordVector write_buffer_;
+  /** The LSN of the last record written by the transaction. Checkpoints read it while the transaction runs. */
+  std::atomic<lsn_t> prev_lsn_;
+  /** False if the commit does not wait for the commit record to be on disk. */
+  bool synchronous_commit_ = true;
+  /** The Tracer::Now() at which the transaction began if it is traced, 0 otherwise. */
+  uint64_t trace_start_ns_{0};
 
   /** Concurrent index: the pages that were latched during index operation. */
-  std::shared_ptr<std::deque<Page *>> page_set_;
+  std::vector<Page *> page_set_;
   /** Concurrent index: the page IDs that were deleted during index operation.*/
-  std::shared_ptr<std::unordered_set<page_id_t>> deleted_page_set_;
+  std::unordered_set<page_id_t> deleted_page_set_;
 
   /** LockManager: the set of shared-locked tuples held by this transaction. */
-  std::shared_ptr<std::unordered_set<RID>> shared_lock_set_;
+  std::unordered_set<RID> shared_lock_set_;
   /** LockManager: the set of exclusive-locked tuples held by this transaction. */
-  std::shared_ptr<std::unordered_set<RID>> exclusive_lock_set_;
+  std::unordered_set<RID> exclusive_lock_set_;
+  /** LockManager: the tables locked by this transaction, with their lock modes. */
+  std::unordered_map<table_oid_t, LockMode> table_lock_set_;
+  /** LockManager: the locked rows of each table, which are counted towards lock escalation. */
+  std::unordered_map<table_oid_t, std::unordered_set<RID>> table_row_lock_set_;
 };
 
 }  // namespace bustub
@@ -13,12 +13,16 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
+#include "concurrency/transaction_registry.h"
 #include "recovery/log_manager.h"
 
 namespace bustub {
@@ -32,50 +36,88 @@ class TransactionManager {
   explicit TransactionManager(LockManager *lock_manager, LogManager *log_manager = nullptr)
       : lock_manager_(lock_manager), log_manager_(log_manager) {}
 
-  ~TransactionManager() = default;
+  /** Deletes the transactions that were recycled. */
+  ~TransactionManager();
 
   /**
-   * Begins a new transaction.
-   * @param txn an optional transaction object to be initialized, otherwise a new transaction is created
+   * Begins a new transaction. A snapshot sees the writes of the transactions that committed before.
+   * @param txn an optional transaction object to be initialized, otherwise a recycled transaction is reused, or a new
+   * one is created if there is none
+   * @param isolation_level the isolation level of the new transaction if txn is nullptr
+   * @param read_only true if the new transaction is read-only, see Transaction::IsReadOnly()
    * @return an initialized transaction
    */
-  Transaction *Begin(Transaction *txn = nullptr);
+  Transaction *Begin(Transaction *txn = nullptr, IsolationLevel isolation_level = IsolationLevel::REPEATABLE_READ,
+                     bool read_only = false);
 
   /**
-   * Commits a transaction.
+   * Commits a transaction. Unless the commit is asynchronous, it returns once the commit record is on disk. An
+   * optimistic transaction writes its buffered writes first, and is aborted instead if a row that it read or writes
+   * changed after its begin; its state tells whether it committed.
    * @param txn the transaction to commit
    */
   void Commit(Transaction *txn);
 
   /**
-   * Aborts a transaction
+   * Sets whether the commits of all transactions wait for their commit records to be on disk. A commit is
+   * asynchronous if it is turned off here or for its transaction.
+   * @param synchronous_commit false to let commits return before, within the bounds of async_commit_delay and
+   * async_commit_max_lag
+   */
+  void SetSynchronousCommit(bool synchronous_commit) { synchronous_commit_ = synchronous_commit; }
+
+  /**
+   * Aborts a transaction, rolling back its writes from the last to the first. With logging on, the tuple before an
+   * update is read back from its log record rather than kept in the write set, and every write that is rolled back is
+   * followed by a compensation log record, so that undo after a crash during the abort does not roll it back again.
    * @param txn the transaction to abort
    */
   void Abort(Transaction *txn);
 
+  /**
+   * Takes back a committed or aborted transaction instead of deleting it, Begin() reuses it with the storage of its
+   * sets. The transaction must not be used by the caller anymore; it is deleted with the transaction manager.
+   * @param txn the transaction that ended
+   */
+  void Recycle(Transaction *txn);
+
   /**
    * Global list of running transactions
    */
 
-  /** The transaction map is a global list of all the running transactions in the system. */
-  static std::unordered_map<txn_id_t, Transaction *> txn_map;
+  /** The transaction registry is a global list of all the running transactions in the system. */
+  static TransactionRegistry txn_registry;
+
+  /**
+   * Takes a snapshot of the active transaction table for a fuzzy checkpoint, without blocking any transaction.
+   * @param[out] begin_lsn if not nullptr, the LSN of the oldest BEGIN record of the transactions, INVALID_LSN if none
+   * of them has one
+   * @return the transactions that have neither committed nor aborted, each with the LSN of its last log record; the
+   * read-only ones, which log nothing, are left out
+   */
+  std::vector<std::pair<txn_id_t, lsn_t>> GetActiveTransactions(lsn_t *begin_lsn = nullptr);
+
+  /** @return the ids of the transactions that have neither committed nor aborted, the read-only ones included */
+  std::vector<txn_id_t> GetActiveTxnIds();
+
+  /** @return the oldest read timestamp of the snapshots, the versions before which no transaction reads anymore */
+  timestamp_t GetWatermark();
 
   /**
    * Locates and returns the transaction with the given transaction ID.
-   * @param txn_id the id of the transaction to be found, it must exist!
+   * @param txn_id the id of the transaction to be found, it must be running!
    * @return the transaction with the given transaction id
    */
   static Transaction *GetTransaction(txn_id_t txn_id) {
-    assert(TransactionManager::txn_map.find(txn_id) != TransactionManager::txn_map.end());
-    auto *res = TransactionManager::txn_map[txn_id];
+    auto *res = TransactionManager::txn_registry.Find(txn_id);
     assert(res != nullptr);
     return res;
   }
 
-  /** Prevents all transactions from performing operations, used for checkpointing. */
+  /** Prevents all transactions from performing operations, used for consistent checkpoints. */
   void BlockAllTransactions();
 
-  /** Resumes all transactions, used for checkpointing. */
+  /** Resumes all transactions, used for consistent checkpoints. */
   void ResumeTransactions();
 
  private:
@@ -84,6 +126,8 @@ class TransactionManager {
    * @param txn the transaction whose locks should be released
    */
   void ReleaseLocks(Transaction *txn) {
+    // All the rows are unlocked, there is no need to keep track of them by table.
+    txn->GetTableRowLockSet()->clear();
     std::unordered_set<RID> lock_set;
     for (auto item : *txn->GetExclusiveLockSet()) {
       lock_set.emplace(item);
@@ -94,14 +138,64 @@ class TransactionManager {
     for (auto locked_rid : lock_set) {
       lock_manager_->Unlock(txn, locked_rid);
     }
+    // The tables are unlocked after their rows.
+    std::vector<table_oid_t> tables;
+    for (const auto &[oid, lock_mode] : *txn->GetTableLockSet()) {
+      tables.push_back(oid);
+    }
+    for (const table_oid_t oid : tables) {
+      lock_manager_->UnlockTable(txn, oid);
+    }
   }
 
+  /**
+   * Removes a committed or aborted transaction from the active transaction table.
+   * @param txn the transaction that ended
+   */
+  void EndTransaction(Transaction *txn);
+
+  /**
+   * Writes the buffered writes of an optimistic transaction, after locking all the rows that they write.
+   * @param txn the committing transaction
+   * @return false if a row could not be locked or written, the transaction must be aborted then
+   */
+  bool WriteBuffered(Transaction *txn);
+
+  /**
+   * Stamps the versions that a committing transaction wrote with its commit timestamp, and makes them visible to the
+   * snapshots that begin afterwards. The reads of an optimistic transaction are validated first.
+   * @param txn the committing transaction
+   * @return false if a read failed validation, nothing was stamped then
+   */
+  bool CommitVersions(Transaction *txn);
+
+  /** @return the watermark of the versions, see GetWatermark(), called while holding commit_latch_ */
+  timestamp_t ComputeWatermark();
+
   std::atomic<txn_id_t> next_txn_id_{0};
   LockManager *lock_manager_ __attribute__((__unused__));
   LogManager *log_manager_ __attribute__((__unused__));
 
-  /** The global transaction latch is used for checkpointing. */
-  ReaderWriterLatch global_txn_latch_;
+  /** The global transaction latch is used for consistent checkpoints. */
+  DistributedReaderWriterLatch global_txn_latch_;
+
+  /**
+   * The transactions of this transaction manager that have neither committed nor aborted yet, each with the LSN of its
+   * BEGIN record.
+   */
+  std::unordered_map<txn_id_t, std::pair<Transaction *, lsn_t>> active_txns_;
+  /** The nodes of the entries erased from active_txns_, which its inserts reuse. */
+  std::vector<decltype(active_txns_)::node_type> active_txns_nodes_;
+  /** The recycled transactions, which Begin() reuses. */
+  std::vector<Transaction *> txn_pool_;
+  /** Protects active_txns_, and the recycled transactions and nodes. */
+  std::mutex active_txns_latch_;
+  /** The commit timestamp of the last transaction whose versions are visible, the read timestamp of a new snapshot. */
+  std::atomic<timestamp_t> last_commit_ts_{0};
+  /** Serializes the commit timestamps, a transaction is visible only once all before it are. */
+  std::mutex commit_latch_;
+  /** False if no commit waits for its commit record to be on disk. */
+  std::atomic<bool> synchronous_commit_{true};
 };
 
 }  // namespace bustub
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// transaction_registry.h
+//
+// Identification: src/include/concurrency/transaction_registry.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+
+#include "common/config.h"
+
+namespace bustub {
+
+class Transaction;
+
+/**
+ * TransactionRegistry maps the ids of the running transactions to the transactions. A transaction has the slot at its
+ * id modulo TXN_REGISTRY_SIZE, which is free unless a transaction TXN_REGISTRY_SIZE ids before is still running; then
+ * it goes into an overflow map under a latch instead. Registering, unregistering and finding a transaction in its slot
+ * take no latch and allocate nothing.
+ *
+ * The slots are never freed, so a concurrent find only ever reads a slot that is reused, which it detects by the id in
+ * the slot. The transaction that a find returns is not kept alive by the registry.
+ */
+class TransactionRegistry {
+ public:
+  /**
+   * Registers a transaction under its id, replacing the transaction registered under the id before if there is one.
+   * @param txn the transaction that begins
+   */
+  void Register(Transaction *txn);
+
+  /**
+   * Unregisters a transaction.
+   * @param txn the transaction that ended
+   */
+  void Unregister(Transaction *txn);
+
+  /**
+   * @param txn_id the id of the transaction to be found
+   * @return the transaction registered under txn_id, nullptr if there is none
+   */
+  Transaction *Find(txn_id_t txn_id);
+
+ private:
+  /** A slot of the registry. A transaction is in it while both its id and the transaction are. */
+  struct Slot {
+    std::atomic<txn_id_t> txn_id_{INVALID_TXN_ID};
+    std::atomic<Transaction *> txn_{nullptr};
+  };
+
+  /** @return the slot of the transaction with the given id */
+  Slot *GetSlot(txn_id_t txn_id) { return &slots_[static_cast<uint32_t>(txn_id) % TXN_REGISTRY_SIZE]; }
+
+  std::array<Slot, TXN_REGISTRY_SIZE> slots_;
+  /** The transactions whose slot is taken by another transaction. */
+  std::unordered_map<txn_id_t, Transaction *> overflow_;
+  /** The number of transactions in overflow_, which finds check before they take the latch. */
+  std::atomic<size_t> overflow_size_{0};
+  /** Protects overflow_. */
+  std::mutex overflow_latch_;
+};
+
+}  // namespace bustub
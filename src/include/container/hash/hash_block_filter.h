@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_block_filter.h
+//
+// Identification: src/include/container/hash/hash_block_filter.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+
+#include "common/config.h"
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/**
+ * An in-memory blocked Bloom filter of the keys of a hash table, one filter per block of the table. A key is added to
+ * the filter of its home block, and a lookup whose key is not in the filter of its home block can skip the block
+ * pages altogether. A key sets HASH_TABLE_FILTER_PROBES bits of a single cache line of the filter, picked by its
+ * hash, so that a check touches one cache line only.
+ *
+ * Bits are set concurrently with atomic ORs; resizing and clearing a filter need the table latch in write mode.
+ */
+class HashBlockFilter {
+ public:
+  /** @param lines_per_block the number of 512-bit cache lines of the filter of a block */
+  explicit HashBlockFilter(size_t lines_per_block) : lines_per_block_(lines_per_block) {}
+
+  /** Makes room for the filters of a number of blocks, the new filters are empty. */
+  void Resize(size_t num_blocks) { lines_.resize(num_blocks * lines_per_block_); }
+
+  /** Adds the hash of a key to the filter of a block. */
+  void Add(size_t block_index, uint64_t hash) {
+    const uint64_t mixed = HashUtil::Mix(hash, FILTER_SEED);
+    Line &line = lines_[block_index * lines_per_block_ + LineIndex(mixed)];
+    for (int i = 0; i < HASH_TABLE_FILTER_PROBES; i++) {
+      const uint64_t bit = (mixed >> (9 * i)) & 511;
+      line.words_[bit / 64].fetch_or(uint64_t{1} << (bit % 64), std::memory_order_release);
+    }
+  }
+
+  /** @return false if the hash of a key was never added to the filter of a block */
+  bool MayContain(size_t block_index, uint64_t hash) const {
+    const uint64_t mixed = HashUtil::Mix(hash, FILTER_SEED);
+    const Line &line = lines_[block_index * lines_per_block_ + LineIndex(mixed)];
+    for (int i = 0; i < HASH_TABLE_FILTER_PROBES; i++) {
+      const uint64_t bit = (mixed >> (9 * i)) & 511;
+      if ((line.words_[bit / 64].load(std::memory_order_acquire) & (uint64_t{1} << (bit % 64))) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** Empties the filter of a block, e.g. when all the keys whose home it is are moved away. */
+  void Clear(size_t block_index) {
+    for (size_t i = 0; i < lines_per_block_; i++) {
+      for (auto &word : lines_[block_index * lines_per_block_ + i].words_) {
+        word.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  static constexpr uint64_t FILTER_SEED = 0x9e3779b97f4a7c15ULL;
+
+  /** 512 bits of a filter, on a cache line of their own. */
+  struct alignas(64) Line {
+    std::atomic<uint64_t> words_[8] = {};
+  };
+
+  /** @return the line of the filter of a block that a mixed hash sets its bits in, from the bits that pick no bit */
+  size_t LineIndex(uint64_t mixed) const { return ((mixed >> 40) * lines_per_block_) >> 24; }
+
+  size_t lines_per_block_;
+  // never shrinks, so the lines of the blocks stay in place as blocks are added
+  std::deque<Line> lines_;
+};
+
+}  // namespace bustub
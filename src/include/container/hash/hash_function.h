@@ -13,11 +13,16 @@
 #pragma once
 
 #include <cstdint>
+#include <type_traits>
 
-#include "murmur3/MurmurHash3.h"
+#include "common/util/hash_util.h"
 
 namespace bustub {
 
+/**
+ * Hashes the keys of the hash tables. Integer keys are mixed as a word; any other key, such as a GenericKey<N>, is
+ * hashed as its sizeof(KeyType) bytes, which is a constant that HashUtil::HashBytes is unrolled for.
+ */
 template <typename KeyType>
 class HashFunction {
  public:
@@ -26,10 +31,11 @@ class HashFunction {
    * @return the hashed value
    */
   virtual uint64_t GetHash(KeyType key) {
-    uint64_t hash[2];
-    murmur3::MurmurHash3_x64_128(reinterpret_cast<const void *>(&key), static_cast<int>(sizeof(KeyType)), 0,
-                                 reinterpret_cast<void *>(&hash));
-    return hash[0];
+    if constexpr (std::is_integral_v<KeyType>) {
+      return HashUtil::HashInt(static_cast<uint64_t>(key));
+    } else {
+      return HashUtil::Hash(&key);
+    }
   }
 };
 
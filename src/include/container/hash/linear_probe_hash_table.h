@@ -12,12 +12,16 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <memory>
 #include <queue>
 #include <string>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction.h"
+#include "container/hash/hash_block_filter.h"
 #include "container/hash/hash_function.h"
 #include "container/hash/hash_table.h"
 #include "storage/page/hash_table_block_page.h"
@@ -28,10 +32,44 @@ namespace bustub {
 
 #define HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
 
+/** A snapshot of how full a LinearProbeHashTable is and how long its probes run. */
+struct HashTableStats {
+  // number of buckets that the probes run over
+  size_t num_buckets_{0};
+  // number of readable pairs
+  size_t num_pairs_{0};
+  // number of tombstones left by removes
+  size_t num_tombstones_{0};
+  // probe_lengths_[i] is the number of pairs that sit d buckets past their home bucket, for 2^i - 1 <= d < 2^(i+1) - 1
+  std::vector<size_t> probe_lengths_;
+
+  /** @return the share of the buckets that hold a pair */
+  double LoadFactor() const { return num_buckets_ == 0 ? 0 : static_cast<double>(num_pairs_) / num_buckets_; }
+
+  /** @return the share of the buckets that hold a tombstone */
+  double TombstoneRatio() const {
+    return num_buckets_ == 0 ? 0 : static_cast<double>(num_tombstones_) / num_buckets_;
+  }
+};
+
 /**
  * Implementation of linear probing hash table that is backed by a buffer pool
- * manager. Non-unique keys are supported. Supports insert and delete. The
- * table dynamically grows once full.
+ * manager. Non-unique keys are supported, and unique keys as an option.
+ * Supports insert and delete. The table dynamically grows once full.
+ *
+ * The blocks form one array of buckets: a probe runs on into the next block
+ * at the end of a block, and wraps around at the last one.
+ *
+ * Concurrency: inserts, removes and lookups hold the table latch in read
+ * mode, only growth takes it in write mode. Inserts and removes write latch
+ * the blocks that they probe, lookups take no page latch at all and read
+ * each block optimistically, retrying if a writer got in the way. The number
+ * of pairs, which decides when the table grows, is counted per thread and
+ * only summed up every HASH_TABLE_LOAD_CHECK_INTERVAL inserts of a thread.
+ *
+ * An optional in-memory Bloom filter per block, see HashBlockFilter, lets
+ * lookups of missing keys skip the blocks. Removes leave it alone, a block
+ * that splits rebuilds its filter from the keys that it reinserts.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
@@ -43,9 +81,12 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    * @param comparator comparator for keys
    * @param num_buckets initial number of buckets contained by this hash table
    * @param hash_fn the hash function
+   * @param unique_keys true if a key may only have one value; a probe then stops at the first match of its key, and
+   * an insert fails for a key that is present already
    */
   explicit LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn);
+                                const KeyComparator &comparator, size_t num_buckets, HashFunction<KeyType> hash_fn,
+                                bool unique_keys = false);
 
   /**
    * Inserts a key-value pair into the hash table.
@@ -75,34 +116,249 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
+   * Inserts several pairs, e.g. the keys of the tuples that an insert adds to an index. The pairs are sorted by their
+   * home bucket and inserted in that order, a chunk of BLOCK_ARRAY_SIZE pairs per hold of the table latch, so that
+   * consecutive probes find their blocks in the buffer pool and the load is checked once per chunk instead of every
+   * HASH_TABLE_LOAD_CHECK_INTERVAL inserts. Pairs whose probe wraps around or finds the table full are inserted one
+   * at a time afterwards, see Insert().
+   * @param transaction the current transaction
+   * @param pairs the pairs to insert
+   * @return the number of pairs that were inserted
+   */
+  size_t InsertBatch(Transaction *transaction, const std::vector<MappingType> &pairs);
+
+  /**
+   * Removes several pairs, in the order of their home buckets, see InsertBatch().
+   * @param transaction the current transaction
+   * @param pairs the pairs to remove
+   * @return the number of pairs that were removed
+   */
+  size_t RemoveBatch(Transaction *transaction, const std::vector<MappingType> &pairs);
+
+  /**
+   * Performs point queries for several keys. All the keys are hashed first, then the blocks of a group of
+   * HASH_TABLE_BATCH_SIZE keys are fetched together and the start of their probes prefetched, so that the misses of
+   * the group overlap instead of following one another.
+   * @param transaction the current transaction
+   * @param keys the keys to look up
+   * @param[out] results resized to the number of keys, the value(s) of keys[i] are appended to (*results)[i]
+   * @return false if a block could not be fetched for some key, whose values are then left out
+   */
+  bool GetValueBatch(Transaction *transaction, const std::vector<KeyType> &keys,
+                     std::vector<std::vector<ValueType>> *results);
+
+  /**
+   * Builds the table from pairs at once, which is much faster than inserting them one at a time. The table first
+   * gets enough blocks for the pairs, then the pairs are radix sorted by the bucket that they hash to and written
+   * block by block, in a single pass over the blocks. Pairs that occur more than once are only inserted once,
+   * and only the first pair of a unique key.
+   * @param items the pairs
+   * @return false if the table is not empty, if it can not get enough blocks for the pairs, or if a block could not be
+   * fetched, the pairs are then loaded only in part
+   */
+  bool BulkLoad(const std::vector<MappingType> &items);
+
+  /**
+   * Reads all the blocks and counts their pairs, tombstones and probe lengths.
+   * @param[out] stats the counts
+   * @return false if a block could not be fetched
+   */
+  bool GetStats(HashTableStats *stats);
+
+  /**
+   * Rebuilds the table without tombstones: all the pairs are taken out of the blocks, which are emptied, and put back
+   * as BulkLoad() would. A remove runs it when the tombstones take more than HASH_TABLE_MAX_TOMBSTONE_PERCENT of the
+   * buckets.
+   * @return false if a block could not be fetched
+   */
+  bool Compact();
+
+  /**
+   * Builds an in-memory Bloom filter of the keys of every block from the blocks, and keeps it up to date from then on.
+   * A lookup of a key that the filter of its home block does not hold reads no block at all.
+   * @return false if a block could not be fetched, the table then goes on without a filter
+   */
+  bool EnableFilter();
+
+  /**
+   * Resizes the table to at least twice the initial size provided. The resize only adds the new blocks, the entries
+   * move to them a few blocks at a time by the inserts, removes and lookups that follow.
    * @param initial_size the initial size of the hash table
    */
   void Resize(size_t initial_size);
 
   /**
    * Gets the size of the hash table
-   * @return current size of the hash table
+   * @return current size of the hash table, in buckets
    */
   size_t GetSize();
 
  private:
+  using BlockPage = HashTableBlockPage<KeyType, ValueType, KeyComparator>;
+
+  /** @return the index of the block that a hash belongs in, the table latch is held */
+  size_t GetBlockIndex(uint64_t hash) const {
+    size_t block_index = hash % num_blocks_;
+    // Linear hashing: the blocks split so far hold the entries of both halves of their hash range.
+    return block_index < next_split_ ? hash % (2 * num_blocks_) : block_index;
+  }
+
+  /**
+   * @return the bucket in its block that a hash probes from. It takes the high bits of the hash, the block index the
+   * low ones, so that the buckets of the entries of a block do not depend on the block.
+   */
+  static slot_offset_t GetBucketIndex(uint64_t hash) { return (hash >> 32) % BLOCK_ARRAY_SIZE; }
+
+  /** @return the 7-bit fingerprint of a hash, from bits that neither the block nor the bucket index depend on */
+  static uint8_t GetFingerprint(uint64_t hash) { return (hash >> 25) & 0x7f; }
+
+  /** How the probe of a block ended. */
+  enum class BlockProbe {
+    CONTINUE,   // the run goes on past the probed buckets
+    RUN_ENDED,  // an empty bucket ended the run
+    STOPPED,    // on_match stopped the probe
+  };
+
+  /**
+   * Probes buckets of a block for a fingerprint, a group of buckets at a time.
+   * @param block_page the block
+   * @param begin the first bucket to be probed
+   * @param end the bucket past the last one to be probed
+   * @param fingerprint the fingerprint of the key looked for
+   * @param[in,out] first_free if not nullptr and BLOCK_ARRAY_SIZE, set to the first tombstone or empty bucket of the run
+   * @param on_match called as on_match(bucket_ind) for the readable buckets of the run with the fingerprint, stops the
+   * probe by returning true
+   */
+  template <class OnMatch>
+  static BlockProbe ProbeBlock(const BlockPage *block_page, slot_offset_t begin, slot_offset_t end, uint8_t fingerprint,
+                               slot_offset_t *first_free, OnMatch &&on_match);
+
+  /** Outcome of an insert or remove attempt. */
+  enum class ProbeResult {
+    SUCCESS,  // inserted or removed
+    FAILURE,  // duplicate pair, pair not found, or a block could not be fetched
+    FULL,     // no free slot in the whole table
+    WRAPPED,  // the probe reached the end of the table, which only an exclusive attempt may wrap around
+  };
+
+  /** @return the number of pairs in the table, which is not exact while inserts and removes run */
+  size_t CountEntries() const;
+
+  /** @return the number of tombstones in the table, which is not exact while inserts and removes run */
+  size_t CountTombstones() const;
+
+  /** @return true if the tombstones take more than HASH_TABLE_MAX_TOMBSTONE_PERCENT of a number of buckets */
+  bool HasTooManyTombstones(size_t num_buckets) const;
+
+  /**
+   * Writes pairs into the blocks, which hold no readable pairs, see BulkLoad(). The table latch is write latched.
+   * @return false if the pairs do not fit or a block could not be fetched
+   */
+  bool PlacePairs(const std::vector<MappingType> &items);
+
+  /** @return the page id of a block, the table latch is held */
+  page_id_t GetBlockPageId(size_t block_index) const { return block_page_ids_[block_index]; }
+
+  /**
+   * Appends blocks to the directory of the header page, adding block directory pages as needed. Either all of the
+   * blocks are added or none. The table latch is write latched, or the table is being constructed.
+   * @return false if the directory is full or a block directory page could not be created or fetched
+   */
+  bool AddBlockPages(const std::vector<page_id_t> &page_ids);
+
+  /** @return the number of blocks that the probes run over, the table latch is held */
+  size_t GetNumActiveBlocks() const { return num_blocks_ + next_split_; }
+
+  /**
+   * Inserts a pair into the first free slot of the run of its key, unless the run holds it already. The home block of
+   * the key stays latched throughout, so that inserts and removes of the same key are serialized, and so does the
+   * block of the free slot. Blocks are latched in ascending order only.
+   * @param exclusive true if the table latch is write latched, then the probe may wrap around the end of the table
+   */
+  ProbeResult TryInsert(const KeyType &key, const ValueType &value, bool exclusive);
+
+  /** Removes a pair from the run of its key, see TryInsert(). */
+  ProbeResult TryRemove(const KeyType &key, const ValueType &value, bool exclusive);
+
+  /** @return the positions of pairs in the order of their home buckets. The table latch is latched. */
+  std::vector<size_t> SortByHome(const std::vector<MappingType> &pairs);
+
+  /**
+   * Probes for the values of a key, the caller holds the table latch in read mode.
+   * @param[out] result the value(s) of the key are appended to it
+   * @return false if a block could not be fetched
+   */
+  bool LookupValues(const KeyType &key, uint64_t hash, std::vector<ValueType> *result);
+
+  /** Starts reading the block after a block, which a probe that starts near the block end is likely to reach. */
+  void PrefetchNextBlock(size_t block_index, size_t num_active_blocks);
+
+  /** Splits the next HASH_TABLE_SPLITS_PER_OP blocks, if the table is growing. */
+  void Migrate();
+
+  /**
+   * Makes room in a full table: splits the next block if the table is growing, and starts the next doubling
+   * otherwise. @return false if the table can not grow any further
+   */
+  bool Grow();
+
+  /**
+   * Doubles the number of blocks. The new blocks join the probes one at a time, as the blocks split. The table latch
+   * is write latched. @return false if there is no room for the new blocks
+   */
+  bool StartGrowth();
+
+  /**
+   * Splits the next block of the doubling, and makes its new sibling the last block of the table. The entries of the
+   * block, and the entries that wrapped around the end of the table, are reinserted from their new homes. The table
+   * latch is write latched. @return false if a block could not be fetched
+   */
+  bool SplitBlock();
+
+  /**
+   * Turns the readable pairs of a run that are to move into tombstones, and collects them. The table latch is write
+   * latched.
+   * @param start_block the block that the run starts at, at its first bucket
+   * @param wrapped true to collect the pairs that wrapped around the end of the table, false to collect the pairs of
+   * start_block, which are looked for in all of it
+   * @param[out] entries the collected pairs
+   * @return false if a block could not be fetched
+   */
+  bool ExtractEntries(size_t start_block, bool wrapped, std::vector<MappingType> *entries);
+
   // member variable
   page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
+  // true if a key may only have one value
+  const bool unique_keys_;
 
   // Readers includes inserts and removes, writer is only resize
-  ReaderWriterLatch table_latch_;
+  DistributedReaderWriterLatch table_latch_;
 
   // Hash function
   HashFunction<KeyType> hash_fn_;
 
   // header page
   HashTableHeaderPage * header_page_;
+  // the page ids of the blocks as listed by the block directory pages, cached so that a probe does not read them
+  std::vector<page_id_t> block_page_ids_;
+  // the Bloom filters of the blocks, nullptr unless enabled
+  std::unique_ptr<HashBlockFilter> filter_;
 
-  // number of blocks
+  // number of blocks before the current doubling
   size_t num_blocks_;
+  // number of blocks split by the current doubling, the table is growing while it is below num_blocks_
+  size_t next_split_{0};
+  std::atomic<bool> growing_{false};
+  /** A count kept by the threads of a latch slot, on a cache line of its own. It may go negative. */
+  struct alignas(64) SlotCount {
+    std::atomic<int64_t> count_{0};
+  };
+  // number of key and value pairs, counted per thread so that inserts do not fight over a single cache line
+  std::array<SlotCount, DISTRIBUTED_LATCH_SLOTS> entry_counts_;
+  // number of tombstones, counted per thread likewise
+  std::array<SlotCount, DISTRIBUTED_LATCH_SLOTS> tombstone_counts_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregate_view.h
+//
+// Identification: src/include/execution/aggregate_view.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "concurrency/transaction.h"
+#include "execution/aggregation_table.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+/**
+ * AggregateView is a materialized GROUP BY over a table: it keeps the groups of an aggregation of the table in an
+ * AggregationTable, and keeps them up to date as transactions commit, from the net change of their write sets, see
+ * TableHeap::AddCommitListener(). An AggregationPlanNode that is given the view reads its groups instead of
+ * aggregating its child.
+ *
+ * Counts and sums are taken back exactly when a row is deleted or updated. A min or max is not, if the row may hold
+ * it: the view goes stale then, as it does when a change is not all known, and the next read aggregates the table
+ * again. A hidden count of the rows of each group drops the groups whose rows are all gone.
+ *
+ * The view holds the latest committed state of the table. It is read under a SHARED lock of the table, so that no
+ * transaction that writes the table commits meanwhile, by transactions that lock, see ReadGroups(). The table needs
+ * an oid for the locks to be taken.
+ */
+class AggregateView {
+ public:
+  /** A group of the view: its group by values and its aggregates. */
+  using Group = std::pair<std::vector<Value>, std::vector<Value>>;
+
+  /**
+   * Creates a view without groups, see Build().
+   * @param table the table that is aggregated
+   * @param schema the schema of the tuples of the table, which the expressions are evaluated on
+   * @param group_bys the group by expressions
+   * @param aggregates the expressions that are aggregated
+   * @param agg_types the types of the aggregations, which AggregationTable::CanAggregate() must take
+   */
+  AggregateView(TableHeap *table, const Schema *schema, std::vector<const AbstractExpression *> group_bys,
+                std::vector<const AbstractExpression *> aggregates, std::vector<AggregationType> agg_types);
+
+  /** Stops listening to the commits of the table. */
+  ~AggregateView();
+
+  DISALLOW_COPY_AND_MOVE(AggregateView);
+
+  /**
+   * Aggregates the table, and keeps the groups up to date from then on.
+   * @param txn the transaction that reads the table, which must lock, i.e. neither read a snapshot nor only read
+   * @return false if the transaction could not lock the table, or does not lock
+   */
+  bool Build(Transaction *txn);
+
+  /**
+   * Reads the groups of the view, which are aggregated again first if the view is stale. The groups are read under a
+   * SHARED lock of the table, which the transaction holds on to, like a scan of the table would.
+   * @param txn the reading transaction, which must lock, and must not have written the table: the view does not have
+   * its writes, which have not committed
+   * @param[out] groups the groups with at least one row, in no particular order
+   * @return false if the view cannot be read by the transaction, whose query aggregates the table then
+   */
+  bool ReadGroups(Transaction *txn, std::vector<Group> *groups);
+
+  /** @return true if the view is to be aggregated again before it is read */
+  bool IsStale() {
+    std::scoped_lock lock(latch_);
+    return !built_ || stale_;
+  }
+
+ private:
+  /** @return true if the transaction locks the rows that it reads, rather than reading a snapshot */
+  static bool Locks(Transaction *txn) { return !txn->IsSnapshot() && !txn->IsReadOnly(); }
+
+  /** Aggregates the table into groups_ anew, under the SHARED lock of the table and the latch of the view. */
+  void Aggregate(Transaction *txn);
+
+  /**
+   * Combines tuples of the table into their groups, or takes them out of them.
+   * @return false if a tuple could not be taken out of its group, see AggregationTable::RemoveCombine()
+   */
+  bool Combine(const std::vector<Tuple> &tuples, bool remove);
+
+  /** Applies the net change of a committed transaction, see TableHeap::CommitListener. */
+  void Apply(const TableChange &change);
+
+  TableHeap *table_;
+  const Schema *schema_;
+  const std::vector<const AbstractExpression *> group_bys_;
+  const std::vector<const AbstractExpression *> aggregates_;
+  /** The types of the aggregations, after the hidden count, and of the values that they take. */
+  std::vector<AggregationType> agg_types_;
+  std::vector<TypeId> input_types_;
+  std::vector<TypeId> key_types_;
+  /** The id of the commit listener on the table, once the view is built. */
+  size_t listener_id_{0};
+  /** Protects the groups and the state of the view. */
+  std::mutex latch_;
+  AggregationTable groups_;
+  bool built_{false};
+  bool stale_{false};
+};
+
+}  // namespace bustub
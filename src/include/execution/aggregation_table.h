@@ -0,0 +1,211 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// aggregation_table.h
+//
+// Identification: src/include/execution/aggregation_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+#include "common/exception.h"
+#include "common/util/hash_util.h"
+#include "execution/plans/aggregation_plan.h"
+#include "type/type_kernels.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** The state of one aggregate of one group, unboxed: an integer, or a double for an aggregate of decimals. */
+struct AggregateSlot {
+  union {
+    int64_t int_;
+    double real_;
+  };
+  /** The rounding error of a sum of decimals so far, which the sum makes up for once it is done, see AddReal(). */
+  double error_;
+};
+
+/**
+ * AggregationTable is the hash table of a parallel aggregation. Unlike SimpleAggregationHashTable, it keeps the state
+ * of an aggregate in a fixed-width AggregateSlot instead of a Value, and it takes its input column by column, so that
+ * combining a row into a group that exists allocates nothing. The groups are stored in the order in which they were
+ * first seen, their keys side by side in one vector and their slots in another, and found by linear probing on the
+ * hashes of their keys.
+ *
+ * A table is used by one thread at a time. A parallel aggregation gives each thread a table per partition of the hash
+ * of the keys to pre-aggregate into, and then merges the tables of each partition, see Merge().
+ */
+class AggregationTable {
+ public:
+  /**
+   * Creates an empty table.
+   * @param agg_types the types of the aggregations
+   * @param input_types the types of the values that are aggregated, one per aggregation
+   * @param key_types the types of the group by values of a group, whose kernels hash and compare them
+   */
+  AggregationTable(const std::vector<AggregationType> &agg_types, const std::vector<TypeId> &input_types,
+                   const std::vector<TypeId> &key_types);
+
+  /** @return true if every aggregation can be kept unboxed, i.e. it counts rows, or aggregates numbers */
+  static bool CanAggregate(const std::vector<AggregationType> &agg_types, const std::vector<TypeId> &input_types);
+
+  /**
+   * Hashes the group by values of every row, which are compared like CompareEquals(), but nulls are equal. The
+   * columns are hashed one at a time, by the kernels of their types.
+   * @param key_columns the group by values, by column
+   * @param num_rows the number of rows
+   * @param[out] hashes the hashes, one per row
+   */
+  void HashKeys(const std::vector<std::vector<Value>> &key_columns, size_t num_rows, std::vector<hash_t> *hashes) const;
+
+  /**
+   * Combines a row into the aggregates of its group, which is created if it is new.
+   * @param hash the hash of the keys of the row, see HashKeys()
+   * @param key_columns the group by values, by column
+   * @param agg_columns the values that are aggregated, by column
+   * @param row the index of the row in the columns
+   */
+  void InsertCombine(hash_t hash, const std::vector<std::vector<Value>> &key_columns,
+                     const std::vector<std::vector<Value>> &agg_columns, size_t row);
+
+  /**
+   * Takes a row that was combined into its group back out of the aggregates, the inverse of InsertCombine(), e.g. for
+   * a row that was deleted from the table that an AggregateView aggregates. The group stays, even once no row is left.
+   * A min or max cannot be taken back if the row may hold it, for the table does not know the next smallest value.
+   * @param hash the hash of the keys of the row, see HashKeys()
+   * @param key_columns the group by values, by column
+   * @param agg_columns the values that are aggregated, by column
+   * @param row the index of the row in the columns
+   * @return false if the row has no group, or it may hold a min or max, the aggregates are left as they were then
+   */
+  bool RemoveCombine(hash_t hash, const std::vector<std::vector<Value>> &key_columns,
+                     const std::vector<std::vector<Value>> &agg_columns, size_t row);
+
+  /** @return true if the group by values of a row have a group in the table */
+  bool Contains(hash_t hash, const std::vector<std::vector<Value>> &key_columns, size_t row) const {
+    size_t bucket;
+    return Find(hash, [&](size_t i) -> const Value & { return key_columns[i][row]; }, &bucket) >= 0;
+  }
+
+  /** Combines every group of another table, of the same aggregations, into this one. */
+  void Merge(const AggregationTable &other);
+
+  /** @return the number of groups */
+  size_t GetNumGroups() const { return hashes_.size(); }
+
+  /** @return the bytes that the groups take up, roughly, not counting those of variable length keys */
+  size_t GetMemoryUsage() const {
+    return keys_.capacity() * sizeof(Value) + slots_.capacity() * sizeof(AggregateSlot) +
+           hashes_.capacity() * sizeof(hash_t) + buckets_.capacity() * sizeof(int64_t);
+  }
+
+  /** @return the group by values of a group */
+  std::vector<Value> GetKeys(size_t group) const;
+
+  /**
+   * @return the aggregates of a group as values, of type INTEGER for counts and aggregates of smaller integers. Nulls
+   * are not aggregated, but counted: the min or max of a group of nulls only is null, their sum is zero.
+   */
+  std::vector<Value> GetAggregates(size_t group) const;
+
+ private:
+  /**
+   * Looks up the group of some keys.
+   * @param key_at called as key_at(i) for the i'th key
+   * @param[out] bucket the empty bucket for the keys if they have no group
+   * @return the group, -1 if the keys have none
+   */
+  template <class KeyAt>
+  int64_t Find(hash_t hash, KeyAt &&key_at, size_t *bucket) const {
+    const size_t mask = buckets_.size() - 1;
+    for (size_t b = hash & mask;; b = (b + 1) & mask) {
+      const int64_t group = buckets_[b];
+      if (group < 0) {
+        *bucket = b;
+        return -1;
+      }
+      if (hashes_[group] == hash && KeysEqual(group, key_at)) {
+        return group;
+      }
+    }
+  }
+
+  /** @return true if the keys of a group are the given ones */
+  template <class KeyAt>
+  bool KeysEqual(int64_t group, KeyAt &&key_at) const {
+    const Value *keys = keys_.data() + group * num_keys_;
+    for (size_t i = 0; i < num_keys_; i++) {
+      const Value &key = key_at(i);
+      if (keys[i].IsNull() || key.IsNull()) {
+        if (keys[i].IsNull() != key.IsNull()) {
+          return false;
+        }
+      } else if (key_kernels_[i]->compare_equals_(keys[i], key) != CmpBool::CmpTrue) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** Appends a group with initial slots and no keys, which the caller appends, into an empty bucket. */
+  size_t AddGroup(hash_t hash, size_t bucket);
+
+  /**
+   * Adds a double to the sum of a slot with Neumaier's compensated summation: the part of the double that rounding
+   * loses is added up in the error of the slot, which the sum makes up for once it is done. This keeps the rounding
+   * error from growing with the number of rows, but the sum is still of doubles: it is not exact, and sums of the same
+   * rows in another order, or merged from other workers, may differ in their last bits.
+   */
+  static void AddReal(AggregateSlot *slot, double real) {
+    const double sum = slot->real_ + real;
+    if (std::abs(slot->real_) >= std::abs(real)) {
+      slot->error_ += (slot->real_ - sum) + real;
+    } else {
+      slot->error_ += (real - sum) + slot->real_;
+    }
+    slot->real_ = sum;
+  }
+
+  /** Adds an integer to the sum of a slot, and throws if the sum overflows. */
+  static void AddInt(AggregateSlot *slot, int64_t integer) {
+    if (__builtin_add_overflow(slot->int_, integer, &slot->int_)) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "Numeric value out of range.");
+    }
+  }
+
+  /** Subtracts an integer from the sum of a slot, and throws if the sum overflows. */
+  static void SubtractInt(AggregateSlot *slot, int64_t integer) {
+    if (__builtin_sub_overflow(slot->int_, integer, &slot->int_)) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "Numeric value out of range.");
+    }
+  }
+
+  /** @return true if the aggregation adds up or compares doubles */
+  bool IsReal(size_t agg) const { return input_types_[agg] == TypeId::DECIMAL; }
+
+  /** Doubles the buckets, once they are half full. */
+  void Grow();
+
+  std::vector<AggregationType> agg_types_;
+  std::vector<TypeId> input_types_;
+  size_t num_keys_;
+  std::vector<const TypeKernels *> key_kernels_;
+  /** The keys of group g are keys_[g * num_keys_] on, its slots slots_[g * agg_types_.size()] on. */
+  std::vector<Value> keys_;
+  std::vector<AggregateSlot> slots_;
+  std::vector<hash_t> hashes_;
+  /** The group in each bucket, -1 for an empty one, a power of two of them. */
+  std::vector<int64_t> buckets_;
+};
+
+}  // namespace bustub
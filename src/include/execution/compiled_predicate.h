@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_predicate.h
+//
+// Identification: src/include/execution/compiled_predicate.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * CompiledPredicate is a predicate compiled against the schema of the tuples it tests. Evaluating an expression walks
+ * its tree with a virtual call per node, boxes every column into a Value, and compares the Values through their Type;
+ * a compiled predicate is a single function, specialized for the types of its operands and for its comparison, that
+ * reads the columns straight out of the bytes of a tuple.
+ *
+ * Comparisons of numeric columns with each other or with numeric constants compile. Like those of Values, they compare
+ * integers as 64-bit integers and anything else as doubles, and a null operand fails the predicate.
+ */
+class CompiledPredicate {
+ public:
+  /**
+   * Compiles a predicate.
+   * @param predicate the predicate, on tuples of the schema
+   * @param schema the schema of the tuples
+   * @return the compiled predicate, nullptr if the predicate does not compile
+   */
+  static std::unique_ptr<CompiledPredicate> Compile(const AbstractExpression *predicate, const Schema *schema);
+
+  /** @return true if a tuple of the schema passes the predicate */
+  bool Test(const Tuple &tuple) const { return test_(operands_, tuple.GetData()); }
+
+  /** What a compiled predicate reads, besides the tuple. */
+  struct Operands {
+    // the offsets of the columns in the tuple
+    uint32_t left_offset_{0};
+    uint32_t right_offset_{0};
+    // the constant, as a 64-bit integer or as a double, whichever the comparison is in
+    int64_t int_{0};
+    double real_{0};
+  };
+
+ private:
+  using TestFn = bool (*)(const Operands &operands, const char *data);
+
+  CompiledPredicate(TestFn test, const Operands &operands) : test_(test), operands_(operands) {}
+
+  TestFn test_;
+  Operands operands_;
+};
+
+}  // namespace bustub
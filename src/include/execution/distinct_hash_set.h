@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// distinct_hash_set.h
+//
+// Identification: src/include/execution/distinct_hash_set.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "common/macros.h"
+#include "common/util/hash_util.h"
+#include "type/type.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * DistinctHashSet is a set of keys for DISTINCT and COUNT(DISTINCT), kept as their raw bytes, see AppendKey().
+ *
+ * The keys are appended one after another to a single arena, and an open addressing table of 16 byte slots, the hash
+ * of a key next to its place in the arena, finds them. A key costs its own bytes and a slot or two, rather than a Value
+ * and a node of a std::unordered_set per column. Slots are probed linearly, and the table doubles once it is half full.
+ * Keys are never removed.
+ */
+class DistinctHashSet {
+ public:
+  /**
+   * Appends the raw bytes of a value to a key: a byte that tells if it is null and, if it is not, the value as a tuple
+   * holds it. Two keys of values of the same types are equal if, and only if, the values are, nulls being equal to
+   * each other.
+   */
+  static void AppendKey(const Value &value, std::vector<char> *key) {
+    if (value.IsNull()) {
+      key->push_back(1);
+      return;
+    }
+    key->push_back(0);
+    const size_t offset = key->size();
+    if (value.GetTypeId() == TypeId::VARCHAR) {
+      key->resize(offset + sizeof(uint32_t) + value.GetLength());
+    } else {
+      key->resize(offset + Type::GetTypeSize(value.GetTypeId()));
+    }
+    value.SerializeTo(key->data() + offset);
+  }
+
+  /** @return the hash of a key */
+  static hash_t HashKey(const std::vector<char> &key) { return HashUtil::HashBytes(key.data(), key.size()); }
+
+  /**
+   * Adds a key to the set.
+   * @param hash the hash of the key, see HashKey()
+   * @param key the key
+   * @return true if the key was not in the set
+   */
+  bool Insert(hash_t hash, const std::vector<char> &key) {
+    if ((num_keys_ + 1) * 2 > slots_.size()) {
+      Grow();
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+      Slot &slot = slots_[i];
+      if (slot.size_ == EMPTY) {
+        BUSTUB_ASSERT(arena_.size() + key.size() <= UINT32_MAX, "distinct keys take up more than 4 GB");
+        slot = Slot{hash, static_cast<uint32_t>(arena_.size()), static_cast<uint32_t>(key.size())};
+        arena_.insert(arena_.end(), key.begin(), key.end());
+        num_keys_++;
+        return true;
+      }
+      if (slot.hash_ == hash && slot.size_ == key.size() &&
+          std::memcmp(arena_.data() + slot.offset_, key.data(), key.size()) == 0) {
+        return false;
+      }
+    }
+  }
+
+  /** @return the number of keys in the set */
+  size_t GetSize() const { return num_keys_; }
+
+  /** @return the bytes that the set takes up */
+  size_t GetMemoryUsage() const { return slots_.capacity() * sizeof(Slot) + arena_.capacity(); }
+
+  /** Removes every key from the set. */
+  void Clear() {
+    slots_.clear();
+    arena_.clear();
+    num_keys_ = 0;
+  }
+
+ private:
+  struct Slot {
+    hash_t hash_;
+    uint32_t offset_;
+    uint32_t size_;
+  };
+  /** The size of an empty slot, which no key has, since it has at least the null byte. */
+  static constexpr uint32_t EMPTY = 0;
+  static constexpr size_t INITIAL_SLOTS = 16;
+
+  /** Doubles the number of slots, and puts the keys in their new places. */
+  void Grow() {
+    std::vector<Slot> old_slots(std::max(INITIAL_SLOTS, slots_.size() * 2), Slot{0, 0, EMPTY});
+    old_slots.swap(slots_);
+    const size_t mask = slots_.size() - 1;
+    for (const Slot &slot : old_slots) {
+      if (slot.size_ == EMPTY) {
+        continue;
+      }
+      size_t i = slot.hash_ & mask;
+      while (slots_[i].size_ != EMPTY) {
+        i = (i + 1) & mask;
+      }
+      slots_[i] = slot;
+    }
+  }
+
+  std::vector<Slot> slots_;
+  std::vector<char> arena_;
+  size_t num_keys_{0};
+};
+
+}  // namespace bustub
@@ -12,12 +12,16 @@
 
 #pragma once
 
+#include <algorithm>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "catalog/simple_catalog.h"
+#include "common/task_scheduler.h"
 #include "concurrency/transaction.h"
+#include "execution/memory_tracker.h"
+#include "storage/disk/spill_file.h"
 #include "storage/page/tmp_tuple_page.h"
 
 namespace bustub {
@@ -33,7 +37,11 @@ class ExecutorContext {
    * @param bpm the buffer pool manager that the executor should use
    */
   ExecutorContext(Transaction *transaction, SimpleCatalog *catalog, BufferPoolManager *bpm)
-      : transaction_(transaction), catalog_{catalog}, bpm_{bpm} {}
+      : transaction_(transaction),
+        catalog_{catalog},
+        bpm_{bpm},
+        memory_budget_(bpm == nullptr ? 1 : std::max<size_t>(bpm->GetPoolSize() / 4, 1)),
+        memory_tracker_((bpm == nullptr ? 1 : std::max<size_t>(bpm->GetPoolSize(), 1)) * PAGE_SIZE) {}
 
   DISALLOW_COPY_AND_MOVE(ExecutorContext);
 
@@ -42,12 +50,65 @@ class ExecutorContext {
   /** @return the running transaction */
   Transaction *GetTransaction() const { return transaction_; }
 
+  /** Sets the transaction of the executors from their next Init() on, e.g. of a plan that PlanCache keeps around. */
+  void SetTransaction(Transaction *transaction) { transaction_ = transaction; }
+
   /** @return the catalog */
   SimpleCatalog *GetCatalog() { return catalog_; }
 
   /** @return the buffer pool manager */
   BufferPoolManager *GetBufferPoolManager() { return bpm_; }
 
+  /**
+   * @return the number of buffer pool pages that an operator of the query may fill before it spills to disk, e.g. the
+   * build side of a hash join; a quarter of the pool unless set otherwise
+   */
+  size_t GetMemoryBudget() const { return memory_budget_; }
+
+  /** Sets the memory budget of the operators of the query, at least one page. */
+  void SetMemoryBudget(size_t pages) { memory_budget_ = std::max<size_t>(pages, 1); }
+
+  /**
+   * @return the tracker of the memory that the operators of the query hold, all of them together, whose limit is the
+   * whole buffer pool unless set otherwise. An operator spills once either it is over its own budget or the query is
+   * over its limit.
+   */
+  MemoryTracker *GetMemoryTracker() { return &memory_tracker_; }
+
+  /** Sets the memory budget of the query as a whole, in pages, at least one. */
+  void SetQueryMemoryBudget(size_t pages) { memory_tracker_.SetLimit(std::max<size_t>(pages, 1) * PAGE_SIZE); }
+
+  /**
+   * @return the manager of the files that the operators of the query spill to, e.g. the partitions of a hash join,
+   * whose buffers have a memory budget of their own, apart from the buffer pool. The files go away with their runs,
+   * at the latest with the context.
+   */
+  SpillFileManager *GetSpillFileManager() { return &spill_files_; }
+
+  /** @return the number of threads that an operator of the query may run on, e.g. a hash join; 1 by default */
+  size_t GetParallelism() const { return parallelism_; }
+
+  /** Sets the number of threads of the operators of the query, at least one. */
+  void SetParallelism(size_t num_threads) { parallelism_ = std::max<size_t>(num_threads, 1); }
+
+  /** @return the scheduler that the workers of the operators run on, nullptr if they run on threads of their own */
+  TaskScheduler *GetScheduler() const { return scheduler_; }
+
+  /** Sets the scheduler of the workers of the operators, see BustubInstance. */
+  void SetScheduler(TaskScheduler *scheduler) { scheduler_ = scheduler; }
+
+  /** Runs fn(worker) on GetParallelism() workers, the calling thread being worker 0, and waits for all of them. */
+  template <class Fn>
+  void RunWorkers(Fn &&fn) const {
+    TaskScheduler::RunWorkers(scheduler_, parallelism_, fn);
+  }
+
+  /** @return true if ExecutorFactory instruments the executors that it creates, see InstrumentedExecutor */
+  bool IsStatsEnabled() const { return stats_enabled_; }
+
+  /** Turns the instrumentation of the executors that ExecutorFactory creates from now on on or off. */
+  void EnableStats(bool enabled) { stats_enabled_ = enabled; }
+
   /** @return the log manager - don't worry about it for now */
   LogManager *GetLogManager() { return nullptr; }
 
@@ -58,6 +119,12 @@ class ExecutorContext {
   Transaction *transaction_;
   SimpleCatalog *catalog_;
   BufferPoolManager *bpm_;
+  size_t memory_budget_;
+  MemoryTracker memory_tracker_;
+  SpillFileManager spill_files_;
+  size_t parallelism_{1};
+  TaskScheduler *scheduler_{nullptr};
+  bool stats_enabled_{false};
 };
 
 }  // namespace bustub
@@ -14,12 +14,14 @@
 
 #include <memory>
 
+#include "execution/executor_stats.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/abstract_plan.h"
 
 namespace bustub {
 /**
- * ExecutorFactory creates executors for arbitrary plan nodes.
+ * ExecutorFactory creates executors for arbitrary plan nodes. If the context asks for stats, every executor is wrapped
+ * in an InstrumentedExecutor, whose GetStats() of the root executor is the tree of the stats of the whole plan.
  */
 class ExecutorFactory {
  public:
@@ -30,5 +32,14 @@ class ExecutorFactory {
    * @return an executor for the given plan and context
    */
   static std::unique_ptr<AbstractExecutor> CreateExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *plan);
+
+ private:
+  /** CreateExecutor() of a plan node whose stats, if any, are a child of the stats of its parent, nullptr for none. */
+  static std::unique_ptr<AbstractExecutor> CreateExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *plan,
+                                                          ExecutorStats *parent_stats);
+
+  /** Creates the executor of a plan node itself, the executors of whose children get stats, nullptr for none. */
+  static std::unique_ptr<AbstractExecutor> CreatePlanExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *plan,
+                                                              ExecutorStats *stats);
 };
 }  // namespace bustub
@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// executor_stats.h
+//
+// Identification: src/include/execution/executor_stats.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * ExecutorStats are the runtime statistics of the executor of a plan node, like those of EXPLAIN ANALYZE, which an
+ * InstrumentedExecutor gathers. They form a tree like that of the plan: the stats of the executors of the children of
+ * the plan node are the children of its stats.
+ *
+ * The times and the pages of an executor include those of its children, which it pulls from while it runs. The pages
+ * are counted on the whole buffer pool, so they include those of any query that runs at the same time.
+ */
+struct ExecutorStats {
+  /** @return the stats and those of the children, an indented line per executor */
+  std::string ToString() const;
+
+  /** The plan node of the executor. */
+  const AbstractPlanNode *plan_{nullptr};
+  /** The rows that the executor produced. */
+  uint64_t num_rows_{0};
+  /** The time spent in Init(), and in Next() and NextBatch(). */
+  std::chrono::nanoseconds init_time_{0};
+  std::chrono::nanoseconds next_time_{0};
+  /** The pages fetched while the executor ran, and those of them that were resident. */
+  uint64_t page_fetches_{0};
+  uint64_t page_hits_{0};
+  /** The most bytes that the executor held in memory at once, see AbstractExecutor::GetMemoryUsage(). */
+  size_t peak_memory_{0};
+  /** The stats of the executors of the children of the plan node, in the order in which they were created. */
+  std::vector<std::shared_ptr<ExecutorStats>> children_;
+};
+
+}  // namespace bustub
@@ -12,12 +12,21 @@
 
 #pragma once
 
+#include <vector>
+
 #include "execution/executor_context.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
+
+class AbstractExpression;
+class JoinFilter;
+
 /**
- * AbstractExecutor implements the Volcano tuple-at-a-time iterator model.
+ * AbstractExecutor implements the Volcano iterator model, tuple-at-a-time with Next() or batch-at-a-time with
+ * NextBatch(). An executor implements at least one of the two natively; each has a fallback that goes through the
+ * other one, see NextBatch() and NextFromBatch().
  */
 class AbstractExecutor {
  public:
@@ -43,13 +52,76 @@ class AbstractExecutor {
    */
   virtual bool Next(Tuple *tuple) = 0;
 
+  /**
+   * Produces the next batch of tuples from this executor. By default, the batch is filled by calling Next(), so an
+   * executor that works on whole batches overrides this, and implements Next() with NextFromBatch().
+   * @param[out] batch the next batch, of the output schema and of at most EXECUTOR_BATCH_SIZE rows
+   * @return true if the batch has a selected row, false if there are no more tuples
+   */
+  virtual bool NextBatch(TupleBatch *batch) {
+    batch->Reset(GetOutputSchema());
+    Tuple tuple;
+    while (!batch->IsFull() && Next(&tuple)) {
+      batch->AppendTuple(tuple);
+    }
+    return !batch->IsEmpty();
+  }
+
   /** @return the schema of the tuples that this executor produces */
   virtual const Schema *GetOutputSchema() = 0;
 
+  /**
+   * Tells the executor that its consumer needs no more of its tuples, e.g. a limit that has produced all of its rows,
+   * so that it stops reading ahead and lets go of the pages and memory that it holds, and tells its children the same.
+   * The executor is not pulled from again until the next Init(). By default there is nothing to let go of.
+   */
+  virtual void Stop() {}
+
+  /**
+   * Offers the executor the filter of a hash join whose probe side it produces, so that it drops the tuples that can
+   * not find a match before it makes them. The filter outlives the executor's use of it.
+   * @param filter the filter of the build side of the join
+   * @param keys the join keys of the probe side, on the output schema of this executor
+   * @return false if the executor does not filter, it produces every tuple then
+   */
+  virtual bool PushJoinFilter(const JoinFilter *filter, const std::vector<const AbstractExpression *> &keys) {
+    return false;
+  }
+
+  /**
+   * @return the bytes that the executor holds in memory right now, roughly, e.g. its hash table, not counting those of
+   * its children. By default an executor holds none worth counting.
+   */
+  virtual size_t GetMemoryUsage() const { return 0; }
+
   /** @return the executor context in which this executor runs */
   ExecutorContext *GetExecutorContext() { return exec_ctx_; }
 
  protected:
+  /** Next() of an executor that produces batches natively, which hands out the rows of one batch after another. */
+  bool NextFromBatch(Tuple *tuple) {
+    while (next_batch_index_ >= next_batch_.GetSize()) {
+      next_batch_index_ = 0;
+      if (!NextBatch(&next_batch_)) {
+        return false;
+      }
+    }
+    // The row goes into the buffer of the caller's tuple, which a loop over Next() allocates only once or so.
+    next_batch_.GetTuple(next_batch_.GetSelection()[next_batch_index_++], tuple);
+    return true;
+  }
+
+  /** Drops the rest of the batch that NextFromBatch() hands out, for an executor that starts over in Init(). */
+  void ResetNextFromBatch() {
+    next_batch_.Clear();
+    next_batch_index_ = 0;
+  }
+
   ExecutorContext *exec_ctx_;
+
+ private:
+  /** The batch that NextFromBatch() hands out, and the position in its selection of the next row. */
+  TupleBatch next_batch_;
+  size_t next_batch_index_{0};
 };
 }  // namespace bustub
@@ -12,25 +12,45 @@
 
 #pragma once
 
+#include <cmath>
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "common/util/hash_util.h"
+#include "common/util/hyper_log_log.h"
 #include "container/hash/hash_function.h"
+#include "execution/aggregate_view.h"
 #include "execution/executor_context.h"
+#include "execution/aggregation_table.h"
+#include "execution/distinct_hash_set.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
+#include "execution/memory_tracker.h"
 #include "execution/plans/aggregation_plan.h"
+#include "storage/table/tmp_tuple_run.h"
 #include "storage/table/tuple.h"
 #include "type/value_factory.h"
 
 namespace bustub {
 /**
  * A simplified hash table that has all the necessary functionality for aggregations.
+ *
+ * A distinct count keeps the values of each group apart: COUNT(DISTINCT) in a DistinctHashSet, its approximation in a
+ * HyperLogLog. Their counts are only filled in by Finish(), once every row is in.
  */
 class SimpleAggregationHashTable {
+  using Sketch = HyperLogLog<APPROX_COUNT_DISTINCT_BITS>;
+
+  /** The values of a group, and the values that its distinct counts have seen, one set or sketch per aggregate. */
+  struct Entry {
+    AggregateValue value_;
+    std::vector<DistinctHashSet> sets_;
+    std::vector<std::unique_ptr<Sketch>> sketches_;
+  };
+
  public:
   /**
    * Create a new simplified aggregation hash table.
@@ -39,7 +59,12 @@ class SimpleAggregationHashTable {
    */
   SimpleAggregationHashTable(const std::vector<const AbstractExpression *> &agg_exprs,
                              const std::vector<AggregationType> &agg_types)
-      : agg_exprs_{agg_exprs}, agg_types_{agg_types} {}
+      : agg_exprs_{agg_exprs}, agg_types_{agg_types} {
+    for (AggregationType agg_type : agg_types_) {
+      has_distinct_ = has_distinct_ || agg_type == AggregationType::CountDistinctAggregate ||
+                      agg_type == AggregationType::ApproxCountDistinctAggregate;
+    }
+  }
 
   /** @return the initial aggregrate value for this aggregation executor */
   AggregateValue GenerateInitialAggregateValue() {
@@ -47,6 +72,8 @@ class SimpleAggregationHashTable {
     for (const auto &agg_type : agg_types_) {
       switch (agg_type) {
         case AggregationType::CountAggregate:
+        case AggregationType::CountDistinctAggregate:
+        case AggregationType::ApproxCountDistinctAggregate:
           // Count starts at zero.
           values.emplace_back(ValueFactory::GetIntegerValue(0));
           break;
@@ -87,6 +114,10 @@ class SimpleAggregationHashTable {
           // Max is just the max.
           result->aggregates_[i] = result->aggregates_[i].Max(input.aggregates_[i]);
           break;
+        case AggregationType::CountDistinctAggregate:
+        case AggregationType::ApproxCountDistinctAggregate:
+          // Distinct counts are counted by Finish().
+          break;
       }
     }
   }
@@ -97,10 +128,96 @@ class SimpleAggregationHashTable {
    * @param agg_val the value to be inserted
    */
   void InsertCombine(const AggregateKey &agg_key, const AggregateValue &agg_val) {
-    if (ht.count(agg_key) == 0) {
-      ht.insert({agg_key, GenerateInitialAggregateValue()});
+    auto it = ht.find(agg_key);
+    if (it == ht.end()) {
+      it = ht.emplace(agg_key, Entry{GenerateInitialAggregateValue(), {}, {}}).first;
+      if (has_distinct_) {
+        it->second.sets_.resize(agg_types_.size());
+        it->second.sketches_.resize(agg_types_.size());
+      }
+    }
+    CombineAggregateValues(&it->second.value_, agg_val);
+    if (has_distinct_) {
+      CombineDistinct(&it->second, agg_val);
+    }
+  }
+
+  /** Fills in the distinct counts of every group, once every row is in. */
+  void Finish() {
+    if (!has_distinct_) {
+      return;
+    }
+    for (auto &[key, entry] : ht) {
+      for (uint32_t i = 0; i < agg_types_.size(); i++) {
+        if (agg_types_[i] == AggregationType::CountDistinctAggregate) {
+          entry.value_.aggregates_[i] = ValueFactory::GetIntegerValue(static_cast<int32_t>(entry.sets_[i].GetSize()));
+        } else if (agg_types_[i] == AggregationType::ApproxCountDistinctAggregate && entry.sketches_[i] != nullptr) {
+          const auto estimate = static_cast<int32_t>(std::llround(entry.sketches_[i]->Estimate()));
+          entry.value_.aggregates_[i] = ValueFactory::GetIntegerValue(estimate);
+        }
+      }
+    }
+  }
+
+  /**
+   * Inserts the selected rows of a batch and combines them with the current aggregations.
+   * @param batch the rows, of the schema that the expressions refer to
+   * @param group_by_exprs the group by expressions, which make the keys
+   */
+  void InsertCombineBatch(const TupleBatch &batch, const std::vector<const AbstractExpression *> &group_by_exprs) {
+    InsertCombineBatch(batch, group_by_exprs, nullptr);
+  }
+
+  /**
+   * Like InsertCombineBatch(), but the rows of groups that are not in the hash table yet may be left out.
+   * @param[out] new_rows if not nullptr, the rows of new groups are not inserted, their indexes in the selection of the
+   * batch are appended to it instead
+   */
+  void InsertCombineBatch(const TupleBatch &batch, const std::vector<const AbstractExpression *> &group_by_exprs,
+                          std::vector<uint32_t> *new_rows) {
+    std::vector<std::vector<Value>> group_by_columns(group_by_exprs.size());
+    std::vector<std::vector<Value>> agg_columns(agg_exprs_.size());
+    for (size_t i = 0; i < group_by_exprs.size(); i++) {
+      group_by_exprs[i]->EvaluateBatch(batch, &group_by_columns[i]);
     }
-    CombineAggregateValues(&ht[agg_key], agg_val);
+    for (size_t i = 0; i < agg_exprs_.size(); i++) {
+      agg_exprs_[i]->EvaluateBatch(batch, &agg_columns[i]);
+    }
+    for (size_t row = 0; row < batch.GetSize(); row++) {
+      AggregateKey agg_key;
+      agg_key.group_bys_.reserve(group_by_columns.size());
+      for (const auto &column : group_by_columns) {
+        agg_key.group_bys_.push_back(column[row]);
+      }
+      if (new_rows != nullptr && ht.count(agg_key) == 0) {
+        new_rows->push_back(static_cast<uint32_t>(row));
+        continue;
+      }
+      AggregateValue agg_val;
+      agg_val.aggregates_.reserve(agg_columns.size());
+      for (const auto &column : agg_columns) {
+        agg_val.aggregates_.push_back(column[row]);
+      }
+      InsertCombine(agg_key, agg_val);
+    }
+  }
+
+  /** Removes every aggregate from the hash table. */
+  void Clear() {
+    ht.clear();
+    distinct_bytes_ = 0;
+  }
+
+  /** @return the bytes that the groups take up, roughly, not counting those of variable length keys */
+  size_t GetMemoryUsage() const {
+    if (ht.empty()) {
+      return 0;
+    }
+    const auto &entry = *ht.begin();
+    const size_t num_values = entry.first.group_bys_.size() + entry.second.value_.aggregates_.size();
+    // every entry is a node of its own, next to the values its vectors hold
+    return ht.size() * (sizeof(entry) + sizeof(void *) + num_values * sizeof(Value)) +
+           ht.bucket_count() * sizeof(void *) + distinct_bytes_;
   }
 
   /**
@@ -109,13 +226,13 @@ class SimpleAggregationHashTable {
   class Iterator {
    public:
     /** Creates an iterator for the aggregate map. */
-    explicit Iterator(std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter) : iter_(iter) {}
+    explicit Iterator(std::unordered_map<AggregateKey, Entry>::const_iterator iter) : iter_(iter) {}
 
     /** @return the key of the iterator */
     const AggregateKey &Key() { return iter_->first; }
 
     /** @return the value of the iterator */
-    const AggregateValue &Val() { return iter_->second; }
+    const AggregateValue &Val() { return iter_->second.value_; }
 
     /** @return the iterator before it is incremented */
     Iterator &operator++() {
@@ -131,7 +248,7 @@ class SimpleAggregationHashTable {
 
    private:
     /** Aggregates map. */
-    std::unordered_map<AggregateKey, AggregateValue>::const_iterator iter_;
+    std::unordered_map<AggregateKey, Entry>::const_iterator iter_;
   };
 
   /** @return iterator to the start of the hash table */
@@ -141,16 +258,61 @@ class SimpleAggregationHashTable {
   Iterator End() { return Iterator{ht.cend()}; }
 
  private:
-  /** The hash table is just a map from aggregate keys to aggregate values. */
-  std::unordered_map<AggregateKey, AggregateValue> ht{};
+  /** Adds the values of the distinct counts of a row to the sets or sketches of its group. Nulls are not counted. */
+  void CombineDistinct(Entry *entry, const AggregateValue &input) {
+    for (uint32_t i = 0; i < agg_types_.size(); i++) {
+      const Value &value = input.aggregates_[i];
+      if (value.IsNull()) {
+        continue;
+      }
+      if (agg_types_[i] == AggregationType::CountDistinctAggregate) {
+        DistinctHashSet &set = entry->sets_[i];
+        key_.clear();
+        DistinctHashSet::AppendKey(value, &key_);
+        const size_t memory_usage = set.GetMemoryUsage();
+        set.Insert(DistinctHashSet::HashKey(key_), key_);
+        distinct_bytes_ += set.GetMemoryUsage() - memory_usage;
+      } else if (agg_types_[i] == AggregationType::ApproxCountDistinctAggregate) {
+        if (entry->sketches_[i] == nullptr) {
+          entry->sketches_[i] = std::make_unique<Sketch>();
+          distinct_bytes_ += sizeof(Sketch);
+        }
+        entry->sketches_[i]->Add(HashUtil::HashValue(&value));
+      }
+    }
+  }
+
+  /** The hash table is just a map from aggregate keys to aggregate values, and the state of their distinct counts. */
+  std::unordered_map<AggregateKey, Entry> ht{};
   /** The aggregate expressions that we have. */
   const std::vector<const AbstractExpression *> &agg_exprs_;
   /** The types of aggregations that we have. */
   const std::vector<AggregationType> &agg_types_;
+  /** True if an aggregation is a distinct count. */
+  bool has_distinct_{false};
+  /** The bytes that the sets and sketches of the distinct counts take up. */
+  size_t distinct_bytes_{0};
+  /** The key of a value of a distinct count, reused from row to row. */
+  std::vector<char> key_;
 };
 
 /**
  * AggregationExecutor executes an aggregation operation (e.g. COUNT, SUM, MIN, MAX) on the tuples of a child executor.
+ *
+ * Aggregations of numbers run on the threads of the query, see ExecutorContext::GetParallelism(). The batches of the
+ * child are read in rounds of AGGREGATION_ROUND_BATCHES per thread, which each thread pre-aggregates into its own
+ * AggregationTable per partition of the hash of the group by values. The tables of each partition are then merged by
+ * a thread of their own. Other aggregations, distinct counts among them, fall back to the SimpleAggregationHashTable.
+ *
+ * Groups that outgrow the memory budget of the ExecutorContext, or take the query over its own, see
+ * ExecutorContext::GetMemoryTracker(), are spilled the way a hash join spills its inputs: once the table is over
+ * budget, the rows of groups that it holds keep being aggregated into it, and those of new groups are appended to a
+ * TmpTupleRun of their partition of the hash of the group by values, HASH_JOIN_PARTITIONS of them. The groups in memory
+ * are produced first, then each spilled partition is read back and aggregated in turn, which spills again if the
+ * partition is still over budget, up to HASH_JOIN_MAX_DEPTH times.
+ *
+ * A plan with an AggregateView reads the groups of the view instead, and does not touch its child, unless the
+ * transaction cannot read the view.
  */
 class AggregationExecutor : public AbstractExecutor {
  public:
@@ -168,9 +330,34 @@ class AggregationExecutor : public AbstractExecutor {
 
   const Schema *GetOutputSchema() override;
 
+  /** Aggregates the child, a batch at a time. */
   void Init() override;
 
-  bool Next(Tuple *tuple) override;
+  bool Next(Tuple *tuple) override { return NextFromBatch(tuple); }
+
+  /** Produces the groups that pass the having clause, in the order of the hash table. */
+  bool NextBatch(TupleBatch *batch) override;
+
+  /** Stops the child and deletes the spilled partitions that are left to aggregate. */
+  void Stop() override;
+
+  /** @return true if the aggregates are kept unboxed in AggregationTables */
+  bool IsUnboxed() const { return unboxed_; }
+
+  /** @return true if the groups outgrew the memory budget and the aggregation spilled partitions */
+  bool HasSpilled() const { return spilled_; }
+
+  /** @return the bytes of the groups in memory */
+  size_t GetMemoryUsage() const override {
+    if (!unboxed_) {
+      return aht_.GetMemoryUsage();
+    }
+    size_t memory_usage = 0;
+    for (const auto &partition : partitions_) {
+      memory_usage += partition.GetMemoryUsage();
+    }
+    return memory_usage;
+  }
 
   /** @return the tuple as an AggregateKey */
   AggregateKey MakeKey(const Tuple *tuple) {
@@ -196,8 +383,85 @@ class AggregationExecutor : public AbstractExecutor {
   /** The child executor whose tuples we are aggregating. */
   std::unique_ptr<AbstractExecutor> child_;
   /** Simple aggregation hash table. */
-  // Uncomment me! SimpleAggregationHashTable aht_;
+  SimpleAggregationHashTable aht_;
   /** Simple aggregation hash table iterator. */
-  // Uncomment me! SimpleAggregationHashTable::Iterator aht_iterator_;
+  SimpleAggregationHashTable::Iterator aht_iterator_;
+  /** The charge of the groups in memory to the memory of the query. */
+  MemoryReservation memory_;
+
+  /** The spilled rows of the groups of a partition. */
+  struct SpilledPartition {
+    std::unique_ptr<TmpTupleRun> run_;
+    // the number of times the rows have been partitioned
+    int depth_{0};
+  };
+
+  /** @return the partition of a hash among the tables of the threads, which is independent of the spilled ones */
+  static size_t WorkerPartitionOf(hash_t hash, size_t num_workers) {
+    return HashUtil::Partition(hash, HASH_JOIN_MAX_DEPTH, num_workers);
+  }
+
+  /**
+   * Aggregates the input, the child or else the spilled partition being read, into memory, and spills the rows of the
+   * groups that do not fit.
+   * @param depth the number of times the input has been partitioned
+   */
+  void Aggregate(int depth);
+
+  /** Aggregate() into aht_. */
+  void AggregateBoxed(int depth);
+
+  /** Aggregate() into partitions_, on several threads. */
+  void AggregateUnboxed(int depth);
+
+  /**
+   * Charges the groups in memory to the memory of the query.
+   * @return true if they take up more than the memory budget, or the query is over its own
+   */
+  bool IsOverBudget(size_t memory_usage) {
+    const bool query_over_budget = !memory_.Resize(memory_usage);
+    return query_over_budget || memory_usage > exec_ctx_->GetMemoryBudget() * static_cast<size_t>(PAGE_SIZE);
+  }
+
+  /** Sets up the runs that the rows of new groups spill to, one per partition. */
+  void StartSpilling();
+
+  /** Queues up the runs that the input spilled to, a partition at a time. */
+  void FinishSpilling(int depth);
+
+  /**
+   * Reads the next batch of the input: the child, or the runs of the spilled partition being aggregated.
+   * @return false if the input is exhausted
+   */
+  bool NextInput(TupleBatch *batch);
+
+  /** Moves on to the next spilled partition and aggregates it. @return false if there is none left */
+  bool NextPartition();
+
+  /** Appends a group to a batch if it passes the having clause. */
+  void AppendGroup(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates, TupleBatch *batch);
+
+  /** True if the groups are read from the view of the plan, view_groups_, and the position of the next to produce. */
+  bool from_view_{false};
+  std::vector<AggregateView::Group> view_groups_;
+  size_t view_index_{0};
+  /** True if the aggregation runs on partitions_ instead of aht_. */
+  bool unboxed_{false};
+  /** The types of the values that are aggregated, one per aggregation. */
+  std::vector<TypeId> input_types_;
+  /** The merged tables of the partitions, and the position of the next group to produce. */
+  std::vector<AggregationTable> partitions_;
+  size_t partition_index_{0};
+  size_t group_index_{0};
+
+  /** True once the aggregation has spilled. */
+  bool spilled_{false};
+  /** The runs that rows spill to, one per partition, empty while the groups fit the budget. */
+  std::vector<std::unique_ptr<TmpTupleRun>> spill_runs_;
+  /** The spilled partitions that are yet to be aggregated. */
+  std::deque<SpilledPartition> pending_;
+  /** The spilled partition being aggregated, no run while the child is, and the position of the read in its run. */
+  SpilledPartition current_;
+  TmpTupleRun::Cursor current_cursor_;
 };
 }  // namespace bustub
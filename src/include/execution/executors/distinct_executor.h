@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// distinct_executor.h
+//
+// Identification: src/include/execution/executors/distinct_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/distinct_hash_set.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/memory_tracker.h"
+#include "execution/plans/distinct_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * DistinctExecutor produces the distinct rows of its child as they come: each row of a batch of the child is looked up
+ * in a DistinctHashSet of the raw bytes of the rows seen so far, and produced if it is not in it yet. Unlike an
+ * aggregation with a group by on every column, it keeps no values per row, only their bytes, and does not wait for the
+ * child to end.
+ *
+ * The set stays in memory, charged to the memory of the query, see ExecutorContext::GetMemoryTracker(); it does not
+ * spill.
+ */
+class DistinctExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new distinct executor.
+   * @param exec_ctx the executor context
+   * @param plan the distinct plan to be executed
+   * @param child the child executor whose distinct rows are produced
+   */
+  DistinctExecutor(ExecutorContext *exec_ctx, const DistinctPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child)
+      : AbstractExecutor(exec_ctx),
+        plan_(plan),
+        child_(std::move(child)),
+        memory_(exec_ctx->GetMemoryTracker()) {}
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override;
+
+  bool Next(Tuple *tuple) override { return NextFromBatch(tuple); }
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  /** Stops the child and lets go of the set. */
+  void Stop() override;
+
+  /** @return the bytes of the set */
+  size_t GetMemoryUsage() const override { return set_.GetMemoryUsage(); }
+
+ private:
+  /** The distinct plan node to be executed. */
+  const DistinctPlanNode *plan_;
+  /** The child executor whose distinct rows are produced. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** The rows produced so far. */
+  DistinctHashSet set_;
+  /** The last batch of the child, and the output columns evaluated on it. */
+  TupleBatch child_batch_;
+  std::vector<std::vector<Value>> columns_;
+  /** The key of a row, reused from row to row. */
+  std::vector<char> key_;
+  /** The charge of the set to the memory of the query. */
+  MemoryReservation memory_;
+};
+}  // namespace bustub
@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// fetch_executor.h
+//
+// Identification: src/include/execution/executors/fetch_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/fetch_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * FetchExecutor reads the tuples whose rids its child produces, a batch of the child at a time, and outputs columns of
+ * them: the late materialization of a query whose scans and joins only hand on rids, see RowIdExpression.
+ *
+ * The rids of a batch are read in the order of their pages, like an IndexScanExecutor reads them, so that the tuples
+ * of a page are read one after another, and a tuple that several rows of the batch name, e.g. the build side of a join
+ * with many matches, is read once. The output keeps the order of the child. A row of which a tuple is gone by then is
+ * skipped.
+ */
+class FetchExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new fetch executor.
+   * @param exec_ctx the executor context
+   * @param plan the fetch plan to be executed
+   * @param child the child executor that produces the rids
+   */
+  FetchExecutor(ExecutorContext *exec_ctx, const FetchPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child)
+      : AbstractExecutor(exec_ctx), plan_(plan), child_(std::move(child)) {}
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override;
+
+  bool Next(Tuple *tuple) override { return NextFromBatch(tuple); }
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  void Stop() override;
+
+ private:
+  /**
+   * Reads the tuples of a source that the selected rows of a batch of the child name.
+   * @param source the index of the source
+   * @param[out] tuples the tuple of each selected row
+   * @param[out] found cleared for the rows whose tuple could not be read
+   */
+  void FetchTuples(size_t source, std::vector<Tuple> *tuples, std::vector<bool> *found);
+
+  /** The fetch plan node to be executed. */
+  const FetchPlanNode *plan_;
+  /** The child executor that produces the rids. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** The tables of the sources. */
+  std::vector<TableMetadata *> tables_;
+  /** The last batch of the child. */
+  TupleBatch child_batch_;
+};
+}  // namespace bustub
@@ -12,21 +12,33 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <deque>
 #include <memory>
 #include <string>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "common/macros.h"
 #include "common/util/hash_util.h"
 #include "container/hash/hash_function.h"
 #include "container/hash/linear_probe_hash_table.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/executors/replay_executor.h"
+#include "execution/executors/seq_scan_executor.h"
 #include "execution/expressions/abstract_expression.h"
+#include "execution/join_filter.h"
+#include "execution/join_key.h"
+#include "execution/memory_tracker.h"
 #include "execution/plans/hash_join_plan.h"
+#include "execution/radix_join.h"
 #include "storage/index/hash_comparator.h"
+#include "storage/page/tmp_tuple_page.h"
 #include "storage/table/tmp_tuple.h"
+#include "storage/table/tmp_tuple_run.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -44,47 +56,273 @@ class IdentityHashFunction : public HashFunction<hash_t> {
 };
 
 /**
- * A simple hash table that supports hash joins.
+ * An in-memory hash table for hash joins, which many threads can build at once without a latch.
+ *
+ * The table is a fixed array of slots, each the head of a list of entries whose hashes share the slot. An entry holds
+ * a copy of its tuple and lives in an arena of chunks that double in size, so that an insert costs no allocation of
+ * its own most of the time. An insert pushes its entry onto the front of its list with a compare-and-swap. The upper
+ * 16 bits of a slot, which an x86-64 or AArch64 pointer does not use, hold a tiny Bloom filter of the hashes in its
+ * list: a probe for a hash whose bit is not set returns without touching an entry.
+ *
+ * A table that is given the width of a JoinKeyLayout keeps the join key of each tuple next to its entry, in an arena
+ * of its own: a probe with a key skips the entries whose key differs, so that tuples which only share the hash of
+ * their keys are not handed out to have the predicate evaluated on them.
+ *
+ * Probes return a range over the tuples of the table, nothing is copied. Probes may run alongside inserts and see
+ * each entry either in full or not at all; entries are never removed.
  */
 class SimpleHashJoinHashTable {
+  struct Entry {
+    const Entry *next_{nullptr};
+    hash_t hash_{0};
+    char *key_{nullptr};
+    Tuple tuple_;
+  };
+
  public:
-  /** Creates a new simple hash join hash table. */
+  /** Iterates over the tuples of a list whose hash, and key if the probe has one, are those of the probe. */
+  class Iterator {
+   public:
+    Iterator(const Entry *entry, hash_t hash, const char *key = nullptr, size_t key_width = 0)
+        : entry_(entry), hash_(hash), key_(key), key_width_(key_width) {
+      SkipMismatches();
+    }
+
+    const Tuple &operator*() const { return entry_->tuple_; }
+    const Tuple *operator->() const { return &entry_->tuple_; }
+
+    Iterator &operator++() {
+      entry_ = entry_->next_;
+      SkipMismatches();
+      return *this;
+    }
+
+    bool operator==(const Iterator &other) const { return entry_ == other.entry_; }
+    bool operator!=(const Iterator &other) const { return entry_ != other.entry_; }
+
+   private:
+    void SkipMismatches() {
+      while (entry_ != nullptr &&
+             (entry_->hash_ != hash_ || (key_ != nullptr && !JoinKeyLayout::Equal(entry_->key_, key_, key_width_)))) {
+        entry_ = entry_->next_;
+      }
+    }
+
+    const Entry *entry_;
+    hash_t hash_;
+    const char *key_;
+    size_t key_width_;
+  };
+
+  /** The tuples that a probe matched, for use in a range-based for loop. */
+  class Range {
+   public:
+    Range(const Entry *head, hash_t hash, const char *key, size_t key_width)
+        : head_(head), hash_(hash), key_(key), key_width_(key_width) {}
+
+    Iterator begin() const { return Iterator(head_, hash_, key_, key_width_); }  // NOLINT
+    Iterator end() const { return Iterator(nullptr, hash_); }                    // NOLINT
+    bool IsEmpty() const { return begin() == end(); }
+
+   private:
+    const Entry *head_;
+    hash_t hash_;
+    const char *key_;
+    size_t key_width_;
+  };
+
+  /**
+   * Creates a new simple hash join hash table.
+   * @param buckets the expected number of tuples; the table has twice as many slots, rounded up to a power of two,
+   * and does not grow, inserts beyond that only make its lists longer
+   * @param key_width the width of the JoinKeyLayout of the keys that are inserted, 0 to keep no keys
+   */
   SimpleHashJoinHashTable(const std::string &name, BufferPoolManager *bpm, HashComparator cmp, uint32_t buckets,
-                          const IdentityHashFunction &hash_fn) {}
+                          const IdentityHashFunction &hash_fn, size_t key_width = 0)
+      : num_slots_(NumSlots(buckets)), key_width_(key_width), slots_(new std::atomic<uintptr_t>[num_slots_]) {
+    for (size_t i = 0; i < num_slots_; i++) {
+      slots_[i].store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < MAX_CHUNKS; i++) {
+      chunks_[i].store(nullptr, std::memory_order_relaxed);
+      key_chunks_[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~SimpleHashJoinHashTable() {
+    for (size_t i = 0; i < MAX_CHUNKS; i++) {
+      delete[] chunks_[i].load(std::memory_order_relaxed);
+      delete[] key_chunks_[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(SimpleHashJoinHashTable);
 
   /**
-   * Inserts a (hash key, tuple) pair into the hash table.
+   * Inserts a (hash key, tuple) pair into the hash table. Safe to call from many threads at once.
    * @param txn the transaction that we execute in
    * @param h the hash key
-   * @param t the tuple to associate with the key
+   * @param t the tuple to associate with the key, which the table copies
+   * @param key the join key of the tuple, of the width that the table was created with, which the table copies
    * @return true if the insert succeeded
    */
-  bool Insert(Transaction *txn, hash_t h, const Tuple &t) {
-    hash_table_[h].emplace_back(t);
+  bool Insert(Transaction *txn, hash_t h, const Tuple &t, const char *key = nullptr) {
+    Entry *entry = AllocateEntry();
+    entry->hash_ = h;
+    entry->tuple_ = t;
+    if (key_width_ > 0) {
+      std::memcpy(entry->key_, key, key_width_);
+    }
+    auto addr = reinterpret_cast<uintptr_t>(entry);
+    BUSTUB_ASSERT((addr & TAG_MASK) == 0, "entry address does not leave the tag bits free");
+    std::atomic<uintptr_t> &slot = slots_[h & (num_slots_ - 1)];
+    uintptr_t head = slot.load(std::memory_order_relaxed);
+    do {
+      entry->next_ = Untag(head);
+    } while (!slot.compare_exchange_weak(head, addr | (head & TAG_MASK) | TagOf(h), std::memory_order_release,
+                                         std::memory_order_relaxed));
     return true;
   }
 
   /**
-   * Gets the values in the hash table that match the given hash key.
+   * Probes the hash table.
+   * @param h the hash key
+   * @param key the join key of the probe, which must outlive the range, nullptr to match on the hash only
+   * @return the tuples that match the given hash key, which stay valid as long as the table
+   */
+  Range Probe(hash_t h, const char *key = nullptr) const {
+    if (key_width_ == 0) {
+      key = nullptr;
+    }
+    uintptr_t head = slots_[h & (num_slots_ - 1)].load(std::memory_order_acquire);
+    if ((head & TagOf(h)) == 0) {
+      return Range(nullptr, h, key, key_width_);
+    }
+    return Range(Untag(head), h, key, key_width_);
+  }
+
+  /**
+   * Gets the values in the hash table that match the given hash key. Prefer Probe(), which copies nothing.
    * @param txn the transaction that we execute in
    * @param h the hash key
    * @param[out] t the list of tuples that matched the key
    */
-  void GetValue(Transaction *txn, hash_t h, std::vector<Tuple> *t) { *t = hash_table_[h]; }
+  void GetValue(Transaction *txn, hash_t h, std::vector<Tuple> *t) {
+    t->clear();
+    for (const Tuple &tuple : Probe(h)) {
+      t->push_back(tuple);
+    }
+  }
+
+  /** @return the number of tuples in the table */
+  size_t GetSize() const { return num_entries_.load(std::memory_order_relaxed); }
 
  private:
-  std::unordered_map<hash_t, std::vector<Tuple>> hash_table_;
-};
+  static constexpr int TAG_SHIFT = 48;
+  static constexpr uintptr_t TAG_MASK = ~((static_cast<uintptr_t>(1) << TAG_SHIFT) - 1);
+  // the first chunk of the arena holds this many entries, chunk i holds FIRST_CHUNK_SIZE * 2^i
+  static constexpr size_t FIRST_CHUNK_SIZE = 256;
+  static constexpr size_t MAX_CHUNKS = 40;
+
+  static size_t NumSlots(uint32_t buckets) {
+    size_t num_slots = 64;
+    while (num_slots < 2 * static_cast<size_t>(buckets)) {
+      num_slots *= 2;
+    }
+    return num_slots;
+  }
+
+  /** @return the Bloom filter bit of a hash, taken from the bits that do not pick the slot */
+  static uintptr_t TagOf(hash_t h) { return static_cast<uintptr_t>(1) << (TAG_SHIFT + (h >> 60)); }
+
+  static const Entry *Untag(uintptr_t head) { return reinterpret_cast<const Entry *>(head & ~TAG_MASK); }
 
-// TODO(student): when you are ready to attempt task 3, replace the using declaration!
-using HT = SimpleHashJoinHashTable;
+  /**
+   * @return an entry of the arena that no other insert has, the chunk of which is allocated on first use, with its key
+   * pointing to its bytes in the arena of the keys
+   */
+  Entry *AllocateEntry() {
+    const size_t index = num_entries_.fetch_add(1, std::memory_order_relaxed);
+    // chunk c starts at FIRST_CHUNK_SIZE * (2^c - 1)
+    const size_t chunk_index = 63 - __builtin_clzll(index / FIRST_CHUNK_SIZE + 1);
+    BUSTUB_ASSERT(chunk_index < MAX_CHUNKS, "join hash table arena is full");
+    const size_t offset = index - FIRST_CHUNK_SIZE * ((static_cast<size_t>(1) << chunk_index) - 1);
+    Entry *entry = &GetChunk(&chunks_[chunk_index], FIRST_CHUNK_SIZE << chunk_index)[offset];
+    if (key_width_ > 0) {
+      char *keys = GetChunk(&key_chunks_[chunk_index], (FIRST_CHUNK_SIZE << chunk_index) * key_width_);
+      entry->key_ = keys + offset * key_width_;
+    }
+    return entry;
+  }
 
-// using HashJoinKeyType = ???;
-// using HashJoinValType = ???;
-// using HT = LinearProbeHashTable<HashJoinKeyType, HashJoinValType, HashComparator>;
+  /** @return a chunk of an arena, which the first thread to get it allocates */
+  template <typename T>
+  static T *GetChunk(std::atomic<T *> *slot, size_t size) {
+    T *chunk = slot->load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+      auto *fresh = new T[size];
+      if (slot->compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+        chunk = fresh;
+      } else {
+        delete[] fresh;
+      }
+    }
+    return chunk;
+  }
+
+  const size_t num_slots_;
+  const size_t key_width_;
+  // the slots, tagged heads of the lists of entries
+  std::unique_ptr<std::atomic<uintptr_t>[]> slots_;
+  std::array<std::atomic<Entry *>, MAX_CHUNKS> chunks_;
+  // the keys of the entries, at the same indexes as the entries of chunks_, if the table keeps keys
+  std::array<std::atomic<char *>, MAX_CHUNKS> key_chunks_;
+  std::atomic<size_t> num_entries_{0};
+};
+
+using HashJoinKeyType = hash_t;
+using HashJoinValType = TmpTuple;
+using HT = LinearProbeHashTable<HashJoinKeyType, HashJoinValType, HashComparator>;
 
 /**
  * HashJoinExecutor executes hash join operations.
+ *
+ * Init() copies the tuples of the left child into TmpTuplePages and indexes them by the hash of their join keys in a
+ * LinearProbeHashTable, both of which live in the buffer pool. Next() probes the table with the tuples of the right
+ * child.
+ *
+ * Each tuple of the build side is kept with its join key as laid out by a JoinKeyLayout: in its TmpTuplePage, ahead of
+ * the tuple, in the arena of a SimpleHashJoinHashTable, or next to the tuples of a RadixJoin. A probe compares the
+ * keys of the tuples that share its hash before the predicate is evaluated on them, so that the tuples that only
+ * collide on the hash cost a compare of a few words, rather than a read of the tuple and the predicate.
+ *
+ * A build side that outgrows the memory budget of the ExecutorContext would be evicted and read back at random as the
+ * probes need it, so the join turns into a hybrid hash join instead: both inputs are split by hash into
+ * HASH_JOIN_PARTITIONS partitions. Partition 0 stays hot in the hash table and is joined as the right child is read,
+ * the others are spilled to TmpTupleRuns in spill files outside the buffer pool, see SpillFileManager, written and
+ * read back in order, and joined one pair of runs at a time in memory. A spilled partition that is still larger than
+ * the budget is split again, up to HASH_JOIN_MAX_DEPTH times; beyond that it is most likely a single key and is joined
+ * as it is. The build side also spills, or splits, if it takes the query over its memory budget as a whole, see
+ * ExecutorContext::GetMemoryTracker().
+ *
+ * With more than one thread in the ExecutorContext, a build side that fits the budget is kept in memory and joined by
+ * a RadixJoin instead: the right child is read in batches of HASH_JOIN_PROBE_BATCH tuples, each of which is
+ * partitioned and joined on all the threads at once.
+ *
+ * With more than one thread, a join of the scans of two co-partitioned tables, see TablePartitioning, on their
+ * partition keys runs partition-wise: the rows that join are in the partitions of the same index, so each worker joins
+ * a pair of partitions on its own, in a hash table of its own, and neither child is read through Next(). It does so if
+ * the pairs of a round, one per worker, fit in the memory budget.
+ *
+ * Once the build side is in, the join hands a JoinFilter of its keys to the right child, which drops the tuples that
+ * can not match before it makes them. If the child can not filter, the join checks the filter itself before it
+ * probes, or spills, a tuple of the right child.
+ *
+ * If the plan carries an estimate of the rows of the left child, the join reads the left child ahead by up to
+ * HASH_JOIN_MISESTIMATE_FACTOR times that many rows before it builds. Should it go past that, the estimate was badly
+ * wrong, and the join reads the right child ahead as well: if that ends with fewer rows, the join builds on the right
+ * child and probes with the left one instead, see IsSwapped(). The output is the same either way, only its order
+ * differs.
  */
 class HashJoinExecutor : public AbstractExecutor {
  public:
@@ -99,13 +337,19 @@ class HashJoinExecutor : public AbstractExecutor {
                    std::unique_ptr<AbstractExecutor> &&right);
 
   /** @return the JHT in use. Do not modify this function, otherwise you will get a zero. */
-  // Uncomment me! const HT *GetJHT() const { return &jht_; }
+  const HT *GetJHT() const { return &jht_; }
 
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
 
   void Init() override;
 
-  bool Next(Tuple *tuple) override;
+  bool Next(Tuple *tuple) override { return NextFromBatch(tuple); }
+
+  /** Probes with batches of the right child, and evaluates the output columns straight into the batch. */
+  bool NextBatch(TupleBatch *batch) override;
+
+  /** Stops both children and deletes the spilled partitions and the tables that are left to probe. */
+  void Stop() override;
 
   /**
    * Hashes a tuple by evaluating it against every expression on the given schema, combining all non-null hashes.
@@ -115,31 +359,220 @@ class HashJoinExecutor : public AbstractExecutor {
    * @return the hashed tuple
    */
   hash_t HashValues(const Tuple *tuple, const Schema *schema, const std::vector<const AbstractExpression *> &exprs) {
-    hash_t curr_hash = 0;
-    // For every expression,
-    for (const auto &expr : exprs) {
-      // We evaluate the tuple on the expression and schema.
-      Value val = expr->Evaluate(tuple, schema);
-      // If this produces a value,
-      if (!val.IsNull()) {
-        // We combine the hash of that value into our current hash.
-        curr_hash = HashUtil::CombineHashes(curr_hash, HashUtil::HashValue(&val));
-      }
-    }
-    return curr_hash;
+    return JoinFilter::HashKeys(tuple, schema, exprs);
+  }
+
+  /** @return true if the right child took the filter of the build side, and only produces tuples that may match */
+  bool HasPushedFilter() const { return filter_pushed_; }
+
+  /** @return true if the build side outgrew the memory budget and the join spilled partitions */
+  bool HasSpilled() const { return !left_runs_.empty(); }
+
+  /** @return true if the join builds on the right child, since the estimate of the left child was badly wrong */
+  bool IsSwapped() const { return swapped_; }
+
+  /** @return true if the join runs as a RadixJoin */
+  bool IsRadixJoin() const { return radix_ != nullptr; }
+
+  /** @return true if the join runs partition-wise, a pair of partitions of the children per worker */
+  bool IsPartitionWise() const { return left_scan_ != nullptr; }
+
+  /** @return the bytes of the build side in memory: the pages of the hot partition, or the tuples of a radix join */
+  size_t GetMemoryUsage() const override {
+    return (hot_run_ == nullptr ? 0 : hot_run_->GetNumPages() * PAGE_SIZE) + build_tuples_.capacity() * sizeof(Tuple) +
+           build_keys_.capacity() + build_hashes_.capacity() * sizeof(hash_t);
   }
 
  private:
+  /** A pair of spilled partitions, which join with each other only. */
+  struct PartitionPair {
+    std::unique_ptr<TmpTupleRun> left_;
+    std::unique_ptr<TmpTupleRun> right_;
+    // the number of times the partition has been split
+    int depth_;
+  };
+
+  /** @return the partition of a hash among the partitions of a split at a depth */
+  static size_t PartitionOf(hash_t hash, int depth) {
+    return HashUtil::Partition(hash, depth, HASH_JOIN_PARTITIONS);
+  }
+
+  /** Reads both children ahead if the plan has an estimate of the build side, and picks the side to build on. */
+  void ChooseBuildSide();
+
+  /** @return the join keys of the child that is built on */
+  const std::vector<const AbstractExpression *> &BuildKeys() const {
+    return swapped_ ? plan_->GetRightKeys() : plan_->GetLeftKeys();
+  }
+
+  /** @return the join keys of the child that is probed with */
+  const std::vector<const AbstractExpression *> &ProbeKeys() const {
+    return swapped_ ? plan_->GetLeftKeys() : plan_->GetRightKeys();
+  }
+
+  /** Adds a tuple of the left child to the hot partition or, once the join has spilled, to the run of its partition. */
+  void BuildTuple(const Tuple &tuple);
+
+  /**
+   * Appends a tuple of the build side to the hot partition, as a record of its join key followed by its data, see
+   * StoredTuple().
+   * @return the location of the record
+   */
+  TmpTuple AppendHot(const Tuple &tuple);
+
+  /** @return the tuple of the data of a record of the hot partition, which refers to the data in place */
+  Tuple StoredTuple(const char *data, uint32_t size) const {
+    return Tuple(data + key_layout_.GetWidth(), size - key_layout_.GetWidth());
+  }
+
+  /**
+   * Reads the left child into memory and builds a RadixJoin on it.
+   * @return false if the left child outgrew the budget, the tuples read so far are added with BuildTuple() then
+   */
+  bool BuildRadix();
+
+  /**
+   * Works out whether the join runs partition-wise: both children are scans of co-partitioned tables, a pair of the
+   * join keys is their partition key, and a round of pairs of partitions fits in the memory budget, which it charges.
+   * @return true if the join runs partition-wise, with left_scan_ and right_scan_ set
+   */
+  bool ChoosePartitionWise();
+
+  /** NextOutput() of a partition-wise join, which joins a round of pairs of partitions, one per worker, at a time. */
+  bool NextPartitionWise(std::vector<Value> *values);
+
+  /**
+   * Joins a pair of partitions of the children in memory, see SeqScanExecutor::ScanPartition(). Safe to call on many
+   * threads, for different partitions.
+   * @param partition the partition
+   * @param[out] outputs the output rows, which are appended to
+   * @return false if a page could not be fetched
+   */
+  bool JoinPartition(size_t partition, std::vector<std::vector<Value>> *outputs);
+
+  /** Builds the JoinFilter from the hashes of the build side and offers it to the right child. */
+  void PushFilter();
+
+  /** @return false if no tuple of the build side has the hash */
+  bool MayMatch(hash_t hash) const { return filter_pushed_ || join_filter_->MayContain(hash); }
+
+  /**
+   * Produces the next output row of the join.
+   * @param[out] values the values of the output columns
+   * @return false if there is none left
+   */
+  bool NextOutput(std::vector<Value> *values);
+
+  /** NextOutput() of a radix join. */
+  bool NextRadix(std::vector<Value> *values);
+
+  /**
+   * Moves on to the next tuple of the right child that may match, which is read from a batch of it.
+   * @param[out] tuple the tuple
+   * @param[out] hash the hash of its join keys
+   * @return false if the right child is exhausted
+   */
+  bool NextRight(Tuple *tuple, hash_t *hash);
+
+  /** Splits the hot partition, which outgrew the budget: all the tuples but those of partition 0 move to runs. */
+  void Spill();
+
+  /** Splits a pair of partitions that is larger than the budget into HASH_JOIN_PARTITIONS pairs, queued up. */
+  void Repartition(PartitionPair *pair);
+
+  /**
+   * Moves on to the next right tuple to probe with, which is read from the right child or, once that is done, from a
+   * spilled partition.
+   * @return false if there is none left
+   */
+  bool NextProbe();
+
+  /** Moves on to the next spilled pair and builds its in-memory table. @return false if there is none left */
+  bool NextPartition();
+
+  /**
+   * Evaluates the predicate and, if it holds, the output schema on a pair of tuples. Safe to call on many threads.
+   * @param build_tuple the tuple of the build side
+   * @param probe_tuple the tuple of the probe side
+   * @param[out] values the values of the output columns
+   * @return true if the predicate holds
+   */
+  bool MakeOutput(const Tuple &build_tuple, const Tuple &probe_tuple, std::vector<Value> *values);
+
   /** The hash join plan node. */
   const HashJoinPlanNode *plan_;
+  /** The left child, which builds the hash table. */
+  std::unique_ptr<AbstractExecutor> left_;
+  /** The right child, which probes it. */
+  std::unique_ptr<AbstractExecutor> right_;
+  /** The children as read ahead, see ChooseBuildSide(). */
+  ReplayExecutor left_replay_;
+  ReplayExecutor right_replay_;
+  /** The child that builds the hash table and the one that probes it, the left and the right one unless swapped. */
+  AbstractExecutor *build_{nullptr};
+  AbstractExecutor *probe_{nullptr};
+  bool swapped_{false};
   /** The comparator is used to compare hashes. */
-  [[maybe_unused]] HashComparator jht_comp_{};
+  HashComparator jht_comp_{};
   /** The identity hash function. */
   IdentityHashFunction jht_hash_fn_{};
 
-  /** The hash table that we are using. */
-  // Uncomment me! HT jht_;
+  /** The hash table that we are using, for the hot partition. */
+  HT jht_;
   /** The number of buckets in the hash table. */
   static constexpr uint32_t jht_num_buckets_ = 2;
+  /** The tuples of the left child in the hot partition. Those that moved to runs when it spilled stay behind. */
+  std::unique_ptr<TmpTupleRun> hot_run_;
+
+  /** The runs of the partitions of each input, but for partition 0, empty until the build side spills. */
+  std::vector<std::unique_ptr<TmpTupleRun>> left_runs_;
+  std::vector<std::unique_ptr<TmpTupleRun>> right_runs_;
+  /** The spilled pairs that are yet to be joined. */
+  std::deque<PartitionPair> pending_;
+  /** The spilled pair being joined, its left tuples in memory and the position of the probe in its right run. */
+  PartitionPair current_;
+  std::unique_ptr<SimpleHashJoinHashTable> current_table_;
+  TmpTupleRun::Cursor current_cursor_;
+
+  /** The layout of the join keys, and the key of the tuple that is being probed with. */
+  JoinKeyLayout key_layout_;
+  std::vector<char> probe_key_;
+  /** The buffer that the records of the hot partition are made in, see AppendHot(). */
+  std::vector<char> record_;
+  /** The tuple that is being probed with. */
+  Tuple right_tuple_;
+  /** True once the right child is exhausted. */
+  bool right_done_{false};
+  /** The last batch of the right child, filtered down to the rows that may match, the hashes of their keys and the
+   * position in its selection of the next row to probe with. */
+  TupleBatch right_batch_;
+  std::vector<hash_t> right_hashes_;
+  size_t right_index_{0};
+  /** The matches in the hot partition of right_tuple_, and the next of them to check. */
+  std::vector<TmpTuple> matches_;
+  size_t match_index_{0};
+  /** The matches in the current spilled pair of right_tuple_, from the next to check to the last. */
+  SimpleHashJoinHashTable::Iterator partition_match_{nullptr, 0};
+  SimpleHashJoinHashTable::Iterator partition_end_{nullptr, 0};
+
+  /** The radix join, nullptr unless the join runs on several threads in memory. */
+  std::unique_ptr<RadixJoin> radix_;
+  /** The tuples of the left child, in memory for the radix join, and their join keys one after the other. */
+  std::vector<Tuple> build_tuples_;
+  std::vector<char> build_keys_;
+  /** The hashes of the build side, until the filter is built from them. */
+  std::vector<hash_t> build_hashes_;
+  /** The filter of the build side, and whether the right child filters with it. */
+  std::unique_ptr<JoinFilter> join_filter_;
+  bool filter_pushed_{false};
+  /** The scans of a partition-wise join, nullptr unless it runs partition-wise, and the next partition to join. */
+  const SeqScanExecutor *left_scan_{nullptr};
+  const SeqScanExecutor *right_scan_{nullptr};
+  size_t next_partition_{0};
+  /** The output of the last batch of a radix join, or partition-wise join, and the next of them to return. */
+  std::vector<std::vector<Value>> outputs_;
+  size_t output_index_{0};
+  /** The charge of the build side in memory to the memory of the query. */
+  MemoryReservation memory_;
 };
 }  // namespace bustub
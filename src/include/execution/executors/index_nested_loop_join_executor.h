@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_nested_loop_join_executor.h
+//
+// Identification: src/include/execution/executors/index_nested_loop_join_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/index_nested_loop_join_plan.h"
+#include "storage/table/tuple.h"
+#include "storage/table/tuple_ref.h"
+
+namespace bustub {
+
+/**
+ * IndexNestedLoopJoinExecutor executes an index nested loop join. It builds nothing: it takes the outer side a batch at
+ * a time, looks up the keys of the whole batch in the index at once, see Index::ScanKeys(), and reads the inner tuples
+ * that match in the order of their pages, so that an inner page is fetched once per batch however many outer tuples
+ * it matches. The output of a batch follows the order of the inner pages, not that of the outer tuples.
+ *
+ * An outer tuple with a null key matches nothing. Like IndexScanExecutor, the inner table is not locked as a whole, its
+ * tuples are read like any other point read.
+ */
+class IndexNestedLoopJoinExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new index nested loop join executor.
+   * @param exec_ctx the context that the join should be performed in
+   * @param plan the index nested loop join plan node
+   * @param outer the executor of the outer side
+   */
+  IndexNestedLoopJoinExecutor(ExecutorContext *exec_ctx, const IndexNestedLoopJoinPlanNode *plan,
+                              std::unique_ptr<AbstractExecutor> &&outer);
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override;
+
+  bool Next(Tuple *tuple) override { return NextFromBatch(tuple); }
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  void Stop() override;
+
+ private:
+  /** Looks up the keys of the next batch of the outer side. @return false if the outer side is done */
+  bool ProbeNextBatch();
+
+  /** @return true if an inner tuple has the given key */
+  bool HasKey(const Tuple &inner_tuple, const std::vector<Value> &key) const;
+
+  /** The index nested loop join plan node. */
+  const IndexNestedLoopJoinPlanNode *plan_;
+  /** The executor of the outer side. */
+  std::unique_ptr<AbstractExecutor> outer_;
+  /** The inner table, and its index. */
+  TableMetadata *inner_info_{nullptr};
+  Index *index_{nullptr};
+  /** The outer tuples of the current batch that have a key, and their keys. */
+  std::vector<Tuple> outer_tuples_;
+  std::vector<std::vector<Value>> outer_keys_;
+  /** The matches of the current batch as pairs of an outer tuple and an inner rid, sorted by rid, and the next one. */
+  std::vector<std::pair<size_t, RID>> matches_;
+  size_t match_index_{0};
+  /**
+   * The inner tuple that was read last, which the next match may share. It is read in place, and released before the
+   * outer child runs and before a batch is returned, so that its page is latched for one batch at most.
+   */
+  TupleRef inner_tuple_;
+  RID inner_rid_;
+  bool inner_valid_{false};
+};
+}  // namespace bustub
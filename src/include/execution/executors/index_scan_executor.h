@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_scan_executor.h
+//
+// Identification: src/include/execution/executors/index_scan_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/index_scan_plan.h"
+#include "storage/table/tuple.h"
+#include "storage/table/tuple_ref.h"
+
+namespace bustub {
+
+/**
+ * IndexScanExecutor executes an index scan: it looks the key of the plan up in the index, and reads the tuples that the
+ * index names from the table, in the order of their pages, so that the tuples of one page are read one after another
+ * and no page is fetched twice in a row. A tuple that is gone by then, or whose key no longer matches, is skipped.
+ *
+ * Unlike SeqScanExecutor, the scan does not lock the whole table, so it reads the tuples like any other point read,
+ * see TableHeap::GetTupleRef(), which reads them in place where the transaction may.
+ */
+class IndexScanExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new index scan executor.
+   * @param exec_ctx the executor context
+   * @param plan the index scan plan to be executed
+   */
+  IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan);
+
+  void Init() override;
+
+  bool Next(Tuple *tuple) override;
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Stop() override {
+    rids_.clear();
+    next_rid_ = 0;
+  }
+
+ private:
+  /** @return true if a tuple of the table has the key of the plan */
+  bool HasKey(const Tuple &tuple) const;
+
+  /** The index scan plan node to be executed. */
+  const IndexScanPlanNode *plan_;
+  /** The table being scanned. */
+  TableMetadata *table_info_{nullptr};
+  /** The index that the key is looked up in. */
+  Index *index_{nullptr};
+  /** The rids of the key, sorted by page and slot, and the position of the next one to read. */
+  std::vector<RID> rids_;
+  size_t next_rid_{0};
+};
+}  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
@@ -24,6 +25,8 @@ namespace bustub {
 /**
  * InsertExecutor executes an insert into a table.
  * Inserted values can either be embedded in the plan itself ("raw insert") or come from a child executor.
+ * The tuples are inserted a batch at a time, see TableHeap::InsertTuples() and Index::InsertEntries(). The tuples of a
+ * partitioned table go to the heaps and the indexes of their partitions, see TablePartitioning.
  */
 class InsertExecutor : public AbstractExecutor {
  public:
@@ -42,10 +45,34 @@ class InsertExecutor : public AbstractExecutor {
 
   // Note that Insert does not make use of the tuple pointer being passed in.
   // We return false if the insert failed for any reason, and return true if all inserts succeeded.
+  // The child's tuples are read a batch at a time.
   bool Next([[maybe_unused]] Tuple *tuple) override;
 
+  /** Runs the insert like Next(). An insert produces no tuples, so the batch is always empty. */
+  bool NextBatch(TupleBatch *batch) override;
+
  private:
+  /** Inserts a batch of tuples into the table and its indexes. @return false if the table heap could not take them */
+  bool InsertTuples(const std::vector<Tuple> &tuples);
+
+  /**
+   * Inserts a batch of tuples into a table that holds its rows in its heap, i.e. one that is neither LSM nor
+   * partitioned, and into its indexes.
+   * @return false if the table heap could not take them
+   */
+  bool InsertInto(TableMetadata *table_info, const std::vector<IndexInfo *> &indexes, const std::vector<Tuple> &tuples);
+
   /** The insert plan node to be executed. */
   const InsertPlanNode *plan_;
+  /** The child executor that produces the tuples to insert, nullptr for a raw insert. */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  /** The table being inserted into. */
+  TableMetadata *table_info_{nullptr};
+  /** The indexes of the table, which get an entry for every inserted tuple. */
+  std::vector<IndexInfo *> table_indexes_;
+  /** The indexes of each partition of a partitioned table, see SimpleCatalog::CreatePartitionedIndex(). */
+  std::vector<std::vector<IndexInfo *>> partition_indexes_;
+  /** True once the insert ran, a second Next() inserts nothing. */
+  bool done_{false};
 };
 }  // namespace bustub
@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// instrumented_executor.h
+//
+// Identification: src/include/execution/executors/instrumented_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_stats.h"
+#include "execution/executors/abstract_executor.h"
+
+namespace bustub {
+
+/**
+ * InstrumentedExecutor wraps the executor of a plan node and gathers its ExecutorStats: it passes every call on to the
+ * executor, and times them and counts the rows that they produce and the pages that they fetch. ExecutorFactory wraps
+ * every executor that it creates in one if the context asks for stats, see ExecutorContext::EnableStats().
+ */
+class InstrumentedExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new instrumented executor.
+   * @param exec_ctx the executor context
+   * @param executor the executor that is instrumented
+   * @param stats the stats of the executor, whose plan node is set, and which the children already were added to
+   */
+  InstrumentedExecutor(ExecutorContext *exec_ctx, std::unique_ptr<AbstractExecutor> &&executor,
+                       std::shared_ptr<ExecutorStats> stats)
+      : AbstractExecutor(exec_ctx), executor_(std::move(executor)), stats_(std::move(stats)) {}
+
+  void Init() override;
+
+  bool Next(Tuple *tuple) override;
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  const Schema *GetOutputSchema() override { return executor_->GetOutputSchema(); }
+
+  void Stop() override { executor_->Stop(); }
+
+  bool PushJoinFilter(const JoinFilter *filter, const std::vector<const AbstractExpression *> &keys) override {
+    return executor_->PushJoinFilter(filter, keys);
+  }
+
+  size_t GetMemoryUsage() const override { return executor_->GetMemoryUsage(); }
+
+  /** @return the stats of the executor and of those of the children of its plan node, so far */
+  std::shared_ptr<const ExecutorStats> GetStats() const { return stats_; }
+
+  /** @return the executor that is instrumented */
+  AbstractExecutor *GetExecutor() const { return executor_.get(); }
+
+ private:
+  /**
+   * Runs a call of the executor and adds its time, its page fetches and the memory of the executor after it to the
+   * stats.
+   * @param time the time of the stats that the call counts towards
+   */
+  template <class Call>
+  auto Measure(std::chrono::nanoseconds *time, Call &&call);
+
+  std::unique_ptr<AbstractExecutor> executor_;
+  std::shared_ptr<ExecutorStats> stats_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// limit_executor.h
+//
+// Identification: src/include/execution/executors/limit_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/limit_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * LimitExecutor executes a LIMIT. It passes the batches of its child through, cutting the last one short by its
+ * selection vector, and stops the child, see AbstractExecutor::Stop(), as soon as it has produced enough tuples, so that
+ * nothing below it reads further than it has to. A limit of zero does not even initialize the child.
+ */
+class LimitExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new limit executor.
+   * @param exec_ctx the executor context
+   * @param plan the limit plan to be executed
+   * @param child the child executor whose first tuples are produced
+   */
+  LimitExecutor(ExecutorContext *exec_ctx, const LimitPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child)
+      : AbstractExecutor(exec_ctx), plan_(plan), child_(std::move(child)) {}
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  void Init() override;
+
+  bool Next(Tuple *tuple) override { return NextFromBatch(tuple); }
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  void Stop() override;
+
+ private:
+  /** The limit plan node to be executed. */
+  const LimitPlanNode *plan_;
+  /** The child executor whose first tuples are produced. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** The number of tuples that may still be produced. */
+  size_t remaining_{0};
+  /** True once the child was stopped, or was never initialized. */
+  bool stopped_{true};
+};
+}  // namespace bustub
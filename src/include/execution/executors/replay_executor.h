@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replay_executor.h
+//
+// Identification: src/include/execution/executors/replay_executor.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/join_filter.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ReplayExecutor lets its consumer look ahead at an executor that it does not own: ReadAhead() pulls batches of the
+ * child and keeps them, NextBatch() hands them out again before it goes on with the child. A HashJoinExecutor reads
+ * its children ahead this way to see which one is the smaller before it builds on it.
+ *
+ * The child is initialized, and stopped, by its owner; Init() only drops the batches read ahead.
+ */
+class ReplayExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new replay executor.
+   * @param exec_ctx the executor context
+   * @param child the executor to read ahead, which must outlive this one
+   */
+  ReplayExecutor(ExecutorContext *exec_ctx, AbstractExecutor *child) : AbstractExecutor(exec_ctx), child_(child) {}
+
+  const Schema *GetOutputSchema() override { return child_->GetOutputSchema(); }
+
+  void Init() override {
+    batches_.clear();
+    num_rows_ = 0;
+    child_done_ = false;
+    filter_ = nullptr;
+    ResetNextFromBatch();
+  }
+
+  /**
+   * Reads batches of the child ahead until there are at least some rows kept, or the child is exhausted.
+   * @param num_rows the number of rows to read ahead
+   * @return true if the child is exhausted, all of its rows are kept then
+   */
+  bool ReadAhead(size_t num_rows) {
+    while (!child_done_ && num_rows_ < num_rows) {
+      TupleBatch batch;
+      if (!child_->NextBatch(&batch)) {
+        child_done_ = true;
+        break;
+      }
+      num_rows_ += batch.GetSize();
+      batches_.push_back(std::move(batch));
+    }
+    return child_done_;
+  }
+
+  /** @return the number of rows read ahead and not handed out yet */
+  size_t GetNumRows() const { return num_rows_; }
+
+  bool Next(Tuple *tuple) override { return NextFromBatch(tuple); }
+
+  bool NextBatch(TupleBatch *batch) override {
+    while (!batches_.empty()) {
+      *batch = std::move(batches_.front());
+      batches_.pop_front();
+      num_rows_ -= batch->GetSize();
+      if (filter_ != nullptr) {
+        // The child filters what it makes from now on, the rows it made before are filtered here.
+        std::vector<hash_t> hashes;
+        JoinFilter::HashKeys(*batch, *filter_keys_, &hashes);
+        batch->Filter([this, &hashes](size_t i) { return filter_->MayContain(hashes[i]); });
+      }
+      if (!batch->IsEmpty()) {
+        return true;
+      }
+    }
+    return !child_done_ && child_->NextBatch(batch);
+  }
+
+  bool PushJoinFilter(const JoinFilter *filter, const std::vector<const AbstractExpression *> &keys) override {
+    if (!child_->PushJoinFilter(filter, keys)) {
+      return false;
+    }
+    filter_ = filter;
+    filter_keys_ = &keys;
+    return true;
+  }
+
+  void Stop() override {
+    batches_.clear();
+    num_rows_ = 0;
+    child_done_ = true;
+    ResetNextFromBatch();
+  }
+
+ private:
+  /** The executor that is read ahead. */
+  AbstractExecutor *child_;
+  /** The batches read ahead and not handed out yet, and their number of rows. */
+  std::deque<TupleBatch> batches_;
+  size_t num_rows_{0};
+  /** True once the child is exhausted. */
+  bool child_done_{false};
+  /** The filter that the child took, nullptr for none, and the keys to check the rows read ahead with. */
+  const JoinFilter *filter_{nullptr};
+  const std::vector<const AbstractExpression *> *filter_keys_{nullptr};
+};
+}  // namespace bustub
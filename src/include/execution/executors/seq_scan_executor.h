@@ -12,17 +12,48 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "buffer/buffer_ring.h"
 #include "execution/executor_context.h"
+#include "execution/compiled_predicate.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/filter_kernel.h"
+#include "execution/join_filter.h"
+#include "execution/morsel_queue.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "storage/table/lsm_table.h"
+#include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
- * SeqScanExecutor executes a sequential scan over a table.
+ * SeqScanExecutor executes a sequential scan over a table. With a parallelism above one, the scan is morsel-driven:
+ * the workers take morsels of pages from a MorselQueue and filter and project them on their own, a round of one
+ * morsel per worker at a time, whose batches NextBatch() then hands out. The order of the tuples is lost then.
+ *
+ * A predicate that compiles, see CompiledPredicate, is tested on the tuples of the table as they are read, so that
+ * only those that pass it are taken apart into a batch, and only into the columns that the scan reads. Any other
+ * predicate is evaluated on the batch. A transaction that reads the table in place, see TableHeap::ReadsInPlace(),
+ * tests the tuples right in their pages, so that a tuple that fails the predicate is not even copied. Of a columnar
+ * table, see ColumnarTablePage, it reads the columns that the scan needs straight from their arrays in the pages. A
+ * comparison of a column with a constant is tested on the array of the column first, by a FilterKernel, and only the
+ * tuples that pass it are read; any other predicate is evaluated on the batch. A dictionary encoded column, see
+ * ColumnDictionary, is tested on its codes, and decoded for the tuples that are read only.
+ *
+ * A predicate that compares a column with a constant is also tested against the zone map of the table, see ZoneMap:
+ * a page whose zone shows that none of its tuples can pass is skipped without being fetched. Only the scans that read
+ * a page at a time do so, i.e. those that read in place or in parallel.
+ *
+ * An output column may be the rid of the tuple, see RowIdExpression, so that a FetchExecutor reads the rest of the
+ * tuple later on, if it is still needed by then.
+ *
+ * Of a partitioned table, see TablePartitioning, the scan reads the partitions that the predicate does not prune, one
+ * after the other, or, in parallel, the morsels of all of them. A partition-wise join reads the partitions one at a
+ * time instead, see ScanPartition().
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -35,12 +66,172 @@ class SeqScanExecutor : public AbstractExecutor {
 
   void Init() override;
 
-  bool Next(Tuple *tuple) override;
+  bool Next(Tuple *tuple) override { return NextFromBatch(tuple); }
+
+  /**
+   * Reads up to EXECUTOR_BATCH_SIZE tuples of the table into a batch of the table's schema, filters it through its
+   * selection vector and evaluates the output columns on what is left, a column at a time.
+   */
+  bool NextBatch(TupleBatch *batch) override;
 
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
 
+  /** Filters on keys that are columns of the output, which it evaluates on the tuples of the table. */
+  bool PushJoinFilter(const JoinFilter *filter, const std::vector<const AbstractExpression *> &keys) override;
+
+  /** Drops the position of the scan, its ring of frames and the batches that it read. */
+  void Stop() override;
+
+  /** @return true if the scan runs on several workers */
+  bool IsParallel() const { return morsels_ != nullptr; }
+
+  /** @return the partitioning of the table, nullptr if it is not partitioned or the scan is not initialized */
+  const TablePartitioning *GetPartitioning() const {
+    return table_info_ == nullptr ? nullptr : table_info_->partitioning_.get();
+  }
+
+  /** @return the number of tables that the scan reads: the partitions that were not pruned, or the table itself */
+  size_t GetNumScannedTables() const { return tables_.size(); }
+
+  /** @return the pages of a partition of a partitioned table that the scan reads, 0 if it is pruned */
+  size_t GetPartitionPages(size_t partition) const {
+    return kept_partitions_[partition] ? table_info_->partitions_[partition]->table_->GetNumPages() : 0;
+  }
+
+  /** @return true if an expression on the output of the scan is the key column of the partitioning of the table */
+  bool IsPartitionKey(const AbstractExpression *expr) const;
+
+  /**
+   * Reads a partition of a partitioned table, filters and projects it, like a parallel scan does a morsel. Safe to call
+   * on many threads, for different partitions, once the scan is initialized; a pruned partition has no batches.
+   * @param partition the partition
+   * @param[out] batches the non-empty output batches, which are appended to
+   * @return false if a page could not be fetched
+   */
+  bool ScanPartition(size_t partition, std::vector<TupleBatch> *batches) const;
+
  private:
+  /** Appends the columns that the scan reads of a table tuple to a batch, if it passes the compiled predicate. */
+  void ReadTuple(const Tuple &tuple, TupleBatch *table_batch) const {
+    if (compiled_predicate_ == nullptr || compiled_predicate_->Test(tuple)) {
+      table_batch->AppendColumns(tuple, read_columns_);
+    }
+  }
+
+  /** Appends the columns that the scan reads of the tuples of a columnar page to a batch. */
+  void ReadColumns(ColumnarTablePage *page, uint32_t num_tuples, TupleBatch *table_batch) const;
+
+  /**
+   * Reads a page of the table in place, see TableHeap::ScanPageInPlace(), into a batch of the table.
+   * @param on_read called after tuples were appended to the batch
+   * @return false if the page could not be fetched
+   */
+  template <class OnRead>
+  bool ReadPageInPlace(TableHeap *table, page_id_t page_id, BufferRing *ring, page_id_t *next_page_id,
+                       TupleBatch *table_batch, OnRead &&on_read) const {
+    if (columnar_) {
+      return table->ScanColumnsInPlace(page_id, ring, next_page_id, [&](ColumnarTablePage *page, uint32_t num_tuples) {
+        ReadColumns(page, num_tuples, table_batch);
+        on_read();
+      });
+    }
+    return table->ScanPageInPlace(page_id, ring, next_page_id, [&](const RID &rid, const char *data, uint32_t size) {
+      Tuple tuple(data, size);
+      tuple.SetRid(rid);
+      tuple.SetOverflowStore(table->GetOverflowStore());
+      ReadTuple(tuple, table_batch);
+      on_read();
+    });
+  }
+
+  /** @return true if the predicate is tested as the tuples are read, so that the batches only hold those that pass */
+  bool IsPredicateApplied() const { return compiled_predicate_ != nullptr || filter_kernel_ != nullptr; }
+
+  /** Works out the columns of the table that the output, the predicate and the join filter read. */
+  void UpdateReadColumns();
+
+  /**
+   * Applies the predicate, unless it is applied already, and the join filter to a batch of tuples of the table, and
+   * evaluates the output columns on what is left. Safe to call on many threads.
+   * @param table_batch the tuples, whose selection is filtered
+   * @param[out] batch the output rows
+   */
+  void FilterAndProject(TupleBatch *table_batch, TupleBatch *batch) const;
+
+  /** Works out the comparison of a column with a constant that the predicate is, which pages are skipped by. */
+  void UpdateZoneFilter();
+
+  /**
+   * @param table the heap of the table, or of a partition of it
+   * @param page_id a page of the heap
+   * @param[out] next_page_id the page after it, if it is skipped
+   * @return true if the zone map of the heap shows that no tuple of the page passes the predicate
+   */
+  bool SkipPage(const TableHeap *table, page_id_t page_id, page_id_t *next_page_id) const;
+
+  /** Starts the scan on a single thread of the table at table_idx_ among tables_, if there is one left. */
+  void OpenTable();
+
+  /** NextBatch() of a parallel scan. */
+  bool NextParallelBatch(TupleBatch *batch);
+
+  /** NextBatch() of a scan on a single thread that reads in place, a page at a time. */
+  bool NextInPlaceBatch(TupleBatch *batch);
+
+  /** NextBatch() of a scan of an LSM table, which merges its memtables and runs on a single thread. */
+  bool NextLsmBatch(TupleBatch *batch);
+
+  /**
+   * Reads the pages of a morsel, and appends the non-empty output batches that they make.
+   * @param table the heap that the pages are of
+   * @return false if a page could not be fetched
+   */
+  bool ScanMorsel(TableHeap *table, const std::vector<page_id_t> &page_ids, std::vector<TupleBatch> *batches) const;
+
   /** The sequential scan plan node to be executed. */
   const SeqScanPlanNode *plan_;
+  /** The table being scanned. */
+  TableMetadata *table_info_{nullptr};
+  /**
+   * The tables that hold the tuples that are read: the partitions of a partitioned table that the predicate does not
+   * prune, or the table itself. A scan on a single thread reads the one at table_idx_.
+   */
+  std::vector<TableMetadata *> tables_;
+  size_t table_idx_{0};
+  /** For each partition of a partitioned table, false if the predicate prunes it. */
+  std::vector<bool> kept_partitions_;
+  /** Keeps a large scan from flushing the rest of the buffer pool, nullptr if the pool is too small for a ring. */
+  std::unique_ptr<BufferRing> ring_;
+  /** The current position of the scan, unless it reads in place. */
+  std::unique_ptr<TableIterator> iter_;
+  /** The position of the scan of an LSM table, nullptr for the other tables. */
+  std::unique_ptr<LsmTable::Iterator> lsm_iter_;
+  /** True if the scan reads the tuples in their pages, and the next page that it reads then. */
+  bool in_place_{false};
+  page_id_t page_id_{INVALID_PAGE_ID};
+  /** True if the scan reads in place from the column arrays of a columnar table. */
+  bool columnar_{false};
+  /** The columns of the table that are read into the batches of the table, in increasing order. */
+  std::vector<uint32_t> read_columns_;
+  /** True if the output or the predicate reads the rids of the tuples, which the batches of the table keep then. */
+  bool read_rids_{false};
+  /** The predicate compiled against the schema of the table, nullptr if there is none or it does not compile. */
+  std::unique_ptr<CompiledPredicate> compiled_predicate_;
+  /** The predicate compiled into a kernel on the column arrays of a columnar table, nullptr if it does not compile. */
+  std::unique_ptr<FilterKernel> filter_kernel_;
+  /** The column, comparison and constant that pages are skipped by, zone_col_idx_ is -1 if none, see SkipPage(). */
+  int64_t zone_col_idx_{-1};
+  ComparisonType zone_cmp_{ComparisonType::Equal};
+  Value zone_constant_;
+  /** The filter of the hash join that the scan feeds, nullptr if none, and its keys on the tuples of the table. */
+  const JoinFilter *join_filter_{nullptr};
+  std::vector<const AbstractExpression *> join_filter_keys_;
+  /** The tuples of the table that the current batch is made of. */
+  TupleBatch table_batch_;
+  /** The morsels of a parallel scan, nullptr for a scan on a single thread. */
+  std::unique_ptr<MorselQueue> morsels_;
+  /** The batches of the last round of a parallel scan, and the next of them to hand out. */
+  std::vector<TupleBatch> parallel_batches_;
+  size_t parallel_index_{0};
 };
 }  // namespace bustub
@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor.h
+//
+// Identification: src/include/execution/executors/sort_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/memory_tracker.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/sort_key.h"
+#include "storage/table/tmp_tuple_run.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * SortExecutor executes an ORDER BY. Init() reads the whole child, and keeps each tuple together with its keys in the
+ * normalized form of SortKey, so that the sort compares strings of bytes.
+ *
+ * If the tuples outgrow the memory budget of the operator, see ExecutorContext::GetMemoryBudget(), or the query goes
+ * over its own, see ExecutorContext::GetMemoryTracker(), the tuples read so far are sorted and written to a
+ * TmpTupleRun in a spill file, and the executor starts over on the next ones. The sorted runs are then merged in one
+ * pass by a LoserTree. A run is read a block at a time, outside the buffer pool, see SpillFileManager.
+ */
+class SortExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new sort executor.
+   * @param exec_ctx the executor context
+   * @param plan the sort plan to be executed
+   * @param child the child executor whose tuples are sorted
+   */
+  SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child);
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  /** Reads and sorts the tuples of the child, spilling sorted runs if they do not fit the memory budget. */
+  void Init() override;
+
+  bool Next(Tuple *tuple) override { return NextFromBatch(tuple); }
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  /** Drops the sorted tuples and deletes the runs. */
+  void Stop() override;
+
+  /** @return true if the sort wrote sorted runs, i.e. merges them */
+  bool HasSpilled() const { return !runs_.empty(); }
+
+  /** @return the bytes of the tuples that are held in memory to be sorted */
+  size_t GetMemoryUsage() const override { return entries_bytes_; }
+
+ private:
+  /** A tuple and its normalized keys. */
+  struct Entry {
+    std::string key_;
+    Tuple tuple_;
+  };
+
+  /** Compares the heads of two runs of the merge, a run that is done coming last, and ties going to the first run. */
+  struct RunLess {
+    bool operator()(size_t a, size_t b) const;
+    const SortExecutor *sort_;
+  };
+
+  /** Sorts the entries in memory, into order_. */
+  void SortEntries();
+
+  /** Sorts the entries and writes them to a new run. */
+  void SpillEntries();
+
+  /** Reads the next tuple of a run into its head, which is marked done at the end of the run. */
+  void AdvanceRun(size_t run);
+
+  /** The sort plan node to be executed. */
+  const SortPlanNode *plan_;
+  /** The child executor whose tuples are sorted. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** The tuples that were read and not spilled, their order once sorted, and the position of the next one. */
+  std::vector<Entry> entries_;
+  std::vector<size_t> order_;
+  size_t next_{0};
+  /** The bytes that the entries take up, roughly, and their charge to the memory of the query. */
+  size_t entries_bytes_{0};
+  MemoryReservation memory_;
+  /** The sorted runs, a reader of each, the next tuple of each and whether it has none left. */
+  std::vector<std::unique_ptr<TmpTupleRun>> runs_;
+  std::vector<TmpTupleRun::Cursor> cursors_;
+  std::vector<Entry> heads_;
+  std::vector<bool> done_;
+  /** The merge of the runs. */
+  std::unique_ptr<LoserTree<RunLess>> merge_;
+};
+}  // namespace bustub
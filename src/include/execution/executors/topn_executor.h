@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_executor.h
+//
+// Identification: src/include/execution/executors/topn_executor.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/topn_plan.h"
+#include "execution/sort_key.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TopNExecutor executes an ORDER BY ... LIMIT n without sorting the whole child: Init() keeps the first n tuples seen
+ * so far in a max-heap on their keys, in the normalized form of SortKey, so a tuple that does not beat the largest of
+ * them is dropped before it is even copied. Tuples whose keys are equal keep their order, like with SortExecutor.
+ */
+class TopNExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Creates a new top-n executor.
+   * @param exec_ctx the executor context
+   * @param plan the top-n plan to be executed
+   * @param child the child executor whose tuples are sorted
+   */
+  TopNExecutor(ExecutorContext *exec_ctx, const TopNPlanNode *plan, std::unique_ptr<AbstractExecutor> &&child);
+
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
+
+  /** Reads the tuples of the child, keeping the first n. */
+  void Init() override;
+
+  bool Next(Tuple *tuple) override { return NextFromBatch(tuple); }
+
+  bool NextBatch(TupleBatch *batch) override;
+
+  void Stop() override {
+    child_->Stop();
+    entries_.clear();
+    heap_.clear();
+    next_ = 0;
+    ResetNextFromBatch();
+  }
+
+  /** @return the bytes of the first n tuples that are kept, roughly */
+  size_t GetMemoryUsage() const override {
+    return entries_.capacity() * sizeof(Entry) + heap_.capacity() * sizeof(size_t);
+  }
+
+ private:
+  /** A tuple, its normalized keys, and its position in the input, which breaks ties. */
+  struct Entry {
+    std::string key_;
+    size_t seq_;
+    Tuple tuple_;
+  };
+
+  /** @return true if entry a comes before entry b */
+  bool Before(size_t a, size_t b) const {
+    const int cmp = entries_[a].key_.compare(entries_[b].key_);
+    return cmp < 0 || (cmp == 0 && entries_[a].seq_ < entries_[b].seq_);
+  }
+
+  /** The top-n plan node to be executed. */
+  const TopNPlanNode *plan_;
+  /** The child executor whose tuples are sorted. */
+  std::unique_ptr<AbstractExecutor> child_;
+  /** The first n tuples, at most. */
+  std::vector<Entry> entries_;
+  /** The entries, as a max-heap while the child is read and in order after that, and the next one to produce. */
+  std::vector<size_t> heap_;
+  size_t next_{0};
+};
+}  // namespace bustub
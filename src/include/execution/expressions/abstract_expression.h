@@ -16,6 +16,7 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -58,6 +59,39 @@ class AbstractExpression {
    */
   virtual Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const = 0;
 
+  /**
+   * Evaluates the selected rows of a batch. Expressions that can work on whole columns override this, which spares the
+   * virtual calls and the tuple per row that the default makes.
+   * @param batch the batch, of the schema that the expression refers to
+   * @param[out] result the values, one per selected row in the order of the selection
+   */
+  virtual void EvaluateBatch(const TupleBatch &batch, std::vector<Value> *result) const {
+    result->clear();
+    result->reserve(batch.GetSize());
+    for (uint32_t row : batch.GetSelection()) {
+      Tuple tuple = batch.GetTuple(row);
+      result->push_back(Evaluate(&tuple, batch.GetSchema()));
+    }
+  }
+
+  /**
+   * Evaluates a join on pairs of rows of two batches, the i'th selected row of the left batch with the i'th selected
+   * row of the right one, like EvaluateBatch() evaluates the rows of a single batch.
+   * @param left_batch the left rows
+   * @param right_batch the right rows, as many as there are left ones
+   * @param[out] result the values, one per pair in the order of the selections
+   */
+  virtual void EvaluateJoinBatch(const TupleBatch &left_batch, const TupleBatch &right_batch,
+                                 std::vector<Value> *result) const {
+    result->clear();
+    result->reserve(left_batch.GetSize());
+    for (size_t i = 0; i < left_batch.GetSize(); i++) {
+      Tuple left_tuple = left_batch.GetTuple(left_batch.GetSelection()[i]);
+      Tuple right_tuple = right_batch.GetTuple(right_batch.GetSelection()[i]);
+      result->push_back(EvaluateJoin(&left_tuple, left_batch.GetSchema(), &right_tuple, right_batch.GetSchema()));
+    }
+  }
+
   /** @return the child_idx'th child of this expression */
   const AbstractExpression *GetChildAt(uint32_t child_idx) const { return children_[child_idx]; }
 
@@ -46,6 +46,12 @@ class AggregateValueExpression : public AbstractExpression {
     return is_group_by_term_ ? group_bys[term_idx_] : aggregates[term_idx_];
   }
 
+  /** @return true if the term is a group by, false if it is an aggregate */
+  bool IsGroupByTerm() const { return is_group_by_term_; }
+
+  /** @return the index of the term */
+  uint32_t GetTermIdx() const { return term_idx_; }
+
  private:
   bool is_group_by_term_;
   uint32_t term_idx_;
@@ -45,6 +45,26 @@ class ColumnValueExpression : public AbstractExpression {
     BUSTUB_ASSERT(false, "Aggregation should only refer to group-by and aggregates.");
   }
 
+  void EvaluateBatch(const TupleBatch &batch, std::vector<Value> *result) const override {
+    const std::vector<Value> &column = batch.GetColumn(col_idx_);
+    result->clear();
+    result->reserve(batch.GetSize());
+    for (uint32_t row : batch.GetSelection()) {
+      result->push_back(column[row]);
+    }
+  }
+
+  void EvaluateJoinBatch(const TupleBatch &left_batch, const TupleBatch &right_batch,
+                         std::vector<Value> *result) const override {
+    EvaluateBatch(tuple_idx_ == 0 ? left_batch : right_batch, result);
+  }
+
+  /** @return the index of the tuple in a join, 0 for the left side and 1 for the right */
+  uint32_t GetTupleIdx() const { return tuple_idx_; }
+
+  /** @return the index of the column in the schema */
+  uint32_t GetColIdx() const { return col_idx_; }
+
  private:
   /** Tuple index 0 = left side of join, tuple index 1 = right side of join */
   uint32_t tuple_idx_;
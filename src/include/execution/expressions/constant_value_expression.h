@@ -14,6 +14,7 @@
 
 #include <vector>
 
+#include "common/macros.h"
 #include "execution/expressions/abstract_expression.h"
 
 namespace bustub {
@@ -27,6 +28,18 @@ class ConstantValueExpression : public AbstractExpression {
 
   Value Evaluate(const Tuple *tuple, const Schema *schema) const override { return val_; }
 
+  /** @return the constant */
+  const Value &GetValue() const { return val_; }
+
+  /**
+   * Binds the constant to another value of its type, or null, for a parameter of a prepared plan, see PreparedPlan.
+   * The executors see the value from their next Init() on.
+   */
+  void SetValue(const Value &val) {
+    BUSTUB_ASSERT(val.IsNull() || val.GetTypeId() == GetReturnType(), "A constant keeps its type.");
+    val_ = val;
+  }
+
   Value EvaluateJoin(const Tuple *left_tuple, const Schema *left_schema, const Tuple *right_tuple,
                      const Schema *right_schema) const override {
     return val_;
@@ -36,6 +49,15 @@ class ConstantValueExpression : public AbstractExpression {
     return val_;
   }
 
+  void EvaluateBatch(const TupleBatch &batch, std::vector<Value> *result) const override {
+    result->assign(batch.GetSize(), val_);
+  }
+
+  void EvaluateJoinBatch(const TupleBatch &left_batch, const TupleBatch &right_batch,
+                         std::vector<Value> *result) const override {
+    result->assign(left_batch.GetSize(), val_);
+  }
+
  private:
   Value val_;
 };
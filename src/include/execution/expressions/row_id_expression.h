@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// row_id_expression.h
+//
+// Identification: src/include/execution/expressions/row_id_expression.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+/**
+ * RowIdExpression is the rid of a tuple of a table, as a BIGINT, see RID::Get(). A scan that outputs it instead of the
+ * columns of its tuples defers reading them: a join of such scans hands on pairs of rids, however wide the tables are,
+ * and a FetchExecutor reads the columns that the query outputs in the end.
+ */
+class RowIdExpression : public AbstractExpression {
+ public:
+  /** Creates a new RowIdExpression. */
+  RowIdExpression() : AbstractExpression({}, TypeId::BIGINT) {}
+
+  Value Evaluate(const Tuple *tuple, const Schema *schema) const override {
+    return ValueFactory::GetBigIntValue(tuple->GetRid().Get());
+  }
+
+  Value EvaluateJoin(const Tuple *left_tuple, const Schema *left_schema, const Tuple *right_tuple,
+                     const Schema *right_schema) const override {
+    BUSTUB_ASSERT(false, "A rid is that of a tuple of a table, which a scan outputs.");
+  }
+
+  Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const override {
+    BUSTUB_ASSERT(false, "Aggregation should only refer to group-by and aggregates.");
+  }
+
+  /** Reads the rids of a batch of the tuples of a table, which keeps them, see TupleBatch::KeepRids(). */
+  void EvaluateBatch(const TupleBatch &batch, std::vector<Value> *result) const override {
+    result->clear();
+    result->reserve(batch.GetSize());
+    for (uint32_t row : batch.GetSelection()) {
+      result->push_back(ValueFactory::GetBigIntValue(batch.GetRid(row).Get()));
+    }
+  }
+};
+}  // namespace bustub
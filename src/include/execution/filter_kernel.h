@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// filter_kernel.h
+//
+// Identification: src/include/execution/filter_kernel.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+
+namespace bustub {
+
+class TableHeap;
+
+/**
+ * FilterKernel tests a comparison of a column with a constant on a whole vector of the column at once: the values of
+ * the column side by side, as in a minipage of a ColumnarTablePage. It sets a bit of a selection mask for every row
+ * that passes, 64 rows to a word of the mask.
+ *
+ * Comparisons of INTEGER, BIGINT and DECIMAL columns with numbers compile. They compare like a CompiledPredicate, and a
+ * null fails them. So do comparisons for (in)equality of a dictionary encoded VARCHAR column of a columnar table with a
+ * string, see ColumnDictionary, which compare the codes of the column with that of the string.
+ *
+ * The kernels compare 8 to 16 values per instruction with AVX-512 or AVX2, whichever the CPU turns out to support at
+ * runtime, and one at a time otherwise, or if the constant is not of the width of the column.
+ */
+class FilterKernel {
+ public:
+  /**
+   * Compiles a predicate into a kernel.
+   * @param predicate the predicate, on tuples of the schema
+   * @param schema the schema of the tuples
+   * @param table the columnar table of the tuples, whose dictionaries encode its VARCHAR columns, nullptr if none
+   * @return the kernel, nullptr if the predicate is no comparison of a column that compiles with a constant
+   */
+  static std::unique_ptr<FilterKernel> Compile(const AbstractExpression *predicate, const Schema *schema,
+                                               const TableHeap *table = nullptr);
+
+  /** @return the column that the kernel reads */
+  uint32_t GetColIdx() const { return col_idx_; }
+
+  /**
+   * Tests the values of a vector of the column.
+   * @param values the values, num_rows of them of the fixed length of the column, which need not be aligned
+   * @param num_rows the number of rows
+   * @param[out] mask (num_rows + 63) / 64 words, bit i % 64 of word i / 64 is set iff row i passes
+   * @return the number of rows that pass
+   */
+  size_t Filter(const char *values, size_t num_rows, uint64_t *mask) const;
+
+  /** @return the instruction set that the kernels use on this CPU, "avx512", "avx2" or "scalar" */
+  static const char *GetInstructionSet();
+
+  /** The constant of a kernel, as a 64-bit integer or as a double, whichever the comparison is in. */
+  struct Constant {
+    int64_t int_{0};
+    double real_{0};
+  };
+
+ private:
+  /** Tests the values of num_words * 64 rows, each word of the mask at a time. */
+  using WordsFn = void (*)(const char *values, size_t num_words, const Constant &constant, uint64_t *mask);
+  /** Tests the values of the rows from begin to end, one at a time, setting their bits of a zeroed mask. */
+  using RowsFn = void (*)(const char *values, size_t begin, size_t end, const Constant &constant, uint64_t *mask);
+
+  FilterKernel(uint32_t col_idx, WordsFn words, RowsFn rows, const Constant &constant)
+      : col_idx_(col_idx), words_(words), rows_(rows), constant_(constant) {}
+
+  uint32_t col_idx_;
+  WordsFn words_;
+  RowsFn rows_;
+  Constant constant_;
+};
+
+}  // namespace bustub
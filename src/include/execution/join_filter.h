@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_filter.h
+//
+// Identification: src/include/execution/join_filter.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include "common/config.h"
+#include "common/util/hash_util.h"
+#include "container/hash/hash_block_filter.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+#include "type/type_kernels.h"
+
+namespace bustub {
+
+/**
+ * JoinFilter is a Bloom filter of the join keys of the build side of a hash join. The join hands it to the executor of
+ * its probe side, which drops the tuples whose keys the build side does not have before it materializes them, see
+ * AbstractExecutor::PushJoinFilter(). It is a HashBlockFilter with a single block of HASH_JOIN_FILTER_BITS_PER_KEY bits
+ * per key.
+ */
+class JoinFilter {
+ public:
+  /** @param num_keys the number of keys that will be added */
+  explicit JoinFilter(size_t num_keys)
+      : filter_(std::max<size_t>((num_keys * HASH_JOIN_FILTER_BITS_PER_KEY + 511) / 512, 1)) {
+    filter_.Resize(1);
+  }
+
+  /** Adds the hash of the join keys of a tuple, see HashKeys(). */
+  void Add(hash_t hash) { filter_.Add(0, hash); }
+
+  /** @return false if no tuple with the hash was added */
+  bool MayContain(hash_t hash) const { return filter_.MayContain(0, hash); }
+
+  /**
+   * Hashes a tuple by evaluating it against every expression on the given schema, combining all non-null hashes. Both
+   * sides of a hash join and the executors that filter for it hash their keys so.
+   * @param tuple tuple to be hashed
+   * @param schema schema to evaluate the tuple on
+   * @param exprs expressions to evaluate the tuple with
+   * @return the hashed tuple
+   */
+  static hash_t HashKeys(const Tuple *tuple, const Schema *schema,
+                         const std::vector<const AbstractExpression *> &exprs) {
+    hash_t curr_hash = 0;
+    // For every expression,
+    for (const auto &expr : exprs) {
+      // A key that is a column is hashed straight from the bytes of the tuple, without evaluating it into a Value.
+      if (auto column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+        if (!tuple->IsNull(schema, column->GetColIdx())) {
+          curr_hash = HashUtil::CombineHashes(curr_hash, HashColumn(*tuple, schema, column->GetColIdx()));
+        }
+        continue;
+      }
+      // We evaluate the tuple on the expression and schema.
+      Value val = expr->Evaluate(tuple, schema);
+      // If this produces a value,
+      if (!val.IsNull()) {
+        // We combine the hash of that value into our current hash.
+        curr_hash = HashUtil::CombineHashes(curr_hash, HashUtil::HashValue(&val));
+      }
+    }
+    return curr_hash;
+  }
+
+  /**
+   * Hashes the selected rows of a batch like HashKeys() hashes a tuple of the same schema.
+   * @param batch the batch to be hashed
+   * @param exprs expressions to evaluate the batch with
+   * @param[out] hashes the hashes, one per selected row in the order of the selection
+   */
+  static void HashKeys(const TupleBatch &batch, const std::vector<const AbstractExpression *> &exprs,
+                       std::vector<hash_t> *hashes) {
+    hashes->assign(batch.GetSize(), 0);
+    std::vector<Value> vals;
+    for (const auto &expr : exprs) {
+      expr->EvaluateBatch(batch, &vals);
+      // The kernels of the type of the keys hash the column without a virtual call per value.
+      TypeKernels::Get(expr->GetReturnType()).hash_combine_(vals, true, hashes->data());
+    }
+  }
+
+ private:
+  /** @return like HashUtil::HashValue() of the value of a column of a tuple that is not null */
+  static hash_t HashColumn(const Tuple &tuple, const Schema *schema, uint32_t col_idx) {
+    switch (schema->GetColumnLayout(col_idx).type_id_) {
+      case TypeId::INTEGER:
+        return HashUtil::HashInt(static_cast<int64_t>(tuple.GetInt32(schema, col_idx)));
+      case TypeId::BIGINT:
+        return HashUtil::HashInt(tuple.GetInt64(schema, col_idx));
+      case TypeId::DECIMAL: {
+        const double raw = tuple.GetDecimal(schema, col_idx);
+        return HashUtil::Hash<double>(&raw);
+      }
+      case TypeId::VARCHAR: {
+        // The hash of a string covers its terminating zero, which follows the view in the tuple.
+        const std::string_view str = tuple.GetStringView(schema, col_idx);
+        if (!str.empty()) {
+          return HashUtil::HashBytes(str.data(), str.size() + 1);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    const Value value = tuple.GetValueView(schema, col_idx);
+    return HashUtil::HashValue(&value);
+  }
+
+  HashBlockFilter filter_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_key.h
+//
+// Identification: src/include/execution/join_key.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * JoinKeyLayout lays the join keys of a tuple out as fixed-width bytes, so that a hash join tells the tuples that only
+ * share the hash of their keys apart with a compare of the bytes, rather than by evaluating its predicate on them.
+ *
+ * The key is 8-byte words per key column: the integer types widen to 64 bits, as they do when hashed, so that equal
+ * values of different widths lay out alike; a DECIMAL is its bits, with -0.0 taken for 0.0; a VARCHAR is its length
+ * and the first VARCHAR_PREFIX bytes of its string. A null lays out as zeros, since it satisfies no predicate it does
+ * not matter which keys it looks alike to. Keys whose bytes differ never satisfy the predicate, keys whose bytes are
+ * equal may still not, e.g. long strings that share a prefix, or nulls: the predicate decides those.
+ *
+ * A join whose keys of the two sides are not of the same kind, e.g. an INTEGER and a DECIMAL, gets no layout: its
+ * width is 0, and the join compares the hashes only, as without one.
+ */
+class JoinKeyLayout {
+ public:
+  /** The bytes of the string of a VARCHAR key that are compared. */
+  static constexpr size_t VARCHAR_PREFIX = 16;
+
+  /** Creates a layout of width 0, which compares nothing. */
+  JoinKeyLayout() = default;
+
+  /**
+   * Creates the layout of the keys of a join.
+   * @param build_keys the join keys of the side that is built on
+   * @param probe_keys the join keys of the side that probes, in the order of the build keys that they equal
+   */
+  JoinKeyLayout(const std::vector<const AbstractExpression *> &build_keys,
+                const std::vector<const AbstractExpression *> &probe_keys);
+
+  /** @return the bytes of a key, a multiple of 8, or 0 if the join has no layout */
+  size_t GetWidth() const { return width_; }
+
+  /**
+   * Lays the join keys of a tuple out.
+   * @param tuple the tuple
+   * @param schema the schema to evaluate the tuple on
+   * @param exprs the join keys of the side of the tuple
+   * @param[out] key the GetWidth() bytes of the key
+   */
+  void Normalize(const Tuple &tuple, const Schema *schema, const std::vector<const AbstractExpression *> &exprs,
+                 char *key) const;
+
+  /**
+   * Compares two keys of a layout.
+   * @param a the first key
+   * @param b the second key
+   * @param width the width of the layout, a multiple of 8
+   * @return true if the keys have the same bytes
+   */
+  static bool Equal(const char *a, const char *b, size_t width) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + sizeof(__m256i) <= width; i += sizeof(__m256i)) {
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+      const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+      if (static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y))) != UINT32_MAX) {
+        return false;
+      }
+    }
+#elif defined(__SSE2__)
+    for (; i + sizeof(__m128i) <= width; i += sizeof(__m128i)) {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+      const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) {
+        return false;
+      }
+    }
+#endif
+    // The narrow keys, and what is left of the wide ones, are compared a word at a time.
+    for (; i < width; i += sizeof(uint64_t)) {
+      uint64_t x;
+      uint64_t y;
+      std::memcpy(&x, a + i, sizeof(x));
+      std::memcpy(&y, b + i, sizeof(y));
+      if (x != y) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  /** How a key column is laid out. */
+  enum class KeyKind : uint8_t { INTEGER, BOOLEAN, TIMESTAMP, DECIMAL, VARCHAR, INVALID };
+
+  /** @return the kind of the values of a type, which the keys of both sides must share, INVALID if it has none */
+  static KeyKind KindOf(TypeId type);
+
+  /** The kind of each key column and the offset of its words in the key. */
+  std::vector<KeyKind> kinds_;
+  std::vector<size_t> offsets_;
+  size_t width_{0};
+};
+
+}  // namespace bustub
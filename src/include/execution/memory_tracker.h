@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_tracker.h
+//
+// Identification: src/include/execution/memory_tracker.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "common/macros.h"
+#include "common/memory_accounting.h"
+
+namespace bustub {
+
+/**
+ * MemoryTracker adds up the bytes that the operators of a query hold in memory, e.g. the tuples of a sort or the hash
+ * table of an aggregation, against a limit for the whole query. Operators charge what they hold through a
+ * MemoryReservation each, and spill to disk once the query is over its limit, even if they are within their own
+ * budget. The tracker is shared by the threads of the query.
+ */
+class MemoryTracker {
+ public:
+  /** Creates a tracker with a limit of the given number of bytes. */
+  explicit MemoryTracker(size_t limit) : limit_(limit) {}
+
+  DISALLOW_COPY_AND_MOVE(MemoryTracker);
+
+  /**
+   * Charges bytes to the query, which are charged even if that takes it over its limit.
+   * @return true if the query is within its limit
+   */
+  bool Consume(size_t bytes) {
+    const size_t usage = usage_.fetch_add(bytes) + bytes;
+    size_t peak = peak_.load();
+    while (usage > peak && !peak_.compare_exchange_weak(peak, usage)) {
+    }
+    return usage <= limit_.load();
+  }
+
+  /** Gives back bytes charged to the query. */
+  void Release(size_t bytes) { usage_.fetch_sub(bytes); }
+
+  /** @return the bytes that the query holds */
+  size_t GetUsage() const { return usage_.load(); }
+
+  /** @return the most bytes that the query has held at a time */
+  size_t GetPeak() const { return peak_.load(); }
+
+  /** @return the bytes that the query may hold */
+  size_t GetLimit() const { return limit_.load(); }
+
+  /** Sets the bytes that the query may hold. */
+  void SetLimit(size_t limit) { limit_ = limit; }
+
+ private:
+  std::atomic<size_t> usage_{0};
+  std::atomic<size_t> peak_{0};
+  std::atomic<size_t> limit_;
+};
+
+/**
+ * MemoryReservation is the share of an operator in the memory of its query: the bytes that the operator holds, which
+ * it keeps up to date as they grow and shrink, and which are given back when the reservation goes away. The bytes are
+ * charged to the subsystem of the operator as well, see MemoryAccounting, whose soft limit the operator is held to
+ * like to the limit of its query.
+ */
+class MemoryReservation {
+ public:
+  /** Creates an empty reservation, charged to a tracker, or to none for nullptr, and to a subsystem. */
+  explicit MemoryReservation(MemoryTracker *tracker, MemorySubsystem subsystem = MemorySubsystem::OPERATOR)
+      : tracker_(tracker), account_(MemoryAccounting::Get(subsystem)) {}
+
+  DISALLOW_COPY(MemoryReservation);
+
+  ~MemoryReservation() { Release(); }
+
+  /**
+   * Sets the bytes that the operator holds, charging or giving back the difference.
+   * @return true if the query is within its limit, and the subsystem within its soft limit
+   */
+  bool Resize(size_t bytes) {
+    // The reservation counts as one allocation of its subsystem while it holds any bytes.
+    if (bytes >= bytes_) {
+      account_->Consume(bytes - bytes_, bytes_ == 0 && bytes > 0 ? 1 : 0);
+    } else {
+      account_->Release(bytes_ - bytes, bytes == 0 ? 1 : 0);
+    }
+    const bool within_soft_limit = !account_->IsOverSoftLimit();
+    if (tracker_ == nullptr) {
+      bytes_ = bytes;
+      return within_soft_limit;
+    }
+    bool within_limit;
+    if (bytes >= bytes_) {
+      within_limit = tracker_->Consume(bytes - bytes_);
+    } else {
+      tracker_->Release(bytes_ - bytes);
+      within_limit = tracker_->GetUsage() <= tracker_->GetLimit();
+    }
+    bytes_ = bytes;
+    return within_limit && within_soft_limit;
+  }
+
+  /** Gives back all the bytes of the reservation. */
+  void Release() { Resize(0); }
+
+  /** @return the bytes that the operator holds */
+  size_t GetSize() const { return bytes_; }
+
+ private:
+  MemoryTracker *tracker_;
+  MemoryAccount *account_;
+  size_t bytes_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// morsel_queue.h
+//
+// Identification: src/include/execution/morsel_queue.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+/**
+ * MorselQueue deals out the pages of a table heap to the workers of a parallel scan, a morsel of consecutive pages at
+ * a time, so that a worker that is done with its morsel takes the next one instead of waiting for the others. The
+ * queue takes the pages that the heap has when the scan starts from its page directory, see TableHeap::GetPageIds(),
+ * so that dealing out a morsel does not follow the links of its pages; the workers read the tuples of their morsels on
+ * their own, see TableHeap::ScanPage().
+ *
+ * A queue may deal out the pages of several heaps, e.g. the partitions of a table, one heap after the other. A morsel
+ * holds the pages of one heap only.
+ */
+class MorselQueue {
+ public:
+  /**
+   * @param table_heap the table heap to deal out
+   * @param morsel_pages the number of pages of a morsel
+   */
+  explicit MorselQueue(TableHeap *table_heap, size_t morsel_pages = SCAN_MORSEL_PAGES)
+      : MorselQueue(std::vector<TableHeap *>{table_heap}, morsel_pages) {}
+
+  /**
+   * @param table_heaps the table heaps to deal out, in order
+   * @param morsel_pages the number of pages of a morsel
+   */
+  explicit MorselQueue(const std::vector<TableHeap *> &table_heaps, size_t morsel_pages = SCAN_MORSEL_PAGES)
+      : morsel_pages_(morsel_pages) {
+    for (TableHeap *table_heap : table_heaps) {
+      page_ids_.push_back(table_heap->GetPageIds(0, std::numeric_limits<size_t>::max()));
+    }
+  }
+
+  /** @return the ids of the pages of the next morsel, in the order of the heap, empty once all were dealt out */
+  std::vector<page_id_t> Next() {
+    size_t heap_index;
+    return Next(&heap_index);
+  }
+
+  /**
+   * @param[out] heap_index the position of the heap of the morsel among the heaps of the queue, unless it is empty
+   * @return the ids of the pages of the next morsel, in the order of its heap, empty once all were dealt out
+   */
+  std::vector<page_id_t> Next(size_t *heap_index) {
+    std::lock_guard<std::mutex> guard(latch_);
+    SkipDealtHeaps();
+    if (heap_idx_ == page_ids_.size()) {
+      return {};
+    }
+    const std::vector<page_id_t> &heap_page_ids = page_ids_[heap_idx_];
+    const size_t end = std::min(next_page_idx_ + morsel_pages_, heap_page_ids.size());
+    std::vector<page_id_t> page_ids(heap_page_ids.begin() + next_page_idx_, heap_page_ids.begin() + end);
+    next_page_idx_ = end;
+    *heap_index = heap_idx_;
+    return page_ids;
+  }
+
+  /** @return true once all the pages were dealt out */
+  bool IsDone() {
+    std::lock_guard<std::mutex> guard(latch_);
+    SkipDealtHeaps();
+    return heap_idx_ == page_ids_.size();
+  }
+
+ private:
+  /** Moves on past the heaps whose pages were all dealt out. The caller holds latch_. */
+  void SkipDealtHeaps() {
+    while (heap_idx_ < page_ids_.size() && next_page_idx_ == page_ids_[heap_idx_].size()) {
+      heap_idx_++;
+      next_page_idx_ = 0;
+    }
+  }
+
+  size_t morsel_pages_;
+  std::mutex latch_;
+  /** The pages of each heap, the heap of the next morsel, and the position of its first page among them. */
+  std::vector<std::vector<page_id_t>> page_ids_;
+  size_t heap_idx_{0};
+  size_t next_page_idx_{0};
+};
+
+}  // namespace bustub
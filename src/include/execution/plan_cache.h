@@ -0,0 +1,179 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// plan_cache.h
+//
+// Identification: src/include/execution/plan_cache.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/result_sink.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/**
+ * PreparedPlan is a plan whose constants may be parameters, which are bound to new values at every execution. It owns
+ * the plans, expressions and schemas of the plan tree, which are made with Make() and MakeParameter().
+ *
+ * Once PlanCache has prepared it, the plan keeps one tree of executors, which Execute() initializes again for every
+ * set of values, so that the executors keep their hash tables, batches and other allocations from one execution to
+ * the next. A parameter is a ConstantValueExpression that is rebound before Init(), so that the predicates that the
+ * executors compile at Init(), e.g. CompiledPredicate, FilterKernel and the zone filter of a scan, see its value like
+ * that of any other constant.
+ */
+class PreparedPlan {
+ public:
+  PreparedPlan() = default;
+  DISALLOW_COPY_AND_MOVE(PreparedPlan);
+  ~PreparedPlan() = default;
+
+  /** @return a plan node, expression or schema that the plan owns, made of the arguments */
+  template <class T, class... Args>
+  T *Make(Args &&... args) {
+    auto object = std::make_unique<T>(std::forward<Args>(args)...);
+    T *result = object.get();
+    if constexpr (std::is_base_of_v<AbstractPlanNode, T>) {
+      plans_.push_back(std::move(object));
+    } else if constexpr (std::is_base_of_v<AbstractExpression, T>) {
+      exprs_.push_back(std::move(object));
+    } else {
+      static_assert(std::is_same_v<T, Schema>, "A plan is made of plan nodes, expressions and schemas.");
+      schemas_.push_back(std::move(object));
+    }
+    return result;
+  }
+
+  /**
+   * Makes the next parameter, the first one being parameter 0.
+   * @param type the type of the values that the parameter is bound to
+   * @return the parameter, a constant that is null until the first Execute()
+   */
+  const AbstractExpression *MakeParameter(TypeId type) {
+    params_.push_back(Make<ConstantValueExpression>(ValueFactory::GetNullValueByType(type)));
+    return params_.back();
+  }
+
+  /** Sets the root of the plan tree. */
+  void SetRoot(const AbstractPlanNode *root) { root_ = root; }
+
+  /** @return the root of the plan tree */
+  const AbstractPlanNode *GetRoot() const { return root_; }
+
+  /** @return the number of parameters */
+  size_t GetNumParameters() const { return params_.size(); }
+
+  /** @return the type of the values that a parameter is bound to */
+  TypeId GetParameterType(size_t param_idx) const { return params_[param_idx]->GetReturnType(); }
+
+  /** @return the context that the executors of the plan run with, nullptr until a PlanCache prepared it */
+  ExecutorContext *GetExecutorContext() const { return exec_ctx_; }
+
+  /** @return the number of times that the plan has been executed */
+  size_t GetNumExecutions() const { return num_executions_; }
+
+  /**
+   * @return the signature of the plan: its shape, tables, columns, constants and the places of its parameters, but not
+   * their values. Two plans of the same signature compute the same results for the same values of their parameters.
+   */
+  std::string GetSignature() const;
+
+  /**
+   * Runs the plan with a value for each parameter. The plan must have been prepared by a PlanCache.
+   * @param params the values of the parameters, in their order, each of the type of its parameter or null
+   * @param[out] result the tuples that the plan produces, which replace those that were there
+   */
+  void Execute(const std::vector<Value> &params, std::vector<Tuple> *result);
+
+  /**
+   * Runs the plan with a value for each parameter, and streams its output into a sink, see ResultSink::Drain().
+   * @param params the values of the parameters
+   * @param sink the sink of the output
+   * @return true if the sink took the whole output, false if it stopped the plan
+   */
+  bool Execute(const std::vector<Value> &params, ResultSink *sink);
+
+ private:
+  friend class PlanCache;
+
+  const AbstractPlanNode *root_{nullptr};
+  std::vector<ConstantValueExpression *> params_;
+  std::vector<std::unique_ptr<AbstractPlanNode>> plans_;
+  std::vector<std::unique_ptr<AbstractExpression>> exprs_;
+  std::vector<std::unique_ptr<Schema>> schemas_;
+  /** The signature of the plan, once it is prepared. */
+  std::string signature_;
+  /** The executors of the plan, made once by the PlanCache, and their context. */
+  std::unique_ptr<AbstractExecutor> executor_;
+  ExecutorContext *exec_ctx_{nullptr};
+  size_t num_executions_{0};
+};
+
+/**
+ * PlanCache keeps the prepared plans of an executor context by their signatures, see PreparedPlan::GetSignature(), so
+ * that a query that is issued again and again with other constants is planned, and its executors made, only once.
+ * The least recently prepared plans are dropped once the cache holds more than its capacity.
+ *
+ * The executors of the plans run with the context of the cache, whose transaction may be changed between executions,
+ * see ExecutorContext::SetTransaction().
+ */
+class PlanCache {
+ public:
+  /**
+   * Creates a new plan cache.
+   * @param exec_ctx the context that the executors of the plans run with, which outlives the cache
+   * @param capacity the number of plans that the cache keeps, at least one
+   */
+  PlanCache(ExecutorContext *exec_ctx, size_t capacity)
+      : exec_ctx_(exec_ctx), capacity_(std::max<size_t>(capacity, 1)) {}
+
+  DISALLOW_COPY_AND_MOVE(PlanCache);
+  ~PlanCache() = default;
+
+  /**
+   * Looks a plan up by its signature. If the cache holds one already, that one is returned and the new one dropped;
+   * otherwise the executors of the new plan are made, and it is added to the cache.
+   * @param plan the plan, with its root set and its parameters not yet bound
+   * @return the prepared plan of the signature, which stays valid until the cache drops it in a later Prepare()
+   */
+  PreparedPlan *Prepare(std::unique_ptr<PreparedPlan> &&plan);
+
+  /** @return the number of plans in the cache */
+  size_t GetSize() const { return plans_.size(); }
+
+  /** @return the number of calls to Prepare() that found the plan in the cache, and that did not */
+  size_t GetNumHits() const { return num_hits_; }
+  size_t GetNumMisses() const { return num_misses_; }
+
+ private:
+  ExecutorContext *exec_ctx_;
+  size_t capacity_;
+  /** The plans, the most recently prepared first, and where each signature is in the list. */
+  std::list<std::unique_ptr<PreparedPlan>> plans_;
+  std::unordered_map<std::string, std::list<std::unique_ptr<PreparedPlan>>::iterator> signatures_;
+  size_t num_hits_{0};
+  size_t num_misses_{0};
+};
+
+}  // namespace bustub
@@ -20,7 +20,19 @@
 namespace bustub {
 
 /** PlanType represents the types of plans that we have in our system. */
-enum class PlanType { SeqScan, HashJoin, Insert, Aggregation };
+enum class PlanType {
+  SeqScan,
+  IndexScan,
+  HashJoin,
+  IndexNestedLoopJoin,
+  Insert,
+  Aggregation,
+  Sort,
+  TopN,
+  Limit,
+  Fetch,
+  Distinct
+};
 
 /**
  * AbstractPlanNode represents all the possible types of plan nodes in our system.
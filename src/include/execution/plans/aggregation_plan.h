@@ -21,8 +21,21 @@
 
 namespace bustub {
 
-/** AggregationType enumerates all the possible aggregation functions in our system. */
-enum class AggregationType { CountAggregate, SumAggregate, MinAggregate, MaxAggregate };
+class AggregateView;
+
+/**
+ * AggregationType enumerates all the possible aggregation functions in our system. CountDistinctAggregate is
+ * COUNT(DISTINCT x), the number of distinct values that are not null; ApproxCountDistinctAggregate estimates it in a
+ * fixed amount of memory per group, within about 1%, see APPROX_COUNT_DISTINCT_BITS.
+ */
+enum class AggregationType {
+  CountAggregate,
+  SumAggregate,
+  MinAggregate,
+  MaxAggregate,
+  CountDistinctAggregate,
+  ApproxCountDistinctAggregate
+};
 
 /**
  * AggregationPlanNode represents the various SQL aggregation functions.
@@ -39,15 +52,19 @@ class AggregationPlanNode : public AbstractPlanNode {
    * @param group_bys the group by clause of the aggregation
    * @param aggregates the expressions that we are aggregating
    * @param agg_types the types that we are aggregating
+   * @param view a view of the same aggregation of the table that the child scans, whose groups are read instead of the
+   * child where the transaction may, see AggregateView::ReadGroups(), nullptr to always aggregate the child
    */
   AggregationPlanNode(const Schema *output_schema, const AbstractPlanNode *child, const AbstractExpression *having,
                       std::vector<const AbstractExpression *> &&group_bys,
-                      std::vector<const AbstractExpression *> &&aggregates, std::vector<AggregationType> &&agg_types)
+                      std::vector<const AbstractExpression *> &&aggregates, std::vector<AggregationType> &&agg_types,
+                      AggregateView *view = nullptr)
       : AbstractPlanNode(output_schema, {child}),
         having_(having),
         group_bys_(std::move(group_bys)),
         aggregates_(std::move(aggregates)),
-        agg_types_(std::move(agg_types)) {}
+        agg_types_(std::move(agg_types)),
+        view_(view) {}
 
   PlanType GetType() const override { return PlanType::Aggregation; }
 
@@ -75,11 +92,15 @@ class AggregationPlanNode : public AbstractPlanNode {
   /** @return the aggregate types */
   const std::vector<AggregationType> &GetAggregateTypes() const { return agg_types_; }
 
+  /** @return the view that the groups are read from, nullptr if there is none */
+  AggregateView *GetView() const { return view_; }
+
  private:
   const AbstractExpression *having_;
   std::vector<const AbstractExpression *> group_bys_;
   std::vector<const AbstractExpression *> aggregates_;
   std::vector<AggregationType> agg_types_;
+  AggregateView *view_;
 };
 
 struct AggregateKey {
@@ -0,0 +1,43 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// distinct_plan.h
+//
+// Identification: src/include/execution/plans/distinct_plan.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * DistinctPlanNode produces the distinct rows of the output columns of its only child, i.e. SELECT DISTINCT. The output
+ * columns are expressions on the tuples of the child, and two rows are the same if all of their values are, nulls
+ * being the same as each other. The first of each set of same rows is produced, in the order of the child.
+ */
+class DistinctPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new DistinctPlanNode.
+   * @param output_schema the output format of this plan node, expressions on the tuples of the child
+   * @param child the child plan whose distinct rows are produced
+   */
+  DistinctPlanNode(const Schema *output_schema, const AbstractPlanNode *child)
+      : AbstractPlanNode(output_schema, {child}) {}
+
+  PlanType GetType() const override { return PlanType::Distinct; }
+
+  /** @return the child of this distinct plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Distinct should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+};
+
+}  // namespace bustub
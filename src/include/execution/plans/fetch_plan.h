@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// fetch_plan.h
+//
+// Identification: src/include/execution/plans/fetch_plan.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "catalog/simple_catalog.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/** A table that a FetchPlanNode reads tuples of, and the column of its child that holds their rids. */
+struct FetchSource {
+  uint32_t rid_col_idx_;
+  table_oid_t table_oid_;
+};
+
+/**
+ * FetchPlanNode reads the tuples whose rids its only child produces, see RowIdExpression, and outputs columns of them.
+ * It has one or two sources: with one, the output columns are expressions on the tuples of its table; with two, e.g.
+ * above a join that hands on the rids of both sides, they are expressions on the pair, like those of a join, the left
+ * tuple being that of the first source.
+ */
+class FetchPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new FetchPlanNode.
+   * @param output_schema the output format of this plan node, expressions on the tuples that are read
+   * @param child the child plan that produces the rids
+   * @param sources the tables that are read, one or two of them
+   */
+  FetchPlanNode(const Schema *output_schema, const AbstractPlanNode *child, std::vector<FetchSource> &&sources)
+      : AbstractPlanNode(output_schema, {child}), sources_(std::move(sources)) {
+    BUSTUB_ASSERT(!sources_.empty() && sources_.size() <= 2, "A fetch reads one or two tables.");
+  }
+
+  PlanType GetType() const override { return PlanType::Fetch; }
+
+  /** @return the child of this fetch plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Fetch should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+  /** @return the tables that are read */
+  const std::vector<FetchSource> &GetSources() const { return sources_; }
+
+ private:
+  std::vector<FetchSource> sources_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <optional>
 #include <utility>
 #include <vector>
 
@@ -24,6 +25,10 @@ namespace bustub {
  * HashJoinPlanNode is used to represent performing a hash join between two children plan nodes.
  * By convention, the left child (index 0) is used to build the hash table,
  * and the right child (index 1) is used in probing the hash table.
+ *
+ * A planner that estimated the number of rows of the build side, see JoinPlanner, hands the estimate on, and the
+ * executor checks it at run time: if the left child turns out to be much larger than estimated, and larger than the
+ * right child, the executor builds on the right child instead.
  */
 class HashJoinPlanNode : public AbstractPlanNode {
  public:
@@ -64,6 +69,12 @@ class HashJoinPlanNode : public AbstractPlanNode {
   /** @return the right keys */
   const std::vector<const AbstractExpression *> &GetRightKeys() const { return right_hash_keys_; }
 
+  /** @return the estimated number of rows of the left child, none if the plan was not costed */
+  std::optional<size_t> GetEstimatedBuildRows() const { return estimated_build_rows_; }
+
+  /** Sets the estimated number of rows of the left child. */
+  void SetEstimatedBuildRows(size_t num_rows) { estimated_build_rows_ = num_rows; }
+
  private:
   /** The hash join predicate. */
   const AbstractExpression *predicate_;
@@ -71,5 +82,7 @@ class HashJoinPlanNode : public AbstractPlanNode {
   std::vector<const AbstractExpression *> left_hash_keys_;
   /** The right child's hash keys. */
   std::vector<const AbstractExpression *> right_hash_keys_;
+  /** The estimated number of rows of the left child. */
+  std::optional<size_t> estimated_build_rows_;
 };
 }  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_nested_loop_join_plan.h
+//
+// Identification: src/include/execution/plans/index_nested_loop_join_plan.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "catalog/simple_catalog.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * IndexNestedLoopJoinPlanNode joins the tuples of its only child, the outer side, with the tuples of a table, the inner
+ * side, that an index of the table finds for them. The key of an outer tuple is made of the outer keys, one per key
+ * column of the index. Expressions of the join take the outer tuple as their left tuple (index 0) and the tuple of the
+ * inner table, of the table's schema, as their right tuple (index 1).
+ */
+class IndexNestedLoopJoinPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new index nested loop join plan node.
+   * @param output_schema the output format of the join
+   * @param outer_plan the plan of the outer side
+   * @param predicate the predicate that the joined tuples must satisfy on top of their keys, may be nullptr
+   * @param inner_table_oid the identifier of the inner table
+   * @param index_oid the identifier of the index of the inner table that is probed
+   * @param outer_keys the key to probe with, on the outer tuples
+   */
+  IndexNestedLoopJoinPlanNode(const Schema *output_schema, const AbstractPlanNode *outer_plan,
+                              const AbstractExpression *predicate, table_oid_t inner_table_oid, index_oid_t index_oid,
+                              std::vector<const AbstractExpression *> &&outer_keys)
+      : AbstractPlanNode(output_schema, {outer_plan}),
+        predicate_(predicate),
+        inner_table_oid_(inner_table_oid),
+        index_oid_(index_oid),
+        outer_keys_(std::move(outer_keys)) {}
+
+  PlanType GetType() const override { return PlanType::IndexNestedLoopJoin; }
+
+  /** @return the predicate that the joined tuples must satisfy, nullptr for none */
+  const AbstractExpression *Predicate() const { return predicate_; }
+
+  /** @return the plan node of the outer side */
+  const AbstractPlanNode *GetOuterPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Index nested loop joins should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+  /** @return the identifier of the inner table */
+  table_oid_t GetInnerTableOid() const { return inner_table_oid_; }
+
+  /** @return the identifier of the index of the inner table */
+  index_oid_t GetIndexOid() const { return index_oid_; }
+
+  /** @return the outer keys */
+  const std::vector<const AbstractExpression *> &GetOuterKeys() const { return outer_keys_; }
+
+ private:
+  /** The join predicate. */
+  const AbstractExpression *predicate_;
+  /** The inner table. */
+  table_oid_t inner_table_oid_;
+  /** The index of the inner table. */
+  index_oid_t index_oid_;
+  /** The outer side's keys. */
+  std::vector<const AbstractExpression *> outer_keys_;
+};
+}  // namespace bustub
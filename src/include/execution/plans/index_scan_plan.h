@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_scan_plan.h
+//
+// Identification: src/include/execution/plans/index_scan_plan.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "catalog/simple_catalog.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "type/value.h"
+
+namespace bustub {
+/**
+ * IndexScanPlanNode identifies the tuples of a table whose key equals a given one, which are looked up in an index of
+ * the table, with an optional predicate on top.
+ */
+class IndexScanPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new index scan plan node.
+   * @param output the output format of this scan plan node
+   * @param predicate the predicate to scan with, tuples are returned if predicate(tuple) = true or predicate = nullptr
+   * @param table_oid the identifier of the table to be scanned
+   * @param index_oid the identifier of the index to look the key up in, an index of the table
+   * @param key the key to look up, one value per key column of the index
+   */
+  IndexScanPlanNode(const Schema *output, const AbstractExpression *predicate, table_oid_t table_oid,
+                    index_oid_t index_oid, std::vector<Value> key)
+      : AbstractPlanNode(output, {}),
+        predicate_{predicate},
+        table_oid_(table_oid),
+        index_oid_(index_oid),
+        key_(std::move(key)) {}
+
+  PlanType GetType() const override { return PlanType::IndexScan; }
+
+  /** @return the predicate to test tuples against; tuples should only be returned if they evaluate to true */
+  const AbstractExpression *GetPredicate() const { return predicate_; }
+
+  /** @return the identifier of the table that should be scanned */
+  table_oid_t GetTableOid() const { return table_oid_; }
+
+  /** @return the identifier of the index that the key is looked up in */
+  index_oid_t GetIndexOid() const { return index_oid_; }
+
+  /** @return the key to look up, one value per key column of the index */
+  const std::vector<Value> &GetKey() const { return key_; }
+
+ private:
+  /** The predicate that all returned tuples must satisfy. */
+  const AbstractExpression *predicate_;
+  /** The table whose tuples should be scanned. */
+  table_oid_t table_oid_;
+  /** The index that the key is looked up in. */
+  index_oid_t index_oid_;
+  /** The key of the tuples to scan. */
+  std::vector<Value> key_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// limit_plan.h
+//
+// Identification: src/include/execution/plans/limit_plan.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * LimitPlanNode produces the first tuples of its only child, at most a given number of them, i.e. LIMIT n. The output
+ * schema is that of the child.
+ */
+class LimitPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new LimitPlanNode.
+   * @param output_schema the output format of this plan node, that of the child
+   * @param child the child plan whose first tuples are produced
+   * @param limit the number of tuples to produce at most
+   */
+  LimitPlanNode(const Schema *output_schema, const AbstractPlanNode *child, size_t limit)
+      : AbstractPlanNode(output_schema, {child}), limit_(limit) {}
+
+  PlanType GetType() const override { return PlanType::Limit; }
+
+  /** @return the child of this limit plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Limit should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+  /** @return the number of tuples to produce at most */
+  size_t GetLimit() const { return limit_; }
+
+ private:
+  size_t limit_;
+};
+
+}  // namespace bustub
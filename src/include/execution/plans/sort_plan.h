@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_plan.h
+//
+// Identification: src/include/execution/plans/sort_plan.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/** OrderByType is the direction of a sort key. Nulls are smaller than any other value. */
+enum class OrderByType { ASC, DESC };
+
+/** A sort key: a direction, and an expression on the tuples that are sorted. */
+using OrderBy = std::pair<OrderByType, const AbstractExpression *>;
+
+/**
+ * SortPlanNode sorts the tuples of its only child, i.e. ORDER BY. Tuples whose keys are equal keep their order. The
+ * output schema is that of the child.
+ */
+class SortPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new SortPlanNode.
+   * @param output_schema the output format of this plan node, that of the child
+   * @param child the child plan whose tuples are sorted
+   * @param order_bys the sort keys, the first one the most significant
+   */
+  SortPlanNode(const Schema *output_schema, const AbstractPlanNode *child, std::vector<OrderBy> &&order_bys)
+      : AbstractPlanNode(output_schema, {child}), order_bys_(std::move(order_bys)) {}
+
+  PlanType GetType() const override { return PlanType::Sort; }
+
+  /** @return the child of this sort plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Sort should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+  /** @return the sort keys */
+  const std::vector<OrderBy> &GetOrderBy() const { return order_bys_; }
+
+ private:
+  std::vector<OrderBy> order_bys_;
+};
+
+}  // namespace bustub
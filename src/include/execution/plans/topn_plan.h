@@ -0,0 +1,58 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_plan.h
+//
+// Identification: src/include/execution/plans/topn_plan.h
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/sort_plan.h"
+
+namespace bustub {
+
+/**
+ * TopNPlanNode produces the first n tuples of its only child in the order of some sort keys, i.e. ORDER BY ... LIMIT n,
+ * like a SortPlanNode that is cut short. The output schema is that of the child.
+ */
+class TopNPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Creates a new TopNPlanNode.
+   * @param output_schema the output format of this plan node, that of the child
+   * @param child the child plan whose tuples are sorted
+   * @param order_bys the sort keys, the first one the most significant
+   * @param n the number of tuples to produce
+   */
+  TopNPlanNode(const Schema *output_schema, const AbstractPlanNode *child, std::vector<OrderBy> &&order_bys, size_t n)
+      : AbstractPlanNode(output_schema, {child}), order_bys_(std::move(order_bys)), n_(n) {}
+
+  PlanType GetType() const override { return PlanType::TopN; }
+
+  /** @return the child of this top-n plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "TopN should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+  /** @return the sort keys */
+  const std::vector<OrderBy> &GetOrderBy() const { return order_bys_; }
+
+  /** @return the number of tuples to produce */
+  size_t GetN() const { return n_; }
+
+ private:
+  std::vector<OrderBy> order_bys_;
+  size_t n_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// push_engine.h
+//
+// Identification: src/include/execution/push_engine.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/insert_plan.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * PushEngine runs a plan push-based, instead of pulling its tuples through a tree of executors. The plan is broken
+ * into pipelines at the nodes that must see all of their input before they produce anything, the build side of a hash
+ * join and an aggregation. A pipeline runs as a single loop that takes batches from its source and pushes each batch
+ * through the probes of the hash joins above the source into the breaker that ends the pipeline. The batches stay
+ * columnar from the scan to the breaker: no tuple is made in between, and no operator is called per tuple.
+ *
+ * The sources of the pipelines are the sequential scans, which SeqScanExecutor::NextBatch() reads, filters and
+ * projects a batch at a time. Any other node that the engine has no push-based version of is run the same way, as an
+ * executor whose batches are pushed on. The joins run in memory, they never spill.
+ */
+class PushEngine {
+ public:
+  /** Takes a batch of the output of a pipeline. It may modify the batch, which the pipeline reuses after the call. */
+  using Consumer = std::function<void(TupleBatch *)>;
+
+  /** @param exec_ctx the context that the plans run in */
+  explicit PushEngine(ExecutorContext *exec_ctx) : exec_ctx_(exec_ctx) {}
+
+  /**
+   * Runs a plan.
+   * @param plan the plan
+   * @param consumer called with every batch of the output of the plan, none for an insert
+   */
+  void Execute(const AbstractPlanNode *plan, const Consumer &consumer);
+
+  /**
+   * Runs a plan, and collects its output.
+   * @param plan the plan
+   * @param[out] result the output tuples are appended to it
+   */
+  void Execute(const AbstractPlanNode *plan, std::vector<Tuple> *result);
+
+ private:
+  /** Runs the pipelines below a node, and pushes the output of the node into a consumer. */
+  void Produce(const AbstractPlanNode *plan, const Consumer &consumer);
+
+  /** Builds the hash table on the left side of a hash join, and pushes the right side through its probe. */
+  void ProduceHashJoin(const HashJoinPlanNode *plan, const Consumer &consumer);
+
+  /** Aggregates the child, and pushes the groups that pass the having clause. */
+  void ProduceAggregation(const AggregationPlanNode *plan, const Consumer &consumer);
+
+  /** Inserts the child or the raw values of the plan, pushing nothing. */
+  void ProduceInsert(const InsertPlanNode *plan);
+
+  /** Runs a node as an executor, and pushes its batches. */
+  void ProduceExecutor(const AbstractPlanNode *plan, const Consumer &consumer);
+
+  ExecutorContext *exec_ctx_;
+};
+
+}  // namespace bustub
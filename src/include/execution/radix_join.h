@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// radix_join.h
+//
+// Identification: src/include/execution/radix_join.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "common/config.h"
+#include "common/task_scheduler.h"
+#include "common/util/hash_util.h"
+
+namespace bustub {
+
+/**
+ * RadixJoin matches the rows of two inputs by hash on several threads. Instead of one large hash table that every
+ * probe misses the cache on, both inputs are split by hash into partitions small enough for a partition of the build
+ * side and its hash table to stay in the cache, and the partitions are joined independently, one worker per partition
+ * at a time.
+ *
+ * A row goes to the partition of the top bits of its hash, and to the bucket of the low bits in the table of the
+ * partition. A partitioning pass has every worker count the rows of its share of the input per partition, and then
+ * scatter them through a cache line sized buffer per partition, which is written out whole once full, so that the
+ * writes of a pass go out a line at a time rather than a row at a time. More partitions than
+ * HASH_JOIN_RADIX_BITS_PER_PASS bits allow take a second pass over each partition of the first.
+ *
+ * The join only matches hashes; the caller checks the rows that a match refers to.
+ */
+class RadixJoin {
+ public:
+  /** A row of an input: the hash of its join keys and its index in the input. */
+  struct Row {
+    hash_t hash_;
+    uint32_t index_;
+  };
+
+  /**
+   * @param num_threads the number of threads that partition and join
+   * @param partition_rows the number of build rows that a partition should hold at most
+   * @param scheduler the scheduler that the threads run on, nullptr for threads of their own
+   */
+  explicit RadixJoin(size_t num_threads, size_t partition_rows = HASH_JOIN_RADIX_PARTITION_ROWS,
+                     TaskScheduler *scheduler = nullptr)
+      : num_threads_(std::max<size_t>(num_threads, 1)),
+        partition_rows_(std::max<size_t>(partition_rows, 1)),
+        scheduler_(scheduler) {}
+
+  /** Partitions the rows of the build side and builds the hash table of each partition. */
+  void Build(std::vector<Row> rows);
+
+  /**
+   * Matches rows of the probe side against the build side.
+   * @param emit called as emit(worker, build_index, probe_index) for each pair of rows with equal hashes, by the
+   * workers at once; worker is below the number of threads and the same for calls from the same thread
+   */
+  template <class Emit>
+  void Probe(std::vector<Row> rows, Emit &&emit) const {
+    std::vector<size_t> offsets;
+    PartitionRows(&rows, &offsets);
+    std::atomic<size_t> next_partition{0};
+    RunWorkers([&](size_t worker) {
+      for (size_t p = next_partition++; p + 1 < offsets.size(); p = next_partition++) {
+        const size_t build_begin = build_offsets_[p];
+        const size_t mask = bucket_offsets_[p + 1] - bucket_offsets_[p] - 1;
+        const int32_t *heads = &heads_[bucket_offsets_[p]];
+        for (size_t i = offsets[p]; i < offsets[p + 1]; i++) {
+          const Row &row = rows[i];
+          for (int32_t j = heads[row.hash_ & mask]; j >= 0; j = next_[build_begin + j]) {
+            const Row &build_row = build_rows_[build_begin + j];
+            if (build_row.hash_ == row.hash_) {
+              emit(worker, build_row.index_, row.index_);
+            }
+          }
+        }
+      }
+    });
+  }
+
+  /** @return the number of partitions that the inputs are split into, a power of two */
+  size_t GetNumPartitions() const { return static_cast<size_t>(1) << radix_bits_; }
+
+ private:
+  /** Runs fn(worker) on every worker, the calling thread being worker 0, and waits for all of them. */
+  template <class Fn>
+  void RunWorkers(Fn &&fn) const {
+    TaskScheduler::RunWorkers(scheduler_, num_threads_, fn);
+  }
+
+  /**
+   * Sorts rows by partition, in one or two passes.
+   * @param[out] offsets the rows of partition p are [offsets[p], offsets[p + 1])
+   */
+  void PartitionRows(std::vector<Row> *rows, std::vector<size_t> *offsets) const;
+
+  /**
+   * Scatters the rows [begin, end) of in by the bits of their hashes at shift into out, from begin on.
+   * @param num_workers the number of workers that split the rows between them
+   * @param[out] offsets the start of each partition in out, and end at the back
+   */
+  void Scatter(const Row *in, Row *out, size_t begin, size_t end, int shift, int bits, size_t num_workers,
+               std::vector<size_t> *offsets) const;
+
+  size_t num_threads_;
+  size_t partition_rows_;
+  TaskScheduler *scheduler_;
+  int radix_bits_{0};
+  // the build rows sorted by partition; partition p is [build_offsets_[p], build_offsets_[p + 1])
+  std::vector<Row> build_rows_;
+  std::vector<size_t> build_offsets_;
+  // the chained hash table of each partition: its buckets are [bucket_offsets_[p], bucket_offsets_[p + 1]) of
+  // heads_, each the first row of its chain relative to the start of the partition, -1 for none
+  std::vector<size_t> bucket_offsets_;
+  std::vector<int32_t> heads_;
+  std::vector<int32_t> next_;
+};
+
+}  // namespace bustub
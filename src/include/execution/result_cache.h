@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// result_cache.h
+//
+// Identification: src/include/execution/result_cache.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "catalog/simple_catalog.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "concurrency/transaction.h"
+#include "execution/plan_cache.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ResultCache keeps the results of prepared plans by their signatures and the values of their parameters, so that a
+ * read query over tables that seldom change is answered without running it while they do not.
+ *
+ * Each result records the last-modified LSN of every table that its plan read, see TableHeap::GetLastModifiedLsn(),
+ * as it was before the plan ran. The result is served as long as none of them moved on: the writes to a table, and
+ * their commits and rollbacks, move it on, so that a result never outlives a change to the rows it was computed from.
+ *
+ * Only the transactions that lock use the cache, see Execute(): a result that is served takes the SHARED locks of the
+ * tables, as the scans of its plan would, so that it is the committed state that no writer may change until the
+ * transaction ends. The plans that write, or read an LSM table, always run. The least recently used results are
+ * dropped once the cache holds more than its bytes.
+ *
+ * The cache is safe to share between the sessions of a catalog.
+ */
+class ResultCache {
+ public:
+  /** @param max_bytes the bytes of the tuples of the results that the cache keeps at most */
+  explicit ResultCache(size_t max_bytes = RESULT_CACHE_MAX_BYTES) : max_bytes_(max_bytes) {}
+
+  DISALLOW_COPY_AND_MOVE(ResultCache);
+  ~ResultCache() = default;
+
+  /**
+   * Serves the result of a plan from the cache, or runs the plan and keeps its result. The plan runs with the context
+   * that it was prepared for, see PlanCache::Prepare(), and its transaction.
+   *
+   * The cache is passed by when the transaction does not lock, i.e. it reads a snapshot or only reads, when the plan
+   * writes or reads an LSM table, and when the transaction wrote a table that the plan reads, whose result would hold
+   * writes that have not committed. The plan runs then, and its result is not kept.
+   * @param plan the prepared plan
+   * @param params the values of the parameters
+   * @param[out] result the tuples of the result, which replace those that were there
+   * @return true if the result was served from the cache
+   */
+  bool Execute(PreparedPlan *plan, const std::vector<Value> &params, std::vector<Tuple> *result);
+
+  /** @return the number of results in the cache */
+  size_t GetSize() {
+    std::scoped_lock lock(latch_);
+    return entries_.size();
+  }
+
+  /** @return the bytes of the tuples of the results in the cache */
+  size_t GetNumBytes() {
+    std::scoped_lock lock(latch_);
+    return num_bytes_;
+  }
+
+  /** @return the number of calls to Execute() that were served from the cache, and that looked it up but were not */
+  size_t GetNumHits() {
+    std::scoped_lock lock(latch_);
+    return num_hits_;
+  }
+  size_t GetNumMisses() {
+    std::scoped_lock lock(latch_);
+    return num_misses_;
+  }
+
+ private:
+  /** A result, and the last-modified LSN of each table that it was computed from. */
+  struct Entry {
+    std::string key_;
+    std::vector<std::pair<TableHeap *, lsn_t>> tables_;
+    std::vector<Tuple> tuples_;
+    size_t bytes_{0};
+  };
+
+  /** @return true if the transaction locks the rows that it reads, rather than reading a snapshot */
+  static bool Locks(Transaction *txn) { return !txn->IsSnapshot() && !txn->IsReadOnly(); }
+
+  /**
+   * Gathers the heaps that a plan tree reads: those of its tables, or of their partitions.
+   * @return false if the plan cannot be cached, i.e. it writes or reads an LSM table
+   */
+  static bool CollectTables(const AbstractPlanNode *plan, SimpleCatalog *catalog, std::vector<TableHeap *> *tables);
+
+  /** @return the key of a result: the signature of its plan and the bytes of the values of its parameters */
+  static std::string KeyOf(const PreparedPlan *plan, const std::vector<Value> &params);
+
+  /** @return true if none of the tables of a result changed since it was computed */
+  static bool IsCurrent(const Entry &entry);
+
+  /** Drops a result, under the latch. */
+  void Erase(std::list<Entry>::iterator entry);
+
+  size_t max_bytes_;
+  /** Protects the results and the counters. */
+  std::mutex latch_;
+  /** The results, the most recently used first, and where each key is in the list. */
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> keys_;
+  size_t num_bytes_{0};
+  size_t num_hits_{0};
+  size_t num_misses_{0};
+};
+
+}  // namespace bustub
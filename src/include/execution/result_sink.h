@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// result_sink.h
+//
+// Identification: src/include/execution/result_sink.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/macros.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/tuple_batch.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ResultSink receives the output of a query a batch at a time, as the root executor produces it, so that a result
+ * need not be held in memory as a whole before it goes to the client. The executors run in the thread that calls
+ * Drain(), and only produce the next batch once the sink has taken the last one: a sink that blocks in Consume()
+ * holds the query back, and one that returns false stops it.
+ */
+class ResultSink {
+ public:
+  virtual ~ResultSink() = default;
+
+  /**
+   * Takes a batch of the output.
+   * @param batch the batch, which the sink may modify or move from, since it is refilled after the call
+   * @return false if the sink wants no more of the output
+   */
+  virtual bool Consume(TupleBatch *batch) = 0;
+
+  /** Tells the sink that no more batches come, whether the output ended, the sink stopped it or the query failed. */
+  virtual void Finish() {}
+
+  /**
+   * Runs an executor, and hands its batches to the sink. Once the sink wants no more of them, the executor is stopped,
+   * see AbstractExecutor::Stop().
+   * @param executor the root executor of the query, which is initialized here
+   * @return true if the sink took the whole output, false if it stopped the query
+   */
+  bool Drain(AbstractExecutor *executor);
+};
+
+/** TupleVectorSink collects the output in a vector of tuples, for results that are small. */
+class TupleVectorSink : public ResultSink {
+ public:
+  /** @param result the vector that the tuples are appended to */
+  explicit TupleVectorSink(std::vector<Tuple> *result) : result_(result) {}
+
+  bool Consume(TupleBatch *batch) override {
+    for (uint32_t row : batch->GetSelection()) {
+      result_->push_back(batch->GetTuple(row));
+    }
+    return true;
+  }
+
+ private:
+  std::vector<Tuple> *result_;
+};
+
+/**
+ * ResultQueue hands the output of a query that runs in one thread to a reader in another, e.g. one that sends it to
+ * the client, through a queue of at most a given number of batches. The query waits while the queue is full, so that
+ * the memory of the output stays constant however fast the query and however slow the reader.
+ */
+class ResultQueue : public ResultSink {
+ public:
+  /** @param capacity the number of batches that the queue holds at most, at least one */
+  explicit ResultQueue(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+  DISALLOW_COPY_AND_MOVE(ResultQueue);
+  ~ResultQueue() override = default;
+
+  /** Waits until the queue has room for the batch, or the reader cancels. */
+  bool Consume(TupleBatch *batch) override;
+
+  void Finish() override;
+
+  /**
+   * Takes the next batch of the output, in the reader's thread, waiting until there is one.
+   * @param[out] batch the batch
+   * @return false if the output has ended
+   */
+  bool Pop(TupleBatch *batch);
+
+  /** Tells the query that the reader wants no more of the output, and drops the batches that are in the queue. */
+  void Cancel();
+
+  /** @return the number of batches that have been in the queue at once at most */
+  size_t GetPeakSize() const;
+
+ private:
+  const size_t capacity_;
+  mutable std::mutex latch_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<TupleBatch> batches_;
+  size_t peak_size_{0};
+  bool finished_{false};
+  bool cancelled_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// session.h
+//
+// Identification: src/include/execution/session.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catalog/simple_catalog.h"
+#include "common/bustub_instance.h"
+#include "execution/executor_context.h"
+#include "execution/plan_cache.h"
+#include "execution/result_cache.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** A statement of a batch: a plan that the session prepared, and the values of its parameters. */
+struct Statement {
+  PreparedPlan *plan_;
+  std::vector<Value> params_;
+};
+
+/** What became of a statement of a batch. */
+enum class StatementStatus : uint8_t {
+  OK,       // it ran, and its tuples are the output
+  ABORTED,  // its transaction aborted while it ran, e.g. on a lock conflict, or it failed with the error
+  SKIPPED,  // an earlier statement of the batch aborted the transaction, so it did not run
+};
+
+/** The result of a statement of a batch. */
+struct StatementResult {
+  StatementStatus status_{StatementStatus::SKIPPED};
+  /** The message of the exception that the statement failed with, empty if none. */
+  std::string error_;
+  /** The output of the statement, e.g. the rows of a scan or the count of an insert. */
+  std::vector<Tuple> tuples_;
+};
+
+/**
+ * Session is the state of a client of a BustubInstance: its transaction, an executor context that runs its statements
+ * and a cache of the plans that it prepared. Every client has a session of its own, so that any number of them run at
+ * once; a session itself is used by one thread at a time.
+ *
+ * A client sends its statements a batch at a time, see ExecuteBatch(), so that a transaction of several statements
+ * takes one round trip rather than one per statement. A batch runs in the transaction that the client began, or in a
+ * transaction of its own that commits once the batch is done.
+ */
+class Session {
+ public:
+  /**
+   * Creates a new session.
+   * @param instance the instance whose transaction manager, buffer pool and scheduler the session uses
+   * @param catalog the catalog of the tables that the statements read and write
+   * @param plan_cache_size the number of prepared plans that the session keeps
+   */
+  Session(BustubInstance *instance, SimpleCatalog *catalog, size_t plan_cache_size = SESSION_PLAN_CACHE_SIZE);
+
+  /** Aborts the transaction of the session, if any. */
+  ~Session();
+
+  DISALLOW_COPY_AND_MOVE(Session);
+
+  /**
+   * Begins a transaction that the following batches run in, until Commit() or Abort(). Does nothing if one is open.
+   * @param isolation_level the isolation level of the transaction
+   */
+  void Begin(IsolationLevel isolation_level = IsolationLevel::REPEATABLE_READ);
+
+  /**
+   * Commits the transaction of the session.
+   * @return false if there was none, or it aborted instead, e.g. an optimistic transaction that conflicted
+   */
+  bool Commit();
+
+  /** Aborts the transaction of the session, if any. */
+  void Abort();
+
+  /** @return true if the client began a transaction that is still open */
+  bool InTransaction() const { return txn_ != nullptr; }
+
+  /**
+   * Prepares a plan for the statements of the session, see PlanCache::Prepare().
+   * @return the prepared plan, which stays valid until the session drops it from its cache in a later Prepare()
+   */
+  PreparedPlan *Prepare(std::unique_ptr<PreparedPlan> &&plan) { return plan_cache_.Prepare(std::move(plan)); }
+
+  /**
+   * Runs a batch of statements one after the other. Once a statement aborts the transaction, the following ones are
+   * skipped; the transaction is aborted, also one that the client began.
+   * @param statements the statements, whose plans were prepared by this session
+   * @param[out] results the result of each statement, in their order
+   * @return false if the transaction of the batch aborted
+   */
+  bool ExecuteBatch(const std::vector<Statement> &statements, std::vector<StatementResult> *results);
+
+  /**
+   * Serves the results of the statements from a result cache, see ResultCache::Execute(), which may be shared with
+   * other sessions.
+   * @param cache the cache, which outlives the session, nullptr to run every statement
+   */
+  void SetResultCache(ResultCache *cache) { result_cache_ = cache; }
+
+  /** @return the executor context of the statements, e.g. to set their parallelism */
+  ExecutorContext *GetExecutorContext() { return &exec_ctx_; }
+
+  /** @return the catalog of the session */
+  SimpleCatalog *GetCatalog() { return catalog_; }
+
+ private:
+  /** Ends the transaction of the session, which committed or aborted. */
+  void EndTransaction();
+
+  BustubInstance *instance_;
+  SimpleCatalog *catalog_;
+  ExecutorContext exec_ctx_;
+  PlanCache plan_cache_;
+  /** The cache of the results of the statements, nullptr if they always run. */
+  ResultCache *result_cache_{nullptr};
+  /** The open transaction, nullptr if there is none. */
+  Transaction *txn_{nullptr};
+};
+
+}  // namespace bustub
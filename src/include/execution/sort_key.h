@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_key.h
+//
+// Identification: src/include/execution/sort_key.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/plans/sort_plan.h"
+#include "storage/index/key_normalizer.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * SortKey normalizes the sort keys of a tuple into a string of bytes that compares, byte by byte, like the tuple
+ * compares by its keys, so that sorting compares strings instead of going through Value for every key. The keys are
+ * normalized by KeyNormalizer, a descending key having every byte flipped.
+ */
+class SortKey {
+ public:
+  /** @return the normalized keys of a tuple of a schema */
+  static std::string Make(const Tuple &tuple, const Schema *schema, const std::vector<OrderBy> &order_bys);
+
+  /** Appends the normalized form of a value to a key. */
+  static void Append(const Value &value, OrderByType type, std::string *key);
+};
+
+/**
+ * LoserTree picks the smallest of the heads of k sorted inputs, e.g. the runs of an external sort, at the cost of
+ * about log2(k) comparisons per pick. Each inner node of the tree holds the input that lost the match played there,
+ * so that once the winner moves on to its next head, only the matches on its path to the root are replayed.
+ * @tparam Less called as less(i, j), true if the head of input i comes before the head of input j; an input that is
+ * done comes after every other
+ */
+template <class Less>
+class LoserTree {
+ public:
+  LoserTree(size_t num_inputs, Less less) : less_(std::move(less)), losers_(num_inputs) {
+    winner_ = num_inputs == 0 ? 0 : Play(1);
+  }
+
+  /** @return the input whose head comes first */
+  size_t GetWinner() const { return winner_; }
+
+  /** Replays the matches of the winner, once its head has changed. */
+  void Update() {
+    const size_t num_inputs = losers_.size();
+    size_t winner = winner_;
+    for (size_t node = (winner + num_inputs) / 2; node >= 1; node /= 2) {
+      if (less_(losers_[node], winner)) {
+        std::swap(losers_[node], winner);
+      }
+    }
+    winner_ = winner;
+  }
+
+ private:
+  /** Plays the matches of the subtree at a node, inputs are the leaves num_inputs on. @return its winner */
+  size_t Play(size_t node) {
+    const size_t num_inputs = losers_.size();
+    if (node >= num_inputs) {
+      return node - num_inputs;
+    }
+    const size_t left = Play(2 * node);
+    const size_t right = Play(2 * node + 1);
+    if (less_(right, left)) {
+      losers_[node] = left;
+      return right;
+    }
+    losers_[node] = right;
+    return left;
+  }
+
+  Less less_;
+  /** The loser of the match at each inner node, 1 on; a tree of one input has no inner node. */
+  std::vector<size_t> losers_;
+  size_t winner_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,244 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_batch.h
+//
+// Identification: src/include/execution/tuple_batch.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+#include "type/arena_pool.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * TupleBatch holds up to EXECUTOR_BATCH_SIZE rows of a schema, column by column, which is what executors pass each
+ * other with AbstractExecutor::NextBatch(). A selection vector names the rows of the batch that are live: filters drop
+ * rows by shrinking it instead of moving the values around, and whoever reads the batch only reads the selected rows.
+ *
+ * A batch of the tuples of a table may also keep where each of them is in the table, see KeepRids().
+ *
+ * The varlen data of the values that the batch reads from tuples is borrowed from a pool of the batch, which lets go
+ * of all of it at once when the batch is emptied. A copy of such a value owns its data, so that values may be taken
+ * out of the batch as usual, but a reference to one is only good until the batch is emptied.
+ */
+class TupleBatch {
+ public:
+  /** Creates an empty batch without columns. */
+  TupleBatch() = default;
+
+  /** Creates an empty batch of a schema. */
+  explicit TupleBatch(const Schema *schema) { Reset(schema); }
+
+  /** Copies a batch, whose values own their data in the copy. */
+  TupleBatch(const TupleBatch &other)
+      : schema_(other.schema_),
+        columns_(other.columns_),
+        selection_(other.selection_),
+        keep_rids_(other.keep_rids_),
+        rids_(other.rids_),
+        num_rows_(other.num_rows_) {}
+
+  TupleBatch &operator=(const TupleBatch &other) {
+    if (this != &other) {
+      TupleBatch clone(other);
+      *this = std::move(clone);
+    }
+    return *this;
+  }
+
+  TupleBatch(TupleBatch &&other) = default;
+  TupleBatch &operator=(TupleBatch &&other) = default;
+  ~TupleBatch() = default;
+
+  /** Empties the batch and gives it the columns of a schema, none for nullptr. */
+  void Reset(const Schema *schema) {
+    schema_ = schema;
+    columns_.resize(schema == nullptr ? 0 : schema->GetColumnCount());
+    Clear();
+  }
+
+  /** Empties the batch, which keeps its schema. */
+  void Clear() {
+    for (auto &column : columns_) {
+      column.clear();
+    }
+    selection_.clear();
+    rids_.clear();
+    num_rows_ = 0;
+    pool_.Reset();
+  }
+
+  /**
+   * Makes the empty batch keep the rid of each tuple that it takes from now on, see GetRid(), or stop keeping them.
+   * The setting outlives Reset() and Clear().
+   */
+  void KeepRids(bool keep) {
+    keep_rids_ = keep;
+    rids_.clear();
+  }
+
+  /** @return true if the batch keeps the rids of its rows */
+  bool KeepsRids() const { return keep_rids_; }
+
+  /** @return the rid of a row, of a batch that keeps them */
+  const RID &GetRid(uint32_t row) const { return rids_[row]; }
+
+  /** @return the pool whose memory the varlen data of the values of the batch may borrow until it is emptied */
+  AbstractPool *GetPool() { return &pool_; }
+
+  /** @return the schema of the rows */
+  const Schema *GetSchema() const { return schema_; }
+
+  /** @return the number of rows in the batch, selected or not */
+  size_t GetNumRows() const { return num_rows_; }
+
+  /** @return the number of selected rows */
+  size_t GetSize() const { return selection_.size(); }
+
+  /** @return true if no row is selected */
+  bool IsEmpty() const { return selection_.empty(); }
+
+  /** @return true if the batch takes no more rows */
+  bool IsFull() const { return num_rows_ >= static_cast<size_t>(EXECUTOR_BATCH_SIZE); }
+
+  /** @return the indexes of the selected rows, in increasing order */
+  const std::vector<uint32_t> &GetSelection() const { return selection_; }
+
+  /** @return the values of a column, one per row, selected or not */
+  const std::vector<Value> &GetColumn(uint32_t col_idx) const { return columns_[col_idx]; }
+
+  /** @return the value of a column of a row */
+  const Value &GetValue(uint32_t col_idx, uint32_t row) const { return columns_[col_idx][row]; }
+
+  /** @return a row as a tuple of the schema */
+  Tuple GetTuple(uint32_t row) const {
+    Tuple tuple;
+    GetTuple(row, &tuple);
+    return tuple;
+  }
+
+  /** Writes a row as a tuple of the schema into a tuple, reusing its buffer if it is large enough. */
+  void GetTuple(uint32_t row, Tuple *tuple) const {
+    std::vector<Value> values;
+    values.reserve(columns_.size());
+    // The values are only read into the tuple, so views of them spare the copies of their strings.
+    for (const auto &column : columns_) {
+      values.push_back(column[row].GetView());
+    }
+    tuple->SetValues(values, schema_);
+    tuple->SetRid(keep_rids_ ? rids_[row] : RID());
+  }
+
+  /** Appends a selected row, which has one value per column. */
+  void AppendRow(std::vector<Value> &&values) {
+    for (size_t i = 0; i < columns_.size(); i++) {
+      columns_[i].push_back(std::move(values[i]));
+    }
+    selection_.push_back(static_cast<uint32_t>(num_rows_++));
+  }
+
+  /** Appends a tuple of the schema as a selected row. */
+  void AppendTuple(const Tuple &tuple) {
+    for (size_t i = 0; i < columns_.size(); i++) {
+      columns_[i].push_back(tuple.GetValue(schema_, i, &pool_));
+    }
+    if (keep_rids_) {
+      rids_.push_back(tuple.GetRid());
+    }
+    selection_.push_back(static_cast<uint32_t>(num_rows_++));
+  }
+
+  /**
+   * Appends a tuple of the schema as a selected row, of which only some columns are read. The other columns are left
+   * out, so the batch may only go to readers of the given columns, e.g. expressions on them.
+   * @param tuple the tuple
+   * @param col_idxs the columns to read
+   */
+  void AppendColumns(const Tuple &tuple, const std::vector<uint32_t> &col_idxs) {
+    for (uint32_t col_idx : col_idxs) {
+      columns_[col_idx].push_back(tuple.GetValue(schema_, col_idx, &pool_));
+    }
+    if (keep_rids_) {
+      rids_.push_back(tuple.GetRid());
+    }
+    selection_.push_back(static_cast<uint32_t>(num_rows_++));
+  }
+
+  /**
+   * Appends selected rows of which only some columns are read, see AppendColumns(), a column at a time.
+   * @param col_idxs the columns to read
+   * @param num_rows the number of rows
+   * @param read called as read(col_idx, &column) for each of the columns, appends the num_rows values of the column
+   * @param read_rids called as read_rids(&rids) if the batch keeps rids, appends the num_rows rids of the rows
+   */
+  template <class Read, class ReadRids>
+  void AppendColumnValues(const std::vector<uint32_t> &col_idxs, size_t num_rows, Read &&read, ReadRids &&read_rids) {
+    for (uint32_t col_idx : col_idxs) {
+      read(col_idx, &columns_[col_idx]);
+    }
+    if (keep_rids_) {
+      read_rids(&rids_);
+    }
+    for (size_t i = 0; i < num_rows; i++) {
+      selection_.push_back(static_cast<uint32_t>(num_rows_++));
+    }
+  }
+
+  /**
+   * Replaces the rows of the batch by whole columns, all of whose rows are selected and which keep no rids.
+   * @param columns one column per column of the schema, each of num_rows values
+   * @param num_rows the number of rows, which counts even if the schema has no columns
+   */
+  void Assign(std::vector<std::vector<Value>> &&columns, size_t num_rows) {
+    columns_ = std::move(columns);
+    keep_rids_ = false;
+    rids_.clear();
+    num_rows_ = num_rows;
+    selection_.resize(num_rows);
+    for (size_t i = 0; i < num_rows; i++) {
+      selection_[i] = static_cast<uint32_t>(i);
+    }
+  }
+
+  /**
+   * Keeps the selected rows for which a condition holds.
+   * @param keep called as keep(i) for the i'th selected row, in order
+   */
+  template <class Keep>
+  void Filter(Keep &&keep) {
+    size_t num_kept = 0;
+    for (size_t i = 0; i < selection_.size(); i++) {
+      if (keep(i)) {
+        selection_[num_kept++] = selection_[i];
+      }
+    }
+    selection_.resize(num_kept);
+  }
+
+ private:
+  const Schema *schema_{nullptr};
+  std::vector<std::vector<Value>> columns_;
+  std::vector<uint32_t> selection_;
+  /** The rid of each row, if the batch keeps them. */
+  bool keep_rids_{false};
+  std::vector<RID> rids_;
+  size_t num_rows_{0};
+  /** The varlen data of the values that the batch reads from tuples. */
+  ArenaPool pool_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_replica.h
+//
+// Identification: src/include/network/log_replica.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "common/bustub_instance.h"
+#include "common/macros.h"
+#include "recovery/log_recovery.h"
+
+namespace bustub {
+
+/**
+ * LogReplica keeps a read-only copy of a primary, by applying the log that the LogShipper of the primary streams to
+ * it, so that reports can read from the replica rather than load the primary. The replica writes the log to its own
+ * log file as it arrives, and replays it into its buffer pool with the parallel redo of LogRecovery.
+ *
+ * Readers see snapshots of the primary: the log is applied up to points where no transaction of the primary was
+ * running, so that a reader sees none of the writes of transactions that had not committed yet. A replica that would
+ * hold back more than REPLICA_MAX_APPLY_LAG bytes of log that way, under a long transaction, applies all of it.
+ *
+ * The replica instance must start out empty, and nothing but the replica may write to it. It runs in a process where
+ * logging is off, like recovery does, so not in the process of its primary. Only the table pages are replicated, not
+ * the catalog: readers open the tables by their first pages, see TableHeap.
+ */
+class LogReplica {
+ public:
+  /**
+   * @param instance the instance that the log is applied to, whose database and log files start out empty, and whose
+   * log is not compressed, so that the offsets of the records in its log file are those that the replica scans
+   * @param log_buffer_size the size of the buffers that the log is received and applied in, at least that of the log
+   * manager of the primary
+   */
+  explicit LogReplica(BustubInstance *instance, size_t log_buffer_size = LOG_BUFFER_SIZE);
+
+  /** Disconnects from the primary. */
+  ~LogReplica() { Stop(); }
+
+  DISALLOW_COPY_AND_MOVE(LogReplica);
+
+  /**
+   * Connects to the LogShipper of the primary, and starts applying the log that it streams.
+   * @param address the IPv4 address of the primary
+   * @param port the port that the shipper listens on
+   * @return false if the primary could not be connected to
+   */
+  bool Start(const std::string &address, uint16_t port);
+
+  /** Disconnects from the primary, once the log that arrived so far is applied. */
+  void Stop();
+
+  /** @return true while the replica is connected to the primary */
+  bool IsConnected() const { return connected_; }
+
+  /**
+   * Locks the replica for a reader: no log is applied while the lock is held, so that all of the reads under it see
+   * the same snapshot of the primary.
+   * @return the lock, which the reader releases when it is done
+   */
+  std::shared_lock<std::shared_mutex> LockSnapshot() { return std::shared_lock(apply_latch_); }
+
+  /** @return the LSN of the last record of the primary that was applied, INVALID_LSN if none was */
+  lsn_t GetAppliedLSN() {
+    std::scoped_lock lock(latch_);
+    return applied_lsn_;
+  }
+
+  /**
+   * Waits until the log of the primary is applied up to a record, e.g. to read the writes of a transaction that
+   * committed on the primary.
+   * @param lsn the LSN of the record, e.g. the persistent LSN of the primary after the commit
+   * @param timeout how long to wait at most
+   * @return false if the record was not applied in time, or the replica disconnected before
+   */
+  bool WaitForLSN(lsn_t lsn, std::chrono::milliseconds timeout);
+
+ private:
+  /** Receives the log, writes it to the log file and applies it, until the primary disconnects. */
+  void RunReceiver();
+
+  /** Parses the records of received log, to find the points where no transaction of the primary was running. */
+  void ScanLog(const char *data, size_t size);
+
+  BustubInstance *instance_;
+  const size_t log_buffer_size_;
+  LogRecovery recovery_;
+  int fd_{-1};
+  std::thread receiver_;
+  std::atomic<bool> connected_{false};
+  /** Held in write mode while log is applied, and in read mode by the readers. */
+  std::shared_mutex apply_latch_;
+  /** Protects applied_lsn_. */
+  std::mutex latch_;
+  /** Signals a change of applied_lsn_ or of connected_ to WaitForLSN(). */
+  std::condition_variable applied_cv_;
+  lsn_t applied_lsn_{INVALID_LSN};
+
+  // The state of the receiver thread. The offsets are in the log file of the replica.
+  /** The start of a record that the log received so far ends in. */
+  std::vector<char> partial_record_;
+  /** The transactions of the primary that are running as of the scanned records. */
+  std::unordered_set<txn_id_t> active_txns_;
+  /** The offset after the scanned records, and the LSN of the last one. */
+  int64_t scanned_offset_{0};
+  lsn_t scanned_lsn_{INVALID_LSN};
+  /** The offset after the last scanned record that no transaction was running at, and the LSN of that record. */
+  int64_t consistent_offset_{0};
+  lsn_t consistent_lsn_{INVALID_LSN};
+  /** The offset that the log is applied up to. */
+  int64_t applied_offset_{0};
+};
+
+}  // namespace bustub
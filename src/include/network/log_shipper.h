@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_shipper.h
+//
+// Identification: src/include/network/log_shipper.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "common/macros.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * LogShipper streams the log of a primary to its replicas over TCP, see LogReplica. A replica that connects first
+ * gets the log file from its beginning, and then every log buffer that the log manager writes, as it writes it. The
+ * stream is the log records as they were appended, without compression, with nothing else in between.
+ *
+ * A replica starts out empty, so the primary must still have its whole log: once a checkpoint truncated it, there is
+ * no base backup to start a replica from, and the shipper turns replicas away. A replica that falls behind by
+ * LOG_SHIPPER_MAX_BACKLOG bytes is disconnected rather than holding on to the log buffers of the primary.
+ */
+class LogShipper {
+ public:
+  /**
+   * @param disk_manager the disk manager of the primary, that the log file is read with
+   * @param log_manager the log manager of the primary, whose log buffer writes are shipped
+   */
+  LogShipper(DiskManager *disk_manager, LogManager *log_manager)
+      : disk_manager_(disk_manager), log_manager_(log_manager) {}
+
+  /** Stops the shipper. */
+  ~LogShipper() { Stop(); }
+
+  DISALLOW_COPY_AND_MOVE(LogShipper);
+
+  /**
+   * Starts listening for replicas, and shipping the log buffers that the log manager writes.
+   * @param port the TCP port to listen on, 0 for any free one, see GetPort()
+   * @param address the IPv4 address to listen on
+   * @return false if the port could not be listened on
+   */
+  bool Start(uint16_t port, const std::string &address = "127.0.0.1");
+
+  /** @return the port that the shipper listens on */
+  uint16_t GetPort() const { return port_; }
+
+  /** Stops listening and shipping, and closes the connections of the replicas. */
+  void Stop();
+
+  /** @return the number of replicas that are connected */
+  size_t GetNumReplicas();
+
+ private:
+  /** A replica connection, the thread that ships the log to it, and the log buffers that wait to be shipped. */
+  struct Replica {
+    int fd_{-1};
+    std::thread thread_;
+    /** True once the replica disconnected, and the thread is done. */
+    std::atomic<bool> done_{false};
+    /** The log buffers written since the replica connected, each with the offset in the log file after it. */
+    std::deque<std::pair<std::shared_ptr<const std::string>, int64_t>> queue_;
+    /** The bytes of the buffers in queue_. */
+    size_t queued_bytes_{0};
+    /** True once the replica fell behind by LOG_SHIPPER_MAX_BACKLOG bytes. */
+    bool dropped_{false};
+  };
+
+  /** Queues a log buffer that the log manager wrote for every replica, see LogManager::LogListener. */
+  void Enqueue(const char *data, size_t size, int64_t end_offset);
+
+  /** Accepts replicas until the shipper stops, and closes those that disconnected. */
+  void RunListener();
+
+  /** Sends the log file and then the queued log buffers to a replica, until it disconnects or the shipper stops. */
+  void Serve(Replica *replica);
+
+  DiskManager *disk_manager_;
+  LogManager *log_manager_;
+  int listen_fd_{-1};
+  uint16_t port_{0};
+  std::thread listener_;
+  /** Protects replicas_, their queues and stop_. It is taken while the log manager holds its latch. */
+  std::mutex latch_;
+  /** Signals queued log buffers, and stop_, to the replica threads. */
+  std::condition_variable cv_;
+  bool stop_{false};
+  std::list<Replica> replicas_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// session_server.h
+//
+// Identification: src/include/network/session_server.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "execution/session.h"
+
+namespace bustub {
+
+/**
+ * SessionServer lets clients run statements over TCP, each connection with a Session of its own. There is no SQL: the
+ * application registers its statements by name, as functions that make their plans, and the clients run them by name
+ * with the values of their parameters.
+ *
+ * The protocol is text, a line at a time. A client sends a batch of lines that ends with an empty line, and gets a
+ * batch of response lines back that ends with an empty line, so that a whole transaction takes one round trip:
+ *
+ * - "BEGIN", "COMMIT" and "ABORT" control the transaction of the session, see Session::Begin(); they answer "OK",
+ *   except for a commit that aborted instead, which answers "ABORTED";
+ * - any other line is the name of a statement and the values of its parameters, separated by tabs, as text that is
+ *   cast to the types of the parameters. The statements between two control lines run as one Session::ExecuteBatch().
+ *   A statement answers "OK <n>" and the n rows of its output, with tabs between the values; "ABORTED <error>" if its
+ *   transaction aborted; "SKIPPED" if an earlier one did; and "ERROR <error>" if the line is not a statement, which is
+ *   then ignored.
+ *
+ * A client that sends a line or a batch longer than the limits of the server, or that connects while the server has as
+ * many connections as it allows, gets a batch of a single "ERROR <error>" line, and is disconnected. The batch that
+ * was being sent does not run, and an open transaction of the session aborts.
+ */
+class SessionServer {
+ public:
+  /** Makes the plan of a statement, with a parameter for each value that the clients send. */
+  using PlanFactory = std::function<std::unique_ptr<PreparedPlan>()>;
+
+  /**
+   * @param instance the instance that the sessions use
+   * @param catalog the catalog that the sessions use
+   * @param max_connections the number of clients that are served at once
+   * @param max_line_size the size of a request line in bytes, without its newline
+   * @param max_batch_lines the number of lines of a request batch, without its empty line
+   */
+  SessionServer(BustubInstance *instance, SimpleCatalog *catalog, size_t max_connections = SESSION_MAX_CONNECTIONS,
+                size_t max_line_size = SESSION_MAX_LINE_SIZE, size_t max_batch_lines = SESSION_MAX_BATCH_LINES)
+      : instance_(instance),
+        catalog_(catalog),
+        max_connections_(max_connections),
+        max_line_size_(max_line_size),
+        max_batch_lines_(max_batch_lines) {}
+
+  /** Stops the server. */
+  ~SessionServer() { Stop(); }
+
+  DISALLOW_COPY_AND_MOVE(SessionServer);
+
+  /** Registers a statement that the clients may run, before the server starts. */
+  void RegisterStatement(const std::string &name, PlanFactory factory) { statements_[name] = std::move(factory); }
+
+  /**
+   * Starts listening for clients.
+   * @param port the TCP port to listen on, 0 for any free one, see GetPort()
+   * @param address the IPv4 address to listen on
+   * @return false if the port could not be listened on
+   */
+  bool Start(uint16_t port, const std::string &address = "127.0.0.1");
+
+  /** @return the port that the server listens on */
+  uint16_t GetPort() const { return port_; }
+
+  /** Stops listening, and closes the connections, once the batches that are running are done. */
+  void Stop();
+
+  /**
+   * Runs a batch of request lines for a session, as if a client sent them, see the protocol above.
+   * @param session the session of the client
+   * @param plans the plans that the session prepared for the statements so far, by name
+   * @param lines the lines of the batch, without the empty line at the end
+   * @return the lines of the response, without the empty line at the end
+   */
+  std::vector<std::string> RunBatch(Session *session, std::unordered_map<std::string, PreparedPlan *> *plans,
+                                    const std::vector<std::string> &lines) const;
+
+ private:
+  /** A client connection and the thread that serves it. */
+  struct Connection {
+    int fd_{-1};
+    std::thread thread_;
+    /** True once the client disconnected, and the thread is done. */
+    std::atomic<bool> done_{false};
+  };
+
+  /** Accepts connections until the server stops, and closes those whose clients disconnected. */
+  void RunListener();
+
+  /** Serves the batches of a client until it disconnects, the server stops, or the client exceeds a limit. */
+  void Serve(Connection *connection) const;
+
+  BustubInstance *instance_;
+  SimpleCatalog *catalog_;
+  const size_t max_connections_;
+  const size_t max_line_size_;
+  const size_t max_batch_lines_;
+  std::unordered_map<std::string, PlanFactory> statements_;
+  int listen_fd_{-1};
+  uint16_t port_{0};
+  std::thread listener_;
+  /** Protects connections_. */
+  std::mutex latch_;
+  std::list<Connection> connections_;
+};
+
+}  // namespace bustub
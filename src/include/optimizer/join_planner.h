@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_planner.h
+//
+// Identification: src/include/optimizer/join_planner.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "catalog/simple_catalog.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/** A column of the output of a join that a JoinPlanner plans: a column of the outer side or of the inner table. */
+struct JoinOutputColumn {
+  /** The side of the column. */
+  enum class Side { OUTER, INNER };
+  Side side_;
+  /** The column, of the output schema of the outer plan or of the schema of the inner table. */
+  uint32_t col_idx_;
+};
+
+/**
+ * JoinPlanner plans the equi-join of a plan, the outer side, with a table, the inner side, by the statistics of the
+ * tables, see TableStatistics. It weighs an IndexNestedLoopJoinPlanNode that probes an index of the inner table once
+ * per outer row against a HashJoinPlanNode that scans the inner table, and builds the hash join on whichever of the two
+ * sides it estimates to be the smaller. The estimate of the build side goes into the plan, so that the executor can
+ * check it, see HashJoinExecutor.
+ *
+ * The planner owns the plans, schemas and expressions that it makes, which must not outlive it.
+ */
+class JoinPlanner {
+ public:
+  /** The cost of reading a tuple of the inner table in a scan. */
+  static constexpr double SCAN_COST = 1.0;
+  /** The cost of adding a row to the hash table of a join, and of probing the table with one. */
+  static constexpr double HASH_BUILD_COST = 2.0;
+  static constexpr double HASH_PROBE_COST = 1.0;
+  /** The cost of a lookup in an index, and of reading a tuple that it found, at random. */
+  static constexpr double INDEX_PROBE_COST = 4.0;
+  static constexpr double INDEX_FETCH_COST = 2.0;
+
+  /** Creates a new join planner that looks tables, indexes and statistics up in a catalog. */
+  explicit JoinPlanner(SimpleCatalog *catalog) : catalog_(catalog) {}
+
+  /**
+   * Estimates the number of rows that a plan produces: a scan by the statistics of its table, a limit by its limit,
+   * and anything else by the largest of its children.
+   * @param plan the plan
+   * @return the estimated number of rows
+   */
+  double EstimateRows(const AbstractPlanNode *plan) const;
+
+  /**
+   * Plans an equi-join.
+   * @param outer the plan of the outer side
+   * @param outer_key_col the join key, a column of the output schema of the outer plan
+   * @param inner_table_oid the inner table
+   * @param inner_key_col the join key, a column of the inner table
+   * @param inner_predicate the predicate that the tuples of the inner table must pass, on the tuple of the inner table
+   * as the right tuple (index 1), nullptr for none
+   * @param output_columns the columns of the output
+   * @return the plan of the join, either an IndexNestedLoopJoinPlanNode or a HashJoinPlanNode
+   */
+  const AbstractPlanNode *PlanJoin(const AbstractPlanNode *outer, uint32_t outer_key_col, table_oid_t inner_table_oid,
+                                   uint32_t inner_key_col, const AbstractExpression *inner_predicate,
+                                   const std::vector<JoinOutputColumn> &output_columns);
+
+ private:
+  /** @return a column value expression that the planner owns */
+  const AbstractExpression *MakeColumnValue(uint32_t tuple_idx, uint32_t col_idx, const Schema *schema);
+
+  /** @return a schema that the planner owns */
+  const Schema *MakeSchema(std::vector<Column> &&columns);
+
+  SimpleCatalog *catalog_;
+  std::vector<std::unique_ptr<AbstractPlanNode>> plans_;
+  std::vector<std::unique_ptr<AbstractExpression>> exprs_;
+  std::vector<std::unique_ptr<Schema>> schemas_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// backup_manager.h
+//
+// Identification: src/include/recovery/backup_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * BackupManager copies a database while it is being written, without blocking transactions or checkpoints.
+ *
+ * The pages are copied straight from the database file, so each of them is as old as the last time it was written
+ * back, or newer. The copy is made consistent by the log: a backup keeps the log from being truncated while it runs,
+ * and copies the log from the last checkpoint up to where it ended once the pages are copied. The write-ahead rule
+ * puts every change that a copied page holds in that range of the log, so that recovery on the copy, see LogRecovery,
+ * brings every page to the end of the range, redoing the changes that the copy missed and undoing the transactions
+ * that had not committed by then.
+ *
+ * A page is read again while it does not match its checksum, i.e. while it is read halfway through a write. The pages
+ * and the log are copied at a limited rate, so that a backup leaves most of the bandwidth of the drive to the queries.
+ */
+class BackupManager {
+ public:
+  /** @param disk_manager the disk manager of the database to back up */
+  explicit BackupManager(DiskManager *disk_manager) : disk_manager_(disk_manager) {}
+
+  /**
+   * Copies the database into the database file of another disk manager, which should be new, and writes its log and
+   * master record. The copy is recovered like after a crash: it is opened, and redone and undone by LogRecovery.
+   * @param target the disk manager of the copy
+   * @param bytes_per_second the bytes of pages and log that are copied per second at most, 0 for no limit
+   * @return false if a page could not be read without a write tearing it, or the log could not be copied. The copy
+   * is not usable then.
+   */
+  bool Backup(DiskManager *target, int64_t bytes_per_second = BACKUP_BYTES_PER_SECOND);
+
+  /** @return the number of pages that the last backup copied */
+  int64_t GetNumPagesCopied() const { return num_pages_copied_; }
+
+  /** @return the offsets in the log that the last backup copied from and up to, i.e. the point the copy restores to */
+  int64_t GetLogStartOffset() const { return log_start_offset_; }
+  int64_t GetLogEndOffset() const { return log_end_offset_; }
+
+ private:
+  /** Sleeps until the bytes copied so far are within the rate of the backup. */
+  void Throttle(int64_t bytes);
+
+  /** Copies a page into the copy, reading it again while it does not match its checksum. */
+  bool CopyPage(DiskManager *target, page_id_t page_id, char *page_data);
+
+  /** Starts the log of the copy over at begin, the start of a segment, and copies the log up to end into it. */
+  bool CopyLog(DiskManager *target, int64_t begin, int64_t end);
+
+  DiskManager *disk_manager_;
+  int64_t num_pages_copied_{0};
+  int64_t log_start_offset_{0};
+  int64_t log_end_offset_{0};
+
+  /** The rate of the running backup, when it started, and the bytes that it copied. */
+  int64_t bytes_per_second_{0};
+  std::chrono::steady_clock::time_point start_time_;
+  int64_t num_bytes_copied_{0};
+};
+
+}  // namespace bustub
@@ -12,6 +12,11 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction_manager.h"
 #include "recovery/log_manager.h"
@@ -19,7 +24,12 @@
 namespace bustub {
 
 /**
- * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily.
+ * CheckpointManager creates fuzzy checkpoints, which do not block transactions.
+ *
+ * A checkpoint logs a BEGIN_CHECKPOINT record with the active transaction table and the dirty page table, and makes
+ * it the one that recovery starts from once the record is on disk. Redo starts at the smallest recLSN of the dirty
+ * page table. The dirty pages are then written back in small batches by a background thread, so that the next
+ * checkpoint can start later in the log, and an END_CHECKPOINT record is logged once they are all written.
  */
 class CheckpointManager {
  public:
@@ -29,15 +39,42 @@ class CheckpointManager {
         log_manager_(log_manager),
         buffer_pool_manager_(buffer_pool_manager) {}
 
-  ~CheckpointManager() = default;
+  /** Stops writing back the pages of a running checkpoint, which leaves it without its END_CHECKPOINT record. */
+  ~CheckpointManager();
 
+  /**
+   * Takes a checkpoint and starts writing back its dirty pages in the background. A checkpoint that is still writing
+   * back its pages is ended first.
+   */
   void BeginCheckpoint();
+
+  /**
+   * Waits until the dirty pages of the checkpoint are written back, without pausing between the batches anymore, and
+   * logs END_CHECKPOINT. Returns once the record is on disk. Does nothing if no checkpoint is running.
+   */
   void EndCheckpoint();
 
  private:
-  TransactionManager *transaction_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /**
+   * Body of the background thread, writes back CHECKPOINT_FLUSH_BATCH pages every checkpoint_flush_interval.
+   * @param page_ids the dirty pages of the checkpoint
+   */
+  void WriteBackDirtyPages(std::vector<page_id_t> page_ids);
+
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+
+  /** The thread that writes back the dirty pages of the running checkpoint, nullptr if none is running. */
+  std::thread *write_back_thread_ = nullptr;
+  /** Protects the flags below. */
+  std::mutex latch_;
+  /** Wakes the background thread up early. */
+  std::condition_variable cv_;
+  /** True once the background thread should write the remaining pages without pausing. Protected by latch_. */
+  bool finish_requested_ = false;
+  /** True once the background thread should exit right away. Protected by latch_. */
+  bool stop_requested_ = false;
 };
 
 }  // namespace bustub
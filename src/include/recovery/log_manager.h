@@ -13,32 +13,80 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>              // NOLINT
 #include <condition_variable>  // NOLINT
+#include <functional>
 #include <future>              // NOLINT
+#include <map>
 #include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+#include <utility>
+#include <vector>
 
+#include "common/macros.h"
+#include "common/util/metrics.h"
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
+/**
+ * LogReadBuffer holds the log buffer that LogManager::ReadLogRecord() read back last, and where its records start, so
+ * that the records of a transaction that are read back one after the other read every log buffer once.
+ */
+struct LogReadBuffer {
+  /** The offset in the log file that the data was read at, -1 if none has been read. */
+  int64_t offset_{-1};
+  std::vector<char> data_;
+  /** The LSN of every record in the data and its position, in LSN order. */
+  std::vector<std::pair<lsn_t, size_t>> records_;
+};
+
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * Log records are appended to one of two log buffers. The flush thread swaps the buffers and writes the records with a
+ * single DiskManager::WriteLog while new records go to the other buffer. Committing transactions wait in
+ * WaitUntilPersistent and wake the flush thread up, so all the commits that arrive while a write is in progress share
+ * the next one (group commit).
+ *
+ * Appending takes no latch. A record reserves its LSN and its space in the buffer with a single compare-and-swap on
+ * reserve_state_, is serialized into the space in parallel with other appends, and is then counted as written. Before
+ * the buffers are swapped, the buffer is closed for reservations and the flush waits until all reserved space is
+ * written.
  */
 class LogManager {
  public:
-  explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+  /**
+   * Is called with every log buffer once it has been written, in the order of the writes, e.g. to ship the log to
+   * replicas. It is called while the log manager holds its latch, so it must not block.
+   * @param data the records of the buffer, as they were appended, even if the log file holds them compressed
+   * @param size the size of the records in byte
+   * @param end_offset the offset in the log file after the buffer
+   */
+  using LogListener = std::function<void(const char *data, size_t size, int64_t end_offset)>;
+
+  /**
+   * Creates a new LogManager.
+   * @param disk_manager the disk manager that the log is written with
+   * @param log_buffer_size the size of the log buffer and of the flush buffer in byte
+   */
+  explicit LogManager(DiskManager *disk_manager, size_t log_buffer_size = LOG_BUFFER_SIZE)
+      : persistent_lsn_(INVALID_LSN), log_buffer_size_(log_buffer_size), disk_manager_(disk_manager) {
+    BUSTUB_ASSERT(log_buffer_size_ <= OFFSET_MASK, "The log buffer is too large for the reservation state.");
+    log_buffers_[0] = new char[log_buffer_size_];
+    log_buffers_[1] = new char[log_buffer_size_];
+    // The log file is appended to, the first record goes after the ones of earlier runs.
+    open_buffer_offset_ = disk_manager_->GetLogSize();
+    buffer_offsets_.emplace(0, open_buffer_offset_);
   }
 
   ~LogManager() {
-    delete[] log_buffer_;
-    delete[] flush_buffer_;
-    log_buffer_ = nullptr;
-    flush_buffer_ = nullptr;
+    StopFlushThread();
+    delete[] log_buffers_[0];
+    delete[] log_buffers_[1];
   }
 
   void RunFlushThread();
@@ -46,29 +94,170 @@ class LogManager {
 
   lsn_t AppendLogRecord(LogRecord *log_record);
 
-  inline lsn_t GetNextLSN() { return next_lsn_; }
+  /**
+   * Blocks until the log records up to and including lsn are on disk. The flush thread is woken up right away, and
+   * the records of all waiters are written together. Without a flush thread, the caller writes the log buffer itself.
+   * @param lsn the log sequence number to wait for. LSNs that have not been handed out yet, e.g. the LSN that a page
+   * which is not a table page seems to have, are waited for as far as they have been.
+   */
+  void WaitUntilPersistent(lsn_t lsn);
+
+  /**
+   * Has the log records up to and including lsn written within async_commit_delay, without waiting for them unless
+   * more than async_commit_max_lag records are not on disk yet. Without a flush thread, only the lag is bounded.
+   * @param lsn the log sequence number of the commit record of an asynchronous commit
+   */
+  void PersistAsync(lsn_t lsn);
+
+  /**
+   * @param lsn the log sequence number of a record of this run
+   * @return the offset in the log file that reading has to start at to come across the record, the offset of the log
+   * buffer that it was appended to
+   */
+  int64_t GetLogOffset(lsn_t lsn);
+
+  /**
+   * Reads a record of this run back from the log file, e.g. to roll back the write that it logged. The records up to
+   * it are written first if they are not on disk yet.
+   * @param lsn the LSN of the record, which must be of a transaction that is running or after the last checkpoint
+   * @param[out] log_record the record, whose page image points into the buffer
+   * @param[in,out] buffer the log buffer that was read back last, which is read again only if it does not hold the
+   * record
+   * @return false if the record could not be read
+   */
+  bool ReadLogRecord(lsn_t lsn, LogRecord *log_record, LogReadBuffer *buffer);
+
+  /**
+   * Makes a checkpoint the one that recovery starts from, and truncates the log segments that recovery does not need
+   * anymore. Its record has to be on disk already.
+   * @param checkpoint_lsn the LSN of the BEGIN_CHECKPOINT record
+   * @param redo_lsn the LSN of the oldest record that may be missing from the database file
+   * @param undo_lsn the LSN of the oldest record of a transaction that was active at the checkpoint, at most redo_lsn
+   */
+  void SetCheckpoint(lsn_t checkpoint_lsn, lsn_t redo_lsn, lsn_t undo_lsn);
+
+  /**
+   * Sets the listener of the log buffer writes, see LogListener.
+   * @param listener the listener, nullptr to remove it
+   */
+  void SetLogListener(LogListener listener) {
+    std::scoped_lock lock(latch_);
+    log_listener_ = std::move(listener);
+  }
+
+  /** @return the number of times the log buffer was written to disk */
+  int GetNumLogFlushes() const { return num_log_flushes_; }
+
+  /**
+   * Adds the number, latency and size of the log buffer writes and the next and persistent LSNs to a snapshot, see
+   * MetricsRegistry.
+   * @param snapshot the snapshot to add the metrics to
+   */
+  void CollectMetrics(MetricsSnapshot *snapshot);
+
+  inline lsn_t GetNextLSN() { return GetLSN(reserve_state_.load()); }
   inline lsn_t GetPersistentLSN() { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
-  inline char *GetLogBuffer() { return log_buffer_; }
+  inline char *GetLogBuffer() { return log_buffers_[GetBufferIndex(reserve_state_.load())]; }
+  inline size_t GetLogBufferSize() { return log_buffer_size_; }
 
  private:
-  // TODO(students): you may add your own member variables
+  /*
+   * The reservation state packs, from the lowest bit up: the offset of the free space in the log buffer, the index of
+   * the log buffer, a flag that is set while the buffer is closed for a swap and the next LSN.
+   */
+  static constexpr uint64_t OFFSET_MASK = (uint64_t{1} << 31) - 1;
+  static constexpr int BUFFER_INDEX_SHIFT = 31;
+  static constexpr uint64_t CLOSED_FLAG = uint64_t{1} << 32;
+  static constexpr int LSN_SHIFT = 33;
+
+  static uint64_t MakeState(lsn_t lsn, bool closed, size_t buffer_index, size_t offset) {
+    return (static_cast<uint64_t>(lsn) << LSN_SHIFT) | (closed ? CLOSED_FLAG : 0) |
+           (static_cast<uint64_t>(buffer_index) << BUFFER_INDEX_SHIFT) | offset;
+  }
+  static size_t GetOffset(uint64_t state) { return state & OFFSET_MASK; }
+  static size_t GetBufferIndex(uint64_t state) { return (state >> BUFFER_INDEX_SHIFT) & 1; }
+  static bool IsClosed(uint64_t state) { return (state & CLOSED_FLAG) != 0; }
+  static lsn_t GetLSN(uint64_t state) { return static_cast<lsn_t>(state >> LSN_SHIFT); }
 
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  /**
+   * Serializes a log record into its reserved space.
+   * @param log_record the record, whose lsn_ is set
+   * @param data the reserved space of the record
+   */
+  static void SerializeLogRecord(LogRecord *log_record, char *data);
+
+  /**
+   * Waits until a log buffer that is full or closed has been swapped, asking the flush thread for the swap or doing it
+   * without one.
+   * @param state the reservation state that could not be used
+   */
+  void WaitForSpace(uint64_t state);
+
+  /**
+   * Body of the flush thread. Writes the log buffer whenever a flush is requested or log_timeout expires, or
+   * async_commit_delay after an asynchronous commit.
+   */
+  void RunFlusher();
+
+  /**
+   * Closes the log buffer, waits for the appends that reserved space in it, swaps the buffers and writes the closed one
+   * to disk, then advances persistent_lsn_. The lock is released during the write.
+   * @param lock the caller's lock on latch_
+   */
+  void FlushLogBuffer(std::unique_lock<std::mutex> *lock);
+
+  /** The next log sequence number and the space of the log buffer that has been reserved, see MakeState. */
+  std::atomic<uint64_t> reserve_state_{0};
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
-  char *log_buffer_;
-  char *flush_buffer_;
+  /** The size of each log buffer in byte. */
+  const size_t log_buffer_size_;
+  /** The log buffers. Records are appended to the one in reserve_state_, the other one is being written or empty. */
+  char *log_buffers_[2];
+  /** The number of bytes of the log buffers that have been written by appends. */
+  std::atomic<size_t> written_bytes_[2] = {};
 
+  /** Serializes the swaps of the log buffers, and protects the flags below. Appends do not take it. */
   std::mutex latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_ = nullptr;
 
+  /** Wakes up the flush thread, when a flush is requested or on shutdown. */
   std::condition_variable cv_;
+  /** Signalled after every write, for waiters on persistent_lsn_ and on space in the log buffer. */
+  std::condition_variable flushed_cv_;
+  /** True if somebody waits for the log buffer to be written. Protected by latch_. */
+  bool flush_requested_ = false;
+  /** True while a write of a log buffer is in progress. Protected by latch_. */
+  bool flush_in_progress_ = false;
+  /** True once the flush thread has been asked to exit. Protected by latch_. */
+  bool stop_flush_thread_ = false;
+  /** True if the log buffer holds the commit record of an asynchronous commit. Set under latch_. */
+  std::atomic<bool> async_flush_pending_{false};
+  /** When the log buffer has to be written for the asynchronous commits. Protected by latch_. */
+  std::chrono::steady_clock::time_point async_flush_deadline_;
+  std::atomic<int> num_log_flushes_{0};
+  /** Microseconds that the writes of the log buffers took. */
+  MetricHistogram flush_latency_us_;
+  /** Bytes that the writes of the log buffers wrote. */
+  MetricHistogram flush_bytes_;
+
+  /**
+   * The log file offset of the buffer that records are appended to, known once the other buffer is written. Protected
+   * by latch_.
+   */
+  int64_t open_buffer_offset_;
+  /**
+   * The log file offset of every log buffer since the last checkpoint, by the LSN of its first record. Protected by
+   * latch_.
+   */
+  std::map<lsn_t, int64_t> buffer_offsets_;
+  /** Is called after every write of a log buffer, see SetLogListener(). Protected by latch_. */
+  LogListener log_listener_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
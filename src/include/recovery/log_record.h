@@ -13,7 +13,10 @@
 #pragma once
 
 #include <cassert>
+#include <cstring>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "storage/table/tuple.h"
@@ -32,6 +35,19 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** A fuzzy checkpoint, with the active transaction table and the dirty page table at its start. */
+  BEGIN_CHECKPOINT,
+  /** The dirty pages of the preceding BEGIN_CHECKPOINT have been written back. */
+  END_CHECKPOINT,
+  /** The whole image of a table page that a bulk load filled, instead of a record per tuple. */
+  PAGEIMAGE,
+  /** Emptying a table heap, which keeps its first page and cuts off the pages after it, see TableHeap::Truncate. */
+  TRUNCATE,
+  /**
+   * A compensation log record, which ends the rollback of a write by an aborting transaction. The records that the
+   * rollback logged before it redo the rollback, undo skips from it to the write before the one that was rolled back.
+   */
+  CLR,
 };
 
 /**
@@ -49,18 +65,39 @@ enum class LogRecordType {
  *----------------------------------------------------------------
  * | HEADER | tuple_rid | tuple_size | tuple_data(char[] array) |
  *---------------------------------------------------------------
- * For update type log record
- *-----------------------------------------------------------------------------------
- * | HEADER | tuple_rid | tuple_size | old_tuple_data | tuple_size | new_tuple_data |
- *-----------------------------------------------------------------------------------
+ * For update type log record, the bytes that differ between the old and the new tuple (all sizes are 2 bytes). A range
+ * holds the XOR of the old and the new bytes, so it turns either tuple into the other. The tail is the end of the
+ * longer tuple past the length of the shorter one.
+ *-------------------------------------------------------------------------------------------------------------
+ * | HEADER | tuple_rid | old_size | new_size | num_ranges | (offset, length, xor_data) ... | tail_data |
+ *-------------------------------------------------------------------------------------------------------------
  * For new page type log record
- *--------------------------
- * | HEADER | prev_page_id |
- *--------------------------
+ *------------------------------------
+ * | HEADER | prev_page_id | page_id |
+ *------------------------------------
+ * For begin checkpoint type log record
+ *-----------------------------------------------------------------------------------------
+ * | HEADER | num_txns | (txn_id, last_lsn) ... | num_pages | (page_id, rec_lsn) ... |
+ *-----------------------------------------------------------------------------------------
+ * For page image type log record, the next page is the page that the bulk load continues on. Redo initializes it like
+ * a NEWPAGE record, so a page of a bulk load needs no record but its image.
+ *-------------------------------------------------------------
+ * | HEADER | page_id | next_page_id | page_data (PAGE_SIZE) |
+ *-------------------------------------------------------------
+ * For truncate type log record, laid out like a page image: the first page of the table and its image before the
+ * truncation, which undo copies back, and the page that followed it. Redo initializes the first page empty.
+ *-------------------------------------------------------------
+ * | HEADER | page_id | next_page_id | page_data (PAGE_SIZE) |
+ *-------------------------------------------------------------
+ * For compensation type log record, the LSN of the record that undo goes on with, INVALID_LSN if none is left
+ *------------------------------
+ * | HEADER | undo_next_lsn |
+ *------------------------------
  */
 class LogRecord {
   friend class LogManager;
   friend class LogRecovery;
+  friend class LogRecordView;
 
  public:
   LogRecord() = default;
@@ -85,30 +122,50 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(RID) + sizeof(int32_t) + tuple.GetLength();
   }
 
-  // constructor for UPDATE type
+  // constructor for UPDATE type, only the changed bytes are logged
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &update_rid,
-            const Tuple &old_tuple, const Tuple &new_tuple)
-      : txn_id_(txn_id),
-        prev_lsn_(prev_lsn),
-        log_record_type_(log_record_type),
-        update_rid_(update_rid),
-        old_tuple_(old_tuple),
-        new_tuple_(new_tuple) {
-    // calculate log record size
-    size_ = HEADER_SIZE + sizeof(RID) + old_tuple.GetLength() + new_tuple.GetLength() + 2 * sizeof(int32_t);
-  }
+            const Tuple &old_tuple, const Tuple &new_tuple);
 
   // constructor for NEWPAGE type
-  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, page_id_t prev_page_id)
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, page_id_t prev_page_id,
+            page_id_t page_id = INVALID_PAGE_ID)
       : size_(HEADER_SIZE),
         txn_id_(txn_id),
         prev_lsn_(prev_lsn),
         log_record_type_(log_record_type),
-        prev_page_id_(prev_page_id) {
+        prev_page_id_(prev_page_id),
+        page_id_(page_id) {
     // calculate log record size, header size + sizeof(prev_page_id) + sizeof(page_id)
     size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
   }
 
+  // constructor for PAGEIMAGE and TRUNCATE type, the image is copied when the record is appended
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, page_id_t page_id, page_id_t next_page_id,
+            const char *page_image)
+      : size_(HEADER_SIZE + sizeof(page_id_t) * 2 + PAGE_SIZE),
+        txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(log_record_type),
+        page_id_(page_id),
+        next_page_id_(next_page_id),
+        page_image_(page_image) {}
+
+  // constructor for CLR type
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, lsn_t undo_next_lsn)
+      : size_(HEADER_SIZE + sizeof(lsn_t)),
+        txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(LogRecordType::CLR),
+        undo_next_lsn_(undo_next_lsn) {}
+
+  // constructor for BEGIN_CHECKPOINT type
+  LogRecord(std::vector<std::pair<txn_id_t, lsn_t>> active_txns, std::vector<std::pair<page_id_t, lsn_t>> dirty_pages)
+      : log_record_type_(LogRecordType::BEGIN_CHECKPOINT),
+        active_txns_(std::move(active_txns)),
+        dirty_pages_(std::move(dirty_pages)) {
+    size_ = GetCheckpointSize(active_txns_.size(), dirty_pages_.size());
+  }
+
   ~LogRecord() = default;
 
   inline RID &GetDeleteRID() { return delete_rid_; }
@@ -119,6 +176,49 @@ class LogRecord {
 
   inline page_id_t GetNewPageRecord() { return prev_page_id_; }
 
+  inline page_id_t GetNewPageId() { return page_id_; }
+
+  inline RID &GetUpdateRID() { return update_rid_; }
+
+  /** @return the page that the bulk load continues on, of a PAGEIMAGE record */
+  inline page_id_t GetNextPageId() { return next_page_id_; }
+
+  /** @return the LSN of the record that undo goes on with, of a CLR record */
+  inline lsn_t GetUndoNextLSN() { return undo_next_lsn_; }
+
+  /**
+   * @param old_tuple the tuple before the update
+   * @return the tuple after the update, of an UPDATE record
+   */
+  Tuple GetNewTuple(const Tuple &old_tuple) const { return ApplyUpdateDelta(old_tuple, false); }
+
+  /**
+   * @param new_tuple the tuple after the update
+   * @return the tuple before the update, of an UPDATE record
+   */
+  Tuple GetOldTuple(const Tuple &new_tuple) const { return ApplyUpdateDelta(new_tuple, true); }
+
+  /**
+   * Applies the serialized delta of an UPDATE record to one of the tuples of the update.
+   * @param delta the delta, which follows the rid in the record
+   * @param tuple the old tuple, or the new tuple if undo is true
+   * @param undo true to get the old tuple back
+   * @param[out] buffer the buffer that the other tuple is serialized into, its memory is reused
+   * @return the other tuple, pointing into buffer
+   */
+  static Tuple ApplyUpdateDelta(const char *delta, const Tuple &tuple, bool undo, std::vector<char> *buffer);
+
+  /** @return the running transactions and the LSNs of their last records, of a BEGIN_CHECKPOINT record */
+  inline std::vector<std::pair<txn_id_t, lsn_t>> &GetActiveTxns() { return active_txns_; }
+
+  /** @return the dirty pages and the LSNs that their changes since the last write start at, of a BEGIN_CHECKPOINT */
+  inline std::vector<std::pair<page_id_t, lsn_t>> &GetDirtyPages() { return dirty_pages_; }
+
+  /** @return the size of a BEGIN_CHECKPOINT record with the given numbers of transactions and pages */
+  static int32_t GetCheckpointSize(size_t num_txns, size_t num_pages) {
+    return static_cast<int32_t>(HEADER_SIZE + sizeof(int32_t) * (2 + 2 * num_txns + 2 * num_pages));
+  }
+
   inline int32_t GetSize() { return size_; }
 
   inline lsn_t GetLSN() { return lsn_; }
@@ -143,6 +243,17 @@ class LogRecord {
   }
 
  private:
+  /** Changed bytes that are closer than this are logged as one range, a range of their own would not be smaller. */
+  static constexpr uint32_t UPDATE_RANGE_GAP = 2 * sizeof(uint16_t);
+
+  /**
+   * Applies the update delta to one of the tuples of the update.
+   * @param tuple the old tuple, or the new tuple if undo is true
+   * @param undo true to get the old tuple back
+   * @return the other tuple
+   */
+  Tuple ApplyUpdateDelta(const Tuple &tuple, bool undo) const;
+
   // the length of log record(for serialization, in bytes)
   int32_t size_{0};
   // must have fields
@@ -159,15 +270,101 @@ class LogRecord {
   RID insert_rid_;
   Tuple insert_tuple_;
 
-  // case3: for update opeartion
+  // case3: for update opeartion, the serialized delta that follows the rid
   RID update_rid_;
-  Tuple old_tuple_;
-  Tuple new_tuple_;
+  std::vector<char> update_delta_;
 
-  // case4: for new page opeartion
+  // case4: for new page opeartion, and the page of a page image
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
+
+  // case6: for page image operation, the image points to the page or to the log data that the record was read from
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  const char *page_image_{nullptr};
+
+  // case7: for compensation operation
+  lsn_t undo_next_lsn_{INVALID_LSN};
+
+  // case5: for begin checkpoint operation
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns_;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages_;
   static const int HEADER_SIZE = 20;
 };  // namespace bustub
 
+/**
+ * LogRecordView reads a serialized log record in place, see LogRecord for the layout. Tuples are returned pointing into
+ * the serialized record, so reading a record allocates and copies nothing. A view is only valid as long as the data
+ * that it was parsed from.
+ */
+class LogRecordView {
+ public:
+  /**
+   * Parses the record at the start of the data.
+   * @param data serialized log records
+   * @param size the size of the data in bytes
+   * @return false if the data does not start with a complete record
+   */
+  bool Parse(const char *data, size_t size);
+
+  inline int32_t GetSize() const { return size_; }
+
+  inline lsn_t GetLSN() const { return lsn_; }
+
+  inline txn_id_t GetTxnId() const { return txn_id_; }
+
+  inline lsn_t GetPrevLSN() const { return prev_lsn_; }
+
+  inline LogRecordType GetLogRecordType() const { return log_record_type_; }
+
+  /** @return the serialized record */
+  inline const char *GetData() const { return data_; }
+
+  /** @return the rid of an INSERT, delete or UPDATE record */
+  inline RID GetRID() const {
+    RID rid;
+    memcpy(&rid, data_ + LogRecord::HEADER_SIZE, sizeof(RID));
+    return rid;
+  }
+
+  /** @return the tuple of an INSERT or delete record, pointing into the record */
+  inline Tuple GetTuple() const {
+    const char *tuple_data = data_ + LogRecord::HEADER_SIZE + sizeof(RID);
+    uint32_t tuple_size;
+    memcpy(&tuple_size, tuple_data, sizeof(uint32_t));
+    return Tuple(tuple_data + sizeof(uint32_t), tuple_size);
+  }
+
+  /** @return the delta of an UPDATE record, see LogRecord::ApplyUpdateDelta */
+  inline const char *GetUpdateDelta() const { return data_ + LogRecord::HEADER_SIZE + sizeof(RID); }
+
+  /** @return the page before the new page, of a NEWPAGE record */
+  inline page_id_t GetPrevPageId() const { return ReadPageId(0); }
+
+  /** @return the new page, of a NEWPAGE record */
+  inline page_id_t GetNewPageId() const { return ReadPageId(1); }
+
+  /** @return the page of a PAGEIMAGE or TRUNCATE record */
+  inline page_id_t GetImagePageId() const { return ReadPageId(0); }
+
+  /** @return the page that the bulk load continues on, of a PAGEIMAGE record, the page that followed, of a TRUNCATE */
+  inline page_id_t GetImageNextPageId() const { return ReadPageId(1); }
+
+  /** @return the page data of a PAGEIMAGE or TRUNCATE record */
+  inline const char *GetPageImage() const { return data_ + LogRecord::HEADER_SIZE + 2 * sizeof(page_id_t); }
+
+ private:
+  inline page_id_t ReadPageId(size_t index) const {
+    page_id_t page_id;
+    memcpy(&page_id, data_ + LogRecord::HEADER_SIZE + index * sizeof(page_id_t), sizeof(page_id_t));
+    return page_id;
+  }
+
+  const char *data_{nullptr};
+  int32_t size_{0};
+  lsn_t lsn_{INVALID_LSN};
+  txn_id_t txn_id_{INVALID_TXN_ID};
+  lsn_t prev_lsn_{INVALID_LSN};
+  LogRecordType log_record_type_{LogRecordType::INVALID};
+};
+
 }  // namespace bustub
@@ -13,8 +13,14 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
@@ -27,9 +33,21 @@ namespace bustub {
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
+  /**
+   * Creates a new LogRecovery.
+   * @param disk_manager the disk manager that the log is read with
+   * @param buffer_pool_manager the buffer pool that the log is replayed into
+   * @param log_buffer_size the size of the buffer that the log is read into in byte, at least that of the log manager
+   * @param num_redo_workers the number of threads that replay the log records during redo
+   */
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager,
+              size_t log_buffer_size = LOG_BUFFER_SIZE, size_t num_redo_workers = REDO_WORKERS)
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        offset_(0),
+        log_buffer_size_(log_buffer_size),
+        num_redo_workers_(std::max<size_t>(num_redo_workers, 1)) {
+    log_buffer_ = new char[log_buffer_size_];
   }
 
   ~LogRecovery() {
@@ -37,21 +55,143 @@ class LogRecovery {
     log_buffer_ = nullptr;
   }
 
+  /**
+   * Replays the log from the redo start of the last checkpoint, or from its beginning without one. The calling thread
+   * reads and deserializes the log records, and hands each record to the redo worker of the page that it changes, so
+   * that the pages are replayed in parallel while the records of every page are still applied in LSN order. A page that
+   * fails its checksum, e.g. one that the crash tore, is rebuilt if its first record rewrites all of it.
+   * @throws Exception if a page that the log changes cannot be read and is not rebuilt
+   */
   void Redo();
+
+  /**
+   * Rolls back the transactions that neither committed nor aborted before the crash. Must be called after Redo.
+   * @throws Exception if a page that is rolled back cannot be read
+   */
   void Undo();
-  bool DeserializeLogRecord(const char *data, LogRecord *log_record);
+
+  /**
+   * Replays the records of a part of the log like Redo(), for a replica that applies the log its primary ships to it.
+   * Unlike Redo(), it keeps nothing for Undo(), so it can be called over and over as the log grows.
+   * @param begin the offset in the log of the first record
+   * @param end the offset in the log that the part ends at, a record that does not end before it is not replayed
+   * @return the offset after the last record that was replayed
+   * @throws Exception like Redo()
+   */
+  int64_t RedoRange(int64_t begin, int64_t end);
+
+  /**
+   * Deserializes a log record.
+   * @param data the serialized log record
+   * @param size the number of bytes that are readable at data
+   * @param[out] log_record the deserialized log record
+   * @return false if data does not hold a complete log record
+   */
+  static bool DeserializeLogRecord(const char *data, size_t size, LogRecord *log_record);
+
+  /** @return the number of log records that were applied to a page during redo */
+  size_t GetNumRedoneRecords() const { return num_redone_records_; }
+
+  /** @return the offset in the log file that redo started reading at */
+  int64_t GetRedoStartOffset() const { return redo_start_offset_; }
 
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** A log record that a redo worker replays on one page. */
+  struct RedoItem {
+    /** The page that the record is replayed on. A NEWPAGE record is replayed on the new and the previous page. */
+    page_id_t page_id;
+    /** The record, in the log data of its batch. */
+    LogRecordView log_record;
+  };
+
+  /** The records of one read of the log that a redo worker replays, together with the log data they are in. */
+  struct RedoBatch {
+    std::shared_ptr<std::vector<char>> log_data;
+    std::vector<RedoItem> items;
+  };
+
+  /** The log records that a redo worker has yet to replay, in LSN order. */
+  struct RedoQueue {
+    std::mutex latch;
+    std::condition_variable cv;
+    std::deque<RedoBatch> batches;
+    bool done = false;
+  };
+
+  /**
+   * Reads the log from an offset, and has the redo workers replay its records. See Redo().
+   * @param begin the offset in the log of the first record
+   * @param end the offset in the log that reading stops at, INT64_MAX for the end of the log
+   * @param prepare_undo true to record the active transactions and the offsets of the records for Undo()
+   * @return the offset after the last record that was replayed
+   */
+  int64_t ReplayLog(int64_t begin, int64_t end, bool prepare_undo);
+
+  /** Replays the records of the queue until the reader is done with the log. */
+  void RunRedoWorker(RedoQueue *queue);
+
+  /**
+   * Applies a log record to a page if the page does not reflect it yet. The tuples are applied from the log data.
+   * @param page_id the page
+   * @param log_record the record
+   * @param[out] tuple_buffer memory for the new tuple of an update, which is reused across calls
+   * @return true if the record was applied, false if the page does not need it or cannot be read, see
+   * unreadable_page_id_
+   */
+  bool RedoOnPage(page_id_t page_id, const LogRecordView &log_record, std::vector<char> *tuple_buffer);
+
+  /**
+   * Fetches a page for redo. A page that fails its checksum is replaced by a zeroed one if the record rewrites all of
+   * it, its LSN of 0 then has the record applied.
+   * @param page_id the page
+   * @param log_record the record that is replayed on the page
+   * @return the pinned page, nullptr if it cannot be read
+   */
+  Page *FetchPageForRedo(page_id_t page_id, const LogRecordView &log_record);
+
+  /**
+   * Records the offsets of the log records in a part of the log that redo did not read.
+   * @param begin the offset of the first record
+   * @param end the offset that the part ends before
+   */
+  void MapLogRecords(int64_t begin, int64_t end);
+
+  /**
+   * @param offset the offset in the log file that the last read started at
+   * @param pos the size of the records that were found in the read data
+   * @param read_size the size of the read data
+   * @param next_offset the offset in the log file after the read data
+   * @return the offset in the log file of the record after the ones that were found
+   */
+  static int64_t GetNextReadOffset(int64_t offset, size_t pos, int read_size, int64_t next_offset);
+
+  /** Reverts the change of a log record on its page. */
+  void UndoOnPage(LogRecord *log_record);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
 
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
-  /** Mapping the log sequence number to log file offset for undos. */
-  std::unordered_map<lsn_t, int> lsn_mapping_;
+  /**
+   * Mapping the log sequence number to log file offset for undos: the offset that the read holding the record started
+   * at, and the position of the record in the read data.
+   */
+  std::unordered_map<lsn_t, std::pair<int64_t, size_t>> lsn_mapping_;
 
-  int offset_ __attribute__((__unused__));
+  int64_t offset_;
+  /** The offset in the log file that redo started reading at. */
+  int64_t redo_start_offset_{0};
+  /** The offset in the log file of the oldest record that undo may need, the log before it may have been truncated. */
+  int64_t undo_start_offset_{0};
+  /** The size of log_buffer_ in byte. */
+  const size_t log_buffer_size_;
   char *log_buffer_;
+  /** The number of threads that replay the log records during redo. */
+  const size_t num_redo_workers_;
+  std::atomic<size_t> num_redone_records_{0};
+  /** The first page that a redo worker could not read, the log reader throws once the workers are done. */
+  std::atomic<page_id_t> unreadable_page_id_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
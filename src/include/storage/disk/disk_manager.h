@@ -12,34 +12,102 @@
 
 #pragma once
 
+#include <sys/types.h>
+
+#include <array>
 #include <atomic>
+#include <condition_variable>  // NOLINT
 #include <fstream>
 #include <future>  // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "common/util/metrics.h"
+#include "storage/disk/io_uring.h"
 
 namespace bustub {
 
+/**
+ * How the DiskManager accesses the database file. BUFFERED goes through the OS page cache. DIRECT bypasses it with
+ * O_DIRECT, so that pages are only cached once, by the buffer pool.
+ */
+enum class DiskIOMode { BUFFERED, DIRECT };
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * The pages are stored in segment files of SEGMENT_SIZE pages each. The first segment file is the database file, the
+ * others are named after it with the number of the segment appended, and can be spread over several directories, e.g.
+ * on different drives, so that scans read from all of them at once. Pages are read and written with positional I/O,
+ * so page I/O from different threads never serializes on a shared file cursor.
+ *
+ * Segments whose data no longer changes, e.g. because they were bulk loaded, can be mapped into memory read-only. Their
+ * pages are then read straight from the mapping and can no longer be written or allocated.
+ *
+ * Page ids are handed out in extents of EXTENT_SIZE contiguous pages. Shared extents hold the pages of AllocatePage,
+ * dedicated extents hold chains of pages from AllocateExtentPage, such as the pages of a table heap, which therefore
+ * stay physically sequential. Deallocated pages are reused, and extents whose pages are all deallocated are reused
+ * before the file grows. Which pages are allocated is kept in a bitmap, the free space map, that is saved next to the
+ * database file. Before a page is written, the map is saved and synced if pages were allocated since it was last
+ * saved, so that no page on disk is free in the saved map, whatever allocated it. Recovery marks the pages that the log
+ * names, which may have been allocated after the map was saved and never written, see MarkPageAllocated().
+ *
+ * Every page that is written gets a CRC-32C checksum, which is verified when the page is read back. Pages use all of
+ * their bytes, so the checksums are kept in a file next to the database file rather than in the pages. A page that
+ * fails its checksum is reported to the caller of the read, which must not use its data. The checksum of a write goes
+ * to the file once the write is done, and SyncPages() syncs the pages before the checksums. The file keeps the
+ * previous checksum of every page as well, and a page passes if it matches either, so a checksum that reached the disk
+ * before its page did is not taken for corruption after a crash.
+ *
+ * Optionally, pages are stored compressed. The database file is then split into slots of a multiple of
+ * COMPRESSED_SLOT_SIZE bytes, each holding one version of a page behind a header. A rewritten page goes to a new slot
+ * and its old slot is reused by later writes, so a crash never tears the previous version. Which slot holds a page is
+ * kept in memory and rebuilt from the slot headers when the file is opened. Compressed pages are all kept in the
+ * database file.
+ *
+ * Optionally, the extents are stored in two tiers: the segment files are the performance tier, and files of the same
+ * layout in a capacity directory, e.g. on a slower and cheaper drive, are the capacity tier. The disk manager counts
+ * the accesses to every extent, its own I/O as well as the buffer pool hits that RecordPageAccesses reports, and a
+ * background thread moves extents that went cold to the capacity tier and extents that warmed up again back. Which
+ * tier an extent is in is saved next to the database file, callers address pages by id either way.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param io_mode how the database file is accessed. If the file system does not support direct I/O, or the pages are
+   * compressed, the disk manager falls back to buffered I/O
+   * @param compress_pages true to store the pages compressed, which must match how the file was written
+   * @param stripe_dirs the directories that segment i > 0 is put in, round-robin by i, empty to put all segments next
+   * to the database file. The directories must be the same every time the database is opened.
+   * @param capacity_dir the directory of the capacity tier, empty to keep all extents in the segment files. Tiering
+   * is not available with compressed pages, and asynchronous page I/O is not used with it.
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, DiskIOMode io_mode = DiskIOMode::BUFFERED,
+                       bool compress_pages = false, std::vector<std::string> stripe_dirs = {},
+                       std::string capacity_dir = "");
 
-  ~DiskManager() = default;
+  /** Stops the migration thread of a tiered disk manager. */
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
    */
   void ShutDown();
 
+  /** @return true once ShutDown() was called, after which no page may be written */
+  bool IsShutDown() const { return shut_down_.load(); }
+
   /**
    * Write a page to the database file.
    * @param page_id id of the page
@@ -51,37 +119,240 @@ class DiskManager {
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @return false if the page does not match its checksum, its data must not be used then
+   */
+  bool ReadPage(page_id_t page_id, char *page_data);
+
+  /**
+   * Read a page from the database file without counting a checksum failure, e.g. to copy it while it may be written.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   * @return true if the page matches its checksum, false if it may have been read halfway through a write
+   */
+  bool TryReadPage(page_id_t page_id, char *page_data);
+
+  /**
+   * Start writing a page to the database file. With an io_uring available, the write is queued to the kernel and the
+   * call returns right away; otherwise the page is written before the call returns.
+   * @param page_id id of the page
+   * @param page_data raw page data, which must stay unchanged until the future is ready
+   * @return a future that becomes ready once the page is written, false if the write failed
+   */
+  std::future<bool> WritePageAsync(page_id_t page_id, const char *page_data);
+
+  /**
+   * Start reading a page from the database file. With an io_uring available, the read is queued to the kernel and the
+   * call returns right away; otherwise the page is read before the call returns.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, which must stay valid until the future is ready
+   * @return a future that becomes ready once page_data holds the page, false if the read failed or the page does not
+   * match its checksum
+   */
+  std::future<bool> ReadPageAsync(page_id_t page_id, char *page_data);
+
+  /** @return true if asynchronous page I/O is queued to the kernel rather than performed synchronously */
+  bool IsAsyncIOAvailable() const { return io_uring_ != nullptr; }
+
+  /**
+   * Read several pages from the database file. Runs of consecutive page ids are read with a single vectored read, so
+   * callers should pass the pages sorted by page id.
+   * @param page_ids ids of the pages
+   * @param[out] page_data output buffers, one per page
+   * @return for every page, false if it does not match its checksum, see ReadPage()
+   */
+  std::vector<bool> ReadPages(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data);
+
+  /**
+   * Write several pages to the database file. Runs of consecutive page ids are written with a single vectored write,
+   * and the other pages are queued like WritePageAsync() does, so callers should pass the pages sorted by page id.
+   * Returns once all of the pages are written, which are not durable before SyncPages().
+   * @param page_ids ids of the pages
+   * @param page_data raw page data, one per page
+   */
+  void WritePages(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data);
+
+  /** Makes the pages written so far durable, with an fdatasync of every file that holds pages or their checksums. */
+  void SyncPages();
+
+  /**
+   * Maps a segment file into memory read-only, until the disk manager shuts down. The pages in the file at that time
+   * can no longer be written, and the rest of their extents can no longer be allocated. Pages read from the mapping
+   * are not verified against their checksums.
+   * @param segment the number of the segment
+   * @return true if the segment is mapped, false if it has no pages, could not be mapped, or the pages are compressed
+   * or tiered
+   */
+  bool MapSegmentReadOnly(size_t segment);
+
+  /**
+   * @param page_id id of a page
+   * @return the data of the page in the mapping of its read-only segment, nullptr if the page is not mapped
+   */
+  const char *GetMappedPage(page_id_t page_id);
+
+  /** @return true if any segment is mapped read-only */
+  bool HasMappedSegments() const { return has_mapped_segments_.load(std::memory_order_acquire); }
+
+  /** @return true if the extents are stored in two tiers, see above */
+  bool IsTiered() const { return !capacity_dir_.empty(); }
+
+  /**
+   * Counts accesses to a page that did not come to the disk manager, e.g. the hits of a buffer pool frame, towards the
+   * heat of its extent. Does nothing if the disk manager is not tiered.
+   * @param page_id id of the page
+   * @param num_accesses the number of accesses
+   */
+  void RecordPageAccesses(page_id_t page_id, uint32_t num_accesses);
+
+  /**
+   * Moves the in-use extents that went cold to the capacity tier, and those that were accessed TIER_PROMOTE_HEAT times
+   * back to the performance tier, at most TIER_MIGRATION_BATCH of them. Then halves the heat of every extent. The
+   * migration thread calls this every tier_migration_interval. Pages are read and written as usual during a move,
+   * except for the pages of the extent that is being moved, which wait for it.
+   * @return the number of extents that were moved
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  size_t MigrateExtents();
+
+  /** @return true if an extent is in the capacity tier */
+  bool IsExtentCold(size_t extent);
 
   /**
-   * Flush the entire log buffer into disk.
+   * Write the entire log buffer to disk and wait until it is durable. The log is appended to its last segment file,
+   * a new segment file is started whenever one reaches LOG_SEGMENT_SIZE bytes.
    * @param log_data raw log data
    * @param size size of log entry
    */
   void WriteLog(char *log_data, int size);
 
   /**
-   * Read a log entry from the log file.
+   * Read a log entry from the log, across segment files if need be. The part of the buffer past the end of the log is
+   * zeroed. At the start of a compressed block, the blocks that fit into the buffer are read and decompressed.
    * @param[out] log_data output buffer
    * @param size size of the log entry
-   * @param offset offset of the log entry in the file
-   * @return true if the read was successful, false otherwise
+   * @param offset offset of the log entry in the log
+   * @param[out] read_size if not nullptr, the size of the log data that was read into the buffer
+   * @param[out] next_offset if not nullptr, the offset in the log after the data that was read
+   * @return true if the read was successful, false if the offset is past the end of the log or has been truncated
    */
-  bool ReadLog(char *log_data, int size, int offset);
+  bool ReadLog(char *log_data, int size, int64_t offset, int *read_size = nullptr, int64_t *next_offset = nullptr);
+
+  /** @return the size of the log in byte, including the segments that have been truncated */
+  int64_t GetLogSize();
+
+  /** @return the offset of the first byte of the log that is still on disk */
+  int64_t GetLogStartOffset();
+
+  /**
+   * Deletes the segment files that lie entirely before the given offset. The segment that is written to is kept.
+   * @param offset offset in the log that no longer has to be read
+   */
+  void TruncateLog(int64_t offset);
 
   /**
-   * Allocate a page on disk.
+   * Keeps the log from being truncated from its current start on, until UnpinLog(), e.g. while a backup copies it.
+   * @return the offset of the first byte of the log that is still on disk, which stays there while it is pinned
+   */
+  int64_t PinLog();
+
+  /** @param offset an offset that PinLog() returned, which may be truncated again */
+  void UnpinLog(int64_t offset);
+
+  /**
+   * Reads the log as it is stored, i.e. without decompressing its blocks, e.g. to copy it.
+   * @param[out] data output buffer
+   * @param size the number of bytes to read
+   * @param offset offset in the log
+   * @return the number of bytes that were read, 0 if the offset is past the end of the log or has been truncated
+   */
+  int ReadRawLog(char *data, int size, int64_t offset);
+
+  /**
+   * Drops the log and starts it over empty at an offset, so that a copy of another log can be appended to it with
+   * AppendRawLog() at the offsets that it had there.
+   * @param offset the offset of the new start of the log, a multiple of LOG_SEGMENT_SIZE
+   */
+  void RestartLog(int64_t offset);
+
+  /**
+   * Appends bytes that ReadRawLog() read to the log, and makes them durable.
+   * @return false on an I/O error
+   */
+  bool AppendRawLog(const char *data, int size);
+
+  /**
+   * Saves the master record, which points recovery at the last checkpoint. It replaces the previous one atomically.
+   * @param checkpoint_lsn the LSN of the BEGIN_CHECKPOINT record of the checkpoint
+   * @param redo_offset the offset in the log that redo starts reading at
+   * @param undo_offset the offset in the log of the oldest record that undo may need, at most redo_offset. The
+   * segments before it can be truncated once the record has been written.
+   */
+  void WriteMasterRecord(lsn_t checkpoint_lsn, int64_t redo_offset, int64_t undo_offset);
+
+  /**
+   * Loads the master record.
+   * @param[out] checkpoint_lsn the LSN of the BEGIN_CHECKPOINT record of the last checkpoint
+   * @param[out] redo_offset the offset in the log that redo starts reading at
+   * @param[out] undo_offset the offset in the log of the oldest record that undo may need
+   * @return false if no checkpoint has been taken
+   */
+  bool ReadMasterRecord(lsn_t *checkpoint_lsn, int64_t *redo_offset, int64_t *undo_offset);
+
+  /**
+   * Allocate a page on disk, preferring deallocated pages of the shared extents over opening a new extent.
+   * The page ids can be split into classes by their remainder, e.g. so that every buffer pool shard allocates its own.
+   * @param num_classes the number of classes that page ids are split into
+   * @param page_class the class of the page, the allocated id satisfies page_id % num_classes == page_class
    * @return the id of the allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(uint32_t num_classes = 1, uint32_t page_class = 0);
 
   /**
-   * Deallocate a page on disk.
+   * Allocate a page on disk in a dedicated extent. The page that follows prev_page_id in its class is used if it is
+   * free, either in the extent of prev_page_id or at the start of the next extent; otherwise a new extent is opened.
+   * @param prev_page_id the page that the new page should follow, INVALID_PAGE_ID to open a new extent
+   * @param num_classes the number of classes that page ids are split into
+   * @param page_class the class of the page, the allocated id satisfies page_id % num_classes == page_class
+   * @return the id of the allocated page
+   */
+  page_id_t AllocateExtentPage(page_id_t prev_page_id, uint32_t num_classes = 1, uint32_t page_class = 0);
+
+  /**
+   * @param page_id id of a page
+   * @return true if the page has been allocated and not deallocated since
+   */
+  bool IsPageAllocated(page_id_t page_id);
+
+  /** @return one past the highest page id that has been allocated */
+  page_id_t GetNumAllocatedPages() const { return next_page_id_; }
+
+  /** @return the number of pages that the database file holds, including those written by earlier runs */
+  page_id_t GetNumPagesOnDisk();
+
+  /**
+   * Deallocate a page on disk, so that its id can be handed out again. Pages that are not allocated are ignored.
    * @param page_id id of the page to deallocate
    */
   void DeallocatePage(page_id_t page_id);
 
+  /**
+   * Marks a page allocated, e.g. one that recovery finds in the log, whose allocation may have been lost with a free
+   * space map that was not saved. Pages that are allocated are left as they are.
+   * @param page_id id of the page
+   */
+  void MarkPageAllocated(page_id_t page_id);
+
+  /**
+   * Saves the free space map next to the database file if it changed since it was last saved. The map is saved as a
+   * whole, synced, and replaces the previous one atomically.
+   */
+  void FlushFreeSpaceMap();
+
+  /**
+   * Replaces the free space map of another disk manager with this one and saves it, e.g. that of a backup.
+   * @param target the disk manager of the other database file
+   */
+  void CopyFreeSpaceMapTo(DiskManager *target);
+
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
 
@@ -91,6 +362,36 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of pages that were read back with a checksum that did not match */
+  int GetNumChecksumFailures() const { return num_checksum_failures_; }
+
+  /**
+   * Adds the write, flush and checksum counters and the sizes of the database file and the log to a snapshot, see
+   * MetricsRegistry.
+   * @param snapshot the snapshot to add the metrics to
+   */
+  void CollectMetrics(MetricsSnapshot *snapshot);
+
+  /**
+   * Turns the verification of checksums on reads on or off. Checksums are computed on writes either way, so
+   * verification can be turned back on at any time.
+   * @param verify true to verify the checksum of every page that is read
+   */
+  void SetVerifyChecksums(bool verify) { verify_checksums_ = verify; }
+
+  /** @return true if the pages are stored compressed */
+  bool IsCompressed() const { return compress_pages_; }
+
+  /**
+   * Turns the compression of log writes on or off. Compressed and uncompressed writes can follow each other in the same
+   * log, ReadLog tells them apart.
+   * @param compress true to write every log buffer that gets smaller as a compressed block
+   */
+  void SetCompressLog(bool compress) { compress_log_ = compress; }
+
+  /** @return how the database file is accessed, which may differ from the requested mode */
+  DiskIOMode GetIOMode() const { return io_mode_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -101,18 +402,342 @@ class DiskManager {
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
  private:
-  int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
+  /** How the pages of an extent are handed out. */
+  enum class ExtentKind : uint8_t { FREE, SHARED, DEDICATED };
+
+  /** Where the pages of an extent are stored. */
+  enum class StorageTier : uint8_t { PERFORMANCE, CAPACITY };
+
+  /** The read-only mapping of a segment file. */
+  struct MappedSegment {
+    char *data_ = nullptr;
+    // the number of pages in the mapping
+    size_t num_pages_ = 0;
+  };
+
+  /** Where a compressed page is stored. */
+  struct PageSlot {
+    // the offset of the slot in the database file, -1 if the page has not been written
+    off_t offset_ = -1;
+    // the write that put the page into the slot, later writes have higher numbers
+    uint64_t write_seq_ = 0;
+    // the size of the slot in units of COMPRESSED_SLOT_SIZE
+    uint8_t num_units_ = 0;
+  };
+
+  int64_t GetFileSize(const std::string &file_name);
+
+  /**
+   * @param segment_name the path of a segment file
+   * @param create true to create the file if it does not exist
+   * @return the file descriptor of the file, opened for the I/O mode, -1 if it could not be opened
+   */
+  int OpenSegmentFile(const std::string &segment_name, bool create) const;
+
+  /** @return the path of the segment file with the given number */
+  std::string GetSegmentName(size_t segment) const;
+
+  /** The header of a compressed block of the log. */
+  struct LogBlockHeader {
+    // LOG_BLOCK_MAGIC, which no log record starts with as its size is negative
+    uint32_t magic_;
+    // the size of the log data in the block
+    uint32_t data_size_;
+    // the size of the compressed data that follows the header
+    uint32_t compressed_size_;
+    // the checksum of the compressed data
+    uint32_t checksum_;
+  };
+  static constexpr uint32_t LOG_BLOCK_MAGIC = 0xB10C10C5;
+
+  /**
+   * Appends to the log, continuing in a new segment file whenever one fills up. The caller holds log_latch_.
+   * @return false on an I/O error
+   */
+  bool AppendLog(const char *data, int size);
+
+  /**
+   * Reads from the log across segment files. The caller holds log_latch_.
+   * @return the number of bytes read, less than size at the end of the log
+   */
+  int ReadLogData(char *data, int size, int64_t offset);
+
+  /**
+   * Reads and decompresses the compressed blocks at an offset into the log, as many as fit. The caller holds
+   * log_latch_.
+   * @param[out] data output buffer
+   * @param size size of the output buffer
+   * @param[in,out] offset the offset of the first block, set to the offset after the last block that was read
+   * @return the size of the decompressed data, 0 if there is no complete block at the offset
+   */
+  int ReadLogBlocks(char *data, int size, int64_t *offset);
+
+  /** @return the path of the log segment file with the given number */
+  std::string GetLogSegmentName(int64_t segment) const;
+
+  /**
+   * Finds the log segment files of an existing log, the first one is the segment that the last checkpoint needs undo
+   * to start reading in, and opens the last one for appending.
+   * @param db_exists false if the database file has just been created, the log of a previous one is started over
+   */
+  void OpenLog(bool db_exists);
+
+  /**
+   * @param page_id id of a page
+   * @param create true to create the segment file of the page and those before it, if they do not exist yet
+   * @return the file descriptor of the segment file that holds the page, -1 if it does not exist
+   */
+  int GetSegmentFd(page_id_t page_id, bool create);
+
+  /**
+   * Picks the file of a page in the tier of its extent, and counts the access towards the heat of the extent. The
+   * caller holds the latch of the extent, see LockExtent().
+   * @param page_id id of a page
+   * @param create true to create the file if it does not exist yet
+   * @return the file descriptor of the file that holds the page, -1 if it does not exist
+   */
+  int GetPageFd(page_id_t page_id, bool create);
+
+  /** @return a shared latch on the extent of a page, which keeps it in its tier; an empty lock if not tiered */
+  std::shared_lock<std::shared_mutex> LockExtent(page_id_t page_id);
+
+  /** @return the path of the capacity tier file of a segment */
+  std::string GetCapacityName(size_t segment) const;
+
+  /**
+   * @param segment the number of a segment
+   * @param create true to create the file if it does not exist
+   * @return the file descriptor of the capacity tier file of the segment, -1 if it does not exist
+   */
+  int GetCapacityFd(size_t segment, bool create);
+
+  /**
+   * Copies an extent to the other tier, makes the copy durable and switches the extent over, then frees the space of
+   * the old copy. The caller holds migration_latch_.
+   * @return false on an I/O error, and then the extent stays where it was
+   */
+  bool MoveExtent(size_t extent, StorageTier tier);
+
+  /** Loads the tiers of the extents of an existing database file. */
+  void LoadTierMap();
+
+  /** Saves the tiers of the extents, replacing the previous map atomically. The caller holds tier_latch_. */
+  bool SaveTierMap();
+
+  /** Migrates extents every tier_migration_interval until StopMigrations() is called. */
+  void RunMigrations();
+
+  /** Stops and joins the migration thread, if there is one. */
+  void StopMigrations();
+
+  /** @return the offset of a page in its segment file */
+  static off_t GetSegmentOffset(page_id_t page_id) { return static_cast<off_t>(page_id % SEGMENT_SIZE) * PAGE_SIZE; }
+
+  /**
+   * Reads the free space map of an existing database file. Pages on disk that the map does not cover, because they
+   * were written after it was saved, are marked allocated. The caller must hold map_latch_.
+   */
+  void LoadFreeSpaceMap();
+
+  /**
+   * Marks an extent as in use, growing the map if the extent lies past its end. The caller must hold map_latch_.
+   * @param extent the index of the extent, which must be free
+   * @param kind how the pages of the extent are handed out, SHARED or DEDICATED
+   */
+  void ClaimExtent(size_t extent, ExtentKind kind);
+
+  /**
+   * Claims the first free extent, or a new one at the end of the file. The caller must hold map_latch_.
+   * @param kind how the pages of the extent are handed out, SHARED or DEDICATED
+   * @return the index of the extent
+   */
+  size_t OpenExtent(ExtentKind kind);
+
+  /**
+   * Marks a page of an extent allocated. The caller must hold map_latch_.
+   * @param extent the index of the extent
+   * @param offset the offset of the page in the extent, which must be free
+   * @return the id of the page
+   */
+  page_id_t TakePage(size_t extent, int offset);
+
+  /** Saves the free space map if pages were allocated since it was last saved, before a page is written. */
+  void SaveAllocations();
+
+  /**
+   * @param extent the index of an extent
+   * @return true if a page of the extent is mapped read-only, so that the extent must not be allocated from
+   */
+  bool IsExtentMapped(size_t extent);
+
+  /**
+   * Rebuilds the slots of the compressed pages from the slot headers in the database file. Of the slots that hold the
+   * same page, the one written last is used and the others are free.
+   */
+  void LoadPageSlots();
+
+  /** Compresses a page into a new slot, then frees the slot of its previous version. */
+  void WriteCompressedPage(page_id_t page_id, const char *page_data);
+
+  /** Reads a page from its slot, zero filling pages that have not been written. */
+  void ReadCompressedPage(page_id_t page_id, char *page_data);
+
+  /** Reads a page, compressed or not, without verifying it. Pages past the end of the file read as zeros. */
+  void ReadPageData(page_id_t page_id, char *page_data);
+
+  /**
+   * Hands out a free slot, or a new one at the end of the file. The caller must hold slot_latch_.
+   * @param num_units the size of the slot in units of COMPRESSED_SLOT_SIZE
+   * @return the offset of the slot
+   */
+  off_t TakeSlot(uint8_t num_units);
+
+  /** Sets up the io_uring for asynchronous I/O on db_fd_, if the kernel provides one. */
+  void StartAsyncIO();
+
+  /**
+   * @param page_data a page buffer
+   * @return true if the buffer can be handed to the kernel as is, false if direct I/O needs a bounce buffer for it
+   */
+  bool CanUseBuffer(const char *page_data) const;
+
+  /**
+   * Opens the checksum file and loads the checksums of an existing database file.
+   * @param db_exists false if the database file was just created, which makes the old checksums stale
+   */
+  void OpenChecksumFile(bool db_exists);
+
+  /**
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @return the checksum of the page, never 0. The page id is part of it, so pages written to the wrong place fail.
+   */
+  static uint32_t ComputeChecksum(page_id_t page_id, const char *page_data);
+
+  /**
+   * Stores the checksum of a page that has been written, and keeps its previous one. Only called once the write is
+   * done, so the file never holds a checksum of data that was not written.
+   * @param page_id id of the page
+   * @param checksum the checksum of the data that was written
+   */
+  void RecordChecksum(page_id_t page_id, uint32_t checksum);
+
+  /**
+   * Checks a page that has been read against its checksum, counting a failure if it does not match. Pages that have
+   * never been written have no checksum and always pass.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @return false if the page does not match, unless verification is turned off
+   */
+  bool VerifyChecksum(page_id_t page_id, const char *page_data);
+
+  /** @return true if a page that has been read matches its current or its previous checksum, or has none */
+  bool MatchesChecksum(page_id_t page_id, const char *page_data);
+
+  // protects the log segment bookkeeping below
+  std::mutex log_latch_;
+  // descriptor of the last log segment file, that WriteLog appends to, -1 if it could not be opened
+  int log_fd_ = -1;
+  // the path of the first log segment file, the others add their number to it
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // the number of the first log segment file that has not been truncated
+  int64_t first_log_segment_ = 0;
+  // the size of the log in byte, the last segment file ends at this offset
+  int64_t log_size_ = 0;
+  // the offsets of the log that PinLog() keeps from being truncated
+  std::multiset<int64_t> log_pins_;
   std::string file_name_;
+  // one past the highest allocated page id
   std::atomic<page_id_t> next_page_id_;
   int num_flushes_;
-  int num_writes_;
+  std::atomic<int> num_writes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
+  // file descriptor of the db file, -1 if it could not be opened; positional I/O on it needs no latch
+  int db_fd_ = -1;
+  // set by ShutDown()
+  std::atomic<bool> shut_down_{false};
+  DiskIOMode io_mode_;
+  std::vector<std::string> stripe_dirs_;
+  // protects the growth of segment_fds_
+  std::shared_mutex segment_latch_;
+  // the file descriptors of the segment files, starting with db_fd_
+  std::vector<int> segment_fds_;
+  // the read-only mappings, indexed by segment and protected by segment_latch_
+  std::vector<MappedSegment> mapped_segments_;
+  std::atomic<bool> has_mapped_segments_{false};
+  // asynchronous page I/O on the segment files, nullptr if io_uring is not available
+  std::unique_ptr<IoUring> io_uring_;
+
+  // the free space map is saved to this file, empty if it is not saved
+  std::string map_name_;
+  // the master record of the last checkpoint is saved to this file, empty if it is not saved
+  std::string master_name_;
+  // protects the free space map below
+  std::mutex map_latch_;
+  // bit i of extent_pages_[e] is set iff page e * EXTENT_SIZE + i is allocated
+  std::vector<uint64_t> extent_pages_;
+  std::vector<ExtentKind> extent_kinds_;
+  // the free extents before the end of the map, lowest first
+  std::set<size_t> free_extents_;
+  // the first shared extent that may have a free page of a class, keyed by (num_classes, page_class)
+  std::map<std::pair<uint32_t, uint32_t>, size_t> shared_hints_;
+  // true if the map changed since it was last saved
+  bool map_dirty_ = false;
+  // true if pages were allocated since the map was last saved; set under map_latch_, read without it by the writes
+  std::atomic<bool> map_unsaved_allocations_{false};
+
+  /** The last two checksums of a page, 0 where the page has none. */
+  struct PageChecksums {
+    uint32_t current_;
+    uint32_t previous_;
+  };
+  // file descriptor of the checksum file, which holds the checksums of page i at offset i * sizeof(PageChecksums)
+  int checksum_fd_ = -1;
+  // protects the growth of checksums_
+  std::shared_mutex checksum_latch_;
+  // the checksums of every page that has been written
+  std::vector<PageChecksums> checksums_;
+  std::atomic<bool> verify_checksums_{true};
+  // true if log buffers are written as compressed blocks
+  std::atomic<bool> compress_log_{false};
+  // the compressed block of the log buffer that WriteLog writes, protected by log_latch_
+  std::vector<char> log_block_;
+  std::atomic<int> num_checksum_failures_{0};
+
+  bool compress_pages_;
+  // protects the slots below
+  std::mutex slot_latch_;
+  // the slot of every compressed page, indexed by page id
+  std::vector<PageSlot> page_slots_;
+  // the offsets of the free slots, indexed by their number of units
+  std::vector<std::vector<off_t>> free_slots_;
+  // the end of the last slot in the database file
+  off_t slots_end_ = 0;
+  uint64_t next_write_seq_ = 1;
+
+  // the directory of the capacity tier, empty if the disk manager is not tiered
+  std::string capacity_dir_;
+  // the tiers of the extents are saved to this file
+  std::string tier_name_;
+  // the file descriptors of the capacity tier files, indexed by segment and protected by segment_latch_, -1 if none
+  std::vector<int> capacity_fds_;
+  // protects tiers_ and heat_
+  std::mutex tier_latch_;
+  // the tier of every extent, extents past the end are in the performance tier
+  std::vector<StorageTier> tiers_;
+  // the accesses to every extent, halved by every migration pass
+  std::vector<uint32_t> heat_;
+  // page I/O holds the latch of its extent shared, a move holds it exclusively; extent e uses latch e % size
+  std::array<std::shared_mutex, 64> extent_latches_;
+  // serializes the migration passes
+  std::mutex migration_latch_;
+  // protects stop_migrations_, with migration_cv_ waking up the migration thread
+  std::mutex migration_thread_latch_;
+  std::condition_variable migration_cv_;
+  bool stop_migrations_ = false;
+  std::thread migration_thread_;
+  std::atomic<uint64_t> num_migrations_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring.h
+//
+// Identification: src/include/storage/disk/io_uring.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
+namespace bustub {
+
+/**
+ * IoUring submits reads and writes to the kernel through an io_uring, without linking against liburing.
+ *
+ * Any thread can submit; the submission queue is shared and protected by a latch. A completion thread reaps the
+ * completion queue and fulfills the future of every request. At most queue_depth requests are in flight, further
+ * submissions wait for a slot, so the completion queue can never overflow.
+ */
+class IoUring {
+ public:
+  /** Decides whether a request succeeded from its result, the number of bytes transferred or -errno. */
+  using completion_fn = std::function<bool(int result)>;
+
+  /**
+   * Sets up a new io_uring. Check IsAvailable() afterwards: kernels without io_uring, or sandboxes that forbid it, make
+   * the setup fail.
+   * @param queue_depth the maximum number of requests in flight
+   */
+  explicit IoUring(unsigned queue_depth);
+
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  /** Waits for the requests in flight, then tears the ring down. */
+  ~IoUring();
+
+  /** @return true if the ring was set up and accepts requests */
+  bool IsAvailable() const { return ring_fd_ >= 0; }
+
+  /**
+   * Submits a positional read.
+   * @param fd the file to read from
+   * @param data the buffer, which must stay valid until the future is ready
+   * @param len the number of bytes to read
+   * @param offset the offset in the file
+   * @param complete decides on the completion thread whether the read succeeded
+   * @return the future of the read
+   */
+  std::future<bool> Read(int fd, char *data, unsigned len, uint64_t offset, completion_fn complete);
+
+  /**
+   * Submits a positional write.
+   * @param fd the file to write to
+   * @param data the buffer, which must stay valid until the future is ready
+   * @param len the number of bytes to write
+   * @param offset the offset in the file
+   * @param complete decides on the completion thread whether the write succeeded
+   * @return the future of the write
+   */
+  std::future<bool> Write(int fd, const char *data, unsigned len, uint64_t offset, completion_fn complete);
+
+ private:
+  struct Request {
+    std::promise<bool> promise;
+    completion_fn complete;
+  };
+
+  /**
+   * Puts a request into the submission queue and hands it to the kernel.
+   * @param opcode IORING_OP_READ, IORING_OP_WRITE or IORING_OP_NOP
+   * @param request the request to be completed, nullptr for the NOP that stops the completion thread
+   */
+  void Submit(uint8_t opcode, int fd, const char *data, unsigned len, uint64_t offset, Request *request);
+
+  /** Reaps completions until the ring is shut down and every request in flight has completed. */
+  void RunCompletions();
+
+  int ring_fd_ = -1;
+  unsigned queue_depth_ = 0;
+
+  // The mapped rings, see io_uring_setup(2).
+  void *sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void *cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  void *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+  unsigned *sq_tail_ = nullptr;
+  unsigned *sq_mask_ = nullptr;
+  unsigned *sq_array_ = nullptr;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned *cq_mask_ = nullptr;
+  void *cqes_ = nullptr;
+
+  /** Protects the submission queue and in_flight_. */
+  std::mutex latch_;
+  std::condition_variable slot_cv_;
+  unsigned in_flight_ = 0;
+  std::thread *completion_thread_ = nullptr;
+};
+
+}  // namespace bustub
@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// spill_file.h
+//
+// Identification: src/include/storage/disk/spill_file.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>  // NOLINT
+#include <memory>
+#include <string>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class SpillFileManager;
+
+/**
+ * SpillFile is a temporary file that an operator appends bytes to and later reads back, e.g. a partition of a hash
+ * join that spilled, see TmpTupleRun. It bypasses the buffer pool: appends fill a block buffer of its own that is
+ * written to the file as a whole, at an offset that is a multiple of the block size, and sequential reads are served
+ * from a block buffer while the next block is read ahead in the background.
+ *
+ * The file is unlinked as soon as it is created, so that it goes away when it is closed, at the latest when the
+ * process exits.
+ */
+class SpillFile {
+ public:
+  ~SpillFile();
+
+  DISALLOW_COPY_AND_MOVE(SpillFile);
+
+  /** Appends bytes to the end of the file. */
+  void Append(const char *data, size_t size);
+
+  /** Writes what was appended but not written yet, and gives up the block buffer of the appends. */
+  void Finish();
+
+  /**
+   * Reads bytes that were appended. Reads that follow one another in the file read whole blocks, and the block after
+   * that of a read is read ahead.
+   * @return false if the bytes run past the end of the file
+   */
+  bool Read(uint64_t offset, char *data, size_t size);
+
+  /** @return the number of bytes appended */
+  uint64_t GetSize() const { return size_; }
+
+ private:
+  friend class SpillFileManager;
+
+  SpillFile(SpillFileManager *manager, int fd) : manager_(manager), fd_(fd) {}
+
+  /** Writes the block of the appends, which starts at the offset written_. */
+  void WriteBlock();
+
+  /** Loads the block that starts at the offset block * read_block_size_ into read_buffer_, unless it is there. */
+  void LoadBlock(uint64_t block);
+
+  /** Starts reading the block after the loaded one, if the memory budget leaves room for a second buffer. */
+  void ReadAhead();
+
+  /** @return the number of bytes of a block that were read into a buffer, throws if the read failed */
+  size_t ReadBlock(uint64_t block, char *buffer);
+
+  SpillFileManager *manager_;
+  int fd_;
+  uint64_t size_{0};
+  /** The bytes written to the file, a multiple of write_block_size_ until Finish(). */
+  uint64_t written_{0};
+
+  char *write_buffer_{nullptr};
+  size_t write_block_size_{0};
+
+  char *read_buffer_{nullptr};
+  size_t read_block_size_{0};
+  /** The block in read_buffer_, UINT64_MAX for none, and the number of its bytes. */
+  uint64_t read_block_{UINT64_MAX};
+  size_t read_bytes_{0};
+
+  char *ahead_buffer_{nullptr};
+  uint64_t ahead_block_{UINT64_MAX};
+  std::future<size_t> ahead_;
+};
+
+/**
+ * SpillFileManager hands out the spill files of a query, see ExecutorContext. The buffers of its files come out of a
+ * memory budget of their own rather than out of the buffer pool: a file gets a block buffer of SPILL_BLOCK_SIZE bytes
+ * while the budget has room for it, and a buffer of a single page otherwise, so that a spill always goes on; a block
+ * is only read ahead while the budget has room for its buffer.
+ */
+class SpillFileManager {
+ public:
+  /**
+   * @param directory the directory of the files, the temporary directory of the system if empty
+   * @param memory_budget the bytes that the buffers of the files may take together
+   */
+  explicit SpillFileManager(std::string directory = "", size_t memory_budget = SPILL_MEMORY_BUDGET);
+
+  DISALLOW_COPY_AND_MOVE(SpillFileManager);
+
+  ~SpillFileManager() = default;
+
+  /** @return a new empty file, throws if it could not be created */
+  std::unique_ptr<SpillFile> CreateFile();
+
+  /** @return the bytes that the buffers of the files may take together */
+  size_t GetMemoryBudget() const { return memory_budget_; }
+
+  void SetMemoryBudget(size_t bytes) { memory_budget_ = bytes; }
+
+  /** @return the bytes that the buffers of the files take now */
+  size_t GetMemoryUsed() const { return memory_used_.load(); }
+
+ private:
+  friend class SpillFile;
+
+  /**
+   * Allocates a buffer aligned to PAGE_SIZE.
+   * @param[out] size SPILL_BLOCK_SIZE if the budget has room for it, PAGE_SIZE otherwise
+   * @param required false if the buffer is only worth it in full, nullptr is then returned instead of a small one
+   */
+  char *AllocateBuffer(size_t *size, bool required);
+
+  void FreeBuffer(char *buffer, size_t size);
+
+  std::string directory_;
+  size_t memory_budget_;
+  std::atomic<size_t> memory_used_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree.h
+//
+// Identification: src/include/storage/index/b_plus_tree.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "storage/index/index_iterator.h"
+#include "storage/page/b_plus_tree_internal_page.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+#define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
+
+/** The pages that a pessimistic insert or remove of a B+ tree holds write latched, from the top down. */
+struct BPlusTreeContext {
+  // the header page, while the root may change
+  WritePageGuard header_guard_;
+  page_id_t root_page_id_{INVALID_PAGE_ID};
+  std::deque<WritePageGuard> write_set_;
+  // pages that were merged away, which are deleted once all the latches are let go of
+  std::vector<page_id_t> deleted_page_ids_;
+
+  bool IsRootPage(page_id_t page_id) const { return page_id == root_page_id_; }
+};
+
+/**
+ * Main class providing the API for the interactive B+ tree. Only unique keys are supported. Supports insert and
+ * remove; the pages split and merge as needed.
+ *
+ * Concurrency is by latch crabbing. An insert or remove first read latches its way down and only write latches the
+ * leaf; if the leaf would split or underflow, it starts over and write latches its way down, letting go of the pages
+ * above the last one that is safe, i.e. that would not split or underflow. The header page, which names the root, is
+ * latched like the parent of the root.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTree {
+  using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
+ public:
+  /**
+   * Creates a new, empty BPlusTree.
+   * @param name the name of the index
+   * @param buffer_pool_manager buffer pool manager to be used
+   * @param comparator comparator for keys
+   * @param leaf_max_size the number of keys beyond which a leaf splits
+   * @param internal_max_size the number of children beyond which an internal page splits
+   */
+  explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                     int leaf_max_size = LEAF_PAGE_SIZE - 1, int internal_max_size = INTERNAL_PAGE_SIZE - 1);
+
+  /** @return true if the tree holds no keys */
+  bool IsEmpty();
+
+  /**
+   * Inserts a key-value pair into the tree.
+   * @return false if the key is present already
+   */
+  bool Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  /** Removes a key and its value from the tree, if it is present. */
+  void Remove(const KeyType &key, Transaction *transaction = nullptr);
+
+  /**
+   * Performs a point query on the tree.
+   * @param[out] result the value of the key is appended to it
+   * @return true if the key is present
+   */
+  bool GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr);
+
+  /**
+   * Builds the tree bottom up from pairs sorted by key, which is much faster than inserting them one at a time. The
+   * pages are filled evenly, as full as their max sizes allow.
+   * @param items the pairs, in strictly increasing key order
+   * @return false if the tree is not empty or the pairs are not sorted
+   */
+  bool BulkLoad(const std::vector<MappingType> &items);
+
+  /** @return the page id of the root, INVALID_PAGE_ID for an empty tree */
+  page_id_t GetRootPageId();
+
+  /** @return an iterator at the first pair */
+  INDEXITERATOR_TYPE Begin();
+
+  /** @return an iterator at the first pair whose key is not less than key */
+  INDEXITERATOR_TYPE Begin(const KeyType &key);
+
+  /** @return the iterator past the last pair */
+  INDEXITERATOR_TYPE End() { return INDEXITERATOR_TYPE(); }
+
+ private:
+  enum class Operation { INSERT, REMOVE };
+
+  using Context = BPlusTreeContext;
+
+  /** @return true if an operation on a page can not make it split or underflow */
+  static bool IsSafe(const BPlusTreePage *page, Operation operation, bool is_root);
+
+  /**
+   * Read latches its way down to the leaf of a key.
+   * @param key the key, nullptr for the leftmost leaf
+   * @return the read latched leaf, an empty guard if the tree is empty
+   */
+  ReadPageGuard FindLeafRead(const KeyType *key);
+
+  /**
+   * Read latches its way down to the leaf of a key, and applies an operation to it under its write latch if the
+   * operation is safe for it.
+   * @param leaf_op called as leaf_op(LeafPage *)
+   * @return false if the tree is empty or the leaf is not safe, leaf_op was not called then
+   */
+  template <class LeafOp>
+  bool TryOptimistic(const KeyType &key, Operation operation, LeafOp &&leaf_op);
+
+  /** Write latches its way down to the leaf of a key, see BPlusTreeContext. The tree is not empty. */
+  void FindLeafWrite(const KeyType &key, Operation operation, Context *context);
+
+  /** @return a new page, write latched; throws if the buffer pool has no frame for it */
+  WritePageGuard NewPage(page_id_t *page_id);
+
+  /**
+   * Inserts the separator of a page that split into the parent of the page, the last page of the context, splitting
+   * the parent in turn if need be. The page is released.
+   */
+  void InsertIntoParent(Context *context, const KeyType &key, page_id_t right_page_id);
+
+  /**
+   * Fixes the underflow of the last page of the context, which is released: the root shrinks, or the page borrows a
+   * pair from a sibling, or merges with it, in which case its parent may underflow in turn.
+   */
+  void HandleUnderflow(Context *context);
+
+  // member variable
+  std::string index_name_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  int leaf_max_size_;
+  int internal_max_size_;
+  page_id_t header_page_id_;
+};
+
+}  // namespace bustub
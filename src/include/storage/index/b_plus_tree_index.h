@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_index.h
+//
+// Identification: src/include/storage/index/b_plus_tree_index.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/index.h"
+
+namespace bustub {
+
+#define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeIndex : public Index {
+ public:
+  BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager);
+
+  ~BPlusTreeIndex() override = default;
+
+  void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  /** Inserts the entries in key order, so that the inserts into a leaf follow each other while it is still cached. */
+  void InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) override;
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+  /**
+   * Builds the index from entries sorted by key, see BPlusTree::BulkLoad().
+   * @return false if the index is not empty or the entries are not sorted
+   */
+  bool BulkLoad(const std::vector<std::pair<Tuple, RID>> &entries);
+
+  /** @return an iterator at the first entry */
+  INDEXITERATOR_TYPE GetBeginIterator();
+
+  /** @return an iterator at the first entry whose key is not less than key */
+  INDEXITERATOR_TYPE GetBeginIterator(const KeyType &key);
+
+  /** @return the iterator past the last entry */
+  INDEXITERATOR_TYPE GetEndIterator();
+
+ protected:
+  /** Sets an index key from a key tuple, normalized if the keys of the tree are, see GenericComparator. */
+  void MakeKey(const Tuple &key, KeyType *index_key) const {
+    if (comparator_.IsNormalized()) {
+      index_key->SetFromNormalizedKey(key, GetKeySchema());
+    } else {
+      index_key->SetFromKey(key);
+    }
+  }
+
+  // comparator for key, of normalized keys if they fit
+  KeyComparator comparator_;
+  // container
+  BPlusTree<KeyType, ValueType, KeyComparator> container_;
+};
+
+}  // namespace bustub
@@ -12,9 +12,17 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <string>
+#include <vector>
 
+#include "common/macros.h"
+#include "storage/index/key_normalizer.h"
 #include "storage/table/tuple.h"
+#include "type/limits.h"
+#include "type/type_kernels.h"
 #include "type/value.h"
 
 namespace bustub {
@@ -25,16 +33,35 @@ namespace bustub {
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * The data is either the key tuple, see SetFromKey(), or its normalized form, see SetFromNormalizedKey(), which a
+ * GenericComparator of normalized keys compares by memcmp().
  */
 template <size_t KeySize>
 class GenericKey {
  public:
   inline void SetFromKey(const Tuple &tuple) {
-    // intialize to 0
+    // Only the bytes behind the key tuple are zeroed, rather than the whole key before it is copied in.
+    const size_t length = std::min<size_t>(tuple.GetLength(), KeySize);
+    memcpy(data_, tuple.GetData(), length);
+    memset(data_ + length, 0, KeySize - length);
+  }
+
+  /** Sets the key to the normalized form of a key tuple, see KeyNormalizer, which must fit the key. */
+  inline void SetFromNormalizedKey(const Tuple &tuple, const Schema *key_schema) {
+    std::string key;
+    for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+      KeyNormalizer::Append(tuple.GetValueView(key_schema, i), false, &key);
+    }
+    BUSTUB_ASSERT(key.size() <= KeySize, "A normalized key must fit the key.");
+    // The normalized keys of a schema are no prefixes of each other, so the zero bytes behind them compare the same.
     memset(data_, 0, KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+    memcpy(data_, key.data(), key.size());
   }
 
+  /** @return true if the normalized keys of a schema fit the key, so that a GenericComparator may compare them */
+  static bool FitsNormalized(const Schema &key_schema) { return KeyNormalizer::GetMaxLength(key_schema) <= KeySize; }
+
   // NOTE: for test purpose only
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
@@ -72,21 +99,33 @@ class GenericKey {
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * A key of integer columns only is compared in place, without a Value per column: the columns are read at the offsets
+ * and widths that the comparator works out of the key schema once, and compared without a branch on their values. A
+ * null is neither less nor greater than any value of its column, as in Value::CompareLessThan(), so that the columns
+ * after it decide.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline int operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const {
+    if (normalized_) {
+      return memcmp(lhs.data_, rhs.data_, KeySize);
+    }
+    if (!integer_columns_.empty()) {
+      return CompareIntegers(lhs.data_, rhs.data_);
+    }
     uint32_t column_count = key_schema_->GetColumnCount();
 
     for (uint32_t i = 0; i < column_count; i++) {
       Value lhs_value = (lhs.ToValue(key_schema_, i));
       Value rhs_value = (rhs.ToValue(key_schema_, i));
 
-      if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
+      // The values are of the types of the key schema, whose kernels compare them without a virtual call.
+      if (kernels_[i]->compare_less_than_(lhs_value, rhs_value) == CmpBool::CmpTrue) {
         return -1;
       }
-      if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
+      if (kernels_[i]->compare_less_than_(rhs_value, lhs_value) == CmpBool::CmpTrue) {
         return 1;
       }
     }
@@ -94,13 +133,92 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_},
+        normalized_{other.normalized_},
+        kernels_{other.kernels_},
+        integer_columns_{other.integer_columns_} {}
+
+  /**
+   * @param key_schema the schema of the key tuples
+   * @param normalized true if the keys are normalized, see GenericKey::SetFromNormalizedKey(), and compare by memcmp()
+   */
+  explicit GenericComparator(Schema *key_schema, bool normalized = false)
+      : key_schema_(key_schema), normalized_(normalized) {
+    for (const Column &column : key_schema_->GetColumns()) {
+      kernels_.push_back(&TypeKernels::Get(column.GetType()));
+    }
+    for (uint32_t i = 0; !normalized_ && i < key_schema_->GetColumnCount(); i++) {
+      const ColumnLayout &layout = key_schema_->GetColumnLayout(i);
+      const auto size = static_cast<uint8_t>(key_schema_->GetColumn(i).GetFixedLength());
+      const bool integer = layout.type_id_ == TypeId::TINYINT || layout.type_id_ == TypeId::SMALLINT ||
+                           layout.type_id_ == TypeId::INTEGER || layout.type_id_ == TypeId::BIGINT;
+      if (!integer || layout.offset_ + size > KeySize) {
+        integer_columns_.clear();
+        break;
+      }
+      integer_columns_.push_back(IntegerColumn{layout.offset_, size});
+    }
+  }
+
+  /** @return true if the keys are normalized */
+  bool IsNormalized() const { return normalized_; }
 
-  // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  /** @return true if the keys are of integer columns only, which are compared in place */
+  bool IsInteger() const { return !integer_columns_.empty(); }
 
  private:
+  /** Where an integer column of the key sits, and how many bytes it takes. */
+  struct IntegerColumn {
+    uint32_t offset_;
+    uint8_t size_;
+  };
+
+  /**
+   * @return -1, 0 or 1 as the integer of type T at lhs is less than, equal to or greater than that at rhs, and 0 if
+   * either is the null of the type
+   */
+  template <class T, T Null>
+  static inline int CompareAt(const char *lhs, const char *rhs) {
+    T a;
+    T b;
+    memcpy(&a, lhs, sizeof(T));
+    memcpy(&b, rhs, sizeof(T));
+    const int cmp = static_cast<int>(a > b) - static_cast<int>(a < b);
+    return cmp & -static_cast<int>(a != Null && b != Null);
+  }
+
+  inline int CompareIntegers(const char *lhs, const char *rhs) const {
+    int result = 0;
+    for (const IntegerColumn &column : integer_columns_) {
+      const char *a = lhs + column.offset_;
+      const char *b = rhs + column.offset_;
+      int cmp;
+      switch (column.size_) {
+        case sizeof(int8_t):
+          cmp = CompareAt<int8_t, BUSTUB_INT8_NULL>(a, b);
+          break;
+        case sizeof(int16_t):
+          cmp = CompareAt<int16_t, BUSTUB_INT16_NULL>(a, b);
+          break;
+        case sizeof(int32_t):
+          cmp = CompareAt<int32_t, BUSTUB_INT32_NULL>(a, b);
+          break;
+        default:
+          cmp = CompareAt<int64_t, BUSTUB_INT64_NULL>(a, b);
+          break;
+      }
+      // The first column that differs decides: a later one is masked out once the result is set.
+      result |= cmp & -static_cast<int>(result == 0);
+    }
+    return result;
+  }
+
   Schema *key_schema_;
+  bool normalized_;
+  std::vector<const TypeKernels *> kernels_;
+  /** The columns of a key of integer columns only, empty for other keys and normalized ones. */
+  std::vector<IntegerColumn> integer_columns_;
 };
 
 }  // namespace bustub
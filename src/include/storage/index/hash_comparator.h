@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include "common/util/hash_util.h"
+
 namespace bustub {
 
 /**
@@ -31,6 +31,7 @@ namespace bustub {
  * the index key, so it is the index's responsibility to maintain such a
  * mapping relation and does the conversion between tuple key and index key
  */
+class MetricsSnapshot;
 class Transaction;
 class IndexMetadata {
  public:
@@ -132,11 +133,40 @@ class Index {
   // designed for secondary indexes.
   virtual void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
+  // insert the entries of a batch, keys[i] for rids[i], as if one at a time in order; an index that can do better with
+  // a whole batch overrides this
+  virtual void InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      InsertEntry(keys[i], rids[i], transaction);
+    }
+  }
+
   // delete the index entry linked to given tuple
   virtual void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
+  // delete the entries of a batch, keys[i] for rids[i]; by default one at a time, see InsertEntries()
+  virtual void DeleteEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      DeleteEntry(keys[i], rids[i], transaction);
+    }
+  }
+
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  // look up several keys at once, the rids of keys[i] are appended to (*results)[i]; an index that can overlap the
+  // lookups of a batch overrides this, by default the keys are looked up one at a time
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                        Transaction *transaction) {
+    results->resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*results)[i], transaction);
+    }
+  }
+
+  // add the metrics of the index to a snapshot, each with the given labels, see MetricsRegistry; an index that keeps
+  // metrics overrides this, by default there are none
+  virtual void CollectMetrics([[maybe_unused]] MetricsSnapshot *snapshot, [[maybe_unused]] const std::string &labels) {}
+
  private:
   //===--------------------------------------------------------------------===//
   //  Data members
@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_iterator.h
+//
+// Identification: src/include/storage/index/index_iterator.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+#define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
+
+/**
+ * Iterates over the pairs of a B+ tree in key order, following the sibling links of its leaves. The iterator keeps
+ * its leaf read latched; it latches the next leaf before it lets go of the current one, which is the order in which
+ * the tree latches neighbouring leaves too.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class IndexIterator {
+ public:
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
+  /** Creates the end iterator. */
+  IndexIterator() = default;
+
+  /**
+   * Creates an iterator at a pair of a leaf, or at the first pair of the leaves after it if index is past its end.
+   * @param bpm the buffer pool of the tree
+   * @param guard the read latched leaf, an empty guard for the end iterator
+   * @param index the index of the pair in the leaf
+   */
+  IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index);
+
+  /** @return true if the iterator is past the last pair */
+  bool IsEnd() const { return !guard_.IsValid(); }
+
+  /** @return the pair that the iterator is at */
+  const MappingType &operator*() const { return guard_.As<LeafPage>()->GetItem(index_); }
+
+  /** Moves the iterator to the next pair. */
+  IndexIterator &operator++();
+
+  bool operator==(const IndexIterator &itr) const {
+    return guard_.PageId() == itr.guard_.PageId() && index_ == itr.index_;
+  }
+
+  bool operator!=(const IndexIterator &itr) const { return !(*this == itr); }
+
+ private:
+  /** Moves on to the next leaf for as long as the iterator is past the end of its leaf. */
+  void SkipExhaustedLeaves();
+
+  BufferPoolManager *bpm_{nullptr};
+  ReadPageGuard guard_;
+  int index_{0};
+};
+
+}  // namespace bustub
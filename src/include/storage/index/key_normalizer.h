@@ -0,0 +1,45 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_normalizer.h
+//
+// Identification: src/include/storage/index/key_normalizer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "catalog/schema.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * KeyNormalizer turns keys of one or more values into strings of bytes that compare by memcmp() like the keys compare
+ * value by value, so that a sort or an index compares bytes instead of going through Value for every column, see
+ * SortKey and GenericComparator.
+ *
+ * A value is a byte that tells nulls, which come first, from the rest, followed by the value: integers big-endian with
+ * the sign bit flipped, decimals with the sign bit flipped or, if negative, every bit, and varchars with their zero
+ * bytes escaped and two zero bytes at the end. A descending value has every byte flipped. No normalized key of a
+ * schema is a prefix of another, so that keys padded with zero bytes to a fixed length compare the same.
+ */
+class KeyNormalizer {
+ public:
+  /** Appends the normalized form of a value to a key, with every byte flipped if it is descending. */
+  static void Append(const Value &value, bool descending, std::string *key);
+
+  /**
+   * @return the most bytes that a normalized key of the columns of a schema takes, or SIZE_MAX if a column is not of
+   * a fixed-length type
+   */
+  static size_t GetMaxLength(const Schema &schema);
+};
+
+}  // namespace bustub
@@ -13,7 +13,9 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "container/hash/hash_function.h"
@@ -27,22 +29,63 @@ namespace bustub {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTableIndex : public Index {
  public:
+  /**
+   * @param unique_keys true for an index on a unique key, e.g. a primary key, see LinearProbeHashTable
+   */
   LinearProbeHashTableIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager, size_t num_buckets,
-                            const HashFunction<KeyType> &hash_fn);
+                            const HashFunction<KeyType> &hash_fn, bool unique_keys = false);
 
   ~LinearProbeHashTableIndex() override = default;
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  /** Inserts the entries with LinearProbeHashTable::InsertBatch(), which takes the table latch once per chunk. */
+  void InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) override;
+
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  /** Deletes the entries with LinearProbeHashTable::RemoveBatch(). */
+  void DeleteEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) override;
+
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /** Looks the keys up with LinearProbeHashTable::GetValueBatch(), which overlaps the misses of their blocks. */
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                Transaction *transaction) override;
+
+  /**
+   * Builds the index from the entries of a table at once, e.g. from a scan of its heap, see
+   * LinearProbeHashTable::BulkLoad().
+   * @return false if the index is not empty or could not be built in full
+   */
+  bool BulkLoad(const std::vector<std::pair<Tuple, RID>> &entries);
+
+  /** @return false if the stats of the index could not be read, see LinearProbeHashTable::GetStats() */
+  bool GetStats(HashTableStats *stats) { return container_.GetStats(stats); }
+
+  /** Adds the buckets, pairs and tombstones of GetStats() to a snapshot, which reads all the blocks of the index. */
+  void CollectMetrics(MetricsSnapshot *snapshot, const std::string &labels) override;
+
  protected:
+  /** @return the pairs of the index keys of keys and their rids */
+  static std::vector<std::pair<KeyType, ValueType>> MakePairs(const std::vector<Tuple> &keys,
+                                                              const std::vector<RID> &rids);
+
   // comparator for key
   KeyComparator comparator_;
   // container
   LinearProbeHashTable<KeyType, ValueType, KeyComparator> container_;
 };
 
+/**
+ * Creates a hash index on the smallest GenericKey that holds the keys of an index, so that a block page holds as many
+ * pairs as it can; e.g. the pairs of a 4-byte integer key take 8 bytes rather than the 68 of a GenericKey<64>.
+ * @param metadata the metadata of the index, which the index takes over
+ * @param unique_keys true for an index on a unique key, see LinearProbeHashTable
+ * @return the index, nullptr if the keys are wider than the widest GenericKey
+ */
+std::unique_ptr<Index> CreateLinearProbeHashTableIndex(IndexMetadata *metadata,
+                                                       BufferPoolManager *buffer_pool_manager, size_t num_buckets,
+                                                       bool unique_keys = false);
+
 }  // namespace bustub
@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_internal_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_internal_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <queue>
+
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
+#define INTERNAL_PAGE_HEADER_SIZE 16
+#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+
+/**
+ * Store n indexed keys and n+1 child pointers (page_id) within internal page.
+ * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
+ * K(i) <= K < K(i+1).
+ * NOTE: since the number of keys does not equal to number of child pointers,
+ * the first key always remains invalid. That is to say, any search/lookup
+ * should ignore the first key.
+ *
+ * Internal page format (keys are stored in increasing order):
+ *  --------------------------------------------------------------------------
+ * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
+ *  --------------------------------------------------------------------------
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeInternalPage : public BPlusTreePage {
+ public:
+  /**
+   * Initializes a new internal page, which has no children yet.
+   * @param max_size the number of children beyond which the page splits, less than INTERNAL_PAGE_SIZE
+   */
+  void Init(int max_size = INTERNAL_PAGE_SIZE - 1);
+
+  /** @return the key at an index, the key at index 0 is invalid */
+  KeyType KeyAt(int index) const { return array_[index].first; }
+
+  /** Sets the key at an index. */
+  void SetKeyAt(int index, const KeyType &key) { array_[index].first = key; }
+
+  /** @return the child pointer at an index */
+  ValueType ValueAt(int index) const { return array_[index].second; }
+
+  /** @return the index of a child pointer, -1 if the page does not hold it */
+  int ValueIndex(const ValueType &value) const;
+
+  /** @return the index of the child whose subtree a key belongs in */
+  int LookupIndex(const KeyType &key, const KeyComparator &comparator) const;
+
+  /** @return the child whose subtree a key belongs in */
+  ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const {
+    return ValueAt(LookupIndex(key, comparator));
+  }
+
+  /** Makes this page a new root of two children, split at a key. */
+  void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
+
+  /** Inserts a key and the child to its right after an existing child. @return the new size */
+  int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
+
+  /** Removes the key and child at an index. */
+  void Remove(int index);
+
+  /**
+   * Appends the larger half of this page's children to an empty recipient. The key at the recipient's index 0, which
+   * is invalid there, is the key that separates the two pages in their parent.
+   */
+  void MoveHalfTo(BPlusTreeInternalPage *recipient);
+
+  /**
+   * Appends all the children of this page to its left sibling.
+   * @param middle_key the key that separates the two pages in their parent, which moves down with the children
+   */
+  void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
+
+  /**
+   * Moves the first child of this page to the end of its left sibling.
+   * @param middle_key the key that separates the two pages in their parent; the key of the moved child
+   * @return the key that is to separate the two pages afterwards
+   */
+  KeyType MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
+
+  /**
+   * Moves the last child of this page to the front of its right sibling.
+   * @param middle_key the key that separates the two pages in their parent; the key of the recipient's old first child
+   * @return the key that is to separate the two pages afterwards
+   */
+  KeyType MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
+
+  /** Appends pairs to the page, which must have room for them. The key of the first pair is invalid if it is empty. */
+  void CopyNFrom(const MappingType *items, int size);
+
+ private:
+  // Flexible array member for page data.
+  MappingType array_[0];
+};
+
+}  // namespace bustub
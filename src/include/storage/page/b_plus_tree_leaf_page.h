@@ -0,0 +1,101 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_leaf_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_leaf_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
+#define LEAF_PAGE_HEADER_SIZE 20
+#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+
+/**
+ * Store indexed key and record id(record id = page id combined with slot id,
+ * see include/common/rid.h for detailed implementation) together within leaf
+ * page. Only support unique key.
+ *
+ * Leaf page format (keys are stored in order):
+ *  ----------------------------------------------------------------------
+ * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
+ *  ----------------------------------------------------------------------
+ *
+ *  Header format (size in byte, 20 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) | NextPageId (4)
+ *  ---------------------------------------------------------------------
+ *
+ * The leaves are linked from left to right by NextPageId, for scans in key order.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeLeafPage : public BPlusTreePage {
+ public:
+  /**
+   * Initializes a new, empty leaf page.
+   * @param max_size the number of keys beyond which the page splits, less than LEAF_PAGE_SIZE
+   */
+  void Init(int max_size = LEAF_PAGE_SIZE - 1);
+
+  /** @return the page id of the right sibling, INVALID_PAGE_ID for the last leaf */
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  /** Sets the page id of the right sibling. */
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /** @return the key at an index */
+  KeyType KeyAt(int index) const { return array_[index].first; }
+
+  /** @return the pair at an index */
+  const MappingType &GetItem(int index) const { return array_[index]; }
+
+  /** @return the index of the first key that is not less than key, GetSize() if there is none */
+  int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
+
+  /**
+   * Looks up the value of a key.
+   * @param[out] value the value of the key
+   * @return true if the key is present
+   */
+  bool Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const;
+
+  /** Inserts a pair in key order, unless the key is present. @return the new size */
+  int Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
+
+  /** Removes the pair of a key, if it is present. @return the new size */
+  int RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator);
+
+  /** Moves the larger half of this page's pairs to an empty recipient, which becomes the right sibling. */
+  void MoveHalfTo(BPlusTreeLeafPage *recipient);
+
+  /** Appends all the pairs of this page to its left sibling, which takes over the right sibling of this page. */
+  void MoveAllTo(BPlusTreeLeafPage *recipient);
+
+  /** Moves the first pair of this page to the end of its left sibling. */
+  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
+
+  /** Moves the last pair of this page to the front of its right sibling. */
+  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
+
+  /** Appends pairs to the page, which must have room for them and keep it in key order. */
+  void CopyNFrom(const MappingType *items, int size);
+
+ private:
+  page_id_t next_page_id_;
+  // Flexible array member for page data.
+  MappingType array_[0];
+};
+
+}  // namespace bustub
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cassert>
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#include "common/config.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+#define MappingType std::pair<KeyType, ValueType>
+
+#define INDEX_TEMPLATE_ARGUMENTS template <typename KeyType, typename ValueType, typename KeyComparator>
+
+enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
+
+/**
+ * Both the internal and the leaf pages of a B+ tree inherit from this page. It only holds the header that they share,
+ * the pages do not point to their parents: the tree keeps the path to a page latched while it modifies the page.
+ *
+ * Header format (size in byte, 16 bytes in total):
+ * ----------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
+ * ----------------------------------------------------------
+ */
+class BPlusTreePage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  BPlusTreePage() = delete;
+  BPlusTreePage(const BPlusTreePage &other) = delete;
+  ~BPlusTreePage() = delete;
+
+  /** @return true if this is a leaf page */
+  bool IsLeafPage() const { return page_type_ == IndexPageType::LEAF_PAGE; }
+
+  /** Sets the type of this page. */
+  void SetPageType(IndexPageType page_type) { page_type_ = page_type; }
+
+  /** @return the number of keys of a leaf page, or the number of children of an internal page */
+  int GetSize() const { return size_; }
+
+  /** Sets the size of this page. */
+  void SetSize(int size) { size_ = size; }
+
+  /** Adds amount, which may be negative, to the size of this page. */
+  void IncreaseSize(int amount) { size_ += amount; }
+
+  /** @return the size beyond which this page splits */
+  int GetMaxSize() const { return max_size_; }
+
+  /** Sets the size beyond which this page splits. */
+  void SetMaxSize(int max_size) { max_size_ = max_size; }
+
+  /** @return the size below which a non-root page borrows from or merges with a sibling */
+  int GetMinSize() const { return IsLeafPage() ? max_size_ / 2 : (max_size_ + 1) / 2; }
+
+  /** @return the lsn of this page */
+  lsn_t GetLSN() const { return lsn_; }
+
+  /** Sets the LSN of this page. */
+  void SetLSN(lsn_t lsn = INVALID_LSN) { lsn_ = lsn; }
+
+ private:
+  IndexPageType page_type_;
+  lsn_t lsn_;
+  int size_;
+  int max_size_;
+};
+
+/**
+ * The header page of a B+ tree, which names its root page. It is latched by the operations that may change the root.
+ */
+class BPlusTreeHeaderPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  BPlusTreeHeaderPage() = delete;
+  BPlusTreeHeaderPage(const BPlusTreeHeaderPage &other) = delete;
+
+  page_id_t root_page_id_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// catalog_page.h
+//
+// Identification: src/include/storage/page/catalog_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/** What a catalog entry describes. */
+enum class CatalogEntryKind : uint32_t { TABLE = 1, INDEX, STATISTICS };
+
+/**
+ * An entry of the catalog directory. The metadata that it describes is serialized into a chain of OverflowPages of its
+ * own, so that the directory stays small enough to be searched without reading the metadata of every object.
+ */
+struct CatalogEntry {
+  CatalogEntryKind kind_;
+  /** The oid of the table or index, for STATISTICS the oid of their table. */
+  uint32_t oid_;
+  /** The hash of the name of the table, of the table of an index. */
+  uint64_t name_hash_;
+  /** The first page of the chain that holds the serialized metadata. */
+  page_id_t record_page_id_;
+  /** The size of the serialized metadata. */
+  uint32_t record_size_;
+};
+
+/**
+ * CatalogPage is a page of the directory of a persistent catalog, see SimpleCatalog. The directory is a chain of pages
+ * that starts at HEADER_PAGE_ID; its first page also holds the oids that the catalog hands out next. Opening the
+ * catalog only reads the first page, entries are looked up once their table is first used.
+ *
+ * CatalogPage format:
+ *
+ * Sizes are in bytes.
+ * | PageId (4) | LSN (4) | Magic (4) | NextPageId (4) | NumEntries (4) | NextTableOid (4) | NextIndexOid (4) |
+ * | Reserved (4) | CatalogEntry (24) ... |
+ */
+class CatalogPage : public Page {
+ public:
+  /** Tells a catalog page apart from a page of another kind, e.g. one of a database without a persistent catalog. */
+  static constexpr uint32_t MAGIC = 0x47544143;
+  /** The number of entries that a page holds. */
+  static constexpr uint32_t MAX_ENTRIES = (PAGE_SIZE - 32) / sizeof(CatalogEntry);
+
+  /** Initializes an empty page of the directory. */
+  void Init(page_id_t page_id) {
+    memset(GetData(), 0, SIZE_HEADER);
+    memcpy(GetData(), &page_id, sizeof(page_id_t));
+    const lsn_t lsn = INVALID_LSN;
+    memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t));
+    Store(OFFSET_MAGIC, MAGIC);
+    SetNextPageId(INVALID_PAGE_ID);
+  }
+
+  /** @return true if the page was initialized as a page of the directory */
+  bool IsCatalogPage() { return Load<uint32_t>(OFFSET_MAGIC) == MAGIC; }
+
+  /** @return the next page of the directory, INVALID_PAGE_ID for the last one */
+  page_id_t GetNextPageId() { return Load<page_id_t>(OFFSET_NEXT_PAGE_ID); }
+
+  void SetNextPageId(page_id_t next_page_id) { Store(OFFSET_NEXT_PAGE_ID, next_page_id); }
+
+  uint32_t GetNumEntries() { return Load<uint32_t>(OFFSET_NUM_ENTRIES); }
+
+  /** @return the oid of the next table, kept on the first page only */
+  uint32_t GetNextTableOid() { return Load<uint32_t>(OFFSET_NEXT_TABLE_OID); }
+
+  void SetNextTableOid(uint32_t oid) { Store(OFFSET_NEXT_TABLE_OID, oid); }
+
+  /** @return the oid of the next index, kept on the first page only */
+  uint32_t GetNextIndexOid() { return Load<uint32_t>(OFFSET_NEXT_INDEX_OID); }
+
+  void SetNextIndexOid(uint32_t oid) { Store(OFFSET_NEXT_INDEX_OID, oid); }
+
+  CatalogEntry GetEntry(uint32_t slot) { return Load<CatalogEntry>(SIZE_HEADER + slot * sizeof(CatalogEntry)); }
+
+  void SetEntry(uint32_t slot, const CatalogEntry &entry) { Store(SIZE_HEADER + slot * sizeof(CatalogEntry), entry); }
+
+  /** @return false if the page is full */
+  bool AppendEntry(const CatalogEntry &entry) {
+    const uint32_t num_entries = GetNumEntries();
+    if (num_entries == MAX_ENTRIES) {
+      return false;
+    }
+    SetEntry(num_entries, entry);
+    Store(OFFSET_NUM_ENTRIES, num_entries + 1);
+    return true;
+  }
+
+ private:
+  static_assert(sizeof(page_id_t) == 4);
+  static_assert(sizeof(CatalogEntry) == 24);
+  static constexpr size_t OFFSET_LSN = sizeof(page_id_t);
+  static constexpr size_t OFFSET_MAGIC = OFFSET_LSN + sizeof(lsn_t);
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = OFFSET_MAGIC + sizeof(uint32_t);
+  static constexpr size_t OFFSET_NUM_ENTRIES = OFFSET_NEXT_PAGE_ID + sizeof(page_id_t);
+  static constexpr size_t OFFSET_NEXT_TABLE_OID = OFFSET_NUM_ENTRIES + sizeof(uint32_t);
+  static constexpr size_t OFFSET_NEXT_INDEX_OID = OFFSET_NEXT_TABLE_OID + sizeof(uint32_t);
+  static constexpr size_t SIZE_HEADER = OFFSET_NEXT_INDEX_OID + 2 * sizeof(uint32_t);
+  static_assert(SIZE_HEADER == 32);
+
+  template <class T>
+  T Load(size_t offset) {
+    T value;
+    memcpy(static_cast<void *>(&value), GetData() + offset, sizeof(T));
+    return value;
+  }
+
+  template <class T>
+  void Store(size_t offset, const T &value) {
+    memcpy(GetData() + offset, &value, sizeof(T));
+  }
+};
+
+}  // namespace bustub
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// columnar_table_page.h
+//
+// Identification: src/include/storage/page/columnar_table_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/rid.h"
+#include "storage/page/page.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * Columnar (PAX) page format, for the tuples of a schema whose columns are all of fixed width:
+ *  ------------------------------------------------------------------------------
+ *  | HEADER | COLUMN_1 MINIPAGE | COLUMN_2 MINIPAGE | ... | COLUMN_N MINIPAGE | |
+ *  ------------------------------------------------------------------------------
+ *
+ *  The header is that of a TablePage, of which the page ids, the LSN and the tuple count are used. The header methods
+ *  of TablePage, and the log records of whole pages, thus work on both kinds of pages.
+ *
+ *  A page has room for GetCapacity() tuples. The minipage of a column holds the values of the column of all of them,
+ *  side by side: the column at offset o of a tuple of the schema starts at HEADER + capacity * o, and the value of the
+ *  tuple in slot s at s * width past that. A scan of a column reads one contiguous array per page.
+ *
+ *  Tuples are only ever appended, by bulk loads, so the slots below the tuple count hold a live tuple each.
+ */
+class ColumnarTablePage : public Page {
+ public:
+  /** @return the number of tuples of a schema that a page holds */
+  static uint32_t GetCapacity(const Schema &schema) {
+    return static_cast<uint32_t>((PAGE_SIZE - SIZE_TABLE_PAGE_HEADER) / schema.GetLength());
+  }
+
+  /** @return the page ID of this table page */
+  page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData()); }
+
+  /** @return the number of tuples in this page */
+  uint32_t GetTupleCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
+
+  /**
+   * Appends a tuple behind the last one, see TablePage::AppendTuple(). The tuple is neither locked nor logged.
+   * @param schema the schema of the tuples of the page, which are all inlined
+   * @param tuple tuple to append
+   * @param[out] rid rid of the appended tuple
+   * @return true if the append is successful (i.e. the page is not full)
+   */
+  bool AppendTuple(const Schema &schema, const Tuple &tuple, RID *rid);
+
+  /** @return the values of a column of the tuples of the page, the i'th at i times the width of the column */
+  const char *GetColumnData(const Schema &schema, uint32_t col_idx) {
+    return GetData() + SIZE_TABLE_PAGE_HEADER + GetCapacity(schema) * schema.GetColumn(col_idx).GetOffset();
+  }
+
+  /**
+   * Read a tuple from the raw data of a columnar page, see TablePage::CopyTuple(): its columns are gathered from the
+   * minipages into a row.
+   * @return true if the slot holds a tuple
+   */
+  static bool CopyTuple(const char *data, const Schema &schema, const RID &rid, Tuple *tuple);
+
+  /**
+   * Reads the tuples of the page as rows, see TablePage::ScanTuples(). Each is gathered into a buffer first.
+   * @param fn called as fn(rid, data, size) for every tuple, data being valid only for the call
+   */
+  template <class Fn>
+  void ScanTuples(const Schema &schema, Fn &&fn) {
+    const uint32_t tuple_count = GetTupleCount();
+    std::vector<char> row(schema.GetLength());
+    for (uint32_t slot_num = 0; slot_num < tuple_count; slot_num++) {
+      GatherRow(GetData(), schema, slot_num, row.data());
+      fn(RID(GetTablePageId(), slot_num), row.data(), schema.GetLength());
+    }
+  }
+
+  /** @return true if the page holds a tuple, whose rid is then the first one */
+  bool GetFirstTupleRid(RID *first_rid);
+
+  /** @return true if a tuple follows the current one, whose rid is then the next one */
+  bool GetNextTupleRid(const RID &cur_rid, RID *next_rid);
+
+ private:
+  static_assert(sizeof(page_id_t) == 4);
+
+  /** The header of a TablePage, see table_page.h. */
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
+  static constexpr size_t OFFSET_TUPLE_COUNT = 20;
+
+  /** Copies the columns of the tuple in a slot of the data of a page into a row of the schema. */
+  static void GatherRow(const char *data, const Schema &schema, uint32_t slot_num, char *row);
+};
+
+}  // namespace bustub
@@ -12,10 +12,14 @@
 
 #pragma once
 
-#include <atomic>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include "common/config.h"
 #include "storage/index/int_comparator.h"
 #include "storage/page/hash_table_page_defs.h"
@@ -26,11 +30,19 @@ namespace bustub {
  * non-unique keys.
  *
  * Block page format (keys are stored in order):
- *  ----------------------------------------------------------------
- * | KEY(1) + VALUE(1) | KEY(2) + VALUE(2) | ... | KEY(n) + VALUE(n)
- *  ----------------------------------------------------------------
+ *  ----------------------------------------------------------------------------------------
+ * | CONTROL(1) | ... | CONTROL(n) | KEY(1) | ... | KEY(n) | VALUE(1) | ... | VALUE(n)
+ *  ----------------------------------------------------------------------------------------
+ *
+ * The keys and the values are stored in separate arrays: a probe only reads
+ * the keys, which are packed densely into cache lines, and neither array is
+ * padded for the alignment of the other.
  *
- *  Here '+' means concatenation.
+ * The control byte of a bucket is EMPTY if it was never occupied, DELETED if
+ * it holds a tombstone, and FULL plus a 7-bit fingerprint of the key if it is
+ * readable. A probe compares the control bytes of BLOCK_GROUP_SIZE buckets
+ * with one SIMD instruction, and only looks at the keys whose fingerprint
+ * matches.
  *
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -45,7 +57,7 @@ class HashTableBlockPage {
    * @param bucket_ind the index in the block to get the key at
    * @return key at index bucket_ind of the block
    */
-  KeyType KeyAt(slot_offset_t bucket_ind) const;
+  const KeyType &KeyAt(slot_offset_t bucket_ind) const { return Keys()[bucket_ind]; }
 
   /**
    * Gets the value at an index in the block.
@@ -53,22 +65,22 @@ class HashTableBlockPage {
    * @param bucket_ind the index in the block to get the value at
    * @return value at index bucket_ind of the block
    */
-  ValueType ValueAt(slot_offset_t bucket_ind) const;
+  const ValueType &ValueAt(slot_offset_t bucket_ind) const { return Values()[bucket_ind]; }
 
   /**
    * Attempts to insert a key and value into an index in the block.
-   * The insert is thread safe. It uses compare and swap to claim the index,
-   * and then writes the key and value into the index, and then marks the
-   * index as readable.
+   * It writes the key and value into the index, and then marks the index as
+   * readable. The caller holds the write latch of the page.
    *
    * @param bucket_ind index to write the key and value to
    * @param key key to insert
    * @param value value to insert
+   * @param fingerprint the 7-bit fingerprint of the key
    * @return If the value is inserted successfully, it returns true. If the
-   * index is marked as occupied before the key and value can be inserted,
-   * Insert returns false.
+   * index holds a readable key and value before the key and value can be
+   * inserted, Insert returns false. A tombstone is reused.
    */
-  bool Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value);
+  bool Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value, uint8_t fingerprint = 0);
 
   /**
    * Removes a key and value at index.
@@ -77,6 +89,11 @@ class HashTableBlockPage {
    */
   void Remove(slot_offset_t bucket_ind);
 
+  /**
+   * Empties all the buckets of the block, tombstones included. The caller holds the write latch of the page.
+   */
+  void Clear();
+
   /**
    * Returns whether or not an index is occupied (key/value pair or tombstone)
    *
@@ -93,12 +110,89 @@ class HashTableBlockPage {
    */
   bool IsReadable(slot_offset_t bucket_ind) const;
 
+  /** The number of buckets that MatchGroup() compares at once. */
+#if defined(__AVX2__)
+  static constexpr slot_offset_t BLOCK_GROUP_SIZE = 32;
+#else
+  static constexpr slot_offset_t BLOCK_GROUP_SIZE = 16;
+#endif
+
+  /** Masks of the buckets of a group, bit i for the bucket group_ind + i. */
+  struct GroupMasks {
+    uint32_t match_;     // readable, with the fingerprint
+    uint32_t readable_;  // readable
+    uint32_t empty_;     // never occupied
+  };
+
+  /**
+   * Compares the control bytes of a group of buckets with a fingerprint.
+   *
+   * @param group_ind index of the first bucket of the group, a multiple of BLOCK_GROUP_SIZE
+   * @param fingerprint the 7-bit fingerprint of the key looked for
+   * @return the masks of the group; the bits past BLOCK_ARRAY_SIZE are to be ignored
+   */
+  GroupMasks MatchGroup(slot_offset_t group_ind, uint8_t fingerprint) const {
+    const char full = static_cast<char>(FULL | fingerprint);
+#if defined(__AVX2__)
+    __m256i control = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(control_ + group_ind));
+    return {static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(control, _mm256_set1_epi8(full)))),
+            static_cast<uint32_t>(_mm256_movemask_epi8(control)),
+            static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(control, _mm256_setzero_si256())))};
+#elif defined(__SSE2__)
+    __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i *>(control_ + group_ind));
+    return {static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(full)))),
+            static_cast<uint32_t>(_mm_movemask_epi8(control)),
+            static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_setzero_si128())))};
+#else
+    GroupMasks masks{0, 0, 0};
+    for (slot_offset_t i = 0; i < BLOCK_GROUP_SIZE; i++) {
+      const uint8_t control = control_[group_ind + i];
+      masks.match_ |= static_cast<uint32_t>(control == static_cast<uint8_t>(full)) << i;
+      masks.readable_ |= static_cast<uint32_t>((control & FULL) != 0) << i;
+      masks.empty_ |= static_cast<uint32_t>(control == EMPTY) << i;
+    }
+    return masks;
+#endif
+  }
+
+  /**
+   * Hints the CPU to bring in the control bytes of the group of a bucket and the key of the bucket, where a probe
+   * that starts at the bucket looks first.
+   *
+   * @param bucket_ind index of the bucket
+   */
+  void PrefetchBucket(slot_offset_t bucket_ind) const {
+    __builtin_prefetch(control_ + bucket_ind - bucket_ind % BLOCK_GROUP_SIZE);
+    __builtin_prefetch(&Keys()[bucket_ind]);
+  }
+
  private:
-  std::atomic_char occupied_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
+  static constexpr uint8_t EMPTY = 0x00;
+  static constexpr uint8_t DELETED = 0x01;
+  static constexpr uint8_t FULL = 0x80;
+
+  /** @return a byte offset rounded up to an alignment */
+  static constexpr size_t AlignUp(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+  }
+
+  // Offsets of the key and the value arrays from the start of the page.
+  static constexpr size_t KEYS_OFFSET = AlignUp(BLOCK_CONTROL_SIZE, alignof(KeyType));
+  static constexpr size_t VALUES_OFFSET = AlignUp(KEYS_OFFSET + BLOCK_ARRAY_SIZE * sizeof(KeyType), alignof(ValueType));
+
+  const KeyType *Keys() const {
+    return reinterpret_cast<const KeyType *>(reinterpret_cast<const char *>(this) + KEYS_OFFSET);
+  }
+  KeyType *Keys() { return reinterpret_cast<KeyType *>(reinterpret_cast<char *>(this) + KEYS_OFFSET); }
+  const ValueType *Values() const {
+    return reinterpret_cast<const ValueType *>(reinterpret_cast<const char *>(this) + VALUES_OFFSET);
+  }
+  ValueType *Values() { return reinterpret_cast<ValueType *>(reinterpret_cast<char *>(this) + VALUES_OFFSET); }
+
+  // The control byte of each bucket, a zeroed page is empty. The key and the value arrays follow.
+  uint8_t control_[BLOCK_CONTROL_SIZE];
 
-  // 0 if tombstone/brand new (never occupied), 1 otherwise.
-  std::atomic_char readable_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
-  MappingType array_[0];
+  static_assert(VALUES_OFFSET + BLOCK_ARRAY_SIZE * sizeof(ValueType) <= PAGE_SIZE, "A block page must fit in a page.");
 };
 
 }  // namespace bustub
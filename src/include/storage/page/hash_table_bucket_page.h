@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_bucket_page.h
+//
+// Identification: src/include/storage/page/hash_table_bucket_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/index/int_comparator.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+/**
+ * Store indexed key and and value together within the bucket page of an
+ * extendible hash table. Supports non-unique keys, but not duplicate pairs.
+ *
+ * Bucket page format:
+ *  ----------------------------------------------------------------------
+ * | READABLE(BUCKET_ARRAY_SIZE bits) | KEY(1) + VALUE(1) | ... | KEY(n) + VALUE(n)
+ *  ----------------------------------------------------------------------
+ *
+ *  Here '+' means concatenation.
+ *
+ * Unlike a block page, a bucket needs no tombstones: it is never probed past,
+ * the whole bucket is looked at instead. A zeroed page is an empty bucket.
+ *
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class HashTableBucketPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  HashTableBucketPage() = delete;
+
+  /**
+   * Scans the bucket and collects the values that have the matching key.
+   *
+   * @param key key to look up
+   * @param cmp the comparator
+   * @param[out] result the values of the key are appended to it
+   * @return true if at least one value was found
+   */
+  bool GetValue(const KeyType &key, KeyComparator cmp, std::vector<ValueType> *result) const;
+
+  /**
+   * Inserts a key and value into the first free slot of the bucket.
+   *
+   * @param key key to insert
+   * @param value value to insert
+   * @param cmp the comparator
+   * @return false if the bucket holds the pair already, or is full
+   */
+  bool Insert(const KeyType &key, const ValueType &value, KeyComparator cmp);
+
+  /**
+   * Writes a key and value into a free slot without looking for the pair, as a split moves pairs that are known to
+   * be unique.
+   *
+   * @param bucket_ind the free slot
+   * @param key key to write
+   * @param value value to write
+   */
+  void InsertAt(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value);
+
+  /**
+   * Removes a key and value.
+   *
+   * @param key key to remove
+   * @param value value to remove
+   * @param cmp the comparator
+   * @return true if the pair was found and removed
+   */
+  bool Remove(const KeyType &key, const ValueType &value, KeyComparator cmp);
+
+  /**
+   * Removes the key and value at an index.
+   *
+   * @param bucket_ind index to remove the pair at
+   */
+  void RemoveAt(slot_offset_t bucket_ind);
+
+  /**
+   * Gets the key at an index in the bucket.
+   *
+   * @param bucket_ind the index in the bucket to get the key at
+   * @return key at index bucket_ind of the bucket
+   */
+  KeyType KeyAt(slot_offset_t bucket_ind) const;
+
+  /**
+   * Gets the value at an index in the bucket.
+   *
+   * @param bucket_ind the index in the bucket to get the value at
+   * @return value at index bucket_ind of the bucket
+   */
+  ValueType ValueAt(slot_offset_t bucket_ind) const;
+
+  /**
+   * Returns whether or not an index is readable (valid key/value pair)
+   *
+   * @param bucket_ind index to look at
+   * @return true if the index is readable, false otherwise
+   */
+  bool IsReadable(slot_offset_t bucket_ind) const;
+
+  /**
+   * @return the number of readable pairs in the bucket
+   */
+  uint32_t NumReadable() const;
+
+  /**
+   * @return true if every slot of the bucket is readable
+   */
+  bool IsFull() const { return NumReadable() == BUCKET_ARRAY_SIZE; }
+
+  /**
+   * @return true if no slot of the bucket is readable
+   */
+  bool IsEmpty() const { return NumReadable() == 0; }
+
+ private:
+  char readable_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+  MappingType array_[0];
+
+  static_assert(((BUCKET_ARRAY_SIZE - 1) / 8 + alignof(MappingType)) / alignof(MappingType) * alignof(MappingType) +
+                        BUCKET_ARRAY_SIZE * sizeof(MappingType) <=
+                    PAGE_SIZE,
+                "A bucket page must fit in a page.");
+};
+
+}  // namespace bustub
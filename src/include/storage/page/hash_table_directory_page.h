@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory_page.h
+//
+// Identification: src/include/storage/page/hash_table_directory_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+/**
+ *
+ * Directory Page for extendible hash table.
+ *
+ * Directory format (size in byte):
+ * --------------------------------------------------------------------------------------------
+ * | LSN (4) | PageId (4) | GlobalDepth (4) | LocalDepths (512) | BucketPageIds (2048) | Free (1524)
+ * --------------------------------------------------------------------------------------------
+ *
+ * Slot i of the directory points to the bucket of the keys whose hash ends in the GlobalDepth bits of i. The bucket
+ * of a slot with a local depth below the global depth is pointed to by all the slots that share its LocalDepth low
+ * bits.
+ */
+class HashTableDirectoryPage {
+ public:
+  /**
+   * @return the page ID of this page
+   */
+  page_id_t GetPageId() const;
+
+  /**
+   * Sets the page ID of this page
+   *
+   * @param page_id the page id for the page id field to be set to
+   */
+  void SetPageId(page_id_t page_id);
+
+  /**
+   * @return the lsn of this page
+   */
+  lsn_t GetLSN() const;
+
+  /**
+   * Sets the LSN of this page
+   *
+   * @param lsn the log sequence number for the lsn field to be set to
+   */
+  void SetLSN(lsn_t lsn);
+
+  /**
+   * @param bucket_idx the slot of the directory
+   * @return the page id of the bucket that the slot points to
+   */
+  page_id_t GetBucketPageId(uint32_t bucket_idx) const;
+
+  /**
+   * Points a slot of the directory to a bucket.
+   *
+   * @param bucket_idx the slot of the directory
+   * @param bucket_page_id the page id of the bucket
+   */
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
+
+  /**
+   * @param bucket_idx a slot of the directory
+   * @return the slot that differs from bucket_idx in the highest of its local depth bits, which points to the bucket
+   * that the bucket of bucket_idx split from, or merges with
+   */
+  uint32_t GetSplitImageIndex(uint32_t bucket_idx) const;
+
+  /**
+   * @return the mask of the global depth low bits of a hash, which give its slot of the directory
+   */
+  uint32_t GetGlobalDepthMask() const { return (1U << global_depth_) - 1; }
+
+  /**
+   * @return the global depth of the directory
+   */
+  uint32_t GetGlobalDepth() const { return global_depth_; }
+
+  /**
+   * Doubles the directory: the upper half of the slots points to the same buckets as the lower half.
+   */
+  void IncrGlobalDepth();
+
+  /**
+   * Halves the directory, see CanShrink().
+   */
+  void DecrGlobalDepth();
+
+  /**
+   * @return true if no bucket has a local depth as large as the global depth, then the upper half of the directory
+   * repeats its lower half
+   */
+  bool CanShrink() const;
+
+  /**
+   * @return the number of slots of the directory, 2^global depth
+   */
+  uint32_t Size() const { return 1U << global_depth_; }
+
+  /**
+   * @param bucket_idx the slot of the directory
+   * @return the local depth of the bucket that the slot points to
+   */
+  uint32_t GetLocalDepth(uint32_t bucket_idx) const;
+
+  /**
+   * Sets the local depth of a slot of the directory.
+   *
+   * @param bucket_idx the slot of the directory
+   * @param local_depth the local depth of the bucket that the slot points to
+   */
+  void SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth);
+
+  /**
+   * Asserts that the directory is consistent:
+   * (1) the local depth of every slot is at most the global depth;
+   * (2) every bucket is pointed to by 2^(global depth - local depth) slots;
+   * (3) all the slots that point to a bucket have the same local depth.
+   */
+  void VerifyIntegrity() const;
+
+ private:
+  lsn_t lsn_;
+  page_id_t page_id_;
+  uint32_t global_depth_{0};
+  uint8_t local_depths_[DIRECTORY_ARRAY_SIZE];
+  page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE];
+};
+
+static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE, "A directory page must fit in a page.");
+
+}  // namespace bustub
@@ -26,10 +26,14 @@ namespace bustub {
  *
  * Header Page for linear probing hash table.
  *
- * Header format (size in byte, 16 bytes in total):
- * -------------------------------------------------------------
- * | LSN (4) | Size (4) | PageId(4) | NextBlockIndex(4)
- * -------------------------------------------------------------
+ * The block page ids are kept in a two-level directory: the header page lists
+ * the block directory pages, each of which lists BLOCK_DIRECTORY_ARRAY_SIZE
+ * block page ids, see HashTableBlockDirectoryPage.
+ *
+ * Header format (size in byte, 40 bytes in total):
+ * ----------------------------------------------------------------------------------------
+ * | LSN (4) | Size (8) | PageId(4) | NumBlocks(8) | NumDirectories(8) | DirectoryPageIds
+ * ----------------------------------------------------------------------------------------
  */
 class HashTableHeaderPage {
  public:
@@ -70,31 +74,87 @@ class HashTableHeaderPage {
   void SetLSN(lsn_t lsn);
 
   /**
-   * Adds a block page_id to the end of header page
+   * @return the number of blocks listed by the block directory pages
+   */
+  size_t NumBlocks() const;
+
+  /**
+   * Sets the number of blocks listed by the block directory pages
+   *
+   * @param num_blocks the number of blocks
+   */
+  void SetNumBlocks(size_t num_blocks);
+
+  /**
+   * Adds a block directory page_id to the end of header page
    *
    * @param page_id page_id to be added
    */
-  void AddBlockPageId(page_id_t page_id);
+  void AddDirectoryPageId(page_id_t page_id);
 
   /**
-   * Returns the page_id of the index-th block
+   * Returns the page_id of the index-th block directory page
    *
-   * @param index the index of the block
-   * @return the page_id for the block.
+   * @param index the index of the block directory page
+   * @return the page_id for the block directory page
    */
-  page_id_t GetBlockPageId(size_t index);
+  page_id_t GetDirectoryPageId(size_t index) const;
 
   /**
-   * @return the number of blocks currently stored in the header page
+   * @return the number of block directory pages currently stored in the header page
    */
-  size_t NumBlocks();
+  size_t NumDirectories() const;
+
+  /**
+   * @return the number of block directory pages that the header page has room for
+   */
+  static size_t MaxDirectories();
+
+  /**
+   * @return the number of blocks that the directory has room for
+   */
+  static size_t MaxBlocks();
 
  private:
   __attribute__((unused)) lsn_t lsn_;
   __attribute__((unused)) size_t size_;
   __attribute__((unused)) page_id_t page_id_;
+  __attribute__((unused)) size_t num_blocks_;
   __attribute__((unused)) size_t next_ind_;
-  __attribute__((unused)) page_id_t block_page_ids_[0];
+  __attribute__((unused)) page_id_t directory_page_ids_[0];
+};
+
+/**
+ *
+ * Block directory page for linear probing hash table, the second level of the
+ * directory of block page ids. The index-th block of the table is listed by
+ * directory page index / BLOCK_DIRECTORY_ARRAY_SIZE of the header page, at
+ * index % BLOCK_DIRECTORY_ARRAY_SIZE.
+ *
+ */
+class HashTableBlockDirectoryPage {
+ public:
+  // Delete all constructor / destructor to ensure memory safety
+  HashTableBlockDirectoryPage() = delete;
+
+  /**
+   * Returns the page_id of a block listed by this page
+   *
+   * @param index the index of the block in this page
+   * @return the page_id for the block
+   */
+  page_id_t GetBlockPageId(size_t index) const;
+
+  /**
+   * Lists a block at an index of this page
+   *
+   * @param index the index of the block in this page
+   * @param page_id the page_id for the block
+   */
+  void SetBlockPageId(size_t index, page_id_t page_id);
+
+ private:
+  page_id_t block_page_ids_[BLOCK_DIRECTORY_ARRAY_SIZE];
 };
 
 }  // namespace bustub
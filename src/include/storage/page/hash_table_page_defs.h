@@ -14,11 +14,28 @@
 
 #define MappingType std::pair<KeyType, ValueType>
 
-/** BLOCK_ARRAY_SIZE is the number of (key, value) pairs that can be stored in   * a block page. It is an approximate
- * calculation based on the size of MappingType (which is a std::pair of KeyType and ValueType). For each key/value
- * pair, we need two additional bits for occupied_ and readable_. 4 * PAGE_SIZE / (4 * sizeof (MappingType) + 1) =
- * PAGE_SIZE/(sizeof (MappingType) + 0.25) because 0.25 bytes = 2 bits is the space required to maintain the occupied
- * and readable flags for a key value pair.*/
-#define BLOCK_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
+/** BLOCK_ARRAY_SIZE is the number of (key, value) pairs that can be stored in a block page. It is an approximate
+ * calculation based on the sizes of KeyType and ValueType, which are kept in separate arrays, so that no padding is
+ * needed between a key and its value. For each key/value pair, we need one additional control byte, which holds its
+ * occupied and readable flags and a fingerprint of its key. The control bytes are padded to a multiple of 32, 64
+ * bytes of the page are set aside for that and the alignment of the arrays. */
+#define BLOCK_ARRAY_SIZE ((PAGE_SIZE - 64) / (sizeof(KeyType) + sizeof(ValueType) + 1))
+
+/** The number of control bytes of a block page, BLOCK_ARRAY_SIZE rounded up so that the last group is complete. */
+#define BLOCK_CONTROL_SIZE ((BLOCK_ARRAY_SIZE + 31) / 32 * 32)
 
 #define HASH_TABLE_BLOCK_TYPE HashTableBlockPage<KeyType, ValueType, KeyComparator>
+
+/** BLOCK_DIRECTORY_ARRAY_SIZE is the number of block page ids that a block directory page of a linear probing hash
+ * table lists. */
+#define BLOCK_DIRECTORY_ARRAY_SIZE (PAGE_SIZE / sizeof(page_id_t))
+
+/** BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in an extendible hash table bucket page.
+ * Each pair takes one more bit for its readable flag. */
+#define BUCKET_ARRAY_SIZE (8 * PAGE_SIZE / (8 * sizeof(MappingType) + 1))
+
+/** DIRECTORY_ARRAY_SIZE is the number of slots of an extendible hash table directory, which bounds its global depth
+ * to 9. */
+#define DIRECTORY_ARRAY_SIZE 512
+
+#define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lsm_run_page.h
+//
+// Identification: src/include/storage/page/lsm_run_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * LsmRunPage holds entries of a sorted run of an LsmTable, in increasing order of their keys. An entry is the key and
+ * the tuple of a row, serialized as by Tuple::SerializeTo(), or the key and a tombstone for a deleted row.
+ *
+ * LsmRunPage format:
+ *
+ * Sizes are in bytes.
+ * | PageId (4) | LSN (4) | NumEntries (4) | FreeSpacePointer (4) | Entry | Entry | ... |
+ *
+ * Entry format:
+ * | Key (8) | TupleSize (4) | TupleData (TupleSize) |
+ *
+ * A tombstone has a TupleSize of TOMBSTONE and no data.
+ */
+class LsmRunPage : public Page {
+ public:
+  /** The TupleSize of a tombstone. */
+  static constexpr uint32_t TOMBSTONE = UINT32_MAX;
+  /** The bytes of entries that a page holds at most. */
+  static constexpr uint32_t CAPACITY = PAGE_SIZE - 16;
+
+  /** Initializes an empty page. */
+  void Init(page_id_t page_id) {
+    memcpy(GetData(), &page_id, sizeof(page_id_t));
+    const lsn_t lsn = INVALID_LSN;
+    memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t));
+    Store<uint32_t>(OFFSET_NUM_ENTRIES, 0);
+    Store<uint32_t>(OFFSET_FREE_SPACE, SIZE_HEADER);
+  }
+
+  /** @return the bytes that an entry takes, with a tuple of a size or a tombstone */
+  static uint32_t SpaceFor(uint32_t tuple_size) {
+    return sizeof(int64_t) + sizeof(uint32_t) + (tuple_size == TOMBSTONE ? 0 : tuple_size);
+  }
+
+  /**
+   * Appends an entry, whose key must be larger than those of the page.
+   * @param key the key of the row
+   * @param tuple the tuple of the row, serialized with its size in front, nullptr for a tombstone
+   * @return false if the page has no room for the entry
+   */
+  bool Append(int64_t key, const char *tuple) {
+    uint32_t tuple_size = TOMBSTONE;
+    if (tuple != nullptr) {
+      memcpy(&tuple_size, tuple, sizeof(uint32_t));
+    }
+    const uint32_t offset = Load<uint32_t>(OFFSET_FREE_SPACE);
+    if (offset + SpaceFor(tuple_size) > PAGE_SIZE) {
+      return false;
+    }
+    Store<int64_t>(offset, key);
+    if (tuple == nullptr) {
+      Store<uint32_t>(offset + sizeof(int64_t), TOMBSTONE);
+    } else {
+      memcpy(GetData() + offset + sizeof(int64_t), tuple, sizeof(uint32_t) + tuple_size);
+    }
+    Store<uint32_t>(OFFSET_NUM_ENTRIES, Load<uint32_t>(OFFSET_NUM_ENTRIES) + 1);
+    Store<uint32_t>(OFFSET_FREE_SPACE, offset + SpaceFor(tuple_size));
+    return true;
+  }
+
+  /** @return the number of entries of the page */
+  uint32_t GetNumEntries() { return Load<uint32_t>(OFFSET_NUM_ENTRIES); }
+
+  /**
+   * Calls a function on the entries of the page in order, until it returns false.
+   * @param fn takes the key and the serialized tuple of an entry, nullptr for a tombstone, and returns true to go on
+   */
+  template <class F>
+  void ScanEntries(F &&fn) {
+    const uint32_t num_entries = GetNumEntries();
+    uint32_t offset = SIZE_HEADER;
+    for (uint32_t i = 0; i < num_entries; i++) {
+      const auto key = Load<int64_t>(offset);
+      const auto tuple_size = Load<uint32_t>(offset + sizeof(int64_t));
+      if (!fn(key, tuple_size == TOMBSTONE ? nullptr : GetData() + offset + sizeof(int64_t))) {
+        return;
+      }
+      offset += SpaceFor(tuple_size);
+    }
+  }
+
+ private:
+  static_assert(sizeof(page_id_t) == 4);
+  static constexpr size_t OFFSET_LSN = sizeof(page_id_t);
+  static constexpr size_t OFFSET_NUM_ENTRIES = OFFSET_LSN + sizeof(lsn_t);
+  static constexpr size_t OFFSET_FREE_SPACE = OFFSET_NUM_ENTRIES + sizeof(uint32_t);
+  static constexpr size_t SIZE_HEADER = OFFSET_FREE_SPACE + sizeof(uint32_t);
+  static_assert(SIZE_HEADER == PAGE_SIZE - CAPACITY);
+
+  template <class T>
+  T Load(size_t offset) {
+    T value;
+    memcpy(&value, GetData() + offset, sizeof(T));
+    return value;
+  }
+
+  template <class T>
+  void Store(size_t offset, T value) {
+    memcpy(GetData() + offset, &value, sizeof(T));
+  }
+};
+
+}  // namespace bustub
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_page.h
+//
+// Identification: src/include/storage/page/overflow_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * OverflowPage holds a piece of a value that is stored out of line, see OverflowStore. The pieces of a value are
+ * chained from its first page to its last one.
+ *
+ * OverflowPage format:
+ *
+ * Sizes are in bytes.
+ * | PageId (4) | LSN (4) | NextPageId (4) | DataSize (4) | Data |
+ */
+class OverflowPage : public Page {
+ public:
+  /** The bytes of a value that a page holds at most. */
+  static constexpr uint32_t CAPACITY = PAGE_SIZE - 16;
+
+  /**
+   * Initializes the page with a piece of a value.
+   * @param page_id the id of this page
+   * @param next_page_id the page that holds the next piece, INVALID_PAGE_ID for the last one
+   * @param data the piece
+   * @param size the size of the piece, at most CAPACITY
+   */
+  void Init(page_id_t page_id, page_id_t next_page_id, const char *data, uint32_t size) {
+    memcpy(GetData(), &page_id, sizeof(page_id_t));
+    const lsn_t lsn = INVALID_LSN;
+    memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t));
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+    memcpy(GetData() + OFFSET_DATA_SIZE, &size, sizeof(uint32_t));
+    memcpy(GetData() + SIZE_HEADER, data, size);
+  }
+
+  /** @return the page that holds the next piece, INVALID_PAGE_ID for the last one */
+  page_id_t GetNextPageId() { return Load<page_id_t>(OFFSET_NEXT_PAGE_ID); }
+
+  /** @return the size of the piece that this page holds */
+  uint32_t GetDataSize() { return Load<uint32_t>(OFFSET_DATA_SIZE); }
+
+  /** @return the piece that this page holds */
+  const char *GetPieceData() { return GetData() + SIZE_HEADER; }
+
+ private:
+  static_assert(sizeof(page_id_t) == 4);
+  static constexpr size_t OFFSET_LSN = sizeof(page_id_t);
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = OFFSET_LSN + sizeof(lsn_t);
+  static constexpr size_t OFFSET_DATA_SIZE = OFFSET_NEXT_PAGE_ID + sizeof(page_id_t);
+  static constexpr size_t SIZE_HEADER = OFFSET_DATA_SIZE + sizeof(uint32_t);
+  static_assert(SIZE_HEADER == PAGE_SIZE - CAPACITY);
+
+  template <class T>
+  T Load(size_t offset) {
+    T value;
+    memcpy(&value, GetData() + offset, sizeof(T));
+    return value;
+  }
+};
+
+}  // namespace bustub
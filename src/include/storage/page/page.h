@@ -12,11 +12,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
+#include "common/util/contention_profiler.h"
 
 namespace bustub {
 
@@ -30,8 +33,8 @@ class Page {
   friend class BufferPoolManager;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. Allocates and zeros out the page data. */
+  Page() : owned_data_(new char[PAGE_SIZE]), data_(owned_data_.get()) { ResetMemory(); }
 
   /** Default destructor. */
   ~Page() = default;
@@ -43,19 +46,43 @@ class Page {
   inline page_id_t GetPageId() { return page_id_; }
 
   /** @return the pin count of this page */
-  inline int GetPinCount() { return pin_count_; }
+  inline int GetPinCount() {
+    // Free frames and frames that are being reused are marked with a negative pin count, see pin_count_.
+    int pin_count = pin_count_;
+    return pin_count < 0 ? 0 : pin_count;
+  }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline bool IsDirty() { return is_dirty_; }
 
-  /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  /** Acquire the page write latch. Optimistic readers of the page fail their validation until WUnlatch. */
+  inline void WLatch() {
+    BUSTUB_PROFILE_LATCH(LatchSite::PAGE_WRITE, page_id_, rwlatch_.TryWLock(), rwlatch_.WLock());
+    BeginWrite();
+  }
+
+  /**
+   * Acquire the page write latch only if nobody holds the latch, for a thread that must not wait for it.
+   * @return true if the latch was acquired
+   */
+  inline bool TryWLatch() {
+    if (!rwlatch_.TryWLock()) {
+      return false;
+    }
+    BeginWrite();
+    return true;
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    EndWrite();
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
-  inline void RLatch() { rwlatch_.RLock(); }
+  inline void RLatch() {
+    BUSTUB_PROFILE_LATCH(LatchSite::PAGE_READ, page_id_, rwlatch_.TryRLock(), rwlatch_.RLock());
+  }
 
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
@@ -75,17 +102,46 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /**
+   * Creates the page of a buffer pool frame. The data lives in the buffer pool's frame arena, which keeps it away
+   * from the metadata below and hands it out zeroed.
+   * @param data the PAGE_SIZE bytes of data of the frame
+   */
+  explicit Page(char *data) : data_(data) {}
+
+  /**
+   * Marks the start of a modification of the data, see version_. Writers are mutually exclusive: they either hold the
+   * write latch or own the frame inside the buffer pool.
+   */
+  inline void BeginWrite() {
+    version_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /** Marks the end of a modification of the data. */
+  inline void EndWrite() { version_.fetch_add(1, std::memory_order_release); }
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
+  /** The data of a page that is not part of a buffer pool. */
+  std::unique_ptr<char[]> owned_data_;
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  char *data_;
+  /** The ID of this page. Atomic because the buffer pool validates optimistic page table lookups against it. */
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  /**
+   * The pin count of this page. The buffer pool sets it to -1 while the frame is free or being reused, so that
+   * optimistic lookups, which pin a page with a compare-and-swap, can never pin a frame that changes hands.
+   */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
+  /**
+   * Seqlock style version of the data. It is odd while the data is being modified, and changes with every
+   * modification, so a reader that saw the same even version before and after reading the data read a consistent copy.
+   */
+  std::atomic<uint64_t> version_{0};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
@@ -0,0 +1,228 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard owns one pin of a page and unpins the page when it goes out of scope.
+ *
+ * Guards are move-only: moving a guard hands its pin over, and the moved-from guard becomes empty. A guard that
+ * failed to fetch or create its page is empty as well, which callers check with IsValid().
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * Creates a guard for a page that the caller has already pinned.
+   * @param bpm the buffer pool that the page was pinned in
+   * @param page the pinned page, nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+
+  /** Takes over the pin of that guard, leaving it empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Drops the pin of this guard, then takes over the pin of that guard, leaving it empty. */
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  /** Drops the pin of this guard. */
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpins the page, marking it dirty if it was modified through this guard. The guard is empty afterwards. */
+  void Drop();
+
+  /**
+   * Latches the page for reading. The pin is handed over to the returned guard and this guard becomes empty.
+   * @return the read guard of the page
+   */
+  ReadPageGuard UpgradeRead();
+
+  /**
+   * Latches the page for writing. The pin is handed over to the returned guard and this guard becomes empty.
+   * @return the write guard of the page
+   */
+  WritePageGuard UpgradeWrite();
+
+  /** @return true if the guard holds a pin */
+  bool IsValid() const { return page_ != nullptr; }
+
+  /** @return the id of the guarded page, INVALID_PAGE_ID for an empty guard */
+  page_id_t PageId() const { return page_ == nullptr ? INVALID_PAGE_ID : page_->GetPageId(); }
+
+  /** @return the guarded page */
+  Page *GetPage() const { return page_; }
+
+  /** @return the data of the guarded page */
+  char *GetData() const { return page_->GetData(); }
+
+  /** Makes the page be unpinned as dirty. */
+  void SetDirty() { is_dirty_ = true; }
+
+  /**
+   * Views the page as T. Page classes deriving from Page are cast from the page itself, all other types are laid
+   * over the page data. Modifications through the result must be reported with SetDirty().
+   * @return the page viewed as T
+   */
+  template <class T>
+  T *As() const {
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+  /**
+   * Views the page as T for modification, see As(). The page is unpinned as dirty.
+   * @return the page viewed as T
+   */
+  template <class T>
+  T *AsMut() {
+    is_dirty_ = true;
+    return As<T>();
+  }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard owns one pin and the read latch of a page, and releases both when it goes out of scope.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Creates a guard for a page that the caller has already pinned and latched for reading.
+   * @param bpm the buffer pool that the page was pinned in
+   * @param page the pinned and latched page, nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** Releases the page of this guard, then takes over the page of that guard, leaving it empty. */
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  /** Releases the page. */
+  ~ReadPageGuard() { Drop(); }
+
+  /** Releases the read latch, then unpins the page. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds the page */
+  bool IsValid() const { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page, INVALID_PAGE_ID for an empty guard */
+  page_id_t PageId() const { return guard_.PageId(); }
+
+  /** @return the data of the guarded page */
+  const char *GetData() const { return guard_.GetData(); }
+
+  /** @return the page viewed as T, see BasicPageGuard::As() */
+  template <class T>
+  T *As() const {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard owns one pin and the write latch of a page, and releases both when it goes out of scope.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Creates a guard for a page that the caller has already pinned and latched for writing.
+   * @param bpm the buffer pool that the page was pinned in
+   * @param page the pinned and latched page, nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** Releases the page of this guard, then takes over the page of that guard, leaving it empty. */
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  /** Releases the page. */
+  ~WritePageGuard() { Drop(); }
+
+  /** Releases the write latch, then unpins the page. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds the page */
+  bool IsValid() const { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page, INVALID_PAGE_ID for an empty guard */
+  page_id_t PageId() const { return guard_.PageId(); }
+
+  /** @return the data of the guarded page */
+  const char *GetData() const { return guard_.GetData(); }
+
+  /** @return the data of the guarded page for modification, the page is unpinned as dirty */
+  char *GetDataMut() {
+    guard_.SetDirty();
+    return guard_.GetData();
+  }
+
+  /** Makes the page be unpinned as dirty. */
+  void SetDirty() { guard_.SetDirty(); }
+
+  /** @return the page viewed as T, see BasicPageGuard::As() */
+  template <class T>
+  T *As() const {
+    return guard_.As<T>();
+  }
+
+  /** @return the page viewed as T for modification, the page is unpinned as dirty */
+  template <class T>
+  T *AsMut() {
+    return guard_.AsMut<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
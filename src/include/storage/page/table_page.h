@@ -48,7 +48,8 @@ class TablePage : public Page {
    * @param page_id the page ID of this table page
    * @param page_size the size of this table page
    * @param prev_page_id the previous table page ID
-   * @param log_manager the log manager in use
+   * @param log_manager the log manager in use, nullptr if the page is not logged, e.g. because it is logged with the
+   * image of the previous page of a bulk load
    * @param txn the transaction that this page is created in
    */
   void Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn);
@@ -62,6 +63,12 @@ class TablePage : public Page {
   /** @return the page ID of the next table page */
   page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
 
+  /**
+   * @note returned tuple count may be an overestimate because some slots may be empty
+   * @return at least the number of tuples in this page
+   */
+  uint32_t GetTupleCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
+
   /** Set the page id of the previous page in the table. */
   void SetPrevPageId(page_id_t prev_page_id) {
     memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
@@ -79,9 +86,77 @@ class TablePage : public Page {
    * @param txn transaction performing the insert
    * @param lock_manager the lock manager
    * @param log_manager the log manager
+   * @param oid the table that the page belongs to, see LockManager::LockExclusive()
    * @return true if the insert is successful (i.e. there is enough space)
    */
-  bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
+  bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager,
+                   table_oid_t oid = INVALID_TABLE_OID);
+
+  /**
+   * Append a tuple behind the last slot of a page that a bulk load fills. The tuple is neither locked nor logged, the
+   * page is logged as a whole with LogImage() once it is full.
+   * @param tuple tuple to append
+   * @param[out] rid rid of the appended tuple
+   * @return true if the append is successful (i.e. there is enough space)
+   */
+  bool AppendTuple(const Tuple &tuple, RID *rid);
+
+  /**
+   * Log the whole page, which holds tuples that were appended without being logged.
+   * @param next_page_id the page that the bulk load continues on, which redo initializes, or INVALID_PAGE_ID
+   * @param txn the transaction performing the bulk load
+   * @param log_manager the log manager
+   */
+  void LogImage(page_id_t next_page_id, Transaction *txn, LogManager *log_manager);
+
+  /** Remove all tuples from the page, which keeps its place in the table. Undoes a bulk load of the page. */
+  void RemoveAllTuples();
+
+  /**
+   * Empty the first page of a table heap and unlink the pages after it, see TableHeap::Truncate(). The image of the
+   * page before the truncation is logged, for undo to copy back.
+   * @param txn the transaction performing the truncation
+   * @param log_manager the log manager
+   */
+  void Truncate(Transaction *txn, LogManager *log_manager);
+
+  /** @return true if no slot of the page holds a tuple, not even one that is marked as deleted */
+  bool IsEmpty() {
+    const uint32_t tuple_count = GetTupleCount();
+    for (uint32_t slot_num = 0; slot_num < tuple_count; slot_num++) {
+      if (GetTupleSize(slot_num) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Takes away the room of an empty page that was unlinked from its table, so that an inserter that still got to it
+   * fails to insert into it. Its link to the next page stays, for the scans that are still on their way through it.
+   */
+  void MarkUnlinked() {
+    SetTupleCount(0);
+    SetFreeSpacePointer(SIZE_TABLE_PAGE_HEADER);
+  }
+
+  /**
+   * Removes the empty slots at the end of the page, which gives their room back to the inserts. The tuples keep their
+   * slots, and an insert still takes the first empty slot, i.e. the same one as before.
+   * @param keep called as keep(slot_num) for an empty slot at the end, true if it must stay, e.g. because a snapshot
+   * may still see an older version of its row
+   * @return the number of slots that were removed
+   */
+  template <class Fn>
+  uint32_t TrimEmptySlots(Fn &&keep) {
+    const uint32_t old_count = GetTupleCount();
+    uint32_t tuple_count = old_count;
+    while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0 && !keep(tuple_count - 1)) {
+      tuple_count--;
+    }
+    SetTupleCount(tuple_count);
+    return old_count - tuple_count;
+  }
 
   /**
    * Mark a tuple as deleted. This does not actually delete the tuple.
@@ -89,25 +164,32 @@ class TablePage : public Page {
    * @param txn transaction performing the delete
    * @param lock_manager the lock manager
    * @param log_manager the log manager
+   * @param oid the table that the page belongs to, see LockManager::LockExclusive()
    * @return true if marking the tuple as deleted is successful (i.e the tuple exists)
    */
-  bool MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
+  bool MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager,
+                  table_oid_t oid = INVALID_TABLE_OID);
 
   /**
-   * Update a tuple.
+   * Update a tuple. A new value of the same size overwrites the changed bytes of the old one in place, a new value of
+   * another size moves the tuples that are stored before it.
    * @param new_tuple new value of the tuple
    * @param[out] old_tuple old value of the tuple
    * @param rid rid of the tuple
    * @param txn transaction performing the update
    * @param lock_manager the lock manager
    * @param log_manager the log manager
+   * @param oid the table that the page belongs to, see LockManager::LockExclusive()
    * @return true if updating the tuple succeeded
    */
   bool UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
-                   LockManager *lock_manager, LogManager *log_manager);
+                   LockManager *lock_manager, LogManager *log_manager, table_oid_t oid = INVALID_TABLE_OID);
 
-  /** To be called on commit or abort. Actually perform the delete or rollback an insert. */
-  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+  /**
+   * To be called on commit or abort. Actually perform the delete or rollback an insert.
+   * @param[out] deleted_tuple the tuple that was removed, nullptr if it is not needed
+   */
+  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager, Tuple *deleted_tuple = nullptr);
 
   /** To be called on abort. Rollback a delete, i.e. this reverses a MarkDelete. */
   void RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
@@ -117,25 +199,64 @@ class TablePage : public Page {
    * @param rid rid of the tuple to read
    * @param[out] tuple the tuple that was read
    * @param txn transaction performing the read
-   * @param lock_manager the lock manager
+   * @param lock_manager the lock manager, nullptr if a lock on the table covers the read
+   * @param oid the table that the page belongs to, see LockManager::LockShared()
+   * @param in_place true to point the tuple at its bytes in the page instead of copying them, for a caller that keeps
+   * the page pinned and latched while it reads the tuple, see TupleRef
    * @return true if the read is successful (i.e. the tuple exists)
    */
-  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
+  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager,
+                table_oid_t oid = INVALID_TABLE_OID, bool in_place = false);
+
+  /**
+   * Read a tuple from the raw data of a table page, without any locking. Every offset is checked against the bounds of
+   * the page, so that optimistic readers, which may see a torn copy of the page, never leave it.
+   * @param data the data of the table page
+   * @param rid rid of the tuple to read
+   * @param[out] tuple the tuple that was read
+   * @return true if the slot holds a live tuple
+   */
+  static bool CopyTuple(const char *data, const RID &rid, Tuple *tuple);
+
+  /**
+   * Reads the live tuples of the page in place, without copying them out. The caller holds the latch of the page, and
+   * takes no tuple locks: it must hold a lock on the whole table instead, or run without locking.
+   * @param fn called as fn(rid, data, size) for every live tuple, data being its bytes in the page, which are only
+   * valid for the call
+   */
+  template <class Fn>
+  void ScanTuples(Fn &&fn) {
+    const uint32_t tuple_count = GetTupleCount();
+    for (uint32_t slot_num = 0; slot_num < tuple_count; slot_num++) {
+      const uint32_t tuple_size = GetTupleSize(slot_num);
+      if (!IsDeleted(tuple_size)) {
+        fn(RID(GetTablePageId(), slot_num), GetData() + GetTupleOffsetAtSlot(slot_num), tuple_size);
+      }
+    }
+  }
+
+  /** @return the size of the largest tuple that InsertTuple() has room for on this page, 0 if it has none */
+  uint32_t GetMaxInsertSize() {
+    const uint32_t free_space = GetFreeSpaceRemaining();
+    return free_space > SIZE_TUPLE ? free_space - SIZE_TUPLE : 0;
+  }
 
   /** @return the rid of the first tuple in this page */
 
   /**
    * @param[out] first_rid the RID of the first tuple in this page
+   * @param empty_slots true to also return slots without a live tuple, which a snapshot may see an older version of
    * @return true if the first tuple exists, false otherwise
    */
-  bool GetFirstTupleRid(RID *first_rid);
+  bool GetFirstTupleRid(RID *first_rid, bool empty_slots = false);
 
   /**
    * @param cur_rid the RID of the current tuple
    * @param[out] next_rid the RID of the tuple following the current tuple
+   * @param empty_slots true to also return slots without a live tuple, which a snapshot may see an older version of
    * @return true if the next tuple exists, false otherwise
    */
-  bool GetNextTupleRid(const RID &cur_rid, RID *next_rid);
+  bool GetNextTupleRid(const RID &cur_rid, RID *next_rid, bool empty_slots = false);
 
  private:
   static_assert(sizeof(page_id_t) == 4);
@@ -157,12 +278,6 @@ class TablePage : public Page {
     memcpy(GetData() + OFFSET_FREE_SPACE, &free_space_pointer, sizeof(uint32_t));
   }
 
-  /**
-   * @note returned tuple count may be an overestimate because some slots may be empty
-   * @return at least the number of tuples in this page
-   */
-  uint32_t GetTupleCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
-
   /** Set the number of tuples in this page. */
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
@@ -1,16 +1,18 @@
 #pragma once
 
+#include <cstring>
+
 #include "storage/page/page.h"
 #include "storage/table/tmp_tuple.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
-// To pass the test cases for this class, you must follow the existing TmpTuplePage format and implement the
-// existing functions exactly as they are! It may be helpful to look at TablePage.
-// Remember that this task is optional, you get full credit if you finish the next task.
-
 /**
+ * TmpTuplePage holds tuples that an operator keeps around for a while, e.g. the build side of a hash join, so that they
+ * live in the buffer pool rather than in memory of their own. The tuples are appended from the end of the page
+ * towards its header and are never removed.
+ *
  * TmpTuplePage format:
  *
  * Sizes are in bytes.
@@ -20,14 +22,69 @@ namespace bustub {
  */
 class TmpTuplePage : public Page {
  public:
-  void Init(page_id_t page_id, uint32_t page_size) {}
+  /** Initializes an empty page. */
+  void Init(page_id_t page_id, uint32_t page_size) {
+    memcpy(GetData(), &page_id, sizeof(page_id_t));
+    const lsn_t lsn = INVALID_LSN;
+    memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t));
+    SetFreeSpacePointer(page_size);
+  }
+
+  /** @return the bytes that a tuple takes up in a page */
+  static uint32_t SpaceFor(const Tuple &tuple) { return sizeof(uint32_t) + tuple.GetLength(); }
+
+  /** @return the bytes that an empty page of a size has room for */
+  static uint32_t RoomOf(uint32_t page_size) { return page_size - SIZE_HEADER; }
 
-  page_id_t GetTablePageId() { return INVALID_PAGE_ID; }
+  /** @return the page ID of this page */
+  page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData()); }
 
-  bool Insert(const Tuple &tuple, TmpTuple *out) { return false; }
+  /**
+   * Appends a tuple to the page.
+   * @param[out] out where the tuple went, its offset is that of its size
+   * @return false if the page has no room for the tuple
+   */
+  bool Insert(const Tuple &tuple, TmpTuple *out) {
+    const uint32_t size = tuple.GetLength();
+    const uint32_t free_space_pointer = GetFreeSpacePointer();
+    if (free_space_pointer < SIZE_HEADER + sizeof(uint32_t) + size) {
+      return false;
+    }
+    const uint32_t offset = free_space_pointer - size - sizeof(uint32_t);
+    memcpy(GetData() + offset, &size, sizeof(uint32_t));
+    memcpy(GetData() + offset + sizeof(uint32_t), tuple.GetData(), size);
+    SetFreeSpacePointer(offset);
+    *out = TmpTuple(GetTablePageId(), offset);
+    return true;
+  }
+
+  /**
+   * @param offset the offset of a tuple, see Insert()
+   * @return a copy of the tuple
+   */
+  Tuple Get(size_t offset) {
+    Tuple tuple;
+    tuple.DeserializeFrom(GetData() + offset);
+    return tuple;
+  }
+
+  /** @return the offset of the tuple that was inserted last, the page size if there is none */
+  uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
+
+  /** @return the offset of the tuple that was inserted before the one at an offset, the page size if there is none */
+  uint32_t GetNextOffset(uint32_t offset) {
+    return offset + sizeof(uint32_t) + *reinterpret_cast<uint32_t *>(GetData() + offset);
+  }
 
  private:
   static_assert(sizeof(page_id_t) == 4);
+  static constexpr size_t OFFSET_LSN = sizeof(page_id_t);
+  static constexpr size_t OFFSET_FREE_SPACE = OFFSET_LSN + sizeof(lsn_t);
+  static constexpr size_t SIZE_HEADER = OFFSET_FREE_SPACE + sizeof(uint32_t);
+
+  void SetFreeSpacePointer(uint32_t free_space_pointer) {
+    memcpy(GetData() + OFFSET_FREE_SPACE, &free_space_pointer, sizeof(uint32_t));
+  }
 };
 
 }  // namespace bustub
@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// column_dictionary.h
+//
+// Identification: src/include/storage/table/column_dictionary.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "type/limits.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * ColumnDictionary encodes the strings of a VARCHAR column of a columnar table as codes, see
+ * TableHeap::UseColumnarLayout(): the pages of the table hold the 4-byte code of every value, which the dictionary
+ * maps back to its string. The codes count up from 0 in the order that the strings are first seen, so they keep the
+ * equality of the strings but not their order. A null is coded as BUSTUB_INT32_NULL.
+ *
+ * It is meant for columns of a handful of distinct strings, e.g. a status or a country: a comparison of such a column
+ * with a string for equality compares codes, see FilterKernel, and the strings are only looked up for the rows that
+ * are read, as views of the strings of the dictionary, which live as long as it does.
+ *
+ * Like the pages of a columnar table, the dictionary is only written by bulk loads, which lock the table exclusively,
+ * so its readers do not latch it.
+ */
+class ColumnDictionary {
+ public:
+  /** @return the code of a string, which gets the next code if it is new */
+  int32_t Encode(std::string_view str);
+
+  /** @return the code of a string, -1 if the dictionary does not have it */
+  int32_t Find(std::string_view str) const {
+    auto it = codes_.find(str);
+    return it == codes_.end() ? -1 : it->second;
+  }
+
+  /** @return the string of a code as a VARCHAR value that borrows it (see Value::GetView), a null for a null code */
+  Value Decode(int32_t code) const {
+    if (code == BUSTUB_INT32_NULL) {
+      return Value(TypeId::VARCHAR, nullptr, BUSTUB_VALUE_NULL, false);
+    }
+    const std::string &str = strings_[code];
+    // The terminating zero of the string is part of the value.
+    return Value(TypeId::VARCHAR, str.c_str(), static_cast<uint32_t>(str.size() + 1), false);
+  }
+
+  /** @return the number of distinct strings */
+  size_t GetSize() const { return strings_.size(); }
+
+ private:
+  /** The strings by code, which never move, so that the keys of codes_ may refer to them. */
+  std::deque<std::string> strings_;
+  std::unordered_map<std::string_view, int32_t> codes_;
+};
+
+}  // namespace bustub
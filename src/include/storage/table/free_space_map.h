@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/table/free_space_map.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <mutex>  // NOLINT
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap tells a table heap which of its pages have room for a tuple, so that an insert goes straight to one
+ * instead of walking the pages from the first one. The room of a page, see TablePage::GetMaxInsertSize(), is rounded
+ * down to one of NUM_CATEGORIES categories of CATEGORY_SIZE bytes each, so that the map only changes when a page
+ * crosses from one category into another, and a page of the category that a tuple needs surely has room for it.
+ *
+ * The inserters of a heap claim the pages that they insert into, see ClaimPage(), and the map hands a claimed page to
+ * no other inserter, so that inserters that run at the same time write to different pages.
+ *
+ * The map lives in memory next to the heap, which updates it while holding the write latch of the page that it
+ * writes. It only knows the pages that the heap has written or passed since it was opened: until an insert has walked
+ * to the last page once, the map knows no last page.
+ */
+class FreeSpaceMap {
+ public:
+  static constexpr uint32_t NUM_CATEGORIES = 32;
+  static constexpr uint32_t CATEGORY_SIZE = PAGE_SIZE / NUM_CATEGORIES;
+
+  /** Records the room that a page has for a tuple, the size of the largest tuple that it can take. */
+  void Update(page_id_t page_id, uint32_t max_insert_size);
+
+  /**
+   * Gives back a claimed page, and claims the page with the smallest id that has room for a tuple of a size and is
+   * not claimed.
+   * @param tuple_size the size of the tuple to insert
+   * @param released the page that the inserter claimed so far, INVALID_PAGE_ID for none
+   * @return the claimed page, INVALID_PAGE_ID if no page that is known and not claimed has room
+   */
+  page_id_t ClaimPage(uint32_t tuple_size, page_id_t released);
+
+  /** Claims a page, e.g. a new one, which no other inserter knows of yet. */
+  void Claim(page_id_t page_id) {
+    std::scoped_lock lock(latch_);
+    claimed_.insert(page_id);
+  }
+
+  /** Gives back a claimed page. */
+  void Release(page_id_t page_id) {
+    std::scoped_lock lock(latch_);
+    claimed_.erase(page_id);
+  }
+
+  /**
+   * Forgets a page that is about to be removed from the heap, unless an inserter claimed it.
+   * @return false if the page is claimed, it stays known then
+   */
+  bool Remove(page_id_t page_id);
+
+  /** Forgets all pages and their claims, e.g. of a heap that was truncated. */
+  void Clear() {
+    std::scoped_lock lock(latch_);
+    categories_.clear();
+    for (auto &pages : pages_) {
+      pages.clear();
+    }
+    claimed_.clear();
+    last_page_id_ = INVALID_PAGE_ID;
+  }
+
+  /** Records the last page of the heap, which the inserts extend once no other page has room. */
+  void SetLastPageId(page_id_t page_id) {
+    std::scoped_lock lock(latch_);
+    last_page_id_ = page_id;
+  }
+
+  /** @return the last page of the heap, INVALID_PAGE_ID if it is not known yet */
+  page_id_t GetLastPageId() const {
+    std::scoped_lock lock(latch_);
+    return last_page_id_;
+  }
+
+ private:
+  mutable std::mutex latch_;
+  /** The category of every known page, and the pages of each category but the first, which has no room to speak of. */
+  std::unordered_map<page_id_t, uint32_t> categories_;
+  std::array<std::set<page_id_t>, NUM_CATEGORIES> pages_;
+  std::unordered_set<page_id_t> claimed_;
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
@@ -0,0 +1,244 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lsm_table.h
+//
+// Identification: src/include/storage/table/lsm_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "common/macros.h"
+#include "container/hash/hash_block_filter.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** The version of a row that an LsmTable keeps: its tuple, or a tombstone if the row was deleted. */
+struct LsmEntry {
+  bool deleted_{false};
+  /** The tuple, serialized as by Tuple::SerializeTo(), empty for a tombstone. */
+  std::string tuple_;
+};
+
+/**
+ * LsmRun is a sorted immutable run of an LsmTable: the entries of a frozen memtable, or those of runs that were
+ * compacted into one, in LsmRunPages of their own in increasing order of their keys. The run keeps the first key of
+ * every page, so that a lookup reads a single page, and a Bloom filter of its keys, so that a lookup of a key that it
+ * does not have reads none. The run deletes its pages when it goes away.
+ */
+class LsmRun {
+ public:
+  /**
+   * Creates an empty run, which is appended to and then finished.
+   * @param bpm the buffer pool that the pages of the run are in
+   * @param expected_entries about the number of entries that the run gets, which sizes its Bloom filter
+   */
+  LsmRun(BufferPoolManager *bpm, size_t expected_entries);
+
+  ~LsmRun();
+
+  DISALLOW_COPY_AND_MOVE(LsmRun);
+
+  /** Appends an entry, whose key must be larger than those of the run. Throws if there is no frame for a page. */
+  void Append(int64_t key, const LsmEntry &entry);
+
+  /** Unpins the last page, the run is not appended to any more. */
+  void Finish();
+
+  /** @return false if the run certainly has no entry of a key, see the Bloom filter above */
+  bool MayContain(int64_t key) const { return filter_.MayContain(0, static_cast<uint64_t>(key)); }
+
+  /**
+   * Looks an entry up.
+   * @param key the key of the entry
+   * @param[out] entry the entry, if the run has one
+   * @return true if the run has an entry of the key
+   */
+  bool Find(int64_t key, LsmEntry *entry) const;
+
+  /** Reads the entries of a page of the run, in order. */
+  void ReadPage(size_t page_index, std::vector<std::pair<int64_t, LsmEntry>> *entries) const;
+
+  /** @return the number of pages of the run */
+  size_t GetNumPages() const { return page_ids_.size(); }
+
+  /** @return the number of entries of the run, tombstones included */
+  size_t GetNumEntries() const { return num_entries_; }
+
+ private:
+  /** @return the pinned page of the run, throws if the buffer pool has no frame for it */
+  Page *FetchPage(page_id_t page_id) const;
+
+  BufferPoolManager *bpm_;
+  std::vector<page_id_t> page_ids_;
+  /** The key of the first entry of every page. */
+  std::vector<int64_t> first_keys_;
+  /** The filter of the keys of the run, a single block of it. */
+  HashBlockFilter filter_;
+  /** The last page, pinned until it is full or the run is finished. */
+  Page *last_page_{nullptr};
+  size_t num_entries_{0};
+};
+
+/**
+ * LsmTable is a log-structured table, for tables that take many more writes than reads, e.g. tables of events that
+ * are ingested and only now and then looked up. Its rows are keyed by their first column, which is an integer, and a
+ * write of a key replaces the row of the key, if any.
+ *
+ * A write goes to an in-memory memtable, sorted by key. A memtable that grew to its size is frozen, and a background
+ * thread writes it out as a new LsmRun, so that the writers never wait on pages. A lookup reads the memtable, the
+ * frozen memtables and the runs from the newest to the oldest, until one of them has the key; a scan merges them all.
+ * Once there are LSM_COMPACTION_TRIGGER runs, the thread compacts them into one, which drops the tombstones and the
+ * versions that newer ones replaced. Writers stall while LSM_MAX_IMMUTABLE frozen memtables wait to be written out.
+ *
+ * The table has no undo and no log records: a write takes effect at once, and an abort of its transaction does not
+ * take it back. Like a columnar table, it is not persisted, and it has no indexes.
+ */
+class LsmTable {
+ public:
+  /** Sorted entries by key. */
+  using Memtable = std::map<int64_t, LsmEntry>;
+
+  /**
+   * A scan of the table, in increasing order of the keys. It reads the table as it was when the scan began.
+   */
+  class Iterator {
+    friend class LsmTable;
+
+   public:
+    /**
+     * @param[out] tuple the next row
+     * @return false if there are no more rows
+     */
+    bool Next(Tuple *tuple);
+
+   private:
+    /** A memtable or a run that the scan merges, and the position in it. */
+    struct Source {
+      std::shared_ptr<const Memtable> memtable_;
+      Memtable::const_iterator it_;
+      std::shared_ptr<const LsmRun> run_;
+      size_t page_index_{0};
+      std::vector<std::pair<int64_t, LsmEntry>> entries_;
+      size_t entry_index_{0};
+    };
+
+    /** @param sources the sources to merge, the newest first */
+    explicit Iterator(std::vector<Source> &&sources);
+
+    /**
+     * Moves to the next key, whose entry is that of the newest source that has it.
+     * @return false if there are no more keys
+     */
+    bool NextEntry(int64_t *key, LsmEntry *entry);
+
+    std::vector<Source> sources_;
+  };
+
+  /**
+   * Creates an empty table, and starts its background thread.
+   * @param bpm the buffer pool that the pages of the runs are in
+   * @param schema the schema of the table, whose first column is the integer key
+   * @param memtable_size the bytes of tuples that a memtable takes before it is frozen
+   */
+  LsmTable(BufferPoolManager *bpm, const Schema &schema, size_t memtable_size = LSM_MEMTABLE_SIZE);
+
+  /** Stops the background thread, the memtables that were not written out yet are dropped. */
+  ~LsmTable();
+
+  DISALLOW_COPY_AND_MOVE(LsmTable);
+
+  /**
+   * Writes rows, each replacing the row of its key, if any.
+   * @return false if a tuple has a null key, or does not fit a page of a run, and then none was written
+   */
+  bool InsertTuples(const std::vector<Tuple> &tuples);
+
+  /** Deletes the row of a key, if any. */
+  void DeleteKey(int64_t key);
+
+  /**
+   * Looks a row up.
+   * @param key the key of the row
+   * @param[out] tuple the row, if any
+   * @return true if the table has a row of the key
+   */
+  bool GetTuple(int64_t key, Tuple *tuple) const;
+
+  /** @return a scan of the rows of the table */
+  Iterator Begin() const;
+
+  /** @return the key of a row */
+  int64_t GetKey(const Tuple &tuple) const;
+
+  /** Freezes the memtable and writes out all of the frozen memtables as runs, before it returns. */
+  void Flush();
+
+  /** Compacts all of the runs into one, before it returns. */
+  void Compact();
+
+  /** @return the number of runs of the table */
+  size_t GetNumRuns() const {
+    std::shared_lock lock(latch_);
+    return runs_.size();
+  }
+
+ private:
+  /** Waits while LSM_MAX_IMMUTABLE frozen memtables wait to be written out. Takes latch_ in write mode. */
+  std::unique_lock<std::shared_mutex> LockForWrite();
+
+  /** Writes a version of a row to the memtable, and freezes it once it is full. Needs latch_ in write mode. */
+  void Put(int64_t key, LsmEntry &&entry);
+
+  /** Freezes the memtable, and hands it to the background thread. Needs latch_ in write mode. */
+  void Freeze();
+
+  /** Writes out the frozen memtables, the oldest first. Needs maintenance_latch_. */
+  void WriteImmutables();
+
+  /** Merges the runs into one. Needs maintenance_latch_. */
+  void CompactRuns();
+
+  /** Writes out frozen memtables and compacts the runs until the table goes away. */
+  void RunMaintenance();
+
+  BufferPoolManager *bpm_;
+  Schema schema_;
+  size_t memtable_size_;
+  /** Protects the memtables and the runs, and stop_. */
+  mutable std::shared_mutex latch_;
+  /** Signals a frozen memtable to the background thread, and one that it wrote out to the writers. */
+  std::condition_variable_any cv_;
+  Memtable memtable_;
+  /** The bytes of the entries of memtable_. */
+  size_t memtable_bytes_{0};
+  /** The frozen memtables, the newest first. */
+  std::deque<std::shared_ptr<const Memtable>> immutables_;
+  /** The runs, the newest first. */
+  std::vector<std::shared_ptr<const LsmRun>> runs_;
+  /** Serializes the writing of runs, by the background thread, Flush() and Compact(). */
+  std::mutex maintenance_latch_;
+  bool stop_{false};
+  std::thread maintenance_thread_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_store.h
+//
+// Identification: src/include/storage/table/overflow_store.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * Where a VARCHAR value that is stored out of line lives. It follows the length of the value in the tuple, which has
+ * Tuple::OVERFLOW_FLAG set.
+ */
+struct OverflowPointer {
+  /** The first page of the chain of OverflowPages that holds the value. */
+  page_id_t first_page_id_;
+  /** The length of the value, with its terminating zero, like Value::GetLength() has it. */
+  uint32_t length_;
+  /** The bytes that the chain holds, fewer than length_ if the value is compressed, see LzCompressor. */
+  uint32_t stored_length_;
+};
+
+/**
+ * OverflowStore keeps the large VARCHAR values of the tuples of a table laid out by row out of line, in chains of
+ * OverflowPages, so that a tuple of any size fits into a table page, and a read of its other columns does not drag the
+ * large values along. The tuple holds an OverflowPointer in place of such a value, which a Tuple that knows the store,
+ * see Tuple::SetOverflowStore(), reads through it only once the column is read.
+ *
+ * A value that compresses well is stored compressed. Every version of a row owns the chains of its values: a tuple
+ * that is written into the table gets chains of its own, see Store(), and the table heap releases the chains of a
+ * version that nobody sees anymore, see Release(), which its vacuum frees once no transaction may read them.
+ *
+ * The chains are not logged: with logging, the pages of a chain are written back before the tuple that points to it is
+ * logged, so that it is on disk before any record that refers to it.
+ */
+class OverflowStore {
+ public:
+  /** A tuple that is larger than this has its largest values stored out of line, until it is no larger. */
+  static constexpr uint32_t STORE_THRESHOLD = PAGE_SIZE / 4;
+
+  /**
+   * @param buffer_pool_manager the buffer pool that the chains are in
+   * @param schema the schema of the tuples of the table
+   */
+  OverflowStore(BufferPoolManager *buffer_pool_manager, const Schema &schema)
+      : buffer_pool_manager_(buffer_pool_manager), schema_(schema) {}
+
+  /** @return true if a tuple has to go through Store() before it is written: it is too large, or points to chains */
+  bool NeedsStore(const Tuple &tuple) const;
+
+  /**
+   * Stores the largest VARCHAR values of a tuple out of line until it is no larger than STORE_THRESHOLD, or no value is
+   * left that is worth it. A value that the tuple already stores out of line is copied into a chain of its own.
+   * @param tuple the tuple
+   * @param[out] stored the tuple to write instead, which reads its values through this store
+   * @return false if a page could not be allocated
+   */
+  bool Store(const Tuple &tuple, Tuple *stored);
+
+  /**
+   * Reads a value that is stored out of line.
+   * @param pointer the OverflowPointer of the value, the bytes after its length in the tuple
+   * @param[out] data length_ bytes for the value
+   */
+  void Read(const OverflowPointer &pointer, char *data) const;
+
+  /** Releases the chains of the values that a tuple stores out of line, which is no longer a version of its row. */
+  void Release(const Tuple &tuple);
+
+  /** @return the first pages of the chains that were released since the last call */
+  std::vector<page_id_t> TakeReleased();
+
+  /**
+   * Deallocates a chain that no transaction may read anymore.
+   * @return the number of pages that were deallocated
+   */
+  size_t FreeChain(page_id_t first_page_id);
+
+  /** @return the number of pages of chains that were read so far */
+  size_t GetNumPagesRead() const { return num_pages_read_; }
+
+ private:
+  /**
+   * Writes a value into a new chain.
+   * @return the pointer to the chain, whose first page is INVALID_PAGE_ID if a page could not be allocated
+   */
+  OverflowPointer WriteChain(const char *data, uint32_t length);
+
+  BufferPoolManager *buffer_pool_manager_;
+  const Schema schema_;
+  /** Protects the released chains. */
+  std::mutex latch_;
+  std::vector<page_id_t> released_;
+  mutable std::atomic<size_t> num_pages_read_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_directory.h
+//
+// Identification: src/include/storage/table/page_directory.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * PageDirectory lists the pages of a table heap in the order of their chain, so that a reader can split the heap into
+ * ranges of pages up front, e.g. the morsels of a parallel scan, instead of following the links of the pages one at a
+ * time. The heap appends a page to it while it holds the write latch of the page that it links the page to, and
+ * removes a page that a vacuum unlinked.
+ */
+class PageDirectory {
+ public:
+  /** Appends a page that was linked to the end of the heap. */
+  void Append(page_id_t page_id) {
+    std::scoped_lock lock(latch_);
+    page_ids_.push_back(page_id);
+  }
+
+  /** Removes a page that was unlinked from the heap. */
+  void Remove(page_id_t page_id);
+
+  /** Forgets all pages, e.g. of a heap that was truncated. */
+  void Clear() {
+    std::scoped_lock lock(latch_);
+    page_ids_.clear();
+  }
+
+  /** @return the number of pages of the heap */
+  size_t GetNumPages() const {
+    std::scoped_lock lock(latch_);
+    return page_ids_.size();
+  }
+
+  /**
+   * @param begin the position of the first page of the range
+   * @param end the position after the last page of the range, which is cut off at the number of pages
+   * @return the ids of the pages of a range of the heap, in the order of their chain
+   */
+  std::vector<page_id_t> GetPageIds(size_t begin, size_t end) const;
+
+ private:
+  mutable std::mutex latch_;
+  std::vector<page_id_t> page_ids_;
+};
+
+}  // namespace bustub
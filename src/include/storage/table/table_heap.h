@@ -12,17 +12,63 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/page/columnar_table_page.h"
 #include "storage/page/table_page.h"
+#include "storage/table/column_dictionary.h"
+#include "storage/table/free_space_map.h"
+#include "storage/table/overflow_store.h"
+#include "storage/table/page_directory.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
+#include "storage/table/tuple_ref.h"
+#include "storage/table/version_store.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
+class TransactionManager;
+
+/**
+ * How the pages of a table hold its tuples: by row, see TablePage, by column, see ColumnarTablePage, or in the sorted
+ * runs of a log-structured table, see LsmTable.
+ */
+enum class TableLayout { ROW, COLUMNAR, LSM };
+
+/**
+ * The net change that a committed transaction made to a table, see TableHeap::AddCommitListener(). A tuple that it
+ * updated is removed as it was before and added as it is after, one that it inserted and deleted again is in neither.
+ */
+struct TableChange {
+  /** True if the table was truncated first: removed_ then holds none of the tuples that the table had before. */
+  bool truncated_{false};
+  /** True if some of the removed tuples are not known, e.g. were deleted before the listener was added. */
+  bool incomplete_{false};
+  std::vector<Tuple> removed_;
+  std::vector<Tuple> added_;
+};
+
 /**
  * TableHeap represents a physical table on disk.
  * This is just a doubly-linked list of pages.
+ *
+ * The pages of a columnar table are ColumnarTablePages, which are meant for tables that are loaded in bulk and then
+ * scanned. Its tuples are only ever appended, as by BulkInsert(), so its writers lock it exclusively, and a read only
+ * needs an intention lock on it. Its VARCHAR columns are dictionary encoded, see ColumnDictionary: the pages hold the
+ * codes of the strings, and the tuples are encoded as they are appended and decoded as they are read as rows.
+ *
+ * A table laid out by row may store its large VARCHAR values out of line, see EnableOverflow(), and then takes tuples
+ * of any size.
  */
 class TableHeap {
   friend class TableIterator;
@@ -36,9 +82,11 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param first_page_id the id of the first page
+   * @param oid the id of the table in the catalog, which its table locks are taken on, INVALID_TABLE_OID for row locks
+   * only
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            page_id_t first_page_id);
+            page_id_t first_page_id, table_oid_t oid = INVALID_TABLE_OID);
 
   /**
    * Create a table heap with a transaction. (create table)
@@ -46,21 +94,93 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param txn the creating transaction
+   * @param oid the id of the table in the catalog, which its table locks are taken on, INVALID_TABLE_OID for row locks
+   * only
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            Transaction *txn);
+            Transaction *txn, table_oid_t oid = INVALID_TABLE_OID);
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Lock the table, e.g. SHARED for a scan, which then takes no locks on the rows that it reads. Inserts, deletes and
+   * updates take INTENTION_EXCLUSIVE on their own, and reads INTENTION_SHARED unless the table is locked for them. A
+   * read-only transaction is aborted if it asks for a mode that writes.
+   * @param txn the transaction that needs the lock
+   * @param lock_mode the mode that the table is needed in
+   * @return true if the table is locked, or need not be because the table has no oid or locking is off
+   */
+  bool LockTable(Transaction *txn, LockMode lock_mode);
+
+  /**
+   * Insert a tuple into the table. If the tuple is too large (>= page_size), even once its large values are stored out
+   * of line, return false. An optimistic transaction
+   * buffers the insert, like its deletes and updates, and gets no rid for the tuple.
+   * The tuple goes to the page that the thread inserts into, see InsertIntoAppendPage().
+   * A columnar table appends the tuple like a bulk insert of one tuple.
    * @param tuple tuple to insert
-   * @param[out] rid the rid of the inserted tuple
+   * @param[out] rid the rid of the inserted tuple, invalid if the insert was buffered
    * @param txn the transaction performing the insert
    * @return true iff the insert is successful
    */
   bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn);
 
+  /**
+   * Insert tuples into the table like InsertTuple() would one at a time, but a page at a time: the insert packs as
+   * many tuples into a page as fit while it holds its latch. Each tuple is still locked and logged on its own, so that
+   * it is undone like one that InsertTuple() inserted.
+   * @param tuples the tuples to insert, each of which must fit into a page
+   * @param[out] rids the rids of the inserted tuples, invalid ones for buffered inserts
+   * @param txn the transaction performing the insert
+   * @return true iff all tuples were inserted
+   */
+  bool InsertTuples(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn);
+
+  /**
+   * Load tuples into new pages at the end of the table. The pages are filled directly and logged as whole-page images
+   * once they are full, instead of a record per tuple, and the tuples are not locked. Meant for loading a table that
+   * was just created in the transaction, which has the table to itself until it commits: a table with an oid is
+   * locked EXCLUSIVE.
+   * @param tuples the tuples to insert, each of which must fit into a page
+   * @param[out] rids the rids of the inserted tuples, nullptr if they are not needed
+   * @param txn the transaction performing the load
+   * @return true iff all tuples were inserted
+   */
+  bool BulkInsert(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn);
+
+  /**
+   * Delete all tuples of the table at once, in a time that does not depend on their number: the first page is emptied
+   * and unlinked from the pages after it, with a single log record that holds its image, instead of a delete and a
+   * record per tuple. The table is locked EXCLUSIVE, like for a bulk insert. The pages that followed the first page
+   * stay as they are until the transaction ends: a commit retires them, for the vacuum to deallocate once the
+   * transactions that were active then have ended, see Vacuum(), and an abort links them back.
+   *
+   * Like TRUNCATE in most systems, the truncation does not keep older versions for the snapshots: a snapshot that reads
+   * the table without locking it sees it empty once it is truncated. An out of line value of a truncated tuple is never
+   * freed. A columnar table
+   * cannot be truncated, and neither can an optimistic transaction truncate, their transactions are aborted.
+   * @param txn the transaction performing the truncation
+   * @return true iff the table was truncated
+   */
+  bool Truncate(Transaction *txn);
+
+  /**
+   * Called on Commit of a truncation: the pages that followed the first page are retired.
+   * @param truncated the tuple of the write record of the truncation
+   * @param transaction_manager the manager of the transactions that may still read the retired pages
+   */
+  void ApplyTruncate(const Tuple &truncated, TransactionManager *transaction_manager);
+
+  /**
+   * Called on abort to rollback a truncation: the first page gets its tuples and its link back, and the pages that
+   * were added since are retired.
+   * @param truncated the tuple of the write record of the truncation
+   * @param transaction_manager the manager of the transactions that may still read the retired pages
+   * @param txn transaction performing the rollback
+   */
+  void RollbackTruncate(const Tuple &truncated, TransactionManager *transaction_manager, Transaction *txn);
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
+   * A columnar table is append only, the transaction is aborted.
    * @param rid resource id of the tuple of delete
    * @param txn transaction performing the delete
    * @return true iff the delete is successful (i.e the tuple exists)
@@ -69,6 +189,7 @@ class TableHeap {
 
   /**
    * if the new tuple is too large to fit in the old page, return false (will delete and insert)
+   * A columnar table is append only, the transaction is aborted.
    * @param tuple new tuple
    * @param rid rid of the old tuple
    * @param txn transaction performing the update
@@ -76,6 +197,13 @@ class TableHeap {
    */
   bool UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn);
 
+  /**
+   * Called on Commit of an update: the values that the version before it stored out of line are released, for the
+   * vacuum to free once no transaction may read them.
+   * @param old_tuple the version before the update
+   */
+  void ApplyUpdate(const Tuple &old_tuple);
+
   /**
    * Called on Commit/Abort to actually delete a tuple or rollback an insert.
    * @param rid rid of the tuple to delete
@@ -83,6 +211,23 @@ class TableHeap {
    */
   void ApplyDelete(const RID &rid, Transaction *txn);
 
+  /**
+   * Called on abort to rollback the tuples that a bulk insert loaded into a page.
+   * @param page_id the page that the bulk insert filled
+   * @param txn transaction performing the rollback
+   */
+  void RollbackBulkInsert(page_id_t page_id, Transaction *txn);
+
+  /**
+   * Called on abort to roll back an update whose tuple before it is not in the write set, by reading its log record
+   * back and updating the tuple to what it was.
+   * @param rid rid of the updated tuple
+   * @param lsn the LSN of the UPDATE record
+   * @param[in,out] log_buffer the log buffer that the records of the rollback are read back through
+   * @param txn transaction performing the rollback
+   */
+  void RollbackUpdate(const RID &rid, lsn_t lsn, LogReadBuffer *log_buffer, Transaction *txn);
+
   /**
    * Called on abort to rollback a delete.
    * @param rid rid of the deleted tuple.
@@ -91,28 +236,386 @@ class TableHeap {
   void RollbackDelete(const RID &rid, Transaction *txn);
 
   /**
-   * Read a tuple from the table.
+   * Read a tuple from the table. A snapshot reads the version that it sees without taking any locks, an optimistic
+   * transaction reads its buffered writes over it and remembers the read for validation.
    * @param rid rid of the tuple to read
    * @param tuple output variable for the tuple
    * @param txn transaction performing the read
-   * @return true if the read was successful (i.e. the tuple exists)
+   * @return true if the read was successful (i.e. the tuple exists, or a version of it is seen by the snapshot)
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
-  /** @return the begin iterator of this table */
-  TableIterator Begin(Transaction *txn);
+  /**
+   * Read a tuple from the table like GetTuple(), but in place for a transaction that reads in place, see
+   * ReadsInPlace(): the tuple of the ref then borrows the bytes of its page, which stays pinned and read latched until
+   * the ref is released. Other transactions, and columnar tables, get a copy of the tuple.
+   * @param rid rid of the tuple to read
+   * @param[out] ref the ref to the tuple, whose previous tuple is released
+   * @param txn transaction performing the read
+   * @return true if the read was successful
+   */
+  bool GetTupleRef(const RID &rid, TupleRef *ref, Transaction *txn);
+
+  /**
+   * @param txn the transaction performing the scan
+   * @param ring the buffer ring that the scan fetches pages through, nullptr to use the whole buffer pool
+   * @return the begin iterator of this table
+   */
+  TableIterator Begin(Transaction *txn, BufferRing *ring = nullptr);
+
+  /**
+   * Iterates over a range of the pages of this table only, e.g. a morsel of a parallel scan: the iterator goes from
+   * one page of the range to the next one instead of following the links of the pages.
+   * @param txn the transaction performing the scan
+   * @param page_ids the pages of the range, see GetPageIds()
+   * @param ring the buffer ring that the scan fetches pages through, nullptr to use the whole buffer pool
+   * @return the begin iterator of the range, the end iterator if the range holds no tuple
+   */
+  TableIterator BeginRange(Transaction *txn, std::vector<page_id_t> page_ids, BufferRing *ring = nullptr);
 
   /** @return the end iterator of this table */
   TableIterator End();
 
+  /** @return the number of pages of this table, see PageDirectory */
+  size_t GetNumPages() const { return page_directory_.GetNumPages(); }
+
+  /**
+   * @param begin the position of the first page of the range in the chain of the pages of this table
+   * @param end the position after the last page of the range, which is cut off at the number of pages
+   * @return the ids of the pages of a range of this table, in the order of their chain
+   */
+  std::vector<page_id_t> GetPageIds(size_t begin, size_t end) const { return page_directory_.GetPageIds(begin, end); }
+
+  /**
+   * Reads the tuples of a page that a transaction sees, as a TableIterator does on its way through the page. Unlike
+   * an iterator, many threads may scan pages for the same transaction at once, unless it is optimistic, which records
+   * its reads.
+   * @param page_id the id of a page of this table
+   * @param txn the transaction performing the scan
+   * @param[out] tuples the tuples are appended to it
+   * @return false if the page could not be fetched, the transaction is aborted then
+   */
+  bool ScanPage(page_id_t page_id, Transaction *txn, std::vector<Tuple> *tuples);
+
+  /**
+   * @return true if a transaction reads the tuples of this table as they are in its pages, see ScanPageInPlace(): it is
+   * neither optimistic nor a snapshot, and its reads take no tuple locks, because it holds a shared lock on the whole
+   * table or nothing is locked at all
+   */
+  bool ReadsInPlace(Transaction *txn) const {
+    return !txn->IsOptimistic() && !txn->IsSnapshot() &&
+           (!enable_logging || (oid_ != INVALID_TABLE_OID && txn->IsTableSharedLocked(oid_)));
+  }
+
+  /**
+   * Reads the live tuples of a page in place, under the read latch of the page, for a transaction that reads in place.
+   * Unlike ScanPage(), no tuple is copied out of the page unless fn copies it.
+   * @param page_id the id of a page of this table
+   * @param ring the buffer ring that the scan fetches pages through, nullptr to use the whole buffer pool
+   * @param[out] next_page_id the id of the page after it
+   * @param fn called as fn(rid, data, size) for every tuple, see TablePage::ScanTuples()
+   * @return false if the page could not be fetched
+   */
+  template <class Fn>
+  bool ScanPageInPlace(page_id_t page_id, BufferRing *ring, page_id_t *next_page_id, Fn &&fn) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPageForScan(page_id, ring));
+    if (page == nullptr) {
+      return false;
+    }
+    page->RLatch();
+    if (columnar_schema_ != nullptr && table_schema_ != nullptr) {
+      // The rows of a dictionary encoded table are decoded for fn, one at a time.
+      Tuple decoded;
+      reinterpret_cast<ColumnarTablePage *>(page)->ScanTuples(
+          *columnar_schema_, [&](const RID &rid, const char *data, uint32_t size) {
+            DecodeTuple(Tuple(data, size), &decoded);
+            fn(rid, decoded.GetData(), decoded.GetLength());
+          });
+    } else if (columnar_schema_ != nullptr) {
+      reinterpret_cast<ColumnarTablePage *>(page)->ScanTuples(*columnar_schema_, fn);
+    } else {
+      page->ScanTuples(fn);
+    }
+    *next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return true;
+  }
+
+  /**
+   * Reads the columns of the tuples of a page of a columnar table in place, under the read latch of the page, for a
+   * transaction that reads in place. The columns are those of GetColumnarSchema(), i.e. the codes of the strings of
+   * dictionary encoded columns.
+   * @param page_id the id of a page of this table
+   * @param ring the buffer ring that the scan fetches pages through, nullptr to use the whole buffer pool
+   * @param[out] next_page_id the id of the page after it
+   * @param fn called as fn(page, num_tuples), see ColumnarTablePage::GetColumnData()
+   * @return false if the page could not be fetched
+   */
+  template <class Fn>
+  bool ScanColumnsInPlace(page_id_t page_id, BufferRing *ring, page_id_t *next_page_id, Fn &&fn) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPageForScan(page_id, ring));
+    if (page == nullptr) {
+      return false;
+    }
+    page->RLatch();
+    auto columnar_page = reinterpret_cast<ColumnarTablePage *>(page);
+    fn(columnar_page, columnar_page->GetTupleCount());
+    *next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return true;
+  }
+
+  /**
+   * @return the id of the page after a page of this table, INVALID_PAGE_ID for the last page. The page is not fetched
+   * if the zone map knows it.
+   */
+  page_id_t GetNextPageId(page_id_t page_id);
+
+  /**
+   * Starts keeping a zone map of the pages of this table, which summarizes the pages that it has so far and is kept up
+   * to date by the writes from then on. Called while nobody writes the table, e.g. right after it is created.
+   * @param schema the schema of the tuples of this table
+   */
+  void EnableZoneMap(const Schema &schema);
+
+  /**
+   * Stores the large VARCHAR values of the tuples of this table out of line from now on, see OverflowStore. Called on
+   * a table laid out by row right after it is created.
+   * @param schema the schema of the tuples of this table
+   */
+  void EnableOverflow(const Schema &schema);
+
+  /** @return the store of the values that this table stores out of line, nullptr if it stores none */
+  const OverflowStore *GetOverflowStore() const { return overflow_.get(); }
+
+  /**
+   * Lays the pages of this table out by column from now on. Called on a table without tuples.
+   * @param schema the schema of the tuples of this table, whose columns are inlined, except for VARCHAR columns, which
+   * are dictionary encoded
+   */
+  void UseColumnarLayout(const Schema &schema);
+
+  /**
+   * @return the schema of the tuples in the pages of a columnar table, in which a dictionary encoded column is an
+   * INTEGER column of codes, nullptr for a table that is laid out by row
+   */
+  const Schema *GetColumnarSchema() const { return columnar_schema_.get(); }
+
+  /** @return the dictionary of a column of a columnar table, nullptr if the column is not dictionary encoded */
+  const ColumnDictionary *GetDictionary(uint32_t col_idx) const {
+    return col_idx < dictionaries_.size() ? dictionaries_[col_idx].get() : nullptr;
+  }
+
+  /** @return the layout of the pages of this table */
+  TableLayout GetLayout() const { return columnar_schema_ == nullptr ? TableLayout::ROW : TableLayout::COLUMNAR; }
+
+  /** @return the zone map of this table, nullptr if it keeps none */
+  const ZoneMap *GetZoneMap() const { return zone_map_.get(); }
+
   /** @return the id of the first page of this table */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /** @return the older versions of the rows of this table, which the TransactionManager commits */
+  inline VersionStore *GetVersionStore() { return &versions_; }
+
+  /**
+   * Called with the net change of every transaction that commits writes to this table from now on, e.g. to keep an
+   * AggregateView up to date. It is called before the locks of the transaction are released, so a listener that is
+   * added under a SHARED lock of the table misses no commit, and while it runs no other transaction commits writes
+   * to the same rows. It must not take locks, nor latches that are held while a page is latched.
+   */
+  using CommitListener = std::function<void(const TableChange &change)>;
+
+  /** @return the id of the listener, to remove it with */
+  size_t AddCommitListener(CommitListener listener);
+
+  /** Removes a commit listener, which is not called anymore once this returns. */
+  void RemoveCommitListener(size_t listener_id);
+
+  /** @return true if the commits of this table are listened to, which then need to know the tuples that they delete */
+  bool HasCommitListeners() const { return has_listeners_; }
+
+  /**
+   * @return the LSN of the last change to the rows of this table: a write, or the commit or rollback of one. It only
+   * ever grows, so that a reader tells by it whether the table changed since it last looked, see ResultCache.
+   */
+  lsn_t GetLastModifiedLsn() const { return last_modified_lsn_.load(); }
+
+  /**
+   * Moves the last-modified LSN of this table on past a change: to the LSN of its log record, or on by one if the
+   * change was not logged, or the LSN is not past the last one.
+   * @param lsn the LSN of the log record of the change, INVALID_LSN if none
+   */
+  void MarkModified(lsn_t lsn) {
+    lsn_t last = last_modified_lsn_.load();
+    while (!last_modified_lsn_.compare_exchange_weak(last, std::max(last + 1, lsn))) {
+    }
+  }
+
+  /**
+   * Called on Commit, before the deletes are applied: computes the net change of the transaction to this table from
+   * its write set and the pages, and calls the commit listeners with it.
+   * @param txn the committing transaction, which holds the locks on its writes still
+   */
+  void PublishCommit(Transaction *txn);
+
+  /**
+   * Vacuums the table: trims the empty slots off the end of its pages, see TablePage::TrimEmptySlots(), and unlinks the
+   * pages that hold no tuples at all from the chain, except for the first and the last one. An unlinked page keeps its
+   * link to the page that followed it, and is only deallocated once the transactions that were active when it was
+   * unlinked have ended, for they may still be on their way to it, e.g. a scan that read the link to it.
+   *
+   * The vacuum only waits for the latch of a page while it holds no other latch, and skips the pages that it cannot
+   * latch right away otherwise, so that it never waits for a transaction that waits for a lock while it holds a latch.
+   * A page that an inserter claimed, or of whose slots a snapshot may still read an older version, is left as it is.
+   * The changes of the vacuum are not logged: with logging, a page that it changed is written back right away, with an
+   * LSN past its records, so that redo does not replay them onto it. The chains of the values that were stored out of
+   * line by versions that nobody sees anymore are freed like unlinked pages. A columnar table is append only, it is
+   * never vacuumed.
+   * @param transaction_manager the manager of the transactions that use the table, nullptr if none are running, the
+   * unlinked pages are deallocated right away then
+   * @return the number of pages that were deallocated, which this or an earlier vacuum unlinked
+   */
+  size_t Vacuum(TransactionManager *transaction_manager);
+
+  /**
+   * Lock a row exclusively before a snapshot writes it, upgrading from a shared lock if necessary. The page methods
+   * lock rows while holding the latch of their page, but a snapshot must hold the lock before it checks under the
+   * latch whether the row changed after its begin. An optimistic transaction locks all the rows it writes up front.
+   * @return true if the row is locked, or need not be because locking is off
+   */
+  bool LockRowExclusive(const RID &rid, Transaction *txn);
+
  private:
+  /** Reads a tuple from the raw data of a page of this table, see TablePage::CopyTuple(). */
+  bool CopyTuple(const char *data, const RID &rid, Tuple *tuple) const;
+
+  /**
+   * Gets a tuple ready to be written into a page: its large values are stored out of line, if the table stores any.
+   * @param[out] stored the tuple with its values stored out of line, if it needs to be
+   * @return the tuple to write, the given one or stored, nullptr if it does not fit into a page or a page could not be
+   * allocated, the transaction is aborted then
+   */
+  const Tuple *PrepareTuple(const Tuple &tuple, Tuple *stored, Transaction *txn);
+
+  /** Encodes a tuple of the table into a tuple of the pages of a dictionary encoded table. */
+  void EncodeTuple(const Tuple &tuple, Tuple *encoded);
+
+  /** Decodes a tuple of the pages of a dictionary encoded table into a tuple of the table. */
+  void DecodeTuple(const Tuple &encoded, Tuple *tuple) const;
+
+  /**
+   * @return true if the last write of a transaction was a bulk insert into this table that ended on a page, all of
+   * whose tuples are then its own
+   */
+  bool IsOwnBulkPage(page_id_t page_id, Transaction *txn) const;
+
+  /** Records the room that a page of a table laid out by row has left in the free space map, and if it is the last. */
+  void UpdateFreeSpace(const WritePageGuard &guard);
+
+  /**
+   * Inserts a tuple into the page that the calling thread inserts into, its append point, so that threads that insert
+   * at the same time latch different pages. Once the page is full, the thread claims another one, see
+   * ClaimInsertPage(). Threads of the same number modulo NUM_APPEND_POINTS share an append point.
+   * @param cur_guard the guard of the page to try first, if it is valid, which is moved to the page that takes the
+   * tuple and marked dirty. It is released and the transaction aborted if a page could not be fetched.
+   * @return false if the tuple could not be inserted
+   */
+  bool InsertIntoAppendPage(const Tuple &tuple, RID *rid, WritePageGuard *cur_guard, Transaction *txn);
+
+  /**
+   * Gives back the page that an inserter claimed, and claims a page that has room for a tuple: one that the free space
+   * map knows, or else a new page, which is linked to the end of the table under the write latch of its last page.
+   * @param cur_guard the guard of the full page, if it is valid, which is released, or moved to a new page
+   * @return the claimed page, INVALID_PAGE_ID if a page could not be fetched, the transaction is aborted then
+   */
+  page_id_t ClaimInsertPage(uint32_t tuple_size, page_id_t released_page_id, WritePageGuard *cur_guard,
+                            Transaction *txn);
+
+  /** @return a guard of a page that is fetched and write latched, an empty one if another thread holds its latch */
+  WritePageGuard TryFetchPageWrite(page_id_t page_id);
+
+  /** Trims the empty slots off the end of a page, except for those that a snapshot may still read, see Vacuum(). */
+  void TrimPage(WritePageGuard *guard);
+
+  /**
+   * Unlinks a page without tuples from between two others, unless it is the page of the last bulk insert, or an
+   * inserter claimed it, or a snapshot may still read an older version of one of its rows, see Vacuum().
+   * @return true if the page was unlinked
+   */
+  bool UnlinkPage(WritePageGuard *prev_guard, WritePageGuard *cur_guard, WritePageGuard *next_guard);
+
+  /**
+   * Resets what the table keeps in memory about its pages to its first page only, or, once a truncation was rolled
+   * back, to the chain of pages that starts there.
+   * @param rebuild true to learn the chain and the zones of its pages from the pages
+   */
+  void ResetPages(bool rebuild);
+
+  /** Adds the pages of the table to a zone map without pages, with the zones of the tuples that they hold. */
+  void FillZoneMap(ZoneMap *zone_map);
+
+  /** Retires pages of the table for the vacuum to deallocate, see Vacuum(). The caller holds vacuum_latch_. */
+  void RetirePages(std::vector<page_id_t> page_ids, TransactionManager *transaction_manager);
+
+  /** Writes back a page that a vacuum changed without a log record, if logging is on, see Vacuum(). */
+  void WriteBackVacuumed(WritePageGuard *guard);
+
+  /**
+   * Buffer a write of an optimistic transaction that has not started committing yet.
+   * @return true if the write was buffered
+   */
+  bool BufferWrite(const RID &rid, WType wtype, const Tuple &tuple, Transaction *txn);
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  table_oid_t oid_{INVALID_TABLE_OID};
+  /** The last page of the previous bulk insert, where the next one starts looking for the end of the table. */
+  std::atomic<page_id_t> bulk_page_id_{INVALID_PAGE_ID};
+  /** The page that the threads of each append point insert into, see InsertIntoAppendPage(). */
+  struct AppendPoint {
+    std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  };
+  static constexpr size_t NUM_APPEND_POINTS = 16;
+  std::array<AppendPoint, NUM_APPEND_POINTS> append_points_;
+  /** The versions that the snapshots read, the rows of a bulk insert get none. */
+  VersionStore versions_;
+  /** The schema of the tuples in the pages of a columnar table, nullptr for a table that is laid out by row. */
+  std::unique_ptr<Schema> columnar_schema_;
+  /** The schema of the tuples of a dictionary encoded table, and the dictionaries of its columns, nullptr if none. */
+  std::unique_ptr<Schema> table_schema_;
+  std::vector<std::unique_ptr<ColumnDictionary>> dictionaries_;
+  /** The pages of this table in the order of their chain. */
+  PageDirectory page_directory_;
+  /** The pages of a table laid out by row that have room for the inserts, and those that the inserters claimed. */
+  FreeSpaceMap free_space_;
+  /** The summary of the pages that scans skip pages by, nullptr if it is not enabled. */
+  std::unique_ptr<ZoneMap> zone_map_;
+  /** The values that are stored out of line, nullptr if the table stores none. */
+  std::unique_ptr<OverflowStore> overflow_;
+  /**
+   * The pages that a vacuum unlinked and the first pages of the chains that were released, with the transactions that
+   * were active then, which may still read them.
+   */
+  struct RetiredPages {
+    std::vector<page_id_t> page_ids_;
+    std::vector<page_id_t> chain_page_ids_;
+    std::vector<txn_id_t> txn_ids_;
+  };
+  /** Protects listeners_, which PublishCommit() holds while it calls them. */
+  std::mutex listener_latch_;
+  std::vector<std::pair<size_t, CommitListener>> listeners_;
+  size_t next_listener_id_{0};
+  std::atomic<bool> has_listeners_{false};
+  /** See GetLastModifiedLsn(). */
+  std::atomic<lsn_t> last_modified_lsn_{0};
+  /** Serializes the vacuums of this table, and protects the pages that they unlinked but did not deallocate yet. */
+  std::mutex vacuum_latch_;
+  std::vector<RetiredPages> retired_pages_;
 };
 
 }  // namespace bustub
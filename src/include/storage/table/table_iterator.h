@@ -13,7 +13,11 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
+#include <utility>
+#include <vector>
 
+#include "buffer/buffer_ring.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -23,16 +27,40 @@ namespace bustub {
 class TableHeap;
 
 /**
- * TableIterator enables the sequential scan of a TableHeap.
+ * TableIterator enables the sequential scan of a TableHeap, or of a range of its pages, see TableHeap::BeginRange().
  */
 class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  /**
+   * Creates a new TableIterator.
+   * @param table_heap the table heap to iterate over
+   * @param rid the rid of the first tuple
+   * @param txn the transaction performing the scan
+   * @param ring the buffer ring used to fetch pages, nullptr to fetch them through the whole buffer pool
+   */
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferRing *ring = nullptr);
+
+  /**
+   * Creates a new TableIterator over a range of pages.
+   * @param table_heap the table heap to iterate over
+   * @param rid the rid of the first tuple, on the page at page_idx of the range
+   * @param txn the transaction performing the scan
+   * @param ring the buffer ring used to fetch pages, nullptr to fetch them through the whole buffer pool
+   * @param page_ids the pages of the range
+   * @param page_idx the position of the page of the first tuple in the range
+   */
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferRing *ring,
+                std::shared_ptr<const std::vector<page_id_t>> page_ids, size_t page_idx);
 
   TableIterator(const TableIterator &other)
-  :table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        ring_(other.ring_),
+        page_ids_(other.page_ids_),
+        page_idx_(other.page_idx_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -49,9 +77,22 @@ class TableIterator {
   TableIterator operator++(int);
 
  private:
+  /**
+   * Moves to the next tuple and reads it.
+   * @param empty_slots true to also stop at slots without a live tuple
+   * @return true if the tuple was read, see TableHeap::GetTuple()
+   */
+  bool Advance(bool empty_slots);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The buffer ring that pages are fetched through, not owned by the iterator. */
+  BufferRing *ring_;
+  /** The pages of the range that the iterator goes through, nullptr to follow the links of the pages instead. */
+  std::shared_ptr<const std::vector<page_id_t>> page_ids_;
+  /** The position of the current page in the range. */
+  size_t page_idx_{0};
 };
 
 }  // namespace bustub
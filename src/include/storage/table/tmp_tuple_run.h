@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tmp_tuple_run.h
+//
+// Identification: src/include/storage/table/tmp_tuple_run.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "storage/disk/spill_file.h"
+#include "storage/page/tmp_tuple_page.h"
+#include "storage/table/tmp_tuple.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TmpTupleRun is a sequence of TmpTuplePages that an operator appends tuples to and later reads back from start to
+ * end, e.g. a partition of a hash join that spilled. Only the page that takes the next tuple stays pinned, so that the
+ * run is written and read one page after the other. The run deletes its pages when it goes away.
+ *
+ * A run that is only read from start to end, e.g. a spilled partition or a sorted run, goes to a SpillFile instead, so
+ * that it does not take frames of the buffer pool away from the tables. Its tuples are read in the order of their
+ * appends, and there are no pages to name them by.
+ */
+class TmpTupleRun {
+ public:
+  /** The position of a reader of the run. */
+  struct Cursor {
+    size_t page_index_{0};
+    // the offset of the next tuple in the page, 0 before the page is read
+    uint32_t offset_{0};
+    // the offset of the next tuple in the spill file
+    uint64_t file_offset_{0};
+  };
+
+  explicit TmpTupleRun(BufferPoolManager *bpm) : bpm_(bpm) {}
+
+  /** Creates a run in a spill file of its own, see SpillFileManager. */
+  explicit TmpTupleRun(SpillFileManager *spill_files) : bpm_(nullptr), file_(spill_files->CreateFile()) {}
+
+  ~TmpTupleRun();
+
+  DISALLOW_COPY_AND_MOVE(TmpTupleRun);
+
+  /**
+   * Appends a tuple to the last page of the run, or to a new page if it is full.
+   * @return where the tuple went, a page of INVALID_PAGE_ID for a run in a spill file
+   */
+  TmpTuple Append(const Tuple &tuple);
+
+  /**
+   * Appends tuples so that Read() hands them out in the order in which they are given, e.g. a sorted run: the tuples
+   * are split into groups that fill a new page each, and the tuples of a group are appended in reverse.
+   */
+  void AppendInOrder(const std::vector<const Tuple *> &tuples);
+
+  /** Unpins the last page, or writes out the spill file, the run is not appended to any more. */
+  void Finish();
+
+  /**
+   * Reads the tuple at a cursor and moves the cursor past it. The tuples of a page come in the reverse order of their
+   * appends, those of a spill file in order.
+   * @param[out] tuple the tuple
+   * @param[out] tmp_tuple where the tuple is, if not nullptr
+   * @return false if the cursor is at the end of the run
+   */
+  bool Read(Cursor *cursor, Tuple *tuple, TmpTuple *tmp_tuple = nullptr);
+
+  /** @return the number of pages of the run, those that the tuples of a spill file would fill */
+  size_t GetNumPages() const {
+    return file_ == nullptr ? page_ids_.size() : (file_->GetSize() + PAGE_SIZE - 1) / PAGE_SIZE;
+  }
+
+  /** @return the number of tuples of the run */
+  size_t GetNumTuples() const { return num_tuples_; }
+
+ private:
+  /** @return the pinned page of the run, throws if the buffer pool has no frame for it */
+  TmpTuplePage *FetchPage(page_id_t page_id);
+
+  BufferPoolManager *bpm_;
+  std::vector<page_id_t> page_ids_;
+  // the last page, pinned until it is full or the run is finished
+  TmpTuplePage *last_page_{nullptr};
+  size_t num_tuples_{0};
+  // the spill file of the run, nullptr for a run in the buffer pool
+  std::unique_ptr<SpillFile> file_;
+  // a tuple of the spill file, as Tuple::DeserializeFrom() reads it
+  std::vector<char> read_buffer_;
+};
+
+}  // namespace bustub
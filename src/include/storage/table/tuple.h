@@ -12,7 +12,12 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstring>
+#include <deque>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "catalog/schema.h"
@@ -21,6 +26,8 @@
 
 namespace bustub {
 
+class OverflowStore;
+
 /**
  * Tuple format:
  * ---------------------------------------------------------------------
@@ -30,69 +37,167 @@ namespace bustub {
 class Tuple {
   friend class TablePage;
 
+  friend class ColumnarTablePage;
+
   friend class TableHeap;
 
   friend class TableIterator;
 
+  friend class TupleRef;
+
+  friend class OverflowStore;
+
  public:
+  // The length of a VARCHAR that is stored out of line has this flag set, and an OverflowPointer follows it instead of
+  // the string (see OverflowStore)
+  static constexpr uint32_t OVERFLOW_FLAG = 1U << 31;
+
   // Default constructor (to create a dummy tuple)
   Tuple() = default;
 
   // constructor for table heap tuple
   explicit Tuple(RID rid) : rid_(rid) {}
 
+  // constructor for a tuple that refers to data it does not own, e.g. in a log buffer (shallow, never freed)
+  Tuple(const char *data, uint32_t size) : size_(size), data_(const_cast<char *>(data)) {}
+
   // constructor for creating a new tuple based on input value
   Tuple(std::vector<Value> values, const Schema *schema);
 
   // copy constructor, deep copy
   Tuple(const Tuple &other);
 
-  // assign operator, deep copy
+  // move constructor, takes over the data of the other tuple, which is left empty
+  Tuple(Tuple &&other) noexcept;
+
+  // assign operator, deep copy into the buffer of this tuple if it is large enough
   Tuple &operator=(const Tuple &other);
 
-  ~Tuple() {
-    if (allocated_) {
-      delete[] data_;
-    }
-    allocated_ = false;
-    data_ = nullptr;
-  }
+  // move assign operator, takes over the data of the other tuple, which is left empty
+  Tuple &operator=(Tuple &&other) noexcept;
+
+  ~Tuple() { Release(); }
+
+  // serialize values into this tuple, reusing its buffer if it is large enough, e.g. for the tuple of a Next() call
+  void SetValues(const std::vector<Value> &values, const Schema *schema);
   // serialize tuple data
   void SerializeTo(char *storage) const;
 
-  // deserialize tuple data(deep copy)
+  // deserialize tuple data(deep copy), reusing the buffer of this tuple if it is large enough
   void DeserializeFrom(const char *storage);
 
   // return RID of current tuple
   inline RID GetRid() const { return rid_; }
 
+  // set the RID of a tuple that was read from the table heap some other way, e.g. in place
+  inline void SetRid(const RID &rid) { rid_ = rid; }
+
   // Get the address of this tuple in the table's backing store
   inline char *GetData() const { return data_; }
 
   // Get length of the tuple, including varchar legth
   inline uint32_t GetLength() const { return size_; }
 
+  // set the store that the VARCHARs of the tuple that are stored out of line are read from, which copies share
+  inline void SetOverflowStore(const OverflowStore *overflow) { overflow_ = overflow; }
+
   // Get the value of a specified column (const)
   // checks the schema to see how to return the Value.
   Value GetValue(const Schema *schema, uint32_t column_idx) const;
 
-  // Is the column value null ?
-  inline bool IsNull(const Schema *schema, uint32_t column_idx) const {
-    Value value = GetValue(schema, column_idx);
-    return value.IsNull();
+  // Get the value of a specified column, whose varlen data is borrowed from a pool (see Value::DeserializeFrom)
+  Value GetValue(const Schema *schema, uint32_t column_idx, AbstractPool *pool) const;
+
+  // Get a view of the value of a specified column, whose varlen data is borrowed from the tuple instead of copied
+  // (see Value::GetView): the value is only valid as long as the tuple is, and not changed
+  Value GetValueView(const Schema *schema, uint32_t column_idx) const;
+
+  // Get the key of an index from this tuple: the values of the key columns, as a tuple of the key schema
+  Tuple KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const;
+
+  // Fast accessors of a column of the given type, which read its bytes in place through the layout of the schema (see
+  // Schema::GetColumnLayout) instead of deserializing a Value. A null reads as the null of the type, e.g.
+  // BUSTUB_INT32_NULL.
+  inline int32_t GetInt32(const Schema *schema, uint32_t column_idx) const {
+    assert(schema->GetColumnLayout(column_idx).type_id_ == TypeId::INTEGER);
+    return Load<int32_t>(data_ + schema->GetColumnLayout(column_idx).offset_);
+  }
+  inline int64_t GetInt64(const Schema *schema, uint32_t column_idx) const {
+    assert(schema->GetColumnLayout(column_idx).type_id_ == TypeId::BIGINT);
+    return Load<int64_t>(data_ + schema->GetColumnLayout(column_idx).offset_);
   }
+  inline double GetDecimal(const Schema *schema, uint32_t column_idx) const {
+    assert(schema->GetColumnLayout(column_idx).type_id_ == TypeId::DECIMAL);
+    return Load<double>(data_ + schema->GetColumnLayout(column_idx).offset_);
+  }
+
+  // Get the string of a VARCHAR column without its terminating zero, borrowed from the tuple like GetValueView. A null
+  // reads as an empty view, which IsNull tells apart from an empty string.
+  inline std::string_view GetStringView(const Schema *schema, uint32_t column_idx) const {
+    assert(schema->GetColumnLayout(column_idx).type_id_ == TypeId::VARCHAR);
+    const char *data_ptr = GetDataPtr(schema, column_idx);
+    const auto len = Load<uint32_t>(data_ptr);
+    if (len == BUSTUB_VALUE_NULL || len == 0) {
+      return std::string_view();
+    }
+    if ((len & OVERFLOW_FLAG) != 0) {
+      return ReadOverflowView(data_ptr);
+    }
+    return std::string_view(data_ptr + sizeof(uint32_t), len - 1);
+  }
+
+  // Is the column value null ?
+  bool IsNull(const Schema *schema, uint32_t column_idx) const;
   inline bool IsAllocated() { return allocated_; }
 
   std::string ToString(const Schema *schema) const;
 
  private:
   // Get the starting storage address of specific column
-  const char *GetDataPtr(const Schema *schema, uint32_t column_idx) const;
+  inline const char *GetDataPtr(const Schema *schema, uint32_t column_idx) const {
+    assert(data_);
+    const ColumnLayout &layout = schema->GetColumnLayout(column_idx);
+    // For inline type, data is stored where it is.
+    if (layout.inlined_) {
+      return data_ + layout.offset_;
+    }
+    // We read the relative offset from the tuple data, which is where the real data of the VARCHAR begins.
+    return data_ + Load<int32_t>(data_ + layout.offset_);
+  }
+
+  // Is the VARCHAR at the storage address of a column stored out of line?
+  static inline bool IsOverflow(const char *data_ptr) {
+    const auto len = Load<uint32_t>(data_ptr);
+    return len != BUSTUB_VALUE_NULL && (len & OVERFLOW_FLAG) != 0;
+  }
+
+  // Read a VARCHAR that is stored out of line into memory from a pool, or of the value if the pool is nullptr
+  Value ReadOverflow(const char *data_ptr, AbstractPool *pool) const;
+
+  // Read a VARCHAR that is stored out of line into memory of the tuple, which lasts until the tuple is released
+  std::string_view ReadOverflowView(const char *data_ptr) const;
+
+  // Read a value of a native type from the tuple bytes, which need not be aligned for it
+  template <class T>
+  static inline T Load(const char *ptr) {
+    T value;
+    memcpy(&value, ptr, sizeof(T));
+    return value;
+  }
+
+  // Make the tuple size bytes long in a buffer of its own, which is reused if it is large enough, and return it
+  char *Reserve(uint32_t size);
+
+  // Free the buffer of the tuple, if it owns one, and leave it empty
+  void Release();
 
   bool allocated_{false};  // is allocated?
   RID rid_{};              // if pointing to the table heap, the rid is valid
   uint32_t size_{0};
+  uint32_t capacity_{0};  // the size of the buffer, if allocated
   char *data_{nullptr};
+  const OverflowStore *overflow_{nullptr};  // where the VARCHARs stored out of line are read from, if any
+  mutable std::unique_ptr<std::deque<std::string>> overflow_views_;  // the strings read for ReadOverflowView
 };
 
 }  // namespace bustub
@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_ref.h
+//
+// Identification: src/include/storage/table/tuple_ref.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <utility>
+
+#include "storage/page/page_guard.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TupleRef is a tuple of a table that is read without copying it out of its page, see TableHeap::GetTupleRef(): the
+ * tuple borrows the bytes of the page, which the ref keeps pinned and read latched until it is released or destroyed.
+ * A transaction that cannot read the table in place, see TableHeap::ReadsInPlace(), gets a copy of the tuple instead,
+ * which the ref owns.
+ *
+ * A ref is for a reader that is done with the tuple soon, e.g. one that tests a predicate on it and projects a few
+ * values out of it. Since it holds the latch of the page, it is released before anything else fetches pages for a
+ * while, and a tuple that must outlive it is copied with ToTuple().
+ */
+class TupleRef {
+ public:
+  TupleRef() = default;
+  TupleRef(const TupleRef &) = delete;
+  TupleRef &operator=(const TupleRef &) = delete;
+  TupleRef(TupleRef &&) = default;
+  TupleRef &operator=(TupleRef &&) = default;
+  ~TupleRef() = default;
+
+  /** @return the tuple, which is only valid until the ref is released */
+  const Tuple &operator*() const { return tuple_; }
+  const Tuple *operator->() const { return &tuple_; }
+
+  /** @return true if the tuple borrows the bytes of its page, false if it is a copy */
+  bool IsBorrowed() const { return guard_.IsValid(); }
+
+  /** @return a copy of the tuple, which owns its bytes */
+  Tuple ToTuple() const {
+    Tuple owned(tuple_.rid_);
+    memcpy(owned.Reserve(tuple_.size_), tuple_.data_, tuple_.size_);
+    owned.SetOverflowStore(tuple_.overflow_);
+    return owned;
+  }
+
+  /** Lets go of the tuple, and unlatches and unpins its page. */
+  void Release() {
+    tuple_ = Tuple();
+    guard_.Drop();
+  }
+
+ private:
+  friend class TableHeap;
+
+  ReadPageGuard guard_;
+  Tuple tuple_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// vacuum_manager.h
+//
+// Identification: src/include/storage/table/vacuum_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+#include <vector>
+
+#include "concurrency/transaction_manager.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+/**
+ * VacuumManager vacuums the tables that were added to it, see TableHeap::Vacuum(), so that a table whose tuples are
+ * deleted gives the room of the deleted tuples and its empty pages back. It vacuums them on demand, or in the
+ * background every vacuum_interval once the background vacuum is started.
+ */
+class VacuumManager {
+ public:
+  /** @param transaction_manager the manager of the transactions that use the tables */
+  explicit VacuumManager(TransactionManager *transaction_manager) : transaction_manager_(transaction_manager) {}
+
+  /** Stops the background vacuum. */
+  ~VacuumManager();
+
+  /** Adds a table to those that are vacuumed. */
+  void AddTable(TableHeap *table);
+
+  /** Removes a table from those that are vacuumed, which waits for a vacuum of the table that is running. */
+  void RemoveTable(TableHeap *table);
+
+  /**
+   * Vacuums every table once.
+   * @return the number of pages that were deallocated
+   */
+  size_t VacuumTables();
+
+  /** Starts vacuuming the tables in the background every vacuum_interval. */
+  void StartVacuumThread();
+
+  /** Stops the background vacuum, after the vacuum that is running, if any. */
+  void StopVacuumThread();
+
+ private:
+  /** Body of the background thread. */
+  void RunVacuumThread();
+
+  TransactionManager *transaction_manager_;
+
+  /** Protects the tables, and is held while they are vacuumed. */
+  std::mutex tables_latch_;
+  std::vector<TableHeap *> tables_;
+
+  /** The thread of the background vacuum, nullptr if it is not running. */
+  std::thread *vacuum_thread_ = nullptr;
+  /** Protects the flag below. */
+  std::mutex latch_;
+  /** Wakes the background thread up early. */
+  std::condition_variable cv_;
+  /** True once the background thread should exit. Protected by latch_. */
+  bool stop_requested_ = false;
+};
+
+}  // namespace bustub
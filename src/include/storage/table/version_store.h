@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store.h
+//
+// Identification: src/include/storage/table/version_store.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/rid.h"
+#include "concurrency/transaction.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * VersionStore keeps the older versions of the recently written rows of a table, for the transactions that read a
+ * snapshot. The newest version of a row is the one in its page, a row has a version chain here while an uncommitted
+ * write or a snapshot older than its newest version may need the versions before.
+ *
+ * A write records the version that it replaces, while holding the write latch of the page, so that a reader either
+ * sees the page before the write, or the write together with its chain. Commit timestamps are handed out by the
+ * TransactionManager, which calls Commit() for all rows of a transaction before its timestamp becomes visible.
+ */
+class VersionStore {
+ public:
+  /**
+   * @param rid the row to be written
+   * @param txn the writing transaction, which holds the exclusive lock on the row if locking is on
+   * @return false if the newest version was committed after the snapshot of txn, or is not committed by another
+   * transaction: snapshot isolation lets the first writer win
+   */
+  bool CanWrite(const RID &rid, Transaction *txn);
+
+  /**
+   * Validates a read of an optimistic transaction, called while the TransactionManager serializes the commits.
+   * @param rid the row that was read
+   * @param txn the committing transaction
+   * @return false if a version of the row was committed after the snapshot of txn; an uncommitted version of another
+   * transaction commits after txn, so its write does not conflict with the read
+   */
+  bool Validate(const RID &rid, Transaction *txn);
+
+  /**
+   * Records a write of a row by a transaction, called while holding the write latch of its page.
+   * @param rid the row that was written
+   * @param txn the writing transaction
+   * @param old_tuple the version before the write, nullptr for an insert
+   */
+  void AddVersion(const RID &rid, Transaction *txn, const Tuple *old_tuple);
+
+  /**
+   * Stamps the uncommitted version of a row with the commit timestamp of its transaction.
+   * @param rid the row that was written
+   * @param txn the committing transaction
+   * @param commit_ts the commit timestamp
+   * @param watermark the oldest read timestamp of the active transactions, versions before it are dropped
+   */
+  void Commit(const RID &rid, Transaction *txn, timestamp_t commit_ts, timestamp_t watermark);
+
+  /**
+   * Undoes AddVersion() after the page was rolled back, called while holding the write latch of the page.
+   * @param rid the row that was written
+   * @param txn the aborting transaction
+   */
+  void Rollback(const RID &rid, Transaction *txn);
+
+  /**
+   * Finds the version of a row that a snapshot sees.
+   * @param rid the row to be read
+   * @param txn the reading transaction
+   * @param in_page true if the row exists in its page, which was copied to tuple
+   * @param[in,out] tuple the version in the page, replaced by the one that txn sees
+   * @return true if txn sees a version of the row
+   */
+  bool Read(const RID &rid, Transaction *txn, bool in_page, Tuple *tuple);
+
+  /**
+   * Drops the versions that no transaction sees anymore of all rows at once, e.g. before a vacuum, which leaves the
+   * slots of the rows with a chain alone.
+   * @param watermark the oldest read timestamp of the active transactions
+   */
+  void PruneAll(timestamp_t watermark);
+
+  /** @return true if a row has a version chain, i.e. a snapshot may still read a version of it from its slot */
+  bool HasChain(const RID &rid) {
+    std::lock_guard<std::mutex> guard(latch_);
+    return chains_.count(rid) > 0;
+  }
+
+  /** @return the number of rows with a version chain, for testing */
+  size_t GetChainCount() {
+    std::lock_guard<std::mutex> guard(latch_);
+    return chains_.size();
+  }
+
+ private:
+  /** A replaced version of a row. */
+  struct TupleVersion {
+    /** The commit timestamp of the version. */
+    timestamp_t ts_;
+    /** False if the row did not exist in the version, which has no tuple then. */
+    bool exists_;
+    Tuple tuple_;
+  };
+
+  /** The versions of a row before the one in its page. */
+  struct VersionChain {
+    /** The commit timestamp of the version in the page if it is committed. */
+    timestamp_t ts_;
+    /** The transaction that wrote the version in the page, INVALID_TXN_ID once it is committed. */
+    txn_id_t txn_id_;
+    /** The writes of the uncommitted version, which are rolled back one at a time. */
+    uint32_t writes_;
+    /** The replaced versions, the newest last. */
+    std::vector<TupleVersion> undo_;
+  };
+
+  /**
+   * Drops the versions that no transaction sees anymore.
+   * @return true if the chain can be dropped as a whole, its committed version is seen by all transactions
+   */
+  static bool Prune(VersionChain *chain, timestamp_t watermark);
+
+  /** Prunes all chains, called while holding latch_. */
+  void Sweep(timestamp_t watermark);
+
+  std::mutex latch_;
+  std::unordered_map<RID, VersionChain> chains_;
+  /** Chains whose rows are not written again are pruned all at once, when there are twice as many as after the last. */
+  size_t sweep_size_{64};
+};
+
+}  // namespace bustub
@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.h
+//
+// Identification: src/include/storage/table/zone_map.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** The values of a column on a page: the smallest and largest that are not null, and the number of nulls. */
+struct ColumnZone {
+  bool has_values_{false};
+  Value min_;
+  Value max_;
+  uint32_t num_nulls_{0};
+};
+
+/**
+ * ZoneMap summarizes the pages of a table heap, so that a scan can tell that a page holds no tuple that passes its
+ * predicate without fetching it: for every numeric column, the ColumnZone of the tuples that were ever written to a
+ * page, and the page after it in the heap. A zone only ever widens, so it still covers the tuples that a delete or the
+ * rollback of a write leaves behind for the snapshots, at the cost of covering some that are gone.
+ *
+ * The zones live in memory next to the heap, which maintains them while holding the write latch of the page that it
+ * writes. Pages that the zone map does not know, e.g. those of the heap before it was enabled, are never skipped.
+ */
+class ZoneMap {
+ public:
+  /** Creates a zone map without pages for a table of a schema. */
+  explicit ZoneMap(const Schema &schema);
+
+  /** @return true if the values of a column are summarized, which those of the fixed-width numeric types are */
+  bool IsTracked(uint32_t col_idx) const {
+    const TypeId type = schema_.GetColumn(col_idx).GetType();
+    return type >= TypeId::TINYINT && type <= TypeId::DECIMAL;
+  }
+
+  /**
+   * Adds an empty page to the end of the heap.
+   * @param page_id the id of the new page
+   * @param prev_page_id the page that now links to it, INVALID_PAGE_ID for the first page
+   */
+  void AddPage(page_id_t page_id, page_id_t prev_page_id);
+
+  /**
+   * Removes a page that was unlinked from the heap.
+   * @param page_id the id of the removed page
+   * @param prev_page_id the page that linked to it, which now links to the page after it
+   * @param next_page_id the page after it
+   */
+  void RemovePage(page_id_t page_id, page_id_t prev_page_id, page_id_t next_page_id);
+
+  /** Forgets all pages, e.g. of a heap that was truncated. */
+  void Clear() {
+    std::lock_guard<std::mutex> guard(latch_);
+    pages_.clear();
+  }
+
+  /** Widens the zones of a page to cover a tuple that was written to it, if the page is known. */
+  void Update(page_id_t page_id, const Tuple &tuple);
+
+  /**
+   * Looks up the zone of a column of a page.
+   * @param[out] zone the zone of the column
+   * @param[out] next_page_id the page after it, INVALID_PAGE_ID for the last page
+   * @return false if the page is not known, or the column is not tracked
+   */
+  bool GetZone(page_id_t page_id, uint32_t col_idx, ColumnZone *zone, page_id_t *next_page_id) const;
+
+  /** @return false if the page is not known, otherwise sets the page after it */
+  bool GetNextPageId(page_id_t page_id, page_id_t *next_page_id) const;
+
+ private:
+  struct PageZone {
+    page_id_t next_page_id_{INVALID_PAGE_ID};
+    /** One per column of the schema, those of columns that are not tracked stay empty. */
+    std::vector<ColumnZone> columns_;
+  };
+
+  Schema schema_;
+  std::vector<uint32_t> tracked_columns_;
+  mutable std::mutex latch_;
+  std::unordered_map<page_id_t, PageZone> pages_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arena_pool.h
+//
+// Identification: src/include/type/arena_pool.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "common/config.h"
+#include "type/abstract_pool.h"
+
+namespace bustub {
+
+/**
+ * ArenaPool is an AbstractPool that hands out memory by bumping a pointer through blocks of ARENA_BLOCK_SIZE bytes.
+ * Free() does nothing; everything that the pool handed out goes at once in Reset(), which keeps the blocks for the
+ * allocations that follow, or when the pool is destroyed. An allocation larger than a block gets a block of its own,
+ * which Reset() lets go of.
+ *
+ * The varlen data of the values of a TupleBatch comes from its pool, see Value::DeserializeFrom(), so that a batch of
+ * strings costs a few blocks instead of an allocation and a deletion per string.
+ */
+class ArenaPool : public AbstractPool {
+ public:
+  ArenaPool() = default;
+  ArenaPool(const ArenaPool &) = delete;
+  ArenaPool &operator=(const ArenaPool &) = delete;
+  ArenaPool(ArenaPool &&) = default;
+  ArenaPool &operator=(ArenaPool &&) = default;
+  ~ArenaPool() override = default;
+
+  /** @return size bytes, aligned to 8 bytes, which stay valid until the next Reset() */
+  void *Allocate(size_t size) override;
+
+  /** Does nothing, the memory is given back by Reset(). */
+  void Free(void *ptr) override {}
+
+  /** Gives back everything that the pool has handed out, and keeps its blocks of the standard size. */
+  void Reset();
+
+  /** @return the bytes that the pool has handed out since the last Reset() */
+  size_t GetBytesAllocated() const { return bytes_allocated_; }
+
+  /** @return the bytes of the blocks of the pool */
+  size_t GetMemoryUsage() const { return memory_usage_; }
+
+ private:
+  static constexpr size_t ALIGNMENT = 8;
+
+  /** The blocks, of which those before current_ are full, and the next free byte of the current one. */
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  size_t current_{0};
+  size_t offset_{0};
+  /** The blocks of the allocations that are larger than a block. */
+  std::vector<std::unique_ptr<char[]>> large_blocks_;
+  size_t bytes_allocated_{0};
+  size_t memory_usage_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,183 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// type_kernels.h
+//
+// Identification: src/include/type/type_kernels.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "type/limits.h"
+#include "type/type_id.h"
+#include "type/type_util.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** The C++ type that a Value of a fixed-length TypeId holds, see Value::GetAs(). */
+template <TypeId T>
+struct NativeTypeOf;
+template <>
+struct NativeTypeOf<TypeId::BOOLEAN> {
+  using Type = int8_t;
+};
+template <>
+struct NativeTypeOf<TypeId::TINYINT> {
+  using Type = int8_t;
+};
+template <>
+struct NativeTypeOf<TypeId::SMALLINT> {
+  using Type = int16_t;
+};
+template <>
+struct NativeTypeOf<TypeId::INTEGER> {
+  using Type = int32_t;
+};
+template <>
+struct NativeTypeOf<TypeId::BIGINT> {
+  using Type = int64_t;
+};
+template <>
+struct NativeTypeOf<TypeId::DECIMAL> {
+  using Type = double;
+};
+template <>
+struct NativeTypeOf<TypeId::TIMESTAMP> {
+  using Type = uint64_t;
+};
+
+/**
+ * TypeKernel holds the operations on values of one type, compiled for that type: they read the values in place, and
+ * compare and hash them inline, where a Value goes through Type::GetInstance() and a virtual call of its Type for
+ * every operation.
+ *
+ * A kernel gives the same results as the methods of Value and HashUtil::HashValue(). It falls back on them for a value
+ * of another type, e.g. an INTEGER compared with a BIGINT, so that it is always safe to pick the kernel of the type
+ * that an expression returns.
+ */
+template <TypeId T>
+class TypeKernel {
+ public:
+  /** @return like left.CompareEquals(right) */
+  static inline CmpBool CompareEquals(const Value &left, const Value &right) {
+    if (!IsFast(left, right)) {
+      return left.CompareEquals(right);
+    }
+    if (left.IsNull() || right.IsNull()) {
+      return CmpBool::CmpNull;
+    }
+    if constexpr (T == TypeId::VARCHAR) {
+      return GetCmpBool(Compare(left, right) == 0);
+    } else {
+      // Not by Compare(), for a NaN equals nothing.
+      using Native = typename NativeTypeOf<T>::Type;
+      return GetCmpBool(left.GetAs<Native>() == right.GetAs<Native>());
+    }
+  }
+
+  /** @return like left.CompareLessThan(right) */
+  static inline CmpBool CompareLessThan(const Value &left, const Value &right) {
+    if (!IsFast(left, right)) {
+      return left.CompareLessThan(right);
+    }
+    if (left.IsNull() || right.IsNull()) {
+      return CmpBool::CmpNull;
+    }
+    return GetCmpBool(Compare(left, right) < 0);
+  }
+
+  /** @return like HashUtil::HashValue(&value), the value not being null */
+  static inline hash_t Hash(const Value &value) {
+    if (value.GetTypeId() != T) {
+      return HashUtil::HashValue(&value);
+    }
+    if constexpr (T == TypeId::DECIMAL) {
+      auto raw = value.GetAs<double>();
+      return HashUtil::Hash<double>(&raw);
+    }
+    if constexpr (T == TypeId::VARCHAR) {
+      return HashUtil::HashBytes(GetVarlenData(value), GetVarlenLength(value));
+    } else if constexpr (T == TypeId::BOOLEAN) {
+      return HashUtil::HashInt(static_cast<uint64_t>(value.GetAs<bool>()));
+    } else if constexpr (T == TypeId::TIMESTAMP) {
+      return HashUtil::HashInt(value.GetAs<uint64_t>());
+    } else {
+      return HashUtil::HashInt(static_cast<int64_t>(value.GetAs<typename NativeTypeOf<T>::Type>()));
+    }
+  }
+
+  /**
+   * Combines the hashes of values into hashes, hashes[i] becoming like
+   * HashUtil::CombineHashes(hashes[i], HashUtil::HashValue(&values[i])).
+   * @param skip_nulls true if a null leaves its hash as it is, false if it combines 0 into it
+   */
+  static void HashCombine(const std::vector<Value> &values, bool skip_nulls, hash_t *hashes) {
+    for (size_t i = 0; i < values.size(); i++) {
+      if (!values[i].IsNull()) {
+        hashes[i] = HashUtil::CombineHashes(hashes[i], Hash(values[i]));
+      } else if (!skip_nulls) {
+        hashes[i] = HashUtil::CombineHashes(hashes[i], 0);
+      }
+    }
+  }
+
+ private:
+  /** @return true if both values are of the type, and compare without a cast */
+  static inline bool IsFast(const Value &left, const Value &right) {
+    if (left.GetTypeId() != T || right.GetTypeId() != T) {
+      return false;
+    }
+    if constexpr (T == TypeId::VARCHAR) {
+      // The maximal length stands for the maximal string, which only Value compares.
+      return left.IsNull() || right.IsNull() ||
+             (GetVarlenLength(left) != BUSTUB_VARCHAR_MAX_LEN && GetVarlenLength(right) != BUSTUB_VARCHAR_MAX_LEN);
+    }
+    return true;
+  }
+
+  /** @return the order of two values of the type that are not null, as a negative number, 0 or a positive one */
+  static inline int Compare(const Value &left, const Value &right) {
+    if constexpr (T == TypeId::VARCHAR) {
+      return TypeUtil::CompareStrings(GetVarlenData(left), static_cast<int>(GetVarlenLength(left) - 1),
+                                      GetVarlenData(right), static_cast<int>(GetVarlenLength(right) - 1));
+    } else {
+      using Native = typename NativeTypeOf<T>::Type;
+      const Native l = left.GetAs<Native>();
+      const Native r = right.GetAs<Native>();
+      return l < r ? -1 : (r < l ? 1 : 0);
+    }
+  }
+
+  static inline const char *GetVarlenData(const Value &value) {
+    return value.inline_len_ != 0 ? value.GetInlineData() : value.value_.const_varlen_;
+  }
+
+  static inline uint32_t GetVarlenLength(const Value &value) {
+    return value.inline_len_ != 0 ? value.inline_len_ : value.size_.len_;
+  }
+};
+
+/**
+ * TypeKernels is a table of the kernels of one type, for code that only learns the types of its values at runtime,
+ * e.g. from a plan: it looks the table up once per column with Get(), and then calls the kernels of the column without
+ * a virtual call per value. A type that has no kernels gets the generic ones, which call the methods of Value.
+ */
+struct TypeKernels {
+  /** @return the table of the kernels of a type */
+  static const TypeKernels &Get(TypeId type_id);
+
+  CmpBool (*compare_equals_)(const Value &left, const Value &right);
+  CmpBool (*compare_less_than_)(const Value &left, const Value &right);
+  void (*hash_combine_)(const std::vector<Value> &values, bool skip_nulls, hash_t *hashes);
+};
+
+}  // namespace bustub
@@ -12,10 +12,12 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstring>
 #include <string>
 #include <utility>
 
+#include "type/abstract_pool.h"
 #include "type/limits.h"
 #include "type/type.h"
 
@@ -39,6 +41,8 @@ class Value {
   friend class TimestampType;
   friend class BooleanType;
   friend class VarlenType;
+  template <TypeId T>
+  friend class TypeKernel;
 
  public:
   explicit Value(const TypeId type) : manage_data_(false), type_id_(type) { size_.len_ = BUSTUB_VALUE_NULL; }
@@ -60,7 +64,10 @@ class Value {
   Value(TypeId type, const std::string &data);
 
   Value() : Value(TypeId::INVALID) {}
+  // A copy owns its varlen data, even if the value that it copies borrows it
   Value(const Value &other);
+  // A moved value keeps the varlen data as it was, owned or borrowed
+  Value(Value &&other) noexcept;
   Value &operator=(Value other);
   ~Value();
   // NOLINTNEXTLINE
@@ -68,6 +75,7 @@ class Value {
     std::swap(first.value_, second.value_);
     std::swap(first.size_, second.size_);
     std::swap(first.manage_data_, second.manage_data_);
+    std::swap(first.inline_len_, second.inline_len_);
     std::swap(first.type_id_, second.type_id_);
   }
   // check whether value is integer
@@ -118,7 +126,7 @@ class Value {
 
   inline Value OperateNull(const Value &o) const { return Type::GetInstance(type_id_)->OperateNull(*this, o); }
   inline bool IsZero() const { return Type::GetInstance(type_id_)->IsZero(*this); }
-  inline bool IsNull() const { return size_.len_ == BUSTUB_VALUE_NULL; }
+  inline bool IsNull() const { return inline_len_ == 0 && size_.len_ == BUSTUB_VALUE_NULL; }
 
   // Serialize this value into the given storage space. The inlined parameter
   // indicates whether we are allowed to inline this value into the storage
@@ -128,14 +136,23 @@ class Value {
   inline void SerializeTo(char *storage) const { Type::GetInstance(type_id_)->SerializeTo(*this, storage); }
 
   // Deserialize a value of the given type from the given storage space.
-  inline static Value DeserializeFrom(const char *storage, const TypeId type_id) {
-    return Type::GetInstance(type_id)->DeserializeFrom(storage);
-  }
+  static Value DeserializeFrom(const char *storage, TypeId type_id);
+
+  // Deserialize a value whose varlen data, if any, is copied into a pool and borrowed from there, so that it is only
+  // valid as long as the memory of the pool is, e.g. until ArenaPool::Reset(). Copies of the value own their data.
+  static Value DeserializeFrom(const char *storage, TypeId type_id, AbstractPool *pool);
 
   // Return a string version of this value
   inline std::string ToString() const { return Type::GetInstance(type_id_)->ToString(*this); }
   // Create a copy of this value
   inline Value Copy() const { return Type::GetInstance(type_id_)->Copy(*this); }
+  // Create a view of this value, which borrows its varlen data instead of copying it, so that it is only valid as long
+  // as this value is. A short VARCHAR is copied, being kept in the value itself anyway (see INLINE_VARLEN_SIZE).
+  Value GetView() const;
+
+  // VARCHARs of up to this many bytes, the terminating zero included, are kept in the value itself instead of the
+  // heap, in the bytes of value_ and size_, so that they are copied without an allocation
+  static constexpr uint32_t INLINE_VARLEN_SIZE = 12;
 
  protected:
   // The actual value item
@@ -157,7 +174,15 @@ class Value {
   } size_;
 
   bool manage_data_;
+  // The length of a VARCHAR that is kept in the value itself, 0 if it is not
+  uint8_t inline_len_{0};
   // The data type
   TypeId type_id_;
+
+ private:
+  // Keeps len bytes of VARCHAR data in the value itself, len being at most INLINE_VARLEN_SIZE
+  void SetInline(const char *data, uint32_t len);
+  // The VARCHAR data that is kept in the value itself
+  const char *GetInlineData() const { return reinterpret_cast<const char *>(this) + offsetof(Value, value_); }
 };
 }  // namespace bustub
@@ -34,8 +34,12 @@ namespace bustub {
 
 class ValueFactory {
  public:
-  static inline Value Clone(const Value &src, __attribute__((__unused__)) AbstractPool *dataPool = nullptr) {
-    return src.Copy();
+  /** @return a copy of a value, whose varlen data, given a pool, is borrowed from the pool, see GetVarcharValue() */
+  static inline Value Clone(const Value &src, AbstractPool *dataPool = nullptr) {
+    if (dataPool == nullptr || src.GetTypeId() != TypeId::VARCHAR || src.IsNull()) {
+      return src.Copy();
+    }
+    return GetVarcharValue(src.GetData(), src.GetLength(), false, dataPool);
   }
 
   static inline Value GetTinyIntValue(int8_t value) { return Value(TypeId::TINYINT, value); }
@@ -58,20 +62,31 @@ class ValueFactory {
 
   static inline Value GetBooleanValue(int8_t value) { return Value(TypeId::BOOLEAN, value); }
 
-  static inline Value GetVarcharValue(const char *value, bool manage_data,
-                                      __attribute__((__unused__)) AbstractPool *pool = nullptr) {
+  static inline Value GetVarcharValue(const char *value, bool manage_data, AbstractPool *pool = nullptr) {
     auto len = static_cast<uint32_t>(value == nullptr ? 0U : strlen(value) + 1);
-    return GetVarcharValue(value, len, manage_data);
+    return GetVarcharValue(value, len, manage_data, pool);
   }
 
+  /**
+   * @return a varchar of len bytes of data. Given a pool, the bytes are copied into memory of the pool, which the value
+   * borrows, and manage_data is ignored: the value is valid as long as the memory of the pool is, and its copies own
+   * their data.
+   */
   static inline Value GetVarcharValue(const char *value, uint32_t len, bool manage_data,
-                                      __attribute__((__unused__)) AbstractPool *pool = nullptr) {
-    return Value(TypeId::VARCHAR, value, len, manage_data);
+                                      AbstractPool *pool = nullptr) {
+    if (pool == nullptr || value == nullptr || len <= Value::INLINE_VARLEN_SIZE) {
+      return Value(TypeId::VARCHAR, value, len, manage_data);
+    }
+    auto data = static_cast<char *>(pool->Allocate(len));
+    memcpy(data, value, len);
+    return Value(TypeId::VARCHAR, data, len, false);
   }
 
-  static inline Value GetVarcharValue(const std::string &value,
-                                      __attribute__((__unused__)) AbstractPool *pool = nullptr) {
-    return Value(TypeId::VARCHAR, value);
+  static inline Value GetVarcharValue(const std::string &value, AbstractPool *pool = nullptr) {
+    if (pool == nullptr) {
+      return Value(TypeId::VARCHAR, value);
+    }
+    return GetVarcharValue(value.c_str(), static_cast<uint32_t>(value.length()) + 1, false, pool);
   }
 
   static inline Value GetNullValueByType(TypeId type_id) {
@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_replica.cpp
+//
+// Identification: src/network/log_replica.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "network/log_replica.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+
+#include "common/logger.h"
+#include "recovery/log_record.h"
+
+namespace bustub {
+
+LogReplica::LogReplica(BustubInstance *instance, size_t log_buffer_size)
+    : instance_(instance),
+      log_buffer_size_(log_buffer_size),
+      recovery_(instance->disk_manager_, instance->buffer_pool_manager_, log_buffer_size) {
+  // The records of the primary go after whatever the log of the replica has already.
+  scanned_offset_ = instance_->disk_manager_->GetLogSize();
+  consistent_offset_ = scanned_offset_;
+  applied_offset_ = scanned_offset_;
+}
+
+bool LogReplica::Start(const std::string &address, uint16_t port) {
+  if (fd_ >= 0) {
+    return true;
+  }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+    return false;
+  }
+  fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd_ < 0) {
+    return false;
+  }
+  if (::connect(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+    LOG_WARN("Cannot connect to the primary at %s:%u", address.c_str(), port);
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  connected_ = true;
+  receiver_ = std::thread(&LogReplica::RunReceiver, this);
+  return true;
+}
+
+void LogReplica::Stop() {
+  if (fd_ < 0) {
+    return;
+  }
+  // Shutting the socket down wakes up the receiver that waits in recv().
+  ::shutdown(fd_, SHUT_RDWR);
+  receiver_.join();
+  ::close(fd_);
+  fd_ = -1;
+}
+
+bool LogReplica::WaitForLSN(lsn_t lsn, std::chrono::milliseconds timeout) {
+  std::unique_lock lock(latch_);
+  applied_cv_.wait_for(lock, timeout, [&] { return applied_lsn_ >= lsn || !connected_; });
+  return applied_lsn_ >= lsn;
+}
+
+void LogReplica::RunReceiver() {
+  DiskManager *disk_manager = instance_->disk_manager_;
+  // The disk manager may still hold on to the last buffer that it wrote, so the receives alternate between two.
+  std::vector<char> buffers[2] = {std::vector<char>(log_buffer_size_), std::vector<char>(log_buffer_size_)};
+  int buffer_index = 0;
+  while (true) {
+    char *data = buffers[buffer_index].data();
+    ssize_t n = ::recv(fd_, data, log_buffer_size_, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    // Take what else has arrived as well, so that a burst of log is written and applied at once.
+    auto size = static_cast<size_t>(n);
+    while (size < log_buffer_size_) {
+      n = ::recv(fd_, data + size, log_buffer_size_ - size, MSG_DONTWAIT);
+      if (n <= 0) {
+        break;
+      }
+      size += n;
+    }
+    disk_manager->WriteLog(data, static_cast<int>(size));
+    buffer_index ^= 1;
+    ScanLog(data, size);
+    // The log of the replica is on disk up to there, so its pages may be written back, see the write-ahead rule.
+    instance_->log_manager_->SetPersistentLSN(scanned_lsn_);
+
+    int64_t target_offset = consistent_offset_;
+    lsn_t target_lsn = consistent_lsn_;
+    if (scanned_offset_ - applied_offset_ > REPLICA_MAX_APPLY_LAG) {
+      target_offset = scanned_offset_;
+      target_lsn = scanned_lsn_;
+    }
+    if (target_offset <= applied_offset_) {
+      continue;
+    }
+    {
+      std::unique_lock apply_lock(apply_latch_);
+      applied_offset_ = recovery_.RedoRange(applied_offset_, target_offset);
+    }
+    std::scoped_lock lock(latch_);
+    applied_lsn_ = target_lsn;
+    applied_cv_.notify_all();
+  }
+  std::scoped_lock lock(latch_);
+  connected_ = false;
+  applied_cv_.notify_all();
+}
+
+void LogReplica::ScanLog(const char *data, size_t size) {
+  partial_record_.insert(partial_record_.end(), data, data + size);
+  size_t pos = 0;
+  LogRecordView log_record;
+  while (log_record.Parse(partial_record_.data() + pos, partial_record_.size() - pos)) {
+    switch (log_record.GetLogRecordType()) {
+      case LogRecordType::COMMIT:
+      case LogRecordType::ABORT:
+        active_txns_.erase(log_record.GetTxnId());
+        break;
+      case LogRecordType::BEGIN_CHECKPOINT:
+      case LogRecordType::END_CHECKPOINT:
+        break;
+      default:
+        active_txns_.insert(log_record.GetTxnId());
+        break;
+    }
+    pos += log_record.GetSize();
+    scanned_offset_ += log_record.GetSize();
+    scanned_lsn_ = log_record.GetLSN();
+    if (active_txns_.empty()) {
+      consistent_offset_ = scanned_offset_;
+      consistent_lsn_ = scanned_lsn_;
+    }
+  }
+  partial_record_.erase(partial_record_.begin(), partial_record_.begin() + pos);
+}
+
+}  // namespace bustub
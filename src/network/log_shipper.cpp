@@ -0,0 +1,207 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_shipper.cpp
+//
+// Identification: src/network/log_shipper.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "network/log_shipper.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return false if the connection broke before all of the data was sent */
+bool SendAll(int fd, const char *data, size_t size) {
+  size_t sent = 0;
+  while (sent < size) {
+    const ssize_t n = ::send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return false;
+    }
+    sent += n;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool LogShipper::Start(uint16_t port, const std::string &address) {
+  if (listen_fd_ >= 0) {
+    return true;
+  }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+    return false;
+  }
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    return false;
+  }
+  const int reuse = 1;
+  ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  socklen_t len = sizeof(addr);
+  if (::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd_, 16) != 0 ||
+      ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len) != 0) {
+    LOG_WARN("Cannot listen on %s:%u", address.c_str(), port);
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  port_ = ntohs(addr.sin_port);
+  log_manager_->SetLogListener(
+      [this](const char *data, size_t size, int64_t end_offset) { Enqueue(data, size, end_offset); });
+  listener_ = std::thread(&LogShipper::RunListener, this);
+  return true;
+}
+
+void LogShipper::Stop() {
+  if (listen_fd_ < 0) {
+    return;
+  }
+  log_manager_->SetLogListener(nullptr);
+  // Shutting the sockets down wakes up the threads that wait in accept() and send().
+  ::shutdown(listen_fd_, SHUT_RDWR);
+  listener_.join();
+  ::close(listen_fd_);
+  listen_fd_ = -1;
+  {
+    std::scoped_lock lock(latch_);
+    stop_ = true;
+    for (Replica &replica : replicas_) {
+      ::shutdown(replica.fd_, SHUT_RDWR);
+    }
+  }
+  cv_.notify_all();
+  for (Replica &replica : replicas_) {
+    replica.thread_.join();
+    ::close(replica.fd_);
+  }
+  std::scoped_lock lock(latch_);
+  replicas_.clear();
+  stop_ = false;
+}
+
+size_t LogShipper::GetNumReplicas() {
+  std::scoped_lock lock(latch_);
+  size_t num_replicas = 0;
+  for (const Replica &replica : replicas_) {
+    num_replicas += replica.done_ ? 0 : 1;
+  }
+  return num_replicas;
+}
+
+void LogShipper::Enqueue(const char *data, size_t size, int64_t end_offset) {
+  std::scoped_lock lock(latch_);
+  if (replicas_.empty()) {
+    return;
+  }
+  // The replicas share a copy of the buffer, which the log manager appends to again once this returns.
+  auto buffer = std::make_shared<const std::string>(data, size);
+  for (Replica &replica : replicas_) {
+    if (replica.done_ || replica.dropped_) {
+      continue;
+    }
+    if (replica.queued_bytes_ + size > LOG_SHIPPER_MAX_BACKLOG) {
+      LOG_WARN("Disconnecting a replica that fell behind by %zu bytes of log", replica.queued_bytes_);
+      replica.dropped_ = true;
+      ::shutdown(replica.fd_, SHUT_RDWR);
+      continue;
+    }
+    replica.queue_.emplace_back(buffer, end_offset);
+    replica.queued_bytes_ += size;
+  }
+  cv_.notify_all();
+}
+
+void LogShipper::RunListener() {
+  while (true) {
+    const int fd = ::accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      // The listening socket was shut down.
+      return;
+    }
+    std::scoped_lock lock(latch_);
+    for (auto it = replicas_.begin(); it != replicas_.end();) {
+      if (it->done_) {
+        it->thread_.join();
+        ::close(it->fd_);
+        it = replicas_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    // The replica gets the log buffers that are written from here on, before its thread reads the log file.
+    Replica *replica = &replicas_.emplace_back();
+    replica->fd_ = fd;
+    replica->thread_ = std::thread(&LogShipper::Serve, this, replica);
+  }
+}
+
+void LogShipper::Serve(Replica *replica) {
+  const int fd = replica->fd_;
+  if (disk_manager_->GetLogStartOffset() > 0) {
+    LOG_WARN("Cannot start a replica, the log was truncated by a checkpoint");
+    replica->done_ = true;
+    ::shutdown(fd, SHUT_RDWR);
+    return;
+  }
+  // Catch up from the log file, up to where it ends once the reads get there. The buffers written meanwhile are
+  // queued, the ones that end up to there are in the file already. Reads of whole compressed blocks need a buffer as
+  // large as a log buffer.
+  std::vector<char> data(log_manager_->GetLogBufferSize());
+  int64_t offset = 0;
+  int read_size;
+  int64_t next_offset;
+  while (disk_manager_->ReadLog(data.data(), static_cast<int>(data.size()), offset, &read_size, &next_offset) &&
+         read_size > 0) {
+    if (!SendAll(fd, data.data(), read_size)) {
+      replica->done_ = true;
+      return;
+    }
+    offset = next_offset;
+  }
+
+  while (true) {
+    std::shared_ptr<const std::string> buffer;
+    int64_t end_offset;
+    {
+      std::unique_lock lock(latch_);
+      cv_.wait(lock, [&] { return stop_ || replica->dropped_ || !replica->queue_.empty(); });
+      if (stop_ || replica->dropped_) {
+        break;
+      }
+      std::tie(buffer, end_offset) = std::move(replica->queue_.front());
+      replica->queue_.pop_front();
+      replica->queued_bytes_ -= buffer->size();
+    }
+    // A log buffer is written at once, so it ends either up to the offset that the catch-up read to or after it.
+    if (end_offset > offset && !SendAll(fd, buffer->data(), buffer->size())) {
+      break;
+    }
+  }
+  std::scoped_lock lock(latch_);
+  replica->queue_.clear();
+  replica->queued_bytes_ = 0;
+  replica->done_ = true;
+}
+
+}  // namespace bustub
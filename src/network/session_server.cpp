@@ -0,0 +1,288 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// session_server.cpp
+//
+// Identification: src/network/session_server.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "network/session_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the fields of a line between its tabs */
+std::vector<std::string> SplitTabs(const std::string &line) {
+  std::vector<std::string> fields;
+  size_t start = 0;
+  while (true) {
+    const size_t end = line.find('\t', start);
+    fields.push_back(line.substr(start, end == std::string::npos ? std::string::npos : end - start));
+    if (end == std::string::npos) {
+      return fields;
+    }
+    start = end + 1;
+  }
+}
+
+/** @return false if the connection broke before all of the data was sent */
+bool SendAll(int fd, const std::string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return false;
+    }
+    sent += n;
+  }
+  return true;
+}
+
+/** Answers a client that exceeded a limit with an error batch, and disconnects it. The socket stays open. */
+void Reject(int fd, const std::string &error) {
+  SendAll(fd, "ERROR " + error + "\n\n");
+  ::shutdown(fd, SHUT_RDWR);
+}
+
+}  // namespace
+
+bool SessionServer::Start(uint16_t port, const std::string &address) {
+  if (listen_fd_ >= 0) {
+    return true;
+  }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+    return false;
+  }
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    return false;
+  }
+  const int reuse = 1;
+  ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  socklen_t len = sizeof(addr);
+  if (::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd_, 64) != 0 ||
+      ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len) != 0) {
+    LOG_WARN("Cannot listen on %s:%u", address.c_str(), port);
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+  port_ = ntohs(addr.sin_port);
+  listener_ = std::thread(&SessionServer::RunListener, this);
+  return true;
+}
+
+void SessionServer::Stop() {
+  if (listen_fd_ < 0) {
+    return;
+  }
+  // Shutting the sockets down wakes up the threads that wait in accept() and recv().
+  ::shutdown(listen_fd_, SHUT_RDWR);
+  listener_.join();
+  ::close(listen_fd_);
+  listen_fd_ = -1;
+  std::list<Connection> connections;
+  {
+    std::scoped_lock lock(latch_);
+    connections.swap(connections_);
+  }
+  for (Connection &connection : connections) {
+    ::shutdown(connection.fd_, SHUT_RDWR);
+    connection.thread_.join();
+    ::close(connection.fd_);
+  }
+}
+
+void SessionServer::RunListener() {
+  while (true) {
+    const int fd = ::accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      // The listening socket was shut down.
+      return;
+    }
+    std::scoped_lock lock(latch_);
+    for (auto it = connections_.begin(); it != connections_.end();) {
+      if (it->done_) {
+        it->thread_.join();
+        ::close(it->fd_);
+        it = connections_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (connections_.size() >= max_connections_) {
+      Reject(fd, "too many connections");
+      ::close(fd);
+      continue;
+    }
+    Connection *connection = &connections_.emplace_back();
+    connection->fd_ = fd;
+    connection->thread_ = std::thread(&SessionServer::Serve, this, connection);
+  }
+}
+
+void SessionServer::Serve(Connection *connection) const {
+  const int fd = connection->fd_;
+  // The cache keeps a plan of every statement, so that the plans of the session stay valid.
+  Session session(instance_, catalog_, std::max<size_t>(SESSION_PLAN_CACHE_SIZE, statements_.size()));
+  std::unordered_map<std::string, PreparedPlan *> plans;
+  std::vector<std::string> lines;
+  std::string buffer;
+  char data[4096];
+  while (true) {
+    const ssize_t n = ::recv(fd, data, sizeof(data), 0);
+    if (n <= 0) {
+      break;
+    }
+    buffer.append(data, n);
+    size_t start = 0;
+    for (size_t end = buffer.find('\n'); end != std::string::npos; end = buffer.find('\n', start)) {
+      std::string line = buffer.substr(start, end - start);
+      start = end + 1;
+      if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
+      if (line.size() > max_line_size_) {
+        Reject(fd, "line longer than " + std::to_string(max_line_size_) + " bytes");
+        connection->done_ = true;
+        return;
+      }
+      if (!line.empty()) {
+        if (lines.size() == max_batch_lines_) {
+          Reject(fd, "batch longer than " + std::to_string(max_batch_lines_) + " lines");
+          connection->done_ = true;
+          return;
+        }
+        lines.push_back(std::move(line));
+        continue;
+      }
+      std::string response;
+      for (const std::string &response_line : RunBatch(&session, &plans, lines)) {
+        response += response_line;
+        response += '\n';
+      }
+      response += '\n';
+      lines.clear();
+      if (!SendAll(fd, response)) {
+        connection->done_ = true;
+        return;
+      }
+    }
+    buffer.erase(0, start);
+    // The rest is a line without its newline yet, which may end in a \r.
+    if (buffer.size() > max_line_size_ + 1) {
+      Reject(fd, "line longer than " + std::to_string(max_line_size_) + " bytes");
+      break;
+    }
+  }
+  connection->done_ = true;
+}
+
+std::vector<std::string> SessionServer::RunBatch(Session *session,
+                                                 std::unordered_map<std::string, PreparedPlan *> *plans,
+                                                 const std::vector<std::string> &lines) const {
+  // The statements since the last control line, and the line of each; the others answer ERROR at their place.
+  std::vector<Statement> statements;
+  std::vector<size_t> statement_lines;
+  std::vector<std::string> answers(lines.size());
+  auto run_statements = [&]() {
+    if (statements.empty()) {
+      return;
+    }
+    std::vector<StatementResult> results;
+    session->ExecuteBatch(statements, &results);
+    for (size_t i = 0; i < results.size(); i++) {
+      std::string *answer = &answers[statement_lines[i]];
+      switch (results[i].status_) {
+        case StatementStatus::OK: {
+          const Schema *schema = statements[i].plan_->GetRoot()->OutputSchema();
+          *answer = "OK " + std::to_string(results[i].tuples_.size());
+          for (const Tuple &tuple : results[i].tuples_) {
+            *answer += '\n';
+            for (uint32_t col = 0; col < schema->GetColumnCount(); col++) {
+              *answer += (col == 0 ? "" : "\t") + tuple.GetValue(schema, col).ToString();
+            }
+          }
+          break;
+        }
+        case StatementStatus::ABORTED:
+          *answer = "ABORTED " + results[i].error_;
+          break;
+        case StatementStatus::SKIPPED:
+          *answer = "SKIPPED";
+          break;
+      }
+    }
+    statements.clear();
+    statement_lines.clear();
+  };
+
+  for (size_t i = 0; i < lines.size(); i++) {
+    const std::string &line = lines[i];
+    if (line == "BEGIN" || line == "COMMIT" || line == "ABORT") {
+      run_statements();
+      answers[i] = "OK";
+      if (line == "BEGIN") {
+        session->Begin();
+      } else if (line == "COMMIT") {
+        answers[i] = session->Commit() ? "OK" : "ABORTED";
+      } else {
+        session->Abort();
+      }
+      continue;
+    }
+    std::vector<std::string> fields = SplitTabs(line);
+    auto factory = statements_.find(fields[0]);
+    if (factory == statements_.end()) {
+      answers[i] = "ERROR unknown statement " + fields[0];
+      continue;
+    }
+    PreparedPlan *&plan = (*plans)[fields[0]];
+    if (plan == nullptr) {
+      plan = session->Prepare(factory->second());
+    }
+    if (fields.size() - 1 != plan->GetNumParameters()) {
+      answers[i] = "ERROR " + fields[0] + " takes " + std::to_string(plan->GetNumParameters()) + " parameters";
+      continue;
+    }
+    Statement statement{plan, {}};
+    try {
+      for (size_t p = 1; p < fields.size(); p++) {
+        const Value text(TypeId::VARCHAR, fields[p]);
+        const TypeId type = plan->GetParameterType(p - 1);
+        statement.params_.push_back(type == TypeId::VARCHAR ? text : text.CastAs(type));
+      }
+    } catch (const std::exception &e) {
+      // Not only an Exception, e.g. std::invalid_argument for a number that is not one.
+      answers[i] = std::string("ERROR ") + e.what();
+      continue;
+    }
+    statements.push_back(std::move(statement));
+    statement_lines.push_back(i);
+  }
+  run_statements();
+  return answers;
+}
+
+}  // namespace bustub
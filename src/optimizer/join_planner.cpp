@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_planner.cpp
+//
+// Identification: src/optimizer/join_planner.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "optimizer/join_planner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_nested_loop_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return a copy of a column that is computed by an expression */
+Column CopyColumn(const Column &column, const AbstractExpression *expr) {
+  if (column.GetType() == TypeId::VARCHAR) {
+    return Column(column.GetName(), column.GetType(), column.GetLength(), expr);
+  }
+  return Column(column.GetName(), column.GetType(), expr);
+}
+
+}  // namespace
+
+double JoinPlanner::EstimateRows(const AbstractPlanNode *plan) const {
+  switch (plan->GetType()) {
+    case PlanType::SeqScan: {
+      auto scan = static_cast<const SeqScanPlanNode *>(plan);
+      const TableStatistics &stats = catalog_->GetTable(scan->GetTableOid())->stats_;
+      return stats.GetNumRows() * stats.EstimateSelectivity(scan->GetPredicate());
+    }
+    case PlanType::IndexScan: {
+      auto scan = static_cast<const IndexScanPlanNode *>(plan);
+      const TableStatistics &stats = catalog_->GetTable(scan->GetTableOid())->stats_;
+      // The values of the key columns are taken to be independent of each other.
+      double rows = stats.GetNumRows() * stats.EstimateSelectivity(scan->GetPredicate());
+      for (uint32_t key_attr : catalog_->GetIndex(scan->GetIndexOid())->index_->GetKeyAttrs()) {
+        rows /= std::max<size_t>(stats.GetNumDistinct(key_attr), 1);
+      }
+      return rows;
+    }
+    case PlanType::Limit: {
+      auto limit = static_cast<const LimitPlanNode *>(plan);
+      return std::min(static_cast<double>(limit->GetLimit()), EstimateRows(limit->GetChildPlan()));
+    }
+    default: {
+      double rows = 0;
+      for (const AbstractPlanNode *child : plan->GetChildren()) {
+        rows = std::max(rows, EstimateRows(child));
+      }
+      return rows;
+    }
+  }
+}
+
+const AbstractPlanNode *JoinPlanner::PlanJoin(const AbstractPlanNode *outer, uint32_t outer_key_col,
+                                              table_oid_t inner_table_oid, uint32_t inner_key_col,
+                                              const AbstractExpression *inner_predicate,
+                                              const std::vector<JoinOutputColumn> &output_columns) {
+  TableMetadata *inner_info = catalog_->GetTable(inner_table_oid);
+  const TableStatistics &stats = inner_info->stats_;
+  const Schema *outer_schema = outer->OutputSchema();
+  const Schema *inner_schema = &inner_info->schema_;
+  const double outer_rows = EstimateRows(outer);
+  const double table_rows = stats.GetNumRows();
+  const double inner_rows = table_rows * stats.EstimateSelectivity(inner_predicate);
+
+  // A hash join scans the inner table, builds on the smaller side and probes with the other one.
+  const double build_rows = std::min(outer_rows, inner_rows);
+  const double hash_cost = table_rows * SCAN_COST + build_rows * HASH_BUILD_COST +
+                           std::max(outer_rows, inner_rows) * HASH_PROBE_COST;
+
+  // An index nested loop join looks up each outer row, and reads every tuple with its key.
+  IndexInfo *best_index = nullptr;
+  double index_cost = std::numeric_limits<double>::infinity();
+  for (IndexInfo *index_info : catalog_->GetTableIndexes(inner_info->name_)) {
+    if (index_info->index_->GetKeyAttrs() != std::vector<uint32_t>{inner_key_col}) {
+      continue;
+    }
+    const size_t num_distinct = stats.GetNumDistinct(inner_key_col);
+    const double matches = num_distinct == 0 ? 0 : table_rows / num_distinct;
+    index_cost = outer_rows * (INDEX_PROBE_COST + matches * INDEX_FETCH_COST);
+    best_index = index_info;
+  }
+
+  if (best_index != nullptr && index_cost < hash_cost) {
+    std::vector<Column> columns;
+    for (const JoinOutputColumn &output : output_columns) {
+      const bool is_outer = output.side_ == JoinOutputColumn::Side::OUTER;
+      const Schema *schema = is_outer ? outer_schema : inner_schema;
+      columns.push_back(CopyColumn(schema->GetColumn(output.col_idx_),
+                                   MakeColumnValue(is_outer ? 0 : 1, output.col_idx_, schema)));
+    }
+    plans_.push_back(std::make_unique<IndexNestedLoopJoinPlanNode>(
+        MakeSchema(std::move(columns)), outer, inner_predicate, inner_table_oid, best_index->oid_,
+        std::vector<const AbstractExpression *>{MakeColumnValue(0, outer_key_col, outer_schema)}));
+    return plans_.back().get();
+  }
+
+  // The scan of the inner table outputs all of its columns, so that they keep their indexes.
+  std::vector<Column> scan_columns;
+  for (uint32_t col_idx = 0; col_idx < inner_schema->GetColumnCount(); col_idx++) {
+    scan_columns.push_back(CopyColumn(inner_schema->GetColumn(col_idx), MakeColumnValue(0, col_idx, inner_schema)));
+  }
+  plans_.push_back(std::make_unique<SeqScanPlanNode>(MakeSchema(std::move(scan_columns)), inner_predicate,
+                                                     inner_table_oid));
+  const AbstractPlanNode *inner_scan = plans_.back().get();
+
+  const bool build_inner = inner_rows < outer_rows;
+  const uint32_t outer_idx = build_inner ? 1 : 0;
+  const uint32_t inner_idx = 1 - outer_idx;
+  const AbstractExpression *outer_key = MakeColumnValue(outer_idx, outer_key_col, outer_schema);
+  const AbstractExpression *inner_key = MakeColumnValue(inner_idx, inner_key_col, inner_schema);
+  const AbstractExpression *left_key = build_inner ? inner_key : outer_key;
+  const AbstractExpression *right_key = build_inner ? outer_key : inner_key;
+  exprs_.push_back(std::make_unique<ComparisonExpression>(left_key, right_key, ComparisonType::Equal));
+  const AbstractExpression *predicate = exprs_.back().get();
+  std::vector<Column> columns;
+  for (const JoinOutputColumn &output : output_columns) {
+    const bool is_outer = output.side_ == JoinOutputColumn::Side::OUTER;
+    const Schema *schema = is_outer ? outer_schema : inner_schema;
+    columns.push_back(CopyColumn(schema->GetColumn(output.col_idx_),
+                                 MakeColumnValue(is_outer ? outer_idx : inner_idx, output.col_idx_, schema)));
+  }
+  auto join = std::make_unique<HashJoinPlanNode>(
+      MakeSchema(std::move(columns)),
+      std::vector<const AbstractPlanNode *>{build_inner ? inner_scan : outer, build_inner ? outer : inner_scan},
+      predicate, std::vector<const AbstractExpression *>{left_key}, std::vector<const AbstractExpression *>{right_key});
+  join->SetEstimatedBuildRows(static_cast<size_t>(std::llround(build_rows)));
+  plans_.push_back(std::move(join));
+  return plans_.back().get();
+}
+
+const AbstractExpression *JoinPlanner::MakeColumnValue(uint32_t tuple_idx, uint32_t col_idx, const Schema *schema) {
+  exprs_.push_back(std::make_unique<ColumnValueExpression>(tuple_idx, col_idx, schema->GetColumn(col_idx).GetType()));
+  return exprs_.back().get();
+}
+
+const Schema *JoinPlanner::MakeSchema(std::vector<Column> &&columns) {
+  schemas_.push_back(std::make_unique<Schema>(columns));
+  return schemas_.back().get();
+}
+
+}  // namespace bustub
@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// backup_manager.cpp
+//
+// Identification: src/recovery/backup_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/backup_manager.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+/** The bytes of the log that a backup copies at a time. */
+constexpr int BACKUP_LOG_CHUNK_SIZE = 1 << 20;
+
+}  // namespace
+
+bool BackupManager::Backup(DiskManager *target, int64_t bytes_per_second) {
+  bytes_per_second_ = bytes_per_second;
+  start_time_ = std::chrono::steady_clock::now();
+  num_bytes_copied_ = 0;
+  num_pages_copied_ = 0;
+
+  // The log is pinned before the master record is read, so that a checkpoint taken meanwhile cannot truncate the part
+  // of it that the record points at.
+  const int64_t pinned_offset = disk_manager_->PinLog();
+  lsn_t checkpoint_lsn;
+  int64_t redo_offset;
+  int64_t undo_offset;
+  const bool has_checkpoint = disk_manager_->ReadMasterRecord(&checkpoint_lsn, &redo_offset, &undo_offset);
+  log_start_offset_ = pinned_offset;
+  if (has_checkpoint) {
+    log_start_offset_ = std::max(pinned_offset, undo_offset / LOG_SEGMENT_SIZE * LOG_SEGMENT_SIZE);
+  }
+
+  // The pages that the file grows by meanwhile are new since the checkpoint, so redo builds them from the log.
+  std::vector<char> page_data(PAGE_SIZE);
+  const page_id_t num_pages = disk_manager_->GetNumPagesOnDisk();
+  bool ok = true;
+  for (page_id_t page_id = 0; ok && page_id < num_pages; page_id++) {
+    ok = CopyPage(target, page_id, page_data.data());
+  }
+
+  // A page is written only once the log holds its changes, so the log that is on disk now holds those of every page
+  // that was copied.
+  log_end_offset_ = disk_manager_->GetLogSize();
+  ok = ok && CopyLog(target, log_start_offset_, log_end_offset_);
+  if (ok) {
+    // The map is copied last: a page that was allocated after the end of the log is left over in the copy, which is
+    // better than a page that was allocated before it being handed out again.
+    disk_manager_->CopyFreeSpaceMapTo(target);
+    if (has_checkpoint) {
+      target->WriteMasterRecord(checkpoint_lsn, redo_offset, undo_offset);
+    }
+    target->SyncPages();
+  }
+  disk_manager_->UnpinLog(pinned_offset);
+  return ok;
+}
+
+void BackupManager::Throttle(int64_t bytes) {
+  num_bytes_copied_ += bytes;
+  if (bytes_per_second_ <= 0) {
+    return;
+  }
+  const std::chrono::duration<double> due(static_cast<double>(num_bytes_copied_) / bytes_per_second_);
+  std::this_thread::sleep_until(start_time_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(due));
+}
+
+bool BackupManager::CopyPage(DiskManager *target, page_id_t page_id, char *page_data) {
+  for (int attempt = 0; attempt < BACKUP_PAGE_RETRIES; attempt++) {
+    if (disk_manager_->TryReadPage(page_id, page_data)) {
+      target->WritePage(page_id, page_data);
+      num_pages_copied_++;
+      Throttle(PAGE_SIZE);
+      return true;
+    }
+    std::this_thread::yield();
+  }
+  LOG_DEBUG("Page %d kept being written while it was backed up", page_id);
+  return false;
+}
+
+bool BackupManager::CopyLog(DiskManager *target, int64_t begin, int64_t end) {
+  // The copy keeps the offsets of the log, which the master record and the LSN mapping of recovery refer to.
+  target->RestartLog(begin);
+  std::vector<char> data(BACKUP_LOG_CHUNK_SIZE);
+  for (int64_t offset = begin; offset < end;) {
+    const auto size = static_cast<int>(std::min<int64_t>(data.size(), end - offset));
+    const int read_size = disk_manager_->ReadRawLog(data.data(), size, offset);
+    if (read_size <= 0 || !target->AppendRawLog(data.data(), read_size)) {
+      LOG_DEBUG("Could not copy the log at offset %" PRId64, offset);
+      return false;
+    }
+    offset += read_size;
+    Throttle(read_size);
+  }
+  return true;
+}
+
+}  // namespace bustub
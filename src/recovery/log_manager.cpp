@@ -12,6 +12,15 @@
 
 #include "recovery/log_manager.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include "common/macros.h"
+#include "recovery/log_recovery.h"
+
 namespace bustub {
 /*
  * set enable_logging = true
@@ -22,33 +31,295 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::scoped_lock lock(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  enable_logging = true;
+  stop_flush_thread_ = false;
+  flush_thread_ = new std::thread(&LogManager::RunFlusher, this);
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *flush_thread;
+  {
+    std::scoped_lock lock(latch_);
+    if (flush_thread_ == nullptr) {
+      return;
+    }
+    enable_logging = false;
+    stop_flush_thread_ = true;
+    flush_thread = flush_thread_;
+  }
+  cv_.notify_one();
+  // The flush thread writes the records that are left before it exits.
+  flush_thread->join();
+  delete flush_thread;
+  std::scoped_lock lock(latch_);
+  flush_thread_ = nullptr;
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
  */
-lsn_t LogManager::AppendLogRecord(LogRecord *log_record) { return INVALID_LSN; }
+lsn_t LogManager::AppendLogRecord(LogRecord *log_record) {
+  const auto size = static_cast<size_t>(log_record->size_);
+  BUSTUB_ASSERT(size <= log_buffer_size_, "A log record must fit into the log buffer.");
+  uint64_t state = reserve_state_.load(std::memory_order_acquire);
+  while (true) {
+    if (IsClosed(state) || GetOffset(state) + size > log_buffer_size_) {
+      WaitForSpace(state);
+      state = reserve_state_.load(std::memory_order_acquire);
+      continue;
+    }
+    const uint64_t reserved =
+        MakeState(GetLSN(state) + 1, false, GetBufferIndex(state), GetOffset(state) + size);
+    if (reserve_state_.compare_exchange_weak(state, reserved, std::memory_order_acq_rel)) {
+      break;
+    }
+  }
+  const size_t buffer_index = GetBufferIndex(state);
+  log_record->lsn_ = GetLSN(state);
+  SerializeLogRecord(log_record, log_buffers_[buffer_index] + GetOffset(state));
+  // The flush that closes the buffer waits until it has seen all reserved bytes written.
+  written_bytes_[buffer_index].fetch_add(size, std::memory_order_release);
+  return log_record->lsn_;
+}
+
+void LogManager::SerializeLogRecord(LogRecord *log_record, char *data) {
+  // The header is the first HEADER_SIZE bytes of the record: size, lsn, txn id, prev lsn and type.
+  memcpy(data, log_record, LogRecord::HEADER_SIZE);
+  size_t pos = LogRecord::HEADER_SIZE;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      memcpy(data + pos, &log_record->insert_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->insert_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(data + pos, &log_record->delete_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->delete_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(data + pos, &log_record->update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      memcpy(data + pos, log_record->update_delta_.data(), log_record->update_delta_.size());
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(data + pos, &log_record->prev_page_id_, sizeof(page_id_t));
+      pos += sizeof(page_id_t);
+      memcpy(data + pos, &log_record->page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::PAGEIMAGE:
+    case LogRecordType::TRUNCATE:
+      memcpy(data + pos, &log_record->page_id_, sizeof(page_id_t));
+      pos += sizeof(page_id_t);
+      memcpy(data + pos, &log_record->next_page_id_, sizeof(page_id_t));
+      pos += sizeof(page_id_t);
+      memcpy(data + pos, log_record->page_image_, PAGE_SIZE);
+      break;
+    case LogRecordType::CLR:
+      memcpy(data + pos, &log_record->undo_next_lsn_, sizeof(lsn_t));
+      break;
+    case LogRecordType::BEGIN_CHECKPOINT: {
+      const auto num_txns = static_cast<int32_t>(log_record->active_txns_.size());
+      memcpy(data + pos, &num_txns, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      for (const auto &[txn_id, lsn] : log_record->active_txns_) {
+        memcpy(data + pos, &txn_id, sizeof(txn_id_t));
+        memcpy(data + pos + sizeof(txn_id_t), &lsn, sizeof(lsn_t));
+        pos += sizeof(txn_id_t) + sizeof(lsn_t);
+      }
+      const auto num_pages = static_cast<int32_t>(log_record->dirty_pages_.size());
+      memcpy(data + pos, &num_pages, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      for (const auto &[page_id, rec_lsn] : log_record->dirty_pages_) {
+        memcpy(data + pos, &page_id, sizeof(page_id_t));
+        memcpy(data + pos + sizeof(page_id_t), &rec_lsn, sizeof(lsn_t));
+        pos += sizeof(page_id_t) + sizeof(lsn_t);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void LogManager::WaitForSpace(uint64_t state) {
+  std::unique_lock<std::mutex> lock(latch_);
+  if (reserve_state_.load() != state) {
+    return;
+  }
+  if (flush_thread_ == nullptr || stop_flush_thread_) {
+    FlushLogBuffer(&lock);
+    return;
+  }
+  flush_requested_ = true;
+  cv_.notify_one();
+  flushed_cv_.wait(lock, [&] { return reserve_state_.load() != state; });
+}
+
+int64_t LogManager::GetLogOffset(lsn_t lsn) {
+  std::scoped_lock lock(latch_);
+  auto it = buffer_offsets_.upper_bound(lsn);
+  if (it == buffer_offsets_.begin()) {
+    return it->second;
+  }
+  return std::prev(it)->second;
+}
+
+bool LogManager::ReadLogRecord(lsn_t lsn, LogRecord *log_record, LogReadBuffer *buffer) {
+  WaitUntilPersistent(lsn);
+  const int64_t offset = GetLogOffset(lsn);
+  if (buffer->offset_ != offset) {
+    buffer->offset_ = -1;
+    buffer->records_.clear();
+    buffer->data_.resize(log_buffer_size_);
+    if (!disk_manager_->ReadLog(buffer->data_.data(), static_cast<int>(log_buffer_size_), offset)) {
+      return false;
+    }
+    buffer->offset_ = offset;
+    // The records of a buffer are in the order of their LSNs, which the appends reserved together with their space.
+    LogRecordView view;
+    for (size_t pos = 0; view.Parse(buffer->data_.data() + pos, log_buffer_size_ - pos); pos += view.GetSize()) {
+      buffer->records_.emplace_back(view.GetLSN(), pos);
+    }
+  }
+  auto it = std::lower_bound(buffer->records_.begin(), buffer->records_.end(), std::make_pair(lsn, size_t{0}));
+  if (it == buffer->records_.end() || it->first != lsn) {
+    return false;
+  }
+  return LogRecovery::DeserializeLogRecord(buffer->data_.data() + it->second, log_buffer_size_ - it->second,
+                                           log_record);
+}
+
+void LogManager::SetCheckpoint(lsn_t checkpoint_lsn, lsn_t redo_lsn, lsn_t undo_lsn) {
+  const int64_t redo_offset = GetLogOffset(redo_lsn);
+  const int64_t undo_offset = GetLogOffset(undo_lsn);
+  disk_manager_->WriteMasterRecord(checkpoint_lsn, redo_offset, undo_offset);
+  // Recovery never reads before the checkpoint again, neither the segments nor the offsets of older buffers are needed.
+  disk_manager_->TruncateLog(undo_offset);
+  std::scoped_lock lock(latch_);
+  auto it = buffer_offsets_.upper_bound(undo_lsn);
+  if (it != buffer_offsets_.begin()) {
+    buffer_offsets_.erase(buffer_offsets_.begin(), std::prev(it));
+  }
+}
+
+void LogManager::WaitUntilPersistent(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  lsn = std::min(lsn, GetNextLSN() - 1);
+  while (persistent_lsn_ < lsn) {
+    if (flush_thread_ == nullptr || stop_flush_thread_) {
+      FlushLogBuffer(&lock);
+      continue;
+    }
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_cv_.wait(lock);
+  }
+}
+
+void LogManager::PersistAsync(lsn_t lsn) {
+  const lsn_t max_lag = async_commit_max_lag;
+  if (persistent_lsn_ < lsn - max_lag) {
+    WaitUntilPersistent(lsn - max_lag);
+  }
+  // Only the first asynchronous commit of a buffer takes the latch, to set the deadline for them all.
+  if (!async_flush_pending_.load(std::memory_order_acquire)) {
+    std::scoped_lock lock(latch_);
+    if (!async_flush_pending_ && persistent_lsn_ < lsn) {
+      async_flush_deadline_ = std::chrono::steady_clock::now() + async_commit_delay;
+      async_flush_pending_ = true;
+      cv_.notify_one();
+    }
+  }
+}
+
+void LogManager::RunFlusher() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    auto deadline = std::chrono::steady_clock::now() + log_timeout;
+    while (!flush_requested_ && !stop_flush_thread_) {
+      if (async_flush_pending_) {
+        deadline = std::min(deadline, async_flush_deadline_);
+      }
+      if (cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+        break;
+      }
+    }
+    FlushLogBuffer(&lock);
+    if (stop_flush_thread_ && GetOffset(reserve_state_.load()) == 0) {
+      return;
+    }
+  }
+}
+
+void LogManager::FlushLogBuffer(std::unique_lock<std::mutex> *lock) {
+  // The other buffer must be written before it can take appends again; the records appended meanwhile go with the
+  // next write.
+  flushed_cv_.wait(*lock, [&] { return !flush_in_progress_; });
+  flush_requested_ = false;
+  // The commit records of the asynchronous commits so far are in the buffer that is written now.
+  async_flush_pending_ = false;
+  uint64_t state = reserve_state_.load(std::memory_order_acquire);
+  do {
+    if (GetOffset(state) == 0) {
+      return;
+    }
+  } while (!reserve_state_.compare_exchange_weak(state, state | CLOSED_FLAG, std::memory_order_acq_rel));
+
+  // Appends that reserved space before the buffer was closed may still be serializing their records.
+  const size_t buffer_index = GetBufferIndex(state);
+  const size_t size = GetOffset(state);
+  while (written_bytes_[buffer_index].load(std::memory_order_acquire) != size) {
+    std::this_thread::yield();
+  }
+  written_bytes_[buffer_index] = 0;
+  const lsn_t lsn = GetLSN(state) - 1;
+  reserve_state_.store(MakeState(GetLSN(state), false, buffer_index ^ 1, 0), std::memory_order_release);
+  flush_in_progress_ = true;
+  // Appenders that waited for space can go on while the records are written.
+  flushed_cv_.notify_all();
+  lock->unlock();
+  const auto start = std::chrono::steady_clock::now();
+  disk_manager_->WriteLog(log_buffers_[buffer_index], static_cast<int>(size));
+  flush_latency_us_.Record(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+  flush_bytes_.Record(size);
+  lock->lock();
+  // The records of the next buffer follow the ones of this buffer in the log file, which may have been compressed.
+  open_buffer_offset_ = disk_manager_->GetLogSize();
+  buffer_offsets_.emplace(lsn + 1, open_buffer_offset_);
+  // The buffer is not appended to until the write is over, and the next write waits for the latch.
+  if (log_listener_) {
+    log_listener_(log_buffers_[buffer_index], size, open_buffer_offset_);
+  }
+  persistent_lsn_ = lsn;
+  flush_in_progress_ = false;
+  num_log_flushes_++;
+  flushed_cv_.notify_all();
+}
+
+void LogManager::CollectMetrics(MetricsSnapshot *snapshot) {
+  snapshot->AddCounter("bustub_log_flushes_total", "Writes of the log buffers.",
+                       static_cast<double>(GetNumLogFlushes()));
+  snapshot->AddHistogram("bustub_log_flush_latency_us", "Latency of the writes of the log buffers, in microseconds.",
+                         flush_latency_us_.Snapshot());
+  snapshot->AddHistogram("bustub_log_flush_bytes", "Bytes written by the writes of the log buffers.",
+                         flush_bytes_.Snapshot());
+  snapshot->AddGauge("bustub_log_next_lsn", "LSN of the next log record.", static_cast<double>(GetNextLSN()));
+  snapshot->AddGauge("bustub_log_persistent_lsn", "LSN of the last log record on disk.",
+                     static_cast<double>(GetPersistentLSN()));
+}
 
 }  // namespace bustub
@@ -0,0 +1,199 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_record.cpp
+//
+// Identification: src/recovery/log_record.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_record.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+namespace {
+
+void AppendUint16(std::vector<char> *delta, uint32_t value) {
+  const auto value16 = static_cast<uint16_t>(value);
+  const auto *bytes = reinterpret_cast<const char *>(&value16);
+  delta->insert(delta->end(), bytes, bytes + sizeof(uint16_t));
+}
+
+uint32_t ReadUint16(const char *data) {
+  uint16_t value;
+  memcpy(&value, data, sizeof(uint16_t));
+  return value;
+}
+
+/** @return true if the update delta, i.e. its ranges and its tail, fits into size bytes */
+bool IsUpdateDeltaComplete(const char *delta, size_t size) {
+  if (size < 3 * sizeof(uint16_t)) {
+    return false;
+  }
+  const uint32_t old_size = ReadUint16(delta);
+  const uint32_t new_size = ReadUint16(delta + sizeof(uint16_t));
+  const uint32_t num_ranges = ReadUint16(delta + 2 * sizeof(uint16_t));
+  size_t pos = 3 * sizeof(uint16_t);
+  for (uint32_t range = 0; range < num_ranges; range++) {
+    if (pos + 2 * sizeof(uint16_t) > size) {
+      return false;
+    }
+    const uint32_t offset = ReadUint16(delta + pos);
+    const uint32_t length = ReadUint16(delta + pos + sizeof(uint16_t));
+    if (offset + length > std::min(old_size, new_size)) {
+      return false;
+    }
+    pos += 2 * sizeof(uint16_t) + length;
+  }
+  return pos + std::max(old_size, new_size) - std::min(old_size, new_size) <= size;
+}
+
+}  // namespace
+
+LogRecord::LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &update_rid,
+                     const Tuple &old_tuple, const Tuple &new_tuple)
+    : txn_id_(txn_id), prev_lsn_(prev_lsn), log_record_type_(log_record_type), update_rid_(update_rid) {
+  const uint32_t old_size = old_tuple.GetLength();
+  const uint32_t new_size = new_tuple.GetLength();
+  BUSTUB_ASSERT(old_size <= UINT16_MAX && new_size <= UINT16_MAX, "A tuple must fit into a page.");
+  const char *old_data = old_tuple.GetData();
+  const char *new_data = new_tuple.GetData();
+  const uint32_t common_size = std::min(old_size, new_size);
+
+  AppendUint16(&update_delta_, old_size);
+  AppendUint16(&update_delta_, new_size);
+  const size_t num_ranges_pos = update_delta_.size();
+  AppendUint16(&update_delta_, 0);
+  uint32_t num_ranges = 0;
+  for (uint32_t i = 0; i < common_size; i++) {
+    if (old_data[i] == new_data[i]) {
+      continue;
+    }
+    // Extend the range over the changed bytes that follow within the gap.
+    uint32_t end = i + 1;
+    for (uint32_t j = end; j < common_size && j < end + UPDATE_RANGE_GAP; j++) {
+      if (old_data[j] != new_data[j]) {
+        end = j + 1;
+      }
+    }
+    AppendUint16(&update_delta_, i);
+    AppendUint16(&update_delta_, end - i);
+    for (; i < end; i++) {
+      update_delta_.push_back(static_cast<char>(old_data[i] ^ new_data[i]));
+    }
+    num_ranges++;
+    i = end - 1;
+  }
+  const auto num_ranges16 = static_cast<uint16_t>(num_ranges);
+  memcpy(update_delta_.data() + num_ranges_pos, &num_ranges16, sizeof(uint16_t));
+  if (old_size > common_size) {
+    update_delta_.insert(update_delta_.end(), old_data + common_size, old_data + old_size);
+  } else {
+    update_delta_.insert(update_delta_.end(), new_data + common_size, new_data + new_size);
+  }
+  // calculate log record size
+  size_ = static_cast<int32_t>(HEADER_SIZE + sizeof(RID) + update_delta_.size());
+}
+
+Tuple LogRecord::ApplyUpdateDelta(const Tuple &tuple, bool undo) const {
+  std::vector<char> buffer;
+  ApplyUpdateDelta(update_delta_.data(), tuple, undo, &buffer);
+  Tuple target;
+  target.DeserializeFrom(buffer.data());
+  return target;
+}
+
+Tuple LogRecord::ApplyUpdateDelta(const char *delta, const Tuple &tuple, bool undo, std::vector<char> *buffer) {
+  const uint32_t old_size = ReadUint16(delta);
+  const uint32_t new_size = ReadUint16(delta + sizeof(uint16_t));
+  const uint32_t num_ranges = ReadUint16(delta + 2 * sizeof(uint16_t));
+  const uint32_t target_size = undo ? old_size : new_size;
+  BUSTUB_ASSERT(tuple.GetLength() == (undo ? new_size : old_size), "The update was logged for another tuple.");
+  const uint32_t common_size = std::min(old_size, new_size);
+
+  // The result is built in the serialized form of a tuple, a size followed by the data.
+  buffer->resize(sizeof(int32_t) + target_size);
+  memcpy(buffer->data(), &target_size, sizeof(int32_t));
+  char *data = buffer->data() + sizeof(int32_t);
+  memcpy(data, tuple.GetData(), common_size);
+  size_t pos = 3 * sizeof(uint16_t);
+  for (uint32_t range = 0; range < num_ranges; range++) {
+    const uint32_t offset = ReadUint16(delta + pos);
+    const uint32_t length = ReadUint16(delta + pos + sizeof(uint16_t));
+    pos += 2 * sizeof(uint16_t);
+    for (uint32_t i = 0; i < length; i++) {
+      data[offset + i] ^= delta[pos + i];
+    }
+    pos += length;
+  }
+  // The tail belongs to the longer tuple, the shorter one simply ends before it.
+  if (target_size > common_size) {
+    memcpy(data + common_size, delta + pos, target_size - common_size);
+  }
+  return Tuple(data, target_size);
+}
+
+bool LogRecordView::Parse(const char *data, size_t size) {
+  if (size < static_cast<size_t>(LogRecord::HEADER_SIZE)) {
+    return false;
+  }
+  // The header is size, lsn, txn id, prev lsn and type, see LogManager::SerializeLogRecord.
+  memcpy(&size_, data, sizeof(int32_t));
+  if (size_ < LogRecord::HEADER_SIZE || static_cast<size_t>(size_) > size) {
+    return false;
+  }
+  memcpy(&log_record_type_, data + 4 * sizeof(int32_t), sizeof(LogRecordType));
+  if (log_record_type_ <= LogRecordType::INVALID || log_record_type_ > LogRecordType::CLR) {
+    return false;
+  }
+  memcpy(&lsn_, data + sizeof(int32_t), sizeof(lsn_t));
+  memcpy(&txn_id_, data + 2 * sizeof(int32_t), sizeof(txn_id_t));
+  memcpy(&prev_lsn_, data + 3 * sizeof(int32_t), sizeof(lsn_t));
+  data_ = data;
+
+  // The payload must lie within the record, a torn record at the end of the log may have any size in it.
+  const auto payload_size = static_cast<size_t>(size_ - LogRecord::HEADER_SIZE);
+  switch (log_record_type_) {
+    case LogRecordType::INSERT:
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      return payload_size >= sizeof(RID) + sizeof(uint32_t) &&
+             GetTuple().GetLength() <= payload_size - sizeof(RID) - sizeof(uint32_t);
+    case LogRecordType::UPDATE:
+      return payload_size >= sizeof(RID) && IsUpdateDeltaComplete(GetUpdateDelta(), payload_size - sizeof(RID));
+    case LogRecordType::NEWPAGE:
+      return payload_size >= 2 * sizeof(page_id_t);
+    case LogRecordType::PAGEIMAGE:
+    case LogRecordType::TRUNCATE:
+      return payload_size >= 2 * sizeof(page_id_t) + PAGE_SIZE;
+    case LogRecordType::CLR:
+      return payload_size >= sizeof(lsn_t);
+    case LogRecordType::BEGIN_CHECKPOINT: {
+      if (payload_size < sizeof(int32_t)) {
+        return false;
+      }
+      int32_t num_txns;
+      memcpy(&num_txns, data + LogRecord::HEADER_SIZE, sizeof(int32_t));
+      const size_t pages_pos = sizeof(int32_t) * (1 + 2 * static_cast<size_t>(num_txns));
+      if (num_txns < 0 || payload_size < pages_pos + sizeof(int32_t)) {
+        return false;
+      }
+      int32_t num_pages;
+      memcpy(&num_pages, data + LogRecord::HEADER_SIZE + pages_pos, sizeof(int32_t));
+      return num_pages >= 0 && size_ == LogRecord::GetCheckpointSize(num_txns, num_pages);
+    }
+    default:
+      return true;
+  }
+}
+
+}  // namespace bustub
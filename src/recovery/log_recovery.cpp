@@ -12,6 +12,13 @@
 
 #include "recovery/log_recovery.h"
 
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+
+#include "common/exception.h"
 #include "storage/page/table_page.h"
 
 namespace bustub {
@@ -20,7 +27,80 @@ namespace bustub {
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
  */
-bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) { return false; }
+bool LogRecovery::DeserializeLogRecord(const char *data, size_t size, LogRecord *log_record) {
+  LogRecordView view;
+  if (!view.Parse(data, size)) {
+    return false;
+  }
+  const int32_t record_size = view.GetSize();
+  const LogRecordType type = view.GetLogRecordType();
+  log_record->size_ = record_size;
+  log_record->lsn_ = view.GetLSN();
+  log_record->txn_id_ = view.GetTxnId();
+  log_record->prev_lsn_ = view.GetPrevLSN();
+  log_record->log_record_type_ = type;
+
+  size_t pos = LogRecord::HEADER_SIZE;
+  switch (type) {
+    case LogRecordType::INSERT:
+      memcpy(&log_record->insert_rid_, data + pos, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->insert_tuple_.DeserializeFrom(data + pos);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(&log_record->delete_rid_, data + pos, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->delete_tuple_.DeserializeFrom(data + pos);
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(&log_record->update_rid_, data + pos, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->update_delta_.assign(data + pos, data + log_record->size_);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(&log_record->prev_page_id_, data + pos, sizeof(page_id_t));
+      pos += sizeof(page_id_t);
+      memcpy(&log_record->page_id_, data + pos, sizeof(page_id_t));
+      break;
+    case LogRecordType::PAGEIMAGE:
+    case LogRecordType::TRUNCATE:
+      memcpy(&log_record->page_id_, data + pos, sizeof(page_id_t));
+      pos += sizeof(page_id_t);
+      memcpy(&log_record->next_page_id_, data + pos, sizeof(page_id_t));
+      pos += sizeof(page_id_t);
+      log_record->page_image_ = data + pos;
+      break;
+    case LogRecordType::CLR:
+      memcpy(&log_record->undo_next_lsn_, data + pos, sizeof(lsn_t));
+      break;
+    case LogRecordType::BEGIN_CHECKPOINT: {
+      int32_t num_txns;
+      memcpy(&num_txns, data + pos, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      log_record->active_txns_.resize(num_txns);
+      for (auto &[txn_id, lsn] : log_record->active_txns_) {
+        memcpy(&txn_id, data + pos, sizeof(txn_id_t));
+        memcpy(&lsn, data + pos + sizeof(txn_id_t), sizeof(lsn_t));
+        pos += sizeof(txn_id_t) + sizeof(lsn_t);
+      }
+      int32_t num_pages;
+      memcpy(&num_pages, data + pos, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      log_record->dirty_pages_.resize(num_pages);
+      for (auto &[page_id, rec_lsn] : log_record->dirty_pages_) {
+        memcpy(&page_id, data + pos, sizeof(page_id_t));
+        memcpy(&rec_lsn, data + pos + sizeof(page_id_t), sizeof(lsn_t));
+        pos += sizeof(page_id_t) + sizeof(lsn_t);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return true;
+}
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
@@ -29,12 +109,387 @@ bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record)
  *LSN with log_record's sequence number, and also build active_txn_ table &
  *lsn_mapping_ table
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  // The last checkpoint tells where the oldest change that may be missing from the database file was logged.
+  lsn_t checkpoint_lsn;
+  if (!disk_manager_->ReadMasterRecord(&checkpoint_lsn, &redo_start_offset_, &undo_start_offset_)) {
+    redo_start_offset_ = disk_manager_->GetLogStartOffset();
+    undo_start_offset_ = redo_start_offset_;
+  }
+  offset_ = ReplayLog(redo_start_offset_, INT64_MAX, true);
+}
+
+int64_t LogRecovery::RedoRange(int64_t begin, int64_t end) { return ReplayLog(begin, end, false); }
+
+int64_t LogRecovery::ReplayLog(int64_t begin, int64_t end, bool prepare_undo) {
+  std::vector<std::unique_ptr<RedoQueue>> queues;
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < num_redo_workers_; i++) {
+    queues.emplace_back(new RedoQueue());
+    workers.emplace_back(&LogRecovery::RunRedoWorker, this, queues.back().get());
+  }
+
+  // The records of a page always go to the same worker, which replays its queue in order.
+  std::vector<RedoBatch> batches(num_redo_workers_);
+  auto dispatch = [&](page_id_t page_id, const LogRecordView &log_record) {
+    if (page_id != INVALID_PAGE_ID) {
+      // The page may have been allocated after the free space map was last saved, and never been written since.
+      disk_manager_->MarkPageAllocated(page_id);
+      batches[page_id % num_redo_workers_].items.push_back(RedoItem{page_id, log_record});
+    }
+  };
+
+  int64_t offset = begin;
+  // Transactions that ended since the last checkpoint record. A checkpoint takes its active transactions before it
+  // appends its record, so the record may list transactions whose COMMIT or ABORT precedes it.
+  std::unordered_set<txn_id_t> ended_txns;
+  int read_size;
+  int64_t next_offset;
+  while (offset < end) {
+    // The workers replay the records in place, so every read gets a buffer of its own that lives as long as they do.
+    // A read that is cut off at the end leaves out the record that crosses it.
+    const auto size = static_cast<size_t>(std::min<int64_t>(log_buffer_size_, end - offset));
+    auto log_data = std::make_shared<std::vector<char>>(size);
+    if (!disk_manager_->ReadLog(log_data->data(), static_cast<int>(size), offset, &read_size, &next_offset)) {
+      break;
+    }
+    const char *data = log_data->data();
+    size_t pos = 0;
+    LogRecordView log_record;
+    while (log_record.Parse(data + pos, size - pos)) {
+      if (prepare_undo) {
+        lsn_mapping_[log_record.GetLSN()] = {offset, pos};
+        switch (log_record.GetLogRecordType()) {
+          case LogRecordType::COMMIT:
+          case LogRecordType::ABORT:
+            active_txn_.erase(log_record.GetTxnId());
+            ended_txns.insert(log_record.GetTxnId());
+            break;
+          case LogRecordType::BEGIN_CHECKPOINT: {
+            // Transactions that were running at the checkpoint may have logged nothing since the redo start.
+            LogRecord checkpoint;
+            DeserializeLogRecord(data + pos, size - pos, &checkpoint);
+            for (const auto &[txn_id, lsn] : checkpoint.active_txns_) {
+              if (ended_txns.count(txn_id) == 0) {
+                active_txn_.emplace(txn_id, lsn);
+              }
+            }
+            // The next checkpoint takes its transactions after this record, when these have ended for good.
+            ended_txns.clear();
+            break;
+          }
+          case LogRecordType::END_CHECKPOINT:
+            break;
+          default:
+            active_txn_[log_record.GetTxnId()] = log_record.GetLSN();
+            break;
+        }
+      }
+
+      switch (log_record.GetLogRecordType()) {
+        case LogRecordType::INSERT:
+        case LogRecordType::MARKDELETE:
+        case LogRecordType::APPLYDELETE:
+        case LogRecordType::ROLLBACKDELETE:
+        case LogRecordType::UPDATE:
+          dispatch(log_record.GetRID().GetPageId(), log_record);
+          break;
+        case LogRecordType::NEWPAGE:
+          // The new page is initialized, and the previous page is linked to it.
+          dispatch(log_record.GetNewPageId(), log_record);
+          dispatch(log_record.GetPrevPageId(), log_record);
+          break;
+        case LogRecordType::PAGEIMAGE:
+          // The image is copied onto its page, and the page that the bulk load continues on is initialized.
+          dispatch(log_record.GetImagePageId(), log_record);
+          dispatch(log_record.GetImageNextPageId(), log_record);
+          break;
+        case LogRecordType::TRUNCATE:
+          // The pages that followed the first page are left as they are, they are not part of the table anymore.
+          dispatch(log_record.GetImagePageId(), log_record);
+          break;
+        default:
+          break;
+      }
+      pos += log_record.GetSize();
+    }
+
+    // Hand the records of this part of the log to the workers while the next part is read.
+    for (size_t i = 0; i < num_redo_workers_; i++) {
+      if (batches[i].items.empty()) {
+        continue;
+      }
+      batches[i].log_data = log_data;
+      {
+        std::lock_guard<std::mutex> guard(queues[i]->latch);
+        queues[i]->batches.emplace_back(std::move(batches[i]));
+      }
+      queues[i]->cv.notify_one();
+      batches[i] = RedoBatch();
+    }
+    // Nothing but the zeroes past the end of the log, or a torn record at its end.
+    if (pos == 0) {
+      break;
+    }
+    offset = GetNextReadOffset(offset, pos, read_size, next_offset);
+  }
+
+  for (auto &queue : queues) {
+    {
+      std::lock_guard<std::mutex> guard(queue->latch);
+      queue->done = true;
+    }
+    queue->cv.notify_one();
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  const page_id_t unreadable_page_id = unreadable_page_id_.exchange(INVALID_PAGE_ID);
+  if (unreadable_page_id != INVALID_PAGE_ID) {
+    throw Exception("Redo cannot read page " + std::to_string(unreadable_page_id) +
+                    ": it fails its checksum and the log does not rebuild it, or no frame is free.");
+  }
+  return offset;
+}
+
+void LogRecovery::RunRedoWorker(RedoQueue *queue) {
+  std::vector<char> tuple_buffer;
+  while (true) {
+    RedoBatch batch;
+    {
+      std::unique_lock<std::mutex> lock(queue->latch);
+      queue->cv.wait(lock, [&] { return !queue->batches.empty() || queue->done; });
+      if (queue->batches.empty()) {
+        return;
+      }
+      batch = std::move(queue->batches.front());
+      queue->batches.pop_front();
+    }
+    for (const auto &item : batch.items) {
+      if (RedoOnPage(item.page_id, item.log_record, &tuple_buffer)) {
+        num_redone_records_++;
+      }
+    }
+  }
+}
+
+Page *LogRecovery::FetchPageForRedo(page_id_t page_id, const LogRecordView &log_record) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page != nullptr) {
+    return page;
+  }
+  bool rewrites_page;
+  switch (log_record.GetLogRecordType()) {
+    case LogRecordType::NEWPAGE:
+      rewrites_page = page_id == log_record.GetNewPageId();
+      break;
+    case LogRecordType::PAGEIMAGE:
+    case LogRecordType::TRUNCATE:
+      rewrites_page = true;
+      break;
+    default:
+      rewrites_page = false;
+      break;
+  }
+  if (!rewrites_page) {
+    return nullptr;
+  }
+  const std::vector<char> zeros(PAGE_SIZE, 0);
+  disk_manager_->WritePage(page_id, zeros.data());
+  return buffer_pool_manager_->FetchPage(page_id);
+}
+
+bool LogRecovery::RedoOnPage(page_id_t page_id, const LogRecordView &log_record, std::vector<char> *tuple_buffer) {
+  Page *page = FetchPageForRedo(page_id, log_record);
+  if (page == nullptr) {
+    page_id_t none = INVALID_PAGE_ID;
+    unreadable_page_id_.compare_exchange_strong(none, page_id);
+    return false;
+  }
+  auto *table_page = reinterpret_cast<TablePage *>(page);
+  page->WLatch();
+  // The page was written back after the record, so it holds the change already.
+  const bool redo = page->GetLSN() < log_record.GetLSN();
+  if (redo) {
+    switch (log_record.GetLogRecordType()) {
+      case LogRecordType::INSERT: {
+        // The records of the page are replayed in order, so the insert picks the slot that it did before.
+        RID rid;
+        table_page->InsertTuple(log_record.GetTuple(), &rid, nullptr, nullptr, nullptr);
+        BUSTUB_ASSERT(rid == log_record.GetRID(), "Redo must insert the tuple into its logged slot.");
+        break;
+      }
+      case LogRecordType::MARKDELETE:
+        table_page->MarkDelete(log_record.GetRID(), nullptr, nullptr, nullptr);
+        break;
+      case LogRecordType::APPLYDELETE:
+        table_page->ApplyDelete(log_record.GetRID(), nullptr, nullptr);
+        break;
+      case LogRecordType::ROLLBACKDELETE:
+        table_page->RollbackDelete(log_record.GetRID(), nullptr, nullptr);
+        break;
+      case LogRecordType::UPDATE: {
+        // The page holds the tuple as it was before the update, the record only has the bytes that changed.
+        Tuple old_tuple;
+        const bool found = table_page->GetTuple(log_record.GetRID(), &old_tuple, nullptr, nullptr);
+        BUSTUB_ASSERT(found, "Redo must find the tuple that was updated.");
+        const Tuple new_tuple =
+            LogRecord::ApplyUpdateDelta(log_record.GetUpdateDelta(), old_tuple, false, tuple_buffer);
+        table_page->UpdateTuple(new_tuple, &old_tuple, log_record.GetRID(), nullptr, nullptr, nullptr);
+        break;
+      }
+      case LogRecordType::NEWPAGE:
+        if (page_id == log_record.GetNewPageId()) {
+          table_page->Init(page_id, PAGE_SIZE, log_record.GetPrevPageId(), nullptr, nullptr);
+        } else {
+          table_page->SetNextPageId(log_record.GetNewPageId());
+        }
+        break;
+      case LogRecordType::PAGEIMAGE:
+        if (page_id == log_record.GetImagePageId()) {
+          memcpy(page->GetData(), log_record.GetPageImage(), PAGE_SIZE);
+        } else {
+          table_page->Init(page_id, PAGE_SIZE, log_record.GetImagePageId(), nullptr, nullptr);
+        }
+        break;
+      case LogRecordType::TRUNCATE:
+        table_page->Init(page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, nullptr);
+        break;
+      default:
+        break;
+    }
+    page->SetLSN(log_record.GetLSN());
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, redo);
+  return redo;
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
  *iterate through active txn map and undo each operation
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  bool log_prefix_mapped = undo_start_offset_ == redo_start_offset_;
+  for (const auto &active_txn : active_txn_) {
+    lsn_t lsn = active_txn.second;
+    while (lsn != INVALID_LSN) {
+      auto it = lsn_mapping_.find(lsn);
+      if (it == lsn_mapping_.end() && !log_prefix_mapped) {
+        // A transaction that started before the redo start needs the records that redo skipped.
+        MapLogRecords(undo_start_offset_, redo_start_offset_);
+        log_prefix_mapped = true;
+        it = lsn_mapping_.find(lsn);
+      }
+      if (it == lsn_mapping_.end()) {
+        break;
+      }
+      LogRecord log_record;
+      const size_t pos = it->second.second;
+      if (!disk_manager_->ReadLog(log_buffer_, static_cast<int>(log_buffer_size_), it->second.first) ||
+          !DeserializeLogRecord(log_buffer_ + pos, log_buffer_size_ - pos, &log_record)) {
+        break;
+      }
+      UndoOnPage(&log_record);
+      // The writes between a compensation and the write before the one it compensates are rolled back already.
+      lsn = log_record.log_record_type_ == LogRecordType::CLR ? log_record.undo_next_lsn_ : log_record.prev_lsn_;
+    }
+  }
+  active_txn_.clear();
+  lsn_mapping_.clear();
+}
+
+void LogRecovery::MapLogRecords(int64_t begin, int64_t end) {
+  int64_t offset = begin;
+  int read_size;
+  int64_t next_offset;
+  while (offset < end &&
+         disk_manager_->ReadLog(log_buffer_, static_cast<int>(log_buffer_size_), offset, &read_size, &next_offset)) {
+    // A read may run past the end, the records there are mapped already.
+    size_t pos = 0;
+    LogRecord log_record;
+    while (DeserializeLogRecord(log_buffer_ + pos, log_buffer_size_ - pos, &log_record)) {
+      lsn_mapping_.emplace(log_record.lsn_, std::make_pair(offset, pos));
+      pos += log_record.size_;
+    }
+    if (pos == 0) {
+      break;
+    }
+    offset = GetNextReadOffset(offset, pos, read_size, next_offset);
+  }
+}
+
+int64_t LogRecovery::GetNextReadOffset(int64_t offset, size_t pos, int read_size, int64_t next_offset) {
+  // Compressed blocks hold whole records, their offsets in the log differ from the positions in the read data.
+  return pos == static_cast<size_t>(read_size) ? next_offset : offset + static_cast<int64_t>(pos);
+}
+
+void LogRecovery::UndoOnPage(LogRecord *log_record) {
+  page_id_t page_id;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      page_id = log_record->insert_rid_.GetPageId();
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      page_id = log_record->delete_rid_.GetPageId();
+      break;
+    case LogRecordType::UPDATE:
+      page_id = log_record->update_rid_.GetPageId();
+      break;
+    case LogRecordType::PAGEIMAGE:
+    case LogRecordType::TRUNCATE:
+      page_id = log_record->page_id_;
+      break;
+    default:
+      // A new page is left in the table heap, it is empty once the tuples of the transaction are gone.
+      return;
+  }
+
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception("Undo cannot read page " + std::to_string(page_id) +
+                    ": it fails its checksum, or no frame is free.");
+  }
+  auto *table_page = reinterpret_cast<TablePage *>(page);
+  page->WLatch();
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      table_page->ApplyDelete(log_record->insert_rid_, nullptr, nullptr);
+      break;
+    case LogRecordType::MARKDELETE:
+      table_page->RollbackDelete(log_record->delete_rid_, nullptr, nullptr);
+      break;
+    case LogRecordType::APPLYDELETE: {
+      RID rid;
+      table_page->InsertTuple(log_record->delete_tuple_, &rid, nullptr, nullptr, nullptr);
+      break;
+    }
+    case LogRecordType::ROLLBACKDELETE:
+      table_page->MarkDelete(log_record->delete_rid_, nullptr, nullptr, nullptr);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple new_tuple;
+      const bool found = table_page->GetTuple(log_record->update_rid_, &new_tuple, nullptr, nullptr);
+      BUSTUB_ASSERT(found, "Undo must find the tuple that was updated.");
+      table_page->UpdateTuple(log_record->GetOldTuple(new_tuple), &new_tuple, log_record->update_rid_, nullptr, nullptr,
+                              nullptr);
+      break;
+    }
+    case LogRecordType::PAGEIMAGE:
+      // A bulk load has the pages that it filled to itself, all the tuples there are its own.
+      table_page->RemoveAllTuples();
+      break;
+    case LogRecordType::TRUNCATE:
+      // The first page links to the pages that followed it again, which the truncation left as they were.
+      memcpy(page->GetData(), log_record->page_image_, PAGE_SIZE);
+      break;
+    default:
+      break;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
 
 }  // namespace bustub
@@ -10,106 +10,525 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cinttypes>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <shared_mutex>
 #include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
+#include "common/macros.h"
 #include "common/logger.h"
+#include "common/util/crc32c.h"
+#include "common/util/lz_compressor.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
+namespace {
+
+// Direct I/O needs buffers, file offsets and lengths that are aligned to the logical block size of the device.
+constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+static_assert(PAGE_SIZE % DIRECT_IO_ALIGNMENT == 0, "Pages must be aligned for direct I/O.");
+
+// Identifies a free space map file, followed by the number of extents that the map covers.
+constexpr uint64_t FREE_SPACE_MAP_MAGIC = 0x4253544246534d31;  // "BSTBFSM1"
+
+// Identifies a tier map file, followed by the number of extents that the map covers.
+constexpr uint64_t TIER_MAP_MAGIC = 0x4253544254494531;  // "BSTBTIE1"
+
+static_assert(EXTENT_SIZE == 64, "An extent must fit the 64 bits of a free space map word.");
+static_assert(SEGMENT_SIZE % EXTENT_SIZE == 0, "Extents must not cross segment files.");
+
+/**
+ * @return a mask of the pages of an extent whose ids are in the class, i.e. page_id % num_classes == page_class
+ */
+uint64_t ClassMask(size_t extent, uint32_t num_classes, uint32_t page_class) {
+  if (num_classes == 1) {
+    return ~uint64_t{0};
+  }
+  const size_t first_page_id = extent * EXTENT_SIZE;
+  uint64_t mask = 0;
+  for (size_t i = (page_class + num_classes - first_page_id % num_classes) % num_classes; i < EXTENT_SIZE;
+       i += num_classes) {
+    mask |= uint64_t{1} << i;
+  }
+  return mask;
+}
+
+// Identifies the header of a slot that holds a compressed page.
+constexpr uint32_t PAGE_SLOT_MAGIC = 0x42535450;  // "BSTP"
+
+/** The header in front of the data of every slot of a compressed database file. */
+struct SlotHeader {
+  uint32_t magic_;
+  page_id_t page_id_;
+  // the write that put the page into the slot
+  uint64_t write_seq_;
+  // the size of the data behind the header, PAGE_SIZE if the page is stored uncompressed
+  uint16_t data_size_;
+  // the size of the slot in units of COMPRESSED_SLOT_SIZE
+  uint8_t num_units_;
+  uint8_t compressed_;
+  uint32_t reserved_;
+};
+
+// A page that does not compress is stored as is, in the largest slot.
+constexpr size_t MAX_SLOT_UNITS = (sizeof(SlotHeader) + PAGE_SIZE + COMPRESSED_SLOT_SIZE - 1) / COMPRESSED_SLOT_SIZE;
+
+/** @return a buffer for the calling thread that holds the largest slot */
+char *GetSlotBuffer() {
+  thread_local std::vector<char> buffer(MAX_SLOT_UNITS * COMPRESSED_SLOT_SIZE);
+  return buffer.data();
+}
+
+/**
+ * Replaces a small file, e.g. a map, with new contents durably: the contents are written to a file next to it and
+ * synced before the rename, and the rename is synced after, so that a crash leaves either the old file or the new one.
+ * @return false on an I/O error, the old file is left as it was then
+ */
+bool ReplaceFileDurably(const std::string &name, const char *data, size_t size) {
+  const std::string tmp_name = name + ".tmp";
+  const int fd = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_DEBUG("can't open %s (%s)", tmp_name.c_str(), strerror(errno));
+    return false;
+  }
+  const bool written = write(fd, data, size) == static_cast<ssize_t>(size) && fsync(fd) == 0;
+  close(fd);
+  if (!written || rename(tmp_name.c_str(), name.c_str()) != 0) {
+    remove(tmp_name.c_str());
+    return false;
+  }
+  const std::string::size_type slash = name.rfind('/');
+  const std::string dir_name = slash == std::string::npos ? "." : name.substr(0, slash + 1);
+  const int dir_fd = open(dir_name.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dir_fd >= 0) {
+    if (fsync(dir_fd) != 0) {
+      LOG_DEBUG("I/O error while syncing the directory of %s", name.c_str());
+    }
+    close(dir_fd);
+  }
+  return true;
+}
+
+bool IsDirectIOAligned(const char *data) { return reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0; }
+
+/** @return an aligned PAGE_SIZE buffer for the calling thread, used for page buffers that are not aligned */
+char *GetBounceBuffer() {
+  thread_local std::unique_ptr<char, decltype(&free)> buffer(
+      static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, PAGE_SIZE)), &free);
+  return buffer.get();
+}
+
+}  // namespace
+
 static char *buffer_used;
 
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, DiskIOMode io_mode, bool compress_pages,
+                         std::vector<std::string> stripe_dirs, std::string capacity_dir)
+    : file_name_(db_file),
+      next_page_id_(0),
+      num_flushes_(0),
+      num_writes_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr),
+      io_mode_(io_mode),
+      stripe_dirs_(std::move(stripe_dirs)),
+      compress_pages_(compress_pages),
+      free_slots_(MAX_SLOT_UNITS + 1),
+      capacity_dir_(std::move(capacity_dir)) {
+  // Compressed pages are copied through a slot buffer anyway and their slots are smaller than a block. Their slots
+  // are not laid out by page id, so they have no extents to move between tiers either.
+  if (compress_pages_) {
+    io_mode_ = DiskIOMode::BUFFERED;
+    capacity_dir_.clear();
+  }
   std::string::size_type n = file_name_.find('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
+    io_mode_ = DiskIOMode::BUFFERED;
+    capacity_dir_.clear();
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  map_name_ = file_name_.substr(0, n) + ".fsm";
+  master_name_ = file_name_.substr(0, n) + ".master";
+  tier_name_ = file_name_.substr(0, n) + ".tier";
+
+  // A leftover map or checksum file of a database file that has since been removed must not be loaded.
+  const bool db_exists = GetFileSize(db_file) > 0;
+  OpenLog(db_exists);
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  }
-
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+#ifndef O_DIRECT
+  io_mode_ = DiskIOMode::BUFFERED;
+#endif
+  db_fd_ = OpenSegmentFile(db_file, true);
+  if (db_fd_ < 0 && io_mode_ == DiskIOMode::DIRECT) {
+    LOG_DEBUG("Direct I/O is not available for %s (%s), falling back to buffered I/O.", db_file.c_str(),
+              strerror(errno));
+    io_mode_ = DiskIOMode::BUFFERED;
+    db_fd_ = OpenSegmentFile(db_file, true);
+  }
+  if (db_fd_ < 0) {
+    LOG_DEBUG("can't open db file %s (%s)", db_file.c_str(), strerror(errno));
+  } else {
+    if (compress_pages_) {
+      LoadPageSlots();
+    } else {
+      // The segment files are created in order, so the first one missing ends the database.
+      segment_fds_.push_back(db_fd_);
+      for (int fd; (fd = OpenSegmentFile(GetSegmentName(segment_fds_.size()), false)) >= 0;) {
+        segment_fds_.push_back(fd);
+      }
+      // An I/O in flight could land in the copy of an extent that is being moved away, so tiered I/O is synchronous.
+      if (!IsTiered()) {
+        StartAsyncIO();
+      }
+    }
+    OpenChecksumFile(db_exists);
+  }
+  if (db_exists) {
+    std::scoped_lock map_lock(map_latch_);
+    LoadFreeSpaceMap();
+  }
+  if (IsTiered() && db_fd_ >= 0) {
+    LoadTierMap();
+    if (!db_exists) {
+      // The capacity tier of a database file that has since been removed must not be read.
+      for (size_t segment = 0; GetFileSize(GetCapacityName(segment)) >= 0; segment++) {
+        std::remove(GetCapacityName(segment).c_str());
+      }
+      std::scoped_lock tier_lock(tier_latch_);
+      tiers_.clear();
+      SaveTierMap();
+    }
+    migration_thread_ = std::thread(&DiskManager::RunMigrations, this);
   }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() { StopMigrations(); }
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  db_io_.close();
-  log_io_.close();
+  shut_down_ = true;
+  StopMigrations();
+  FlushFreeSpaceMap();
+  // Let the queued I/Os finish before their file goes away.
+  io_uring_.reset();
+  for (auto &mapped_segment : mapped_segments_) {
+    if (mapped_segment.data_ != nullptr) {
+      munmap(mapped_segment.data_, mapped_segment.num_pages_ * PAGE_SIZE);
+    }
+  }
+  mapped_segments_.clear();
+  has_mapped_segments_ = false;
+  // The first segment file is the database file itself.
+  for (size_t segment = 1; segment < segment_fds_.size(); segment++) {
+    close(segment_fds_[segment]);
+  }
+  segment_fds_.clear();
+  for (int fd : capacity_fds_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  capacity_fds_.clear();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (checksum_fd_ >= 0) {
+    close(checksum_fd_);
+    checksum_fd_ = -1;
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  if (GetMappedPage(page_id) != nullptr) {
+    LOG_DEBUG("Page %d is read-only", page_id);
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  SaveAllocations();
+  if (compress_pages_) {
+    WriteCompressedPage(page_id, page_data);
+    return;
+  }
+  auto extent_lock = LockExtent(page_id);
+  const int fd = GetPageFd(page_id, true);
+  if (fd < 0) {
+    LOG_DEBUG("can't open the segment file of page %d", page_id);
+    return;
+  }
+  const off_t offset = GetSegmentOffset(page_id);
+  const char *buffer = page_data;
+  if (!CanUseBuffer(page_data)) {
+    char *bounce_buffer = GetBounceBuffer();
+    memcpy(bounce_buffer, page_data, PAGE_SIZE);
+    buffer = bounce_buffer;
+  }
+  num_writes_ += 1;
+  size_t write_count = 0;
+  while (write_count < PAGE_SIZE) {
+    ssize_t n = pwrite(fd, buffer + write_count, PAGE_SIZE - write_count, offset + write_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    write_count += n;
+  }
+  RecordChecksum(page_id, ComputeChecksum(page_id, buffer));
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error while reading");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+bool DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  ReadPageData(page_id, page_data);
+  return VerifyChecksum(page_id, page_data);
+}
+
+bool DiskManager::TryReadPage(page_id_t page_id, char *page_data) {
+  ReadPageData(page_id, page_data);
+  return MatchesChecksum(page_id, page_data);
+}
+
+void DiskManager::ReadPageData(page_id_t page_id, char *page_data) {
+  if (compress_pages_) {
+    ReadCompressedPage(page_id, page_data);
+    return;
+  }
+  // Pages past the last segment file read as zeros, like pages past the end of a segment file.
+  auto extent_lock = LockExtent(page_id);
+  const int fd = GetPageFd(page_id, false);
+  const off_t offset = GetSegmentOffset(page_id);
+  char *buffer = CanUseBuffer(page_data) ? page_data : GetBounceBuffer();
+  size_t read_count = 0;
+  while (fd >= 0 && read_count < PAGE_SIZE) {
+    ssize_t n = pread(fd, buffer + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      LOG_DEBUG("I/O error while reading");
+      break;
+    }
+    if (n == 0) {
       LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+      break;
+    }
+    read_count += n;
+  }
+  // if file ends before reading PAGE_SIZE
+  memset(buffer + read_count, 0, PAGE_SIZE - read_count);
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, PAGE_SIZE);
+  }
+}
+
+std::vector<bool> DiskManager::ReadPages(const std::vector<page_id_t> &page_ids, const std::vector<char *> &page_data) {
+  assert(page_ids.size() == page_data.size());
+  std::vector<bool> valid(page_ids.size());
+  if (compress_pages_) {
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      valid[i] = ReadPage(page_ids[i], page_data[i]);
+    }
+    return valid;
+  }
+  std::vector<struct iovec> iov;
+  size_t i = 0;
+  while (i < page_ids.size()) {
+    // Gather the run of consecutive pages of a segment starting at page i whose buffers the kernel can fill directly.
+    // With tiers, the extents of a segment may be in different files, so the run stays in one extent.
+    const page_id_t run_unit = IsTiered() ? EXTENT_SIZE : SEGMENT_SIZE;
+    iov.clear();
+    size_t end = i;
+    while (end < page_ids.size() && iov.size() < IOV_MAX && page_ids[end] == page_ids[i] + static_cast<int>(end - i) &&
+           page_ids[end] / run_unit == page_ids[i] / run_unit && CanUseBuffer(page_data[end])) {
+      iov.push_back({page_data[end], PAGE_SIZE});
+      end++;
+    }
+    if (iov.size() <= 1) {
+      valid[i] = ReadPage(page_ids[i], page_data[i]);
+      i++;
+      continue;
+    }
+    ssize_t n = -1;
+    {
+      auto extent_lock = LockExtent(page_ids[i]);
+      const int fd = GetPageFd(page_ids[i], false);
+      if (fd >= 0) {
+        do {
+          n = preadv(fd, iov.data(), static_cast<int>(iov.size()), GetSegmentOffset(page_ids[i]));
+        } while (n < 0 && errno == EINTR);
+      }
+    }
+    // The pages that came back whole are done, the rest of the run is read one by one, which zero fills past the end.
+    const size_t num_read = n < 0 ? 0 : static_cast<size_t>(n) / PAGE_SIZE;
+    for (size_t j = i; j < i + num_read; j++) {
+      valid[j] = VerifyChecksum(page_ids[j], page_data[j]);
     }
+    for (size_t j = i + num_read; j < end; j++) {
+      valid[j] = ReadPage(page_ids[j], page_data[j]);
+    }
+    i = end;
+  }
+  return valid;
+}
+
+void DiskManager::WritePages(const std::vector<page_id_t> &page_ids, const std::vector<const char *> &page_data) {
+  assert(page_ids.size() == page_data.size());
+  SaveAllocations();
+  if (compress_pages_) {
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      WritePage(page_ids[i], page_data[i]);
+    }
+    return;
+  }
+  std::vector<std::future<bool>> writes;
+  std::vector<struct iovec> iov;
+  size_t i = 0;
+  while (i < page_ids.size()) {
+    // Gather the run of consecutive writable pages starting at page i, within a segment or an extent like ReadPages.
+    const page_id_t run_unit = IsTiered() ? EXTENT_SIZE : SEGMENT_SIZE;
+    iov.clear();
+    size_t end = i;
+    while (end < page_ids.size() && iov.size() < IOV_MAX && page_ids[end] == page_ids[i] + static_cast<int>(end - i) &&
+           page_ids[end] / run_unit == page_ids[i] / run_unit && CanUseBuffer(page_data[end]) &&
+           GetMappedPage(page_ids[end]) == nullptr) {
+      iov.push_back({const_cast<char *>(page_data[end]), PAGE_SIZE});
+      end++;
+    }
+    if (iov.size() <= 1) {
+      writes.push_back(WritePageAsync(page_ids[i], page_data[i]));
+      i++;
+      continue;
+    }
+    ssize_t n = -1;
+    {
+      auto extent_lock = LockExtent(page_ids[i]);
+      const int fd = GetPageFd(page_ids[i], true);
+      if (fd >= 0) {
+        do {
+          n = pwritev(fd, iov.data(), static_cast<int>(iov.size()), GetSegmentOffset(page_ids[i]));
+        } while (n < 0 && errno == EINTR);
+      }
+    }
+    // The pages that went out whole are done, the rest of the run is written one by one.
+    const size_t num_written = n < 0 ? 0 : static_cast<size_t>(n) / PAGE_SIZE;
+    num_writes_ += static_cast<int>(num_written);
+    for (size_t j = i; j < i + num_written; j++) {
+      RecordChecksum(page_ids[j], ComputeChecksum(page_ids[j], page_data[j]));
+    }
+    for (size_t j = i + num_written; j < end; j++) {
+      WritePage(page_ids[j], page_data[j]);
+    }
+    i = end;
+  }
+  for (auto &write : writes) {
+    write.wait();
   }
 }
 
+void DiskManager::SyncPages() {
+  std::vector<int> fds;
+  {
+    std::shared_lock segment_lock(segment_latch_);
+    fds = segment_fds_;
+    for (int fd : capacity_fds_) {
+      if (fd >= 0) {
+        fds.push_back(fd);
+      }
+    }
+  }
+  // The checksums go last, so that none of them is durable before the page it was computed from.
+  if (checksum_fd_ >= 0) {
+    fds.push_back(checksum_fd_);
+  }
+  for (int fd : fds) {
+    if (fdatasync(fd) != 0) {
+      LOG_DEBUG("can't sync the pages (%s)", strerror(errno));
+    }
+  }
+}
+
+bool DiskManager::MapSegmentReadOnly(size_t segment) {
+  // The pages of a mapping could not move between the tiers.
+  if (compress_pages_ || IsTiered()) {
+    return false;
+  }
+  const int fd = GetSegmentFd(static_cast<page_id_t>(segment * SEGMENT_SIZE), false);
+  struct stat stat_buf;
+  if (fd < 0 || fstat(fd, &stat_buf) != 0 || stat_buf.st_size < PAGE_SIZE) {
+    return false;
+  }
+  std::unique_lock segment_lock(segment_latch_);
+  if (segment < mapped_segments_.size() && mapped_segments_[segment].data_ != nullptr) {
+    return true;
+  }
+  const size_t num_pages = std::min<size_t>(stat_buf.st_size / PAGE_SIZE, SEGMENT_SIZE);
+  void *data = mmap(nullptr, num_pages * PAGE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    LOG_DEBUG("can't map segment %zu (%s)", segment, strerror(errno));
+    return false;
+  }
+  // Read-only segments are mostly scanned.
+  madvise(data, num_pages * PAGE_SIZE, MADV_SEQUENTIAL);
+  if (mapped_segments_.size() <= segment) {
+    mapped_segments_.resize(segment + 1);
+  }
+  mapped_segments_[segment] = {static_cast<char *>(data), num_pages};
+  has_mapped_segments_.store(true, std::memory_order_release);
+  return true;
+}
+
+const char *DiskManager::GetMappedPage(page_id_t page_id) {
+  if (!HasMappedSegments() || page_id < 0) {
+    return nullptr;
+  }
+  const auto segment = static_cast<size_t>(page_id / SEGMENT_SIZE);
+  const auto offset = static_cast<size_t>(page_id % SEGMENT_SIZE);
+  std::shared_lock segment_lock(segment_latch_);
+  if (segment >= mapped_segments_.size() || offset >= mapped_segments_[segment].num_pages_) {
+    return nullptr;
+  }
+  return mapped_segments_[segment].data_ + offset * PAGE_SIZE;
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -131,54 +550,413 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
+  std::scoped_lock log_lock(log_latch_);
+  if (compress_log_ && static_cast<size_t>(size) > sizeof(LogBlockHeader)) {
+    // The block is only written if it is smaller than the log data.
+    log_block_.resize(sizeof(LogBlockHeader) + size);
+    char *compressed = log_block_.data() + sizeof(LogBlockHeader);
+    const size_t compressed_size = LzCompressor::Compress(log_data, size, compressed, size - sizeof(LogBlockHeader));
+    if (compressed_size != 0) {
+      LogBlockHeader header{LOG_BLOCK_MAGIC, static_cast<uint32_t>(size), static_cast<uint32_t>(compressed_size),
+                            Crc32c::Value(compressed, compressed_size)};
+      memcpy(log_block_.data(), &header, sizeof(LogBlockHeader));
+      log_data = log_block_.data();
+      size = static_cast<int>(sizeof(LogBlockHeader) + compressed_size);
+    }
+  }
+  if (!AppendLog(log_data, size)) {
     LOG_DEBUG("I/O error while writing log");
     return;
   }
   // needs to flush to keep disk file in sync
-  log_io_.flush();
+  if (fdatasync(log_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing log");
+  }
   flush_log_ = false;
 }
 
 /**
  * Read the contents of the log into the given memory area
- * Always read from the beginning and perform sequence read
+ * Perform sequence read across the segment files, starting at the given offset
  * @return: false means already reach the end
  */
-bool DiskManager::ReadLog(char *log_data, int size, int offset) {
-  if (offset >= GetFileSize(log_name_)) {
-    // LOG_DEBUG("end of log file");
-    // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
+bool DiskManager::ReadLog(char *log_data, int size, int64_t offset, int *read_size, int64_t *next_offset) {
+  std::scoped_lock log_lock(log_latch_);
+  if (offset >= log_size_ || offset < first_log_segment_ * LOG_SEGMENT_SIZE) {
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
+  int64_t end_offset = offset;
+  int read_count = ReadLogBlocks(log_data, size, &end_offset);
+  if (read_count == 0) {
+    read_count = ReadLogData(log_data, size, offset);
+    end_offset = offset + read_count;
+  }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
+  if (read_size != nullptr) {
+    *read_size = read_count;
+  }
+  if (next_offset != nullptr) {
+    *next_offset = end_offset;
+  }
+  return true;
+}
 
+bool DiskManager::AppendLog(const char *data, int size) {
+  // sequence write, data that does not fit into the last segment continues in a new one
+  for (int written = 0; written < size;) {
+    if (log_fd_ < 0) {
+      return false;
+    }
+    const auto count =
+        static_cast<int>(std::min<int64_t>(size - written, LOG_SEGMENT_SIZE - log_size_ % LOG_SEGMENT_SIZE));
+    const ssize_t rc = write(log_fd_, data + written, count);
+    if (rc <= 0) {
+      return false;
+    }
+    written += rc;
+    log_size_ += rc;
+    if (log_size_ % LOG_SEGMENT_SIZE == 0) {
+      // A full segment is never written again, it has to be durable before the log goes on in the next one.
+      if (fdatasync(log_fd_) != 0) {
+        LOG_DEBUG("I/O error while syncing log");
+      }
+      close(log_fd_);
+      log_fd_ = open(GetLogSegmentName(log_size_ / LOG_SEGMENT_SIZE).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    }
+  }
   return true;
 }
 
+int DiskManager::ReadLogData(char *data, int size, int64_t offset) {
+  int read_count = 0;
+  while (read_count < size && offset + read_count < log_size_) {
+    const int64_t position = offset + read_count;
+    const int fd = open(GetLogSegmentName(position / LOG_SEGMENT_SIZE).c_str(), O_RDONLY);
+    if (fd < 0) {
+      LOG_DEBUG("can't open log segment of offset %" PRId64, position);
+      break;
+    }
+    const auto count =
+        static_cast<int>(std::min<int64_t>(size - read_count, LOG_SEGMENT_SIZE - position % LOG_SEGMENT_SIZE));
+    const ssize_t rc = pread(fd, data + read_count, count, position % LOG_SEGMENT_SIZE);
+    close(fd);
+    if (rc <= 0) {
+      break;
+    }
+    read_count += rc;
+  }
+  return read_count;
+}
+
+int DiskManager::ReadLogBlocks(char *data, int size, int64_t *offset) {
+  int read_count = 0;
+  std::vector<char> compressed;
+  while (*offset < log_size_) {
+    LogBlockHeader header;
+    if (ReadLogData(reinterpret_cast<char *>(&header), sizeof(header), *offset) != sizeof(header) ||
+        header.magic_ != LOG_BLOCK_MAGIC || header.data_size_ > static_cast<uint32_t>(size - read_count)) {
+      break;
+    }
+    // A block that was torn by a crash ends the log.
+    compressed.resize(header.compressed_size_);
+    const int compressed_size = static_cast<int>(header.compressed_size_);
+    if (ReadLogData(compressed.data(), compressed_size, *offset + sizeof(header)) != compressed_size ||
+        Crc32c::Value(compressed.data(), compressed.size()) != header.checksum_ ||
+        LzCompressor::Decompress(compressed.data(), compressed.size(), data + read_count, header.data_size_) !=
+            header.data_size_) {
+      break;
+    }
+    read_count += header.data_size_;
+    *offset += sizeof(header) + compressed_size;
+  }
+  return read_count;
+}
+
+int64_t DiskManager::GetLogSize() {
+  std::scoped_lock log_lock(log_latch_);
+  return log_size_;
+}
+
+int64_t DiskManager::GetLogStartOffset() {
+  std::scoped_lock log_lock(log_latch_);
+  return first_log_segment_ * LOG_SEGMENT_SIZE;
+}
+
+void DiskManager::TruncateLog(int64_t offset) {
+  std::scoped_lock log_lock(log_latch_);
+  if (!log_pins_.empty()) {
+    offset = std::min(offset, *log_pins_.begin());
+  }
+  const int64_t last_segment = log_size_ / LOG_SEGMENT_SIZE;
+  while (first_log_segment_ < last_segment && (first_log_segment_ + 1) * LOG_SEGMENT_SIZE <= offset) {
+    std::remove(GetLogSegmentName(first_log_segment_).c_str());
+    first_log_segment_++;
+  }
+}
+
+int64_t DiskManager::PinLog() {
+  std::scoped_lock log_lock(log_latch_);
+  const int64_t offset = first_log_segment_ * LOG_SEGMENT_SIZE;
+  log_pins_.insert(offset);
+  return offset;
+}
+
+void DiskManager::UnpinLog(int64_t offset) {
+  std::scoped_lock log_lock(log_latch_);
+  auto it = log_pins_.find(offset);
+  if (it != log_pins_.end()) {
+    log_pins_.erase(it);
+  }
+}
+
+int DiskManager::ReadRawLog(char *data, int size, int64_t offset) {
+  std::scoped_lock log_lock(log_latch_);
+  if (offset >= log_size_ || offset < first_log_segment_ * LOG_SEGMENT_SIZE) {
+    return 0;
+  }
+  return ReadLogData(data, size, offset);
+}
+
+void DiskManager::RestartLog(int64_t offset) {
+  assert(offset % LOG_SEGMENT_SIZE == 0);
+  std::scoped_lock log_lock(log_latch_);
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+  }
+  for (int64_t segment = first_log_segment_; segment <= log_size_ / LOG_SEGMENT_SIZE; segment++) {
+    std::remove(GetLogSegmentName(segment).c_str());
+  }
+  first_log_segment_ = offset / LOG_SEGMENT_SIZE;
+  log_size_ = offset;
+  log_fd_ = open(GetLogSegmentName(first_log_segment_).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+  if (log_fd_ < 0) {
+    LOG_DEBUG("can't open log file %s (%s)", GetLogSegmentName(first_log_segment_).c_str(), strerror(errno));
+  }
+}
+
+bool DiskManager::AppendRawLog(const char *data, int size) {
+  std::scoped_lock log_lock(log_latch_);
+  if (!AppendLog(data, size)) {
+    LOG_DEBUG("I/O error while writing log");
+    return false;
+  }
+  return log_fd_ >= 0 && fdatasync(log_fd_) == 0;
+}
+
+void DiskManager::WriteMasterRecord(lsn_t checkpoint_lsn, int64_t redo_offset, int64_t undo_offset) {
+  if (master_name_.empty()) {
+    return;
+  }
+  // Write a new file and swap it in, a crash in between must leave the previous checkpoint behind.
+  const std::string tmp_name = master_name_ + ".tmp";
+  {
+    std::ofstream out(tmp_name, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&checkpoint_lsn), sizeof(lsn_t));
+    out.write(reinterpret_cast<const char *>(&redo_offset), sizeof(int64_t));
+    out.write(reinterpret_cast<const char *>(&undo_offset), sizeof(int64_t));
+    out.close();
+    if (!out) {
+      LOG_DEBUG("I/O error while writing the master record");
+      std::remove(tmp_name.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_name.c_str(), master_name_.c_str()) != 0) {
+    LOG_DEBUG("can't replace the master record %s", master_name_.c_str());
+  }
+}
+
+bool DiskManager::ReadMasterRecord(lsn_t *checkpoint_lsn, int64_t *redo_offset, int64_t *undo_offset) {
+  std::ifstream in(master_name_, std::ios::binary);
+  if (!in.read(reinterpret_cast<char *>(checkpoint_lsn), sizeof(lsn_t)) ||
+      !in.read(reinterpret_cast<char *>(redo_offset), sizeof(int64_t)) ||
+      !in.read(reinterpret_cast<char *>(undo_offset), sizeof(int64_t))) {
+    return false;
+  }
+  // A master record that points outside of the log belongs to a log that has been replaced.
+  std::scoped_lock log_lock(log_latch_);
+  return *undo_offset >= first_log_segment_ * LOG_SEGMENT_SIZE && *undo_offset <= *redo_offset &&
+         *redo_offset < log_size_;
+}
+
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Reuses a free page of the shared extents, or opens a new shared extent
+ */
+page_id_t DiskManager::AllocatePage(uint32_t num_classes, uint32_t page_class) {
+  std::scoped_lock map_lock(map_latch_);
+  size_t &hint = shared_hints_[{num_classes, page_class}];
+  for (size_t extent = hint; extent < extent_pages_.size(); extent++) {
+    if (extent_kinds_[extent] != ExtentKind::SHARED || IsExtentMapped(extent)) {
+      continue;
+    }
+    const uint64_t free_pages = ~extent_pages_[extent] & ClassMask(extent, num_classes, page_class);
+    if (free_pages != 0) {
+      hint = extent;
+      return TakePage(extent, __builtin_ctzll(free_pages));
+    }
+  }
+  while (true) {
+    // With more classes than pages per extent, some extents have no page of this class. The others get to use them.
+    const size_t extent = OpenExtent(ExtentKind::SHARED);
+    const uint64_t class_pages = ClassMask(extent, num_classes, page_class);
+    if (class_pages != 0) {
+      hint = extent;
+      return TakePage(extent, __builtin_ctzll(class_pages));
+    }
+  }
+}
+
+page_id_t DiskManager::AllocateExtentPage(page_id_t prev_page_id, uint32_t num_classes, uint32_t page_class) {
+  std::scoped_lock map_lock(map_latch_);
+  if (prev_page_id >= 0) {
+    const size_t prev_extent = prev_page_id / EXTENT_SIZE;
+    // The first page after prev_page_id that is in the class.
+    const page_id_t next_page_id =
+        prev_page_id + 1 + (page_class + num_classes - (prev_page_id + 1) % num_classes) % num_classes;
+    const size_t extent = next_page_id / EXTENT_SIZE;
+    const int offset = next_page_id % EXTENT_SIZE;
+    if (extent == prev_extent && extent_kinds_[extent] == ExtentKind::DEDICATED &&
+        (extent_pages_[extent] & (uint64_t{1} << offset)) == 0 && !IsExtentMapped(extent)) {
+      return TakePage(extent, offset);
+    }
+    if (extent == prev_extent + 1 && (extent >= extent_pages_.size() || extent_kinds_[extent] == ExtentKind::FREE) &&
+        !IsExtentMapped(extent)) {
+      ClaimExtent(extent, ExtentKind::DEDICATED);
+      return TakePage(extent, offset);
+    }
+  }
+  while (true) {
+    const size_t extent = OpenExtent(ExtentKind::DEDICATED);
+    const uint64_t class_pages = ClassMask(extent, num_classes, page_class);
+    if (class_pages != 0) {
+      return TakePage(extent, __builtin_ctzll(class_pages));
+    }
+  }
+}
+
+bool DiskManager::IsPageAllocated(page_id_t page_id) {
+  if (page_id < 0) {
+    return false;
+  }
+  std::scoped_lock map_lock(map_latch_);
+  const size_t extent = page_id / EXTENT_SIZE;
+  return extent < extent_pages_.size() && (extent_pages_[extent] & (uint64_t{1} << (page_id % EXTENT_SIZE))) != 0;
+}
+
+/**
+ * Returns the number of pages in the database file
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::GetNumPagesOnDisk() {
+  if (compress_pages_) {
+    std::scoped_lock slot_lock(slot_latch_);
+    return static_cast<page_id_t>(page_slots_.size());
+  }
+  std::shared_lock segment_lock(segment_latch_);
+  if (segment_fds_.empty()) {
+    return 0;
+  }
+  struct stat stat_buf;
+  if (fstat(segment_fds_.back(), &stat_buf) != 0) {
+    return 0;
+  }
+  return static_cast<page_id_t>((segment_fds_.size() - 1) * SEGMENT_SIZE + stat_buf.st_size / PAGE_SIZE);
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * An extent whose pages are all deallocated becomes free and can be opened again
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  if (page_id < 0) {
+    return;
+  }
+  if (compress_pages_) {
+    std::scoped_lock slot_lock(slot_latch_);
+    if (static_cast<size_t>(page_id) < page_slots_.size() && page_slots_[page_id].offset_ >= 0) {
+      PageSlot &slot = page_slots_[page_id];
+      free_slots_[slot.num_units_].push_back(slot.offset_);
+      // The write sequence stays, so that an older write of the page still in flight cannot take it back.
+      slot.offset_ = -1;
+      slot.num_units_ = 0;
+    }
+  }
+  std::scoped_lock map_lock(map_latch_);
+  const size_t extent = page_id / EXTENT_SIZE;
+  const uint64_t bit = uint64_t{1} << (page_id % EXTENT_SIZE);
+  if (extent >= extent_pages_.size() || (extent_pages_[extent] & bit) == 0) {
+    return;
+  }
+  extent_pages_[extent] &= ~bit;
+  map_dirty_ = true;
+  if (extent_pages_[extent] == 0) {
+    extent_kinds_[extent] = ExtentKind::FREE;
+    free_extents_.insert(extent);
+  } else if (extent_kinds_[extent] == ExtentKind::SHARED) {
+    for (auto &hint : shared_hints_) {
+      hint.second = std::min(hint.second, extent);
+    }
+  }
+}
+
+void DiskManager::FlushFreeSpaceMap() {
+  std::scoped_lock map_lock(map_latch_);
+  if (!map_dirty_ || map_name_.empty()) {
+    return;
+  }
+  const uint64_t header[2] = {FREE_SPACE_MAP_MAGIC, extent_pages_.size()};
+  std::vector<char> data(sizeof(header) + extent_pages_.size() * (sizeof(uint64_t) + sizeof(ExtentKind)));
+  char *pos = data.data();
+  memcpy(pos, header, sizeof(header));
+  pos += sizeof(header);
+  memcpy(pos, extent_pages_.data(), extent_pages_.size() * sizeof(uint64_t));
+  pos += extent_pages_.size() * sizeof(uint64_t);
+  memcpy(pos, extent_kinds_.data(), extent_kinds_.size() * sizeof(ExtentKind));
+  // The map is synced before it replaces the old one, since the pages that it covers are written after it.
+  if (!ReplaceFileDurably(map_name_, data.data(), data.size())) {
+    LOG_DEBUG("I/O error while writing the free space map");
+    return;
+  }
+  map_dirty_ = false;
+  map_unsaved_allocations_ = false;
+}
+
+void DiskManager::SaveAllocations() {
+  if (map_unsaved_allocations_ && !map_name_.empty()) {
+    FlushFreeSpaceMap();
+  }
+}
+
+void DiskManager::MarkPageAllocated(page_id_t page_id) {
+  if (page_id < 0) {
+    return;
+  }
+  std::scoped_lock map_lock(map_latch_);
+  const size_t extent = page_id / EXTENT_SIZE;
+  if (extent >= extent_pages_.size() || extent_kinds_[extent] == ExtentKind::FREE) {
+    // The pages that the log names are those of table heaps, which allocate in dedicated extents.
+    ClaimExtent(extent, ExtentKind::DEDICATED);
+  }
+  if ((extent_pages_[extent] & (uint64_t{1} << (page_id % EXTENT_SIZE))) == 0) {
+    TakePage(extent, page_id % EXTENT_SIZE);
+  }
+}
+
+void DiskManager::CopyFreeSpaceMapTo(DiskManager *target) {
+  {
+    std::scoped_lock map_lock(map_latch_, target->map_latch_);
+    target->extent_pages_ = extent_pages_;
+    target->extent_kinds_ = extent_kinds_;
+    target->free_extents_ = free_extents_;
+    target->shared_hints_.clear();
+    target->next_page_id_ = next_page_id_.load();
+    target->map_dirty_ = true;
+  }
+  target->FlushFreeSpaceMap();
+}
 
 /**
  * Returns number of flushes made so far
@@ -195,13 +973,726 @@ int DiskManager::GetNumWrites() const { return num_writes_; }
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+void DiskManager::CollectMetrics(MetricsSnapshot *snapshot) {
+  snapshot->AddCounter("bustub_disk_page_writes_total", "Pages written to the database file.",
+                       static_cast<double>(GetNumWrites()));
+  snapshot->AddCounter("bustub_disk_log_flushes_total", "Writes to the log.", static_cast<double>(GetNumFlushes()));
+  snapshot->AddCounter("bustub_disk_checksum_failures_total", "Pages read back with a checksum that did not match.",
+                       static_cast<double>(GetNumChecksumFailures()));
+  snapshot->AddGauge("bustub_disk_pages", "Pages that the database file holds.",
+                     static_cast<double>(GetNumPagesOnDisk()));
+  snapshot->AddGauge("bustub_disk_log_bytes", "Size of the log, including the truncated segments.",
+                     static_cast<double>(GetLogSize()));
+  if (IsTiered()) {
+    size_t num_cold_extents;
+    {
+      std::scoped_lock tier_lock(tier_latch_);
+      num_cold_extents = std::count(tiers_.begin(), tiers_.end(), StorageTier::CAPACITY);
+    }
+    snapshot->AddGauge("bustub_disk_capacity_tier_extents", "Extents in the capacity tier.",
+                       static_cast<double>(num_cold_extents));
+    snapshot->AddCounter("bustub_disk_tier_migrations_total", "Extents moved between the storage tiers.",
+                         static_cast<double>(num_migrations_.load()));
+  }
+}
+
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
+}
+
+int DiskManager::OpenSegmentFile(const std::string &segment_name, bool create) const {
+  int flags = O_RDWR | (create ? O_CREAT : 0);
+#ifdef O_DIRECT
+  if (io_mode_ == DiskIOMode::DIRECT) {
+    flags |= O_DIRECT;
+  }
+#endif
+  return open(segment_name.c_str(), flags, 0644);
+}
+
+std::string DiskManager::GetSegmentName(size_t segment) const {
+  if (segment == 0) {
+    return file_name_;
+  }
+  if (stripe_dirs_.empty()) {
+    return file_name_ + "." + std::to_string(segment);
+  }
+  const std::string::size_type slash = file_name_.rfind('/');
+  const std::string base_name = slash == std::string::npos ? file_name_ : file_name_.substr(slash + 1);
+  return stripe_dirs_[segment % stripe_dirs_.size()] + "/" + base_name + "." + std::to_string(segment);
+}
+
+std::string DiskManager::GetLogSegmentName(int64_t segment) const {
+  return segment == 0 ? log_name_ : log_name_ + "." + std::to_string(segment);
+}
+
+void DiskManager::OpenLog(bool db_exists) {
+  // The master record of a log that belongs to a removed database file must not be followed.
+  if (!db_exists) {
+    std::remove(master_name_.c_str());
+  }
+  // The segments before the one that the last checkpoint needs undo to start in have been truncated, or should have.
+  lsn_t checkpoint_lsn;
+  int64_t redo_offset;
+  int64_t undo_offset;
+  std::ifstream in(master_name_, std::ios::binary);
+  if (in.read(reinterpret_cast<char *>(&checkpoint_lsn), sizeof(lsn_t)) &&
+      in.read(reinterpret_cast<char *>(&redo_offset), sizeof(int64_t)) &&
+      in.read(reinterpret_cast<char *>(&undo_offset), sizeof(int64_t)) && undo_offset >= 0 &&
+      GetFileSize(GetLogSegmentName(undo_offset / LOG_SEGMENT_SIZE)) >= 0) {
+    first_log_segment_ = undo_offset / LOG_SEGMENT_SIZE;
+  }
+  for (int64_t segment = first_log_segment_ - 1; segment >= 0 && GetFileSize(GetLogSegmentName(segment)) >= 0;
+       segment--) {
+    std::remove(GetLogSegmentName(segment).c_str());
+  }
+  // Only the last segment is not full. Anything after it is left over from a log that has been started over.
+  int64_t last_segment = first_log_segment_;
+  while (GetFileSize(GetLogSegmentName(last_segment)) == LOG_SEGMENT_SIZE) {
+    last_segment++;
+  }
+  for (int64_t segment = last_segment + 1; GetFileSize(GetLogSegmentName(segment)) >= 0; segment++) {
+    std::remove(GetLogSegmentName(segment).c_str());
+  }
+  log_fd_ = open(GetLogSegmentName(last_segment).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (log_fd_ < 0) {
+    LOG_DEBUG("can't open log file %s (%s)", GetLogSegmentName(last_segment).c_str(), strerror(errno));
+  }
+  log_size_ = last_segment * LOG_SEGMENT_SIZE + std::max<int64_t>(GetFileSize(GetLogSegmentName(last_segment)), 0);
+}
+
+int DiskManager::GetSegmentFd(page_id_t page_id, bool create) {
+  const auto segment = static_cast<size_t>(page_id / SEGMENT_SIZE);
+  {
+    std::shared_lock segment_lock(segment_latch_);
+    if (segment < segment_fds_.size()) {
+      return segment_fds_[segment];
+    }
+  }
+  if (!create) {
+    return -1;
+  }
+  std::unique_lock segment_lock(segment_latch_);
+  while (segment_fds_.size() <= segment) {
+    const std::string segment_name = GetSegmentName(segment_fds_.size());
+    const int fd = OpenSegmentFile(segment_name, true);
+    if (fd < 0) {
+      LOG_DEBUG("can't open segment file %s (%s)", segment_name.c_str(), strerror(errno));
+      return -1;
+    }
+    segment_fds_.push_back(fd);
+  }
+  return segment_fds_[segment];
+}
+
+int DiskManager::GetPageFd(page_id_t page_id, bool create) {
+  if (!IsTiered()) {
+    return GetSegmentFd(page_id, create);
+  }
+  const auto extent = static_cast<size_t>(page_id / EXTENT_SIZE);
+  bool cold;
+  {
+    std::scoped_lock tier_lock(tier_latch_);
+    if (heat_.size() <= extent) {
+      heat_.resize(extent + 1, TIER_PROMOTE_HEAT);
+    }
+    heat_[extent] += heat_[extent] < UINT32_MAX ? 1 : 0;
+    cold = extent < tiers_.size() && tiers_[extent] == StorageTier::CAPACITY;
+  }
+  return cold ? GetCapacityFd(page_id / SEGMENT_SIZE, create) : GetSegmentFd(page_id, create);
+}
+
+std::shared_lock<std::shared_mutex> DiskManager::LockExtent(page_id_t page_id) {
+  if (!IsTiered()) {
+    return {};
+  }
+  return std::shared_lock(extent_latches_[static_cast<size_t>(page_id / EXTENT_SIZE) % extent_latches_.size()]);
+}
+
+std::string DiskManager::GetCapacityName(size_t segment) const {
+  const std::string::size_type slash = file_name_.rfind('/');
+  const std::string base_name = slash == std::string::npos ? file_name_ : file_name_.substr(slash + 1);
+  return capacity_dir_ + "/" + base_name + ".cold." + std::to_string(segment);
+}
+
+int DiskManager::GetCapacityFd(size_t segment, bool create) {
+  {
+    std::shared_lock segment_lock(segment_latch_);
+    if (segment < capacity_fds_.size() && capacity_fds_[segment] >= 0) {
+      return capacity_fds_[segment];
+    }
+  }
+  std::unique_lock segment_lock(segment_latch_);
+  if (capacity_fds_.size() <= segment) {
+    capacity_fds_.resize(segment + 1, -1);
+  }
+  if (capacity_fds_[segment] < 0) {
+    capacity_fds_[segment] = OpenSegmentFile(GetCapacityName(segment), create);
+  }
+  return capacity_fds_[segment];
+}
+
+void DiskManager::RecordPageAccesses(page_id_t page_id, uint32_t num_accesses) {
+  if (!IsTiered() || page_id < 0 || num_accesses == 0) {
+    return;
+  }
+  const auto extent = static_cast<size_t>(page_id / EXTENT_SIZE);
+  std::scoped_lock tier_lock(tier_latch_);
+  if (heat_.size() <= extent) {
+    heat_.resize(extent + 1, TIER_PROMOTE_HEAT);
+  }
+  heat_[extent] = static_cast<uint32_t>(std::min<uint64_t>(uint64_t{heat_[extent]} + num_accesses, UINT32_MAX));
+}
+
+bool DiskManager::IsExtentCold(size_t extent) {
+  std::scoped_lock tier_lock(tier_latch_);
+  return extent < tiers_.size() && tiers_[extent] == StorageTier::CAPACITY;
+}
+
+size_t DiskManager::MigrateExtents() {
+  if (!IsTiered()) {
+    return 0;
+  }
+  std::scoped_lock migration_lock(migration_latch_);
+  std::vector<ExtentKind> extent_kinds;
+  {
+    std::scoped_lock map_lock(map_latch_);
+    extent_kinds = extent_kinds_;
+  }
+  std::vector<std::pair<size_t, StorageTier>> moves;
+  {
+    std::scoped_lock tier_lock(tier_latch_);
+    if (heat_.size() < extent_kinds.size()) {
+      heat_.resize(extent_kinds.size(), TIER_PROMOTE_HEAT);
+    }
+    for (size_t extent = 0; extent < extent_kinds.size() && moves.size() < TIER_MIGRATION_BATCH; extent++) {
+      const bool cold = extent < tiers_.size() && tiers_[extent] == StorageTier::CAPACITY;
+      // A free cold extent goes back for free, so that the next data put into it lands in the performance tier.
+      if (cold && (extent_kinds[extent] == ExtentKind::FREE || heat_[extent] >= TIER_PROMOTE_HEAT)) {
+        moves.emplace_back(extent, StorageTier::PERFORMANCE);
+      } else if (!cold && extent_kinds[extent] != ExtentKind::FREE && heat_[extent] == 0) {
+        moves.emplace_back(extent, StorageTier::CAPACITY);
+      }
+    }
+    // An extent that is no longer accessed cools down over a few passes, one that was promoted as well.
+    for (uint32_t &heat : heat_) {
+      heat /= 2;
+    }
+  }
+  size_t num_moved = 0;
+  for (const auto &[extent, tier] : moves) {
+    num_moved += MoveExtent(extent, tier) ? 1 : 0;
+  }
+  return num_moved;
+}
+
+bool DiskManager::MoveExtent(size_t extent, StorageTier tier) {
+  const auto first_page_id = static_cast<page_id_t>(extent * EXTENT_SIZE);
+  const int hot_fd = GetSegmentFd(first_page_id, true);
+  const int cold_fd = GetCapacityFd(first_page_id / SEGMENT_SIZE, true);
+  if (hot_fd < 0 || cold_fd < 0) {
+    LOG_DEBUG("can't open the files of extent %zu (%s)", extent, strerror(errno));
+    return false;
+  }
+  const int from_fd = tier == StorageTier::CAPACITY ? hot_fd : cold_fd;
+  const int to_fd = tier == StorageTier::CAPACITY ? cold_fd : hot_fd;
+  const off_t offset = GetSegmentOffset(first_page_id);
+  constexpr size_t extent_bytes = static_cast<size_t>(EXTENT_SIZE) * PAGE_SIZE;
+
+  std::unique_lock extent_lock(extent_latches_[extent % extent_latches_.size()]);
+  bool is_free;
+  {
+    std::scoped_lock map_lock(map_latch_);
+    is_free = extent >= extent_kinds_.size() || extent_kinds_[extent] == ExtentKind::FREE;
+  }
+  // A free extent holds no data, so it switches over without a copy.
+  if (!is_free) {
+    std::unique_ptr<char, decltype(&free)> buffer(static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, extent_bytes)),
+                                                  &free);
+    // The pages past the end of the old file have never been written, they are not copied.
+    size_t size = 0;
+    while (size < extent_bytes) {
+      const ssize_t n = pread(from_fd, buffer.get() + size, extent_bytes - size, offset + size);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n < 0) {
+        LOG_DEBUG("I/O error while reading extent %zu", extent);
+        return false;
+      }
+      if (n == 0) {
+        break;
+      }
+      size += n;
+    }
+    for (size_t written = 0; written < size;) {
+      const ssize_t n = pwrite(to_fd, buffer.get() + written, size - written, offset + written);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        LOG_DEBUG("I/O error while writing extent %zu", extent);
+        return false;
+      }
+      written += n;
+    }
+    if (fdatasync(to_fd) != 0) {
+      LOG_DEBUG("I/O error while syncing extent %zu", extent);
+      return false;
+    }
+  }
+  {
+    std::scoped_lock tier_lock(tier_latch_);
+    if (tiers_.size() <= extent) {
+      tiers_.resize(extent + 1, StorageTier::PERFORMANCE);
+    }
+    const StorageTier old_tier = tiers_[extent];
+    tiers_[extent] = tier;
+    if (!SaveTierMap()) {
+      tiers_[extent] = old_tier;
+      return false;
+    }
+  }
+  extent_lock.unlock();
+  // Nothing reads the old copy any more. Its blocks go back to the file system, the file keeps its size so that the
+  // other extents stay where they are.
+#ifdef FALLOC_FL_PUNCH_HOLE
+  if (fallocate(from_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, extent_bytes) != 0) {
+    LOG_DEBUG("can't free the old copy of extent %zu (%s)", extent, strerror(errno));
+  }
+#endif
+  num_migrations_++;
+  return true;
+}
+
+void DiskManager::LoadTierMap() {
+  std::ifstream map_io(tier_name_, std::ios::binary | std::ios::in);
+  uint64_t header[2];
+  if (!map_io.read(reinterpret_cast<char *>(header), sizeof(header)) || header[0] != TIER_MAP_MAGIC) {
+    return;
+  }
+  std::vector<StorageTier> tiers(header[1]);
+  if (!map_io.read(reinterpret_cast<char *>(tiers.data()), tiers.size() * sizeof(StorageTier))) {
+    LOG_DEBUG("Ignoring a truncated tier map");
+    return;
+  }
+  std::scoped_lock tier_lock(tier_latch_);
+  tiers_ = std::move(tiers);
+}
+
+bool DiskManager::SaveTierMap() {
+  // The old copy of an extent is only freed once the map that points away from it is durable.
+  const uint64_t header[2] = {TIER_MAP_MAGIC, tiers_.size()};
+  std::vector<char> data(sizeof(header) + tiers_.size() * sizeof(StorageTier));
+  memcpy(data.data(), header, sizeof(header));
+  memcpy(data.data() + sizeof(header), tiers_.data(), tiers_.size() * sizeof(StorageTier));
+  if (!ReplaceFileDurably(tier_name_, data.data(), data.size())) {
+    LOG_DEBUG("I/O error while writing the tier map");
+    return false;
+  }
+  return true;
+}
+
+void DiskManager::RunMigrations() {
+  std::unique_lock lock(migration_thread_latch_);
+  while (!migration_cv_.wait_for(lock, tier_migration_interval, [this] { return stop_migrations_; })) {
+    lock.unlock();
+    MigrateExtents();
+    lock.lock();
+  }
+}
+
+void DiskManager::StopMigrations() {
+  {
+    std::scoped_lock lock(migration_thread_latch_);
+    stop_migrations_ = true;
+  }
+  migration_cv_.notify_all();
+  if (migration_thread_.joinable()) {
+    migration_thread_.join();
+  }
+}
+
+void DiskManager::LoadFreeSpaceMap() {
+  std::ifstream map_io(map_name_, std::ios::binary | std::ios::in);
+  uint64_t header[2];
+  if (map_io.read(reinterpret_cast<char *>(header), sizeof(header)) && header[0] == FREE_SPACE_MAP_MAGIC) {
+    std::vector<uint64_t> extent_pages(header[1]);
+    std::vector<ExtentKind> extent_kinds(header[1]);
+    map_io.read(reinterpret_cast<char *>(extent_pages.data()), extent_pages.size() * sizeof(uint64_t));
+    map_io.read(reinterpret_cast<char *>(extent_kinds.data()), extent_kinds.size() * sizeof(ExtentKind));
+    if (map_io) {
+      extent_pages_ = std::move(extent_pages);
+      extent_kinds_ = std::move(extent_kinds);
+    } else {
+      LOG_DEBUG("Ignoring a truncated free space map");
+    }
+  }
+
+  next_page_id_ = 0;
+  for (size_t extent = 0; extent < extent_pages_.size(); extent++) {
+    if (extent_pages_[extent] == 0) {
+      extent_kinds_[extent] = ExtentKind::FREE;
+      free_extents_.insert(extent);
+    } else {
+      next_page_id_ = static_cast<page_id_t>((extent + 1) * EXTENT_SIZE - __builtin_clzll(extent_pages_[extent]));
+    }
+  }
+  // Pages written after the map was saved may hold data, so they must not be handed out again.
+  const page_id_t num_pages = GetNumPagesOnDisk();
+  for (page_id_t page_id = static_cast<page_id_t>(extent_pages_.size() * EXTENT_SIZE); page_id < num_pages;
+       page_id++) {
+    const size_t extent = page_id / EXTENT_SIZE;
+    if (extent >= extent_pages_.size()) {
+      ClaimExtent(extent, ExtentKind::SHARED);
+    }
+    TakePage(extent, page_id % EXTENT_SIZE);
+  }
+}
+
+void DiskManager::ClaimExtent(size_t extent, ExtentKind kind) {
+  for (size_t i = extent_pages_.size(); i <= extent; i++) {
+    extent_pages_.push_back(0);
+    extent_kinds_.push_back(ExtentKind::FREE);
+    free_extents_.insert(i);
+  }
+  BUSTUB_ASSERT(extent_kinds_[extent] == ExtentKind::FREE, "Only free extents can be claimed.");
+  free_extents_.erase(extent);
+  extent_kinds_[extent] = kind;
+  map_dirty_ = true;
+}
+
+size_t DiskManager::OpenExtent(ExtentKind kind) {
+  size_t extent = extent_pages_.size();
+  for (size_t free_extent : free_extents_) {
+    if (!IsExtentMapped(free_extent)) {
+      extent = free_extent;
+      break;
+    }
+  }
+  while (IsExtentMapped(extent)) {
+    extent++;
+  }
+  ClaimExtent(extent, kind);
+  return extent;
+}
+
+page_id_t DiskManager::TakePage(size_t extent, int offset) {
+  extent_pages_[extent] |= uint64_t{1} << offset;
+  map_dirty_ = true;
+  map_unsaved_allocations_ = true;
+  const auto page_id = static_cast<page_id_t>(extent * EXTENT_SIZE + offset);
+  if (page_id >= next_page_id_) {
+    next_page_id_ = page_id + 1;
+  }
+  return page_id;
+}
+
+void DiskManager::LoadPageSlots() {
+  std::scoped_lock slot_lock(slot_latch_);
+  const int64_t file_size = GetFileSize(file_name_);
+  off_t offset = 0;
+  while (offset + static_cast<off_t>(sizeof(SlotHeader)) <= file_size) {
+    SlotHeader header;
+    if (pread(db_fd_, &header, sizeof(header), offset) != sizeof(header)) {
+      LOG_DEBUG("I/O error while reading the slot headers");
+      break;
+    }
+    const off_t slot_size = static_cast<off_t>(header.num_units_) * COMPRESSED_SLOT_SIZE;
+    if (header.magic_ != PAGE_SLOT_MAGIC || header.page_id_ < 0 || header.num_units_ == 0 ||
+        header.num_units_ > MAX_SLOT_UNITS || sizeof(header) + header.data_size_ > static_cast<size_t>(slot_size)) {
+      // Never written, e.g. behind a torn slot. It is reused as a slot of one unit.
+      free_slots_[1].push_back(offset);
+      offset += COMPRESSED_SLOT_SIZE;
+      continue;
+    }
+    if (offset + slot_size > file_size) {
+      // The last write was torn by a crash, so the previous version of the page is used.
+      break;
+    }
+    if (static_cast<size_t>(header.page_id_) >= page_slots_.size()) {
+      page_slots_.resize(header.page_id_ + 1);
+    }
+    PageSlot &slot = page_slots_[header.page_id_];
+    if (slot.write_seq_ < header.write_seq_) {
+      if (slot.offset_ >= 0) {
+        free_slots_[slot.num_units_].push_back(slot.offset_);
+      }
+      slot = {offset, header.write_seq_, header.num_units_};
+    } else {
+      free_slots_[header.num_units_].push_back(offset);
+    }
+    next_write_seq_ = std::max(next_write_seq_, header.write_seq_ + 1);
+    offset += slot_size;
+  }
+  slots_end_ = offset;
+}
+
+off_t DiskManager::TakeSlot(uint8_t num_units) {
+  std::vector<off_t> &free_slots = free_slots_[num_units];
+  if (!free_slots.empty()) {
+    const off_t offset = free_slots.back();
+    free_slots.pop_back();
+    return offset;
+  }
+  const off_t offset = slots_end_;
+  slots_end_ += static_cast<off_t>(num_units) * COMPRESSED_SLOT_SIZE;
+  return offset;
+}
+
+void DiskManager::WriteCompressedPage(page_id_t page_id, const char *page_data) {
+  char *buffer = GetSlotBuffer();
+  // Only compress pages into slots that are smaller than the page.
+  const size_t max_size = (MAX_SLOT_UNITS - 1) * COMPRESSED_SLOT_SIZE - sizeof(SlotHeader);
+  size_t data_size = LzCompressor::Compress(page_data, PAGE_SIZE, buffer + sizeof(SlotHeader), max_size);
+  const bool compressed = data_size != 0;
+  if (!compressed) {
+    memcpy(buffer + sizeof(SlotHeader), page_data, PAGE_SIZE);
+    data_size = PAGE_SIZE;
+  }
+  const auto num_units =
+      static_cast<uint8_t>((sizeof(SlotHeader) + data_size + COMPRESSED_SLOT_SIZE - 1) / COMPRESSED_SLOT_SIZE);
+  const size_t slot_size = static_cast<size_t>(num_units) * COMPRESSED_SLOT_SIZE;
+  memset(buffer + sizeof(SlotHeader) + data_size, 0, slot_size - sizeof(SlotHeader) - data_size);
+
+  SlotHeader header{PAGE_SLOT_MAGIC, page_id, 0, static_cast<uint16_t>(data_size), num_units, compressed, 0};
+  off_t offset;
+  {
+    std::scoped_lock slot_lock(slot_latch_);
+    header.write_seq_ = next_write_seq_++;
+    offset = TakeSlot(num_units);
+  }
+  memcpy(buffer, &header, sizeof(header));
+
+  num_writes_ += 1;
+  size_t write_count = 0;
+  while (write_count < slot_size) {
+    ssize_t n = pwrite(db_fd_, buffer + write_count, slot_size - write_count, offset + write_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      std::scoped_lock slot_lock(slot_latch_);
+      free_slots_[num_units].push_back(offset);
+      return;
+    }
+    write_count += n;
+  }
+
+  {
+    std::scoped_lock slot_lock(slot_latch_);
+    if (static_cast<size_t>(page_id) >= page_slots_.size()) {
+      page_slots_.resize(page_id + 1);
+    }
+    PageSlot &slot = page_slots_[page_id];
+    // Of two concurrent writes of a page, the one that started last wins.
+    if (slot.write_seq_ > header.write_seq_) {
+      free_slots_[num_units].push_back(offset);
+      return;
+    }
+    if (slot.offset_ >= 0) {
+      free_slots_[slot.num_units_].push_back(slot.offset_);
+    }
+    slot = {offset, header.write_seq_, num_units};
+  }
+  RecordChecksum(page_id, ComputeChecksum(page_id, page_data));
+}
+
+void DiskManager::ReadCompressedPage(page_id_t page_id, char *page_data) {
+  char *buffer = GetSlotBuffer();
+  while (true) {
+    PageSlot slot;
+    {
+      std::scoped_lock slot_lock(slot_latch_);
+      if (page_id >= 0 && static_cast<size_t>(page_id) < page_slots_.size()) {
+        slot = page_slots_[page_id];
+      }
+    }
+    if (slot.offset_ < 0) {
+      memset(page_data, 0, PAGE_SIZE);
+      return;
+    }
+    const size_t slot_size = static_cast<size_t>(slot.num_units_) * COMPRESSED_SLOT_SIZE;
+    size_t read_count = 0;
+    while (read_count < slot_size) {
+      ssize_t n = pread(db_fd_, buffer + read_count, slot_size - read_count, slot.offset_ + read_count);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        LOG_DEBUG("I/O error while reading");
+        memset(page_data, 0, PAGE_SIZE);
+        return;
+      }
+      read_count += n;
+    }
+    {
+      // A page that was rewritten or deallocated during the read may have had its slot reused, so it is read again.
+      std::scoped_lock slot_lock(slot_latch_);
+      if (page_slots_[page_id].offset_ != slot.offset_ || page_slots_[page_id].write_seq_ != slot.write_seq_) {
+        continue;
+      }
+    }
+    SlotHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    const char *data = buffer + sizeof(SlotHeader);
+    if (header.page_id_ != page_id || header.write_seq_ != slot.write_seq_ ||
+        sizeof(header) + header.data_size_ > slot_size) {
+      LOG_DEBUG("Corrupt slot header of page %d", page_id);
+      memset(page_data, 0, PAGE_SIZE);
+    } else if (header.compressed_ == 0) {
+      memcpy(page_data, data, PAGE_SIZE);
+    } else if (LzCompressor::Decompress(data, header.data_size_, page_data, PAGE_SIZE) != PAGE_SIZE) {
+      LOG_DEBUG("Corrupt compressed data of page %d", page_id);
+      memset(page_data, 0, PAGE_SIZE);
+    }
+    return;
+  }
+}
+
+bool DiskManager::IsExtentMapped(size_t extent) {
+  // Extents never cross segments, so an extent is mapped iff its first page is.
+  return GetMappedPage(static_cast<page_id_t>(extent * EXTENT_SIZE)) != nullptr;
+}
+
+void DiskManager::StartAsyncIO() {
+  auto io_uring = std::make_unique<IoUring>(IO_URING_QUEUE_DEPTH);
+  if (io_uring->IsAvailable()) {
+    io_uring_ = std::move(io_uring);
+  }
+}
+
+std::future<bool> DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  SaveAllocations();
+  // The bounce buffer of unaligned direct I/O cannot be shared with I/Os in flight, so those are written right away.
+  const int fd = io_uring_ == nullptr || GetMappedPage(page_id) != nullptr ? -1 : GetSegmentFd(page_id, true);
+  if (fd < 0 || !CanUseBuffer(page_data)) {
+    WritePage(page_id, page_data);
+    std::promise<bool> done;
+    done.set_value(true);
+    return done.get_future();
+  }
+  num_writes_ += 1;
+  const uint32_t checksum = ComputeChecksum(page_id, page_data);
+  return io_uring_->Write(fd, page_data, PAGE_SIZE, GetSegmentOffset(page_id),
+                          [this, page_id, checksum](int result) {
+                            if (result != PAGE_SIZE) {
+                              LOG_DEBUG("I/O error while writing");
+                              return false;
+                            }
+                            RecordChecksum(page_id, checksum);
+                            return true;
+                          });
+}
+
+std::future<bool> DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  const int fd = io_uring_ == nullptr ? -1 : GetSegmentFd(page_id, false);
+  if (fd < 0 || !CanUseBuffer(page_data)) {
+    std::promise<bool> done;
+    done.set_value(ReadPage(page_id, page_data));
+    return done.get_future();
+  }
+  return io_uring_->Read(fd, page_data, PAGE_SIZE, GetSegmentOffset(page_id),
+                         [this, page_id, page_data](int result) {
+                           if (result < 0) {
+                             LOG_DEBUG("I/O error while reading");
+                             return false;
+                           }
+                           // if file ends before reading PAGE_SIZE
+                           if (result < PAGE_SIZE) {
+                             LOG_DEBUG("Read less than a page");
+                             memset(page_data + result, 0, PAGE_SIZE - result);
+                           }
+                           return VerifyChecksum(page_id, page_data);
+                         });
+}
+
+bool DiskManager::CanUseBuffer(const char *page_data) const {
+  return io_mode_ == DiskIOMode::BUFFERED || IsDirectIOAligned(page_data);
+}
+
+void DiskManager::OpenChecksumFile(bool db_exists) {
+  const std::string checksum_name = file_name_.substr(0, file_name_.find('.')) + ".crc";
+  checksum_fd_ = open(checksum_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (checksum_fd_ < 0) {
+    LOG_DEBUG("can't open checksum file %s (%s)", checksum_name.c_str(), strerror(errno));
+    return;
+  }
+  if (!db_exists) {
+    if (ftruncate(checksum_fd_, 0) != 0) {
+      LOG_DEBUG("I/O error while truncating the checksum file");
+    }
+    return;
+  }
+  struct stat stat_buf;
+  if (fstat(checksum_fd_, &stat_buf) != 0) {
+    return;
+  }
+  checksums_.resize(stat_buf.st_size / sizeof(PageChecksums));
+  const size_t len = checksums_.size() * sizeof(PageChecksums);
+  if (pread(checksum_fd_, checksums_.data(), len, 0) != static_cast<ssize_t>(len)) {
+    LOG_DEBUG("I/O error while reading the checksum file");
+    checksums_.clear();
+  }
+}
+
+uint32_t DiskManager::ComputeChecksum(page_id_t page_id, const char *page_data) {
+  uint32_t checksum = Crc32c::Value(reinterpret_cast<const char *>(&page_id), sizeof(page_id));
+  checksum = Crc32c::Extend(checksum, page_data, PAGE_SIZE);
+  // 0 marks pages without a checksum.
+  return checksum == 0 ? 1 : checksum;
+}
+
+void DiskManager::RecordChecksum(page_id_t page_id, uint32_t checksum) {
+  PageChecksums checksums;
+  {
+    std::unique_lock checksum_lock(checksum_latch_);
+    if (static_cast<size_t>(page_id) >= checksums_.size()) {
+      checksums_.resize(page_id + 1);
+    }
+    // Rewriting the same data must not lose the checksum of the version before it.
+    if (checksums_[page_id].current_ != checksum) {
+      checksums_[page_id] = {checksum, checksums_[page_id].current_};
+    }
+    checksums = checksums_[page_id];
+  }
+  // Without a sync in between, the disk may still get this before the page. The previous checksum keeps the old page
+  // valid then.
+  if (checksum_fd_ >= 0 &&
+      pwrite(checksum_fd_, &checksums, sizeof(checksums), static_cast<off_t>(page_id) * sizeof(checksums)) !=
+          sizeof(checksums)) {
+    LOG_DEBUG("I/O error while writing the checksum of page %d", page_id);
+  }
+}
+
+bool DiskManager::VerifyChecksum(page_id_t page_id, const char *page_data) {
+  if (verify_checksums_ && !MatchesChecksum(page_id, page_data)) {
+    LOG_DEBUG("Checksum mismatch on page %d", page_id);
+    num_checksum_failures_++;
+    return false;
+  }
+  return true;
+}
+
+bool DiskManager::MatchesChecksum(page_id_t page_id, const char *page_data) {
+  PageChecksums checksums{0, 0};
+  {
+    std::shared_lock checksum_lock(checksum_latch_);
+    if (static_cast<size_t>(page_id) < checksums_.size()) {
+      checksums = checksums_[page_id];
+    }
+  }
+  if (checksums.current_ == 0) {
+    return true;
+  }
+  const uint32_t checksum = ComputeChecksum(page_id, page_data);
+  return checksum == checksums.current_ || checksum == checksums.previous_;
 }
 
 }  // namespace bustub
@@ -0,0 +1,187 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring.cpp
+//
+// Identification: src/storage/disk/io_uring.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/io_uring.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+int IoUringSetup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+template <class T>
+T *RingField(void *ring, unsigned offset) {
+  return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+}  // namespace
+
+IoUring::IoUring(unsigned queue_depth) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = IoUringSetup(queue_depth, &params);
+  if (ring_fd < 0) {
+    LOG_DEBUG("io_uring is not available (%s).", strerror(errno));
+    return;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                  IORING_OFF_SQ_RING);
+  cq_ring_ = single_mmap ? sq_ring_
+                         : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                                IORING_OFF_CQ_RING);
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+    LOG_DEBUG("Could not map the io_uring queues.");
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (!single_mmap && cq_ring_ != MAP_FAILED) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    close(ring_fd);
+    return;
+  }
+
+  sq_tail_ = RingField<unsigned>(sq_ring_, params.sq_off.tail);
+  sq_mask_ = RingField<unsigned>(sq_ring_, params.sq_off.ring_mask);
+  sq_array_ = RingField<unsigned>(sq_ring_, params.sq_off.array);
+  cq_head_ = RingField<unsigned>(cq_ring_, params.cq_off.head);
+  cq_tail_ = RingField<unsigned>(cq_ring_, params.cq_off.tail);
+  cq_mask_ = RingField<unsigned>(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = RingField<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+  // The kernel may round the queue up, but never beyond what the completion queue can hold.
+  queue_depth_ = std::min(params.sq_entries, params.cq_entries);
+  ring_fd_ = ring_fd;
+  completion_thread_ = new std::thread(&IoUring::RunCompletions, this);
+}
+
+IoUring::~IoUring() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  // The NOP tells the completion thread to finish once nothing is in flight anymore.
+  Submit(IORING_OP_NOP, -1, nullptr, 0, 0, nullptr);
+  completion_thread_->join();
+  delete completion_thread_;
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  munmap(sq_ring_, sq_ring_size_);
+  close(ring_fd_);
+}
+
+std::future<bool> IoUring::Read(int fd, char *data, unsigned len, uint64_t offset, completion_fn complete) {
+  auto *request = new Request{std::promise<bool>(), std::move(complete)};
+  std::future<bool> future = request->promise.get_future();
+  Submit(IORING_OP_READ, fd, data, len, offset, request);
+  return future;
+}
+
+std::future<bool> IoUring::Write(int fd, const char *data, unsigned len, uint64_t offset, completion_fn complete) {
+  auto *request = new Request{std::promise<bool>(), std::move(complete)};
+  std::future<bool> future = request->promise.get_future();
+  Submit(IORING_OP_WRITE, fd, data, len, offset, request);
+  return future;
+}
+
+void IoUring::Submit(uint8_t opcode, int fd, const char *data, unsigned len, uint64_t offset, Request *request) {
+  std::unique_lock<std::mutex> lock(latch_);
+  slot_cv_.wait(lock, [&] { return in_flight_ < queue_depth_; });
+  in_flight_++;
+
+  // Without SQPOLL, the kernel consumes the entry during io_uring_enter, so the slot is free again once it returns.
+  const unsigned tail = *sq_tail_;
+  const unsigned index = tail & *sq_mask_;
+  io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(data);
+  sqe->len = len;
+  sqe->off = offset;
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+  while (IoUringEnter(ring_fd_, 1, 0, 0) < 0) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      // The entry stays queued and goes in with the next successful enter.
+      LOG_DEBUG("io_uring_enter failed (%s).", strerror(errno));
+      break;
+    }
+  }
+}
+
+void IoUring::RunCompletions() {
+  bool stopping = false;
+  while (true) {
+    unsigned head = __atomic_load_n(cq_head_, __ATOMIC_RELAXED);
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      {
+        std::lock_guard<std::mutex> guard(latch_);
+        if (stopping && in_flight_ == 0) {
+          return;
+        }
+      }
+      IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+      continue;
+    }
+
+    const io_uring_cqe *cqe = static_cast<io_uring_cqe *>(cqes_) + (head & *cq_mask_);
+    auto *request = reinterpret_cast<Request *>(cqe->user_data);
+    const int result = cqe->res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    if (request == nullptr) {
+      stopping = true;
+    } else {
+      request->promise.set_value(request->complete(result));
+      delete request;
+    }
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      in_flight_--;
+    }
+    slot_cv_.notify_one();
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,216 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// spill_file.cpp
+//
+// Identification: src/storage/disk/spill_file.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/spill_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+/** Tells apart the files of all the managers of the process. */
+std::atomic<uint64_t> next_spill_file{0};
+
+}  // namespace
+
+SpillFile::~SpillFile() {
+  if (ahead_.valid()) {
+    ahead_.wait();
+  }
+  close(fd_);
+  if (write_buffer_ != nullptr) {
+    manager_->FreeBuffer(write_buffer_, write_block_size_);
+  }
+  if (read_buffer_ != nullptr) {
+    manager_->FreeBuffer(read_buffer_, read_block_size_);
+  }
+  if (ahead_buffer_ != nullptr) {
+    manager_->FreeBuffer(ahead_buffer_, SPILL_BLOCK_SIZE);
+  }
+}
+
+void SpillFile::Append(const char *data, size_t size) {
+  while (size > 0) {
+    if (write_buffer_ == nullptr) {
+      write_buffer_ = manager_->AllocateBuffer(&write_block_size_, true);
+    }
+    const size_t used = size_ - written_;
+    const size_t bytes = std::min(size, write_block_size_ - used);
+    memcpy(write_buffer_ + used, data, bytes);
+    size_ += bytes;
+    data += bytes;
+    size -= bytes;
+    if (used + bytes == write_block_size_) {
+      WriteBlock();
+    }
+  }
+}
+
+void SpillFile::Finish() {
+  if (size_ > written_) {
+    WriteBlock();
+    // The last block that was read may have grown.
+    if (ahead_.valid()) {
+      ahead_.wait();
+    }
+    read_block_ = UINT64_MAX;
+    ahead_block_ = UINT64_MAX;
+  }
+  if (write_buffer_ != nullptr) {
+    manager_->FreeBuffer(write_buffer_, write_block_size_);
+    write_buffer_ = nullptr;
+  }
+}
+
+bool SpillFile::Read(uint64_t offset, char *data, size_t size) {
+  if (offset + size > size_) {
+    return false;
+  }
+  Finish();
+  if (read_buffer_ == nullptr) {
+    read_buffer_ = manager_->AllocateBuffer(&read_block_size_, true);
+  }
+  while (size > 0) {
+    LoadBlock(offset / read_block_size_);
+    const size_t in_block = offset % read_block_size_;
+    const size_t bytes = std::min(size, read_bytes_ - in_block);
+    memcpy(data, read_buffer_ + in_block, bytes);
+    offset += bytes;
+    data += bytes;
+    size -= bytes;
+  }
+  return true;
+}
+
+void SpillFile::WriteBlock() {
+  const char *data = write_buffer_;
+  size_t size = size_ - written_;
+  while (size > 0) {
+    const ssize_t bytes = pwrite(fd_, data, size, static_cast<off_t>(written_));
+    if (bytes < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytes <= 0) {
+      throw Exception(std::string("Could not write a spill file: ") + strerror(errno));
+    }
+    data += bytes;
+    size -= bytes;
+    written_ += bytes;
+  }
+}
+
+void SpillFile::LoadBlock(uint64_t block) {
+  if (block == read_block_) {
+    return;
+  }
+  if (block == ahead_block_) {
+    read_bytes_ = ahead_.get();
+    std::swap(read_buffer_, ahead_buffer_);
+  } else {
+    // A read that jumped elsewhere, the block read ahead is of no use.
+    if (ahead_.valid()) {
+      ahead_.wait();
+      ahead_ = std::future<size_t>();
+    }
+    read_bytes_ = ReadBlock(block, read_buffer_);
+  }
+  ahead_block_ = UINT64_MAX;
+  read_block_ = block;
+  ReadAhead();
+}
+
+void SpillFile::ReadAhead() {
+  const uint64_t next = read_block_ + 1;
+  if (next * read_block_size_ >= written_ || read_block_size_ != SPILL_BLOCK_SIZE) {
+    return;
+  }
+  if (ahead_buffer_ == nullptr) {
+    size_t size;
+    ahead_buffer_ = manager_->AllocateBuffer(&size, false);
+    if (ahead_buffer_ == nullptr) {
+      return;
+    }
+  }
+  ahead_block_ = next;
+  ahead_ = std::async(std::launch::async, [this, next, buffer = ahead_buffer_] { return ReadBlock(next, buffer); });
+}
+
+size_t SpillFile::ReadBlock(uint64_t block, char *buffer) {
+  const uint64_t begin = block * read_block_size_;
+  const size_t size = std::min<uint64_t>(read_block_size_, written_ - begin);
+  size_t read = 0;
+  while (read < size) {
+    const ssize_t bytes = pread(fd_, buffer + read, size - read, static_cast<off_t>(begin + read));
+    if (bytes < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytes <= 0) {
+      throw Exception(std::string("Could not read a spill file: ") + strerror(errno));
+    }
+    read += bytes;
+  }
+  return read;
+}
+
+SpillFileManager::SpillFileManager(std::string directory, size_t memory_budget)
+    : directory_(std::move(directory)), memory_budget_(memory_budget) {
+  if (directory_.empty()) {
+    directory_ = std::filesystem::temp_directory_path().string();
+  }
+}
+
+std::unique_ptr<SpillFile> SpillFileManager::CreateFile() {
+  const std::string name = directory_ + "/bustub_spill." + std::to_string(getpid()) + "." +
+                           std::to_string(next_spill_file.fetch_add(1));
+  const int fd = open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    throw Exception("Could not create the spill file " + name + ": " + strerror(errno));
+  }
+  // The open file keeps its data, which goes away once it is closed.
+  unlink(name.c_str());
+  return std::unique_ptr<SpillFile>(new SpillFile(this, fd));
+}
+
+char *SpillFileManager::AllocateBuffer(size_t *size, bool required) {
+  size_t used = memory_used_.load();
+  do {
+    const bool fits = used + SPILL_BLOCK_SIZE <= memory_budget_;
+    if (!fits && !required) {
+      return nullptr;
+    }
+    *size = fits ? SPILL_BLOCK_SIZE : PAGE_SIZE;
+  } while (!memory_used_.compare_exchange_weak(used, used + *size));
+  auto *buffer = static_cast<char *>(aligned_alloc(PAGE_SIZE, *size));
+  if (buffer == nullptr) {
+    memory_used_.fetch_sub(*size);
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "No memory for the buffer of a spill file.");
+  }
+  return buffer;
+}
+
+void SpillFileManager::FreeBuffer(char *buffer, size_t size) {
+  free(buffer);
+  memory_used_.fetch_sub(size);
+}
+
+}  // namespace bustub
@@ -0,0 +1,417 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree.cpp
+//
+// Identification: src/storage/index/b_plus_tree.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/macros.h"
+#include "common/rid.h"
+#include "storage/index/b_plus_tree.h"
+
+namespace bustub {
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                          int leaf_max_size, int internal_max_size)
+    : index_name_(std::move(name)),
+      buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      leaf_max_size_(leaf_max_size),
+      internal_max_size_(internal_max_size) {
+  WritePageGuard header_guard = NewPage(&header_page_id_);
+  header_guard.AsMut<BPlusTreeHeaderPage>()->root_page_id_ = INVALID_PAGE_ID;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsEmpty() { return GetRootPageId() == INVALID_PAGE_ID; }
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::GetRootPageId() {
+  ReadPageGuard header_guard = buffer_pool_manager_->FetchPageRead(header_page_id_);
+  return header_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+}
+
+/*****************************************************************************
+ * UTILITIES
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(const BPlusTreePage *page, Operation operation, bool is_root) {
+  if (operation == Operation::INSERT) {
+    return page->GetSize() < page->GetMaxSize();
+  }
+  if (is_root) {
+    // an empty root leaf empties the tree, a root with one child gives way to it
+    return page->GetSize() > (page->IsLeafPage() ? 1 : 2);
+  }
+  return page->GetSize() > page->GetMinSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+WritePageGuard BPLUSTREE_TYPE::NewPage(page_id_t *page_id) {
+  WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id).UpgradeWrite();
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for a new B+ tree page.");
+  }
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::FindLeafRead(const KeyType *key) {
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(header_page_id_);
+  page_id_t page_id = guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return ReadPageGuard();
+  }
+  for (;;) {
+    // the child is latched before its parent is let go of
+    ReadPageGuard child_guard = buffer_pool_manager_->FetchPageRead(page_id);
+    guard = std::move(child_guard);
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      return guard;
+    }
+    auto internal = guard.As<InternalPage>();
+    page_id = key == nullptr ? internal->ValueAt(0) : internal->Lookup(*key, comparator_);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+template <class LeafOp>
+bool BPLUSTREE_TYPE::TryOptimistic(const KeyType &key, Operation operation, LeafOp &&leaf_op) {
+  ReadPageGuard parent_guard = buffer_pool_manager_->FetchPageRead(header_page_id_);
+  page_id_t page_id = parent_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  for (bool is_root = true;; is_root = false) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      // The parent stays read latched, so the leaf can not split or merge before it is write latched.
+      guard.Drop();
+      WritePageGuard leaf_guard = buffer_pool_manager_->FetchPageWrite(page_id);
+      parent_guard.Drop();
+      if (!IsSafe(leaf_guard.As<BPlusTreePage>(), operation, is_root)) {
+        return false;
+      }
+      leaf_op(leaf_guard.AsMut<LeafPage>());
+      return true;
+    }
+    page_id = guard.As<InternalPage>()->Lookup(key, comparator_);
+    parent_guard = std::move(guard);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FindLeafWrite(const KeyType &key, Operation operation, Context *context) {
+  page_id_t page_id = context->root_page_id_;
+  for (;;) {
+    context->write_set_.push_back(buffer_pool_manager_->FetchPageWrite(page_id));
+    auto page = context->write_set_.back().As<BPlusTreePage>();
+    if (IsSafe(page, operation, context->IsRootPage(page_id))) {
+      context->header_guard_.Drop();
+      while (context->write_set_.size() > 1) {
+        context->write_set_.pop_front();
+      }
+    }
+    if (page->IsLeafPage()) {
+      return;
+    }
+    page_id = reinterpret_cast<const InternalPage *>(page)->Lookup(key, comparator_);
+  }
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
+  ReadPageGuard leaf_guard = FindLeafRead(&key);
+  if (!leaf_guard.IsValid()) {
+    return false;
+  }
+  ValueType value;
+  if (!leaf_guard.As<LeafPage>()->Lookup(key, &value, comparator_)) {
+    return false;
+  }
+  result->push_back(value);
+  return true;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  bool inserted = false;
+  if (TryOptimistic(key, Operation::INSERT, [&](LeafPage *leaf) {
+        const int size = leaf->GetSize();
+        inserted = leaf->Insert(key, value, comparator_) != size;
+      })) {
+    return inserted;
+  }
+
+  Context context;
+  context.header_guard_ = buffer_pool_manager_->FetchPageWrite(header_page_id_);
+  context.root_page_id_ = context.header_guard_.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (context.root_page_id_ == INVALID_PAGE_ID) {
+    page_id_t root_page_id;
+    WritePageGuard root_guard = NewPage(&root_page_id);
+    auto root = root_guard.AsMut<LeafPage>();
+    root->Init(leaf_max_size_);
+    root->Insert(key, value, comparator_);
+    context.header_guard_.AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page_id;
+    return true;
+  }
+  FindLeafWrite(key, Operation::INSERT, &context);
+
+  auto leaf = context.write_set_.back().AsMut<LeafPage>();
+  const int size = leaf->GetSize();
+  if (leaf->Insert(key, value, comparator_) == size) {
+    return false;
+  }
+  if (leaf->GetSize() > leaf->GetMaxSize()) {
+    page_id_t new_page_id;
+    WritePageGuard new_guard = NewPage(&new_page_id);
+    auto new_leaf = new_guard.AsMut<LeafPage>();
+    new_leaf->Init(leaf_max_size_);
+    leaf->MoveHalfTo(new_leaf);
+    new_leaf->SetNextPageId(leaf->GetNextPageId());
+    leaf->SetNextPageId(new_page_id);
+    const KeyType separator = new_leaf->KeyAt(0);
+    new_guard.Drop();
+    InsertIntoParent(&context, separator, new_page_id);
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParent(Context *context, const KeyType &key, page_id_t right_page_id) {
+  const page_id_t left_page_id = context->write_set_.back().PageId();
+  context->write_set_.pop_back();
+  if (context->write_set_.empty()) {
+    // the root split, and the header page is still latched as it was not safe
+    BUSTUB_ASSERT(context->IsRootPage(left_page_id), "Only the root has no latched parent.");
+    page_id_t root_page_id;
+    WritePageGuard root_guard = NewPage(&root_page_id);
+    auto root = root_guard.AsMut<InternalPage>();
+    root->Init(internal_max_size_);
+    root->PopulateNewRoot(left_page_id, key, right_page_id);
+    context->header_guard_.AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page_id;
+    return;
+  }
+
+  auto parent = context->write_set_.back().AsMut<InternalPage>();
+  if (parent->InsertNodeAfter(left_page_id, key, right_page_id) > parent->GetMaxSize()) {
+    page_id_t new_page_id;
+    WritePageGuard new_guard = NewPage(&new_page_id);
+    auto new_internal = new_guard.AsMut<InternalPage>();
+    new_internal->Init(internal_max_size_);
+    parent->MoveHalfTo(new_internal);
+    const KeyType separator = new_internal->KeyAt(0);
+    new_guard.Drop();
+    InsertIntoParent(context, separator, new_page_id);
+  }
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  if (TryOptimistic(key, Operation::REMOVE, [&](LeafPage *leaf) { leaf->RemoveAndDeleteRecord(key, comparator_); })) {
+    return;
+  }
+
+  Context context;
+  context.header_guard_ = buffer_pool_manager_->FetchPageWrite(header_page_id_);
+  context.root_page_id_ = context.header_guard_.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (context.root_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  FindLeafWrite(key, Operation::REMOVE, &context);
+
+  auto leaf = context.write_set_.back().AsMut<LeafPage>();
+  const int size = leaf->GetSize();
+  if (leaf->RemoveAndDeleteRecord(key, comparator_) != size) {
+    HandleUnderflow(&context);
+  }
+  // Deleting a page waits for the flusher to let go of it, which may wait for a latch of the context.
+  context.header_guard_.Drop();
+  context.write_set_.clear();
+  for (page_id_t page_id : context.deleted_page_ids_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::HandleUnderflow(Context *context) {
+  WritePageGuard guard = std::move(context->write_set_.back());
+  context->write_set_.pop_back();
+  const page_id_t page_id = guard.PageId();
+  auto page = guard.As<BPlusTreePage>();
+
+  if (context->IsRootPage(page_id)) {
+    page_id_t new_root_page_id;
+    if (page->IsLeafPage() && page->GetSize() == 0) {
+      new_root_page_id = INVALID_PAGE_ID;
+    } else if (!page->IsLeafPage() && page->GetSize() == 1) {
+      new_root_page_id = reinterpret_cast<const InternalPage *>(page)->ValueAt(0);
+    } else {
+      return;
+    }
+    context->header_guard_.AsMut<BPlusTreeHeaderPage>()->root_page_id_ = new_root_page_id;
+    context->deleted_page_ids_.push_back(page_id);
+    return;
+  }
+  if (page->GetSize() >= page->GetMinSize()) {
+    return;
+  }
+
+  // The page was not safe, so its parent is latched.
+  auto parent = context->write_set_.back().AsMut<InternalPage>();
+  const int index = parent->ValueIndex(page_id);
+  const bool from_left = index > 0;
+  const int right_index = from_left ? index : index + 1;
+  WritePageGuard sibling_guard;
+  if (from_left) {
+    // Leaves are latched from left to right, like the iterators that follow their sibling links do. Nothing but
+    // readers can get to the page meanwhile, as its parent stays latched.
+    guard.Drop();
+    sibling_guard = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(index - 1));
+    guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  } else {
+    sibling_guard = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(index + 1));
+  }
+  WritePageGuard &left_guard = from_left ? sibling_guard : guard;
+  WritePageGuard &right_guard = from_left ? guard : sibling_guard;
+  auto left = left_guard.AsMut<BPlusTreePage>();
+  auto right = right_guard.AsMut<BPlusTreePage>();
+  const KeyType middle_key = parent->KeyAt(right_index);
+
+  if (left->GetSize() + right->GetSize() <= left->GetMaxSize()) {
+    // merge the right page into the left one
+    if (left->IsLeafPage()) {
+      reinterpret_cast<LeafPage *>(right)->MoveAllTo(reinterpret_cast<LeafPage *>(left));
+    } else {
+      reinterpret_cast<InternalPage *>(right)->MoveAllTo(reinterpret_cast<InternalPage *>(left), middle_key);
+    }
+    context->deleted_page_ids_.push_back(right_guard.PageId());
+    left_guard.Drop();
+    right_guard.Drop();
+    parent->Remove(right_index);
+    HandleUnderflow(context);
+    return;
+  }
+
+  // borrow a pair from the sibling
+  if (left->IsLeafPage()) {
+    auto left_leaf = reinterpret_cast<LeafPage *>(left);
+    auto right_leaf = reinterpret_cast<LeafPage *>(right);
+    if (from_left) {
+      left_leaf->MoveLastToFrontOf(right_leaf);
+    } else {
+      right_leaf->MoveFirstToEndOf(left_leaf);
+    }
+    parent->SetKeyAt(right_index, right_leaf->KeyAt(0));
+  } else {
+    auto left_internal = reinterpret_cast<InternalPage *>(left);
+    auto right_internal = reinterpret_cast<InternalPage *>(right);
+    parent->SetKeyAt(right_index, from_left ? left_internal->MoveLastToFrontOf(right_internal, middle_key)
+                                            : right_internal->MoveFirstToEndOf(left_internal, middle_key));
+  }
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(const std::vector<MappingType> &items) {
+  WritePageGuard header_guard = buffer_pool_manager_->FetchPageWrite(header_page_id_);
+  if (header_guard.As<BPlusTreeHeaderPage>()->root_page_id_ != INVALID_PAGE_ID) {
+    return false;
+  }
+  for (size_t i = 1; i < items.size(); i++) {
+    if (comparator_(items[i - 1].first, items[i].first) >= 0) {
+      return false;
+    }
+  }
+  if (items.empty()) {
+    return true;
+  }
+
+  // The pages of a level share its entries evenly, so that the last one does not underflow.
+  auto page_size = [](size_t num_entries, size_t max_size, size_t page_index) {
+    const size_t num_pages = (num_entries + max_size - 1) / max_size;
+    return num_entries / num_pages + (page_index < num_entries % num_pages ? 1 : 0);
+  };
+
+  // the first key and the page id of each page of the level being built
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  WritePageGuard prev_guard;
+  for (size_t begin = 0; begin < items.size();) {
+    const size_t size = page_size(items.size(), leaf_max_size_, level.size());
+    page_id_t page_id;
+    WritePageGuard guard = NewPage(&page_id);
+    auto leaf = guard.AsMut<LeafPage>();
+    leaf->Init(leaf_max_size_);
+    leaf->CopyNFrom(&items[begin], size);
+    if (prev_guard.IsValid()) {
+      prev_guard.AsMut<LeafPage>()->SetNextPageId(page_id);
+    }
+    level.emplace_back(items[begin].first, page_id);
+    prev_guard = std::move(guard);
+    begin += size;
+  }
+  prev_guard.Drop();
+
+  while (level.size() > 1) {
+    std::vector<std::pair<KeyType, page_id_t>> upper_level;
+    for (size_t begin = 0; begin < level.size();) {
+      const size_t size = page_size(level.size(), internal_max_size_, upper_level.size());
+      page_id_t page_id;
+      WritePageGuard guard = NewPage(&page_id);
+      auto internal = guard.AsMut<InternalPage>();
+      internal->Init(internal_max_size_);
+      internal->CopyNFrom(&level[begin], size);
+      upper_level.emplace_back(level[begin].first, page_id);
+      begin += size;
+    }
+    level = std::move(upper_level);
+  }
+  header_guard.AsMut<BPlusTreeHeaderPage>()->root_page_id_ = level[0].second;
+  return true;
+}
+
+/*****************************************************************************
+ * INDEX ITERATOR
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, FindLeafRead(nullptr), 0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
+  ReadPageGuard leaf_guard = FindLeafRead(&key);
+  if (!leaf_guard.IsValid()) {
+    return End();
+  }
+  const int index = leaf_guard.As<LeafPage>()->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(leaf_guard), index);
+}
+
+template class BPlusTree<GenericKey<4>, RID, GenericComparator<4>>;
+template class BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
+template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
+template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -0,0 +1,58 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_iterator.cpp
+//
+// Identification: src/storage/index/index_iterator.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cassert>
+#include <utility>
+
+#include "common/rid.h"
+#include "storage/index/index_iterator.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index)
+    : bpm_(bpm), guard_(std::move(guard)), index_(index) {
+  SkipExhaustedLeaves();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  index_++;
+  SkipExhaustedLeaves();
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (guard_.IsValid() && index_ >= guard_.As<LeafPage>()->GetSize()) {
+    const page_id_t next_page_id = guard_.As<LeafPage>()->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      guard_.Drop();
+    } else {
+      ReadPageGuard next_guard = bpm_->FetchPageRead(next_page_id);
+      guard_ = std::move(next_guard);
+    }
+    index_ = 0;
+  }
+}
+
+template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
+
+template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
+
+template class IndexIterator<GenericKey<16>, RID, GenericComparator<16>>;
+
+template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
+
+template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_normalizer.cpp
+//
+// Identification: src/storage/index/key_normalizer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/key_normalizer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+namespace {
+
+/** Appends an unsigned integer of some bytes, big-endian. */
+void AppendBigEndian(uint64_t bits, size_t num_bytes, std::string *key) {
+  for (size_t i = num_bytes; i > 0; i--) {
+    key->push_back(static_cast<char>(bits >> (8 * (i - 1))));
+  }
+}
+
+/** Appends a signed integer of some bytes, its sign bit flipped so that negative numbers come first. */
+void AppendSigned(int64_t value, size_t num_bytes, std::string *key) {
+  AppendBigEndian(static_cast<uint64_t>(value) ^ (uint64_t{1} << (8 * num_bytes - 1)), num_bytes, key);
+}
+
+}  // namespace
+
+void KeyNormalizer::Append(const Value &value, bool descending, std::string *key) {
+  const size_t begin = key->size();
+  if (value.IsNull()) {
+    key->push_back(0);
+  } else {
+    key->push_back(1);
+    switch (value.GetTypeId()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        AppendSigned(value.GetAs<int8_t>(), 1, key);
+        break;
+      case TypeId::SMALLINT:
+        AppendSigned(value.GetAs<int16_t>(), 2, key);
+        break;
+      case TypeId::INTEGER:
+        AppendSigned(value.GetAs<int32_t>(), 4, key);
+        break;
+      case TypeId::BIGINT:
+        AppendSigned(value.GetAs<int64_t>(), 8, key);
+        break;
+      case TypeId::TIMESTAMP:
+        AppendBigEndian(value.GetAs<uint64_t>(), 8, key);
+        break;
+      case TypeId::DECIMAL: {
+        const double real = value.GetAs<double>();
+        uint64_t bits;
+        std::memcpy(&bits, &real, sizeof(bits));
+        AppendBigEndian((bits >> 63) != 0 ? ~bits : bits ^ (uint64_t{1} << 63), 8, key);
+        break;
+      }
+      case TypeId::VARCHAR: {
+        const char *data = value.GetData();
+        size_t length = value.GetLength();
+        // the length counts the terminating zero byte
+        if (length > 0 && data[length - 1] == '\0') {
+          length--;
+        }
+        for (size_t i = 0; i < length; i++) {
+          key->push_back(data[i]);
+          if (data[i] == '\0') {
+            key->push_back(static_cast<char>(0xFF));
+          }
+        }
+        key->append(2, '\0');
+        break;
+      }
+      default:
+        UNREACHABLE("Unsupported key type.");
+    }
+  }
+  if (descending) {
+    for (size_t i = begin; i < key->size(); i++) {
+      (*key)[i] = static_cast<char>(~(*key)[i]);
+    }
+  }
+}
+
+size_t KeyNormalizer::GetMaxLength(const Schema &schema) {
+  size_t length = 0;
+  for (const Column &column : schema.GetColumns()) {
+    // the byte that tells nulls from the rest
+    length++;
+    switch (column.GetType()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+      case TypeId::SMALLINT:
+      case TypeId::INTEGER:
+      case TypeId::BIGINT:
+      case TypeId::TIMESTAMP:
+      case TypeId::DECIMAL:
+        length += column.GetFixedLength();
+        break;
+      default:
+        // Nothing holds a varchar to the length of its column, so its key has no bound.
+        return SIZE_MAX;
+    }
+  }
+  return length;
+}
+
+}  // namespace bustub
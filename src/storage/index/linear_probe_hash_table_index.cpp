@@ -1,17 +1,23 @@
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "storage/index/linear_probe_hash_table_index.h"
 
+#include "common/util/metrics.h"
+
 namespace bustub {
 /*
  * Constructor
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_INDEX_TYPE::LinearProbeHashTableIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager,
-                                                 size_t num_buckets, const HashFunction<KeyType> &hash_fn)
+                                                 size_t num_buckets, const HashFunction<KeyType> &hash_fn,
+                                                 bool unique_keys)
     : Index(metadata),
       comparator_(metadata->GetKeySchema()),
-      container_(metadata->GetName(), buffer_pool_manager, comparator_, num_buckets, hash_fn) {}
+      container_(metadata->GetName(), buffer_pool_manager, comparator_, num_buckets, hash_fn, unique_keys) {}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
@@ -22,6 +28,12 @@ void HASH_TABLE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *
   container_.Insert(transaction, index_key, rid);
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_INDEX_TYPE::InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids,
+                                          Transaction *transaction) {
+  container_.InsertBatch(transaction, MakePairs(keys, rids));
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
@@ -31,6 +43,12 @@ void HASH_TABLE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *
   container_.Remove(transaction, index_key, rid);
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_INDEX_TYPE::DeleteEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids,
+                                          Transaction *transaction) {
+  container_.RemoveBatch(transaction, MakePairs(keys, rids));
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
@@ -39,10 +57,83 @@ void HASH_TABLE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result,
 
   container_.GetValue(transaction, index_key, result);
 }
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                                     Transaction *transaction) {
+  std::vector<KeyType> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromKey(keys[i]);
+  }
+  container_.GetValueBatch(transaction, index_keys, results);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+std::vector<std::pair<KeyType, ValueType>> HASH_TABLE_INDEX_TYPE::MakePairs(const std::vector<Tuple> &keys,
+                                                                            const std::vector<RID> &rids) {
+  std::vector<std::pair<KeyType, ValueType>> pairs(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    pairs[i].first.SetFromKey(keys[i]);
+    pairs[i].second = rids[i];
+  }
+  return pairs;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_INDEX_TYPE::BulkLoad(const std::vector<std::pair<Tuple, RID>> &entries) {
+  std::vector<std::pair<KeyType, ValueType>> items(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    items[i].first.SetFromKey(entries[i].first);
+    items[i].second = entries[i].second;
+  }
+  return container_.BulkLoad(items);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_INDEX_TYPE::CollectMetrics(MetricsSnapshot *snapshot, const std::string &labels) {
+  HashTableStats stats;
+  if (!GetStats(&stats)) {
+    return;
+  }
+  snapshot->AddGauge("bustub_hash_index_buckets", "Buckets of a hash index.", static_cast<double>(stats.num_buckets_),
+                     labels);
+  snapshot->AddGauge("bustub_hash_index_pairs", "Pairs of a hash index.", static_cast<double>(stats.num_pairs_),
+                     labels);
+  snapshot->AddGauge("bustub_hash_index_tombstones", "Tombstones of a hash index.",
+                     static_cast<double>(stats.num_tombstones_), labels);
+}
+
 template class LinearProbeHashTableIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class LinearProbeHashTableIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class LinearProbeHashTableIndex<GenericKey<16>, RID, GenericComparator<16>>;
 template class LinearProbeHashTableIndex<GenericKey<32>, RID, GenericComparator<32>>;
 template class LinearProbeHashTableIndex<GenericKey<64>, RID, GenericComparator<64>>;
 
+std::unique_ptr<Index> CreateLinearProbeHashTableIndex(IndexMetadata *metadata,
+                                                       BufferPoolManager *buffer_pool_manager, size_t num_buckets,
+                                                       bool unique_keys) {
+  const uint32_t key_size = metadata->GetKeySchema()->GetLength();
+  if (key_size <= 4) {
+    return std::make_unique<LinearProbeHashTableIndex<GenericKey<4>, RID, GenericComparator<4>>>(
+        metadata, buffer_pool_manager, num_buckets, HashFunction<GenericKey<4>>(), unique_keys);
+  }
+  if (key_size <= 8) {
+    return std::make_unique<LinearProbeHashTableIndex<GenericKey<8>, RID, GenericComparator<8>>>(
+        metadata, buffer_pool_manager, num_buckets, HashFunction<GenericKey<8>>(), unique_keys);
+  }
+  if (key_size <= 16) {
+    return std::make_unique<LinearProbeHashTableIndex<GenericKey<16>, RID, GenericComparator<16>>>(
+        metadata, buffer_pool_manager, num_buckets, HashFunction<GenericKey<16>>(), unique_keys);
+  }
+  if (key_size <= 32) {
+    return std::make_unique<LinearProbeHashTableIndex<GenericKey<32>, RID, GenericComparator<32>>>(
+        metadata, buffer_pool_manager, num_buckets, HashFunction<GenericKey<32>>(), unique_keys);
+  }
+  if (key_size <= 64) {
+    return std::make_unique<LinearProbeHashTableIndex<GenericKey<64>, RID, GenericComparator<64>>>(
+        metadata, buffer_pool_manager, num_buckets, HashFunction<GenericKey<64>>(), unique_keys);
+  }
+  return nullptr;
+}
+
 }  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// columnar_table_page.cpp
+//
+// Identification: src/storage/page/columnar_table_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/columnar_table_page.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+bool ColumnarTablePage::AppendTuple(const Schema &schema, const Tuple &tuple, RID *rid) {
+  BUSTUB_ASSERT(tuple.GetLength() == schema.GetLength(), "Cannot append a tuple of another schema.");
+  const uint32_t slot_num = GetTupleCount();
+  if (slot_num >= GetCapacity(schema)) {
+    return false;
+  }
+  // Scatter the columns of the row into their minipages.
+  const char *row = tuple.GetData();
+  const uint32_t capacity = GetCapacity(schema);
+  for (const Column &column : schema.GetColumns()) {
+    const uint32_t width = column.GetFixedLength();
+    memcpy(GetData() + SIZE_TABLE_PAGE_HEADER + capacity * column.GetOffset() + slot_num * width,
+           row + column.GetOffset(), width);
+  }
+  const uint32_t tuple_count = slot_num + 1;
+  memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t));
+  rid->Set(GetTablePageId(), slot_num);
+  return true;
+}
+
+void ColumnarTablePage::GatherRow(const char *data, const Schema &schema, uint32_t slot_num, char *row) {
+  const uint32_t capacity = GetCapacity(schema);
+  for (const Column &column : schema.GetColumns()) {
+    const uint32_t width = column.GetFixedLength();
+    memcpy(row + column.GetOffset(), data + SIZE_TABLE_PAGE_HEADER + capacity * column.GetOffset() + slot_num * width,
+           width);
+  }
+}
+
+bool ColumnarTablePage::CopyTuple(const char *data, const Schema &schema, const RID &rid, Tuple *tuple) {
+  // The slot is checked against the capacity too, since optimistic readers may see a torn tuple count.
+  uint32_t tuple_count;
+  memcpy(&tuple_count, data + OFFSET_TUPLE_COUNT, sizeof(uint32_t));
+  const uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= tuple_count || slot_num >= GetCapacity(schema)) {
+    return false;
+  }
+  GatherRow(data, schema, slot_num, tuple->Reserve(schema.GetLength()));
+  tuple->rid_ = rid;
+  return true;
+}
+
+bool ColumnarTablePage::GetFirstTupleRid(RID *first_rid) {
+  if (GetTupleCount() == 0) {
+    first_rid->Set(INVALID_PAGE_ID, 0);
+    return false;
+  }
+  first_rid->Set(GetTablePageId(), 0);
+  return true;
+}
+
+bool ColumnarTablePage::GetNextTupleRid(const RID &cur_rid, RID *next_rid) {
+  BUSTUB_ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
+  if (cur_rid.GetSlotNum() + 1 >= GetTupleCount()) {
+    next_rid->Set(INVALID_PAGE_ID, 0);
+    return false;
+  }
+  next_rid->Set(GetTablePageId(), cur_rid.GetSlotNum() + 1);
+  return true;
+}
+
+}  // namespace bustub
@@ -10,46 +10,44 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstring>
+
 #include "storage/page/hash_table_block_page.h"
 #include "storage/index/generic_key.h"
+#include "storage/index/hash_comparator.h"
+#include "storage/table/tmp_tuple.h"
 
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-KeyType HASH_TABLE_BLOCK_TYPE::KeyAt(slot_offset_t bucket_ind) const {
-  return array_[bucket_ind].first;
-}
+bool HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value,
+                                   uint8_t fingerprint) {
+  if (IsReadable(bucket_ind)) { return false; }
 
-template <typename KeyType, typename ValueType, typename KeyComparator>
-ValueType HASH_TABLE_BLOCK_TYPE::ValueAt(slot_offset_t bucket_ind) const {
-  return array_[bucket_ind].second;
+  Keys()[bucket_ind] = key;
+  Values()[bucket_ind] = value;
+  control_[bucket_ind] = FULL | fingerprint;
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value) {
-  // which number: occupied_[bucket_ind / 8]
-  // which bit in this number: bucket_ind % 8
-  if (IsOccupied(bucket_ind)) { return false; }
-
-  array_[bucket_ind] = std::make_pair(key, value);
-  occupied_[bucket_ind / 8] |= (1 << bucket_ind % 8);
-  readable_[bucket_ind / 8] |= (1 << bucket_ind % 8);
-  return true;
+void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {
+  if (IsReadable(bucket_ind)) { control_[bucket_ind] = DELETED; }
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {
-  readable_[bucket_ind / 8] &= (~(1 << bucket_ind % 8));
+void HASH_TABLE_BLOCK_TYPE::Clear() {
+  memset(control_, EMPTY, sizeof(control_));
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BLOCK_TYPE::IsOccupied(slot_offset_t bucket_ind) const {
-  return occupied_[bucket_ind / 8] & (1 << bucket_ind % 8);
+  return control_[bucket_ind] != EMPTY;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BLOCK_TYPE::IsReadable(slot_offset_t bucket_ind) const {
-  return readable_[bucket_ind / 8] & (1 << bucket_ind % 8);
+  return (control_[bucket_ind] & FULL) != 0;
 }
 
 // DO NOT REMOVE ANYTHING BELOW THIS LINE
@@ -59,5 +57,6 @@ template class HashTableBlockPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class HashTableBlockPage<GenericKey<16>, RID, GenericComparator<16>>;
 template class HashTableBlockPage<GenericKey<32>, RID, GenericComparator<32>>;
 template class HashTableBlockPage<GenericKey<64>, RID, GenericComparator<64>>;
+template class HashTableBlockPage<hash_t, TmpTuple, HashComparator>;
 
 }  // namespace bustub
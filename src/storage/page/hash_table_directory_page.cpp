@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory_page.cpp
+//
+// Identification: src/storage/page/hash_table_directory_page.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/hash_table_directory_page.h"
+
+#include <unordered_map>
+
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace bustub {
+page_id_t HashTableDirectoryPage::GetPageId() const { return page_id_; }
+
+void HashTableDirectoryPage::SetPageId(bustub::page_id_t page_id) { page_id_ = page_id; }
+
+lsn_t HashTableDirectoryPage::GetLSN() const { return lsn_; }
+
+void HashTableDirectoryPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+page_id_t HashTableDirectoryPage::GetBucketPageId(uint32_t bucket_idx) const { return bucket_page_ids_[bucket_idx]; }
+
+void HashTableDirectoryPage::SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id) {
+  bucket_page_ids_[bucket_idx] = bucket_page_id;
+}
+
+uint32_t HashTableDirectoryPage::GetSplitImageIndex(uint32_t bucket_idx) const {
+  const uint32_t local_depth = local_depths_[bucket_idx];
+  return local_depth == 0 ? bucket_idx : bucket_idx ^ (1U << (local_depth - 1));
+}
+
+void HashTableDirectoryPage::IncrGlobalDepth() {
+  BUSTUB_ASSERT(Size() * 2 <= DIRECTORY_ARRAY_SIZE, "The directory is full.");
+  const uint32_t size = Size();
+  for (uint32_t i = 0; i < size; i++) {
+    bucket_page_ids_[size + i] = bucket_page_ids_[i];
+    local_depths_[size + i] = local_depths_[i];
+  }
+  global_depth_++;
+}
+
+void HashTableDirectoryPage::DecrGlobalDepth() { global_depth_--; }
+
+bool HashTableDirectoryPage::CanShrink() const {
+  if (global_depth_ == 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i < Size(); i++) {
+    if (local_depths_[i] == global_depth_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t HashTableDirectoryPage::GetLocalDepth(uint32_t bucket_idx) const { return local_depths_[bucket_idx]; }
+
+void HashTableDirectoryPage::SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth) {
+  local_depths_[bucket_idx] = local_depth;
+}
+
+void HashTableDirectoryPage::VerifyIntegrity() const {
+  std::unordered_map<page_id_t, uint32_t> page_id_to_count;
+  std::unordered_map<page_id_t, uint32_t> page_id_to_local_depth;
+  for (uint32_t i = 0; i < Size(); i++) {
+    const page_id_t page_id = bucket_page_ids_[i];
+    const uint32_t local_depth = local_depths_[i];
+    BUSTUB_ASSERT(local_depth <= global_depth_, "A local depth exceeds the global depth.");
+    page_id_to_count[page_id]++;
+    auto it = page_id_to_local_depth.emplace(page_id, local_depth).first;
+    if (it->second != local_depth) {
+      LOG_WARN("Bucket page %d has local depths %u and %u", page_id, it->second, local_depth);
+      BUSTUB_ASSERT(it->second == local_depth, "The slots of a bucket have different local depths.");
+    }
+  }
+  for (const auto &[page_id, count] : page_id_to_count) {
+    const uint32_t local_depth = page_id_to_local_depth[page_id];
+    if (count != 1U << (global_depth_ - local_depth)) {
+      LOG_WARN("Bucket page %d of local depth %u has %u slots", page_id, local_depth, count);
+      BUSTUB_ASSERT(count == 1U << (global_depth_ - local_depth), "A bucket has the wrong number of slots.");
+    }
+  }
+}
+
+}  // namespace bustub
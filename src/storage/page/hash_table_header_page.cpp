@@ -13,8 +13,6 @@
 #include "storage/page/hash_table_header_page.h"
 
 namespace bustub {
-page_id_t HashTableHeaderPage::GetBlockPageId(size_t index) { return block_page_ids_[index]; }
-
 page_id_t HashTableHeaderPage::GetPageId() const { return page_id_; }
 
 void HashTableHeaderPage::SetPageId(bustub::page_id_t page_id) { page_id_ = page_id; }
@@ -23,12 +21,28 @@ lsn_t HashTableHeaderPage::GetLSN() const { return lsn_; }
 
 void HashTableHeaderPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
 
-void HashTableHeaderPage::AddBlockPageId(page_id_t page_id) { block_page_ids_[next_ind_++] = page_id; }
+size_t HashTableHeaderPage::NumBlocks() const { return num_blocks_; }
+
+void HashTableHeaderPage::SetNumBlocks(size_t num_blocks) { num_blocks_ = num_blocks; }
+
+void HashTableHeaderPage::AddDirectoryPageId(page_id_t page_id) { directory_page_ids_[next_ind_++] = page_id; }
+
+page_id_t HashTableHeaderPage::GetDirectoryPageId(size_t index) const { return directory_page_ids_[index]; }
 
-size_t HashTableHeaderPage::NumBlocks() { return next_ind_; }
+size_t HashTableHeaderPage::NumDirectories() const { return next_ind_; }
+
+size_t HashTableHeaderPage::MaxDirectories() {
+  return (PAGE_SIZE - sizeof(HashTableHeaderPage)) / sizeof(page_id_t);
+}
+
+size_t HashTableHeaderPage::MaxBlocks() { return MaxDirectories() * BLOCK_DIRECTORY_ARRAY_SIZE; }
 
 void HashTableHeaderPage::SetSize(size_t size) { size_ = size; }
 
 size_t HashTableHeaderPage::GetSize() const { return size_; }
 
+page_id_t HashTableBlockDirectoryPage::GetBlockPageId(size_t index) const { return block_page_ids_[index]; }
+
+void HashTableBlockDirectoryPage::SetBlockPageId(size_t index, page_id_t page_id) { block_page_ids_[index] = page_id; }
+
 }  // namespace bustub
@@ -13,6 +13,7 @@
 #include "storage/page/table_page.h"
 
 #include <cassert>
+#include <utility>
 
 namespace bustub {
 
@@ -21,8 +22,9 @@ void TablePage::Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_
   // Set the page ID.
   memcpy(GetData(), &page_id, sizeof(page_id));
   // Log that we are creating a new page.
-  if (enable_logging) {
-    LogRecord log_record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::NEWPAGE, prev_page_id);
+  if (enable_logging && log_manager != nullptr) {
+    LogRecord log_record =
+        LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::NEWPAGE, prev_page_id, page_id);
     lsn_t lsn = log_manager->AppendLogRecord(&log_record);
     SetLSN(lsn);
     txn->SetPrevLSN(lsn);
@@ -35,7 +37,7 @@ void TablePage::Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_
 }
 
 bool TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager,
-                            LogManager *log_manager) {
+                            LogManager *log_manager, table_oid_t oid) {
   BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
   // If there is not enough space, then return false.
   if (GetFreeSpaceRemaining() < tuple.size_ + SIZE_TUPLE) {
@@ -74,7 +76,7 @@ bool TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, Lock
   if (enable_logging) {
     BUSTUB_ASSERT(!txn->IsSharedLocked(*rid) && !txn->IsExclusiveLocked(*rid), "A new tuple should not be locked.");
     // Acquire an exclusive lock on the new tuple.
-    bool locked = lock_manager->LockExclusive(txn, *rid);
+    bool locked = lock_manager->LockExclusive(txn, *rid, oid);
     BUSTUB_ASSERT(locked, "Locking a new tuple should always work.");
     LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::INSERT, *rid, tuple);
     lsn_t lsn = log_manager->AppendLogRecord(&log_record);
@@ -84,7 +86,50 @@ bool TablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, Lock
   return true;
 }
 
-bool TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager) {
+bool TablePage::AppendTuple(const Tuple &tuple, RID *rid) {
+  BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  if (GetFreeSpaceRemaining() < tuple.size_ + SIZE_TUPLE) {
+    return false;
+  }
+  // The page is filled from the start, so there are no free slots to reuse.
+  const uint32_t slot_num = GetTupleCount();
+  SetFreeSpacePointer(GetFreeSpacePointer() - tuple.size_);
+  memcpy(GetData() + GetFreeSpacePointer(), tuple.data_, tuple.size_);
+  SetTupleOffsetAtSlot(slot_num, GetFreeSpacePointer());
+  SetTupleSize(slot_num, tuple.size_);
+  SetTupleCount(slot_num + 1);
+  rid->Set(GetTablePageId(), slot_num);
+  return true;
+}
+
+void TablePage::LogImage(page_id_t next_page_id, Transaction *txn, LogManager *log_manager) {
+  if (enable_logging) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::PAGEIMAGE, GetTablePageId(),
+                         next_page_id, GetData());
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+}
+
+void TablePage::RemoveAllTuples() {
+  SetFreeSpacePointer(PAGE_SIZE);
+  SetTupleCount(0);
+}
+
+void TablePage::Truncate(Transaction *txn, LogManager *log_manager) {
+  if (enable_logging) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::TRUNCATE, GetTablePageId(),
+                         GetNextPageId(), GetData());
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+  Init(GetTablePageId(), PAGE_SIZE, INVALID_PAGE_ID, nullptr, txn);
+}
+
+bool TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager,
+                           table_oid_t oid) {
   uint32_t slot_num = rid.GetSlotNum();
   // If the slot number is invalid, abort the transaction.
   if (slot_num >= GetTupleCount()) {
@@ -106,10 +151,10 @@ bool TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_m
   if (enable_logging) {
     // Acquire an exclusive lock, upgrading from a shared lock if necessary.
     if (txn->IsSharedLocked(rid)) {
-      if (!lock_manager->LockUpgrade(txn, rid)) {
+      if (!lock_manager->LockUpgrade(txn, rid, oid)) {
         return false;
       }
-    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
+    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid, oid)) {
       return false;
     }
     Tuple dummy_tuple;
@@ -127,7 +172,7 @@ bool TablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_m
 }
 
 bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
-                            LockManager *lock_manager, LogManager *log_manager) {
+                            LockManager *lock_manager, LogManager *log_manager, table_oid_t oid) {
   BUSTUB_ASSERT(new_tuple.size_ > 0, "Cannot have empty tuples.");
   uint32_t slot_num = rid.GetSlotNum();
   // If the slot number is invalid, abort the transaction.
@@ -152,22 +197,16 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
 
   // Copy out the old value.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
-  old_tuple->size_ = tuple_size;
-  if (old_tuple->allocated_) {
-    delete[] old_tuple->data_;
-  }
-  old_tuple->data_ = new char[old_tuple->size_];
-  memcpy(old_tuple->data_, GetData() + tuple_offset, old_tuple->size_);
+  memcpy(old_tuple->Reserve(tuple_size), GetData() + tuple_offset, tuple_size);
   old_tuple->rid_ = rid;
-  old_tuple->allocated_ = true;
 
   if (enable_logging) {
     // Acquire an exclusive lock, upgrading from shared if necessary.
     if (txn->IsSharedLocked(rid)) {
-      if (!lock_manager->LockUpgrade(txn, rid)) {
+      if (!lock_manager->LockUpgrade(txn, rid, oid)) {
         return false;
       }
-    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
+    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid, oid)) {
       return false;
     }
     LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::UPDATE, rid, *old_tuple, new_tuple);
@@ -176,6 +215,22 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
     txn->SetPrevLSN(lsn);
   }
 
+  // A tuple of the same size is overwritten where it is, only from its first changed byte to its last one, e.g. the
+  // counter of a row. Neither the data region nor the slot array moves.
+  if (new_tuple.size_ == tuple_size) {
+    const char *old_data = old_tuple->data_;
+    uint32_t begin = 0;
+    while (begin < tuple_size && old_data[begin] == new_tuple.data_[begin]) {
+      begin++;
+    }
+    uint32_t end = tuple_size;
+    while (end > begin && old_data[end - 1] == new_tuple.data_[end - 1]) {
+      end--;
+    }
+    memcpy(GetData() + tuple_offset + begin, new_tuple.data_ + begin, end - begin);
+    return true;
+  }
+
   // Perform the update.
   uint32_t free_space_pointer = GetFreeSpacePointer();
   BUSTUB_ASSERT(tuple_offset >= free_space_pointer, "Offset should appear after current free space position.");
@@ -196,7 +251,7 @@ bool TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
   return true;
 }
 
-void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager, Tuple *deleted_tuple) {
   uint32_t slot_num = rid.GetSlotNum();
   BUSTUB_ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
 
@@ -210,11 +265,8 @@ void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_ma
 
   // We need to copy out the deleted tuple for undo purposes.
   Tuple delete_tuple;
-  delete_tuple.size_ = tuple_size;
-  delete_tuple.data_ = new char[delete_tuple.size_];
-  memcpy(delete_tuple.data_, GetData() + tuple_offset, delete_tuple.size_);
+  memcpy(delete_tuple.Reserve(tuple_size), GetData() + tuple_offset, tuple_size);
   delete_tuple.rid_ = rid;
-  delete_tuple.allocated_ = true;
 
   if (enable_logging) {
     BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
@@ -241,6 +293,9 @@ void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_ma
       SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size);
     }
   }
+  if (deleted_tuple != nullptr) {
+    *deleted_tuple = std::move(delete_tuple);
+  }
 }
 
 void TablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
@@ -264,7 +319,8 @@ void TablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log
   }
 }
 
-bool TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) {
+bool TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager, table_oid_t oid,
+                         bool in_place) {
   // Get the current slot number.
   uint32_t slot_num = rid.GetSlotNum();
   // If somehow we have more slots than tuples, abort the transaction.
@@ -285,29 +341,49 @@ bool TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockMan
   }
 
   // Otherwise we have a valid tuple, try to acquire at least a shared lock.
-  if (enable_logging) {
-    if (!txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) && !lock_manager->LockShared(txn, rid)) {
+  if (enable_logging && lock_manager != nullptr) {
+    if (!txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) && !lock_manager->LockShared(txn, rid, oid)) {
       return false;
     }
   }
 
   // At this point, we have at least a shared lock on the RID. Copy the tuple data into our result.
   uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
-  tuple->size_ = tuple_size;
-  if (tuple->allocated_) {
-    delete[] tuple->data_;
+  tuple->rid_ = rid;
+  if (in_place) {
+    tuple->Release();
+    tuple->size_ = tuple_size;
+    tuple->data_ = GetData() + tuple_offset;
+    return true;
   }
-  tuple->data_ = new char[tuple->size_];
-  memcpy(tuple->data_, GetData() + tuple_offset, tuple->size_);
+  memcpy(tuple->Reserve(tuple_size), GetData() + tuple_offset, tuple_size);
+  return true;
+}
+
+bool TablePage::CopyTuple(const char *data, const RID &rid, Tuple *tuple) {
+  uint32_t tuple_count;
+  memcpy(&tuple_count, data + OFFSET_TUPLE_COUNT, sizeof(uint32_t));
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= tuple_count || OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num + sizeof(uint32_t) > PAGE_SIZE) {
+    return false;
+  }
+  uint32_t tuple_offset;
+  uint32_t tuple_size;
+  memcpy(&tuple_offset, data + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num, sizeof(uint32_t));
+  memcpy(&tuple_size, data + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num, sizeof(uint32_t));
+  if (IsDeleted(tuple_size) || tuple_offset > PAGE_SIZE || tuple_size > PAGE_SIZE - tuple_offset) {
+    return false;
+  }
+
+  memcpy(tuple->Reserve(tuple_size), data + tuple_offset, tuple_size);
   tuple->rid_ = rid;
-  tuple->allocated_ = true;
   return true;
 }
 
-bool TablePage::GetFirstTupleRid(RID *first_rid) {
+bool TablePage::GetFirstTupleRid(RID *first_rid, bool empty_slots) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); ++i) {
-    if (GetTupleSize(i) > 0) {
+    if (empty_slots || GetTupleSize(i) > 0) {
       first_rid->Set(GetTablePageId(), i);
       return true;
     }
@@ -316,11 +392,11 @@ bool TablePage::GetFirstTupleRid(RID *first_rid) {
   return false;
 }
 
-bool TablePage::GetNextTupleRid(const RID &cur_rid, RID *next_rid) {
+bool TablePage::GetNextTupleRid(const RID &cur_rid, RID *next_rid, bool empty_slots) {
   BUSTUB_ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
   // Find and return the first valid tuple after our current slot number.
   for (auto i = cur_rid.GetSlotNum() + 1; i < GetTupleCount(); ++i) {
-    if (GetTupleSize(i) > 0) {
+    if (empty_slots || GetTupleSize(i) > 0) {
       next_rid->Set(GetTablePageId(), i);
       return true;
     }
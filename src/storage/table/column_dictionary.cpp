@@ -0,0 +1,31 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// column_dictionary.cpp
+//
+// Identification: src/storage/table/column_dictionary.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/column_dictionary.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+int32_t ColumnDictionary::Encode(std::string_view str) {
+  auto it = codes_.find(str);
+  if (it != codes_.end()) {
+    return it->second;
+  }
+  BUSTUB_ASSERT(strings_.size() < static_cast<size_t>(INT32_MAX), "A dictionary holds fewer strings than codes.");
+  const auto code = static_cast<int32_t>(strings_.size());
+  strings_.emplace_back(str);
+  codes_.emplace(strings_.back(), code);
+  return code;
+}
+
+}  // namespace bustub
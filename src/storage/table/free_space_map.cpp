@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/table/free_space_map.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/free_space_map.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+void FreeSpaceMap::Update(page_id_t page_id, uint32_t max_insert_size) {
+  const uint32_t category = std::min(max_insert_size / CATEGORY_SIZE, NUM_CATEGORIES - 1);
+  std::scoped_lock lock(latch_);
+  auto [it, inserted] = categories_.emplace(page_id, category);
+  if (!inserted) {
+    if (it->second == category) {
+      return;
+    }
+    pages_[it->second].erase(page_id);
+    it->second = category;
+  }
+  if (category > 0) {
+    pages_[category].insert(page_id);
+  }
+}
+
+bool FreeSpaceMap::Remove(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  if (claimed_.count(page_id) > 0) {
+    return false;
+  }
+  auto it = categories_.find(page_id);
+  if (it != categories_.end()) {
+    pages_[it->second].erase(page_id);
+    categories_.erase(it);
+  }
+  return true;
+}
+
+page_id_t FreeSpaceMap::ClaimPage(uint32_t tuple_size, page_id_t released) {
+  // Rounded up, every page of this category or a higher one has room for the tuple.
+  const uint32_t needed = std::max<uint32_t>((tuple_size + CATEGORY_SIZE - 1) / CATEGORY_SIZE, 1);
+  std::scoped_lock lock(latch_);
+  claimed_.erase(released);
+  page_id_t page_id = INVALID_PAGE_ID;
+  for (uint32_t category = needed; category < NUM_CATEGORIES; category++) {
+    // Few pages are claimed at a time, one per inserter.
+    for (page_id_t candidate : pages_[category]) {
+      if (page_id != INVALID_PAGE_ID && candidate > page_id) {
+        break;
+      }
+      if (claimed_.count(candidate) == 0) {
+        page_id = candidate;
+        break;
+      }
+    }
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    claimed_.insert(page_id);
+  }
+  return page_id;
+}
+
+}  // namespace bustub
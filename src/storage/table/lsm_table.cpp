@@ -0,0 +1,393 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lsm_table.cpp
+//
+// Identification: src/storage/table/lsm_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/lsm_table.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "storage/page/lsm_run_page.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the 512-bit lines of a Bloom filter of a number of keys */
+size_t FilterLines(size_t num_keys) { return std::max<size_t>(1, (num_keys * LSM_FILTER_BITS_PER_KEY + 511) / 512); }
+
+}  // namespace
+
+LsmRun::LsmRun(BufferPoolManager *bpm, size_t expected_entries)
+    : bpm_(bpm), filter_(FilterLines(expected_entries)) {
+  filter_.Resize(1);
+}
+
+LsmRun::~LsmRun() {
+  Finish();
+  for (page_id_t page_id : page_ids_) {
+    bpm_->DeletePage(page_id);
+  }
+}
+
+void LsmRun::Append(int64_t key, const LsmEntry &entry) {
+  const char *tuple = entry.deleted_ ? nullptr : entry.tuple_.data();
+  if (last_page_ == nullptr || !reinterpret_cast<LsmRunPage *>(last_page_)->Append(key, tuple)) {
+    Finish();
+    page_id_t page_id;
+    last_page_ = bpm_->NewPage(&page_id);
+    if (last_page_ == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for a page of an LSM run.");
+    }
+    page_ids_.push_back(page_id);
+    first_keys_.push_back(key);
+    auto page = reinterpret_cast<LsmRunPage *>(last_page_);
+    page->Init(page_id);
+    if (!page->Append(key, tuple)) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "An entry of an LSM run does not fit a page.");
+    }
+  }
+  filter_.Add(0, static_cast<uint64_t>(key));
+  num_entries_++;
+}
+
+void LsmRun::Finish() {
+  if (last_page_ != nullptr) {
+    bpm_->UnpinPage(last_page_->GetPageId(), true);
+    last_page_ = nullptr;
+  }
+}
+
+bool LsmRun::Find(int64_t key, LsmEntry *entry) const {
+  if (!MayContain(key)) {
+    return false;
+  }
+  // The page of the key is the last one whose first key is not larger.
+  auto it = std::upper_bound(first_keys_.begin(), first_keys_.end(), key);
+  if (it == first_keys_.begin()) {
+    return false;
+  }
+  const page_id_t page_id = page_ids_[it - first_keys_.begin() - 1];
+  auto page = reinterpret_cast<LsmRunPage *>(FetchPage(page_id));
+  bool found = false;
+  page->ScanEntries([&](int64_t entry_key, const char *tuple) {
+    if (entry_key == key) {
+      found = true;
+      entry->deleted_ = tuple == nullptr;
+      entry->tuple_.clear();
+      if (tuple != nullptr) {
+        uint32_t size;
+        memcpy(&size, tuple, sizeof(uint32_t));
+        entry->tuple_.assign(tuple, sizeof(uint32_t) + size);
+      }
+    }
+    return entry_key < key;
+  });
+  bpm_->UnpinPage(page_id, false);
+  return found;
+}
+
+void LsmRun::ReadPage(size_t page_index, std::vector<std::pair<int64_t, LsmEntry>> *entries) const {
+  entries->clear();
+  const page_id_t page_id = page_ids_[page_index];
+  auto page = reinterpret_cast<LsmRunPage *>(FetchPage(page_id));
+  entries->reserve(page->GetNumEntries());
+  page->ScanEntries([entries](int64_t key, const char *tuple) {
+    LsmEntry entry;
+    entry.deleted_ = tuple == nullptr;
+    if (tuple != nullptr) {
+      uint32_t size;
+      memcpy(&size, tuple, sizeof(uint32_t));
+      entry.tuple_.assign(tuple, sizeof(uint32_t) + size);
+    }
+    entries->emplace_back(key, std::move(entry));
+    return true;
+  });
+  bpm_->UnpinPage(page_id, false);
+}
+
+Page *LsmRun::FetchPage(page_id_t page_id) const {
+  Page *page = bpm_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for a page of an LSM run.");
+  }
+  return page;
+}
+
+LsmTable::Iterator::Iterator(std::vector<Source> &&sources) : sources_(std::move(sources)) {
+  for (Source &source : sources_) {
+    if (source.memtable_ != nullptr) {
+      source.it_ = source.memtable_->begin();
+    } else if (source.run_->GetNumPages() > 0) {
+      source.run_->ReadPage(0, &source.entries_);
+    }
+  }
+}
+
+bool LsmTable::Iterator::NextEntry(int64_t *key, LsmEntry *entry) {
+  auto is_valid = [](const Source &source) {
+    return source.memtable_ != nullptr ? source.it_ != source.memtable_->end()
+                                       : source.entry_index_ < source.entries_.size();
+  };
+  auto key_of = [](const Source &source) {
+    return source.memtable_ != nullptr ? source.it_->first : source.entries_[source.entry_index_].first;
+  };
+  // On a tie, the first source, which is the newest, wins.
+  Source *newest = nullptr;
+  for (Source &source : sources_) {
+    if (is_valid(source) && (newest == nullptr || key_of(source) < key_of(*newest))) {
+      newest = &source;
+    }
+  }
+  if (newest == nullptr) {
+    return false;
+  }
+  *key = key_of(*newest);
+  *entry = newest->memtable_ != nullptr ? newest->it_->second : newest->entries_[newest->entry_index_].second;
+  for (Source &source : sources_) {
+    if (!is_valid(source) || key_of(source) != *key) {
+      continue;
+    }
+    if (source.memtable_ != nullptr) {
+      ++source.it_;
+    } else if (++source.entry_index_ == source.entries_.size() &&
+               ++source.page_index_ < source.run_->GetNumPages()) {
+      source.run_->ReadPage(source.page_index_, &source.entries_);
+      source.entry_index_ = 0;
+    }
+  }
+  return true;
+}
+
+bool LsmTable::Iterator::Next(Tuple *tuple) {
+  int64_t key;
+  LsmEntry entry;
+  while (NextEntry(&key, &entry)) {
+    if (!entry.deleted_) {
+      tuple->DeserializeFrom(entry.tuple_.data());
+      return true;
+    }
+  }
+  return false;
+}
+
+LsmTable::LsmTable(BufferPoolManager *bpm, const Schema &schema, size_t memtable_size)
+    : bpm_(bpm), schema_(schema), memtable_size_(memtable_size) {
+  const TypeId key_type = schema_.GetColumn(0).GetType();
+  BUSTUB_ASSERT(key_type >= TypeId::TINYINT && key_type <= TypeId::BIGINT, "The key of an LSM table is an integer!");
+  maintenance_thread_ = std::thread(&LsmTable::RunMaintenance, this);
+}
+
+LsmTable::~LsmTable() {
+  {
+    std::unique_lock lock(latch_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  maintenance_thread_.join();
+}
+
+int64_t LsmTable::GetKey(const Tuple &tuple) const {
+  return tuple.GetValue(&schema_, 0).CastAs(TypeId::BIGINT).GetAs<int64_t>();
+}
+
+bool LsmTable::InsertTuples(const std::vector<Tuple> &tuples) {
+  std::vector<std::pair<int64_t, LsmEntry>> entries;
+  entries.reserve(tuples.size());
+  for (const Tuple &tuple : tuples) {
+    if (tuple.IsNull(&schema_, 0) || LsmRunPage::SpaceFor(tuple.GetLength()) > LsmRunPage::CAPACITY) {
+      return false;
+    }
+    LsmEntry entry;
+    entry.tuple_.resize(sizeof(uint32_t) + tuple.GetLength());
+    tuple.SerializeTo(entry.tuple_.data());
+    entries.emplace_back(GetKey(tuple), std::move(entry));
+  }
+  auto lock = LockForWrite();
+  for (auto &[key, entry] : entries) {
+    Put(key, std::move(entry));
+  }
+  return true;
+}
+
+void LsmTable::DeleteKey(int64_t key) {
+  auto lock = LockForWrite();
+  Put(key, LsmEntry{true, {}});
+}
+
+bool LsmTable::GetTuple(int64_t key, Tuple *tuple) const {
+  auto found = [tuple](const LsmEntry &entry) {
+    if (!entry.deleted_) {
+      tuple->DeserializeFrom(entry.tuple_.data());
+    }
+    return !entry.deleted_;
+  };
+  std::vector<std::shared_ptr<const LsmRun>> runs;
+  {
+    std::shared_lock lock(latch_);
+    auto it = memtable_.find(key);
+    if (it != memtable_.end()) {
+      return found(it->second);
+    }
+    for (const auto &immutable : immutables_) {
+      it = immutable->find(key);
+      if (it != immutable->end()) {
+        return found(it->second);
+      }
+    }
+    runs = runs_;
+  }
+  // The pages of the runs are read without the latch, the runs stay alive as long as they are held here.
+  LsmEntry entry;
+  for (const auto &run : runs) {
+    if (run->Find(key, &entry)) {
+      return found(entry);
+    }
+  }
+  return false;
+}
+
+LsmTable::Iterator LsmTable::Begin() const {
+  std::vector<Iterator::Source> sources;
+  std::shared_lock lock(latch_);
+  sources.reserve(1 + immutables_.size() + runs_.size());
+  // The memtable is copied, so that the writers go on while the scan runs.
+  sources.emplace_back().memtable_ = std::make_shared<const Memtable>(memtable_);
+  for (const auto &immutable : immutables_) {
+    sources.emplace_back().memtable_ = immutable;
+  }
+  for (const auto &run : runs_) {
+    sources.emplace_back().run_ = run;
+  }
+  return Iterator(std::move(sources));
+}
+
+void LsmTable::Flush() {
+  {
+    std::unique_lock lock(latch_);
+    if (!memtable_.empty()) {
+      Freeze();
+    }
+  }
+  std::scoped_lock lock(maintenance_latch_);
+  WriteImmutables();
+}
+
+void LsmTable::Compact() {
+  std::scoped_lock lock(maintenance_latch_);
+  CompactRuns();
+}
+
+std::unique_lock<std::shared_mutex> LsmTable::LockForWrite() {
+  std::unique_lock lock(latch_);
+  cv_.wait(lock, [this] { return stop_ || immutables_.size() < static_cast<size_t>(LSM_MAX_IMMUTABLE); });
+  return lock;
+}
+
+void LsmTable::Put(int64_t key, LsmEntry &&entry) {
+  memtable_bytes_ += sizeof(int64_t) + entry.tuple_.size();
+  memtable_[key] = std::move(entry);
+  if (memtable_bytes_ >= memtable_size_) {
+    Freeze();
+  }
+}
+
+void LsmTable::Freeze() {
+  immutables_.push_front(std::make_shared<const Memtable>(std::move(memtable_)));
+  memtable_.clear();
+  memtable_bytes_ = 0;
+  cv_.notify_all();
+}
+
+void LsmTable::WriteImmutables() {
+  while (true) {
+    std::shared_ptr<const Memtable> oldest;
+    {
+      std::shared_lock lock(latch_);
+      if (immutables_.empty()) {
+        return;
+      }
+      oldest = immutables_.back();
+    }
+    auto run = std::make_shared<LsmRun>(bpm_, oldest->size());
+    for (const auto &[key, entry] : *oldest) {
+      run->Append(key, entry);
+    }
+    run->Finish();
+    // The run takes the place of the memtable at once, so that a reader finds the entries in either of them.
+    {
+      std::unique_lock lock(latch_);
+      runs_.insert(runs_.begin(), std::move(run));
+      immutables_.pop_back();
+    }
+    cv_.notify_all();
+  }
+}
+
+void LsmTable::CompactRuns() {
+  std::vector<Iterator::Source> sources;
+  size_t num_entries = 0;
+  {
+    std::shared_lock lock(latch_);
+    if (runs_.size() < 2) {
+      return;
+    }
+    for (const auto &run : runs_) {
+      sources.emplace_back().run_ = run;
+      num_entries += run->GetNumEntries();
+    }
+  }
+  // All of the runs are merged, so there is nothing older that a tombstone would have to hide.
+  auto merged = std::make_shared<LsmRun>(bpm_, num_entries);
+  Iterator it(std::move(sources));
+  int64_t key;
+  LsmEntry entry;
+  while (it.NextEntry(&key, &entry)) {
+    if (!entry.deleted_) {
+      merged->Append(key, entry);
+    }
+  }
+  merged->Finish();
+  // Only the holder of maintenance_latch_ changes the runs, so they are still those that were merged. Their pages go
+  // once the readers that hold them are done.
+  std::unique_lock lock(latch_);
+  runs_.assign(1, std::move(merged));
+}
+
+void LsmTable::RunMaintenance() {
+  while (true) {
+    {
+      std::unique_lock lock(latch_);
+      cv_.wait(lock, [this] { return stop_ || !immutables_.empty(); });
+      if (stop_) {
+        return;
+      }
+    }
+    std::scoped_lock lock(maintenance_latch_);
+    try {
+      WriteImmutables();
+      if (GetNumRuns() >= static_cast<size_t>(LSM_COMPACTION_TRIGGER)) {
+        CompactRuns();
+      }
+    } catch (const Exception &e) {
+      // E.g. no frame for a page, the frozen memtables stay as they are and are written out later.
+      LOG_WARN("LSM table maintenance failed: %s", e.what());
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_store.cpp
+//
+// Identification: src/storage/table/overflow_store.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/overflow_store.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/util/lz_compressor.h"
+#include "storage/page/overflow_page.h"
+
+namespace bustub {
+
+bool OverflowStore::NeedsStore(const Tuple &tuple) const {
+  if (tuple.size_ > STORE_THRESHOLD) {
+    return true;
+  }
+  for (uint32_t col_idx : schema_.GetUnlinedColumns()) {
+    if (Tuple::IsOverflow(tuple.GetDataPtr(&schema_, col_idx))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool OverflowStore::Store(const Tuple &tuple, Tuple *stored) {
+  const uint32_t column_count = schema_.GetColumnCount();
+  // The values are viewed in place, except for those that the tuple stores out of line already.
+  std::vector<Value> values;
+  values.reserve(column_count);
+  for (uint32_t i = 0; i < column_count; i++) {
+    const char *data_ptr = tuple.GetDataPtr(&schema_, i);
+    if (schema_.GetColumnLayout(i).type_id_ == TypeId::VARCHAR && Tuple::IsOverflow(data_ptr)) {
+      const auto pointer = Tuple::Load<OverflowPointer>(data_ptr + sizeof(uint32_t));
+      std::string data(pointer.length_, '\0');
+      Read(pointer, data.data());
+      values.emplace_back(TypeId::VARCHAR, data.data(), pointer.length_, true);
+    } else {
+      values.push_back(tuple.GetValueView(&schema_, i));
+    }
+  }
+
+  // The largest values go out of line first, as long as the tuple is too large.
+  uint32_t size = schema_.GetLength();
+  std::vector<uint32_t> candidates;
+  for (uint32_t col_idx : schema_.GetUnlinedColumns()) {
+    const uint32_t length = values[col_idx].IsNull() ? 0 : values[col_idx].GetLength();
+    size += sizeof(uint32_t) + length;
+    if (length > sizeof(OverflowPointer)) {
+      candidates.push_back(col_idx);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [&](uint32_t left, uint32_t right) { return values[left].GetLength() > values[right].GetLength(); });
+  std::vector<OverflowPointer> pointers(column_count, OverflowPointer{INVALID_PAGE_ID, 0, 0});
+  for (uint32_t col_idx : candidates) {
+    if (size <= STORE_THRESHOLD) {
+      break;
+    }
+    pointers[col_idx] = WriteChain(values[col_idx].GetData(), values[col_idx].GetLength());
+    if (pointers[col_idx].first_page_id_ == INVALID_PAGE_ID) {
+      // Nobody knows the chains that were written so far.
+      for (const OverflowPointer &pointer : pointers) {
+        if (pointer.first_page_id_ != INVALID_PAGE_ID) {
+          FreeChain(pointer.first_page_id_);
+        }
+      }
+      return false;
+    }
+    size -= values[col_idx].GetLength() - sizeof(OverflowPointer);
+  }
+
+  // Serialize the tuple like Tuple::SetValues(), with the pointers in place of the values that went out of line.
+  char *data = stored->Reserve(size);
+  std::memset(data, 0, size);
+  uint32_t offset = schema_.GetLength();
+  for (uint32_t i = 0; i < column_count; i++) {
+    const Column &col = schema_.GetColumn(i);
+    if (col.IsInlined()) {
+      values[i].SerializeTo(data + col.GetOffset());
+      continue;
+    }
+    memcpy(data + col.GetOffset(), &offset, sizeof(uint32_t));
+    if (pointers[i].first_page_id_ != INVALID_PAGE_ID) {
+      const uint32_t len = Tuple::OVERFLOW_FLAG | static_cast<uint32_t>(sizeof(OverflowPointer));
+      memcpy(data + offset, &len, sizeof(uint32_t));
+      memcpy(data + offset + sizeof(uint32_t), &pointers[i], sizeof(OverflowPointer));
+      offset += sizeof(uint32_t) + sizeof(OverflowPointer);
+    } else {
+      values[i].SerializeTo(data + offset);
+      offset += sizeof(uint32_t) + (values[i].IsNull() ? 0 : values[i].GetLength());
+    }
+  }
+  BUSTUB_ASSERT(offset == size, "The stored tuple must be as large as it was sized.");
+  stored->rid_ = tuple.rid_;
+  stored->overflow_ = this;
+  return true;
+}
+
+OverflowPointer OverflowStore::WriteChain(const char *data, uint32_t length) {
+  OverflowPointer pointer{INVALID_PAGE_ID, length, length};
+  // The value is stored compressed if that saves a quarter of it at least.
+  std::unique_ptr<char[]> compressed(new char[length]);
+  const size_t compressed_size = LzCompressor::Compress(data, length, compressed.get(), length - length / 4);
+  if (compressed_size != 0) {
+    data = compressed.get();
+    pointer.stored_length_ = static_cast<uint32_t>(compressed_size);
+  }
+
+  // The chain is written from its last piece to its first one, so that a page knows the next one when it is written.
+  const uint32_t num_pages = (pointer.stored_length_ + OverflowPage::CAPACITY - 1) / OverflowPage::CAPACITY;
+  std::vector<page_id_t> page_ids;
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  for (uint32_t i = num_pages; i-- > 0;) {
+    page_id_t page_id;
+    BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(&page_id);
+    if (!guard.IsValid()) {
+      for (page_id_t written_page_id : page_ids) {
+        buffer_pool_manager_->DeletePage(written_page_id);
+      }
+      return pointer;
+    }
+    const uint32_t offset = i * OverflowPage::CAPACITY;
+    guard.AsMut<OverflowPage>()->Init(page_id, next_page_id, data + offset,
+                                      std::min(OverflowPage::CAPACITY, pointer.stored_length_ - offset));
+    guard.Drop();
+    // The chain is on disk before the tuple that points to it is logged.
+    if (enable_logging) {
+      buffer_pool_manager_->FlushPage(page_id);
+    }
+    page_ids.push_back(page_id);
+    next_page_id = page_id;
+  }
+  pointer.first_page_id_ = next_page_id;
+  return pointer;
+}
+
+void OverflowStore::Read(const OverflowPointer &pointer, char *data) const {
+  const bool compressed = pointer.stored_length_ < pointer.length_;
+  std::unique_ptr<char[]> buffer;
+  char *stored_data = data;
+  if (compressed) {
+    buffer.reset(new char[pointer.stored_length_]);
+    stored_data = buffer.get();
+  }
+  uint32_t offset = 0;
+  for (page_id_t page_id = pointer.first_page_id_; page_id != INVALID_PAGE_ID && offset < pointer.stored_length_;) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+    if (!guard.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for an overflow page.");
+    }
+    num_pages_read_++;
+    auto page = guard.As<OverflowPage>();
+    const uint32_t size = std::min(page->GetDataSize(), pointer.stored_length_ - offset);
+    memcpy(stored_data + offset, page->GetPieceData(), size);
+    offset += size;
+    page_id = page->GetNextPageId();
+  }
+  if (offset != pointer.stored_length_ ||
+      (compressed && LzCompressor::Decompress(stored_data, pointer.stored_length_, data, pointer.length_) !=
+                         pointer.length_)) {
+    throw Exception(ExceptionType::INVALID, "A value that is stored out of line is corrupt.");
+  }
+}
+
+void OverflowStore::Release(const Tuple &tuple) {
+  std::vector<page_id_t> first_page_ids;
+  for (uint32_t col_idx : schema_.GetUnlinedColumns()) {
+    const char *data_ptr = tuple.GetDataPtr(&schema_, col_idx);
+    if (Tuple::IsOverflow(data_ptr)) {
+      first_page_ids.push_back(Tuple::Load<OverflowPointer>(data_ptr + sizeof(uint32_t)).first_page_id_);
+    }
+  }
+  if (first_page_ids.empty()) {
+    return;
+  }
+  std::scoped_lock lock(latch_);
+  released_.insert(released_.end(), first_page_ids.begin(), first_page_ids.end());
+}
+
+std::vector<page_id_t> OverflowStore::TakeReleased() {
+  std::scoped_lock lock(latch_);
+  return std::exchange(released_, {});
+}
+
+size_t OverflowStore::FreeChain(page_id_t first_page_id) {
+  size_t num_deallocated = 0;
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    page_id_t next_page_id;
+    {
+      ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+      if (!guard.IsValid()) {
+        break;
+      }
+      next_page_id = guard.As<OverflowPage>()->GetNextPageId();
+    }
+    num_deallocated += buffer_pool_manager_->DeletePage(page_id) ? 1 : 0;
+    page_id = next_page_id;
+  }
+  return num_deallocated;
+}
+
+}  // namespace bustub
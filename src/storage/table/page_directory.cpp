@@ -0,0 +1,36 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_directory.cpp
+//
+// Identification: src/storage/table/page_directory.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/page_directory.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+void PageDirectory::Remove(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  auto it = std::find(page_ids_.begin(), page_ids_.end(), page_id);
+  if (it != page_ids_.end()) {
+    page_ids_.erase(it);
+  }
+}
+
+std::vector<page_id_t> PageDirectory::GetPageIds(size_t begin, size_t end) const {
+  std::scoped_lock lock(latch_);
+  end = std::min(end, page_ids_.size());
+  if (begin >= end) {
+    return {};
+  }
+  return std::vector<page_id_t>(page_ids_.begin() + begin, page_ids_.begin() + end);
+}
+
+}  // namespace bustub
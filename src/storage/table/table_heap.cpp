@@ -10,177 +10,1206 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "common/exception.h"
 #include "common/logger.h"
+#include "concurrency/transaction_manager.h"
 #include "storage/table/table_heap.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
+namespace {
+
+/** @return the number of the calling thread, which the threads draw in the order in which they first insert */
+size_t ThreadNumber() {
+  static std::atomic<size_t> next_number{0};
+  thread_local const size_t number = next_number++;
+  return number;
+}
+
+}  // namespace
+
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                     page_id_t first_page_id)
+                     page_id_t first_page_id, table_oid_t oid)
     : buffer_pool_manager_(buffer_pool_manager),
       lock_manager_(lock_manager),
       log_manager_(log_manager),
-      first_page_id_(first_page_id) {}
+      first_page_id_(first_page_id),
+      oid_(oid) {
+  // The directory learns the pages of the heap from their chain, before anybody else uses the heap.
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID; page_id = GetNextPageId(page_id)) {
+    page_directory_.Append(page_id);
+  }
+}
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                     Transaction *txn)
-    : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager) {
-  // Initialize the first table page.
-  auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
+                     Transaction *txn, table_oid_t oid)
+    : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager), oid_(oid) {
+  // Initialize the first table page. It opens an extent that the following pages of the table fill up.
+  auto first_page =
+      reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPageInExtent(INVALID_PAGE_ID, &first_page_id_));
   BUSTUB_ASSERT(first_page != nullptr, "Couldn't create a page for the table heap.");
   first_page->WLatch();
   first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  free_space_.Update(first_page_id_, first_page->GetMaxInsertSize());
+  free_space_.SetLastPageId(first_page_id_);
+  page_directory_.Append(first_page_id_);
   first_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
 }
 
-bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
-  if (tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
+bool TableHeap::LockTable(Transaction *txn, LockMode lock_mode) {
+  // Every write locks its table first, which a read-only transaction must not do for writing.
+  if (txn->IsReadOnly() && lock_mode != LockMode::INTENTION_SHARED && lock_mode != LockMode::SHARED) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
+  if (!enable_logging || oid_ == INVALID_TABLE_OID) {
+    return true;
+  }
+  return lock_manager_->LockTable(txn, oid_, lock_mode);
+}
+
+bool TableHeap::BufferWrite(const RID &rid, WType wtype, const Tuple &tuple, Transaction *txn) {
+  // The transaction writes what it buffered once it stops growing, when it commits.
+  if (!txn->IsOptimistic() || txn->GetState() != TransactionState::GROWING) {
+    return false;
+  }
+  txn->GetWriteBuffer()->emplace_back(rid, wtype, tuple, this);
+  return true;
+}
+
+bool TableHeap::LockRowExclusive(const RID &rid, Transaction *txn) {
+  if (!enable_logging || txn->IsExclusiveLocked(rid)) {
+    return true;
+  }
+  if (txn->IsSharedLocked(rid)) {
+    return lock_manager_->LockUpgrade(txn, rid, oid_);
+  }
+  return lock_manager_->LockExclusive(txn, rid, oid_);
+}
+
+const Tuple *TableHeap::PrepareTuple(const Tuple &tuple, Tuple *stored, Transaction *txn) {
+  const Tuple *prepared = &tuple;
+  if (overflow_ != nullptr && overflow_->NeedsStore(tuple)) {
+    if (!overflow_->Store(tuple, stored)) {
+      txn->SetState(TransactionState::ABORTED);
+      return nullptr;
+    }
+    prepared = stored;
+  }
+  if (prepared->size_ + 32 > PAGE_SIZE) {  // larger than one page size
+    if (prepared == stored) {
+      overflow_->Release(*stored);
+    }
+    txn->SetState(TransactionState::ABORTED);
+    return nullptr;
+  }
+  return prepared;
+}
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
+bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
+  // A table that stores values out of line finds out whether the tuple fits once it stored them.
+  if (overflow_ == nullptr && tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
+  if (BufferWrite(RID(), WType::INSERT, tuple, txn)) {
+    *rid = RID();
+    return true;
+  }
+  if (columnar_schema_ != nullptr) {
+    std::vector<RID> rids;
+    if (!BulkInsert({tuple}, &rids, txn)) {
+      return false;
+    }
+    *rid = rids[0];
+    return true;
+  }
+  if (!LockTable(txn, LockMode::INTENTION_EXCLUSIVE)) {
+    return false;
+  }
+  Tuple stored;
+  const Tuple *prepared = PrepareTuple(tuple, &stored, txn);
+  if (prepared == nullptr) {
+    return false;
+  }
+
+  WritePageGuard cur_guard;
+  if (!InsertIntoAppendPage(*prepared, rid, &cur_guard, txn)) {
+    if (prepared == &stored) {
+      overflow_->Release(stored);
+    }
+    return false;
+  }
+  if (zone_map_ != nullptr) {
+    zone_map_->Update(rid->GetPageId(), tuple);
+  }
+  // The snapshots that began before see no version of the row.
+  versions_.AddVersion(*rid, txn, nullptr);
+  cur_guard.Drop();
+  // Update the transaction's write set.
+  txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this, txn->GetPrevLSN());
+  MarkModified(txn->GetPrevLSN());
+  return true;
+}
+
+bool TableHeap::InsertTuples(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn) {
+  rids->clear();
+  rids->reserve(tuples.size());
+  for (const auto &tuple : tuples) {
+    if (overflow_ == nullptr && tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+  }
+  if (columnar_schema_ != nullptr) {
+    return BulkInsert(tuples, rids, txn);
+  }
+  // Buffered inserts touch no pages.
+  if (txn->IsOptimistic() && txn->GetState() == TransactionState::GROWING) {
+    for (const auto &tuple : tuples) {
+      BufferWrite(RID(), WType::INSERT, tuple, txn);
+      rids->emplace_back();
+    }
+    return true;
+  }
+  if (tuples.empty()) {
+    return true;
+  }
+  if (!LockTable(txn, LockMode::INTENTION_EXCLUSIVE)) {
+    return false;
+  }
 
-  cur_page->WLatch();
-  // Insert into the first page with enough space. If no such page exists, create a new page and insert into that.
-  // INVARIANT: cur_page is WLatched if you leave the loop normally.
-  while (!cur_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
-    auto next_page_id = cur_page->GetNextPageId();
-    // If the next page is a valid page,
-    if (next_page_id != INVALID_PAGE_ID) {
-      // Unlatch and unpin the current page.
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-      // And repeat the process with the next page.
-      cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-      cur_page->WLatch();
+  // The large values are stored out of line before any page is latched. Those of the tuples that are not inserted in
+  // the end are released again.
+  std::vector<Tuple> stored(overflow_ != nullptr ? tuples.size() : 0);
+  std::vector<const Tuple *> prepared;
+  prepared.reserve(tuples.size());
+  auto release_from = [&](size_t begin) {
+    for (size_t i = begin; i < prepared.size(); i++) {
+      if (prepared[i] != &tuples[i]) {
+        overflow_->Release(*prepared[i]);
+      }
+    }
+  };
+  for (size_t i = 0; i < tuples.size(); i++) {
+    prepared.push_back(PrepareTuple(tuples[i], overflow_ != nullptr ? &stored[i] : nullptr, txn));
+    if (prepared.back() == nullptr) {
+      prepared.pop_back();
+      release_from(0);
+      return false;
+    }
+  }
+
+  // The batch stays on a page while the page has room, the page being the one that the thread inserts into anyway.
+  WritePageGuard cur_guard;
+  for (size_t i = 0; i < tuples.size(); i++) {
+    RID rid;
+    if (!InsertIntoAppendPage(*prepared[i], &rid, &cur_guard, txn)) {
+      release_from(i);
+      return false;
+    }
+    if (zone_map_ != nullptr) {
+      zone_map_->Update(rid.GetPageId(), tuples[i]);
+    }
+    versions_.AddVersion(rid, txn, nullptr);
+    // Written right away, so that an abort halfway through the batch rolls back what was inserted.
+    txn->GetWriteSet()->emplace_back(rid, WType::INSERT, Tuple{}, this, txn->GetPrevLSN());
+    rids->push_back(rid);
+  }
+  MarkModified(txn->GetPrevLSN());
+  return true;
+}
+
+bool TableHeap::InsertIntoAppendPage(const Tuple &tuple, RID *rid, WritePageGuard *cur_guard, Transaction *txn) {
+  std::atomic<page_id_t> &append_page_id = append_points_[ThreadNumber() % NUM_APPEND_POINTS].page_id_;
+  page_id_t page_id = cur_guard->IsValid() ? cur_guard->PageId() : append_page_id.load();
+  while (true) {
+    if (!cur_guard->IsValid() && page_id != INVALID_PAGE_ID) {
+      *cur_guard = buffer_pool_manager_->FetchPageWrite(page_id);
+      if (!cur_guard->IsValid()) {
+        txn->SetState(TransactionState::ABORTED);
+        return false;
+      }
+    }
+    if (cur_guard->IsValid()) {
+      const bool inserted = cur_guard->As<TablePage>()->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_, oid_);
+      UpdateFreeSpace(*cur_guard);
+      if (inserted) {
+        cur_guard->SetDirty();
+        return true;
+      }
+    }
+    const page_id_t claimed_page_id = ClaimInsertPage(tuple.size_, page_id, cur_guard, txn);
+    if (claimed_page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+    // A thread that shares the append point may have moved it on already, the page that it claimed is shared then.
+    page_id_t expected = page_id;
+    if (append_page_id.compare_exchange_strong(expected, claimed_page_id)) {
+      page_id = claimed_page_id;
     } else {
-      // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
-      // If we could not create a new page,
-      if (new_page == nullptr) {
-        // Then life sucks and we abort the transaction.
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
+      cur_guard->Drop();
+      free_space_.Release(claimed_page_id);
+      page_id = expected;
+    }
+  }
+}
+
+page_id_t TableHeap::ClaimInsertPage(uint32_t tuple_size, page_id_t released_page_id, WritePageGuard *cur_guard,
+                                     Transaction *txn) {
+  page_id_t page_id = free_space_.ClaimPage(tuple_size, released_page_id);
+  if (page_id != INVALID_PAGE_ID) {
+    // A page that is full is released clean.
+    cur_guard->Drop();
+    return page_id;
+  }
+
+  // No page that is known has room, the table is extended under the write latch of its last page. That is the full
+  // page if it is the last one, else the map knows the last page, or at least one before it if other threads extended
+  // the table since. Until it knows one, the pages are walked from the first one, and the map learns of each of them.
+  WritePageGuard tail_guard;
+  const page_id_t last_page_id = free_space_.GetLastPageId();
+  if (cur_guard->IsValid() && cur_guard->As<TablePage>()->GetNextPageId() == INVALID_PAGE_ID) {
+    tail_guard = std::move(*cur_guard);
+  } else {
+    cur_guard->Drop();
+    tail_guard =
+        buffer_pool_manager_->FetchPageWrite(last_page_id != INVALID_PAGE_ID ? last_page_id : first_page_id_);
+  }
+  if (!tail_guard.IsValid()) {
+    txn->SetState(TransactionState::ABORTED);
+    return INVALID_PAGE_ID;
+  }
+  while (tail_guard.As<TablePage>()->GetNextPageId() != INVALID_PAGE_ID) {
+    UpdateFreeSpace(tail_guard);
+    const page_id_t next_page_id = tail_guard.As<TablePage>()->GetNextPageId();
+    tail_guard.Drop();
+    tail_guard = buffer_pool_manager_->FetchPageWrite(next_page_id);
+    if (!tail_guard.IsValid()) {
+      txn->SetState(TransactionState::ABORTED);
+      return INVALID_PAGE_ID;
+    }
+  }
+  UpdateFreeSpace(tail_guard);
+  if (last_page_id == INVALID_PAGE_ID) {
+    page_id = free_space_.ClaimPage(tuple_size, INVALID_PAGE_ID);
+    if (page_id != INVALID_PAGE_ID) {
+      return page_id;
+    }
+  }
+
+  BasicPageGuard new_guard = buffer_pool_manager_->NewPageInExtentGuarded(tail_guard.PageId(), &page_id);
+  if (!new_guard.IsValid()) {
+    txn->SetState(TransactionState::ABORTED);
+    return INVALID_PAGE_ID;
+  }
+  // Claimed before the map learns of it, the new page is the inserter's own.
+  free_space_.Claim(page_id);
+  WritePageGuard new_write_guard = new_guard.UpgradeWrite();
+  tail_guard.AsMut<TablePage>()->SetNextPageId(page_id);
+  new_write_guard.AsMut<TablePage>()->Init(page_id, PAGE_SIZE, tail_guard.PageId(), log_manager_, txn);
+  page_directory_.Append(page_id);
+  if (zone_map_ != nullptr) {
+    zone_map_->AddPage(page_id, tail_guard.PageId());
+  }
+  UpdateFreeSpace(new_write_guard);
+  *cur_guard = std::move(new_write_guard);
+  return page_id;
+}
+
+void TableHeap::UpdateFreeSpace(const WritePageGuard &guard) {
+  auto page = guard.As<TablePage>();
+  free_space_.Update(guard.PageId(), page->GetMaxInsertSize());
+  if (page->GetNextPageId() == INVALID_PAGE_ID) {
+    free_space_.SetLastPageId(guard.PageId());
+  }
+}
+
+bool TableHeap::BulkInsert(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn) {
+  for (const auto &tuple : tuples) {
+    if (tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+  }
+  if (!LockTable(txn, LockMode::EXCLUSIVE)) {
+    return false;
+  }
+  if (rids != nullptr) {
+    rids->clear();
+    rids->reserve(tuples.size());
+  }
+  if (tuples.empty()) {
+    return true;
+  }
+
+  // Find the last page of the table.
+  const page_id_t bulk_page_id = bulk_page_id_;
+  WritePageGuard cur_guard =
+      buffer_pool_manager_->FetchPageWrite(bulk_page_id != INVALID_PAGE_ID ? bulk_page_id : first_page_id_);
+  if (!cur_guard.IsValid()) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  while (cur_guard.As<TablePage>()->GetNextPageId() != INVALID_PAGE_ID) {
+    const page_id_t next_page_id = cur_guard.As<TablePage>()->GetNextPageId();
+    cur_guard.Drop();
+    cur_guard = buffer_pool_manager_->FetchPageWrite(next_page_id);
+    if (!cur_guard.IsValid()) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+  }
+  // Undoing an image removes all tuples of its page, so the load starts on a page that has none yet, or only its own.
+  if (cur_guard.As<TablePage>()->GetTupleCount() > 0 && !IsOwnBulkPage(cur_guard.PageId(), txn)) {
+    page_id_t next_page_id;
+    BasicPageGuard new_guard = buffer_pool_manager_->NewPageInExtentGuarded(cur_guard.PageId(), &next_page_id);
+    if (!new_guard.IsValid()) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    WritePageGuard new_write_guard = new_guard.UpgradeWrite();
+    cur_guard.AsMut<TablePage>()->SetNextPageId(next_page_id);
+    new_write_guard.AsMut<TablePage>()->Init(next_page_id, PAGE_SIZE, cur_guard.PageId(), log_manager_, txn);
+    page_directory_.Append(next_page_id);
+    if (zone_map_ != nullptr) {
+      zone_map_->AddPage(next_page_id, cur_guard.PageId());
+    }
+    cur_guard = std::move(new_write_guard);
+  }
+
+  // Log the image of the current page, which also creates the page that the load continues on.
+  auto log_image = [&](page_id_t next_page_id) {
+    auto *cur_page = cur_guard.AsMut<TablePage>();
+    cur_page->SetNextPageId(next_page_id);
+    cur_page->LogImage(next_page_id, txn, log_manager_);
+    txn->GetWriteSet()->emplace_back(RID(cur_guard.PageId(), 0), WType::BULKINSERT, Tuple{}, this, txn->GetPrevLSN());
+    MarkModified(txn->GetPrevLSN());
+  };
+  Tuple encoded;
+  for (const auto &tuple : tuples) {
+    RID rid;
+    // The strings of a dictionary encoded table are stored as their codes.
+    if (table_schema_ != nullptr) {
+      EncodeTuple(tuple, &encoded);
+    }
+    // The page is not unpinned before its image is logged, so its unlogged tuples cannot be written back.
+    auto append = [&]() {
+      return columnar_schema_ != nullptr
+                 ? cur_guard.AsMut<ColumnarTablePage>()->AppendTuple(
+                       *columnar_schema_, table_schema_ != nullptr ? encoded : tuple, &rid)
+                 : cur_guard.AsMut<TablePage>()->AppendTuple(tuple, &rid);
+    };
+    while (!append()) {
+      page_id_t next_page_id;
+      BasicPageGuard new_guard = buffer_pool_manager_->NewPageInExtentGuarded(cur_guard.PageId(), &next_page_id);
+      if (!new_guard.IsValid()) {
+        log_image(INVALID_PAGE_ID);
+        bulk_page_id_ = cur_guard.PageId();
         txn->SetState(TransactionState::ABORTED);
         return false;
       }
-      // Otherwise we were able to create a new page. We initialize it now.
-      new_page->WLatch();
-      cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-      cur_page = new_page;
-    }
-  }
-  // This line has caused most of us to double-take and "whoa double unlatch".
-  // We are not, in fact, double unlatching. See the invariant above.
-  cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-  // Update the transaction's write set.
-  txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
+      WritePageGuard new_write_guard = new_guard.UpgradeWrite();
+      new_write_guard.AsMut<TablePage>()->Init(next_page_id, PAGE_SIZE, cur_guard.PageId(), nullptr, txn);
+      page_directory_.Append(next_page_id);
+      if (zone_map_ != nullptr) {
+        zone_map_->AddPage(next_page_id, cur_guard.PageId());
+      }
+      log_image(next_page_id);
+      cur_guard = std::move(new_write_guard);
+    }
+    if (zone_map_ != nullptr) {
+      zone_map_->Update(rid.GetPageId(), tuple);
+    }
+    if (rids != nullptr) {
+      rids->push_back(rid);
+    }
+  }
+  log_image(INVALID_PAGE_ID);
+  bulk_page_id_ = cur_guard.PageId();
+  if (columnar_schema_ == nullptr) {
+    UpdateFreeSpace(cur_guard);
+  }
+  return true;
+}
+
+bool TableHeap::Truncate(Transaction *txn) {
+  if (columnar_schema_ != nullptr || txn->IsOptimistic()) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  if (!LockTable(txn, LockMode::EXCLUSIVE)) {
+    return false;
+  }
+  // No vacuum unlinks a page from the chain while it is cut off.
+  std::scoped_lock lock(vacuum_latch_);
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(first_page_id_);
+  if (!guard.IsValid()) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  // The write record keeps the image of the first page, which an abort copies back, followed by the pages after it,
+  // which a commit retires. It is serialized like a tuple.
+  const std::vector<page_id_t> page_ids = page_directory_.GetPageIds(1, page_directory_.GetNumPages());
+  const auto size = static_cast<uint32_t>(PAGE_SIZE + page_ids.size() * sizeof(page_id_t));
+  std::vector<char> storage(sizeof(uint32_t) + size);
+  memcpy(storage.data(), &size, sizeof(uint32_t));
+  memcpy(storage.data() + sizeof(uint32_t), guard.GetData(), PAGE_SIZE);
+  memcpy(storage.data() + sizeof(uint32_t) + PAGE_SIZE, page_ids.data(), page_ids.size() * sizeof(page_id_t));
+  Tuple truncated;
+  truncated.DeserializeFrom(storage.data());
+
+  guard.AsMut<TablePage>()->Truncate(txn, log_manager_);
+  txn->GetWriteSet()->emplace_back(RID(first_page_id_, 0), WType::TRUNCATE, truncated, this, txn->GetPrevLSN());
+  ResetPages(false);
+  UpdateFreeSpace(guard);
+  MarkModified(txn->GetPrevLSN());
   return true;
 }
 
 bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
-  // TODO(Amadou): remove empty page
+  if (columnar_schema_ != nullptr) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  if (BufferWrite(rid, WType::DELETE, Tuple{}, txn)) {
+    return true;
+  }
+  if (!LockTable(txn, LockMode::INTENTION_EXCLUSIVE)) {
+    return false;
+  }
+  if (txn->IsSnapshot() && !LockRowExclusive(rid, txn)) {
+    return false;
+  }
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  // Otherwise, mark the tuple as deleted.
-  page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
-  // Update the transaction's write set.
-  txn->GetWriteSet()->emplace_back(rid, WType::DELETE, Tuple{}, this);
+  // A snapshot must not delete a row that was changed after its begin.
+  if (txn->IsSnapshot() && !versions_.CanWrite(rid, txn)) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  // Otherwise, mark the tuple as deleted, keeping the version that the snapshots see until the delete commits.
+  Tuple old_tuple;
+  const bool exists = TablePage::CopyTuple(guard.GetData(), rid, &old_tuple);
+  old_tuple.SetOverflowStore(overflow_.get());
+  if (guard.AsMut<TablePage>()->MarkDelete(rid, txn, lock_manager_, log_manager_, oid_) && exists) {
+    versions_.AddVersion(rid, txn, &old_tuple);
+  }
+  guard.Drop();
+  // Update the transaction's write set. The commit listeners learn what was deleted from it.
+  txn->GetWriteSet()->emplace_back(rid, WType::DELETE, has_listeners_ ? old_tuple : Tuple{}, this, txn->GetPrevLSN());
+  MarkModified(txn->GetPrevLSN());
   return true;
 }
 
 bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) {
+  if (columnar_schema_ != nullptr) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  if (BufferWrite(rid, WType::UPDATE, tuple, txn)) {
+    return true;
+  }
+  if (!LockTable(txn, LockMode::INTENTION_EXCLUSIVE)) {
+    return false;
+  }
+  if (txn->IsSnapshot() && !LockRowExclusive(rid, txn)) {
+    return false;
+  }
+  // A rollback puts back the version before the update as it was, values stored out of line and all.
+  Tuple stored;
+  const Tuple *prepared = &tuple;
+  if (txn->GetState() != TransactionState::ABORTED) {
+    prepared = PrepareTuple(tuple, &stored, txn);
+    if (prepared == nullptr) {
+      return false;
+    }
+  }
+  auto release_prepared = [&]() {
+    if (prepared == &stored) {
+      overflow_->Release(stored);
+    }
+  };
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
+    release_prepared();
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  // A snapshot must not update a row that was changed after its begin.
+  if (txn->IsSnapshot() && !versions_.CanWrite(rid, txn)) {
+    release_prepared();
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Update the tuple; but first save the old value for rollbacks.
   Tuple old_tuple;
-  page->WLatch();
-  bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
-  // Update the transaction's write set.
+  bool is_updated =
+      guard.As<TablePage>()->UpdateTuple(*prepared, &old_tuple, rid, txn, lock_manager_, log_manager_, oid_);
+  if (is_updated) {
+    guard.SetDirty();
+    if (zone_map_ != nullptr) {
+      zone_map_->Update(rid.GetPageId(), tuple);
+    }
+    // An aborted transaction updates to roll back an update, which puts back the version before it. The values that
+    // the update stored out of line are seen by nobody then.
+    if (txn->GetState() == TransactionState::ABORTED) {
+      versions_.Rollback(rid, txn);
+      if (overflow_ != nullptr) {
+        overflow_->Release(old_tuple);
+      }
+    } else {
+      old_tuple.SetOverflowStore(overflow_.get());
+      versions_.AddVersion(rid, txn, &old_tuple);
+    }
+  } else {
+    release_prepared();
+  }
+  guard.Drop();
+  // Update the transaction's write set. With logging on, an abort reads the tuple before the update back from the
+  // log, see RollbackUpdate(), unless the commit needs it anyway.
   if (is_updated && txn->GetState() != TransactionState::ABORTED) {
-    txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
+    const bool keep_old_tuple = !enable_logging || log_manager_ == nullptr || overflow_ != nullptr || has_listeners_;
+    txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, keep_old_tuple ? old_tuple : Tuple{}, this,
+                                     txn->GetPrevLSN());
+  }
+  if (is_updated) {
+    MarkModified(txn->GetPrevLSN());
   }
   return is_updated;
 }
 
+void TableHeap::ApplyUpdate(const Tuple &old_tuple) {
+  if (overflow_ != nullptr) {
+    overflow_->Release(old_tuple);
+  }
+}
+
 void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
-  // Delete the tuple from the page.
-  page->WLatch();
-  page->ApplyDelete(rid, txn, log_manager_);
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ASSERT(guard.IsValid(), "Couldn't find a page containing that RID.");
+  // Delete the tuple from the page, whose space is free for the inserts again, and release what it stored out of line.
+  Tuple deleted_tuple;
+  guard.AsMut<TablePage>()->ApplyDelete(rid, txn, log_manager_, overflow_ != nullptr ? &deleted_tuple : nullptr);
+  if (overflow_ != nullptr) {
+    overflow_->Release(deleted_tuple);
+  }
+  UpdateFreeSpace(guard);
+  // Rolling back an insert removes the version of the insert, committing a delete leaves it to the snapshots.
+  if (txn->GetState() == TransactionState::ABORTED) {
+    versions_.Rollback(rid, txn);
+  }
   lock_manager_->Unlock(txn, rid);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+}
+
+void TableHeap::RollbackBulkInsert(page_id_t page_id, Transaction *txn) {
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  BUSTUB_ASSERT(guard.IsValid(), "Couldn't find the page of the bulk insert.");
+  // The page is logged as a whole again, now without the tuples.
+  auto *page = guard.AsMut<TablePage>();
+  page->RemoveAllTuples();
+  page->LogImage(INVALID_PAGE_ID, txn, log_manager_);
+  if (columnar_schema_ == nullptr) {
+    UpdateFreeSpace(guard);
+  }
+}
+
+void TableHeap::ApplyTruncate(const Tuple &truncated, TransactionManager *transaction_manager) {
+  const auto num_pages = (truncated.GetLength() - PAGE_SIZE) / sizeof(page_id_t);
+  std::vector<page_id_t> page_ids(num_pages);
+  memcpy(page_ids.data(), truncated.GetData() + PAGE_SIZE, num_pages * sizeof(page_id_t));
+  std::scoped_lock lock(vacuum_latch_);
+  RetirePages(std::move(page_ids), transaction_manager);
+}
+
+void TableHeap::RollbackTruncate(const Tuple &truncated, TransactionManager *transaction_manager, Transaction *txn) {
+  std::scoped_lock lock(vacuum_latch_);
+  {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(first_page_id_);
+    BUSTUB_ASSERT(guard.IsValid(), "Couldn't find the first page of the truncated table.");
+    // The pages that the transaction added since the truncation are cut off in turn.
+    RetirePages(page_directory_.GetPageIds(1, page_directory_.GetNumPages()), transaction_manager);
+    // The page is logged as a whole again, now with the tuples and the link that it had.
+    memcpy(guard.GetDataMut(), truncated.GetData(), PAGE_SIZE);
+    guard.AsMut<TablePage>()->LogImage(INVALID_PAGE_ID, txn, log_manager_);
+  }
+  ResetPages(true);
+}
+
+void TableHeap::RollbackUpdate(const RID &rid, lsn_t lsn, LogReadBuffer *log_buffer, Transaction *txn) {
+  LogRecord log_record;
+  const bool found = log_manager_->ReadLogRecord(lsn, &log_record, log_buffer);
+  BUSTUB_ASSERT(found && log_record.GetLogRecordType() == LogRecordType::UPDATE, "Couldn't read back the update.");
+  // The transaction still holds the lock of the row, so the tuple is the one that the update left.
+  Tuple new_tuple;
+  {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(rid.GetPageId());
+    BUSTUB_ASSERT(guard.IsValid(), "Couldn't find a page containing that RID.");
+    const bool exists = TablePage::CopyTuple(guard.GetData(), rid, &new_tuple);
+    BUSTUB_ASSERT(exists, "Couldn't find the tuple of the update.");
+  }
+  UpdateTuple(log_record.GetOldTuple(new_tuple), rid, txn);
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ASSERT(guard.IsValid(), "Couldn't find a page containing that RID.");
   // Rollback the delete.
-  page->WLatch();
-  page->RollbackDelete(rid, txn, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  guard.AsMut<TablePage>()->RollbackDelete(rid, txn, log_manager_);
+  versions_.Rollback(rid, txn);
+}
+
+size_t TableHeap::AddCommitListener(CommitListener listener) {
+  std::scoped_lock lock(listener_latch_);
+  listeners_.emplace_back(next_listener_id_, std::move(listener));
+  has_listeners_ = true;
+  return next_listener_id_++;
+}
+
+void TableHeap::RemoveCommitListener(size_t listener_id) {
+  std::scoped_lock lock(listener_latch_);
+  listeners_.erase(std::remove_if(listeners_.begin(), listeners_.end(),
+                                  [listener_id](const auto &listener) { return listener.first == listener_id; }),
+                   listeners_.end());
+  has_listeners_ = !listeners_.empty();
+}
+
+void TableHeap::PublishCommit(Transaction *txn) {
+  std::scoped_lock lock(listener_latch_);
+  if (listeners_.empty()) {
+    return;
+  }
+  const auto &write_set = *txn->GetWriteSet();
+  TableChange change;
+  // Nothing that the table had before a truncation is left, nor are the writes before it.
+  size_t begin = 0;
+  for (size_t i = 0; i < write_set.size(); i++) {
+    if (write_set[i].table_ == this && write_set[i].wtype_ == WType::TRUNCATE) {
+      begin = i + 1;
+      change.truncated_ = true;
+    }
+  }
+  // The pages that a bulk insert filled hold tuples of the transaction only, they are read as a whole.
+  std::unordered_set<page_id_t> bulk_page_ids;
+  for (size_t i = begin; i < write_set.size(); i++) {
+    if (write_set[i].table_ == this && write_set[i].wtype_ == WType::BULKINSERT) {
+      bulk_page_ids.insert(write_set[i].rid_.GetPageId());
+    }
+  }
+  for (const page_id_t page_id : bulk_page_ids) {
+    page_id_t next_page_id;
+    auto add = [&](const RID &/*rid*/, const char *data, uint32_t size) {
+      change.added_.emplace_back(data, size);
+      change.added_.back().SetOverflowStore(overflow_.get());
+    };
+    if (!ScanPageInPlace(page_id, nullptr, &next_page_id, add)) {
+      change.incomplete_ = true;
+    }
+  }
+  // Of every other row, the first write knows what it was before the transaction, and the page what it is now: the
+  // transaction still holds its lock, and its deletes are not applied yet.
+  std::unordered_set<RID> rids;
+  for (size_t i = begin; i < write_set.size(); i++) {
+    const WriteRecord &item = write_set[i];
+    if (item.table_ != this || item.wtype_ == WType::BULKINSERT || item.wtype_ == WType::TRUNCATE ||
+        bulk_page_ids.count(item.rid_.GetPageId()) > 0 || !rids.insert(item.rid_).second) {
+      continue;
+    }
+    if (item.wtype_ != WType::INSERT) {
+      if (item.tuple_.GetLength() > 0) {
+        change.removed_.push_back(item.tuple_);
+      } else {
+        change.incomplete_ = true;
+      }
+    }
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(item.rid_.GetPageId());
+    Tuple tuple;
+    if (!guard.IsValid()) {
+      change.incomplete_ = true;
+    } else if (CopyTuple(guard.GetData(), item.rid_, &tuple)) {
+      change.added_.push_back(std::move(tuple));
+    }
+  }
+  if (!change.truncated_ && !change.incomplete_ && change.removed_.empty() && change.added_.empty()) {
+    return;
+  }
+  for (const auto &[listener_id, listener] : listeners_) {
+    listener(change);
+  }
 }
 
 bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
+  // The tuples that are copied into it, e.g. versions, know the store as well.
+  tuple->SetOverflowStore(overflow_.get());
+  if (txn->IsOptimistic()) {
+    // The latest buffered write of the row is what the transaction reads, only rows read from the table are validated.
+    auto write_buffer = txn->GetWriteBuffer();
+    for (auto it = write_buffer->rbegin(); it != write_buffer->rend(); ++it) {
+      if (it->table_ == this && it->rid_ == rid && it->wtype_ != WType::INSERT) {
+        if (it->wtype_ == WType::DELETE) {
+          return false;
+        }
+        *tuple = it->tuple_;
+        tuple->rid_ = rid;
+        return true;
+      }
+    }
+    txn->GetReadSet()->emplace_back(rid, this);
+  }
+  if (!enable_logging || txn->IsSnapshot()) {
+    // Without logging, reads take no tuple locks, so the tuple can be copied out of the page optimistically. A snapshot
+    // takes none either, it replaces the copy by the version that it sees afterwards.
+    bool exists = false;
+    if (!buffer_pool_manager_->ReadPageOptimistic(
+            rid.GetPageId(), [&](const char *data) { exists = CopyTuple(data, rid, tuple); })) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    return txn->IsSnapshot() ? versions_.Read(rid, txn, exists, tuple) : exists;
+  }
+  // A scan that locked the whole table reads its rows without row locks.
+  const bool covered = oid_ != INVALID_TABLE_OID && txn->IsTableSharedLocked(oid_);
+  if (!covered && !LockTable(txn, LockMode::INTENTION_SHARED)) {
+    return false;
+  }
   // Find the page which contains the tuple.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
+  // The writers of a columnar table lock all of it, which the intention lock conflicts with already.
+  if (columnar_schema_ != nullptr) {
+    return CopyTuple(guard.GetData(), rid, tuple);
+  }
   // Read the tuple from the page.
-  page->RLatch();
-  bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
-  return res;
+  return guard.As<TablePage>()->GetTuple(rid, tuple, txn, covered ? nullptr : lock_manager_, oid_);
 }
 
-TableIterator TableHeap::Begin(Transaction *txn) {
+bool TableHeap::GetTupleRef(const RID &rid, TupleRef *ref, Transaction *txn) {
+  ref->Release();
+  if (columnar_schema_ != nullptr || !ReadsInPlace(txn)) {
+    return GetTuple(rid, &ref->tuple_, txn);
+  }
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(rid.GetPageId());
+  if (!guard.IsValid()) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  // Reading in place, the transaction takes no row locks.
+  ref->tuple_.SetOverflowStore(overflow_.get());
+  if (!guard.As<TablePage>()->GetTuple(rid, &ref->tuple_, txn, nullptr, oid_, true)) {
+    return false;
+  }
+  ref->guard_ = std::move(guard);
+  return true;
+}
+
+TableIterator TableHeap::Begin(Transaction *txn, BufferRing *ring) {
   // Start an iterator from the first page.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPageForScan(first_page_id_, ring));
   page->RLatch();
   RID rid;
   // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
-  page->GetFirstTupleRid(&rid);
+  if (columnar_schema_ != nullptr) {
+    reinterpret_cast<ColumnarTablePage *>(page)->GetFirstTupleRid(&rid);
+  } else {
+    page->GetFirstTupleRid(&rid, txn->IsSnapshot());
+  }
   page->RUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, false);
-  return TableIterator(this, rid, txn);
+  return TableIterator(this, rid, txn, ring);
+}
+
+TableIterator TableHeap::BeginRange(Transaction *txn, std::vector<page_id_t> page_ids, BufferRing *ring) {
+  // The iterator starts at the first tuple of the range, which need not be on its first page.
+  auto pages = std::make_shared<const std::vector<page_id_t>>(std::move(page_ids));
+  const bool columnar = columnar_schema_ != nullptr;
+  for (size_t page_idx = 0; page_idx < pages->size(); page_idx++) {
+    const page_id_t page_id = (*pages)[page_idx];
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPageForScan(page_id, ring));
+    if (page == nullptr) {
+      txn->SetState(TransactionState::ABORTED);
+      break;
+    }
+    page->RLatch();
+    RID rid;
+    const bool found = columnar ? reinterpret_cast<ColumnarTablePage *>(page)->GetFirstTupleRid(&rid)
+                                : page->GetFirstTupleRid(&rid, txn->IsSnapshot());
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (found) {
+      return TableIterator(this, rid, txn, ring, std::move(pages), page_idx);
+    }
+  }
+  return End();
 }
 
 TableIterator TableHeap::End() { return TableIterator(this, RID(INVALID_PAGE_ID, 0), nullptr); }
 
+bool TableHeap::ScanPage(page_id_t page_id, Transaction *txn, std::vector<Tuple> *tuples) {
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  // The slots are listed under the latch, and read after it is let go of: GetTuple() latches the page on its own.
+  std::vector<RID> rids;
+  page->RLatch();
+  if (columnar_schema_ != nullptr) {
+    const uint32_t tuple_count = reinterpret_cast<ColumnarTablePage *>(page)->GetTupleCount();
+    for (uint32_t slot_num = 0; slot_num < tuple_count; slot_num++) {
+      rids.emplace_back(page_id, slot_num);
+    }
+  } else {
+    RID rid;
+    if (page->GetFirstTupleRid(&rid, txn->IsSnapshot())) {
+      rids.push_back(rid);
+      while (page->GetNextTupleRid(rids.back(), &rid, txn->IsSnapshot())) {
+        rids.push_back(rid);
+      }
+    }
+  }
+  page->RUnlatch();
+  for (const RID &slot : rids) {
+    Tuple tuple;
+    if (GetTuple(slot, &tuple, txn)) {
+      tuples->push_back(std::move(tuple));
+    }
+  }
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return true;
+}
+
+page_id_t TableHeap::GetNextPageId(page_id_t page_id) {
+  page_id_t next_page_id;
+  if (zone_map_ != nullptr && zone_map_->GetNextPageId(page_id, &next_page_id)) {
+    return next_page_id;
+  }
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr) {
+    return INVALID_PAGE_ID;
+  }
+  page->RLatch();
+  next_page_id = page->GetNextPageId();
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return next_page_id;
+}
+
+size_t TableHeap::Vacuum(TransactionManager *transaction_manager) {
+  if (columnar_schema_ != nullptr) {
+    return 0;
+  }
+  std::scoped_lock lock(vacuum_latch_);
+  // The rows whose older versions nobody reads anymore free their slots.
+  if (transaction_manager != nullptr) {
+    versions_.PruneAll(transaction_manager->GetWatermark());
+  }
+  // The pages are latched in the order of the chain, like the inserters and the scans do, but the vacuum only waits
+  // for a latch while it holds none.
+  std::vector<page_id_t> unlinked;
+  WritePageGuard prev_guard = buffer_pool_manager_->FetchPageWrite(first_page_id_);
+  if (prev_guard.IsValid()) {
+    TrimPage(&prev_guard);
+  }
+  while (prev_guard.IsValid() && prev_guard.As<TablePage>()->GetNextPageId() != INVALID_PAGE_ID) {
+    const page_id_t page_id = prev_guard.As<TablePage>()->GetNextPageId();
+    WritePageGuard cur_guard = TryFetchPageWrite(page_id);
+    if (!cur_guard.IsValid()) {
+      prev_guard.Drop();
+      prev_guard = buffer_pool_manager_->FetchPageWrite(page_id);
+      if (prev_guard.IsValid()) {
+        TrimPage(&prev_guard);
+      }
+      continue;
+    }
+    const page_id_t next_page_id = cur_guard.As<TablePage>()->GetNextPageId();
+    if (next_page_id != INVALID_PAGE_ID && cur_guard.As<TablePage>()->IsEmpty()) {
+      WritePageGuard next_guard = TryFetchPageWrite(next_page_id);
+      if (next_guard.IsValid() && UnlinkPage(&prev_guard, &cur_guard, &next_guard)) {
+        unlinked.push_back(page_id);
+        continue;
+      }
+    }
+    TrimPage(&cur_guard);
+    prev_guard = std::move(cur_guard);
+  }
+  prev_guard.Drop();
+
+  // Only the transactions that are active by now may have read a link to a page that was unlinked, or a version that
+  // points to a chain that was released.
+  std::vector<page_id_t> released;
+  if (overflow_ != nullptr) {
+    released = overflow_->TakeReleased();
+  }
+  if (!unlinked.empty() || !released.empty()) {
+    RetiredPages retired{std::move(unlinked), std::move(released), {}};
+    if (transaction_manager != nullptr) {
+      retired.txn_ids_ = transaction_manager->GetActiveTxnIds();
+    }
+    retired_pages_.push_back(std::move(retired));
+  }
+  std::unordered_set<txn_id_t> active_txn_ids;
+  if (transaction_manager != nullptr) {
+    for (txn_id_t txn_id : transaction_manager->GetActiveTxnIds()) {
+      active_txn_ids.insert(txn_id);
+    }
+  }
+  size_t num_deallocated = 0;
+  for (auto it = retired_pages_.begin(); it != retired_pages_.end();) {
+    auto &txn_ids = it->txn_ids_;
+    txn_ids.erase(std::remove_if(txn_ids.begin(), txn_ids.end(),
+                                 [&](txn_id_t txn_id) { return active_txn_ids.count(txn_id) == 0; }),
+                  txn_ids.end());
+    if (!txn_ids.empty()) {
+      ++it;
+      continue;
+    }
+    for (page_id_t chain_page_id : it->chain_page_ids_) {
+      num_deallocated += overflow_->FreeChain(chain_page_id);
+    }
+    it->chain_page_ids_.clear();
+    // A page that is still pinned, e.g. by a prefetch, is deallocated by the next vacuum.
+    auto &page_ids = it->page_ids_;
+    page_ids.erase(std::remove_if(page_ids.begin(), page_ids.end(),
+                                  [&](page_id_t page_id) {
+                                    const bool deleted = buffer_pool_manager_->DeletePage(page_id);
+                                    num_deallocated += deleted ? 1 : 0;
+                                    return deleted;
+                                  }),
+                   page_ids.end());
+    it = page_ids.empty() ? retired_pages_.erase(it) : it + 1;
+  }
+  return num_deallocated;
+}
+
+WritePageGuard TableHeap::TryFetchPageWrite(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    return {};
+  }
+  if (!page->TryWLatch()) {
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return {};
+  }
+  return {buffer_pool_manager_, page};
+}
+
+void TableHeap::TrimPage(WritePageGuard *guard) {
+  const page_id_t page_id = guard->PageId();
+  const uint32_t num_trimmed = guard->As<TablePage>()->TrimEmptySlots(
+      [&](uint32_t slot_num) { return versions_.HasChain(RID(page_id, slot_num)); });
+  if (num_trimmed == 0) {
+    return;
+  }
+  guard->SetDirty();
+  UpdateFreeSpace(*guard);
+  WriteBackVacuumed(guard);
+}
+
+bool TableHeap::UnlinkPage(WritePageGuard *prev_guard, WritePageGuard *cur_guard, WritePageGuard *next_guard) {
+  const page_id_t page_id = cur_guard->PageId();
+  // The next bulk insert starts looking for the end of the table on the page of the last one.
+  if (page_id == bulk_page_id_) {
+    return false;
+  }
+  const uint32_t tuple_count = cur_guard->As<TablePage>()->GetTupleCount();
+  for (uint32_t slot_num = 0; slot_num < tuple_count; slot_num++) {
+    if (versions_.HasChain(RID(page_id, slot_num))) {
+      return false;
+    }
+  }
+  // An inserter only inserts into a page that it claimed, which the map does not hand out anymore once it forgot it.
+  // One that got to the page before fails to insert into it, and the append points let go of it.
+  if (!free_space_.Remove(page_id)) {
+    return false;
+  }
+  for (auto &append_point : append_points_) {
+    page_id_t expected = page_id;
+    append_point.page_id_.compare_exchange_strong(expected, INVALID_PAGE_ID);
+  }
+  cur_guard->AsMut<TablePage>()->MarkUnlinked();
+  prev_guard->AsMut<TablePage>()->SetNextPageId(next_guard->PageId());
+  next_guard->AsMut<TablePage>()->SetPrevPageId(prev_guard->PageId());
+  page_directory_.Remove(page_id);
+  if (zone_map_ != nullptr) {
+    zone_map_->RemovePage(page_id, prev_guard->PageId(), next_guard->PageId());
+  }
+  WriteBackVacuumed(prev_guard);
+  WriteBackVacuumed(cur_guard);
+  WriteBackVacuumed(next_guard);
+  return true;
+}
+
+void TableHeap::ResetPages(bool rebuild) {
+  page_directory_.Clear();
+  free_space_.Clear();
+  for (auto &append_point : append_points_) {
+    append_point.page_id_ = INVALID_PAGE_ID;
+  }
+  bulk_page_id_ = INVALID_PAGE_ID;
+  if (zone_map_ != nullptr) {
+    zone_map_->Clear();
+  }
+  if (!rebuild) {
+    page_directory_.Append(first_page_id_);
+    if (zone_map_ != nullptr) {
+      zone_map_->AddPage(first_page_id_, INVALID_PAGE_ID);
+    }
+    return;
+  }
+  // Like a heap that was just opened, the free space map learns of the pages as the inserts pass them.
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID; page_id = GetNextPageId(page_id)) {
+    page_directory_.Append(page_id);
+  }
+  if (zone_map_ != nullptr) {
+    FillZoneMap(zone_map_.get());
+  }
+}
+
+void TableHeap::RetirePages(std::vector<page_id_t> page_ids, TransactionManager *transaction_manager) {
+  if (page_ids.empty()) {
+    return;
+  }
+  RetiredPages retired{std::move(page_ids), {}, {}};
+  if (transaction_manager != nullptr) {
+    retired.txn_ids_ = transaction_manager->GetActiveTxnIds();
+  }
+  retired_pages_.push_back(std::move(retired));
+}
+
+void TableHeap::WriteBackVacuumed(WritePageGuard *guard) {
+  if (!enable_logging || log_manager_ == nullptr) {
+    return;
+  }
+  // The records of a page are appended while it is latched, so the page holds the changes of all records so far.
+  auto page = guard->As<TablePage>();
+  page->SetLSN(std::max(page->GetLSN(), log_manager_->GetNextLSN() - 1));
+  buffer_pool_manager_->FlushPage(guard->PageId());
+}
+
+bool TableHeap::IsOwnBulkPage(page_id_t page_id, Transaction *txn) const {
+  const auto *write_set = txn->GetWriteSet();
+  return !write_set->empty() && write_set->back().wtype_ == WType::BULKINSERT && write_set->back().table_ == this &&
+         write_set->back().rid_.GetPageId() == page_id;
+}
+
+void TableHeap::UseColumnarLayout(const Schema &schema) {
+  // The pages hold the code of a VARCHAR column in its place, which is as wide as the offset of its data was.
+  std::vector<Column> columns;
+  dictionaries_.clear();
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    const Column &column = schema.GetColumn(i);
+    dictionaries_.emplace_back();
+    if (column.GetType() == TypeId::VARCHAR) {
+      columns.emplace_back(column.GetName(), TypeId::INTEGER);
+      dictionaries_.back() = std::make_unique<ColumnDictionary>();
+    } else {
+      BUSTUB_ASSERT(column.IsInlined(), "The columns of a columnar table must be inlined or VARCHAR.");
+      columns.push_back(column);
+    }
+  }
+  columnar_schema_ = std::make_unique<Schema>(columns);
+  overflow_.reset();
+  if (schema.IsInlined()) {
+    dictionaries_.clear();
+  } else {
+    table_schema_ = std::make_unique<Schema>(schema);
+  }
+}
+
+bool TableHeap::CopyTuple(const char *data, const RID &rid, Tuple *tuple) const {
+  if (columnar_schema_ == nullptr) {
+    tuple->SetOverflowStore(overflow_.get());
+    return TablePage::CopyTuple(data, rid, tuple);
+  }
+  if (table_schema_ == nullptr) {
+    return ColumnarTablePage::CopyTuple(data, *columnar_schema_, rid, tuple);
+  }
+  Tuple encoded;
+  if (!ColumnarTablePage::CopyTuple(data, *columnar_schema_, rid, &encoded)) {
+    return false;
+  }
+  DecodeTuple(encoded, tuple);
+  tuple->SetRid(rid);
+  return true;
+}
+
+void TableHeap::EncodeTuple(const Tuple &tuple, Tuple *encoded) {
+  std::vector<Value> values;
+  values.reserve(table_schema_->GetColumnCount());
+  for (uint32_t i = 0; i < table_schema_->GetColumnCount(); i++) {
+    if (dictionaries_[i] == nullptr) {
+      values.push_back(tuple.GetValueView(table_schema_.get(), i));
+    } else if (tuple.IsNull(table_schema_.get(), i)) {
+      values.push_back(ValueFactory::GetIntegerValue(BUSTUB_INT32_NULL));
+    } else {
+      const int32_t code = dictionaries_[i]->Encode(tuple.GetStringView(table_schema_.get(), i));
+      values.push_back(ValueFactory::GetIntegerValue(code));
+    }
+  }
+  encoded->SetValues(values, columnar_schema_.get());
+}
+
+void TableHeap::DecodeTuple(const Tuple &encoded, Tuple *tuple) const {
+  std::vector<Value> values;
+  values.reserve(table_schema_->GetColumnCount());
+  for (uint32_t i = 0; i < table_schema_->GetColumnCount(); i++) {
+    if (dictionaries_[i] == nullptr) {
+      values.push_back(encoded.GetValue(columnar_schema_.get(), i));
+    } else {
+      values.push_back(dictionaries_[i]->Decode(encoded.GetInt32(columnar_schema_.get(), i)));
+    }
+  }
+  tuple->SetValues(values, table_schema_.get());
+}
+
+void TableHeap::EnableOverflow(const Schema &schema) {
+  // A table whose columns are all inlined has no value to store out of line.
+  if (columnar_schema_ == nullptr && !schema.IsInlined()) {
+    overflow_ = std::make_unique<OverflowStore>(buffer_pool_manager_, schema);
+  }
+}
+
+void TableHeap::EnableZoneMap(const Schema &schema) {
+  auto zone_map = std::make_unique<ZoneMap>(schema);
+  FillZoneMap(zone_map.get());
+  zone_map_ = std::move(zone_map);
+}
+
+void TableHeap::FillZoneMap(ZoneMap *zone_map) {
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    zone_map->AddPage(page_id, prev_page_id);
+    prev_page_id = page_id;
+    auto update = [zone_map](const RID &rid, const char *data, uint32_t size) {
+      zone_map->Update(rid.GetPageId(), Tuple(data, size));
+    };
+    if (!ScanPageInPlace(page_id, nullptr, &page_id, update)) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for a page of the table heap.");
+    }
+  }
+}
+
 }  // namespace bustub
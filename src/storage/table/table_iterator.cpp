@@ -16,10 +16,24 @@
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
-  if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferRing *ring)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), ring_(ring) {
+  // A snapshot starts at the first slot, which may hold no row that it sees.
+  if (rid.GetPageId() != INVALID_PAGE_ID && !table_heap_->GetTuple(tuple_->rid_, tuple_, txn_) && txn_->IsSnapshot()) {
+    ++(*this);
+  }
+}
+
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferRing *ring,
+                             std::shared_ptr<const std::vector<page_id_t>> page_ids, size_t page_idx)
+    : table_heap_(table_heap),
+      tuple_(new Tuple(rid)),
+      txn_(txn),
+      ring_(ring),
+      page_ids_(std::move(page_ids)),
+      page_idx_(page_idx) {
+  if (rid.GetPageId() != INVALID_PAGE_ID && !table_heap_->GetTuple(tuple_->rid_, tuple_, txn_) && txn_->IsSnapshot()) {
+    ++(*this);
   }
 }
 
@@ -34,34 +48,66 @@ Tuple *TableIterator::operator->() {
 }
 
 TableIterator &TableIterator::operator++() {
+  // A snapshot visits every slot, a row may have a version that it sees after it was deleted from the page, and skips
+  // the rows that it sees no version of.
+  const bool snapshot = txn_->IsSnapshot();
+  bool visible;
+  do {
+    visible = Advance(snapshot);
+  } while (snapshot && !visible && *this != table_heap_->End());
+  return *this;
+}
+
+bool TableIterator::Advance(bool empty_slots) {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+  auto cur_page =
+      static_cast<TablePage *>(buffer_pool_manager->FetchPageForScan(tuple_->rid_.GetPageId(), ring_));
   cur_page->RLatch();
   assert(cur_page != nullptr);  // all pages are pinned
 
+  // The slots of a columnar page all hold a tuple.
+  const bool columnar = table_heap_->GetLayout() == TableLayout::COLUMNAR;
+  auto next_rid = [&](const RID &cur_rid, RID *next_rid) {
+    return columnar ? reinterpret_cast<ColumnarTablePage *>(cur_page)->GetNextTupleRid(cur_rid, next_rid)
+                    : cur_page->GetNextTupleRid(cur_rid, next_rid, empty_slots);
+  };
+  auto first_rid = [&](RID *first_rid) {
+    return columnar ? reinterpret_cast<ColumnarTablePage *>(cur_page)->GetFirstTupleRid(first_rid)
+                    : cur_page->GetFirstTupleRid(first_rid, empty_slots);
+  };
+
+  // The page after the current one is the next one of the range, if the iterator goes through one.
+  auto next_page_id = [&]() -> page_id_t {
+    if (page_ids_ == nullptr) {
+      return cur_page->GetNextPageId();
+    }
+    return page_idx_ + 1 < page_ids_->size() ? (*page_ids_)[page_idx_ + 1] : INVALID_PAGE_ID;
+  };
+
   RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 &next_tuple_rid)) {  // end of this page
-    while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+  if (!next_rid(tuple_->rid_, &next_tuple_rid)) {  // end of this page
+    while (next_page_id() != INVALID_PAGE_ID) {
+      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPageForScan(next_page_id(), ring_));
+      page_idx_++;
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
       cur_page->RLatch();
-      if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
+      if (first_rid(&next_tuple_rid)) {
         break;
       }
     }
   }
   tuple_->rid_ = next_tuple_rid;
 
+  bool visible = false;
   if (*this != table_heap_->End()) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    visible = table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
   // release until copy the tuple
   cur_page->RUnlatch();
   buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-  return *this;
+  return visible;
 }
 
 TableIterator TableIterator::operator++(int) {
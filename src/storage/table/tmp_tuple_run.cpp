@@ -0,0 +1,143 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tmp_tuple_run.cpp
+//
+// Identification: src/storage/table/tmp_tuple_run.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/tmp_tuple_run.h"
+
+#include <cstring>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+TmpTupleRun::~TmpTupleRun() {
+  // A spill file goes away with what was not written of it.
+  if (file_ == nullptr) {
+    Finish();
+  }
+  for (page_id_t page_id : page_ids_) {
+    bpm_->DeletePage(page_id);
+  }
+}
+
+TmpTuple TmpTupleRun::Append(const Tuple &tuple) {
+  TmpTuple tmp_tuple(INVALID_PAGE_ID, 0);
+  if (file_ != nullptr) {
+    tmp_tuple = TmpTuple(INVALID_PAGE_ID, file_->GetSize());
+    const uint32_t size = tuple.GetLength();
+    file_->Append(reinterpret_cast<const char *>(&size), sizeof(uint32_t));
+    file_->Append(tuple.GetData(), size);
+    num_tuples_++;
+    return tmp_tuple;
+  }
+  if (last_page_ == nullptr || !last_page_->Insert(tuple, &tmp_tuple)) {
+    Finish();
+    page_id_t page_id;
+    Page *page = bpm_->NewPage(&page_id);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for a page of a run of tuples.");
+    }
+    page_ids_.push_back(page_id);
+    last_page_ = reinterpret_cast<TmpTuplePage *>(page);
+    last_page_->Init(page_id, PAGE_SIZE);
+    if (!last_page_->Insert(tuple, &tmp_tuple)) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "A tuple of a run of tuples does not fit a page.");
+    }
+  }
+  num_tuples_++;
+  return tmp_tuple;
+}
+
+void TmpTupleRun::AppendInOrder(const std::vector<const Tuple *> &tuples) {
+  if (file_ != nullptr) {
+    for (const Tuple *tuple : tuples) {
+      Append(*tuple);
+    }
+    return;
+  }
+  size_t begin = 0;
+  while (begin < tuples.size()) {
+    size_t end = begin;
+    uint32_t room = TmpTuplePage::RoomOf(PAGE_SIZE);
+    while (end < tuples.size() && TmpTuplePage::SpaceFor(*tuples[end]) <= room) {
+      room -= TmpTuplePage::SpaceFor(*tuples[end++]);
+    }
+    if (end == begin) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "A tuple of a run of tuples does not fit a page.");
+    }
+    Finish();
+    for (size_t i = end; i > begin; i--) {
+      Append(*tuples[i - 1]);
+    }
+    begin = end;
+  }
+}
+
+void TmpTupleRun::Finish() {
+  if (file_ != nullptr) {
+    file_->Finish();
+    return;
+  }
+  if (last_page_ != nullptr) {
+    bpm_->UnpinPage(last_page_->GetTablePageId(), true);
+    last_page_ = nullptr;
+  }
+}
+
+bool TmpTupleRun::Read(Cursor *cursor, Tuple *tuple, TmpTuple *tmp_tuple) {
+  if (file_ != nullptr) {
+    uint32_t size;
+    if (!file_->Read(cursor->file_offset_, reinterpret_cast<char *>(&size), sizeof(uint32_t))) {
+      return false;
+    }
+    read_buffer_.resize(sizeof(uint32_t) + size);
+    memcpy(read_buffer_.data(), &size, sizeof(uint32_t));
+    if (!file_->Read(cursor->file_offset_ + sizeof(uint32_t), read_buffer_.data() + sizeof(uint32_t), size)) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "A tuple of a run of tuples runs past the end of its spill file.");
+    }
+    tuple->DeserializeFrom(read_buffer_.data());
+    if (tmp_tuple != nullptr) {
+      *tmp_tuple = TmpTuple(INVALID_PAGE_ID, cursor->file_offset_);
+    }
+    cursor->file_offset_ += sizeof(uint32_t) + size;
+    return true;
+  }
+  while (cursor->page_index_ < page_ids_.size()) {
+    const page_id_t page_id = page_ids_[cursor->page_index_];
+    TmpTuplePage *page = FetchPage(page_id);
+    if (cursor->offset_ == 0) {
+      cursor->offset_ = page->GetFreeSpacePointer();
+    }
+    if (cursor->offset_ < PAGE_SIZE) {
+      *tuple = page->Get(cursor->offset_);
+      if (tmp_tuple != nullptr) {
+        *tmp_tuple = TmpTuple(page_id, cursor->offset_);
+      }
+      cursor->offset_ = page->GetNextOffset(cursor->offset_);
+      bpm_->UnpinPage(page_id, false);
+      return true;
+    }
+    bpm_->UnpinPage(page_id, false);
+    cursor->page_index_++;
+    cursor->offset_ = 0;
+  }
+  return false;
+}
+
+TmpTuplePage *TmpTupleRun::FetchPage(page_id_t page_id) {
+  Page *page = bpm_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "No buffer pool frame for a page of a run of tuples.");
+  }
+  return reinterpret_cast<TmpTuplePage *>(page);
+}
+
+}  // namespace bustub
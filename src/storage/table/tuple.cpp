@@ -14,25 +14,33 @@
 #include <cstdlib>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "common/exception.h"
+#include "storage/table/overflow_store.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 // TODO(Amadou): It does not look like nulls are supported. Add a null bitmap?
-Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true) {
+Tuple::Tuple(std::vector<Value> values, const Schema *schema) { SetValues(values, schema); }
+
+void Tuple::SetValues(const std::vector<Value> &values, const Schema *schema) {
   assert(values.size() == schema->GetColumnCount());
 
   // 1. Calculate the size of the tuple.
   uint32_t tuple_size = schema->GetLength();
+  // A null varchar is its length only.
+  auto varlen_size = [](const Value &value) {
+    return static_cast<uint32_t>((value.IsNull() ? 0 : value.GetLength()) + sizeof(uint32_t));
+  };
   for (auto &i : schema->GetUnlinedColumns()) {
-    tuple_size += (values[i].GetLength() + sizeof(uint32_t));
+    tuple_size += varlen_size(values[i]);
   }
 
-  // 2. Allocate memory.
-  size_ = tuple_size;
-  data_ = new char[size_];
+  // 2. Allocate memory, or reuse the buffer of the tuple.
+  Reserve(tuple_size);
   std::memset(data_, 0, size_);
 
   // 3. Serialize each attribute based on the input value.
@@ -46,69 +54,199 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true)
       *reinterpret_cast<uint32_t *>(data_ + col.GetOffset()) = offset;
       // Serialize varchar value, in place (size+data).
       values[i].SerializeTo(data_ + offset);
-      offset += (values[i].GetLength() + sizeof(uint32_t));
+      offset += varlen_size(values[i]);
     } else {
       values[i].SerializeTo(data_ + col.GetOffset());
     }
   }
 }
 
-Tuple::Tuple(const Tuple &other) : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_) {
-  if (allocated_) {
-    delete[] data_;
-  }
-  if (allocated_) {
+Tuple::Tuple(const Tuple &other) : rid_(other.rid_), overflow_(other.overflow_) {
+  if (other.allocated_) {
     // Deep copy.
-    data_ = new char[size_];
-    memcpy(data_, other.data_, size_);
+    memcpy(Reserve(other.size_), other.data_, other.size_);
   } else {
     // Shallow copy.
+    size_ = other.size_;
     data_ = other.data_;
   }
 }
 
+Tuple::Tuple(Tuple &&other) noexcept
+    : allocated_(other.allocated_),
+      rid_(other.rid_),
+      size_(other.size_),
+      capacity_(other.capacity_),
+      data_(other.data_),
+      overflow_(other.overflow_),
+      overflow_views_(std::move(other.overflow_views_)) {
+  other.allocated_ = false;
+  other.size_ = 0;
+  other.capacity_ = 0;
+  other.data_ = nullptr;
+}
+
 Tuple &Tuple::operator=(const Tuple &other) {
-  if (allocated_) {
-    delete[] data_;
+  if (this == &other) {
+    return *this;
   }
-  allocated_ = other.allocated_;
   rid_ = other.rid_;
-  size_ = other.size_;
-
-  if (allocated_) {
-    // Deep copy.
-    data_ = new char[size_];
-    memcpy(data_, other.data_, size_);
+  overflow_ = other.overflow_;
+  if (other.allocated_) {
+    // Deep copy, into the buffer of this tuple if it is large enough.
+    memcpy(Reserve(other.size_), other.data_, other.size_);
   } else {
     // Shallow copy.
+    Release();
+    size_ = other.size_;
     data_ = other.data_;
   }
+  return *this;
+}
 
+Tuple &Tuple::operator=(Tuple &&other) noexcept {
+  if (this != &other) {
+    Release();
+    std::swap(allocated_, other.allocated_);
+    std::swap(rid_, other.rid_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(data_, other.data_);
+    std::swap(overflow_, other.overflow_);
+    std::swap(overflow_views_, other.overflow_views_);
+  }
   return *this;
 }
 
+char *Tuple::Reserve(uint32_t size) {
+  if (!allocated_ || capacity_ < size) {
+    Release();
+    data_ = new char[size];
+    capacity_ = size;
+    allocated_ = true;
+  }
+  size_ = size;
+  overflow_views_.reset();
+  return data_;
+}
+
+void Tuple::Release() {
+  if (allocated_) {
+    delete[] data_;
+  }
+  allocated_ = false;
+  capacity_ = 0;
+  size_ = 0;
+  data_ = nullptr;
+  overflow_views_.reset();
+}
+
 Value Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const {
   assert(schema);
-  assert(data_);
-  const TypeId column_type = schema->GetColumn(column_idx).GetType();
+  const TypeId column_type = schema->GetColumnLayout(column_idx).type_id_;
   const char *data_ptr = GetDataPtr(schema, column_idx);
-  // the third parameter "is_inlined" is unused
+  if (column_type == TypeId::VARCHAR && IsOverflow(data_ptr)) {
+    return ReadOverflow(data_ptr, nullptr);
+  }
   return Value::DeserializeFrom(data_ptr, column_type);
 }
 
-const char *Tuple::GetDataPtr(const Schema *schema, const uint32_t column_idx) const {
+Value Tuple::GetValue(const Schema *schema, const uint32_t column_idx, AbstractPool *pool) const {
   assert(schema);
-  assert(data_);
-  const auto &col = schema->GetColumn(column_idx);
-  bool is_inlined = col.IsInlined();
-  // For inline type, data is stored where it is.
-  if (is_inlined) {
-    return (data_ + col.GetOffset());
+  const TypeId column_type = schema->GetColumnLayout(column_idx).type_id_;
+  const char *data_ptr = GetDataPtr(schema, column_idx);
+  if (column_type == TypeId::VARCHAR && IsOverflow(data_ptr)) {
+    return ReadOverflow(data_ptr, pool);
+  }
+  return Value::DeserializeFrom(data_ptr, column_type, pool);
+}
+
+Value Tuple::GetValueView(const Schema *schema, const uint32_t column_idx) const {
+  assert(schema);
+  const TypeId column_type = schema->GetColumnLayout(column_idx).type_id_;
+  const char *data_ptr = GetDataPtr(schema, column_idx);
+  if (column_type != TypeId::VARCHAR) {
+    return Value::DeserializeFrom(data_ptr, column_type);
+  }
+  if (IsOverflow(data_ptr)) {
+    return ReadOverflow(data_ptr, nullptr);
+  }
+  const auto len = Load<uint32_t>(data_ptr);
+  return Value(column_type, len == BUSTUB_VALUE_NULL ? nullptr : data_ptr + sizeof(uint32_t), len, false);
+}
+
+Value Tuple::ReadOverflow(const char *data_ptr, AbstractPool *pool) const {
+  if (overflow_ == nullptr) {
+    throw Exception(ExceptionType::INVALID, "A value is stored out of line, but the tuple knows no overflow store.");
+  }
+  const auto pointer = Load<OverflowPointer>(data_ptr + sizeof(uint32_t));
+  if (pool != nullptr) {
+    auto data = static_cast<char *>(pool->Allocate(pointer.length_));
+    overflow_->Read(pointer, data);
+    return Value(TypeId::VARCHAR, data, pointer.length_, false);
+  }
+  std::string data(pointer.length_, '\0');
+  overflow_->Read(pointer, data.data());
+  return Value(TypeId::VARCHAR, data.data(), pointer.length_, true);
+}
+
+std::string_view Tuple::ReadOverflowView(const char *data_ptr) const {
+  if (overflow_ == nullptr) {
+    throw Exception(ExceptionType::INVALID, "A value is stored out of line, but the tuple knows no overflow store.");
+  }
+  const auto pointer = Load<OverflowPointer>(data_ptr + sizeof(uint32_t));
+  if (overflow_views_ == nullptr) {
+    overflow_views_ = std::make_unique<std::deque<std::string>>();
+  }
+  std::string &data = overflow_views_->emplace_back(pointer.length_, '\0');
+  overflow_->Read(pointer, data.data());
+  return std::string_view(data.data(), pointer.length_ - 1);
+}
+
+bool Tuple::IsNull(const Schema *schema, const uint32_t column_idx) const {
+  assert(schema);
+  const char *data_ptr = GetDataPtr(schema, column_idx);
+  // A fixed-length value is null if it holds the null of its type, see the constructors of Value.
+  switch (schema->GetColumnLayout(column_idx).type_id_) {
+    case TypeId::BOOLEAN:
+      return Load<int8_t>(data_ptr) == BUSTUB_BOOLEAN_NULL;
+    case TypeId::TINYINT:
+      return Load<int8_t>(data_ptr) == BUSTUB_INT8_NULL;
+    case TypeId::SMALLINT:
+      return Load<int16_t>(data_ptr) == BUSTUB_INT16_NULL;
+    case TypeId::INTEGER:
+      return Load<int32_t>(data_ptr) == BUSTUB_INT32_NULL;
+    case TypeId::BIGINT:
+      return Load<int64_t>(data_ptr) == BUSTUB_INT64_NULL;
+    case TypeId::DECIMAL:
+      return Load<double>(data_ptr) == BUSTUB_DECIMAL_NULL;
+    case TypeId::TIMESTAMP:
+      return Load<uint64_t>(data_ptr) == BUSTUB_TIMESTAMP_NULL;
+    case TypeId::VARCHAR:
+      return Load<uint32_t>(data_ptr) == BUSTUB_VALUE_NULL;
+    default:
+      return GetValueView(schema, column_idx).IsNull();
+  }
+}
+
+Tuple Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema,
+                          const std::vector<uint32_t> &key_attrs) const {
+  // A key of inlined columns is copied column by column, in the bytes that the columns are stored in.
+  if (key_schema.IsInlined()) {
+    Tuple key;
+    char *data = key.Reserve(key_schema.GetLength());
+    for (uint32_t i = 0; i < key_attrs.size(); i++) {
+      memcpy(data + key_schema.GetColumnLayout(i).offset_, GetDataPtr(&schema, key_attrs[i]),
+             key_schema.GetColumn(i).GetFixedLength());
+    }
+    return key;
+  }
+  std::vector<Value> values;
+  values.reserve(key_attrs.size());
+  for (uint32_t idx : key_attrs) {
+    values.push_back(GetValueView(&schema, idx));
   }
-  // We read the relative offset from the tuple data.
-  int32_t offset = *reinterpret_cast<int32_t *>(data_ + col.GetOffset());
-  // And return the beginning address of the real data for the VARCHAR type.
-  return (data_ + offset);
+  return Tuple(values, &key_schema);
 }
 
 std::string Tuple::ToString(const Schema *schema) const {
@@ -126,7 +264,7 @@ std::string Tuple::ToString(const Schema *schema) const {
     if (IsNull(schema, column_itr)) {
       os << "<NULL>";
     } else {
-      Value val = (GetValue(schema, column_itr));
+      Value val = GetValueView(schema, column_itr);
       os << val.ToString();
     }
   }
@@ -143,14 +281,8 @@ void Tuple::SerializeTo(char *storage) const {
 
 void Tuple::DeserializeFrom(const char *storage) {
   uint32_t size = *reinterpret_cast<const uint32_t *>(storage);
-  // Construct a tuple.
-  this->size_ = size;
-  if (this->allocated_) {
-    delete[] this->data_;
-  }
-  this->data_ = new char[this->size_];
-  memcpy(this->data_, storage + sizeof(int32_t), this->size_);
-  this->allocated_ = true;
+  // Construct a tuple, in the buffer of this one if it is large enough.
+  memcpy(Reserve(size), storage + sizeof(int32_t), size);
 }
 
 }  // namespace bustub
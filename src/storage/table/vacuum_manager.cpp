@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// vacuum_manager.cpp
+//
+// Identification: src/storage/table/vacuum_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/vacuum_manager.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+VacuumManager::~VacuumManager() { StopVacuumThread(); }
+
+void VacuumManager::AddTable(TableHeap *table) {
+  std::scoped_lock lock(tables_latch_);
+  tables_.push_back(table);
+}
+
+void VacuumManager::RemoveTable(TableHeap *table) {
+  std::scoped_lock lock(tables_latch_);
+  tables_.erase(std::remove(tables_.begin(), tables_.end(), table), tables_.end());
+}
+
+size_t VacuumManager::VacuumTables() {
+  std::scoped_lock lock(tables_latch_);
+  size_t num_deallocated = 0;
+  for (TableHeap *table : tables_) {
+    num_deallocated += table->Vacuum(transaction_manager_);
+  }
+  return num_deallocated;
+}
+
+void VacuumManager::StartVacuumThread() {
+  if (vacuum_thread_ != nullptr) {
+    return;
+  }
+  {
+    std::scoped_lock lock(latch_);
+    stop_requested_ = false;
+  }
+  vacuum_thread_ = new std::thread(&VacuumManager::RunVacuumThread, this);
+}
+
+void VacuumManager::StopVacuumThread() {
+  if (vacuum_thread_ == nullptr) {
+    return;
+  }
+  {
+    std::scoped_lock lock(latch_);
+    stop_requested_ = true;
+  }
+  cv_.notify_one();
+  vacuum_thread_->join();
+  delete vacuum_thread_;
+  vacuum_thread_ = nullptr;
+}
+
+void VacuumManager::RunVacuumThread() {
+  std::unique_lock lock(latch_);
+  while (!cv_.wait_for(lock, vacuum_interval, [&] { return stop_requested_; })) {
+    lock.unlock();
+    VacuumTables();
+    lock.lock();
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store.cpp
+//
+// Identification: src/storage/table/version_store.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/version_store.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+bool VersionStore::CanWrite(const RID &rid, Transaction *txn) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = chains_.find(rid);
+  if (it == chains_.end()) {
+    return true;
+  }
+  const VersionChain &chain = it->second;
+  if (chain.txn_id_ != INVALID_TXN_ID) {
+    return chain.txn_id_ == txn->GetTransactionId();
+  }
+  return !txn->IsSnapshot() || chain.ts_ <= txn->GetReadTs();
+}
+
+bool VersionStore::Validate(const RID &rid, Transaction *txn) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = chains_.find(rid);
+  // An uncommitted version leaves the timestamp of the version before it.
+  return it == chains_.end() || it->second.ts_ <= txn->GetReadTs();
+}
+
+void VersionStore::AddVersion(const RID &rid, Transaction *txn, const Tuple *old_tuple) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto [it, inserted] = chains_.try_emplace(rid);
+  VersionChain &chain = it->second;
+  if (inserted) {
+    // A row without a chain is seen by all transactions, as if it had been written at the beginning of time.
+    chain.ts_ = 0;
+    chain.txn_id_ = INVALID_TXN_ID;
+    chain.writes_ = 0;
+  }
+  // The version from before the transaction's first write of the row is what the others see until it commits.
+  if (chain.txn_id_ != txn->GetTransactionId()) {
+    chain.undo_.push_back(TupleVersion{chain.ts_, old_tuple != nullptr, old_tuple != nullptr ? *old_tuple : Tuple{}});
+    chain.txn_id_ = txn->GetTransactionId();
+    chain.writes_ = 0;
+  }
+  chain.writes_++;
+}
+
+void VersionStore::Commit(const RID &rid, Transaction *txn, timestamp_t commit_ts, timestamp_t watermark) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = chains_.find(rid);
+  // A row that the transaction wrote several times is committed with its first write set entry.
+  if (it != chains_.end() && it->second.txn_id_ == txn->GetTransactionId()) {
+    it->second.ts_ = commit_ts;
+    it->second.txn_id_ = INVALID_TXN_ID;
+    if (Prune(&it->second, watermark)) {
+      chains_.erase(it);
+    }
+  }
+  if (chains_.size() < 2 * sweep_size_) {
+    return;
+  }
+  Sweep(watermark);
+}
+
+void VersionStore::PruneAll(timestamp_t watermark) {
+  std::lock_guard<std::mutex> guard(latch_);
+  Sweep(watermark);
+}
+
+void VersionStore::Sweep(timestamp_t watermark) {
+  for (auto chain = chains_.begin(); chain != chains_.end();) {
+    chain = Prune(&chain->second, watermark) ? chains_.erase(chain) : std::next(chain);
+  }
+  sweep_size_ = std::max<size_t>(chains_.size(), 64);
+}
+
+void VersionStore::Rollback(const RID &rid, Transaction *txn) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = chains_.find(rid);
+  if (it == chains_.end() || it->second.txn_id_ != txn->GetTransactionId()) {
+    return;
+  }
+  VersionChain &chain = it->second;
+  // The page holds the version from before the transaction again once its first write is rolled back.
+  if (--chain.writes_ > 0) {
+    return;
+  }
+  chain.ts_ = chain.undo_.back().ts_;
+  chain.txn_id_ = INVALID_TXN_ID;
+  chain.undo_.pop_back();
+  if (chain.undo_.empty()) {
+    chains_.erase(it);
+  }
+}
+
+bool VersionStore::Read(const RID &rid, Transaction *txn, bool in_page, Tuple *tuple) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = chains_.find(rid);
+  if (it == chains_.end()) {
+    return in_page;
+  }
+  const VersionChain &chain = it->second;
+  if (chain.txn_id_ == txn->GetTransactionId() ||
+      (chain.txn_id_ == INVALID_TXN_ID && chain.ts_ <= txn->GetReadTs())) {
+    return in_page;
+  }
+  for (auto version = chain.undo_.rbegin(); version != chain.undo_.rend(); ++version) {
+    if (version->ts_ <= txn->GetReadTs()) {
+      if (!version->exists_) {
+        return false;
+      }
+      *tuple = version->tuple_;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool VersionStore::Prune(VersionChain *chain, timestamp_t watermark) {
+  if (chain->txn_id_ == INVALID_TXN_ID && chain->ts_ <= watermark) {
+    return true;
+  }
+  // The oldest snapshot sees the newest version that is not newer than the watermark, it needs none before.
+  auto &undo = chain->undo_;
+  auto seen = std::find_if(undo.rbegin(), undo.rend(), [watermark](const TupleVersion &version) {
+    return version.ts_ <= watermark;
+  });
+  if (seen != undo.rend()) {
+    undo.erase(undo.begin(), std::prev(seen.base()));
+  }
+  return false;
+}
+
+}  // namespace bustub
@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.cpp
+//
+// Identification: src/storage/table/zone_map.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/zone_map.h"
+
+namespace bustub {
+
+ZoneMap::ZoneMap(const Schema &schema) : schema_(schema) {
+  for (uint32_t i = 0; i < schema_.GetColumnCount(); i++) {
+    if (IsTracked(i)) {
+      tracked_columns_.push_back(i);
+    }
+  }
+}
+
+void ZoneMap::AddPage(page_id_t page_id, page_id_t prev_page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  pages_[page_id].columns_.resize(schema_.GetColumnCount());
+  if (prev_page_id != INVALID_PAGE_ID) {
+    pages_[prev_page_id].next_page_id_ = page_id;
+  }
+}
+
+void ZoneMap::RemovePage(page_id_t page_id, page_id_t prev_page_id, page_id_t next_page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  pages_.erase(page_id);
+  auto it = pages_.find(prev_page_id);
+  if (it != pages_.end()) {
+    it->second.next_page_id_ = next_page_id;
+  }
+}
+
+void ZoneMap::Update(page_id_t page_id, const Tuple &tuple) {
+  // The values are taken out of the tuple before the latch is taken.
+  std::vector<Value> values;
+  values.reserve(tracked_columns_.size());
+  for (uint32_t col_idx : tracked_columns_) {
+    values.push_back(tuple.GetValue(&schema_, col_idx));
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = pages_.find(page_id);
+  if (it == pages_.end()) {
+    return;
+  }
+  for (size_t i = 0; i < tracked_columns_.size(); i++) {
+    ColumnZone &zone = it->second.columns_[tracked_columns_[i]];
+    const Value &value = values[i];
+    if (value.IsNull()) {
+      zone.num_nulls_++;
+    } else if (!zone.has_values_) {
+      zone.has_values_ = true;
+      zone.min_ = value;
+      zone.max_ = value;
+    } else if (value.CompareLessThan(zone.min_) == CmpBool::CmpTrue) {
+      zone.min_ = value;
+    } else if (value.CompareGreaterThan(zone.max_) == CmpBool::CmpTrue) {
+      zone.max_ = value;
+    }
+  }
+}
+
+bool ZoneMap::GetZone(page_id_t page_id, uint32_t col_idx, ColumnZone *zone, page_id_t *next_page_id) const {
+  if (!IsTracked(col_idx)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = pages_.find(page_id);
+  if (it == pages_.end()) {
+    return false;
+  }
+  *zone = it->second.columns_[col_idx];
+  *next_page_id = it->second.next_page_id_;
+  return true;
+}
+
+bool ZoneMap::GetNextPageId(page_id_t page_id, page_id_t *next_page_id) const {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = pages_.find(page_id);
+  if (it == pages_.end()) {
+    return false;
+  }
+  *next_page_id = it->second.next_page_id_;
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arena_pool.cpp
+//
+// Identification: src/type/arena_pool.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "type/arena_pool.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+void *ArenaPool::Allocate(size_t size) {
+  const size_t aligned = (std::max<size_t>(size, 1) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  bytes_allocated_ += aligned;
+  // A large allocation gets a block of its own, so that the rest of the current block stays in use.
+  if (aligned > static_cast<size_t>(ARENA_BLOCK_SIZE)) {
+    large_blocks_.push_back(std::make_unique<char[]>(aligned));
+    memory_usage_ += aligned;
+    return large_blocks_.back().get();
+  }
+  while (current_ < blocks_.size() && offset_ + aligned > static_cast<size_t>(ARENA_BLOCK_SIZE)) {
+    current_++;
+    offset_ = 0;
+  }
+  if (current_ == blocks_.size()) {
+    blocks_.push_back(std::make_unique<char[]>(ARENA_BLOCK_SIZE));
+    memory_usage_ += ARENA_BLOCK_SIZE;
+  }
+  void *result = blocks_[current_].get() + offset_;
+  offset_ += aligned;
+  return result;
+}
+
+void ArenaPool::Reset() {
+  large_blocks_.clear();
+  memory_usage_ = blocks_.size() * ARENA_BLOCK_SIZE;
+  current_ = 0;
+  offset_ = 0;
+  bytes_allocated_ = 0;
+}
+
+}  // namespace bustub
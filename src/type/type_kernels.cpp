@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// type_kernels.cpp
+//
+// Identification: src/type/type_kernels.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "type/type_kernels.h"
+
+namespace bustub {
+
+namespace {
+
+template <TypeId T>
+constexpr TypeKernels MakeKernels() {
+  return {&TypeKernel<T>::CompareEquals, &TypeKernel<T>::CompareLessThan, &TypeKernel<T>::HashCombine};
+}
+
+CmpBool GenericCompareEquals(const Value &left, const Value &right) { return left.CompareEquals(right); }
+
+CmpBool GenericCompareLessThan(const Value &left, const Value &right) { return left.CompareLessThan(right); }
+
+void GenericHashCombine(const std::vector<Value> &values, bool skip_nulls, hash_t *hashes) {
+  for (size_t i = 0; i < values.size(); i++) {
+    if (!values[i].IsNull()) {
+      hashes[i] = HashUtil::CombineHashes(hashes[i], HashUtil::HashValue(&values[i]));
+    } else if (!skip_nulls) {
+      hashes[i] = HashUtil::CombineHashes(hashes[i], 0);
+    }
+  }
+}
+
+constexpr TypeKernels BOOLEAN_KERNELS = MakeKernels<TypeId::BOOLEAN>();
+constexpr TypeKernels TINYINT_KERNELS = MakeKernels<TypeId::TINYINT>();
+constexpr TypeKernels SMALLINT_KERNELS = MakeKernels<TypeId::SMALLINT>();
+constexpr TypeKernels INTEGER_KERNELS = MakeKernels<TypeId::INTEGER>();
+constexpr TypeKernels BIGINT_KERNELS = MakeKernels<TypeId::BIGINT>();
+constexpr TypeKernels DECIMAL_KERNELS = MakeKernels<TypeId::DECIMAL>();
+constexpr TypeKernels TIMESTAMP_KERNELS = MakeKernels<TypeId::TIMESTAMP>();
+constexpr TypeKernels VARCHAR_KERNELS = MakeKernels<TypeId::VARCHAR>();
+constexpr TypeKernels GENERIC_KERNELS = {&GenericCompareEquals, &GenericCompareLessThan, &GenericHashCombine};
+
+}  // namespace
+
+const TypeKernels &TypeKernels::Get(TypeId type_id) {
+  switch (type_id) {
+    case TypeId::BOOLEAN:
+      return BOOLEAN_KERNELS;
+    case TypeId::TINYINT:
+      return TINYINT_KERNELS;
+    case TypeId::SMALLINT:
+      return SMALLINT_KERNELS;
+    case TypeId::INTEGER:
+      return INTEGER_KERNELS;
+    case TypeId::BIGINT:
+      return BIGINT_KERNELS;
+    case TypeId::DECIMAL:
+      return DECIMAL_KERNELS;
+    case TypeId::TIMESTAMP:
+      return TIMESTAMP_KERNELS;
+    case TypeId::VARCHAR:
+      return VARCHAR_KERNELS;
+    default:
+      return GENERIC_KERNELS;
+  }
+}
+
+}  // namespace bustub
@@ -11,29 +11,49 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <cstddef>
 #include <string>
 #include <utility>
 
 #include "common/exception.h"
+#include "common/memory_accounting.h"
 #include "type/value.h"
 
 namespace bustub {
+
+namespace {
+
+/** @return the bytes of a string that a Value owns, which are charged to the VARLEN subsystem */
+char *AllocateVarlen(uint32_t len) {
+  char *data = new char[len];
+  MemoryAccounting::Get(MemorySubsystem::VARLEN)->Consume(len);
+  return data;
+}
+
+/** Frees the bytes of a string that a Value owned. */
+void FreeVarlen(char *data, uint32_t len) {
+  MemoryAccounting::Get(MemorySubsystem::VARLEN)->Release(len);
+  delete[] data;
+}
+
+}  // namespace
+
 Value::Value(const Value &other) {
   type_id_ = other.type_id_;
   size_ = other.size_;
   manage_data_ = other.manage_data_;
+  inline_len_ = other.inline_len_;
   value_ = other.value_;
   switch (type_id_) {
     case TypeId::VARCHAR:
-      if (size_.len_ == BUSTUB_VALUE_NULL) {
+      // An inlined VARCHAR came along with value_ and size_.
+      if (inline_len_ == 0 && size_.len_ == BUSTUB_VALUE_NULL) {
         value_.varlen_ = nullptr;
-      } else {
-        if (manage_data_) {
-          value_.varlen_ = new char[size_.len_];
-          memcpy(value_.varlen_, other.value_.varlen_, size_.len_);
-        } else {
-          value_ = other.value_;
-        }
+      } else if (inline_len_ == 0) {
+        // A copy of a value that borrows its data, e.g. from the pool of a batch, owns it, so it may outlive the pool.
+        manage_data_ = true;
+        value_.varlen_ = AllocateVarlen(size_.len_);
+        memcpy(value_.varlen_, other.value_.const_varlen_, size_.len_);
       }
       break;
     default:
@@ -41,6 +61,62 @@ Value::Value(const Value &other) {
   }
 }
 
+Value::Value(Value &&other) noexcept : Value(TypeId::INVALID) { Swap(*this, other); }
+
+Value Value::GetView() const {
+  if (type_id_ != TypeId::VARCHAR || inline_len_ != 0 || IsNull()) {
+    return *this;
+  }
+  return Value(type_id_, value_.const_varlen_, size_.len_, false);
+}
+
+void Value::SetInline(const char *data, uint32_t len) {
+  static_assert(offsetof(Value, size_) == offsetof(Value, value_) + sizeof(Val),
+                "An inlined VARCHAR takes up value_ and size_, which must be next to each other.");
+  static_assert(INLINE_VARLEN_SIZE == sizeof(Val) + sizeof(size_));
+  assert(len > 0 && len <= INLINE_VARLEN_SIZE);
+  memcpy(reinterpret_cast<char *>(this) + offsetof(Value, value_), data, len);
+  inline_len_ = static_cast<uint8_t>(len);
+  manage_data_ = false;
+}
+
+Value Value::DeserializeFrom(const char *storage, TypeId type_id) {
+  // The fixed-length types are read here, which spares the lookup of the type and a virtual call per value.
+  switch (type_id) {
+    case TypeId::INTEGER:
+      return Value(type_id, *reinterpret_cast<const int32_t *>(storage));
+    case TypeId::BIGINT:
+      return Value(type_id, *reinterpret_cast<const int64_t *>(storage));
+    case TypeId::DECIMAL:
+      return Value(type_id, *reinterpret_cast<const double *>(storage));
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return Value(type_id, *reinterpret_cast<const int8_t *>(storage));
+    case TypeId::SMALLINT:
+      return Value(type_id, *reinterpret_cast<const int16_t *>(storage));
+    case TypeId::TIMESTAMP:
+      return Value(type_id, *reinterpret_cast<const uint64_t *>(storage));
+    default:
+      return Type::GetInstance(type_id)->DeserializeFrom(storage);
+  }
+}
+
+Value Value::DeserializeFrom(const char *storage, TypeId type_id, AbstractPool *pool) {
+  if (type_id != TypeId::VARCHAR || pool == nullptr) {
+    return DeserializeFrom(storage, type_id);
+  }
+  const uint32_t len = *reinterpret_cast<const uint32_t *>(storage);
+  if (len == BUSTUB_VALUE_NULL) {
+    return Value(type_id, nullptr, len, false);
+  }
+  if (len <= INLINE_VARLEN_SIZE) {
+    return Value(type_id, storage + sizeof(uint32_t), len, false);
+  }
+  auto data = static_cast<char *>(pool->Allocate(len));
+  memcpy(data, storage + sizeof(uint32_t), len);
+  return Value(type_id, data, len, false);
+}
+
 Value &Value::operator=(Value other) {
   Swap(*this, other);
   return *this;
@@ -217,11 +293,13 @@ Value::Value(TypeId type, const char *data, uint32_t len, bool manage_data) : Va
       if (data == nullptr) {
         value_.varlen_ = nullptr;
         size_.len_ = BUSTUB_VALUE_NULL;
+      } else if (len > 0 && len <= INLINE_VARLEN_SIZE) {
+        SetInline(data, len);
       } else {
         manage_data_ = manage_data;
         if (manage_data_) {
           assert(len < BUSTUB_VARCHAR_MAX_LEN);
-          value_.varlen_ = new char[len];
+          value_.varlen_ = AllocateVarlen(len);
           assert(value_.varlen_ != nullptr);
           size_.len_ = len;
           memcpy(value_.varlen_, data, len);
@@ -243,7 +321,11 @@ Value::Value(TypeId type, const std::string &data) : Value(type) {
       manage_data_ = true;
       // TODO(TAs): How to represent a null string here?
       uint32_t len = static_cast<uint32_t>(data.length()) + 1;
-      value_.varlen_ = new char[len];
+      if (len <= INLINE_VARLEN_SIZE) {
+        SetInline(data.c_str(), len);
+        break;
+      }
+      value_.varlen_ = AllocateVarlen(len);
       assert(value_.varlen_ != nullptr);
       size_.len_ = len;
       memcpy(value_.varlen_, data.c_str(), len);
@@ -259,7 +341,7 @@ Value::~Value() {
   switch (type_id_) {
     case TypeId::VARCHAR:
       if (manage_data_) {
-        delete[] value_.varlen_;
+        FreeVarlen(value_.varlen_, size_.len_);
       }
       break;
     default:
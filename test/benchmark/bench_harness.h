@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bench_harness.h
+//
+// Identification: test/benchmark/bench_harness.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>  // NOLINT
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "catalog/table_generator.h"
+
+namespace bustub {
+
+/**
+ * BenchOptions holds the --name=value options of a benchmark. Every option that a benchmark knows is read with a
+ * default, and IsValid() then tells whether the command line only held those, and numbers where numbers go.
+ */
+class BenchOptions {
+ public:
+  BenchOptions(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+      const std::string arg = argv[i];
+      const std::string::size_type equals = arg.find('=');
+      if (arg.rfind("--", 0) != 0 || equals == std::string::npos) {
+        valid_ = false;
+        continue;
+      }
+      values_[arg.substr(2, equals - 2)] = arg.substr(equals + 1);
+    }
+  }
+
+  size_t GetSize(const std::string &name, size_t default_value) {
+    const std::string *value = Find(name);
+    if (value == nullptr) {
+      return default_value;
+    }
+    char *end;
+    const size_t number = std::strtoull(value->c_str(), &end, 10);
+    valid_ = valid_ && !value->empty() && *end == '\0';
+    return number;
+  }
+
+  std::string GetString(const std::string &name, const std::string &default_value) {
+    const std::string *value = Find(name);
+    return value == nullptr ? default_value : *value;
+  }
+
+  /** @return a distribution of TableGenerator: uniform, zipf50, zipf75, zipf95 or zipf99 */
+  TableGenerator::Dist GetDist(const std::string &name, TableGenerator::Dist default_value) {
+    const std::map<std::string, TableGenerator::Dist> dists = {{"uniform", TableGenerator::Dist::Uniform},
+                                                                {"zipf50", TableGenerator::Dist::Zipf_50},
+                                                                {"zipf75", TableGenerator::Dist::Zipf_75},
+                                                                {"zipf95", TableGenerator::Dist::Zipf_95},
+                                                                {"zipf99", TableGenerator::Dist::Zipf_99}};
+    const std::string *value = Find(name);
+    if (value == nullptr) {
+      return default_value;
+    }
+    auto dist = dists.find(*value);
+    valid_ = valid_ && dist != dists.end();
+    return dist == dists.end() ? default_value : dist->second;
+  }
+
+  /** Fails the options unless a condition on their values holds. */
+  void Require(bool condition) { valid_ = valid_ && condition; }
+
+  /** @return true if every option was well formed and known, see above */
+  bool IsValid() const {
+    return valid_ && std::all_of(values_.begin(), values_.end(), [&](const auto &value) {
+             return used_.count(value.first) != 0;
+           });
+  }
+
+ private:
+  const std::string *Find(const std::string &name) {
+    used_.insert(name);
+    auto value = values_.find(name);
+    return value == values_.end() ? nullptr : &value->second;
+  }
+
+  std::map<std::string, std::string> values_;
+  std::set<std::string> used_;
+  bool valid_{true};
+};
+
+/**
+ * Runs fn(thread) on num_threads threads and waits for them. With pin, thread i runs on the i-th CPU that the process
+ * may run on, round-robin, so that runs of a benchmark put the same load on the same CPUs and are comparable. The
+ * threads only start once all of them are pinned.
+ * @return the seconds from the start of the threads until the last one finished
+ */
+template <class Fn>
+double RunPinnedThreads(size_t num_threads, bool pin, Fn &&fn) {
+  std::vector<int> cpus;
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (pin && sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  std::mutex latch;
+  std::condition_variable cv;
+  bool started = false;
+  std::vector<std::thread> threads;
+  for (size_t thread = 0; thread < num_threads; thread++) {
+    threads.emplace_back([&, thread] {
+      {
+        std::unique_lock lock(latch);
+        cv.wait(lock, [&] { return started; });
+      }
+      fn(thread);
+    });
+    if (!cpus.empty()) {
+      cpu_set_t cpu;
+      CPU_ZERO(&cpu);
+      CPU_SET(cpus[thread % cpus.size()], &cpu);
+      pthread_setaffinity_np(threads.back().native_handle(), sizeof(cpu), &cpu);
+    }
+  }
+  const auto start = std::chrono::steady_clock::now();
+  {
+    std::scoped_lock lock(latch);
+    started = true;
+  }
+  cv.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** @return the value below which a fraction of the sorted values are */
+inline uint64_t Percentile(const std::vector<uint64_t> &sorted, double fraction) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * static_cast<double>(sorted.size())))];
+}
+
+/**
+ * Deletes a database file and the files that a DiskManager keeps next to it: its log, free space map, checksums and
+ * master record, and the later segments of the file and of the log.
+ */
+inline void RemoveDatabaseFiles(const std::string &db_file) {
+  const std::filesystem::path db_path(db_file);
+  const std::string base_name = db_path.stem().string();
+  const std::string file_name = db_path.filename().string();
+  const std::set<std::string> suffixes = {".log", ".fsm", ".crc", ".master"};
+  const std::filesystem::path directory = db_path.has_parent_path() ? db_path.parent_path() : ".";
+  std::error_code error;
+  for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+    const std::string name = entry.path().filename().string();
+    const bool is_segment = name.rfind(file_name + ".", 0) == 0 || name.rfind(base_name + ".log.", 0) == 0;
+    const bool is_side_file = name.rfind(base_name, 0) == 0 && suffixes.count(name.substr(base_name.size())) != 0;
+    if (name == file_name || is_segment || is_side_file) {
+      std::filesystem::remove(entry.path(), error);
+    }
+  }
+}
+
+}  // namespace bustub
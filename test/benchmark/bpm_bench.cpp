@@ -0,0 +1,201 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bpm_bench.cpp
+//
+// Identification: test/benchmark/bpm_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Drives a buffer pool with several threads that fetch pages of a database file, and reports the throughput, the hit
+// ratio and the latency percentiles of the fetches. Compares replacers and shardings, e.g.
+//
+//   bpm_bench --threads=8 --pool=1000 --pages=20000 --dist=zipf99 --scan-percent=5 --replacer=lru_k --shards=4
+//
+// Options, all --name=value:
+//   threads       threads fetching pages (4)
+//   pages         pages of the database file (10000)
+//   pool          frames of the buffer pool (1000)
+//   shards        shards of a ParallelBufferPoolManager, 1 for a single BufferPoolManager (1)
+//   replacer      clock or lru_k (clock)
+//   dist          the pages that a point fetch reads: uniform, zipf50, zipf75, zipf95 or zipf99 (uniform)
+//   scan-percent  operations that scan scan-pages pages from a page of dist instead of fetching one (0)
+//   scan-pages    pages of a scan (64)
+//   scan-ring     frames of the buffer ring of a scan, 0 for none (SCAN_RING_SIZE)
+//   write-percent point fetches that dirty their page (0)
+//   ops           operations per thread (100000)
+//   pin           1 to pin the threads to fixed CPUs, see RunPinnedThreads() (1)
+//   db            the database file, deleted at the end (bpm_bench.db)
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/bench_harness.h"
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+namespace {
+
+struct BenchConfig {
+  size_t threads_ = 4;
+  size_t pages_ = 10000;
+  size_t pool_ = 1000;
+  size_t shards_ = 1;
+  ReplacerPolicy replacer_ = ReplacerPolicy::CLOCK;
+  TableGenerator::Dist dist_ = TableGenerator::Dist::Uniform;
+  size_t scan_percent_ = 0;
+  size_t scan_pages_ = 64;
+  size_t scan_ring_ = SCAN_RING_SIZE;
+  size_t write_percent_ = 0;
+  size_t ops_ = 100000;
+  bool pin_ = true;
+  std::string db_ = "bpm_bench.db";
+};
+
+/** @return false if an option is unknown or its value is not valid */
+bool ParseArgs(int argc, char **argv, BenchConfig *config) {
+  BenchOptions options(argc, argv);
+  config->threads_ = options.GetSize("threads", config->threads_);
+  config->pages_ = options.GetSize("pages", config->pages_);
+  config->pool_ = options.GetSize("pool", config->pool_);
+  config->shards_ = options.GetSize("shards", config->shards_);
+  const std::string replacer = options.GetString("replacer", "clock");
+  options.Require(replacer == "clock" || replacer == "lru_k");
+  config->replacer_ = replacer == "lru_k" ? ReplacerPolicy::LRU_K : ReplacerPolicy::CLOCK;
+  config->dist_ = options.GetDist("dist", config->dist_);
+  config->scan_percent_ = options.GetSize("scan-percent", config->scan_percent_);
+  config->scan_pages_ = options.GetSize("scan-pages", config->scan_pages_);
+  config->scan_ring_ = options.GetSize("scan-ring", config->scan_ring_);
+  config->write_percent_ = options.GetSize("write-percent", config->write_percent_);
+  config->ops_ = options.GetSize("ops", config->ops_);
+  config->pin_ = options.GetSize("pin", 1) != 0;
+  config->db_ = options.GetString("db", config->db_);
+  options.Require(config->threads_ > 0 && config->pages_ > 0 && config->pool_ > 0 && config->shards_ > 0 &&
+                  config->scan_percent_ <= 100 && config->write_percent_ <= 100);
+  return options.IsValid();
+}
+
+/**
+ * Runs the operations of a thread: point fetches of pages of the distribution, and scans that start at one.
+ * @param[out] latencies the nanoseconds of each fetch, from the fetch to the unpin
+ * @return the number of fetches that failed, because every frame was pinned
+ */
+size_t RunThread(const BenchConfig &config, BufferPoolManager *bpm, const std::vector<page_id_t> &page_ids,
+                 size_t thread, std::vector<uint64_t> *latencies) {
+  TableGenerator::Sampler pages(config.dist_, 0, config.pages_ - 1, thread + 1);
+  std::mt19937_64 generator(thread);
+  std::uniform_int_distribution<size_t> percent(0, 99);
+  size_t failures = 0;
+  auto fetch = [&](page_id_t page_id, bool dirty, BufferRing *ring) {
+    const auto start = std::chrono::steady_clock::now();
+    Page *page = bpm->FetchPageForScan(page_id, ring);
+    if (page == nullptr) {
+      failures++;
+      return;
+    }
+    if (dirty) {
+      page->WLatch();
+      page->GetData()[sizeof(page_id_t) * 2]++;
+      page->WUnlatch();
+    }
+    bpm->UnpinPage(page_id, dirty);
+    latencies->push_back(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+  };
+  for (size_t op = 0; op < config.ops_; op++) {
+    const uint64_t first = pages.Next();
+    if (percent(generator) < config.scan_percent_) {
+      BufferRing ring(config.scan_ring_);
+      for (size_t i = 0; i < config.scan_pages_; i++) {
+        fetch(page_ids[(first + i) % config.pages_], false, config.scan_ring_ == 0 ? nullptr : &ring);
+      }
+    } else {
+      fetch(page_ids[first], percent(generator) < config.write_percent_, nullptr);
+    }
+  }
+  return failures;
+}
+
+int RunBench(const BenchConfig &config) {
+  RemoveDatabaseFiles(config.db_);
+  auto disk_manager = std::make_unique<DiskManager>(config.db_);
+  std::unique_ptr<BufferPoolManager> bpm;
+  if (config.shards_ == 1) {
+    bpm = std::make_unique<BufferPoolManager>(config.pool_, disk_manager.get(), nullptr, config.replacer_);
+  } else {
+    bpm = std::make_unique<ParallelBufferPoolManager>(config.shards_, config.pool_ / config.shards_,
+                                                      disk_manager.get(), nullptr, config.replacer_);
+  }
+
+  // The shards of a parallel buffer pool hand out the page ids, so page i of the benchmark is page_ids[i].
+  std::vector<page_id_t> page_ids(config.pages_);
+  for (size_t i = 0; i < config.pages_; i++) {
+    if (bpm->NewPage(&page_ids[i]) == nullptr) {
+      fprintf(stderr, "Could not create page %zu of the database.\n", i);
+      return 1;
+    }
+    bpm->UnpinPage(page_ids[i], true);
+  }
+  bpm->FlushAllPages();
+
+  const BufferPoolStats before = bpm->GetStats();
+  std::vector<std::vector<uint64_t>> latencies(config.threads_);
+  std::vector<size_t> failures(config.threads_);
+  for (auto &thread_latencies : latencies) {
+    thread_latencies.reserve(config.ops_);
+  }
+  const double seconds = RunPinnedThreads(config.threads_, config.pin_, [&](size_t thread) {
+    failures[thread] = RunThread(config, bpm.get(), page_ids, thread, &latencies[thread]);
+  });
+  const BufferPoolStats after = bpm->GetStats();
+
+  std::vector<uint64_t> all;
+  size_t num_failures = 0;
+  for (size_t thread = 0; thread < config.threads_; thread++) {
+    all.insert(all.end(), latencies[thread].begin(), latencies[thread].end());
+    num_failures += failures[thread];
+  }
+  std::sort(all.begin(), all.end());
+  const uint64_t hits = after.fetch_hits - before.fetch_hits;
+  const uint64_t misses = after.fetch_misses - before.fetch_misses;
+  printf("fetches:     %zu in %.3f s, %zu failed\n", all.size(), seconds, num_failures);
+  printf("throughput:  %.0f fetches/s\n", static_cast<double>(all.size()) / seconds);
+  printf("hit ratio:   %.4f (%lu hits, %lu misses, %lu evictions)\n",
+         hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses), hits, misses,
+         after.evictions - before.evictions);
+  printf("latency ns:  p50 %lu, p90 %lu, p99 %lu, p99.9 %lu, max %lu\n", Percentile(all, 0.5), Percentile(all, 0.9),
+         Percentile(all, 0.99), Percentile(all, 0.999), all.empty() ? 0 : all.back());
+
+  bpm.reset();
+  disk_manager->ShutDown();
+  RemoveDatabaseFiles(config.db_);
+  return 0;
+}
+
+}  // namespace
+
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  bustub::BenchConfig config;
+  if (!bustub::ParseArgs(argc, argv, &config)) {
+    fprintf(stderr,
+            "usage: %s [--threads=N] [--pages=N] [--pool=N] [--shards=N] [--replacer=clock|lru_k]\n"
+            "  [--dist=uniform|zipf50|zipf75|zipf95|zipf99] [--scan-percent=P] [--scan-pages=N] [--scan-ring=N]\n"
+            "  [--write-percent=P] [--ops=N] [--pin=0|1] [--db=FILE]\n",
+            argv[0]);
+    return 1;
+  }
+  return bustub::RunBench(config);
+}
@@ -0,0 +1,244 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_bench.cpp
+//
+// Identification: test/benchmark/hash_table_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Drives LinearProbeHashTables of GenericKeys, the instantiations that hash indexes use, with a mix of inserts,
+// lookups and removes from several threads pinned to fixed CPUs, and reports the throughput and the probe lengths of
+// the pairs afterwards, e.g.
+//
+//   hash_table_bench --threads=8 --keys=200000 --load=80 --insert-percent=20 --remove-percent=20 --dist=zipf95
+//
+// Options, all --name=value:
+//   key-sizes       the GenericKey sizes to run, a comma separated list of 8, 16, 32 and 64 (8,16,32,64)
+//   threads         threads running operations (4)
+//   keys            keys loaded before the run, which the operations draw from (100000)
+//   load            percent of the buckets that the loaded keys take, growth starts at HASH_TABLE_MAX_LOAD_PERCENT (50)
+//   insert-percent  operations that insert a new pair of a key (10)
+//   remove-percent  operations that remove a pair that the thread inserted, if any is left (10)
+//   dist            the keys of the operations: uniform, zipf50, zipf75, zipf95 or zipf99 (uniform)
+//   ops             operations per thread (200000)
+//   pool            frames of the buffer pool (4096)
+//   pin             1 to pin the threads to fixed CPUs, see RunPinnedThreads() (1)
+//   db              the database file, deleted at the end (hash_table_bench.db)
+//
+// The rest of the operations look a key up.
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/bench_harness.h"
+#include "buffer/buffer_pool_manager.h"
+#include "container/hash/hash_function.h"
+#include "container/hash/linear_probe_hash_table.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+namespace {
+
+struct BenchConfig {
+  std::vector<size_t> key_sizes_ = {8, 16, 32, 64};
+  size_t threads_ = 4;
+  size_t keys_ = 100000;
+  size_t load_ = 50;
+  size_t insert_percent_ = 10;
+  size_t remove_percent_ = 10;
+  TableGenerator::Dist dist_ = TableGenerator::Dist::Uniform;
+  size_t ops_ = 200000;
+  size_t pool_ = 4096;
+  bool pin_ = true;
+  std::string db_ = "hash_table_bench.db";
+};
+
+/** @return false if an option is unknown or its value is not valid */
+bool ParseArgs(int argc, char **argv, BenchConfig *config) {
+  BenchOptions options(argc, argv);
+  std::istringstream key_sizes(options.GetString("key-sizes", "8,16,32,64"));
+  config->key_sizes_.clear();
+  for (std::string key_size; std::getline(key_sizes, key_size, ',');) {
+    options.Require(key_size == "8" || key_size == "16" || key_size == "32" || key_size == "64");
+    config->key_sizes_.push_back(std::strtoull(key_size.c_str(), nullptr, 10));
+  }
+  config->threads_ = options.GetSize("threads", config->threads_);
+  config->keys_ = options.GetSize("keys", config->keys_);
+  config->load_ = options.GetSize("load", config->load_);
+  config->insert_percent_ = options.GetSize("insert-percent", config->insert_percent_);
+  config->remove_percent_ = options.GetSize("remove-percent", config->remove_percent_);
+  config->dist_ = options.GetDist("dist", config->dist_);
+  config->ops_ = options.GetSize("ops", config->ops_);
+  config->pool_ = options.GetSize("pool", config->pool_);
+  config->pin_ = options.GetSize("pin", 1) != 0;
+  config->db_ = options.GetString("db", config->db_);
+  options.Require(!config->key_sizes_.empty() && config->threads_ > 0 && config->keys_ > 0 && config->load_ > 0 &&
+                  config->load_ <= 100 && config->insert_percent_ + config->remove_percent_ <= 100 &&
+                  config->pool_ > 0);
+  return options.IsValid();
+}
+
+/** The operations that a thread ran. */
+struct OpCounts {
+  size_t inserts_{0};
+  size_t lookups_{0};
+  size_t removes_{0};
+  size_t found_{0};
+};
+
+/** Prints the probe lengths of the pairs of a table: their histogram and the bucket of their 99th percentile. */
+void PrintProbeLengths(const HashTableStats &stats) {
+  printf("  load:        %.3f, %.3f tombstones, %zu pairs in %zu buckets\n", stats.LoadFactor(),
+         stats.TombstoneRatio(), stats.num_pairs_, stats.num_buckets_);
+  printf("  probe lengths:");
+  size_t counted = 0;
+  size_t p99_bucket = 0;
+  for (size_t i = 0; i < stats.probe_lengths_.size(); i++) {
+    if (stats.probe_lengths_[i] != 0) {
+      printf(" [%zu,%zu): %zu", (size_t{1} << i) - 1, (size_t{2} << i) - 1, stats.probe_lengths_[i]);
+    }
+    counted += stats.probe_lengths_[i];
+    if (counted * 100 < stats.num_pairs_ * 99) {
+      p99_bucket = i + 1;
+    }
+  }
+  printf("\n  p99 probe:   < %zu buckets\n", (size_t{2} << p99_bucket) - 1);
+}
+
+template <size_t KeySize>
+int RunKeySize(const BenchConfig &config) {
+  using Key = GenericKey<KeySize>;
+  using Table = LinearProbeHashTable<Key, RID, GenericComparator<KeySize>>;
+  RemoveDatabaseFiles(config.db_);
+  auto disk_manager = std::make_unique<DiskManager>(config.db_);
+  auto bpm = std::make_unique<BufferPoolManager>(config.pool_, disk_manager.get());
+  Schema key_schema({Column("k", TypeId::BIGINT)});
+  GenericComparator<KeySize> comparator(&key_schema);
+  auto make_key = [](uint64_t k) {
+    Key key;
+    key.SetFromInteger(static_cast<int64_t>(k));
+    return key;
+  };
+
+  // Key k is loaded with the value (k, 0); the table starts with as many blocks as the load asks for.
+  using KeyType = Key;
+  using ValueType = RID;
+  const size_t bucket_percents = BLOCK_ARRAY_SIZE * config.load_;
+  const size_t num_blocks = (config.keys_ * 100 + bucket_percents - 1) / bucket_percents;
+  auto table = std::make_unique<Table>("hash_table_bench", bpm.get(), comparator, num_blocks, HashFunction<Key>());
+  std::vector<std::pair<Key, RID>> pairs;
+  pairs.reserve(config.keys_);
+  for (size_t k = 0; k < config.keys_; k++) {
+    pairs.emplace_back(make_key(k), RID(static_cast<page_id_t>(k), 0));
+  }
+  if (!table->BulkLoad(pairs)) {
+    fprintf(stderr, "Could not load %zu keys, the buffer pool may be too small.\n", config.keys_);
+    return 1;
+  }
+  pairs.clear();
+  HashTableStats stats;
+  table->GetStats(&stats);
+  printf("GenericKey<%zu>\n", KeySize);
+  PrintProbeLengths(stats);
+
+  std::vector<OpCounts> counts(config.threads_);
+  const double seconds = RunPinnedThreads(config.threads_, config.pin_, [&](size_t thread) {
+    TableGenerator::Sampler keys(config.dist_, 0, config.keys_ - 1, thread + 1);
+    std::mt19937_64 generator(thread);
+    std::uniform_int_distribution<size_t> percent(0, 99);
+    // The pairs that the thread inserted and did not remove yet, oldest first. Their values are unique to the thread.
+    std::deque<std::pair<Key, RID>> inserted;
+    std::vector<RID> result;
+    OpCounts *count = &counts[thread];
+    for (size_t op = 0; op < config.ops_; op++) {
+      const Key key = make_key(keys.Next());
+      const size_t draw = percent(generator);
+      if (draw < config.insert_percent_) {
+        const RID value(static_cast<page_id_t>(config.keys_ + thread), static_cast<uint32_t>(op));
+        table->Insert(nullptr, key, value);
+        inserted.emplace_back(key, value);
+        count->inserts_++;
+      } else if (draw < config.insert_percent_ + config.remove_percent_ && !inserted.empty()) {
+        table->Remove(nullptr, inserted.front().first, inserted.front().second);
+        inserted.pop_front();
+        count->removes_++;
+      } else {
+        result.clear();
+        table->GetValue(nullptr, key, &result);
+        count->lookups_++;
+        count->found_ += result.empty() ? 0 : 1;
+      }
+    }
+  });
+
+  OpCounts total;
+  for (const OpCounts &count : counts) {
+    total.inserts_ += count.inserts_;
+    total.lookups_ += count.lookups_;
+    total.removes_ += count.removes_;
+    total.found_ += count.found_;
+  }
+  const size_t num_ops = total.inserts_ + total.lookups_ + total.removes_;
+  printf("  operations:  %zu in %.3f s, %.0f ops/s\n", num_ops, seconds, static_cast<double>(num_ops) / seconds);
+  printf("  mix:         %zu inserts, %zu lookups (%zu found), %zu removes\n", total.inserts_, total.lookups_,
+         total.found_, total.removes_);
+  table->GetStats(&stats);
+  PrintProbeLengths(stats);
+
+  table.reset();
+  bpm.reset();
+  disk_manager->ShutDown();
+  RemoveDatabaseFiles(config.db_);
+  return 0;
+}
+
+}  // namespace
+
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  bustub::BenchConfig config;
+  if (!bustub::ParseArgs(argc, argv, &config)) {
+    fprintf(stderr,
+            "usage: %s [--key-sizes=8,16,32,64] [--threads=N] [--keys=N] [--load=P] [--insert-percent=P]\n"
+            "  [--remove-percent=P] [--dist=uniform|zipf50|zipf75|zipf95|zipf99] [--ops=N] [--pool=N] [--pin=0|1]\n"
+            "  [--db=FILE]\n",
+            argv[0]);
+    return 1;
+  }
+  for (size_t key_size : config.key_sizes_) {
+    int result = 0;
+    switch (key_size) {
+      case 8:
+        result = bustub::RunKeySize<8>(config);
+        break;
+      case 16:
+        result = bustub::RunKeySize<16>(config);
+        break;
+      case 32:
+        result = bustub::RunKeySize<32>(config);
+        break;
+      default:
+        result = bustub::RunKeySize<64>(config);
+        break;
+    }
+    if (result != 0) {
+      return result;
+    }
+  }
+  return 0;
+}
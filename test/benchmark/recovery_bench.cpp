@@ -0,0 +1,547 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// recovery_bench.cpp
+//
+// Identification: test/benchmark/recovery_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Crashes a database at a random point of a logged workload, recovers it, and reports how long redo and undo took,
+// how fast redo read the log, and whether the table came back right, e.g.
+//
+//   recovery_bench --log-mb=256 --threads=8 --checkpoint-mb=64 --redo-workers=8 --trials=5 --kill=1
+//
+// Writer threads run transactions on a table of their own rows: inserts, and updates and deletes of rows that they
+// inserted before. Every transaction is noted in a journal file before it commits and once more after, and the crash
+// comes once the log has grown to a random size between half of log-mb and log-mb. With kill, the workload runs in a
+// child process that is killed with SIGKILL; otherwise the crash is simulated: the writers stop wherever they are, and
+// the database is dropped without writing back its dirty pages. Recovery then runs Redo() and Undo(), and the table
+// is checked against the journal: every committed transaction must be there, none that did not commit, and the ones
+// that were committing at the crash must be there either whole or not at all.
+//
+// Options, all --name=value:
+//   log-mb         the most log that a trial writes before the crash, in MB (64)
+//   threads        writer threads (4)
+//   txn-size       rows that a transaction writes (16)
+//   update-percent writes that update a row of the thread (30)
+//   delete-percent writes that delete a row of the thread, the rest insert one (10)
+//   tuple-size     bytes of a row (100)
+//   checkpoint-mb  MB of log between fuzzy checkpoints, 0 for none (0)
+//   flush          1 to let the background flusher write back dirty pages, 0 to leave them all to redo (1)
+//   redo-workers   threads of redo (REDO_WORKERS)
+//   pool           frames of the buffer pool (4096)
+//   trials         crashes, each of a new database (3)
+//   kill           1 to kill a child process, 0 to simulate the crash in process (0)
+//   seed           seed of the crash points and of the writes (0)
+//   pin            1 to pin the writers to fixed CPUs, see RunPinnedThreads() (1)
+//   db             the database file, deleted at the end (recovery_bench.db)
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "benchmark/bench_harness.h"
+#include "common/bustub_instance.h"
+#include "concurrency/transaction_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+struct BenchConfig {
+  size_t log_mb_ = 64;
+  size_t threads_ = 4;
+  size_t txn_size_ = 16;
+  size_t update_percent_ = 30;
+  size_t delete_percent_ = 10;
+  size_t tuple_size_ = 100;
+  size_t checkpoint_mb_ = 0;
+  bool flush_ = true;
+  size_t redo_workers_ = REDO_WORKERS;
+  size_t pool_ = 4096;
+  size_t trials_ = 3;
+  bool kill_ = false;
+  size_t seed_ = 0;
+  bool pin_ = true;
+  std::string db_ = "recovery_bench.db";
+};
+
+/** @return false if an option is unknown or its value is not valid */
+bool ParseArgs(int argc, char **argv, BenchConfig *config) {
+  BenchOptions options(argc, argv);
+  config->log_mb_ = options.GetSize("log-mb", config->log_mb_);
+  config->threads_ = options.GetSize("threads", config->threads_);
+  config->txn_size_ = options.GetSize("txn-size", config->txn_size_);
+  config->update_percent_ = options.GetSize("update-percent", config->update_percent_);
+  config->delete_percent_ = options.GetSize("delete-percent", config->delete_percent_);
+  config->tuple_size_ = options.GetSize("tuple-size", config->tuple_size_);
+  config->checkpoint_mb_ = options.GetSize("checkpoint-mb", config->checkpoint_mb_);
+  config->flush_ = options.GetSize("flush", 1) != 0;
+  config->redo_workers_ = options.GetSize("redo-workers", config->redo_workers_);
+  config->pool_ = options.GetSize("pool", config->pool_);
+  config->trials_ = options.GetSize("trials", config->trials_);
+  config->kill_ = options.GetSize("kill", 0) != 0;
+  config->seed_ = options.GetSize("seed", config->seed_);
+  config->pin_ = options.GetSize("pin", 1) != 0;
+  config->db_ = options.GetString("db", config->db_);
+  // A row is two BIGINTs and a VARCHAR, which takes 4 bytes of offset and 4 of length besides its data.
+  options.Require(config->log_mb_ > 0 && config->threads_ > 0 && config->txn_size_ > 0 &&
+                  config->update_percent_ + config->delete_percent_ <= 100 && config->tuple_size_ >= 25 &&
+                  config->tuple_size_ <= PAGE_SIZE / 4 && config->redo_workers_ > 0 && config->pool_ > 0 &&
+                  config->trials_ > 0);
+  return options.IsValid();
+}
+
+/**
+ * The journal tells the checker what the writers did: the first page of their table, the rows that a transaction
+ * left behind before it commits, and its commit once Commit() returned. A record is written with a single write(),
+ * so that a kill leaves at most a torn last record, which is ignored.
+ */
+enum class JournalKind : uint32_t { TABLE, INTENT, COMMIT };
+
+struct JournalHeader {
+  JournalKind kind_;
+  uint32_t num_rows_;
+  uint64_t value_;
+};
+
+/**
+ * A row as a transaction left it: the value of the row, or DELETED. Rows go by their keys, which are unique, since
+ * a slot that a delete freed may be taken by an insert of another thread before the delete is in the journal.
+ */
+struct JournalRow {
+  int64_t key_;
+  int64_t value_;
+};
+
+constexpr int64_t DELETED = -1;
+
+class Journal {
+ public:
+  explicit Journal(const std::string &file_name)
+      : fd_(open(file_name.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_APPEND, 0644)) {}
+
+  ~Journal() { close(fd_); }
+
+  void Write(JournalKind kind, uint64_t value, const std::vector<JournalRow> &rows = {}) {
+    std::vector<char> record(sizeof(JournalHeader) + rows.size() * sizeof(JournalRow));
+    const JournalHeader header{kind, static_cast<uint32_t>(rows.size()), value};
+    memcpy(record.data(), &header, sizeof(header));
+    if (!rows.empty()) {
+      memcpy(record.data() + sizeof(header), rows.data(), rows.size() * sizeof(JournalRow));
+    }
+    std::scoped_lock lock(latch_);
+    if (write(fd_, record.data(), record.size()) != static_cast<ssize_t>(record.size())) {
+      perror("journal");
+    }
+  }
+
+ private:
+  int fd_;
+  std::mutex latch_;
+};
+
+/** The schema of the table: a key, the value that the checker checks, and padding up to tuple-size bytes. */
+Schema MakeSchema(const BenchConfig &config) {
+  const auto pad = static_cast<uint32_t>(config.tuple_size_ - 24);
+  return Schema({Column("k", TypeId::BIGINT), Column("v", TypeId::BIGINT), Column("pad", TypeId::VARCHAR, pad)});
+}
+
+Tuple MakeTuple(const Schema &schema, const std::string &pad, int64_t key, int64_t value) {
+  return Tuple({ValueFactory::GetBigIntValue(key), ValueFactory::GetBigIntValue(value),
+                ValueFactory::GetVarcharValue(pad.c_str(), true)},
+               &schema);
+}
+
+/** @return the bytes of the log of a database on disk, counting from the start of its first segment */
+int64_t GetLogFileSize(const std::string &db_file) {
+  const std::string log_name = db_file.substr(0, db_file.rfind('.')) + ".log";
+  int64_t last_segment = 0;
+  for (int64_t segment = 1; std::ifstream(log_name + "." + std::to_string(segment)).good(); segment++) {
+    last_segment = segment;
+  }
+  const std::string last_name = last_segment == 0 ? log_name : log_name + "." + std::to_string(last_segment);
+  std::ifstream last(last_name, std::ios::binary | std::ios::ate);
+  return last_segment * LOG_SEGMENT_SIZE + (last.good() ? static_cast<int64_t>(last.tellg()) : 0);
+}
+
+/**
+ * Runs the workload until stop is set, or until the log reaches max_log_bytes, and returns with the transactions
+ * that were running at that point left as they are. Must only be followed by dropping the database.
+ */
+void RunWorkload(const BenchConfig &config, size_t trial, int64_t max_log_bytes, std::atomic<bool> *stop) {
+  BustubConfig bustub_config;
+  bustub_config.buffer_pool_size = config.pool_;
+  auto *instance = new BustubInstance(config.db_, bustub_config);
+  instance->log_manager_->RunFlushThread();
+  TransactionManager *txn_mgr = instance->transaction_manager_;
+  Journal journal(config.db_ + ".journal");
+  const Schema schema = MakeSchema(config);
+  const std::string pad(config.tuple_size_ - 25, 'p');
+
+  Transaction *create_txn = txn_mgr->Begin();
+  auto *table = new TableHeap(instance->buffer_pool_manager_, instance->lock_manager_, instance->log_manager_,
+                              create_txn);
+  txn_mgr->Commit(create_txn);
+  journal.Write(JournalKind::TABLE, static_cast<uint64_t>(table->GetFirstPageId()));
+
+  // The monitor takes the checkpoints and calls the crash.
+  std::thread monitor([&] {
+    int64_t next_checkpoint = config.checkpoint_mb_ == 0 ? INT64_MAX : config.checkpoint_mb_ << 20;
+    while (!stop->load()) {
+      const int64_t log_size = instance->disk_manager_->GetLogSize();
+      if (log_size >= max_log_bytes) {
+        stop->store(true);
+        break;
+      }
+      if (log_size >= next_checkpoint) {
+        instance->checkpoint_manager_->BeginCheckpoint();
+        instance->checkpoint_manager_->EndCheckpoint();
+        next_checkpoint += config.checkpoint_mb_ << 20;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  });
+
+  std::atomic<uint64_t> next_txn{1};
+  std::vector<Transaction *> running(config.threads_, nullptr);
+  RunPinnedThreads(config.threads_, config.pin_, [&](size_t thread) {
+    std::mt19937_64 generator(config.seed_ * 1000003 + trial * 1009 + thread);
+    std::uniform_int_distribution<size_t> percent(0, 99);
+    // The committed rows of the thread, which only it updates and deletes, and the rows of its transaction.
+    std::vector<std::pair<RID, int64_t>> owned;
+    std::vector<std::pair<RID, int64_t>> taken;
+    std::vector<std::pair<RID, int64_t>> written;
+    std::vector<JournalRow> rows;
+    while (!stop->load()) {
+      const uint64_t txn_id = next_txn.fetch_add(1);
+      Transaction *txn = txn_mgr->Begin();
+      running[thread] = txn;
+      rows.clear();
+      taken.clear();
+      written.clear();
+      bool ok = true;
+      for (size_t i = 0; i < config.txn_size_ && ok && !stop->load(); i++) {
+        const size_t draw = percent(generator);
+        const auto value = static_cast<int64_t>(txn_id);
+        if (draw >= config.update_percent_ + config.delete_percent_ || owned.empty()) {
+          RID rid;
+          const int64_t key = value * static_cast<int64_t>(config.txn_size_) + static_cast<int64_t>(i);
+          ok = table->InsertTuple(MakeTuple(schema, pad, key, value), &rid, txn);
+          written.emplace_back(rid, key);
+          rows.push_back({key, value});
+          continue;
+        }
+        // A row is written at most once by a transaction, it goes back to the owned rows once that ends.
+        const size_t index = std::uniform_int_distribution<size_t>(0, owned.size() - 1)(generator);
+        const auto [rid, key] = owned[index];
+        owned[index] = owned.back();
+        owned.pop_back();
+        taken.emplace_back(rid, key);
+        written.emplace_back(rid, key);
+        if (draw < config.update_percent_) {
+          ok = table->UpdateTuple(MakeTuple(schema, pad, key, value), rid, txn);
+          rows.push_back({key, value});
+        } else {
+          ok = table->MarkDelete(rid, txn);
+          rows.push_back({key, DELETED});
+        }
+      }
+      if (stop->load()) {
+        // The crash: the transaction stays running.
+        return;
+      }
+      if (!ok) {
+        txn_mgr->Abort(txn);
+        running[thread] = nullptr;
+        txn_mgr->Recycle(txn);
+        owned.insert(owned.end(), taken.begin(), taken.end());
+        continue;
+      }
+      journal.Write(JournalKind::INTENT, txn_id, rows);
+      txn_mgr->Commit(txn);
+      journal.Write(JournalKind::COMMIT, txn_id);
+      running[thread] = nullptr;
+      for (size_t i = 0; i < rows.size(); i++) {
+        if (rows[i].value_ != DELETED) {
+          owned.push_back(written[i]);
+        }
+      }
+      txn_mgr->Recycle(txn);
+    }
+  });
+  stop->store(true);
+  monitor.join();
+
+  // The crash drops the dirty pages. The log buffer may still be written, as it could have been just before a crash.
+  delete table;
+  delete instance;
+  for (Transaction *txn : running) {
+    delete txn;
+  }
+}
+
+/** What the journal says the table holds, and what it may hold. */
+struct Expectation {
+  page_id_t first_page_id_{INVALID_PAGE_ID};
+  /** The rows of the committed transactions, by key, with their values. */
+  std::unordered_map<int64_t, int64_t> rows_;
+  /** The transactions that were committing at the crash, with their rows. */
+  std::vector<std::vector<JournalRow>> in_doubt_;
+  size_t num_committed_{0};
+};
+
+Expectation ReadJournal(const std::string &file_name) {
+  std::ifstream file(file_name, std::ios::binary);
+  const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  Expectation expectation;
+  std::unordered_map<uint64_t, std::vector<JournalRow>> intents;
+  size_t offset = 0;
+  while (offset + sizeof(JournalHeader) <= data.size()) {
+    JournalHeader header;
+    memcpy(&header, data.data() + offset, sizeof(header));
+    const size_t size = sizeof(header) + header.num_rows_ * sizeof(JournalRow);
+    if (offset + size > data.size()) {
+      break;
+    }
+    std::vector<JournalRow> rows(header.num_rows_);
+    if (!rows.empty()) {
+      memcpy(rows.data(), data.data() + offset + sizeof(header), rows.size() * sizeof(JournalRow));
+    }
+    offset += size;
+    switch (header.kind_) {
+      case JournalKind::TABLE:
+        expectation.first_page_id_ = static_cast<page_id_t>(header.value_);
+        break;
+      case JournalKind::INTENT:
+        intents[header.value_] = std::move(rows);
+        break;
+      case JournalKind::COMMIT:
+        // The rows of a thread are its own, so the commits of different threads may be applied in any order.
+        for (const JournalRow &row : intents[header.value_]) {
+          if (row.value_ == DELETED) {
+            expectation.rows_.erase(row.key_);
+          } else {
+            expectation.rows_[row.key_] = row.value_;
+          }
+        }
+        intents.erase(header.value_);
+        expectation.num_committed_++;
+        break;
+    }
+  }
+  for (auto &[txn_id, rows] : intents) {
+    expectation.in_doubt_.push_back(std::move(rows));
+  }
+  return expectation;
+}
+
+/** The outcome of the check of a recovered table. */
+struct CheckResult {
+  size_t in_doubt_applied_{0};
+  size_t in_doubt_undone_{0};
+  size_t torn_{0};
+  size_t lost_{0};
+  size_t wrong_{0};
+  size_t extra_{0};
+
+  bool IsCorrect() const { return torn_ == 0 && lost_ == 0 && wrong_ == 0 && extra_ == 0; }
+};
+
+CheckResult CheckTable(BustubInstance *instance, const Schema &schema, Expectation *expectation) {
+  std::unordered_map<int64_t, int64_t> actual;
+  Transaction *txn = instance->transaction_manager_->Begin();
+  TableHeap table(instance->buffer_pool_manager_, instance->lock_manager_, instance->log_manager_,
+                  expectation->first_page_id_);
+  for (auto it = table.Begin(txn); it != table.End(); ++it) {
+    actual[it->GetValue(&schema, 0).GetAs<int64_t>()] = it->GetValue(&schema, 1).GetAs<int64_t>();
+  }
+  instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  CheckResult result;
+  auto state_of = [](const std::unordered_map<int64_t, int64_t> &rows, int64_t key) {
+    auto it = rows.find(key);
+    return it == rows.end() ? DELETED : it->second;
+  };
+  for (const std::vector<JournalRow> &rows : expectation->in_doubt_) {
+    const bool applied = std::all_of(rows.begin(), rows.end(), [&](const JournalRow &row) {
+      return state_of(actual, row.key_) == row.value_;
+    });
+    const bool undone = std::all_of(rows.begin(), rows.end(), [&](const JournalRow &row) {
+      return state_of(actual, row.key_) == state_of(expectation->rows_, row.key_);
+    });
+    if (applied && !undone) {
+      result.in_doubt_applied_++;
+      for (const JournalRow &row : rows) {
+        if (row.value_ == DELETED) {
+          expectation->rows_.erase(row.key_);
+        } else {
+          expectation->rows_[row.key_] = row.value_;
+        }
+      }
+    } else if (undone) {
+      result.in_doubt_undone_++;
+    } else {
+      result.torn_++;
+    }
+  }
+  for (const auto &[key, value] : expectation->rows_) {
+    auto it = actual.find(key);
+    if (it == actual.end()) {
+      result.lost_++;
+    } else if (it->second != value) {
+      result.wrong_++;
+    }
+  }
+  for (const auto &[key, value] : actual) {
+    result.extra_ += expectation->rows_.count(key) == 0 ? 1 : 0;
+  }
+  return result;
+}
+
+/** The measurements of a trial. */
+struct TrialResult {
+  double log_mb_{0};
+  double redo_mb_{0};
+  size_t redone_records_{0};
+  double redo_seconds_{0};
+  double undo_seconds_{0};
+  bool correct_{false};
+};
+
+/** @return false if the crashed workload could not be run */
+bool RunTrial(const BenchConfig &config, size_t trial, TrialResult *trial_result) {
+  RemoveDatabaseFiles(config.db_);
+  std::mt19937_64 generator(config.seed_ * 7919 + trial);
+  const int64_t max_log_bytes = static_cast<int64_t>(config.log_mb_ << 20);
+  const int64_t crash_bytes = std::uniform_int_distribution<int64_t>(max_log_bytes / 2, max_log_bytes)(generator);
+
+  if (config.kill_) {
+    // The child only stops by itself if it outgrows the crash point by far, e.g. because the parent is gone.
+    const pid_t child = fork();
+    if (child < 0) {
+      perror("fork");
+      return false;
+    }
+    if (child == 0) {
+      std::atomic<bool> stop{false};
+      RunWorkload(config, trial, max_log_bytes * 2, &stop);
+      _exit(0);
+    }
+    while (GetLogFileSize(config.db_) < crash_bytes && waitpid(child, nullptr, WNOHANG) == 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+  } else {
+    std::atomic<bool> stop{false};
+    RunWorkload(config, trial, crash_bytes, &stop);
+  }
+
+  BustubConfig bustub_config;
+  bustub_config.buffer_pool_size = config.pool_;
+  auto instance = std::make_unique<BustubInstance>(config.db_, bustub_config);
+  const int64_t log_size = instance->disk_manager_->GetLogSize();
+  LogRecovery recovery(instance->disk_manager_, instance->buffer_pool_manager_, LOG_BUFFER_SIZE, config.redo_workers_);
+  const auto redo_start = std::chrono::steady_clock::now();
+  recovery.Redo();
+  const auto undo_start = std::chrono::steady_clock::now();
+  recovery.Undo();
+  const auto undo_end = std::chrono::steady_clock::now();
+
+  trial_result->log_mb_ = static_cast<double>(log_size) / (1 << 20);
+  trial_result->redo_mb_ = static_cast<double>(log_size - recovery.GetRedoStartOffset()) / (1 << 20);
+  trial_result->redone_records_ = recovery.GetNumRedoneRecords();
+  trial_result->redo_seconds_ = std::chrono::duration<double>(undo_start - redo_start).count();
+  trial_result->undo_seconds_ = std::chrono::duration<double>(undo_end - undo_start).count();
+
+  Expectation expectation = ReadJournal(config.db_ + ".journal");
+  const Schema schema = MakeSchema(config);
+  const CheckResult check = CheckTable(instance.get(), schema, &expectation);
+  trial_result->correct_ = check.IsCorrect();
+  printf("trial %zu: crash at %.1f MB of log, %zu transactions committed, %zu in doubt (%zu applied, %zu undone)\n",
+         trial, trial_result->log_mb_, expectation.num_committed_, expectation.in_doubt_.size(),
+         check.in_doubt_applied_, check.in_doubt_undone_);
+  printf("  redo:  %.1f MB from offset %ld, %zu records applied, %.3f s, %.1f MB/s\n", trial_result->redo_mb_,
+         recovery.GetRedoStartOffset(), trial_result->redone_records_, trial_result->redo_seconds_,
+         trial_result->redo_mb_ / std::max(trial_result->redo_seconds_, 1e-9));
+  printf("  undo:  %.3f s\n", trial_result->undo_seconds_);
+  if (check.IsCorrect()) {
+    printf("  check: ok, %zu rows\n", expectation.rows_.size());
+  } else {
+    printf("  check: FAILED, %zu committed rows lost, %zu wrong, %zu uncommitted rows left, %zu torn transactions\n",
+           check.lost_, check.wrong_, check.extra_, check.torn_);
+  }
+
+  instance.reset();
+  RemoveDatabaseFiles(config.db_);
+  return true;
+}
+
+int RunBench(const BenchConfig &config) {
+  if (!config.flush_) {
+    flush_interval = std::chrono::hours(1);
+  }
+  std::vector<TrialResult> results(config.trials_);
+  for (size_t trial = 0; trial < config.trials_; trial++) {
+    if (!RunTrial(config, trial, &results[trial])) {
+      return 1;
+    }
+  }
+  double redo_mb = 0;
+  double redo_seconds = 0;
+  double undo_seconds = 0;
+  size_t failed = 0;
+  for (const TrialResult &result : results) {
+    redo_mb += result.redo_mb_;
+    redo_seconds += result.redo_seconds_;
+    undo_seconds += result.undo_seconds_;
+    failed += result.correct_ ? 0 : 1;
+  }
+  printf("total: redo %.1f MB/s, %.3f s of redo and %.3f s of undo per trial, %zu of %zu trials failed the check\n",
+         redo_mb / std::max(redo_seconds, 1e-9), redo_seconds / config.trials_, undo_seconds / config.trials_,
+         failed, config.trials_);
+  return failed == 0 ? 0 : 1;
+}
+
+}  // namespace
+
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  bustub::BenchConfig config;
+  if (!bustub::ParseArgs(argc, argv, &config)) {
+    fprintf(stderr,
+            "usage: %s [--log-mb=N] [--threads=N] [--txn-size=N] [--update-percent=P] [--delete-percent=P]\n"
+            "  [--tuple-size=N] [--checkpoint-mb=N] [--flush=0|1] [--redo-workers=N] [--pool=N] [--trials=N]\n"
+            "  [--kill=0|1] [--seed=N] [--pin=0|1] [--db=FILE]\n",
+            argv[0]);
+    return 1;
+  }
+  return bustub::RunBench(config);
+}
@@ -0,0 +1,195 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// txn_bench.cpp
+//
+// Identification: test/benchmark/txn_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Runs synthetic two-phase locking transactions through a TransactionManager and a LockManager from several threads,
+// and reports the commit throughput, the abort rate, the time spent waiting for locks and the cost of deadlock
+// handling. Compares deadlock modes and contention levels, e.g.
+//
+//   txn_bench --threads=16 --hot-rows=64 --hot-percent=90 --read-percent=50 --txn-length=16 --deadlock=detection
+//
+// Options, all --name=value:
+//   threads       threads running transactions, one at a time each (4)
+//   rows          rows that the transactions lock (100000)
+//   hot-rows      rows of the hot set, the first rows (1000)
+//   hot-percent   accesses that go to the hot set, the rest go to any row (80)
+//   read-percent  accesses that take a shared lock, the rest take an exclusive one or upgrade a shared one (80)
+//   txn-length    rows that a transaction accesses (8)
+//   deadlock      prevention (wait-die), wound_wait or detection (prevention)
+//   twopl         regular or strict (strict)
+//   interval      milliseconds between the rounds of cycle detection, or between the checks of a waiting request for a
+//                 wound, 0 for the defaults cycle_detection_interval and wound_check_interval (0)
+//   txns          transactions per thread, committed or aborted (20000)
+//   pin           1 to pin the threads to fixed CPUs, see RunPinnedThreads() (1)
+//
+// An aborted transaction is not retried, the thread goes on with a new one.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/bench_harness.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+
+namespace bustub {
+
+namespace {
+
+struct BenchConfig {
+  size_t threads_ = 4;
+  size_t rows_ = 100000;
+  size_t hot_rows_ = 1000;
+  size_t hot_percent_ = 80;
+  size_t read_percent_ = 80;
+  size_t txn_length_ = 8;
+  DeadlockMode deadlock_ = DeadlockMode::PREVENTION;
+  TwoPLMode twopl_ = TwoPLMode::STRICT;
+  size_t interval_ = 0;
+  size_t txns_ = 20000;
+  bool pin_ = true;
+};
+
+/** @return false if an option is unknown or its value is not valid */
+bool ParseArgs(int argc, char **argv, BenchConfig *config) {
+  BenchOptions options(argc, argv);
+  config->threads_ = options.GetSize("threads", config->threads_);
+  config->rows_ = options.GetSize("rows", config->rows_);
+  config->hot_rows_ = options.GetSize("hot-rows", config->hot_rows_);
+  config->hot_percent_ = options.GetSize("hot-percent", config->hot_percent_);
+  config->read_percent_ = options.GetSize("read-percent", config->read_percent_);
+  config->txn_length_ = options.GetSize("txn-length", config->txn_length_);
+  const std::string deadlock = options.GetString("deadlock", "prevention");
+  options.Require(deadlock == "prevention" || deadlock == "wound_wait" || deadlock == "detection");
+  config->deadlock_ = deadlock == "detection"    ? DeadlockMode::DETECTION
+                      : deadlock == "wound_wait" ? DeadlockMode::WOUND_WAIT
+                                                 : DeadlockMode::PREVENTION;
+  const std::string twopl = options.GetString("twopl", "strict");
+  options.Require(twopl == "regular" || twopl == "strict");
+  config->twopl_ = twopl == "regular" ? TwoPLMode::REGULAR : TwoPLMode::STRICT;
+  config->interval_ = options.GetSize("interval", config->interval_);
+  config->txns_ = options.GetSize("txns", config->txns_);
+  config->pin_ = options.GetSize("pin", 1) != 0;
+  options.Require(config->threads_ > 0 && config->rows_ > 0 && config->hot_rows_ > 0 &&
+                  config->hot_rows_ <= config->rows_ && config->hot_percent_ <= 100 && config->read_percent_ <= 100 &&
+                  config->txn_length_ > 0);
+  return options.IsValid();
+}
+
+/** The transactions that a thread ran. */
+struct TxnCounts {
+  size_t commits_{0};
+  size_t aborts_{0};
+  /** Nanoseconds of each committed transaction, from its begin to the return of its commit. */
+  std::vector<uint64_t> latencies_;
+};
+
+/** Runs the transactions of a thread, each locks txn_length rows, one after the other, and commits. */
+void RunThread(const BenchConfig &config, TransactionManager *txn_mgr, LockManager *lock_mgr, size_t thread,
+               TxnCounts *count) {
+  std::mt19937_64 generator(thread);
+  std::uniform_int_distribution<size_t> percent(0, 99);
+  std::uniform_int_distribution<size_t> hot_row(0, config.hot_rows_ - 1);
+  std::uniform_int_distribution<size_t> any_row(0, config.rows_ - 1);
+  count->latencies_.reserve(config.txns_);
+  for (size_t t = 0; t < config.txns_; t++) {
+    const auto start = std::chrono::steady_clock::now();
+    Transaction *txn = txn_mgr->Begin();
+    bool locked = true;
+    for (size_t access = 0; access < config.txn_length_ && locked; access++) {
+      const size_t row = percent(generator) < config.hot_percent_ ? hot_row(generator) : any_row(generator);
+      const RID rid(static_cast<page_id_t>(row / 256), static_cast<uint32_t>(row % 256));
+      if (percent(generator) < config.read_percent_) {
+        locked = lock_mgr->LockShared(txn, rid);
+      } else if (txn->IsSharedLocked(rid)) {
+        locked = lock_mgr->LockUpgrade(txn, rid);
+      } else {
+        locked = txn->IsExclusiveLocked(rid) || lock_mgr->LockExclusive(txn, rid);
+      }
+    }
+    // A wounded transaction may only find out at its commit.
+    if (locked && txn->GetState() != TransactionState::ABORTED) {
+      txn_mgr->Commit(txn);
+      count->commits_++;
+      count->latencies_.push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    } else {
+      txn_mgr->Abort(txn);
+      count->aborts_++;
+    }
+    txn_mgr->Recycle(txn);
+  }
+}
+
+int RunBench(const BenchConfig &config) {
+  if (config.interval_ != 0) {
+    cycle_detection_interval = std::chrono::milliseconds(config.interval_);
+    wound_check_interval = std::chrono::milliseconds(config.interval_);
+  }
+  LockManager lock_mgr(config.twopl_, config.deadlock_);
+  TransactionManager txn_mgr(&lock_mgr);
+  const LockManagerStats before = lock_mgr.GetStats();
+  std::vector<TxnCounts> counts(config.threads_);
+  const double seconds = RunPinnedThreads(config.threads_, config.pin_, [&](size_t thread) {
+    RunThread(config, &txn_mgr, &lock_mgr, thread, &counts[thread]);
+  });
+  const LockManagerStats after = lock_mgr.GetStats();
+
+  std::vector<uint64_t> all;
+  size_t commits = 0;
+  size_t aborts = 0;
+  for (const TxnCounts &count : counts) {
+    commits += count.commits_;
+    aborts += count.aborts_;
+    all.insert(all.end(), count.latencies_.begin(), count.latencies_.end());
+  }
+  std::sort(all.begin(), all.end());
+  const uint64_t waits = after.lock_waits - before.lock_waits;
+  const uint64_t wait_us = after.lock_wait_time_us - before.lock_wait_time_us;
+  const uint64_t detection_us = after.detection_time_us - before.detection_time_us;
+  printf("transactions: %zu in %.3f s, %zu committed, %zu aborted\n", commits + aborts, seconds, commits, aborts);
+  printf("throughput:   %.0f commits/s\n", static_cast<double>(commits) / seconds);
+  printf("abort rate:   %.4f\n", static_cast<double>(aborts) / static_cast<double>(commits + aborts));
+  printf("lock waits:   %lu, %.3f s in total, %.1f us each, %lu requests aborted\n", waits,
+         static_cast<double>(wait_us) / 1e6,
+         waits == 0 ? 0.0 : static_cast<double>(wait_us) / static_cast<double>(waits),
+         after.aborted_requests - before.aborted_requests);
+  if (config.deadlock_ == DeadlockMode::DETECTION) {
+    const uint64_t runs = after.detection_runs - before.detection_runs;
+    printf("detection:    %lu runs, %.3f ms in total, %.1f us each, %.4f%% of the run, %lu victims\n", runs,
+           static_cast<double>(detection_us) / 1e3,
+           runs == 0 ? 0.0 : static_cast<double>(detection_us) / static_cast<double>(runs),
+           static_cast<double>(detection_us) / 1e4 / seconds, after.detection_victims - before.detection_victims);
+  }
+  printf("commit ns:    p50 %lu, p90 %lu, p99 %lu, p99.9 %lu, max %lu\n", Percentile(all, 0.5), Percentile(all, 0.9),
+         Percentile(all, 0.99), Percentile(all, 0.999), all.empty() ? 0 : all.back());
+  return 0;
+}
+
+}  // namespace
+
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  bustub::BenchConfig config;
+  if (!bustub::ParseArgs(argc, argv, &config)) {
+    fprintf(stderr,
+            "usage: %s [--threads=N] [--rows=N] [--hot-rows=N] [--hot-percent=P] [--read-percent=P] [--txn-length=N]\n"
+            "  [--deadlock=prevention|wound_wait|detection] [--twopl=regular|strict] [--interval=MS] [--txns=N]\n"
+            "  [--pin=0|1]\n",
+            argv[0]);
+    return 1;
+  }
+  return bustub::RunBench(config);
+}
@@ -0,0 +1,726 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// workload_bench.cpp
+//
+// Identification: test/benchmark/workload_bench.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Runs a whole workload against a BustubInstance: tables of a SimpleCatalog with hash indexes, rows read and updated
+// through the table heaps under two-phase locking, inserts through InsertExecutors and reads through
+// IndexScanExecutors, all logged. Closed-loop clients run one transaction after the other, e.g.
+//
+//   workload_bench --workload=ycsb --threads=8 --records=200000 --read-percent=95 --update-percent=5 --dist=zipf99
+//   workload_bench --workload=tpcc --threads=8 --warehouses=4 --new-order-percent=50
+//
+// ycsb is a table of records with a BIGINT key and fields of text; an operation reads a record by its key, updates a
+// field of one, or inserts a new one. tpcc is a simplified TPC-C of NewOrder and Payment transactions over warehouses,
+// districts, customers, items, stock, orders, new orders, order lines and history, without the ad-hoc read-only
+// transactions and without the rollback of NewOrder on an unknown item.
+//
+// Options, all --name=value:
+//   workload           ycsb or tpcc (ycsb)
+//   threads            clients, each runs one transaction at a time (4)
+//   txns               transactions per client, committed or aborted (10000)
+//   dist               the records, or the items and customers of tpcc: uniform, zipf50, ..., zipf99 (zipf99)
+//   records            ycsb: records loaded before the run (100000)
+//   fields             ycsb: fields of a record (10)
+//   field-size         ycsb: bytes of a field (100)
+//   txn-ops            ycsb: operations of a transaction (1)
+//   read-percent       ycsb: operations that read a record (50)
+//   update-percent     ycsb: operations that update a field of a record, the rest insert a record (50)
+//   warehouses         tpcc: warehouses, with 10 districts each (1)
+//   customers          tpcc: customers per district (300)
+//   items              tpcc: items, every warehouse stocks each of them (10000)
+//   new-order-percent  tpcc: NewOrder transactions, the rest are Payments (50)
+//   pool               frames of the buffer pool (16384)
+//   sync-commit        1 to have commits wait for their commit records to be on disk (1)
+//   pin                1 to pin the clients to fixed CPUs, see RunPinnedThreads() (1)
+//   db                 the database file, deleted at the end (workload_bench.db)
+//
+// An aborted transaction is not retried, its client goes on with a new one. The time of the clients is broken down
+// into the buffer pool (waiting for frames and reading pages that missed), lock waits, commits (the wait for the log
+// to be written) and the rest, execution.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "benchmark/bench_harness.h"
+#include "catalog/simple_catalog.h"
+#include "common/bustub_instance.h"
+#include "concurrency/transaction_manager.h"
+#include "execution/executor_context.h"
+#include "execution/executor_factory.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/insert_plan.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+struct BenchConfig {
+  std::string workload_ = "ycsb";
+  size_t threads_ = 4;
+  size_t txns_ = 10000;
+  TableGenerator::Dist dist_ = TableGenerator::Dist::Zipf_99;
+  size_t records_ = 100000;
+  size_t fields_ = 10;
+  size_t field_size_ = 100;
+  size_t txn_ops_ = 1;
+  size_t read_percent_ = 50;
+  size_t update_percent_ = 50;
+  size_t warehouses_ = 1;
+  size_t customers_ = 300;
+  size_t items_ = 10000;
+  size_t new_order_percent_ = 50;
+  size_t pool_ = 16384;
+  bool sync_commit_ = true;
+  bool pin_ = true;
+  std::string db_ = "workload_bench.db";
+};
+
+/** @return false if an option is unknown or its value is not valid */
+bool ParseArgs(int argc, char **argv, BenchConfig *config) {
+  BenchOptions options(argc, argv);
+  config->workload_ = options.GetString("workload", config->workload_);
+  options.Require(config->workload_ == "ycsb" || config->workload_ == "tpcc");
+  config->threads_ = options.GetSize("threads", config->threads_);
+  config->txns_ = options.GetSize("txns", config->txns_);
+  config->dist_ = options.GetDist("dist", config->dist_);
+  config->records_ = options.GetSize("records", config->records_);
+  config->fields_ = options.GetSize("fields", config->fields_);
+  config->field_size_ = options.GetSize("field-size", config->field_size_);
+  config->txn_ops_ = options.GetSize("txn-ops", config->txn_ops_);
+  config->read_percent_ = options.GetSize("read-percent", config->read_percent_);
+  config->update_percent_ = options.GetSize("update-percent", config->update_percent_);
+  config->warehouses_ = options.GetSize("warehouses", config->warehouses_);
+  config->customers_ = options.GetSize("customers", config->customers_);
+  config->items_ = options.GetSize("items", config->items_);
+  config->new_order_percent_ = options.GetSize("new-order-percent", config->new_order_percent_);
+  config->pool_ = options.GetSize("pool", config->pool_);
+  config->sync_commit_ = options.GetSize("sync-commit", 1) != 0;
+  config->pin_ = options.GetSize("pin", 1) != 0;
+  config->db_ = options.GetString("db", config->db_);
+  options.Require(config->threads_ > 0 && config->records_ > 0 && config->fields_ > 0 && config->field_size_ > 0 &&
+                  config->txn_ops_ > 0 && config->read_percent_ + config->update_percent_ <= 100 &&
+                  config->warehouses_ > 0 && config->customers_ > 0 && config->items_ > 0 &&
+                  config->new_order_percent_ <= 100 && config->pool_ > 0);
+  return options.IsValid();
+}
+
+Value Int(int64_t value) { return ValueFactory::GetIntegerValue(static_cast<int32_t>(value)); }
+
+Value BigInt(int64_t value) { return ValueFactory::GetBigIntValue(value); }
+
+/** The transaction types of a workload, with the latencies of their commits. */
+struct TxnType {
+  std::string name_;
+  size_t commits_{0};
+  size_t aborts_{0};
+  std::vector<uint64_t> latencies_;
+};
+
+/** What a client did, and where its time went. */
+struct ClientStats {
+  std::vector<TxnType> types_;
+  uint64_t busy_ns_{0};
+  uint64_t commit_ns_{0};
+};
+
+/**
+ * Database holds the tables of a workload and the operations that its transactions are made of. Rows are found
+ * through hash indexes, read and updated in the table heaps, and inserted through InsertExecutors so that the
+ * indexes of their tables are kept up to date.
+ */
+class Database {
+ public:
+  explicit Database(BustubInstance *instance)
+      : instance_(instance),
+        catalog_(instance->buffer_pool_manager_, instance->lock_manager_, instance->log_manager_) {}
+
+  SimpleCatalog *GetCatalog() { return &catalog_; }
+
+  /** Creates a table and loads rows into it, before the run. */
+  TableMetadata *LoadTable(Transaction *txn, const std::string &name, const std::vector<Column> &columns,
+                           const std::vector<std::vector<Value>> &rows) {
+    TableMetadata *table = catalog_.CreateTable(txn, name, Schema(columns));
+    std::vector<Tuple> tuples;
+    for (size_t begin = 0; begin < rows.size(); begin += EXECUTOR_BATCH_SIZE) {
+      tuples.clear();
+      for (size_t i = begin; i < std::min(rows.size(), begin + EXECUTOR_BATCH_SIZE); i++) {
+        tuples.emplace_back(rows[i], &table->schema_);
+      }
+      table->table_->BulkInsert(tuples, nullptr, txn);
+    }
+    return table;
+  }
+
+  /** Creates the hash index of a table, which is named after it, on some of its columns. */
+  IndexInfo *CreateIndex(Transaction *txn, TableMetadata *table, const std::vector<uint32_t> &key_attrs,
+                         size_t expected_rows) {
+    return catalog_.CreateIndex(txn, table->name_ + "_pk", table->name_, key_attrs, expected_rows / 64 + 1);
+  }
+
+  /** Finds the rid of a row by the key of its index, false if there is none. */
+  static bool Find(IndexInfo *index, std::vector<Value> &&key, Transaction *txn, RID *rid) {
+    std::vector<RID> rids;
+    index->index_->ScanKey(Tuple(std::move(key), index->index_->GetKeySchema()), &rids, txn);
+    if (rids.empty()) {
+      return false;
+    }
+    *rid = rids.back();
+    return true;
+  }
+
+  /** Reads a row under a shared lock. */
+  static bool Read(TableMetadata *table, const RID &rid, Transaction *txn, Tuple *tuple) {
+    return table->table_->GetTuple(rid, tuple, txn);
+  }
+
+  /** Reads a row under an exclusive lock, so that the update that follows does not have to upgrade a shared one. */
+  bool ReadForUpdate(TableMetadata *table, const RID &rid, Transaction *txn, Tuple *tuple) {
+    if (enable_logging && !txn->IsExclusiveLocked(rid) &&
+        (!table->table_->LockTable(txn, LockMode::INTENTION_EXCLUSIVE) ||
+         !instance_->lock_manager_->LockExclusive(txn, rid, table->oid_))) {
+      return false;
+    }
+    return table->table_->GetTuple(rid, tuple, txn);
+  }
+
+  /** Replaces some values of a row that was read for update. */
+  static bool Update(TableMetadata *table, const RID &rid, const Tuple &old_tuple,
+                     const std::vector<std::pair<uint32_t, Value>> &changes, Transaction *txn) {
+    const Schema &schema = table->schema_;
+    std::vector<Value> values;
+    values.reserve(schema.GetColumnCount());
+    for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+      values.push_back(old_tuple.GetValue(&schema, i));
+    }
+    for (const auto &[column, value] : changes) {
+      values[column] = value;
+    }
+    return table->table_->UpdateTuple(Tuple(values, &schema), rid, txn);
+  }
+
+  /** Inserts rows through an InsertExecutor. */
+  static bool Insert(ExecutorContext *exec_ctx, TableMetadata *table, std::vector<std::vector<Value>> &&rows) {
+    InsertPlanNode plan(std::move(rows), table->oid_);
+    auto executor = ExecutorFactory::CreateExecutor(exec_ctx, &plan);
+    executor->Init();
+    return executor->Next(nullptr);
+  }
+
+ private:
+  BustubInstance *instance_;
+  SimpleCatalog catalog_;
+};
+
+/** A workload: the tables that it loads, and the transactions that its clients run. */
+class Workload {
+ public:
+  virtual ~Workload() = default;
+
+  /** Creates and fills the tables and their indexes, before the run. */
+  virtual void Load(Transaction *txn) = 0;
+
+  /** @return the names of the transaction types, RunTxn returns an index into them */
+  virtual std::vector<std::string> GetTxnTypes() const = 0;
+
+  /**
+   * Runs the operations of a transaction of the client, but does not commit it.
+   * @param[out] type the type of the transaction
+   * @return false if the transaction was aborted
+   */
+  virtual bool RunTxn(size_t client, ExecutorContext *exec_ctx, size_t *type) = 0;
+};
+
+class YcsbWorkload : public Workload {
+ public:
+  YcsbWorkload(const BenchConfig &config, Database *db) : config_(config), db_(db) {
+    for (size_t i = 0; i < config.threads_; i++) {
+      keys_.emplace_back(config.dist_, 0, config.records_ - 1, i + 1);
+      generators_.emplace_back(i);
+      next_insert_.push_back(0);
+    }
+    field_ = std::string(config.field_size_ - 1, 'x');
+  }
+
+  void Load(Transaction *txn) override {
+    std::vector<Column> columns{Column("ycsb_key", TypeId::BIGINT)};
+    for (size_t i = 0; i < config_.fields_; i++) {
+      columns.emplace_back("field" + std::to_string(i), TypeId::VARCHAR, static_cast<uint32_t>(config_.field_size_));
+    }
+    std::vector<std::vector<Value>> rows;
+    rows.reserve(config_.records_);
+    for (size_t key = 0; key < config_.records_; key++) {
+      rows.push_back(MakeRecord(key));
+    }
+    table_ = db_->LoadTable(txn, "usertable", columns, rows);
+    index_ = db_->CreateIndex(txn, table_, {0}, config_.records_);
+    std::vector<Column> output;
+    for (uint32_t i = 0; i < columns.size(); i++) {
+      expressions_.push_back(std::make_unique<ColumnValueExpression>(0, i, columns[i].GetType()));
+      if (columns[i].GetType() == TypeId::VARCHAR) {
+        output.emplace_back(columns[i].GetName(), TypeId::VARCHAR, columns[i].GetLength(), expressions_.back().get());
+      } else {
+        output.emplace_back(columns[i].GetName(), columns[i].GetType(), expressions_.back().get());
+      }
+    }
+    output_schema_ = std::make_unique<Schema>(output);
+  }
+
+  std::vector<std::string> GetTxnTypes() const override { return {"ycsb"}; }
+
+  bool RunTxn(size_t client, ExecutorContext *exec_ctx, size_t *type) override {
+    *type = 0;
+    Transaction *txn = exec_ctx->GetTransaction();
+    std::uniform_int_distribution<size_t> percent(0, 99);
+    std::uniform_int_distribution<uint32_t> field(1, static_cast<uint32_t>(config_.fields_));
+    for (size_t op = 0; op < config_.txn_ops_; op++) {
+      const size_t draw = percent(generators_[client]);
+      const auto key = static_cast<int64_t>(keys_[client].Next());
+      if (draw < config_.read_percent_) {
+        // A read goes through an IndexScanExecutor, which reads the whole record.
+        IndexScanPlanNode plan(output_schema_.get(), nullptr, table_->oid_, index_->oid_, {BigInt(key)});
+        auto executor = ExecutorFactory::CreateExecutor(exec_ctx, &plan);
+        executor->Init();
+        Tuple tuple;
+        executor->Next(&tuple);
+      } else if (draw < config_.read_percent_ + config_.update_percent_) {
+        RID rid;
+        Tuple tuple;
+        if (Database::Find(index_, {BigInt(key)}, txn, &rid) &&
+            (!db_->ReadForUpdate(table_, rid, txn, &tuple) ||
+             !Database::Update(table_, rid, tuple, {{field(generators_[client]), Text()}}, txn))) {
+          return false;
+        }
+      } else {
+        // The keys of the inserts of a client are its own, after the loaded ones.
+        const size_t new_key = config_.records_ + next_insert_[client]++ * config_.threads_ + client;
+        if (!Database::Insert(exec_ctx, table_, {MakeRecord(new_key)})) {
+          return false;
+        }
+      }
+    }
+    return txn->GetState() != TransactionState::ABORTED;
+  }
+
+ private:
+  Value Text() const { return ValueFactory::GetVarcharValue(field_.c_str(), true); }
+
+  std::vector<Value> MakeRecord(size_t key) const {
+    std::vector<Value> values{BigInt(static_cast<int64_t>(key))};
+    for (size_t i = 0; i < config_.fields_; i++) {
+      values.push_back(Text());
+    }
+    return values;
+  }
+
+  const BenchConfig &config_;
+  Database *db_;
+  TableMetadata *table_{nullptr};
+  IndexInfo *index_{nullptr};
+  std::vector<std::unique_ptr<ColumnValueExpression>> expressions_;
+  std::unique_ptr<Schema> output_schema_;
+  std::string field_;
+  /** Per client: the keys of its operations, its draws of operations, and the number of records that it inserted. */
+  std::vector<TableGenerator::Sampler> keys_;
+  std::vector<std::mt19937_64> generators_;
+  std::vector<size_t> next_insert_;
+};
+
+class TpccWorkload : public Workload {
+ public:
+  static constexpr size_t DISTRICTS = 10;
+
+  TpccWorkload(const BenchConfig &config, Database *db) : config_(config), db_(db) {
+    for (size_t i = 0; i < config.threads_; i++) {
+      items_.emplace_back(config.dist_, 1, config.items_, i + 1);
+      customers_.emplace_back(config.dist_, 1, config.customers_, config.threads_ + i + 1);
+      generators_.emplace_back(i);
+    }
+  }
+
+  void Load(Transaction *txn) override {
+    const size_t w = config_.warehouses_;
+    std::vector<std::vector<Value>> rows;
+    for (size_t w_id = 1; w_id <= w; w_id++) {
+      rows.push_back({Int(w_id), BigInt(0), Int(w_id % 20)});
+    }
+    warehouse_ = LoadTable(txn, "warehouse", {"w_id", "w_ytd", "w_tax"}, rows, {0});
+    rows.clear();
+    for (size_t w_id = 1; w_id <= w; w_id++) {
+      for (size_t d_id = 1; d_id <= DISTRICTS; d_id++) {
+        rows.push_back({Int(w_id), Int(d_id), Int(1), BigInt(0), Int(d_id % 20)});
+      }
+    }
+    district_ = LoadTable(txn, "district", {"d_w_id", "d_id", "d_next_o_id", "d_ytd", "d_tax"}, rows, {0, 1});
+    rows.clear();
+    for (size_t w_id = 1; w_id <= w; w_id++) {
+      for (size_t d_id = 1; d_id <= DISTRICTS; d_id++) {
+        for (size_t c_id = 1; c_id <= config_.customers_; c_id++) {
+          rows.push_back({Int(w_id), Int(d_id), Int(c_id), BigInt(0), Int(0), Int(c_id % 50)});
+        }
+      }
+    }
+    customer_ = LoadTable(txn, "customer", {"c_w_id", "c_d_id", "c_id", "c_balance", "c_payment_cnt", "c_discount"},
+                          rows, {0, 1, 2});
+    rows.clear();
+    for (size_t i_id = 1; i_id <= config_.items_; i_id++) {
+      rows.push_back({Int(i_id), Int(100 + i_id % 9900)});
+    }
+    item_ = LoadTable(txn, "item", {"i_id", "i_price"}, rows, {0});
+    rows.clear();
+    for (size_t w_id = 1; w_id <= w; w_id++) {
+      for (size_t i_id = 1; i_id <= config_.items_; i_id++) {
+        rows.push_back({Int(w_id), Int(i_id), Int(50 + i_id % 50), Int(0), Int(0)});
+      }
+    }
+    stock_ = LoadTable(txn, "stock", {"s_w_id", "s_i_id", "s_quantity", "s_ytd", "s_order_cnt"}, rows, {0, 1});
+    rows.clear();
+    // Each client inserts about 10 order lines per NewOrder.
+    const size_t orders = config_.threads_ * config_.txns_;
+    orders_ = LoadTable(txn, "orders", {"o_w_id", "o_d_id", "o_id", "o_c_id", "o_ol_cnt"}, rows, {0, 1, 2}, orders);
+    new_order_ = LoadTable(txn, "new_order", {"no_w_id", "no_d_id", "no_o_id"}, rows, {0, 1, 2}, orders);
+    order_line_ = LoadTable(txn, "order_line",
+                            {"ol_w_id", "ol_d_id", "ol_o_id", "ol_number", "ol_i_id", "ol_quantity", "ol_amount"},
+                            rows, {0, 1, 2, 3}, orders * 10);
+    history_ = LoadTable(txn, "history", {"h_c_id", "h_d_id", "h_w_id", "h_amount"}, rows, {});
+  }
+
+  std::vector<std::string> GetTxnTypes() const override { return {"NewOrder", "Payment"}; }
+
+  bool RunTxn(size_t client, ExecutorContext *exec_ctx, size_t *type) override {
+    std::mt19937_64 &generator = generators_[client];
+    const auto w_id = static_cast<int64_t>(std::uniform_int_distribution<size_t>(1, config_.warehouses_)(generator));
+    const auto d_id = static_cast<int64_t>(std::uniform_int_distribution<size_t>(1, DISTRICTS)(generator));
+    const auto c_id = static_cast<int64_t>(customers_[client].Next());
+    if (std::uniform_int_distribution<size_t>(0, 99)(generator) < config_.new_order_percent_) {
+      *type = 0;
+      return NewOrder(client, exec_ctx, w_id, d_id, c_id);
+    }
+    *type = 1;
+    return Payment(exec_ctx, w_id, d_id, c_id, std::uniform_int_distribution<int64_t>(100, 500000)(generator));
+  }
+
+ private:
+  /** Loads a table of INTEGER columns, except for the BIGINT amounts, with an index on key_attrs unless empty. */
+  TableMetadata *LoadTable(Transaction *txn, const std::string &name, const std::vector<std::string> &column_names,
+                           const std::vector<std::vector<Value>> &rows, const std::vector<uint32_t> &key_attrs,
+                           size_t expected_rows = 0) {
+    std::vector<Column> columns;
+    for (size_t i = 0; i < column_names.size(); i++) {
+      columns.emplace_back(column_names[i], rows.empty() ? TypeId::INTEGER : rows[0][i].GetTypeId());
+    }
+    // The tables that start empty have amounts as well.
+    if (rows.empty()) {
+      for (Column &column : columns) {
+        const std::string &column_name = column.GetName();
+        if (column_name.size() > 7 && column_name.compare(column_name.size() - 7, 7, "_amount") == 0) {
+          column = Column(column_name, TypeId::BIGINT);
+        }
+      }
+    }
+    TableMetadata *table = db_->LoadTable(txn, name, columns, rows);
+    if (!key_attrs.empty()) {
+      indexes_[table->oid_] = db_->CreateIndex(txn, table, key_attrs, std::max(rows.size(), expected_rows));
+    }
+    return table;
+  }
+
+  IndexInfo *GetIndex(TableMetadata *table) { return indexes_.at(table->oid_); }
+
+  bool NewOrder(size_t client, ExecutorContext *exec_ctx, int64_t w_id, int64_t d_id, int64_t c_id) {
+    Transaction *txn = exec_ctx->GetTransaction();
+    RID rid;
+    Tuple warehouse;
+    if (!Database::Find(GetIndex(warehouse_), {Int(w_id)}, txn, &rid) ||
+        !Database::Read(warehouse_, rid, txn, &warehouse)) {
+      return false;
+    }
+    // The district hands out the order id.
+    Tuple district;
+    if (!Database::Find(GetIndex(district_), {Int(w_id), Int(d_id)}, txn, &rid) ||
+        !db_->ReadForUpdate(district_, rid, txn, &district)) {
+      return false;
+    }
+    const int32_t o_id = district.GetValue(&district_->schema_, 2).GetAs<int32_t>();
+    if (!Database::Update(district_, rid, district, {{2, Int(o_id + 1)}}, txn)) {
+      return false;
+    }
+    Tuple customer;
+    if (!Database::Find(GetIndex(customer_), {Int(w_id), Int(d_id), Int(c_id)}, txn, &rid) ||
+        !Database::Read(customer_, rid, txn, &customer)) {
+      return false;
+    }
+
+    std::mt19937_64 &generator = generators_[client];
+    const auto ol_cnt = std::uniform_int_distribution<int32_t>(5, 15)(generator);
+    std::vector<std::vector<Value>> order_lines;
+    for (int32_t ol_number = 1; ol_number <= ol_cnt; ol_number++) {
+      const auto i_id = static_cast<int64_t>(items_[client].Next());
+      const auto quantity = std::uniform_int_distribution<int32_t>(1, 10)(generator);
+      Tuple item;
+      Tuple stock;
+      if (!Database::Find(GetIndex(item_), {Int(i_id)}, txn, &rid) || !Database::Read(item_, rid, txn, &item) ||
+          !Database::Find(GetIndex(stock_), {Int(w_id), Int(i_id)}, txn, &rid) ||
+          !db_->ReadForUpdate(stock_, rid, txn, &stock)) {
+        return false;
+      }
+      const Schema &schema = stock_->schema_;
+      const int32_t s_quantity = stock.GetValue(&schema, 2).GetAs<int32_t>();
+      const int32_t new_quantity = s_quantity >= quantity + 10 ? s_quantity - quantity : s_quantity - quantity + 91;
+      if (!Database::Update(stock_, rid, stock,
+                            {{2, Int(new_quantity)},
+                             {3, Int(stock.GetValue(&schema, 3).GetAs<int32_t>() + quantity)},
+                             {4, Int(stock.GetValue(&schema, 4).GetAs<int32_t>() + 1)}},
+                            txn)) {
+        return false;
+      }
+      const int64_t price = item.GetValue(&item_->schema_, 1).GetAs<int32_t>();
+      order_lines.push_back({Int(w_id), Int(d_id), Int(o_id), Int(ol_number), Int(i_id), Int(quantity),
+                             BigInt(price * quantity)});
+    }
+    return Database::Insert(exec_ctx, orders_, {{Int(w_id), Int(d_id), Int(o_id), Int(c_id), Int(ol_cnt)}}) &&
+           Database::Insert(exec_ctx, new_order_, {{Int(w_id), Int(d_id), Int(o_id)}}) &&
+           Database::Insert(exec_ctx, order_line_, std::move(order_lines)) &&
+           txn->GetState() != TransactionState::ABORTED;
+  }
+
+  bool Payment(ExecutorContext *exec_ctx, int64_t w_id, int64_t d_id, int64_t c_id, int64_t amount) {
+    Transaction *txn = exec_ctx->GetTransaction();
+    RID rid;
+    Tuple warehouse;
+    if (!Database::Find(GetIndex(warehouse_), {Int(w_id)}, txn, &rid) ||
+        !db_->ReadForUpdate(warehouse_, rid, txn, &warehouse) ||
+        !Database::Update(warehouse_, rid, warehouse,
+                          {{1, BigInt(warehouse.GetValue(&warehouse_->schema_, 1).GetAs<int64_t>() + amount)}}, txn)) {
+      return false;
+    }
+    Tuple district;
+    if (!Database::Find(GetIndex(district_), {Int(w_id), Int(d_id)}, txn, &rid) ||
+        !db_->ReadForUpdate(district_, rid, txn, &district) ||
+        !Database::Update(district_, rid, district,
+                          {{3, BigInt(district.GetValue(&district_->schema_, 3).GetAs<int64_t>() + amount)}}, txn)) {
+      return false;
+    }
+    Tuple customer;
+    if (!Database::Find(GetIndex(customer_), {Int(w_id), Int(d_id), Int(c_id)}, txn, &rid) ||
+        !db_->ReadForUpdate(customer_, rid, txn, &customer)) {
+      return false;
+    }
+    const Schema &schema = customer_->schema_;
+    if (!Database::Update(customer_, rid, customer,
+                          {{3, BigInt(customer.GetValue(&schema, 3).GetAs<int64_t>() - amount)},
+                           {4, Int(customer.GetValue(&schema, 4).GetAs<int32_t>() + 1)}},
+                          txn)) {
+      return false;
+    }
+    return Database::Insert(exec_ctx, history_, {{Int(c_id), Int(d_id), Int(w_id), BigInt(amount)}}) &&
+           txn->GetState() != TransactionState::ABORTED;
+  }
+
+  const BenchConfig &config_;
+  Database *db_;
+  TableMetadata *warehouse_{nullptr};
+  TableMetadata *district_{nullptr};
+  TableMetadata *customer_{nullptr};
+  TableMetadata *item_{nullptr};
+  TableMetadata *stock_{nullptr};
+  TableMetadata *orders_{nullptr};
+  TableMetadata *new_order_{nullptr};
+  TableMetadata *order_line_{nullptr};
+  TableMetadata *history_{nullptr};
+  std::unordered_map<table_oid_t, IndexInfo *> indexes_;
+  /** Per client: the items of its order lines, the customers of its transactions, and its other draws. */
+  std::vector<TableGenerator::Sampler> items_;
+  std::vector<TableGenerator::Sampler> customers_;
+  std::vector<std::mt19937_64> generators_;
+};
+
+uint64_t Nanos(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+/** Runs the transactions of a client. */
+void RunClient(const BenchConfig &config, BustubInstance *instance, Database *db, Workload *workload, size_t client,
+               ClientStats *stats) {
+  TransactionManager *txn_mgr = instance->transaction_manager_;
+  ExecutorContext exec_ctx(nullptr, db->GetCatalog(), instance->buffer_pool_manager_);
+  exec_ctx.SetScheduler(instance->task_scheduler_);
+  for (const std::string &name : workload->GetTxnTypes()) {
+    stats->types_.push_back(TxnType{name, 0, 0, {}});
+    stats->types_.back().latencies_.reserve(config.txns_);
+  }
+  for (size_t t = 0; t < config.txns_; t++) {
+    const auto start = std::chrono::steady_clock::now();
+    Transaction *txn = txn_mgr->Begin();
+    exec_ctx.SetTransaction(txn);
+    size_t type = 0;
+    const bool ran = workload->RunTxn(client, &exec_ctx, &type);
+    TxnType *txn_type = &stats->types_[type];
+    if (ran) {
+      const auto commit_start = std::chrono::steady_clock::now();
+      txn_mgr->Commit(txn);
+      const auto end = std::chrono::steady_clock::now();
+      stats->commit_ns_ += Nanos(end - commit_start);
+      stats->busy_ns_ += Nanos(end - start);
+      txn_type->commits_++;
+      txn_type->latencies_.push_back(Nanos(end - start));
+    } else {
+      txn_mgr->Abort(txn);
+      stats->busy_ns_ += Nanos(std::chrono::steady_clock::now() - start);
+      txn_type->aborts_++;
+    }
+    txn_mgr->Recycle(txn);
+  }
+}
+
+/** Prints the latencies of the committed transactions of a type: percentiles, and a histogram of powers of two. */
+void PrintLatencies(const TxnType &type, double seconds) {
+  const std::vector<uint64_t> &sorted = type.latencies_;
+  printf("%-10s %zu committed, %zu aborted, %.0f commits/s\n", type.name_.c_str(), type.commits_, type.aborts_,
+         static_cast<double>(type.commits_) / seconds);
+  if (sorted.empty()) {
+    return;
+  }
+  printf("  latency us: p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+         static_cast<double>(Percentile(sorted, 0.5)) / 1e3, static_cast<double>(Percentile(sorted, 0.9)) / 1e3,
+         static_cast<double>(Percentile(sorted, 0.99)) / 1e3, static_cast<double>(Percentile(sorted, 0.999)) / 1e3,
+         static_cast<double>(sorted.back()) / 1e3);
+  std::vector<size_t> buckets;
+  for (uint64_t ns : sorted) {
+    size_t bucket = 0;
+    for (uint64_t us = ns / 1000; us > 0; us >>= 1) {
+      bucket++;
+    }
+    buckets.resize(std::max(buckets.size(), bucket + 1));
+    buckets[bucket]++;
+  }
+  printf("  histogram us:");
+  for (size_t i = 0; i < buckets.size(); i++) {
+    if (buckets[i] != 0) {
+      printf(" [%zu,%zu): %zu", i == 0 ? 0 : size_t{1} << (i - 1), size_t{1} << i, buckets[i]);
+    }
+  }
+  printf("\n");
+}
+
+int RunBench(const BenchConfig &config) {
+  RemoveDatabaseFiles(config.db_);
+  BustubConfig bustub_config;
+  bustub_config.buffer_pool_size = config.pool_;
+  bustub_config.synchronous_commit = config.sync_commit_;
+  auto instance = std::make_unique<BustubInstance>(config.db_, bustub_config);
+  auto db = std::make_unique<Database>(instance.get());
+  std::unique_ptr<Workload> workload;
+  if (config.workload_ == "ycsb") {
+    workload = std::make_unique<YcsbWorkload>(config, db.get());
+  } else {
+    workload = std::make_unique<TpccWorkload>(config, db.get());
+  }
+
+  // The load is neither locked nor logged, the run is both.
+  const auto load_start = std::chrono::steady_clock::now();
+  Transaction *txn = instance->transaction_manager_->Begin();
+  workload->Load(txn);
+  instance->transaction_manager_->Commit(txn);
+  instance->transaction_manager_->Recycle(txn);
+  instance->buffer_pool_manager_->FlushAllPages();
+  printf("load:       %.3f s\n",
+         std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count());
+  instance->log_manager_->RunFlushThread();
+
+  const BufferPoolStats bpm_before = instance->buffer_pool_manager_->GetStats();
+  const LockManagerStats lock_before = instance->lock_manager_->GetStats();
+  std::vector<ClientStats> clients(config.threads_);
+  const double seconds = RunPinnedThreads(config.threads_, config.pin_, [&](size_t client) {
+    RunClient(config, instance.get(), db.get(), workload.get(), client, &clients[client]);
+  });
+  const BufferPoolStats bpm_after = instance->buffer_pool_manager_->GetStats();
+  const LockManagerStats lock_after = instance->lock_manager_->GetStats();
+
+  std::vector<TxnType> types = clients[0].types_;
+  uint64_t busy_ns = 0;
+  uint64_t commit_ns = 0;
+  for (size_t client = 0; client < config.threads_; client++) {
+    busy_ns += clients[client].busy_ns_;
+    commit_ns += clients[client].commit_ns_;
+    for (size_t i = 0; client > 0 && i < types.size(); i++) {
+      const TxnType &type = clients[client].types_[i];
+      types[i].commits_ += type.commits_;
+      types[i].aborts_ += type.aborts_;
+      types[i].latencies_.insert(types[i].latencies_.end(), type.latencies_.begin(), type.latencies_.end());
+    }
+  }
+  size_t commits = 0;
+  size_t aborts = 0;
+  for (TxnType &type : types) {
+    std::sort(type.latencies_.begin(), type.latencies_.end());
+    commits += type.commits_;
+    aborts += type.aborts_;
+  }
+  printf("run:        %zu transactions in %.3f s, %.0f commits/s, abort rate %.4f\n", commits + aborts, seconds,
+         static_cast<double>(commits) / seconds,
+         commits + aborts == 0 ? 0.0 : static_cast<double>(aborts) / static_cast<double>(commits + aborts));
+  for (const TxnType &type : types) {
+    PrintLatencies(type, seconds);
+  }
+
+  // The counters are shared by all clients, so the breakdown is over the sum of their times.
+  const uint64_t bpm_ns =
+      (bpm_after.pin_wait_time_us - bpm_before.pin_wait_time_us + bpm_after.read_time_us - bpm_before.read_time_us) *
+      1000;
+  const uint64_t lock_ns = (lock_after.lock_wait_time_us - lock_before.lock_wait_time_us) * 1000;
+  const uint64_t known_ns = bpm_ns + lock_ns + commit_ns;
+  auto share = [&](uint64_t ns) { return busy_ns == 0 ? 0.0 : 100.0 * static_cast<double>(ns) / busy_ns; };
+  printf("time of the clients: %.3f s\n", static_cast<double>(busy_ns) / 1e9);
+  const uint64_t hits = bpm_after.fetch_hits - bpm_before.fetch_hits;
+  const uint64_t misses = bpm_after.fetch_misses - bpm_before.fetch_misses;
+  printf("  buffer pool: %5.1f%% (%.4f hit ratio, %lu misses, %lu pin waits)\n", share(bpm_ns),
+         hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses), misses,
+         bpm_after.pin_waits - bpm_before.pin_waits);
+  printf("  locks:       %5.1f%% (%lu waits, %lu requests aborted)\n", share(lock_ns),
+         lock_after.lock_waits - lock_before.lock_waits, lock_after.aborted_requests - lock_before.aborted_requests);
+  printf("  commit/WAL:  %5.1f%% (%d log flushes)\n", share(commit_ns), instance->log_manager_->GetNumLogFlushes());
+  printf("  execution:   %5.1f%%\n", share(busy_ns > known_ns ? busy_ns - known_ns : 0));
+  printf("page writes: %lu, %.3f s in total\n", bpm_after.flushes - bpm_before.flushes,
+         static_cast<double>(bpm_after.flush_time_us - bpm_before.flush_time_us) / 1e6);
+
+  workload.reset();
+  db.reset();
+  instance.reset();
+  RemoveDatabaseFiles(config.db_);
+  return 0;
+}
+
+}  // namespace
+
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  bustub::BenchConfig config;
+  if (!bustub::ParseArgs(argc, argv, &config)) {
+    fprintf(stderr,
+            "usage: %s [--workload=ycsb|tpcc] [--threads=N] [--txns=N] [--dist=uniform|zipf50|zipf75|zipf95|zipf99]\n"
+            "  [--records=N] [--fields=N] [--field-size=N] [--txn-ops=N] [--read-percent=P] [--update-percent=P]\n"
+            "  [--warehouses=N] [--customers=N] [--items=N] [--new-order-percent=P] [--pool=N] [--sync-commit=0|1]\n"
+            "  [--pin=0|1] [--db=FILE]\n",
+            argv[0]);
+    return 1;
+  }
+  return bustub::RunBench(config);
+}
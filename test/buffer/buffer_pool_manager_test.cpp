@@ -11,8 +11,16 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -138,4 +146,745 @@ TEST(BufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, BackgroundFlushTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page0);
+  snprintf(page0->GetData(), PAGE_SIZE, "Hello");
+
+  // Scenario: Unpinning a dirty page only marks it dirty, the write happens in the background.
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  bool flushed = false;
+  for (int attempt = 0; attempt < 100 && !flushed; ++attempt) {
+    std::this_thread::sleep_for(flush_interval);
+    page0 = bpm->FetchPage(page_id_temp);
+    ASSERT_NE(nullptr, page0);
+    flushed = !page0->IsDirty();
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_TRUE(flushed);
+
+  // Scenario: Once the flusher is done, the page content can be read straight from disk.
+  char buffer[PAGE_SIZE];
+  disk_manager->ReadPage(page_id_temp, buffer);
+  EXPECT_EQ(0, strcmp(buffer, "Hello"));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ShutdownFlushTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const page_id_t num_pages = 5;
+  remove(db_name.c_str());
+  remove("test.crc");
+  // The flusher does not get to the pages on its own before the buffer pool is deleted.
+  const auto saved_flush_interval = flush_interval;
+  flush_interval = std::chrono::hours(1);
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: deleting the buffer pool without flushing it writes back its dirty pages.
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  flush_interval = saved_flush_interval;
+
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+  remove("test.crc");
+
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, BufferRingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t ring_size = 2;
+  const size_t num_scan_pages = 4 * buffer_pool_size;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: the pages of the working set fill every frame but the ones that the scan is going to use.
+  std::vector<page_id_t> hot_page_ids;
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size - ring_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+    hot_page_ids.push_back(page_id_temp);
+  }
+
+  // Scenario: the scanned table lives on disk only.
+  std::vector<page_id_t> scan_page_ids;
+  char data[PAGE_SIZE] = {0};
+  for (size_t i = 0; i < num_scan_pages; ++i) {
+    scan_page_ids.push_back(disk_manager->AllocatePage());
+    disk_manager->WritePage(scan_page_ids.back(), data);
+  }
+
+  // Scenario: a scan through the ring touches every page once.
+  BufferRing ring(ring_size);
+  for (auto page_id : scan_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPageForScan(page_id, &ring));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: the scan recycled its own frames, so the whole working set is still resident.
+  for (auto hot_page_id : hot_page_ids) {
+    bool resident = false;
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      resident |= bpm->GetPages()[i].GetPageId() == hot_page_id;
+    }
+    EXPECT_TRUE(resident) << "Page " << hot_page_id << " was evicted by the scan";
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: write more pages than fit into the pool, so that the first ones only live on disk.
+  const page_id_t num_pages = 3 * buffer_pool_size;
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "Page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->FlushAllPages();
+  // Fill the pool with the last pages. The background flusher may have kept earlier pages from being evicted so far.
+  for (page_id_t i = num_pages - buffer_pool_size; i < num_pages; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+  }
+  for (page_id_t i = num_pages - buffer_pool_size; i < num_pages; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  auto is_resident = [&](page_id_t page_id) {
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      if (bpm->GetPages()[i].GetPageId() == page_id) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Scenario: prefetched pages are resident right away, and fetching them returns their content from disk.
+  EXPECT_FALSE(is_resident(0));
+  EXPECT_FALSE(bpm->IsPageReady(0));
+  bpm->PrefetchPages(0, 3);
+  for (page_id_t i = 0; i < 3; ++i) {
+    EXPECT_TRUE(is_resident(i));
+  }
+  for (page_id_t i = 0; i < 3; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("Page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+    // Once its read is done, a fetch of the page does not wait.
+    EXPECT_TRUE(bpm->IsPageReady(i));
+  }
+
+  // Scenario: pages that were never allocated are not prefetched.
+  bpm->PrefetchPages(num_pages, 2);
+  EXPECT_FALSE(is_resident(num_pages));
+
+  // Scenario: a few sequential misses make the buffer pool read the following pages ahead of the scan.
+  const page_id_t scan_start = buffer_pool_size;
+  for (page_id_t i = scan_start; i < scan_start + READ_AHEAD_TRIGGER; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  for (page_id_t i = scan_start + READ_AHEAD_TRIGGER; i < scan_start + READ_AHEAD_TRIGGER + READ_AHEAD_PAGES; ++i) {
+    EXPECT_TRUE(is_resident(i)) << "Page " << i << " was not read ahead";
+  }
+  for (page_id_t i = scan_start + READ_AHEAD_TRIGGER; i < num_pages; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("Page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, FrameArenaTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 600;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: the frame data is page aligned and contiguous, away from the frame metadata.
+  Page *pages = bpm->GetPages();
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages[i].GetData()) % PAGE_SIZE);
+    EXPECT_EQ(pages[0].GetData() + i * PAGE_SIZE, pages[i].GetData());
+  }
+
+  // Scenario: every frame starts out zeroed, and pages written through the frames survive eviction.
+  for (size_t i = 0; i < buffer_pool_size * 2; ++i) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, page->GetData()[PAGE_SIZE - 1]);
+    snprintf(page->GetData(), PAGE_SIZE, "Page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size * 2); ++page_id) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("Page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t max_pool_size = 8;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::CLOCK, max_pool_size);
+
+  std::vector<page_id_t> page_ids;
+  auto new_pages = [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      page_id_t page_id;
+      Page *page = bpm->NewPage(&page_id);
+      if (page == nullptr) {
+        return false;
+      }
+      snprintf(page->GetData(), PAGE_SIZE, "Page %d", page_id);
+      page_ids.push_back(page_id);
+    }
+    return true;
+  };
+
+  // Scenario: the pool only holds as many pinned pages as it has frames.
+  EXPECT_TRUE(new_pages(buffer_pool_size));
+  EXPECT_FALSE(new_pages(1));
+
+  // Scenario: growing adds frames, but only up to the maximum size.
+  EXPECT_FALSE(bpm->Resize(max_pool_size + 1));
+  EXPECT_TRUE(bpm->Resize(max_pool_size));
+  EXPECT_EQ(max_pool_size, bpm->GetPoolSize());
+  EXPECT_TRUE(new_pages(max_pool_size - buffer_pool_size));
+  EXPECT_FALSE(new_pages(1));
+
+  // Scenario: frames holding pinned pages cannot be removed.
+  EXPECT_FALSE(bpm->Resize(2));
+  EXPECT_EQ(max_pool_size, bpm->GetPoolSize());
+
+  // Scenario: once the pages are unpinned, shrinking writes them back and drops them.
+  for (auto page_id : page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_TRUE(bpm->Resize(2));
+  EXPECT_EQ(2, bpm->GetPoolSize());
+  std::vector<Page *> pinned;
+  for (auto page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("Page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  for (int i = 0; i < 2; ++i) {
+    pinned.push_back(bpm->FetchPage(page_ids[i]));
+    ASSERT_NE(nullptr, pinned.back());
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[2]));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 2;
+
+  // Keep the background flusher out of the way, so that the dirty page is still dirty when it is evicted.
+  const auto old_flush_interval = flush_interval;
+  const size_t old_high_water_mark = dirty_page_high_water_mark;
+  flush_interval = std::chrono::hours(1);
+  dirty_page_high_water_mark = 100;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id0;
+  page_id_t page_id1;
+  page_id_t page_id2;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id0));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id1));
+
+  // Scenario: a full pool fails NewPage and fetches of pages that are not resident.
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id2));
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_id1 + 1));
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.new_page_failures);
+  EXPECT_EQ(1, stats.fetch_failures);
+  EXPECT_EQ(0, stats.evictions);
+
+  // Scenario: fetching a resident page is a hit, both while it is pinned and after it was unpinned.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id0));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id0, false));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id0, true));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id0));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id0, false));
+  stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.fetch_hits);
+  EXPECT_EQ(0, stats.fetch_misses);
+
+  // Scenario: two new pages evict the dirty page 0 and the clean page 1, a fetch of page 0 then misses.
+  page_id_t page_id3;
+  EXPECT_EQ(true, bpm->UnpinPage(page_id1, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id2));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id3));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id2, false));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id3, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id0));
+  stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.fetch_misses);
+  EXPECT_EQ(3, stats.evictions);
+  EXPECT_EQ(1, stats.dirty_evictions);
+  EXPECT_DOUBLE_EQ(2.0 / 3.0, stats.HitRatio());
+
+  // Scenario: every write back lands in the latency histogram.
+  EXPECT_GE(stats.flushes, 1);
+  uint64_t histogram_total = 0;
+  for (auto count : stats.flush_latency_us) {
+    histogram_total += count;
+  }
+  EXPECT_EQ(stats.flushes, histogram_total);
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+  flush_interval = old_flush_interval;
+  dirty_page_high_water_mark = old_high_water_mark;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, WarmStartTest) {
+  const std::string db_name = "test.db";
+  const std::string warm_start_file = "test.warm";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size + 2; ++i) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "Page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  // Touch two of the resident pages last, they are the hottest ones now.
+  for (auto page_id : {page_ids[3], page_ids[5]}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  ASSERT_TRUE(bpm->DumpResidentPages(warm_start_file));
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // Scenario: a smaller pool is warmed up with the hottest pages, without any fetch misses.
+  bpm = new BufferPoolManager(2, disk_manager);
+  EXPECT_EQ(2, bpm->RestoreResidentPages(warm_start_file));
+  std::vector<page_id_t> resident;
+  for (size_t i = 0; i < bpm->GetPoolSize(); ++i) {
+    resident.push_back(bpm->GetPages()[i].GetPageId());
+  }
+  std::sort(resident.begin(), resident.end());
+  EXPECT_EQ((std::vector<page_id_t>{page_ids[3], page_ids[5]}), resident);
+  for (auto page_id : resident) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("Page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->GetStats().fetch_misses);
+
+  // Scenario: a restore never evicts resident pages.
+  EXPECT_EQ(0, bpm->RestoreResidentPages(warm_start_file));
+
+  // Scenario: a missing warm start file loads nothing.
+  EXPECT_EQ(0, bpm->RestoreResidentPages("missing.warm"));
+
+  // Shutdown the disk manager and remove the temporary files we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(warm_start_file.c_str());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, BatchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: NewPages creates as many pages as there are free frames.
+  std::vector<page_id_t> page_ids;
+  std::vector<Page *> pages = bpm->NewPages(buffer_pool_size + 2, &page_ids);
+  ASSERT_EQ(buffer_pool_size, pages.size());
+  ASSERT_EQ(buffer_pool_size, page_ids.size());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    snprintf(pages[i]->GetData(), PAGE_SIZE, "Page %d", page_ids[i]);
+  }
+  EXPECT_TRUE(bpm->UnpinPages(page_ids, true));
+  EXPECT_FALSE(bpm->UnpinPages({page_ids[0]}, false));
+
+  std::vector<page_id_t> more_page_ids;
+  for (Page *page : bpm->NewPages(2, &more_page_ids)) {
+    snprintf(page->GetData(), PAGE_SIZE, "Page %d", page->GetPageId());
+  }
+  ASSERT_EQ(2, more_page_ids.size());
+  EXPECT_TRUE(bpm->UnpinPages(more_page_ids, true));
+  page_ids.insert(page_ids.end(), more_page_ids.begin(), more_page_ids.end());
+
+  // Scenario: FetchPages mixes hits and misses, keeps the order of the request and pins duplicates twice.
+  std::vector<page_id_t> fetch_ids = {page_ids[5], page_ids[0], page_ids[1], page_ids[0]};
+  pages = bpm->FetchPages(fetch_ids);
+  ASSERT_EQ(fetch_ids.size(), pages.size());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ("Page " + std::to_string(fetch_ids[i]), std::string(pages[i]->GetData()));
+  }
+
+  // Scenario: a batch that needs more frames than the pool has returns nullptr for the pages that do not fit.
+  pages = bpm->FetchPages({page_ids[2], page_ids[3]});
+  EXPECT_NE(nullptr, pages[0]);
+  EXPECT_EQ(nullptr, pages[1]);
+  EXPECT_TRUE(bpm->UnpinPages({page_ids[2]}, false));
+  // The duplicate was pinned twice, both pins are gone once it has been unpinned twice. The pin counts themselves may
+  // include a pin of the background flusher.
+  EXPECT_TRUE(bpm->UnpinPages(fetch_ids, false));
+  EXPECT_FALSE(bpm->UnpinPage(page_ids[0], false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[0], false));
+  EXPECT_EQ(false, bpm->UnpinPage(page_ids[0], false));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, OptimisticReadTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  Page *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Scenario: while a writer keeps filling the page with a single byte value, every validated read sees one value.
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for (int i = 0; i < 2000; i++) {
+      WritePageGuard guard = bpm->FetchPageWrite(page_id);
+      memset(guard.GetDataMut(), i % 128, PAGE_SIZE);
+    }
+    done = true;
+  });
+  size_t num_reads = 0;
+  while (!done || num_reads == 0) {
+    char first = 0;
+    char last = 0;
+    ASSERT_TRUE(bpm->ReadPageOptimistic(page_id, [&](const char *data) {
+      first = data[0];
+      last = data[PAGE_SIZE - 1];
+    }));
+    EXPECT_EQ(first, last);
+    num_reads++;
+  }
+  writer.join();
+
+  // Scenario: a page that is not resident is brought in and read under its latch.
+  page_id_t other_page_ids[2];
+  for (auto &other_page_id : other_page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&other_page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(other_page_id, false));
+  }
+  char value = 0;
+  EXPECT_TRUE(bpm->ReadPageOptimistic(page_id, [&](const char *data) { value = data[0]; }));
+  EXPECT_EQ(1999 % 128, value);
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ExtentTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: the id of a deleted page is reused by the next new page.
+  page_id_t page_id;
+  for (page_id_t i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(i, page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(true, bpm->DeletePage(1));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(1, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Scenario: a chain of pages stays sequential on disk while other pages are created in between.
+  page_id_t prev_page_id;
+  ASSERT_NE(nullptr, bpm->NewPageInExtent(INVALID_PAGE_ID, &prev_page_id));
+  EXPECT_EQ(EXTENT_SIZE, prev_page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(prev_page_id, true));
+  for (int i = 1; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(2 + i, page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    BasicPageGuard guard = bpm->NewPageInExtentGuarded(prev_page_id, &page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(prev_page_id + 1, page_id);
+    prev_page_id = page_id;
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ReadOnlySegmentTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const page_id_t num_pages = 20;
+  remove(db_name.c_str());
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  ASSERT_TRUE(bpm->MapSegmentReadOnly(0));
+  EXPECT_FALSE(bpm->MapSegmentReadOnly(1));
+
+  // Scenario: read-only pages are views of the mapping, so more of them can be pinned than the pool has frames.
+  std::vector<Page *> pages;
+  char expected[PAGE_SIZE];
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_EQ(disk_manager->GetMappedPage(i), page->GetData());
+    EXPECT_EQ(i, page->GetPageId());
+    pages.push_back(page);
+  }
+  EXPECT_EQ(pages[5], bpm->FetchPage(5));
+  EXPECT_EQ(2, pages[5]->GetPinCount());
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+  EXPECT_EQ(false, bpm->UnpinPage(5, false));
+
+  // Scenario: read guards, optimistic reads and scans see the mapping.
+  {
+    ReadPageGuard guard = bpm->FetchPageRead(7);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_STREQ("page 7", guard.GetData());
+  }
+  std::string seen;
+  EXPECT_TRUE(bpm->ReadPageOptimistic(8, [&seen](const char *data) { seen = data; }));
+  EXPECT_EQ("page 8", seen);
+  BufferRing ring(2);
+  Page *page = bpm->FetchPageForScan(9, &ring);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("page 9", page->GetData());
+  EXPECT_EQ(true, bpm->UnpinPage(9, false));
+
+  // Scenario: read-only pages can be neither written nor deleted, and new pages go to the next extent.
+  char data[PAGE_SIZE] = "overwritten";
+  disk_manager->WritePage(3, data);
+  EXPECT_STREQ("page 3", disk_manager->GetMappedPage(3));
+  EXPECT_EQ(false, bpm->DeletePage(3));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(EXTENT_SIZE, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  EXPECT_EQ(true, bpm->FlushPage(3));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+  remove("test.crc");
+
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ChecksumFailureTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const page_id_t num_pages = 8;
+  remove(db_name.c_str());
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: a page that fails its checksum is not handed out, by any way of fetching it.
+  int fd = open(db_name.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(1, pwrite(fd, "x", 1, 2 * PAGE_SIZE + 100));
+  close(fd);
+  EXPECT_EQ(nullptr, bpm->FetchPage(2));
+  EXPECT_EQ(1, bpm->GetStats().fetch_failures);
+  std::vector<Page *> pages = bpm->FetchPages({1, 2, 3, 2});
+  ASSERT_EQ(4, pages.size());
+  ASSERT_NE(nullptr, pages[0]);
+  EXPECT_STREQ("page 1", pages[0]->GetData());
+  EXPECT_EQ(nullptr, pages[1]);
+  ASSERT_NE(nullptr, pages[2]);
+  EXPECT_STREQ("page 3", pages[2]->GetData());
+  EXPECT_EQ(nullptr, pages[3]);
+  EXPECT_TRUE(bpm->UnpinPages({1, 3}, false));
+  bpm->PrefetchPages(2, 1);
+  EXPECT_EQ(nullptr, bpm->FetchPage(2));
+  EXPECT_EQ(false, bpm->UnpinPage(2, false));
+
+  // Scenario: the frames of the failed reads are free again, and a page that was rewritten can be fetched.
+  for (page_id_t i = num_pages - buffer_pool_size; i < num_pages; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+  }
+  for (page_id_t i = num_pages - buffer_pool_size; i < num_pages; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  char data[PAGE_SIZE] = "page 2";
+  disk_manager->WritePage(2, data);
+  Page *page = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("page 2", page->GetData());
+  EXPECT_EQ(true, bpm->UnpinPage(2, false));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+  remove("test.crc");
+
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <cstdio>
 #include <thread>  // NOLINT
 #include <vector>
@@ -59,4 +60,67 @@ TEST(ClockReplacerTest, SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+// NOLINTNEXTLINE
+TEST(ClockReplacerTest, ConcurrentTest) {
+  const int num_frames = 1000;
+  const int num_threads = 4;
+  ClockReplacer clock_replacer(num_frames);
+
+  // Scenario: threads pin and unpin frames of their own at the same time, and leave the even ones pinned.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int round = 0; round < 10; round++) {
+        for (int i = t; i < num_frames; i += num_threads) {
+          clock_replacer.Unpin(i);
+          clock_replacer.Pin(i);
+          if (i % 2 == 1 || round < 9) {
+            clock_replacer.Unpin(i);
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_frames / 2, clock_replacer.Size());
+  for (int i = 0; i < num_frames; i += 2) {
+    clock_replacer.Unpin(i);
+  }
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+
+  // Scenario: victims are taken while another thread pins the even frames. Every frame is taken at most once, and
+  // every odd frame is taken.
+  std::vector<std::atomic<int>> taken(num_frames);
+  threads.clear();
+  threads.emplace_back([&] {
+    for (int i = 0; i < num_frames; i += 2) {
+      clock_replacer.Pin(i);
+    }
+  });
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&] {
+      int frame_id;
+      while (clock_replacer.Victim(&frame_id)) {
+        taken[frame_id]++;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  int frame_id;
+  while (clock_replacer.Victim(&frame_id)) {
+    taken[frame_id]++;
+  }
+  for (int i = 0; i < num_frames; i++) {
+    EXPECT_GE(1, taken[i]) << i;
+    if (i % 2 == 1) {
+      EXPECT_EQ(1, taken[i]) << i;
+    }
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
 }  // namespace bustub
@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer. Each of them has been accessed once.
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_replacer.Unpin(i);
+  }
+  lru_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // Scenario: access frame 1 a second time. It is now the only frame with a finite backward k-distance.
+  lru_replacer.Pin(1);
+  lru_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // Scenario: get three victims. Frames with a single access go first, oldest first.
+  frame_id_t value;
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(3, lru_replacer.Size());
+
+  // Scenario: pinned frames cannot be victimized.
+  lru_replacer.Pin(5);
+  lru_replacer.Pin(6);
+  EXPECT_EQ(1, lru_replacer.Size());
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+  EXPECT_EQ(0, lru_replacer.Size());
+
+  // Scenario: 5 and 6 now have two accesses each. 5's second most recent access is older, so it goes first.
+  lru_replacer.Unpin(6);
+  lru_replacer.Unpin(5);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  EXPECT_EQ(0, lru_replacer.Size());
+}
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, RemoveTest) {
+  LRUKReplacer lru_replacer(4, 2);
+
+  // Scenario: frame 1 is accessed twice, frame 2 once.
+  lru_replacer.Pin(1);
+  lru_replacer.Pin(1);
+  lru_replacer.Unpin(1);
+  lru_replacer.Pin(2);
+  lru_replacer.Unpin(2);
+  EXPECT_EQ(2, lru_replacer.Size());
+
+  // Scenario: a removed frame is not victimized.
+  lru_replacer.Remove(1);
+  EXPECT_EQ(1, lru_replacer.Size());
+  frame_id_t value;
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+
+  // Scenario: the next page in frame 1 does not inherit the accesses of the removed one. It has a single access like
+  // the page in frame 3, and an older one, so it goes first.
+  lru_replacer.Pin(1);
+  lru_replacer.Unpin(1);
+  lru_replacer.Pin(3);
+  lru_replacer.Unpin(3);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(0, lru_replacer.Size());
+}
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, ReplacerPolicy::LRU_K);
+
+  // Scenario: a hot page is accessed repeatedly.
+  page_id_t hot_page_id;
+  auto *hot_page = bpm->NewPage(&hot_page_id);
+  ASSERT_NE(nullptr, hot_page);
+  snprintf(hot_page->GetData(), PAGE_SIZE, "Hot");
+  EXPECT_EQ(true, bpm->UnpinPage(hot_page_id, true));
+  ASSERT_NE(nullptr, bpm->FetchPage(hot_page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(hot_page_id, false));
+
+  // Scenario: a scan touches many more pages than fit in the pool, each of them once.
+  for (size_t i = 0; i < 4 * buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: the hot page survived the scan and is still resident in one of the frames.
+  bool resident = false;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    resident |= bpm->GetPages()[i].GetPageId() == hot_page_id;
+  }
+  EXPECT_TRUE(resident);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/buffer/page_guard_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+TEST(PageGuardTest, SampleTest) {
+  const size_t buffer_pool_size = 2;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id0;
+  Page *page0;
+  {
+    // Scenario: a guard unpins its page when it goes out of scope.
+    BasicPageGuard guard = bpm->NewPageGuarded(&page_id0);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id0, guard.PageId());
+    page0 = guard.GetPage();
+    EXPECT_EQ(1, page0->GetPinCount());
+
+    // Scenario: moving a guard hands over the pin, the moved-from guard is empty.
+    BasicPageGuard moved = std::move(guard);
+    EXPECT_FALSE(guard.IsValid());  // NOLINT
+    EXPECT_EQ(INVALID_PAGE_ID, guard.PageId());  // NOLINT
+    EXPECT_EQ(1, page0->GetPinCount());
+    snprintf(moved.AsMut<char>(), PAGE_SIZE, "Hello");
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+  EXPECT_TRUE(page0->IsDirty());
+
+  {
+    // Scenario: a write guard holds the write latch, and releases it together with the pin.
+    WritePageGuard guard = bpm->FetchPageWrite(page_id0);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_STREQ("Hello", guard.GetData());
+    EXPECT_EQ(1, page0->GetPinCount());
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "World");
+
+    // Scenario: move-assigning releases the page the guard held before.
+    guard = WritePageGuard();
+    EXPECT_EQ(0, page0->GetPinCount());
+  }
+
+  {
+    // Scenario: several read guards of the same page can coexist.
+    ReadPageGuard guard1 = bpm->FetchPageRead(page_id0);
+    ReadPageGuard guard2 = bpm->FetchPageRead(page_id0);
+    EXPECT_EQ(2, page0->GetPinCount());
+    EXPECT_STREQ("World", guard1.As<char>());
+    guard1.Drop();
+    EXPECT_EQ(1, page0->GetPinCount());
+    // Dropping twice must not unpin twice.
+    guard1.Drop();
+    EXPECT_EQ(1, page0->GetPinCount());
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  {
+    // Scenario: upgrading a basic guard latches the page and hands the pin over.
+    BasicPageGuard guard = bpm->FetchPageBasic(page_id0);
+    WritePageGuard write_guard = guard.UpgradeWrite();
+    EXPECT_FALSE(guard.IsValid());
+    EXPECT_EQ(1, page0->GetPinCount());
+  }
+  // All latches are released again.
+  page0->WLatch();
+  page0->WUnlatch();
+
+  {
+    // Scenario: guards of pages that could not be brought in are empty.
+    page_id_t page_id1;
+    page_id_t page_id2;
+    BasicPageGuard guard1 = bpm->NewPageGuarded(&page_id1);
+    BasicPageGuard guard2 = bpm->NewPageGuarded(&page_id2);
+    ASSERT_TRUE(guard1.IsValid());
+    ASSERT_TRUE(guard2.IsValid());
+    ReadPageGuard guard3 = bpm->FetchPageRead(page_id0);
+    EXPECT_FALSE(guard3.IsValid());
+  }
+
+  // Scenario: the page was written back with the contents written through the guards.
+  bpm->FlushPage(page_id0);
+  char buffer[PAGE_SIZE];
+  disk_manager->ReadPage(page_id0, buffer);
+  EXPECT_EQ(0, strcmp(buffer, "World"));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/page_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(PageTableTest, SampleTest) {
+  PageTable page_table(4);
+  frame_id_t frame_id;
+
+  // Scenario: inserted pages can be found, other pages cannot.
+  page_table.Insert(0, 3);
+  page_table.Insert(17, 1);
+  EXPECT_EQ(2, page_table.Size());
+  EXPECT_TRUE(page_table.Find(0, &frame_id));
+  EXPECT_EQ(3, frame_id);
+  EXPECT_TRUE(page_table.Find(17, &frame_id));
+  EXPECT_EQ(1, frame_id);
+  EXPECT_FALSE(page_table.Find(1, &frame_id));
+
+  // Scenario: erased pages are gone, and erasing them again fails.
+  EXPECT_TRUE(page_table.Erase(0));
+  EXPECT_FALSE(page_table.Find(0, &frame_id));
+  EXPECT_FALSE(page_table.Erase(0));
+  EXPECT_EQ(1, page_table.Size());
+
+  // Scenario: churn through many more pages than the table has slots, which forces it to drop its tombstones.
+  for (page_id_t page_id = 100; page_id < 1100; ++page_id) {
+    page_table.Insert(page_id, page_id % 4);
+    EXPECT_TRUE(page_table.Find(page_id, &frame_id));
+    EXPECT_EQ(page_id % 4, frame_id);
+    EXPECT_TRUE(page_table.Erase(page_id));
+  }
+  EXPECT_EQ(1, page_table.Size());
+  EXPECT_TRUE(page_table.Find(17, &frame_id));
+  EXPECT_EQ(1, frame_id);
+}
+
+TEST(PageTableTest, ConcurrentHitTest) {
+  const size_t buffer_pool_size = 4;
+  const int num_threads = 4;
+  const int num_rounds = 2000;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Keep one page pinned so that every fetch of it is a hit, and have the other pages evict each other meanwhile.
+  page_id_t hot_page_id;
+  Page *hot_page = bpm->NewPage(&hot_page_id);
+  ASSERT_NE(nullptr, hot_page);
+  snprintf(hot_page->GetData(), PAGE_SIZE, "Hot");
+  std::vector<page_id_t> cold_page_ids;
+  for (int i = 0; i < 8; ++i) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "Cold %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    cold_page_ids.push_back(page_id);
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      for (int round = 0; round < num_rounds; ++round) {
+        Page *page = bpm->FetchPage(hot_page_id);
+        ASSERT_EQ(hot_page, page);
+        EXPECT_STREQ("Hot", page->GetData());
+        EXPECT_EQ(true, bpm->UnpinPage(hot_page_id, false));
+
+        // Only one frame is left for the cold pages, so a fetch may fail while another thread holds it.
+        page_id_t cold_page_id = cold_page_ids[(tid + round) % cold_page_ids.size()];
+        page = bpm->FetchPage(cold_page_id);
+        if (page != nullptr) {
+          EXPECT_EQ(cold_page_id, page->GetPageId());
+          EXPECT_EQ(true, bpm->UnpinPage(cold_page_id, false));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1, hot_page->GetPinCount());
+  EXPECT_EQ(true, bpm->UnpinPage(hot_page_id, true));
+  EXPECT_EQ(false, bpm->UnpinPage(hot_page_id, true));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,217 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/util/numa_util.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  EXPECT_EQ(num_instances * buffer_pool_size, bpm->GetPoolSize());
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  snprintf(page0->GetData(), PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: We should be able to create new pages until we fill up the buffer pool. New pages are spread
+  // round robin over the shards, so every shard must have handed out ids from its own residue class.
+  std::vector<page_id_t> page_ids{page_id_temp};
+  for (size_t i = 1; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    page_ids.push_back(page_id_temp);
+  }
+  std::vector<size_t> pages_per_instance(num_instances, 0);
+  for (auto page_id : page_ids) {
+    pages_per_instance[page_id % num_instances]++;
+  }
+  for (auto count : pages_per_instance) {
+    EXPECT_EQ(buffer_pool_size, count);
+  }
+
+  // Scenario: Once the buffer pool is full, we should not be able to create any new pages.
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: After unpinning every page and creating as many new ones, page 0 must have been written back
+  // and can be read again from disk.
+  for (auto page_id : page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(false, bpm->UnpinPage(0, false));
+
+  // Scenario: An unpinned page can be deleted, a pinned one cannot.
+  EXPECT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(false, bpm->DeletePage(0));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(true, bpm->DeletePage(0));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const std::string db_name = "test.db";
+  const size_t num_threads = 4;
+  const size_t num_pages_per_thread = 50;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_threads, 8, disk_manager);
+
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid] {
+      std::vector<page_id_t> page_ids;
+      for (size_t i = 0; i < num_pages_per_thread; i++) {
+        page_id_t page_id;
+        Page *page = bpm->NewPage(&page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "%zu-%d", tid, page_id);
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+        page_ids.push_back(page_id);
+      }
+      for (auto page_id : page_ids) {
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(std::to_string(tid) + "-" + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, NumaTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 2;
+
+  // Scenario: every thread runs on one of the nodes, and an arena bound to a node stays usable.
+  ASSERT_GE(NumaUtil::GetNumNodes(), 1);
+  EXPECT_LT(NumaUtil::GetCurrentNode(), NumaUtil::GetNumNodes());
+  FrameArena arena(buffer_pool_size, 0);
+  EXPECT_TRUE(arena.GetNumaNode() == 0 || arena.GetNumaNode() == FrameArena::ANY_NUMA_NODE);
+  snprintf(arena.GetFrame(buffer_pool_size - 1), PAGE_SIZE, "Hello");
+  EXPECT_EQ("Hello", std::string(arena.GetFrame(buffer_pool_size - 1)));
+
+  // Scenario: a NUMA aware pool prefers the local shards for new pages, but still fills all shards once they are full.
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, nullptr,
+                                            ReplacerPolicy::CLOCK, 0, true);
+  std::vector<page_id_t> page_ids;
+  EXPECT_EQ(num_instances * buffer_pool_size, bpm->NewPages(num_instances * buffer_pool_size, &page_ids).size());
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  EXPECT_TRUE(bpm->UnpinPages(page_ids, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ExtentTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: shared pages come from the residue class of their shard, and deleted ones are reused.
+  std::vector<page_id_t> page_ids;
+  auto new_pages = [&] {
+    page_ids.clear();
+    for (size_t i = 0; i < num_instances; ++i) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      page_ids.push_back(page_id);
+    }
+    std::sort(page_ids.begin(), page_ids.end());
+  };
+  new_pages();
+  EXPECT_EQ((std::vector<page_id_t>{0, 1, 2}), page_ids);
+  EXPECT_EQ(true, bpm->DeletePage(1));
+  new_pages();
+  EXPECT_EQ((std::vector<page_id_t>{1, 3, 5}), page_ids);
+
+  // Scenario: a chain of pages takes consecutive page ids, although consecutive ids belong to different shards.
+  page_id_t prev_page_id;
+  ASSERT_NE(nullptr, bpm->NewPageInExtent(INVALID_PAGE_ID, &prev_page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(prev_page_id, true));
+  for (size_t i = 0; i < 2 * EXTENT_SIZE; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(prev_page_id, &page_id));
+    EXPECT_EQ(prev_page_id + 1, page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    prev_page_id = page_id;
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
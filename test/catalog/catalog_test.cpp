@@ -10,19 +10,23 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_set>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/simple_catalog.h"
+#include "catalog/table_generator.h"
+#include "concurrency/transaction_manager.h"
 #include "gtest/gtest.h"
 #include "type/value_factory.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(CatalogTest, DISABLED_CreateTableTest) {
+TEST(CatalogTest, CreateTableTest) {
   auto disk_manager = new DiskManager("catalog_test.db");
   auto bpm = new BufferPoolManager(32, disk_manager);
   auto catalog = new SimpleCatalog(bpm, nullptr, nullptr);
@@ -48,4 +52,236 @@ TEST(CatalogTest, DISABLED_CreateTableTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(CatalogTest, ConcurrentLookupTest) {
+  auto disk_manager = new DiskManager("catalog_test.db");
+  auto bpm = new BufferPoolManager(32, disk_manager);
+  auto catalog = new SimpleCatalog(bpm, nullptr, nullptr);
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  Schema schema(columns);
+  const int num_tables = 100;
+
+  // Lookups see every table that was created before them, while new tables are published.
+  std::atomic<int> num_created{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&] {
+      while (num_created.load() < num_tables) {
+        const int created = num_created.load();
+        for (int oid = 0; oid < created; oid++) {
+          TableMetadata *table_info = catalog->GetTable(oid);
+          EXPECT_EQ("t" + std::to_string(oid), table_info->name_);
+          EXPECT_EQ(table_info, catalog->GetTable(table_info->name_));
+        }
+      }
+    });
+  }
+  for (int i = 0; i < num_tables; i++) {
+    catalog->CreateTable(nullptr, "t" + std::to_string(i), schema);
+    num_created++;
+  }
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_THROW(catalog->GetTable(num_tables), std::out_of_range);
+
+  delete catalog;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, PersistentCatalogTest) {
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  columns.emplace_back("B", TypeId::VARCHAR, 16);
+  const Schema schema(columns);
+  const int num_tables = 200;
+  RID rid;
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+
+  // More tables than a page of the directory holds.
+  {
+    auto *disk_manager = new DiskManager("catalog_test.db");
+    auto *bpm = new BufferPoolManager(32, disk_manager);
+    auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+    auto *log_manager = new LogManager(disk_manager);
+    auto *txn_mgr = new TransactionManager(lock_manager, log_manager);
+    auto *catalog = new SimpleCatalog(bpm, lock_manager, log_manager, true);
+    Transaction *txn = txn_mgr->Begin();
+    for (int i = 0; i < num_tables; i++) {
+      EXPECT_EQ(i, catalog->CreateTable(txn, "t" + std::to_string(i), schema)->oid_);
+    }
+    TableMetadata *table_info = catalog->GetTable("t7");
+    for (int i = 0; i < 10; i++) {
+      const Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue("v" + std::to_string(i))},
+                        &schema);
+      ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn));
+    }
+    ASSERT_NE(nullptr, catalog->CreateIndex(txn, "i7", "t7", {0}, 8));
+    catalog->AnalyzeTable(txn, "t7");
+    txn_mgr->Commit(txn);
+    delete txn;
+
+    delete catalog;
+    delete txn_mgr;
+    delete log_manager;
+    delete lock_manager;
+    delete bpm;
+    disk_manager->ShutDown();
+    delete disk_manager;
+  }
+
+  // The reopened catalog finds the tables by name and by oid, with their tuples, statistics and indexes.
+  auto *disk_manager = new DiskManager("catalog_test.db");
+  auto *bpm = new BufferPoolManager(32, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager, log_manager);
+  auto *catalog = new SimpleCatalog(bpm, lock_manager, log_manager, true);
+  Transaction *txn = txn_mgr->Begin();
+  EXPECT_THROW(catalog->GetTable("potato"), std::out_of_range);
+  EXPECT_EQ("t150", catalog->GetTable(150)->name_);
+  EXPECT_EQ(num_tables - 1, catalog->GetTable("t" + std::to_string(num_tables - 1))->oid_);
+
+  TableMetadata *table_info = catalog->GetTable("t7");
+  EXPECT_EQ(7, table_info->oid_);
+  ASSERT_EQ(2, table_info->schema_.GetColumnCount());
+  EXPECT_EQ("B", table_info->schema_.GetColumn(1).GetName());
+  EXPECT_EQ(TypeId::VARCHAR, table_info->schema_.GetColumn(1).GetType());
+  EXPECT_TRUE(table_info->stats_.IsAnalyzed());
+  EXPECT_EQ(10, table_info->stats_.GetNumRows());
+  EXPECT_EQ(9, table_info->stats_.GetColumn(0).max_.GetAs<int32_t>());
+  int num_tuples = 0;
+  for (auto it = table_info->table_->Begin(txn); it != table_info->table_->End(); ++it) {
+    EXPECT_EQ("v" + std::to_string(num_tuples), it->GetValue(&schema, 1).ToString());
+    num_tuples++;
+  }
+  EXPECT_EQ(10, num_tuples);
+
+  const std::vector<IndexInfo *> indexes = catalog->GetTableIndexes("t7");
+  ASSERT_EQ(1, indexes.size());
+  EXPECT_EQ("i7", indexes[0]->name_);
+  EXPECT_EQ(indexes[0], catalog->GetIndex("i7", "t7"));
+  std::vector<RID> rids;
+  const Tuple key({ValueFactory::GetIntegerValue(9)}, indexes[0]->index_->GetKeySchema());
+  indexes[0]->index_->ScanKey(key, &rids, txn);
+  ASSERT_EQ(1, rids.size());
+  EXPECT_EQ(rid, rids[0]);
+
+  // New tables and indexes go on from the oids that were handed out before.
+  EXPECT_EQ(num_tables, catalog->CreateTable(txn, "potato", schema)->oid_);
+  EXPECT_EQ(1, catalog->CreateIndex(txn, "i8", "t8", {0}, 8)->oid_);
+  txn_mgr->Commit(txn);
+  delete txn;
+
+  delete catalog;
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+  remove("catalog_test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, FillTableTest) {
+  using Dist = TableGenerator::Dist;
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+  auto *disk_manager = new DiskManager("catalog_test.db");
+  auto *bpm = new BufferPoolManager(64, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *txn_mgr = new TransactionManager(lock_manager);
+  auto *catalog = new SimpleCatalog(bpm, lock_manager, nullptr);
+  Transaction *txn = txn_mgr->Begin();
+  ExecutorContext exec_ctx(txn, catalog, bpm);
+  TableGenerator generator(&exec_ctx);
+
+  // Generates a table of a few batches and returns its rows in order.
+  const uint32_t num_rows = 5 * GENERATE_BATCH_SIZE + 17;
+  auto generate = [&](const char *name, const TableFillOptions &options) {
+    TableGenerator::TableInsertMeta table_meta{name,
+                                               num_rows,
+                                               {{"serial", TypeId::INTEGER, false, Dist::Serial, 0, 0},
+                                                {"uniform", TypeId::SMALLINT, false, Dist::Uniform, 10, 99},
+                                                {"zipf", TypeId::BIGINT, false, Dist::Zipf_99, 0, 9999},
+                                                {"real", TypeId::DECIMAL, false, Dist::Uniform, 0, 1}}};
+    TableMetadata *info = generator.GenerateTable(&table_meta, options);
+    std::vector<std::string> rows;
+    for (auto it = info->table_->Begin(txn); it != info->table_->End(); ++it) {
+      rows.push_back(it->ToString(&info->schema_));
+    }
+    return rows;
+  };
+
+  TableFillOptions options;
+  const std::vector<std::string> inline_rows = generate("inline", options);
+  ASSERT_EQ(num_rows, inline_rows.size());
+  TableMetadata *info = catalog->GetTable("inline");
+  uint32_t serial = 0;
+  for (auto it = info->table_->Begin(txn); it != info->table_->End(); ++it, ++serial) {
+    EXPECT_EQ(serial, it->GetValue(&info->schema_, 0).GetAs<int32_t>());
+    EXPECT_GE(it->GetValue(&info->schema_, 1).GetAs<int16_t>(), 10);
+    EXPECT_LE(it->GetValue(&info->schema_, 1).GetAs<int16_t>(), 99);
+  }
+
+  // Threads generate the same rows in the same order, whether they are inserted as tuples or as pages.
+  options.num_threads_ = 4;
+  EXPECT_EQ(inline_rows, generate("threads", options));
+  options.bulk_load_ = true;
+  EXPECT_EQ(inline_rows, generate("bulk", options));
+  options.seed_ = 1;
+  EXPECT_NE(inline_rows, generate("seed", options));
+  txn_mgr->Commit(txn);
+  delete txn;
+
+  delete catalog;
+  delete txn_mgr;
+  delete lock_manager;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("catalog_test.db");
+  remove("catalog_test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, SamplerTest) {
+  using Dist = TableGenerator::Dist;
+  const int num_values = 1000;
+  const int num_draws = 100000;
+  auto count_first = [&](Dist dist) {
+    TableGenerator::Sampler sampler(dist, 10, 10 + num_values - 1, 15445);
+    int first = 0;
+    for (int i = 0; i < num_draws; i++) {
+      const uint64_t value = sampler.Next();
+      EXPECT_GE(value, 10);
+      EXPECT_LT(value, 10 + num_values);
+      first += value < 10 + num_values / 100 ? 1 : 0;
+    }
+    return first;
+  };
+  // The first percent of the values takes about a percent of a uniform sample, and more the more skewed a Zipf one is.
+  const int uniform = count_first(Dist::Uniform);
+  EXPECT_NEAR(num_draws / 100, uniform, num_draws / 200);
+  const int zipf_50 = count_first(Dist::Zipf_50);
+  const int zipf_99 = count_first(Dist::Zipf_99);
+  EXPECT_GT(zipf_50, 2 * uniform);
+  EXPECT_GT(zipf_99, 2 * zipf_50);
+
+  TableGenerator::Sampler serial(Dist::Serial, 5, 7);
+  for (uint64_t expected : {5, 6, 7, 5}) {
+    EXPECT_EQ(expected, serial.Next());
+  }
+}
+
 }  // namespace bustub
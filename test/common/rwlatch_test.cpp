@@ -10,14 +10,24 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <cstdint>
+#include <string>
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/memory_accounting.h"
 #include "common/rwlatch.h"
+#include "common/task_scheduler.h"
+#include "common/util/contention_profiler.h"
+#include "common/util/metrics.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
 
+template <typename Latch>
 class Counter {
  public:
   Counter() = default;
@@ -36,13 +46,13 @@ class Counter {
 
  private:
   int count_{0};
-  ReaderWriterLatch mutex{};
+  Latch mutex{};
 };
 
 // NOLINTNEXTLINE
 TEST(RWLatchTest, BasicTest) {
   int num_threads = 100;
-  Counter counter{};
+  Counter<ReaderWriterLatch> counter{};
   counter.Add(5);
   std::vector<std::thread> threads;
   for (int tid = 0; tid < num_threads; tid++) {
@@ -57,4 +67,263 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// Readers must never see a writer halfway through an update, under enough contention that waiters go to sleep.
+template <typename Latch>
+void CheckExclusion() {
+  Latch latch;
+  int64_t first = 0;
+  int64_t second = 0;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 8; tid++) {
+    threads.emplace_back([&, tid]() {
+      for (int i = 0; i < 20000; i++) {
+        if (tid % 4 == 0) {
+          latch.WLock();
+          first++;
+          second--;
+          latch.WUnlock();
+        } else {
+          latch.RLock();
+          EXPECT_EQ(first, -second);
+          latch.RUnlock();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(first, 2 * 20000);
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, ExclusionTest) { CheckExclusion<ReaderWriterLatch>(); }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, DistributedTest) {
+  int num_threads = 100;
+  Counter<DistributedReaderWriterLatch> counter{};
+  counter.Add(5);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    if (tid % 2 == 0) {
+      threads.emplace_back([&counter]() { counter.Read(); });
+    } else {
+      threads.emplace_back([&counter]() { counter.Add(1); });
+    }
+  }
+  for (int i = 0; i < num_threads; i++) {
+    threads[i].join();
+  }
+  EXPECT_EQ(counter.Read(), 55);
+
+  CheckExclusion<DistributedReaderWriterLatch>();
+
+  // A read latch released by another thread still lets the writer in.
+  DistributedReaderWriterLatch latch;
+  latch.RLock();
+  std::thread([&latch]() { latch.RUnlock(); }).join();
+  latch.WLock();
+  latch.WUnlock();
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, ContentionProfilerTest) {
+  ContentionProfiler::Reset();
+  const uint64_t now = ContentionProfiler::Now();
+  ContentionProfiler::Record(LatchSite::PAGE_WRITE, 7, now - 3000000000);
+  ContentionProfiler::Record(LatchSite::PAGE_WRITE, 7, now - 1000000000);
+  ContentionProfiler::Record(LatchSite::ROW_LOCK, 7, now - 2000000000);
+  ContentionProfiler::Record(LatchSite::BUFFER_POOL, 0, now - 1000000);
+
+  auto top = ContentionProfiler::GetTopContended(2);
+  ASSERT_EQ(top.size(), 2);
+  EXPECT_EQ(top[0].site_, LatchSite::PAGE_WRITE);
+  EXPECT_EQ(top[0].key_, 7);
+  EXPECT_EQ(top[0].waits_, 2);
+  EXPECT_GE(top[0].total_wait_ns_, 4000000000);
+  EXPECT_GE(top[0].max_wait_ns_, 3000000000);
+  EXPECT_EQ(top[1].site_, LatchSite::ROW_LOCK);
+  EXPECT_EQ(ContentionProfiler::GetTopContended(10).size(), 3);
+  EXPECT_EQ(ContentionProfiler::Report(1).rfind("page_write 7: 2 waits", 0), 0);
+
+  ContentionProfiler::Reset();
+  EXPECT_TRUE(ContentionProfiler::GetTopContended(10).empty());
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, MetricsRegistryTest) {
+  MetricsRegistry registry;
+  MetricCounter *counter = registry.GetCounter("test_ops_total", "Operations.");
+  MetricHistogram *histogram = registry.GetHistogram("test_latency_us", "Latency.", "op=\"get\"");
+  EXPECT_EQ(registry.GetCounter("test_ops_total", "Operations."), counter);
+  EXPECT_THROW(registry.GetGauge("test_ops_total", "Operations."), Exception);
+
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < 4; t++) {
+    threads.emplace_back([counter, histogram, t]() {
+      for (uint64_t i = 1; i <= 250; i++) {
+        counter->Add();
+        histogram->Record(t * 250 + i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter->Value(), 1000);
+  const HistogramSnapshot latency = histogram->Snapshot();
+  EXPECT_EQ(latency.count_, 1000);
+  EXPECT_EQ(latency.sum_, 500500);
+  EXPECT_EQ(latency.max_, 1000);
+  // The buckets are at most 1/16 of their values wide.
+  EXPECT_GE(latency.Percentile(0.5), 500);
+  EXPECT_LE(latency.Percentile(0.5), 500 + 500 / 16);
+  EXPECT_GE(latency.Percentile(0.99), 990);
+  EXPECT_EQ(latency.Percentile(1), 1000);
+  for (uint64_t value : {0UL, 15UL, 16UL, 17UL, 1000UL, 123456789UL}) {
+    EXPECT_GE(HistogramSnapshot::GetBucketUpperBound(HistogramSnapshot::GetBucket(value)), value);
+  }
+
+  const size_t id = registry.AddCollector([](MetricsSnapshot *snapshot) {
+    snapshot->AddGauge("test_shard_pages", "Pages.", 3);
+    snapshot->AddGauge("test_shard_pages", "Pages.", 4);
+  });
+  MetricsSnapshot snapshot = registry.Collect();
+  EXPECT_EQ(snapshot.GetValue("test_ops_total"), 1000);
+  EXPECT_EQ(snapshot.GetValue("test_shard_pages"), 7);
+  ASSERT_NE(snapshot.GetHistogram("test_latency_us", "op=\"get\""), nullptr);
+  const std::string text = snapshot.ToText();
+  EXPECT_NE(text.find("# TYPE test_ops_total counter\ntest_ops_total 1000\n"), std::string::npos);
+  EXPECT_NE(text.find("# TYPE test_latency_us summary\n"), std::string::npos);
+  EXPECT_NE(text.find("test_latency_us{op=\"get\",quantile=\"0.99\"} "), std::string::npos);
+  EXPECT_NE(text.find("test_latency_us_count{op=\"get\"} 1000\n"), std::string::npos);
+  EXPECT_NE(text.find("test_shard_pages 7\n"), std::string::npos);
+
+  registry.RemoveCollector(id);
+  EXPECT_FALSE(registry.Collect().GetValue("test_shard_pages").has_value());
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, MemoryAccountingTest) {
+  MemoryAccount *account = MemoryAccounting::Get(MemorySubsystem::WRITE_SET);
+  account->Flush();
+  const size_t usage = account->GetUsage();
+  const size_t allocations = account->GetNumAllocations();
+
+  // An allocation of a batch or more is charged at once, a smaller one once its thread flushes or exits.
+  {
+    std::vector<int64_t, TrackedAllocator<int64_t, MemorySubsystem::WRITE_SET>> records;
+    records.reserve(MEMORY_ACCOUNT_BATCH);
+    EXPECT_EQ(account->GetUsage(), usage + MEMORY_ACCOUNT_BATCH * sizeof(int64_t));
+    EXPECT_EQ(account->GetNumAllocations(), allocations + 1);
+    EXPECT_GE(account->GetPeak(), account->GetUsage());
+  }
+  EXPECT_EQ(account->GetUsage(), usage);
+  std::thread([account]() { account->Consume(100); }).join();
+  EXPECT_EQ(account->GetUsage(), usage + 100);
+  account->Release(100);
+  account->Flush();
+  EXPECT_EQ(account->GetUsage(), usage);
+  EXPECT_EQ(account->GetNumAllocations(), allocations);
+
+  // The soft limit tells the subsystem whether an allocation would take it over.
+  account->SetSoftLimit(usage + 1000);
+  EXPECT_TRUE(account->Fits(1000));
+  EXPECT_FALSE(account->Fits(1001));
+  EXPECT_FALSE(account->IsOverSoftLimit());
+
+  MetricsRegistry registry;
+  registry.AddCollector([](MetricsSnapshot *snapshot) { MemoryAccounting::CollectMetrics(snapshot); });
+  MetricsSnapshot snapshot = registry.Collect();
+  EXPECT_EQ(snapshot.GetValue("bustub_memory_bytes", "subsystem=\"write_set\""), usage);
+  EXPECT_EQ(snapshot.GetValue("bustub_memory_soft_limit_bytes", "subsystem=\"write_set\""), usage + 1000);
+  EXPECT_TRUE(snapshot.GetValue("bustub_memory_peak_bytes", "subsystem=\"varlen\"").has_value());
+  account->SetSoftLimit(0);
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, AsyncLoggerTest) {
+  testing::internal::CaptureStdout();
+  AsyncLogger::Start(1024);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([t]() {
+      std::string name = "thread " + std::to_string(t);
+      for (int i = 0; i < 100; i++) {
+        LOG_WARN("%s message %d of %.1f", name.c_str(), i, 100.0);
+      }
+      // The string is copied, not read after the message is logged.
+      name = "gone";
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  AsyncLogger::Stop();
+  EXPECT_FALSE(AsyncLogger::IsRunning());
+  LOG_WARN("written %s", "synchronously");
+  const std::string output = testing::internal::GetCapturedStdout();
+
+  EXPECT_EQ(AsyncLogger::GetNumDropped(), 0);
+  EXPECT_NE(output.find("WARN  - thread 2 message 99 of 100.0\n"), std::string::npos);
+  EXPECT_EQ(output.find("gone"), std::string::npos);
+  EXPECT_NE(output.find("WARN  - written synchronously\n"), std::string::npos);
+  size_t lines = 0;
+  for (char c : output) {
+    lines += c == '\n' ? 1 : 0;
+  }
+  EXPECT_EQ(lines, 401);
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, TaskSchedulerTest) {
+  std::atomic<size_t> background{0};
+  {
+    TaskScheduler scheduler(2);
+    EXPECT_EQ(scheduler.GetNumThreads(), 2);
+
+    // Every worker runs once, also when there are more of them than threads, and nested ones do not deadlock.
+    std::vector<std::atomic<int>> runs(8 * 8);
+    scheduler.ParallelFor(8, [&](size_t outer) {
+      scheduler.ParallelFor(8, [&](size_t inner) { runs[outer * 8 + inner]++; });
+    });
+    for (const auto &run : runs) {
+      EXPECT_EQ(run.load(), 1);
+    }
+
+    // A task that runs while another waits runs no tasks while it waits itself, however many are queued.
+    std::atomic<int> max_depth{0};
+    std::atomic<int> num_waits{0};
+    static thread_local int depth = 0;
+    for (int i = 0; i < 32; i++) {
+      scheduler.Submit([&] {
+        depth++;
+        int seen = max_depth.load();
+        while (seen < depth && !max_depth.compare_exchange_weak(seen, depth)) {
+        }
+        scheduler.RunPendingTasksUntil([] { return false; });
+        depth--;
+        num_waits++;
+      });
+    }
+    scheduler.RunPendingTasksUntil([&] { return num_waits == 32; });
+    while (num_waits != 32) {
+      std::this_thread::yield();
+    }
+    EXPECT_LE(max_depth.load(), TASK_WAIT_MAX_DEPTH + 1);
+
+    for (int i = 0; i < 100; i++) {
+      scheduler.Submit([&] { background++; }, TaskPriority::BACKGROUND);
+    }
+
+    // Without a scheduler, the workers run on threads of their own.
+    std::atomic<size_t> sum{0};
+    TaskScheduler::RunWorkers(nullptr, 4, [&](size_t worker) { sum += worker; });
+    EXPECT_EQ(sum.load(), 6);
+  }
+  // The tasks that were submitted all ran before the scheduler went away.
+  EXPECT_EQ(background.load(), 100);
+}
 }  // namespace bustub
@@ -18,6 +18,8 @@
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/hash_table_block_page.h"
+#include "storage/page/hash_table_bucket_page.h"
+#include "storage/page/hash_table_directory_page.h"
 #include "storage/page/hash_table_header_page.h"
 
 namespace bustub {
@@ -41,16 +43,32 @@ TEST(HashTablePageTest, HeaderPageSampleTest) {
     EXPECT_EQ(i, header_page->GetLSN());
   }
 
-  // add a few hypothetical block pages
+  // add a few hypothetical block directory pages
   for (unsigned i = 0; i < 10; i++) {
-    header_page->AddBlockPageId(i);
-    EXPECT_EQ(i + 1, header_page->NumBlocks());
+    header_page->AddDirectoryPageId(i);
+    EXPECT_EQ(i + 1, header_page->NumDirectories());
   }
+  header_page->SetNumBlocks(10 * BLOCK_DIRECTORY_ARRAY_SIZE);
+  EXPECT_EQ(10 * BLOCK_DIRECTORY_ARRAY_SIZE, header_page->NumBlocks());
 
-  // check for correct block page IDs
+  // check for correct block directory page IDs
   for (int i = 0; i < 10; i++) {
-    EXPECT_EQ(i, header_page->GetBlockPageId(i));
+    EXPECT_EQ(i, header_page->GetDirectoryPageId(i));
   }
+  EXPECT_EQ(HashTableHeaderPage::MaxDirectories() * BLOCK_DIRECTORY_ARRAY_SIZE, HashTableHeaderPage::MaxBlocks());
+  EXPECT_GT(HashTableHeaderPage::MaxBlocks(), 1000000);
+
+  // a block directory page lists as many blocks as fit in a page
+  page_id_t directory_page_id = INVALID_PAGE_ID;
+  auto directory_page =
+      reinterpret_cast<HashTableBlockDirectoryPage *>(bpm->NewPage(&directory_page_id, nullptr)->GetData());
+  for (size_t i = 0; i < BLOCK_DIRECTORY_ARRAY_SIZE; i++) {
+    directory_page->SetBlockPageId(i, static_cast<page_id_t>(i) * 3);
+  }
+  for (size_t i = 0; i < BLOCK_DIRECTORY_ARRAY_SIZE; i++) {
+    EXPECT_EQ(static_cast<page_id_t>(i) * 3, directory_page->GetBlockPageId(i));
+  }
+  bpm->UnpinPage(directory_page_id, true, nullptr);
 
   // unpin the header page now that we are done
   bpm->UnpinPage(header_page_id, true, nullptr);
@@ -103,6 +121,18 @@ TEST(HashTablePageTest, BlockPageSampleTest) {
     }
   }
 
+  // the control bytes of a group match the fingerprint of the readable pairs only
+  block_page->Insert(10, 10, 10, 0x2a);
+  block_page->Insert(11, 11, 11, 0x2a);
+  block_page->Remove(11);
+  auto masks = block_page->MatchGroup(0, 0x2a);
+  EXPECT_EQ(1U << 10, masks.match_);
+  EXPECT_EQ((1U << 10) | 0x155, masks.readable_ & 0xfff);
+  EXPECT_EQ(0U, masks.empty_ & 0xfff);
+  const uint64_t group_mask = (1ULL << HashTableBlockPage<int, int, IntComparator>::BLOCK_GROUP_SIZE) - 1;
+  EXPECT_EQ(group_mask & ~0xfffULL, masks.empty_);
+  EXPECT_EQ(0x155U, block_page->MatchGroup(0, 0).match_);
+
   // unpin the header page now that we are done
   bpm->UnpinPage(block_page_id, true, nullptr);
   disk_manager->ShutDown();
@@ -111,4 +141,100 @@ TEST(HashTablePageTest, BlockPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, DirectoryPageSampleTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+
+  // get a directory page from the BufferPoolManager
+  page_id_t directory_page_id = INVALID_PAGE_ID;
+  auto directory_page =
+      reinterpret_cast<HashTableDirectoryPage *>(bpm->NewPage(&directory_page_id, nullptr)->GetData());
+  EXPECT_EQ(0, directory_page->GetGlobalDepth());
+  directory_page->SetPageId(directory_page_id);
+  EXPECT_EQ(directory_page_id, directory_page->GetPageId());
+  directory_page->SetBucketPageId(0, 10);
+  directory_page->VerifyIntegrity();
+
+  // doubling the directory points the new slots to the same buckets
+  directory_page->IncrGlobalDepth();
+  EXPECT_EQ(2, directory_page->Size());
+  EXPECT_EQ(10, directory_page->GetBucketPageId(1));
+  directory_page->VerifyIntegrity();
+
+  // split bucket 10: slot 1 points to the new bucket 11
+  directory_page->SetBucketPageId(1, 11);
+  directory_page->SetLocalDepth(0, 1);
+  directory_page->SetLocalDepth(1, 1);
+  EXPECT_EQ(1, directory_page->GetSplitImageIndex(0));
+  EXPECT_FALSE(directory_page->CanShrink());
+  directory_page->IncrGlobalDepth();
+  EXPECT_EQ(3, directory_page->GetGlobalDepthMask());
+  EXPECT_EQ(11, directory_page->GetBucketPageId(3));
+  directory_page->VerifyIntegrity();
+
+  // no bucket has the global depth, so the directory can shrink
+  EXPECT_TRUE(directory_page->CanShrink());
+  directory_page->DecrGlobalDepth();
+  EXPECT_EQ(1, directory_page->GetGlobalDepth());
+  directory_page->VerifyIntegrity();
+
+  // unpin the directory page now that we are done
+  bpm->UnpinPage(directory_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketPageSampleTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+
+  // get a bucket page from the BufferPoolManager
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  auto bucket_page = reinterpret_cast<HashTableBucketPage<int, int, IntComparator> *>(
+      bpm->NewPage(&bucket_page_id, nullptr)->GetData());
+  EXPECT_TRUE(bucket_page->IsEmpty());
+
+  // insert a few (key, value) pairs, a pair only once
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(bucket_page->Insert(i, i, IntComparator()));
+    EXPECT_FALSE(bucket_page->Insert(i, i, IntComparator()));
+  }
+  EXPECT_EQ(10, bucket_page->NumReadable());
+  for (int i = 0; i < 10; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(bucket_page->GetValue(i, IntComparator(), &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // remove a few pairs, their slots are reused
+  for (int i = 0; i < 10; i += 2) {
+    EXPECT_TRUE(bucket_page->Remove(i, i, IntComparator()));
+    EXPECT_FALSE(bucket_page->Remove(i, i, IntComparator()));
+    EXPECT_FALSE(bucket_page->IsReadable(i));
+  }
+  EXPECT_TRUE(bucket_page->Insert(1, 2, IntComparator()));
+  EXPECT_TRUE(bucket_page->IsReadable(0));
+  std::vector<int> res;
+  EXPECT_TRUE(bucket_page->GetValue(1, IntComparator(), &res));
+  EXPECT_EQ(2, res.size());
+
+  // fill the bucket
+  for (int i = 100; !bucket_page->IsFull(); i++) {
+    EXPECT_TRUE(bucket_page->Insert(i, i, IntComparator()));
+  }
+  EXPECT_FALSE(bucket_page->Insert(-1, -1, IntComparator()));
+
+  // unpin the bucket page now that we are done
+  bpm->UnpinPage(bucket_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -10,13 +10,20 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "common/logger.h"
+#include "container/hash/extendible_hash_table.h"
 #include "container/hash/linear_probe_hash_table.h"
 #include "gtest/gtest.h"
 #include "murmur3/MurmurHash3.h"
+#include "storage/index/linear_probe_hash_table_index.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -105,4 +112,557 @@ TEST(HashTableTest, SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, GrowTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2, HashFunction<int>());
+  const size_t initial_size = ht.GetSize();
+
+  // Four threads insert far more pairs than two blocks hold, the table grows while they do.
+  const int num_threads = 4;
+  const int per_thread = 2000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&ht, tid]() {
+      for (int i = tid * per_thread; i < (tid + 1) * per_thread; i++) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+        EXPECT_TRUE(ht.Insert(nullptr, i, -i - 1));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_GE(ht.GetSize(), 4 * initial_size);
+  // The blocks share their free slots, so the table grows with its load rather than with its fullest block.
+  EXPECT_LE(ht.GetSize(), 2 * 8 * num_threads * per_thread);
+
+  for (int i = 0; i < num_threads * per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(2, res.size()) << "Failed to keep " << i;
+    EXPECT_TRUE((res[0] == i && res[1] == -i - 1) || (res[0] == -i - 1 && res[1] == i));
+    EXPECT_FALSE(ht.Insert(nullptr, i, i));
+  }
+  for (int i = 0; i < num_threads * per_thread; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  for (int i = 0; i < num_threads * per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 2 == 0 ? 1 : 2, res.size());
+  }
+
+  // A batched lookup sees the same values, for keys spread over all the blocks and for missing keys.
+  std::vector<int> keys;
+  for (int i = -100; i < num_threads * per_thread + 100; i += 3) {
+    keys.push_back(i);
+  }
+  std::vector<std::vector<int>> results;
+  EXPECT_TRUE(ht.GetValueBatch(nullptr, keys, &results));
+  ASSERT_EQ(keys.size(), results.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, keys[i], &res);
+    std::sort(res.begin(), res.end());
+    std::sort(results[i].begin(), results[i].end());
+    EXPECT_EQ(res, results[i]) << "Failed to look up " << keys[i];
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentLookupTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2, HashFunction<int>());
+
+  // Each writer inserts its keys in turn while a reader keeps looking up the keys that its writer inserted so far,
+  // which are never missing while the blocks change under it and the table grows.
+  const int num_pairs = 2;
+  const int per_thread = 3000;
+  std::vector<std::atomic<int>> inserted(num_pairs);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_pairs; tid++) {
+    threads.emplace_back([&ht, &inserted, tid]() {
+      for (int i = 0; i < per_thread; i++) {
+        EXPECT_TRUE(ht.Insert(nullptr, tid * per_thread + i, i));
+        inserted[tid] = i + 1;
+      }
+    });
+    threads.emplace_back([&ht, &inserted, tid]() {
+      std::mt19937 gen(tid);
+      while (inserted[tid] < per_thread) {
+        const int done = inserted[tid];
+        if (done == 0) {
+          continue;
+        }
+        const int i = static_cast<int>(gen() % done);
+        std::vector<int> res;
+        ht.GetValue(nullptr, tid * per_thread + i, &res);
+        ASSERT_EQ(1, res.size()) << "Failed to find " << tid * per_thread + i;
+        EXPECT_EQ(i, res[0]);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ProbeAcrossBlocksTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2, HashFunction<int>());
+  const size_t initial_size = ht.GetSize();
+  const size_t block_size = initial_size / 2;
+
+  // Keys whose home is the last bucket of the last block: their run fills the block end and wraps around to block 0.
+  HashFunction<int> hash_fn;
+  std::vector<int> keys;
+  for (int key = 0; keys.size() < block_size / 2; key++) {
+    uint64_t hash = hash_fn.GetHash(key);
+    if (hash % 2 == 1 && (hash >> 32) % block_size == block_size - 1) {
+      keys.push_back(key);
+    }
+  }
+  for (int key : keys) {
+    EXPECT_TRUE(ht.Insert(nullptr, key, key));
+  }
+  EXPECT_EQ(initial_size, ht.GetSize());
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, keys[i], &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << keys[i];
+    if (i % 2 == 0) {
+      EXPECT_TRUE(ht.Remove(nullptr, keys[i], keys[i]));
+    }
+  }
+  // The tombstones keep the rest of the run reachable, and take new pairs.
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, keys[i], &res);
+    EXPECT_EQ(i % 2, res.size());
+    EXPECT_EQ(i % 2 == 0, ht.Insert(nullptr, keys[i], keys[i]));
+  }
+
+  // Growing the table moves the pairs that wrapped around to the blocks that come after the last one.
+  for (int i = 0; ht.GetSize() == initial_size; i--) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  for (int key : keys) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, key, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << key;
+    EXPECT_EQ(key, res[0]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ManyBlocksTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  // More blocks than a single page could list, so the header page takes several block directory pages.
+  const size_t num_blocks = 3000;
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), num_blocks, HashFunction<int>());
+  using KeyType = int;
+  using ValueType = int;
+  EXPECT_EQ(num_blocks * BLOCK_ARRAY_SIZE, ht.GetSize());
+
+  for (int i = 0; i < 20000; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  for (int i = 0; i < 20000; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, BulkLoadTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2, HashFunction<int>());
+  const size_t initial_size = ht.GetSize();
+
+  // Every key twice with different values, and a few pairs more than once, which are loaded once.
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < 10000; i++) {
+    items.emplace_back(i, i);
+    items.emplace_back(i, -i - 1);
+  }
+  for (int i = 0; i < 100; i++) {
+    items.emplace_back(i, i);
+  }
+  std::shuffle(items.begin(), items.end(), std::mt19937(15445));
+  EXPECT_TRUE(ht.BulkLoad(items));
+  EXPECT_FALSE(ht.BulkLoad(items));
+  EXPECT_GT(ht.GetSize(), 20000);
+  EXPECT_EQ(0, ht.GetSize() % initial_size);
+
+  for (int i = 0; i < 10000; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(2, res.size()) << "Failed to load " << i;
+    EXPECT_TRUE((res[0] == i && res[1] == -i - 1) || (res[0] == -i - 1 && res[1] == i));
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, 0, 0));
+
+  // the loaded table takes inserts and removes like any other, and grows from its loaded size
+  for (int i = 0; i < 10000; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  for (int i = 10000; i < 30000; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  for (int i = 0; i < 30000; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i >= 10000 || i % 2 == 0 ? 1 : 2, res.size()) << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, BatchInsertRemoveTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2, HashFunction<int>());
+
+  // The batches make the table grow, and pairs that occur more than once are inserted once.
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < 20000; i++) {
+    items.emplace_back(i, i);
+  }
+  for (int i = 0; i < 100; i++) {
+    items.emplace_back(i, i);
+  }
+  std::shuffle(items.begin(), items.end(), std::mt19937(15445));
+  EXPECT_EQ(20000, ht.InsertBatch(nullptr, items));
+  EXPECT_EQ(0, ht.InsertBatch(nullptr, items));
+  for (int i = 0; i < 20000; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to insert " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  std::vector<std::pair<int, int>> removed;
+  for (int i = 0; i < 20000; i += 2) {
+    removed.emplace_back(i, i);
+  }
+  // a pair that is not in the table is left out
+  removed.emplace_back(20000, 20000);
+  EXPECT_EQ(10000, ht.RemoveBatch(nullptr, removed));
+  EXPECT_EQ(0, ht.RemoveBatch(nullptr, removed));
+  for (int i = 0; i < 20000; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 2, res.size()) << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, UniqueKeyTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2, HashFunction<int>(), true);
+
+  // a key takes a single value, whatever the value of a second insert
+  for (int i = 0; i < 5000; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, 7, 7));
+  EXPECT_FALSE(ht.Insert(nullptr, 7, 8));
+  for (int i = 0; i < 5000; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // a pair is only removed with its value, after which the key takes another value
+  EXPECT_FALSE(ht.Remove(nullptr, 7, 8));
+  EXPECT_TRUE(ht.Remove(nullptr, 7, 7));
+  EXPECT_TRUE(ht.Insert(nullptr, 7, 8));
+  std::vector<int> res;
+  ht.GetValue(nullptr, 7, &res);
+  EXPECT_EQ(std::vector<int>{8}, res);
+
+  // a bulk load keeps the first pair of every key
+  LinearProbeHashTable<int, int, IntComparator> loaded("blah", bpm, IntComparator(), 2, HashFunction<int>(), true);
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < 3000; i++) {
+    items.emplace_back(i, i);
+    items.emplace_back(i, -i);
+  }
+  EXPECT_TRUE(loaded.BulkLoad(items));
+  for (int i = 0; i < 3000; i++) {
+    res.clear();
+    loaded.GetValue(nullptr, i, &res);
+    EXPECT_EQ(std::vector<int>{i}, res);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, FilterTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  // The filter is built from the pairs in the table, and follows the inserts and the splits from then on.
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 2, HashFunction<int>());
+  for (int i = 0; i < 1000; i += 2) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_TRUE(ht.EnableFilter());
+  const size_t initial_size = ht.GetSize();
+  for (int i = 1000; i < 20000; i += 2) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_GT(ht.GetSize(), initial_size);
+
+  std::vector<int> keys;
+  for (int i = 0; i < 20000; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(i % 2 == 0 ? 1 : 0, res.size()) << i;
+    keys.push_back(i);
+  }
+  std::vector<std::vector<int>> results;
+  EXPECT_TRUE(ht.GetValueBatch(nullptr, keys, &results));
+  for (int i = 0; i < 20000; i++) {
+    EXPECT_EQ(i % 2 == 0 ? 1 : 0, results[i].size()) << i;
+  }
+
+  // removed keys are gone, whatever the filter still holds
+  for (int i = 0; i < 20000; i += 4) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  for (int i = 0; i < 20000; i += 2) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 4 == 0 ? 0 : 1, res.size()) << i;
+  }
+
+  // a bulk loaded table fills its filter as it loads
+  LinearProbeHashTable<int, int, IntComparator> loaded("blah", bpm, IntComparator(), 2, HashFunction<int>());
+  EXPECT_TRUE(loaded.EnableFilter());
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < 5000; i += 2) {
+    items.emplace_back(i, i);
+  }
+  EXPECT_TRUE(loaded.BulkLoad(items));
+  for (int i = 0; i < 5000; i++) {
+    std::vector<int> res;
+    loaded.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 2 == 0 ? 1 : 0, res.size()) << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, StatsTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1000, HashFunction<int>());
+
+  const int num_keys = 1000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  HashTableStats stats;
+  EXPECT_TRUE(ht.GetStats(&stats));
+  EXPECT_EQ(num_keys, stats.num_pairs_);
+  EXPECT_EQ(0, stats.num_tombstones_);
+  EXPECT_GE(stats.num_buckets_, stats.num_pairs_);
+  EXPECT_DOUBLE_EQ(static_cast<double>(num_keys) / stats.num_buckets_, stats.LoadFactor());
+  size_t histogram_total = 0;
+  for (size_t count : stats.probe_lengths_) {
+    histogram_total += count;
+  }
+  EXPECT_EQ(num_keys, histogram_total);
+  const size_t num_buckets = stats.num_buckets_;
+
+  // a few removes leave their tombstones behind
+  for (int i = 0; i < 40; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  EXPECT_TRUE(ht.GetStats(&stats));
+  EXPECT_EQ(num_keys - 40, stats.num_pairs_);
+  EXPECT_EQ(40, stats.num_tombstones_);
+
+  // many more make a remove compact the table, which stays correct
+  for (int i = 40; i < num_keys; i++) {
+    if (i % 4 != 0) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    }
+  }
+  EXPECT_TRUE(ht.GetStats(&stats));
+  EXPECT_EQ(num_buckets, stats.num_buckets_);
+  EXPECT_EQ((num_keys - 40) / 4, stats.num_pairs_);
+  EXPECT_LE(stats.num_tombstones_ * 100, stats.num_buckets_ * HASH_TABLE_MAX_TOMBSTONE_PERCENT);
+  EXPECT_LE(stats.TombstoneRatio() * 100, HASH_TABLE_MAX_TOMBSTONE_PERCENT);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i >= 40 && i % 4 == 0 ? 1 : 0, res.size()) << i;
+  }
+
+  // a compaction on demand drops every tombstone
+  EXPECT_TRUE(ht.Remove(nullptr, 40, 40));
+  EXPECT_TRUE(ht.Compact());
+  EXPECT_TRUE(ht.GetStats(&stats));
+  EXPECT_EQ(0, stats.num_tombstones_);
+  EXPECT_EQ((num_keys - 40) / 4 - 1, stats.num_pairs_);
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, -i));
+  }
+  for (int i = 44; i < num_keys; i += 4) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    std::sort(res.begin(), res.end());
+    EXPECT_EQ((std::vector<int>{-i, i}), res) << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, IndexKeyWidthTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  // an index on an integer column takes 4-byte keys, on two big integers 16-byte ones
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::BIGINT), Column("c", TypeId::BIGINT)});
+  std::unique_ptr<Index> index =
+      CreateLinearProbeHashTableIndex(new IndexMetadata("a_idx", "foo", &schema, {0}), bpm, 2, true);
+  using NarrowIndex = LinearProbeHashTableIndex<GenericKey<4>, RID, GenericComparator<4>>;
+  using WideIndex = LinearProbeHashTableIndex<GenericKey<16>, RID, GenericComparator<16>>;
+  ASSERT_NE(nullptr, dynamic_cast<NarrowIndex *>(index.get()));
+  std::unique_ptr<Index> wide_index =
+      CreateLinearProbeHashTableIndex(new IndexMetadata("bc_idx", "foo", &schema, {1, 2}), bpm, 2);
+  ASSERT_NE(nullptr, dynamic_cast<WideIndex *>(wide_index.get()));
+
+  Schema *key_schema = index->GetMetadata()->GetKeySchema();
+  for (int i = 0; i < 3000; i++) {
+    index->InsertEntry(Tuple({ValueFactory::GetIntegerValue(i)}, key_schema), RID(i, i), nullptr);
+  }
+  for (int i = 0; i < 3000; i++) {
+    std::vector<RID> result;
+    index->ScanKey(Tuple({ValueFactory::GetIntegerValue(i)}, key_schema), &result, nullptr);
+    ASSERT_EQ(1, result.size()) << "Failed to keep " << i;
+    EXPECT_EQ(RID(i, i), result[0]);
+  }
+
+  index.reset();
+  wide_index.reset();
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtendibleHashTableTest, SplitMergeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  // Four threads insert far more pairs than a bucket holds, the buckets split while they do.
+  const int num_threads = 4;
+  const int per_thread = 2000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&ht, tid]() {
+      for (int i = tid * per_thread; i < (tid + 1) * per_thread; i++) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+        EXPECT_TRUE(ht.Insert(nullptr, i, -i - 1));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_LT(0, ht.GetGlobalDepth());
+  ht.VerifyIntegrity();
+
+  for (int i = 0; i < num_threads * per_thread; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(2, res.size()) << "Failed to keep " << i;
+    EXPECT_TRUE((res[0] == i && res[1] == -i - 1) || (res[0] == -i - 1 && res[1] == i));
+    EXPECT_FALSE(ht.Insert(nullptr, i, i));
+  }
+
+  // Emptied buckets merge with their split images, until the directory is down to a single bucket.
+  for (int i = 0; i < num_threads * per_thread; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_TRUE(ht.Remove(nullptr, i, -i - 1));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 0, &res));
+  EXPECT_EQ(0, res.size());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -0,0 +1,265 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// session_test.cpp
+//
+// Identification: test/execution/session_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "catalog/simple_catalog.h"
+#include "common/bustub_instance.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/plans/insert_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/result_cache.h"
+#include "execution/session.h"
+#include "gtest/gtest.h"
+#include "network/session_server.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class SessionTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    ::testing::Test::SetUp();
+    remove("session_test.db");
+    remove("session_test.log");
+    instance_ = std::make_unique<BustubInstance>("session_test.db");
+    catalog_ = std::make_unique<SimpleCatalog>(instance_->buffer_pool_manager_, instance_->lock_manager_,
+                                               instance_->log_manager_);
+    Transaction *txn = instance_->transaction_manager_->Begin();
+    Schema schema({Column("id", TypeId::INTEGER), Column("balance", TypeId::INTEGER)});
+    table_oid_ = catalog_->CreateTable(txn, "accounts", schema)->oid_;
+    instance_->transaction_manager_->Commit(txn);
+    instance_->transaction_manager_->Recycle(txn);
+  }
+
+  void TearDown() override {
+    catalog_.reset();
+    instance_->disk_manager_->ShutDown();
+    instance_.reset();
+    remove("session_test.db");
+    remove("session_test.log");
+  }
+
+  /** @return a plan that inserts a row */
+  std::unique_ptr<PreparedPlan> MakeInsert(int32_t id, int32_t balance) {
+    auto plan = std::make_unique<PreparedPlan>();
+    std::vector<std::vector<Value>> rows{{ValueFactory::GetIntegerValue(id), ValueFactory::GetIntegerValue(balance)}};
+    plan->SetRoot(plan->Make<InsertPlanNode>(std::move(rows), table_oid_));
+    return plan;
+  }
+
+  /** @return a plan of SELECT id, balance FROM accounts WHERE id < ? */
+  std::unique_ptr<PreparedPlan> MakeScan() {
+    auto plan = std::make_unique<PreparedPlan>();
+    auto id = plan->Make<ColumnValueExpression>(0, 0, TypeId::INTEGER);
+    auto balance = plan->Make<ColumnValueExpression>(0, 1, TypeId::INTEGER);
+    auto bound = plan->MakeParameter(TypeId::INTEGER);
+    auto predicate = plan->Make<ComparisonExpression>(id, bound, ComparisonType::LessThan);
+    auto schema = plan->Make<Schema>(
+        std::vector<Column>{Column("id", TypeId::INTEGER, id), Column("balance", TypeId::INTEGER, balance)});
+    plan->SetRoot(plan->Make<SeqScanPlanNode>(schema, predicate, table_oid_));
+    return plan;
+  }
+
+ protected:
+  std::unique_ptr<BustubInstance> instance_;
+  std::unique_ptr<SimpleCatalog> catalog_;
+  table_oid_t table_oid_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(SessionTest, BatchTest) {
+  Session session(instance_.get(), catalog_.get());
+  PreparedPlan *scan = session.Prepare(MakeScan());
+  std::vector<StatementResult> results;
+
+  // Two inserts and a scan in one batch, which commits on its own.
+  ASSERT_TRUE(session.ExecuteBatch({{session.Prepare(MakeInsert(1, 100)), {}},
+                                    {session.Prepare(MakeInsert(2, 200)), {}},
+                                    {scan, {ValueFactory::GetIntegerValue(10)}}},
+                                   &results));
+  ASSERT_EQ(3, results.size());
+  for (const StatementResult &result : results) {
+    EXPECT_EQ(StatementStatus::OK, result.status_);
+  }
+  EXPECT_EQ(2, results[2].tuples_.size());
+  EXPECT_FALSE(session.InTransaction());
+
+  // The batches of a transaction that the client began see its writes, and an abort takes them back.
+  session.Begin();
+  ASSERT_TRUE(session.ExecuteBatch({{session.Prepare(MakeInsert(3, 300)), {}}}, &results));
+  ASSERT_TRUE(session.ExecuteBatch({{scan, {ValueFactory::GetIntegerValue(10)}}}, &results));
+  EXPECT_EQ(3, results[0].tuples_.size());
+  EXPECT_TRUE(session.InTransaction());
+  session.Abort();
+  ASSERT_TRUE(session.ExecuteBatch({{scan, {ValueFactory::GetIntegerValue(10)}}}, &results));
+  EXPECT_EQ(2, results[0].tuples_.size());
+
+  // Another session sees the committed rows.
+  Session other(instance_.get(), catalog_.get());
+  ASSERT_TRUE(other.ExecuteBatch({{other.Prepare(MakeScan()), {ValueFactory::GetIntegerValue(2)}}}, &results));
+  ASSERT_EQ(1, results[0].tuples_.size());
+  EXPECT_EQ(100, results[0].tuples_[0].GetValue(&catalog_->GetTable(table_oid_)->schema_, 1).GetAs<int32_t>());
+}
+
+// NOLINTNEXTLINE
+TEST_F(SessionTest, ResultCacheTest) {
+  ResultCache cache;
+  Session session(instance_.get(), catalog_.get());
+  session.SetResultCache(&cache);
+  PreparedPlan *scan = session.Prepare(MakeScan());
+  std::vector<StatementResult> results;
+  ASSERT_TRUE(session.ExecuteBatch({{session.Prepare(MakeInsert(1, 100)), {}},
+                                    {session.Prepare(MakeInsert(2, 200)), {}}},
+                                   &results));
+
+  // The second run of a scan is served from the cache, a scan with another value of its parameter is not.
+  ASSERT_TRUE(session.ExecuteBatch({{scan, {ValueFactory::GetIntegerValue(10)}}}, &results));
+  EXPECT_EQ(2, results[0].tuples_.size());
+  ASSERT_TRUE(session.ExecuteBatch({{scan, {ValueFactory::GetIntegerValue(10)}}}, &results));
+  EXPECT_EQ(2, results[0].tuples_.size());
+  EXPECT_EQ(1, cache.GetNumHits());
+  ASSERT_TRUE(session.ExecuteBatch({{scan, {ValueFactory::GetIntegerValue(2)}}}, &results));
+  EXPECT_EQ(1, results[0].tuples_.size());
+  EXPECT_EQ(1, cache.GetNumHits());
+  EXPECT_EQ(2, cache.GetNumMisses());
+  EXPECT_EQ(2, cache.GetSize());
+
+  // A scan after its own insert in a transaction sees it, and passes the cache by.
+  ASSERT_TRUE(session.ExecuteBatch(
+      {{session.Prepare(MakeInsert(3, 300)), {}}, {scan, {ValueFactory::GetIntegerValue(10)}}}, &results));
+  EXPECT_EQ(3, results[1].tuples_.size());
+  EXPECT_EQ(2, cache.GetNumMisses());
+
+  // The commit of the insert changed the table, so that the cached result is not served again.
+  ASSERT_TRUE(session.ExecuteBatch({{scan, {ValueFactory::GetIntegerValue(10)}}}, &results));
+  EXPECT_EQ(3, results[0].tuples_.size());
+  EXPECT_EQ(1, cache.GetNumHits());
+  EXPECT_EQ(3, cache.GetNumMisses());
+
+  // Another session shares the cache, and a transaction that reads a snapshot passes it by.
+  Session other(instance_.get(), catalog_.get());
+  other.SetResultCache(&cache);
+  ASSERT_TRUE(other.ExecuteBatch({{other.Prepare(MakeScan()), {ValueFactory::GetIntegerValue(10)}}}, &results));
+  EXPECT_EQ(3, results[0].tuples_.size());
+  EXPECT_EQ(2, cache.GetNumHits());
+  other.Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+  ASSERT_TRUE(other.ExecuteBatch({{other.Prepare(MakeScan()), {ValueFactory::GetIntegerValue(10)}}}, &results));
+  EXPECT_EQ(3, results[0].tuples_.size());
+  EXPECT_TRUE(other.Commit());
+  EXPECT_EQ(2, cache.GetNumHits());
+  EXPECT_EQ(3, cache.GetNumMisses());
+}
+
+// NOLINTNEXTLINE
+TEST_F(SessionTest, ServerTest) {
+  SessionServer server(instance_.get(), catalog_.get());
+  server.RegisterStatement("scan", [this] { return MakeScan(); });
+  server.RegisterStatement("insert_1", [this] { return MakeInsert(1, 100); });
+  server.RegisterStatement("insert_2", [this] { return MakeInsert(2, 200); });
+  ASSERT_TRUE(server.Start(0));
+  ASSERT_NE(0, server.GetPort());
+
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(server.GetPort());
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+  ASSERT_EQ(0, ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)));
+  // Sends a batch, and reads its response up to the empty line.
+  auto round_trip = [fd](const std::string &batch) {
+    EXPECT_EQ(static_cast<ssize_t>(batch.size()), ::send(fd, batch.data(), batch.size(), 0));
+    std::string response;
+    char data[1024];
+    while (response.size() < 2 || response.compare(response.size() - 2, 2, "\n\n") != 0) {
+      const ssize_t n = ::recv(fd, data, sizeof(data), 0);
+      if (n <= 0) {
+        break;
+      }
+      response.append(data, n);
+    }
+    return response;
+  };
+
+  // A whole transaction in one round trip.
+  EXPECT_EQ("OK\nOK 0\nOK 0\nOK 1\n1\t100\nOK\n\n",
+            round_trip("BEGIN\ninsert_1\ninsert_2\nscan\t2\nCOMMIT\n\n"));
+  EXPECT_EQ("ERROR unknown statement missing\nERROR scan takes 1 parameters\nERROR stoi\nOK 2\n1\t100\n2\t200\n\n",
+            round_trip("missing\nscan\nscan\tabc\nscan\t10\n\n"));
+  ::close(fd);
+  server.Stop();
+}
+
+// NOLINTNEXTLINE
+TEST_F(SessionTest, ServerLimitsTest) {
+  SessionServer server(instance_.get(), catalog_.get(), 2, 16, 2);
+  server.RegisterStatement("scan", [this] { return MakeScan(); });
+  ASSERT_TRUE(server.Start(0));
+
+  auto connect = [&server] {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server.GetPort());
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    EXPECT_EQ(0, ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)));
+    return fd;
+  };
+  // Sends the data, and reads the response up to the empty line, or up to the end of the connection.
+  auto round_trip = [](int fd, const std::string &data) {
+    EXPECT_EQ(static_cast<ssize_t>(data.size()), ::send(fd, data.data(), data.size(), 0));
+    std::string response;
+    char buffer[1024];
+    while (response.size() < 2 || response.compare(response.size() - 2, 2, "\n\n") != 0) {
+      const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0) {
+        break;
+      }
+      response.append(buffer, n);
+    }
+    return response;
+  };
+  auto is_closed = [](int fd) {
+    char buffer[16];
+    return ::recv(fd, buffer, sizeof(buffer), 0) == 0;
+  };
+
+  // Scenario: the connections past the limit are turned away.
+  const int fd1 = connect();
+  const int fd2 = connect();
+  EXPECT_EQ("OK 0\n\n", round_trip(fd1, "scan\t2\n\n"));
+  EXPECT_EQ("OK 0\n\n", round_trip(fd2, "scan\t2\n\n"));
+  const int fd3 = connect();
+  EXPECT_EQ("ERROR too many connections\n\n", round_trip(fd3, ""));
+  EXPECT_TRUE(is_closed(fd3));
+
+  // Scenario: a batch with too many lines, and a line that is too long even before its newline, end the connection.
+  EXPECT_EQ("ERROR batch longer than 2 lines\n\n", round_trip(fd1, "scan\t1\nscan\t2\nscan\t3\n\n"));
+  EXPECT_TRUE(is_closed(fd1));
+  EXPECT_EQ("ERROR line longer than 16 bytes\n\n", round_trip(fd2, "scan\t" + std::string(32, '1')));
+  EXPECT_TRUE(is_closed(fd2));
+  ::close(fd1);
+  ::close(fd2);
+  ::close(fd3);
+  server.Stop();
+}
+
+}  // namespace bustub
@@ -0,0 +1,197 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_test.cpp
+//
+// Identification: test/recovery/log_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_manager.h"
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** Checks that the log file holds the records [0, num_records) in LSN order. */
+void CheckLogFile(DiskManager *disk_manager, lsn_t num_records) {
+  std::vector<char> log(num_records * 20 + 1);
+  ASSERT_TRUE(disk_manager->ReadLog(log.data(), static_cast<int>(log.size()), 0));
+  for (lsn_t lsn = 0; lsn < num_records; lsn++) {
+    int32_t size;
+    lsn_t record_lsn;
+    memcpy(&size, log.data() + lsn * 20, sizeof(size));
+    memcpy(&record_lsn, log.data() + lsn * 20 + sizeof(size), sizeof(record_lsn));
+    ASSERT_EQ(20, size);
+    ASSERT_EQ(lsn, record_lsn);
+  }
+  EXPECT_EQ(0, log[num_records * 20]);
+}
+
+// NOLINTNEXTLINE
+TEST(LogManagerTest, GroupCommitTest) {
+  remove("test.db");
+  remove("test.log");
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+
+  // Scenario: without a flush thread, waiting for a record writes the log buffer right away.
+  LogRecord begin(0, INVALID_LSN, LogRecordType::BEGIN);
+  EXPECT_EQ(0, log_manager->AppendLogRecord(&begin));
+  EXPECT_EQ(INVALID_LSN, log_manager->GetPersistentLSN());
+  log_manager->WaitUntilPersistent(0);
+  EXPECT_EQ(0, log_manager->GetPersistentLSN());
+  EXPECT_EQ(1, log_manager->GetNumLogFlushes());
+  // LSNs that were never handed out do not block.
+  log_manager->WaitUntilPersistent(1000);
+
+  // Scenario: concurrent commits share the writes of the flush thread.
+  log_manager->RunFlushThread();
+  EXPECT_TRUE(enable_logging);
+  const int num_threads = 8;
+  const int num_commits = 25;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([log_manager, t] {
+      for (int i = 0; i < num_commits; i++) {
+        LogRecord commit(t, INVALID_LSN, LogRecordType::COMMIT);
+        const lsn_t lsn = log_manager->AppendLogRecord(&commit);
+        log_manager->WaitUntilPersistent(lsn);
+        EXPECT_LE(lsn, log_manager->GetPersistentLSN());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const lsn_t num_records = 1 + num_threads * num_commits;
+  EXPECT_EQ(num_records, log_manager->GetNextLSN());
+  EXPECT_EQ(num_records - 1, log_manager->GetPersistentLSN());
+  EXPECT_LT(log_manager->GetNumLogFlushes(), num_threads * num_commits);
+  log_manager->StopFlushThread();
+  EXPECT_FALSE(enable_logging);
+  CheckLogFile(disk_manager, num_records);
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(LogManagerTest, FullBufferTest) {
+  remove("test.db");
+  remove("test.log");
+  auto *disk_manager = new DiskManager("test.db");
+  // Room for three records.
+  auto *log_manager = new LogManager(disk_manager, 64);
+  log_manager->RunFlushThread();
+
+  // Scenario: appends that do not fit wait for the flush thread to swap the buffers, and stopping it writes the rest.
+  const lsn_t num_records = 100;
+  for (lsn_t lsn = 0; lsn < num_records; lsn++) {
+    LogRecord record(0, lsn - 1, LogRecordType::BEGIN);
+    EXPECT_EQ(lsn, log_manager->AppendLogRecord(&record));
+  }
+  EXPECT_GE(log_manager->GetNumLogFlushes(), (num_records - 3) / 3);
+  log_manager->StopFlushThread();
+  EXPECT_EQ(num_records - 1, log_manager->GetPersistentLSN());
+  CheckLogFile(disk_manager, num_records);
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(LogManagerTest, AsyncCommitTest) {
+  remove("test.db");
+  remove("test.log");
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  const int max_lag = async_commit_max_lag;
+  async_commit_max_lag = 10;
+
+  // Scenario: an asynchronous commit returns before its record is written, unless the log falls too far behind.
+  for (lsn_t lsn = 0; lsn < 10; lsn++) {
+    LogRecord commit(0, INVALID_LSN, LogRecordType::COMMIT);
+    EXPECT_EQ(lsn, log_manager->AppendLogRecord(&commit));
+    log_manager->PersistAsync(lsn);
+    EXPECT_EQ(INVALID_LSN, log_manager->GetPersistentLSN());
+  }
+  LogRecord commit(0, INVALID_LSN, LogRecordType::COMMIT);
+  EXPECT_EQ(10, log_manager->AppendLogRecord(&commit));
+  log_manager->PersistAsync(10);
+  EXPECT_LE(0, log_manager->GetPersistentLSN());
+  EXPECT_EQ(1, log_manager->GetNumLogFlushes());
+
+  // Scenario: the flush thread writes the record within async_commit_delay instead of waiting for log_timeout.
+  log_manager->RunFlushThread();
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(11, log_manager->AppendLogRecord(&commit));
+  log_manager->PersistAsync(11);
+  while (log_manager->GetPersistentLSN() < 11) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+  log_manager->StopFlushThread();
+  CheckLogFile(disk_manager, 12);
+
+  async_commit_max_lag = max_lag;
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(LogManagerTest, ConcurrentAppendTest) {
+  remove("test.db");
+  remove("test.log");
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager, 1024);
+  log_manager->RunFlushThread();
+
+  // Scenario: appends that race for the space of the log buffer, and with its swaps, each get their own LSN and
+  // space, so the log holds every record once and in LSN order.
+  const int num_threads = 8;
+  const int num_appends = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([log_manager, t] {
+      for (int i = 0; i < num_appends; i++) {
+        LogRecord record(t, INVALID_LSN, LogRecordType::BEGIN);
+        log_manager->AppendLogRecord(&record);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager->StopFlushThread();
+  const lsn_t num_records = num_threads * num_appends;
+  EXPECT_EQ(num_records - 1, log_manager->GetPersistentLSN());
+  CheckLogFile(disk_manager, num_records);
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -10,7 +10,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <cstring>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "common/bustub_instance.h"
@@ -19,13 +26,27 @@
 #include "concurrency/transaction_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "network/log_replica.h"
+#include "network/log_shipper.h"
+#include "recovery/backup_manager.h"
 #include "recovery/log_recovery.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
+/** Deletes an instance like a crash would: the log records that were written are on disk, the dirty pages are not. */
+void Crash(BustubInstance *bustub_instance) {
+  bustub_instance->log_manager_->StopFlushThread();
+  delete bustub_instance->checkpoint_manager_;
+  bustub_instance->checkpoint_manager_ = nullptr;
+  // The buffer pool does not write back its pages to a disk manager that was shut down.
+  bustub_instance->disk_manager_->ShutDown();
+  delete bustub_instance;
+}
+
 // NOLINTNEXTLINE
 TEST(RecoveryTest, DISABLED_RedoTest) {
   remove("test.db");
@@ -206,7 +227,7 @@ TEST(RecoveryTest, DISABLED_UndoTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(RecoveryTest, DISABLED_CheckpointTest) {
+TEST(RecoveryTest, CheckpointTest) {
   remove("test.db");
   remove("test.log");
   BustubInstance *bustub_instance = new BustubInstance("test.db");
@@ -303,6 +324,15 @@ TEST(RecoveryTest, DISABLED_CheckpointTest) {
 
   EXPECT_TRUE(all_pages_lte);
 
+  // The metrics of the instance follow the state of its components.
+  MetricsSnapshot metrics = bustub_instance->metrics_registry_->Collect();
+  EXPECT_EQ(metrics.GetValue("bustub_log_persistent_lsn"), persistent_lsn);
+  EXPECT_EQ(metrics.GetValue("bustub_buffer_pool_frames"), pool_size);
+  EXPECT_GT(*metrics.GetValue("bustub_log_flushes_total"), 0);
+  ASSERT_NE(metrics.GetHistogram("bustub_log_flush_latency_us"), nullptr);
+  EXPECT_EQ(metrics.GetHistogram("bustub_log_flush_latency_us")->count_, *metrics.GetValue("bustub_log_flushes_total"));
+  EXPECT_NE(metrics.ToText().find("# TYPE bustub_lock_waits_total counter\n"), std::string::npos);
+
   delete txn;
   delete txn1;
   delete test_table;
@@ -314,4 +344,968 @@ TEST(RecoveryTest, DISABLED_CheckpointTest) {
   remove("test.db");
   remove("test.log");
 }
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, ParallelRedoTest) {
+  remove("test.db");
+  remove("test.log");
+  // Keep the background flusher away, so that the table pages only reach the disk through redo.
+  const auto old_flush_interval = flush_interval;
+  flush_interval = std::chrono::hours(1);
+  BustubConfig config;
+  config.buffer_pool_size = 64;
+  auto *bustub_instance = new BustubInstance("test.db", config);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  // Scenario: a committed transaction fills enough pages to keep all redo workers busy, and deletes some tuples.
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 1000;
+  std::vector<Tuple> tuples;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    tuples.push_back(ConstructTuple(&schema));
+    ASSERT_TRUE(test_table->InsertTuple(tuples[i], &rids[i], txn));
+  }
+  for (int i = 0; i < num_tuples; i += 10) {
+    ASSERT_TRUE(test_table->MarkDelete(rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  const page_id_t last_page_id = rids.back().GetPageId();
+  ASSERT_GE(last_page_id - first_page_id, REDO_WORKERS);
+  Crash(bustub_instance);
+
+  bustub_instance = new BustubInstance("test.db", config);
+  auto *log_recovery =
+      new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_, LOG_BUFFER_SIZE, 4);
+  log_recovery->Redo();
+  EXPECT_LT(0, log_recovery->GetNumRedoneRecords());
+  log_recovery->Undo();
+  delete log_recovery;
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple;
+    if (i % 10 == 0) {
+      EXPECT_FALSE(test_table->GetTuple(rids[i], &tuple, txn));
+      continue;
+    }
+    ASSERT_TRUE(test_table->GetTuple(rids[i], &tuple, txn));
+    EXPECT_EQ(CmpBool::CmpTrue, tuple.GetValue(&schema, 0).CompareEquals(tuples[i].GetValue(&schema, 0)));
+    EXPECT_EQ(CmpBool::CmpTrue, tuple.GetValue(&schema, 1).CompareEquals(tuples[i].GetValue(&schema, 1)));
+  }
+  // The table heap was linked up again by the NEWPAGE records.
+  int num_scanned = 0;
+  for (auto it = test_table->Begin(txn); it != test_table->End(); ++it) {
+    num_scanned++;
+  }
+  EXPECT_EQ(num_tuples - num_tuples / 10, num_scanned);
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+
+  // Scenario: the pages hold the LSNs of the replayed records, so a second redo applies nothing.
+  log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  EXPECT_EQ(0, log_recovery->GetNumRedoneRecords());
+  delete log_recovery;
+
+  delete bustub_instance;
+  flush_interval = old_flush_interval;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, UpdateDeltaTest) {
+  remove("test.db");
+  remove("test.log");
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto make_tuple = [&](const std::string &a, int16_t b) {
+    return Tuple({Value(TypeId::VARCHAR, a), Value(TypeId::SMALLINT, b)}, &schema);
+  };
+  auto same_bytes = [](const Tuple &a, const Tuple &b) {
+    return a.GetLength() == b.GetLength() && memcmp(a.GetData(), b.GetData(), a.GetLength()) == 0;
+  };
+
+  // Scenario: a counter update logs the changed bytes only, and the delta turns either tuple into the other.
+  const Tuple counter_old = make_tuple("counter", 41);
+  const Tuple counter_new = make_tuple("counter", 42);
+  LogRecord counter_record(0, INVALID_LSN, LogRecordType::UPDATE, RID(0, 0), counter_old, counter_new);
+  EXPECT_LT(counter_record.GetSize(), static_cast<int32_t>(20 + sizeof(RID) + counter_old.GetLength()));
+  EXPECT_TRUE(same_bytes(counter_new, counter_record.GetNewTuple(counter_old)));
+  EXPECT_TRUE(same_bytes(counter_old, counter_record.GetOldTuple(counter_new)));
+  // Tuples that change their size keep the tail of the longer one.
+  const Tuple longer = make_tuple("counter with a longer name", 42);
+  LogRecord grow_record(0, INVALID_LSN, LogRecordType::UPDATE, RID(0, 0), counter_old, longer);
+  EXPECT_TRUE(same_bytes(longer, grow_record.GetNewTuple(counter_old)));
+  EXPECT_TRUE(same_bytes(counter_old, grow_record.GetOldTuple(longer)));
+  LogRecord shrink_record(0, INVALID_LSN, LogRecordType::UPDATE, RID(0, 0), longer, counter_new);
+  EXPECT_TRUE(same_bytes(counter_new, shrink_record.GetNewTuple(longer)));
+  EXPECT_TRUE(same_bytes(longer, shrink_record.GetOldTuple(counter_new)));
+
+  // Scenario: redo replays the committed updates on the before-images, undo reverts the uncommitted ones.
+  const auto old_flush_interval = flush_interval;
+  flush_interval = std::chrono::hours(1);
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 20;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->InsertTuple(make_tuple("counter", 0), &rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->UpdateTuple(make_tuple("counter", static_cast<int16_t>(i)), rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (int i = 0; i < num_tuples; i += 2) {
+    ASSERT_TRUE(test_table->UpdateTuple(make_tuple("uncommitted", 1000), rids[i], txn));
+  }
+  bustub_instance->log_manager_->WaitUntilPersistent(txn->GetPrevLSN());
+  delete txn;
+  delete test_table;
+  Crash(bustub_instance);
+
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple;
+    ASSERT_TRUE(test_table->GetTuple(rids[i], &tuple, txn));
+    EXPECT_TRUE(same_bytes(make_tuple("counter", static_cast<int16_t>(i)), tuple));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+
+  delete bustub_instance;
+  flush_interval = old_flush_interval;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, LogRecordViewTest) {
+  remove("test.db");
+  remove("test.log");
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple old_tuple({Value(TypeId::VARCHAR, std::string("counter")), Value(TypeId::SMALLINT, 41)}, &schema);
+  const Tuple new_tuple({Value(TypeId::VARCHAR, std::string("counter")), Value(TypeId::SMALLINT, 42)}, &schema);
+  LogRecord insert(0, INVALID_LSN, LogRecordType::INSERT, RID(3, 1), old_tuple);
+  LogRecord update(0, 0, LogRecordType::UPDATE, RID(3, 1), old_tuple, new_tuple);
+  LogRecord new_page(0, 1, LogRecordType::NEWPAGE, 3, 4);
+  LogRecord checkpoint({{0, 0}}, {{3, 0}, {4, 2}});
+  for (auto *record : {&insert, &update, &new_page, &checkpoint}) {
+    log_manager->AppendLogRecord(record);
+  }
+  log_manager->WaitUntilPersistent(3);
+  std::vector<char> log(LOG_BUFFER_SIZE);
+  ASSERT_TRUE(disk_manager->ReadLog(log.data(), static_cast<int>(log.size()), 0));
+
+  // Scenario: the views read the records where they are, the tuple of an insert is not copied out of the log.
+  LogRecordView view;
+  ASSERT_TRUE(view.Parse(log.data(), log.size()));
+  EXPECT_EQ(LogRecordType::INSERT, view.GetLogRecordType());
+  EXPECT_EQ(0, view.GetLSN());
+  EXPECT_EQ(RID(3, 1), view.GetRID());
+  Tuple logged_tuple = view.GetTuple();
+  EXPECT_FALSE(logged_tuple.IsAllocated());
+  EXPECT_EQ(log.data() + 20 + sizeof(RID) + sizeof(uint32_t), logged_tuple.GetData());
+  ASSERT_EQ(old_tuple.GetLength(), logged_tuple.GetLength());
+  EXPECT_EQ(0, memcmp(old_tuple.GetData(), logged_tuple.GetData(), old_tuple.GetLength()));
+  size_t pos = view.GetSize();
+
+  ASSERT_TRUE(view.Parse(log.data() + pos, log.size() - pos));
+  EXPECT_EQ(LogRecordType::UPDATE, view.GetLogRecordType());
+  EXPECT_EQ(0, view.GetPrevLSN());
+  std::vector<char> tuple_buffer;
+  const Tuple updated = LogRecord::ApplyUpdateDelta(view.GetUpdateDelta(), old_tuple, false, &tuple_buffer);
+  ASSERT_EQ(new_tuple.GetLength(), updated.GetLength());
+  EXPECT_EQ(0, memcmp(new_tuple.GetData(), updated.GetData(), new_tuple.GetLength()));
+  // A truncated record is torn, whatever part of it is missing.
+  for (size_t size = 0; size < static_cast<size_t>(view.GetSize()); size++) {
+    LogRecordView torn;
+    EXPECT_FALSE(torn.Parse(log.data() + pos, size));
+  }
+  pos += view.GetSize();
+
+  ASSERT_TRUE(view.Parse(log.data() + pos, log.size() - pos));
+  EXPECT_EQ(LogRecordType::NEWPAGE, view.GetLogRecordType());
+  EXPECT_EQ(3, view.GetPrevPageId());
+  EXPECT_EQ(4, view.GetNewPageId());
+  pos += view.GetSize();
+
+  ASSERT_TRUE(view.Parse(log.data() + pos, log.size() - pos));
+  EXPECT_EQ(LogRecordType::BEGIN_CHECKPOINT, view.GetLogRecordType());
+  EXPECT_EQ(LogRecord::GetCheckpointSize(1, 2), view.GetSize());
+  pos += view.GetSize();
+  // The zeroes after the last record are not a record.
+  EXPECT_FALSE(view.Parse(log.data() + pos, log.size() - pos));
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, BulkInsertTest) {
+  remove("test.db");
+  remove("test.log");
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::INTEGER};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto make_tuples = [&](int begin, int end) {
+    std::vector<Tuple> tuples;
+    for (int i = begin; i < end; i++) {
+      tuples.emplace_back(std::vector<Value>{Value(TypeId::VARCHAR, std::string("row")), Value(TypeId::INTEGER, i)},
+                          &schema);
+    }
+    return tuples;
+  };
+  auto count_tuples = [](TableHeap *table, Transaction *txn) {
+    int count = 0;
+    for (auto it = table->Begin(txn); it != table->End(); ++it) {
+      count++;
+    }
+    return count;
+  };
+
+  const auto old_flush_interval = flush_interval;
+  flush_interval = std::chrono::hours(1);
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+
+  // Scenario: a load into a new table logs a record per page instead of one per tuple.
+  const int num_tuples = 1000;
+  std::vector<RID> rids;
+  const lsn_t load_lsn = bustub_instance->log_manager_->GetNextLSN();
+  ASSERT_TRUE(test_table->BulkInsert(make_tuples(0, num_tuples), &rids, txn));
+  ASSERT_EQ(num_tuples, static_cast<int>(rids.size()));
+  const lsn_t num_records = bustub_instance->log_manager_->GetNextLSN() - load_lsn;
+  EXPECT_GT(num_records, 1);
+  EXPECT_LT(num_records, num_tuples / 20);
+  EXPECT_EQ(num_tuples, count_tuples(test_table, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  // Scenario: an aborted load leaves the table as it was.
+  txn = bustub_instance->transaction_manager_->Begin();
+  ASSERT_TRUE(test_table->BulkInsert(make_tuples(num_tuples, 2 * num_tuples), nullptr, txn));
+  EXPECT_EQ(2 * num_tuples, count_tuples(test_table, txn));
+  bustub_instance->transaction_manager_->Abort(txn);
+  delete txn;
+  txn = bustub_instance->transaction_manager_->Begin();
+  EXPECT_EQ(num_tuples, count_tuples(test_table, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  // Scenario: a load that is running at the crash is undone, the committed load is redone from the images.
+  txn = bustub_instance->transaction_manager_->Begin();
+  ASSERT_TRUE(test_table->BulkInsert(make_tuples(2 * num_tuples, 3 * num_tuples), nullptr, txn));
+  bustub_instance->log_manager_->WaitUntilPersistent(txn->GetPrevLSN());
+  delete txn;
+  delete test_table;
+  Crash(bustub_instance);
+
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  EXPECT_EQ(num_tuples, count_tuples(test_table, txn));
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple;
+    ASSERT_TRUE(test_table->GetTuple(rids[i], &tuple, txn));
+    EXPECT_EQ(i, tuple.GetValue(&schema, 1).GetAs<int32_t>());
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+
+  delete bustub_instance;
+  flush_interval = old_flush_interval;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, TruncateTest) {
+  remove("test.db");
+  remove("test.log");
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::INTEGER};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto insert_tuples = [&](TableHeap *table, int begin, int end, Transaction *txn) {
+    for (int i = begin; i < end; i++) {
+      Tuple tuple(std::vector<Value>{Value(TypeId::VARCHAR, std::string("row")), Value(TypeId::INTEGER, i)}, &schema);
+      RID rid;
+      ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+    }
+  };
+  auto count_tuples = [](TableHeap *table, Transaction *txn) {
+    int count = 0;
+    for (auto it = table->Begin(txn); it != table->End(); ++it) {
+      count++;
+    }
+    return count;
+  };
+
+  const auto old_flush_interval = flush_interval;
+  flush_interval = std::chrono::hours(1);
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  auto *transaction_manager = bustub_instance->transaction_manager_;
+  Transaction *txn = transaction_manager->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 1000;
+  insert_tuples(test_table, 0, num_tuples, txn);
+  transaction_manager->Commit(txn);
+  delete txn;
+  const size_t num_pages = test_table->GetNumPages();
+  ASSERT_GT(num_pages, 1);
+
+  // Scenario: a truncation logs a single record, and an aborted one leaves the table as it was.
+  txn = transaction_manager->Begin();
+  const lsn_t truncate_lsn = bustub_instance->log_manager_->GetNextLSN();
+  ASSERT_TRUE(test_table->Truncate(txn));
+  EXPECT_EQ(1, bustub_instance->log_manager_->GetNextLSN() - truncate_lsn);
+  EXPECT_EQ(0, count_tuples(test_table, txn));
+  EXPECT_EQ(1, test_table->GetNumPages());
+  insert_tuples(test_table, num_tuples, num_tuples + 10, txn);
+  EXPECT_EQ(10, count_tuples(test_table, txn));
+  transaction_manager->Abort(txn);
+  delete txn;
+  txn = transaction_manager->Begin();
+  EXPECT_EQ(num_tuples, count_tuples(test_table, txn));
+  EXPECT_EQ(num_pages, test_table->GetNumPages());
+  transaction_manager->Commit(txn);
+  delete txn;
+
+  // Scenario: once a truncation commits, the vacuum deallocates the pages that followed the first page.
+  txn = transaction_manager->Begin();
+  ASSERT_TRUE(test_table->Truncate(txn));
+  insert_tuples(test_table, num_tuples, num_tuples + 10, txn);
+  EXPECT_EQ(0, test_table->Vacuum(transaction_manager));
+  transaction_manager->Commit(txn);
+  delete txn;
+  EXPECT_EQ(num_pages - 1, test_table->Vacuum(transaction_manager));
+  txn = transaction_manager->Begin();
+  EXPECT_EQ(10, count_tuples(test_table, txn));
+  transaction_manager->Commit(txn);
+  delete txn;
+
+  // Scenario: a truncation that is running at the crash is undone, the committed one is redone.
+  txn = transaction_manager->Begin();
+  ASSERT_TRUE(test_table->Truncate(txn));
+  bustub_instance->log_manager_->WaitUntilPersistent(txn->GetPrevLSN());
+  delete txn;
+  delete test_table;
+  Crash(bustub_instance);
+
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  EXPECT_EQ(10, count_tuples(test_table, txn));
+  EXPECT_EQ(1, test_table->GetNumPages());
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+
+  delete bustub_instance;
+  flush_interval = old_flush_interval;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, TornPageTest) {
+  remove("test.db");
+  remove("test.log");
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::INTEGER};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 100;
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple tuple(std::vector<Value>{Value(TypeId::VARCHAR, std::string("row")), Value(TypeId::INTEGER, i)}, &schema);
+    RID rid;
+    ASSERT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  bustub_instance->buffer_pool_manager_->FlushAllPages();
+  delete test_table;
+  delete bustub_instance;
+
+  // Scenario: the crash tore the first page of the table. It fails its checksum, and redo rebuilds it from the log,
+  // which creates it with a record that rewrites all of it.
+  int fd = open("test.db", O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(1, pwrite(fd, "x", 1, static_cast<off_t>(first_page_id) * PAGE_SIZE + 100));
+  close(fd);
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  EXPECT_LT(0, bustub_instance->disk_manager_->GetNumChecksumFailures());
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  int count = 0;
+  for (auto it = test_table->Begin(txn); it != test_table->End(); ++it) {
+    EXPECT_EQ(count, it->GetValue(&schema, 1).GetAs<int32_t>());
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+
+  delete bustub_instance;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, CompressedLogTest) {
+  remove("test.db");
+  remove("test.log");
+  const auto old_flush_interval = flush_interval;
+  flush_interval = std::chrono::hours(1);
+  BustubConfig config;
+  config.buffer_pool_size = 64;
+  config.compress_log = true;
+  auto *bustub_instance = new BustubInstance("test.db", config);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple({Value(TypeId::VARCHAR, std::string("repetitive")), Value(TypeId::SMALLINT, int16_t{7})}, &schema);
+
+  // Scenario: a bulk load of the same tuple takes a fraction of its log volume, and recovers from the compressed log.
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  const int num_tuples = 500;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; i++) {
+    ASSERT_TRUE(test_table->InsertTuple(tuple, &rids[i], txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  const int64_t insert_size = 20 + sizeof(RID) + sizeof(int32_t) + tuple.GetLength();
+  EXPECT_LT(bustub_instance->disk_manager_->GetLogSize(), num_tuples * insert_size / 2);
+  // The inserts of a transaction that does not commit are undone.
+  txn = bustub_instance->transaction_manager_->Begin();
+  RID uncommitted_rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &uncommitted_rid, txn));
+  bustub_instance->log_manager_->WaitUntilPersistent(txn->GetPrevLSN());
+  delete txn;
+  delete test_table;
+  Crash(bustub_instance);
+
+  bustub_instance = new BustubInstance("test.db", config);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  EXPECT_LT(0, log_recovery->GetNumRedoneRecords());
+  log_recovery->Undo();
+  delete log_recovery;
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  for (int i = 0; i < num_tuples; i++) {
+    Tuple recovered;
+    ASSERT_TRUE(test_table->GetTuple(rids[i], &recovered, txn));
+    EXPECT_EQ(CmpBool::CmpTrue, recovered.GetValue(&schema, 0).CompareEquals(tuple.GetValue(&schema, 0)));
+  }
+  Tuple recovered;
+  EXPECT_FALSE(test_table->GetTuple(uncommitted_rid, &recovered, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+
+  delete bustub_instance;
+  flush_interval = old_flush_interval;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, FuzzyCheckpointTest) {
+  remove("test.db");
+  remove("test.log");
+  const auto old_flush_interval = flush_interval;
+  flush_interval = std::chrono::hours(1);
+  BustubConfig config;
+  config.buffer_pool_size = 64;
+  auto *bustub_instance = new BustubInstance("test.db", config);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto insert_tuples = [&](TableHeap *table, Transaction *txn, int num_tuples, std::vector<RID> *rids) {
+    for (int i = 0; i < num_tuples; i++) {
+      RID rid;
+      ASSERT_TRUE(table->InsertTuple(ConstructTuple(&schema), &rid, txn));
+      rids->push_back(rid);
+    }
+  };
+
+  std::vector<RID> committed_rids;
+  std::vector<RID> uncommitted_rids;
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  insert_tuples(test_table, txn, 300, &committed_rids);
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  // Scenario: a transaction keeps running across two checkpoints, and it is not blocked by them. The first one writes
+  // back all the pages, including the uncommitted changes of the transaction.
+  Transaction *running_txn = bustub_instance->transaction_manager_->Begin();
+  insert_tuples(test_table, running_txn, 20, &uncommitted_rids);
+  bustub_instance->checkpoint_manager_->BeginCheckpoint();
+  bustub_instance->checkpoint_manager_->EndCheckpoint();
+  EXPECT_TRUE(bustub_instance->buffer_pool_manager_->GetDirtyPageTable().empty());
+  bustub_instance->checkpoint_manager_->BeginCheckpoint();
+  insert_tuples(test_table, running_txn, 20, &uncommitted_rids);
+  bustub_instance->checkpoint_manager_->EndCheckpoint();
+  EXPECT_EQ(bustub_instance->log_manager_->GetNextLSN() - 1, bustub_instance->log_manager_->GetPersistentLSN());
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  insert_tuples(test_table, txn, 50, &committed_rids);
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  // The system crashes before the running transaction commits.
+  delete test_table;
+  Crash(bustub_instance);
+  delete running_txn;
+
+  bustub_instance = new BustubInstance("test.db", config);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  // Redo starts at the second checkpoint, the first one wrote back the pages that were dirty before it. Undo has to go
+  // further back for the first changes of the running transaction.
+  EXPECT_LT(0, log_recovery->GetRedoStartOffset());
+  log_recovery->Undo();
+  delete log_recovery;
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple tuple;
+  for (const auto &rid : committed_rids) {
+    EXPECT_TRUE(test_table->GetTuple(rid, &tuple, txn));
+  }
+  for (const auto &rid : uncommitted_rids) {
+    EXPECT_FALSE(test_table->GetTuple(rid, &tuple, txn));
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+
+  delete bustub_instance;
+  flush_interval = old_flush_interval;
+  remove("test.db");
+  remove("test.log");
+  remove("test.master");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, LogShippingTest) {
+  remove("test.db");
+  remove("test.log");
+  remove("replica.db");
+  remove("replica.log");
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const int num_tuples = 200;
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetVarcharValue("row " + std::to_string(i)),
+                  ValueFactory::GetSmallIntValue(static_cast<int16_t>(i))},
+                 &schema);
+  };
+
+  // Logging is on or off for a whole process, and redo needs it off, so the primary runs in a process of its own. It
+  // tells its progress to the replica through a pipe, and waits for the replica through another.
+  int to_replica[2];
+  int to_primary[2];
+  ASSERT_EQ(0, pipe(to_replica));
+  ASSERT_EQ(0, pipe(to_primary));
+  const pid_t primary = fork();
+  ASSERT_LE(0, primary);
+  if (primary == 0) {
+    close(to_replica[0]);
+    close(to_primary[1]);
+    auto tell = [&](int64_t value) { return write(to_replica[1], &value, sizeof(value)) == sizeof(value); };
+    auto wait = [&]() {
+      char go;
+      return read(to_primary[0], &go, 1) == 1;
+    };
+    auto *bustub_instance = new BustubInstance("test.db");
+    bustub_instance->log_manager_->RunFlushThread();
+    auto *shipper = new LogShipper(bustub_instance->disk_manager_, bustub_instance->log_manager_);
+    Transaction *txn = bustub_instance->transaction_manager_->Begin();
+    auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                     bustub_instance->log_manager_, txn);
+    bool ok = shipper->Start(0);
+    RID rid;
+    for (int i = 0; i < num_tuples; i++) {
+      ok = ok && test_table->InsertTuple(make_tuple(i), &rid, txn);
+      if (i == num_tuples / 2) {
+        // The replica connects once the first half is in the log file.
+        bustub_instance->transaction_manager_->Commit(txn);
+        delete txn;
+        txn = bustub_instance->transaction_manager_->Begin();
+        ok = ok && tell(shipper->GetPort()) && tell(test_table->GetFirstPageId()) && wait();
+      }
+    }
+    bustub_instance->transaction_manager_->Commit(txn);
+    delete txn;
+    ok = ok && tell(bustub_instance->log_manager_->GetPersistentLSN()) && wait();
+
+    // A transaction that is still running.
+    txn = bustub_instance->transaction_manager_->Begin();
+    ok = ok && test_table->InsertTuple(make_tuple(num_tuples), &rid, txn);
+    bustub_instance->log_manager_->WaitUntilPersistent(bustub_instance->log_manager_->GetNextLSN() - 1);
+    ok = ok && tell(bustub_instance->log_manager_->GetPersistentLSN()) && wait();
+    bustub_instance->transaction_manager_->Commit(txn);
+    delete txn;
+    ok = ok && tell(bustub_instance->log_manager_->GetPersistentLSN()) && wait();
+
+    delete shipper;
+    delete test_table;
+    delete bustub_instance;
+    _exit(ok ? 0 : 1);
+  }
+  close(to_replica[1]);
+  close(to_primary[0]);
+  auto hear = [&]() {
+    int64_t value = -1;
+    EXPECT_EQ(sizeof(value), read(to_replica[0], &value, sizeof(value)));
+    return value;
+  };
+  auto go_on = [&]() { EXPECT_EQ(1, write(to_primary[1], "g", 1)); };
+
+  // Scenario: the replica catches up from the log file of the primary, and then gets its log buffers as they are
+  // written.
+  auto *replica_instance = new BustubInstance("replica.db");
+  auto *replica = new LogReplica(replica_instance);
+  const auto port = static_cast<uint16_t>(hear());
+  const auto first_page_id = static_cast<page_id_t>(hear());
+  ASSERT_TRUE(replica->Start("127.0.0.1", port));
+  go_on();
+  EXPECT_TRUE(replica->WaitForLSN(hear(), std::chrono::seconds(10)));
+  {
+    auto snapshot = replica->LockSnapshot();
+    Transaction reader(0);
+    TableHeap replica_table(replica_instance->buffer_pool_manager_, replica_instance->lock_manager_,
+                            replica_instance->log_manager_, first_page_id);
+    int num_scanned = 0;
+    for (auto it = replica_table.Begin(&reader); it != replica_table.End(); ++it) {
+      const Tuple expected = make_tuple(num_scanned++);
+      EXPECT_EQ(CmpBool::CmpTrue, it->GetValue(&schema, 0).CompareEquals(expected.GetValue(&schema, 0)));
+      EXPECT_EQ(CmpBool::CmpTrue, it->GetValue(&schema, 1).CompareEquals(expected.GetValue(&schema, 1)));
+    }
+    EXPECT_EQ(num_tuples, num_scanned);
+  }
+  go_on();
+
+  // Scenario: the writes of a transaction that is still running on the primary are not applied until it commits.
+  const lsn_t committed_lsn = replica->GetAppliedLSN();
+  EXPECT_FALSE(replica->WaitForLSN(hear(), std::chrono::milliseconds(200)));
+  EXPECT_EQ(committed_lsn, replica->GetAppliedLSN());
+  go_on();
+  EXPECT_TRUE(replica->WaitForLSN(hear(), std::chrono::seconds(10)));
+  go_on();
+
+  int status;
+  ASSERT_EQ(primary, waitpid(primary, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  delete replica;
+  delete replica_instance;
+  close(to_replica[0]);
+  close(to_primary[1]);
+  remove("test.db");
+  remove("test.log");
+  remove("replica.db");
+  remove("replica.log");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, OnlineBackupTest) {
+  remove("test.db");
+  remove("test.log");
+  remove("backup.db");
+  remove("backup.log");
+  BustubConfig config;
+  config.buffer_pool_size = 16;
+  auto *bustub_instance = new BustubInstance("test.db", config);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::INTEGER};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto make_tuple = [&schema](int i) {
+    return Tuple({ValueFactory::GetVarcharValue("row " + std::to_string(i)), ValueFactory::GetIntegerValue(i)},
+                 &schema);
+  };
+  // Every transaction inserts a batch of rows, so a consistent copy holds a whole number of batches.
+  const int batch_size = 10;
+  int num_rows = 0;
+  auto insert_batch = [&](TableHeap *table) {
+    Transaction *txn = bustub_instance->transaction_manager_->Begin();
+    RID rid;
+    for (int i = 0; i < batch_size; i++) {
+      ASSERT_TRUE(table->InsertTuple(make_tuple(num_rows + i), &rid, txn));
+    }
+    bustub_instance->transaction_manager_->Commit(txn);
+    delete txn;
+    num_rows += batch_size;
+  };
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  for (int i = 0; i < 100; i++) {
+    insert_batch(test_table);
+  }
+  bustub_instance->checkpoint_manager_->BeginCheckpoint();
+  bustub_instance->checkpoint_manager_->EndCheckpoint();
+  for (int i = 0; i < 100; i++) {
+    insert_batch(test_table);
+  }
+  const int num_rows_before = num_rows;
+
+  // Scenario: the rows keep being inserted, and the pages written back, while the backup copies the database at a
+  // limited rate. The writer is not held up, and the copy restores to a point where a whole number of batches was in.
+  std::atomic<bool> stop{false};
+  std::thread writer([&]() {
+    while (!stop) {
+      insert_batch(test_table);
+    }
+  });
+  auto *backup_disk_manager = new DiskManager("backup.db");
+  BackupManager backup_manager(bustub_instance->disk_manager_);
+  const int64_t bytes_per_second = 1 << 19;
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(backup_manager.Backup(backup_disk_manager, bytes_per_second));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  stop = true;
+  writer.join();
+  EXPECT_LT(num_rows_before, num_rows);
+  EXPECT_LT(0, backup_manager.GetNumPagesCopied());
+  EXPECT_LT(backup_manager.GetLogStartOffset(), backup_manager.GetLogEndOffset());
+  const int64_t num_bytes_copied = backup_manager.GetNumPagesCopied() * PAGE_SIZE + backup_manager.GetLogEndOffset() -
+                                   backup_manager.GetLogStartOffset();
+  EXPECT_LE(std::chrono::duration<double>(num_bytes_copied) / bytes_per_second * 0.9,
+            std::chrono::duration<double>(elapsed));
+  backup_disk_manager->ShutDown();
+  delete backup_disk_manager;
+  delete test_table;
+  delete bustub_instance;
+
+  bustub_instance = new BustubInstance("backup.db", config);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  int num_scanned = 0;
+  for (auto it = test_table->Begin(txn); it != test_table->End(); ++it) {
+    EXPECT_EQ(num_scanned, it->GetValue(&schema, 1).GetAs<int32_t>());
+    num_scanned++;
+  }
+  EXPECT_LE(num_rows_before, num_scanned);
+  EXPECT_GE(num_rows, num_scanned);
+  EXPECT_EQ(0, num_scanned % batch_size);
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+
+  delete bustub_instance;
+  remove("test.db");
+  remove("test.log");
+  remove("test.master");
+  remove("backup.db");
+  remove("backup.log");
+  remove("backup.master");
+}
+
+// NOLINTNEXTLINE
+TEST(RecoveryTest, AbortFromLogTest) {
+  remove("test.db");
+  remove("test.log");
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::INTEGER};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto make_tuple = [&schema](const std::string &text, int i) {
+    return Tuple({ValueFactory::GetVarcharValue(text + " " + std::to_string(i)), ValueFactory::GetIntegerValue(i)},
+                 &schema);
+  };
+  const int num_rows = 100;
+  std::vector<RID> rids;
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  const page_id_t first_page_id = test_table->GetFirstPageId();
+  for (int i = 0; i < num_rows; i++) {
+    RID rid;
+    ASSERT_TRUE(test_table->InsertTuple(make_tuple("row", i), &rid, txn));
+    rids.push_back(rid);
+  }
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  auto check_rows = [&](TableHeap *table) {
+    Transaction *reader = bustub_instance->transaction_manager_->Begin();
+    Tuple tuple;
+    for (int i = 0; i < num_rows; i++) {
+      EXPECT_TRUE(table->GetTuple(rids[i], &tuple, reader));
+      EXPECT_EQ(CmpBool::CmpTrue,
+                tuple.GetValue(&schema, 0).CompareEquals(make_tuple("row", i).GetValue(&schema, 0)));
+    }
+    bustub_instance->transaction_manager_->Commit(reader);
+    delete reader;
+  };
+
+  // Scenario: the write set of a transaction keeps no tuples of its updates, the abort reads them back from the log
+  // and logs a compensation for every write that it rolls back.
+  txn = bustub_instance->transaction_manager_->Begin();
+  const txn_id_t aborted_txn_id = txn->GetTransactionId();
+  for (int i = 0; i < num_rows; i++) {
+    ASSERT_TRUE(test_table->UpdateTuple(make_tuple("updated", i), rids[i], txn));
+  }
+  for (const auto &item : *txn->GetWriteSet()) {
+    EXPECT_EQ(0, item.tuple_.GetLength());
+    EXPECT_NE(INVALID_LSN, item.lsn_);
+  }
+  bustub_instance->transaction_manager_->Abort(txn);
+  delete txn;
+  check_rows(test_table);
+  bustub_instance->log_manager_->WaitUntilPersistent(bustub_instance->log_manager_->GetNextLSN() - 1);
+  int num_clrs = 0;
+  {
+    std::vector<char> log_data(bustub_instance->disk_manager_->GetLogSize());
+    ASSERT_TRUE(bustub_instance->disk_manager_->ReadLog(log_data.data(), static_cast<int>(log_data.size()), 0));
+    LogRecordView log_record;
+    for (size_t pos = 0; log_record.Parse(log_data.data() + pos, log_data.size() - pos); pos += log_record.GetSize()) {
+      num_clrs += log_record.GetLogRecordType() == LogRecordType::CLR && log_record.GetTxnId() == aborted_txn_id;
+    }
+  }
+  EXPECT_EQ(num_rows, num_clrs);
+
+  // Scenario: the system crashes while a transaction rolls back its updates. Undo goes on where the rollback stopped.
+  txn = bustub_instance->transaction_manager_->Begin();
+  for (int i = 0; i < num_rows; i++) {
+    ASSERT_TRUE(test_table->UpdateTuple(make_tuple("crashed", i), rids[i], txn));
+  }
+  txn->SetState(TransactionState::ABORTED);
+  LogReadBuffer log_buffer;
+  auto *write_set = txn->GetWriteSet();
+  for (int i = 0; i < num_rows / 2; i++) {
+    const WriteRecord item = write_set->back();
+    test_table->RollbackUpdate(item.rid_, item.lsn_, &log_buffer, txn);
+    write_set->pop_back();
+    LogRecord clr(txn->GetTransactionId(), txn->GetPrevLSN(), write_set->back().lsn_);
+    txn->SetPrevLSN(bustub_instance->log_manager_->AppendLogRecord(&clr));
+  }
+  bustub_instance->log_manager_->WaitUntilPersistent(bustub_instance->log_manager_->GetNextLSN() - 1);
+  delete test_table;
+  Crash(bustub_instance);
+  delete txn;
+
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  check_rows(test_table);
+  delete test_table;
+
+  delete bustub_instance;
+  remove("test.db");
+  remove("test.log");
+  remove("test.master");
+}
 }  // namespace bustub
@@ -0,0 +1,341 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_test.cpp
+//
+// Identification: test/storage/b_plus_tree_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <thread>  // NOLINT
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/index/b_plus_tree.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+GenericKey<8> MakeKey(int64_t key) {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(key);
+  return index_key;
+}
+
+RID MakeRID(int64_t key) { return RID(static_cast<int32_t>(key >> 32), static_cast<uint32_t>(key)); }
+
+/** @return the keys of the tree in iteration order, starting from the first key not less than begin_key */
+std::vector<int64_t> ScanKeys(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree, int64_t begin_key) {
+  std::vector<int64_t> keys;
+  for (auto it = tree->Begin(MakeKey(begin_key)); it != tree->End(); ++it) {
+    keys.push_back((*it).first.ToString());
+    EXPECT_EQ(MakeRID(keys.back()), (*it).second);
+  }
+  return keys;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTest, InsertScanRemoveTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  Schema key_schema({Column("a", TypeId::BIGINT)});
+  GenericComparator<8> comparator(&key_schema);
+
+  // tiny pages, so that the tree is several levels deep
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_TRUE(tree.Begin() == tree.End());
+
+  std::vector<int64_t> keys(500);
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = static_cast<int64_t>(i) * 2;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (int64_t key : keys) {
+    EXPECT_TRUE(tree.Insert(MakeKey(key), MakeRID(key)));
+  }
+  EXPECT_FALSE(tree.Insert(MakeKey(keys[0]), MakeRID(keys[0])));
+
+  for (int64_t key = 0; key < 1000; key++) {
+    std::vector<RID> result;
+    EXPECT_EQ(key % 2 == 0, tree.GetValue(MakeKey(key), &result)) << key;
+    if (key % 2 == 0) {
+      ASSERT_EQ(1, result.size());
+      EXPECT_EQ(MakeRID(key), result[0]);
+    }
+  }
+
+  // the leaves are scanned in key order, from any key on
+  std::vector<int64_t> scanned = ScanKeys(&tree, 0);
+  ASSERT_EQ(500, scanned.size());
+  EXPECT_TRUE(std::is_sorted(scanned.begin(), scanned.end()));
+  scanned = ScanKeys(&tree, 501);
+  ASSERT_EQ(249, scanned.size());
+  EXPECT_EQ(502, scanned[0]);
+  EXPECT_TRUE(ScanKeys(&tree, 999).empty());
+
+  // remove every other key, the pages borrow from and merge with their siblings
+  for (int64_t key : keys) {
+    if (key % 4 == 0) {
+      tree.Remove(MakeKey(key));
+    }
+  }
+  tree.Remove(MakeKey(1));
+  scanned = ScanKeys(&tree, 0);
+  ASSERT_EQ(250, scanned.size());
+  for (size_t i = 0; i < scanned.size(); i++) {
+    EXPECT_EQ(static_cast<int64_t>(i) * 4 + 2, scanned[i]);
+  }
+
+  for (int64_t key : keys) {
+    tree.Remove(MakeKey(key));
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_TRUE(tree.Begin() == tree.End());
+  EXPECT_TRUE(tree.Insert(MakeKey(7), MakeRID(7)));
+  EXPECT_EQ(std::vector<int64_t>{7}, ScanKeys(&tree, 0));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  Schema key_schema({Column("a", TypeId::BIGINT)});
+  GenericComparator<8> comparator(&key_schema);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+
+  // Four threads insert interleaved keys, then remove half of them while scans run alongside.
+  const int num_threads = 4;
+  const int per_thread = 1000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&tree, tid]() {
+      for (int64_t key = tid; key < num_threads * per_thread; key += num_threads) {
+        EXPECT_TRUE(tree.Insert(MakeKey(key), MakeRID(key)));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<int64_t> scanned = ScanKeys(&tree, 0);
+  ASSERT_EQ(num_threads * per_thread, scanned.size());
+  for (size_t i = 0; i < scanned.size(); i++) {
+    EXPECT_EQ(static_cast<int64_t>(i), scanned[i]);
+  }
+
+  threads.clear();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&tree, tid]() {
+      for (int64_t key = tid; key < num_threads * per_thread; key += num_threads) {
+        if (key % 2 == 1) {
+          tree.Remove(MakeKey(key));
+        } else if (key % 64 == 0) {
+          std::vector<int64_t> keys = ScanKeys(&tree, key);
+          EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  scanned = ScanKeys(&tree, 0);
+  ASSERT_EQ(num_threads * per_thread / 2, scanned.size());
+  for (size_t i = 0; i < scanned.size(); i++) {
+    EXPECT_EQ(static_cast<int64_t>(i) * 2, scanned[i]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTest, BulkLoadTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  Schema key_schema({Column("a", TypeId::BIGINT)});
+  GenericComparator<8> comparator(&key_schema);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 5, 4);
+
+  std::vector<std::pair<GenericKey<8>, RID>> items;
+  for (int64_t key = 0; key < 1000; key += 3) {
+    items.emplace_back(MakeKey(key), MakeRID(key));
+  }
+  std::vector<std::pair<GenericKey<8>, RID>> unsorted = items;
+  std::swap(unsorted[10], unsorted[20]);
+  EXPECT_FALSE(tree.BulkLoad(unsorted));
+  EXPECT_TRUE(tree.IsEmpty());
+
+  EXPECT_TRUE(tree.BulkLoad(items));
+  EXPECT_FALSE(tree.BulkLoad(items));
+  std::vector<int64_t> scanned = ScanKeys(&tree, 0);
+  ASSERT_EQ(items.size(), scanned.size());
+  for (size_t i = 0; i < scanned.size(); i++) {
+    EXPECT_EQ(static_cast<int64_t>(i) * 3, scanned[i]);
+  }
+
+  // the loaded tree takes inserts and removes like any other
+  for (int64_t key = 1; key < 1000; key += 3) {
+    EXPECT_TRUE(tree.Insert(MakeKey(key), MakeRID(key)));
+  }
+  for (int64_t key = 0; key < 1000; key += 3) {
+    tree.Remove(MakeKey(key));
+  }
+  scanned = ScanKeys(&tree, 0);
+  ASSERT_EQ(333, scanned.size());
+  for (size_t i = 0; i < scanned.size(); i++) {
+    EXPECT_EQ(static_cast<int64_t>(i) * 3 + 1, scanned[i]);
+    std::vector<RID> result;
+    EXPECT_TRUE(tree.GetValue(MakeKey(scanned[i]), &result));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTest, NormalizedKeyTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  Schema key_schema({Column("a", TypeId::INTEGER), Column("b", TypeId::BIGINT)});
+  EXPECT_TRUE(GenericKey<16>::FitsNormalized(key_schema));
+  EXPECT_FALSE(GenericKey<8>::FitsNormalized(key_schema));
+  Schema varchar_schema({Column("a", TypeId::INTEGER), Column("b", TypeId::VARCHAR, 8)});
+  EXPECT_FALSE(GenericKey<64>::FitsNormalized(varchar_schema));
+  GenericComparator<16> comparator(&key_schema, true);
+
+  // Keys of negative and positive numbers, which memcmp() would misorder in their native form.
+  std::vector<std::pair<int32_t, int64_t>> values;
+  for (int32_t a : {-100000, -256, -1, 0, 1, 256, 100000}) {
+    for (int64_t b : {INT64_C(-4294967296), INT64_C(-1), INT64_C(0), INT64_C(255), INT64_C(4294967296)}) {
+      values.emplace_back(a, b);
+    }
+  }
+  std::vector<Tuple> tuples;
+  std::vector<GenericKey<16>> keys(values.size() + 1);
+  for (size_t i = 0; i < values.size(); i++) {
+    tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(values[i].first),
+                                           ValueFactory::GetBigIntValue(values[i].second)},
+                        &key_schema);
+    keys[i].SetFromNormalizedKey(tuples.back(), &key_schema);
+  }
+  Tuple null_tuple({ValueFactory::GetIntegerValue(0), ValueFactory::GetNullValueByType(TypeId::BIGINT)}, &key_schema);
+  keys.back().SetFromNormalizedKey(null_tuple, &key_schema);
+
+  // The keys compare by memcmp() like their values, and a null comes before any number.
+  for (size_t i = 0; i < values.size(); i++) {
+    for (size_t j = 0; j < values.size(); j++) {
+      const int expected = values[i] < values[j] ? -1 : (values[j] < values[i] ? 1 : 0);
+      const int result = comparator(keys[i], keys[j]);
+      EXPECT_EQ(expected, (result > 0) - (result < 0)) << i << " " << j;
+    }
+  }
+  // (0, null) falls between (-1, 4294967296) and (0, -4294967296).
+  EXPECT_GT(comparator(keys.back(), keys[14]), 0);
+  EXPECT_LT(comparator(keys.back(), keys[15]), 0);
+
+  // A tree of the keys scans them in order.
+  BPlusTree<GenericKey<16>, RID, GenericComparator<16>> tree("foo_pk", bpm, comparator, 4, 4);
+  std::vector<size_t> order(values.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(15445));
+  for (size_t i : order) {
+    EXPECT_TRUE(tree.Insert(keys[i], RID(0, static_cast<uint32_t>(i))));
+  }
+  std::vector<uint32_t> scanned;
+  for (auto it = tree.Begin(); it != tree.End(); ++it) {
+    scanned.push_back((*it).second.GetSlotNum());
+  }
+  ASSERT_EQ(values.size(), scanned.size());
+  for (size_t i = 0; i < scanned.size(); i++) {
+    EXPECT_EQ(i, scanned[i]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTest, IntegerKeyTest) {
+  Schema schema({Column("s", TypeId::VARCHAR, 8), Column("a", TypeId::SMALLINT), Column("b", TypeId::BIGINT),
+                 Column("c", TypeId::INTEGER)});
+  const std::vector<uint32_t> key_attrs{3, 1, 2};
+  std::unique_ptr<Schema> key_schema(Schema::CopySchema(&schema, key_attrs));
+  GenericComparator<16> comparator(key_schema.get());
+  EXPECT_TRUE(comparator.IsInteger());
+  Schema varchar_schema({Column("a", TypeId::INTEGER), Column("b", TypeId::VARCHAR, 8)});
+  EXPECT_FALSE(GenericComparator<16>(&varchar_schema).IsInteger());
+
+  std::vector<std::tuple<int32_t, int16_t, int64_t>> values;
+  for (int32_t c : {-70000, 0, 70000}) {
+    for (int16_t a : {-300, -1, 1, 300}) {
+      for (int64_t b : {INT64_C(-4294967296), INT64_C(0), INT64_C(4294967296)}) {
+        values.emplace_back(c, a, b);
+      }
+    }
+  }
+  std::vector<GenericKey<16>> keys(values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    const auto &[c, a, b] = values[i];
+    Tuple tuple({ValueFactory::GetVarcharValue("row"), ValueFactory::GetSmallIntValue(a),
+                 ValueFactory::GetBigIntValue(b), ValueFactory::GetIntegerValue(c)},
+                &schema);
+    // The key copied out of the tuple is the one that its values make.
+    Tuple key = tuple.KeyFromTuple(schema, *key_schema, key_attrs);
+    Tuple expected_key({ValueFactory::GetIntegerValue(c), ValueFactory::GetSmallIntValue(a),
+                        ValueFactory::GetBigIntValue(b)},
+                       key_schema.get());
+    ASSERT_EQ(expected_key.GetLength(), key.GetLength());
+    EXPECT_EQ(0, memcmp(expected_key.GetData(), key.GetData(), key.GetLength()));
+    keys[i].SetFromKey(key);
+  }
+
+  // The keys compare in place like their values.
+  for (size_t i = 0; i < values.size(); i++) {
+    for (size_t j = 0; j < values.size(); j++) {
+      const int expected = values[i] < values[j] ? -1 : (values[j] < values[i] ? 1 : 0);
+      EXPECT_EQ(expected, comparator(keys[i], keys[j])) << i << " " << j;
+    }
+  }
+
+  // A null is neither less nor greater than a number, as when its values are compared, so the next column decides.
+  GenericKey<16> null_key;
+  null_key.SetFromKey(Tuple({ValueFactory::GetIntegerValue(0), ValueFactory::GetNullValueByType(TypeId::SMALLINT),
+                             ValueFactory::GetBigIntValue(0)},
+                            key_schema.get()));
+  EXPECT_EQ(1, comparator(null_key, keys[11]));
+  EXPECT_EQ(1, comparator(null_key, keys[12]));
+  EXPECT_EQ(0, comparator(null_key, keys[22]));
+  EXPECT_EQ(-1, comparator(null_key, keys[23]));
+  EXPECT_EQ(0, comparator(null_key, null_key));
+}
+
+}  // namespace bustub
@@ -0,0 +1,761 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_test.cpp
+//
+// Identification: test/storage/disk_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/frame_arena.h"
+#include "common/util/crc32c.h"
+#include "common/util/lz_compressor.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, DirectIOTest) {
+  const std::string db_name = "test.db";
+  remove(db_name.c_str());
+
+  auto *disk_manager = new DiskManager(db_name, DiskIOMode::DIRECT);
+  // File systems without O_DIRECT support fall back to buffered I/O, the pages must round-trip either way.
+  EXPECT_TRUE(disk_manager->GetIOMode() == DiskIOMode::DIRECT || disk_manager->GetIOMode() == DiskIOMode::BUFFERED);
+
+  // Scenario: aligned buffers, as handed out by the buffer pool, are read and written in place.
+  FrameArena arena(2);
+  snprintf(arena.GetFrame(0), PAGE_SIZE, "Aligned page");
+  disk_manager->WritePage(0, arena.GetFrame(0));
+  disk_manager->ReadPage(0, arena.GetFrame(1));
+  EXPECT_EQ(0, memcmp(arena.GetFrame(0), arena.GetFrame(1), PAGE_SIZE));
+
+  // Scenario: unaligned buffers go through a bounce buffer.
+  auto unaligned = std::make_unique<char[]>(PAGE_SIZE + 1);
+  snprintf(unaligned.get() + 1, PAGE_SIZE, "Unaligned page");
+  disk_manager->WritePage(1, unaligned.get() + 1);
+  char buf[PAGE_SIZE + 1];
+  disk_manager->ReadPage(1, buf + 1);
+  EXPECT_EQ("Unaligned page", std::string(buf + 1));
+  EXPECT_EQ(2, disk_manager->GetNumWrites());
+  EXPECT_EQ(2, disk_manager->GetNumPagesOnDisk());
+
+  // Scenario: pages past the end of the file read as zeroes.
+  memset(buf, 1, sizeof(buf));
+  disk_manager->ReadPage(5, buf);
+  if (disk_manager->GetIOMode() == DiskIOMode::DIRECT) {
+    EXPECT_EQ(0, buf[0]);
+    EXPECT_EQ(0, buf[PAGE_SIZE - 1]);
+  }
+
+  // Scenario: a buffered disk manager reads what the direct one wrote.
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  disk_manager->ReadPage(0, buf);
+  EXPECT_EQ("Aligned page", std::string(buf));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, AsyncIOTest) {
+  const std::string db_name = "test.db";
+  const size_t num_pages = 2 * IO_URING_QUEUE_DEPTH;
+  remove(db_name.c_str());
+
+  for (auto io_mode : {DiskIOMode::DIRECT, DiskIOMode::BUFFERED}) {
+    auto *disk_manager = new DiskManager(db_name, io_mode);
+    FrameArena arena(2 * num_pages);
+
+    // Scenario: more writes than the queue holds are in flight at once, each one lands on its page.
+    std::vector<std::future<bool>> writes;
+    for (size_t i = 0; i < num_pages; i++) {
+      snprintf(arena.GetFrame(i), PAGE_SIZE, "Page %zu", i);
+      writes.push_back(disk_manager->WritePageAsync(i, arena.GetFrame(i)));
+    }
+    for (auto &write : writes) {
+      EXPECT_TRUE(write.get());
+    }
+
+    // Scenario: reads complete into their own buffers, also from several threads at once.
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 2; t++) {
+      threads.emplace_back([&, t] {
+        std::vector<std::future<bool>> reads;
+        for (size_t i = t; i < num_pages; i += 2) {
+          reads.push_back(disk_manager->ReadPageAsync(i, arena.GetFrame(num_pages + i)));
+        }
+        for (auto &read : reads) {
+          EXPECT_TRUE(read.get());
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    for (size_t i = 0; i < num_pages; i++) {
+      EXPECT_EQ("Page " + std::to_string(i), std::string(arena.GetFrame(num_pages + i)));
+    }
+
+    disk_manager->ShutDown();
+    remove(db_name.c_str());
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, ConcurrentIOTest) {
+  const std::string db_name = "test.db";
+  const size_t num_threads = 4;
+  const size_t num_pages = 64;
+  remove(db_name.c_str());
+
+  for (auto io_mode : {DiskIOMode::BUFFERED, DiskIOMode::DIRECT}) {
+    auto *disk_manager = new DiskManager(db_name, io_mode);
+
+    // Scenario: threads write and read back interleaved pages at the same time, nothing ends up at a wrong offset.
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t] {
+        char data[PAGE_SIZE];
+        char buffer[PAGE_SIZE];
+        for (size_t round = 0; round < 4; round++) {
+          for (size_t i = t; i < num_pages; i += num_threads) {
+            memset(data, 0, PAGE_SIZE);
+            snprintf(data, PAGE_SIZE, "Page %zu round %zu", i, round);
+            disk_manager->WritePage(i, data);
+            disk_manager->ReadPage(i, buffer);
+            EXPECT_EQ(0, memcmp(data, buffer, PAGE_SIZE));
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    // Scenario: a batch with a gap, a page past the end of the file and a mix of aligned and unaligned buffers.
+    FrameArena arena(4);
+    std::vector<char> unaligned(PAGE_SIZE + 1);
+    std::vector<page_id_t> page_ids{1, 2, 3, 7, 8, static_cast<page_id_t>(num_pages) + 1};
+    std::vector<char *> page_data{arena.GetFrame(0), arena.GetFrame(1), unaligned.data() + 1,
+                                  arena.GetFrame(2), arena.GetFrame(3), unaligned.data() + 1};
+    std::vector<char> past_end(PAGE_SIZE + 1, 'x');
+    page_data[5] = past_end.data() + 1;
+    disk_manager->ReadPages(page_ids, page_data);
+    for (size_t i = 0; i < 5; i++) {
+      EXPECT_EQ("Page " + std::to_string(page_ids[i]) + " round 3", std::string(page_data[i]));
+    }
+    EXPECT_EQ(static_cast<size_t>(PAGE_SIZE), std::count(past_end.begin() + 1, past_end.end(), 0));
+
+    // Scenario: a batch of writes with a run of pages that an unaligned buffer splits, and a single page.
+    page_ids = {4, 5, 6, 7, 20};
+    std::vector<const char *> write_data{arena.GetFrame(0), arena.GetFrame(1), unaligned.data() + 1,
+                                         arena.GetFrame(2), arena.GetFrame(3)};
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      char *data = const_cast<char *>(write_data[i]);
+      memset(data, 0, PAGE_SIZE);
+      snprintf(data, PAGE_SIZE, "Page %d round 4", page_ids[i]);
+    }
+    const int num_writes = disk_manager->GetNumWrites();
+    disk_manager->WritePages(page_ids, write_data);
+    disk_manager->SyncPages();
+    EXPECT_EQ(num_writes + static_cast<int>(page_ids.size()), disk_manager->GetNumWrites());
+    char buffer[PAGE_SIZE];
+    for (page_id_t page_id : page_ids) {
+      disk_manager->ReadPage(page_id, buffer);
+      EXPECT_EQ("Page " + std::to_string(page_id) + " round 4", std::string(buffer));
+    }
+    EXPECT_EQ(0, disk_manager->GetNumChecksumFailures());
+
+    disk_manager->ShutDown();
+    remove(db_name.c_str());
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, FreeSpaceMapTest) {
+  const std::string db_name = "test.db";
+  const std::string map_name = "test.fsm";
+  remove(db_name.c_str());
+  remove(map_name.c_str());
+
+  auto *disk_manager = new DiskManager(db_name);
+  for (page_id_t i = 0; i < 10; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+  }
+
+  // Scenario: deallocated pages are handed out again before new ones, pages that are not allocated are ignored.
+  disk_manager->DeallocatePage(4);
+  disk_manager->DeallocatePage(3);
+  disk_manager->DeallocatePage(3);
+  disk_manager->DeallocatePage(100);
+  EXPECT_FALSE(disk_manager->IsPageAllocated(3));
+  EXPECT_EQ(3, disk_manager->AllocatePage());
+  EXPECT_EQ(4, disk_manager->AllocatePage());
+  EXPECT_EQ(10, disk_manager->AllocatePage());
+
+  // Scenario: a chain of pages fills a dedicated extent that other allocations stay out of, and continues into the
+  // next extent.
+  page_id_t page_id = disk_manager->AllocateExtentPage(INVALID_PAGE_ID);
+  EXPECT_EQ(EXTENT_SIZE, page_id);
+  EXPECT_EQ(11, disk_manager->AllocatePage());
+  for (int i = 1; i <= EXTENT_SIZE; i++) {
+    page_id = disk_manager->AllocateExtentPage(page_id);
+    EXPECT_EQ(EXTENT_SIZE + i, page_id);
+  }
+  EXPECT_EQ(2 * EXTENT_SIZE + 1, disk_manager->GetNumAllocatedPages());
+
+  // Scenario: page ids are split into classes, every class allocates its own, also in dedicated extents.
+  EXPECT_EQ(13, disk_manager->AllocatePage(4, 1));
+  EXPECT_EQ(17, disk_manager->AllocatePage(4, 1));
+  EXPECT_EQ(12, disk_manager->AllocatePage(4, 0));
+  EXPECT_EQ(3 * EXTENT_SIZE + 2, disk_manager->AllocateExtentPage(INVALID_PAGE_ID, 4, 2));
+  EXPECT_EQ(3 * EXTENT_SIZE + 3, disk_manager->AllocateExtentPage(3 * EXTENT_SIZE + 2, 4, 3));
+
+  // Scenario: an extent whose pages are all deallocated is reused before the file grows.
+  for (page_id_t i = EXTENT_SIZE; i <= 2 * EXTENT_SIZE; i++) {
+    disk_manager->DeallocatePage(i);
+  }
+  EXPECT_EQ(EXTENT_SIZE, disk_manager->AllocateExtentPage(INVALID_PAGE_ID));
+
+  // Scenario: the map survives a restart. Pages written after it was saved count as allocated.
+  char data[PAGE_SIZE] = "A page";
+  disk_manager->WritePage(3 * EXTENT_SIZE + 3, data);
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  disk_manager->WritePage(4 * EXTENT_SIZE, data);
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  EXPECT_TRUE(disk_manager->IsPageAllocated(4));
+  EXPECT_FALSE(disk_manager->IsPageAllocated(EXTENT_SIZE + 1));
+  EXPECT_TRUE(disk_manager->IsPageAllocated(4 * EXTENT_SIZE));
+  EXPECT_EQ(4 * EXTENT_SIZE + 1, disk_manager->GetNumAllocatedPages());
+  EXPECT_EQ(EXTENT_SIZE + 1, disk_manager->AllocateExtentPage(EXTENT_SIZE));
+  EXPECT_EQ(14, disk_manager->AllocatePage());
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: a page that was allocated and written survives a crash, i.e. a restart without a shutdown, even if it
+  // lies within the map that was saved before. So does a page that the log names, e.g. after recovery marks it.
+  disk_manager = new DiskManager(db_name);
+  page_id = disk_manager->AllocatePage();
+  EXPECT_EQ(15, page_id);
+  disk_manager->WritePage(page_id, data);
+  disk_manager->DeallocatePage(13);
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  EXPECT_TRUE(disk_manager->IsPageAllocated(15));
+  EXPECT_TRUE(disk_manager->IsPageAllocated(13));
+  EXPECT_FALSE(disk_manager->IsPageAllocated(16));
+  disk_manager->MarkPageAllocated(16);
+  disk_manager->MarkPageAllocated(6 * EXTENT_SIZE + 5);
+  EXPECT_TRUE(disk_manager->IsPageAllocated(16));
+  EXPECT_TRUE(disk_manager->IsPageAllocated(6 * EXTENT_SIZE + 5));
+  EXPECT_EQ(18, disk_manager->AllocatePage());
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: the map of a database file that was removed is not loaded.
+  remove(db_name.c_str());
+  disk_manager = new DiskManager(db_name);
+  EXPECT_EQ(0, disk_manager->AllocatePage());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove(map_name.c_str());
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, ChecksumTest) {
+  const std::string db_name = "test.db";
+  remove(db_name.c_str());
+  EXPECT_EQ(0xe3069283, Crc32c::Value("123456789", 9));
+  EXPECT_EQ(Crc32c::Value("123456789", 9), Crc32c::Extend(Crc32c::Value("1234", 4), "56789", 5));
+
+  auto *disk_manager = new DiskManager(db_name);
+  FrameArena arena(3);
+  char *buffer = arena.GetFrame(0);
+  char data[PAGE_SIZE];
+  for (page_id_t i = 0; i < 3; i++) {
+    memset(data, 'a' + i, PAGE_SIZE);
+    disk_manager->WritePage(i, data);
+  }
+
+  // Scenario: intact pages and pages that were never written pass.
+  EXPECT_TRUE(disk_manager->ReadPage(1, buffer));
+  EXPECT_TRUE(disk_manager->ReadPage(10, buffer));
+  EXPECT_EQ(0, disk_manager->GetNumChecksumFailures());
+
+  // Scenario: a flipped byte on disk is caught and reported by every way of reading the page.
+  int fd = open(db_name.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(1, pwrite(fd, "x", 1, PAGE_SIZE + 100));
+  close(fd);
+  EXPECT_FALSE(disk_manager->ReadPage(1, buffer));
+  EXPECT_EQ(1, disk_manager->GetNumChecksumFailures());
+  EXPECT_EQ(std::vector<bool>({true, false, true}),
+            disk_manager->ReadPages({0, 1, 2}, {arena.GetFrame(1), buffer, arena.GetFrame(2)}));
+  EXPECT_EQ(2, disk_manager->GetNumChecksumFailures());
+  EXPECT_FALSE(disk_manager->ReadPageAsync(1, buffer).get());
+  EXPECT_EQ(3, disk_manager->GetNumChecksumFailures());
+
+  // Scenario: with verification turned off, nothing is checked.
+  disk_manager->SetVerifyChecksums(false);
+  EXPECT_TRUE(disk_manager->ReadPage(1, buffer));
+  EXPECT_EQ(3, disk_manager->GetNumChecksumFailures());
+  disk_manager->SetVerifyChecksums(true);
+
+  // Scenario: the checksums survive a restart, and rewriting the page fixes it.
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  disk_manager->ReadPage(1, buffer);
+  EXPECT_EQ(1, disk_manager->GetNumChecksumFailures());
+  disk_manager->WritePage(1, buffer);
+  EXPECT_TRUE(disk_manager->ReadPage(1, buffer));
+  EXPECT_TRUE(disk_manager->ReadPage(2, buffer));
+  EXPECT_EQ(1, disk_manager->GetNumChecksumFailures());
+
+  // Scenario: a crash may leave the checksum of a write on disk without the page. The previous version of the page
+  // still passes, the one before it does not.
+  char old_data[PAGE_SIZE];
+  memset(old_data, 'c', PAGE_SIZE);
+  memset(data, 'y', PAGE_SIZE);
+  disk_manager->WritePage(2, data);
+  fd = open(db_name.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(PAGE_SIZE, pwrite(fd, old_data, PAGE_SIZE, 2 * PAGE_SIZE));
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  EXPECT_TRUE(disk_manager->ReadPage(2, buffer));
+  memset(data, 'z', PAGE_SIZE);
+  disk_manager->WritePage(2, data);
+  ASSERT_EQ(PAGE_SIZE, pwrite(fd, old_data, PAGE_SIZE, 2 * PAGE_SIZE));
+  close(fd);
+  EXPECT_FALSE(disk_manager->ReadPage(2, buffer));
+  EXPECT_EQ(1, disk_manager->GetNumChecksumFailures());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test.crc");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, CompressionTest) {
+  const std::string db_name = "test.db";
+  remove(db_name.c_str());
+  std::mt19937 rng(15445);
+  std::vector<char> zeros(PAGE_SIZE, 0);
+  std::vector<char> sparse(PAGE_SIZE, 0);
+  std::vector<char> noise(PAGE_SIZE);
+  for (int i = PAGE_SIZE - 300; i < PAGE_SIZE; i++) {
+    sparse[i] = static_cast<char>(i % 7);
+  }
+  snprintf(sparse.data(), PAGE_SIZE, "A short header at the start of the page");
+  std::generate(noise.begin(), noise.end(), [&rng] { return static_cast<char>(rng()); });
+
+  // Scenario: the compressor round-trips data, and gives up on data that does not fit.
+  char compressed[2 * PAGE_SIZE];
+  char decompressed[PAGE_SIZE];
+  for (const auto *data : {&zeros, &sparse, &noise}) {
+    size_t size = LzCompressor::Compress(data->data(), PAGE_SIZE, compressed, sizeof(compressed));
+    ASSERT_NE(0, size);
+    EXPECT_EQ(PAGE_SIZE, LzCompressor::Decompress(compressed, size, decompressed, PAGE_SIZE));
+    EXPECT_EQ(0, memcmp(data->data(), decompressed, PAGE_SIZE));
+  }
+  EXPECT_LT(LzCompressor::Compress(zeros.data(), PAGE_SIZE, compressed, sizeof(compressed)), 64);
+  EXPECT_EQ(0, LzCompressor::Compress(noise.data(), PAGE_SIZE, compressed, PAGE_SIZE / 2));
+  size_t size = LzCompressor::Compress(sparse.data(), PAGE_SIZE, compressed, sizeof(compressed));
+  EXPECT_GT(PAGE_SIZE, LzCompressor::Decompress(compressed, size / 2, decompressed, PAGE_SIZE));
+  EXPECT_EQ(0, LzCompressor::Decompress(compressed, size, decompressed, PAGE_SIZE / 2));
+
+  // Scenario: pages round-trip through a compressed database file that is much smaller than the pages.
+  auto *disk_manager = new DiskManager(db_name, DiskIOMode::BUFFERED, true);
+  EXPECT_TRUE(disk_manager->IsCompressed());
+  EXPECT_FALSE(disk_manager->IsAsyncIOAvailable());
+  const page_id_t num_pages = 100;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+    disk_manager->WritePage(i, sparse.data());
+  }
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat(db_name.c_str(), &stat_buf));
+  EXPECT_LE(stat_buf.st_size, num_pages * PAGE_SIZE / 4);
+  char buffer[PAGE_SIZE];
+  disk_manager->ReadPage(num_pages / 2, buffer);
+  EXPECT_EQ(0, memcmp(sparse.data(), buffer, PAGE_SIZE));
+
+  // Scenario: rewritten pages move to slots of their new size, and pages that were never written read as zeros.
+  disk_manager->WritePage(1, noise.data());
+  disk_manager->WritePage(2, zeros.data());
+  disk_manager->WritePage(3, noise.data());
+  disk_manager->WritePage(3, sparse.data());
+  disk_manager->ReadPage(num_pages, buffer);
+  EXPECT_EQ(0, memcmp(zeros.data(), buffer, PAGE_SIZE));
+  char pages[3][PAGE_SIZE];
+  disk_manager->ReadPages({1, 2, 3}, {pages[0], pages[1], pages[2]});
+  EXPECT_EQ(0, memcmp(noise.data(), pages[0], PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(zeros.data(), pages[1], PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(sparse.data(), pages[2], PAGE_SIZE));
+  EXPECT_EQ(num_pages, disk_manager->GetNumPagesOnDisk());
+
+  // Scenario: concurrent writers of different pages and readers of the same pages always see whole pages.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      char page[PAGE_SIZE];
+      for (int i = 0; i < 50; i++) {
+        const page_id_t page_id = 10 + t;
+        disk_manager->WritePage(page_id, (i % 2 == 0 ? noise : sparse).data());
+        disk_manager->ReadPage(20 + t, page);
+        EXPECT_EQ(0, memcmp(sparse.data(), page, PAGE_SIZE));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, disk_manager->GetNumChecksumFailures());
+
+  // Scenario: after a restart the slots are found again, with the latest version of every page.
+  disk_manager->DeallocatePage(num_pages - 1);
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name, DiskIOMode::DIRECT, true);
+  EXPECT_EQ(DiskIOMode::BUFFERED, disk_manager->GetIOMode());
+  disk_manager->ReadPages({1, 2, 3}, {pages[0], pages[1], pages[2]});
+  EXPECT_EQ(0, memcmp(noise.data(), pages[0], PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(zeros.data(), pages[1], PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(sparse.data(), pages[2], PAGE_SIZE));
+  for (page_id_t i = 10; i < 14; i++) {
+    disk_manager->ReadPage(i, buffer);
+    EXPECT_EQ(0, memcmp(sparse.data(), buffer, PAGE_SIZE));
+  }
+  EXPECT_FALSE(disk_manager->IsPageAllocated(num_pages - 1));
+  EXPECT_EQ(0, disk_manager->GetNumChecksumFailures());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test.crc");
+  remove("test.fsm");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, SegmentTest) {
+  const std::string db_name = "test.db";
+  const std::vector<std::string> stripe_dirs = {"test_stripe_0", "test_stripe_1"};
+  remove(db_name.c_str());
+  for (const auto &dir : stripe_dirs) {
+    mkdir(dir.c_str(), 0755);
+  }
+  // Pages past the 8 GB that 32 bit offsets could address.
+  const std::vector<page_id_t> page_ids = {0, SEGMENT_SIZE - 1, SEGMENT_SIZE, 2 * SEGMENT_SIZE + 5, 9 * SEGMENT_SIZE};
+  auto *disk_manager = new DiskManager(db_name, DiskIOMode::BUFFERED, false, stripe_dirs);
+  char data[PAGE_SIZE];
+  for (page_id_t page_id : page_ids) {
+    snprintf(data, PAGE_SIZE, "page %d", page_id);
+    disk_manager->WritePage(page_id, data);
+  }
+  EXPECT_EQ(9 * SEGMENT_SIZE + 1, disk_manager->GetNumPagesOnDisk());
+
+  // Scenario: the segment files are spread over the stripe directories round-robin.
+  struct stat stat_buf;
+  EXPECT_EQ(0, stat("test_stripe_1/test.db.1", &stat_buf));
+  EXPECT_EQ(0, stat("test_stripe_0/test.db.2", &stat_buf));
+  EXPECT_EQ(0, stat("test_stripe_1/test.db.9", &stat_buf));
+  EXPECT_NE(0, stat("test.db.1", &stat_buf));
+
+  // Scenario: pages round-trip on either side of a segment boundary, for single and batched reads, and pages past
+  // the last segment read as zeros.
+  auto check = [&](DiskManager *dm) {
+    char buffer[PAGE_SIZE];
+    char pages[2][PAGE_SIZE];
+    for (page_id_t page_id : page_ids) {
+      snprintf(data, PAGE_SIZE, "page %d", page_id);
+      dm->ReadPage(page_id, buffer);
+      EXPECT_STREQ(data, buffer);
+    }
+    dm->ReadPages({SEGMENT_SIZE - 1, SEGMENT_SIZE}, {pages[0], pages[1]});
+    snprintf(data, PAGE_SIZE, "page %d", SEGMENT_SIZE - 1);
+    EXPECT_STREQ(data, pages[0]);
+    snprintf(data, PAGE_SIZE, "page %d", SEGMENT_SIZE);
+    EXPECT_STREQ(data, pages[1]);
+    EXPECT_TRUE(dm->ReadPageAsync(2 * SEGMENT_SIZE + 5, buffer).get());
+    snprintf(data, PAGE_SIZE, "page %d", 2 * SEGMENT_SIZE + 5);
+    EXPECT_STREQ(data, buffer);
+    dm->ReadPage(20 * SEGMENT_SIZE, buffer);
+    EXPECT_EQ(0, buffer[0]);
+    EXPECT_EQ(0, dm->GetNumChecksumFailures());
+  };
+  check(disk_manager);
+
+  // Scenario: the segment files are found again after a restart.
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name, DiskIOMode::BUFFERED, false, stripe_dirs);
+  EXPECT_EQ(9 * SEGMENT_SIZE + 1, disk_manager->GetNumPagesOnDisk());
+  check(disk_manager);
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(db_name.c_str());
+  remove("test.crc");
+  remove("test.fsm");
+  for (size_t segment = 1; segment <= 9; segment++) {
+    remove((stripe_dirs[segment % 2] + "/test.db." + std::to_string(segment)).c_str());
+  }
+  for (const auto &dir : stripe_dirs) {
+    rmdir(dir.c_str());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, TieringTest) {
+  const std::string db_name = "test.db";
+  const std::string capacity_dir = "test_capacity";
+  remove(db_name.c_str());
+  mkdir(capacity_dir.c_str(), 0755);
+  // The test migrates by hand.
+  const auto interval = tier_migration_interval;
+  tier_migration_interval = std::chrono::hours(1);
+  auto *disk_manager = new DiskManager(db_name, DiskIOMode::BUFFERED, false, {}, capacity_dir);
+  ASSERT_TRUE(disk_manager->IsTiered());
+  char data[PAGE_SIZE];
+  for (int i = 0; i <= EXTENT_SIZE; i++) {
+    const page_id_t page_id = disk_manager->AllocatePage();
+    snprintf(data, PAGE_SIZE, "page %d", page_id);
+    disk_manager->WritePage(page_id, data);
+  }
+
+  // Scenario: an extent that is no longer accessed is demoted after a few passes, one that is stays.
+  for (int pass = 0; pass < 10 && !disk_manager->IsExtentCold(0); pass++) {
+    disk_manager->RecordPageAccesses(EXTENT_SIZE, 2);
+    disk_manager->MigrateExtents();
+  }
+  EXPECT_TRUE(disk_manager->IsExtentCold(0));
+  EXPECT_FALSE(disk_manager->IsExtentCold(1));
+  struct stat stat_buf;
+  EXPECT_EQ(0, stat((capacity_dir + "/test.db.cold.0").c_str(), &stat_buf));
+
+  // Scenario: the pages of either tier read back as written, also in a batch across the extents, and can be
+  // rewritten in the capacity tier.
+  auto check = [&](DiskManager *dm) {
+    char buffer[PAGE_SIZE];
+    char pages[2][PAGE_SIZE];
+    for (page_id_t page_id = 0; page_id <= EXTENT_SIZE; page_id++) {
+      snprintf(data, PAGE_SIZE, page_id == 3 ? "page %d again" : "page %d", page_id);
+      dm->ReadPage(page_id, buffer);
+      EXPECT_STREQ(data, buffer);
+    }
+    dm->ReadPages({EXTENT_SIZE - 1, EXTENT_SIZE}, {pages[0], pages[1]});
+    snprintf(data, PAGE_SIZE, "page %d", EXTENT_SIZE - 1);
+    EXPECT_STREQ(data, pages[0]);
+    snprintf(data, PAGE_SIZE, "page %d", EXTENT_SIZE);
+    EXPECT_STREQ(data, pages[1]);
+    EXPECT_EQ(0, dm->GetNumChecksumFailures());
+  };
+  snprintf(data, PAGE_SIZE, "page %d again", 3);
+  disk_manager->WritePage(3, data);
+  check(disk_manager);
+
+  // Scenario: the tiers of the extents are found again after a restart.
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name, DiskIOMode::BUFFERED, false, {}, capacity_dir);
+  EXPECT_TRUE(disk_manager->IsExtentCold(0));
+  check(disk_manager);
+
+  // Scenario: an extent that is accessed again, e.g. by hits in the buffer pool, is promoted back.
+  disk_manager->RecordPageAccesses(0, TIER_PROMOTE_HEAT);
+  EXPECT_LE(1, disk_manager->MigrateExtents());
+  EXPECT_FALSE(disk_manager->IsExtentCold(0));
+  check(disk_manager);
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+  tier_migration_interval = interval;
+  remove(db_name.c_str());
+  remove("test.crc");
+  remove("test.fsm");
+  remove("test.tier");
+  remove((capacity_dir + "/test.db.cold.0").c_str());
+  rmdir(capacity_dir.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, LogCompressionTest) {
+  const std::string db_name = "test.db";
+  remove(db_name.c_str());
+  remove("test.log");
+  auto *disk_manager = new DiskManager(db_name);
+
+  // Scenario: repetitive log data is written as compressed blocks, random data as it is.
+  std::vector<std::vector<char>> buffers(4, std::vector<char>(8192));
+  std::mt19937 generator(7);
+  for (size_t i = 0; i < buffers.size(); i++) {
+    for (size_t j = 0; j < buffers[i].size(); j++) {
+      buffers[i][j] = i == 2 ? static_cast<char>(generator()) : static_cast<char>('a' + i + j % 16);
+    }
+  }
+  disk_manager->WriteLog(buffers[0].data(), 8192);
+  disk_manager->SetCompressLog(true);
+  disk_manager->WriteLog(buffers[1].data(), 8192);
+  disk_manager->WriteLog(buffers[2].data(), 8192);
+  disk_manager->WriteLog(buffers[3].data(), 8192);
+  const int64_t block_start = 8192;
+  EXPECT_LT(disk_manager->GetLogSize(), 3 * 8192);
+
+  // Reads at a block return the compressed blocks that follow it decompressed, other reads return the log as it is.
+  std::vector<char> data(4 * 8192);
+  int read_size;
+  int64_t next_offset;
+  ASSERT_TRUE(disk_manager->ReadLog(data.data(), 4096, 4096, &read_size, &next_offset));
+  EXPECT_EQ(4096, read_size);
+  EXPECT_EQ(block_start, next_offset);
+  EXPECT_EQ(0, memcmp(data.data(), buffers[0].data() + 4096, 4096));
+  ASSERT_TRUE(disk_manager->ReadLog(data.data(), static_cast<int>(data.size()), block_start, &read_size, &next_offset));
+  EXPECT_EQ(8192, read_size);
+  EXPECT_LT(next_offset, block_start + 8192);
+  EXPECT_EQ(0, memcmp(data.data(), buffers[1].data(), 8192));
+  ASSERT_TRUE(disk_manager->ReadLog(data.data(), 8192, next_offset, &read_size, &next_offset));
+  EXPECT_EQ(8192, read_size);
+  EXPECT_EQ(0, memcmp(data.data(), buffers[2].data(), 8192));
+  const int64_t last_block = next_offset;
+  ASSERT_TRUE(disk_manager->ReadLog(data.data(), static_cast<int>(data.size()), last_block, &read_size, &next_offset));
+  EXPECT_EQ(8192, read_size);
+  EXPECT_EQ(0, memcmp(data.data(), buffers[3].data(), 8192));
+  EXPECT_EQ(disk_manager->GetLogSize(), next_offset);
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: a block torn by a crash is not decompressed.
+  const int64_t log_size = next_offset;
+  ASSERT_EQ(0, truncate("test.log", log_size - 1));
+  disk_manager = new DiskManager(db_name);
+  ASSERT_TRUE(disk_manager->ReadLog(data.data(), static_cast<int>(data.size()), last_block, &read_size, &next_offset));
+  EXPECT_EQ(log_size - 1 - last_block, read_size);
+  EXPECT_NE(0, memcmp(data.data(), buffers[3].data(), 8192));
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(db_name.c_str());
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerTest, LogSegmentTest) {
+  const std::string db_name = "test.db";
+  const std::vector<std::string> log_names = {"test.log", "test.log.1", "test.log.2", "test.log.3"};
+  remove(db_name.c_str());
+  remove("test.master");
+  for (const auto &log_name : log_names) {
+    remove(log_name.c_str());
+  }
+  auto file_size = [](const std::string &file_name) {
+    struct stat stat_buf;
+    return stat(file_name.c_str(), &stat_buf) == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
+  };
+
+  auto *disk_manager = new DiskManager(db_name);
+  // The log of a database file that is still empty would be started over on reopening.
+  char page[PAGE_SIZE] = "page";
+  disk_manager->WritePage(0, page);
+
+  // Two and a half segments, every chunk filled with its number.
+  const int chunk_size = 1 << 20;
+  const int64_t num_chunks = 5 * LOG_SEGMENT_SIZE / 2 / chunk_size;
+  std::vector<std::vector<char>> buffers(2, std::vector<char>(chunk_size));
+  for (int64_t chunk = 0; chunk < num_chunks; chunk++) {
+    auto &buffer = buffers[chunk % 2];
+    std::fill(buffer.begin(), buffer.end(), static_cast<char>(chunk));
+    disk_manager->WriteLog(buffer.data(), chunk_size);
+  }
+  EXPECT_EQ(num_chunks * chunk_size, disk_manager->GetLogSize());
+  EXPECT_EQ(LOG_SEGMENT_SIZE, file_size(log_names[0]));
+  EXPECT_EQ(LOG_SEGMENT_SIZE, file_size(log_names[1]));
+  EXPECT_EQ(LOG_SEGMENT_SIZE / 2, file_size(log_names[2]));
+
+  // A read across a segment boundary, and one that runs past the end of the log.
+  char data[20];
+  const int64_t chunks_per_segment = LOG_SEGMENT_SIZE / chunk_size;
+  ASSERT_TRUE(disk_manager->ReadLog(data, sizeof(data), LOG_SEGMENT_SIZE - 10));
+  EXPECT_EQ(static_cast<char>(chunks_per_segment - 1), data[9]);
+  EXPECT_EQ(static_cast<char>(chunks_per_segment), data[10]);
+  ASSERT_TRUE(disk_manager->ReadLog(data, sizeof(data), disk_manager->GetLogSize() - 5));
+  EXPECT_EQ(static_cast<char>(num_chunks - 1), data[4]);
+  EXPECT_EQ(0, data[5]);
+  EXPECT_FALSE(disk_manager->ReadLog(data, sizeof(data), disk_manager->GetLogSize()));
+
+  // Only whole segments before the checkpoint go.
+  disk_manager->WriteMasterRecord(1, LOG_SEGMENT_SIZE + 5, LOG_SEGMENT_SIZE + 5);
+  disk_manager->TruncateLog(LOG_SEGMENT_SIZE + 5);
+  EXPECT_EQ(-1, file_size(log_names[0]));
+  EXPECT_EQ(LOG_SEGMENT_SIZE, file_size(log_names[1]));
+  EXPECT_EQ(LOG_SEGMENT_SIZE, disk_manager->GetLogStartOffset());
+  EXPECT_FALSE(disk_manager->ReadLog(data, sizeof(data), 0));
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Reopening starts at the segment of the checkpoint and appends to the last one.
+  disk_manager = new DiskManager(db_name);
+  EXPECT_EQ(num_chunks * chunk_size, disk_manager->GetLogSize());
+  EXPECT_EQ(LOG_SEGMENT_SIZE, disk_manager->GetLogStartOffset());
+  lsn_t checkpoint_lsn;
+  int64_t redo_offset;
+  int64_t undo_offset;
+  ASSERT_TRUE(disk_manager->ReadMasterRecord(&checkpoint_lsn, &redo_offset, &undo_offset));
+  EXPECT_EQ(LOG_SEGMENT_SIZE + 5, redo_offset);
+  ASSERT_TRUE(disk_manager->ReadLog(data, sizeof(data), LOG_SEGMENT_SIZE));
+  EXPECT_EQ(static_cast<char>(chunks_per_segment), data[0]);
+  std::fill(buffers[0].begin(), buffers[0].end(), 'x');
+  disk_manager->WriteLog(buffers[0].data(), chunk_size);
+  EXPECT_EQ(LOG_SEGMENT_SIZE / 2 + chunk_size, file_size(log_names[2]));
+
+  // The segment that is written to is never truncated.
+  disk_manager->TruncateLog(disk_manager->GetLogSize());
+  EXPECT_EQ(-1, file_size(log_names[1]));
+  EXPECT_EQ(2 * LOG_SEGMENT_SIZE, disk_manager->GetLogStartOffset());
+  ASSERT_TRUE(disk_manager->ReadLog(data, sizeof(data), disk_manager->GetLogSize() - chunk_size));
+  EXPECT_EQ('x', data[0]);
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(db_name.c_str());
+  remove("test.master");
+  for (const auto &log_name : log_names) {
+    remove(log_name.c_str());
+  }
+}
+
+}  // namespace bustub
@@ -10,20 +10,19 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <filesystem>
+#include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
 #include "storage/page/tmp_tuple_page.h"
+#include "storage/table/tmp_tuple_run.h"
 #include "type/value_factory.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(TmpTuplePageTest, DISABLED_BasicTest) {
-  // There are many ways to do this assignment, and this is only one of them.
-  // If you don't like the TmpTuplePage idea, please feel free to delete this test case entirely.
-  // You will get full credit as long as you are correctly using a linear probe hash table.
-
+TEST(TmpTuplePageTest, BasicTest) {
   TmpTuplePage page{};
   page_id_t page_id = 15445;
   page.Init(page_id, PAGE_SIZE);
@@ -46,6 +45,74 @@ TEST(TmpTuplePageTest, DISABLED_BasicTest) {
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + sizeof(page_id_t) + sizeof(lsn_t)), PAGE_SIZE - 8);
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + PAGE_SIZE - 8), 4);
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + PAGE_SIZE - 4), 123);
+  ASSERT_EQ(page_id, tmp_tuple.GetPageId());
+  ASSERT_EQ(PAGE_SIZE - 8, tmp_tuple.GetOffset());
+  ASSERT_EQ(123, page.Get(tmp_tuple.GetOffset()).GetValue(&schema, 0).GetAs<int32_t>());
+
+  // the page takes tuples until it is full
+  size_t num_tuples = 1;
+  while (page.Insert(tuple, &tmp_tuple)) {
+    num_tuples++;
+  }
+  ASSERT_EQ((PAGE_SIZE - 12) / 8, num_tuples);
+}
+
+// NOLINTNEXTLINE
+TEST(TmpTuplePageTest, SpillFileRunTest) {
+  const std::string directory = "spill_test_dir";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directory(directory);
+  // Room for two block buffers, any further buffer is a page.
+  SpillFileManager spill_files(directory, 2 * SPILL_BLOCK_SIZE);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  columns.emplace_back("B", TypeId::VARCHAR, 64);
+  Schema schema(columns);
+  {
+    TmpTupleRun first(&spill_files);
+    TmpTupleRun second(&spill_files);
+    const int num_tuples = 20000;
+    for (int i = 0; i < num_tuples; i++) {
+      Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(i % 50, 'x'))},
+                  &schema);
+      first.Append(tuple);
+      second.Append(tuple);
+    }
+    // the files are unlinked at once, and their buffers do not come out of the buffer pool
+    EXPECT_TRUE(std::filesystem::is_empty(directory));
+    EXPECT_EQ(2 * SPILL_BLOCK_SIZE, spill_files.GetMemoryUsed());
+    TmpTupleRun third(&spill_files);
+    third.Append(Tuple({ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue("")}, &schema));
+    EXPECT_EQ(2 * SPILL_BLOCK_SIZE + PAGE_SIZE, spill_files.GetMemoryUsed());
+    first.Finish();
+    second.Finish();
+    third.Finish();
+    EXPECT_EQ(0, spill_files.GetMemoryUsed());
+    EXPECT_GT(first.GetNumPages(), SPILL_BLOCK_SIZE / PAGE_SIZE);
+
+    // both runs read back in the order of their appends, the first a block at a time and ahead, the second a page at a
+    // time
+    TmpTupleRun::Cursor first_cursor;
+    TmpTupleRun::Cursor second_cursor;
+    Tuple tuple;
+    for (int i = 0; i < num_tuples; i++) {
+      ASSERT_TRUE(first.Read(&first_cursor, &tuple));
+      ASSERT_EQ(i, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+      ASSERT_EQ(std::string(i % 50, 'x'), tuple.GetValue(&schema, 1).ToString());
+      ASSERT_TRUE(second.Read(&second_cursor, &tuple));
+      ASSERT_EQ(i, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    }
+    EXPECT_FALSE(first.Read(&first_cursor, &tuple));
+    EXPECT_FALSE(second.Read(&second_cursor, &tuple));
+
+    // a new cursor starts over
+    first_cursor = TmpTupleRun::Cursor();
+    ASSERT_TRUE(first.Read(&first_cursor, &tuple));
+    EXPECT_EQ(0, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  EXPECT_EQ(0, spill_files.GetMemoryUsed());
+  std::filesystem::remove_all(directory);
 }
 
 }  // namespace bustub
@@ -14,13 +14,19 @@
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "storage/page/overflow_page.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "storage/table/tuple_ref.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -71,4 +77,876 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, TableLockScanTest) {
+  Column col1{"a", TypeId::INTEGER};
+  std::vector<Column> cols{col1};
+  Schema schema{cols};
+  std::vector<Value> values{ValueFactory::GetIntegerValue(1)};
+  Tuple tuple{values, &schema};
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn0 = new Transaction(0);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn0, 0);
+  for (int i = 0; i < 100; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn0));
+  }
+
+  // Scenario: a scan under a shared table lock reads every row without locking it, one without takes a row lock each.
+  enable_logging = true;
+  auto *txn1 = new Transaction(1);
+  ASSERT_TRUE(table->LockTable(txn1, LockMode::SHARED));
+  int count = 0;
+  for (auto itr = table->Begin(txn1); itr != table->End(); ++itr) {
+    count++;
+  }
+  EXPECT_EQ(100, count);
+  EXPECT_TRUE(txn1->GetSharedLockSet()->empty());
+
+  auto *txn2 = new Transaction(2);
+  count = 0;
+  for (auto itr = table->Begin(txn2); itr != table->End(); ++itr) {
+    count++;
+  }
+  EXPECT_EQ(100, count);
+  EXPECT_EQ(100, txn2->GetSharedLockSet()->size());
+  EXPECT_EQ(LockMode::INTENTION_SHARED, txn2->GetTableLockSet()->at(0));
+
+  // A writer of the table conflicts with the scan that locked all of it.
+  RID rid;
+  EXPECT_FALSE(table->InsertTuple(tuple, &rid, txn2));
+  EXPECT_EQ(TransactionState::ABORTED, txn2->GetState());
+  enable_logging = false;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete txn0;
+  delete txn1;
+  delete txn2;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, SnapshotIsolationTest) {
+  Column col1{"a", TypeId::INTEGER};
+  std::vector<Column> cols{col1};
+  Schema schema{cols};
+  auto make_tuple = [&](int a) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(a)};
+    return Tuple{values, &schema};
+  };
+
+  enable_logging = true;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager);
+  auto *txn0 = txn_mgr->Begin();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn0, 0);
+  std::vector<RID> rids(3);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rids[i], txn0));
+  }
+  txn_mgr->Commit(txn0);
+
+  auto scan = [&](Transaction *txn) {
+    std::vector<int> values;
+    for (auto itr = table->Begin(txn); itr != table->End(); ++itr) {
+      values.push_back(itr->GetValue(&schema, 0).GetAs<int32_t>());
+    }
+    std::sort(values.begin(), values.end());
+    return values;
+  };
+
+  // Scenario: a snapshot reads the rows as of its begin while a writer changes them, without taking any locks.
+  auto *snapshot1 = txn_mgr->Begin(nullptr, IsolationLevel::SNAPSHOT_ISOLATION);
+  auto *writer = txn_mgr->Begin();
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(10), rids[0], writer));
+  ASSERT_TRUE(table->MarkDelete(rids[1], writer));
+  RID rid;
+  ASSERT_TRUE(table->InsertTuple(make_tuple(3), &rid, writer));
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), scan(snapshot1));
+  EXPECT_TRUE(snapshot1->GetSharedLockSet()->empty());
+  EXPECT_TRUE(snapshot1->GetTableLockSet()->empty());
+
+  // Neither does it see the writes once they are committed, including the deleted row that left its page.
+  txn_mgr->Commit(writer);
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), scan(snapshot1));
+  Tuple tuple;
+  EXPECT_TRUE(table->GetTuple(rids[1], &tuple, snapshot1));
+  EXPECT_EQ(1, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+
+  // A snapshot that begins afterwards sees them.
+  auto *snapshot2 = txn_mgr->Begin(nullptr, IsolationLevel::SNAPSHOT_ISOLATION);
+  EXPECT_EQ((std::vector<int>{2, 3, 10}), scan(snapshot2));
+  EXPECT_FALSE(table->GetTuple(rids[1], &tuple, snapshot2));
+
+  // The first writer wins: the older snapshot cannot update the row that was updated after its begin.
+  EXPECT_FALSE(table->UpdateTuple(make_tuple(20), rids[0], snapshot1));
+  EXPECT_EQ(TransactionState::ABORTED, snapshot1->GetState());
+  txn_mgr->Abort(snapshot1);
+
+  // An aborted write leaves the version that the snapshots see in place.
+  auto *aborted = txn_mgr->Begin(nullptr, IsolationLevel::SNAPSHOT_ISOLATION);
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(30), rids[2], aborted));
+  EXPECT_EQ((std::vector<int>{3, 10, 30}), scan(aborted));
+  txn_mgr->Abort(aborted);
+  EXPECT_EQ((std::vector<int>{2, 3, 10}), scan(snapshot2));
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(20), rids[2], snapshot2));
+  txn_mgr->Commit(snapshot2);
+
+  auto *snapshot3 = txn_mgr->Begin(nullptr, IsolationLevel::SNAPSHOT_ISOLATION);
+  EXPECT_EQ((std::vector<int>{3, 10, 20}), scan(snapshot3));
+  txn_mgr->Commit(snapshot3);
+  enable_logging = false;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete txn0;
+  delete writer;
+  delete snapshot1;
+  delete snapshot2;
+  delete aborted;
+  delete snapshot3;
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, OptimisticTest) {
+  Column col1{"a", TypeId::INTEGER};
+  std::vector<Column> cols{col1};
+  Schema schema{cols};
+  auto make_tuple = [&](int a) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(a)};
+    return Tuple{values, &schema};
+  };
+
+  enable_logging = true;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager);
+  auto *txn0 = txn_mgr->Begin();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn0, 0);
+  std::vector<RID> rids(3);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rids[i], txn0));
+  }
+  txn_mgr->Commit(txn0);
+
+  auto scan = [&](Transaction *txn) {
+    std::vector<int> values;
+    for (auto itr = table->Begin(txn); itr != table->End(); ++itr) {
+      values.push_back(itr->GetValue(&schema, 0).GetAs<int32_t>());
+    }
+    std::sort(values.begin(), values.end());
+    return values;
+  };
+  auto read = [&](const RID &rid, Transaction *txn) {
+    Tuple tuple;
+    EXPECT_TRUE(table->GetTuple(rid, &tuple, txn));
+    return tuple.GetValue(&schema, 0).GetAs<int32_t>();
+  };
+
+  // Scenario: two optimistic transactions read and update the same row. They take no locks until they commit, and
+  // read their own writes; the second to commit fails validation.
+  auto *txn1 = txn_mgr->Begin(nullptr, IsolationLevel::OPTIMISTIC);
+  auto *txn2 = txn_mgr->Begin(nullptr, IsolationLevel::OPTIMISTIC);
+  EXPECT_EQ(0, read(rids[0], txn1));
+  EXPECT_EQ(0, read(rids[0], txn2));
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(10), rids[0], txn1));
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(20), rids[0], txn2));
+  EXPECT_EQ(10, read(rids[0], txn1));
+  EXPECT_TRUE(txn1->GetExclusiveLockSet()->empty());
+  EXPECT_TRUE(txn1->GetTableLockSet()->empty());
+  EXPECT_TRUE(txn1->GetWriteSet()->empty());
+  txn_mgr->Commit(txn1);
+  EXPECT_EQ(TransactionState::COMMITTED, txn1->GetState());
+  txn_mgr->Commit(txn2);
+  EXPECT_EQ(TransactionState::ABORTED, txn2->GetState());
+
+  // A row that was only read is validated too: it was updated by a locking transaction after the begin.
+  auto *txn3 = txn_mgr->Begin(nullptr, IsolationLevel::OPTIMISTIC);
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(read(rids[1], txn3) + 1), rids[2], txn3));
+  auto *txn4 = txn_mgr->Begin();
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(11), rids[1], txn4));
+  txn_mgr->Commit(txn4);
+  txn_mgr->Commit(txn3);
+  EXPECT_EQ(TransactionState::ABORTED, txn3->GetState());
+
+  // Buffered inserts and deletes are written at commit.
+  auto *txn5 = txn_mgr->Begin(nullptr, IsolationLevel::OPTIMISTIC);
+  RID rid;
+  ASSERT_TRUE(table->InsertTuple(make_tuple(4), &rid, txn5));
+  EXPECT_EQ(INVALID_PAGE_ID, rid.GetPageId());
+  ASSERT_TRUE(table->MarkDelete(rids[2], txn5));
+  Tuple tuple;
+  EXPECT_FALSE(table->GetTuple(rids[2], &tuple, txn5));
+  EXPECT_EQ((std::vector<int>{10, 11}), scan(txn5));
+  txn_mgr->Commit(txn5);
+  EXPECT_EQ(TransactionState::COMMITTED, txn5->GetState());
+
+  auto *txn6 = txn_mgr->Begin(nullptr, IsolationLevel::SNAPSHOT_ISOLATION);
+  EXPECT_EQ((std::vector<int>{4, 10, 11}), scan(txn6));
+  txn_mgr->Commit(txn6);
+  enable_logging = false;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  for (auto *txn : {txn0, txn1, txn2, txn3, txn4, txn5, txn6}) {
+    delete txn;
+  }
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, ReadOnlyTest) {
+  Column col1{"a", TypeId::INTEGER};
+  std::vector<Column> cols{col1};
+  Schema schema{cols};
+  auto make_tuple = [&](int a) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(a)};
+    return Tuple{values, &schema};
+  };
+
+  enable_logging = true;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager, log_manager);
+  auto *txn0 = txn_mgr->Begin();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn0, 0);
+  std::vector<RID> rids(3);
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rids[i], txn0));
+  }
+  txn_mgr->Commit(txn0);
+
+  // Scenario: a read-only transaction at the default isolation level reads around a writer without locking or logging.
+  auto *writer = txn_mgr->Begin();
+  ASSERT_TRUE(table->UpdateTuple(make_tuple(10), rids[0], writer));
+  const lsn_t next_lsn = log_manager->GetNextLSN();
+  auto *reader = txn_mgr->Begin(nullptr, IsolationLevel::REPEATABLE_READ, true);
+  EXPECT_TRUE(reader->IsSnapshot());
+  std::vector<int> values;
+  for (auto itr = table->Begin(reader); itr != table->End(); ++itr) {
+    values.push_back(itr->GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), values);
+  EXPECT_TRUE(reader->GetSharedLockSet()->empty());
+  EXPECT_TRUE(reader->GetTableLockSet()->empty());
+  // Only the writer is active for a checkpoint.
+  ASSERT_EQ(1, txn_mgr->GetActiveTransactions().size());
+  EXPECT_EQ(writer->GetTransactionId(), txn_mgr->GetActiveTransactions()[0].first);
+  txn_mgr->Commit(reader);
+  EXPECT_EQ(TransactionState::COMMITTED, reader->GetState());
+  EXPECT_EQ(next_lsn, log_manager->GetNextLSN());
+  txn_mgr->Commit(writer);
+
+  // A read-only transaction cannot write.
+  auto *bad_reader = txn_mgr->Begin(nullptr, IsolationLevel::REPEATABLE_READ, true);
+  EXPECT_FALSE(table->MarkDelete(rids[1], bad_reader));
+  EXPECT_EQ(TransactionState::ABORTED, bad_reader->GetState());
+  txn_mgr->Abort(bad_reader);
+  Tuple tuple;
+  auto *check = txn_mgr->Begin(nullptr, IsolationLevel::REPEATABLE_READ, true);
+  EXPECT_TRUE(table->GetTuple(rids[1], &tuple, check));
+  txn_mgr->Commit(check);
+  enable_logging = false;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  for (auto *txn : {txn0, writer, reader, bad_reader, check}) {
+    delete txn;
+  }
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, TupleRefTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 64};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn0 = new Transaction(0);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn0, 0);
+  std::vector<RID> rids;
+  for (int i = 0; i < 100; i++) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(i),
+                              ValueFactory::GetVarcharValue("a string of row " + std::to_string(i))};
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(Tuple(values, &schema), &rid, txn0));
+    rids.push_back(rid);
+  }
+
+  // Scenario: without locking, a tuple is read in place, and a copy of it outlives the ref.
+  Tuple copy;
+  {
+    TupleRef ref;
+    ASSERT_TRUE(table->GetTupleRef(rids[42], &ref, txn0));
+    EXPECT_TRUE(ref.IsBorrowed());
+    EXPECT_EQ(rids[42], ref->GetRid());
+    EXPECT_EQ(42, ref->GetValueView(&schema, 0).GetAs<int32_t>());
+    EXPECT_EQ("a string of row 42", ref->GetValueView(&schema, 1).ToString());
+    copy = ref.ToTuple();
+    EXPECT_NE(ref->GetData(), copy.GetData());
+    // Once released, the page may be written again.
+    ref.Release();
+    EXPECT_FALSE(ref.IsBorrowed());
+    EXPECT_TRUE(buffer_pool_manager->FetchPageWrite(rids[42].GetPageId()).IsValid());
+  }
+  EXPECT_EQ("a string of row 42", copy.GetValue(&schema, 1).ToString());
+
+  // A transaction that locks rows gets a copy, and a lock on the row.
+  enable_logging = true;
+  auto *txn1 = new Transaction(1);
+  TupleRef ref;
+  ASSERT_TRUE(table->GetTupleRef(rids[7], &ref, txn1));
+  EXPECT_FALSE(ref.IsBorrowed());
+  EXPECT_EQ(7, ref->GetValue(&schema, 0).GetAs<int32_t>());
+  EXPECT_TRUE(txn1->IsSharedLocked(rids[7]));
+  // One that locked the whole table reads in place.
+  auto *txn2 = new Transaction(2);
+  ASSERT_TRUE(table->LockTable(txn2, LockMode::SHARED));
+  ASSERT_TRUE(table->GetTupleRef(rids[8], &ref, txn2));
+  EXPECT_TRUE(ref.IsBorrowed());
+  EXPECT_EQ(8, ref->GetValue(&schema, 0).GetAs<int32_t>());
+  ref.Release();
+  enable_logging = false;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete txn0;
+  delete txn1;
+  delete txn2;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, FreeSpaceMapTest) {
+  // The map hands out the page with the smallest id among those of a high enough category that nobody claimed.
+  FreeSpaceMap map;
+  map.Update(5, 4000);
+  map.Update(3, 200);
+  map.Update(4, 1000);
+  EXPECT_EQ(3, map.ClaimPage(100, INVALID_PAGE_ID));
+  EXPECT_EQ(4, map.ClaimPage(100, INVALID_PAGE_ID));
+  EXPECT_EQ(5, map.ClaimPage(100, INVALID_PAGE_ID));
+  EXPECT_EQ(INVALID_PAGE_ID, map.ClaimPage(100, INVALID_PAGE_ID));
+  EXPECT_EQ(4, map.ClaimPage(500, 4));
+  EXPECT_EQ(INVALID_PAGE_ID, map.ClaimPage(PAGE_SIZE, INVALID_PAGE_ID));
+  map.Release(5);
+  map.Update(5, 10);
+  EXPECT_EQ(INVALID_PAGE_ID, map.ClaimPage(2000, INVALID_PAGE_ID));
+  EXPECT_EQ(INVALID_PAGE_ID, map.GetLastPageId());
+
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 512};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn = new Transaction(0);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn, 0);
+  const Tuple tuple({ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue(std::string(300, 'x'))}, &schema);
+  std::vector<RID> rids;
+  for (int i = 0; i < 100; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+    rids.push_back(rid);
+  }
+  ASSERT_NE(rids.front().GetPageId(), rids.back().GetPageId());
+
+  // The space of a deleted tuple on the first page is taken once the page that the thread inserts into is full.
+  ASSERT_TRUE(table->MarkDelete(rids[1], txn));
+  table->ApplyDelete(rids[1], txn);
+  RID rid;
+  for (int i = 0; i < 100 && !(rid == rids[1]); i++) {
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+  }
+  EXPECT_EQ(rids[1], rid);
+
+  // A heap that is opened again walks its pages once, and then inserts at the end right away.
+  auto *reopened = new TableHeap(buffer_pool_manager, lock_manager, log_manager, table->GetFirstPageId(), 0);
+  RID first;
+  ASSERT_TRUE(reopened->InsertTuple(tuple, &first, txn));
+  ASSERT_TRUE(reopened->InsertTuple(tuple, &rid, txn));
+  EXPECT_EQ(first.GetPageId(), rid.GetPageId());
+
+  // Threads that insert at the same time fill pages of their own.
+  auto *shared = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn, 0);
+  std::vector<std::vector<RID>> thread_rids(4);
+  std::vector<std::thread> threads;
+  for (auto &own_rids : thread_rids) {
+    threads.emplace_back([&, rids = &own_rids]() {
+      Transaction thread_txn(1);
+      for (int i = 0; i < 50; i++) {
+        RID thread_rid;
+        ASSERT_TRUE(shared->InsertTuple(tuple, &thread_rid, &thread_txn));
+        rids->push_back(thread_rid);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::unordered_map<page_id_t, size_t> page_threads;
+  for (size_t i = 0; i < thread_rids.size(); i++) {
+    for (const RID &thread_rid : thread_rids[i]) {
+      EXPECT_EQ(i, page_threads.emplace(thread_rid.GetPageId(), i).first->second);
+    }
+  }
+  size_t num_tuples = 0;
+  for (auto it = shared->Begin(txn); it != shared->End(); ++it) {
+    num_tuples++;
+  }
+  EXPECT_EQ(200, num_tuples);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete shared;
+  delete reopened;
+  delete table;
+  delete txn;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, VacuumTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 512};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager, log_manager);
+  Transaction *txn = txn_mgr->Begin();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn, 0);
+  const Tuple tuple({ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue(std::string(300, 'x'))}, &schema);
+  std::vector<RID> rids;
+  for (int i = 0; i < 60; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+    rids.push_back(rid);
+  }
+  txn_mgr->Commit(txn);
+  delete txn;
+  auto chain = [&]() {
+    std::vector<page_id_t> page_ids;
+    for (page_id_t page_id = table->GetFirstPageId(); page_id != INVALID_PAGE_ID;) {
+      page_ids.push_back(page_id);
+      page_id = table->GetNextPageId(page_id);
+    }
+    return page_ids;
+  };
+  auto tuple_count = [&](page_id_t page_id) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(page_id));
+    const uint32_t count = page->GetTupleCount();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    return count;
+  };
+  auto scan = [&](Transaction *scan_txn) {
+    size_t num_tuples = 0;
+    for (auto it = table->Begin(scan_txn); it != table->End(); ++it) {
+      num_tuples++;
+    }
+    return num_tuples;
+  };
+  const std::vector<page_id_t> pages = chain();
+  ASSERT_GE(pages.size(), 4U);
+  const uint32_t first_count = tuple_count(pages[0]);
+
+  // Empty the second and the third page, and the last slot of the first one.
+  txn = txn_mgr->Begin();
+  size_t num_deleted = 0;
+  for (size_t i = 0; i < rids.size(); i++) {
+    const bool last_of_first = rids[i].GetPageId() == pages[0] && rids[i + 1].GetPageId() != pages[0];
+    if (last_of_first || rids[i].GetPageId() == pages[1] || rids[i].GetPageId() == pages[2]) {
+      ASSERT_TRUE(table->MarkDelete(rids[i], txn));
+      num_deleted++;
+    }
+  }
+  txn_mgr->Commit(txn);
+  delete txn;
+
+  // The empty pages are unlinked, but not deallocated while a transaction that may be on its way to them is active.
+  Transaction *reader = txn_mgr->Begin();
+  EXPECT_EQ(0, table->Vacuum(txn_mgr));
+  EXPECT_EQ(pages.size() - 2, chain().size());
+  EXPECT_EQ(first_count - 1, tuple_count(pages[0]));
+  EXPECT_EQ(rids.size() - num_deleted, scan(reader));
+  txn_mgr->Commit(reader);
+  delete reader;
+  EXPECT_EQ(2, table->Vacuum(txn_mgr));
+  EXPECT_EQ(0, table->Vacuum(txn_mgr));
+
+  // The inserts only go to the pages that are left.
+  txn = txn_mgr->Begin();
+  for (int i = 0; i < 60; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+    EXPECT_NE(pages[1], rid.GetPageId());
+    EXPECT_NE(pages[2], rid.GetPageId());
+  }
+  EXPECT_EQ(2 * rids.size() - num_deleted, scan(txn));
+  txn_mgr->Commit(txn);
+  delete txn;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, OverflowTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 20000};
+  Column col3{"c", TypeId::VARCHAR, 20000};
+  std::vector<Column> cols{col1, col2, col3};
+  Schema schema{cols};
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager, log_manager);
+  Transaction *txn = txn_mgr->Begin();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn, 0);
+  table->EnableOverflow(schema);
+  const OverflowStore *overflow = table->GetOverflowStore();
+  ASSERT_NE(nullptr, overflow);
+
+  // A string of random letters does not compress, a run of one letter does.
+  std::string random(10000, 'a');
+  uint32_t seed = 1;
+  for (char &c : random) {
+    seed = seed * 1103515245 + 12345;
+    c = static_cast<char>('a' + (seed >> 16) % 26);
+  }
+  const std::string run(20000, 'z');
+  const Tuple tuple({ValueFactory::GetIntegerValue(7), ValueFactory::GetVarcharValue(random),
+                     ValueFactory::GetVarcharValue(run)},
+                    &schema);
+  ASSERT_GT(tuple.GetLength(), static_cast<uint32_t>(PAGE_SIZE));
+  RID rid;
+  ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+  txn_mgr->Commit(txn);
+  delete txn;
+
+  // The strings are only read once their columns are.
+  txn = txn_mgr->Begin();
+  Tuple result;
+  ASSERT_TRUE(table->GetTuple(rid, &result, txn));
+  EXPECT_LT(result.GetLength(), OverflowStore::STORE_THRESHOLD);
+  EXPECT_EQ(7, result.GetValue(&schema, 0).GetAs<int32_t>());
+  EXPECT_EQ(0, overflow->GetNumPagesRead());
+  EXPECT_EQ(random, result.GetValue(&schema, 1).ToString());
+  const size_t random_pages = overflow->GetNumPagesRead();
+  EXPECT_EQ((random.size() + OverflowPage::CAPACITY) / OverflowPage::CAPACITY, random_pages);  // with the zero
+  EXPECT_EQ(run, std::string(result.GetStringView(&schema, 2)));
+  EXPECT_EQ(random_pages + 1, overflow->GetNumPagesRead());
+  EXPECT_FALSE(result.IsNull(&schema, 2));
+
+  // A copy of a stored tuple that is inserted gets chains of its own.
+  RID copy_rid;
+  ASSERT_TRUE(table->InsertTuple(result, &copy_rid, txn));
+
+  // An update replaces the strings, whose chains are freed once no transaction that may read them is active.
+  const Tuple small({ValueFactory::GetIntegerValue(8), ValueFactory::GetVarcharValue("b"),
+                     ValueFactory::GetVarcharValue("c")},
+                    &schema);
+  ASSERT_TRUE(table->UpdateTuple(small, rid, txn));
+  txn_mgr->Commit(txn);
+  delete txn;
+  Transaction *reader = txn_mgr->Begin();
+  EXPECT_EQ(0, table->Vacuum(txn_mgr));
+  txn_mgr->Commit(reader);
+  delete reader;
+  EXPECT_EQ(random_pages + 1, table->Vacuum(txn_mgr));
+
+  // So are those of a deleted row.
+  txn = txn_mgr->Begin();
+  Tuple copy;
+  ASSERT_TRUE(table->GetTuple(copy_rid, &copy, txn));
+  EXPECT_EQ(random, copy.GetValue(&schema, 1).ToString());
+  EXPECT_EQ(run, copy.GetValue(&schema, 2).ToString());
+  ASSERT_TRUE(table->MarkDelete(copy_rid, txn));
+  txn_mgr->Commit(txn);
+  delete txn;
+  EXPECT_EQ(random_pages + 1, table->Vacuum(txn_mgr));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, PageRangeTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 512};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(50, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager, log_manager);
+  Transaction *txn = txn_mgr->Begin();
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn, 0);
+  for (int i = 0; i < 100; i++) {
+    const Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(300, 'x'))},
+                      &schema);
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+  }
+
+  // The directory lists the pages in the order of their chain.
+  const size_t num_pages = table->GetNumPages();
+  ASSERT_GE(num_pages, 4U);
+  const std::vector<page_id_t> page_ids = table->GetPageIds(0, num_pages + 1);
+  ASSERT_EQ(num_pages, page_ids.size());
+  page_id_t page_id = table->GetFirstPageId();
+  for (page_id_t directory_page_id : page_ids) {
+    EXPECT_EQ(page_id, directory_page_id);
+    page_id = table->GetNextPageId(page_id);
+  }
+  EXPECT_EQ(INVALID_PAGE_ID, page_id);
+
+  // Iterators over the ranges of a split of the pages read every tuple once, and those of a range only.
+  std::vector<int> values;
+  for (size_t begin = 0; begin < num_pages; begin += 3) {
+    const std::vector<page_id_t> range = table->GetPageIds(begin, begin + 3);
+    for (auto it = table->BeginRange(txn, range); it != table->End(); ++it) {
+      EXPECT_NE(range.end(), std::find(range.begin(), range.end(), it->GetRid().GetPageId()));
+      values.push_back(it->GetValue(&schema, 0).GetAs<int32_t>());
+    }
+  }
+  ASSERT_EQ(100, values.size());
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(i, values[i]);
+  }
+  EXPECT_TRUE(table->BeginRange(txn, {}) == table->End());
+  txn_mgr->Commit(txn);
+  delete txn;
+
+  // A table that is reopened learns its pages from their chain.
+  auto *reopened = new TableHeap(buffer_pool_manager, lock_manager, log_manager, table->GetFirstPageId(), 0);
+  EXPECT_EQ(page_ids, reopened->GetPageIds(0, num_pages));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete reopened;
+  delete table;
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, InPlaceUpdateTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 20};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManager(10, disk_manager);
+  auto *lock_manager = new LockManager(TwoPLMode::STRICT, DeadlockMode::PREVENTION);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *txn_mgr = new TransactionManager(lock_manager, log_manager);
+  Transaction *txn = txn_mgr->Begin();
+  page_id_t page_id;
+  BasicPageGuard guard = buffer_pool_manager->NewPageGuarded(&page_id);
+  auto *page = guard.AsMut<TablePage>();
+  page->Init(page_id, PAGE_SIZE, INVALID_PAGE_ID, nullptr, txn);
+  std::vector<RID> rids(3);
+  for (int i = 0; i < 3; i++) {
+    const Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue("abc")}, &schema);
+    ASSERT_TRUE(page->InsertTuple(tuple, &rids[i], txn, lock_manager, log_manager));
+  }
+  auto tuple_data = [&]() {
+    std::vector<const char *> data;
+    page->ScanTuples([&](const RID &, const char *tuple, uint32_t) { data.push_back(tuple); });
+    return data;
+  };
+  const std::vector<const char *> data = tuple_data();
+
+  // A value of the same size is overwritten where it is, nothing moves.
+  Tuple old_tuple;
+  const Tuple counter({ValueFactory::GetIntegerValue(42), ValueFactory::GetVarcharValue("abc")}, &schema);
+  ASSERT_TRUE(page->UpdateTuple(counter, &old_tuple, rids[1], txn, lock_manager, log_manager));
+  EXPECT_EQ(1, old_tuple.GetValue(&schema, 0).GetAs<int32_t>());
+  EXPECT_EQ(data, tuple_data());
+  Tuple tuple;
+  ASSERT_TRUE(page->GetTuple(rids[1], &tuple, txn, lock_manager));
+  EXPECT_EQ(42, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+  EXPECT_EQ("abc", tuple.GetValue(&schema, 1).ToString());
+
+  // A value of another size moves the tuples that are stored before it.
+  const Tuple longer({ValueFactory::GetIntegerValue(7), ValueFactory::GetVarcharValue("abcdef")}, &schema);
+  ASSERT_TRUE(page->UpdateTuple(longer, &old_tuple, rids[1], txn, lock_manager, log_manager));
+  EXPECT_EQ(42, old_tuple.GetValue(&schema, 0).GetAs<int32_t>());
+  EXPECT_NE(data, tuple_data());
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(page->GetTuple(rids[i], &tuple, txn, lock_manager));
+    EXPECT_EQ(i == 1 ? 7 : i, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    EXPECT_EQ(i == 1 ? "abcdef" : "abc", tuple.GetValue(&schema, 1).ToString());
+  }
+  guard.Drop();
+  txn_mgr->Commit(txn);
+  delete txn;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete txn_mgr;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, MoveAndReuseTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 64};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const std::string long_str = "a string that makes the tuple long";
+  Tuple big({ValueFactory::GetIntegerValue(1), ValueFactory::GetVarcharValue(long_str)}, &schema);
+  Tuple small({ValueFactory::GetIntegerValue(2), ValueFactory::GetVarcharValue("short")}, &schema);
+
+  // A move takes over the buffer, and leaves the source empty.
+  const char *data = big.GetData();
+  Tuple moved(std::move(big));
+  EXPECT_EQ(data, moved.GetData());
+  EXPECT_EQ(nullptr, big.GetData());  // NOLINT
+  EXPECT_EQ(0U, big.GetLength());     // NOLINT
+  Tuple assigned;
+  assigned = std::move(moved);
+  EXPECT_EQ(data, assigned.GetData());
+  EXPECT_EQ(long_str, assigned.GetValue(&schema, 1).ToString());
+
+  // A copy of a shorter tuple, new values and deserialized bytes reuse the buffer that fits them.
+  assigned = small;
+  EXPECT_EQ(data, assigned.GetData());
+  EXPECT_NE(small.GetData(), assigned.GetData());
+  EXPECT_EQ(small.GetLength(), assigned.GetLength());
+  EXPECT_EQ("short", assigned.GetValue(&schema, 1).ToString());
+  assigned.SetValues({ValueFactory::GetIntegerValue(3), ValueFactory::GetVarcharValue("other")}, &schema);
+  EXPECT_EQ(data, assigned.GetData());
+  EXPECT_EQ(3, assigned.GetValue(&schema, 0).GetAs<int32_t>());
+  std::vector<char> storage(sizeof(uint32_t) + small.GetLength());
+  small.SerializeTo(storage.data());
+  assigned.DeserializeFrom(storage.data());
+  EXPECT_EQ(data, assigned.GetData());
+  EXPECT_EQ(2, assigned.GetValue(&schema, 0).GetAs<int32_t>());
+  // A longer tuple needs a larger buffer.
+  assigned.SetValues({ValueFactory::GetIntegerValue(4), ValueFactory::GetVarcharValue(long_str + long_str)}, &schema);
+  EXPECT_EQ(long_str + long_str, assigned.GetValue(&schema, 1).ToString());
+
+  // A tuple that refers to data it does not own is copied shallowly.
+  Tuple shallow(small.GetData(), small.GetLength());
+  Tuple shallow_copy = shallow;
+  EXPECT_EQ(small.GetData(), shallow_copy.GetData());
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, ColumnAccessorTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 64}, Column{"c", TypeId::BIGINT},
+                 Column{"d", TypeId::DECIMAL}, Column{"e", TypeId::VARCHAR, 64}}};
+  EXPECT_EQ(0U, schema.GetColumnLayout(0).offset_);
+  EXPECT_EQ(schema.GetColumn(3).GetOffset(), schema.GetColumnLayout(3).offset_);
+  EXPECT_FALSE(schema.GetColumnLayout(1).inlined_);
+  EXPECT_EQ(TypeId::BIGINT, schema.GetColumnLayout(2).type_id_);
+
+  Tuple tuple({ValueFactory::GetIntegerValue(-7), ValueFactory::GetVarcharValue("a string that is not inlined"),
+               ValueFactory::GetBigIntValue(1LL << 40), ValueFactory::GetDecimalValue(2.5),
+               ValueFactory::GetVarcharValue("")},
+              &schema);
+  EXPECT_EQ(-7, tuple.GetInt32(&schema, 0));
+  EXPECT_EQ("a string that is not inlined", tuple.GetStringView(&schema, 1));
+  EXPECT_EQ(1LL << 40, tuple.GetInt64(&schema, 2));
+  EXPECT_EQ(2.5, tuple.GetDecimal(&schema, 3));
+  EXPECT_EQ("", tuple.GetStringView(&schema, 4));
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    EXPECT_FALSE(tuple.IsNull(&schema, i));
+  }
+
+  // A null reads as the null of its type, and IsNull() tells it apart without a Value.
+  std::vector<Value> nulls;
+  for (const Column &column : schema.GetColumns()) {
+    nulls.push_back(ValueFactory::GetNullValueByType(column.GetType()));
+  }
+  Tuple null_tuple(nulls, &schema);
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    EXPECT_TRUE(null_tuple.IsNull(&schema, i));
+    EXPECT_TRUE(null_tuple.GetValue(&schema, i).IsNull());
+  }
+  EXPECT_EQ(BUSTUB_INT32_NULL, null_tuple.GetInt32(&schema, 0));
+  EXPECT_TRUE(null_tuple.GetStringView(&schema, 1).empty());
+}
+
 }  // namespace bustub
@@ -11,12 +11,17 @@
 //===----------------------------------------------------------------------===//
 
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "common/exception.h"
+#include "common/util/hash_util.h"
 #include "gtest/gtest.h"
+#include "type/arena_pool.h"
+#include "type/type_kernels.h"
 #include "type/value.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 //===--------------------------------------------------------------------===//
@@ -95,4 +100,169 @@ TEST(TypeTests, TemplateTest) {
   BPlusTreePage<Value, Value> node;
   node.GetInfo(val1, val2);
 }
+
+// NOLINTNEXTLINE
+TEST(TypeTests, HashValueTest) {
+  auto hash_of = [](const Value &val) { return HashUtil::HashValue(&val); };
+
+  // equal integers hash alike whatever their width
+  EXPECT_EQ(hash_of(ValueFactory::GetTinyIntValue(7)), hash_of(ValueFactory::GetBigIntValue(7)));
+  EXPECT_EQ(hash_of(ValueFactory::GetIntegerValue(-7)), hash_of(ValueFactory::GetSmallIntValue(-7)));
+
+  // strings of every length up to past two words, each differing from the previous one in its last byte
+  std::unordered_set<hash_t> hashes;
+  std::string str;
+  for (int i = 0; i < 40; i++) {
+    str.push_back('a');
+    for (char c = 'a'; c <= 'z'; c++) {
+      str.back() = c;
+      hashes.insert(hash_of(ValueFactory::GetVarcharValue(str)));
+    }
+  }
+  EXPECT_EQ(40 * 26, hashes.size());
+
+  // consecutive integers spread over both halves of the hash
+  std::unordered_set<hash_t> low_bits;
+  std::unordered_set<hash_t> high_bits;
+  for (int32_t i = 0; i < 1000; i++) {
+    hash_t hash = hash_of(ValueFactory::GetIntegerValue(i));
+    low_bits.insert(hash & 0xfff);
+    high_bits.insert(hash >> 52);
+    hashes.insert(HashUtil::CombineHashes(hash, hash));
+  }
+  EXPECT_GT(low_bits.size(), 700);
+  EXPECT_GT(high_bits.size(), 700);
+  EXPECT_EQ(40 * 26 + 1000, hashes.size());
+}
+
+// NOLINTNEXTLINE
+TEST(TypeTests, ArenaPoolTest) {
+  ArenaPool pool;
+  // Allocations are aligned, and fill a block before the next one is taken.
+  std::vector<char *> ptrs;
+  for (int i = 0; i < 100; i++) {
+    ptrs.push_back(static_cast<char *>(pool.Allocate(13)));
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(ptrs.back()) % 8);
+  }
+  EXPECT_EQ(100U * 16, pool.GetBytesAllocated());
+  EXPECT_EQ(static_cast<size_t>(ARENA_BLOCK_SIZE), pool.GetMemoryUsage());
+  // A large allocation gets a block of its own, which a reset lets go of.
+  pool.Allocate(ARENA_BLOCK_SIZE * 2);
+  EXPECT_EQ(static_cast<size_t>(ARENA_BLOCK_SIZE) * 3, pool.GetMemoryUsage());
+  pool.Reset();
+  EXPECT_EQ(0U, pool.GetBytesAllocated());
+  EXPECT_EQ(static_cast<size_t>(ARENA_BLOCK_SIZE), pool.GetMemoryUsage());
+  // The blocks are used again after a reset.
+  EXPECT_EQ(ptrs[0], pool.Allocate(13));
+
+  // A varchar of the pool borrows its data, and a copy of it owns a copy of the data.
+  const std::string str = "a string that lives in the pool";
+  Value borrowed = ValueFactory::GetVarcharValue(str, &pool);
+  Value copy = borrowed;
+  Value clone = ValueFactory::Clone(copy, &pool);
+  EXPECT_NE(borrowed.GetData(), copy.GetData());
+  EXPECT_EQ(CmpBool::CmpTrue, borrowed.CompareEquals(copy));
+  EXPECT_EQ(CmpBool::CmpTrue, clone.CompareEquals(copy));
+  // A moved value keeps borrowing.
+  const char *data = borrowed.GetData();
+  Value moved = std::move(borrowed);
+  EXPECT_EQ(data, moved.GetData());
+  // Deserialized from a tuple's bytes into the pool.
+  std::vector<char> storage(sizeof(uint32_t) + str.size() + 1);
+  copy.SerializeTo(storage.data());
+  Value deserialized = Value::DeserializeFrom(storage.data(), TypeId::VARCHAR, &pool);
+  EXPECT_EQ(str, deserialized.ToString());
+  pool.Reset();
+  EXPECT_EQ(str, copy.ToString());
+}
+
+// NOLINTNEXTLINE
+TEST(TypeTests, InlineVarcharTest) {
+  // Strings of up to INLINE_VARLEN_SIZE bytes, the terminating zero included, live in the value itself.
+  EXPECT_EQ(24U, sizeof(Value));
+  const std::string short_str = "eleven char";
+  Value short_val = ValueFactory::GetVarcharValue(short_str);
+  Value copy = short_val;
+  EXPECT_EQ(short_str, copy.ToString());
+  EXPECT_EQ(short_str.size() + 1, copy.GetLength());
+  EXPECT_NE(short_val.GetData(), copy.GetData());
+  EXPECT_FALSE(copy.IsNull());
+  EXPECT_EQ(CmpBool::CmpTrue, short_val.CompareEquals(copy));
+  EXPECT_EQ(HashUtil::HashValue(&short_val), HashUtil::HashValue(&copy));
+  Value moved = std::move(copy);
+  EXPECT_EQ(short_str, moved.ToString());
+
+  // Inlined and heap strings compare the same way.
+  const std::string long_str = "twelve chars";
+  Value long_val = ValueFactory::GetVarcharValue(long_str);
+  EXPECT_EQ(CmpBool::CmpTrue, short_val.CompareLessThan(long_val));
+  EXPECT_EQ(CmpBool::CmpTrue, long_val.CompareGreaterThan(short_val));
+  Value empty = ValueFactory::GetVarcharValue("");
+  EXPECT_FALSE(empty.IsNull());
+  EXPECT_EQ("", empty.ToString());
+
+  // Serialized and deserialized, with and without a pool.
+  std::vector<char> storage(sizeof(uint32_t) + short_str.size() + 1);
+  short_val.SerializeTo(storage.data());
+  ArenaPool pool;
+  EXPECT_EQ(short_str, Value::DeserializeFrom(storage.data(), TypeId::VARCHAR).ToString());
+  EXPECT_EQ(short_str, Value::DeserializeFrom(storage.data(), TypeId::VARCHAR, &pool).ToString());
+  EXPECT_EQ(0U, pool.GetBytesAllocated());
+
+  // A view of a long string borrows its data, and one of a short string carries it along.
+  Value long_view = long_val.GetView();
+  EXPECT_EQ(long_val.GetData(), long_view.GetData());
+  EXPECT_EQ(CmpBool::CmpTrue, long_view.CompareEquals(long_val));
+  Value short_view = short_val.GetView();
+  EXPECT_EQ(short_str, short_view.ToString());
+  Value null_view = ValueFactory::GetNullValueByType(TypeId::VARCHAR).GetView();
+  EXPECT_TRUE(null_view.IsNull());
+  // A copy of a view owns its data.
+  Value owned = long_view;
+  EXPECT_NE(long_val.GetData(), owned.GetData());
+  EXPECT_EQ(long_str, owned.ToString());
+}
+
+// NOLINTNEXTLINE
+TEST(TypeTests, TypeKernelTest) {
+  // The kernels of a type compare and hash like Value, for values of the type, of other types, and nulls.
+  std::vector<Value> values = {ValueFactory::GetTinyIntValue(-3),
+                               ValueFactory::GetSmallIntValue(7),
+                               ValueFactory::GetIntegerValue(7),
+                               ValueFactory::GetIntegerValue(-100000),
+                               ValueFactory::GetBigIntValue(7),
+                               ValueFactory::GetBigIntValue(1LL << 40),
+                               ValueFactory::GetDecimalValue(7.0),
+                               ValueFactory::GetDecimalValue(-2.5),
+                               ValueFactory::GetBooleanValue(true),
+                               ValueFactory::GetBooleanValue(false),
+                               ValueFactory::GetTimestampValue(42),
+                               ValueFactory::GetVarcharValue("abc"),
+                               ValueFactory::GetVarcharValue("abcd"),
+                               ValueFactory::GetVarcharValue("a string longer than the inline ones")};
+  for (TypeId type : {TypeId::TINYINT, TypeId::SMALLINT, TypeId::INTEGER, TypeId::BIGINT, TypeId::DECIMAL,
+                      TypeId::BOOLEAN, TypeId::VARCHAR}) {
+    values.push_back(ValueFactory::GetNullValueByType(type));
+  }
+  for (const Value &left : values) {
+    const TypeKernels &kernels = TypeKernels::Get(left.GetTypeId());
+    std::vector<hash_t> hashes(1, 0);
+    kernels.hash_combine_({left}, false, hashes.data());
+    EXPECT_EQ(HashUtil::CombineHashes(0, left.IsNull() ? 0 : HashUtil::HashValue(&left)), hashes[0]);
+    for (const Value &right : values) {
+      // A string compared with a number is cast to it, which fails for these strings.
+      const bool one_varchar = (left.GetTypeId() == TypeId::VARCHAR) != (right.GetTypeId() == TypeId::VARCHAR);
+      if (!left.CheckComparable(right) || one_varchar) {
+        continue;
+      }
+      EXPECT_EQ(left.CompareEquals(right), kernels.compare_equals_(left, right));
+      EXPECT_EQ(left.CompareLessThan(right), kernels.compare_less_than_(left, right));
+    }
+  }
+  // A kernel of another type falls back on the generic operations.
+  const Value big = ValueFactory::GetBigIntValue(7);
+  const Value integer = ValueFactory::GetIntegerValue(7);
+  EXPECT_EQ(CmpBool::CmpTrue, TypeKernel<TypeId::INTEGER>::CompareEquals(big, integer));
+  EXPECT_EQ(HashUtil::HashValue(&big), TypeKernel<TypeId::INTEGER>::Hash(big));
+}
 }  // namespace bustub